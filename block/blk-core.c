@@ -256,6 +256,8 @@ static void blk_free_queue_rcu(struct rcu_head *rcu_head)
 
 static void blk_free_queue(struct request_queue *q)
 {
+	if (queue_is_mq(q))
+		blk_mq_poll_free_stats(q);
 	blk_free_queue_stats(q->stats);
 	if (queue_is_mq(q))
 		blk_mq_release(q);
@@ -952,7 +954,11 @@ int bio_poll(struct bio *bio, struct io_comp_batch *iob, unsigned int flags)
 	if (!percpu_ref_tryget(&q->q_usage_counter))
 		return 0;
 	if (queue_is_mq(q)) {
-		ret = blk_mq_poll(q, cookie, iob, flags);
+		if (blk_mq_poll_hybrid(q, bio, cookie, flags))
+			ret = 1;
+		else
+			ret = blk_mq_poll(q, cookie & ~BLK_QC_T_SLEPT, iob,
+					  flags);
 	} else {
 		struct gendisk *disk = q->disk;
 
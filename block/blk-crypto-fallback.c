@@ -18,6 +18,7 @@
 #include <linux/module.h>
 #include <linux/random.h>
 #include <linux/scatterlist.h>
+#include <linux/sizes.h>
 
 #include "blk-cgroup.h"
 #include "blk-crypto-internal.h"
@@ -37,6 +38,21 @@ module_param(num_prealloc_fallback_crypt_ctxs, uint, 0);
 MODULE_PARM_DESC(num_prealloc_crypt_fallback_ctxs,
 		 "Number of preallocated bio fallback crypto contexts for blk-crypto to use during crypto API fallback");
 
+static unsigned int max_parallel_cpus = 4;
+module_param(max_parallel_cpus, uint, 0644);
+MODULE_PARM_DESC(max_parallel_cpus,
+		 "Maximum number of CPUs en/decrypting one bio in parallel");
+
+static unsigned int parallel_min_bytes = SZ_64K;
+module_param(parallel_min_bytes, uint, 0644);
+MODULE_PARM_DESC(parallel_min_bytes,
+		 "Minimum number of bytes of a bio handed to each parallel CPU");
+
+static unsigned int crypt_batch = 16;
+module_param(crypt_batch, uint, 0644);
+MODULE_PARM_DESC(crypt_batch,
+		 "Number of data units submitted at once to an asynchronous crypto engine");
+
 struct bio_fallback_crypt_ctx {
 	struct bio_crypt_ctx crypt_ctx;
 	/*
@@ -80,6 +96,7 @@ static struct blk_crypto_fallback_keyslot {
 
 static struct blk_crypto_profile *blk_crypto_fallback_profile;
 static struct workqueue_struct *blk_crypto_wq;
+static struct workqueue_struct *blk_crypto_par_wq;
 static mempool_t *blk_crypto_bounce_page_pool;
 static struct bio_set crypto_bio_split;
 
@@ -184,28 +201,13 @@ static struct bio *blk_crypto_fallback_clone_bio(struct bio *bio_src)
 	return bio;
 }
 
-static bool
-blk_crypto_fallback_alloc_cipher_req(struct blk_crypto_keyslot *slot,
-				     struct skcipher_request **ciph_req_ret,
-				     struct crypto_wait *wait)
+static struct crypto_skcipher *
+blk_crypto_fallback_tfm(struct blk_crypto_keyslot *slot)
 {
-	struct skcipher_request *ciph_req;
-	const struct blk_crypto_fallback_keyslot *slotp;
-	int keyslot_idx = blk_crypto_keyslot_index(slot);
-
-	slotp = &blk_crypto_keyslots[keyslot_idx];
-	ciph_req = skcipher_request_alloc(slotp->tfms[slotp->crypto_mode],
-					  GFP_NOIO);
-	if (!ciph_req)
-		return false;
+	const struct blk_crypto_fallback_keyslot *slotp =
+		&blk_crypto_keyslots[blk_crypto_keyslot_index(slot)];
 
-	skcipher_request_set_callback(ciph_req,
-				      CRYPTO_TFM_REQ_MAY_BACKLOG |
-				      CRYPTO_TFM_REQ_MAY_SLEEP,
-				      crypto_req_done, wait);
-	*ciph_req_ret = ciph_req;
-
-	return true;
+	return slotp->tfms[slotp->crypto_mode];
 }
 
 static bool blk_crypto_fallback_split_bio_if_needed(struct bio **bio_ptr)
@@ -252,6 +254,246 @@ static void blk_crypto_dun_to_iv(const u64 dun[BLK_CRYPTO_DUN_ARRAY_SIZE],
 		iv->dun[i] = cpu_to_le64(dun[i]);
 }
 
+/*
+ * Each bio is en/decrypted as one or more ranges of consecutive segments.
+ * The submitter handles the first range itself while the others run on
+ * other CPUs, and the bio only proceeds once all of them have finished.
+ * Within a range, up to crypt_batch data units are submitted before
+ * waiting, so that asynchronous engines see a queue instead of a single
+ * request at a time.
+ */
+struct blk_crypto_fallback_job;
+
+struct blk_crypto_fallback_range {
+	struct work_struct work;
+	struct blk_crypto_fallback_job *job;
+	struct crypto_skcipher *tfm;
+	bool encrypt;
+	unsigned int data_unit_size;
+	/* source segments, starting at @iter */
+	struct bio *bio;
+	struct bvec_iter iter;
+	unsigned int nr_segs;
+	/* destination segments, NULL to work in place */
+	struct bio_vec *dst;
+	u64 dun[BLK_CRYPTO_DUN_ARRAY_SIZE];
+	blk_status_t status;
+};
+
+struct blk_crypto_fallback_job {
+	atomic_t remaining;
+	struct completion done;
+	struct blk_crypto_fallback_range ranges[];
+};
+
+struct blk_crypto_fallback_unit {
+	struct scatterlist src, dst;
+	union blk_crypto_iv iv;
+	/* must be last, followed by the request context */
+	struct skcipher_request req;
+};
+
+struct blk_crypto_fallback_wait {
+	atomic_t pending;
+	int err;
+	struct completion done;
+};
+
+static void blk_crypto_fallback_unit_done(void *data, int err)
+{
+	struct blk_crypto_fallback_wait *wait = data;
+
+	/* a backlogged request has been started, we'll be called again */
+	if (err == -EINPROGRESS)
+		return;
+	if (err)
+		WRITE_ONCE(wait->err, err);
+	if (atomic_dec_and_test(&wait->pending))
+		complete(&wait->done);
+}
+
+static void blk_crypto_fallback_crypt_range(struct blk_crypto_fallback_range *r)
+{
+	const unsigned int reqsize = crypto_skcipher_reqsize(r->tfm);
+	const unsigned int dus = r->data_unit_size;
+	unsigned int batch = clamp(READ_ONCE(crypt_batch), 1U, 64U);
+	struct blk_crypto_fallback_unit **units;
+	struct blk_crypto_fallback_wait wait;
+	struct bvec_iter iter = r->iter;
+	unsigned int seg = 0, off = 0, n, k;
+	struct bio_vec src, dst;
+	int err = 0;
+
+	units = kcalloc(batch, sizeof(*units), GFP_NOIO);
+	if (!units) {
+		r->status = BLK_STS_RESOURCE;
+		return;
+	}
+	for (n = 0; n < batch; n++) {
+		units[n] = kmalloc(sizeof(*units[n]) + reqsize, GFP_NOIO);
+		if (!units[n])
+			break;
+		skcipher_request_set_tfm(&units[n]->req, r->tfm);
+		skcipher_request_set_callback(&units[n]->req,
+					      CRYPTO_TFM_REQ_MAY_BACKLOG |
+					      CRYPTO_TFM_REQ_MAY_SLEEP,
+					      blk_crypto_fallback_unit_done,
+					      &wait);
+		sg_init_table(&units[n]->src, 1);
+		sg_init_table(&units[n]->dst, 1);
+	}
+	if (!n) {
+		r->status = BLK_STS_RESOURCE;
+		goto out;
+	}
+
+	init_completion(&wait.done);
+	while (seg < r->nr_segs && !err) {
+		atomic_set(&wait.pending, 1);
+		wait.err = 0;
+		reinit_completion(&wait.done);
+
+		for (k = 0; k < n && seg < r->nr_segs; k++) {
+			struct blk_crypto_fallback_unit *u = units[k];
+			int ret;
+
+			src = bio_iter_iovec(r->bio, iter);
+			dst = r->dst ? r->dst[seg] : src;
+
+			sg_set_page(&u->src, src.bv_page, dus,
+				    src.bv_offset + off);
+			sg_set_page(&u->dst, dst.bv_page, dus,
+				    dst.bv_offset + off);
+			blk_crypto_dun_to_iv(r->dun, &u->iv);
+			bio_crypt_dun_increment(r->dun, 1);
+			skcipher_request_set_crypt(&u->req, &u->src, &u->dst,
+						   dus, u->iv.bytes);
+
+			atomic_inc(&wait.pending);
+			ret = r->encrypt ? crypto_skcipher_encrypt(&u->req) :
+					   crypto_skcipher_decrypt(&u->req);
+			if (ret != -EINPROGRESS && ret != -EBUSY)
+				blk_crypto_fallback_unit_done(&wait, ret);
+
+			off += dus;
+			if (off >= src.bv_len) {
+				off = 0;
+				bio_advance_iter_single(r->bio, &iter,
+							src.bv_len);
+				seg++;
+			}
+		}
+
+		if (!atomic_dec_and_test(&wait.pending))
+			wait_for_completion(&wait.done);
+		err = READ_ONCE(wait.err);
+	}
+	if (err)
+		r->status = BLK_STS_IOERR;
+out:
+	while (n)
+		kfree(units[--n]);
+	kfree(units);
+}
+
+static void blk_crypto_fallback_range_work(struct work_struct *work)
+{
+	struct blk_crypto_fallback_range *r =
+		container_of(work, struct blk_crypto_fallback_range, work);
+
+	blk_crypto_fallback_crypt_range(r);
+	if (atomic_dec_and_test(&r->job->remaining))
+		complete(&r->job->done);
+}
+
+static unsigned int blk_crypto_fallback_nr_ranges(unsigned int bytes,
+						  unsigned int nr_segs)
+{
+	unsigned int min_bytes = max(READ_ONCE(parallel_min_bytes), 1U);
+	unsigned int nr = min(READ_ONCE(max_parallel_cpus), num_online_cpus());
+
+	return clamp(min3(nr, nr_segs, bytes / min_bytes), 1U, nr_segs ?: 1U);
+}
+
+/*
+ * En/decrypt the @bytes bytes of @bio starting at @iter into @dst, or in
+ * place if @dst is NULL, starting with data unit number @dun.
+ */
+static blk_status_t
+blk_crypto_fallback_crypt(struct crypto_skcipher *tfm, bool encrypt,
+			  unsigned int data_unit_size, struct bio *bio,
+			  struct bvec_iter iter, unsigned int bytes,
+			  struct bio_vec *dst,
+			  const u64 dun[BLK_CRYPTO_DUN_ARRAY_SIZE])
+{
+	struct blk_crypto_fallback_range single = {}, *r;
+	struct blk_crypto_fallback_job *job = NULL;
+	unsigned int nr_segs = 0, nr, i, seg, done;
+	struct bvec_iter it;
+	struct bio_vec bv;
+	blk_status_t status = BLK_STS_OK;
+
+	__bio_for_each_segment(bv, bio, it, iter)
+		nr_segs++;
+
+	nr = blk_crypto_fallback_nr_ranges(bytes, nr_segs);
+	if (nr > 1) {
+		job = kzalloc(struct_size(job, ranges, nr), GFP_NOIO);
+		if (!job)
+			nr = 1;
+	}
+	r = job ? job->ranges : &single;
+
+	/* cut the segments into ranges of about the same number of bytes */
+	it = iter;
+	seg = 0;
+	done = 0;
+	for (i = 0; i < nr; i++) {
+		unsigned int limit = (u64)bytes * (i + 1) / nr;
+
+		r[i].tfm = tfm;
+		r[i].encrypt = encrypt;
+		r[i].data_unit_size = data_unit_size;
+		r[i].bio = bio;
+		r[i].iter = it;
+		r[i].dst = dst ? &dst[seg] : NULL;
+		memcpy(r[i].dun, dun, sizeof(r[i].dun));
+		bio_crypt_dun_increment(r[i].dun, done / data_unit_size);
+		while (seg < nr_segs && (done < limit || i == nr - 1)) {
+			bv = bio_iter_iovec(bio, it);
+			bio_advance_iter_single(bio, &it, bv.bv_len);
+			done += bv.bv_len;
+			r[i].nr_segs++;
+			seg++;
+		}
+	}
+
+	if (job) {
+		int cpu = raw_smp_processor_id();
+
+		atomic_set(&job->remaining, nr - 1);
+		init_completion(&job->done);
+		for (i = 1; i < nr; i++) {
+			r[i].job = job;
+			INIT_WORK(&r[i].work, blk_crypto_fallback_range_work);
+			cpu = cpumask_next(cpu, cpu_online_mask);
+			if (cpu >= nr_cpu_ids)
+				cpu = cpumask_first(cpu_online_mask);
+			queue_work_on(cpu, blk_crypto_par_wq, &r[i].work);
+		}
+	}
+
+	blk_crypto_fallback_crypt_range(&r[0]);
+
+	if (job)
+		wait_for_completion(&job->done);
+	for (i = 0; i < nr; i++)
+		if (r[i].status != BLK_STS_OK)
+			status = r[i].status;
+	kfree(job);
+	return status;
+}
+
 /*
  * The crypto API fallback's encryption routine.
  * Allocate a bounce bio for encryption, encrypt the input bio using crypto API,
@@ -265,12 +507,7 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 	struct bio_crypt_ctx *bc;
 	struct blk_crypto_keyslot *slot;
 	int data_unit_size;
-	struct skcipher_request *ciph_req = NULL;
-	DECLARE_CRYPTO_WAIT(wait);
-	u64 curr_dun[BLK_CRYPTO_DUN_ARRAY_SIZE];
-	struct scatterlist src, dst;
-	union blk_crypto_iv iv;
-	unsigned int i, j;
+	unsigned int i;
 	bool ret = false;
 	blk_status_t blk_st;
 
@@ -300,51 +537,31 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 		goto out_put_enc_bio;
 	}
 
-	/* and then allocate an skcipher_request for it */
-	if (!blk_crypto_fallback_alloc_cipher_req(slot, &ciph_req, &wait)) {
-		src_bio->bi_status = BLK_STS_RESOURCE;
-		goto out_release_keyslot;
-	}
-
-	memcpy(curr_dun, bc->bc_dun, sizeof(curr_dun));
-	sg_init_table(&src, 1);
-	sg_init_table(&dst, 1);
-
-	skcipher_request_set_crypt(ciph_req, &src, &dst, data_unit_size,
-				   iv.bytes);
-
-	/* Encrypt each page in the bounce bio */
+	/*
+	 * Point the bounce bio at bounce pages.  The plaintext is read from
+	 * the segments of the source bio, which match the bounce bio's one
+	 * to one.
+	 */
 	for (i = 0; i < enc_bio->bi_vcnt; i++) {
 		struct bio_vec *enc_bvec = &enc_bio->bi_io_vec[i];
-		struct page *plaintext_page = enc_bvec->bv_page;
 		struct page *ciphertext_page =
 			mempool_alloc(blk_crypto_bounce_page_pool, GFP_NOIO);
 
-		enc_bvec->bv_page = ciphertext_page;
-
 		if (!ciphertext_page) {
 			src_bio->bi_status = BLK_STS_RESOURCE;
 			goto out_free_bounce_pages;
 		}
+		enc_bvec->bv_page = ciphertext_page;
+	}
 
-		sg_set_page(&src, plaintext_page, data_unit_size,
-			    enc_bvec->bv_offset);
-		sg_set_page(&dst, ciphertext_page, data_unit_size,
-			    enc_bvec->bv_offset);
-
-		/* Encrypt each data unit in this page */
-		for (j = 0; j < enc_bvec->bv_len; j += data_unit_size) {
-			blk_crypto_dun_to_iv(curr_dun, &iv);
-			if (crypto_wait_req(crypto_skcipher_encrypt(ciph_req),
-					    &wait)) {
-				i++;
-				src_bio->bi_status = BLK_STS_IOERR;
-				goto out_free_bounce_pages;
-			}
-			bio_crypt_dun_increment(curr_dun, 1);
-			src.offset += data_unit_size;
-			dst.offset += data_unit_size;
-		}
+	blk_st = blk_crypto_fallback_crypt(blk_crypto_fallback_tfm(slot), true,
+					   data_unit_size, src_bio,
+					   src_bio->bi_iter,
+					   src_bio->bi_iter.bi_size,
+					   enc_bio->bi_io_vec, bc->bc_dun);
+	if (blk_st != BLK_STS_OK) {
+		src_bio->bi_status = blk_st;
+		goto out_free_bounce_pages;
 	}
 
 	enc_bio->bi_private = src_bio;
@@ -353,14 +570,12 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 	ret = true;
 
 	enc_bio = NULL;
-	goto out_free_ciph_req;
+	goto out_release_keyslot;
 
 out_free_bounce_pages:
 	while (i > 0)
 		mempool_free(enc_bio->bi_io_vec[--i].bv_page,
 			     blk_crypto_bounce_page_pool);
-out_free_ciph_req:
-	skcipher_request_free(ciph_req);
 out_release_keyslot:
 	blk_crypto_put_keyslot(slot);
 out_put_enc_bio:
@@ -381,15 +596,7 @@ static void blk_crypto_fallback_decrypt_bio(struct work_struct *work)
 	struct bio *bio = f_ctx->bio;
 	struct bio_crypt_ctx *bc = &f_ctx->crypt_ctx;
 	struct blk_crypto_keyslot *slot;
-	struct skcipher_request *ciph_req = NULL;
-	DECLARE_CRYPTO_WAIT(wait);
-	u64 curr_dun[BLK_CRYPTO_DUN_ARRAY_SIZE];
-	union blk_crypto_iv iv;
-	struct scatterlist sg;
-	struct bio_vec bv;
-	struct bvec_iter iter;
 	const int data_unit_size = bc->bc_key->crypto_cfg.data_unit_size;
-	unsigned int i;
 	blk_status_t blk_st;
 
 	/*
@@ -403,38 +610,15 @@ static void blk_crypto_fallback_decrypt_bio(struct work_struct *work)
 		goto out_no_keyslot;
 	}
 
-	/* and then allocate an skcipher_request for it */
-	if (!blk_crypto_fallback_alloc_cipher_req(slot, &ciph_req, &wait)) {
-		bio->bi_status = BLK_STS_RESOURCE;
-		goto out;
-	}
-
-	memcpy(curr_dun, bc->bc_dun, sizeof(curr_dun));
-	sg_init_table(&sg, 1);
-	skcipher_request_set_crypt(ciph_req, &sg, &sg, data_unit_size,
-				   iv.bytes);
-
-	/* Decrypt each segment in the bio */
-	__bio_for_each_segment(bv, bio, iter, f_ctx->crypt_iter) {
-		struct page *page = bv.bv_page;
-
-		sg_set_page(&sg, page, data_unit_size, bv.bv_offset);
-
-		/* Decrypt each data unit in the segment */
-		for (i = 0; i < bv.bv_len; i += data_unit_size) {
-			blk_crypto_dun_to_iv(curr_dun, &iv);
-			if (crypto_wait_req(crypto_skcipher_decrypt(ciph_req),
-					    &wait)) {
-				bio->bi_status = BLK_STS_IOERR;
-				goto out;
-			}
-			bio_crypt_dun_increment(curr_dun, 1);
-			sg.offset += data_unit_size;
-		}
-	}
+	/* Decrypt the bio in place */
+	blk_st = blk_crypto_fallback_crypt(blk_crypto_fallback_tfm(slot), false,
+					   data_unit_size, bio,
+					   f_ctx->crypt_iter,
+					   f_ctx->crypt_iter.bi_size, NULL,
+					   bc->bc_dun);
+	if (blk_st != BLK_STS_OK)
+		bio->bi_status = blk_st;
 
-out:
-	skcipher_request_free(ciph_req);
 	blk_crypto_put_keyslot(slot);
 out_no_keyslot:
 	mempool_free(f_ctx, bio_fallback_crypt_ctx_pool);
@@ -573,11 +757,17 @@ static int blk_crypto_fallback_init(void)
 	if (!blk_crypto_wq)
 		goto fail_destroy_profile;
 
+	/* bound, so that the ranges of a bio really run on different CPUs */
+	blk_crypto_par_wq = alloc_workqueue("blk_crypto_par_wq",
+					    WQ_HIGHPRI | WQ_MEM_RECLAIM, 0);
+	if (!blk_crypto_par_wq)
+		goto fail_free_wq;
+
 	blk_crypto_keyslots = kcalloc(blk_crypto_num_keyslots,
 				      sizeof(blk_crypto_keyslots[0]),
 				      GFP_KERNEL);
 	if (!blk_crypto_keyslots)
-		goto fail_free_wq;
+		goto fail_free_par_wq;
 
 	blk_crypto_bounce_page_pool =
 		mempool_create_page_pool(num_prealloc_bounce_pg, 0);
@@ -603,6 +793,8 @@ static int blk_crypto_fallback_init(void)
 	mempool_destroy(blk_crypto_bounce_page_pool);
 fail_free_keyslots:
 	kfree(blk_crypto_keyslots);
+fail_free_par_wq:
+	destroy_workqueue(blk_crypto_par_wq);
 fail_free_wq:
 	destroy_workqueue(blk_crypto_wq);
 fail_destroy_profile:
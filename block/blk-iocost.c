@@ -44,7 +44,9 @@
  * /sys/fs/cgroup/io.cost.model.
  *
  * If needed, tools/cgroup/iocost_coef_gen.py can be used to generate
- * device-specific coefficients.
+ * device-specific coefficients.  Alternatively, writing "ctrl=calib" to
+ * io.cost.model makes the controller fit the coefficients itself from the
+ * IOs which run alone on the device, see ioc_calib_fit_dir().
  *
  * 2. Control Strategy
  *
@@ -312,6 +314,18 @@ enum {
 
 	/* if apart further than 16M, consider randio for linear model */
 	LCOEF_RANDIO_PAGES	= 4096,
+
+	/*
+	 * Calibration keeps up to IOC_CALIB_SAMPLES samples for each of
+	 * read/write x seq/rand, refits every IOC_CALIB_FIT_INTERVAL new
+	 * samples and uses a group once it has IOC_CALIB_MIN_SAMPLES.
+	 * Larger or slower IOs are ignored, which also bounds the sums.
+	 */
+	IOC_CALIB_SAMPLES	= 4096,
+	IOC_CALIB_MIN_SAMPLES	= 64,
+	IOC_CALIB_FIT_INTERVAL	= 256,
+	IOC_CALIB_MAX_PAGES	= 256,
+	IOC_CALIB_MAX_LAT_NS	= 100 * NSEC_PER_MSEC,
 };
 
 enum ioc_running {
@@ -395,6 +409,38 @@ struct ioc_missed {
 	u32				last_missed;
 };
 
+/* completions of IOs which had the device to themselves */
+struct ioc_calib_group {
+	u32				nr;
+	u64				sum_x;		/* pages */
+	u64				sum_xx;
+	u64				sum_y;		/* nsecs */
+	u64				sum_xy;
+	u64				sum_yy_us;	/* usecs^2 */
+};
+
+enum ioc_calib_state {
+	IOC_CALIB_OFF,
+	IOC_CALIB_RUNNING,
+	IOC_CALIB_DONE,
+};
+
+struct ioc_calib {
+	spinlock_t			lock;
+	enum ioc_calib_state		state;
+	u32				inflight;
+	/* io_start_time_ns of the IO issued to an idle device, 0 if none */
+	u64				solo_start_ns;
+	bool				solo_seq;
+	sector_t			cursor;
+	u32				since_fit;
+	struct work_struct		fit_work;
+	/* [READ/WRITE][rand/seq] */
+	struct ioc_calib_group		groups[2][2];
+	/* goodness of the last fit per direction, in 1/1000 */
+	u32				r2[2];
+};
+
 struct ioc_pcpu_stat {
 	struct ioc_missed		missed[2];
 
@@ -445,6 +491,8 @@ struct ioc {
 	int				autop_idx;
 	bool				user_qos_params:1;
 	bool				user_cost_model:1;
+
+	struct ioc_calib		calib;
 };
 
 struct iocg_pcpu_stat {
@@ -2807,6 +2855,254 @@ static void ioc_rqos_done_bio(struct rq_qos *rqos, struct bio *bio)
 		atomic64_add(bio->bi_iocost_cost, &iocg->done_vtime);
 }
 
+/*
+ * Cost model calibration.  Only IOs issued to an idle device which complete
+ * before anything else is issued are sampled, so that their completion
+ * latency is the device service time.  For each direction, the samples are
+ * fitted to the linear model
+ *
+ *   latency = base(seq or rand) + pages * per_page
+ *
+ * with least squares, with a common per-page cost and separate intercepts
+ * for sequential and random IOs.  The result is converted back to the
+ * bps/seqiops/randiops parameters of io.cost.model.
+ */
+static void ioc_calib_start(struct ioc *ioc)
+{
+	struct ioc_calib *cb = &ioc->calib;
+
+	lockdep_assert_held(&ioc->lock);
+
+	spin_lock(&cb->lock);
+	if (cb->state != IOC_CALIB_RUNNING)
+		blk_stat_enable_accounting(ioc->rqos.disk->queue);
+	memset(cb->groups, 0, sizeof(cb->groups));
+	memset(cb->r2, 0, sizeof(cb->r2));
+	cb->inflight = 0;
+	cb->solo_start_ns = 0;
+	cb->cursor = 0;
+	cb->since_fit = 0;
+	WRITE_ONCE(cb->state, IOC_CALIB_RUNNING);
+	spin_unlock(&cb->lock);
+}
+
+static void ioc_calib_stop(struct ioc *ioc, enum ioc_calib_state state)
+{
+	struct ioc_calib *cb = &ioc->calib;
+
+	lockdep_assert_held(&ioc->lock);
+
+	spin_lock(&cb->lock);
+	if (cb->state == IOC_CALIB_RUNNING)
+		blk_stat_disable_accounting(ioc->rqos.disk->queue);
+	WRITE_ONCE(cb->state, state);
+	spin_unlock(&cb->lock);
+}
+
+/*
+ * Fit one direction.  @g is indexed by sequentiality and @u points to the
+ * bps, seqiops and randiops parameters, which are only updated for groups
+ * with enough samples.  Returns the coefficient of determination in 1/1000.
+ */
+static u32 ioc_calib_fit_dir(const struct ioc_calib_group *g, u64 *u)
+{
+	s64 sxx = 0, sxy = 0, syy_us = 0, page_ns, base_ns, res, tot;
+	u64 n = 0, sum_y_us = 0, sum_yy_us = 0;
+	bool fitted = false;
+	int seq;
+
+	for (seq = 0; seq < 2; seq++) {
+		if (g[seq].nr < IOC_CALIB_MIN_SAMPLES)
+			continue;
+		sxx += g[seq].sum_xx - mul_u64_u64_div_u64(g[seq].sum_x,
+					g[seq].sum_x, g[seq].nr);
+		sxy += (s64)g[seq].sum_xy - (s64)mul_u64_u64_div_u64(
+					g[seq].sum_x, g[seq].sum_y, g[seq].nr);
+		syy_us += g[seq].sum_yy_us -
+			div_u64(div_u64(g[seq].sum_y, NSEC_PER_USEC) *
+				div_u64(g[seq].sum_y, NSEC_PER_USEC),
+				g[seq].nr);
+		n += g[seq].nr;
+		sum_y_us += div_u64(g[seq].sum_y, NSEC_PER_USEC);
+		sum_yy_us += g[seq].sum_yy_us;
+	}
+	if (!n)
+		return 0;
+
+	/* without a spread of sizes, keep the current per-page cost */
+	if (sxx > 0 && sxy > 0) {
+		page_ns = max_t(s64, div64_s64(sxy, sxx), 1);
+		fitted = true;
+	} else {
+		page_ns = DIV64_U64_ROUND_UP((u64)IOC_PAGE_SIZE * NSEC_PER_SEC,
+					     u[0] ?: 1) ?: 1;
+	}
+	u[0] = div64_u64((u64)IOC_PAGE_SIZE * NSEC_PER_SEC, page_ns);
+
+	for (seq = 0; seq < 2; seq++) {
+		if (g[seq].nr < IOC_CALIB_MIN_SAMPLES)
+			continue;
+		base_ns = div64_s64((s64)g[seq].sum_y -
+				    page_ns * (s64)g[seq].sum_x, g[seq].nr);
+		base_ns = max_t(s64, base_ns, 0);
+		u[seq ? 1 : 2] = div64_u64(NSEC_PER_SEC, base_ns + page_ns);
+	}
+
+	if (!fitted)
+		return 0;
+
+	/* the residual is what the per-page cost leaves unexplained */
+	res = syy_us - mul_u64_u64_div_u64(sxy, page_ns,
+					   NSEC_PER_USEC * NSEC_PER_USEC);
+	tot = sum_yy_us - div64_u64(sum_y_us * sum_y_us, n);
+	if (tot <= 0)
+		return 0;
+	return clamp_t(s64, 1000 - div64_s64(max_t(s64, res, 0) * 1000, tot),
+		       0, 1000);
+}
+
+static void ioc_calib_fit_workfn(struct work_struct *work)
+{
+	struct ioc *ioc = container_of(work, struct ioc, calib.fit_work);
+	struct ioc_calib *cb = &ioc->calib;
+	struct ioc_calib_group groups[2][2];
+	u64 u[NR_I_LCOEFS];
+	bool full = true;
+	u32 r2[2];
+	int rw, seq;
+
+	spin_lock_irq(&ioc->lock);
+	spin_lock(&cb->lock);
+	if (cb->state != IOC_CALIB_RUNNING) {
+		spin_unlock(&cb->lock);
+		goto out;
+	}
+	memcpy(groups, cb->groups, sizeof(groups));
+	spin_unlock(&cb->lock);
+
+	memcpy(u, ioc->params.i_lcoefs, sizeof(u));
+	for (rw = READ; rw <= WRITE; rw++) {
+		r2[rw] = ioc_calib_fit_dir(groups[rw],
+				&u[rw == READ ? I_LCOEF_RBPS : I_LCOEF_WBPS]);
+		for (seq = 0; seq < 2; seq++)
+			if (groups[rw][seq].nr < IOC_CALIB_SAMPLES)
+				full = false;
+	}
+
+	memcpy(ioc->params.i_lcoefs, u, sizeof(u));
+	ioc_refresh_params(ioc, true);
+
+	spin_lock(&cb->lock);
+	memcpy(cb->r2, r2, sizeof(r2));
+	spin_unlock(&cb->lock);
+	if (full)
+		ioc_calib_stop(ioc, IOC_CALIB_DONE);
+out:
+	spin_unlock_irq(&ioc->lock);
+}
+
+static void ioc_rqos_issue(struct rq_qos *rqos, struct request *rq)
+{
+	struct ioc_calib *cb = &rqos_to_ioc(rqos)->calib;
+	unsigned long flags;
+	u64 seek_pages;
+
+	if (READ_ONCE(cb->state) != IOC_CALIB_RUNNING)
+		return;
+
+	spin_lock_irqsave(&cb->lock, flags);
+	if (!cb->inflight++) {
+		seek_pages = abs((s64)blk_rq_pos(rq) - (s64)cb->cursor) >>
+			IOC_SECT_TO_PAGE_SHIFT;
+		cb->solo_start_ns = rq->io_start_time_ns;
+		cb->solo_seq = cb->cursor && seek_pages <= LCOEF_RANDIO_PAGES;
+	} else {
+		cb->solo_start_ns = 0;
+	}
+	cb->cursor = blk_rq_pos(rq) + blk_rq_sectors(rq);
+	spin_unlock_irqrestore(&cb->lock, flags);
+}
+
+static void ioc_rqos_requeue(struct rq_qos *rqos, struct request *rq)
+{
+	struct ioc_calib *cb = &rqos_to_ioc(rqos)->calib;
+	unsigned long flags;
+
+	if (READ_ONCE(cb->state) != IOC_CALIB_RUNNING ||
+	    !(rq->rq_flags & RQF_STATS))
+		return;
+
+	spin_lock_irqsave(&cb->lock, flags);
+	if (cb->inflight)
+		cb->inflight--;
+	cb->solo_start_ns = 0;
+	spin_unlock_irqrestore(&cb->lock, flags);
+}
+
+static void ioc_calib_done(struct ioc *ioc, struct request *rq)
+{
+	struct ioc_calib *cb = &ioc->calib;
+	struct ioc_calib_group *grp;
+	unsigned long flags;
+	bool solo, fit = false;
+	u64 now, x, y;
+	int rw;
+
+	if (READ_ONCE(cb->state) != IOC_CALIB_RUNNING ||
+	    !(rq->rq_flags & RQF_STATS))
+		return;
+
+	switch (req_op(rq)) {
+	case REQ_OP_READ:
+		rw = READ;
+		break;
+	case REQ_OP_WRITE:
+		rw = WRITE;
+		break;
+	default:
+		rw = -1;
+	}
+
+	now = blk_time_get_ns();
+	x = max_t(u64, blk_rq_stats_sectors(rq) >> IOC_SECT_TO_PAGE_SHIFT, 1);
+
+	spin_lock_irqsave(&cb->lock, flags);
+	if (cb->state != IOC_CALIB_RUNNING)
+		goto out;
+	solo = cb->inflight == 1 && cb->solo_start_ns &&
+		cb->solo_start_ns == rq->io_start_time_ns;
+	if (cb->inflight)
+		cb->inflight--;
+	cb->solo_start_ns = 0;
+
+	if (!solo || rw < 0 || now <= rq->io_start_time_ns)
+		goto out;
+	y = now - rq->io_start_time_ns;
+	if (x > IOC_CALIB_MAX_PAGES || y > IOC_CALIB_MAX_LAT_NS)
+		goto out;
+
+	grp = &cb->groups[rw][cb->solo_seq];
+	if (grp->nr >= IOC_CALIB_SAMPLES)
+		goto out;
+	grp->nr++;
+	grp->sum_x += x;
+	grp->sum_xx += x * x;
+	grp->sum_y += y;
+	grp->sum_xy += x * y;
+	grp->sum_yy_us += div_u64(y, NSEC_PER_USEC) * div_u64(y, NSEC_PER_USEC);
+
+	if (++cb->since_fit >= IOC_CALIB_FIT_INTERVAL) {
+		cb->since_fit = 0;
+		fit = true;
+	}
+out:
+	spin_unlock_irqrestore(&cb->lock, flags);
+
+	/* completions may run in hardirq context, fit from process context */
+	if (fit)
+		schedule_work(&cb->fit_work);
+}
+
 static void ioc_rqos_done(struct rq_qos *rqos, struct request *rq)
 {
 	struct ioc *ioc = rqos_to_ioc(rqos);
@@ -2814,6 +3110,8 @@ static void ioc_rqos_done(struct rq_qos *rqos, struct request *rq)
 	u64 on_q_ns, rq_wait_ns, size_nsec;
 	int pidx, rw;
 
+	ioc_calib_done(ioc, rq);
+
 	if (!ioc->enabled || !rq->alloc_time_ns || !rq->start_time_ns)
 		return;
 
@@ -2864,8 +3162,10 @@ static void ioc_rqos_exit(struct rq_qos *rqos)
 
 	spin_lock_irq(&ioc->lock);
 	ioc->running = IOC_STOP;
+	ioc_calib_stop(ioc, IOC_CALIB_OFF);
 	spin_unlock_irq(&ioc->lock);
 
+	cancel_work_sync(&ioc->calib.fit_work);
 	timer_shutdown_sync(&ioc->timer);
 	free_percpu(ioc->pcpu_stat);
 	kfree(ioc);
@@ -2874,6 +3174,8 @@ static void ioc_rqos_exit(struct rq_qos *rqos)
 static const struct rq_qos_ops ioc_rqos_ops = {
 	.throttle = ioc_rqos_throttle,
 	.merge = ioc_rqos_merge,
+	.issue = ioc_rqos_issue,
+	.requeue = ioc_rqos_requeue,
 	.done_bio = ioc_rqos_done_bio,
 	.done = ioc_rqos_done,
 	.queue_depth_changed = ioc_rqos_queue_depth_changed,
@@ -2906,6 +3208,8 @@ static int blk_iocost_init(struct gendisk *disk)
 	}
 
 	spin_lock_init(&ioc->lock);
+	spin_lock_init(&ioc->calib.lock);
+	INIT_WORK(&ioc->calib.fit_work, ioc_calib_fit_workfn);
 	timer_setup(&ioc->timer, ioc_timer_fn, 0);
 	INIT_LIST_HEAD(&ioc->active_iocgs);
 
@@ -3363,6 +3667,28 @@ static ssize_t ioc_qos_write(struct kernfs_open_file *of, char *input,
 	return ret;
 }
 
+/*
+ * Sample counts per direction and sequentiality, and the coefficient of
+ * determination of the fit in percent, so that userspace can tell how far
+ * to trust the calibrated model.
+ */
+static void ioc_calib_print(struct seq_file *sf, struct ioc_calib *cb)
+{
+	struct ioc_calib_group (*g)[2] = cb->groups;
+	unsigned long flags;
+
+	spin_lock_irqsave(&cb->lock, flags);
+	seq_printf(sf, " calib=%s "
+		   "rseq_samples=%u rrand_samples=%u rfit=%u.%u "
+		   "wseq_samples=%u wrand_samples=%u wfit=%u.%u",
+		   cb->state == IOC_CALIB_DONE ? "done" : "running",
+		   g[READ][1].nr, g[READ][0].nr,
+		   cb->r2[READ] / 10, cb->r2[READ] % 10,
+		   g[WRITE][1].nr, g[WRITE][0].nr,
+		   cb->r2[WRITE] / 10, cb->r2[WRITE] % 10);
+	spin_unlock_irqrestore(&cb->lock, flags);
+}
+
 static u64 ioc_cost_model_prfill(struct seq_file *sf,
 				 struct blkg_policy_data *pd, int off)
 {
@@ -3376,10 +3702,14 @@ static u64 ioc_cost_model_prfill(struct seq_file *sf,
 	spin_lock(&ioc->lock);
 	seq_printf(sf, "%s ctrl=%s model=linear "
 		   "rbps=%llu rseqiops=%llu rrandiops=%llu "
-		   "wbps=%llu wseqiops=%llu wrandiops=%llu\n",
-		   dname, ioc->user_cost_model ? "user" : "auto",
+		   "wbps=%llu wseqiops=%llu wrandiops=%llu",
+		   dname, ioc->calib.state != IOC_CALIB_OFF ? "calib" :
+		   ioc->user_cost_model ? "user" : "auto",
 		   u[I_LCOEF_RBPS], u[I_LCOEF_RSEQIOPS], u[I_LCOEF_RRANDIOPS],
 		   u[I_LCOEF_WBPS], u[I_LCOEF_WSEQIOPS], u[I_LCOEF_WRANDIOPS]);
+	if (ioc->calib.state != IOC_CALIB_OFF)
+		ioc_calib_print(sf, &ioc->calib);
+	seq_putc(sf, '\n');
 	spin_unlock(&ioc->lock);
 	return 0;
 }
@@ -3416,7 +3746,7 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 	struct request_queue *q;
 	struct ioc *ioc;
 	u64 u[NR_I_LCOEFS];
-	bool user;
+	bool user, calib = false;
 	char *body, *p;
 	int ret;
 
@@ -3464,6 +3794,8 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 				user = false;
 			else if (!strcmp(buf, "user"))
 				user = true;
+			else if (!strcmp(buf, "calib"))
+				calib = true;
 			else
 				goto einval;
 			continue;
@@ -3483,12 +3815,17 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 		user = true;
 	}
 
-	if (user) {
+	/* calibration starts from the current or the given coefficients */
+	if (user || calib) {
 		memcpy(ioc->params.i_lcoefs, u, sizeof(u));
 		ioc->user_cost_model = true;
 	} else {
 		ioc->user_cost_model = false;
 	}
+	if (calib)
+		ioc_calib_start(ioc);
+	else
+		ioc_calib_stop(ioc, IOC_CALIB_OFF);
 	ioc_refresh_params(ioc, true);
 	spin_unlock_irq(&ioc->lock);
 
@@ -4547,6 +4547,7 @@ int blk_mq_init_allocated_queue(struct blk_mq_tag_set *set,
 	spin_lock_init(&q->requeue_lock);
 
 	q->nr_requests = set->queue_depth;
+	q->poll_nsec = BLK_MQ_POLL_CLASSIC;
 
 	blk_mq_init_cpu_queues(q, set->nr_hw_queues);
 	blk_mq_add_queue_tag_set(set, q);
@@ -5095,6 +5096,141 @@ static int blk_hctx_poll(struct request_queue *q, struct blk_mq_hw_ctx *hctx,
 	return 0;
 }
 
+static int blk_mq_poll_bucket(int ddir, unsigned int sectors)
+{
+	if (!sectors)
+		return -1;
+	return min_t(int, ddir + 2 * ilog2(sectors),
+		     ddir + BLK_MQ_POLL_STATS_BKTS - 2);
+}
+
+static int blk_mq_poll_stats_bkt(const struct request *rq)
+{
+	return blk_mq_poll_bucket(rq_data_dir(rq), blk_rq_stats_sectors(rq));
+}
+
+static void blk_mq_poll_stats_fn(struct blk_stat_callback *cb)
+{
+	struct request_queue *q = cb->data;
+	int bucket;
+
+	for (bucket = 0; bucket < BLK_MQ_POLL_STATS_BKTS; bucket++) {
+		if (cb->stat[bucket].nr_samples)
+			q->poll_stat[bucket] = cb->stat[bucket];
+	}
+}
+
+/*
+ * Set the hybrid polling sleep, see struct request_queue.  Completion times
+ * are only sampled while the adaptive mode is selected.  Called with the
+ * queue frozen, so nobody is polling.
+ */
+int blk_mq_poll_set_delay(struct request_queue *q, int nsec)
+{
+	if (nsec < BLK_MQ_POLL_CLASSIC)
+		return -EINVAL;
+	if (nsec == q->poll_nsec)
+		return 0;
+
+	if (!nsec && !q->poll_cb) {
+		q->poll_stat = kcalloc(BLK_MQ_POLL_STATS_BKTS,
+				       sizeof(*q->poll_stat), GFP_KERNEL);
+		if (!q->poll_stat)
+			return -ENOMEM;
+		q->poll_cb = blk_stat_alloc_callback(blk_mq_poll_stats_fn,
+				blk_mq_poll_stats_bkt,
+				BLK_MQ_POLL_STATS_BKTS, q);
+		if (!q->poll_cb) {
+			kfree(q->poll_stat);
+			q->poll_stat = NULL;
+			return -ENOMEM;
+		}
+	}
+
+	if (!nsec)
+		blk_stat_add_callback(q, q->poll_cb);
+	else if (!q->poll_nsec)
+		blk_stat_remove_callback(q, q->poll_cb);
+	WRITE_ONCE(q->poll_nsec, nsec);
+	return 0;
+}
+
+/* Must be called before the queue stats go away. */
+void blk_mq_poll_free_stats(struct request_queue *q)
+{
+	if (!q->poll_cb)
+		return;
+	if (!q->poll_nsec)
+		blk_stat_remove_callback(q, q->poll_cb);
+	blk_stat_free_callback(q->poll_cb);
+	kfree(q->poll_stat);
+}
+
+static unsigned long blk_mq_poll_nsecs(struct request_queue *q,
+		struct bio *bio, int nsec)
+{
+	struct blk_rq_stat *stat;
+	int bucket;
+
+	if (nsec > 0)
+		return nsec;
+
+	/* keep sampling for as long as somebody polls */
+	if (!blk_stat_is_active(q->poll_cb))
+		blk_stat_activate_msecs(q->poll_cb, 100);
+
+	/*
+	 * As an optimistic guess, sleep for half of the mean service time of
+	 * requests of this direction and size.
+	 */
+	bucket = blk_mq_poll_bucket(op_is_write(bio_op(bio)), bio_sectors(bio));
+	if (bucket < 0)
+		return 0;
+	stat = &q->poll_stat[bucket];
+	if (!stat->nr_samples)
+		return 0;
+	return (stat->mean + 1) / 2;
+}
+
+/*
+ * Sleep before the first poll of a bio instead of spinning for the whole
+ * service time.  Only done for callers that poll a single bio until it
+ * completes; returns true if we slept and the caller should check for
+ * completion again.
+ */
+bool blk_mq_poll_hybrid(struct request_queue *q, struct bio *bio,
+		blk_qc_t cookie, unsigned int flags)
+{
+	struct hrtimer_sleeper hs;
+	unsigned long nsecs;
+	int nsec;
+
+	if ((cookie & BLK_QC_T_SLEPT) || (flags & BLK_POLL_ONESHOT))
+		return false;
+	nsec = READ_ONCE(q->poll_nsec);
+	if (nsec == BLK_MQ_POLL_CLASSIC || !blk_mq_can_poll(q))
+		return false;
+
+	nsecs = blk_mq_poll_nsecs(q, bio, nsec);
+	if (!nsecs)
+		return false;
+
+	/* the bio may have completed and been reused, leave that one alone */
+	if (cmpxchg(&bio->bi_cookie, cookie, cookie | BLK_QC_T_SLEPT) != cookie)
+		return false;
+
+	hrtimer_init_sleeper_on_stack(&hs, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	hrtimer_set_expires(&hs.timer, ns_to_ktime(nsecs));
+	set_current_state(TASK_UNINTERRUPTIBLE);
+	hrtimer_sleeper_start_expires(&hs, HRTIMER_MODE_REL);
+	if (hs.task)
+		io_schedule();
+	hrtimer_cancel(&hs.timer);
+	__set_current_state(TASK_RUNNING);
+	destroy_hrtimer_on_stack(&hs.timer);
+	return true;
+}
+
 int blk_mq_poll(struct request_queue *q, blk_qc_t cookie,
 		struct io_comp_batch *iob, unsigned int flags)
 {
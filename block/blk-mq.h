@@ -44,6 +44,10 @@ typedef unsigned int __bitwise blk_insert_t;
 void blk_mq_submit_bio(struct bio *bio);
 int blk_mq_poll(struct request_queue *q, blk_qc_t cookie, struct io_comp_batch *iob,
 		unsigned int flags);
+bool blk_mq_poll_hybrid(struct request_queue *q, struct bio *bio,
+		blk_qc_t cookie, unsigned int flags);
+int blk_mq_poll_set_delay(struct request_queue *q, int nsec);
+void blk_mq_poll_free_stats(struct request_queue *q);
 void blk_mq_exit_queue(struct request_queue *q);
 int blk_mq_update_nr_requests(struct request_queue *q, unsigned int nr);
 void blk_mq_wake_waiters(struct request_queue *q);
@@ -451,6 +455,9 @@ do {								\
 #define blk_mq_run_dispatch_ops(q, dispatch_ops)		\
 	__blk_mq_run_dispatch_ops(q, true, dispatch_ops)	\
 
+#define BLK_MQ_POLL_CLASSIC	-1
+#define BLK_MQ_POLL_STATS_BKTS	16
+
 static inline bool blk_mq_can_poll(struct request_queue *q)
 {
 	return (q->limits.features & BLK_FEAT_POLL) &&
@@ -150,7 +150,15 @@ static ssize_t queue_##_name##_show(struct gendisk *disk, char *page)	\
 /* deprecated fields */
 QUEUE_SYSFS_SHOW_CONST(discard_zeroes_data, 0)
 QUEUE_SYSFS_SHOW_CONST(write_same_max, 0)
-QUEUE_SYSFS_SHOW_CONST(poll_delay, -1)
+
+static ssize_t queue_poll_delay_show(struct gendisk *disk, char *page)
+{
+	int nsec = READ_ONCE(disk->queue->poll_nsec);
+
+	if (!queue_is_mq(disk->queue) || nsec == BLK_MQ_POLL_CLASSIC)
+		return sprintf(page, "%d\n", BLK_MQ_POLL_CLASSIC);
+	return sprintf(page, "%d\n", nsec / 1000);
+}
 
 static ssize_t queue_max_discard_sectors_store(struct gendisk *disk,
 		const char *page, size_t count)
@@ -338,9 +346,31 @@ queue_rq_affinity_store(struct gendisk *disk, const char *page, size_t count)
 	return ret;
 }
 
+/*
+ * -1 spins until completion, 0 sleeps for half the mean completion time
+ * before spinning, and any other value sleeps for that many microseconds.
+ */
 static ssize_t queue_poll_delay_store(struct gendisk *disk, const char *page,
 				size_t count)
 {
+	struct request_queue *q = disk->queue;
+	int err, val;
+
+	if (!queue_is_mq(q) || !(q->limits.features & BLK_FEAT_POLL))
+		return -EINVAL;
+
+	err = kstrtoint(page, 10, &val);
+	if (err < 0)
+		return err;
+	if (val != BLK_MQ_POLL_CLASSIC) {
+		if (val < 0 || val > INT_MAX / 1000)
+			return -EINVAL;
+		val *= 1000;
+	}
+
+	err = blk_mq_poll_set_delay(q, val);
+	if (err)
+		return err;
 	return count;
 }
 
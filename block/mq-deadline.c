@@ -37,6 +37,11 @@ static const int prio_aging_expire = 10 * HZ;
 static const int writes_starved = 2;    /* max times reads can starve a write */
 static const int fifo_batch = 16;       /* # of sequential requests treated as one
 				     by the above parameters. For throughput. */
+/*
+ * How long lower priority requests are throttled after a request of a
+ * priority with a latency target took longer than that target.
+ */
+static const int latency_throttle_window = HZ / 10;
 
 enum dd_data_dir {
 	DD_READ		= READ,
@@ -54,6 +59,9 @@ enum dd_prio {
 
 enum { DD_PRIO_COUNT = 3 };
 
+/* Completion latency histogram buckets: [2^i, 2^(i+1)) microseconds. */
+enum { DD_LAT_BUCKETS = 24 };
+
 /*
  * I/O statistics per I/O priority. It is fine if these counters overflow.
  * What matters is that these counters are at least as wide as
@@ -66,6 +74,17 @@ struct io_stats_per_prio {
 	atomic_t completed;
 };
 
+/*
+ * Latencies from allocation to completion, updated without holding
+ * dd->lock from dd_finish_request().
+ */
+struct io_latency_per_prio {
+	atomic_t hist[DD_LAT_BUCKETS];
+	atomic_t missed;
+	/* jiffies of the most recent completion that missed the target */
+	unsigned long missed_at;
+};
+
 /*
  * Deadline scheduler data per I/O priority (enum dd_prio). Requests are
  * present on both sort_list[] and fifo_list[].
@@ -77,6 +96,9 @@ struct dd_per_prio {
 	/* Position of the most recently dispatched request. */
 	sector_t latest_pos[DD_DIR_COUNT];
 	struct io_stats_per_prio stats;
+	struct io_latency_per_prio lat;
+	/* target completion latency in nanoseconds, 0 if none */
+	u64 latency_target;
 };
 
 struct deadline_data {
@@ -258,6 +280,17 @@ static u32 dd_queued(struct deadline_data *dd, enum dd_prio prio)
 	return stats->inserted - atomic_read(&stats->completed);
 }
 
+/* Number of requests owned by the block driver for a given priority. */
+static u32 dd_owned_by_driver(struct deadline_data *dd, enum dd_prio prio)
+{
+	const struct io_stats_per_prio *stats = &dd->per_prio[prio].stats;
+
+	lockdep_assert_held(&dd->lock);
+
+	return stats->dispatched + stats->merged -
+		atomic_read(&stats->completed);
+}
+
 /*
  * deadline_check_fifo returns true if and only if there are expired requests
  * in the FIFO list. Requires !list_empty(&dd->fifo_list[data_dir]).
@@ -451,6 +484,32 @@ static struct request *dd_dispatch_prio_aged_requests(struct deadline_data *dd,
 	return NULL;
 }
 
+/*
+ * Returns true if a higher priority with a latency target recently missed
+ * it and @prio already has a request in flight. Keeping lower priorities
+ * to a single request lets the device drain its queue for the higher one.
+ */
+static bool dd_prio_throttled(struct deadline_data *dd, enum dd_prio prio)
+{
+	enum dd_prio hi;
+
+	lockdep_assert_held(&dd->lock);
+
+	if (!dd_owned_by_driver(dd, prio))
+		return false;
+
+	for (hi = 0; hi < prio; hi++) {
+		struct dd_per_prio *per_prio = &dd->per_prio[hi];
+
+		if (per_prio->latency_target &&
+		    atomic_read(&per_prio->lat.missed) &&
+		    time_before(jiffies, READ_ONCE(per_prio->lat.missed_at) +
+				latency_throttle_window))
+			return true;
+	}
+	return false;
+}
+
 /*
  * Called from blk_mq_run_hw_queue() -> __blk_mq_sched_dispatch_requests().
  *
@@ -473,9 +532,12 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 
 	/*
 	 * Next, dispatch requests in priority order. Ignore lower priority
-	 * requests if any higher priority requests are pending.
+	 * requests if any higher priority requests are pending or if a
+	 * higher priority is missing its latency target.
 	 */
 	for (prio = 0; prio <= DD_PRIO_MAX; prio++) {
+		if (dd_prio_throttled(dd, prio))
+			break;
 		rq = __dd_dispatch_request(dd, &dd->per_prio[prio], now);
 		if (rq || dd_queued(dd, prio))
 			break;
@@ -747,6 +809,18 @@ static void dd_prepare_request(struct request *rq)
 	rq->elv.priv[0] = NULL;
 }
 
+static void dd_account_latency(struct dd_per_prio *per_prio, u64 lat)
+{
+	u64 us = div_u64(lat, NSEC_PER_USEC);
+	int bucket = us ? min_t(int, ilog2(us), DD_LAT_BUCKETS - 1) : 0;
+
+	atomic_inc(&per_prio->lat.hist[bucket]);
+	if (per_prio->latency_target && lat > per_prio->latency_target) {
+		WRITE_ONCE(per_prio->lat.missed_at, jiffies);
+		atomic_inc(&per_prio->lat.missed);
+	}
+}
+
 /*
  * Callback from inside blk_mq_free_request().
  */
@@ -759,8 +833,13 @@ static void dd_finish_request(struct request *rq)
 	 * called dd_insert_requests(). Skip requests that bypassed I/O
 	 * scheduling. See also blk_mq_request_bypass_insert().
 	 */
-	if (per_prio)
-		atomic_inc(&per_prio->stats.completed);
+	if (!per_prio)
+		return;
+
+	if (rq->start_time_ns)
+		dd_account_latency(per_prio,
+				   blk_time_get_ns() - rq->start_time_ns);
+	atomic_inc(&per_prio->stats.completed);
 }
 
 static bool dd_has_work_for_prio(struct dd_per_prio *per_prio)
@@ -800,7 +879,19 @@ SHOW_INT(deadline_writes_starved_show, dd->writes_starved);
 SHOW_INT(deadline_front_merges_show, dd->front_merges);
 SHOW_INT(deadline_async_depth_show, dd->async_depth);
 SHOW_INT(deadline_fifo_batch_show, dd->fifo_batch);
+#define SHOW_NSEC_AS_USEC(__FUNC, __VAR)				\
+static ssize_t __FUNC(struct elevator_queue *e, char *page)		\
+{									\
+	struct deadline_data *dd = e->elevator_data;			\
+									\
+	return sysfs_emit(page, "%llu\n", div_u64(__VAR, NSEC_PER_USEC));	\
+}
+SHOW_NSEC_AS_USEC(deadline_rt_latency_target_show,
+		  dd->per_prio[DD_RT_PRIO].latency_target);
+SHOW_NSEC_AS_USEC(deadline_be_latency_target_show,
+		  dd->per_prio[DD_BE_PRIO].latency_target);
 #undef SHOW_INT
+#undef SHOW_NSEC_AS_USEC
 #undef SHOW_JIFFIES
 
 #define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
@@ -834,6 +925,26 @@ STORE_INT(deadline_fifo_batch_store, &dd->fifo_batch, 0, INT_MAX);
 #undef STORE_INT
 #undef STORE_JIFFIES
 
+/* Latency targets are set in microseconds, 0 disables them. */
+#define STORE_USEC_AS_NSEC(__FUNC, __PTR)				\
+static ssize_t __FUNC(struct elevator_queue *e, const char *page, size_t count)	\
+{									\
+	struct deadline_data *dd = e->elevator_data;			\
+	u32 __data;							\
+	int __ret;							\
+									\
+	__ret = kstrtou32(page, 0, &__data);				\
+	if (__ret < 0)							\
+		return __ret;						\
+	WRITE_ONCE(*(__PTR), (u64)__data * NSEC_PER_USEC);		\
+	return count;							\
+}
+STORE_USEC_AS_NSEC(deadline_rt_latency_target_store,
+		   &dd->per_prio[DD_RT_PRIO].latency_target);
+STORE_USEC_AS_NSEC(deadline_be_latency_target_store,
+		   &dd->per_prio[DD_BE_PRIO].latency_target);
+#undef STORE_USEC_AS_NSEC
+
 #define DD_ATTR(name) \
 	__ATTR(name, 0644, deadline_##name##_show, deadline_##name##_store)
 
@@ -845,6 +956,8 @@ static struct elv_fs_entry deadline_attrs[] = {
 	DD_ATTR(async_depth),
 	DD_ATTR(fifo_batch),
 	DD_ATTR(prio_aging_expire),
+	DD_ATTR(rt_latency_target),
+	DD_ATTR(be_latency_target),
 	__ATTR_NULL
 };
 
@@ -955,17 +1068,6 @@ static int dd_queued_show(void *data, struct seq_file *m)
 	return 0;
 }
 
-/* Number of requests owned by the block driver for a given priority. */
-static u32 dd_owned_by_driver(struct deadline_data *dd, enum dd_prio prio)
-{
-	const struct io_stats_per_prio *stats = &dd->per_prio[prio].stats;
-
-	lockdep_assert_held(&dd->lock);
-
-	return stats->dispatched + stats->merged -
-		atomic_read(&stats->completed);
-}
-
 static int dd_owned_by_driver_show(void *data, struct seq_file *m)
 {
 	struct request_queue *q = data;
@@ -983,6 +1085,55 @@ static int dd_owned_by_driver_show(void *data, struct seq_file *m)
 	return 0;
 }
 
+/*
+ * Upper bound in microseconds of the histogram bucket holding the @pct
+ * per mille percentile.
+ */
+static u64 dd_latency_percentile(const u32 *hist, u64 total, unsigned int pct)
+{
+	u64 want = div_u64(total * pct + 999, 1000), seen = 0;
+	int i;
+
+	for (i = 0; i < DD_LAT_BUCKETS - 1; i++) {
+		seen += hist[i];
+		if (seen >= want)
+			break;
+	}
+	return 2ULL << i;
+}
+
+static int dd_latency_show(void *data, struct seq_file *m)
+{
+	static const char * const names[DD_PRIO_COUNT] = { "rt", "be", "idle" };
+	struct request_queue *q = data;
+	struct deadline_data *dd = q->elevator->elevator_data;
+	u32 hist[DD_LAT_BUCKETS];
+	enum dd_prio prio;
+	u64 total;
+	int i;
+
+	for (prio = 0; prio <= DD_PRIO_MAX; prio++) {
+		struct dd_per_prio *per_prio = &dd->per_prio[prio];
+
+		total = 0;
+		for (i = 0; i < DD_LAT_BUCKETS; i++) {
+			hist[i] = atomic_read(&per_prio->lat.hist[i]);
+			total += hist[i];
+		}
+		seq_printf(m, "%s: samples %llu missed %u", names[prio], total,
+			   atomic_read(&per_prio->lat.missed));
+		if (total)
+			seq_printf(m, " p50 %llu p90 %llu p99 %llu p999 %llu",
+				   dd_latency_percentile(hist, total, 500),
+				   dd_latency_percentile(hist, total, 900),
+				   dd_latency_percentile(hist, total, 990),
+				   dd_latency_percentile(hist, total, 999));
+		seq_puts(m, "\n");
+	}
+
+	return 0;
+}
+
 #define DEADLINE_DISPATCH_ATTR(prio)					\
 static void *deadline_dispatch##prio##_start(struct seq_file *m,	\
 					     loff_t *pos)		\
@@ -1053,6 +1204,7 @@ static const struct blk_mq_debugfs_attr deadline_queue_debugfs_attrs[] = {
 	{"dispatch2", 0400, .seq_ops = &deadline_dispatch2_seq_ops},
 	{"owned_by_driver", 0400, dd_owned_by_driver_show},
 	{"queued", 0400, dd_queued_show},
+	{"latency", 0400, dd_latency_show},
 	{},
 };
 #undef DEADLINE_QUEUE_DDIR_ATTRS
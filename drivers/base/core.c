@@ -2557,6 +2557,8 @@ static void device_release(struct kobject *kobj)
 	 * possible memory leak.
 	 */
 	devres_release_all(dev);
+	dma_recycle_drain(dev);
+	swiotlb_dev_release(dev);
 
 	kfree(dev->dma_range_map);
 
@@ -240,7 +240,9 @@ static void dprc_add_new_devices(struct fsl_mc_device *mc_bus_dev,
  * devices can allocate any type of allocatable devices.
  * That is, we need to ensure that the corresponding resource pools are
  * populated before they can get allocation requests from probe callbacks
- * of the device drivers for the non-allocatable devices.
+ * of the device drivers for the non-allocatable devices. The allocator
+ * driver always probes synchronously for that reason, while the other
+ * devices may be probed in parallel when the bus async_probe option is set.
  */
 int dprc_scan_objects(struct fsl_mc_device *mc_bus_dev,
 		      bool alloc_interrupts)
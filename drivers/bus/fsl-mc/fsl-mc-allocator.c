@@ -246,7 +246,14 @@ void fsl_mc_resource_free(struct fsl_mc_resource *resource)
 	if (!list_empty(&resource->node))
 		goto out_unlock;
 
-	list_add_tail(&resource->node, &res_pool->free_list);
+	/*
+	 * Freed MC portals keep their DPMCP open, hand them out again first
+	 * so that re-probing drivers do not open a cold one.
+	 */
+	if (res_pool->type == FSL_MC_POOL_DPMCP)
+		list_add(&resource->node, &res_pool->free_list);
+	else
+		list_add_tail(&resource->node, &res_pool->free_list);
 	res_pool->free_count++;
 out_unlock:
 	mutex_unlock(&res_pool->mutex);
@@ -601,6 +608,9 @@ static void fsl_mc_allocator_remove(struct fsl_mc_device *mc_dev)
 			return;
 	}
 
+	if (is_fsl_mc_bus_dpmcp(mc_dev))
+		fsl_mc_portal_release(mc_dev);
+
 	dev_dbg(&mc_dev->dev,
 		"Allocatable fsl-mc device unbound from fsl_mc_allocator driver");
 }
@@ -625,6 +635,8 @@ static struct fsl_mc_driver fsl_mc_allocator_driver = {
 	.driver = {
 		   .name = "fsl_mc_allocator",
 		   .pm = NULL,
+		   /* pools must be populated before any consumer probes */
+		   .probe_type = PROBE_FORCE_SYNCHRONOUS,
 		   },
 	.match_id_table = match_id_table,
 	.probe = fsl_mc_allocator_probe,
@@ -32,6 +32,15 @@
 
 static struct fsl_mc_version mc_version;
 
+/*
+ * Each functional object driver talks to the MC through its own DPMCP, so
+ * probing the objects of a DPRC concurrently does not serialize on a portal.
+ */
+static bool async_probe;
+module_param(async_probe, bool, 0444);
+MODULE_PARM_DESC(async_probe,
+		 "Probe fsl-mc devices asynchronously, unless their driver asks otherwise");
+
 /**
  * struct fsl_mc - Private data of a "fsl,qoriq-mc" platform device
  * @root_mc_bus_dev: fsl-mc device representing the root DPRC
@@ -491,6 +500,9 @@ int __fsl_mc_driver_register(struct fsl_mc_driver *mc_driver,
 
 	mc_driver->driver.owner = owner;
 	mc_driver->driver.bus = &fsl_mc_bus_type;
+	if (async_probe &&
+	    mc_driver->driver.probe_type == PROBE_DEFAULT_STRATEGY)
+		mc_driver->driver.probe_type = PROBE_PREFER_ASYNCHRONOUS;
 
 	if (mc_driver->probe)
 		mc_driver->driver.probe = fsl_mc_driver_probe;
@@ -1283,6 +1295,8 @@ static int __init fsl_mc_bus_driver_init(void)
 {
 	int error;
 
+	fsl_mc_cmd_stats_init();
+
 	error = bus_register(&fsl_mc_bus_type);
 	if (error < 0) {
 		pr_err("bus type registration failed: %d\n", error);
@@ -49,11 +49,34 @@ struct dpmng_rsp_get_version {
 /* DPMCP command IDs */
 #define DPMCP_CMDID_CLOSE		DPMCP_CMD(0x800)
 #define DPMCP_CMDID_RESET		DPMCP_CMD(0x005)
+#define DPMCP_CMDID_SET_IRQ_ENABLE	DPMCP_CMD(0x012)
+#define DPMCP_CMDID_SET_IRQ_MASK	DPMCP_CMD(0x014)
+#define DPMCP_CMDID_CLEAR_IRQ_STATUS	DPMCP_CMD(0x017)
+
+/* DPMCP IRQ index and events */
+#define DPMCP_IRQ_INDEX			0
+#define DPMCP_IRQ_EVENT_CMD_DONE	0x00000001
 
 struct dpmcp_cmd_open {
 	__le32 dpmcp_id;
 };
 
+struct dpmcp_cmd_set_irq_enable {
+	u8 enable;
+	u8 pad[3];
+	u8 irq_index;
+};
+
+struct dpmcp_cmd_set_irq_mask {
+	__le32 mask;
+	u8 irq_index;
+};
+
+struct dpmcp_cmd_clear_irq_status {
+	__le32 status;
+	u8 irq_index;
+};
+
 /*
  * Initialization and runtime control APIs for DPMCP
  */
@@ -70,6 +93,24 @@ int dpmcp_reset(struct fsl_mc_io *mc_io,
 		u32 cmd_flags,
 		u16 token);
 
+int dpmcp_set_irq_enable(struct fsl_mc_io *mc_io,
+			 u32 cmd_flags,
+			 u16 token,
+			 u8 irq_index,
+			 u8 en);
+
+int dpmcp_set_irq_mask(struct fsl_mc_io *mc_io,
+		       u32 cmd_flags,
+		       u16 token,
+		       u8 irq_index,
+		       u32 mask);
+
+int dpmcp_clear_irq_status(struct fsl_mc_io *mc_io,
+			   u32 cmd_flags,
+			   u16 token,
+			   u8 irq_index,
+			   u32 status);
+
 /*
  * Data Path Resource Container (DPRC) API
  */
@@ -657,6 +698,8 @@ int __must_check fsl_create_mc_io(struct device *dev,
 
 void fsl_destroy_mc_io(struct fsl_mc_io *mc_io);
 
+void fsl_mc_portal_release(struct fsl_mc_device *dpmcp_dev);
+
 bool fsl_mc_is_root_dprc(struct device *dev);
 
 void fsl_mc_get_root_dprc(struct device *dev,
@@ -667,6 +710,16 @@ struct fsl_mc_device *fsl_mc_device_lookup(struct fsl_mc_obj_desc *obj_desc,
 
 u16 mc_cmd_hdr_read_cmdid(struct fsl_mc_command *cmd);
 
+bool mc_cmd_process_completion(struct fsl_mc_io *mc_io);
+
+#ifdef CONFIG_DEBUG_FS
+void fsl_mc_cmd_stats_init(void);
+#else
+static inline void fsl_mc_cmd_stats_init(void)
+{
+}
+#endif
+
 #ifdef CONFIG_FSL_MC_UAPI_SUPPORT
 
 int fsl_mc_uapi_create_device_file(struct fsl_mc_bus *mc_bus);
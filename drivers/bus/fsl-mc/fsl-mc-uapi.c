@@ -497,7 +497,8 @@ static int fsl_mc_uapi_dev_open(struct inode *inode, struct file *filep)
 		priv_data->mc_io = mc_uapi->static_mc_io;
 		mc_uapi->local_instance_in_use = 1;
 	} else {
-		error = fsl_mc_portal_allocate(root_mc_device, 0,
+		error = fsl_mc_portal_allocate(root_mc_device,
+					       FSL_MC_IO_CMD_COMPLETION_IRQ,
 					       &dynamic_mc_io);
 		if (error) {
 			dev_dbg(&root_mc_device->dev,
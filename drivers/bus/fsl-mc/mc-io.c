@@ -49,6 +49,79 @@ static void fsl_mc_io_unset_dpmcp(struct fsl_mc_io *mc_io)
 	dpmcp_dev->mc_io = NULL;
 }
 
+static irqreturn_t fsl_mc_io_irq_handler_thread(int irq_num, void *arg)
+{
+	struct fsl_mc_io *mc_io = arg;
+
+	mc_cmd_process_completion(mc_io);
+	return IRQ_HANDLED;
+}
+
+/*
+ * Arm the DPMCP command completion interrupt, so that commands sent through
+ * this portal are completed from its handler instead of by polling.
+ */
+static int fsl_mc_io_setup_irq(struct fsl_mc_io *mc_io)
+{
+	struct fsl_mc_device *dpmcp_dev = mc_io->dpmcp_dev;
+	int error, irq;
+
+	error = fsl_mc_allocate_irqs(dpmcp_dev);
+	if (error < 0)
+		return error;
+
+	irq = dpmcp_dev->irqs[DPMCP_IRQ_INDEX]->virq;
+	error = request_threaded_irq(irq, NULL, fsl_mc_io_irq_handler_thread,
+				     IRQF_ONESHOT, dev_name(&dpmcp_dev->dev),
+				     mc_io);
+	if (error < 0)
+		goto error_free_irqs;
+
+	error = dpmcp_set_irq_mask(mc_io, MC_CMD_FLAG_INTR_DIS,
+				   dpmcp_dev->mc_handle, DPMCP_IRQ_INDEX,
+				   DPMCP_IRQ_EVENT_CMD_DONE);
+	if (error < 0)
+		goto error_free_irq;
+
+	error = dpmcp_set_irq_enable(mc_io, MC_CMD_FLAG_INTR_DIS,
+				     dpmcp_dev->mc_handle, DPMCP_IRQ_INDEX, 1);
+	if (error < 0)
+		goto error_free_irq;
+
+	error = dpmcp_clear_irq_status(mc_io, MC_CMD_FLAG_INTR_DIS,
+				       dpmcp_dev->mc_handle, DPMCP_IRQ_INDEX,
+				       ~0U);
+	if (error < 0)
+		goto error_disable_irq;
+
+	WRITE_ONCE(mc_io->irq, irq);
+	return 0;
+
+error_disable_irq:
+	dpmcp_set_irq_enable(mc_io, MC_CMD_FLAG_INTR_DIS,
+			     dpmcp_dev->mc_handle, DPMCP_IRQ_INDEX, 0);
+error_free_irq:
+	free_irq(irq, mc_io);
+error_free_irqs:
+	fsl_mc_free_irqs(dpmcp_dev);
+	return error;
+}
+
+static void fsl_mc_io_teardown_irq(struct fsl_mc_io *mc_io)
+{
+	struct fsl_mc_device *dpmcp_dev = mc_io->dpmcp_dev;
+	int irq = mc_io->irq;
+
+	WARN_ON(!list_empty(&mc_io->cmd_queue));
+
+	/* back to polling for the commands below */
+	WRITE_ONCE(mc_io->irq, 0);
+	dpmcp_set_irq_enable(mc_io, MC_CMD_FLAG_INTR_DIS,
+			     dpmcp_dev->mc_handle, DPMCP_IRQ_INDEX, 0);
+	free_irq(irq, mc_io);
+	fsl_mc_free_irqs(dpmcp_dev);
+}
+
 /**
  * fsl_create_mc_io() - Creates an MC I/O object
  *
@@ -73,6 +146,11 @@ int __must_check fsl_create_mc_io(struct device *dev,
 	void __iomem *mc_portal_virt_addr;
 	struct resource *res;
 
+	/* completion interrupts are only waited for from non-atomic context */
+	if ((flags & FSL_MC_IO_ATOMIC_CONTEXT_PORTAL) &&
+	    (flags & FSL_MC_IO_CMD_COMPLETION_IRQ))
+		return -EINVAL;
+
 	mc_io = devm_kzalloc(dev, sizeof(*mc_io), GFP_KERNEL);
 	if (!mc_io)
 		return -ENOMEM;
@@ -85,6 +163,8 @@ int __must_check fsl_create_mc_io(struct device *dev,
 		raw_spin_lock_init(&mc_io->spinlock);
 	else
 		mutex_init(&mc_io->mutex);
+	spin_lock_init(&mc_io->queue_lock);
+	INIT_LIST_HEAD(&mc_io->cmd_queue);
 
 	res = devm_request_mem_region(dev,
 				      mc_portal_phys_addr,
@@ -112,6 +192,12 @@ int __must_check fsl_create_mc_io(struct device *dev,
 		error = fsl_mc_io_set_dpmcp(mc_io, dpmcp_dev);
 		if (error < 0)
 			goto error_destroy_mc_io;
+
+		/* the portal still works without it, just by polling */
+		if ((flags & FSL_MC_IO_CMD_COMPLETION_IRQ) &&
+		    fsl_mc_io_setup_irq(mc_io) < 0)
+			dev_dbg(dev, "Command completion IRQ unavailable for %s\n",
+				dev_name(&dpmcp_dev->dev));
 	}
 
 	*new_mc_io = mc_io;
@@ -136,6 +222,9 @@ void fsl_destroy_mc_io(struct fsl_mc_io *mc_io)
 
 	dpmcp_dev = mc_io->dpmcp_dev;
 
+	if (mc_io->irq)
+		fsl_mc_io_teardown_irq(mc_io);
+
 	if (dpmcp_dev)
 		fsl_mc_io_unset_dpmcp(mc_io);
 
@@ -204,15 +293,27 @@ int __must_check fsl_mc_portal_allocate(struct fsl_mc_device *mc_dev,
 		goto error_cleanup_resource;
 	}
 
-	mc_portal_phys_addr = dpmcp_dev->regions[0].start;
-	mc_portal_size = resource_size(dpmcp_dev->regions);
+	/*
+	 * Reuse the portal left mapped and open by the previous user, unless
+	 * it was set up for a different locking context.
+	 */
+	mc_io = dpmcp_dev->mc_io;
+	if (mc_io && mc_io->flags != mc_io_flags) {
+		fsl_destroy_mc_io(mc_io);
+		mc_io = NULL;
+	}
 
-	error = fsl_create_mc_io(&mc_bus_dev->dev,
-				 mc_portal_phys_addr,
-				 mc_portal_size, dpmcp_dev,
-				 mc_io_flags, &mc_io);
-	if (error < 0)
-		goto error_cleanup_resource;
+	if (!mc_io) {
+		mc_portal_phys_addr = dpmcp_dev->regions[0].start;
+		mc_portal_size = resource_size(dpmcp_dev->regions);
+
+		error = fsl_create_mc_io(&mc_bus_dev->dev,
+					 mc_portal_phys_addr,
+					 mc_portal_size, dpmcp_dev,
+					 mc_io_flags, &mc_io);
+		if (error < 0)
+			goto error_cleanup_resource;
+	}
 
 	/* If the DPRC device itself tries to allocate a portal (usually for
 	 * UAPI interaction), don't add a device link between them since the
@@ -264,13 +365,30 @@ void fsl_mc_portal_free(struct fsl_mc_io *mc_io)
 	if (resource->data != dpmcp_dev)
 		return;
 
-	fsl_destroy_mc_io(mc_io);
+	/*
+	 * Keep the portal mapped and the DPMCP open, so that the next
+	 * fsl_mc_portal_allocate() does not have to go through the MC again.
+	 * It is torn down by fsl_mc_portal_release() when the DPMCP goes away.
+	 */
 	fsl_mc_resource_free(resource);
 
 	dpmcp_dev->consumer_link = NULL;
 }
 EXPORT_SYMBOL_GPL(fsl_mc_portal_free);
 
+/**
+ * fsl_mc_portal_release - Tears down the MC I/O object cached on a DPMCP
+ *
+ * @dpmcp_dev: DPMCP device that is being removed from its resource pool
+ */
+void fsl_mc_portal_release(struct fsl_mc_device *dpmcp_dev)
+{
+	struct fsl_mc_io *mc_io = dpmcp_dev->mc_io;
+
+	if (mc_io && mc_io->dpmcp_dev == dpmcp_dev)
+		fsl_destroy_mc_io(mc_io);
+}
+
 /**
  * fsl_mc_portal_reset - Resets the dpmcp object for a given fsl_mc_io object
  *
@@ -10,6 +10,9 @@
 #include <linux/slab.h>
 #include <linux/ioport.h>
 #include <linux/device.h>
+#include <linux/debugfs.h>
+#include <linux/hash.h>
+#include <linux/seq_file.h>
 #include <linux/io.h>
 #include <linux/io-64-nonatomic-hi-lo.h>
 #include <linux/fsl/mc.h>
@@ -28,6 +31,115 @@
 #define MC_CMD_COMPLETION_POLLING_MIN_SLEEP_USECS    10
 #define MC_CMD_COMPLETION_POLLING_MAX_SLEEP_USECS    500
 
+/*
+ * Interval in milliseconds at which a thread waiting for a command completion
+ * interrupt re-checks the portal, in case the interrupt did not come
+ */
+#define MC_CMD_COMPLETION_IRQ_RECHECK_MS	10
+
+#ifdef CONFIG_DEBUG_FS
+/*
+ * Per command ID latency histogram: bucket i counts the commands that took
+ * less than 2^i microseconds, the last one also catches all the slower ones
+ */
+#define MC_CMD_STATS_SLOTS	256
+#define MC_CMD_STATS_BUCKETS	20
+
+struct mc_cmd_stats {
+	atomic_t cmd_id;	/* 0 while the slot is free */
+	atomic64_t count;
+	atomic64_t total_ns;
+	atomic_t buckets[MC_CMD_STATS_BUCKETS];
+};
+
+static struct mc_cmd_stats *mc_cmd_stats;
+
+static struct mc_cmd_stats *mc_cmd_stats_get(u16 cmd_id)
+{
+	unsigned int i, slot = hash_32(cmd_id, ilog2(MC_CMD_STATS_SLOTS));
+	struct mc_cmd_stats *stats;
+	int id;
+
+	for (i = 0; i < MC_CMD_STATS_SLOTS; i++) {
+		stats = &mc_cmd_stats[(slot + i) % MC_CMD_STATS_SLOTS];
+		id = atomic_read(&stats->cmd_id);
+		if (!id)
+			id = atomic_cmpxchg(&stats->cmd_id, 0, cmd_id) ? : cmd_id;
+		if (id == cmd_id)
+			return stats;
+	}
+
+	return NULL;
+}
+
+static void mc_cmd_stats_add(u16 cmd_id, ktime_t start)
+{
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	struct mc_cmd_stats *stats;
+	unsigned int bucket;
+
+	if (!mc_cmd_stats || !cmd_id)
+		return;
+
+	stats = mc_cmd_stats_get(cmd_id);
+	if (!stats)
+		return;
+
+	bucket = min_t(unsigned int, fls64(div_u64(ns, NSEC_PER_USEC)),
+		       MC_CMD_STATS_BUCKETS - 1);
+	atomic_inc(&stats->buckets[bucket]);
+	atomic64_inc(&stats->count);
+	atomic64_add(ns, &stats->total_ns);
+}
+
+static int mc_cmd_latency_show(struct seq_file *file, void *offset)
+{
+	struct mc_cmd_stats *stats;
+	u64 count;
+	int i, j;
+
+	seq_puts(file, "# cmd_id count avg_us, then commands per latency bucket:");
+	for (j = 0; j < MC_CMD_STATS_BUCKETS - 1; j++)
+		seq_printf(file, " <%luus", BIT(j));
+	seq_puts(file, " slower\n");
+
+	for (i = 0; i < MC_CMD_STATS_SLOTS; i++) {
+		stats = &mc_cmd_stats[i];
+		count = atomic64_read(&stats->count);
+		if (!atomic_read(&stats->cmd_id) || !count)
+			continue;
+
+		seq_printf(file, "%#06x %llu %llu", atomic_read(&stats->cmd_id),
+			   count, div64_u64(atomic64_read(&stats->total_ns),
+					    count * NSEC_PER_USEC));
+		for (j = 0; j < MC_CMD_STATS_BUCKETS; j++)
+			seq_printf(file, " %d", atomic_read(&stats->buckets[j]));
+		seq_putc(file, '\n');
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(mc_cmd_latency);
+
+void fsl_mc_cmd_stats_init(void)
+{
+	struct dentry *dir;
+
+	mc_cmd_stats = kcalloc(MC_CMD_STATS_SLOTS, sizeof(*mc_cmd_stats),
+			       GFP_KERNEL);
+	if (!mc_cmd_stats)
+		return;
+
+	dir = debugfs_create_dir("fsl_mc", NULL);
+	debugfs_create_file("cmd_latency", 0444, dir, NULL,
+			    &mc_cmd_latency_fops);
+}
+#else
+static inline void mc_cmd_stats_add(u16 cmd_id, ktime_t start)
+{
+}
+#endif
+
 static enum mc_cmd_status mc_cmd_hdr_read_status(struct fsl_mc_command *cmd)
 {
 	struct mc_cmd_header *hdr = (struct mc_cmd_header *)&cmd->header;
@@ -234,6 +346,201 @@ static int mc_polling_wait_atomic(struct fsl_mc_io *mc_io,
 	return 0;
 }
 
+static int mc_cmd_check_status(struct fsl_mc_io *mc_io,
+			       struct fsl_mc_command *cmd,
+			       enum mc_cmd_status status)
+{
+	if (status == MC_CMD_STATUS_OK)
+		return 0;
+
+	dev_dbg(mc_io->dev,
+		"MC command failed: portal: %pa, dprc handle: %#x, command: %#x, status: %s (%#x)\n",
+		 &mc_io->portal_phys_addr,
+		 (unsigned int)mc_cmd_hdr_read_token(cmd),
+		 (unsigned int)mc_cmd_hdr_read_cmdid(cmd),
+		 mc_status_to_string(status),
+		 (unsigned int)status);
+
+	return mc_status_to_error(status);
+}
+
+/*
+ * Clear the command completion event, so that the DPMCP signals the next one.
+ * This command must not raise an interrupt itself, so it is polled for.
+ * Called with queue_lock held, while the portal is idle.
+ */
+static void mc_cmd_irq_ack(struct fsl_mc_io *mc_io)
+{
+	struct fsl_mc_device *dpmcp_dev = mc_io->dpmcp_dev;
+	struct dpmcp_cmd_clear_irq_status *cmd_params;
+	struct fsl_mc_command cmd = { 0 };
+	enum mc_cmd_status status;
+
+	cmd.header = mc_encode_cmd_header(DPMCP_CMDID_CLEAR_IRQ_STATUS,
+					  MC_CMD_FLAG_INTR_DIS |
+					  MC_CMD_FLAG_PRI,
+					  dpmcp_dev->mc_handle);
+	cmd_params = (struct dpmcp_cmd_clear_irq_status *)cmd.params;
+	cmd_params->status = cpu_to_le32(DPMCP_IRQ_EVENT_CMD_DONE);
+	cmd_params->irq_index = DPMCP_IRQ_INDEX;
+
+	mc_write_command(mc_io->portal_virt_addr, &cmd);
+	if (mc_polling_wait_atomic(mc_io, &cmd, &status) ||
+	    status != MC_CMD_STATUS_OK)
+		dev_dbg(mc_io->dev,
+			"Failed to clear completion IRQ of dpmcp.%d\n",
+			dpmcp_dev->obj_desc.id);
+}
+
+/* Called with queue_lock held */
+static void mc_cmd_start(struct fsl_mc_io *mc_io,
+			 struct fsl_mc_async_cmd *acmd)
+{
+	acmd->start = ktime_get();
+	mc_write_command(mc_io->portal_virt_addr, &acmd->cmd);
+}
+
+/**
+ * mc_cmd_process_completion() - Completes the command the MC is working on,
+ *                               if it is done, and starts the next one
+ * @mc_io: MC I/O object with command completion interrupts armed
+ *
+ * Called from the command completion interrupt thread, and by threads waiting
+ * for a command in case the interrupt went missing. A command that the MC
+ * does not complete in time is failed with -ETIMEDOUT so the queue moves on.
+ *
+ * Returns true if a command was completed.
+ */
+bool mc_cmd_process_completion(struct fsl_mc_io *mc_io)
+{
+	struct fsl_mc_async_cmd *acmd, *next;
+	enum mc_cmd_status status;
+	unsigned long irq_flags;
+	u16 cmd_id;
+	ktime_t start;
+	int error;
+
+	spin_lock_irqsave(&mc_io->queue_lock, irq_flags);
+	acmd = list_first_entry_or_null(&mc_io->cmd_queue,
+					struct fsl_mc_async_cmd, node);
+	if (!acmd)
+		goto out_unlock;
+
+	status = mc_read_response(mc_io->portal_virt_addr, &acmd->cmd);
+	if (status == MC_CMD_STATUS_READY) {
+		if (ktime_ms_delta(ktime_get(), acmd->start) <
+		    MC_CMD_COMPLETION_TIMEOUT_MS)
+			goto out_unlock;
+
+		dev_dbg(mc_io->dev,
+			"MC command timed out (portal: %pa, dprc handle: %#x, command: %#x)\n",
+			 &mc_io->portal_phys_addr,
+			 (unsigned int)mc_cmd_hdr_read_token(&acmd->cmd),
+			 (unsigned int)acmd->cmd_id);
+		error = -ETIMEDOUT;
+	} else {
+		error = mc_cmd_check_status(mc_io, &acmd->cmd, status);
+		mc_cmd_irq_ack(mc_io);
+	}
+
+	list_del_init(&acmd->node);
+	next = list_first_entry_or_null(&mc_io->cmd_queue,
+					struct fsl_mc_async_cmd, node);
+	if (next)
+		mc_cmd_start(mc_io, next);
+	spin_unlock_irqrestore(&mc_io->queue_lock, irq_flags);
+
+	/* acmd may be gone once done() returns */
+	cmd_id = acmd->cmd_id;
+	start = acmd->start;
+	acmd->done(acmd, error);
+	mc_cmd_stats_add(cmd_id, start);
+	return true;
+
+out_unlock:
+	spin_unlock_irqrestore(&mc_io->queue_lock, irq_flags);
+	return false;
+}
+
+/**
+ * mc_send_command_async() - Queues a command to the MC device using the given
+ *                           MC I/O object, without waiting for its completion
+ * @mc_io: MC I/O object to be used, created with the
+ * FSL_MC_IO_CMD_COMPLETION_IRQ flag
+ * @acmd: command to be sent, with its done() callback filled in
+ *
+ * The commands are handed to the MC one at a time, in submission order, and
+ * acmd->done() is called for each of them from the command completion
+ * interrupt thread, once the MC response has been copied into acmd->cmd.
+ *
+ * Returns '0' if the command was queued; -EOPNOTSUPP if the portal has no
+ * command completion interrupt armed, in which case mc_send_command() has to
+ * be used instead.
+ */
+int mc_send_command_async(struct fsl_mc_io *mc_io,
+			  struct fsl_mc_async_cmd *acmd)
+{
+	unsigned long irq_flags;
+	bool idle;
+
+	if (!READ_ONCE(mc_io->irq))
+		return -EOPNOTSUPP;
+
+	acmd->cmd_id = mc_cmd_hdr_read_cmdid(&acmd->cmd);
+
+	spin_lock_irqsave(&mc_io->queue_lock, irq_flags);
+	idle = list_empty(&mc_io->cmd_queue);
+	list_add_tail(&acmd->node, &mc_io->cmd_queue);
+	if (idle)
+		mc_cmd_start(mc_io, acmd);
+	spin_unlock_irqrestore(&mc_io->queue_lock, irq_flags);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(mc_send_command_async);
+
+struct mc_sync_cmd {
+	struct fsl_mc_async_cmd acmd;
+	struct completion done;
+	int error;
+};
+
+static void mc_sync_cmd_done(struct fsl_mc_async_cmd *acmd, int error)
+{
+	struct mc_sync_cmd *sync = container_of(acmd, struct mc_sync_cmd, acmd);
+
+	sync->error = error;
+	complete(&sync->done);
+}
+
+/*
+ * Queue the command behind the asynchronous ones and sleep until its
+ * completion interrupt, instead of polling the portal.
+ */
+static int mc_send_command_irq(struct fsl_mc_io *mc_io,
+			       struct fsl_mc_command *cmd)
+{
+	struct mc_sync_cmd sync = {
+		.acmd = {
+			.cmd = *cmd,
+			.done = mc_sync_cmd_done,
+		},
+	};
+	int error;
+
+	init_completion(&sync.done);
+	error = mc_send_command_async(mc_io, &sync.acmd);
+	if (error < 0)
+		return error;
+
+	while (!wait_for_completion_timeout(&sync.done,
+					    msecs_to_jiffies(MC_CMD_COMPLETION_IRQ_RECHECK_MS)))
+		mc_cmd_process_completion(mc_io);
+
+	*cmd = sync.acmd.cmd;
+	return sync.error;
+}
+
 /**
  * mc_send_command() - Sends a command to the MC device using the given
  *                     MC I/O object
@@ -247,10 +554,15 @@ int mc_send_command(struct fsl_mc_io *mc_io, struct fsl_mc_command *cmd)
 	int error;
 	enum mc_cmd_status status;
 	unsigned long irq_flags = 0;
+	u16 cmd_id = mc_cmd_hdr_read_cmdid(cmd);
+	ktime_t start;
 
 	if (in_irq() && !(mc_io->flags & FSL_MC_IO_ATOMIC_CONTEXT_PORTAL))
 		return -EINVAL;
 
+	if (READ_ONCE(mc_io->irq))
+		return mc_send_command_irq(mc_io, cmd);
+
 	if (mc_io->flags & FSL_MC_IO_ATOMIC_CONTEXT_PORTAL)
 		raw_spin_lock_irqsave(&mc_io->spinlock, irq_flags);
 	else
@@ -259,6 +571,7 @@ int mc_send_command(struct fsl_mc_io *mc_io, struct fsl_mc_command *cmd)
 	/*
 	 * Send command to the MC hardware:
 	 */
+	start = ktime_get();
 	mc_write_command(mc_io->portal_virt_addr, cmd);
 
 	/*
@@ -272,26 +585,14 @@ int mc_send_command(struct fsl_mc_io *mc_io, struct fsl_mc_command *cmd)
 	if (error < 0)
 		goto common_exit;
 
-	if (status != MC_CMD_STATUS_OK) {
-		dev_dbg(mc_io->dev,
-			"MC command failed: portal: %pa, dprc handle: %#x, command: %#x, status: %s (%#x)\n",
-			 &mc_io->portal_phys_addr,
-			 (unsigned int)mc_cmd_hdr_read_token(cmd),
-			 (unsigned int)mc_cmd_hdr_read_cmdid(cmd),
-			 mc_status_to_string(status),
-			 (unsigned int)status);
-
-		error = mc_status_to_error(status);
-		goto common_exit;
-	}
-
-	error = 0;
+	error = mc_cmd_check_status(mc_io, cmd, status);
 common_exit:
 	if (mc_io->flags & FSL_MC_IO_ATOMIC_CONTEXT_PORTAL)
 		raw_spin_unlock_irqrestore(&mc_io->spinlock, irq_flags);
 	else
 		mutex_unlock(&mc_io->mutex);
 
+	mc_cmd_stats_add(cmd_id, start);
 	return error;
 }
 EXPORT_SYMBOL_GPL(mc_send_command);
@@ -18,6 +18,12 @@
 #include <linux/completion.h>
 #include <linux/io.h>
 #include <linux/bitfield.h>
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/workqueue.h>
 
 #define RNGC_VER_ID			0x0000
 #define RNGC_COMMAND			0x0004
@@ -54,6 +60,13 @@
 #define RNGC_SELFTEST_TIMEOUT 2500 /* us */
 #define RNGC_SEED_TIMEOUT      200 /* ms */
 
+/* entropy buffered ahead of the hwrng readers, in FIFO words */
+#define RNGC_POOL_WORDS		1024
+/* refill again once the buffer has drained below this */
+#define RNGC_POOL_LOW		(RNGC_POOL_WORDS / 2)
+/* words moved from the FIFO to the buffer per refill step */
+#define RNGC_REFILL_WORDS	64
+
 static bool self_test = true;
 module_param(self_test, bool, 0);
 
@@ -68,6 +81,21 @@ struct imx_rngc {
 	 * when interrupts are masked, we need no spinlock
 	 */
 	u32			err_reg;
+
+	/* serialises FIFO reads between the refill work and readers */
+	struct mutex		fifo_lock;
+	struct work_struct	refill_work;
+	spinlock_t		pool_lock;
+	u32			pool[RNGC_POOL_WORDS];
+	unsigned int		pool_words;
+	bool			running;
+
+	/* statistics, exposed through debugfs */
+	u64			underruns;
+	u64			refills;
+	u32			refill_last_us;
+	u32			refill_max_us;
+	struct dentry		*debugfs;
 };
 
 
@@ -119,12 +147,13 @@ static int imx_rngc_self_test(struct imx_rngc *rngc)
 	return rngc->err_reg ? -EIO : 0;
 }
 
-static int imx_rngc_read(struct hwrng *rng, void *data, size_t max, bool wait)
+static int imx_rngc_read_fifo(struct imx_rngc *rngc, void *data, size_t max)
 {
-	struct imx_rngc *rngc = container_of(rng, struct imx_rngc, rng);
 	unsigned int status;
 	int retval = 0;
 
+	lockdep_assert_held(&rngc->fifo_lock);
+
 	while (max >= sizeof(u32)) {
 		status = readl(rngc->base + RNGC_STATUS);
 
@@ -145,6 +174,88 @@ static int imx_rngc_read(struct hwrng *rng, void *data, size_t max, bool wait)
 	return retval ? retval : -EIO;
 }
 
+static void imx_rngc_refill_work(struct work_struct *work)
+{
+	struct imx_rngc *rngc = container_of(work, struct imx_rngc, refill_work);
+	u32 buf[RNGC_REFILL_WORDS];
+	unsigned int want, take;
+	bool running = true;
+	ktime_t start;
+	int ret;
+	u32 us;
+
+	start = ktime_get();
+	while (running) {
+		spin_lock(&rngc->pool_lock);
+		want = min(RNGC_POOL_WORDS - rngc->pool_words,
+			   RNGC_REFILL_WORDS);
+		running = rngc->running;
+		spin_unlock(&rngc->pool_lock);
+		if (!want || !running)
+			break;
+
+		mutex_lock(&rngc->fifo_lock);
+		ret = imx_rngc_read_fifo(rngc, buf, want * sizeof(u32));
+		mutex_unlock(&rngc->fifo_lock);
+		if (ret < 0)
+			break;
+
+		spin_lock(&rngc->pool_lock);
+		take = min_t(unsigned int, ret / sizeof(u32),
+			     RNGC_POOL_WORDS - rngc->pool_words);
+		memcpy(&rngc->pool[rngc->pool_words], buf, take * sizeof(u32));
+		rngc->pool_words += take;
+		spin_unlock(&rngc->pool_lock);
+
+		cond_resched();
+	}
+	memzero_explicit(buf, sizeof(buf));
+
+	us = ktime_us_delta(ktime_get(), start);
+
+	spin_lock(&rngc->pool_lock);
+	rngc->refills++;
+	rngc->refill_last_us = us;
+	rngc->refill_max_us = max(rngc->refill_max_us, us);
+	spin_unlock(&rngc->pool_lock);
+}
+
+static int imx_rngc_read(struct hwrng *rng, void *data, size_t max, bool wait)
+{
+	struct imx_rngc *rngc = container_of(rng, struct imx_rngc, rng);
+	unsigned int words, left;
+	int ret;
+
+	spin_lock(&rngc->pool_lock);
+	words = min_t(unsigned int, max / sizeof(u32), rngc->pool_words);
+	if (words) {
+		rngc->pool_words -= words;
+		memcpy(data, &rngc->pool[rngc->pool_words], words * sizeof(u32));
+		memzero_explicit(&rngc->pool[rngc->pool_words],
+				 words * sizeof(u32));
+	} else if (max >= sizeof(u32)) {
+		rngc->underruns++;
+	}
+	left = rngc->pool_words;
+	spin_unlock(&rngc->pool_lock);
+
+	if (left < RNGC_POOL_LOW)
+		queue_work(system_unbound_wq, &rngc->refill_work);
+
+	if (words)
+		return words * sizeof(u32);
+
+	if (!wait)
+		return 0;
+
+	/* buffer ran dry, fall back to reading the FIFO directly */
+	mutex_lock(&rngc->fifo_lock);
+	ret = imx_rngc_read_fifo(rngc, data, max);
+	mutex_unlock(&rngc->fifo_lock);
+
+	return ret;
+}
+
 static irqreturn_t imx_rngc_irq(int irq, void *priv)
 {
 	struct imx_rngc *rngc = (struct imx_rngc *)priv;
@@ -205,6 +316,11 @@ static int imx_rngc_init(struct hwrng *rng)
 	ctrl |= RNGC_CTRL_AUTO_SEED;
 	writel(ctrl, rngc->base + RNGC_CONTROL);
 
+	spin_lock(&rngc->pool_lock);
+	rngc->running = true;
+	spin_unlock(&rngc->pool_lock);
+	queue_work(system_unbound_wq, &rngc->refill_work);
+
 	/*
 	 * if initialisation was successful, we keep the interrupt
 	 * unmasked until imx_rngc_cleanup is called
@@ -221,9 +337,39 @@ static void imx_rngc_cleanup(struct hwrng *rng)
 {
 	struct imx_rngc *rngc = container_of(rng, struct imx_rngc, rng);
 
+	spin_lock(&rngc->pool_lock);
+	rngc->running = false;
+	spin_unlock(&rngc->pool_lock);
+	cancel_work_sync(&rngc->refill_work);
+
+	spin_lock(&rngc->pool_lock);
+	memzero_explicit(rngc->pool, sizeof(rngc->pool));
+	rngc->pool_words = 0;
+	spin_unlock(&rngc->pool_lock);
+
 	imx_rngc_irq_mask_clear(rngc);
 }
 
+static void imx_rngc_debugfs_remove(void *data)
+{
+	struct imx_rngc *rngc = data;
+
+	debugfs_remove_recursive(rngc->debugfs);
+}
+
+static void imx_rngc_debugfs_init(struct imx_rngc *rngc)
+{
+	rngc->debugfs = debugfs_create_dir(dev_name(rngc->dev), NULL);
+	debugfs_create_u64("underruns", 0444, rngc->debugfs, &rngc->underruns);
+	debugfs_create_u64("refills", 0444, rngc->debugfs, &rngc->refills);
+	debugfs_create_u32("refill_last_us", 0444, rngc->debugfs,
+			   &rngc->refill_last_us);
+	debugfs_create_u32("refill_max_us", 0444, rngc->debugfs,
+			   &rngc->refill_max_us);
+
+	devm_add_action_or_reset(rngc->dev, imx_rngc_debugfs_remove, rngc);
+}
+
 static int __init imx_rngc_probe(struct platform_device *pdev)
 {
 	struct imx_rngc *rngc;
@@ -258,6 +404,9 @@ static int __init imx_rngc_probe(struct platform_device *pdev)
 		return -ENODEV;
 
 	init_completion(&rngc->rng_op_done);
+	mutex_init(&rngc->fifo_lock);
+	spin_lock_init(&rngc->pool_lock);
+	INIT_WORK(&rngc->refill_work, imx_rngc_refill_work);
 
 	rngc->rng.name = pdev->name;
 	rngc->rng.init = imx_rngc_init;
@@ -285,6 +434,8 @@ static int __init imx_rngc_probe(struct platform_device *pdev)
 	if (ret)
 		return dev_err_probe(&pdev->dev, ret, "hwrng registration failed\n");
 
+	imx_rngc_debugfs_init(rngc);
+
 	dev_info(&pdev->dev,
 		"Freescale RNG%c registered (HW revision %d.%02d)\n",
 		rng_type == RNGC_TYPE_RNGB ? 'B' : 'C',
@@ -296,6 +447,7 @@ static int imx_rngc_suspend(struct device *dev)
 {
 	struct imx_rngc *rngc = dev_get_drvdata(dev);
 
+	cancel_work_sync(&rngc->refill_work);
 	clk_disable_unprepare(rngc->clk);
 
 	return 0;
@@ -306,6 +458,8 @@ static int imx_rngc_resume(struct device *dev)
 	struct imx_rngc *rngc = dev_get_drvdata(dev);
 
 	clk_prepare_enable(rngc->clk);
+	if (READ_ONCE(rngc->running))
+		queue_work(system_unbound_wq, &rngc->refill_work);
 
 	return 0;
 }
@@ -49,6 +49,15 @@ static void imx93_clk_composite_gate_endisable(struct clk_hw *hw, int enable)
 	unsigned long flags;
 	u32 reg;
 
+	/*
+	 * The root is often still running, e.g. disable was skipped for
+	 * the M core or the bootloader left it on. Nothing else writes the
+	 * OFF bit and the clk core serializes enable/disable of a clock, so
+	 * skip the locked update and the slice busy wait in that case.
+	 */
+	if (!(readl(gate->reg) & BIT(gate->bit_idx)) == !!enable)
+		return;
+
 	if (gate->lock)
 		spin_lock_irqsave(gate->lock, flags);
 
@@ -84,17 +84,48 @@ static void clk_gate2_do_shared_clks(struct clk_hw *hw, bool enable)
 	}
 }
 
+/*
+ * A shared gate only touches the hardware when its share count moves
+ * between 0 and 1. Users piling on top of an already ungated clock (or
+ * leaving while others remain) just adjust the count, which does not need
+ * the CCM lock as long as every update of the count is atomic. Returns
+ * false when the count is at the @floor and the caller must take the lock.
+ */
+static bool clk_gate2_share_fast(unsigned int *share_count, bool get,
+				 unsigned int floor)
+{
+	unsigned int cnt = READ_ONCE(*share_count);
+
+	while (cnt > floor) {
+		if (try_cmpxchg(share_count, &cnt, get ? cnt + 1 : cnt - 1))
+			return true;
+	}
+
+	return false;
+}
+
 static int clk_gate2_enable(struct clk_hw *hw)
 {
 	struct clk_gate2 *gate = to_clk_gate2(hw);
 	unsigned long flags;
 
+	if (gate->share_count && clk_gate2_share_fast(gate->share_count, true, 0))
+		return 0;
+
 	spin_lock_irqsave(gate->lock, flags);
 
-	if (gate->share_count && (*gate->share_count)++ > 0)
+	/* another user may have ungated it while we waited for the lock */
+	if (gate->share_count && clk_gate2_share_fast(gate->share_count, true, 0))
 		goto out;
 
 	clk_gate2_do_shared_clks(hw, true);
+
+	/*
+	 * Nobody else moves the count away from 0, publish the new user only
+	 * once the gate is open for the lockless path to rely on it.
+	 */
+	if (gate->share_count)
+		smp_store_release(gate->share_count, 1);
 out:
 	spin_unlock_irqrestore(gate->lock, flags);
 
@@ -105,13 +136,22 @@ static void clk_gate2_disable(struct clk_hw *hw)
 {
 	struct clk_gate2 *gate = to_clk_gate2(hw);
 	unsigned long flags;
+	unsigned int cnt;
+
+	if (gate->share_count && clk_gate2_share_fast(gate->share_count, false, 1))
+		return;
 
 	spin_lock_irqsave(gate->lock, flags);
 
 	if (gate->share_count) {
-		if (WARN_ON(*gate->share_count == 0))
-			goto out;
-		else if (--(*gate->share_count) > 0)
+		/* a lockless enable may still bump the count from 1 to 2 */
+		cnt = READ_ONCE(*gate->share_count);
+		do {
+			if (WARN_ON(cnt == 0))
+				goto out;
+		} while (!try_cmpxchg(gate->share_count, &cnt, cnt - 1));
+
+		if (cnt > 1)
 			goto out;
 	}
 
@@ -134,17 +174,10 @@ static int clk_gate2_reg_is_enabled(void __iomem *reg, u8 bit_idx,
 static int clk_gate2_is_enabled(struct clk_hw *hw)
 {
 	struct clk_gate2 *gate = to_clk_gate2(hw);
-	unsigned long flags;
-	int ret = 0;
-
-	spin_lock_irqsave(gate->lock, flags);
-
-	ret = clk_gate2_reg_is_enabled(gate->reg, gate->bit_idx,
-					gate->cgr_val, gate->cgr_mask);
-
-	spin_unlock_irqrestore(gate->lock, flags);
 
-	return ret;
+	/* a single register read, no need to serialize against updates */
+	return clk_gate2_reg_is_enabled(gate->reg, gate->bit_idx,
+					 gate->cgr_val, gate->cgr_mask);
 }
 
 static void clk_gate2_disable_unused(struct clk_hw *hw)
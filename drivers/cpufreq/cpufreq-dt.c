@@ -12,6 +12,7 @@
 #include <linux/cpu.h>
 #include <linux/cpufreq.h>
 #include <linux/cpumask.h>
+#include <linux/energy_model.h>
 #include <linux/err.h>
 #include <linux/list.h>
 #include <linux/module.h>
@@ -35,6 +36,8 @@ struct private_data {
 };
 
 static LIST_HEAD(priv_list);
+static unsigned int transition_delay_us;
+static unsigned int dynamic_power_coefficient;
 
 static struct freq_attr *cpufreq_dt_attr[] = {
 	&cpufreq_freq_attr_scaling_available_freqs,
@@ -118,6 +121,7 @@ static int cpufreq_init(struct cpufreq_policy *policy)
 	policy->freq_table = priv->freq_table;
 	policy->suspend_freq = dev_pm_opp_get_suspend_opp_freq(cpu_dev) / 1000;
 	policy->cpuinfo.transition_latency = transition_latency;
+	policy->transition_delay_us = transition_delay_us;
 	policy->dvfs_possible_from_any_cpu = true;
 
 	/* Support turbo/boost mode */
@@ -157,6 +161,53 @@ static void cpufreq_exit(struct cpufreq_policy *policy)
 	clk_put(policy->clk);
 }
 
+/* Same model as dev_pm_opp_calc_power(), with the platform coefficient */
+static int cpufreq_dt_calc_power(struct device *dev, unsigned long *uW,
+				 unsigned long *kHz)
+{
+	struct dev_pm_opp *opp;
+	unsigned long mV, Hz;
+	u64 tmp;
+
+	Hz = *kHz * 1000;
+	opp = dev_pm_opp_find_freq_ceil(dev, &Hz);
+	if (IS_ERR(opp))
+		return -EINVAL;
+
+	mV = dev_pm_opp_get_voltage(opp) / 1000;
+	dev_pm_opp_put(opp);
+	if (!mV)
+		return -EINVAL;
+
+	tmp = (u64)dynamic_power_coefficient * mV * mV * (Hz / 1000000);
+	do_div(tmp, 1000000);
+
+	*uW = (unsigned long)tmp;
+	*kHz = Hz / 1000;
+
+	return 0;
+}
+
+static void cpufreq_dt_register_em(struct cpufreq_policy *policy)
+{
+	struct device *cpu_dev = get_cpu_device(policy->cpu);
+	struct em_data_callback em_cb = EM_DATA_CB(cpufreq_dt_calc_power);
+	int nr_opp;
+
+	/* A power model from DT always takes precedence */
+	if (!dev_pm_opp_of_register_em(cpu_dev, policy->related_cpus) ||
+	    !dynamic_power_coefficient)
+		return;
+
+	nr_opp = dev_pm_opp_get_opp_count(cpu_dev);
+	if (nr_opp <= 0)
+		return;
+
+	if (em_dev_register_perf_domain(cpu_dev, nr_opp, &em_cb,
+					policy->related_cpus, true))
+		dev_dbg(cpu_dev, "Couldn't register Energy Model\n");
+}
+
 static struct cpufreq_driver dt_cpufreq_driver = {
 	.flags = CPUFREQ_NEED_INITIAL_FREQ_CHECK |
 		 CPUFREQ_IS_COOLING_DEV,
@@ -167,7 +218,7 @@ static struct cpufreq_driver dt_cpufreq_driver = {
 	.exit = cpufreq_exit,
 	.online = cpufreq_online,
 	.offline = cpufreq_offline,
-	.register_em = cpufreq_register_em_with_opp,
+	.register_em = cpufreq_dt_register_em,
 	.name = "cpufreq-dt",
 	.attr = cpufreq_dt_attr,
 	.suspend = cpufreq_generic_suspend,
@@ -313,6 +364,9 @@ static int dt_cpufreq_probe(struct platform_device *pdev)
 		if (data->have_governor_per_policy)
 			dt_cpufreq_driver.flags |= CPUFREQ_HAVE_GOVERNOR_PER_POLICY;
 
+		transition_delay_us = data->transition_delay_us;
+		dynamic_power_coefficient = data->dynamic_power_coefficient;
+
 		dt_cpufreq_driver.resume = data->resume;
 		if (data->suspend)
 			dt_cpufreq_driver.suspend = data->suspend;
@@ -14,6 +14,19 @@ struct cpufreq_policy;
 struct cpufreq_dt_platform_data {
 	bool have_governor_per_policy;
 
+	/*
+	 * Minimum time between frequency updates requested by the governor,
+	 * 0 to derive it from the OPP transition latency.
+	 */
+	unsigned int transition_delay_us;
+
+	/*
+	 * Dynamic power coefficient of the CPUs, in uW/MHz/V^2, used to
+	 * build the energy model when DT does not describe one. 0 to only
+	 * rely on DT.
+	 */
+	unsigned int dynamic_power_coefficient;
+
 	unsigned int	(*get_intermediate)(struct cpufreq_policy *policy,
 					    unsigned int index);
 	int		(*target_intermediate)(struct cpufreq_policy *policy,
@@ -29,6 +29,27 @@
 
 #define IMX7ULP_MAX_RUN_FREQ	528000
 
+/*
+ * The A53/A55 clock switch is a glitchless mux to a system PLL while the
+ * ARM PLL relocks, and that relock is what the OPP tables declare as
+ * clock latency. The OPP transition latency also adds the regulator
+ * ramp across the whole OPP range, which only the few steps that change
+ * the voltage pay, and the governor then rate limits every update to
+ * 1.5 times that. Let schedutil come back after one relock instead, so
+ * that a burst of load ramps the CPU up without waiting out the worst
+ * case voltage swing at each step.
+ */
+#define IMX8M_CPUFREQ_TRANSITION_DELAY_US	150
+
+/*
+ * Nominal Cortex-A53 dynamic power coefficients, in uW/MHz/V^2, for the
+ * 28nm i.MX8MQ and the 14nm i.MX8MM/MN/MP. They give the thermal power
+ * allocator an energy model to work with on boards whose DT does not
+ * carry a calibrated dynamic-power-coefficient, which always wins.
+ */
+#define IMX8MQ_DYNAMIC_POWER_COEFF		120
+#define IMX8MM_DYNAMIC_POWER_COEFF		100
+
 /* cpufreq-dt device registered by imx-cpufreq-dt */
 static struct platform_device *cpufreq_dt_pdev;
 static struct device *cpu_dev;
@@ -80,6 +101,10 @@ static struct cpufreq_dt_platform_data imx7ulp_data = {
 	.get_intermediate = imx7ulp_get_intermediate,
 };
 
+static struct cpufreq_dt_platform_data imx8m_data = {
+	.transition_delay_us = IMX8M_CPUFREQ_TRANSITION_DELAY_US,
+};
+
 static int imx_cpufreq_dt_probe(struct platform_device *pdev)
 {
 	struct platform_device *dt_pdev;
@@ -160,8 +185,14 @@ static int imx_cpufreq_dt_probe(struct platform_device *pdev)
 		return ret;
 	}
 
+	if (of_machine_is_compatible("fsl,imx8mq"))
+		imx8m_data.dynamic_power_coefficient = IMX8MQ_DYNAMIC_POWER_COEFF;
+	else
+		imx8m_data.dynamic_power_coefficient = IMX8MM_DYNAMIC_POWER_COEFF;
+
 	cpufreq_dt_pdev = platform_device_register_data(
-			&pdev->dev, "cpufreq-dt", -1, NULL, 0);
+			&pdev->dev, "cpufreq-dt", -1, &imx8m_data,
+			sizeof(imx8m_data));
 	if (IS_ERR(cpufreq_dt_pdev)) {
 		dev_pm_opp_put_supported_hw(cpufreq_opp_token);
 		ret = PTR_ERR(cpufreq_dt_pdev);
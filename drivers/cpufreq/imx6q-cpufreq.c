@@ -8,6 +8,7 @@
 #include <linux/cpu.h>
 #include <linux/cpufreq.h>
 #include <linux/err.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/nvmem-consumer.h>
 #include <linux/of.h>
@@ -75,17 +76,45 @@ static unsigned int max_freq;
 static unsigned int transition_latency;
 
 static u32 *imx6_soc_volt;
+static u32 *imx6_arm_volt;
 static u32 soc_opp_count;
 
+/*
+ * Voltages last requested on each rail, to skip writes that change
+ * nothing. 0 until the first transition has requested them.
+ */
+static unsigned long arm_volt_cur, soc_volt_cur, pu_volt_cur;
+
+static DEFINE_SPINLOCK(trans_stats_lock);
+static u64 trans_time_total_us;
+static u32 trans_time_max_us;
+static unsigned long trans_count;
+
 static bool ignore_dc_reg;
 static bool low_power_run_support;
 
+static int imx6q_set_volt(struct regulator *reg, unsigned long *cur,
+			  unsigned long volt)
+{
+	int ret;
+
+	if (*cur == volt)
+		return 0;
+
+	ret = regulator_set_voltage_tol(reg, volt, 0);
+	if (!ret)
+		*cur = volt;
+
+	return ret;
+}
+
 static int imx6q_set_target(struct cpufreq_policy *policy, unsigned int index)
 {
-	struct dev_pm_opp *opp;
 	unsigned long freq_hz, volt, volt_old;
 	unsigned int old_freq, new_freq;
 	bool pll1_sys_temp_enabled = false;
+	ktime_t start;
+	u32 time_us;
 	int ret;
 
 	new_freq = freq_table[index].frequency;
@@ -101,16 +130,10 @@ static int imx6q_set_target(struct cpufreq_policy *policy, unsigned int index)
 	if (old_freq == FREQ_24_MHZ && new_freq == FREQ_198_MHZ)
 		return 0;
 
-	opp = dev_pm_opp_find_freq_ceil(cpu_dev, &freq_hz);
-	if (IS_ERR(opp)) {
-		dev_err(cpu_dev, "failed to find OPP for %ld\n", freq_hz);
-		return PTR_ERR(opp);
-	}
-
-	volt = dev_pm_opp_get_voltage(opp);
-	dev_pm_opp_put(opp);
+	start = ktime_get();
 
-	volt_old = regulator_get_voltage(arm_reg);
+	volt = imx6_arm_volt[index];
+	volt_old = arm_volt_cur;
 
 	dev_dbg(cpu_dev, "%u MHz, %ld mV --> %u MHz, %ld mV\n",
 		old_freq / 1000, volt_old / 1000,
@@ -126,18 +149,18 @@ static int imx6q_set_target(struct cpufreq_policy *policy, unsigned int index)
 	/* scaling up?  scale voltage before frequency */
 	if (new_freq > old_freq) {
 		if (!IS_ERR(pu_reg)) {
-			ret = regulator_set_voltage_tol(pu_reg, imx6_soc_volt[index], 0);
+			ret = imx6q_set_volt(pu_reg, &pu_volt_cur, imx6_soc_volt[index]);
 			if (ret) {
 				dev_err(cpu_dev, "failed to scale vddpu up: %d\n", ret);
 				return ret;
 			}
 		}
-		ret = regulator_set_voltage_tol(soc_reg, imx6_soc_volt[index], 0);
+		ret = imx6q_set_volt(soc_reg, &soc_volt_cur, imx6_soc_volt[index]);
 		if (ret) {
 			dev_err(cpu_dev, "failed to scale vddsoc up: %d\n", ret);
 			return ret;
 		}
-		ret = regulator_set_voltage_tol(arm_reg, volt, 0);
+		ret = imx6q_set_volt(arm_reg, &arm_volt_cur, volt);
 		if (ret) {
 			dev_err(cpu_dev,
 				"failed to scale vddarm up: %d\n", ret);
@@ -205,7 +228,10 @@ static int imx6q_set_target(struct cpufreq_policy *policy, unsigned int index)
 		int ret1;
 
 		dev_err(cpu_dev, "failed to set clock rate: %d\n", ret);
-		ret1 = regulator_set_voltage_tol(arm_reg, volt_old, 0);
+		if (!volt_old)
+			return ret;
+
+		ret1 = imx6q_set_volt(arm_reg, &arm_volt_cur, volt_old);
 		if (ret1)
 			dev_warn(cpu_dev,
 				 "failed to restore vddarm voltage: %d\n", ret1);
@@ -218,15 +244,15 @@ static int imx6q_set_target(struct cpufreq_policy *policy, unsigned int index)
 
 	/* scaling down?  scale voltage after frequency */
 	if (new_freq < old_freq) {
-		ret = regulator_set_voltage_tol(arm_reg, volt, 0);
+		ret = imx6q_set_volt(arm_reg, &arm_volt_cur, volt);
 		if (ret)
 			dev_warn(cpu_dev,
 				 "failed to scale vddarm down: %d\n", ret);
-		ret = regulator_set_voltage_tol(soc_reg, imx6_soc_volt[index], 0);
+		ret = imx6q_set_volt(soc_reg, &soc_volt_cur, imx6_soc_volt[index]);
 		if (ret)
 			dev_warn(cpu_dev, "failed to scale vddsoc down: %d\n", ret);
 		if (!IS_ERR(pu_reg)) {
-			ret = regulator_set_voltage_tol(pu_reg, imx6_soc_volt[index], 0);
+			ret = imx6q_set_volt(pu_reg, &pu_volt_cur, imx6_soc_volt[index]);
 			if (ret)
 				dev_warn(cpu_dev, "failed to scale vddpu down: %d\n", ret);
 		}
@@ -243,9 +269,44 @@ static int imx6q_set_target(struct cpufreq_policy *policy, unsigned int index)
 		release_bus_freq(BUS_FREQ_HIGH);
 	}
 
+	time_us = ktime_us_delta(ktime_get(), start);
+	spin_lock(&trans_stats_lock);
+	trans_time_total_us += time_us;
+	trans_time_max_us = max(trans_time_max_us, time_us);
+	trans_count++;
+	spin_unlock(&trans_stats_lock);
+
 	return 0;
 }
 
+static ssize_t transition_time_avg_us_show(struct cpufreq_policy *policy,
+					   char *buf)
+{
+	u64 avg = 0;
+
+	spin_lock(&trans_stats_lock);
+	if (trans_count)
+		avg = div_u64(trans_time_total_us, trans_count);
+	spin_unlock(&trans_stats_lock);
+
+	return sprintf(buf, "%llu\n", avg);
+}
+cpufreq_freq_attr_ro(transition_time_avg_us);
+
+static ssize_t transition_time_max_us_show(struct cpufreq_policy *policy,
+					   char *buf)
+{
+	return sprintf(buf, "%u\n", READ_ONCE(trans_time_max_us));
+}
+cpufreq_freq_attr_ro(transition_time_max_us);
+
+static struct freq_attr *imx6q_cpufreq_attr[] = {
+	&cpufreq_freq_attr_scaling_available_freqs,
+	&transition_time_avg_us,
+	&transition_time_max_us,
+	NULL,
+};
+
 static int imx6q_cpufreq_init(struct cpufreq_policy *policy)
 {
 	policy->clk = clks[ARM].clk;
@@ -271,7 +332,7 @@ static struct cpufreq_driver imx6q_cpufreq_driver = {
 	.init = imx6q_cpufreq_init,
 	.register_em = cpufreq_register_em_with_opp,
 	.name = "imx6q-cpufreq",
-	.attr = cpufreq_generic_attr,
+	.attr = imx6q_cpufreq_attr,
 	.suspend = cpufreq_generic_suspend,
 };
 
@@ -563,6 +624,27 @@ static int imx6q_cpufreq_probe(struct platform_device *pdev)
 			imx6_soc_volt[num - 1] = PU_SOC_VOLTAGE_HIGH;
 	}
 
+	/* Look up the ARM voltage of each setpoint once, not per transition */
+	imx6_arm_volt = devm_kcalloc(cpu_dev, num, sizeof(*imx6_arm_volt),
+				     GFP_KERNEL);
+	if (imx6_arm_volt == NULL) {
+		ret = -ENOMEM;
+		goto free_freq_table;
+	}
+
+	for (j = 0; j < num; j++) {
+		opp = dev_pm_opp_find_freq_exact(cpu_dev,
+					freq_table[j].frequency * 1000, true);
+		if (IS_ERR(opp)) {
+			ret = PTR_ERR(opp);
+			dev_err(cpu_dev, "failed to find OPP for %u kHz: %d\n",
+				freq_table[j].frequency, ret);
+			goto free_freq_table;
+		}
+		imx6_arm_volt[j] = dev_pm_opp_get_voltage(opp);
+		dev_pm_opp_put(opp);
+	}
+
 	if (of_property_read_u32(np, "clock-latency", &transition_latency))
 		transition_latency = CPUFREQ_ETERNAL;
 
@@ -59,6 +59,11 @@
  */
 #define CAAM_DMA_CHUNK_SIZE	65280
 
+static bool spread_rings = true;
+module_param(spread_rings, bool, 0644);
+MODULE_PARM_DESC(spread_rings,
+		 "Dispatch each channel's jobs on the job ring of the submitting CPU");
+
 struct caam_dma_sh_desc {
 	u32 desc[DESC_DMA_MEMCPY_LEN] ____cacheline_aligned;
 	dma_addr_t desc_dma;
@@ -69,6 +74,9 @@ struct caam_dma_edesc {
 	struct dma_async_tx_descriptor async_tx;
 	struct list_head node;
 	struct caam_dma_ctx *ctx;
+	struct device *jrdev;
+	u32 err;
+	bool done;
 	dma_addr_t src_dma;
 	dma_addr_t dst_dma;
 	unsigned int src_len;
@@ -82,6 +90,7 @@ struct caam_dma_edesc {
  * @node: list_head used to attach to the global dma_ctx_list
  * @jrdev: Job Ring device
  * @pending_q: queue of pending (submitted, but not enqueued) jobs
+ * @active_q: jobs enqueued on a job ring, in cookie order
  * @done_not_acked: jobs that have been completed by jr, but maybe not acked
  * @edesc_lock: protects extended descriptor
  */
@@ -90,6 +99,7 @@ struct caam_dma_ctx {
 	struct list_head node;
 	struct device *jrdev;
 	struct list_head pending_q;
+	struct list_head active_q;
 	struct list_head done_not_acked;
 	spinlock_t edesc_lock;
 };
@@ -97,6 +107,8 @@ struct caam_dma_ctx {
 static struct dma_device *dma_dev;
 static struct caam_dma_sh_desc *dma_sh_desc;
 static LIST_HEAD(dma_ctx_list);
+static struct device **dma_jrdevs;
+static int dma_nr_jrdevs;
 
 static dma_cookie_t caam_dma_tx_submit(struct dma_async_tx_descriptor *tx)
 {
@@ -135,32 +147,50 @@ static void caam_jr_chan_free_edesc(struct caam_dma_edesc *edesc)
 	spin_unlock_bh(&ctx->edesc_lock);
 }
 
+/*
+ * Jobs of one channel may run on different job rings and finish out of
+ * order, while cookies have to complete in order. Each completion marks its
+ * job done and then retires every finished job at the head of active_q, so a
+ * single callback pass can complete a whole run of descriptors.
+ */
 static void caam_dma_done(struct device *dev, u32 *hwdesc, u32 err,
 			  void *context)
 {
-	struct caam_dma_edesc *edesc = context;
+	struct caam_dma_edesc *edesc = context, *_edesc;
 	struct caam_dma_ctx *ctx = edesc->ctx;
 	dma_async_tx_callback callback;
 	void *callback_param;
-
-	if (err)
-		caam_jr_strstatus(ctx->jrdev, err);
-
-	dma_run_dependencies(&edesc->async_tx);
+	LIST_HEAD(done);
 
 	spin_lock_bh(&ctx->edesc_lock);
-	dma_cookie_complete(&edesc->async_tx);
+	edesc->err = err;
+	edesc->done = true;
+	list_for_each_entry_safe(edesc, _edesc, &ctx->active_q, node) {
+		if (!edesc->done)
+			break;
+		dma_cookie_complete(&edesc->async_tx);
+		list_move_tail(&edesc->node, &done);
+	}
 	spin_unlock_bh(&ctx->edesc_lock);
 
-	callback = edesc->async_tx.callback;
-	callback_param = edesc->async_tx.callback_param;
+	list_for_each_entry_safe(edesc, _edesc, &done, node) {
+		list_del(&edesc->node);
+
+		if (edesc->err)
+			caam_jr_strstatus(edesc->jrdev, edesc->err);
+
+		dma_run_dependencies(&edesc->async_tx);
+
+		callback = edesc->async_tx.callback;
+		callback_param = edesc->async_tx.callback_param;
 
-	dma_descriptor_unmap(&edesc->async_tx);
+		dma_descriptor_unmap(&edesc->async_tx);
 
-	caam_jr_chan_free_edesc(edesc);
+		caam_jr_chan_free_edesc(edesc);
 
-	if (callback)
-		callback(callback_param);
+		if (callback)
+			callback(callback_param);
+	}
 }
 
 static void caam_dma_memcpy_init_job_desc(struct caam_dma_edesc *edesc)
@@ -210,6 +240,33 @@ caam_dma_prep_memcpy(struct dma_chan *chan, dma_addr_t dst, dma_addr_t src,
 	return &edesc->async_tx;
 }
 
+/*
+ * Start with the job ring of the submitting CPU and fall back to the other
+ * rings when it is full.
+ */
+static int caam_dma_enqueue(struct caam_dma_ctx *ctx,
+			    struct caam_dma_edesc *edesc)
+{
+	int first, i, ret = -EBUSY;
+
+	if (!spread_rings || dma_nr_jrdevs < 2) {
+		edesc->jrdev = ctx->jrdev;
+		return caam_jr_enqueue(ctx->jrdev, edesc->jd, caam_dma_done,
+				       edesc);
+	}
+
+	first = raw_smp_processor_id() % dma_nr_jrdevs;
+	for (i = 0; i < dma_nr_jrdevs; i++) {
+		edesc->jrdev = dma_jrdevs[(first + i) % dma_nr_jrdevs];
+		ret = caam_jr_enqueue(edesc->jrdev, edesc->jd, caam_dma_done,
+				      edesc);
+		if (ret != -EBUSY)
+			break;
+	}
+
+	return ret;
+}
+
 /* This function can be called in an interrupt context */
 static void caam_dma_issue_pending(struct dma_chan *chan)
 {
@@ -219,11 +276,15 @@ static void caam_dma_issue_pending(struct dma_chan *chan)
 
 	spin_lock_bh(&ctx->edesc_lock);
 	list_for_each_entry_safe(edesc, _edesc, &ctx->pending_q, node) {
-		int ret = caam_jr_enqueue(ctx->jrdev, edesc->jd,
-					  caam_dma_done, edesc);
-		if (ret != -EINPROGRESS)
+		int ret;
+
+		/* on active_q before the ring can complete it */
+		list_move_tail(&edesc->node, &ctx->active_q);
+		ret = caam_dma_enqueue(ctx, edesc);
+		if (ret != -EINPROGRESS) {
+			list_move(&edesc->node, &ctx->pending_q);
 			break;
-		list_del(&edesc->node);
+		}
 	}
 	spin_unlock_bh(&ctx->edesc_lock);
 }
@@ -272,6 +333,7 @@ static int caam_dma_jr_chan_bind(void)
 		ctx->jrdev = jrdev;
 
 		INIT_LIST_HEAD(&ctx->pending_q);
+		INIT_LIST_HEAD(&ctx->active_q);
 		INIT_LIST_HEAD(&ctx->done_not_acked);
 		INIT_LIST_HEAD(&ctx->node);
 		spin_lock_init(&ctx->edesc_lock);
@@ -357,6 +419,7 @@ static int caam_dma_probe(struct platform_device *pdev)
 	struct device *dev = &pdev->dev;
 	struct device *ctrldev = dev->parent;
 	struct dma_chan *chan, *_chan;
+	struct caam_dma_ctx *ctx;
 	u32 *sh_desc;
 	int err = -ENOMEM;
 	int bonds;
@@ -392,6 +455,12 @@ static int caam_dma_probe(struct platform_device *pdev)
 		goto jr_bind_err;
 	}
 
+	dma_jrdevs = kcalloc(bonds, sizeof(*dma_jrdevs), GFP_KERNEL);
+	if (!dma_jrdevs)
+		goto jr_bind_err;
+	list_for_each_entry(ctx, &dma_ctx_list, node)
+		dma_jrdevs[dma_nr_jrdevs++] = ctx->jrdev;
+
 	dma_dev->dev = dev;
 	dma_dev->residue_granularity = DMA_RESIDUE_GRANULARITY_DESCRIPTOR;
 	dma_cap_set(DMA_MEMCPY, dma_dev->cap_mask);
@@ -404,13 +473,17 @@ static int caam_dma_probe(struct platform_device *pdev)
 	err = dma_async_device_register(dma_dev);
 	if (err) {
 		dev_err(dev, "Failed to register CAAM DMA engine\n");
-		goto jr_bind_err;
+		goto register_err;
 	}
 
 	dev_info(dev, "caam dma support with %d job rings\n", bonds);
 
 	return err;
 
+register_err:
+	kfree(dma_jrdevs);
+	dma_jrdevs = NULL;
+	dma_nr_jrdevs = 0;
 jr_bind_err:
 	list_for_each_entry_safe(chan, _chan, &dma_dev->channels, device_node)
 		caam_jr_dma_free(chan);
@@ -437,6 +510,9 @@ static void caam_dma_remove(struct platform_device *pdev)
 		caam_jr_free(ctx->jrdev);
 		kfree(ctx);
 	}
+	kfree(dma_jrdevs);
+	dma_jrdevs = NULL;
+	dma_nr_jrdevs = 0;
 
 	dma_unmap_single(ctrldev, dma_sh_desc->desc_dma,
 			 desc_bytes(dma_sh_desc->desc), DMA_TO_DEVICE);
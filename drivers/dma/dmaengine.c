@@ -44,6 +44,7 @@
 #include <linux/rcupdate.h>
 #include <linux/mutex.h>
 #include <linux/jiffies.h>
+#include <linux/ktime.h>
 #include <linux/rculist.h>
 #include <linux/idr.h>
 #include <linux/slab.h>
@@ -538,6 +539,40 @@ enum dma_status dma_sync_wait(struct dma_chan *chan, dma_cookie_t cookie)
 }
 EXPORT_SYMBOL(dma_sync_wait);
 
+/**
+ * dma_async_poll_complete - busy poll for the completion of a transaction
+ * @chan:	DMA channel
+ * @cookie:	transaction identifier to poll for
+ * @budget_us:	maximum time to spin, in microseconds
+ *
+ * Spin on device_tx_status() until the transaction leaves the in progress
+ * state or @budget_us elapses. Meant for short transfers prepared with
+ * DMA_PREP_POLL, where the interrupt and tasklet round trip costs more than
+ * the transfer itself. The transaction must already be issued. When the
+ * budget is exhausted DMA_IN_PROGRESS is returned and the caller falls back
+ * to waiting for the completion callback.
+ */
+enum dma_status dma_async_poll_complete(struct dma_chan *chan,
+					dma_cookie_t cookie,
+					unsigned int budget_us)
+{
+	ktime_t timeout = ktime_add_us(ktime_get(), budget_us);
+	struct dma_tx_state state;
+	enum dma_status status;
+
+	for (;;) {
+		status = chan->device->device_tx_status(chan, cookie, &state);
+		if (status != DMA_IN_PROGRESS)
+			break;
+		if (ktime_after(ktime_get(), timeout))
+			break;
+		cpu_relax();
+	}
+
+	return status;
+}
+EXPORT_SYMBOL_GPL(dma_async_poll_complete);
+
 /**
  * dma_find_channel - find a channel to carry out the operation
  * @tx_type:	transaction type
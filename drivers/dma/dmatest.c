@@ -7,18 +7,22 @@
  */
 #define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
 
+#include <linux/atomic.h>
 #include <linux/err.h>
+#include <linux/cpumask.h>
 #include <linux/delay.h>
 #include <linux/dma-mapping.h>
 #include <linux/dmaengine.h>
 #include <linux/freezer.h>
 #include <linux/init.h>
 #include <linux/kthread.h>
+#include <linux/log2.h>
 #include <linux/sched/task.h>
 #include <linux/module.h>
 #include <linux/moduleparam.h>
 #include <linux/random.h>
 #include <linux/slab.h>
+#include <linux/topology.h>
 #include <linux/wait.h>
 
 static bool nobounce;
@@ -92,6 +96,14 @@ static bool polled;
 module_param(polled, bool, 0644);
 MODULE_PARM_DESC(polled, "Use polling for completion instead of interrupts");
 
+static bool bench;
+module_param(bench, bool, 0644);
+MODULE_PARM_DESC(bench, "Benchmark mode: sweep transfer sizes and report throughput and latency percentiles as CSV (default: off)");
+
+static bool pin_cpus;
+module_param(pin_cpus, bool, 0644);
+MODULE_PARM_DESC(pin_cpus, "Bind every test thread to its own CPU (default: off)");
+
 /**
  * struct dmatest_params - test parameters.
  * @nobounce:		prevent using swiotlb buffer
@@ -109,6 +121,8 @@ MODULE_PARM_DESC(polled, "Use polling for completion instead of interrupts");
  * @alignment:		custom data address alignment taken as 2^alignment
  * @transfer_size:	custom transfer size in bytes
  * @polled:		use polling for completion instead of interrupts
+ * @bench:		benchmark mode, sweep sizes and report CSV statistics
+ * @pin_cpus:		bind every test thread to its own CPU
  */
 struct dmatest_params {
 	bool		nobounce;
@@ -126,6 +140,62 @@ struct dmatest_params {
 	int		alignment;
 	unsigned int	transfer_size;
 	bool		polled;
+	bool		bench;
+	bool		pin_cpus;
+};
+
+/*
+ * Submit-to-callback latencies are accounted in log-linear buckets: 16
+ * linear sub-buckets per power of two, i.e. about 6% resolution, up to
+ * 2^40 ns.
+ */
+#define DMATEST_LAT_SUB_BITS	4
+#define DMATEST_LAT_MAX_MSB	39
+#define DMATEST_LAT_BUCKETS	\
+	((DMATEST_LAT_MAX_MSB - DMATEST_LAT_SUB_BITS + 2) << DMATEST_LAT_SUB_BITS)
+
+struct dmatest_lat {
+	u64		count;
+	u32		hist[DMATEST_LAT_BUCKETS];
+};
+
+/* Transfers per size step in benchmark mode when iterations is not set */
+#define DMATEST_BENCH_ITERATIONS	1000
+/* Smallest transfer size of the benchmark sweep */
+#define DMATEST_BENCH_MIN_LEN		64
+/* Size steps are indexed by log2 of the transfer size */
+#define DMATEST_BENCH_STEPS		32
+
+/**
+ * struct dmatest_bench_step - results of all threads for one transfer size
+ * @len:		transfer size
+ * @threads:		number of threads that ran this size
+ * @tests:		number of transfers
+ * @failures:		number of failed transfers
+ * @bytes:		number of bytes transferred
+ * @runtime:		longest runtime of a thread for this size, in us
+ * @lat:		merged latency histogram
+ */
+struct dmatest_bench_step {
+	unsigned int		len;
+	unsigned int		threads;
+	unsigned long long	tests;
+	unsigned long long	failures;
+	unsigned long long	bytes;
+	s64			runtime;
+	struct dmatest_lat	lat;
+};
+
+/**
+ * struct dmatest_bench - aggregated benchmark results
+ * @lock:		protects @steps
+ * @running:		threads that still have to report
+ * @steps:		per size results, indexed by log2 of the size
+ */
+struct dmatest_bench {
+	struct mutex			lock;
+	atomic_t			running;
+	struct dmatest_bench_step	*steps;
 };
 
 /**
@@ -136,6 +206,8 @@ struct dmatest_params {
  * @lock:		access protection to the fields of this structure
  * @did_init:		module has been initialized completely
  * @last_error:		test has faced configuration issues
+ * @nr_threads:		number of threads created, used to spread them on CPUs
+ * @bench:		aggregated benchmark results
  */
 static struct dmatest_info {
 	/* Test parameters */
@@ -147,9 +219,12 @@ static struct dmatest_info {
 	int			last_error;
 	struct mutex		lock;
 	bool			did_init;
+	unsigned int		nr_threads;
+	struct dmatest_bench	bench;
 } test_info = {
 	.channels = LIST_HEAD_INIT(test_info.channels),
 	.lock = __MUTEX_INITIALIZER(test_info.lock),
+	.bench.lock = __MUTEX_INITIALIZER(test_info.bench.lock),
 };
 
 static int dmatest_run_set(const char *val, const struct kernel_param *kp);
@@ -215,6 +290,7 @@ MODULE_PARM_DESC(test_list, "Print current test list");
 /* poor man's completion - we want to use wait_event_freezable() on it */
 struct dmatest_done {
 	bool			done;
+	ktime_t			time;
 	wait_queue_head_t	*wait;
 };
 
@@ -238,6 +314,7 @@ struct dmatest_thread {
 	struct dmatest_done test_done;
 	bool			done;
 	bool			pending;
+	int			cpu;
 };
 
 struct dmatest_chan {
@@ -286,7 +363,7 @@ static int dmatest_wait_get(char *val, const struct kernel_param *kp)
 	struct dmatest_info *info = &test_info;
 	struct dmatest_params *params = &info->params;
 
-	if (params->iterations)
+	if (params->iterations || params->bench)
 		wait_event(thread_wait, !is_threaded_test_run(info));
 	wait = true;
 	return param_get_bool(val, kp);
@@ -437,6 +514,7 @@ static void dmatest_callback(void *arg)
 	struct dmatest_thread *thread =
 		container_of(done, struct dmatest_thread, test_done);
 	if (!thread->done) {
+		done->time = ktime_get();
 		done->done = true;
 		wake_up_all(done->wait);
 	} else {
@@ -510,6 +588,142 @@ static unsigned long long dmatest_KBs(s64 runtime, unsigned long long len)
 	return FIXPT_TO_INT(dmatest_persec(runtime, len >> 10));
 }
 
+static unsigned int dmatest_lat_idx(u64 ns)
+{
+	unsigned int msb;
+
+	if (ns < (1 << DMATEST_LAT_SUB_BITS))
+		return ns;
+
+	msb = fls64(ns) - 1;
+	if (msb > DMATEST_LAT_MAX_MSB)
+		return DMATEST_LAT_BUCKETS - 1;
+
+	return ((msb - DMATEST_LAT_SUB_BITS + 1) << DMATEST_LAT_SUB_BITS) +
+	       ((ns >> (msb - DMATEST_LAT_SUB_BITS)) &
+		((1 << DMATEST_LAT_SUB_BITS) - 1));
+}
+
+/* upper bound of a latency bucket, in ns */
+static u64 dmatest_lat_val(unsigned int idx)
+{
+	unsigned int shift;
+	u64 base;
+
+	if (idx < (1 << DMATEST_LAT_SUB_BITS))
+		return idx;
+
+	shift = (idx >> DMATEST_LAT_SUB_BITS) - 1;
+	base = (idx & ((1 << DMATEST_LAT_SUB_BITS) - 1)) |
+	       (1 << DMATEST_LAT_SUB_BITS);
+
+	return (base << shift) + (1ULL << shift) - 1;
+}
+
+static void dmatest_lat_add(struct dmatest_lat *lat, ktime_t diff)
+{
+	s64 ns = ktime_to_ns(diff);
+
+	lat->hist[dmatest_lat_idx(ns > 0 ? ns : 0)]++;
+	lat->count++;
+}
+
+static void dmatest_lat_merge(struct dmatest_lat *dst,
+			      const struct dmatest_lat *src)
+{
+	unsigned int i;
+
+	for (i = 0; i < DMATEST_LAT_BUCKETS; i++)
+		dst->hist[i] += src->hist[i];
+	dst->count += src->count;
+}
+
+/* latency below which @pcm per-100000 of the samples fall */
+static u64 dmatest_lat_pct(const struct dmatest_lat *lat, unsigned int pcm)
+{
+	u64 target, sum = 0;
+	unsigned int i;
+
+	if (!lat->count)
+		return 0;
+
+	target = div_u64(lat->count * pcm + 99999, 100000);
+	for (i = 0; i < DMATEST_LAT_BUCKETS; i++) {
+		sum += lat->hist[i];
+		if (sum >= target)
+			break;
+	}
+
+	return dmatest_lat_val(min_t(unsigned int, i, DMATEST_LAT_BUCKETS - 1));
+}
+
+static void dmatest_bench_csv(const char *name, const char *chan, int cpu,
+			      unsigned int len, unsigned long long tests,
+			      unsigned long long failures, s64 runtime,
+			      unsigned long long bytes,
+			      const struct dmatest_lat *lat)
+{
+	pr_info("csv: %s,%s,%d,%u,%llu,%llu,%lld,%llu,%llu,%llu,%llu\n",
+		name, chan, cpu, len, tests, failures, runtime,
+		dmatest_KBs(runtime, bytes), dmatest_lat_pct(lat, 50000),
+		dmatest_lat_pct(lat, 99000), dmatest_lat_pct(lat, 99900));
+}
+
+static void dmatest_bench_step_done(struct dmatest_info *info,
+				    struct dmatest_thread *thread,
+				    unsigned int len, unsigned long long tests,
+				    unsigned long long failures, s64 runtime,
+				    const struct dmatest_lat *lat)
+{
+	struct dmatest_bench *bench = &info->bench;
+	struct dmatest_bench_step *step;
+
+	dmatest_bench_csv(current->comm, dma_chan_name(thread->chan),
+			  thread->cpu, len, tests, failures, runtime,
+			  (unsigned long long)len * tests, lat);
+
+	mutex_lock(&bench->lock);
+	if (bench->steps) {
+		step = &bench->steps[ilog2(len)];
+		step->len = len;
+		step->threads++;
+		step->tests += tests;
+		step->failures += failures;
+		step->bytes += (unsigned long long)len * tests;
+		step->runtime = max(step->runtime, runtime);
+		dmatest_lat_merge(&step->lat, lat);
+	}
+	mutex_unlock(&bench->lock);
+}
+
+/*
+ * The last benchmark thread to finish prints the aggregate of all threads,
+ * the throughput being the sum of all bytes over the longest thread runtime.
+ */
+static void dmatest_bench_thread_done(struct dmatest_info *info)
+{
+	struct dmatest_bench *bench = &info->bench;
+	struct dmatest_bench_step *step;
+	char name[16];
+	unsigned int i;
+
+	if (!atomic_dec_and_test(&bench->running))
+		return;
+
+	mutex_lock(&bench->lock);
+	for (i = 0; bench->steps && i < DMATEST_BENCH_STEPS; i++) {
+		step = &bench->steps[i];
+		if (!step->threads)
+			continue;
+
+		snprintf(name, sizeof(name), "total-%u", step->threads);
+		dmatest_bench_csv(name, "all", -1, step->len, step->tests,
+				  step->failures, step->runtime, step->bytes,
+				  &step->lat);
+	}
+	mutex_unlock(&bench->lock);
+}
+
 static void __dmatest_free_test_data(struct dmatest_data *d, unsigned int cnt)
 {
 	unsigned int i;
@@ -602,6 +816,14 @@ static int dmatest_func(void *data)
 	bool			is_memset = false;
 	dma_addr_t		*srcs;
 	dma_addr_t		*dma_pq;
+	struct dmatest_lat	*lat = NULL;
+	unsigned int		bench_len = 0;
+	unsigned int		bench_iterations = 0;
+	unsigned int		step_tests = 0;
+	unsigned int		step_failed = 0;
+	ktime_t			step_start = 0;
+	ktime_t			step_overhead = 0;
+	ktime_t			submit_time;
 
 	set_freezable();
 
@@ -693,17 +915,62 @@ static int dmatest_func(void *data)
 	else
 		flags = DMA_CTRL_ACK | DMA_PREP_INTERRUPT;
 
+	/*
+	 * Benchmark mode runs 'iterations' transfers per size, starting at
+	 * transfer_size if given, otherwise sweeping from DMATEST_BENCH_MIN_LEN
+	 * up to the buffer size in powers of two.
+	 */
+	if (params->bench) {
+		lat = kvzalloc(sizeof(*lat), GFP_KERNEL);
+		if (!lat)
+			goto err_dma_pq;
+
+		bench_iterations = params->iterations ?: DMATEST_BENCH_ITERATIONS;
+		bench_len = params->transfer_size ?:
+			    max_t(unsigned int, 1U << align, DMATEST_BENCH_MIN_LEN);
+		if (bench_len >= buf_size) {
+			pr_err("%u-byte transfer size must be lower than %u-buffer size\n",
+			       bench_len, buf_size);
+			ret = -EINVAL;
+			kvfree(lat);
+			goto err_dma_pq;
+		}
+	}
+
 	ktime = ktime_get();
+	step_start = ktime;
 	while (!(kthread_should_stop() ||
-	       (params->iterations && total_tests >= params->iterations))) {
+	       (params->iterations && !params->bench &&
+		total_tests >= params->iterations))) {
 		struct dma_async_tx_descriptor *tx = NULL;
 		struct dmaengine_unmap_data *um;
 		dma_addr_t *dsts;
 		unsigned int len;
 
+		if (params->bench && step_tests == bench_iterations) {
+			diff = ktime_sub(ktime_get(), step_start);
+			diff = ktime_sub(diff, ktime_sub(ktime_add(filltime, comparetime),
+							 step_overhead));
+			dmatest_bench_step_done(info, thread, bench_len, step_tests,
+						failed_tests - step_failed,
+						ktime_to_us(diff), lat);
+
+			memset(lat, 0, sizeof(*lat));
+			step_tests = 0;
+			step_failed = failed_tests;
+			step_overhead = ktime_add(filltime, comparetime);
+			bench_len <<= 1;
+			if (params->transfer_size || bench_len >= buf_size)
+				break;
+			step_start = ktime_get();
+		}
+
 		total_tests++;
+		step_tests++;
 
-		if (params->transfer_size) {
+		if (params->bench) {
+			len = bench_len;
+		} else if (params->transfer_size) {
 			if (params->transfer_size >= buf_size) {
 				pr_err("%u-byte transfer size must be lower than %u-buffer size\n",
 				       params->transfer_size, buf_size);
@@ -717,14 +984,14 @@ static int dmatest_func(void *data)
 		}
 
 		/* Do not alter transfer size explicitly defined by user */
-		if (!params->transfer_size) {
+		if (!params->transfer_size && !params->bench) {
 			len = (len >> align) << align;
 			if (!len)
 				len = 1 << align;
 		}
 		total_len += len;
 
-		if (params->norandom) {
+		if (params->norandom || params->bench) {
 			src->off = 0;
 			dst->off = 0;
 		} else {
@@ -824,6 +1091,7 @@ static int dmatest_func(void *data)
 			tx->callback = dmatest_callback;
 			tx->callback_param = done;
 		}
+		submit_time = ktime_get();
 		cookie = tx->tx_submit(tx);
 
 		if (dma_submit_error(cookie)) {
@@ -835,6 +1103,7 @@ static int dmatest_func(void *data)
 
 		if (params->polled) {
 			status = dma_sync_wait(chan, cookie);
+			done->time = ktime_get();
 			dmaengine_terminate_sync(chan);
 			if (status == DMA_COMPLETE)
 				done->done = true;
@@ -864,6 +1133,9 @@ static int dmatest_func(void *data)
 			goto error_unmap_continue;
 		}
 
+		if (lat)
+			dmatest_lat_add(lat, ktime_sub(done->time, submit_time));
+
 		dmaengine_unmap_put(um);
 
 		if (params->noverify) {
@@ -918,7 +1190,19 @@ static int dmatest_func(void *data)
 	ktime = ktime_sub(ktime, filltime);
 	runtime = ktime_to_us(ktime);
 
+	/* report the last step, possibly cut short by kthread_stop() */
+	if (params->bench && step_tests) {
+		diff = ktime_sub(ktime_get(), step_start);
+		diff = ktime_sub(diff, ktime_sub(ktime_add(filltime, comparetime),
+						 step_overhead));
+		dmatest_bench_step_done(info, thread, bench_len, step_tests,
+					failed_tests - step_failed,
+					ktime_to_us(diff), lat);
+	}
+
 	ret = 0;
+	kvfree(lat);
+err_dma_pq:
 	kfree(dma_pq);
 err_srcs_array:
 	kfree(srcs);
@@ -939,6 +1223,9 @@ static int dmatest_func(void *data)
 	if (ret || failed_tests)
 		dmaengine_terminate_sync(chan);
 
+	if (params->bench)
+		dmatest_bench_thread_done(info);
+
 	thread->done = true;
 	wake_up(&thread_wait);
 
@@ -996,6 +1283,7 @@ static int dmatest_add_threads(struct dmatest_info *info,
 		thread->info = info;
 		thread->chan = dtc->chan;
 		thread->type = type;
+		thread->cpu = -1;
 		thread->test_done.wait = &thread->done_wait;
 		init_waitqueue_head(&thread->done_wait);
 		smp_wmb();
@@ -1008,6 +1296,13 @@ static int dmatest_add_threads(struct dmatest_info *info,
 			break;
 		}
 
+		if (params->pin_cpus) {
+			thread->cpu = cpumask_local_spread(info->nr_threads,
+						dev_to_node(chan->device->dev));
+			kthread_bind(thread->task, thread->cpu);
+		}
+		info->nr_threads++;
+
 		/* srcbuf and dstbuf are allocated by the thread itself */
 		get_task_struct(thread->task);
 		list_add_tail(&thread->node, &dtc->threads);
@@ -1122,6 +1417,8 @@ static void add_threaded_test(struct dmatest_info *info)
 	params->alignment = alignment;
 	params->transfer_size = transfer_size;
 	params->polled = polled;
+	params->bench = bench;
+	params->pin_cpus = pin_cpus;
 
 	request_channels(info, DMA_MEMCPY);
 	request_channels(info, DMA_MEMSET);
@@ -1129,11 +1426,39 @@ static void add_threaded_test(struct dmatest_info *info)
 	request_channels(info, DMA_PQ);
 }
 
+static void dmatest_bench_start(struct dmatest_info *info)
+{
+	struct dmatest_bench *bench = &info->bench;
+	struct dmatest_chan *dtc;
+	struct dmatest_thread *thread;
+	unsigned int count = 0;
+
+	list_for_each_entry(dtc, &info->channels, node)
+		list_for_each_entry(thread, &dtc->threads, node)
+			if (thread->pending)
+				count++;
+
+	mutex_lock(&bench->lock);
+	kvfree(bench->steps);
+	bench->steps = kvcalloc(DMATEST_BENCH_STEPS, sizeof(*bench->steps),
+				GFP_KERNEL);
+	if (!bench->steps)
+		pr_warn("No memory for benchmark totals\n");
+	mutex_unlock(&bench->lock);
+
+	atomic_set(&bench->running, count);
+
+	pr_info("csv: thread,channel,cpu,len,tests,failures,runtime_us,KBps,p50_ns,p99_ns,p999_ns\n");
+}
+
 static void run_pending_tests(struct dmatest_info *info)
 {
 	struct dmatest_chan *dtc;
 	unsigned int thread_count = 0;
 
+	if (info->params.bench)
+		dmatest_bench_start(info);
+
 	list_for_each_entry(dtc, &info->channels, node) {
 		struct dmatest_thread *thread;
 
@@ -1161,6 +1486,12 @@ static void stop_threaded_test(struct dmatest_info *info)
 	}
 
 	info->nr_channels = 0;
+	info->nr_threads = 0;
+
+	mutex_lock(&info->bench.lock);
+	kvfree(info->bench.steps);
+	info->bench.steps = NULL;
+	mutex_unlock(&info->bench.lock);
 }
 
 static void start_threaded_tests(struct dmatest_info *info)
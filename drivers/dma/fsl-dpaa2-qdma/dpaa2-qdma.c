@@ -26,39 +26,67 @@ static struct dpaa2_qdma_comp *to_fsl_qdma_comp(struct virt_dma_desc *vd)
 	return container_of(vd, struct dpaa2_qdma_comp, vdesc);
 }
 
+/*
+ * Each descriptor takes one FD_POOL_SIZE block holding its frame descriptor,
+ * the three frame list entries and the source/destination descriptors, so a
+ * descriptor costs a single dma_pool allocation.
+ */
+static struct dpaa2_qdma_comp *
+dpaa2_qdma_alloc_comp(struct dpaa2_qdma_chan *dpaa2_chan, gfp_t gfp)
+{
+	struct dpaa2_qdma_comp *comp_temp;
+	dma_addr_t bus_addr;
+	void *virt_addr;
+
+	comp_temp = kzalloc(sizeof(*comp_temp), gfp);
+	if (!comp_temp)
+		return NULL;
+
+	virt_addr = dma_pool_alloc(dpaa2_chan->fd_pool, gfp, &bus_addr);
+	if (!virt_addr) {
+		kfree(comp_temp);
+		return NULL;
+	}
+
+	comp_temp->fd_virt_addr = virt_addr;
+	comp_temp->fd_bus_addr = bus_addr;
+	comp_temp->fl_virt_addr = virt_addr + DPAA2_QDMA_FL_OFFSET;
+	comp_temp->fl_bus_addr = bus_addr + DPAA2_QDMA_FL_OFFSET;
+	comp_temp->desc_virt_addr = virt_addr + DPAA2_QDMA_SDD_OFFSET;
+	comp_temp->desc_bus_addr = bus_addr + DPAA2_QDMA_SDD_OFFSET;
+	comp_temp->qchan = dpaa2_chan;
+	INIT_LIST_HEAD(&comp_temp->list);
+
+	return comp_temp;
+}
+
 static int dpaa2_qdma_alloc_chan_resources(struct dma_chan *chan)
 {
 	struct dpaa2_qdma_chan *dpaa2_chan = to_dpaa2_qdma_chan(chan);
 	struct dpaa2_qdma_engine *dpaa2_qdma = dpaa2_chan->qdma;
 	struct device *dev = &dpaa2_qdma->priv->dpdmai_dev->dev;
+	struct dpaa2_qdma_comp *comp_temp;
+	int i;
 
-	dpaa2_chan->fd_pool = dma_pool_create("fd_pool", dev,
-					      sizeof(struct dpaa2_fd),
+	dpaa2_chan->fd_pool = dma_pool_create("fd_pool", dev, FD_POOL_SIZE,
 					      sizeof(struct dpaa2_fd), 0);
 	if (!dpaa2_chan->fd_pool)
-		goto err;
-
-	dpaa2_chan->fl_pool =
-		dma_pool_create("fl_pool", dev,
-				 sizeof(struct dpaa2_fl_entry) * 3,
-				 sizeof(struct dpaa2_fl_entry), 0);
-
-	if (!dpaa2_chan->fl_pool)
-		goto err_fd;
+		return -ENOMEM;
 
-	dpaa2_chan->sdd_pool =
-		dma_pool_create("sdd_pool", dev,
-				sizeof(struct dpaa2_qdma_sd_d) * 2,
-				sizeof(struct dpaa2_qdma_sd_d), 0);
-	if (!dpaa2_chan->sdd_pool)
-		goto err_fl;
+	/* Fill the descriptor cache so small copies never hit the pool. */
+	for (i = 0; i < DPAA2_QDMA_COMP_CACHE; i++) {
+		comp_temp = dpaa2_qdma_alloc_comp(dpaa2_chan, GFP_KERNEL);
+		if (!comp_temp)
+			goto err_comp;
+		list_add_tail(&comp_temp->list, &dpaa2_chan->comp_free);
+	}
 
 	return dpaa2_qdma->desc_allocated++;
-err_fl:
-	dma_pool_destroy(dpaa2_chan->fl_pool);
-err_fd:
+
+err_comp:
+	dpaa2_dpdmai_free_comp(dpaa2_chan, &dpaa2_chan->comp_free);
 	dma_pool_destroy(dpaa2_chan->fd_pool);
-err:
+	dpaa2_chan->fd_pool = NULL;
 	return -ENOMEM;
 }
 
@@ -80,8 +108,7 @@ static void dpaa2_qdma_free_chan_resources(struct dma_chan *chan)
 	dpaa2_dpdmai_free_comp(dpaa2_chan, &dpaa2_chan->comp_free);
 
 	dma_pool_destroy(dpaa2_chan->fd_pool);
-	dma_pool_destroy(dpaa2_chan->fl_pool);
-	dma_pool_destroy(dpaa2_chan->sdd_pool);
+	dpaa2_chan->fd_pool = NULL;
 	dpaa2_qdma->desc_allocated--;
 }
 
@@ -99,53 +126,20 @@ dpaa2_qdma_request_desc(struct dpaa2_qdma_chan *dpaa2_chan)
 	spin_lock_irqsave(&dpaa2_chan->queue_lock, flags);
 	if (list_empty(&dpaa2_chan->comp_free)) {
 		spin_unlock_irqrestore(&dpaa2_chan->queue_lock, flags);
-		comp_temp = kzalloc(sizeof(*comp_temp), GFP_NOWAIT);
+		comp_temp = dpaa2_qdma_alloc_comp(dpaa2_chan, GFP_NOWAIT);
 		if (!comp_temp)
-			goto err;
-		comp_temp->fd_virt_addr =
-			dma_pool_alloc(dpaa2_chan->fd_pool, GFP_NOWAIT,
-				       &comp_temp->fd_bus_addr);
-		if (!comp_temp->fd_virt_addr)
-			goto err_comp;
-
-		comp_temp->fl_virt_addr =
-			dma_pool_alloc(dpaa2_chan->fl_pool, GFP_NOWAIT,
-				       &comp_temp->fl_bus_addr);
-		if (!comp_temp->fl_virt_addr)
-			goto err_fd_virt;
-
-		comp_temp->desc_virt_addr =
-			dma_pool_alloc(dpaa2_chan->sdd_pool, GFP_NOWAIT,
-				       &comp_temp->desc_bus_addr);
-		if (!comp_temp->desc_virt_addr)
-			goto err_fl_virt;
-
-		comp_temp->qchan = dpaa2_chan;
+			dev_err(dev, "Failed to request descriptor\n");
 		return comp_temp;
 	}
 
 	comp_temp = list_first_entry(&dpaa2_chan->comp_free,
 				     struct dpaa2_qdma_comp, list);
-	list_del(&comp_temp->list);
+	list_del_init(&comp_temp->list);
 	spin_unlock_irqrestore(&dpaa2_chan->queue_lock, flags);
 
 	comp_temp->qchan = dpaa2_chan;
 
 	return comp_temp;
-
-err_fl_virt:
-		dma_pool_free(dpaa2_chan->fl_pool,
-			      comp_temp->fl_virt_addr,
-			      comp_temp->fl_bus_addr);
-err_fd_virt:
-		dma_pool_free(dpaa2_chan->fd_pool,
-			      comp_temp->fd_virt_addr,
-			      comp_temp->fd_bus_addr);
-err_comp:
-	kfree(comp_temp);
-err:
-	dev_err(dev, "Failed to request descriptor\n");
-	return NULL;
 }
 
 static void
@@ -269,32 +263,51 @@ static struct dma_async_tx_descriptor
 	return vchan_tx_prep(&dpaa2_chan->vchan, &dpaa2_comp->vdesc, flags);
 }
 
+/*
+ * Push every issued descriptor to the frame queue, up to
+ * DPAA2_QDMA_ENQ_BATCH frames per portal command. Whatever the portal does
+ * not take stays on the issued list for the next issue_pending call.
+ */
 static void dpaa2_qdma_issue_pending(struct dma_chan *chan)
 {
 	struct dpaa2_qdma_chan *dpaa2_chan = to_dpaa2_qdma_chan(chan);
-	struct dpaa2_qdma_comp *dpaa2_comp;
+	struct dpaa2_qdma_comp *batch[DPAA2_QDMA_ENQ_BATCH];
+	struct dpaa2_fd fds[DPAA2_QDMA_ENQ_BATCH];
+	int retries = DPAA2_QDMA_ENQ_RETRIES;
 	struct virt_dma_desc *vdesc;
-	struct dpaa2_fd *fd;
 	unsigned long flags;
-	int err;
+	int nb, i, err;
 
 	spin_lock_irqsave(&dpaa2_chan->queue_lock, flags);
 	spin_lock(&dpaa2_chan->vchan.lock);
-	if (vchan_issue_pending(&dpaa2_chan->vchan)) {
-		vdesc = vchan_next_desc(&dpaa2_chan->vchan);
-		if (!vdesc)
-			goto err_enqueue;
-		dpaa2_comp = to_fsl_qdma_comp(vdesc);
-
-		fd = dpaa2_comp->fd_virt_addr;
-
-		list_del(&vdesc->node);
-		list_add_tail(&dpaa2_comp->list, &dpaa2_chan->comp_used);
+	if (!vchan_issue_pending(&dpaa2_chan->vchan))
+		goto err_enqueue;
+
+	while (retries) {
+		nb = 0;
+		list_for_each_entry(vdesc, &dpaa2_chan->vchan.desc_issued,
+				    node) {
+			batch[nb] = to_fsl_qdma_comp(vdesc);
+			fds[nb] = *batch[nb]->fd_virt_addr;
+			if (++nb == DPAA2_QDMA_ENQ_BATCH)
+				break;
+		}
+		if (!nb)
+			break;
+
+		err = dpaa2_io_service_enqueue_multiple_fq(NULL,
+							   dpaa2_chan->fqid,
+							   fds, nb);
+		if (err <= 0) {
+			if (err && err != -EBUSY)
+				break;
+			retries--;
+			continue;
+		}
 
-		err = dpaa2_io_service_enqueue_fq(NULL, dpaa2_chan->fqid, fd);
-		if (err) {
-			list_move_tail(&dpaa2_comp->list,
-				       &dpaa2_chan->comp_free);
+		for (i = 0; i < err; i++) {
+			list_del(&batch[i]->vdesc.node);
+			list_move_tail(&batch[i]->list, &dpaa2_chan->comp_used);
 		}
 	}
 err_enqueue:
@@ -592,12 +605,6 @@ static void dpaa2_dpdmai_free_comp(struct dpaa2_qdma_chan *qchan,
 		dma_pool_free(qchan->fd_pool,
 			      comp_tmp->fd_virt_addr,
 			      comp_tmp->fd_bus_addr);
-		dma_pool_free(qchan->fl_pool,
-			      comp_tmp->fl_virt_addr,
-			      comp_tmp->fl_bus_addr);
-		dma_pool_free(qchan->sdd_pool,
-			      comp_tmp->desc_virt_addr,
-			      comp_tmp->desc_bus_addr);
 		kfree(comp_tmp);
 	}
 }
@@ -613,8 +620,7 @@ static void dpaa2_dpdmai_free_channels(struct dpaa2_qdma_engine *dpaa2_qdma)
 		dpaa2_dpdmai_free_comp(qchan, &qchan->comp_used);
 		dpaa2_dpdmai_free_comp(qchan, &qchan->comp_free);
 		dma_pool_destroy(qchan->fd_pool);
-		dma_pool_destroy(qchan->fl_pool);
-		dma_pool_destroy(qchan->sdd_pool);
+		qchan->fd_pool = NULL;
 	}
 }
 
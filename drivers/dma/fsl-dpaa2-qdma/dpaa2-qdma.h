@@ -7,6 +7,9 @@
 #define DPAA2_QDMA_STORE_SIZE 16
 #define NUM_CH 8
 #define DPAA2_QDMA_DEFAULT_PRIORITY 0
+#define DPAA2_QDMA_COMP_CACHE 64 /* descriptors pre-allocated per channel */
+#define DPAA2_QDMA_ENQ_BATCH 8 /* frames per enqueue-multiple command */
+#define DPAA2_QDMA_ENQ_RETRIES 10
 
 struct dpaa2_qdma_sd_d {
 	u32 rsv:32;
@@ -77,8 +80,6 @@ struct dpaa2_qdma_chan {
 	/* spinlock used by dpaa2 qdma driver */
 	spinlock_t			queue_lock;
 	struct dma_pool			*fd_pool;
-	struct dma_pool			*fl_pool;
-	struct dma_pool			*sdd_pool;
 
 	struct list_head		comp_used;
 	struct list_head		comp_free;
@@ -147,6 +148,9 @@ static struct soc_device_attribute soc_fixup_tuning[] = {
 #define FD_POOL_SIZE (sizeof(struct dpaa2_fd) + \
 		sizeof(struct dpaa2_fl_entry) * 3 + \
 		sizeof(struct dpaa2_qdma_sd_d) * 2)
+#define DPAA2_QDMA_FL_OFFSET	sizeof(struct dpaa2_fd)
+#define DPAA2_QDMA_SDD_OFFSET	(DPAA2_QDMA_FL_OFFSET + \
+		sizeof(struct dpaa2_fl_entry) * 3)
 
 static void dpaa2_dpdmai_free_channels(struct dpaa2_qdma_engine *dpaa2_qdma);
 static void dpaa2_dpdmai_free_comp(struct dpaa2_qdma_chan *qchan,
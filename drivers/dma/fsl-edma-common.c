@@ -5,12 +5,15 @@
 
 #include <linux/cleanup.h>
 #include <linux/clk.h>
+#include <linux/debugfs.h>
 #include <linux/dmapool.h>
+#include <linux/log2.h>
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/dma-mapping.h>
 #include <linux/pm_runtime.h>
 #include <linux/pm_domain.h>
+#include <linux/seq_file.h>
 
 #include "fsl-edma-common.h"
 
@@ -44,6 +47,123 @@
 #define EDMA64_ERRH		0x28
 #define EDMA64_ERRL		0x2c
 
+static void fsl_edma_lat_account(u64 *hist, u64 ns)
+{
+	hist[min_t(unsigned int, ns ? ilog2(ns) : 0, FSL_EDMA_LAT_BUCKETS - 1)]++;
+}
+
+static void fsl_edma_desc_done(struct fsl_edma_chan *fsl_chan,
+			       struct fsl_edma_desc *edesc)
+{
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), edesc->started));
+
+	fsl_edma_lat_account(fsl_chan->lat_hist.hw_time, ns);
+	trace_edma_hw_time(fsl_chan, edesc->vdesc.tx.cookie, ns);
+}
+
+static size_t fsl_edma_desc_residue(struct fsl_edma_chan *fsl_chan,
+		struct virt_dma_desc *vdesc, bool in_progress);
+
+/*
+ * Completion coalescing: with adaptive_coalescing set, the completions of a
+ * channel working through a queue of descriptors are handed to the vchan
+ * tasklet, which runs the client callbacks, once coal_comps of them are
+ * done or coal_usec after the first one, whichever comes first.  The next
+ * descriptor is still started from the interrupt right away, and nothing is
+ * held once the channel runs out of work.  comp_dim picks the profile from
+ * the byte and completion rates, biased towards latency, as most clients
+ * wait for their callbacks before queueing more.
+ */
+static void fsl_edma_coal_flush(struct fsl_edma_chan *fsl_chan)
+{
+	struct dim_sample sample = {};
+
+	if (!fsl_chan->coal_pending)
+		return;
+
+	fsl_chan->coal_pending = 0;
+	/* may be called from the timer itself, so don't wait for it */
+	hrtimer_try_to_cancel(&fsl_chan->coal_timer);
+	tasklet_schedule(&fsl_chan->vchan.task);
+
+	dim_update_sample_with_comps(++fsl_chan->dim_events, 0,
+				     fsl_chan->dim_bytes, fsl_chan->dim_comps,
+				     &sample);
+	comp_dim(&fsl_chan->dim, sample, true);
+}
+
+static void fsl_edma_coal_complete(struct fsl_edma_chan *fsl_chan,
+				   struct fsl_edma_desc *edesc)
+{
+	struct virt_dma_desc *vdesc = &edesc->vdesc;
+
+	if (!READ_ONCE(fsl_chan->edma->adaptive_coalescing)) {
+		fsl_edma_coal_flush(fsl_chan);
+		vchan_cookie_complete(vdesc);
+		return;
+	}
+
+	fsl_chan->dim_comps++;
+	fsl_chan->dim_bytes += fsl_edma_desc_residue(fsl_chan, vdesc, false);
+
+	dma_cookie_complete(&vdesc->tx);
+	list_add_tail(&vdesc->node, &fsl_chan->vchan.desc_completed);
+
+	if (++fsl_chan->coal_pending >= fsl_chan->coal_comps ||
+	    list_empty(&fsl_chan->vchan.desc_issued))
+		fsl_edma_coal_flush(fsl_chan);
+	else if (fsl_chan->coal_pending == 1)
+		hrtimer_start(&fsl_chan->coal_timer,
+			      us_to_ktime(fsl_chan->coal_usec),
+			      HRTIMER_MODE_REL);
+}
+
+static enum hrtimer_restart fsl_edma_coal_timer(struct hrtimer *timer)
+{
+	struct fsl_edma_chan *fsl_chan =
+		container_of(timer, struct fsl_edma_chan, coal_timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&fsl_chan->vchan.lock, flags);
+	fsl_edma_coal_flush(fsl_chan);
+	spin_unlock_irqrestore(&fsl_chan->vchan.lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
+static void fsl_edma_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct fsl_edma_chan *fsl_chan =
+		container_of(dim, struct fsl_edma_chan, dim);
+	struct dim_cq_moder moder = comp_dim_get_moderation(dim->profile_ix);
+	unsigned long flags;
+
+	spin_lock_irqsave(&fsl_chan->vchan.lock, flags);
+	fsl_chan->coal_usec = moder.usec;
+	fsl_chan->coal_comps = moder.comps;
+	dim->state = DIM_START_MEASURE;
+	spin_unlock_irqrestore(&fsl_chan->vchan.lock, flags);
+}
+
+static void fsl_edma_coal_init(struct fsl_edma_chan *fsl_chan)
+{
+	struct dim_cq_moder moder;
+
+	memset(&fsl_chan->dim, 0, sizeof(fsl_chan->dim));
+	INIT_WORK(&fsl_chan->dim.work, fsl_edma_dim_work);
+	fsl_chan->dim.profile_ix = COMP_DIM_START_PROFILE;
+	fsl_chan->dim.state = DIM_START_MEASURE;
+
+	moder = comp_dim_get_moderation(COMP_DIM_START_PROFILE);
+	fsl_chan->coal_usec = moder.usec;
+	fsl_chan->coal_comps = moder.comps;
+	fsl_chan->coal_pending = 0;
+
+	hrtimer_init(&fsl_chan->coal_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	fsl_chan->coal_timer.function = fsl_edma_coal_timer;
+}
+
 void fsl_edma_tx_chan_handler(struct fsl_edma_chan *fsl_chan)
 {
 	spin_lock(&fsl_chan->vchan.lock);
@@ -55,15 +175,23 @@ void fsl_edma_tx_chan_handler(struct fsl_edma_chan *fsl_chan)
 	}
 
 	if (!fsl_chan->edesc) {
-		/* terminate_all called before */
+		/*
+		 * terminate_all called before, or the descriptor was completed
+		 * by polling and this is its major loop interrupt.
+		 */
+		if (fsl_chan->poll_irq_pending) {
+			fsl_chan->poll_irq_pending = false;
+			fsl_edma_xfer_desc(fsl_chan);
+		}
 		spin_unlock(&fsl_chan->vchan.lock);
 		return;
 	}
 
 	if (!fsl_chan->edesc->iscyclic) {
 		fsl_edma_get_realcnt(fsl_chan);
+		fsl_edma_desc_done(fsl_chan, fsl_chan->edesc);
 		list_del(&fsl_chan->edesc->vdesc.node);
-		vchan_cookie_complete(&fsl_chan->edesc->vdesc);
+		fsl_edma_coal_complete(fsl_chan, fsl_chan->edesc);
 		fsl_chan->edesc = NULL;
 		fsl_chan->status = DMA_COMPLETE;
 	} else {
@@ -245,6 +373,9 @@ int fsl_edma_terminate_all(struct dma_chan *chan)
 	spin_lock_irqsave(&fsl_chan->vchan.lock, flags);
 	fsl_edma_disable_request(fsl_chan);
 	fsl_chan->edesc = NULL;
+	fsl_chan->poll_irq_pending = false;
+	/* held completions are freed with the rest, and the timer is a nop */
+	fsl_chan->coal_pending = 0;
 	fsl_chan->status = DMA_COMPLETE;
 	vchan_get_all_descriptors(&fsl_chan->vchan, &head);
 	spin_unlock_irqrestore(&fsl_chan->vchan.lock, flags);
@@ -401,6 +532,41 @@ void fsl_edma_get_realcnt(struct fsl_edma_chan *fsl_chan)
 	fsl_chan->chn_real_count = fsl_edma_desc_residue(fsl_chan, NULL, true);
 }
 
+/*
+ * DMA_PREP_POLL: complete the current descriptor as soon as the hardware
+ * reports DONE. The major loop interrupt still arrives afterwards and is the
+ * one starting the next descriptor, so it can't be mistaken for the
+ * completion of a descriptor loaded in the meantime.
+ */
+static void fsl_edma_poll_desc(struct fsl_edma_chan *fsl_chan)
+{
+	struct fsl_edma_desc *edesc;
+	unsigned long flags;
+	bool done;
+
+	spin_lock_irqsave(&fsl_chan->vchan.lock, flags);
+	edesc = fsl_chan->edesc;
+	if (!edesc || edesc->iscyclic || !vchan_desc_polled(&edesc->vdesc))
+		goto out;
+
+	if (fsl_edma_drvflags(fsl_chan) & FSL_EDMA_DRV_SPLIT_REG)
+		done = edma_readl_chreg(fsl_chan, ch_csr) & EDMA_V3_CH_CSR_DONE;
+	else
+		done = edma_read_tcdreg(fsl_chan, csr) & EDMA_TCD_CSR_DONE;
+	if (!done)
+		goto out;
+
+	fsl_edma_get_realcnt(fsl_chan);
+	fsl_edma_desc_done(fsl_chan, edesc);
+	list_del(&edesc->vdesc.node);
+	vchan_cookie_complete(&edesc->vdesc);
+	fsl_chan->edesc = NULL;
+	fsl_chan->status = DMA_COMPLETE;
+	fsl_chan->poll_irq_pending = true;
+out:
+	spin_unlock_irqrestore(&fsl_chan->vchan.lock, flags);
+}
+
 enum dma_status fsl_edma_tx_status(struct dma_chan *chan,
 		dma_cookie_t cookie, struct dma_tx_state *txstate)
 {
@@ -410,6 +576,10 @@ enum dma_status fsl_edma_tx_status(struct dma_chan *chan,
 	unsigned long flags;
 
 	status = dma_cookie_status(chan, cookie, txstate);
+	if (status != DMA_COMPLETE && READ_ONCE(fsl_chan->edesc)) {
+		fsl_edma_poll_desc(fsl_chan);
+		status = dma_cookie_status(chan, cookie, txstate);
+	}
 	if (status == DMA_COMPLETE) {
 		spin_lock_irqsave(&fsl_chan->vchan.lock, flags);
 		txstate->residue = fsl_chan->chn_real_count;
@@ -763,20 +933,42 @@ struct dma_async_tx_descriptor *fsl_edma_prep_memcpy(struct dma_chan *chan,
 	struct fsl_edma_desc *fsl_desc;
 	u32 bus_width = fsl_chan->edma->dma_coherent ?
 			DMA_SLAVE_BUSWIDTH_64_BYTES : DMA_SLAVE_BUSWIDTH_32_BYTES;
+	size_t tcd_len, count;
+	dma_addr_t last_sg;
+	bool last;
+	int n_tcds, i;
 
-	fsl_desc = fsl_edma_alloc_desc(fsl_chan, 1);
+	/*
+	 * One minor loop per TCD, sized to max_seg_size so that a single
+	 * request doesn't hog the engine. Longer copies are split into a
+	 * hardware scatter-gather chain with only the final TCD raising the
+	 * major loop interrupt.
+	 */
+	tcd_len = ALIGN_DOWN(dma_get_max_seg_size(chan->device->dev), bus_width);
+	n_tcds = DIV_ROUND_UP(len, tcd_len) ?: 1;
+
+	fsl_desc = fsl_edma_alloc_desc(fsl_chan, n_tcds);
 	if (!fsl_desc)
 		return NULL;
 	fsl_desc->iscyclic = false;
+	fsl_desc->dirn = DMA_MEM_TO_MEM;
 
 	fsl_chan->is_sw = true;
 	if (fsl_edma_drvflags(fsl_chan) & FSL_EDMA_DRV_MEM_REMOTE)
 		fsl_chan->is_remote = true;
 
-	/* To match with copy_align and max_seg_size so 1 tcd is enough */
-	fsl_edma_fill_tcd(fsl_chan, fsl_desc->tcd[0].vtcd, dma_src, dma_dst,
-			  fsl_edma_get_tcd_attr(bus_width), bus_width, len,
-			  0, 1, 1, bus_width, 0, true, true, false);
+	for (i = 0; i < n_tcds; i++) {
+		last = i == n_tcds - 1;
+		count = last ? len - i * tcd_len : tcd_len;
+		last_sg = last ? 0 : fsl_desc->tcd[i + 1].ptcd;
+
+		fsl_edma_fill_tcd(fsl_chan, fsl_desc->tcd[i].vtcd, dma_src, dma_dst,
+				  fsl_edma_get_tcd_attr(bus_width), bus_width, count,
+				  0, 1, 1, bus_width, last_sg, last, last, !last);
+
+		dma_src += count;
+		dma_dst += count;
+	}
 
 	return vchan_tx_prep(&fsl_chan->vchan, &fsl_desc->vdesc, flags);
 }
@@ -784,13 +976,26 @@ struct dma_async_tx_descriptor *fsl_edma_prep_memcpy(struct dma_chan *chan,
 void fsl_edma_xfer_desc(struct fsl_edma_chan *fsl_chan)
 {
 	struct virt_dma_desc *vdesc;
+	struct fsl_edma_desc *edesc;
+	u64 ns;
 
 	lockdep_assert_held(&fsl_chan->vchan.lock);
 
 	vdesc = vchan_next_desc(&fsl_chan->vchan);
 	if (!vdesc)
 		return;
-	fsl_chan->edesc = to_fsl_edma_desc(vdesc);
+	fsl_chan->edesc = edesc = to_fsl_edma_desc(vdesc);
+
+	/* DONE of the previous descriptor must not be taken for this one */
+	if (vchan_desc_polled(vdesc) &&
+	    (fsl_edma_drvflags(fsl_chan) & FSL_EDMA_DRV_SPLIT_REG))
+		edma_writel_chreg(fsl_chan, edma_readl_chreg(fsl_chan, ch_csr), ch_csr);
+
+	edesc->started = ktime_get();
+	ns = ktime_to_ns(ktime_sub(edesc->started, edesc->issued));
+	fsl_edma_lat_account(fsl_chan->lat_hist.queue_wait, ns);
+	trace_edma_queue_wait(fsl_chan, vdesc->tx.cookie, ns);
+
 	fsl_edma_set_tcd_regs(fsl_chan, fsl_chan->edesc->tcd[0].vtcd);
 	fsl_edma_enable_request(fsl_chan);
 	fsl_chan->status = DMA_IN_PROGRESS;
@@ -799,7 +1004,9 @@ void fsl_edma_xfer_desc(struct fsl_edma_chan *fsl_chan)
 void fsl_edma_issue_pending(struct dma_chan *chan)
 {
 	struct fsl_edma_chan *fsl_chan = to_fsl_edma_chan(chan);
+	struct virt_dma_desc *vdesc;
 	unsigned long flags;
+	ktime_t now;
 
 	spin_lock_irqsave(&fsl_chan->vchan.lock, flags);
 
@@ -809,7 +1016,12 @@ void fsl_edma_issue_pending(struct dma_chan *chan)
 		return;
 	}
 
-	if (vchan_issue_pending(&fsl_chan->vchan) && !fsl_chan->edesc)
+	now = ktime_get();
+	list_for_each_entry(vdesc, &fsl_chan->vchan.desc_submitted, node)
+		to_fsl_edma_desc(vdesc)->issued = now;
+
+	if (vchan_issue_pending(&fsl_chan->vchan) && !fsl_chan->edesc &&
+	    !fsl_chan->poll_irq_pending)
 		fsl_edma_xfer_desc(fsl_chan);
 
 	spin_unlock_irqrestore(&fsl_chan->vchan.lock, flags);
@@ -827,6 +1039,8 @@ int fsl_edma_alloc_chan_resources(struct dma_chan *chan)
 	if (fsl_edma_drvflags(fsl_chan) & FSL_EDMA_DRV_HAS_PD)
 		pm_runtime_get_sync(fsl_chan->pd_dev);
 
+	fsl_edma_coal_init(fsl_chan);
+
 	/* Configuring the write-allocate, read-allocate, cacheable and bufferable
 	 * can improve data transmission performance.
 	 */
@@ -881,10 +1095,14 @@ void fsl_edma_free_chan_resources(struct dma_chan *chan)
 	if (edma->drvdata->dmamuxs)
 		fsl_edma_chan_mux(fsl_chan, 0, false);
 	fsl_chan->edesc = NULL;
+	fsl_chan->coal_pending = 0;
 	vchan_get_all_descriptors(&fsl_chan->vchan, &head);
 	fsl_edma_unprep_slave_dma(fsl_chan);
 	spin_unlock_irqrestore(&fsl_chan->vchan.lock, flags);
 
+	hrtimer_cancel(&fsl_chan->coal_timer);
+	cancel_work_sync(&fsl_chan->dim.work);
+
 	if (fsl_chan->txirq)
 		free_irq(fsl_chan->txirq, fsl_chan);
 	if (fsl_chan->errirq)
@@ -922,6 +1140,105 @@ void fsl_edma_cleanup_vchan(struct dma_device *dmadev)
  * so must be called in xxx_edma_probe() just after setting the
  * edma "version" and "membase" appropriately.
  */
+static void fsl_edma_lat_show(struct seq_file *s, const char *name,
+			      const u64 *hist)
+{
+	int i, last;
+
+	for (last = FSL_EDMA_LAT_BUCKETS - 1; last >= 0; last--)
+		if (hist[last])
+			break;
+
+	seq_printf(s, "  %s:", name);
+	for (i = 0; i <= last; i++)
+		seq_printf(s, " %llu", hist[i]);
+	seq_puts(s, "\n");
+}
+
+static int fsl_edma_latency_show(struct seq_file *s, void *data)
+{
+	struct fsl_edma_engine *edma = s->private;
+	struct fsl_edma_lat_hist hist;
+	unsigned long flags;
+	int i;
+
+	seq_puts(s, "log2(ns) buckets, bucket n counts latencies in [2^n, 2^(n+1))\n");
+	for (i = 0; i < edma->n_chans; i++) {
+		struct fsl_edma_chan *fsl_chan = &edma->chans[i];
+
+		if (edma->chan_masked & BIT_ULL(i))
+			continue;
+
+		spin_lock_irqsave(&fsl_chan->vchan.lock, flags);
+		hist = fsl_chan->lat_hist;
+		spin_unlock_irqrestore(&fsl_chan->vchan.lock, flags);
+
+		if (!memchr_inv(&hist, 0, sizeof(hist)))
+			continue;
+
+		seq_printf(s, "%s:\n", fsl_chan->chan_name);
+		fsl_edma_lat_show(s, "queue_wait", hist.queue_wait);
+		fsl_edma_lat_show(s, "hw_time", hist.hw_time);
+	}
+
+	return 0;
+}
+
+static ssize_t fsl_edma_latency_reset(struct file *file, const char __user *buf,
+				      size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct fsl_edma_engine *edma = s->private;
+	unsigned long flags;
+	int i;
+
+	for (i = 0; i < edma->n_chans; i++) {
+		struct fsl_edma_chan *fsl_chan = &edma->chans[i];
+
+		if (edma->chan_masked & BIT_ULL(i))
+			continue;
+
+		spin_lock_irqsave(&fsl_chan->vchan.lock, flags);
+		memset(&fsl_chan->lat_hist, 0, sizeof(fsl_chan->lat_hist));
+		spin_unlock_irqrestore(&fsl_chan->vchan.lock, flags);
+	}
+
+	return count;
+}
+
+static int fsl_edma_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fsl_edma_latency_show, inode->i_private);
+}
+
+static const struct file_operations fsl_edma_latency_fops = {
+	.owner		= THIS_MODULE,
+	.open		= fsl_edma_latency_open,
+	.read		= seq_read,
+	.write		= fsl_edma_latency_reset,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/*
+ * /sys/kernel/debug/dmaengine/<dev>/latency: per channel histograms of the
+ * time descriptors wait between issue_pending and being loaded into the
+ * TCD registers, and of the time the hardware takes to complete them.
+ * Writing anything to the file clears the histograms.
+ *
+ * /sys/kernel/debug/dmaengine/<dev>/adaptive_coalescing: hold the client
+ * callbacks of a busy channel for a few completions, as comp_dim sees fit.
+ */
+void fsl_edma_debugfs_init(struct fsl_edma_engine *edma)
+{
+	struct dentry *root = dmaengine_get_debugfs_root(&edma->dma_dev);
+
+	debugfs_create_file("latency", 0644, root, edma,
+			    &fsl_edma_latency_fops);
+	debugfs_create_bool("adaptive_coalescing", 0644, root,
+			    &edma->adaptive_coalescing);
+}
+
 void fsl_edma_setup_regs(struct fsl_edma_engine *edma)
 {
 	bool is64 = !!(edma->drvdata->flags & FSL_EDMA_DRV_EDMA64);
@@ -6,7 +6,10 @@
 #ifndef _FSL_EDMA_COMMON_H_
 #define _FSL_EDMA_COMMON_H_
 
+#include <linux/dim.h>
 #include <linux/dma-direction.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
 #include <linux/platform_device.h>
 #include "virt-dma.h"
 
@@ -149,6 +152,14 @@ struct fsl_edma_sw_tcd {
 	void				*vtcd;
 };
 
+/* log2(ns) buckets, the last one collects everything above ~2s */
+#define FSL_EDMA_LAT_BUCKETS		32
+
+struct fsl_edma_lat_hist {
+	u64				queue_wait[FSL_EDMA_LAT_BUCKETS];
+	u64				hw_time[FSL_EDMA_LAT_BUCKETS];
+};
+
 struct fsl_edma_chan {
 	struct virt_dma_chan		vchan;
 	enum dma_status			status;
@@ -182,6 +193,17 @@ struct fsl_edma_chan {
 	bool				is_remote;
 	bool				is_multi_fifo;
 	u32				chn_real_count;
+	struct fsl_edma_lat_hist	lat_hist;
+	bool				poll_irq_pending;
+	/* completion coalescing, see fsl_edma_coal_complete() */
+	struct dim			dim;
+	struct hrtimer			coal_timer;
+	u16				coal_usec;
+	u16				coal_comps;
+	u16				coal_pending;
+	u16				dim_events;
+	u32				dim_comps;
+	u32				dim_bytes;
 };
 
 struct fsl_edma_desc {
@@ -190,6 +212,8 @@ struct fsl_edma_desc {
 	bool				iscyclic;
 	enum dma_transfer_direction	dirn;
 	unsigned int			n_tcds;
+	ktime_t				issued;
+	ktime_t				started;
 	struct fsl_edma_sw_tcd		tcd[];
 };
 
@@ -271,6 +295,7 @@ struct fsl_edma_engine {
 	#define MAX_CHAN_NUM    64
 	bool			big_endian;
 	bool			dma_coherent;
+	bool			adaptive_coalescing;
 	struct edma_regs	regs;
 	struct fsl_edma3_reg_save edma_save_regs[MAX_CHAN_NUM];
 	u64			chan_masked;
@@ -520,5 +545,6 @@ void fsl_edma_free_chan_resources(struct dma_chan *chan);
 void fsl_edma_cleanup_vchan(struct dma_device *dmadev);
 void fsl_edma_setup_regs(struct fsl_edma_engine *edma);
 void fsl_edma_set_tcd_regs(struct fsl_edma_chan *fsl_chan, void *tcd);
+void fsl_edma_debugfs_init(struct fsl_edma_engine *edma);
 
 #endif /* _FSL_EDMA_COMMON_H_ */
@@ -851,6 +851,8 @@ static int fsl_edma_probe(struct platform_device *pdev)
 		return ret;
 	}
 
+	fsl_edma_debugfs_init(fsl_edma);
+
 	/* enable round robin arbitration */
 	if (!(drvdata->flags & FSL_EDMA_DRV_SPLIT_REG))
 		edma_writel(fsl_edma, EDMA_CR_ERGA | EDMA_CR_ERCA, regs->cr);
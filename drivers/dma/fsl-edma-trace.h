@@ -119,6 +119,33 @@ DEFINE_EVENT(edma_log_tcd, edma_fill_tcd,
 	TP_ARGS(chan, tcd)
 );
 
+DECLARE_EVENT_CLASS(edma_log_latency,
+	TP_PROTO(struct fsl_edma_chan *chan, dma_cookie_t cookie, u64 ns),
+	TP_ARGS(chan, cookie, ns),
+	TP_STRUCT__entry(
+		__string(chan, chan->chan_name)
+		__field(dma_cookie_t, cookie)
+		__field(u64, ns)
+	),
+	TP_fast_assign(
+		__assign_str(chan);
+		__entry->cookie = cookie;
+		__entry->ns = ns;
+	),
+	TP_printk("%s cookie %d: %llu ns",
+		__get_str(chan), __entry->cookie, __entry->ns)
+);
+
+DEFINE_EVENT(edma_log_latency, edma_queue_wait,
+	TP_PROTO(struct fsl_edma_chan *chan, dma_cookie_t cookie, u64 ns),
+	TP_ARGS(chan, cookie, ns)
+);
+
+DEFINE_EVENT(edma_log_latency, edma_hw_time,
+	TP_PROTO(struct fsl_edma_chan *chan, dma_cookie_t cookie, u64 ns),
+	TP_ARGS(chan, cookie, ns)
+);
+
 #endif
 
 /* this part must be outside header guard */
@@ -99,6 +99,8 @@
 #define FSL_QDMA_CIRCULAR_DESC_SIZE_MIN	64
 #define FSL_QDMA_CIRCULAR_DESC_SIZE_MAX	16384
 #define FSL_QDMA_QUEUE_NUM_MAX		8
+#define FSL_QDMA_STRIPE_MAX		8
+#define FSL_QDMA_STRIPE_ALIGN		64
 
 /* Field definition for CMD */
 #define FSL_QDMA_CMD_RWTTYPE		0x4
@@ -136,6 +138,11 @@
 #define FSL_QDMA_BLOCK_BASE_OFFSET(fsl_qdma_engine, x)			\
 	(((fsl_qdma_engine)->block_offset) * (x))
 
+static unsigned int stripe_size;
+module_param(stripe_size, uint, 0644);
+MODULE_PARM_DESC(stripe_size,
+		 "Split memcpy of at least twice this size across all command queues (0 = off)");
+
 /**
  * struct fsl_qdma_format - This is the struct holding describing compound
  *			    descriptor format with qDMA.
@@ -183,6 +190,7 @@ struct fsl_qdma_chan {
 	enum dma_status			status;
 	struct fsl_qdma_engine		*qdma;
 	struct fsl_qdma_queue		*queue;
+	bool				stripe;
 };
 
 struct fsl_qdma_queue {
@@ -198,6 +206,7 @@ struct fsl_qdma_queue {
 	u32			id;
 	struct fsl_qdma_format	*cq;
 	void __iomem		*block_base;
+	unsigned int		users;
 };
 
 struct fsl_qdma_comp {
@@ -206,8 +215,14 @@ struct fsl_qdma_comp {
 	struct fsl_qdma_format	*virt_addr;
 	struct fsl_qdma_format	*desc_virt_addr;
 	struct fsl_qdma_chan	*qchan;
+	struct fsl_qdma_queue	*queue;
 	struct virt_dma_desc    vdesc;
 	struct list_head	list;
+	/* striped memcpy: parts hold @parent, the parent counts @pending */
+	struct fsl_qdma_comp	*parent;
+	atomic_t		pending;
+	unsigned int		nr_parts;
+	struct fsl_qdma_comp	*parts[FSL_QDMA_STRIPE_MAX - 1];
 };
 
 struct fsl_qdma_engine {
@@ -306,22 +321,19 @@ static struct fsl_qdma_comp *to_fsl_qdma_comp(struct virt_dma_desc *vd)
 	return container_of(vd, struct fsl_qdma_comp, vdesc);
 }
 
-static void fsl_qdma_free_chan_resources(struct dma_chan *chan)
+/*
+ * Drop a reference on the command buffers of a queue. The pools are shared
+ * by all channels mapped onto the queue and by striping channels, so they
+ * only go away with the last user.
+ */
+static void fsl_qdma_queue_put(struct fsl_qdma_engine *fsl_qdma,
+			       struct fsl_qdma_queue *fsl_queue)
 {
-	struct fsl_qdma_chan *fsl_chan = to_fsl_qdma_chan(chan);
-	struct fsl_qdma_queue *fsl_queue = fsl_chan->queue;
-	struct fsl_qdma_engine *fsl_qdma = fsl_chan->qdma;
 	struct fsl_qdma_comp *comp_temp, *_comp_temp;
-	unsigned long flags;
-	LIST_HEAD(head);
 
-	spin_lock_irqsave(&fsl_chan->vchan.lock, flags);
-	vchan_get_all_descriptors(&fsl_chan->vchan, &head);
-	spin_unlock_irqrestore(&fsl_chan->vchan.lock, flags);
+	lockdep_assert_held(&fsl_qdma->fsl_qdma_mutex);
 
-	vchan_dma_desc_free_list(&fsl_chan->vchan, &head);
-
-	if (!fsl_queue->comp_pool && !fsl_queue->desc_pool)
+	if (!fsl_queue->users || --fsl_queue->users)
 		return;
 
 	list_for_each_entry_safe(comp_temp, _comp_temp,
@@ -351,11 +363,36 @@ static void fsl_qdma_free_chan_resources(struct dma_chan *chan)
 	dma_pool_destroy(fsl_queue->comp_pool);
 	dma_pool_destroy(fsl_queue->desc_pool);
 
-	fsl_qdma->desc_allocated--;
 	fsl_queue->comp_pool = NULL;
 	fsl_queue->desc_pool = NULL;
 }
 
+static void fsl_qdma_free_chan_resources(struct dma_chan *chan)
+{
+	struct fsl_qdma_chan *fsl_chan = to_fsl_qdma_chan(chan);
+	struct fsl_qdma_engine *fsl_qdma = fsl_chan->qdma;
+	unsigned long flags;
+	LIST_HEAD(head);
+	int i;
+
+	spin_lock_irqsave(&fsl_chan->vchan.lock, flags);
+	vchan_get_all_descriptors(&fsl_chan->vchan, &head);
+	spin_unlock_irqrestore(&fsl_chan->vchan.lock, flags);
+
+	vchan_dma_desc_free_list(&fsl_chan->vchan, &head);
+
+	mutex_lock(&fsl_qdma->fsl_qdma_mutex);
+	if (fsl_chan->stripe) {
+		for (i = 0; i < fsl_qdma->n_queues * fsl_qdma->block_number; i++)
+			fsl_qdma_queue_put(fsl_qdma, fsl_qdma->queue + i);
+		fsl_chan->stripe = false;
+	} else {
+		fsl_qdma_queue_put(fsl_qdma, fsl_chan->queue);
+	}
+	fsl_qdma->desc_allocated--;
+	mutex_unlock(&fsl_qdma->fsl_qdma_mutex);
+}
+
 static void fsl_qdma_comp_fill_memcpy(struct fsl_qdma_comp *fsl_comp,
 				      dma_addr_t dst, dma_addr_t src, u32 len)
 {
@@ -418,6 +455,8 @@ static int fsl_qdma_pre_request_enqueue_desc(struct fsl_qdma_queue *queue)
 		if (!comp_temp->desc_virt_addr)
 			goto err_desc_dma_alloc;
 
+		comp_temp->queue = queue;
+
 		list_add_tail(&comp_temp->list, &queue->comp_free);
 	}
 
@@ -449,36 +488,79 @@ static int fsl_qdma_pre_request_enqueue_desc(struct fsl_qdma_queue *queue)
 	return -ENOMEM;
 }
 
+/*
+ * Take a free command descriptor off a queue without waiting.
+ */
+static struct fsl_qdma_comp *fsl_qdma_get_comp(struct fsl_qdma_queue *queue)
+{
+	unsigned long flags;
+	struct fsl_qdma_comp *comp_temp = NULL;
+
+	spin_lock_irqsave(&queue->queue_lock, flags);
+	if (!list_empty(&queue->comp_free)) {
+		comp_temp = list_first_entry(&queue->comp_free,
+					     struct fsl_qdma_comp, list);
+		list_del(&comp_temp->list);
+	}
+	spin_unlock_irqrestore(&queue->queue_lock, flags);
+
+	return comp_temp;
+}
+
+static void fsl_qdma_put_comp(struct fsl_qdma_comp *fsl_comp)
+{
+	unsigned long flags;
+	struct fsl_qdma_queue *queue = fsl_comp->queue;
+
+	spin_lock_irqsave(&queue->queue_lock, flags);
+	list_add_tail(&fsl_comp->list, &queue->comp_free);
+	spin_unlock_irqrestore(&queue->queue_lock, flags);
+}
+
 /*
  * Request a command descriptor for enqueue.
  */
 static struct fsl_qdma_comp
 *fsl_qdma_request_enqueue_desc(struct fsl_qdma_chan *fsl_chan)
 {
-	unsigned long flags;
 	struct fsl_qdma_comp *comp_temp;
 	int timeout = FSL_QDMA_COMP_TIMEOUT;
-	struct fsl_qdma_queue *queue = fsl_chan->queue;
 
 	while (timeout--) {
-		spin_lock_irqsave(&queue->queue_lock, flags);
-		if (!list_empty(&queue->comp_free)) {
-			comp_temp = list_first_entry(&queue->comp_free,
-						     struct fsl_qdma_comp,
-						     list);
-			list_del(&comp_temp->list);
-
-			spin_unlock_irqrestore(&queue->queue_lock, flags);
+		comp_temp = fsl_qdma_get_comp(fsl_chan->queue);
+		if (comp_temp) {
 			comp_temp->qchan = fsl_chan;
 			return comp_temp;
 		}
-		spin_unlock_irqrestore(&queue->queue_lock, flags);
 		udelay(1);
 	}
 
 	return NULL;
 }
 
+/*
+ * A striped memcpy completes once its own command and all of its parts are
+ * done. Parts go straight back to the queue they were borrowed from.
+ */
+static void fsl_qdma_comp_done(struct fsl_qdma_comp *fsl_comp)
+{
+	struct fsl_qdma_comp *root = fsl_comp->parent ?: fsl_comp;
+	struct fsl_qdma_chan *fsl_chan = root->qchan;
+	unsigned long flags;
+
+	spin_lock_irqsave(&fsl_chan->vchan.lock, flags);
+	if (fsl_comp->vdesc.tx_result.result != DMA_TRANS_NOERROR)
+		root->vdesc.tx_result.result = fsl_comp->vdesc.tx_result.result;
+	if (atomic_dec_and_test(&root->pending)) {
+		vchan_cookie_complete(&root->vdesc);
+		fsl_chan->status = DMA_COMPLETE;
+	}
+	spin_unlock_irqrestore(&fsl_chan->vchan.lock, flags);
+
+	if (fsl_comp != root)
+		fsl_qdma_put_comp(fsl_comp);
+}
+
 static struct fsl_qdma_queue
 *fsl_qdma_alloc_queue_resources(struct platform_device *pdev,
 				struct fsl_qdma_engine *fsl_qdma)
@@ -726,10 +808,7 @@ fsl_qdma_queue_transfer_complete(struct fsl_qdma_engine *fsl_qdma,
 			}
 		}
 
-		spin_lock(&fsl_comp->qchan->vchan.lock);
-		vchan_cookie_complete(&fsl_comp->vdesc);
-		fsl_comp->qchan->status = DMA_COMPLETE;
-		spin_unlock(&fsl_comp->qchan->vchan.lock);
+		fsl_qdma_comp_done(fsl_comp);
 	}
 
 	return 0;
@@ -968,6 +1047,60 @@ static int fsl_qdma_reg_init(struct fsl_qdma_engine *fsl_qdma)
 	return 0;
 }
 
+/*
+ * Split a memcpy into up to FSL_QDMA_STRIPE_MAX pieces, borrowing one command
+ * descriptor from each of the following queues (wrapping across blocks) for
+ * every piece after the first. Queues without a free descriptor are skipped.
+ * Returns the length left for the parent's own command.
+ */
+static size_t fsl_qdma_prep_stripe(struct fsl_qdma_chan *fsl_chan,
+				   struct fsl_qdma_comp *root,
+				   dma_addr_t dst, dma_addr_t src, size_t len)
+{
+	struct fsl_qdma_engine *fsl_qdma = fsl_chan->qdma;
+	int nr_queues = fsl_qdma->n_queues * fsl_qdma->block_number;
+	int first = fsl_chan->queue - fsl_qdma->queue;
+	struct fsl_qdma_comp *part;
+	size_t chunk, off;
+	unsigned int i, nr;
+
+	root->parent = NULL;
+	root->nr_parts = 0;
+
+	if (!fsl_chan->stripe || !stripe_size || len < 2 * (size_t)stripe_size)
+		return len;
+
+	nr = min_t(size_t, len / stripe_size,
+		   min(nr_queues, FSL_QDMA_STRIPE_MAX));
+	for (i = 1; i < nr_queues && root->nr_parts < nr - 1; i++) {
+		part = fsl_qdma_get_comp(fsl_qdma->queue +
+					 (first + i) % nr_queues);
+		if (part)
+			root->parts[root->nr_parts++] = part;
+	}
+	if (!root->nr_parts)
+		return len;
+
+	chunk = ALIGN(DIV_ROUND_UP(len, root->nr_parts + 1),
+		      FSL_QDMA_STRIPE_ALIGN);
+	/* Rounding the pieces up may leave the last parts with nothing. */
+	while (root->nr_parts && root->nr_parts * chunk >= len)
+		fsl_qdma_put_comp(root->parts[--root->nr_parts]);
+	if (!root->nr_parts)
+		return len;
+
+	for (i = 0, off = chunk; i < root->nr_parts; i++, off += chunk) {
+		part = root->parts[i];
+		part->qchan = fsl_chan;
+		part->parent = root;
+		part->vdesc.tx_result.result = DMA_TRANS_NOERROR;
+		fsl_qdma_comp_fill_memcpy(part, dst + off, src + off,
+					  min(chunk, len - off));
+	}
+
+	return chunk;
+}
+
 static struct dma_async_tx_descriptor *
 fsl_qdma_prep_memcpy(struct dma_chan *chan, dma_addr_t dst,
 		     dma_addr_t src, size_t len, unsigned long flags)
@@ -980,27 +1113,27 @@ fsl_qdma_prep_memcpy(struct dma_chan *chan, dma_addr_t dst,
 	if (!fsl_comp)
 		return NULL;
 
-	fsl_qdma_comp_fill_memcpy(fsl_comp, dst, src, len);
+	fsl_qdma_comp_fill_memcpy(fsl_comp, dst, src,
+				  fsl_qdma_prep_stripe(fsl_chan, fsl_comp,
+						       dst, src, len));
+	atomic_set(&fsl_comp->pending, fsl_comp->nr_parts + 1);
 
 	return vchan_tx_prep(&fsl_chan->vchan, &fsl_comp->vdesc, flags);
 }
 
-static void fsl_qdma_enqueue_desc(struct fsl_qdma_chan *fsl_chan)
+/*
+ * Write one command into a queue's ring. Called with the queue lock held.
+ */
+static bool fsl_qdma_enqueue_comp(struct fsl_qdma_engine *fsl_qdma,
+				  struct fsl_qdma_queue *fsl_queue,
+				  struct fsl_qdma_comp *fsl_comp)
 {
 	u32 reg;
-	struct virt_dma_desc *vdesc;
-	struct fsl_qdma_comp *fsl_comp;
-	struct fsl_qdma_queue *fsl_queue = fsl_chan->queue;
 	void __iomem *block = fsl_queue->block_base;
 
-	reg = qdma_readl(fsl_chan->qdma, block + FSL_QDMA_BCQSR(fsl_queue->id));
+	reg = qdma_readl(fsl_qdma, block + FSL_QDMA_BCQSR(fsl_queue->id));
 	if (reg & (FSL_QDMA_BCQSR_QF | FSL_QDMA_BCQSR_XOFF))
-		return;
-	vdesc = vchan_next_desc(&fsl_chan->vchan);
-	if (!vdesc)
-		return;
-	list_del(&vdesc->node);
-	fsl_comp = to_fsl_qdma_comp(vdesc);
+		return false;
 
 	memcpy(fsl_queue->virt_head++,
 	       fsl_comp->virt_addr, sizeof(struct fsl_qdma_format));
@@ -1009,38 +1142,98 @@ static void fsl_qdma_enqueue_desc(struct fsl_qdma_chan *fsl_chan)
 
 	list_add_tail(&fsl_comp->list, &fsl_queue->comp_used);
 	barrier();
-	reg = qdma_readl(fsl_chan->qdma, block + FSL_QDMA_BCQMR(fsl_queue->id));
+	reg = qdma_readl(fsl_qdma, block + FSL_QDMA_BCQMR(fsl_queue->id));
 	reg |= FSL_QDMA_BCQMR_EI;
-	qdma_writel(fsl_chan->qdma, reg, block + FSL_QDMA_BCQMR(fsl_queue->id));
-	fsl_chan->status = DMA_IN_PROGRESS;
+	qdma_writel(fsl_qdma, reg, block + FSL_QDMA_BCQMR(fsl_queue->id));
+
+	return true;
 }
 
-static void fsl_qdma_free_desc(struct virt_dma_desc *vdesc)
+static struct fsl_qdma_comp
+*fsl_qdma_enqueue_desc(struct fsl_qdma_chan *fsl_chan)
 {
-	unsigned long flags;
+	struct virt_dma_desc *vdesc;
 	struct fsl_qdma_comp *fsl_comp;
-	struct fsl_qdma_queue *fsl_queue;
 
+	vdesc = vchan_next_desc(&fsl_chan->vchan);
+	if (!vdesc)
+		return NULL;
 	fsl_comp = to_fsl_qdma_comp(vdesc);
-	fsl_queue = fsl_comp->qchan->queue;
+	if (!fsl_qdma_enqueue_comp(fsl_chan->qdma, fsl_chan->queue, fsl_comp))
+		return NULL;
+	list_del(&vdesc->node);
+	fsl_chan->status = DMA_IN_PROGRESS;
 
-	spin_lock_irqsave(&fsl_queue->queue_lock, flags);
-	list_add_tail(&fsl_comp->list, &fsl_queue->comp_free);
-	spin_unlock_irqrestore(&fsl_queue->queue_lock, flags);
+	return fsl_comp;
+}
+
+/*
+ * Push the parts of a striped memcpy onto their own queues. A part whose
+ * queue stays full is failed so that the parent still completes.
+ */
+static void fsl_qdma_enqueue_part(struct fsl_qdma_engine *fsl_qdma,
+				  struct fsl_qdma_comp *part)
+{
+	unsigned long flags;
+	bool queued;
+	int timeout = FSL_QDMA_COMP_TIMEOUT;
+	struct fsl_qdma_queue *fsl_queue = part->queue;
+
+	while (timeout--) {
+		spin_lock_irqsave(&fsl_queue->queue_lock, flags);
+		queued = fsl_qdma_enqueue_comp(fsl_qdma, fsl_queue, part);
+		spin_unlock_irqrestore(&fsl_queue->queue_lock, flags);
+		if (queued)
+			return;
+		udelay(1);
+	}
+
+	part->vdesc.tx_result.result = DMA_TRANS_ABORTED;
+	fsl_qdma_comp_done(part);
+}
+
+static void fsl_qdma_free_desc(struct virt_dma_desc *vdesc)
+{
+	unsigned int i;
+	struct fsl_qdma_comp *fsl_comp = to_fsl_qdma_comp(vdesc);
+
+	/* Never issued: hand the borrowed parts back as well. */
+	if (atomic_read(&fsl_comp->pending))
+		for (i = 0; i < fsl_comp->nr_parts; i++)
+			fsl_qdma_put_comp(fsl_comp->parts[i]);
+
+	fsl_qdma_put_comp(fsl_comp);
 }
 
 static void fsl_qdma_issue_pending(struct dma_chan *chan)
 {
 	unsigned long flags;
+	unsigned int i, nr_parts = 0;
+	struct fsl_qdma_comp *fsl_comp, *parts[FSL_QDMA_STRIPE_MAX - 1];
 	struct fsl_qdma_chan *fsl_chan = to_fsl_qdma_chan(chan);
 	struct fsl_qdma_queue *fsl_queue = fsl_chan->queue;
 
 	spin_lock_irqsave(&fsl_queue->queue_lock, flags);
 	spin_lock(&fsl_chan->vchan.lock);
-	if (vchan_issue_pending(&fsl_chan->vchan))
-		fsl_qdma_enqueue_desc(fsl_chan);
+	if (vchan_issue_pending(&fsl_chan->vchan)) {
+		fsl_comp = fsl_qdma_enqueue_desc(fsl_chan);
+		if (fsl_comp) {
+			nr_parts = fsl_comp->nr_parts;
+			memcpy(parts, fsl_comp->parts,
+			       nr_parts * sizeof(*parts));
+		}
+	}
 	spin_unlock(&fsl_chan->vchan.lock);
 	spin_unlock_irqrestore(&fsl_queue->queue_lock, flags);
+
+	/*
+	 * The parent may complete and be recycled as soon as the last part
+	 * is queued, so only the copied part pointers are used from here on.
+	 * Other queue locks are taken one at a time to avoid lock ordering
+	 * issues between striping channels.
+	 */
+	for (i = 0; i < nr_parts; i++)
+		fsl_qdma_enqueue_part(fsl_chan->qdma, parts[i]);
 }
 
 static void fsl_qdma_synchronize(struct dma_chan *chan)
@@ -1063,15 +1256,20 @@ static int fsl_qdma_terminate_all(struct dma_chan *chan)
 	return 0;
 }
 
-static int fsl_qdma_alloc_chan_resources(struct dma_chan *chan)
+/*
+ * Take a reference on the command buffers of a queue, allocating them for
+ * the first user.
+ */
+static int fsl_qdma_queue_get(struct fsl_qdma_engine *fsl_qdma,
+			      struct fsl_qdma_queue *fsl_queue)
 {
 	int ret;
-	struct fsl_qdma_chan *fsl_chan = to_fsl_qdma_chan(chan);
-	struct fsl_qdma_engine *fsl_qdma = fsl_chan->qdma;
-	struct fsl_qdma_queue *fsl_queue = fsl_chan->queue;
+	struct device *dev = fsl_qdma->dma_dev.dev;
+
+	lockdep_assert_held(&fsl_qdma->fsl_qdma_mutex);
 
-	if (fsl_queue->comp_pool && fsl_queue->desc_pool)
-		return fsl_qdma->desc_allocated;
+	if (fsl_queue->users++)
+		return 0;
 
 	INIT_LIST_HEAD(&fsl_queue->comp_free);
 
@@ -1080,18 +1278,18 @@ static int fsl_qdma_alloc_chan_resources(struct dma_chan *chan)
 	 */
 	fsl_queue->comp_pool =
 	dma_pool_create("comp_pool",
-			chan->device->dev,
+			dev,
 			FSL_QDMA_COMMAND_BUFFER_SIZE,
 			64, 0);
 	if (!fsl_queue->comp_pool)
-		return -ENOMEM;
+		goto err_comp_pool;
 
 	/*
 	 * The dma pool for Descriptor(SD/DD) buffer
 	 */
 	fsl_queue->desc_pool =
 	dma_pool_create("desc_pool",
-			chan->device->dev,
+			dev,
 			FSL_QDMA_DESCRIPTOR_BUFFER_SIZE,
 			32, 0);
 	if (!fsl_queue->desc_pool)
@@ -1099,21 +1297,60 @@ static int fsl_qdma_alloc_chan_resources(struct dma_chan *chan)
 
 	ret = fsl_qdma_pre_request_enqueue_desc(fsl_queue);
 	if (ret) {
-		dev_err(chan->device->dev,
+		dev_err(dev,
 			"failed to alloc dma buffer for S/G descriptor\n");
 		goto err_mem;
 	}
 
-	fsl_qdma->desc_allocated++;
-	return fsl_qdma->desc_allocated;
+	return 0;
 
 err_mem:
 	dma_pool_destroy(fsl_queue->desc_pool);
+	fsl_queue->desc_pool = NULL;
 err_desc_pool:
 	dma_pool_destroy(fsl_queue->comp_pool);
+	fsl_queue->comp_pool = NULL;
+err_comp_pool:
+	fsl_queue->users--;
 	return -ENOMEM;
 }
 
+static int fsl_qdma_alloc_chan_resources(struct dma_chan *chan)
+{
+	int ret, i;
+	struct fsl_qdma_chan *fsl_chan = to_fsl_qdma_chan(chan);
+	struct fsl_qdma_engine *fsl_qdma = fsl_chan->qdma;
+	int nr_queues = fsl_qdma->n_queues * fsl_qdma->block_number;
+
+	mutex_lock(&fsl_qdma->fsl_qdma_mutex);
+	/*
+	 * A striping channel borrows command descriptors from every queue,
+	 * so it keeps all of them allocated while it is in use.
+	 */
+	fsl_chan->stripe = stripe_size && nr_queues > 1;
+	if (fsl_chan->stripe) {
+		for (i = 0; i < nr_queues; i++) {
+			ret = fsl_qdma_queue_get(fsl_qdma, fsl_qdma->queue + i);
+			if (ret) {
+				while (i--)
+					fsl_qdma_queue_put(fsl_qdma,
+							   fsl_qdma->queue + i);
+				fsl_chan->stripe = false;
+				goto out;
+			}
+		}
+	} else {
+		ret = fsl_qdma_queue_get(fsl_qdma, fsl_chan->queue);
+		if (ret)
+			goto out;
+	}
+
+	ret = ++fsl_qdma->desc_allocated;
+out:
+	mutex_unlock(&fsl_qdma->fsl_qdma_mutex);
+	return ret;
+}
+
 static int fsl_qdma_probe(struct platform_device *pdev)
 {
 	int ret, i;
@@ -12,6 +12,7 @@
 
 #include <linux/init.h>
 #include <linux/iopoll.h>
+#include <linux/log2.h>
 #include <linux/module.h>
 #include <linux/types.h>
 #include <linux/bitfield.h>
@@ -24,12 +25,14 @@
 #include <linux/semaphore.h>
 #include <linux/spinlock.h>
 #include <linux/device.h>
+#include <linux/debugfs.h>
 #include <linux/genalloc.h>
 #include <linux/dma-mapping.h>
 #include <linux/firmware.h>
 #include <linux/slab.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/seq_file.h>
 #include <linux/dmaengine.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
@@ -386,6 +389,8 @@ struct sdma_engine;
  * struct sdma_desc - descriptor structor for one transfer
  * @vd:			descriptor for virt dma
  * @num_bd:		number of descriptors currently handling
+ * @bd_cnt:		number of descriptors allocated at @bd, may be larger
+ *			than @num_bd when carved from the channel BD pool
  * @bd_phys:		physical address of bd
  * @buf_tail:		ID of the buffer that was processed
  * @buf_ptail:		ID of the previous buffer that was processed
@@ -394,10 +399,13 @@ struct sdma_engine;
  * @chn_count:		the transfer count set
  * @sdmac:		sdma_channel pointer
  * @bd:			pointer of allocate bd
+ * @hw_bd:		bd array the hardware works on once started, either @bd
+ *			or a slice of the channel's chain array
  */
 struct sdma_desc {
 	struct virt_dma_desc	vd;
 	unsigned int		num_bd;
+	unsigned int		bd_cnt;
 	dma_addr_t		bd_phys;
 	unsigned int		buf_tail;
 	unsigned int		buf_ptail;
@@ -406,6 +414,39 @@ struct sdma_desc {
 	unsigned int		chn_count;
 	struct sdma_channel	*sdmac;
 	struct sdma_buffer_descriptor *bd;
+	struct sdma_buffer_descriptor *hw_bd;
+};
+
+#define SDMA_BD_POOL_DEPTH	4
+#define SDMA_CHAIN_NUM_BD	256
+
+/**
+ * struct sdma_bd_block - one cached buffer descriptor array
+ * @bd:			virtual address of the array
+ * @bd_phys:		physical address of the array
+ */
+struct sdma_bd_block {
+	struct sdma_buffer_descriptor	*bd;
+	dma_addr_t			bd_phys;
+};
+
+/**
+ * struct sdma_bd_pool - per channel cache of buffer descriptor arrays
+ * @lock:		protects the pool
+ * @blocks:		cached, currently unused arrays
+ * @count:		number of valid entries in @blocks
+ * @bd_cnt:		number of descriptors in each cached array. Grows to
+ *			the largest segment count requested on the channel.
+ * @hits:		allocations served from the pool
+ * @misses:		allocations that had to go to the allocator
+ */
+struct sdma_bd_pool {
+	spinlock_t			lock;
+	struct sdma_bd_block		blocks[SDMA_BD_POOL_DEPTH];
+	unsigned int			count;
+	unsigned int			bd_cnt;
+	unsigned long			hits;
+	unsigned long			misses;
 };
 
 /**
@@ -445,6 +486,11 @@ struct sdma_desc {
  * @stride_fifos_dst:	stride for destination device FIFOs
  * @words_per_fifo:	copy number of words one time for one FIFO
  * @sw_done:		software done flag
+ * @bd_pool:		cache of buffer descriptor arrays for this channel
+ * @chain_bd:		bd array used to link several issued descriptors into
+ *			one hardware chain
+ * @chain_bd_phys:	physical address of @chain_bd
+ * @chain:		descriptors linked in the hardware chain behind @desc
  */
 struct sdma_channel {
 	struct virt_dma_chan		vc;
@@ -478,6 +524,10 @@ struct sdma_channel {
 	unsigned int                    stride_fifos_dst;
 	unsigned int                    words_per_fifo;
 	bool                            sw_done;
+	struct sdma_bd_pool		bd_pool;
+	struct sdma_buffer_descriptor	*chain_bd;
+	dma_addr_t			chain_bd_phys;
+	struct list_head		chain;
 };
 
 #define IMX_DMA_SG_LOOP		BIT(0)
@@ -1000,12 +1050,70 @@ static struct sdma_desc *to_sdma_desc(struct dma_async_tx_descriptor *t)
 	return container_of(t, struct sdma_desc, vd.tx);
 }
 
+static dma_addr_t sdma_chain_bd_phys(struct sdma_channel *sdmac,
+				     struct sdma_desc *desc)
+{
+	return sdmac->chain_bd_phys +
+	       (desc->hw_bd - sdmac->chain_bd) * sizeof(*desc->hw_bd);
+}
+
+/*
+ * Copy the buffer descriptors of @head and of as many following issued
+ * descriptors as fit into the channel chain array, so the script runs
+ * from one transfer into the next without going through the interrupt
+ * handler. Every transfer keeps BD_INTR on its last bd, completions are
+ * picked up in batches by sdma_update_channel_chain().
+ */
+static bool sdma_chain_desc(struct sdma_channel *sdmac, struct sdma_desc *head)
+{
+	struct sdma_buffer_descriptor *last;
+	struct virt_dma_desc *vd;
+	struct sdma_desc *desc;
+	unsigned int used;
+
+	if (!sdmac->chain_bd || (sdmac->flags & IMX_DMA_SG_LOOP))
+		return false;
+
+	vd = vchan_next_desc(&sdmac->vc);
+	if (!vd)
+		return false;
+
+	desc = to_sdma_desc(&vd->tx);
+	if (head->num_bd + desc->num_bd > SDMA_CHAIN_NUM_BD)
+		return false;
+
+	memcpy(sdmac->chain_bd, head->bd, head->num_bd * sizeof(*head->bd));
+	head->hw_bd = sdmac->chain_bd;
+	used = head->num_bd;
+	last = &sdmac->chain_bd[used - 1];
+
+	while ((vd = vchan_next_desc(&sdmac->vc))) {
+		desc = to_sdma_desc(&vd->tx);
+		if (used + desc->num_bd > SDMA_CHAIN_NUM_BD)
+			break;
+
+		last->mode.status &= ~BD_LAST;
+		last->mode.status |= BD_CONT;
+
+		memcpy(&sdmac->chain_bd[used], desc->bd,
+		       desc->num_bd * sizeof(*desc->bd));
+		desc->hw_bd = &sdmac->chain_bd[used];
+		used += desc->num_bd;
+		last = &sdmac->chain_bd[used - 1];
+
+		list_move_tail(&vd->node, &sdmac->chain);
+	}
+
+	return true;
+}
+
 static void sdma_start_desc(struct sdma_channel *sdmac)
 {
 	struct virt_dma_desc *vd = vchan_next_desc(&sdmac->vc);
 	struct sdma_desc *desc;
 	struct sdma_engine *sdma = sdmac->sdma;
 	int channel = sdmac->channel;
+	dma_addr_t bd_phys;
 
 	if (!vd) {
 		sdmac->desc = NULL;
@@ -1015,8 +1123,13 @@ static void sdma_start_desc(struct sdma_channel *sdmac)
 
 	list_del(&vd->node);
 
-	sdma->channel_control[channel].base_bd_ptr = desc->bd_phys;
-	sdma->channel_control[channel].current_bd_ptr = desc->bd_phys;
+	desc->hw_bd = desc->bd;
+	bd_phys = desc->bd_phys;
+	if (sdma_chain_desc(sdmac, desc))
+		bd_phys = sdmac->chain_bd_phys;
+
+	sdma->channel_control[channel].base_bd_ptr = bd_phys;
+	sdma->channel_control[channel].current_bd_ptr = bd_phys;
 	sdma_enable_channel(sdma, sdmac->channel);
 }
 
@@ -1100,7 +1213,7 @@ static void mxc_sdma_handle_channel_normal(struct sdma_channel *data)
 	 * errors and call callback function
 	 */
 	for (i = 0; i < sdmac->desc->num_bd; i++) {
-		bd = &sdmac->desc->bd[i];
+		bd = &sdmac->desc->hw_bd[i];
 
 		if (bd->mode.status & (BD_DONE | BD_RROR))
 			error = -EIO;
@@ -1113,6 +1226,49 @@ static void mxc_sdma_handle_channel_normal(struct sdma_channel *data)
 		sdmac->status = DMA_COMPLETE;
 }
 
+static void sdma_update_channel_chain(struct sdma_channel *sdmac)
+{
+	struct sdma_engine *sdma = sdmac->sdma;
+	int channel = sdmac->channel;
+	bool enabled = is_sdma_channel_enabled(sdma, channel);
+
+	/*
+	 * Complete every transfer the script is done with. Interrupts of
+	 * linked transfers may coalesce or arrive after the transfer was
+	 * already completed here, so look at the bds rather than assuming
+	 * one interrupt per transfer.
+	 */
+	while (sdmac->desc) {
+		struct sdma_desc *desc = sdmac->desc;
+		struct sdma_buffer_descriptor *last = &desc->hw_bd[desc->num_bd - 1];
+
+		if ((last->mode.status & BD_DONE) && enabled)
+			break;
+
+		mxc_sdma_handle_channel_normal(sdmac);
+		vchan_cookie_complete(&desc->vd);
+
+		desc = list_first_entry_or_null(&sdmac->chain,
+						struct sdma_desc, vd.node);
+		sdmac->desc = desc;
+		if (!desc)
+			break;
+
+		list_del(&desc->vd.node);
+
+		/* script stopped on an error, resume with the next transfer */
+		if (!enabled) {
+			sdma->channel_control[channel].current_bd_ptr =
+				sdma_chain_bd_phys(sdmac, desc);
+			sdma_enable_channel(sdma, channel);
+			return;
+		}
+	}
+
+	if (!sdmac->desc)
+		sdma_start_desc(sdmac);
+}
+
 static irqreturn_t sdma_int_handler(int irq, void *dev_id)
 {
 	struct sdma_engine *sdma = dev_id;
@@ -1140,9 +1296,7 @@ static irqreturn_t sdma_int_handler(int irq, void *dev_id)
 				else
 					vchan_cyclic_callback(&desc->vd);
 			} else {
-				mxc_sdma_handle_channel_normal(sdmac);
-				vchan_cookie_complete(&desc->vd);
-				sdma_start_desc(sdmac);
+				sdma_update_channel_chain(sdmac);
 			}
 		}
 
@@ -1429,6 +1583,7 @@ static int sdma_terminate_all(struct dma_chan *chan)
 		 * up before the last descriptor terminated.
 		 */
 		vchan_get_all_descriptors(&sdmac->vc, &sdmac->terminated);
+		list_splice_tail_init(&sdmac->chain, &sdmac->terminated);
 		sdmac->desc = NULL;
 		schedule_work(&sdmac->terminate_worker);
 	}
@@ -1617,34 +1772,123 @@ static int sdma_request_channel0(struct sdma_engine *sdma)
 }
 
 
-static int sdma_alloc_bd(struct sdma_desc *desc)
+static struct sdma_buffer_descriptor *
+__sdma_alloc_bd(struct sdma_engine *sdma, unsigned int bd_cnt,
+		dma_addr_t *bd_phys)
 {
-	u32 bd_size = desc->num_bd * sizeof(struct sdma_buffer_descriptor);
-	struct sdma_engine *sdma = desc->sdmac->sdma;
-	int ret = 0;
+	u32 bd_size = bd_cnt * sizeof(struct sdma_buffer_descriptor);
 
 	if (sdma->iram_pool)
-		desc->bd = gen_pool_dma_alloc(sdma->iram_pool, bd_size, &desc->bd_phys);
+		return gen_pool_dma_alloc(sdma->iram_pool, bd_size, bd_phys);
+
+	return dma_alloc_coherent(sdma->dev, bd_size, bd_phys, GFP_NOWAIT);
+}
+
+static void __sdma_free_bd(struct sdma_engine *sdma, unsigned int bd_cnt,
+			   struct sdma_buffer_descriptor *bd, dma_addr_t bd_phys)
+{
+	u32 bd_size = bd_cnt * sizeof(struct sdma_buffer_descriptor);
+
+	if (sdma->iram_pool)
+		gen_pool_free(sdma->iram_pool, (unsigned long)bd, bd_size);
 	else
-		desc->bd = dma_alloc_coherent(sdma->dev, bd_size, &desc->bd_phys, GFP_NOWAIT);
+		dma_free_coherent(sdma->dev, bd_size, bd, bd_phys);
+}
 
-	if (!desc->bd) {
-		ret = -ENOMEM;
-		goto out;
+/*
+ * Buffer descriptor arrays are carved from a small per channel pool so that
+ * the prep callbacks do not hit the coherent allocator for every transfer.
+ * All arrays in the pool have the same size, which is grown lazily to the
+ * largest number of segments seen on the channel.
+ */
+static int sdma_alloc_bd(struct sdma_desc *desc)
+{
+	struct sdma_channel *sdmac = desc->sdmac;
+	struct sdma_bd_pool *pool = &sdmac->bd_pool;
+	struct sdma_bd_block stale[SDMA_BD_POOL_DEPTH];
+	unsigned int stale_cnt = 0, stale_bd_cnt = 0;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	if (desc->num_bd <= pool->bd_cnt && pool->count) {
+		struct sdma_bd_block *blk = &pool->blocks[--pool->count];
+
+		desc->bd = blk->bd;
+		desc->bd_phys = blk->bd_phys;
+		desc->bd_cnt = pool->bd_cnt;
+		pool->hits++;
+		spin_unlock_irqrestore(&pool->lock, flags);
+
+		memset(desc->bd, 0, desc->num_bd * sizeof(*desc->bd));
+		return 0;
 	}
-out:
-	return ret;
+
+	pool->misses++;
+	if (desc->num_bd > pool->bd_cnt) {
+		/* cached arrays are too small from now on, drop them */
+		stale_bd_cnt = pool->bd_cnt;
+		stale_cnt = pool->count;
+		memcpy(stale, pool->blocks, stale_cnt * sizeof(stale[0]));
+		pool->count = 0;
+		pool->bd_cnt = roundup_pow_of_two(desc->num_bd);
+	}
+	desc->bd_cnt = pool->bd_cnt;
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	for (i = 0; i < stale_cnt; i++)
+		__sdma_free_bd(sdmac->sdma, stale_bd_cnt, stale[i].bd,
+			       stale[i].bd_phys);
+
+	desc->bd = __sdma_alloc_bd(sdmac->sdma, desc->bd_cnt, &desc->bd_phys);
+	if (!desc->bd)
+		return -ENOMEM;
+
+	return 0;
 }
 
 static void sdma_free_bd(struct sdma_desc *desc)
 {
-	u32 bd_size = desc->num_bd * sizeof(struct sdma_buffer_descriptor);
-	struct sdma_engine *sdma = desc->sdmac->sdma;
+	struct sdma_channel *sdmac = desc->sdmac;
+	struct sdma_bd_pool *pool = &sdmac->bd_pool;
+	unsigned long flags;
 
-	if (sdma->iram_pool)
-		gen_pool_free(sdma->iram_pool, (unsigned long)desc->bd, bd_size);
-	else
-		dma_free_coherent(desc->sdmac->sdma->dev, bd_size, desc->bd, desc->bd_phys);
+	if (!desc->bd)
+		return;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	if (desc->bd_cnt == pool->bd_cnt && pool->count < SDMA_BD_POOL_DEPTH) {
+		struct sdma_bd_block *blk = &pool->blocks[pool->count++];
+
+		blk->bd = desc->bd;
+		blk->bd_phys = desc->bd_phys;
+		spin_unlock_irqrestore(&pool->lock, flags);
+		return;
+	}
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	__sdma_free_bd(sdmac->sdma, desc->bd_cnt, desc->bd, desc->bd_phys);
+}
+
+static void sdma_bd_pool_drain(struct sdma_channel *sdmac)
+{
+	struct sdma_bd_pool *pool = &sdmac->bd_pool;
+	struct sdma_bd_block blocks[SDMA_BD_POOL_DEPTH];
+	unsigned int count, bd_cnt;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	count = pool->count;
+	bd_cnt = pool->bd_cnt;
+	memcpy(blocks, pool->blocks, count * sizeof(blocks[0]));
+	pool->count = 0;
+	pool->bd_cnt = 0;
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	for (i = 0; i < count; i++)
+		__sdma_free_bd(sdmac->sdma, bd_cnt, blocks[i].bd,
+			       blocks[i].bd_phys);
 }
 
 static void sdma_desc_free(struct virt_dma_desc *vd)
@@ -1811,9 +2055,30 @@ static int sdma_alloc_chan_resources(struct dma_chan *chan)
 	sdmac->event_id1 = data->dma_request2;
 	sdmac->prio = prio;
 
+	/*
+	 * Linking issued transfers is an optimization only, keep the scarce
+	 * IRAM for the per transfer bds and run without chaining if the
+	 * chain array can't be allocated.
+	 */
+	if (!sdmac->sdma->iram_pool && !sdmac->chain_bd)
+		sdmac->chain_bd = dma_alloc_coherent(sdmac->sdma->dev,
+				SDMA_CHAIN_NUM_BD * sizeof(*sdmac->chain_bd),
+				&sdmac->chain_bd_phys, GFP_KERNEL);
+
 	return 0;
 }
 
+static void sdma_free_chain(struct sdma_channel *sdmac)
+{
+	if (!sdmac->chain_bd)
+		return;
+
+	dma_free_coherent(sdmac->sdma->dev,
+			  SDMA_CHAIN_NUM_BD * sizeof(*sdmac->chain_bd),
+			  sdmac->chain_bd, sdmac->chain_bd_phys);
+	sdmac->chain_bd = NULL;
+}
+
 static void sdma_free_chan_resources(struct dma_chan *chan)
 {
 	struct sdma_channel *sdmac = to_sdma_chan(chan);
@@ -1829,8 +2094,10 @@ static void sdma_free_chan_resources(struct dma_chan *chan)
 	 *    pm_runtime is false.
 	 *
 	 */
-	if (unlikely(!sdmac->sdma->fw_data))
+	if (unlikely(!sdmac->sdma->fw_data)) {
+		sdma_free_chain(sdmac);
 		return;
+	}
 
 	if (sdma_clk_enable(sdmac->sdma))
 		return;
@@ -1850,6 +2117,9 @@ static void sdma_free_chan_resources(struct dma_chan *chan)
 	kfree(sdmac->audio_config);
 	sdmac->audio_config = NULL;
 	sdma_clk_disable(sdmac->sdma);
+
+	sdma_free_chain(sdmac);
+	sdma_bd_pool_drain(sdmac);
 }
 
 static struct sdma_desc *sdma_transfer_init(struct sdma_channel *sdmac,
@@ -2229,6 +2499,27 @@ static int sdma_config(struct dma_chan *chan,
 	return 0;
 }
 
+/*
+ * DMA_PREP_POLL: look at the bds of the current transfer from tx_status and
+ * complete it inline when the script is done with it. A late interrupt finds
+ * nothing to do in sdma_update_channel_chain().
+ */
+static void sdma_poll_desc(struct sdma_channel *sdmac)
+{
+	unsigned long flags;
+
+	if (sdma_clk_enable(sdmac->sdma))
+		return;
+
+	spin_lock_irqsave(&sdmac->vc.lock, flags);
+	if (sdmac->desc && vchan_desc_polled(&sdmac->desc->vd) &&
+	    !(sdmac->flags & IMX_DMA_SG_LOOP))
+		sdma_update_channel_chain(sdmac);
+	spin_unlock_irqrestore(&sdmac->vc.lock, flags);
+
+	sdma_clk_disable(sdmac->sdma);
+}
+
 static enum dma_status sdma_tx_status(struct dma_chan *chan,
 				      dma_cookie_t cookie,
 				      struct dma_tx_state *txstate)
@@ -2241,16 +2532,28 @@ static enum dma_status sdma_tx_status(struct dma_chan *chan,
 	unsigned long flags;
 
 	ret = dma_cookie_status(chan, cookie, txstate);
+	if (ret != DMA_COMPLETE && READ_ONCE(sdmac->desc)) {
+		sdma_poll_desc(sdmac);
+		ret = dma_cookie_status(chan, cookie, txstate);
+	}
 	if (ret == DMA_COMPLETE || !txstate)
 		return ret;
 
 	spin_lock_irqsave(&sdmac->vc.lock, flags);
 
 	vd = vchan_find_desc(&sdmac->vc, cookie);
-	if (vd)
+	if (vd) {
 		desc = to_sdma_desc(&vd->tx);
-	else if (sdmac->desc && sdmac->desc->vd.tx.cookie == cookie)
+	} else if (sdmac->desc && sdmac->desc->vd.tx.cookie == cookie) {
 		desc = sdmac->desc;
+	} else {
+		list_for_each_entry(vd, &sdmac->chain, node) {
+			if (vd->tx.cookie == cookie) {
+				desc = to_sdma_desc(&vd->tx);
+				break;
+			}
+		}
+	}
 
 	if (desc) {
 		if (sdmac->flags & IMX_DMA_SG_LOOP)
@@ -2500,6 +2803,36 @@ static struct dma_chan *sdma_xlate(struct of_phandle_args *dma_spec,
 				     ofdma->of_node);
 }
 
+static int sdma_bd_pool_show(struct seq_file *s, void *data)
+{
+	struct sdma_engine *sdma = s->private;
+	int i;
+
+	seq_puts(s, "chan  bd_cnt  cached  hits        misses\n");
+	for (i = 1; i < MAX_DMA_CHANNELS; i++) {
+		struct sdma_bd_pool *pool = &sdma->channel[i].bd_pool;
+		unsigned long flags;
+		unsigned long hits, misses;
+		unsigned int bd_cnt, count;
+
+		spin_lock_irqsave(&pool->lock, flags);
+		bd_cnt = pool->bd_cnt;
+		count = pool->count;
+		hits = pool->hits;
+		misses = pool->misses;
+		spin_unlock_irqrestore(&pool->lock, flags);
+
+		if (!hits && !misses)
+			continue;
+
+		seq_printf(s, "%-4d  %-6u  %-6u  %-10lu  %lu\n",
+			   i, bd_cnt, count, hits, misses);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(sdma_bd_pool);
+
 static int sdma_probe(struct platform_device *pdev)
 {
 	struct device_node *np = pdev->dev.of_node;
@@ -2583,6 +2916,8 @@ static int sdma_probe(struct platform_device *pdev)
 		sdmac->channel = i;
 		sdmac->vc.desc_free = sdma_desc_free;
 		INIT_LIST_HEAD(&sdmac->terminated);
+		INIT_LIST_HEAD(&sdmac->chain);
+		spin_lock_init(&sdmac->bd_pool.lock);
 		INIT_WORK(&sdmac->terminate_worker,
 				sdma_channel_terminate_work);
 		/*
@@ -2638,6 +2973,10 @@ static int sdma_probe(struct platform_device *pdev)
 		goto err_init;
 	}
 
+	debugfs_create_file("bd_pool", 0444,
+			    dmaengine_get_debugfs_root(&sdma->dma_device),
+			    sdma, &sdma_bd_pool_fops);
+
 	if (np) {
 		ret = of_dma_controller_register(np, sdma_xlate, sdma);
 		if (ret) {
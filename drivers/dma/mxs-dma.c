@@ -108,6 +108,12 @@ struct mxs_dma_ccw {
 
 #define CCW_BLOCK_SIZE	(4 * PAGE_SIZE)
 #define NUM_CCW	(int)(CCW_BLOCK_SIZE / sizeof(struct mxs_dma_ccw))
+/*
+ * A channel starts with one CCW block and grows its chain on demand, one
+ * pool block at a time, so a whole multi-page NAND operation fits.
+ */
+#define MXS_DMA_CCW_BLOCKS	16
+#define MAX_CCW			(NUM_CCW * MXS_DMA_CCW_BLOCKS)
 
 struct mxs_dma_chan {
 	struct mxs_dma_engine		*mxs_dma;
@@ -115,8 +121,9 @@ struct mxs_dma_chan {
 	struct dma_async_tx_descriptor	desc;
 	struct tasklet_struct		tasklet;
 	unsigned int			chan_irq;
-	struct mxs_dma_ccw		*ccw;
-	dma_addr_t			ccw_phys;
+	struct mxs_dma_ccw		*ccw[MXS_DMA_CCW_BLOCKS];
+	dma_addr_t			ccw_phys[MXS_DMA_CCW_BLOCKS];
+	int				nr_ccw_blocks;
 	int				desc_count;
 	enum dma_status			status;
 	unsigned int			flags;
@@ -241,7 +248,7 @@ static void mxs_dma_enable_chan(struct dma_chan *chan)
 	int chan_id = mxs_chan->chan.chan_id;
 
 	/* set cmd_addr up */
-	writel(mxs_chan->ccw_phys,
+	writel(mxs_chan->ccw_phys[0],
 		mxs_dma->base + HW_APBHX_CHn_NXTCMDAR(mxs_dma, chan_id));
 
 	/* write 1 to SEMA to kick off the channel */
@@ -397,6 +404,50 @@ static irqreturn_t mxs_dma_int_handler(int irq, void *dev_id)
 	return IRQ_HANDLED;
 }
 
+static struct mxs_dma_ccw *mxs_dma_ccw(struct mxs_dma_chan *mxs_chan, int idx)
+{
+	return &mxs_chan->ccw[idx / NUM_CCW][idx % NUM_CCW];
+}
+
+static u32 mxs_dma_ccw_phys(struct mxs_dma_chan *mxs_chan, int idx)
+{
+	/* the last CCW of a chain points past the end, possibly of a block */
+	if (idx / NUM_CCW >= mxs_chan->nr_ccw_blocks)
+		return 0;
+
+	return mxs_chan->ccw_phys[idx / NUM_CCW] +
+	       sizeof(struct mxs_dma_ccw) * (idx % NUM_CCW);
+}
+
+/* Make sure the chain has room for @count CCWs. */
+static int mxs_dma_grow_ccw(struct mxs_dma_chan *mxs_chan, int count)
+{
+	int blk;
+
+	while (mxs_chan->nr_ccw_blocks * NUM_CCW < count) {
+		blk = mxs_chan->nr_ccw_blocks;
+		mxs_chan->ccw[blk] = dma_pool_zalloc(mxs_chan->ccw_pool,
+						     GFP_ATOMIC,
+						     &mxs_chan->ccw_phys[blk]);
+		if (!mxs_chan->ccw[blk])
+			return -ENOMEM;
+		mxs_chan->nr_ccw_blocks++;
+	}
+
+	return 0;
+}
+
+static void mxs_dma_free_ccw(struct mxs_dma_chan *mxs_chan)
+{
+	while (mxs_chan->nr_ccw_blocks) {
+		int blk = --mxs_chan->nr_ccw_blocks;
+
+		dma_pool_free(mxs_chan->ccw_pool, mxs_chan->ccw[blk],
+			      mxs_chan->ccw_phys[blk]);
+		mxs_chan->ccw[blk] = NULL;
+	}
+}
+
 static int mxs_dma_alloc_chan_resources(struct dma_chan *chan)
 {
 	struct mxs_dma_chan *mxs_chan = to_mxs_dma_chan(chan);
@@ -404,14 +455,9 @@ static int mxs_dma_alloc_chan_resources(struct dma_chan *chan)
 	struct device *dev = &mxs_dma->pdev->dev;
 	int ret;
 
-	mxs_chan->ccw = dma_pool_zalloc(mxs_chan->ccw_pool,
-				        GFP_ATOMIC,
-				        &mxs_chan->ccw_phys);
-
-	if (!mxs_chan->ccw) {
-		ret = -ENOMEM;
+	ret = mxs_dma_grow_ccw(mxs_chan, 1);
+	if (ret)
 		goto err_alloc;
-	}
 
 	ret = request_irq(mxs_chan->chan_irq, mxs_dma_int_handler,
 			  0, "mxs-dma", mxs_dma);
@@ -437,8 +483,7 @@ static int mxs_dma_alloc_chan_resources(struct dma_chan *chan)
 err_clk:
 	free_irq(mxs_chan->chan_irq, mxs_dma);
 err_irq:
-	dma_pool_free(mxs_chan->ccw_pool, mxs_chan->ccw,
-		      mxs_chan->ccw_phys);
+	mxs_dma_free_ccw(mxs_chan);
 err_alloc:
 	return ret;
 }
@@ -453,8 +498,7 @@ static void mxs_dma_free_chan_resources(struct dma_chan *chan)
 
 	free_irq(mxs_chan->chan_irq, mxs_dma);
 
-	dma_pool_free(mxs_chan->ccw_pool, mxs_chan->ccw,
-		      mxs_chan->ccw_phys);
+	mxs_dma_free_ccw(mxs_chan);
 
 	pm_runtime_mark_last_busy(dev);
 	pm_runtime_put_autosuspend(dev);
@@ -499,10 +543,17 @@ static struct dma_async_tx_descriptor *mxs_dma_prep_slave_sg(
 	if (mxs_chan->status == DMA_IN_PROGRESS)
 		idx = mxs_chan->desc_count;
 
-	if (sg_len + idx > NUM_CCW) {
+	if (sg_len + idx > MAX_CCW) {
 		dev_err(mxs_dma->dma_device.dev,
 				"maximum number of sg exceeded: %d > %d\n",
-				sg_len, NUM_CCW);
+				sg_len, MAX_CCW);
+		goto err_out;
+	}
+
+	if (mxs_dma_grow_ccw(mxs_chan, direction == DMA_TRANS_NONE ?
+			     idx + 1 : idx + sg_len)) {
+		dev_err(mxs_dma->dma_device.dev,
+			"failed to grow the command chain\n");
 		goto err_out;
 	}
 
@@ -515,8 +566,8 @@ static struct dma_async_tx_descriptor *mxs_dma_prep_slave_sg(
 	 */
 	if (idx) {
 		BUG_ON(idx < 1);
-		ccw = &mxs_chan->ccw[idx - 1];
-		ccw->next = mxs_chan->ccw_phys + sizeof(*ccw) * idx;
+		ccw = mxs_dma_ccw(mxs_chan, idx - 1);
+		ccw->next = mxs_dma_ccw_phys(mxs_chan, idx);
 		ccw->bits |= CCW_CHAIN;
 		ccw->bits &= ~CCW_IRQ;
 		ccw->bits &= ~CCW_DEC_SEM;
@@ -525,7 +576,7 @@ static struct dma_async_tx_descriptor *mxs_dma_prep_slave_sg(
 	}
 
 	if (direction == DMA_TRANS_NONE) {
-		ccw = &mxs_chan->ccw[idx++];
+		ccw = mxs_dma_ccw(mxs_chan, idx++);
 		pio = (u32 *) sgl;
 
 		for (j = 0; j < sg_len;)
@@ -550,9 +601,9 @@ static struct dma_async_tx_descriptor *mxs_dma_prep_slave_sg(
 				goto err_out;
 			}
 
-			ccw = &mxs_chan->ccw[idx++];
+			ccw = mxs_dma_ccw(mxs_chan, idx++);
 
-			ccw->next = mxs_chan->ccw_phys + sizeof(*ccw) * idx;
+			ccw->next = mxs_dma_ccw_phys(mxs_chan, idx);
 			ccw->bufaddr = sg->dma_address;
 			ccw->xfer_bytes = sg_dma_len(sg);
 
@@ -599,10 +650,16 @@ static struct dma_async_tx_descriptor *mxs_dma_prep_dma_cyclic(
 	mxs_chan->flags |= MXS_DMA_SG_LOOP;
 	mxs_chan->flags |= MXS_DMA_USE_SEMAPHORE;
 
-	if (num_periods > NUM_CCW) {
+	if (num_periods > MAX_CCW) {
 		dev_err(mxs_dma->dma_device.dev,
 				"maximum number of sg exceeded: %d > %d\n",
-				num_periods, NUM_CCW);
+				num_periods, MAX_CCW);
+		goto err_out;
+	}
+
+	if (mxs_dma_grow_ccw(mxs_chan, num_periods)) {
+		dev_err(mxs_dma->dma_device.dev,
+			"failed to grow the command chain\n");
 		goto err_out;
 	}
 
@@ -614,12 +671,12 @@ static struct dma_async_tx_descriptor *mxs_dma_prep_dma_cyclic(
 	}
 
 	while (buf < buf_len) {
-		struct mxs_dma_ccw *ccw = &mxs_chan->ccw[i];
+		struct mxs_dma_ccw *ccw = mxs_dma_ccw(mxs_chan, i);
 
 		if (i + 1 == num_periods)
-			ccw->next = mxs_chan->ccw_phys;
+			ccw->next = mxs_chan->ccw_phys[0];
 		else
-			ccw->next = mxs_chan->ccw_phys + sizeof(*ccw) * (i + 1);
+			ccw->next = mxs_dma_ccw_phys(mxs_chan, i + 1);
 
 		ccw->bufaddr = dma_addr;
 		ccw->xfer_bytes = period_len;
@@ -667,7 +724,7 @@ static enum dma_status mxs_dma_tx_status(struct dma_chan *chan,
 		struct mxs_dma_ccw *last_ccw;
 		u32 bar;
 
-		last_ccw = &mxs_chan->ccw[mxs_chan->desc_count - 1];
+		last_ccw = mxs_dma_ccw(mxs_chan, mxs_chan->desc_count - 1);
 		residue = last_ccw->xfer_bytes + last_ccw->bufaddr;
 
 		bar = readl(mxs_dma->base +
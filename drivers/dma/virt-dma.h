@@ -87,6 +87,18 @@ static inline bool vchan_issue_pending(struct virt_dma_chan *vc)
 	return !list_empty(&vc->desc_issued);
 }
 
+/**
+ * vchan_desc_polled - check whether the client polls for completion
+ * @vd: virtual descriptor
+ *
+ * Drivers implementing DMA_PREP_POLL use this from their device_tx_status
+ * callback to decide whether to check the hardware and complete @vd inline.
+ */
+static inline bool vchan_desc_polled(struct virt_dma_desc *vd)
+{
+	return vd->tx.flags & DMA_PREP_POLL;
+}
+
 /**
  * vchan_cookie_complete - report completion of a descriptor
  * @vd: virtual descriptor to update
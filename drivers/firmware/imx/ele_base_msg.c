@@ -410,6 +410,53 @@ int imx_se_write_fuse(void *se_if_data, uint16_t fuse_index,
 }
 EXPORT_SYMBOL_GPL(imx_se_write_fuse);
 
+static int read_common_fuse_fill(struct se_if_priv *priv,
+				 struct se_api_msg *tx_msg, uint16_t fuse_id)
+{
+	int ret;
+
+	ret = se_fill_cmd_msg_hdr(priv, (struct se_msg_hdr *)&tx_msg->header,
+				  ELE_READ_FUSE_REQ, ELE_READ_FUSE_REQ_MSG_SZ,
+				  true);
+	if (ret) {
+		dev_err(priv->dev, "Error: se_fill_cmd_msg_hdr failed.\n");
+		return ret;
+	}
+
+	tx_msg->data[0] = fuse_id;
+
+	return 0;
+}
+
+static int read_common_fuse_parse(struct se_if_priv *priv,
+				  struct se_api_msg *rx_msg, int rx_msg_sz,
+				  uint16_t fuse_id, u32 *value)
+{
+	int ret;
+
+	ret = se_val_rsp_hdr_n_status(priv,
+				      rx_msg,
+				      ELE_READ_FUSE_REQ,
+				      rx_msg_sz,
+				      true);
+	if (ret)
+		return ret;
+
+	switch (fuse_id) {
+	case OTP_UNIQ_ID:
+		value[0] = rx_msg->data[1];
+		value[1] = rx_msg->data[2];
+		value[2] = rx_msg->data[3];
+		value[3] = rx_msg->data[4];
+		break;
+	default:
+		value[0] = rx_msg->data[1];
+		break;
+	}
+
+	return 0;
+}
+
 int read_common_fuse(struct se_if_priv *priv,
 		     uint16_t fuse_id, u32 *value)
 {
@@ -438,15 +485,9 @@ int read_common_fuse(struct se_if_priv *priv,
 		goto exit;
 	}
 
-	ret = se_fill_cmd_msg_hdr(priv, (struct se_msg_hdr *)&tx_msg->header,
-				  ELE_READ_FUSE_REQ, ELE_READ_FUSE_REQ_MSG_SZ,
-				  true);
-	if (ret) {
-		dev_err(priv->dev, "Error: se_fill_cmd_msg_hdr failed.\n");
+	ret = read_common_fuse_fill(priv, tx_msg, fuse_id);
+	if (ret)
 		goto exit;
-	}
-
-	tx_msg->data[0] = fuse_id;
 
 	ret = ele_msg_send_rcv(priv->priv_dev_ctx,
 			       tx_msg,
@@ -456,25 +497,7 @@ int read_common_fuse(struct se_if_priv *priv,
 	if (ret < 0)
 		goto exit;
 
-	ret = se_val_rsp_hdr_n_status(priv,
-				      rx_msg,
-				      ELE_READ_FUSE_REQ,
-				      rx_msg_sz,
-				      true);
-	if (ret)
-		goto exit;
-
-	switch (fuse_id) {
-	case OTP_UNIQ_ID:
-		value[0] = rx_msg->data[1];
-		value[1] = rx_msg->data[2];
-		value[2] = rx_msg->data[3];
-		value[3] = rx_msg->data[4];
-		break;
-	default:
-		value[0] = rx_msg->data[1];
-		break;
-	}
+	ret = read_common_fuse_parse(priv, rx_msg, rx_msg_sz, fuse_id, value);
 
 exit:
 	return ret;
@@ -503,6 +526,124 @@ int imx_se_read_fuse(void *se_if_data,
 }
 EXPORT_SYMBOL_GPL(imx_se_read_fuse);
 
+struct ele_fuse_batch {
+	atomic_t pending;
+	int err;
+	struct completion done;
+};
+
+struct ele_fuse_read {
+	struct se_async_req req;
+	struct ele_fuse_batch *batch;
+	struct se_if_priv *priv;
+	uint16_t fuse_id;
+	u32 *value;
+	u32 tx_msg[ELE_READ_FUSE_REQ_MSG_SZ / sizeof(u32)];
+	u32 rx_msg[ELE_READ_FUSE_RSP_MSG_SZ / sizeof(u32)];
+};
+
+static void ele_fuse_batch_put(struct ele_fuse_batch *batch, int err)
+{
+	if (err)
+		WRITE_ONCE(batch->err, err);
+
+	if (atomic_dec_and_test(&batch->pending))
+		complete(&batch->done);
+}
+
+static void ele_fuse_read_complete(struct se_async_req *req, int err)
+{
+	struct ele_fuse_read *rd = container_of(req, struct ele_fuse_read, req);
+
+	if (err >= 0)
+		err = read_common_fuse_parse(rd->priv,
+					     (struct se_api_msg *)rd->rx_msg,
+					     ELE_READ_FUSE_RSP_MSG_SZ,
+					     rd->fuse_id, rd->value);
+
+	ele_fuse_batch_put(rd->batch, err);
+}
+
+/**
+ * imx_se_read_fuses() - API to read a range of single-word fuses.
+ * @void *se_if_data: refs to data attached to the se interface.
+ * @uint16_t fuse_base: first fuse identifier to read.
+ * @unsigned int num: number of consecutive fuse words to read.
+ * @u32 *value: array of @num words to store the fused-values.
+ *
+ * All the reads are queued to the SE-FW up front, so the firmware is
+ * kept busy back to back instead of waiting for each caller round trip.
+ *
+ * Context: process context, sleeps until all reads have completed.
+ *
+ * Return value:
+ *   0,   means success.
+ *   < 0, means at least one of the reads failed.
+ */
+int imx_se_read_fuses(void *se_if_data, uint16_t fuse_base,
+		      unsigned int num, u32 *value)
+{
+	struct se_if_priv *priv = se_if_data;
+	struct ele_fuse_read *rd __free(kfree) = NULL;
+	struct ele_fuse_batch batch;
+	unsigned int i;
+	int ret;
+
+	if (!priv)
+		return -EINVAL;
+
+	if (!num)
+		return 0;
+
+	rd = kcalloc(num, sizeof(*rd), GFP_KERNEL);
+	if (!rd)
+		return -ENOMEM;
+
+	batch.err = 0;
+	atomic_set(&batch.pending, 1);
+	init_completion(&batch.done);
+
+	for (i = 0; i < num; i++) {
+		uint16_t fuse_id = fuse_base + i;
+
+		/* The unique ID answers with four words, keep it synchronous. */
+		if (fuse_id == OTP_UNIQ_ID ||
+		    read_common_fuse_fill(priv, (struct se_api_msg *)rd[i].tx_msg,
+					  fuse_id)) {
+			ret = read_common_fuse(priv, fuse_id, value + i);
+			if (ret)
+				WRITE_ONCE(batch.err, ret);
+			continue;
+		}
+
+		rd[i].batch = &batch;
+		rd[i].priv = priv;
+		rd[i].fuse_id = fuse_id;
+		rd[i].value = value + i;
+		rd[i].req.dev_ctx = priv->priv_dev_ctx;
+		rd[i].req.tx_msg = rd[i].tx_msg;
+		rd[i].req.tx_msg_sz = ELE_READ_FUSE_REQ_MSG_SZ;
+		rd[i].req.rx_msg = rd[i].rx_msg;
+		rd[i].req.rx_msg_sz = ELE_READ_FUSE_RSP_MSG_SZ;
+		rd[i].req.complete = ele_fuse_read_complete;
+
+		atomic_inc(&batch.pending);
+		if (ele_msg_send_rcv_async(&rd[i].req)) {
+			/* Queue full: read this word inline instead. */
+			atomic_dec(&batch.pending);
+			ret = read_common_fuse(priv, fuse_id, value + i);
+			if (ret)
+				WRITE_ONCE(batch.err, ret);
+		}
+	}
+
+	ele_fuse_batch_put(&batch, 0);
+	wait_for_completion(&batch.done);
+
+	return READ_ONCE(batch.err);
+}
+EXPORT_SYMBOL_GPL(imx_se_read_fuses);
+
 int ele_voltage_change_req(struct se_if_priv *priv, bool start)
 {
 	struct se_api_msg *tx_msg __free(kfree) = NULL;
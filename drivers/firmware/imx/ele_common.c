@@ -161,6 +161,70 @@ int ele_msg_send_rcv(struct se_if_device_ctx *dev_ctx,
 	return err;
 }
 
+static void ele_msg_async_work(struct work_struct *work)
+{
+	struct se_if_priv *priv = container_of(work, struct se_if_priv,
+					       async_work);
+	struct se_async_req *req;
+	int err;
+
+	for (;;) {
+		spin_lock(&priv->async_lock);
+		req = list_first_entry_or_null(&priv->async_queue,
+					       struct se_async_req, link);
+		if (req) {
+			list_del(&req->link);
+			priv->async_queued--;
+		}
+		spin_unlock(&priv->async_lock);
+
+		if (!req)
+			break;
+
+		/* The MU carries one command at a time, shared with the
+		 * blocking callers through se_if_cmd_lock.
+		 */
+		err = ele_msg_send_rcv(req->dev_ctx,
+				       req->tx_msg,
+				       req->tx_msg_sz,
+				       req->rx_msg,
+				       req->rx_msg_sz);
+		req->complete(req, err);
+	}
+}
+
+void ele_msg_async_init(struct se_if_priv *priv)
+{
+	spin_lock_init(&priv->async_lock);
+	INIT_LIST_HEAD(&priv->async_queue);
+	INIT_WORK(&priv->async_work, ele_msg_async_work);
+}
+
+/* API used for send/receive non-blocking call. */
+int ele_msg_send_rcv_async(struct se_async_req *req)
+{
+	struct se_if_priv *priv = req->dev_ctx->priv;
+
+	spin_lock(&priv->async_lock);
+	if (priv->async_queued >= SE_ASYNC_QUEUE_MAX) {
+		spin_unlock(&priv->async_lock);
+		return -EBUSY;
+	}
+	list_add_tail(&req->link, &priv->async_queue);
+	priv->async_queued++;
+	spin_unlock(&priv->async_lock);
+
+	queue_work(system_unbound_wq, &priv->async_work);
+
+	return 0;
+}
+
+/* Wait for all queued asynchronous requests to complete. */
+void ele_msg_async_flush(struct se_if_priv *priv)
+{
+	flush_work(&priv->async_work);
+}
+
 static bool exception_for_size(struct se_if_priv *priv,
 				struct se_msg_hdr *header)
 {
@@ -25,6 +25,9 @@ int ele_msg_send_rcv(struct se_if_device_ctx *dev_ctx,
 		     int tx_msg_sz,
 		     void *rx_msg,
 		     int exp_rx_msg_sz);
+void ele_msg_async_init(struct se_if_priv *priv);
+int ele_msg_send_rcv_async(struct se_async_req *req);
+void ele_msg_async_flush(struct se_if_priv *priv);
 void se_if_rx_callback(struct mbox_client *mbox_cl, void *msg);
 int se_val_rsp_hdr_n_status(struct se_if_priv *priv,
 			    struct se_api_msg *msg,
@@ -15,6 +15,17 @@ struct ele_rng_msg_data {
 	u32 data[2];
 };
 
+struct ele_rng_async {
+	struct se_async_req req;
+	struct se_if_priv *priv;
+	void (*done)(void *ctx, const u8 *data, int len);
+	void *ctx;
+	u8 *buf;
+	dma_addr_t dst_dma;
+	u32 tx_msg[ELE_GET_RANDOM_REQ_SZ / sizeof(u32)];
+	u32 rx_msg[ELE_GET_RANDOM_RSP_SZ / sizeof(u32)];
+};
+
 int ele_init_fw(struct se_if_priv *priv)
 {
 	struct se_api_msg *tx_msg __free(kfree) = NULL;
@@ -63,6 +74,35 @@ int ele_init_fw(struct se_if_priv *priv)
 	return ret;
 }
 
+static int ele_get_random_fill(struct se_if_priv *priv,
+			       struct se_api_msg *tx_msg,
+			       dma_addr_t dst_dma, size_t len)
+{
+	struct ele_rng_msg_data *rng_msg_data;
+	int ret;
+
+	ret = se_fill_cmd_msg_hdr(priv,
+				  (struct se_msg_hdr *)&tx_msg->header,
+				  ELE_GET_RANDOM_REQ,
+				  ELE_GET_RANDOM_REQ_SZ,
+				  false);
+	if (ret)
+		return ret;
+
+	rng_msg_data = (struct ele_rng_msg_data *)tx_msg->data;
+	/* bit 1(blocking reseed): wait for trng entropy,
+	 * then reseed rng context.
+	 */
+	if (get_se_soc_id(priv) != SOC_ID_OF_IMX95 &&
+	    get_se_soc_id(priv) != SOC_ID_OF_IMX94)
+		rng_msg_data->flags = BIT(1);
+
+	rng_msg_data->data[0] = dst_dma;
+	rng_msg_data->data[1] = len;
+
+	return 0;
+}
+
 /*
  * ele_get_random() - prepare and send the command to proceed
  *                    with a random number generation operation
@@ -74,7 +114,6 @@ int ele_get_random(struct se_if_priv *priv,
 {
 	struct se_api_msg *tx_msg __free(kfree) = NULL;
 	struct se_api_msg *rx_msg __free(kfree) = NULL;
-	struct ele_rng_msg_data *rng_msg_data;
 	dma_addr_t dst_dma;
 	u8 *buf = NULL;
 	int ret;
@@ -110,25 +149,10 @@ int ele_get_random(struct se_if_priv *priv,
 		goto exit;
 	}
 
-	ret = se_fill_cmd_msg_hdr(priv,
-				  (struct se_msg_hdr *)&tx_msg->header,
-				  ELE_GET_RANDOM_REQ,
-				  ELE_GET_RANDOM_REQ_SZ,
-				  false);
+	ret = ele_get_random_fill(priv, tx_msg, dst_dma, len);
 	if (ret)
 		goto exit;
 
-	rng_msg_data = (struct ele_rng_msg_data *)tx_msg->data;
-	/* bit 1(blocking reseed): wait for trng entropy,
-	 * then reseed rng context.
-	 */
-	if (get_se_soc_id(priv) != SOC_ID_OF_IMX95 &&
-	    get_se_soc_id(priv) != SOC_ID_OF_IMX94)
-		rng_msg_data->flags = BIT(1);
-
-	rng_msg_data->data[0] = dst_dma;
-	rng_msg_data->data[1] = len;
-
 	ret = ele_msg_send_rcv(priv->priv_dev_ctx,
 			       tx_msg,
 			       ELE_GET_RANDOM_REQ_SZ,
@@ -151,3 +175,79 @@ int ele_get_random(struct se_if_priv *priv,
 		dma_free_coherent(priv->dev, len, buf, dst_dma);
 	return ret;
 }
+
+static void ele_get_random_complete(struct se_async_req *req, int err)
+{
+	struct ele_rng_async *rng = container_of(req, struct ele_rng_async, req);
+
+	if (err >= 0)
+		err = se_val_rsp_hdr_n_status(rng->priv,
+					      (struct se_api_msg *)rng->rx_msg,
+					      ELE_GET_RANDOM_REQ,
+					      ELE_GET_RANDOM_RSP_SZ,
+					      false);
+
+	rng->done(rng->ctx, rng->buf, err ? err : ELE_RNG_MAX_SIZE);
+
+	memzero_explicit(rng->buf, ELE_RNG_MAX_SIZE);
+	dma_free_coherent(rng->priv->dev, ELE_RNG_MAX_SIZE, rng->buf,
+			  rng->dst_dma);
+	kfree(rng);
+}
+
+/*
+ * ele_get_random_async() - queue a random number generation operation
+ *
+ * done() is called from process context with ELE_RNG_MAX_SIZE bytes of
+ * data, or with a negative error code as len.
+ *
+ * returns:  0 if the request was queued, negative error code otherwise
+ */
+int ele_get_random_async(struct se_if_priv *priv,
+			 void (*done)(void *ctx, const u8 *data, int len),
+			 void *ctx)
+{
+	struct ele_rng_async *rng;
+	int ret;
+
+	if (!priv)
+		return -EINVAL;
+
+	rng = kzalloc(sizeof(*rng), GFP_KERNEL);
+	if (!rng)
+		return -ENOMEM;
+
+	rng->buf = dma_alloc_coherent(priv->dev, ELE_RNG_MAX_SIZE,
+				      &rng->dst_dma, GFP_KERNEL);
+	if (!rng->buf) {
+		ret = -ENOMEM;
+		goto free_rng;
+	}
+
+	ret = ele_get_random_fill(priv, (struct se_api_msg *)rng->tx_msg,
+				  rng->dst_dma, ELE_RNG_MAX_SIZE);
+	if (ret)
+		goto free_buf;
+
+	rng->priv = priv;
+	rng->done = done;
+	rng->ctx = ctx;
+	rng->req.dev_ctx = priv->priv_dev_ctx;
+	rng->req.tx_msg = rng->tx_msg;
+	rng->req.tx_msg_sz = ELE_GET_RANDOM_REQ_SZ;
+	rng->req.rx_msg = rng->rx_msg;
+	rng->req.rx_msg_sz = ELE_GET_RANDOM_RSP_SZ;
+	rng->req.complete = ele_get_random_complete;
+
+	ret = ele_msg_send_rcv_async(&rng->req);
+	if (ret)
+		goto free_buf;
+
+	return 0;
+
+free_buf:
+	dma_free_coherent(priv->dev, ELE_RNG_MAX_SIZE, rng->buf, rng->dst_dma);
+free_rng:
+	kfree(rng);
+	return ret;
+}
@@ -21,6 +21,9 @@
 
 int ele_init_fw(struct se_if_priv *priv);
 int ele_get_random(struct se_if_priv *priv, void *data, size_t len);
+int ele_get_random_async(struct se_if_priv *priv,
+			 void (*done)(void *ctx, const u8 *data, int len),
+			 void *ctx);
 int ele_get_hwrng(struct hwrng *rng, void *data, size_t len, bool wait);
 
 #endif /* ELE_FW_API_H */
@@ -5,20 +5,89 @@
  * Copyright 2024-2025 NXP
  */
 
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+
+#include "ele_common.h"
 #include "ele_trng.h"
 #include "ele_fw_api.h"
 
+#define ELE_TRNG_POOL_SIZE	(64 * ELE_RNG_MAX_SIZE)
+
 struct ele_trng {
 	struct hwrng rng;
 	struct se_if_priv *priv;
+	/* Prefetched random bytes, refilled through the async ELE queue. */
+	spinlock_t lock;
+	u8 pool[ELE_TRNG_POOL_SIZE];
+	size_t avail;
+	bool refill;
+	bool stopping;
+	ktime_t refill_start;
+
+	/* statistics, exposed through debugfs */
+	u64 underruns;
+	u32 refill_last_us;
+	u32 refill_max_us;
+	struct dentry *debugfs;
 };
 
 static struct ele_trng trng;
 
+static void ele_trng_refill(struct ele_trng *trng);
+
+static void ele_trng_refill_done(void *ctx, const u8 *data, int len)
+{
+	struct ele_trng *trng = ctx;
+	size_t n = 0;
+	u32 us;
+
+	us = ktime_us_delta(ktime_get(), trng->refill_start);
+
+	spin_lock(&trng->lock);
+	trng->refill = false;
+	trng->refill_last_us = us;
+	trng->refill_max_us = max(trng->refill_max_us, us);
+	if (len > 0 && !trng->stopping) {
+		n = min_t(size_t, len, ELE_TRNG_POOL_SIZE - trng->avail);
+		memcpy(trng->pool + trng->avail, data, n);
+		trng->avail += n;
+	}
+	spin_unlock(&trng->lock);
+
+	if (n)
+		ele_trng_refill(trng);
+}
+
+static void ele_trng_refill(struct ele_trng *trng)
+{
+	spin_lock(&trng->lock);
+	if (trng->refill || trng->stopping ||
+	    trng->avail + ELE_RNG_MAX_SIZE > ELE_TRNG_POOL_SIZE) {
+		spin_unlock(&trng->lock);
+		return;
+	}
+	trng->refill = true;
+	trng->refill_start = ktime_get();
+	spin_unlock(&trng->lock);
+
+	if (ele_get_random_async(trng->priv, ele_trng_refill_done, trng)) {
+		spin_lock(&trng->lock);
+		trng->refill = false;
+		spin_unlock(&trng->lock);
+	}
+}
+
 int ele_trng_init(struct se_if_priv *priv)
 {
 	int ret;
 
+	spin_lock_init(&trng.lock);
+	trng.avail       = 0;
+	trng.refill      = false;
+	trng.stopping    = false;
+	trng.underruns   = 0;
+
 	trng.priv        = priv;
 	trng.rng.name    = "ele-trng";
 	trng.rng.read    = ele_get_hwrng;
@@ -31,13 +100,35 @@ int ele_trng_init(struct se_if_priv *priv)
 	if (ret)
 		return ret;
 
+	ele_trng_refill(&trng);
+
+	trng.debugfs = debugfs_create_dir("ele-trng", NULL);
+	debugfs_create_u64("underruns", 0444, trng.debugfs, &trng.underruns);
+	debugfs_create_u32("refill_last_us", 0444, trng.debugfs,
+			   &trng.refill_last_us);
+	debugfs_create_u32("refill_max_us", 0444, trng.debugfs,
+			   &trng.refill_max_us);
+
 	dev_info(priv->dev, "Successfully registered ele-trng\n");
 	return 0;
 }
 
 int ele_trng_exit(struct se_if_priv *priv)
 {
+	spin_lock(&trng.lock);
+	trng.stopping = true;
+	spin_unlock(&trng.lock);
+
+	debugfs_remove_recursive(trng.debugfs);
+	trng.debugfs = NULL;
+
 	hwrng_unregister(&trng.rng);
+	ele_msg_async_flush(priv);
+
+	spin_lock(&trng.lock);
+	memzero_explicit(trng.pool, sizeof(trng.pool));
+	trng.avail = 0;
+	spin_unlock(&trng.lock);
 
 	dev_info(priv->dev, "Successfully unregistered ele-trng\n");
 	return 0;
@@ -47,6 +138,23 @@ int ele_get_hwrng(struct hwrng *rng,
 		  void *data, size_t len, bool wait)
 {
 	struct ele_trng *trng = (struct ele_trng *)rng->priv;
+	size_t n;
+
+	spin_lock(&trng->lock);
+	n = min(len, trng->avail);
+	if (n) {
+		trng->avail -= n;
+		memcpy(data, trng->pool + trng->avail, n);
+		memzero_explicit(trng->pool + trng->avail, n);
+	} else if (len) {
+		trng->underruns++;
+	}
+	spin_unlock(&trng->lock);
+
+	ele_trng_refill(trng);
+
+	if (n || !wait)
+		return n;
 
 	return ele_get_random(trng->priv, data, len);
 }
@@ -6,13 +6,61 @@
  * Implementation of the DSP IPC interface (host side)
  */
 
+#include <linux/debugfs.h>
 #include <linux/firmware/imx/dsp.h>
+#include <linux/iopoll.h>
 #include <linux/kernel.h>
+#include <linux/log2.h>
 #include <linux/mailbox_client.h>
+#include <linux/mailbox_controller.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 
+/* Commands up to this size are considered short enough to poll for */
+#define IMX_DSP_POLL_MAX_SIZE	64
+
+static unsigned int poll_us = 50;
+module_param(poll_us, uint, 0644);
+MODULE_PARM_DESC(poll_us, "Time to poll for the reply of short commands (us, 0 = IRQ only)");
+
+static void imx_dsp_stats_start(struct imx_dsp_ipc *ipc)
+{
+	struct imx_dsp_ipc_stats *stats = &ipc->stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->start = ktime_get();
+	stats->pending = true;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+static void imx_dsp_stats_done(struct imx_dsp_ipc *ipc, bool polled)
+{
+	struct imx_dsp_ipc_stats *stats = &ipc->stats;
+	unsigned long flags;
+	u64 ns, us;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	if (!stats->pending)
+		goto unlock;
+
+	/* Only the first of the poller and the IRQ path accounts the reply */
+	stats->pending = false;
+	ns = ktime_to_ns(ktime_sub(ktime_get(), stats->start));
+	us = div_u64(ns, NSEC_PER_USEC);
+
+	stats->count++;
+	stats->polled += polled;
+	stats->total_ns += ns;
+	stats->max_ns = max(stats->max_ns, ns);
+	stats->hist[min_t(u32, us ? ilog2(us) + 1 : 0,
+			  IMX_DSP_LAT_BUCKETS - 1)]++;
+unlock:
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
 /*
  * imx_dsp_ring_doorbell - triggers an interrupt on the other side (DSP)
  *
@@ -30,6 +78,10 @@ int imx_dsp_ring_doorbell(struct imx_dsp_ipc *ipc, unsigned int idx)
 		return -EINVAL;
 
 	dsp_chan = &ipc->chans[idx];
+
+	if (idx == 0)
+		imx_dsp_stats_start(ipc);
+
 	ret = mbox_send_message(dsp_chan->ch, NULL);
 	if (ret < 0)
 		return ret;
@@ -38,6 +90,95 @@ int imx_dsp_ring_doorbell(struct imx_dsp_ipc *ipc, unsigned int idx)
 }
 EXPORT_SYMBOL(imx_dsp_ring_doorbell);
 
+/*
+ * imx_dsp_ring_doorbell_sync - ring a doorbell for a synchronous command
+ *
+ * @ipc: DSP IPC handle
+ * @idx: index of the channel where to trigger the interrupt
+ * @size: size of the command
+ *
+ * Short commands are usually answered within a few microseconds. For those,
+ * busy-wait up to poll_us for the reply doorbell. The reply is still handed
+ * over by the rx IRQ, which is then already pending when the caller starts
+ * waiting, so that the caller does not have to sleep and be woken up again.
+ * Polling needs a mailbox controller implementing peek_data and is safe to
+ * use with interrupts disabled.
+ *
+ * Returns 1 if the reply is pending, 0 if it will be signalled later by the
+ * rx IRQ, negative value for error
+ */
+int imx_dsp_ring_doorbell_sync(struct imx_dsp_ipc *ipc, unsigned int idx,
+			       size_t size)
+{
+	struct mbox_chan *rx;
+	unsigned int timeout = READ_ONCE(poll_us);
+	bool ready;
+	int ret;
+
+	ret = imx_dsp_ring_doorbell(ipc, idx);
+	if (ret < 0 || idx >= DSP_MU_CHAN_NUM / 2)
+		return ret;
+
+	rx = ipc->chans[idx + DSP_MU_CHAN_NUM / 2].ch;
+	if (!timeout || size > IMX_DSP_POLL_MAX_SIZE || !rx->mbox->ops->peek_data)
+		return 0;
+
+	if (readx_poll_timeout_atomic(mbox_client_peek_data, rx, ready, ready,
+				      1, timeout))
+		return 0;
+
+	if (idx == 0)
+		imx_dsp_stats_done(ipc, true);
+
+	return 1;
+}
+EXPORT_SYMBOL(imx_dsp_ring_doorbell_sync);
+
+static int imx_dsp_latency_show(struct seq_file *s, void *data)
+{
+	struct imx_dsp_ipc *ipc = s->private;
+	struct imx_dsp_ipc_stats *stats = &ipc->stats;
+	struct imx_dsp_ipc_stats snap;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	snap = *stats;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	seq_printf(s, "count: %llu\npolled: %llu\n", snap.count, snap.polled);
+	seq_printf(s, "avg_us: %llu\nmax_us: %llu\n",
+		   snap.count ? div64_u64(snap.total_ns, snap.count * NSEC_PER_USEC) : 0,
+		   div_u64(snap.max_ns, NSEC_PER_USEC));
+
+	for (i = 0; i < IMX_DSP_LAT_BUCKETS; i++)
+		seq_printf(s, "%s%6u us: %u\n",
+			   i == IMX_DSP_LAT_BUCKETS - 1 ? ">=" : " <",
+			   i == IMX_DSP_LAT_BUCKETS - 1 ? 1U << (i - 1) : 1U << i,
+			   snap.hist[i]);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(imx_dsp_latency);
+
+/*
+ * imx_dsp_debugfs_init - expose the IPC latency histogram
+ *
+ * @ipc: DSP IPC handle
+ * @parent: debugfs directory of the IPC user
+ *
+ * May be called more than once, the file is only created the first time.
+ */
+void imx_dsp_debugfs_init(struct imx_dsp_ipc *ipc, struct dentry *parent)
+{
+	if (ipc->debugfs || IS_ERR_OR_NULL(parent))
+		return;
+
+	ipc->debugfs = debugfs_create_file("ipc_latency", 0444, parent, ipc,
+					   &imx_dsp_latency_fops);
+}
+EXPORT_SYMBOL(imx_dsp_debugfs_init);
+
 /*
  * imx_dsp_handle_rx - rx callback used by imx mailbox
  *
@@ -52,6 +193,7 @@ static void imx_dsp_handle_rx(struct mbox_client *c, void *msg)
 	struct imx_dsp_chan *chan = container_of(c, struct imx_dsp_chan, cl);
 
 	if (chan->idx == 0) {
+		imx_dsp_stats_done(chan->ipc, false);
 		chan->ipc->ops->handle_reply(chan->ipc);
 	} else {
 		chan->ipc->ops->handle_request(chan->ipc);
@@ -149,6 +291,7 @@ static int imx_dsp_probe(struct platform_device *pdev)
 		return -ENOMEM;
 
 	dsp_ipc->dev = dev;
+	spin_lock_init(&dsp_ipc->stats.lock);
 	dev_set_drvdata(dev, dsp_ipc);
 
 	ret = imx_dsp_setup_channels(dsp_ipc);
@@ -10,10 +10,12 @@
 #include <linux/firmware/imx/ipc.h>
 #include <linux/firmware/imx/sci.h>
 #include <linux/kobject.h>
+#include <linux/ktime.h>
 #include <linux/mailbox_client.h>
 #include <linux/of.h>
 #include <linux/suspend.h>
 #include <linux/sysfs.h>
+#include <linux/workqueue.h>
 
 #define IMX_SC_IRQ_FUNC_ENABLE	1
 #define IMX_SC_IRQ_FUNC_STATUS	2
@@ -54,6 +56,15 @@ static struct kobject *wakeup_obj;
 static ssize_t wakeup_source_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf);
 static struct kobj_attribute wakeup_source_attr =
 		__ATTR(wakeup_src, 0660, wakeup_source_show, NULL);
+static ssize_t irq_latency_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf);
+static struct kobj_attribute irq_latency_attr =
+		__ATTR(irq_latency, 0444, irq_latency_show, NULL);
+
+/* MU doorbell to notifier dispatch latency */
+static ktime_t notify_stamp;
+static u64 notify_count;
+static u64 notify_last_ns;
+static u64 notify_max_ns;
 
 static struct scu_wakeup scu_irq_wakeup[IMX_SC_IRQ_NUM_GROUP];
 
@@ -83,23 +94,56 @@ static int imx_scu_irq_notifier_call_chain(unsigned long status, u8 *group)
 
 static void imx_scu_irq_work_handler(struct work_struct *work)
 {
+	struct imx_sc_msg_irq_get_status msgs[IMX_SC_IRQ_NUM_GROUP];
+	void *ptrs[IMX_SC_IRQ_NUM_GROUP];
+	u8 groups[IMX_SC_IRQ_NUM_GROUP];
+	struct imx_sc_rpc_msg *hdr;
+	unsigned int num = 0, n;
+	ktime_t stamp;
 	u32 irq_status;
+	u64 delta;
 	int ret;
 	u8 i;
 
+	stamp = READ_ONCE(notify_stamp);
+
+	/*
+	 * SCFW only flags enabled interrupts, so a group nobody enabled
+	 * cannot be pending. Query the others in one hold of the channel.
+	 */
 	for (i = 0; i < IMX_SC_IRQ_NUM_GROUP; i++) {
-		if (scu_irq_wakeup[i].mask) {
-			scu_irq_wakeup[i].valid = false;
-			scu_irq_wakeup[i].wakeup_src = 0;
-		}
+		if (!scu_irq_wakeup[i].mask)
+			continue;
 
-		ret = imx_scu_irq_get_status(i, &irq_status);
-		if (ret) {
-			pr_err("get irq group %d status failed, ret %d\n",
-			       i, ret);
-			return;
-		}
+		scu_irq_wakeup[i].valid = false;
+		scu_irq_wakeup[i].wakeup_src = 0;
 
+		hdr = &msgs[num].hdr;
+		hdr->ver = IMX_SC_RPC_VERSION;
+		hdr->svc = IMX_SC_RPC_SVC_IRQ;
+		hdr->func = IMX_SC_IRQ_FUNC_STATUS;
+		hdr->size = 2;
+
+		msgs[num].data.req.resource = mu_resource_id;
+		msgs[num].data.req.group = i;
+		ptrs[num] = &msgs[num];
+		groups[num++] = i;
+	}
+
+	if (!num)
+		return;
+
+	ret = imx_scu_call_rpc_batch(imx_sc_irq_ipc_handle, ptrs, num);
+	if (ret)
+		pr_err("get irq group status failed, ret %d\n", ret);
+
+	for (n = 0; n < num; n++) {
+		/* a reply carries the call status, reading also cleared it */
+		if (msgs[n].hdr.func != 0)
+			break;
+
+		i = groups[n];
+		irq_status = msgs[n].data.resp.status;
 		if (!irq_status)
 			continue;
 		if (scu_irq_wakeup[i].mask & irq_status) {
@@ -112,6 +156,11 @@ static void imx_scu_irq_work_handler(struct work_struct *work)
 		pm_system_wakeup();
 		imx_scu_irq_notifier_call_chain(irq_status, &i);
 	}
+
+	delta = ktime_to_ns(ktime_sub(ktime_get(), stamp));
+	notify_last_ns = delta;
+	notify_max_ns = max(notify_max_ns, delta);
+	notify_count++;
 }
 
 int imx_scu_irq_get_status(u8 group, u32 *irq_status)
@@ -174,7 +223,12 @@ EXPORT_SYMBOL(imx_scu_irq_group_enable);
 
 static void imx_scu_irq_callback(struct mbox_client *c, void *msg)
 {
-	schedule_work(&imx_sc_irq_work);
+	/* doorbells merged into a pending work count from the first one */
+	if (!work_pending(&imx_sc_irq_work))
+		WRITE_ONCE(notify_stamp, ktime_get());
+
+	/* the handlers include watchdog and partition reboot events */
+	queue_work(system_highpri_wq, &imx_sc_irq_work);
 }
 
 static ssize_t wakeup_source_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
@@ -196,6 +250,14 @@ static ssize_t wakeup_source_show(struct kobject *kobj, struct kobj_attribute *a
 	return strlen(buf);
 }
 
+static ssize_t irq_latency_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	/* events, last and max notify to dispatch latency in us */
+	return sysfs_emit(buf, "%llu %llu %llu\n", notify_count,
+			  div_u64(notify_last_ns, NSEC_PER_USEC),
+			  div_u64(notify_max_ns, NSEC_PER_USEC));
+}
+
 int imx_scu_enable_general_irq_channel(struct device *dev)
 {
 	struct of_phandle_args spec;
@@ -249,6 +311,10 @@ int imx_scu_enable_general_irq_channel(struct device *dev)
 		goto free_ch;
 	}
 
+	ret = sysfs_create_file(wakeup_obj, &irq_latency_attr.attr);
+	if (ret)
+		dev_warn(dev, "Cannot create irq latency file: %d\n", ret);
+
 	return 0;
 
 free_ch:
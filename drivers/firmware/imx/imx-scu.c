@@ -203,19 +203,17 @@ static int imx_scu_ipc_write(struct imx_sc_ipc *sc_ipc, void *msg)
 }
 
 /*
- * RPC command/response
+ * Send one RPC and wait for its response, with sc_ipc->lock held.
+ * Returns the SCFW status of the call, or a negative errno on IPC failure.
  */
-int imx_scu_call_rpc(struct imx_sc_ipc *sc_ipc, void *msg, bool have_resp)
+static int __imx_scu_call_rpc(struct imx_sc_ipc *sc_ipc, void *msg,
+			      bool have_resp)
 {
 	uint8_t saved_svc, saved_func;
 	struct imx_sc_rpc_msg *hdr;
 	struct arm_smccc_res res;
 	int ret;
 
-	if (WARN_ON(!sc_ipc || !msg))
-		return -EINVAL;
-
-	mutex_lock(&sc_ipc->lock);
 	reinit_completion(&sc_ipc->done);
 
 	if (have_resp) {
@@ -244,8 +242,8 @@ int imx_scu_call_rpc(struct imx_sc_ipc *sc_ipc, void *msg, bool have_resp)
 			if (!wait_for_completion_timeout(&sc_ipc->done,
 							 MAX_RX_TIMEOUT)) {
 				dev_err(sc_ipc->dev, "RPC send msg timeout\n");
-				mutex_unlock(&sc_ipc->lock);
-				return -ETIMEDOUT;
+				ret = -ETIMEDOUT;
+				goto out;
 			}
 
 			/* response status is stored in hdr->func field */
@@ -267,14 +265,62 @@ int imx_scu_call_rpc(struct imx_sc_ipc *sc_ipc, void *msg, bool have_resp)
 
 out:
 	sc_ipc->msg = NULL;
+
+	return ret;
+}
+
+/*
+ * RPC command/response
+ */
+int imx_scu_call_rpc(struct imx_sc_ipc *sc_ipc, void *msg, bool have_resp)
+{
+	int ret;
+
+	if (WARN_ON(!sc_ipc || !msg))
+		return -EINVAL;
+
+	mutex_lock(&sc_ipc->lock);
+	ret = __imx_scu_call_rpc(sc_ipc, msg, have_resp);
 	mutex_unlock(&sc_ipc->lock);
 
 	dev_dbg(sc_ipc->dev, "RPC SVC done\n");
 
+	if (ret == -ETIMEDOUT)
+		return ret;
+
 	return imx_sc_to_linux_errno(ret);
 }
 EXPORT_SYMBOL(imx_scu_call_rpc);
 
+/*
+ * Batched RPC command/response
+ */
+int imx_scu_call_rpc_batch(struct imx_sc_ipc *sc_ipc, void **msgs,
+			   unsigned int num)
+{
+	unsigned int i;
+	int ret = 0;
+
+	if (WARN_ON(!sc_ipc || !msgs))
+		return -EINVAL;
+
+	mutex_lock(&sc_ipc->lock);
+	for (i = 0; i < num; i++) {
+		ret = __imx_scu_call_rpc(sc_ipc, msgs[i], true);
+		if (ret)
+			break;
+	}
+	mutex_unlock(&sc_ipc->lock);
+
+	dev_dbg(sc_ipc->dev, "RPC batch of %u done at %u\n", num, i);
+
+	if (ret == -ETIMEDOUT)
+		return ret;
+
+	return imx_sc_to_linux_errno(ret);
+}
+EXPORT_SYMBOL(imx_scu_call_rpc_batch);
+
 static int imx_scu_probe(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
@@ -10,6 +10,7 @@
  */
 
 #include <linux/firmware/imx/svc/misc.h>
+#include <linux/slab.h>
 
 struct imx_sc_msg_req_misc_set_ctrl {
 	struct imx_sc_rpc_msg hdr;
@@ -74,6 +75,56 @@ int imx_sc_misc_set_control(struct imx_sc_ipc *ipc, u32 resource,
 }
 EXPORT_SYMBOL(imx_sc_misc_set_control);
 
+/*
+ * This function sets a list of miscellaneous control values with a single
+ * hold of the IPC channel.
+ *
+ * @param[in]     ipc         IPC handle
+ * @param[in]     ctrls       controls to change and values to apply
+ * @param[in]     num         number of controls
+ *
+ * @return Returns 0 for success and < 0 for errors, controls after the
+ * first failing one are left untouched.
+ */
+int imx_sc_misc_set_controls(struct imx_sc_ipc *ipc,
+			     const struct imx_sc_misc_ctrl *ctrls,
+			     unsigned int num)
+{
+	struct imx_sc_msg_req_misc_set_ctrl *msgs;
+	struct imx_sc_rpc_msg *hdr;
+	unsigned int i;
+	void **ptrs;
+	int ret;
+
+	msgs = kcalloc(num, sizeof(*msgs), GFP_KERNEL);
+	ptrs = kcalloc(num, sizeof(*ptrs), GFP_KERNEL);
+	if (!msgs || !ptrs) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < num; i++) {
+		hdr = &msgs[i].hdr;
+		hdr->ver = IMX_SC_RPC_VERSION;
+		hdr->svc = (uint8_t)IMX_SC_RPC_SVC_MISC;
+		hdr->func = (uint8_t)IMX_SC_MISC_FUNC_SET_CONTROL;
+		hdr->size = 4;
+
+		msgs[i].ctrl = ctrls[i].ctrl;
+		msgs[i].val = ctrls[i].val;
+		msgs[i].resource = ctrls[i].resource;
+		ptrs[i] = &msgs[i];
+	}
+
+	ret = imx_scu_call_rpc_batch(ipc, ptrs, num);
+out:
+	kfree(ptrs);
+	kfree(msgs);
+
+	return ret;
+}
+EXPORT_SYMBOL(imx_sc_misc_set_controls);
+
 int imx_sc_misc_set_dma_group(struct imx_sc_ipc *ipc, u32 resource,
 			    u32 val)
 {
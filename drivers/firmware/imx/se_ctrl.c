@@ -2039,6 +2039,8 @@ static void se_if_probe_cleanup(void *plat_dev)
 	priv = dev_get_drvdata(dev);
 	load_fw = get_load_fw_instance(priv);
 
+	ele_msg_async_flush(priv);
+
 	/* In se_if_request_channel(), passed the clean-up functional
 	 * pointer reference as action to devm_add_action().
 	 * No need to free the mbox channels here.
@@ -2141,6 +2143,7 @@ static int se_if_probe(struct platform_device *pdev)
 
 	priv->dev = dev;
 	priv->if_defs = &info->if_defs;
+	ele_msg_async_init(priv);
 	dev_set_drvdata(dev, priv);
 
 	if (info->se_if_early_init) {
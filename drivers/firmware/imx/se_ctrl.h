@@ -9,6 +9,8 @@
 #include <linux/miscdevice.h>
 #include <linux/semaphore.h>
 #include <linux/mailbox_client.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
 #include <uapi/linux/se_ioctl.h>
 
 #include "se_msg_sqfl_ctrl.h"
@@ -18,6 +20,7 @@
 #define RES_STATUS(x)			FIELD_GET(0x000000ff, x)
 #define MAX_DATA_SIZE_PER_USER		(65 * 1024)
 #define MAX_NVM_MSG_LEN			(256)
+#define SE_ASYNC_QUEUE_MAX		32
 #define MESSAGING_VERSION_2		0x2
 #define MESSAGING_VERSION_6		0x6
 #define MESSAGING_VERSION_7		0x7
@@ -44,6 +47,21 @@ struct se_clbk_handle {
 	struct se_api_msg *rx_msg;
 };
 
+/*
+ * Asynchronous request, see ele_msg_send_rcv_async(). The buffers must
+ * stay valid until complete() is called with the return value the
+ * blocking ele_msg_send_rcv() would have returned.
+ */
+struct se_async_req {
+	struct list_head link;
+	struct se_if_device_ctx *dev_ctx;
+	void *tx_msg;
+	int tx_msg_sz;
+	void *rx_msg;
+	int rx_msg_sz;
+	void (*complete)(struct se_async_req *req, int err);
+};
+
 struct se_imem_buf {
 	u8 *buf;
 	phys_addr_t phyaddr;
@@ -132,6 +150,12 @@ struct se_if_priv {
 	struct mutex se_if_cmd_lock;
 	struct se_msg_seq_ctrl se_msg_sq_ctl;
 
+	/* Queued asynchronous requests, issued in order by async_work. */
+	spinlock_t async_lock;
+	struct list_head async_queue;
+	u32 async_queued;
+	struct work_struct async_work;
+
 	struct mbox_client se_mb_cl;
 	struct mbox_chan *tx_chan, *rx_chan;
 
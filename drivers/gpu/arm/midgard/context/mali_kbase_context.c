@@ -300,8 +300,13 @@ int kbase_context_mem_pool_group_init(struct kbase_context *kctx)
 	size_t const small_max_size = KBASE_MEM_POOL_MAX_SIZE_KCTX;
 	size_t const large_max_size = small_max_size >> (KBASE_MEM_POOL_2MB_PAGE_TABLE_ORDER -
 							 KBASE_MEM_POOL_SMALL_PAGE_TABLE_ORDER);
-	return kbase_mem_pool_group_init(&kctx->mem_pools, kctx->kbdev, small_max_size,
-					 large_max_size, NULL);
+	int err = kbase_mem_pool_group_init(&kctx->mem_pools, kctx->kbdev, small_max_size,
+					    large_max_size, NULL);
+
+	if (!err)
+		kbase_mem_pool_group_prefill(&kctx->mem_pools);
+
+	return err;
 }
 
 void kbase_context_mem_pool_group_term(struct kbase_context *kctx)
@@ -522,6 +522,11 @@ struct kbase_pm_device_data {
  * @reclaim_allowed:           true if the shrinker is currently allowed to reclaim from this
  *                             pool. Otherwise, false: the shrinker is forbidden from reclaiming
  *                             memory from it - eg during a grow operation.
+ * @prefill_link:              For hook onto the pools list of &struct kbase_mem_pool_prefill,
+ *                             protected by its lock.
+ * @prefill_target:            Number of free pages the prefill thread keeps in the pool, or 0
+ *                             if the pool is not prefilled. Refill is requested once the pool
+ *                             drops below half of it.
  */
 struct kbase_mem_pool {
 	struct list_head link_to_ctrl;
@@ -541,6 +546,9 @@ struct kbase_mem_pool {
 	bool dying;
 	bool pool_supports_reclaim;
 	bool reclaim_allowed;
+
+	struct list_head prefill_link;
+	size_t prefill_target;
 };
 
 /**
@@ -739,6 +747,28 @@ struct kbase_mem_migrate {
 #endif
 };
 
+/**
+ * struct kbase_mem_pool_prefill - Object representing the background refill
+ *                                 of memory pools.
+ *
+ * @thread:  Low priority kernel thread growing the pools in @pools, so that
+ *           allocating, zeroing and mapping new pages is not done on the
+ *           allocation path of a context.
+ * @lock:    Lock protecting @pools and @active.
+ * @pools:   List of pools waiting to be grown to their prefill target.
+ * @active:  Pool currently being grown by @thread, or NULL.
+ * @wq:      Wait queue @thread sleeps on while @pools is empty.
+ * @idle_wq: Wait queue for a pool being terminated to stop being @active.
+ */
+struct kbase_mem_pool_prefill {
+	struct task_struct *thread;
+	spinlock_t lock;
+	struct list_head pools;
+	struct kbase_mem_pool *active;
+	wait_queue_head_t wq;
+	wait_queue_head_t idle_wq;
+};
+
 /**
  * struct kbase_device   - Object representing an instance of GPU platform device,
  *                         allocated from the probe method of mali driver.
@@ -1037,6 +1067,8 @@ struct kbase_mem_migrate {
  * @oom_notifier_block:     notifier_block containing kernel-registered out-of-
  *                          memory handler.
  * @mem_migrate:            Per device object for managing page migration.
+ * @mem_pool_prefill:       Per device object for refilling memory pools in the
+ *                          background.
  * @live_fence_metadata:    Count of live fence metadata structures created by
  *                          KCPU queue. These structures may outlive kbase module
  *                          itself. Therefore, in such a case, a warning should be
@@ -1304,6 +1336,8 @@ struct kbase_device {
 
 	struct kbase_mem_migrate mem_migrate;
 
+	struct kbase_mem_pool_prefill mem_pool_prefill;
+
 #if IS_ENABLED(CONFIG_SYNC_FILE)
 	atomic_t live_fence_metadata;
 #endif
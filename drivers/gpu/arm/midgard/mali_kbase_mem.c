@@ -232,6 +232,10 @@ int kbase_mem_init(struct kbase_device *kbdev)
 
 	kbase_mem_migrate_init(kbdev);
 
+	err = kbase_mem_pool_prefill_init(kbdev);
+	if (err)
+		goto prefill_fail;
+
 	if ((GPU_PAGES_PER_CPU_PAGE > 1) || kbase_is_page_migration_enabled()) {
 		char page_metadata_slab_name[PAGE_METADATA_SLAB_NAME_SIZE];
 
@@ -313,6 +317,8 @@ int kbase_mem_init(struct kbase_device *kbdev)
 	kmem_cache_destroy(kbdev->page_metadata_slab);
 	kbdev->page_metadata_slab = NULL;
 page_metadata_slab_fail:
+	kbase_mem_pool_prefill_term(kbdev);
+prefill_fail:
 	kbase_mem_migrate_term(kbdev);
 	kmem_cache_destroy(kbdev->va_region_slab);
 	kbdev->va_region_slab = NULL;
@@ -338,6 +344,8 @@ void kbase_mem_term(struct kbase_device *kbdev)
 	if (pages != 0)
 		dev_warn(kbdev->dev, "%s: %d pages in use!\n", __func__, pages);
 
+	kbase_mem_pool_prefill_term(kbdev);
+
 	kbase_mem_pool_term(&kbdev->pgd_mem_pool);
 	kbase_mem_pool_term(&kbdev->fw_mem_pools.small);
 	kbase_mem_pool_term(&kbdev->fw_mem_pools.large);
@@ -1302,6 +1302,32 @@ int kbase_mem_pool_grow(struct kbase_mem_pool *pool, size_t nr_to_grow,
  */
 void kbase_mem_pool_trim(struct kbase_mem_pool *pool, size_t new_size);
 
+/**
+ * kbase_mem_pool_prefill - Start keeping a pool filled in the background
+ * @pool: Memory pool to prefill
+ *
+ * Sets the prefill target of @pool from the mem_pool_prefill_small_pages or
+ * mem_pool_prefill_large_pages module parameter, depending on its order, and
+ * queues it to the prefill thread. From then on, whenever allocations take
+ * the pool below half of its target, the thread grows it back. Does nothing
+ * if the corresponding parameter is 0.
+ */
+void kbase_mem_pool_prefill(struct kbase_mem_pool *pool);
+
+/**
+ * kbase_mem_pool_prefill_init - Start the memory pool prefill thread
+ * @kbdev: Kbase device
+ *
+ * Return: 0 on success or a negative error code.
+ */
+int kbase_mem_pool_prefill_init(struct kbase_device *kbdev);
+
+/**
+ * kbase_mem_pool_prefill_term - Stop the memory pool prefill thread
+ * @kbdev: Kbase device
+ */
+void kbase_mem_pool_prefill_term(struct kbase_device *kbdev);
+
 /**
  * kbase_mem_pool_mark_dying - Mark that this pool is dying
  * @pool:     Memory pool
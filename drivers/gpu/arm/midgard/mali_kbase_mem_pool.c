@@ -27,6 +27,8 @@
 #include <linux/spinlock.h>
 #include <linux/shrinker.h>
 #include <linux/atomic.h>
+#include <linux/kthread.h>
+#include <linux/module.h>
 #include <linux/version.h>
 #if KERNEL_VERSION(4, 11, 0) <= LINUX_VERSION_CODE
 #include <linux/sched/signal.h>
@@ -41,6 +43,21 @@
 #define NOT_DIRTY false
 #define NOT_RECLAIMED false
 
+/* Number of pages the prefill thread adds to a pool between checks for
+ * termination of the pool or of the thread.
+ */
+#define KBASE_MEM_POOL_PREFILL_BATCH 32
+
+static unsigned int mem_pool_prefill_small_pages;
+module_param(mem_pool_prefill_small_pages, uint, 0644);
+MODULE_PARM_DESC(mem_pool_prefill_small_pages,
+		 "Small pages kept ready in the pool of each new context, 0 to disable.");
+
+static unsigned int mem_pool_prefill_large_pages;
+module_param(mem_pool_prefill_large_pages, uint, 0644);
+MODULE_PARM_DESC(mem_pool_prefill_large_pages,
+		 "2MB pages kept ready in the pool of each new context, 0 to disable.");
+
 /**
  * can_alloc_page() - Check if the current thread can allocate a physical page
  *
@@ -825,6 +842,171 @@ static unsigned long kbase_mem_pool_reclaim_scan_objects(struct shrinker *s,
 	return freed;
 }
 
+/**
+ * kbase_mem_pool_prefill_queue - Queue a pool to the prefill thread
+ *
+ * @pool: Pointer to the memory pool.
+ *
+ * Can be called with the pool lock held.
+ */
+static void kbase_mem_pool_prefill_queue(struct kbase_mem_pool *pool)
+{
+	struct kbase_mem_pool_prefill *prefill = &pool->kbdev->mem_pool_prefill;
+	bool queued = false;
+
+	spin_lock(&prefill->lock);
+	if (prefill->thread && !pool->dying && prefill->active != pool &&
+	    list_empty(&pool->prefill_link)) {
+		list_add_tail(&pool->prefill_link, &prefill->pools);
+		queued = true;
+	}
+	spin_unlock(&prefill->lock);
+
+	if (queued)
+		wake_up(&prefill->wq);
+}
+
+/**
+ * kbase_mem_pool_prefill_check - Request a refill if the pool is below its low watermark
+ *
+ * @pool: Pointer to the memory pool.
+ */
+static void kbase_mem_pool_prefill_check(struct kbase_mem_pool *pool)
+{
+	if (pool->prefill_target && kbase_mem_pool_size(pool) < pool->prefill_target / 2)
+		kbase_mem_pool_prefill_queue(pool);
+}
+
+/**
+ * kbase_mem_pool_prefill_drop - Stop prefilling a pool
+ *
+ * @pool: Pointer to the memory pool.
+ *
+ * Removes @pool from the prefill list and waits for the prefill thread to
+ * stop growing it, after which the thread no longer references the pool.
+ */
+static void kbase_mem_pool_prefill_drop(struct kbase_mem_pool *pool)
+{
+	struct kbase_mem_pool_prefill *prefill = &pool->kbdev->mem_pool_prefill;
+
+	spin_lock(&prefill->lock);
+	list_del_init(&pool->prefill_link);
+	spin_unlock(&prefill->lock);
+
+	wait_event(prefill->idle_wq, READ_ONCE(prefill->active) != pool);
+}
+
+static void kbase_mem_pool_prefill_grow(struct kbase_mem_pool *pool)
+{
+	size_t nr_to_grow;
+
+	while (!kthread_should_stop()) {
+		kbase_mem_pool_lock(pool);
+		if (pool->dying || kbase_mem_pool_size(pool) >= min(pool->prefill_target,
+								     pool->max_size)) {
+			kbase_mem_pool_unlock(pool);
+			break;
+		}
+		nr_to_grow = min(pool->prefill_target - kbase_mem_pool_size(pool),
+				 (size_t)KBASE_MEM_POOL_PREFILL_BATCH);
+		kbase_mem_pool_unlock(pool);
+
+		if (kbase_mem_pool_grow(pool, nr_to_grow, NULL))
+			break;
+
+		cond_resched();
+	}
+
+	pool_dbg(pool, "prefilled\n");
+}
+
+static int kbase_mem_pool_prefill_thread(void *data)
+{
+	struct kbase_device *kbdev = data;
+	struct kbase_mem_pool_prefill *prefill = &kbdev->mem_pool_prefill;
+	struct kbase_mem_pool *pool;
+
+	set_user_nice(current, MAX_NICE);
+
+	while (!kthread_should_stop()) {
+		wait_event_interruptible(prefill->wq,
+					 kthread_should_stop() || !list_empty(&prefill->pools));
+
+		spin_lock(&prefill->lock);
+		pool = list_first_entry_or_null(&prefill->pools, struct kbase_mem_pool,
+						prefill_link);
+		if (pool) {
+			list_del_init(&pool->prefill_link);
+			prefill->active = pool;
+		}
+		spin_unlock(&prefill->lock);
+
+		if (!pool)
+			continue;
+
+		kbase_mem_pool_prefill_grow(pool);
+
+		spin_lock(&prefill->lock);
+		prefill->active = NULL;
+		spin_unlock(&prefill->lock);
+		wake_up_all(&prefill->idle_wq);
+	}
+
+	return 0;
+}
+
+int kbase_mem_pool_prefill_init(struct kbase_device *kbdev)
+{
+	struct kbase_mem_pool_prefill *prefill = &kbdev->mem_pool_prefill;
+	struct task_struct *thread;
+
+	spin_lock_init(&prefill->lock);
+	INIT_LIST_HEAD(&prefill->pools);
+	prefill->active = NULL;
+	init_waitqueue_head(&prefill->wq);
+	init_waitqueue_head(&prefill->idle_wq);
+
+	thread = kthread_run(kbase_mem_pool_prefill_thread, kbdev, "mali-mem-pool-prefill");
+	if (IS_ERR(thread)) {
+		dev_err(kbdev->dev, "Failed to start memory pool prefill thread\n");
+		return PTR_ERR(thread);
+	}
+
+	spin_lock(&prefill->lock);
+	prefill->thread = thread;
+	spin_unlock(&prefill->lock);
+
+	return 0;
+}
+
+void kbase_mem_pool_prefill_term(struct kbase_device *kbdev)
+{
+	struct kbase_mem_pool_prefill *prefill = &kbdev->mem_pool_prefill;
+	struct task_struct *thread;
+
+	spin_lock(&prefill->lock);
+	thread = prefill->thread;
+	prefill->thread = NULL;
+	spin_unlock(&prefill->lock);
+
+	if (thread)
+		kthread_stop(thread);
+
+	WARN_ON(!list_empty(&prefill->pools));
+}
+
+void kbase_mem_pool_prefill(struct kbase_mem_pool *pool)
+{
+	size_t target = pool->order ? mem_pool_prefill_large_pages : mem_pool_prefill_small_pages;
+
+	if (pool->order && !kbase_is_large_pages_enabled())
+		target = 0;
+
+	pool->prefill_target = target;
+	kbase_mem_pool_prefill_check(pool);
+}
+KBASE_EXPORT_TEST_API(kbase_mem_pool_prefill);
+
 static int kbasep_mem_pool_init(struct kbase_mem_pool *pool, size_t max_size, unsigned int order,
 				int group_id, struct kbase_device *kbdev, bool support_reclaim)
 {
@@ -850,6 +1032,8 @@ static int kbasep_mem_pool_init(struct kbase_mem_pool *pool, size_t max_size, un
 	spin_lock_init(&pool->pool_lock);
 	INIT_LIST_HEAD(&pool->page_list);
 	INIT_LIST_HEAD(&pool->deferred_pages_list);
+	INIT_LIST_HEAD(&pool->prefill_link);
+	pool->prefill_target = 0;
 
 	if (support_reclaim) {
 		reclaim = KBASE_INIT_RECLAIM(pool, reclaim, "mali-mem-pool");
@@ -891,6 +1075,8 @@ void kbase_mem_pool_mark_dying(struct kbase_mem_pool *pool)
 	/* Remove the pool from pmode pages defer control */
 	kbase_csf_scheduler_pages_defer_ctrl_drop_pool(pool, false);
 	kbase_mem_pool_unlock(pool);
+
+	kbase_mem_pool_prefill_drop(pool);
 }
 KBASE_EXPORT_TEST_API(kbase_mem_pool_mark_dying);
 
@@ -908,6 +1094,8 @@ void kbase_mem_pool_term(struct kbase_mem_pool *pool)
 
 	pool_dbg(pool, "terminate()\n");
 
+	kbase_mem_pool_prefill_drop(pool);
+
 	if (pool->pool_supports_reclaim)
 		KBASE_UNREGISTER_SHRINKER(pool->reclaim);
 
@@ -984,6 +1172,7 @@ struct page *kbase_mem_pool_alloc(struct kbase_mem_pool *pool)
 
 	pool_dbg(pool, "alloc()\n");
 	p = kbase_mem_pool_remove(pool, ALLOCATE_IN_PROGRESS);
+	kbase_mem_pool_prefill_check(pool);
 
 	return p;
 }
@@ -1081,6 +1270,8 @@ int kbase_mem_pool_alloc_pages(struct kbase_mem_pool *pool, size_t nr_small_page
 	}
 	kbase_mem_pool_unlock(pool);
 
+	kbase_mem_pool_prefill_check(pool);
+
 	/* Get any remaining pages from kernel */
 	while (i != nr_small_pages) {
 		if (unlikely(!can_alloc_page(pool, page_owner)))
@@ -1156,6 +1347,8 @@ int kbase_mem_pool_alloc_pages_locked(struct kbase_mem_pool *pool, size_t nr_sma
 		}
 	}
 
+	kbase_mem_pool_prefill_check(pool);
+
 	return nr_small_pages;
 }
 KBASE_EXPORT_TEST_API(kbase_mem_pool_alloc_pages_locked);
@@ -63,6 +63,12 @@ int kbase_mem_pool_group_init(struct kbase_mem_pool_group *const mem_pools,
 	return err;
 }
 
+void kbase_mem_pool_group_prefill(struct kbase_mem_pool_group *const mem_pools)
+{
+	kbase_mem_pool_prefill(&mem_pools->small[0]);
+	kbase_mem_pool_prefill(&mem_pools->large[0]);
+}
+
 void kbase_mem_pool_group_mark_dying(struct kbase_mem_pool_group *const mem_pools)
 {
 	int gid;
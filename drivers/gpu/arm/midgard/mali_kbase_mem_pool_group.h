@@ -52,6 +52,16 @@ int kbase_mem_pool_group_init(struct kbase_mem_pool_group *mem_pools, struct kba
 			      size_t small_max_size, size_t large_max_size,
 			      struct kbase_mem_pool_group *next_pools);
 
+/**
+ * kbase_mem_pool_group_prefill - Prefill a set of memory pools
+ *
+ * @mem_pools: Set of memory pools to prefill
+ *
+ * Queues the small and large pools of memory group 0, which backs default
+ * allocations, to be filled in the background. See kbase_mem_pool_prefill().
+ */
+void kbase_mem_pool_group_prefill(struct kbase_mem_pool_group *mem_pools);
+
 /**
  * kbase_mem_pool_group_mark_dying - Mark a set of memory pools as dying
  *
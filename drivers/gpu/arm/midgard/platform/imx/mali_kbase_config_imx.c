@@ -93,9 +93,22 @@ static void platform_term_func(struct kbase_device *kbdev)
 
 	devm_kfree(kbdev->dev, ictx);
 }
+
+static int platform_late_init_func(struct kbase_device *kbdev)
+{
+	return imx_devfreq_boost_init(kbdev);
+}
+
+static void platform_late_term_func(struct kbase_device *kbdev)
+{
+	imx_devfreq_boost_term(kbdev);
+}
+
 struct kbase_platform_funcs_conf platform_funcs = {
 	.platform_init_func = &platform_init_func,
 	.platform_term_func = &platform_term_func,
+	.platform_late_init_func = &platform_late_init_func,
+	.platform_late_term_func = &platform_late_term_func,
 };
 
 int imx_waveform_start(struct kbase_device *kbdev)
@@ -48,6 +48,9 @@ extern struct kbase_platform_funcs_conf platform_funcs;
  */
 #define AUTO_SUSPEND_DELAY (100)
 
+#include <linux/pm_qos.h>
+#include <linux/workqueue.h>
+
 struct imx_platform_ctx {
 	struct kbase_device *kbdev;
 //#ifdef IMX_GPU_BLK_CTRL
@@ -56,7 +59,22 @@ struct imx_platform_ctx {
 //#endif
 	void __iomem *reg_tcm;
 	int dumpStarted;
+#if defined(CONFIG_MALI_DEVFREQ) && defined(CONFIG_PM)
+	/* devfreq occupancy boost, see mali_kbase_devfreq_imx.c */
+	struct dev_pm_qos_request boost_min_req;
+	struct dev_pm_qos_request boost_max_req;
+	struct delayed_work boost_work;
+	s32 boost_min_khz;
+	s32 boost_max_khz;
+	unsigned int boost_idle_polls;
+	bool boost_ready;
+	bool boost_powered;
+#endif
 };
 
 int imx_waveform_start(struct kbase_device *kbdev);
 int imx_waveform_stop(struct kbase_device *kbdev);
+
+int imx_devfreq_boost_init(struct kbase_device *kbdev);
+void imx_devfreq_boost_term(struct kbase_device *kbdev);
+void imx_devfreq_boost_power(struct kbase_device *kbdev, bool powered);
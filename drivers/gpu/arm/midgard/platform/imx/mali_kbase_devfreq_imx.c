@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note
+/*
+ *
+ * COPYRIGHT 2026 NXP
+ *
+ * This program is free software and is provided to you under the terms of the
+ * GNU General Public License version 2 as published by the Free Software
+ * Foundation, and any use by you of this program is subject to the terms
+ * of such GNU license.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can access it online at
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ */
+
+/*
+ * CSF occupancy input for GPU devfreq.
+ *
+ * The devfreq governor only sees utilization averaged over its polling
+ * period, so it reacts a period late both when work piles up and when the
+ * GPU runs dry. While the GPU is powered, sample the number of command
+ * stream groups resident on CSG slots every few milliseconds and steer the
+ * governor through PM QoS frequency requests on the GPU device:
+ *
+ *  - several resident groups means queued work is competing for the GPU,
+ *    so request the highest OPP until occupancy drops again;
+ *  - no resident group for a couple of samples means the queues are empty,
+ *    so cap at the lowest OPP until work arrives.
+ *
+ * In between, the requests are relaxed and the governor decides.
+ */
+
+#include <mali_kbase.h>
+#include <linux/module.h>
+#include <linux/pm_qos.h>
+#include <linux/workqueue.h>
+
+#include "mali_kbase_config_platform.h"
+
+#if defined(CONFIG_MALI_DEVFREQ) && defined(CONFIG_PM)
+
+#define IMX_BOOST_POLL_MS (8)
+#define IMX_BOOST_IDLE_POLLS (2)
+
+static bool devfreq_occupancy_boost = true;
+module_param(devfreq_occupancy_boost, bool, 0644);
+MODULE_PARM_DESC(devfreq_occupancy_boost,
+		 "Raise GPU frequency when CSF groups queue up and drop it when they drain");
+
+static unsigned int devfreq_boost_csgs = 2;
+module_param(devfreq_boost_csgs, uint, 0644);
+MODULE_PARM_DESC(devfreq_boost_csgs, "Number of resident CSF groups that requests the highest OPP");
+
+static void imx_boost_set(struct imx_platform_ctx *ictx, s32 min_khz, s32 max_khz)
+{
+	if (ictx->boost_min_khz != min_khz) {
+		dev_pm_qos_update_request(&ictx->boost_min_req, min_khz);
+		ictx->boost_min_khz = min_khz;
+	}
+
+	if (ictx->boost_max_khz != max_khz) {
+		dev_pm_qos_update_request(&ictx->boost_max_req, max_khz);
+		ictx->boost_max_khz = max_khz;
+	}
+}
+
+static void imx_boost_worker(struct work_struct *work)
+{
+	struct imx_platform_ctx *ictx =
+		container_of(work, struct imx_platform_ctx, boost_work.work);
+	s32 min_khz = PM_QOS_MIN_FREQUENCY_DEFAULT_VALUE;
+	s32 max_khz = PM_QOS_MAX_FREQUENCY_DEFAULT_VALUE;
+	u32 nr_csgs;
+
+	if (!READ_ONCE(ictx->boost_powered) || !devfreq_occupancy_boost) {
+		ictx->boost_idle_polls = 0;
+		imx_boost_set(ictx, min_khz, max_khz);
+		return;
+	}
+
+	nr_csgs = kbase_csf_scheduler_get_nr_active_csgs(ictx->kbdev);
+
+	if (nr_csgs)
+		ictx->boost_idle_polls = 0;
+	else if (ictx->boost_idle_polls < IMX_BOOST_IDLE_POLLS)
+		ictx->boost_idle_polls++;
+
+	if (devfreq_boost_csgs && nr_csgs >= devfreq_boost_csgs)
+		min_khz = FREQ_QOS_MAX_DEFAULT_VALUE;
+	else if (ictx->boost_idle_polls >= IMX_BOOST_IDLE_POLLS)
+		max_khz = 1; /* clamped up to the lowest OPP */
+
+	imx_boost_set(ictx, min_khz, max_khz);
+
+	queue_delayed_work(system_highpri_wq, &ictx->boost_work,
+			   msecs_to_jiffies(IMX_BOOST_POLL_MS));
+}
+
+int imx_devfreq_boost_init(struct kbase_device *kbdev)
+{
+	struct imx_platform_ctx *ictx = kbdev->platform_context;
+	int err;
+
+	if (!kbdev->devfreq)
+		return 0;
+
+	ictx->boost_min_khz = PM_QOS_MIN_FREQUENCY_DEFAULT_VALUE;
+	err = dev_pm_qos_add_request(kbdev->dev, &ictx->boost_min_req,
+				     DEV_PM_QOS_MIN_FREQUENCY, ictx->boost_min_khz);
+	if (err < 0)
+		goto fail;
+
+	ictx->boost_max_khz = PM_QOS_MAX_FREQUENCY_DEFAULT_VALUE;
+	err = dev_pm_qos_add_request(kbdev->dev, &ictx->boost_max_req,
+				     DEV_PM_QOS_MAX_FREQUENCY, ictx->boost_max_khz);
+	if (err < 0) {
+		dev_pm_qos_remove_request(&ictx->boost_min_req);
+		goto fail;
+	}
+
+	INIT_DELAYED_WORK(&ictx->boost_work, imx_boost_worker);
+	WRITE_ONCE(ictx->boost_ready, true);
+
+	/* The GPU may already be powered, start sampling right away */
+	imx_devfreq_boost_power(kbdev, true);
+
+	return 0;
+
+fail:
+	dev_warn(kbdev->dev, "devfreq occupancy boost disabled: %d\n", err);
+	return 0;
+}
+
+void imx_devfreq_boost_term(struct kbase_device *kbdev)
+{
+	struct imx_platform_ctx *ictx = kbdev->platform_context;
+
+	if (!READ_ONCE(ictx->boost_ready))
+		return;
+
+	WRITE_ONCE(ictx->boost_ready, false);
+	cancel_delayed_work_sync(&ictx->boost_work);
+	dev_pm_qos_remove_request(&ictx->boost_max_req);
+	dev_pm_qos_remove_request(&ictx->boost_min_req);
+}
+
+void imx_devfreq_boost_power(struct kbase_device *kbdev, bool powered)
+{
+	struct imx_platform_ctx *ictx = kbdev->platform_context;
+
+	if (!ictx || !READ_ONCE(ictx->boost_ready))
+		return;
+
+	/* The worker relaxes the requests and stops once powered is cleared */
+	WRITE_ONCE(ictx->boost_powered, powered);
+	mod_delayed_work(system_highpri_wq, &ictx->boost_work, 0);
+}
+
+#else
+
+int imx_devfreq_boost_init(struct kbase_device *kbdev)
+{
+	CSTD_UNUSED(kbdev);
+	return 0;
+}
+
+void imx_devfreq_boost_term(struct kbase_device *kbdev)
+{
+	CSTD_UNUSED(kbdev);
+}
+
+void imx_devfreq_boost_power(struct kbase_device *kbdev, bool powered)
+{
+	CSTD_UNUSED(kbdev);
+	CSTD_UNUSED(powered);
+}
+
+#endif /* CONFIG_MALI_DEVFREQ && CONFIG_PM */
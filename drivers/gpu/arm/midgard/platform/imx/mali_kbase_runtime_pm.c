@@ -123,6 +123,8 @@ static int pm_callback_power_on(struct kbase_device *kbdev)
 	enable_gpu_power_control(kbdev);
 	CSTD_UNUSED(error);
 
+	imx_devfreq_boost_power(kbdev, true);
+
 	return ret;
 }
 
@@ -143,6 +145,8 @@ static void pm_callback_power_off(struct kbase_device *kbdev)
 	spin_unlock_irqrestore(&kbdev->hwaccess_lock, flags);
 #endif
 
+	imx_devfreq_boost_power(kbdev, false);
+
 	/* Power down the GPU immediately */
 	disable_gpu_power_control(kbdev);
 
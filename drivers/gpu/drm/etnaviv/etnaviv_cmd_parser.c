@@ -4,6 +4,8 @@
  */
 
 #include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/string.h>
 
 #include "etnaviv_gem.h"
 #include "etnaviv_gpu.h"
@@ -205,3 +207,106 @@ bool etnaviv_cmd_validate_one(struct etnaviv_gpu *gpu, u32 *stream,
 
 	return true;
 }
+
+void etnaviv_cmd_cache_init(struct etnaviv_cmd_cache *cache)
+{
+	mutex_init(&cache->lock);
+	cache->valid = false;
+	cache->stream = NULL;
+	cache->stream_alloc = 0;
+	cache->reloc_offsets = NULL;
+	cache->reloc_alloc = 0;
+}
+
+void etnaviv_cmd_cache_fini(struct etnaviv_cmd_cache *cache)
+{
+	kvfree(cache->stream);
+	kvfree(cache->reloc_offsets);
+	mutex_destroy(&cache->lock);
+}
+
+/*
+ * The parser only looks at command headers and at the state offsets that
+ * relocations are applied to, never at which BO a relocation points to. A
+ * stream identical to the cached one, with relocations at the same offsets,
+ * therefore validates the same way. The comparison is done on the full
+ * stream, rather than on a hash, as the parser is what keeps userspace away
+ * from physical addresses on MMUv1.
+ */
+static bool etnaviv_cmd_cache_match(struct etnaviv_cmd_cache *cache,
+				    u32 *stream, unsigned int size,
+				    struct drm_etnaviv_gem_submit_reloc *relocs,
+				    unsigned int reloc_size)
+{
+	unsigned int i;
+
+	if (!cache->valid || cache->size != size ||
+	    cache->nr_relocs != reloc_size)
+		return false;
+
+	for (i = 0; i < reloc_size; i++)
+		if (cache->reloc_offsets[i] != relocs[i].submit_offset)
+			return false;
+
+	return !memcmp(cache->stream, stream, size * 4);
+}
+
+static void etnaviv_cmd_cache_store(struct etnaviv_cmd_cache *cache,
+				    u32 *stream, unsigned int size,
+				    struct drm_etnaviv_gem_submit_reloc *relocs,
+				    unsigned int reloc_size)
+{
+	unsigned int i;
+
+	cache->valid = false;
+
+	if (size > cache->stream_alloc) {
+		kvfree(cache->stream);
+		cache->stream = kvmalloc_array(size, sizeof(u32), GFP_KERNEL);
+		cache->stream_alloc = cache->stream ? size : 0;
+		if (!cache->stream)
+			return;
+	}
+
+	if (reloc_size > cache->reloc_alloc) {
+		kvfree(cache->reloc_offsets);
+		cache->reloc_offsets = kvmalloc_array(reloc_size, sizeof(u32),
+						      GFP_KERNEL);
+		cache->reloc_alloc = cache->reloc_offsets ? reloc_size : 0;
+		if (!cache->reloc_offsets)
+			return;
+	}
+
+	memcpy(cache->stream, stream, size * 4);
+	for (i = 0; i < reloc_size; i++)
+		cache->reloc_offsets[i] = relocs[i].submit_offset;
+
+	cache->size = size;
+	cache->nr_relocs = reloc_size;
+	cache->valid = true;
+}
+
+bool etnaviv_cmd_validate_cached(struct etnaviv_cmd_cache *cache,
+				 struct etnaviv_gpu *gpu, u32 *stream,
+				 unsigned int size,
+				 struct drm_etnaviv_gem_submit_reloc *relocs,
+				 unsigned int reloc_size)
+{
+	bool hit;
+
+	mutex_lock(&cache->lock);
+	hit = etnaviv_cmd_cache_match(cache, stream, size, relocs, reloc_size);
+	mutex_unlock(&cache->lock);
+
+	if (hit)
+		return true;
+
+	if (!etnaviv_cmd_validate_one(gpu, stream, size, relocs, reloc_size))
+		return false;
+
+	mutex_lock(&cache->lock);
+	etnaviv_cmd_cache_store(cache, stream, size, relocs, reloc_size);
+	mutex_unlock(&cache->lock);
+
+	return true;
+}
@@ -91,6 +91,8 @@ static int etnaviv_open(struct drm_device *dev, struct drm_file *file)
 					      DRM_SCHED_PRIORITY_NORMAL, &sched,
 					      1, NULL);
 		}
+
+		etnaviv_cmd_cache_init(&ctx->cmd_cache[i]);
 	}
 
 	file->driver_priv = ctx;
@@ -113,6 +115,8 @@ static void etnaviv_postclose(struct drm_device *dev, struct drm_file *file)
 
 		if (gpu)
 			drm_sched_entity_destroy(&ctx->sched_entity[i]);
+
+		etnaviv_cmd_cache_fini(&ctx->cmd_cache[i]);
 	}
 
 	etnaviv_iommu_context_put(ctx->mmu);
@@ -253,9 +257,17 @@ static struct drm_info_list etnaviv_debugfs_list[] = {
 
 static void etnaviv_debugfs_init(struct drm_minor *minor)
 {
+	struct etnaviv_drm_private *priv = minor->dev->dev_private;
+	unsigned int i;
+
 	drm_debugfs_create_files(etnaviv_debugfs_list,
 				 ARRAY_SIZE(etnaviv_debugfs_list),
 				 minor->debugfs_root, minor);
+
+	for (i = 0; i < ETNA_MAX_PIPES; i++)
+		if (priv->gpu[i])
+			etnaviv_pm_sampler_debugfs_init(priv->gpu[i],
+							minor->debugfs_root, i);
 }
 #endif
 
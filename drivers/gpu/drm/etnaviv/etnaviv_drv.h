@@ -9,6 +9,7 @@
 #include <linux/io.h>
 #include <linux/list.h>
 #include <linux/mm_types.h>
+#include <linux/mutex.h>
 #include <linux/sizes.h>
 #include <linux/time64.h>
 #include <linux/types.h>
@@ -28,10 +29,25 @@ struct etnaviv_iommu_global;
 
 #define ETNAVIV_SOFTPIN_START_ADDRESS	SZ_4M /* must be >= SUBALLOC_SIZE */
 
+/*
+ * Last command stream that passed validation on a pipe, so that streams
+ * resubmitted unchanged (apart from the relocation targets) can skip the
+ * command parser.
+ */
+struct etnaviv_cmd_cache {
+	struct mutex lock;
+	bool valid;
+	u32 *stream;
+	unsigned int size, stream_alloc;
+	u32 *reloc_offsets;
+	unsigned int nr_relocs, reloc_alloc;
+};
+
 struct etnaviv_file_private {
 	int id;
 	struct etnaviv_iommu_context	*mmu;
 	struct drm_sched_entity		sched_entity[ETNA_MAX_PIPES];
+	struct etnaviv_cmd_cache	cmd_cache[ETNA_MAX_PIPES];
 };
 
 struct etnaviv_drm_private {
@@ -81,6 +97,11 @@ void etnaviv_validate_init(void);
 bool etnaviv_cmd_validate_one(struct etnaviv_gpu *gpu,
 	u32 *stream, unsigned int size,
 	struct drm_etnaviv_gem_submit_reloc *relocs, unsigned int reloc_size);
+bool etnaviv_cmd_validate_cached(struct etnaviv_cmd_cache *cache,
+	struct etnaviv_gpu *gpu, u32 *stream, unsigned int size,
+	struct drm_etnaviv_gem_submit_reloc *relocs, unsigned int reloc_size);
+void etnaviv_cmd_cache_init(struct etnaviv_cmd_cache *cache);
+void etnaviv_cmd_cache_fini(struct etnaviv_cmd_cache *cache);
 
 #ifdef CONFIG_DEBUG_FS
 void etnaviv_gem_describe_objects(struct etnaviv_drm_private *priv,
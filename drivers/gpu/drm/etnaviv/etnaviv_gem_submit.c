@@ -544,8 +544,9 @@ int etnaviv_ioctl_gem_submit(struct drm_device *dev, void *data,
 		goto err_submit_job;
 
 	if ((priv->mmu_global->version != ETNAVIV_IOMMU_V2) &&
-	    !etnaviv_cmd_validate_one(gpu, stream, args->stream_size / 4,
-				      relocs, args->nr_relocs)) {
+	    !etnaviv_cmd_validate_cached(&ctx->cmd_cache[args->pipe], gpu,
+					 stream, args->stream_size / 4,
+					 relocs, args->nr_relocs)) {
 		ret = -EINVAL;
 		goto err_submit_job;
 	}
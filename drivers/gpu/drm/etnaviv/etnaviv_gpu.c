@@ -1813,6 +1813,8 @@ static void etnaviv_gpu_unbind(struct device *dev, struct device *master,
 
 	DBG("%s", dev_name(gpu->dev));
 
+	etnaviv_pm_sampler_fini(gpu);
+
 	destroy_workqueue(gpu->wq);
 
 	etnaviv_sched_fini(gpu);
@@ -108,6 +108,7 @@ enum etnaviv_gpu_state {
 struct etnaviv_gpu {
 	struct drm_device *drm;
 	struct thermal_cooling_device *cooling;
+	struct etnaviv_pm_sampler *pm_sampler;
 	struct device *dev;
 	struct mutex lock;
 	struct etnaviv_chip_identity identity;
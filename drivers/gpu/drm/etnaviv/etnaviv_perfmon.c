@@ -4,6 +4,14 @@
  * Copyright (C) 2017 Zodiac Inflight Innovations
  */
 
+#include <linux/debugfs.h>
+#include <linux/kref.h>
+#include <linux/mm.h>
+#include <linux/pm_runtime.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
 #include "common.xml.h"
 #include "etnaviv_gpu.h"
 #include "etnaviv_perfmon.h"
@@ -581,3 +589,346 @@ void etnaviv_perfmon_process(struct etnaviv_gpu *gpu,
 
 	*(bo + pmr->offset) = val;
 }
+
+#ifdef CONFIG_DEBUG_FS
+/*
+ * Periodic sampling: a debugfs file per GPU snapshots a set of signals at
+ * a fixed interval into a ring buffer that can be mmap()ed, so counters can
+ * be watched under load without perfmon requests in the command streams.
+ *
+ * Writing "<interval_ms> <domain>:<signal> ..." (domain and signal ids as
+ * returned by the PM_QUERY_DOM/PM_QUERY_SIG ioctls) starts sampling,
+ * writing "stop" stops it. The mapping starts with a struct
+ * etnaviv_pm_sampler_header, followed by nr_records records of record_size
+ * bytes: a struct etnaviv_pm_sampler_record and one u32 value per signal.
+ * Record n is stored at index n % nr_records, and head is the number of
+ * records written so far, updated after the record.
+ */
+#define ETNAVIV_PM_SAMPLER_SIZE		SZ_256K
+#define ETNAVIV_PM_SAMPLER_MAX_SIGNALS	32
+
+struct etnaviv_pm_sampler_header {
+	u32 version;
+	u32 interval_ms;
+	u32 nr_signals;
+	u32 record_size;
+	u32 nr_records;
+	u32 head;
+	struct {
+		u8 domain;
+		u8 signal;
+		u16 pad;
+	} signals[ETNAVIV_PM_SAMPLER_MAX_SIGNALS];
+};
+
+/* flags */
+#define ETNAVIV_PM_SAMPLE_IDLE	BIT(0)	/* GPU suspended, values are 0 */
+
+struct etnaviv_pm_sampler_record {
+	u64 timestamp_ns;
+	u32 flags;
+	u32 pad;
+	u32 values[];
+};
+
+struct etnaviv_pm_sampler {
+	struct kref refcount;
+	struct etnaviv_gpu *gpu;
+	struct mutex lock;
+	struct delayed_work work;
+	bool running;
+
+	const struct etnaviv_pm_domain *domains[ETNAVIV_PM_SAMPLER_MAX_SIGNALS];
+	const struct etnaviv_pm_signal *signals[ETNAVIV_PM_SAMPLER_MAX_SIGNALS];
+	struct etnaviv_pm_sampler_header *hdr;
+};
+
+static void etnaviv_pm_sampler_release(struct kref *kref)
+{
+	struct etnaviv_pm_sampler *s =
+		container_of(kref, struct etnaviv_pm_sampler, refcount);
+
+	vfree(s->hdr);
+	kfree(s);
+}
+
+static void etnaviv_pm_sampler_snapshot(struct etnaviv_pm_sampler *s,
+	struct etnaviv_pm_sampler_record *rec)
+{
+	struct etnaviv_gpu *gpu = s->gpu;
+	u32 clock, power, val;
+	unsigned int i;
+
+	rec->timestamp_ns = ktime_get_ns();
+	rec->flags = 0;
+
+	if (pm_runtime_get_if_in_use(gpu->dev) <= 0) {
+		rec->flags = ETNAVIV_PM_SAMPLE_IDLE;
+		memset(rec->values, 0, s->hdr->nr_signals * sizeof(u32));
+		return;
+	}
+
+	mutex_lock(&gpu->lock);
+
+	/* as in sync_point_perfmon_sample_pre(), but restore what was there */
+	power = gpu_read_power(gpu, VIVS_PM_POWER_CONTROLS);
+	gpu_write_power(gpu, VIVS_PM_POWER_CONTROLS,
+			power & ~VIVS_PM_POWER_CONTROLS_ENABLE_MODULE_CLOCK_GATING);
+	clock = gpu_read(gpu, VIVS_HI_CLOCK_CONTROL);
+	gpu_write(gpu, VIVS_HI_CLOCK_CONTROL,
+		  clock & ~VIVS_HI_CLOCK_CONTROL_DISABLE_DEBUG_REGISTERS);
+
+	for (i = 0; i < s->hdr->nr_signals; i++) {
+		const struct etnaviv_pm_signal *sig = s->signals[i];
+
+		val = sig->sample(gpu, s->domains[i], sig);
+		rec->values[i] = val;
+	}
+
+	gpu_write(gpu, VIVS_HI_CLOCK_CONTROL, clock);
+	gpu_write_power(gpu, VIVS_PM_POWER_CONTROLS, power);
+
+	mutex_unlock(&gpu->lock);
+
+	pm_runtime_put_autosuspend(gpu->dev);
+}
+
+static void etnaviv_pm_sampler_worker(struct work_struct *work)
+{
+	struct etnaviv_pm_sampler *s = container_of(to_delayed_work(work),
+					struct etnaviv_pm_sampler, work);
+	struct etnaviv_pm_sampler_header *hdr = s->hdr;
+	u32 head = hdr->head;
+
+	etnaviv_pm_sampler_snapshot(s, (void *)hdr + sizeof(*hdr) +
+				    (head % hdr->nr_records) * hdr->record_size);
+
+	smp_store_release(&hdr->head, head + 1);
+
+	schedule_delayed_work(&s->work, msecs_to_jiffies(hdr->interval_ms));
+}
+
+static void etnaviv_pm_sampler_stop(struct etnaviv_pm_sampler *s)
+{
+	lockdep_assert_held(&s->lock);
+
+	if (s->running) {
+		cancel_delayed_work_sync(&s->work);
+		s->running = false;
+	}
+}
+
+static int etnaviv_pm_sampler_start(struct etnaviv_pm_sampler *s, char *buf)
+{
+	u8 ids[ETNAVIV_PM_SAMPLER_MAX_SIGNALS][2];
+	struct etnaviv_pm_sampler_header *hdr;
+	unsigned int interval, dom_id, sig_id, i, n = 0;
+	const struct etnaviv_pm_domain *dom;
+	char *tok;
+
+	lockdep_assert_held(&s->lock);
+
+	tok = strsep(&buf, " \t\n");
+	if (!tok || kstrtouint(tok, 0, &interval) || !interval)
+		return -EINVAL;
+
+	etnaviv_pm_sampler_stop(s);
+
+	while ((tok = strsep(&buf, " \t\n"))) {
+		if (!*tok)
+			continue;
+
+		if (n == ETNAVIV_PM_SAMPLER_MAX_SIGNALS ||
+		    sscanf(tok, "%u:%u", &dom_id, &sig_id) != 2)
+			return -EINVAL;
+
+		if (dom_id >= num_pm_domains(s->gpu))
+			return -EINVAL;
+
+		dom = pm_domain(s->gpu, dom_id);
+		if (!dom || sig_id >= dom->nr_signals)
+			return -EINVAL;
+
+		s->domains[n] = dom;
+		s->signals[n] = &dom->signal[sig_id];
+		ids[n][0] = dom_id;
+		ids[n][1] = sig_id;
+		n++;
+	}
+
+	if (!n)
+		return -EINVAL;
+
+	if (!s->hdr) {
+		s->hdr = vmalloc_user(ETNAVIV_PM_SAMPLER_SIZE);
+		if (!s->hdr)
+			return -ENOMEM;
+	}
+
+	hdr = s->hdr;
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->version = 1;
+	hdr->interval_ms = interval;
+	hdr->nr_signals = n;
+	hdr->record_size = struct_size_t(struct etnaviv_pm_sampler_record,
+					 values, n);
+	hdr->nr_records = (ETNAVIV_PM_SAMPLER_SIZE - sizeof(*hdr)) /
+			  hdr->record_size;
+
+	for (i = 0; i < n; i++) {
+		hdr->signals[i].domain = ids[i][0];
+		hdr->signals[i].signal = ids[i][1];
+	}
+
+	s->running = true;
+	schedule_delayed_work(&s->work, 0);
+
+	return 0;
+}
+
+static int etnaviv_pm_sampler_show(struct seq_file *m, void *data)
+{
+	struct etnaviv_pm_sampler *s = m->private;
+	unsigned int i;
+
+	mutex_lock(&s->lock);
+
+	if (!s->running) {
+		seq_puts(m, "stopped\n");
+	} else {
+		seq_printf(m, "interval %u ms, %u records written\n",
+			   s->hdr->interval_ms, READ_ONCE(s->hdr->head));
+		for (i = 0; i < s->hdr->nr_signals; i++)
+			seq_printf(m, "%u:%u %s/%s\n", s->hdr->signals[i].domain,
+				   s->hdr->signals[i].signal,
+				   s->domains[i]->name, s->signals[i]->name);
+	}
+
+	mutex_unlock(&s->lock);
+
+	return 0;
+}
+
+static int etnaviv_pm_sampler_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, etnaviv_pm_sampler_show, inode->i_private);
+}
+
+static ssize_t etnaviv_pm_sampler_write(struct file *file,
+	const char __user *ubuf, size_t len, loff_t *offp)
+{
+	struct etnaviv_pm_sampler *s = file_inode(file)->i_private;
+	char *buf;
+	int ret = 0;
+
+	buf = memdup_user_nul(ubuf, min_t(size_t, len, PAGE_SIZE - 1));
+	if (IS_ERR(buf))
+		return PTR_ERR(buf);
+
+	mutex_lock(&s->lock);
+	if (!s->gpu)
+		ret = -ENODEV;
+	else if (sysfs_streq(buf, "stop"))
+		etnaviv_pm_sampler_stop(s);
+	else
+		ret = etnaviv_pm_sampler_start(s, buf);
+	mutex_unlock(&s->lock);
+
+	kfree(buf);
+
+	return ret ? ret : len;
+}
+
+static void etnaviv_pm_sampler_vm_open(struct vm_area_struct *vma)
+{
+	struct etnaviv_pm_sampler *s = vma->vm_private_data;
+
+	kref_get(&s->refcount);
+}
+
+static void etnaviv_pm_sampler_vm_close(struct vm_area_struct *vma)
+{
+	struct etnaviv_pm_sampler *s = vma->vm_private_data;
+
+	kref_put(&s->refcount, etnaviv_pm_sampler_release);
+}
+
+static const struct vm_operations_struct etnaviv_pm_sampler_vm_ops = {
+	.open = etnaviv_pm_sampler_vm_open,
+	.close = etnaviv_pm_sampler_vm_close,
+};
+
+static int etnaviv_pm_sampler_mmap(struct file *file,
+	struct vm_area_struct *vma)
+{
+	struct etnaviv_pm_sampler *s = file_inode(file)->i_private;
+	int ret;
+
+	if (vma->vm_flags & (VM_WRITE | VM_EXEC))
+		return -EPERM;
+
+	mutex_lock(&s->lock);
+	if (!s->hdr) {
+		ret = -ENODATA;
+	} else {
+		vm_flags_clear(vma, VM_MAYWRITE | VM_MAYEXEC);
+		ret = remap_vmalloc_range(vma, s->hdr, vma->vm_pgoff);
+	}
+	mutex_unlock(&s->lock);
+
+	if (ret)
+		return ret;
+
+	vma->vm_private_data = s;
+	vma->vm_ops = &etnaviv_pm_sampler_vm_ops;
+	etnaviv_pm_sampler_vm_open(vma);
+
+	return 0;
+}
+
+static const struct file_operations etnaviv_pm_sampler_fops = {
+	.owner = THIS_MODULE,
+	.open = etnaviv_pm_sampler_open,
+	.read = seq_read,
+	.write = etnaviv_pm_sampler_write,
+	.mmap = etnaviv_pm_sampler_mmap,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void etnaviv_pm_sampler_debugfs_init(struct etnaviv_gpu *gpu,
+	struct dentry *root, unsigned int pipe)
+{
+	struct etnaviv_pm_sampler *s;
+	char name[24];
+
+	s = kzalloc(sizeof(*s), GFP_KERNEL);
+	if (!s)
+		return;
+
+	kref_init(&s->refcount);
+	s->gpu = gpu;
+	mutex_init(&s->lock);
+	INIT_DELAYED_WORK(&s->work, etnaviv_pm_sampler_worker);
+	gpu->pm_sampler = s;
+
+	snprintf(name, sizeof(name), "perfmon_sampler%u", pipe);
+	debugfs_create_file(name, 0600, root, s, &etnaviv_pm_sampler_fops);
+}
+
+void etnaviv_pm_sampler_fini(struct etnaviv_gpu *gpu)
+{
+	struct etnaviv_pm_sampler *s = gpu->pm_sampler;
+
+	if (!s)
+		return;
+
+	mutex_lock(&s->lock);
+	etnaviv_pm_sampler_stop(s);
+	s->gpu = NULL;
+	mutex_unlock(&s->lock);
+
+	gpu->pm_sampler = NULL;
+	kref_put(&s->refcount, etnaviv_pm_sampler_release);
+}
+#endif /* CONFIG_DEBUG_FS */
@@ -7,6 +7,7 @@
 #ifndef __ETNAVIV_PERFMON_H__
 #define __ETNAVIV_PERFMON_H__
 
+struct dentry;
 struct etnaviv_gpu;
 struct drm_etnaviv_pm_domain;
 struct drm_etnaviv_pm_signal;
@@ -35,4 +36,14 @@ int etnaviv_pm_req_validate(const struct drm_etnaviv_gem_submit_pmr *r,
 void etnaviv_perfmon_process(struct etnaviv_gpu *gpu,
 	const struct etnaviv_perfmon_request *pmr, u32 exec_state);
 
+#ifdef CONFIG_DEBUG_FS
+void etnaviv_pm_sampler_debugfs_init(struct etnaviv_gpu *gpu,
+	struct dentry *root, unsigned int pipe);
+void etnaviv_pm_sampler_fini(struct etnaviv_gpu *gpu);
+#else
+static inline void etnaviv_pm_sampler_fini(struct etnaviv_gpu *gpu)
+{
+}
+#endif
+
 #endif /* __ETNAVIV_PERFMON_H__ */
@@ -89,10 +89,26 @@ static void etnaviv_sched_free_job(struct drm_sched_job *sched_job)
 	etnaviv_submit_put(submit);
 }
 
+/*
+ * The scheduler has room for one credit more than etnaviv_hw_jobs_limit jobs
+ * of two credits each. Jobs someone waits on with a deadline only take one,
+ * so a job the display is waiting for always finds room in the ring, even when
+ * it is filled up with background work.
+ */
+static u32 etnaviv_sched_update_job_credits(struct drm_sched_job *sched_job)
+{
+	if (test_bit(DRM_SCHED_FENCE_FLAG_HAS_DEADLINE_BIT,
+		     &sched_job->s_fence->finished.flags))
+		return 1;
+
+	return 2;
+}
+
 static const struct drm_sched_backend_ops etnaviv_sched_ops = {
 	.run_job = etnaviv_sched_run_job,
 	.timedout_job = etnaviv_sched_timedout_job,
 	.free_job = etnaviv_sched_free_job,
+	.update_job_credits = etnaviv_sched_update_job_credits,
 };
 
 int etnaviv_sched_push_job(struct etnaviv_gem_submit *submit)
@@ -135,7 +151,8 @@ int etnaviv_sched_init(struct etnaviv_gpu *gpu)
 
 	ret = drm_sched_init(&gpu->sched, &etnaviv_sched_ops, NULL,
 			     DRM_SCHED_PRIORITY_COUNT,
-			     etnaviv_hw_jobs_limit, etnaviv_job_hang_limit,
+			     etnaviv_hw_jobs_limit * 2 + 1,
+			     etnaviv_job_hang_limit,
 			     msecs_to_jiffies(500), NULL, NULL,
 			     dev_name(gpu->dev), gpu->dev);
 	if (ret)
@@ -450,6 +450,7 @@ static void dcif_crtc_queue_state_event(struct drm_crtc *crtc)
 		WARN_ON(dcif->event);
 		dcif->event = crtc->state->event;
 		crtc->state->event = NULL;
+		imx_drm_frame_stats_arm(&dcif->frame_stats, crtc);
 	}
 	spin_unlock_irq(&crtc->dev->event_lock);
 }
@@ -648,6 +649,13 @@ static void dcif_crtc_disable_vblank(struct drm_crtc *crtc)
 	regmap_clear_bits(dcif->regmap, DCIF_IS0(domain), DCIF_INT0_VS_BLANK);
 }
 
+static int dcif_crtc_late_register(struct drm_crtc *crtc)
+{
+	struct dcif_dev *dcif = crtc_to_dcif_dev(crtc);
+
+	return imx_drm_frame_stats_late_register(&dcif->frame_stats, crtc);
+}
+
 static const struct drm_crtc_funcs dcif_crtc_funcs = {
 	.reset			= dcif_crtc_reset,
 	.destroy		= drm_crtc_cleanup,
@@ -659,6 +667,7 @@ static const struct drm_crtc_funcs dcif_crtc_funcs = {
 	.disable_vblank		= dcif_crtc_disable_vblank,
 	.set_crc_source         = dcif_crtc_set_crc_source,
 	.verify_crc_source      = dcif_crtc_verify_crc_source,
+	.late_register		= dcif_crtc_late_register,
 };
 
 irqreturn_t dcif_irq_handler(int irq, void *data)
@@ -677,6 +686,8 @@ irqreturn_t dcif_irq_handler(int irq, void *data)
 
 		spin_lock_irqsave(&drm->event_lock, flags);
 		if (dcif->event) {
+			imx_drm_frame_stats_flip(&dcif->frame_stats,
+						 &dcif->crtc);
 			drm_crtc_send_vblank_event(&dcif->crtc, dcif->event);
 			dcif->event = NULL;
 			drm_crtc_vblank_put(&dcif->crtc);
@@ -713,6 +724,8 @@ int dcif_crtc_init(struct dcif_dev *dcif)
 	if (ret)
 		return ret;
 
+	imx_drm_frame_stats_init(&dcif->frame_stats);
+
 	drm_crtc_helper_add(&dcif->crtc, &dcif_crtc_helper_funcs);
 	ret = drm_crtc_init_with_planes(&dcif->drm, &dcif->crtc,
 					&dcif->planes.primary, NULL,
@@ -17,6 +17,8 @@
 #include <drm/drm_plane.h>
 #include <drm/drm_vblank.h>
 
+#include "imx-drm-frame-stats.h"
+
 struct dcif_crc;
 
 struct dcif_dev {
@@ -38,6 +40,7 @@ struct dcif_dev {
 	struct drm_encoder encoder;
 
 	struct drm_pending_vblank_event *event;
+	struct imx_drm_frame_stats frame_stats;
 	/* Implement crc */
 	bool			has_crc;
 	bool			crc_is_enabled;
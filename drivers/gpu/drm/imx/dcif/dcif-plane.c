@@ -230,6 +230,11 @@ static const struct drm_plane_helper_funcs dcif_overlay_plane_helper_funcs = {
 	.atomic_disable = dcif_overlay_plane_atomic_disable,
 };
 
+/*
+ * FB_DAMAGE_CLIPS is deliberately not exposed: DCIF only drives DPI video
+ * mode and refetches whole layers every frame, with no partial fetch window
+ * nor command mode output that damage could narrow down.
+ */
 static const struct drm_plane_funcs dcif_plane_funcs = {
 	.update_plane		= drm_atomic_helper_update_plane,
 	.disable_plane		= drm_atomic_helper_disable_plane,
@@ -5,8 +5,10 @@
  */
 
 #include <linux/clk.h>
+#include <linux/debugfs.h>
 #include <linux/irq.h>
 #include <linux/pm_runtime.h>
+#include <linux/seq_file.h>
 
 #include <drm/drm_atomic.h>
 #include <drm/drm_atomic_helper.h>
@@ -183,6 +185,30 @@ static void dcnano_crtc_set_pixel_clock(struct drm_crtc *crtc)
 			__func__, clk_get_rate(dcnano->pixel_clk));
 }
 
+/*
+ * Whether the DPI mode the bootloader left running is the one requested,
+ * allowing for the pixel clock rate the bootloader could get from the PLL.
+ */
+static bool dcnano_crtc_handover_matches(struct drm_crtc *crtc)
+{
+	struct dcnano_dev *dcnano = crtc_to_dcnano_dev(crtc);
+	const struct drm_display_mode *boot = &dcnano->handover_mode;
+	const struct drm_display_mode *adj = &crtc->state->adjusted_mode;
+	u32 pol = DRM_MODE_FLAG_NHSYNC | DRM_MODE_FLAG_NVSYNC;
+
+	return dcnano->port == DCNANO_DPI_PORT &&
+	       adj->crtc_hdisplay == boot->crtc_hdisplay &&
+	       adj->crtc_hsync_start == boot->crtc_hsync_start &&
+	       adj->crtc_hsync_end == boot->crtc_hsync_end &&
+	       adj->crtc_htotal == boot->crtc_htotal &&
+	       adj->crtc_vdisplay == boot->crtc_vdisplay &&
+	       adj->crtc_vsync_start == boot->crtc_vsync_start &&
+	       adj->crtc_vsync_end == boot->crtc_vsync_end &&
+	       adj->crtc_vtotal == boot->crtc_vtotal &&
+	       (adj->flags & pol) == (boot->flags & pol) &&
+	       abs(adj->crtc_clock - boot->crtc_clock) <= adj->crtc_clock / 200;
+}
+
 static enum drm_mode_status
 dcnano_crtc_mode_valid(struct drm_crtc *crtc,
 		       const struct drm_display_mode *mode)
@@ -206,6 +232,7 @@ static void dcnano_crtc_queue_state_event(struct drm_crtc *crtc)
 		WARN_ON(dcnano->event);
 		dcnano->event = crtc->state->event;
 		crtc->state->event = NULL;
+		imx_drm_frame_stats_arm(&dcnano->frame_stats, crtc);
 	}
 	spin_unlock_irq(&crtc->dev->event_lock);
 }
@@ -248,18 +275,44 @@ static void dcnano_crtc_atomic_enable(struct drm_crtc *crtc,
 	struct drm_plane *plane;
 	struct drm_plane_state *new_plane_state;
 	struct drm_display_mode *adj = &crtc->state->adjusted_mode;
-	int i;
+	int i, ret;
 	u32 primary_fb_fmt = 0;
 	u32 val;
+	bool adopt = false;
 
 	dcnano_crtc_dbg(crtc, "mode " DRM_MODE_FMT "\n", DRM_MODE_ARG(adj));
 
-	dcnano_crtc_set_pixel_clock(crtc);
+	/*
+	 * Adopt the pipe the bootloader left running if it already has the
+	 * requested mode: the pixel clock and the timings are left alone and
+	 * the primary plane update is the first change, a flip from the
+	 * splash screen.  Otherwise stop it before reprogramming them.
+	 */
+	if (dcnano->handover) {
+		adopt = dcnano_crtc_handover_matches(crtc);
+		if (!adopt)
+			dcnano_write(dcnano, DCNANO_FRAMEBUFFERCONFIG, 0);
+		dcnano_crtc_dbg(crtc, "%s the bootloader's display pipe\n",
+				adopt ? "adopting" : "resetting");
+	}
+
+	if (adopt) {
+		/* balanced by the disable in ->atomic_disable() */
+		ret = clk_prepare_enable(dcnano->pixel_clk);
+		if (ret)
+			dcnano_crtc_err(crtc,
+					"failed to enable pixel clock: %d\n",
+					ret);
+	} else {
+		dcnano_crtc_set_pixel_clock(crtc);
+	}
 
 	/* enable power when we start to set mode for CRTC */
 	pm_runtime_get_sync(drm->dev);
 
-	if (dcnano->port == DCNANO_DPI_PORT)
+	dcnano_handover_release(dcnano);
+
+	if (dcnano->port == DCNANO_DPI_PORT && !adopt)
 		dcnano_crtc_mode_set_nofb_dpi(crtc);
 
 	drm_crtc_vblank_on(crtc);
@@ -367,12 +420,24 @@ static const struct drm_crtc_helper_funcs dcnano_crtc_helper_funcs = {
 	.get_scanout_position	= dcnano_crtc_get_scanout_position,
 };
 
+static u32 dcnano_read_debug_counter(struct dcnano_dev *dcnano, u32 sel)
+{
+	unsigned long flags;
+	u32 val;
+
+	spin_lock_irqsave(&dcnano->dbgcnt_lock, flags);
+	dcnano_write(dcnano, DCNANO_DEBUGCOUNTERSELECT, sel);
+	val = dcnano_read(dcnano, DCNANO_DEBUGCOUNTERVALUE);
+	spin_unlock_irqrestore(&dcnano->dbgcnt_lock, flags);
+
+	return val;
+}
+
 static u32 dcnano_crtc_get_vblank_counter(struct drm_crtc *crtc)
 {
 	struct dcnano_dev *dcnano = crtc_to_dcnano_dev(crtc);
 
-	dcnano_write(dcnano, DCNANO_DEBUGCOUNTERSELECT, TOTAL_FRAME_CNT);
-	return dcnano_read(dcnano, DCNANO_DEBUGCOUNTERVALUE);
+	return dcnano_read_debug_counter(dcnano, TOTAL_FRAME_CNT);
 }
 
 static int dcnano_crtc_enable_vblank(struct drm_crtc *crtc)
@@ -391,6 +456,53 @@ static void dcnano_crtc_disable_vblank(struct drm_crtc *crtc)
 	dcnano_write(dcnano, DCNANO_DISPLAYINTRENABLE, 0);
 }
 
+/*
+ * The AXI read counters show how the scanout DMA hits DDR: few pixels per
+ * read burst mean DDR gets woken up more often than the frame needs.
+ */
+static int dcnano_crtc_axi_counters_show(struct seq_file *m, void *data)
+{
+	struct dcnano_dev *dcnano = m->private;
+	struct drm_device *drm = &dcnano->base;
+	u32 rd_req, rd_last, req_burst, rd_burst, pixel, frame;
+
+	if (pm_runtime_get_if_in_use(drm->dev) <= 0) {
+		seq_puts(m, "suspended\n");
+		return 0;
+	}
+
+	rd_req = dcnano_read_debug_counter(dcnano, TOTAL_AXI_RD_REQ_CNT);
+	rd_last = dcnano_read_debug_counter(dcnano, TOTAL_AXI_RD_LAST_CNT);
+	req_burst = dcnano_read_debug_counter(dcnano, TOTAL_AXI_REQ_BURST_CNT);
+	rd_burst = dcnano_read_debug_counter(dcnano, TOTAL_AXI_RD_BURST_CNT);
+	pixel = dcnano_read_debug_counter(dcnano, TOTAL_PIXEL_CNT);
+	frame = dcnano_read_debug_counter(dcnano, TOTAL_FRAME_CNT);
+
+	pm_runtime_put(drm->dev);
+
+	seq_printf(m, "axi read requests:\t%u\n", rd_req);
+	seq_printf(m, "axi read lasts:\t\t%u\n", rd_last);
+	seq_printf(m, "axi request bursts:\t%u\n", req_burst);
+	seq_printf(m, "axi read bursts:\t%u\n", rd_burst);
+	seq_printf(m, "pixels:\t\t\t%u\n", pixel);
+	seq_printf(m, "frames:\t\t\t%u\n", frame);
+	if (rd_burst)
+		seq_printf(m, "pixels per read burst:\t%u\n", pixel / rd_burst);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(dcnano_crtc_axi_counters);
+
+static int dcnano_crtc_late_register(struct drm_crtc *crtc)
+{
+	struct dcnano_dev *dcnano = crtc_to_dcnano_dev(crtc);
+
+	debugfs_create_file("axi_counters", 0444, crtc->debugfs_entry, dcnano,
+			    &dcnano_crtc_axi_counters_fops);
+
+	return imx_drm_frame_stats_late_register(&dcnano->frame_stats, crtc);
+}
+
 static const struct drm_crtc_funcs dcnano_crtc_funcs = {
 	.reset			= drm_atomic_helper_crtc_reset,
 	.destroy		= drm_crtc_cleanup,
@@ -402,6 +514,7 @@ static const struct drm_crtc_funcs dcnano_crtc_funcs = {
 	.enable_vblank		= dcnano_crtc_enable_vblank,
 	.disable_vblank		= dcnano_crtc_disable_vblank,
 	.get_vblank_timestamp	= drm_crtc_vblank_helper_get_vblank_timestamp,
+	.late_register		= dcnano_crtc_late_register,
 };
 
 irqreturn_t dcnano_irq_handler(int irq, void *data)
@@ -417,6 +530,7 @@ irqreturn_t dcnano_irq_handler(int irq, void *data)
 
 	spin_lock_irqsave(&drm->event_lock, flags);
 	if (dcnano->event) {
+		imx_drm_frame_stats_flip(&dcnano->frame_stats, &dcnano->crtc);
 		drm_crtc_send_vblank_event(&dcnano->crtc, dcnano->event);
 		dcnano->event = NULL;
 		drm_crtc_vblank_put(&dcnano->crtc);
@@ -469,6 +583,9 @@ int dcnano_crtc_init(struct dcnano_dev *dcnano)
 	if (ret)
 		return ret;
 
+	imx_drm_frame_stats_init(&dcnano->frame_stats);
+	spin_lock_init(&dcnano->dbgcnt_lock);
+
 	drm_crtc_helper_add(&dcnano->crtc, &dcnano_crtc_helper_funcs);
 	ret = drm_crtc_init_with_planes(&dcnano->base, &dcnano->crtc,
 					&dcnano->primary, NULL,
@@ -27,6 +27,11 @@
 static int legacyfb_depth = 32;
 module_param(legacyfb_depth, uint, 0444);
 
+static bool handover = true;
+module_param(handover, bool, 0444);
+MODULE_PARM_DESC(handover,
+		 "Adopt a display pipe left running by the bootloader (default: true)");
+
 DEFINE_DRM_GEM_DMA_FOPS(dcnano_driver_fops);
 
 static struct drm_driver dcnano_driver = {
@@ -79,6 +84,68 @@ static int dcnano_reset(struct dcnano_dev *dcnano)
 	return ret;
 }
 
+/*
+ * If the bootloader left the DPI output scanning out a splash screen, read
+ * its timings back and skip the reset, so that the first CRTC enable only
+ * has to flip to the new framebuffer when the mode is the same.
+ */
+static void dcnano_handover_init(struct dcnano_dev *dcnano)
+{
+	struct drm_display_mode *mode = &dcnano->handover_mode;
+	struct drm_device *drm = &dcnano->base;
+	u32 val;
+
+	if (!handover)
+		return;
+
+	pm_runtime_get_sync(drm->dev);
+
+	if (!(dcnano_read(dcnano, DCNANO_FRAMEBUFFERCONFIG) &
+	      FBCFG_OUTPUT_ENABLE) ||
+	    dcnano_read(dcnano, DCNANO_DBICONFIG) & DBICFG_BUS_OUTPUT_SEL_DBI) {
+		pm_runtime_put_sync(drm->dev);
+		return;
+	}
+
+	val = dcnano_read(dcnano, DCNANO_HDISPLAY);
+	mode->hdisplay = FIELD_GET(HDISPLAY_END_MASK, val);
+	mode->htotal = FIELD_GET(HDISPLAY_TOTAL_MASK, val);
+
+	val = dcnano_read(dcnano, DCNANO_HSYNC);
+	mode->hsync_start = FIELD_GET(HSYNC_START_MASK, val);
+	mode->hsync_end = FIELD_GET(HSYNC_END_MASK, val);
+	mode->flags |= val & HSYNC_POL_NEGATIVE ? DRM_MODE_FLAG_NHSYNC :
+						  DRM_MODE_FLAG_PHSYNC;
+
+	val = dcnano_read(dcnano, DCNANO_VDISPLAY);
+	mode->vdisplay = FIELD_GET(VDISPLAY_END_MASK, val);
+	mode->vtotal = FIELD_GET(VDISPLAY_TOTAL_MASK, val);
+
+	val = dcnano_read(dcnano, DCNANO_VSYNC);
+	mode->vsync_start = FIELD_GET(VSYNC_START_MASK, val);
+	mode->vsync_end = FIELD_GET(VSYNC_END_MASK, val);
+	mode->flags |= val & VSYNC_POL_NEGATIVE ? DRM_MODE_FLAG_NVSYNC :
+						  DRM_MODE_FLAG_PVSYNC;
+
+	mode->clock = clk_get_rate(dcnano->pixel_clk) / 1000;
+	drm_mode_set_crtcinfo(mode, 0);
+
+	dcnano->handover = true;
+
+	DRM_DEV_INFO(drm->dev, "display left running by the bootloader: "
+		     DRM_MODE_FMT "\n", DRM_MODE_ARG(mode));
+}
+
+/* Drops the runtime PM reference that kept the bootloader's pipe running */
+void dcnano_handover_release(struct dcnano_dev *dcnano)
+{
+	if (!dcnano->handover)
+		return;
+
+	dcnano->handover = false;
+	pm_runtime_put_sync(dcnano->base.dev);
+}
+
 static int dcnano_irq_install(struct drm_device *dev, int irq)
 {
 	if (irq == IRQ_NOTCONNECTED)
@@ -202,9 +269,13 @@ static int dcnano_probe(struct platform_device *pdev)
 		goto err_reset_get;
 	}
 
-	ret = dcnano_reset(dcnano);
-	if (ret)
-		goto err_dcnano_reset;
+	dcnano_handover_init(dcnano);
+
+	if (!dcnano->handover) {
+		ret = dcnano_reset(dcnano);
+		if (ret)
+			goto err_dcnano_reset;
+	}
 
 	pm_runtime_get_sync(drm->dev);
 	ret = dcnano_irq_install(drm, dcnano->irq);
@@ -249,6 +320,7 @@ static int dcnano_probe(struct platform_device *pdev)
 	dcnano_irq_uninstall(drm);
 	pm_runtime_put_sync(drm->dev);
 err_irq_install:
+	dcnano_handover_release(dcnano);
 err_dcnano_reset:
 err_reset_get:
 	pm_runtime_disable(drm->dev);
@@ -270,6 +342,8 @@ static void dcnano_remove(struct platform_device *pdev)
 	dcnano_irq_uninstall(drm);
 	pm_runtime_put_sync(drm->dev);
 
+	dcnano_handover_release(dcnano);
+
 	pm_runtime_disable(drm->dev);
 }
 
@@ -18,6 +18,8 @@
 #include <drm/drm_plane.h>
 #include <drm/drm_vblank.h>
 
+#include "imx-drm-frame-stats.h"
+
 enum dcnano_port {
 	DCNANO_DPI_PORT,
 	DCNANO_DBI_PORT,
@@ -42,8 +44,19 @@ struct dcnano_dev {
 	struct drm_encoder encoder;
 
 	struct drm_pending_vblank_event *event;
+	struct imx_drm_frame_stats frame_stats;
+
+	/* serializes DEBUGCOUNTERSELECT/DEBUGCOUNTERVALUE accesses */
+	spinlock_t dbgcnt_lock;
 
 	enum dcnano_port port;
+
+	/*
+	 * The DPI mode the bootloader left running, kept running with a
+	 * runtime PM reference until the first CRTC enable adopts it.
+	 */
+	bool handover;
+	struct drm_display_mode handover_mode;
 };
 
 static inline struct dcnano_dev *to_dcnano_dev(struct drm_device *drm)
@@ -55,6 +68,8 @@ irqreturn_t dcnano_irq_handler(int irq, void *data);
 
 int dcnano_crtc_init(struct dcnano_dev *dcnano);
 
+void dcnano_handover_release(struct dcnano_dev *dcnano);
+
 int dcnano_plane_init(struct dcnano_dev *dcnano);
 
 int dcnano_kms_prepare(struct dcnano_dev *dcnano);
@@ -15,22 +15,55 @@
 #include <drm/drm_vblank.h>
 #include <drm/drm_print.h>
 #include <drm/drm_drv.h>
+#include <drm/drm_file.h>
 #include <drm/drm_ioctl.h>
+#include <drm/gpu_scheduler.h>
 #include <drm/imx_drm.h>
 #include <linux/component.h>
 #include <linux/device.h>
 #include <linux/dma-buf.h>
+#include <linux/dma-fence-array.h>
 #include <linux/errno.h>
 #include <linux/export.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
+#include <linux/slab.h>
+#include <linux/sync_file.h>
 #include <video/dpu.h>
 
 #include "imx-drm.h"
+#include "dpu-blit.h"
+
+#define IMX_DRM_DPU_MAX_BLITENG		2
+/* matches the command sequencer FIFO space threshold */
+#define IMX_DRM_DPU_MAX_CMD_NR		192
+#define IMX_DRM_DPU_JOBS_IN_FLIGHT	2
+#define IMX_DRM_DPU_JOB_TIMEOUT_MS	500
 
 struct imx_drm_dpu_bliteng {
 	struct dpu_bliteng *dpu_be;
 	struct list_head list;
+	struct drm_gpu_scheduler sched;
+};
+
+/*
+ * Per drm_file blit client: one scheduler entity per blit engine, so the
+ * scheduler round-robins the blitter between clients, and the finished
+ * fence of the last command list queued on each engine.
+ */
+struct imx_drm_dpu_blit_client {
+	struct mutex lock;
+	struct drm_sched_entity entity[IMX_DRM_DPU_MAX_BLITENG];
+	struct dma_fence *last_fence[IMX_DRM_DPU_MAX_BLITENG];
+	bool has_entity[IMX_DRM_DPU_MAX_BLITENG];
+};
+
+struct imx_drm_dpu_blit_job {
+	struct drm_sched_job base;
+	struct imx_drm_dpu_bliteng *bliteng;
+	struct drm_imx_dpu_frame_info frame_info;
+	u32 cmd_nr;
+	u32 cmd[];
 };
 
 static DEFINE_MUTEX(imx_drm_dpu_bliteng_lock);
@@ -58,6 +91,7 @@ int dpu_be_blit(struct dpu_bliteng *dpu_be,
     u32 *cmdlist, u32 cmdnum);
 int dpu_be_get_fence(struct dpu_bliteng *dpu_be, int dpu_num);
 int dpu_be_set_fence(struct dpu_bliteng *dpu_be, int fd);
+struct dma_fence *dpu_be_emit_job_fence(struct dpu_bliteng *dpu_be);
 
 static struct imx_drm_dpu_bliteng *imx_drm_dpu_bliteng_find_by_id(s32 id)
 {
@@ -77,13 +111,206 @@ static struct imx_drm_dpu_bliteng *imx_drm_dpu_bliteng_find_by_id(s32 id)
 	return NULL;
 }
 
+static inline struct imx_drm_dpu_blit_job *
+to_imx_drm_dpu_blit_job(struct drm_sched_job *sched_job)
+{
+	return container_of(sched_job, struct imx_drm_dpu_blit_job, base);
+}
+
+static struct dma_fence *imx_drm_dpu_run_job(struct drm_sched_job *sched_job)
+{
+	struct imx_drm_dpu_blit_job *job = to_imx_drm_dpu_blit_job(sched_job);
+	struct drm_imx_dpu_frame_info *frame_info = &job->frame_info;
+	struct dpu_bliteng *dpu_be = job->bliteng->dpu_be;
+	struct dma_fence *fence;
+	int ret;
+
+	if (sched_job->s_fence->finished.error)
+		return NULL;
+
+	dpu_be_get(dpu_be);
+
+	dpu_be_configure_prefetch(dpu_be, frame_info->width, frame_info->height,
+				  frame_info->x_offset, frame_info->y_offset,
+				  frame_info->stride, frame_info->format,
+				  frame_info->modifier, frame_info->baddr,
+				  frame_info->uv_addr);
+
+	ret = dpu_be_blit(dpu_be, job->cmd, job->cmd_nr);
+	fence = ret ? ERR_PTR(ret) : dpu_be_emit_job_fence(dpu_be);
+
+	dpu_be_put(dpu_be);
+
+	return fence;
+}
+
+static enum drm_gpu_sched_stat
+imx_drm_dpu_timedout_job(struct drm_sched_job *sched_job)
+{
+	struct imx_drm_dpu_blit_job *job = to_imx_drm_dpu_blit_job(sched_job);
+
+	/* the command sequencer cannot be reset on its own */
+	dev_warn(job->bliteng->sched.dev, "blit job %llu timed out\n",
+		 sched_job->id);
+
+	return DRM_GPU_SCHED_STAT_NOMINAL;
+}
+
+static void imx_drm_dpu_free_job(struct drm_sched_job *sched_job)
+{
+	struct imx_drm_dpu_blit_job *job = to_imx_drm_dpu_blit_job(sched_job);
+
+	drm_sched_job_cleanup(sched_job);
+	kfree(job);
+}
+
+static const struct drm_sched_backend_ops imx_drm_dpu_sched_ops = {
+	.run_job = imx_drm_dpu_run_job,
+	.timedout_job = imx_drm_dpu_timedout_job,
+	.free_job = imx_drm_dpu_free_job,
+};
+
+int imx_drm_dpu_open(struct drm_device *drm_dev, struct drm_file *file)
+{
+	struct imx_drm_dpu_blit_client *client;
+	struct imx_drm_dpu_bliteng *bliteng;
+	struct drm_gpu_scheduler *sched;
+	int id, ret;
+
+	client = kzalloc(sizeof(*client), GFP_KERNEL);
+	if (!client)
+		return -ENOMEM;
+
+	mutex_init(&client->lock);
+
+	for (id = 0; id < IMX_DRM_DPU_MAX_BLITENG; id++) {
+		bliteng = imx_drm_dpu_bliteng_find_by_id(id);
+		if (!bliteng)
+			continue;
+
+		sched = &bliteng->sched;
+		ret = drm_sched_entity_init(&client->entity[id],
+					    DRM_SCHED_PRIORITY_NORMAL,
+					    &sched, 1, NULL);
+		if (ret)
+			goto err;
+
+		client->has_entity[id] = true;
+	}
+
+	file->driver_priv = client;
+
+	return 0;
+
+err:
+	while (--id >= 0)
+		if (client->has_entity[id])
+			drm_sched_entity_destroy(&client->entity[id]);
+	kfree(client);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(imx_drm_dpu_open);
+
+void imx_drm_dpu_postclose(struct drm_device *drm_dev, struct drm_file *file)
+{
+	struct imx_drm_dpu_blit_client *client = file->driver_priv;
+	int id;
+
+	if (!client)
+		return;
+
+	for (id = 0; id < IMX_DRM_DPU_MAX_BLITENG; id++) {
+		if (client->has_entity[id])
+			drm_sched_entity_destroy(&client->entity[id]);
+
+		dma_fence_put(client->last_fence[id]);
+	}
+
+	mutex_destroy(&client->lock);
+	kfree(client);
+	file->driver_priv = NULL;
+}
+EXPORT_SYMBOL_GPL(imx_drm_dpu_postclose);
+
+/*
+ * Wrap the finished fences of the command lists last queued by a client
+ * into one sync_file, or return -ENOENT if there's nothing queued.
+ */
+static int imx_drm_dpu_client_fence_fd(struct imx_drm_dpu_blit_client *client)
+{
+	struct dma_fence *fences[IMX_DRM_DPU_MAX_BLITENG];
+	struct dma_fence_array *array;
+	struct dma_fence **array_fences;
+	struct dma_fence *fence;
+	struct sync_file *sync;
+	int i, num = 0, fd;
+
+	mutex_lock(&client->lock);
+	for (i = 0; i < IMX_DRM_DPU_MAX_BLITENG; i++)
+		if (client->last_fence[i])
+			fences[num++] = dma_fence_get(client->last_fence[i]);
+	mutex_unlock(&client->lock);
+
+	if (!num)
+		return -ENOENT;
+
+	if (num == 1) {
+		fence = fences[0];
+	} else {
+		array_fences = kmemdup(fences, sizeof(*fences) * num,
+				       GFP_KERNEL);
+		if (!array_fences) {
+			fd = -ENOMEM;
+			goto err_put;
+		}
+
+		array = dma_fence_array_create(num, array_fences,
+					       dma_fence_context_alloc(1),
+					       1, false);
+		if (!array) {
+			kfree(array_fences);
+			fd = -ENOMEM;
+			goto err_put;
+		}
+
+		/* the array owns the fence references now */
+		fence = &array->base;
+	}
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		dma_fence_put(fence);
+		return fd;
+	}
+
+	sync = sync_file_create(fence);
+	dma_fence_put(fence);
+	if (!sync) {
+		put_unused_fd(fd);
+		return -ENOMEM;
+	}
+
+	fd_install(fd, sync->file);
+
+	return fd;
+
+err_put:
+	for (i = 0; i < num; i++)
+		dma_fence_put(fences[i]);
+
+	return fd;
+}
+
 static int imx_drm_dpu_set_cmdlist_ioctl(struct drm_device *drm_dev, void *data,
 					  struct drm_file *file)
 {
+	struct imx_drm_dpu_blit_client *client = file->driver_priv;
 	struct drm_imx_dpu_set_cmdlist *req;
 	struct imx_drm_dpu_bliteng *bliteng;
-	struct dpu_bliteng *dpu_be;
-	u32 cmd_nr, *cmd, *cmd_list;
+	struct imx_drm_dpu_blit_job *job;
+	struct dma_fence *fence;
+	u32 cmd_nr, *cmd;
 	void *user_data;
 	s32 id = 0;
 	struct drm_imx_dpu_frame_info frame_info;
@@ -106,35 +333,51 @@ static int imx_drm_dpu_set_cmdlist_ioctl(struct drm_device *drm_dev, void *data,
 	}
 
 	bliteng = imx_drm_dpu_bliteng_find_by_id(id);
-	if (!bliteng) {
+	if (!bliteng || !client->has_entity[id]) {
 		DRM_ERROR("Failed to get dpu_bliteng\n");
 		return -ENODEV;
 	}
 
-	dpu_be = bliteng->dpu_be;
-
-	dpu_be_get(dpu_be);
-
 	cmd_nr = req->cmd_nr;
 	cmd = (u32 *)(unsigned long)req->cmd;
-	cmd_list = dpu_bliteng_get_cmd_list(dpu_be);
+	if (cmd_nr > IMX_DRM_DPU_MAX_CMD_NR)
+		return -EINVAL;
+
+	/*
+	 * Queue a copy of the command list and return, the scheduler feeds
+	 * it to the command sequencer once the earlier ones are done.
+	 */
+	job = kzalloc(struct_size(job, cmd, cmd_nr), GFP_KERNEL);
+	if (!job)
+		return -ENOMEM;
 
-	if (copy_from_user(cmd_list, (void __user *)cmd,
+	if (copy_from_user(job->cmd, (void __user *)cmd,
 			sizeof(*cmd) * cmd_nr)) {
 		ret = -EFAULT;
 		goto err;
 	}
 
-	dpu_be_configure_prefetch(dpu_be, frame_info.width, frame_info.height,
-				  frame_info.x_offset, frame_info.y_offset,
-				  frame_info.stride, frame_info.format,
-				  frame_info.modifier, frame_info.baddr,
-				  frame_info.uv_addr);
+	job->bliteng = bliteng;
+	job->frame_info = frame_info;
+	job->cmd_nr = cmd_nr;
+
+	ret = drm_sched_job_init(&job->base, &client->entity[id], 1, client);
+	if (ret)
+		goto err;
+
+	mutex_lock(&client->lock);
+	drm_sched_job_arm(&job->base);
+	fence = dma_fence_get(&job->base.s_fence->finished);
+	drm_sched_entity_push_job(&job->base);
 
-	ret = dpu_be_blit(dpu_be, cmd_list, cmd_nr);
+	dma_fence_put(client->last_fence[id]);
+	client->last_fence[id] = fence;
+	mutex_unlock(&client->lock);
+
+	return 0;
 
 err:
-	dpu_be_put(dpu_be);
+	kfree(job);
 
 	return ret;
 }
@@ -142,11 +385,14 @@ static int imx_drm_dpu_set_cmdlist_ioctl(struct drm_device *drm_dev, void *data,
 static int imx_drm_dpu_wait_ioctl(struct drm_device *drm_dev, void *data,
 				  struct drm_file *file)
 {
+	struct imx_drm_dpu_blit_client *client = file->driver_priv;
 	struct drm_imx_dpu_wait *wait;
 	struct imx_drm_dpu_bliteng *bliteng;
 	struct dpu_bliteng *dpu_be;
+	struct dma_fence *fence;
 	void *user_data;
 	s32 id = 0;
+	long ret;
 
 	wait = data;
 	user_data = (void *)(unsigned long)wait->user_data;
@@ -164,6 +410,17 @@ static int imx_drm_dpu_wait_ioctl(struct drm_device *drm_dev, void *data,
 		return -ENODEV;
 	}
 
+	mutex_lock(&client->lock);
+	fence = dma_fence_get(client->last_fence[id]);
+	mutex_unlock(&client->lock);
+
+	if (fence) {
+		ret = dma_fence_wait(fence, true);
+		dma_fence_put(fence);
+		if (ret)
+			return ret;
+	}
+
 	dpu_be = bliteng->dpu_be;
 
 	dpu_be_get(dpu_be);
@@ -178,6 +435,7 @@ static int imx_drm_dpu_wait_ioctl(struct drm_device *drm_dev, void *data,
 static int imx_drm_dpu_get_param_ioctl(struct drm_device *drm_dev, void *data,
 				       struct drm_file *file)
 {
+	struct imx_drm_dpu_blit_client *client = file->driver_priv;
 	enum drm_imx_dpu_param *param = data;
 	struct imx_drm_dpu_bliteng *bliteng;
 	struct dpu_bliteng *dpu_be;
@@ -188,6 +446,11 @@ static int imx_drm_dpu_get_param_ioctl(struct drm_device *drm_dev, void *data,
 		ret = imx_dpu_num;
 		break;
 	case DRM_IMX_GET_FENCE:
+		/* signaled when the command lists queued so far are done */
+		ret = imx_drm_dpu_client_fence_fd(client);
+		if (ret != -ENOENT)
+			break;
+
 		for (id = 0; id < imx_dpu_num; id++) {
 			bliteng = imx_drm_dpu_bliteng_find_by_id(id);
 			if (!bliteng) {
@@ -296,6 +559,16 @@ static int dpu_bliteng_bind(struct device *dev, struct device *master,
 	if (ret)
 		return ret;
 
+	ret = drm_sched_init(&bliteng->sched, &imx_drm_dpu_sched_ops, NULL,
+			     DRM_SCHED_PRIORITY_COUNT,
+			     IMX_DRM_DPU_JOBS_IN_FLIGHT, 0,
+			     msecs_to_jiffies(IMX_DRM_DPU_JOB_TIMEOUT_MS),
+			     NULL, NULL, dev_name(dev), dev);
+	if (ret) {
+		dpu_bliteng_fini(dpu_bliteng);
+		return ret;
+	}
+
 	mutex_lock(&imx_drm_dpu_bliteng_lock);
 	bliteng->dpu_be = dpu_bliteng;
 	list_add_tail(&bliteng->list, &imx_drm_dpu_bliteng_list);
@@ -316,7 +589,12 @@ static void dpu_bliteng_unbind(struct device *dev, struct device *master,
 	s32 id = dpu_bliteng_get_id(dpu_bliteng);
 
 	bliteng = imx_drm_dpu_bliteng_find_by_id(id);
+
+	mutex_lock(&imx_drm_dpu_bliteng_lock);
 	list_del(&bliteng->list);
+	mutex_unlock(&imx_drm_dpu_bliteng_lock);
+
+	drm_sched_fini(&bliteng->sched);
 
 	dpu_bliteng_fini(dpu_bliteng);
 	dev_set_drvdata(dev, NULL);
@@ -348,10 +626,15 @@ static void dpu_bliteng_remove(struct platform_device *pdev)
 static int dpu_bliteng_suspend(struct device *dev)
 {
 	struct dpu_bliteng *dpu_bliteng = dev_get_drvdata(dev);
+	struct imx_drm_dpu_bliteng *bliteng;
 
 	if (dpu_bliteng == NULL)
 		return 0;
 
+	bliteng = imx_drm_dpu_bliteng_find_by_id(dpu_bliteng_get_id(dpu_bliteng));
+	if (bliteng)
+		drm_sched_wqueue_stop(&bliteng->sched);
+
 	dpu_be_get(dpu_bliteng);
 
 	dpu_be_wait(dpu_bliteng);
@@ -366,9 +649,16 @@ static int dpu_bliteng_suspend(struct device *dev)
 static int dpu_bliteng_resume(struct device *dev)
 {
 	struct dpu_bliteng *dpu_bliteng = dev_get_drvdata(dev);
+	struct imx_drm_dpu_bliteng *bliteng;
+
+	if (dpu_bliteng == NULL)
+		return 0;
+
+	dpu_bliteng_init(dpu_bliteng);
 
-	if (dpu_bliteng != NULL)
-		dpu_bliteng_init(dpu_bliteng);
+	bliteng = imx_drm_dpu_bliteng_find_by_id(dpu_bliteng_get_id(dpu_bliteng));
+	if (bliteng)
+		drm_sched_wqueue_start(&bliteng->sched);
 
 	return 0;
 }
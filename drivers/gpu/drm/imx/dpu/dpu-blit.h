@@ -9,10 +9,24 @@
 
 #include <drm/drm_ioctl.h>
 
+struct drm_device;
+struct drm_file;
+
 #if IS_ENABLED(CONFIG_DRM_IMX_DPU)
 extern const struct drm_ioctl_desc imx_drm_dpu_ioctls[4];
+int imx_drm_dpu_open(struct drm_device *drm_dev, struct drm_file *file);
+void imx_drm_dpu_postclose(struct drm_device *drm_dev, struct drm_file *file);
 #else
 const struct drm_ioctl_desc imx_drm_dpu_ioctls[] = {};
+static inline int imx_drm_dpu_open(struct drm_device *drm_dev,
+				   struct drm_file *file)
+{
+	return 0;
+}
+static inline void imx_drm_dpu_postclose(struct drm_device *drm_dev,
+					 struct drm_file *file)
+{
+}
 #endif
 
 #endif /* _DPU_DRM_BLIT_H_ */
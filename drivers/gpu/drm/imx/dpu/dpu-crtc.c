@@ -56,6 +56,7 @@ static void dpu_crtc_queue_state_event(struct drm_crtc *crtc)
 		WARN_ON(dpu_crtc->event);
 		dpu_crtc->event = crtc->state->event;
 		crtc->state->event = NULL;
+		imx_drm_frame_stats_arm(&dpu_crtc->frame_stats, crtc);
 	}
 	spin_unlock_irq(&crtc->dev->event_lock);
 }
@@ -516,6 +517,13 @@ static void dpu_disable_vblank(struct drm_crtc *crtc)
 	disable_irq_nosync(dpu_crtc->vbl_irq);
 }
 
+static int dpu_crtc_late_register(struct drm_crtc *crtc)
+{
+	struct dpu_crtc *dpu_crtc = to_dpu_crtc(crtc);
+
+	return imx_drm_frame_stats_late_register(&dpu_crtc->frame_stats, crtc);
+}
+
 static const struct drm_crtc_funcs dpu_crtc_funcs = {
 	.set_config = drm_atomic_helper_set_config,
 	.destroy = drm_crtc_cleanup,
@@ -527,6 +535,7 @@ static const struct drm_crtc_funcs dpu_crtc_funcs = {
 	.disable_vblank = dpu_disable_vblank,
 	.set_crc_source = dpu_crtc_set_crc_source,
 	.verify_crc_source = dpu_crtc_verify_crc_source,
+	.late_register = dpu_crtc_late_register,
 };
 
 static irqreturn_t dpu_vbl_irq_handler(int irq, void *dev_id)
@@ -539,6 +548,7 @@ static irqreturn_t dpu_vbl_irq_handler(int irq, void *dev_id)
 
 	spin_lock_irqsave(&crtc->dev->event_lock, flags);
 	if (dpu_crtc->event) {
+		imx_drm_frame_stats_flip(&dpu_crtc->frame_stats, crtc);
 		drm_crtc_send_vblank_event(crtc, dpu_crtc->event);
 		dpu_crtc->event = NULL;
 		drm_crtc_vblank_put(crtc);
@@ -1247,6 +1257,8 @@ static int dpu_crtc_init(struct dpu_crtc *dpu_crtc,
 	init_completion(&dpu_crtc->crc_shdld_done);
 	init_completion(&dpu_crtc->aux_crc_done);
 
+	imx_drm_frame_stats_init(&dpu_crtc->frame_stats);
+
 	dpu_crtc->stream_id = stream_id;
 	dpu_crtc->crtc_grp_id = pdata->di_grp_id;
 	dpu_crtc->hw_plane_num = plane_grp->hw_plane_num;
@@ -18,6 +18,7 @@
 #include <drm/drm_vblank.h>
 #include <video/dpu.h>
 #include "dpu-plane.h"
+#include "imx-drm-frame-stats.h"
 #include "imx-drm.h"
 
 struct dpu_crtc {
@@ -78,6 +79,7 @@ struct dpu_crtc {
 	struct completion	aux_crc_done;
 
 	struct drm_pending_vblank_event *event;
+	struct imx_drm_frame_stats	frame_stats;
 
 	u32			crc_red;
 	u32			crc_green;
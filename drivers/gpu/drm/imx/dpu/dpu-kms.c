@@ -22,6 +22,7 @@
 #include <drm/drm_gem_framebuffer_helper.h>
 #include <linux/sort.h>
 #include <video/dpu.h>
+#include <video/imx8-prefetch.h>
 #include "dpu-crtc.h"
 #include "dpu-plane.h"
 #include "imx-drm.h"
@@ -173,6 +174,27 @@ static int dpu_atomic_get_source_pos(lb_sec_sel_t *current_source,
 	return pos;
 }
 
+/*
+ * Rank a fetch unit by the capabilities it could offer to other planes,
+ * so that a plane picks the least capable unit which fits it and leaves
+ * the video processing units and the tile resolving prefetch channels to
+ * the planes which need them.
+ */
+static int dpu_atomic_source_rank(struct dpu_fetchunit *fu, u32 cap_mask)
+{
+	int rank = hweight32(cap_mask);
+
+	if (fu->dprc) {
+		rank++;
+
+		if (dprc_format_supported(fu->dprc, DRM_FORMAT_NV12,
+					  DRM_FORMAT_MOD_AMPHION_TILED))
+			rank++;
+	}
+
+	return rank;
+}
+
 static int
 dpu_atomic_assign_plane_source_per_crtc(struct drm_plane_state **states,
 					int n, bool use_pc)
@@ -191,11 +213,12 @@ dpu_atomic_assign_plane_source_per_crtc(struct drm_plane_state **states,
 	unsigned int sid, src_sid;
 	unsigned int num_planes;
 	int i, j, k = 0, m;
+	int best_k, rank, best_rank;
 	int total_asrc_num;
 	int s0_layer_cnt = 0, s1_layer_cnt = 0;
 	int s1_n = 0;
-	u32 src_a_mask, cap_mask, fe_mask, hs_mask, vs_mask;
-	bool need_fetcheco, need_hscaler, need_vscaler;
+	u32 src_a_mask, cap_mask, fe_mask, hs_mask, vs_mask, best_vproc_mask;
+	bool need_fetcheco, need_hscaler, need_vscaler, need_tile_resolve;
 	bool fmt_is_yuv;
 	bool alloc_aux_source;
 
@@ -232,6 +255,7 @@ dpu_atomic_assign_plane_source_per_crtc(struct drm_plane_state **states,
 		need_fetcheco = (num_planes > 1);
 		need_hscaler = (states[i]->src_w >> 16 != states[i]->crtc_w);
 		need_vscaler = (states[i]->src_h >> 16 != states[i]->crtc_h);
+		need_tile_resolve = !!fb->modifier;
 
 		src_a_mask = grp->src_a_mask;
 		fe_mask = 0;
@@ -243,6 +267,10 @@ dpu_atomic_assign_plane_source_per_crtc(struct drm_plane_state **states,
 		current_source = alloc_aux_source ?
 				 dpstate->aux_source : dpstate->source;
 
+		best_k = -1;
+		best_rank = INT_MAX;
+		best_vproc_mask = 0;
+
 		/* assign source */
 		mutex_lock(&grp->mutex);
 		for (j = 0; j < total_asrc_num; j++) {
@@ -322,24 +350,56 @@ dpu_atomic_assign_plane_source_per_crtc(struct drm_plane_state **states,
 						goto next;
 				}
 			} else {
+				cap_mask = 0;
+
 				if (fmt_is_yuv || need_fetcheco ||
 				    need_hscaler || need_vscaler)
 					goto next;
 			}
 
-			grp->src_a_mask &= ~BIT(k);
-			grp->src_use_vproc_mask |= fe_mask | hs_mask | vs_mask;
-			break;
+			/* tiles can only be resolved by a prefetch channel */
+			if (need_tile_resolve &&
+			    (!fu->dprc ||
+			     !dprc_format_supported(fu->dprc, fb->format->format,
+						    fb->modifier)))
+				goto next;
+
+			/*
+			 * Stay on the current source to avoid needless
+			 * reprogramming, unless a plane which needs tile
+			 * resolving is still waiting for a fetch unit.
+			 */
+			if (sources[k] == current_source &&
+			    (need_tile_resolve || !grp->src_tiled_num)) {
+				best_k = k;
+				best_vproc_mask = fe_mask | hs_mask | vs_mask;
+				break;
+			}
+
+			rank = dpu_atomic_source_rank(fu, cap_mask);
+			if (rank < best_rank) {
+				best_k = k;
+				best_rank = rank;
+				best_vproc_mask = fe_mask | hs_mask | vs_mask;
+			}
 next:
 			src_a_mask &= ~BIT(k);
 			fe_mask = 0;
 			hs_mask = 0;
 			vs_mask = 0;
 		}
-		mutex_unlock(&grp->mutex);
 
-		if (j == total_asrc_num)
+		if (best_k < 0) {
+			mutex_unlock(&grp->mutex);
 			return -EINVAL;
+		}
+
+		k = best_k;
+		grp->src_a_mask &= ~BIT(k);
+		grp->src_use_vproc_mask |= best_vproc_mask;
+		if (need_tile_resolve && grp->src_tiled_num)
+			grp->src_tiled_num--;
+		mutex_unlock(&grp->mutex);
 
 		if (alloc_aux_source)
 			dpstate->aux_source = sources[k];
@@ -493,6 +553,28 @@ dpu_atomic_put_possible_states_per_crtc(struct drm_crtc_state *crtc_state)
 	dpu_atomic_put_crtc_state(state, crtc);
 }
 
+/*
+ * A commit may only go down the asynchronous plane path when nobody waits
+ * for it to complete: no vblank event or out-fence is requested on any CRTC
+ * in the state.  Legacy cursor updates never carry an event.
+ */
+static bool dpu_drm_atomic_may_async(struct drm_atomic_state *state)
+{
+	struct drm_crtc_state *crtc_state;
+	struct drm_crtc *crtc;
+	int i;
+
+	if (state->legacy_cursor_update)
+		return true;
+
+	for_each_new_crtc_in_state(state, crtc, crtc_state, i) {
+		if (crtc_state->event)
+			return false;
+	}
+
+	return true;
+}
+
 static int dpu_drm_atomic_check(struct drm_device *dev,
 				struct drm_atomic_state *state)
 {
@@ -509,11 +591,26 @@ static int dpu_drm_atomic_check(struct drm_device *dev,
 	int active_plane_fetcheco[MAX_DPU_PLANE_GRP];
 	int active_plane_hscale[MAX_DPU_PLANE_GRP];
 	int active_plane_vscale[MAX_DPU_PLANE_GRP];
+	int active_plane_tiled[MAX_DPU_PLANE_GRP];
 	int half_hdisplay = 0;
 	bool pipe_states_prone_to_put[MAX_CRTC];
 	bool use_pc[MAX_DPU_PLANE_GRP];
 	u32 crtc_mask_in_state = 0;
 
+	/*
+	 * Try the fast path first for a single plane move or flip: it must
+	 * not pull in the other planes and CRTCs as the full check does.
+	 */
+	if (dpu_drm_atomic_may_async(state)) {
+		ret = drm_atomic_helper_async_check(dev, state);
+		if (ret == -EDEADLK)
+			return ret;
+		if (!ret) {
+			state->async_update = true;
+			return 0;
+		}
+	}
+
 	ret = drm_atomic_helper_check_modeset(dev, state);
 	if (ret) {
 		DRM_DEBUG_KMS("%s: failed to check modeset\n", __func__);
@@ -528,6 +625,7 @@ static int dpu_drm_atomic_check(struct drm_device *dev,
 		active_plane_fetcheco[i] = 0;
 		active_plane_hscale[i] = 0;
 		active_plane_vscale[i] = 0;
+		active_plane_tiled[i] = 0;
 		use_pc[i] = false;
 		grp[i] = NULL;
 	}
@@ -638,6 +736,12 @@ static int dpu_drm_atomic_check(struct drm_device *dev,
 					active_plane_fetcheco[grp_id]++;
 			}
 
+			if (fb->modifier) {
+				active_plane_tiled[grp_id]++;
+				if (need_aux_source)
+					active_plane_tiled[grp_id]++;
+			}
+
 			if (plane_state->src_w >> 16 != plane_state->crtc_w) {
 				if (use_pc_per_crtc)
 					return -EINVAL;
@@ -693,6 +797,7 @@ static int dpu_drm_atomic_check(struct drm_device *dev,
 		mutex_lock(&grp[i]->mutex);
 		grp[i]->src_a_mask = grp[i]->src_mask;
 		grp[i]->src_use_vproc_mask = 0;
+		grp[i]->src_tiled_num = active_plane_tiled[i];
 		mutex_unlock(&grp[i]->mutex);
 	}
 
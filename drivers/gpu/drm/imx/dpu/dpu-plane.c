@@ -17,6 +17,7 @@
 #include <drm/drm_atomic_helper.h>
 #include <drm/drm_blend.h>
 #include <drm/drm_color_mgmt.h>
+#include <drm/drm_debugfs.h>
 #include <drm/drm_fb_dma_helper.h>
 #include <drm/drm_fourcc.h>
 #include <drm/drm_framebuffer.h>
@@ -596,13 +597,32 @@ static int dpu_plane_atomic_check(struct drm_plane *plane,
 	return 0;
 }
 
+/*
+ * Account a group of registers to the plane update statistics; returns
+ * true if the group has to be (re)written.
+ */
+static inline bool
+dpu_plane_reg_group_dirty(struct dpu_plane *dplane, bool unchanged)
+{
+	if (unchanged)
+		dplane->regs_skipped++;
+	else
+		dplane->regs_written++;
+
+	return !unchanged;
+}
+
 static void dpu_plane_atomic_update(struct drm_plane *plane,
 				    struct drm_atomic_state *state)
 {
 	struct dpu_plane *dplane = to_dpu_plane(plane);
+	struct drm_plane_state *old_plane_state = drm_atomic_get_old_plane_state(state,
+										 plane);
 	struct drm_plane_state *new_plane_state = drm_atomic_get_new_plane_state(state,
 										 plane);
+	struct dpu_plane_state *old_dpstate = to_dpu_plane_state(old_plane_state);
 	struct dpu_plane_state *dpstate = to_dpu_plane_state(new_plane_state);
+	struct drm_framebuffer *old_fb = old_plane_state->fb;
 	struct drm_framebuffer *fb = new_plane_state->fb;
 	struct dpu_plane_res *res = &dplane->grp->res;
 	struct dpu_fetchunit *fu;
@@ -629,6 +649,10 @@ static void dpu_plane_atomic_update(struct drm_plane *plane,
 	bool use_prefetch;
 	bool need_modeset;
 	bool fb_is_interlaced;
+	bool cached, same_fmt, same_size, same_blend, same_pos;
+
+	dplane->regs_written = 0;
+	dplane->regs_skipped = 0;
 
 	/*
 	 * Do nothing since the plane is disabled by
@@ -641,6 +665,49 @@ static void dpu_plane_atomic_update(struct drm_plane *plane,
 		drm_atomic_crtc_needs_modeset(new_plane_state->crtc->state);
 	fb_is_interlaced = !!(fb->flags & DRM_MODE_FB_INTERLACED);
 
+	/*
+	 * crtc_func->atomic_begin only disables the units of the old planes,
+	 * their format, size and blending setup is left in place.  As long as
+	 * the plane keeps the same fetchunit and layerblend, that setup is
+	 * still the one written by the previous commit of this plane, so only
+	 * rewrite the register groups whose inputs changed.
+	 */
+	cached = !need_modeset && old_fb && !crtc_use_pc &&
+		 !old_dpstate->left_src_w && !old_dpstate->right_src_w &&
+		 old_plane_state->crtc == new_plane_state->crtc &&
+		 old_dpstate->source == dpstate->source &&
+		 old_dpstate->blend == dpstate->blend;
+	same_fmt = cached &&
+		   fb->format == old_fb->format &&
+		   fb->modifier == old_fb->modifier &&
+		   !((fb->flags ^ old_fb->flags) & DRM_MODE_FB_INTERLACED) &&
+		   new_plane_state->color_encoding ==
+					old_plane_state->color_encoding &&
+		   new_plane_state->color_range ==
+					old_plane_state->color_range &&
+		   new_plane_state->pixel_blend_mode ==
+					old_plane_state->pixel_blend_mode &&
+		   new_plane_state->alpha == old_plane_state->alpha;
+	same_size = same_fmt &&
+		    drm_rect_width(&new_plane_state->src) ==
+				drm_rect_width(&old_plane_state->src) &&
+		    drm_rect_height(&new_plane_state->src) ==
+				drm_rect_height(&old_plane_state->src) &&
+		    drm_rect_width(&new_plane_state->dst) ==
+				drm_rect_width(&old_plane_state->dst) &&
+		    drm_rect_height(&new_plane_state->dst) ==
+				drm_rect_height(&old_plane_state->dst) &&
+		    new_plane_state->crtc_h == old_plane_state->crtc_h;
+	same_blend = cached &&
+		     new_plane_state->normalized_zpos ==
+					old_plane_state->normalized_zpos &&
+		     new_plane_state->pixel_blend_mode ==
+					old_plane_state->pixel_blend_mode &&
+		     new_plane_state->alpha == old_plane_state->alpha;
+	same_pos = cached &&
+		   new_plane_state->crtc_x == old_plane_state->crtc_x &&
+		   new_plane_state->crtc_y == old_plane_state->crtc_y;
+
 again:
 	need_fetcheco = false;
 	prefetch_start = false;
@@ -765,19 +832,29 @@ static void dpu_plane_atomic_update(struct drm_plane *plane,
 	     need_modeset))
 		prefetch_start = true;
 
+	/* the buffer address and the address dependent burst setup */
+	dpu_plane_reg_group_dirty(dplane, false);
 	fu->ops->set_burstlength(fu, src_x, mt_w, bpp, baseaddr, use_prefetch);
-	fu->ops->set_src_bpp(fu, bpp);
 	fu->ops->set_src_stride(fu, src_w, src_w, mt_w, bpp, fb->pitches[0],
 				baseaddr, use_prefetch);
-	fu->ops->set_src_buf_dimensions(fu, src_w, src_h, 0, fb_is_interlaced);
-	fu->ops->set_pixel_blend_mode(fu, new_plane_state->pixel_blend_mode,
-				      new_plane_state->alpha,
-				      fb->format->format);
-	fu->ops->set_fmt(fu, fb->format->format,
-			 new_plane_state->color_encoding,
-			 new_plane_state->color_range, fb_is_interlaced);
+	if (dpu_plane_reg_group_dirty(dplane, same_fmt)) {
+		fu->ops->set_src_bpp(fu, bpp);
+		fu->ops->set_pixel_blend_mode(fu,
+					new_plane_state->pixel_blend_mode,
+					new_plane_state->alpha,
+					fb->format->format);
+		fu->ops->set_fmt(fu, fb->format->format,
+				 new_plane_state->color_encoding,
+				 new_plane_state->color_range,
+				 fb_is_interlaced);
+	}
+	if (dpu_plane_reg_group_dirty(dplane, same_size)) {
+		fu->ops->set_src_buf_dimensions(fu, src_w, src_h, 0,
+						fb_is_interlaced);
+		fu->ops->set_framedimensions(fu, src_w, src_h,
+					     fb_is_interlaced);
+	}
 	fu->ops->enable_src_buf(fu);
-	fu->ops->set_framedimensions(fu, src_w, src_h, fb_is_interlaced);
 	fu->ops->set_baseaddress(fu, src_w, src_x, src_y, mt_w, mt_h, bpp,
 				 baseaddr);
 	fu->ops->set_stream_id(fu, stream_id ?
@@ -799,21 +876,26 @@ static void dpu_plane_atomic_update(struct drm_plane *plane,
 
 		fetchdecode_pixengcfg_dynamic_src_sel(fu,
 						(fd_dynamic_src_sel_t)fe_id);
+		dpu_plane_reg_group_dirty(dplane, false);
 		fe->ops->set_burstlength(fe, src_w, mt_w, bpp, uv_baseaddr,
 					 use_prefetch);
-		fe->ops->set_src_bpp(fe, 16);
 		fe->ops->set_src_stride(fe, src_w, src_x, mt_w, bpp,
 					fb->pitches[1],
 					uv_baseaddr, use_prefetch);
-		fe->ops->set_fmt(fe, fb->format->format,
-				 new_plane_state->color_encoding,
-				 new_plane_state->color_range,
-				 fb_is_interlaced);
-		fe->ops->set_src_buf_dimensions(fe, src_w, src_h,
-						fb->format->format,
-						fb_is_interlaced);
-		fe->ops->set_framedimensions(fe, src_w, src_h,
-						fb_is_interlaced);
+		if (dpu_plane_reg_group_dirty(dplane, same_fmt)) {
+			fe->ops->set_src_bpp(fe, 16);
+			fe->ops->set_fmt(fe, fb->format->format,
+					 new_plane_state->color_encoding,
+					 new_plane_state->color_range,
+					 fb_is_interlaced);
+		}
+		if (dpu_plane_reg_group_dirty(dplane, same_size)) {
+			fe->ops->set_src_buf_dimensions(fe, src_w, src_h,
+							fb->format->format,
+							fb_is_interlaced);
+			fe->ops->set_framedimensions(fe, src_w, src_h,
+						     fb_is_interlaced);
+		}
 		fe->ops->set_baseaddress(fe, src_w, src_x, src_y / 2,
 					 mt_w, mt_h, bpp, uv_baseaddr);
 		fe->ops->enable_src_buf(fe);
@@ -837,15 +919,17 @@ static void dpu_plane_atomic_update(struct drm_plane *plane,
 
 		vscaler_pixengcfg_dynamic_src_sel(vs, (vs_src_sel_t)source);
 		vscaler_pixengcfg_clken(vs, CLKEN__AUTOMATIC);
-		vscaler_setup1(vs, src_h, new_plane_state->crtc_h,
-			       fb_is_interlaced);
-		vscaler_setup2(vs, fb_is_interlaced);
-		vscaler_setup3(vs, fb_is_interlaced);
-		vscaler_output_size(vs, dst_h);
-		vscaler_field_mode(vs, fb_is_interlaced ?
+		if (dpu_plane_reg_group_dirty(dplane, same_size)) {
+			vscaler_setup1(vs, src_h, new_plane_state->crtc_h,
+				       fb_is_interlaced);
+			vscaler_setup2(vs, fb_is_interlaced);
+			vscaler_setup3(vs, fb_is_interlaced);
+			vscaler_output_size(vs, dst_h);
+			vscaler_field_mode(vs, fb_is_interlaced ?
 						SCALER_ALWAYS0 : SCALER_INPUT);
-		vscaler_filter_mode(vs, SCALER_LINEAR);
-		vscaler_scale_mode(vs, SCALER_UPSCALE);
+			vscaler_filter_mode(vs, SCALER_LINEAR);
+			vscaler_scale_mode(vs, SCALER_UPSCALE);
+		}
 		vscaler_mode(vs, SCALER_ACTIVE);
 		vscaler_set_stream_id(vs, dplane->stream_id ?
 					DPU_PLANE_SRC_TO_DISP_STREAM1 :
@@ -867,10 +951,12 @@ static void dpu_plane_atomic_update(struct drm_plane *plane,
 							(hs_src_sel_t)vs_id :
 							(hs_src_sel_t)source);
 		hscaler_pixengcfg_clken(hs, CLKEN__AUTOMATIC);
-		hscaler_setup1(hs, src_w, dst_w);
-		hscaler_output_size(hs, dst_w);
-		hscaler_filter_mode(hs, SCALER_LINEAR);
-		hscaler_scale_mode(hs, SCALER_UPSCALE);
+		if (dpu_plane_reg_group_dirty(dplane, same_size)) {
+			hscaler_setup1(hs, src_w, dst_w);
+			hscaler_output_size(hs, dst_w);
+			hscaler_filter_mode(hs, SCALER_LINEAR);
+			hscaler_scale_mode(hs, SCALER_UPSCALE);
+		}
 		hscaler_mode(hs, SCALER_ACTIVE);
 		hscaler_set_stream_id(hs, dplane->stream_id ?
 					DPU_PLANE_SRC_TO_DISP_STREAM1 :
@@ -921,12 +1007,15 @@ static void dpu_plane_atomic_update(struct drm_plane *plane,
 
 	layerblend_pixengcfg_dynamic_prim_sel(lb, stage);
 	layerblend_pixengcfg_dynamic_sec_sel(lb, source);
-	layerblend_control(lb, LB_BLEND);
-	layerblend_blendcontrol(lb, new_plane_state->normalized_zpos,
-				new_plane_state->pixel_blend_mode,
-				new_plane_state->alpha);
+	if (dpu_plane_reg_group_dirty(dplane, same_blend)) {
+		layerblend_control(lb, LB_BLEND);
+		layerblend_blendcontrol(lb, new_plane_state->normalized_zpos,
+					new_plane_state->pixel_blend_mode,
+					new_plane_state->alpha);
+	}
 	layerblend_pixengcfg_clken(lb, CLKEN__AUTOMATIC);
-	layerblend_position(lb, crtc_x, new_plane_state->crtc_y);
+	if (dpu_plane_reg_group_dirty(dplane, same_pos))
+		layerblend_position(lb, crtc_x, new_plane_state->crtc_y);
 
 	if (crtc_use_pc) {
 		if ((!stream_id && dpstate->is_left_top) ||
@@ -954,14 +1043,181 @@ static void dpu_plane_atomic_update(struct drm_plane *plane,
 		update_aux_source = true;
 		goto again;
 	}
+
+	dplane->regs_written_total += dplane->regs_written;
+	dplane->regs_skipped_total += dplane->regs_skipped;
+}
+
+/*
+ * Asynchronous updates only cover a plane which keeps its hardware resources,
+ * size and blending, so that just the fetchunit buffer addresses and the
+ * layerblend position need to be rewritten in shadow registers.
+ */
+static int dpu_plane_atomic_async_check(struct drm_plane *plane,
+					struct drm_atomic_state *state)
+{
+	struct drm_plane_state *old_plane_state = plane->state;
+	struct drm_plane_state *new_plane_state =
+				drm_atomic_get_new_plane_state(state, plane);
+	struct dpu_plane_state *old_dpstate = to_dpu_plane_state(old_plane_state);
+	struct dpu_plane_state *dpstate = to_dpu_plane_state(new_plane_state);
+	struct drm_framebuffer *old_fb = old_plane_state->fb;
+	struct drm_framebuffer *fb = new_plane_state->fb;
+	struct drm_crtc_state *crtc_state;
+	struct drm_crtc_commit *commit;
+	int ret;
+
+	if (!fb || !old_fb || !new_plane_state->crtc ||
+	    new_plane_state->crtc != old_plane_state->crtc)
+		return -EINVAL;
+
+	if (fb->format != old_fb->format ||
+	    fb->modifier != old_fb->modifier ||
+	    fb->pitches[0] != old_fb->pitches[0] ||
+	    fb->pitches[1] != old_fb->pitches[1] ||
+	    (fb->flags ^ old_fb->flags) & DRM_MODE_FB_INTERLACED)
+		return -EINVAL;
+
+	if (new_plane_state->src_w != old_plane_state->src_w ||
+	    new_plane_state->src_h != old_plane_state->src_h ||
+	    new_plane_state->crtc_w != old_plane_state->crtc_w ||
+	    new_plane_state->crtc_h != old_plane_state->crtc_h)
+		return -EINVAL;
+
+	if (new_plane_state->alpha != old_plane_state->alpha ||
+	    new_plane_state->pixel_blend_mode !=
+				old_plane_state->pixel_blend_mode ||
+	    new_plane_state->zpos != old_plane_state->zpos ||
+	    new_plane_state->color_encoding !=
+				old_plane_state->color_encoding ||
+	    new_plane_state->color_range != old_plane_state->color_range)
+		return -EINVAL;
+
+	/* the pixel combiner splits the plane across two streams */
+	if (old_dpstate->left_src_w || old_dpstate->right_src_w ||
+	    old_dpstate->need_aux_source)
+		return -EINVAL;
+
+	crtc_state = drm_atomic_get_crtc_state(state, new_plane_state->crtc);
+	if (IS_ERR(crtc_state))
+		return PTR_ERR(crtc_state);
+
+	if (!crtc_state->active || drm_atomic_crtc_needs_modeset(crtc_state))
+		return -EINVAL;
+
+	/* don't overtake a full commit which is still being programmed */
+	commit = new_plane_state->crtc->state->commit;
+	if (commit && !try_wait_for_completion(&commit->hw_done))
+		return -EBUSY;
+
+	ret = dpu_plane_atomic_check(plane, state);
+	if (ret)
+		return ret;
+
+	/* starting or stopping prefetch needs a frame counter sync */
+	if (dpstate->use_prefetch != old_dpstate->use_prefetch)
+		return -EINVAL;
+
+	return 0;
+}
+
+static void dpu_plane_atomic_async_update(struct drm_plane *plane,
+					  struct drm_atomic_state *state)
+{
+	struct dpu_plane *dplane = to_dpu_plane(plane);
+	struct drm_plane_state *new_plane_state =
+				drm_atomic_get_new_plane_state(state, plane);
+	struct dpu_plane_res *res = &dplane->grp->res;
+
+	dpu_plane_atomic_update(plane, state);
+
+	/*
+	 * Keep the current state object, which the CRTC state refers to,
+	 * and move the new setup into it.  The old fb ends up in the new
+	 * state so that it gets cleaned up with it.
+	 */
+	swap(plane->state->fb, new_plane_state->fb);
+	plane->state->crtc_x = new_plane_state->crtc_x;
+	plane->state->crtc_y = new_plane_state->crtc_y;
+	plane->state->crtc_w = new_plane_state->crtc_w;
+	plane->state->crtc_h = new_plane_state->crtc_h;
+	plane->state->src_x = new_plane_state->src_x;
+	plane->state->src_y = new_plane_state->src_y;
+	plane->state->src_w = new_plane_state->src_w;
+	plane->state->src_h = new_plane_state->src_h;
+	plane->state->src = new_plane_state->src;
+	plane->state->dst = new_plane_state->dst;
+	plane->state->visible = new_plane_state->visible;
+
+	/*
+	 * The new setup is latched from shadow at the next frame start;
+	 * unlike a full commit, don't wait for the shadow load.
+	 */
+	extdst_pixengcfg_sync_trigger(res->ed[dplane->stream_id]);
 }
 
 static const struct drm_plane_helper_funcs dpu_plane_helper_funcs = {
 	.prepare_fb = drm_gem_plane_helper_prepare_fb,
 	.atomic_check = dpu_plane_atomic_check,
 	.atomic_update = dpu_plane_atomic_update,
+	.atomic_async_check = dpu_plane_atomic_async_check,
+	.atomic_async_update = dpu_plane_atomic_async_update,
 };
 
+static int dpu_plane_regs_show(struct seq_file *m, void *unused)
+{
+	struct drm_debugfs_entry *entry = m->private;
+	struct dpu_plane *dplane = entry->file.data;
+
+	seq_printf(m, "last update: %u register groups written, %u skipped\n",
+		   dplane->regs_written, dplane->regs_skipped);
+	seq_printf(m, "total: %llu written, %llu skipped\n",
+		   dplane->regs_written_total, dplane->regs_skipped_total);
+
+	return 0;
+}
+
+static void dpu_plane_source_print(struct seq_file *m, struct dpu_plane *dplane,
+				   const char *tag, lb_sec_sel_t source,
+				   bool use_prefetch)
+{
+	struct dpu_fetchunit *fu = source_to_fu(&dplane->grp->res, source);
+
+	seq_printf(m, "%s: %s, prefetch %s\n", tag, fu ? fu->name : "none",
+		   use_prefetch ? "on" : "off");
+}
+
+/* the fetch unit and prefetch channel assignment of the committed state */
+static int dpu_plane_source_show(struct seq_file *m, void *unused)
+{
+	struct drm_debugfs_entry *entry = m->private;
+	struct dpu_plane *dplane = entry->file.data;
+	struct drm_plane *plane = &dplane->base;
+	struct dpu_plane_state *dpstate;
+	struct drm_framebuffer *fb;
+
+	drm_modeset_lock(&plane->mutex, NULL);
+	dpstate = to_dpu_plane_state(plane->state);
+	fb = plane->state->fb;
+	if (!fb) {
+		seq_puts(m, "disabled\n");
+		goto out;
+	}
+
+	seq_printf(m, "fb: %p4cc modifier 0x%016llx\n",
+		   &fb->format->format, fb->modifier);
+	dpu_plane_source_print(m, dplane, "source", dpstate->source,
+			       dpstate->use_prefetch);
+	if (dpstate->need_aux_source)
+		dpu_plane_source_print(m, dplane, "aux source",
+				       dpstate->aux_source,
+				       dpstate->use_aux_prefetch);
+out:
+	drm_modeset_unlock(&plane->mutex);
+
+	return 0;
+}
+
 struct dpu_plane *dpu_plane_create(struct drm_device *drm,
 				   unsigned int possible_crtcs,
 				   unsigned int stream_id,
@@ -1017,6 +1273,16 @@ struct dpu_plane *dpu_plane_create(struct drm_device *drm,
 	if (ret)
 		goto err;
 
+	snprintf(dpu_plane->debugfs_name, sizeof(dpu_plane->debugfs_name),
+		 "%s_regs", plane->name);
+	drm_debugfs_add_file(drm, dpu_plane->debugfs_name,
+			     dpu_plane_regs_show, dpu_plane);
+	snprintf(dpu_plane->source_debugfs_name,
+		 sizeof(dpu_plane->source_debugfs_name),
+		 "%s_source", plane->name);
+	drm_debugfs_add_file(drm, dpu_plane->source_debugfs_name,
+			     dpu_plane_source_show, dpu_plane);
+
 	return dpu_plane;
 
 err:
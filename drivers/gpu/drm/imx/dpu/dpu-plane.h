@@ -32,6 +32,14 @@ struct dpu_plane {
 	struct dpu_plane_grp	*grp;
 	struct list_head	head;
 	unsigned int		stream_id;
+
+	/* register groups rewritten or skipped by atomic updates */
+	unsigned int		regs_written;
+	unsigned int		regs_skipped;
+	u64			regs_written_total;
+	u64			regs_skipped_total;
+	char			debugfs_name[32];
+	char			source_debugfs_name[32];
 };
 
 struct dpu_plane_state {
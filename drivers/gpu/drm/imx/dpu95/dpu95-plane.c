@@ -25,6 +25,7 @@
 #define DPU95_PLANE_MAX_PITCH			0x10000
 #define DPU95_PLANE_MAX_PIX_CNT			8192
 #define DPU95_PLANE_MAX_PIX_CNT_WITH_SCALER	2048
+#define DPU95_PLANE_MAX_DOWNSCALE		2
 
 static const uint32_t dpu95_plane_formats[] = {
 	DRM_FORMAT_ARGB8888,
@@ -104,6 +105,11 @@ static void dpu95_drm_atomic_plane_destroy_state(struct drm_plane *plane,
 	kfree(to_dpu95_plane_state(state));
 }
 
+/*
+ * The fetch units only read linear raster buffers; unlike the i.MX8 DPU
+ * there is no PRG/DPRC prefetch stage in front of them to resolve GPU tiles
+ * or decompress, so such buffers must be resolved before scanout.
+ */
 static bool dpu95_drm_plane_format_mod_supported(struct drm_plane *plane,
 						 uint32_t format,
 						 uint64_t modifier)
@@ -182,7 +188,7 @@ static int dpu95_plane_check_max_source_resolution(struct drm_plane_state *state
 	u32 dst_w = drm_rect_width(&state->dst);
 	u32 dst_h = drm_rect_height(&state->dst);
 
-	if (src_w == dst_w || src_h == dst_h) {
+	if (src_w == dst_w && src_h == dst_h) {
 		/* without scaling */
 		if (src_w > DPU95_PLANE_MAX_PIX_CNT ||
 		    src_h > DPU95_PLANE_MAX_PIX_CNT) {
@@ -341,7 +347,7 @@ static int dpu95_plane_atomic_check(struct drm_plane *plane,
 				to_dpu95_plane_state(new_plane_state);
 	struct drm_framebuffer *fb = new_plane_state->fb;
 	struct drm_crtc_state *crtc_state;
-	int min_scale, ret;
+	int min_scale, max_scale, ret;
 
 	/* ok to disable */
 	if (!fb) {
@@ -362,8 +368,9 @@ static int dpu95_plane_atomic_check(struct drm_plane *plane,
 		return -EINVAL;
 
 	min_scale = FRAC_16_16(1, DPU95_PLANE_MAX_PIX_CNT_WITH_SCALER);
+	max_scale = FRAC_16_16(DPU95_PLANE_MAX_DOWNSCALE, 1);
 	ret = drm_atomic_helper_check_plane_state(new_plane_state, crtc_state,
-						  min_scale, DRM_PLANE_NO_SCALING,
+						  min_scale, max_scale,
 						  true, false);
 	if (ret) {
 		dpu95_plane_dbg(plane, "failed to check plane state: %d\n", ret);
@@ -419,9 +426,10 @@ static void dpu95_plane_atomic_update(struct drm_plane *plane,
 	dma_addr_t baseaddr, uv_baseaddr;
 	enum dpu95_link_id fu_link;
 	enum dpu95_link_id lb_src_link, stage_link;
-	enum dpu95_link_id vs_link;
+	enum dpu95_link_id vs_src_link, hs_src_link;
 	unsigned int src_w, src_h, dst_w, dst_h;
 	bool need_fetcheco = false, need_hscaler = false, need_vscaler = false;
+	bool hs_first;
 
 	/*
 	 * Do nothing since the plane is disabled by
@@ -483,8 +491,8 @@ static void dpu95_plane_atomic_update(struct drm_plane *plane,
 
 		fu_ops->set_pec_dynamic_src_sel(fu, fe_ops->get_link_id(fe));
 
-		fe_ops->set_numbuffers(fu, 16);
-		fe_ops->set_burstlength(fu, 16);
+		fe_ops->set_numbuffers(fe, 16);
+		fe_ops->set_burstlength(fe, 16);
 		fe_ops->set_src_stride(fe, fb->pitches[1]);
 		fe_ops->set_fmt(fe, fb->format, new_state->color_encoding,
 				new_state->color_range);
@@ -500,50 +508,67 @@ static void dpu95_plane_atomic_update(struct drm_plane *plane,
 			fu_ops->set_pec_dynamic_src_sel(fu, DPU95_LINK_ID_NONE);
 	}
 
-	/* VScaler comes first */
-	if (need_vscaler) {
-		struct dpu95_vscaler *vs = fu_ops->get_vscaler(fu);
-		const struct dpu95_vscaler_ops *vs_ops;
-
-		dpu95_vs_pec_dynamic_src_sel(vs, fu_link);
-		dpu95_vs_pec_clken(vs, CLKEN_AUTOMATIC);
-		dpu95_vs_setup1(vs, src_h, new_state->crtc_h);
-		dpu95_vs_setup2(vs);
-		dpu95_vs_output_size(vs, dst_h);
-		dpu95_vs_filter_mode(vs, new_state->scaling_filter);
-		dpu95_vs_scale_mode(vs, SCALER_UPSCALE);
-		dpu95_vs_mode(vs, SCALER_ACTIVE);
-
-		vs_ops = dpu95_vs_get_ops(vs);
-		vs_ops->set_stream_id(vs, dpu_crtc->stream_id);
-
-		vs_link = dpu95_vs_get_link_id(vs);
-		lb_src_link = vs_link;
-
-		dpu95_plane_dbg(plane, "uses VScaler%u\n", dpu95_vs_get_id(vs));
-	}
+	/*
+	 * For horizontal downscaling HScaler comes first, so that VScaler's
+	 * line buffers only see the narrower output lines.  Otherwise,
+	 * VScaler comes first and HScaler works on the fewest input pixels.
+	 */
+	hs_first = need_hscaler && src_w > dst_w;
+	vs_src_link = fu_link;
+	hs_src_link = fu_link;
 
-	/* and then, HScaler */
 	if (need_hscaler) {
 		struct dpu95_hscaler *hs = fu_ops->get_hscaler(fu);
 		const struct dpu95_hscaler_ops *hs_ops;
 
-		dpu95_hs_pec_dynamic_src_sel(hs, need_vscaler ? vs_link : fu_link);
 		dpu95_hs_pec_clken(hs, CLKEN_AUTOMATIC);
 		dpu95_hs_setup1(hs, src_w, dst_w);
 		dpu95_hs_output_size(hs, dst_w);
 		dpu95_hs_filter_mode(hs, new_state->scaling_filter);
-		dpu95_hs_scale_mode(hs, SCALER_UPSCALE);
+		dpu95_hs_scale_mode(hs, src_w > dst_w ?
+				    SCALER_DOWNSCALE : SCALER_UPSCALE);
 		dpu95_hs_mode(hs, SCALER_ACTIVE);
 
 		hs_ops = dpu95_hs_get_ops(hs);
 		hs_ops->set_stream_id(hs, dpu_crtc->stream_id);
 
-		lb_src_link = dpu95_hs_get_link_id(hs);
+		if (hs_first)
+			vs_src_link = dpu95_hs_get_link_id(hs);
+		if (!hs_first || !need_vscaler)
+			lb_src_link = dpu95_hs_get_link_id(hs);
 
 		dpu95_plane_dbg(plane, "uses HScaler%u\n", dpu95_hs_get_id(hs));
 	}
 
+	if (need_vscaler) {
+		struct dpu95_vscaler *vs = fu_ops->get_vscaler(fu);
+		const struct dpu95_vscaler_ops *vs_ops;
+
+		dpu95_vs_pec_dynamic_src_sel(vs, vs_src_link);
+		dpu95_vs_pec_clken(vs, CLKEN_AUTOMATIC);
+		dpu95_vs_setup1(vs, src_h, dst_h);
+		dpu95_vs_setup2(vs);
+		dpu95_vs_output_size(vs, dst_h);
+		dpu95_vs_filter_mode(vs, new_state->scaling_filter);
+		dpu95_vs_scale_mode(vs, src_h > dst_h ?
+				    SCALER_DOWNSCALE : SCALER_UPSCALE);
+		dpu95_vs_mode(vs, SCALER_ACTIVE);
+
+		vs_ops = dpu95_vs_get_ops(vs);
+		vs_ops->set_stream_id(vs, dpu_crtc->stream_id);
+
+		if (!hs_first)
+			hs_src_link = dpu95_vs_get_link_id(vs);
+		if (hs_first || !need_hscaler)
+			lb_src_link = dpu95_vs_get_link_id(vs);
+
+		dpu95_plane_dbg(plane, "uses VScaler%u\n", dpu95_vs_get_id(vs));
+	}
+
+	if (need_hscaler)
+		dpu95_hs_pec_dynamic_src_sel(fu_ops->get_hscaler(fu),
+					     hs_src_link);
+
 	if (new_state->normalized_zpos == 0)
 		stage_link = dpu95_cf_get_link_id(new_dpstate->stage.cf);
 	else
@@ -15,6 +15,7 @@
 #include <video/imx-lcdif.h>
 #include <video/imx-lcdifv3.h>
 
+#include <drm/drm_aperture.h>
 #include <drm/drm_atomic.h>
 #include <drm/drm_atomic_helper.h>
 #include <drm/drm_drv.h>
@@ -118,6 +119,8 @@ static const struct drm_driver imx_drm_dpu_driver = {
 	.driver_features	= DRIVER_MODESET | DRIVER_GEM | DRIVER_ATOMIC |
 				  DRIVER_RENDER,
 	DRM_GEM_DMA_DRIVER_OPS,
+	.open			= imx_drm_dpu_open,
+	.postclose		= imx_drm_dpu_postclose,
 	.ioctls			= imx_drm_dpu_ioctls,
 	.num_ioctls		= ARRAY_SIZE(imx_drm_dpu_ioctls),
 	.fops			= &imx_drm_driver_fops,
@@ -296,6 +299,15 @@ static int imx_drm_bind(struct device *dev)
 	if (IS_ERR(drm))
 		return PTR_ERR(drm);
 
+	/*
+	 * A simple-framebuffer the bootloader described for its splash
+	 * screen scans out of the same pipe the CRTCs adopt when binding,
+	 * so its driver has to let go of it first.
+	 */
+	ret = drm_aperture_remove_framebuffers(drm->driver);
+	if (ret)
+		goto err_kms;
+
 	/*
 	 * set max width and height as default value(4096x4096).
 	 * this value would be used to check framebuffer size limitation
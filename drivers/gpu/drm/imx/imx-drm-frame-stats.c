@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright 2026 NXP
+ *
+ * Page-flip pacing statistics shared by the i.MX CRTC drivers: the
+ * latency from ->atomic_flush() to the vblank which signals the flip,
+ * vblanks missed between the two and the jitter of the flip interval.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/limits.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
+
+#include <drm/drm_crtc.h>
+#include <drm/drm_vblank.h>
+
+#include "imx-drm-frame-stats.h"
+
+#define CREATE_TRACE_POINTS
+#include "imx-drm-trace.h"
+
+static void imx_drm_frame_stats_reset(struct imx_drm_frame_stats *stats)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->last_flip = 0;
+	stats->last_interval_ns = 0;
+	stats->flips = 0;
+	stats->late_flips = 0;
+	stats->missed_vblanks = 0;
+	stats->latency_last_ns = 0;
+	stats->latency_min_ns = S64_MAX;
+	stats->latency_max_ns = 0;
+	stats->latency_total_ns = 0;
+	stats->jitter_max_ns = 0;
+	stats->jitter_total_ns = 0;
+	stats->jitter_samples = 0;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+void imx_drm_frame_stats_init(struct imx_drm_frame_stats *stats)
+{
+	spin_lock_init(&stats->lock);
+	stats->pending = false;
+	imx_drm_frame_stats_reset(stats);
+}
+EXPORT_SYMBOL_GPL(imx_drm_frame_stats_init);
+
+/* Call with the commit's vblank event taken, before the event fires. */
+void imx_drm_frame_stats_arm(struct imx_drm_frame_stats *stats,
+			     struct drm_crtc *crtc)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->pending = true;
+	stats->arm_time = ktime_get();
+	stats->target_seq = drm_crtc_vblank_count(crtc) + 1;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	trace_imx_drm_flip_arm(crtc->base.id, stats->target_seq);
+}
+EXPORT_SYMBOL_GPL(imx_drm_frame_stats_arm);
+
+/*
+ * Call from the vblank interrupt after drm_crtc_handle_vblank(), or where
+ * the armed event is sent.  Vblanks before the armed target are ignored.
+ */
+void imx_drm_frame_stats_flip(struct imx_drm_frame_stats *stats,
+			      struct drm_crtc *crtc)
+{
+	s64 latency, interval, jitter = -1;
+	unsigned long flags;
+	unsigned int missed;
+	ktime_t vbltime;
+	u64 seq;
+
+	seq = drm_crtc_vblank_count_and_time(crtc, &vbltime);
+
+	spin_lock_irqsave(&stats->lock, flags);
+	if (!stats->pending || seq < stats->target_seq) {
+		spin_unlock_irqrestore(&stats->lock, flags);
+		return;
+	}
+
+	stats->pending = false;
+
+	latency = ktime_to_ns(ktime_sub(vbltime, stats->arm_time));
+	missed = seq - stats->target_seq;
+
+	interval = stats->last_flip ?
+		   ktime_to_ns(ktime_sub(vbltime, stats->last_flip)) : 0;
+	if (interval && stats->last_interval_ns)
+		jitter = abs(interval - stats->last_interval_ns);
+
+	stats->last_flip = vbltime;
+	stats->last_interval_ns = interval;
+
+	stats->flips++;
+	if (missed)
+		stats->late_flips++;
+	stats->missed_vblanks += missed;
+
+	stats->latency_last_ns = latency;
+	stats->latency_min_ns = min(stats->latency_min_ns, latency);
+	stats->latency_max_ns = max(stats->latency_max_ns, latency);
+	stats->latency_total_ns += latency;
+
+	if (jitter >= 0) {
+		stats->jitter_max_ns = max(stats->jitter_max_ns, jitter);
+		stats->jitter_total_ns += jitter;
+		stats->jitter_samples++;
+	}
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	trace_imx_drm_flip_done(crtc->base.id, seq, latency, missed, interval);
+}
+EXPORT_SYMBOL_GPL(imx_drm_frame_stats_flip);
+
+static int imx_drm_frame_stats_show(struct seq_file *m, void *data)
+{
+	struct imx_drm_frame_stats *stats = m->private;
+	struct imx_drm_frame_stats s;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	s = *stats;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	seq_printf(m, "flips:\t\t\t%llu\n", s.flips);
+	seq_printf(m, "late flips:\t\t%llu\n", s.late_flips);
+	seq_printf(m, "missed vblanks:\t\t%llu\n", s.missed_vblanks);
+
+	if (!s.flips)
+		return 0;
+
+	seq_printf(m, "latency last (ns):\t%lld\n", s.latency_last_ns);
+	seq_printf(m, "latency min (ns):\t%lld\n", s.latency_min_ns);
+	seq_printf(m, "latency max (ns):\t%lld\n", s.latency_max_ns);
+	seq_printf(m, "latency avg (ns):\t%lld\n",
+		   div64_s64(s.latency_total_ns, s.flips));
+	seq_printf(m, "flip interval (ns):\t%lld\n", s.last_interval_ns);
+
+	if (!s.jitter_samples)
+		return 0;
+
+	seq_printf(m, "jitter max (ns):\t%lld\n", s.jitter_max_ns);
+	seq_printf(m, "jitter avg (ns):\t%lld\n",
+		   div64_s64(s.jitter_total_ns, s.jitter_samples));
+
+	return 0;
+}
+
+static int imx_drm_frame_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, imx_drm_frame_stats_show, inode->i_private);
+}
+
+/* any write clears the statistics */
+static ssize_t imx_drm_frame_stats_write(struct file *file,
+					 const char __user *ubuf,
+					 size_t len, loff_t *offp)
+{
+	struct seq_file *m = file->private_data;
+
+	imx_drm_frame_stats_reset(m->private);
+
+	return len;
+}
+
+static const struct file_operations imx_drm_frame_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = imx_drm_frame_stats_open,
+	.read = seq_read,
+	.write = imx_drm_frame_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/* Call from drm_crtc_funcs.late_register, once crtc->debugfs_entry exists. */
+int imx_drm_frame_stats_late_register(struct imx_drm_frame_stats *stats,
+				      struct drm_crtc *crtc)
+{
+	debugfs_create_file("frame_stats", 0644, crtc->debugfs_entry, stats,
+			    &imx_drm_frame_stats_fops);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(imx_drm_frame_stats_late_register);
+
+MODULE_DESCRIPTION("i.MX DRM page-flip pacing statistics");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Copyright 2026 NXP
+ */
+
+#ifndef _IMX_DRM_FRAME_STATS_H_
+#define _IMX_DRM_FRAME_STATS_H_
+
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
+
+struct drm_crtc;
+
+/*
+ * Per-CRTC page-flip pacing statistics.
+ *
+ * A flip is armed when the CRTC takes the commit's vblank event in
+ * ->atomic_flush() and completes on the first vblank at or after the
+ * one following the arm, which is when the event is signalled.
+ */
+struct imx_drm_frame_stats {
+	spinlock_t	lock;
+
+	bool		pending;
+	ktime_t		arm_time;
+	u64		target_seq;
+
+	ktime_t		last_flip;
+	s64		last_interval_ns;
+
+	u64		flips;
+	u64		late_flips;
+	u64		missed_vblanks;
+
+	s64		latency_last_ns;
+	s64		latency_min_ns;
+	s64		latency_max_ns;
+	s64		latency_total_ns;
+
+	s64		jitter_max_ns;
+	s64		jitter_total_ns;
+	u64		jitter_samples;
+};
+
+#if IS_ENABLED(CONFIG_DRM_IMX_FRAME_STATS)
+void imx_drm_frame_stats_init(struct imx_drm_frame_stats *stats);
+void imx_drm_frame_stats_arm(struct imx_drm_frame_stats *stats,
+			     struct drm_crtc *crtc);
+void imx_drm_frame_stats_flip(struct imx_drm_frame_stats *stats,
+			      struct drm_crtc *crtc);
+int imx_drm_frame_stats_late_register(struct imx_drm_frame_stats *stats,
+				      struct drm_crtc *crtc);
+#else
+static inline void imx_drm_frame_stats_init(struct imx_drm_frame_stats *stats)
+{
+}
+
+static inline void imx_drm_frame_stats_arm(struct imx_drm_frame_stats *stats,
+					   struct drm_crtc *crtc)
+{
+}
+
+static inline void imx_drm_frame_stats_flip(struct imx_drm_frame_stats *stats,
+					    struct drm_crtc *crtc)
+{
+}
+
+static inline int
+imx_drm_frame_stats_late_register(struct imx_drm_frame_stats *stats,
+				  struct drm_crtc *crtc)
+{
+	return 0;
+}
+#endif
+
+#endif /* _IMX_DRM_FRAME_STATS_H_ */
@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Copyright 2026 NXP
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM imx_drm
+
+#if !defined(_IMX_DRM_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _IMX_DRM_TRACE_H_
+
+#include <linux/tracepoint.h>
+#include <linux/types.h>
+
+TRACE_EVENT(imx_drm_flip_arm,
+	TP_PROTO(unsigned int crtc_id, u64 target_seq),
+	TP_ARGS(crtc_id, target_seq),
+	TP_STRUCT__entry(
+		__field(unsigned int, crtc_id)
+		__field(u64, target_seq)
+	),
+	TP_fast_assign(
+		__entry->crtc_id = crtc_id;
+		__entry->target_seq = target_seq;
+	),
+	TP_printk("crtc=%u target_seq=%llu",
+		  __entry->crtc_id, __entry->target_seq)
+);
+
+TRACE_EVENT(imx_drm_flip_done,
+	TP_PROTO(unsigned int crtc_id, u64 seq, s64 latency_ns,
+		 unsigned int missed, s64 interval_ns),
+	TP_ARGS(crtc_id, seq, latency_ns, missed, interval_ns),
+	TP_STRUCT__entry(
+		__field(unsigned int, crtc_id)
+		__field(u64, seq)
+		__field(s64, latency_ns)
+		__field(unsigned int, missed)
+		__field(s64, interval_ns)
+	),
+	TP_fast_assign(
+		__entry->crtc_id = crtc_id;
+		__entry->seq = seq;
+		__entry->latency_ns = latency_ns;
+		__entry->missed = missed;
+		__entry->interval_ns = interval_ns;
+	),
+	TP_printk("crtc=%u seq=%llu latency=%lldns missed=%u interval=%lldns",
+		  __entry->crtc_id, __entry->seq, __entry->latency_ns,
+		  __entry->missed, __entry->interval_ns)
+);
+
+#endif /* _IMX_DRM_TRACE_H_ */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_PATH .
+#define TRACE_INCLUDE_FILE imx-drm-trace
+#include <trace/define_trace.h>
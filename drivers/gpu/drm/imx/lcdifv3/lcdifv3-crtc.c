@@ -18,6 +18,7 @@
 #include <video/videomode.h>
 
 #include "imx-drm.h"
+#include "imx-drm-frame-stats.h"
 #include "lcdifv3-plane.h"
 #include "lcdifv3-kms.h"
 
@@ -29,10 +30,38 @@ struct lcdifv3_crtc {
 
 	int vbl_irq;
 	u32 pix_fmt;		/* drm fourcc */
+
+	struct imx_drm_frame_stats frame_stats;
 };
 
 #define to_lcdifv3_crtc(crtc) container_of(crtc, struct lcdifv3_crtc, base)
 
+#define LCDIFV3_CRTC_VM_FLAGS	(DISPLAY_FLAGS_HSYNC_LOW |		\
+				 DISPLAY_FLAGS_VSYNC_LOW |		\
+				 DISPLAY_FLAGS_DE_LOW |			\
+				 DISPLAY_FLAGS_PIXDATA_NEGEDGE)
+
+/*
+ * Whether the bootloader's timings are the ones requested, allowing for
+ * the pixel clock rate the bootloader could get from the PLL.
+ */
+static bool lcdifv3_crtc_vm_matches(const struct videomode *vm,
+				    const struct videomode *boot_vm)
+{
+	return vm->hactive == boot_vm->hactive &&
+	       vm->hfront_porch == boot_vm->hfront_porch &&
+	       vm->hback_porch == boot_vm->hback_porch &&
+	       vm->hsync_len == boot_vm->hsync_len &&
+	       vm->vactive == boot_vm->vactive &&
+	       vm->vfront_porch == boot_vm->vfront_porch &&
+	       vm->vback_porch == boot_vm->vback_porch &&
+	       vm->vsync_len == boot_vm->vsync_len &&
+	       (vm->flags & LCDIFV3_CRTC_VM_FLAGS) ==
+	       (boot_vm->flags & LCDIFV3_CRTC_VM_FLAGS) &&
+	       abs_diff(vm->pixelclock, boot_vm->pixelclock) <=
+	       vm->pixelclock / 200;
+}
+
 static void lcdifv3_crtc_reset(struct drm_crtc *crtc)
 {
 	struct imx_crtc_state *state;
@@ -129,6 +158,8 @@ static void lcdifv3_crtc_atomic_begin(struct drm_crtc *crtc,
 	spin_lock_irq(&crtc->dev->event_lock);
 	if (crtc->state->event) {
 		WARN_ON(drm_crtc_vblank_get(crtc));
+		imx_drm_frame_stats_arm(&to_lcdifv3_crtc(crtc)->frame_stats,
+					crtc);
 		drm_crtc_arm_vblank_event(crtc, crtc->state->event);
 		crtc->state->event = NULL;
 	}
@@ -153,7 +184,8 @@ static void lcdifv3_crtc_atomic_enable(struct drm_crtc *crtc,
 	struct drm_display_mode *mode = &crtc->state->adjusted_mode;
 	struct imx_crtc_state *imx_crtc_state = to_imx_crtc_state(crtc->state);
 	struct drm_plane_state *plane_state = drm_atomic_get_new_plane_state(state, crtc->primary);
-	struct videomode vm;
+	struct videomode vm, boot_vm;
+	bool adopt;
 
 	drm_display_mode_to_videomode(mode, &vm);
 
@@ -169,7 +201,24 @@ static void lcdifv3_crtc_atomic_enable(struct drm_crtc *crtc,
 
 	pm_runtime_get_sync(lcdifv3_crtc->dev->parent);
 
-	lcdifv3_set_mode(lcdifv3, &vm);
+	/*
+	 * Adopt the pipe the bootloader left running if it already has the
+	 * requested timings, so the plane update below is the only change
+	 * and the splash screen is replaced by a flip.  Otherwise stop it
+	 * before reprogramming the timings and the pixel clock.
+	 */
+	adopt = lcdifv3_handover_get_mode(lcdifv3, &boot_vm);
+	if (adopt) {
+		adopt = lcdifv3_crtc_vm_matches(&vm, &boot_vm);
+		if (!adopt)
+			lcdifv3_disable_controller(lcdifv3);
+		lcdifv3_handover_release(lcdifv3);
+		dev_dbg(lcdifv3_crtc->dev, "%s the bootloader's display pipe\n",
+			adopt ? "adopting" : "resetting");
+	}
+
+	if (!adopt)
+		lcdifv3_set_mode(lcdifv3, &vm);
 
 	/* config LCDIF output bus format */
 	lcdifv3_set_bus_fmt(lcdifv3, imx_crtc_state->bus_format);
@@ -231,6 +280,14 @@ static void lcdifv3_disable_vblank(struct drm_crtc *crtc)
 	lcdifv3_vblank_irq_disable(lcdifv3);
 }
 
+static int lcdifv3_crtc_late_register(struct drm_crtc *crtc)
+{
+	struct lcdifv3_crtc *lcdifv3_crtc = to_lcdifv3_crtc(crtc);
+
+	return imx_drm_frame_stats_late_register(&lcdifv3_crtc->frame_stats,
+						 crtc);
+}
+
 static const struct drm_crtc_funcs lcdifv3_crtc_funcs = {
 	.set_config = drm_atomic_helper_set_config,
 	.destroy    = drm_crtc_cleanup,
@@ -240,6 +297,7 @@ static const struct drm_crtc_funcs lcdifv3_crtc_funcs = {
 	.atomic_destroy_state	= lcdifv3_crtc_destroy_state,
 	.enable_vblank	= lcdifv3_enable_vblank,
 	.disable_vblank = lcdifv3_disable_vblank,
+	.late_register	= lcdifv3_crtc_late_register,
 };
 
 static irqreturn_t lcdifv3_crtc_vblank_irq_handler(int irq, void *dev_id)
@@ -248,6 +306,8 @@ static irqreturn_t lcdifv3_crtc_vblank_irq_handler(int irq, void *dev_id)
 	struct lcdifv3_soc *lcdifv3 = dev_get_drvdata(lcdifv3_crtc->dev->parent);
 
 	drm_crtc_handle_vblank(&lcdifv3_crtc->base);
+	imx_drm_frame_stats_flip(&lcdifv3_crtc->frame_stats,
+				 &lcdifv3_crtc->base);
 
 	lcdifv3_vblank_irq_clear(lcdifv3);
 
@@ -274,6 +334,8 @@ static int lcdifv3_crtc_init(struct lcdifv3_crtc *lcdifv3_crtc,
 
 	/* TODO: Overlay plane */
 
+	imx_drm_frame_stats_init(&lcdifv3_crtc->frame_stats);
+
 	lcdifv3_crtc->base.port = pdata->of_node;
 	drm_crtc_helper_add(&lcdifv3_crtc->base, &lcdifv3_helper_funcs);
 	ret = drm_crtc_init_with_planes(drm, &lcdifv3_crtc->base,
@@ -333,7 +395,8 @@ static int lcdifv3_crtc_bind(struct device *dev, struct device *master,
 static void lcdifv3_crtc_unbind(struct device *dev, struct device *master,
 			      void *data)
 {
-	/* No special to be done */
+	/* give up a bootloader pipe that was never adopted */
+	lcdifv3_handover_release(dev_get_drvdata(dev->parent));
 }
 
 static const struct component_ops lcdifv3_crtc_ops = {
@@ -27,6 +27,10 @@ static uint32_t lcdifv3_pixel_formats[] = {
 	DRM_FORMAT_ABGR8888,
 	DRM_FORMAT_ARGB1555,
 	DRM_FORMAT_XRGB1555,
+	DRM_FORMAT_YUYV,
+	DRM_FORMAT_YVYU,
+	DRM_FORMAT_UYVY,
+	DRM_FORMAT_VYUY,
 };
 
 static int lcdifv3_plane_atomic_check(struct drm_plane *plane,
@@ -65,6 +69,10 @@ static int lcdifv3_plane_atomic_check(struct drm_plane *plane,
 	if (!plane_state->visible)
 		return -EINVAL;
 
+	/* YCbCr422 macropixels cannot be split */
+	if ((plane_state->src.x1 >> 16) % fb->format->hsub)
+		return -EINVAL;
+
 	/* force 'mode_changed' when fb pitches changed, since
 	 * the pitch related registers configuration of LCDIF
 	 * can not be done when LCDIF is running.
@@ -96,12 +104,16 @@ void lcdifv3_plane_atomic_update(struct drm_plane *plane,
 	 * and the fb pixel format, since the mode set will
 	 * be done in crtc's ->enable() helper func
 	 */
-	if (plane->type == DRM_PLANE_TYPE_PRIMARY)
+	if (plane->type == DRM_PLANE_TYPE_PRIMARY) {
 		lcdifv3_set_pix_fmt(lcdifv3, fb->format->format);
+		lcdifv3_set_csc(lcdifv3, fb->format->format,
+				new_plane_state->color_encoding,
+				new_plane_state->color_range);
+	}
 
 	switch (plane->type) {
 	case DRM_PLANE_TYPE_PRIMARY:
-		/* TODO: only support RGB */
+			/* packed formats only */
 		gem_obj = drm_fb_dma_get_gem_obj(fb, 0);
 		src_off = (new_plane_state->src_y >> 16) * fb->pitches[0] +
 			  (new_plane_state->src_x >> 16) * fb->format->cpp[0];
@@ -191,5 +203,17 @@ struct lcdifv3_plane *lcdifv3_plane_init(struct drm_device *dev,
 		return ERR_PTR(ret);
 	}
 
+	ret = drm_plane_create_color_properties(&lcdifv3_plane->base,
+					BIT(DRM_COLOR_YCBCR_BT601) |
+					BIT(DRM_COLOR_YCBCR_BT709),
+					BIT(DRM_COLOR_YCBCR_LIMITED_RANGE) |
+					BIT(DRM_COLOR_YCBCR_FULL_RANGE),
+					DRM_COLOR_YCBCR_BT709,
+					DRM_COLOR_YCBCR_LIMITED_RANGE);
+	if (ret) {
+		kfree(lcdifv3_plane);
+		return ERR_PTR(ret);
+	}
+
 	return lcdifv3_plane;
 }
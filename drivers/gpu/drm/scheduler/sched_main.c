@@ -72,6 +72,22 @@
  * limit.
  */
 
+/**
+ * DOC: Deadline Hints
+ *
+ * Waiters may attach a deadline to the finished fence of a job with
+ * dma_fence_set_deadline(), e.g. KMS does so for the fences of a commit
+ * targeting the next vblank. Within a run-queue, entities whose next job
+ * carries such a hint are picked before the round robin or FIFO policy is
+ * applied, earliest deadline first, so that jobs blocking scanout don't queue
+ * up behind background work of the same priority.
+ *
+ * This doesn't reorder jobs that already have been handed to the hardware.
+ * Drivers with deep hardware queues can make room for deadline jobs through
+ * update_job_credits by checking for DRM_SCHED_FENCE_FLAG_HAS_DEADLINE_BIT on
+ * the job's finished fence.
+ */
+
 #include <linux/wait.h>
 #include <linux/sched.h>
 #include <linux/completion.h>
@@ -105,6 +121,15 @@ int drm_sched_policy = DRM_SCHED_POLICY_FIFO;
 MODULE_PARM_DESC(sched_policy, "Specify the scheduling policy for entities on a run-queue, " __stringify(DRM_SCHED_POLICY_RR) " = Round Robin, " __stringify(DRM_SCHED_POLICY_FIFO) " = FIFO (default).");
 module_param_named(sched_policy, drm_sched_policy, int, 0444);
 
+static bool drm_sched_deadline = true;
+
+/**
+ * DOC: sched_deadline (bool)
+ * Pick jobs with a fence deadline hint first within a run queue.
+ */
+MODULE_PARM_DESC(sched_deadline, "Pick jobs with a fence deadline first within a run-queue (default: true).");
+module_param_named(sched_deadline, drm_sched_deadline, bool, 0644);
+
 static u32 drm_sched_available_credits(struct drm_gpu_scheduler *sched)
 {
 	u32 credits;
@@ -323,6 +348,83 @@ drm_sched_rq_select_entity_rr(struct drm_gpu_scheduler *sched,
 	return NULL;
 }
 
+/**
+ * drm_sched_job_deadline - Get the deadline hint of a job
+ *
+ * @s_job: the job to check
+ * @deadline: where to store the deadline
+ *
+ * Return true if a deadline was set on the finished fence of @s_job.
+ */
+static bool drm_sched_job_deadline(struct drm_sched_job *s_job,
+				   ktime_t *deadline)
+{
+	struct drm_sched_fence *s_fence = s_job->s_fence;
+	unsigned long flags;
+
+	if (!test_bit(DRM_SCHED_FENCE_FLAG_HAS_DEADLINE_BIT,
+		      &s_fence->finished.flags))
+		return false;
+
+	spin_lock_irqsave(&s_fence->lock, flags);
+	*deadline = s_fence->deadline;
+	spin_unlock_irqrestore(&s_fence->lock, flags);
+
+	return true;
+}
+
+/**
+ * drm_sched_rq_select_entity_deadline - Select the ready entity with the
+ * earliest deadline
+ *
+ * @sched: the gpu scheduler
+ * @rq: scheduler run queue to check.
+ *
+ * Find the ready entity whose next job carries the earliest deadline hint.
+ *
+ * Return an entity if one is found; return an error-pointer (!NULL) if an
+ * entity was found, but the scheduler had insufficient credits to accommodate
+ * its job; return NULL, if no ready entity has a job with a deadline.
+ */
+static struct drm_sched_entity *
+drm_sched_rq_select_entity_deadline(struct drm_gpu_scheduler *sched,
+				    struct drm_sched_rq *rq)
+{
+	struct drm_sched_entity *entity, *best = NULL;
+	ktime_t deadline, best_deadline = 0;
+	struct drm_sched_job *s_job;
+
+	spin_lock(&rq->lock);
+
+	list_for_each_entry(entity, &rq->entities, list) {
+		if (!drm_sched_entity_is_ready(entity))
+			continue;
+
+		s_job = to_drm_sched_job(spsc_queue_peek(&entity->job_queue));
+		if (!drm_sched_job_deadline(s_job, &deadline))
+			continue;
+
+		if (!best || ktime_before(deadline, best_deadline)) {
+			best = entity;
+			best_deadline = deadline;
+		}
+	}
+
+	if (best) {
+		/* Don't let jobs without a deadline take the credits. */
+		if (!drm_sched_can_queue(sched, best)) {
+			spin_unlock(&rq->lock);
+			return ERR_PTR(-ENOSPC);
+		}
+
+		reinit_completion(&best->entity_idle);
+	}
+
+	spin_unlock(&rq->lock);
+
+	return best;
+}
+
 /**
  * drm_sched_rq_select_entity_fifo - Select an entity which provides a job to run
  *
@@ -1055,6 +1157,13 @@ drm_sched_select_entity(struct drm_gpu_scheduler *sched)
 	/* Start with the highest priority.
 	 */
 	for (i = DRM_SCHED_PRIORITY_KERNEL; i < sched->num_rqs; i++) {
+		if (drm_sched_deadline) {
+			entity = drm_sched_rq_select_entity_deadline(sched,
+								     sched->sched_rq[i]);
+			if (entity)
+				break;
+		}
+
 		entity = drm_sched_policy == DRM_SCHED_POLICY_FIFO ?
 			drm_sched_rq_select_entity_fifo(sched, sched->sched_rq[i]) :
 			drm_sched_rq_select_entity_rr(sched, sched->sched_rq[i]);
@@ -373,6 +373,34 @@ int dpu_be_set_fence(struct dpu_bliteng *dpu_be, int fd)
 }
 EXPORT_SYMBOL(dpu_be_set_fence);
 
+/*
+ * Emit a fence behind the commands written so far and return it, it is
+ * signaled by the comctrl interrupt once the command sequencer gets there.
+ */
+struct dma_fence *dpu_be_emit_job_fence(struct dpu_bliteng *dpu_be)
+{
+	struct dpu_be_fence *fence;
+	u64 seqno;
+
+	fence = kzalloc(sizeof(*fence), GFP_KERNEL);
+	if (!fence)
+		return ERR_PTR(-ENOMEM);
+
+	spin_lock_init(&fence->lock);
+	atomic_set(&fence->refcnt, 1);
+
+	seqno = atomic64_inc_return(&dpu_be->seqno);
+	dma_fence_init(&fence->base, &dpu_be_fence_ops, &fence->lock,
+		       dpu_be->context, seqno);
+
+	/* The irq handler drops this reference */
+	dma_fence_get(&fence->base);
+	dpu_be_emit_fence(dpu_be, fence, false);
+
+	return &fence->base;
+}
+EXPORT_SYMBOL(dpu_be_emit_job_fence);
+
 int dpu_be_blit(struct dpu_bliteng *dpu_be,
 	u32 *cmdlist, u32 cmdnum)
 {
@@ -79,6 +79,7 @@ void dpu_be_get(struct dpu_bliteng *dpu_be);
 void dpu_be_put(struct dpu_bliteng *dpu_be);
 int dpu_be_get_fence(struct dpu_bliteng *dpu_be, int dpu_num);
 int dpu_be_set_fence(struct dpu_bliteng *dpu_be, int fd);
+struct dma_fence *dpu_be_emit_job_fence(struct dpu_bliteng *dpu_be);
 int dpu_be_blit(struct dpu_bliteng *dpu_be, u32 *cmdlist, u32 cmdnum);
 int dpu_bliteng_init(struct dpu_bliteng *dpu_bliteng);
 void dpu_bliteng_fini(struct dpu_bliteng *dpu_bliteng);
@@ -68,26 +68,23 @@ int dpu_pxlink_set_dc_sync_mode(struct dpu_soc *dpu, bool enable)
 	return dpu_sc_misc_set_ctrl(dpu, rsc, IMX_SC_C_MODE, enable);
 }
 
-/* KACHUNK_CNT is needed for blit engine */
-static int dpu_sc_misc_set_kachunk_cnt(struct dpu_soc *dpu, u32 cnt)
-{
-	u32 rsc = dpu->id ? IMX_SC_R_DC_1 : IMX_SC_R_DC_0;
-
-	return dpu_sc_misc_set_ctrl(dpu, rsc, IMX_SC_C_KACHUNK_CNT, cnt);
-}
-
 int dpu_sc_misc_init(struct dpu_soc *dpu)
 {
-	int disp_id, ret = 0;
-
-	for (disp_id = 0; disp_id < 2; disp_id++) {
-		ret |= dpu_pxlink_set_mst_addr(dpu, disp_id, 0);
-		ret |= dpu_pxlink_set_mst_enable(dpu, disp_id, false);
-		ret |= dpu_pxlink_set_mst_valid(dpu, disp_id, false);
-		ret |= dpu_pxlink_set_sync_ctrl(dpu, disp_id, false);
-	}
-
-	ret |= dpu_sc_misc_set_kachunk_cnt(dpu, 32);
-
-	return ret;
+	u32 rsc = dpu->id ? IMX_SC_R_DC_1 : IMX_SC_R_DC_0;
+	const struct imx_sc_misc_ctrl ctrls[] = {
+		{ rsc, IMX_SC_C_PXL_LINK_MST1_ADDR, 0 },
+		{ rsc, IMX_SC_C_PXL_LINK_MST1_ENB, false },
+		{ rsc, IMX_SC_C_PXL_LINK_MST1_VLD, false },
+		{ rsc, IMX_SC_C_SYNC_CTRL0, false },
+		{ rsc, IMX_SC_C_PXL_LINK_MST2_ADDR, 0 },
+		{ rsc, IMX_SC_C_PXL_LINK_MST2_ENB, false },
+		{ rsc, IMX_SC_C_PXL_LINK_MST2_VLD, false },
+		{ rsc, IMX_SC_C_SYNC_CTRL1, false },
+		/* KACHUNK_CNT is needed for blit engine */
+		{ rsc, IMX_SC_C_KACHUNK_CNT, 32 },
+	};
+
+	/* one hold of the SCU channel for the whole reset sequence */
+	return imx_sc_misc_set_controls(dpu->dpu_ipc_handle, ctrls,
+					ARRAY_SIZE(ctrls));
 }
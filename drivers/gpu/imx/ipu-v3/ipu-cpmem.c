@@ -236,6 +236,34 @@ void ipu_cpmem_zero(struct ipuv3_channel *ch)
 }
 EXPORT_SYMBOL_GPL(ipu_cpmem_zero);
 
+void ipu_cpmem_save(struct ipuv3_channel *ch, struct ipu_cpmem_snapshot *snap)
+{
+	struct ipu_ch_param __iomem *p = ipu_get_cpmem(ch);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(p->word); i++)
+		__ioread32_copy(snap->data[i], p->word[i].data,
+				ARRAY_SIZE(snap->data[i]));
+}
+EXPORT_SYMBOL_GPL(ipu_cpmem_save);
+
+/*
+ * Write back a parameter memory image saved with ipu_cpmem_save(), so
+ * that a channel set up once can be reprogrammed without going through
+ * the read-modify-write of every field again.
+ */
+void ipu_cpmem_restore(struct ipuv3_channel *ch,
+		       const struct ipu_cpmem_snapshot *snap)
+{
+	struct ipu_ch_param __iomem *p = ipu_get_cpmem(ch);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(p->word); i++)
+		__iowrite32_copy(p->word[i].data, snap->data[i],
+				 ARRAY_SIZE(snap->data[i]));
+}
+EXPORT_SYMBOL_GPL(ipu_cpmem_restore);
+
 void ipu_cpmem_set_resolution(struct ipuv3_channel *ch, int xres, int yres)
 {
 	ipu_ch_param_write_field(ch, IPU_FIELD_FW, xres - 1);
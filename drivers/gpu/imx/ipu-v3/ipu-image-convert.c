@@ -8,6 +8,9 @@
 #include <linux/interrupt.h>
 #include <linux/dma-mapping.h>
 #include <linux/math.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
 
 #include <video/imx-ipu-image-convert.h>
 
@@ -61,8 +64,20 @@
  * With rotation or flipping, tile order changes between input and
  * output image. Tiles are numbered row major from top left to bottom
  * right for both input and output image.
+ *
+ * With the split_tiles module parameter set, a tiled conversion is
+ * shared with a second IC task: the same task on another IPU if there
+ * is one (i.MX6Q/DP), otherwise the other memory-to-memory task of the
+ * same IPU. The second context is a copy of the first one, so both see
+ * the same seams and resizing coefficients, and each converts one half
+ * of the tiles. The caller's run completes once both halves are done.
  */
 
+static bool split_tiles;
+module_param(split_tiles, bool, 0644);
+MODULE_PARM_DESC(split_tiles,
+		 "Share tiled conversions between two IC tasks (default: false)");
+
 #define MAX_STRIPES_W    4
 #define MAX_STRIPES_H    4
 #define MAX_TILES (MAX_STRIPES_W * MAX_STRIPES_H)
@@ -77,6 +92,15 @@ enum ipu_image_convert_type {
 	IMAGE_CONVERT_OUT,
 };
 
+/* the IDMAC channels of a conversion */
+enum ipu_image_convert_idmac {
+	IMAGE_CONVERT_IDMAC_IN = 0,
+	IMAGE_CONVERT_IDMAC_OUT,
+	IMAGE_CONVERT_IDMAC_ROT_IN,
+	IMAGE_CONVERT_IDMAC_ROT_OUT,
+	IMAGE_CONVERT_IDMAC_NUM,
+};
+
 struct ipu_image_convert_dma_buf {
 	void          *virt;
 	dma_addr_t    phys;
@@ -184,12 +208,27 @@ struct ipu_image_convert_ctx {
 	unsigned int num_tiles;
 	/* next tile to process */
 	unsigned int next_tile;
+	/* first and one past the last tile converted by this context */
+	unsigned int first_tile;
+	unsigned int end_tile;
 	/* where to place converted tile in dest image */
 	unsigned int out_tile_map[MAX_TILES];
 
+	/*
+	 * CPMEM images of each IDMAC channel per tile, built on the first
+	 * run and then only patched with the buffer addresses.
+	 */
+	struct ipu_cpmem_snapshot cpmem[IMAGE_CONVERT_IDMAC_NUM][MAX_TILES];
+	u32 cpmem_valid[IMAGE_CONVERT_IDMAC_NUM];
+
 	/* mask of completed EOF irqs at every tile conversion */
 	enum eof_irq_mask eof_mask;
 
+	/* context converting the second half of the tiles */
+	struct ipu_image_convert_ctx *peer;
+	/* this context only converts part of each run */
+	bool split;
+
 	struct list_head list;
 };
 
@@ -227,8 +266,28 @@ struct ipu_image_convert_chan {
 struct ipu_image_convert_priv {
 	struct ipu_image_convert_chan chan[IC_NUM_TASKS];
 	struct ipu_soc *ipu;
+
+	struct list_head list;
 };
 
+struct ipu_image_convert_split;
+
+struct ipu_image_convert_split_half {
+	struct ipu_image_convert_run run;
+	struct ipu_image_convert_split *split;
+};
+
+/* a caller's run, converted by a context and its peer */
+struct ipu_image_convert_split {
+	struct ipu_image_convert_run *run;
+	atomic_t pending;
+	struct ipu_image_convert_split_half half[2];
+};
+
+/* all image converters, to find a peer on another IPU */
+static LIST_HEAD(image_convert_privs);
+static DEFINE_MUTEX(image_convert_privs_lock);
+
 static const struct ipu_image_convert_dma_chan
 image_convert_dma_chan[IC_NUM_TASKS] = {
 	[IC_TASK_VIEWFINDER] = {
@@ -1294,18 +1353,22 @@ static void init_idmac_channel(struct ipu_image_convert_ctx *ctx,
 			       unsigned int tile)
 {
 	struct ipu_image_convert_chan *chan = ctx->chan;
+	enum ipu_image_convert_idmac idmac;
+	struct ipu_cpmem_snapshot *snap;
 	unsigned int burst_size;
 	u32 width, height, stride;
 	dma_addr_t addr0, addr1 = 0;
 	struct ipu_image tile_image;
 	unsigned int tile_idx[2];
+	/* with double-buffering, buffer 1 holds the following tile */
+	unsigned int next = ctx->double_buffering ? tile + 1 : tile;
 
 	if (image->type == IMAGE_CONVERT_OUT) {
 		tile_idx[0] = ctx->out_tile_map[tile];
-		tile_idx[1] = ctx->out_tile_map[1];
+		tile_idx[1] = ctx->out_tile_map[next];
 	} else {
 		tile_idx[0] = tile;
-		tile_idx[1] = 1;
+		tile_idx[1] = next;
 	}
 
 	if (rot_swap_width_height) {
@@ -1326,6 +1389,34 @@ static void init_idmac_channel(struct ipu_image_convert_ctx *ctx,
 				image->tile[tile_idx[1]].offset;
 	}
 
+	if (channel == chan->rotation_in_chan ||
+	    channel == chan->rotation_out_chan)
+		burst_size = 8;
+	else
+		burst_size = (width % 16) ? 8 : 16;
+
+	if (channel == chan->in_chan)
+		idmac = IMAGE_CONVERT_IDMAC_IN;
+	else if (channel == chan->out_chan)
+		idmac = IMAGE_CONVERT_IDMAC_OUT;
+	else if (channel == chan->rotation_in_chan)
+		idmac = IMAGE_CONVERT_IDMAC_ROT_IN;
+	else
+		idmac = IMAGE_CONVERT_IDMAC_ROT_OUT;
+	snap = &ctx->cpmem[idmac][tile];
+
+	/*
+	 * Only the buffer addresses change from run to run, everything
+	 * else in the parameter memory of a tile can be reused as is.
+	 */
+	if (ctx->cpmem_valid[idmac] & BIT(tile)) {
+		ipu_cpmem_restore(channel, snap);
+		ipu_cpmem_set_buffer(channel, 0, addr0);
+		if (ctx->double_buffering)
+			ipu_cpmem_set_buffer(channel, 1, addr1);
+		goto ic_init;
+	}
+
 	ipu_cpmem_zero(channel);
 
 	memset(&tile_image, 0, sizeof(tile_image));
@@ -1355,17 +1446,11 @@ static void init_idmac_channel(struct ipu_image_convert_ctx *ctx,
 		ipu_cpmem_skip_odd_chroma_rows(channel);
 
 	if (channel == chan->rotation_in_chan ||
-	    channel == chan->rotation_out_chan) {
-		burst_size = 8;
+	    channel == chan->rotation_out_chan)
 		ipu_cpmem_set_block_mode(channel);
-	} else
-		burst_size = (width % 16) ? 8 : 16;
 
 	ipu_cpmem_set_burstsize(channel, burst_size);
 
-	ipu_ic_task_idma_init(chan->ic, channel, width, height,
-			      burst_size, rot_mode);
-
 	/*
 	 * Setting a non-zero AXI ID collides with the PRG AXI snooping, so
 	 * only do this when there is no PRG present.
@@ -1373,6 +1458,13 @@ static void init_idmac_channel(struct ipu_image_convert_ctx *ctx,
 	if (!channel->ipu->prg_priv)
 		ipu_cpmem_set_axi_id(channel, 1);
 
+	ipu_cpmem_save(channel, snap);
+	ctx->cpmem_valid[idmac] |= BIT(tile);
+
+ic_init:
+	ipu_ic_task_idma_init(chan->ic, channel, width, height,
+			      burst_size, rot_mode);
+
 	ipu_idmac_set_double_buffer(channel, ctx->double_buffering);
 }
 
@@ -1502,13 +1594,13 @@ static int do_run(struct ipu_image_convert_run *run)
 	ctx->out.base.phys0 = run->out_phys;
 
 	ctx->cur_buf_num = 0;
-	ctx->next_tile = 1;
+	ctx->next_tile = ctx->first_tile + 1;
 
 	/* remove run from pending_q and set as current */
 	list_del(&run->list);
 	chan->current_run = run;
 
-	return convert_start(run, 0);
+	return convert_start(run, ctx->first_tile);
 }
 
 /* hold irqlock when calling */
@@ -1544,6 +1636,23 @@ static void run_next(struct ipu_image_convert_chan *chan)
 	}
 }
 
+static void split_half_complete(struct ipu_image_convert_run *run)
+{
+	struct ipu_image_convert_split_half *half =
+		container_of(run, struct ipu_image_convert_split_half, run);
+	struct ipu_image_convert_split *split = half->split;
+	struct ipu_image_convert_run *parent = split->run;
+
+	if (run->status)
+		WRITE_ONCE(parent->status, run->status);
+
+	if (!atomic_dec_and_test(&split->pending))
+		return;
+
+	parent->ctx->complete(parent, parent->ctx->complete_context);
+	kfree(split);
+}
+
 static void empty_done_q(struct ipu_image_convert_chan *chan)
 {
 	struct ipu_image_convert_priv *priv = chan->priv;
@@ -1565,7 +1674,10 @@ static void empty_done_q(struct ipu_image_convert_chan *chan)
 
 		/* call the completion callback and free the run */
 		spin_unlock_irqrestore(&chan->irqlock, flags);
-		run->ctx->complete(run, run->ctx->complete_context);
+		if (run->ctx->split)
+			split_half_complete(run);
+		else
+			run->ctx->complete(run, run->ctx->complete_context);
 		spin_lock_irqsave(&chan->irqlock, flags);
 	}
 
@@ -1659,7 +1771,7 @@ static irqreturn_t do_tile_complete(struct ipu_image_convert_run *run)
 		goto done;
 	}
 
-	if (ctx->next_tile == ctx->num_tiles) {
+	if (ctx->next_tile == ctx->end_tile) {
 		/*
 		 * the conversion is complete
 		 */
@@ -1698,7 +1810,7 @@ static irqreturn_t do_tile_complete(struct ipu_image_convert_run *run)
 			ipu_idmac_select_buffer(chan->in_chan, 0);
 			ipu_idmac_select_buffer(outch, 0);
 		}
-	} else if (ctx->next_tile < ctx->num_tiles - 1) {
+	} else if (ctx->next_tile < ctx->end_tile - 1) {
 
 		src_tile = &s_image->tile[ctx->next_tile + 1];
 		dst_idx = ctx->out_tile_map[ctx->next_tile + 1];
@@ -2065,6 +2177,107 @@ EXPORT_SYMBOL_GPL(ipu_image_convert_verify);
  * Call ipu_image_convert_prepare() to prepare for the conversion of
  * given images and rotation mode. Returns a new conversion context.
  */
+/*
+ * Create a copy of ctx on another channel, sharing the tile layout so
+ * that both halves of the image meet at the same seams.
+ */
+static struct ipu_image_convert_ctx *
+prepare_peer(struct ipu_image_convert_ctx *ctx,
+	     struct ipu_image_convert_chan *chan)
+{
+	struct ipu_image_convert_priv *priv = chan->priv;
+	struct ipu_image_convert_ctx *peer;
+	unsigned long flags;
+	bool get_res;
+	int i;
+
+	peer = kmemdup(ctx, sizeof(*ctx), GFP_KERNEL);
+	if (!peer)
+		return NULL;
+
+	peer->chan = chan;
+	init_completion(&peer->aborted);
+	/* the CPMEM images depend on the IPU, build them again */
+	memset(peer->cpmem_valid, 0, sizeof(peer->cpmem_valid));
+	memset(peer->rot_intermediate, 0, sizeof(peer->rot_intermediate));
+
+	for (i = 0; i < ARRAY_SIZE(ctx->rot_intermediate); i++) {
+		if (!ctx->rot_intermediate[i].virt)
+			continue;
+		if (alloc_dma_buf(priv, &peer->rot_intermediate[i],
+				  ctx->rot_intermediate[i].len))
+			goto out_free;
+	}
+
+	spin_lock_irqsave(&chan->irqlock, flags);
+	get_res = list_empty(&chan->ctx_list);
+	list_add_tail(&peer->list, &chan->ctx_list);
+	spin_unlock_irqrestore(&chan->irqlock, flags);
+
+	if (get_res && get_ipu_resources(chan)) {
+		spin_lock_irqsave(&chan->irqlock, flags);
+		list_del(&peer->list);
+		spin_unlock_irqrestore(&chan->irqlock, flags);
+		goto out_free;
+	}
+
+	return peer;
+
+out_free:
+	free_dma_buf(priv, &peer->rot_intermediate[1]);
+	free_dma_buf(priv, &peer->rot_intermediate[0]);
+	kfree(peer);
+	return NULL;
+}
+
+/*
+ * Hand the second half of the tiles to a peer context. Failing to find
+ * a free IC task is not an error, the conversion then simply isn't split.
+ */
+static void split_ctx(struct ipu_image_convert_ctx *ctx)
+{
+	struct ipu_image_convert_chan *chan = ctx->chan;
+	struct ipu_image_convert_ctx *peer = NULL;
+	struct ipu_image_convert_priv *priv;
+	enum ipu_ic_task other_task;
+
+	/* prefer the same task on another IPU, it runs fully in parallel */
+	mutex_lock(&image_convert_privs_lock);
+	list_for_each_entry(priv, &image_convert_privs, list) {
+		if (priv == chan->priv)
+			continue;
+		peer = prepare_peer(ctx, &priv->chan[chan->ic_task]);
+		if (peer)
+			break;
+	}
+	mutex_unlock(&image_convert_privs_lock);
+
+	/* otherwise time-share the IC with the other task of this IPU */
+	if (!peer) {
+		other_task = (chan->ic_task == IC_TASK_VIEWFINDER) ?
+			IC_TASK_POST_PROCESSOR : IC_TASK_VIEWFINDER;
+		peer = prepare_peer(ctx, &chan->priv->chan[other_task]);
+	}
+	if (!peer)
+		return;
+
+	ctx->end_tile = ctx->num_tiles / 2;
+	peer->first_tile = ctx->end_tile;
+
+	/* double-buffering needs at least two tiles in each half */
+	ctx->double_buffering &= ctx->end_tile - ctx->first_tile > 1;
+	peer->double_buffering &= peer->end_tile - peer->first_tile > 1;
+
+	ctx->split = peer->split = true;
+	ctx->peer = peer;
+
+	dev_dbg(chan->priv->ipu->dev,
+		"%s: task %u: ctx %p tiles %u-%u, peer %p on %s task %u\n",
+		__func__, chan->ic_task, ctx, ctx->first_tile,
+		ctx->end_tile - 1, peer, dev_name(peer->chan->priv->ipu->dev),
+		peer->chan->ic_task);
+}
+
 struct ipu_image_convert_ctx *
 ipu_image_convert_prepare(struct ipu_soc *ipu, enum ipu_ic_task ic_task,
 			  struct ipu_image *in, struct ipu_image *out,
@@ -2126,6 +2339,8 @@ ipu_image_convert_prepare(struct ipu_soc *ipu, enum ipu_ic_task ic_task,
 	}
 
 	ctx->num_tiles = d_image->num_cols * d_image->num_rows;
+	ctx->first_tile = 0;
+	ctx->end_tile = ctx->num_tiles;
 
 	ret = fill_image(ctx, s_image, in, IMAGE_CONVERT_IN);
 	if (ret)
@@ -2242,6 +2457,9 @@ ipu_image_convert_prepare(struct ipu_soc *ipu, enum ipu_ic_task ic_task,
 			goto out_free_dmabuf1;
 	}
 
+	if (split_tiles && ctx->num_tiles > 1)
+		split_ctx(ctx);
+
 	return ctx;
 
 out_free_dmabuf1:
@@ -2257,12 +2475,7 @@ ipu_image_convert_prepare(struct ipu_soc *ipu, enum ipu_ic_task ic_task,
 }
 EXPORT_SYMBOL_GPL(ipu_image_convert_prepare);
 
-/*
- * Carry out a single image conversion run. Only the physaddr's of the input
- * and output image buffers are needed. The conversion context must have
- * been created previously with ipu_image_convert_prepare().
- */
-int ipu_image_convert_queue(struct ipu_image_convert_run *run)
+static int queue_run(struct ipu_image_convert_run *run)
 {
 	struct ipu_image_convert_chan *chan;
 	struct ipu_image_convert_priv *priv;
@@ -2270,9 +2483,6 @@ int ipu_image_convert_queue(struct ipu_image_convert_run *run)
 	unsigned long flags;
 	int ret = 0;
 
-	if (!run || !run->ctx || !run->in_phys || !run->out_phys)
-		return -EINVAL;
-
 	ctx = run->ctx;
 	chan = ctx->chan;
 	priv = chan->priv;
@@ -2300,6 +2510,62 @@ int ipu_image_convert_queue(struct ipu_image_convert_run *run)
 	spin_unlock_irqrestore(&chan->irqlock, flags);
 	return ret;
 }
+
+/*
+ * Carry out a single image conversion run. Only the physaddr's of the input
+ * and output image buffers are needed. The conversion context must have
+ * been created previously with ipu_image_convert_prepare().
+ */
+int ipu_image_convert_queue(struct ipu_image_convert_run *run)
+{
+	struct ipu_image_convert_split *split;
+	struct ipu_image_convert_ctx *ctx;
+	int i, ret;
+
+	if (!run || !run->ctx || !run->in_phys || !run->out_phys)
+		return -EINVAL;
+
+	ctx = run->ctx;
+	if (!ctx->peer)
+		return queue_run(run);
+
+	split = kzalloc(sizeof(*split), GFP_ATOMIC);
+	if (!split)
+		return -ENOMEM;
+
+	INIT_LIST_HEAD(&run->list);
+	run->status = 0;
+	split->run = run;
+	atomic_set(&split->pending, ARRAY_SIZE(split->half));
+
+	for (i = 0; i < ARRAY_SIZE(split->half); i++) {
+		split->half[i].split = split;
+		split->half[i].run.ctx = i ? ctx->peer : ctx;
+		split->half[i].run.in_phys = run->in_phys;
+		split->half[i].run.out_phys = run->out_phys;
+	}
+
+	ret = queue_run(&split->half[0].run);
+	if (ret) {
+		kfree(split);
+		return ret;
+	}
+
+	ret = queue_run(&split->half[1].run);
+	if (ret) {
+		/*
+		 * The first half is already converting, its completion
+		 * reports the error unless it has finished in the meantime.
+		 */
+		WRITE_ONCE(run->status, ret);
+		if (!atomic_dec_and_test(&split->pending))
+			return 0;
+		kfree(split);
+		return ret;
+	}
+
+	return 0;
+}
 EXPORT_SYMBOL_GPL(ipu_image_convert_queue);
 
 /* Abort any active or pending conversions for this context */
@@ -2359,6 +2625,10 @@ static void __ipu_image_convert_abort(struct ipu_image_convert_ctx *ctx)
 void ipu_image_convert_abort(struct ipu_image_convert_ctx *ctx)
 {
 	__ipu_image_convert_abort(ctx);
+	if (ctx->peer) {
+		__ipu_image_convert_abort(ctx->peer);
+		ctx->peer->aborting = false;
+	}
 	ctx->aborting = false;
 }
 EXPORT_SYMBOL_GPL(ipu_image_convert_abort);
@@ -2374,6 +2644,9 @@ void ipu_image_convert_unprepare(struct ipu_image_convert_ctx *ctx)
 	/* make sure no runs are hanging around */
 	__ipu_image_convert_abort(ctx);
 
+	if (ctx->peer)
+		ipu_image_convert_unprepare(ctx->peer);
+
 	dev_dbg(priv->ipu->dev, "%s: task %u: removing ctx %p\n", __func__,
 		chan->ic_task, ctx);
 
@@ -2500,9 +2773,18 @@ int ipu_image_convert_init(struct ipu_soc *ipu, struct device *dev)
 		INIT_LIST_HEAD(&chan->done_q);
 	}
 
+	mutex_lock(&image_convert_privs_lock);
+	list_add_tail(&priv->list, &image_convert_privs);
+	mutex_unlock(&image_convert_privs_lock);
+
 	return 0;
 }
 
 void ipu_image_convert_exit(struct ipu_soc *ipu)
 {
+	struct ipu_image_convert_priv *priv = ipu->image_convert_priv;
+
+	mutex_lock(&image_convert_privs_lock);
+	list_del(&priv->list);
+	mutex_unlock(&image_convert_privs_lock);
 }
@@ -42,6 +42,10 @@ struct lcdifv3_soc {
 	u32 thres_low_div;
 	u32 thres_high_mul;
 	u32 thres_high_div;
+
+	/* a pipe left running by the bootloader, not adopted yet */
+	bool handover;
+	struct videomode handover_vm;
 };
 
 struct lcdifv3_soc_pdata {
@@ -82,6 +86,11 @@ static const struct of_device_id imx_lcdifv3_dt_ids[] = {
 };
 MODULE_DEVICE_TABLE(of, imx_lcdifv3_dt_ids);
 
+static bool handover = true;
+module_param(handover, bool, 0444);
+MODULE_PARM_DESC(handover,
+		 "Adopt a display pipe left running by the bootloader (default: true)");
+
 static int lcdifv3_enable_clocks(struct lcdifv3_soc *lcdifv3)
 {
 	int ret;
@@ -280,6 +289,22 @@ int lcdifv3_set_pix_fmt(struct lcdifv3_soc *lcdifv3, u32 format)
 	case DRM_FORMAT_XBGR8888:
 		ctrldescl0_5 |= CTRLDESCL0_5_BPP(BPP32_ABGR8888);
 		break;
+	case DRM_FORMAT_YUYV:
+		ctrldescl0_5 |= CTRLDESCL0_5_BPP(BPP16_YCbCr422) |
+				CTRLDESCL0_5_YUV_FORMAT(YUV_FORMAT_VY2UY1);
+		break;
+	case DRM_FORMAT_YVYU:
+		ctrldescl0_5 |= CTRLDESCL0_5_BPP(BPP16_YCbCr422) |
+				CTRLDESCL0_5_YUV_FORMAT(YUV_FORMAT_UY2VY1);
+		break;
+	case DRM_FORMAT_UYVY:
+		ctrldescl0_5 |= CTRLDESCL0_5_BPP(BPP16_YCbCr422) |
+				CTRLDESCL0_5_YUV_FORMAT(YUV_FORMAT_Y2VY1U);
+		break;
+	case DRM_FORMAT_VYUY:
+		ctrldescl0_5 |= CTRLDESCL0_5_BPP(BPP16_YCbCr422) |
+				CTRLDESCL0_5_YUV_FORMAT(YUV_FORMAT_Y2UY1V);
+		break;
 	default:
 		dev_err(lcdifv3->dev, "unsupported pixel format: %p4cc\n",
 			&format);
@@ -292,6 +317,93 @@ int lcdifv3_set_pix_fmt(struct lcdifv3_soc *lcdifv3, u32 format)
 }
 EXPORT_SYMBOL(lcdifv3_set_pix_fmt);
 
+static const u32 lcdifv3_yuv2rgb_coeffs[][2][6] = {
+	[DRM_COLOR_YCBCR_BT601] = {
+		[DRM_COLOR_YCBCR_LIMITED_RANGE] = {
+			/*
+			 * |R|   |1.1644  0.0000  1.5960|   |Y  - 16 |
+			 * |G| = |1.1644 -0.3917 -0.8129| * |Cb - 128|
+			 * |B|   |1.1644  2.0172  0.0000|   |Cr - 128|
+			 */
+			CSC0_COEF0_A1(0x12a) | CSC0_COEF0_A2(0x000),
+			CSC0_COEF1_A3(0x199) | CSC0_COEF1_B1(0x12a),
+			CSC0_COEF2_B2(0x79c) | CSC0_COEF2_B3(0x730),
+			CSC0_COEF3_C1(0x12a) | CSC0_COEF3_C2(0x204),
+			CSC0_COEF4_C3(0x000) | CSC0_COEF4_D1(0x1f0),
+			CSC0_COEF5_D2(0x180) | CSC0_COEF5_D3(0x180),
+		},
+		[DRM_COLOR_YCBCR_FULL_RANGE] = {
+			/*
+			 * |R|   |1.0000  0.0000  1.4020|   |Y  - 0  |
+			 * |G| = |1.0000 -0.3441 -0.7141| * |Cb - 128|
+			 * |B|   |1.0000  1.7720  0.0000|   |Cr - 128|
+			 */
+			CSC0_COEF0_A1(0x100) | CSC0_COEF0_A2(0x000),
+			CSC0_COEF1_A3(0x167) | CSC0_COEF1_B1(0x100),
+			CSC0_COEF2_B2(0x7a8) | CSC0_COEF2_B3(0x749),
+			CSC0_COEF3_C1(0x100) | CSC0_COEF3_C2(0x1c6),
+			CSC0_COEF4_C3(0x000) | CSC0_COEF4_D1(0x000),
+			CSC0_COEF5_D2(0x180) | CSC0_COEF5_D3(0x180),
+		},
+	},
+	[DRM_COLOR_YCBCR_BT709] = {
+		[DRM_COLOR_YCBCR_LIMITED_RANGE] = {
+			/*
+			 * |R|   |1.1644  0.0000  1.7927|   |Y  - 16 |
+			 * |G| = |1.1644 -0.2132 -0.5329| * |Cb - 128|
+			 * |B|   |1.1644  2.1124  0.0000|   |Cr - 128|
+			 */
+			CSC0_COEF0_A1(0x12a) | CSC0_COEF0_A2(0x000),
+			CSC0_COEF1_A3(0x1cb) | CSC0_COEF1_B1(0x12a),
+			CSC0_COEF2_B2(0x7c9) | CSC0_COEF2_B3(0x778),
+			CSC0_COEF3_C1(0x12a) | CSC0_COEF3_C2(0x21d),
+			CSC0_COEF4_C3(0x000) | CSC0_COEF4_D1(0x1f0),
+			CSC0_COEF5_D2(0x180) | CSC0_COEF5_D3(0x180),
+		},
+		[DRM_COLOR_YCBCR_FULL_RANGE] = {
+			/*
+			 * |R|   |1.0000  0.0000  1.5748|   |Y  - 0  |
+			 * |G| = |1.0000 -0.1873 -0.4681| * |Cb - 128|
+			 * |B|   |1.0000  1.8556  0.0000|   |Cr - 128|
+			 */
+			CSC0_COEF0_A1(0x100) | CSC0_COEF0_A2(0x000),
+			CSC0_COEF1_A3(0x193) | CSC0_COEF1_B1(0x100),
+			CSC0_COEF2_B2(0x7d0) | CSC0_COEF2_B3(0x788),
+			CSC0_COEF3_C1(0x100) | CSC0_COEF3_C2(0x1db),
+			CSC0_COEF4_C3(0x000) | CSC0_COEF4_D1(0x000),
+			CSC0_COEF5_D2(0x180) | CSC0_COEF5_D3(0x180),
+		},
+	},
+};
+
+/*
+ * Convert YCbCr input to the RGB output bus with CSC0,
+ * or bypass it for RGB input.
+ */
+void lcdifv3_set_csc(struct lcdifv3_soc *lcdifv3, u32 format,
+		     enum drm_color_encoding encoding,
+		     enum drm_color_range range)
+{
+	const struct drm_format_info *info = drm_format_info(format);
+	const u32 *coeffs;
+	int i;
+
+	if (!info || !info->is_yuv ||
+	    encoding >= ARRAY_SIZE(lcdifv3_yuv2rgb_coeffs)) {
+		writel(CSC0_CTRL_BYPASS, lcdifv3->base + LCDIFV3_CSC0_CTRL);
+		return;
+	}
+
+	coeffs = lcdifv3_yuv2rgb_coeffs[encoding][range];
+
+	for (i = 0; i < 6; i++)
+		writel(coeffs[i], lcdifv3->base + LCDIFV3_CSC0_COEF0 + i * 4);
+
+	writel(CSC0_CTRL_CSC_MODE(CSC_MODE_YCbCr2RGB),
+	       lcdifv3->base + LCDIFV3_CSC0_CTRL);
+}
+EXPORT_SYMBOL(lcdifv3_set_csc);
+
 void lcdifv3_set_bus_fmt(struct lcdifv3_soc *lcdifv3, u32 bus_format)
 {
 	uint32_t disp_para = 0;
@@ -503,6 +615,82 @@ void lcdifv3_disable_controller(struct lcdifv3_soc *lcdifv3)
 }
 EXPORT_SYMBOL(lcdifv3_disable_controller);
 
+/* The reverse of lcdifv3_set_mode(), with the clocks enabled */
+static void lcdifv3_get_mode(struct lcdifv3_soc *lcdifv3,
+			     struct videomode *vmode)
+{
+	const struct lcdifv3_soc_pdata *soc_pdata;
+	bool hs_inv = false, vs_inv = false, de_inv = false;
+	u32 val, ctrl;
+
+	soc_pdata = of_device_get_match_data(lcdifv3->dev);
+	if (soc_pdata) {
+		hs_inv = soc_pdata->hsync_invert;
+		vs_inv = soc_pdata->vsync_invert;
+		de_inv = soc_pdata->de_invert;
+	}
+
+	memset(vmode, 0, sizeof(*vmode));
+	vmode->pixelclock = clk_get_rate(lcdifv3->clk_pix);
+
+	val = readl(lcdifv3->base + LCDIFV3_DISP_SIZE);
+	vmode->hactive = REG_GET(val, 15, 0);
+	vmode->vactive = REG_GET(val, 31, 16);
+
+	val = readl(lcdifv3->base + LCDIFV3_HSYN_PARA);
+	vmode->hfront_porch = REG_GET(val, 15, 0);
+	vmode->hback_porch  = REG_GET(val, 31, 16);
+
+	val = readl(lcdifv3->base + LCDIFV3_VSYN_PARA);
+	vmode->vfront_porch = REG_GET(val, 15, 0);
+	vmode->vback_porch  = REG_GET(val, 31, 16);
+
+	val = readl(lcdifv3->base + LCDIFV3_VSYN_HSYN_WIDTH);
+	vmode->hsync_len = REG_GET(val, 15, 0);
+	vmode->vsync_len = REG_GET(val, 31, 16);
+
+	ctrl = readl(lcdifv3->base + LCDIFV3_CTRL);
+	vmode->flags |= !!(ctrl & CTRL_INV_HS) != hs_inv ?
+			DISPLAY_FLAGS_HSYNC_LOW : DISPLAY_FLAGS_HSYNC_HIGH;
+	vmode->flags |= !!(ctrl & CTRL_INV_VS) != vs_inv ?
+			DISPLAY_FLAGS_VSYNC_LOW : DISPLAY_FLAGS_VSYNC_HIGH;
+	vmode->flags |= !!(ctrl & CTRL_INV_DE) != de_inv ?
+			DISPLAY_FLAGS_DE_LOW : DISPLAY_FLAGS_DE_HIGH;
+	vmode->flags |= ctrl & CTRL_INV_PXCK ?
+			DISPLAY_FLAGS_PIXDATA_NEGEDGE :
+			DISPLAY_FLAGS_PIXDATA_POSEDGE;
+}
+
+/*
+ * Returns the timings of the pipe the bootloader left running, if the
+ * CRTC has not adopted or released it yet.  The controller keeps scanning
+ * out the bootloader's framebuffer until then.
+ */
+bool lcdifv3_handover_get_mode(struct lcdifv3_soc *lcdifv3,
+			       struct videomode *vmode)
+{
+	if (!lcdifv3->handover)
+		return false;
+
+	*vmode = lcdifv3->handover_vm;
+	return true;
+}
+EXPORT_SYMBOL(lcdifv3_handover_get_mode);
+
+/*
+ * Drops the runtime PM reference that kept the bootloader's pipe running.
+ * The CRTC calls it once it holds its own reference, or gives up the pipe.
+ */
+void lcdifv3_handover_release(struct lcdifv3_soc *lcdifv3)
+{
+	if (!lcdifv3->handover)
+		return;
+
+	lcdifv3->handover = false;
+	pm_runtime_put(lcdifv3->dev);
+}
+EXPORT_SYMBOL(lcdifv3_handover_release);
+
 static int platform_remove_device_fn(struct device *dev, void *data)
 {
 	struct platform_device *pdev = to_platform_device(dev);
@@ -624,6 +812,41 @@ static void imx_lcdifv3_of_parse_thres(struct lcdifv3_soc *lcdifv3)
 	}
 }
 
+/*
+ * Keep a pipe that the bootloader left scanning out a splash screen
+ * running, with its clocks and bus frequency, instead of letting the
+ * unused clocks be gated before the CRTC gets to adopt it.
+ */
+static void imx_lcdifv3_handover_init(struct lcdifv3_soc *lcdifv3)
+{
+	struct device *dev = lcdifv3->dev;
+	u32 disp_para, ctrldescl0_5;
+
+	if (!handover || lcdifv3_enable_clocks(lcdifv3))
+		return;
+
+	disp_para = readl(lcdifv3->base + LCDIFV3_DISP_PARA);
+	ctrldescl0_5 = readl(lcdifv3->base + LCDIFV3_CTRLDESCL0_5);
+	if (!(disp_para & DISP_PARA_DISP_ON) ||
+	    !(ctrldescl0_5 & CTRLDESCL0_5_EN)) {
+		lcdifv3_disable_clocks(lcdifv3);
+		return;
+	}
+
+	lcdifv3_get_mode(lcdifv3, &lcdifv3->handover_vm);
+
+	if (of_device_is_compatible(dev->of_node, "fsl,imx93-lcdif"))
+		regmap_write(lcdifv3->gpr, 0xc, 0x3712);
+
+	request_bus_freq(BUS_FREQ_HIGH);
+
+	lcdifv3->handover = true;
+
+	dev_info(dev, "display left running by the bootloader: %ux%u@%luHz\n",
+		 lcdifv3->handover_vm.hactive, lcdifv3->handover_vm.vactive,
+		 lcdifv3->handover_vm.pixelclock);
+}
+
 static int imx_lcdifv3_probe(struct platform_device *pdev)
 {
 	int ret;
@@ -684,9 +907,17 @@ static int imx_lcdifv3_probe(struct platform_device *pdev)
 
 	platform_set_drvdata(pdev, lcdifv3);
 
+	imx_lcdifv3_handover_init(lcdifv3);
+
 	atomic_set(&lcdifv3->rpm_suspended, 0);
+	if (lcdifv3->handover) {
+		/* the clocks are on, released by lcdifv3_handover_release() */
+		pm_runtime_set_active(dev);
+		pm_runtime_get_noresume(dev);
+	}
 	pm_runtime_enable(dev);
-	atomic_inc(&lcdifv3->rpm_suspended);
+	if (!lcdifv3->handover)
+		atomic_inc(&lcdifv3->rpm_suspended);
 
 	dev_dbg(dev, "%s: probe end\n", __func__);
 
@@ -695,6 +926,7 @@ static int imx_lcdifv3_probe(struct platform_device *pdev)
 
 static void imx_lcdifv3_remove(struct platform_device *pdev)
 {
+	lcdifv3_handover_release(platform_get_drvdata(pdev));
 	pm_runtime_disable(&pdev->dev);
 }
 
@@ -128,8 +128,17 @@
    #define BPP32_ARGB8888		0x9
    #define BPP32_ABGR8888		0xa
 #define CTRLDESCL0_5_YUV_FORMAT(x)	REG_PUT((x), 15, 14)
+   /* YCbCr422 component order, from the MSB */
+   #define YUV_FORMAT_Y2VY1U		0x0
+   #define YUV_FORMAT_Y2UY1V		0x1
+   #define YUV_FORMAT_VY2UY1		0x2
+   #define YUV_FORMAT_UY2VY1		0x3
 
 #define CSC0_CTRL_CSC_MODE(x)		REG_PUT((x),  2,  1)
+   #define CSC_MODE_YUV2RGB		0x0
+   #define CSC_MODE_YCbCr2RGB		0x1
+   #define CSC_MODE_RGB2YUV		0x2
+   #define CSC_MODE_RGB2YCbCr		0x3
 #define CSC0_CTRL_BYPASS		BIT(0)
 #define CSC0_COEF0_A2(x)		REG_PUT((x), 26, 16)
 #define CSC0_COEF0_A1(x)		REG_PUT((x), 10,  0)
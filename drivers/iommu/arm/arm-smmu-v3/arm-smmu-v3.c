@@ -13,6 +13,7 @@
 #include <linux/acpi_iort.h>
 #include <linux/bitops.h>
 #include <linux/crash_dump.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/err.h>
 #include <linux/interrupt.h>
@@ -26,6 +27,8 @@
 #include <linux/pci.h>
 #include <linux/pci-ats.h>
 #include <linux/platform_device.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
 #include <kunit/visibility.h>
 #include <uapi/linux/iommufd.h>
 
@@ -43,6 +46,11 @@ static bool disable_pm;
 module_param(disable_pm, bool, 0444);
 MODULE_PARM_DESC(disable_pm, "Disable smmu suspend/resume.");
 
+static unsigned long fq_inv_window = SZ_4M;
+module_param(fq_inv_window, ulong, 0644);
+MODULE_PARM_DESC(fq_inv_window,
+	"Largest IOVA span invalidated by range, rather than the whole context, on flush queue flushes (0 to disable).");
+
 enum arm_smmu_msi_index {
 	EVTQ_MSI_INDEX,
 	GERROR_MSI_INDEX,
@@ -120,6 +128,18 @@ static bool queue_has_space(struct arm_smmu_ll_queue *q, u32 n)
 	return space >= n;
 }
 
+static u32 queue_used(struct arm_smmu_ll_queue *q)
+{
+	u32 prod, cons;
+
+	prod = Q_IDX(q, q->prod);
+	cons = Q_IDX(q, q->cons);
+
+	if (Q_WRP(q, q->prod) == Q_WRP(q, q->cons))
+		return prod - cons;
+	return (1 << q->max_n_shift) - (cons - prod);
+}
+
 static bool queue_full(struct arm_smmu_ll_queue *q)
 {
 	return Q_IDX(q, q->prod) == Q_IDX(q, q->cons) &&
@@ -773,10 +793,13 @@ static int arm_smmu_cmdq_issue_cmdlist(struct arm_smmu_device *smmu,
 				       u64 *cmds, int n, bool sync)
 {
 	u64 cmd_sync[CMDQ_ENT_DWORDS];
-	u32 prod;
+	u32 prod, occupancy;
 	unsigned long flags;
 	bool owner;
 	struct arm_smmu_ll_queue llq, head;
+	struct arm_smmu_cmdq_stats *stats;
+	unsigned int full_waits = 0;
+	u64 start = sync ? local_clock() : 0;
 	int ret = 0;
 
 	llq.max_n_shift = cmdq->q.llq.max_n_shift;
@@ -788,6 +811,7 @@ static int arm_smmu_cmdq_issue_cmdlist(struct arm_smmu_device *smmu,
 		u64 old;
 
 		while (!queue_has_space(&llq, n + sync)) {
+			full_waits++;
 			local_irq_restore(flags);
 			if (arm_smmu_cmdq_poll_until_not_full(smmu, cmdq, &llq))
 				dev_err_ratelimited(smmu->dev, "CMDQ timeout\n");
@@ -804,6 +828,7 @@ static int arm_smmu_cmdq_issue_cmdlist(struct arm_smmu_device *smmu,
 
 		llq.val = old;
 	} while (1);
+	occupancy = queue_used(&llq);
 	owner = !(llq.prod & CMDQ_PROD_OWNED_FLAG);
 	head.prod &= ~CMDQ_PROD_OWNED_FLAG;
 	llq.prod &= ~CMDQ_PROD_OWNED_FLAG;
@@ -884,6 +909,21 @@ static int arm_smmu_cmdq_issue_cmdlist(struct arm_smmu_device *smmu,
 		}
 	}
 
+	/* We may have waited for space with interrupts on, on another CPU */
+	stats = this_cpu_ptr(smmu->cmdq_stats);
+	stats->cmdlists++;
+	stats->cmds += n;
+	stats->full_waits += full_waits;
+	stats->occupancy += occupancy;
+	stats->max_occupancy = max(stats->max_occupancy, occupancy);
+	if (sync) {
+		u64 delta = local_clock() - start;
+
+		stats->syncs++;
+		stats->sync_ns += delta;
+		stats->max_sync_ns = max(stats->max_sync_ns, delta);
+	}
+
 	local_irq_restore(flags);
 	return ret;
 }
@@ -1525,6 +1565,31 @@ static const struct arm_smmu_entry_writer_ops arm_smmu_ste_writer_ops = {
 	.get_used = arm_smmu_get_ste_used,
 };
 
+static void arm_smmu_prefetch_ste(struct arm_smmu_device *smmu, u32 sid)
+{
+	struct arm_smmu_cmdq_ent prefetch_cmd = {
+		.opcode		= CMDQ_OP_PREFETCH_CFG,
+		.prefetch	= {
+			.sid	= sid,
+		},
+	};
+
+	/* It's likely that we'll want to use the new STE soon */
+	if (!(smmu->options & ARM_SMMU_OPT_SKIP_PREFETCH))
+		arm_smmu_cmdq_issue_cmd(smmu, &prefetch_cmd);
+}
+
+/* Bridged PCI devices may end up with duplicated IDs */
+static bool arm_smmu_master_sid_dup(struct arm_smmu_master *master, int i)
+{
+	int j;
+
+	for (j = 0; j < i; j++)
+		if (master->streams[j].id == master->streams[i].id)
+			return true;
+	return false;
+}
+
 static void arm_smmu_write_ste(struct arm_smmu_master *master, u32 sid,
 			       struct arm_smmu_ste *ste,
 			       const struct arm_smmu_ste *target)
@@ -1539,19 +1604,56 @@ static void arm_smmu_write_ste(struct arm_smmu_master *master, u32 sid,
 	};
 
 	arm_smmu_write_entry(&ste_writer.writer, ste->data, target->data);
+	arm_smmu_prefetch_ste(smmu, sid);
+}
 
-	/* It's likely that we'll want to use the new STE soon */
-	if (!(smmu->options & ARM_SMMU_OPT_SKIP_PREFETCH)) {
-		struct arm_smmu_cmdq_ent
-			prefetch_cmd = { .opcode = CMDQ_OP_PREFETCH_CFG,
-					 .prefetch = {
-						 .sid = sid,
-					 } };
+/*
+ * Once all the streams of a master have been given the same STE, which is
+ * always the case after the first installation, further updates are computed
+ * against the master's copy and applied to all of the streams at each step,
+ * followed by a single batch of CFGI_STE and one CMD_SYNC. Otherwise each
+ * stream would need up to three CMD_SYNCs of its own.
+ */
+static struct arm_smmu_ste *
+arm_smmu_get_step_for_sid(struct arm_smmu_device *smmu, u32 sid);
 
-		arm_smmu_cmdq_issue_cmd(smmu, &prefetch_cmd);
+static void arm_smmu_master_ste_sync_entry(struct arm_smmu_entry_writer *writer)
+{
+	struct arm_smmu_master *master = writer->master;
+	struct arm_smmu_device *smmu = master->smmu;
+	struct arm_smmu_cmdq_ent cmd = {
+		.opcode	= CMDQ_OP_CFGI_STE,
+		.cfgi	= {
+			.leaf	= true,
+		},
+	};
+	struct arm_smmu_cmdq_batch cmds;
+	int i, j;
+
+	arm_smmu_cmdq_batch_init(smmu, &cmds, &cmd);
+	for (i = 0; i < master->num_streams; i++) {
+		u32 sid = master->streams[i].id;
+		struct arm_smmu_ste *step;
+
+		if (arm_smmu_master_sid_dup(master, i))
+			continue;
+
+		/* qwords left alone by this step are rewritten as they are */
+		step = arm_smmu_get_step_for_sid(smmu, sid);
+		for (j = 0; j < NUM_ENTRY_QWORDS; j++)
+			WRITE_ONCE(step->data[j], master->ste.data[j]);
+
+		cmd.cfgi.sid = sid;
+		arm_smmu_cmdq_batch_add(smmu, &cmds, &cmd);
 	}
+	arm_smmu_cmdq_batch_submit(smmu, &cmds);
 }
 
+static const struct arm_smmu_entry_writer_ops arm_smmu_master_ste_writer_ops = {
+	.sync = arm_smmu_master_ste_sync_entry,
+	.get_used = arm_smmu_get_ste_used,
+};
+
 VISIBLE_IF_KUNIT
 void arm_smmu_make_abort_ste(struct arm_smmu_ste *target)
 {
@@ -2258,6 +2360,81 @@ void arm_smmu_tlb_inv_range_asid(unsigned long iova, size_t size, int asid,
 	__arm_smmu_tlb_inv_range(&cmd, iova, size, granule, smmu_domain);
 }
 
+/*
+ * Record an unmap whose invalidation was deferred to the flush queue.
+ *
+ * Ordering against arm_smmu_fq_inv_range() comes from the per-CPU lock: if
+ * the flush takes it after us it sees the range, otherwise the flush queue
+ * counter read by the caller after we return already covers that flush, and
+ * the IOVA is only freed after a later one.
+ */
+static void arm_smmu_fq_inv_add(struct arm_smmu_domain *smmu_domain,
+				unsigned long iova, size_t size,
+				size_t granule)
+{
+	struct arm_smmu_fq_inv *inv;
+	unsigned long flags;
+
+	inv = get_cpu_ptr(smmu_domain->fq_inv);
+	spin_lock_irqsave(&inv->lock, flags);
+	if (inv->start > inv->end) {
+		inv->granule = granule;
+		inv->mixed = false;
+	} else if (inv->granule != granule) {
+		inv->granule = min(inv->granule, granule);
+		inv->mixed = true;
+	}
+	inv->start = min(inv->start, iova);
+	inv->end = max(inv->end, iova + size - 1);
+	spin_unlock_irqrestore(&inv->lock, flags);
+	put_cpu_ptr(smmu_domain->fq_inv);
+}
+
+/*
+ * On a flush queue flush, invalidate only what was unmapped since the last
+ * one, as long as it spans no more than fq_inv_window: the whole context
+ * invalidation otherwise also throws away the TLB entries of all the live
+ * mappings of the domain.  Returns false if the context must be invalidated.
+ */
+static bool arm_smmu_fq_inv_range(struct arm_smmu_domain *smmu_domain)
+{
+	unsigned long start = ULONG_MAX, end = 0, flags;
+	unsigned long window = READ_ONCE(fq_inv_window);
+	struct arm_smmu_fq_inv *inv;
+	size_t granule = 0;
+	bool mixed = false;
+	int cpu;
+
+	if (!smmu_domain->fq_inv)
+		return false;
+
+	for_each_possible_cpu(cpu) {
+		inv = per_cpu_ptr(smmu_domain->fq_inv, cpu);
+		spin_lock_irqsave(&inv->lock, flags);
+		if (inv->start <= inv->end) {
+			if (granule && granule != inv->granule)
+				mixed = true;
+			granule = granule ? min(granule, inv->granule) :
+					    inv->granule;
+			mixed |= inv->mixed;
+			start = min(start, inv->start);
+			end = max(end, inv->end);
+			inv->start = ULONG_MAX;
+			inv->end = 0;
+		}
+		spin_unlock_irqrestore(&inv->lock, flags);
+	}
+
+	/* nothing deferred: an explicit flush of the whole domain */
+	if (start > end || !window || end - start >= window)
+		return false;
+
+	/* mixed page sizes must not be invalidated with a leaf TTL hint */
+	arm_smmu_tlb_inv_range_domain(start, end - start + 1, granule, !mixed,
+				      smmu_domain);
+	return true;
+}
+
 static void arm_smmu_tlb_inv_page_nosync(struct iommu_iotlb_gather *gather,
 					 unsigned long iova, size_t granule,
 					 void *cookie)
@@ -2334,12 +2511,27 @@ static struct iommu_domain *arm_smmu_domain_alloc_paging(struct device *dev)
 	if (IS_ERR(smmu_domain))
 		return ERR_CAST(smmu_domain);
 
+	/* without it, flush queue flushes invalidate the whole context */
+	smmu_domain->fq_inv = alloc_percpu(struct arm_smmu_fq_inv);
+	if (smmu_domain->fq_inv) {
+		int cpu;
+
+		for_each_possible_cpu(cpu) {
+			struct arm_smmu_fq_inv *inv =
+				per_cpu_ptr(smmu_domain->fq_inv, cpu);
+
+			spin_lock_init(&inv->lock);
+			inv->start = ULONG_MAX;
+		}
+	}
+
 	if (dev) {
 		struct arm_smmu_master *master = dev_iommu_priv_get(dev);
 		int ret;
 
 		ret = arm_smmu_domain_finalise(smmu_domain, master->smmu, 0);
 		if (ret) {
+			free_percpu(smmu_domain->fq_inv);
 			kfree(smmu_domain);
 			return ERR_PTR(ret);
 		}
@@ -2366,6 +2558,7 @@ static void arm_smmu_domain_free_paging(struct iommu_domain *domain)
 			ida_free(&smmu->vmid_map, cfg->vmid);
 	}
 
+	free_percpu(smmu_domain->fq_inv);
 	kfree(smmu_domain);
 }
 
@@ -2489,8 +2682,12 @@ arm_smmu_get_step_for_sid(struct arm_smmu_device *smmu, u32 sid)
 static void arm_smmu_install_ste_for_dev(struct arm_smmu_master *master,
 					 const struct arm_smmu_ste *target)
 {
-	int i, j;
+	int i;
 	struct arm_smmu_device *smmu = master->smmu;
+	struct arm_smmu_entry_writer writer = {
+		.ops = &arm_smmu_master_ste_writer_ops,
+		.master = master,
+	};
 
 	master->cd_table.in_ste =
 		FIELD_GET(STRTAB_STE_0_CFG, le64_to_cpu(target->data[0])) ==
@@ -2499,20 +2696,31 @@ static void arm_smmu_install_ste_for_dev(struct arm_smmu_master *master,
 		FIELD_GET(STRTAB_STE_1_EATS, le64_to_cpu(target->data[1])) ==
 		STRTAB_STE_1_EATS_TRANS;
 
+	if (master->ste_valid) {
+		/* switching back and forth to the same domain */
+		if (!memcmp(&master->ste, target, sizeof(*target)))
+			return;
+
+		arm_smmu_write_entry(&writer, master->ste.data, target->data);
+		for (i = 0; i < master->num_streams; ++i)
+			if (!arm_smmu_master_sid_dup(master, i))
+				arm_smmu_prefetch_ste(smmu,
+						      master->streams[i].id);
+		return;
+	}
+
 	for (i = 0; i < master->num_streams; ++i) {
 		u32 sid = master->streams[i].id;
 		struct arm_smmu_ste *step =
 			arm_smmu_get_step_for_sid(smmu, sid);
 
-		/* Bridged PCI devices may end up with duplicated IDs */
-		for (j = 0; j < i; j++)
-			if (master->streams[j].id == sid)
-				break;
-		if (j < i)
+		if (arm_smmu_master_sid_dup(master, i))
 			continue;
 
 		arm_smmu_write_ste(master, sid, step, target);
 	}
+	master->ste = *target;
+	master->ste_valid = true;
 }
 
 static bool arm_smmu_ats_supported(struct arm_smmu_master *master)
@@ -2786,6 +2994,18 @@ static void arm_smmu_attach_commit(struct arm_smmu_attach_state *state)
 	arm_smmu_remove_master_domain(master, state->old_domain, state->ssid);
 }
 
+static void arm_smmu_account_attach(struct arm_smmu_device *smmu, u64 start)
+{
+	struct arm_smmu_cmdq_stats *stats;
+	u64 delta = local_clock() - start;
+
+	stats = get_cpu_ptr(smmu->cmdq_stats);
+	stats->attaches++;
+	stats->attach_ns += delta;
+	stats->max_attach_ns = max(stats->max_attach_ns, delta);
+	put_cpu_ptr(smmu->cmdq_stats);
+}
+
 static int arm_smmu_attach_dev(struct iommu_domain *domain, struct device *dev)
 {
 	int ret = 0;
@@ -2799,6 +3019,7 @@ static int arm_smmu_attach_dev(struct iommu_domain *domain, struct device *dev)
 	};
 	struct arm_smmu_master *master;
 	struct arm_smmu_cd *cdptr;
+	u64 start = local_clock();
 
 	if (!fwspec)
 		return -ENOENT;
@@ -2860,6 +3081,7 @@ static int arm_smmu_attach_dev(struct iommu_domain *domain, struct device *dev)
 
 	arm_smmu_attach_commit(&state);
 	mutex_unlock(&arm_smmu_asid_lock);
+	arm_smmu_account_attach(smmu, start);
 	return 0;
 }
 
@@ -3011,6 +3233,7 @@ static void arm_smmu_attach_dev_ste(struct iommu_domain *domain,
 		.old_domain = iommu_get_domain_for_dev(dev),
 		.ssid = IOMMU_NO_PASID,
 	};
+	u64 start = local_clock();
 
 	/*
 	 * Do not allow any ASID to be changed while are working on the STE,
@@ -3046,6 +3269,7 @@ static void arm_smmu_attach_dev_ste(struct iommu_domain *domain,
 	 * descriptor from arm_smmu_share_asid().
 	 */
 	arm_smmu_clear_cd(master, IOMMU_NO_PASID);
+	arm_smmu_account_attach(master->smmu, start);
 }
 
 static int arm_smmu_attach_dev_identity(struct iommu_domain *domain,
@@ -3137,19 +3361,36 @@ static size_t arm_smmu_unmap_pages(struct iommu_domain *domain, unsigned long io
 {
 	struct arm_smmu_domain *smmu_domain = to_smmu_domain(domain);
 	struct io_pgtable_ops *ops = smmu_domain->pgtbl_ops;
+	size_t unmapped;
 
 	if (!ops)
 		return 0;
 
-	return ops->unmap_pages(ops, iova, pgsize, pgcount, gather);
+	unmapped = ops->unmap_pages(ops, iova, pgsize, pgcount, gather);
+	if (unmapped && gather->queued && smmu_domain->fq_inv)
+		arm_smmu_fq_inv_add(smmu_domain, iova, unmapped, pgsize);
+	return unmapped;
 }
 
 static void arm_smmu_flush_iotlb_all(struct iommu_domain *domain)
 {
 	struct arm_smmu_domain *smmu_domain = to_smmu_domain(domain);
+	struct arm_smmu_cmdq_stats *stats;
+	bool range;
 
-	if (smmu_domain->smmu)
+	if (!smmu_domain->smmu)
+		return;
+
+	range = arm_smmu_fq_inv_range(smmu_domain);
+	if (!range)
 		arm_smmu_tlb_inv_context(smmu_domain);
+
+	stats = get_cpu_ptr(smmu_domain->smmu->cmdq_stats);
+	if (range)
+		stats->fq_range_invs++;
+	else
+		stats->fq_full_invs++;
+	put_cpu_ptr(smmu_domain->smmu->cmdq_stats);
 }
 
 static void arm_smmu_iotlb_sync(struct iommu_domain *domain,
@@ -4566,6 +4807,74 @@ static struct arm_smmu_device *arm_smmu_impl_probe(struct arm_smmu_device *smmu)
 	return new_smmu;
 }
 
+#ifdef CONFIG_IOMMU_DEBUGFS
+static struct dentry *arm_smmu_debugfs;
+
+static int arm_smmu_cmdq_stats_show(struct seq_file *s, void *unused)
+{
+	struct arm_smmu_device *smmu = s->private;
+	struct arm_smmu_cmdq_stats sum = {};
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct arm_smmu_cmdq_stats *stats =
+			per_cpu_ptr(smmu->cmdq_stats, cpu);
+
+		sum.cmdlists += READ_ONCE(stats->cmdlists);
+		sum.cmds += READ_ONCE(stats->cmds);
+		sum.full_waits += READ_ONCE(stats->full_waits);
+		sum.occupancy += READ_ONCE(stats->occupancy);
+		sum.max_occupancy = max(sum.max_occupancy,
+					READ_ONCE(stats->max_occupancy));
+		sum.syncs += READ_ONCE(stats->syncs);
+		sum.sync_ns += READ_ONCE(stats->sync_ns);
+		sum.max_sync_ns = max(sum.max_sync_ns,
+				      READ_ONCE(stats->max_sync_ns));
+		sum.fq_range_invs += READ_ONCE(stats->fq_range_invs);
+		sum.fq_full_invs += READ_ONCE(stats->fq_full_invs);
+		sum.attaches += READ_ONCE(stats->attaches);
+		sum.attach_ns += READ_ONCE(stats->attach_ns);
+		sum.max_attach_ns = max(sum.max_attach_ns,
+					READ_ONCE(stats->max_attach_ns));
+	}
+
+	seq_printf(s, "entries: %u\n", 1 << smmu->cmdq.q.llq.max_n_shift);
+	seq_printf(s, "cmdlists: %llu\n", sum.cmdlists);
+	seq_printf(s, "cmds: %llu\n", sum.cmds);
+	seq_printf(s, "full_waits: %llu\n", sum.full_waits);
+	seq_printf(s, "avg_occupancy: %llu\n",
+		   sum.cmdlists ? div64_u64(sum.occupancy, sum.cmdlists) : 0);
+	seq_printf(s, "max_occupancy: %u\n", sum.max_occupancy);
+	seq_printf(s, "syncs: %llu\n", sum.syncs);
+	seq_printf(s, "avg_sync_ns: %llu\n",
+		   sum.syncs ? div64_u64(sum.sync_ns, sum.syncs) : 0);
+	seq_printf(s, "max_sync_ns: %llu\n", sum.max_sync_ns);
+	seq_printf(s, "flush_range_invs: %llu\n", sum.fq_range_invs);
+	seq_printf(s, "flush_full_invs: %llu\n", sum.fq_full_invs);
+	seq_printf(s, "attaches: %llu\n", sum.attaches);
+	seq_printf(s, "avg_attach_ns: %llu\n",
+		   sum.attaches ? div64_u64(sum.attach_ns, sum.attaches) : 0);
+	seq_printf(s, "max_attach_ns: %llu\n", sum.max_attach_ns);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(arm_smmu_cmdq_stats);
+
+static void arm_smmu_debugfs_init(struct arm_smmu_device *smmu)
+{
+	if (!arm_smmu_debugfs)
+		arm_smmu_debugfs = debugfs_create_dir("arm-smmu-v3",
+						      iommu_debugfs_dir);
+	smmu->debugfs = debugfs_create_dir(dev_name(smmu->dev),
+					   arm_smmu_debugfs);
+	debugfs_create_file("cmdq_stats", 0400, smmu->debugfs, smmu,
+			    &arm_smmu_cmdq_stats_fops);
+}
+#else
+static void arm_smmu_debugfs_init(struct arm_smmu_device *smmu)
+{
+}
+#endif
+
 static int arm_smmu_device_probe(struct platform_device *pdev)
 {
 	int irq, ret;
@@ -4591,6 +4900,10 @@ static int arm_smmu_device_probe(struct platform_device *pdev)
 	if (IS_ERR(smmu))
 		return PTR_ERR(smmu);
 
+	smmu->cmdq_stats = devm_alloc_percpu(dev, struct arm_smmu_cmdq_stats);
+	if (!smmu->cmdq_stats)
+		return -ENOMEM;
+
 	/* Base address */
 	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
 	if (!res)
@@ -4669,6 +4982,7 @@ static int arm_smmu_device_probe(struct platform_device *pdev)
 		goto err_free_sysfs;
 	}
 
+	arm_smmu_debugfs_init(smmu);
 	return 0;
 
 err_free_sysfs:
@@ -4684,6 +4998,7 @@ static void arm_smmu_device_remove(struct platform_device *pdev)
 {
 	struct arm_smmu_device *smmu = platform_get_drvdata(pdev);
 
+	debugfs_remove_recursive(smmu->debugfs);
 	iommu_device_unregister(&smmu->iommu);
 	iommu_device_sysfs_remove(&smmu->iommu);
 	arm_smmu_device_disable(smmu);
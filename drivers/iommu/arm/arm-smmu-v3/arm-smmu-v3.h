@@ -607,6 +607,23 @@ struct arm_smmu_cmdq {
 	bool				(*supports_cmd)(struct arm_smmu_cmdq_ent *ent);
 };
 
+/* Per-CPU command queue statistics, exposed in debugfs */
+struct arm_smmu_cmdq_stats {
+	u64				cmdlists;
+	u64				cmds;
+	u64				full_waits;
+	u64				occupancy;	/* sum over cmdlists */
+	u32				max_occupancy;
+	u64				syncs;
+	u64				sync_ns;	/* sum over syncs */
+	u64				max_sync_ns;
+	u64				fq_range_invs;
+	u64				fq_full_invs;
+	u64				attaches;
+	u64				attach_ns;	/* sum over attaches */
+	u64				max_attach_ns;
+};
+
 static inline bool arm_smmu_cmdq_supports_cmd(struct arm_smmu_cmdq *cmdq,
 					      struct arm_smmu_cmdq_ent *ent)
 {
@@ -763,6 +780,9 @@ struct arm_smmu_device {
 
 	struct rb_root			streams;
 	struct mutex			streams_mutex;
+
+	struct arm_smmu_cmdq_stats __percpu *cmdq_stats;
+	struct dentry			*debugfs;
 };
 
 struct arm_smmu_stream {
@@ -781,10 +801,13 @@ struct arm_smmu_master {
 	unsigned int			num_streams;
 	bool				ats_enabled : 1;
 	bool				ste_ats_enabled : 1;
+	bool				ste_valid : 1;
 	bool				stall_enabled;
 	bool				sva_enabled;
 	bool				iopf_enabled;
 	unsigned int			ssid_bits;
+	/* Copy of the STE of all the streams, once ste_valid */
+	struct arm_smmu_ste		ste;
 };
 
 /* SMMU private data for an IOMMU domain */
@@ -813,6 +836,22 @@ struct arm_smmu_domain {
 	spinlock_t			devices_lock;
 
 	struct mmu_notifier		mmu_notifier;
+
+	/* IOVAs unmapped through the flush queue, per CPU */
+	struct arm_smmu_fq_inv __percpu	*fq_inv;
+};
+
+/*
+ * IOVA range whose TLB entries a flush queue flush must invalidate. The
+ * common page size of the unmaps is used as the invalidation granule, unless
+ * they mixed page sizes.
+ */
+struct arm_smmu_fq_inv {
+	spinlock_t			lock;
+	unsigned long			start;
+	unsigned long			end;	/* inclusive, empty if < start */
+	size_t				granule;
+	bool				mixed;
 };
 
 /* The following are exposed for testing purposes. */
@@ -44,6 +44,12 @@ struct vb2_dc_buf {
 
 	struct vb2_buffer		*vb;
 	bool				non_coherent_mem;
+
+	/* CPU access tracking for non-coherent memory */
+	bool				cpu_dirty;
+	bool				cpu_untracked;
+	bool				dmabuf_mmapped;
+	bool				dmabuf_synced;
 };
 
 /*********************************************/
@@ -70,6 +76,36 @@ static unsigned long vb2_dc_get_contiguous_size(struct sg_table *sgt)
 /*         callbacks for all buffers         */
 /*********************************************/
 
+/*
+ * Cache maintenance of non-coherent memory is only needed when the CPU may
+ * have touched the data since the last device access. That is always
+ * assumed for USERPTR buffers, for V4L2 mmap() and for kernel mappings,
+ * which give no notice of CPU access. Buffers only ever shared between
+ * devices, and dma-buf mappings whose users bracket CPU access with
+ * DMA_BUF_IOCTL_SYNC, don't need prepare() and finish() to sync them.
+ */
+static bool vb2_dc_cpu_untracked(struct vb2_dc_buf *buf)
+{
+	return buf->cpu_untracked || (buf->dmabuf_mmapped && !buf->dmabuf_synced);
+}
+
+/*
+ * Called before the CPU gets a new mapping of the buffer: catch up on the
+ * maintenance that was skipped while nobody could look.
+ */
+static void vb2_dc_cpu_map(struct vb2_dc_buf *buf)
+{
+	if (!buf->non_coherent_mem || vb2_dc_cpu_untracked(buf))
+		return;
+
+	if (buf->cpu_dirty) {
+		dma_sync_sgtable_for_device(buf->dev, buf->dma_sgt, buf->dma_dir);
+		buf->cpu_dirty = false;
+	} else {
+		dma_sync_sgtable_for_cpu(buf->dev, buf->dma_sgt, buf->dma_dir);
+	}
+}
+
 static void *vb2_dc_cookie(struct vb2_buffer *vb, void *buf_priv)
 {
 	struct vb2_dc_buf *buf = buf_priv;
@@ -107,9 +143,13 @@ static void *vb2_dc_vaddr(struct vb2_buffer *vb, void *buf_priv)
 		return buf->vaddr;
 	}
 
-	if (buf->non_coherent_mem)
+	if (buf->non_coherent_mem) {
+		vb2_dc_cpu_map(buf);
 		buf->vaddr = dma_vmap_noncontiguous(buf->dev, buf->size,
 						    buf->dma_sgt);
+		if (buf->vaddr)
+			buf->cpu_untracked = true;
+	}
 	return buf->vaddr;
 }
 
@@ -132,6 +172,12 @@ static void vb2_dc_prepare(void *buf_priv)
 	if (!buf->non_coherent_mem)
 		return;
 
+	/* Not written by the CPU since the last sync */
+	if (!buf->cpu_dirty && !vb2_dc_cpu_untracked(buf))
+		return;
+
+	buf->cpu_dirty = false;
+
 	/* Non-coherent MMAP only */
 	if (buf->vaddr)
 		flush_kernel_vmap_range(buf->vaddr, buf->size);
@@ -152,6 +198,10 @@ static void vb2_dc_finish(void *buf_priv)
 	if (!buf->non_coherent_mem)
 		return;
 
+	/* No CPU mapping that could read stale cache lines */
+	if (!vb2_dc_cpu_untracked(buf))
+		return;
+
 	/* Non-coherent MMAP only */
 	if (buf->vaddr)
 		invalidate_kernel_vmap_range(buf->vaddr, buf->size);
@@ -221,6 +271,9 @@ static int vb2_dc_alloc_non_coherent(struct vb2_dc_buf *buf)
 
 	buf->dma_addr = sg_dma_address(buf->dma_sgt->sgl);
 
+	/* The pages were cleared through the CPU cache */
+	buf->cpu_dirty = true;
+
 	/*
 	 * For non-coherent buffers the kernel mapping is created on demand
 	 * in vb2_dc_vaddr().
@@ -271,9 +324,8 @@ static void *vb2_dc_alloc(struct vb2_buffer *vb,
 	return buf;
 }
 
-static int vb2_dc_mmap(void *buf_priv, struct vm_area_struct *vma)
+static int __vb2_dc_mmap(struct vb2_dc_buf *buf, struct vm_area_struct *vma)
 {
-	struct vb2_dc_buf *buf = buf_priv;
 	int ret;
 
 	if (!buf) {
@@ -281,6 +333,8 @@ static int vb2_dc_mmap(void *buf_priv, struct vm_area_struct *vma)
 		return -EINVAL;
 	}
 
+	vb2_dc_cpu_map(buf);
+
 	if (buf->non_coherent_mem)
 		ret = dma_mmap_noncontiguous(buf->dev, vma, buf->size,
 					     buf->dma_sgt);
@@ -305,6 +359,18 @@ static int vb2_dc_mmap(void *buf_priv, struct vm_area_struct *vma)
 	return 0;
 }
 
+static int vb2_dc_mmap(void *buf_priv, struct vm_area_struct *vma)
+{
+	struct vb2_dc_buf *buf = buf_priv;
+	int ret;
+
+	ret = __vb2_dc_mmap(buf, vma);
+	if (!ret)
+		buf->cpu_untracked = true;
+
+	return ret;
+}
+
 /*********************************************/
 /*         DMABUF ops for exporters          */
 /*********************************************/
@@ -433,6 +499,8 @@ vb2_dc_dmabuf_ops_begin_cpu_access(struct dma_buf *dbuf,
 	if (!buf->non_coherent_mem)
 		return 0;
 
+	buf->dmabuf_synced = true;
+
 	if (buf->vaddr)
 		invalidate_kernel_vmap_range(buf->vaddr, buf->size);
 
@@ -451,6 +519,8 @@ vb2_dc_dmabuf_ops_end_cpu_access(struct dma_buf *dbuf,
 	if (!buf->non_coherent_mem)
 		return 0;
 
+	buf->dmabuf_synced = true;
+
 	if (buf->vaddr)
 		flush_kernel_vmap_range(buf->vaddr, buf->size);
 
@@ -477,7 +547,14 @@ static int vb2_dc_dmabuf_ops_vmap(struct dma_buf *dbuf, struct iosys_map *map)
 static int vb2_dc_dmabuf_ops_mmap(struct dma_buf *dbuf,
 	struct vm_area_struct *vma)
 {
-	return vb2_dc_mmap(dbuf->priv, vma);
+	struct vb2_dc_buf *buf = dbuf->priv;
+	int ret;
+
+	ret = __vb2_dc_mmap(buf, vma);
+	if (!ret)
+		buf->dmabuf_mmapped = true;
+
+	return ret;
 }
 
 static const struct dma_buf_ops vb2_dc_dmabuf_ops = {
@@ -681,6 +758,7 @@ static void *vb2_dc_get_userptr(struct vb2_buffer *vb, struct device *dev,
 	buf->dma_addr = sg_dma_address(sgt->sgl);
 	buf->dma_sgt = sgt;
 	buf->non_coherent_mem = 1;
+	buf->cpu_untracked = true;
 
 out:
 	buf->size = size;
@@ -1072,6 +1072,13 @@ static int wave5_prepare_fb(struct vpu_instance *inst)
 		return -EINVAL;
 	}
 
+	/*
+	 * The decoder keeps its reference frames in private, compressed
+	 * (FBC) buffers and writes every displayed picture once more into a
+	 * linear CAPTURE buffer. The compressed layout is internal to the
+	 * codec and no display engine can scan it out, so it is not exposed
+	 * as a CAPTURE format.
+	 */
 	linear_num = v4l2_m2m_num_dst_bufs_ready(m2m_ctx);
 	non_linear_num = inst->fbc_buf_count;
 
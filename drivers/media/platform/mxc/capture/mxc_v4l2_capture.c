@@ -25,6 +25,7 @@
 #include <linux/vmalloc.h>
 #include <linux/types.h>
 #include <linux/fb.h>
+#include <linux/dma-buf.h>
 #include <linux/dma-mapping.h>
 #include <linux/delay.h>
 #include <linux/mxcfb.h>
@@ -218,6 +219,208 @@ static struct v4l2_int_master mxc_v4l2_master = {
 	.detach = mxc_v4l2_master_detach,
 };
 
+/***************************************************************************
+ * Functions for exporting Frame buffers as dma-buf.
+ **************************************************************************/
+
+/*
+ * An exported frame buffer can outlive the frame, e.g. when the VPU
+ * still holds it after VIDIOC_REQBUFS or close. The memory is then
+ * refcounted by the frame and by every dma-buf exported from it.
+ */
+struct mxc_v4l_dmabuf {
+	struct device *dev;
+	void *vaddr;
+	dma_addr_t paddr;
+	size_t size;
+	struct kref refcount;
+};
+
+struct mxc_v4l_dmabuf_attachment {
+	struct sg_table sgt;
+	enum dma_data_direction dma_dir;
+};
+
+static void mxc_v4l_dmabuf_free(struct kref *kref)
+{
+	struct mxc_v4l_dmabuf *dbuf =
+		container_of(kref, struct mxc_v4l_dmabuf, refcount);
+
+	dma_free_coherent(dbuf->dev, dbuf->size, dbuf->vaddr, dbuf->paddr);
+	kfree(dbuf);
+}
+
+static int mxc_v4l_dmabuf_attach(struct dma_buf *dmabuf,
+				 struct dma_buf_attachment *attach)
+{
+	struct mxc_v4l_dmabuf *dbuf = dmabuf->priv;
+	struct mxc_v4l_dmabuf_attachment *attachment;
+	int ret;
+
+	attachment = kzalloc(sizeof(*attachment), GFP_KERNEL);
+	if (!attachment)
+		return -ENOMEM;
+
+	ret = dma_get_sgtable(dbuf->dev, &attachment->sgt, dbuf->vaddr,
+			      dbuf->paddr, dbuf->size);
+	if (ret) {
+		kfree(attachment);
+		return ret;
+	}
+
+	attachment->dma_dir = DMA_NONE;
+	attach->priv = attachment;
+
+	return 0;
+}
+
+static void mxc_v4l_dmabuf_detach(struct dma_buf *dmabuf,
+				  struct dma_buf_attachment *attach)
+{
+	struct mxc_v4l_dmabuf_attachment *attachment = attach->priv;
+
+	if (attachment->dma_dir != DMA_NONE)
+		dma_unmap_sgtable(attach->dev, &attachment->sgt,
+				  attachment->dma_dir, DMA_ATTR_SKIP_CPU_SYNC);
+	sg_free_table(&attachment->sgt);
+	kfree(attachment);
+	attach->priv = NULL;
+}
+
+static struct sg_table *
+mxc_v4l_dmabuf_map(struct dma_buf_attachment *attach,
+		   enum dma_data_direction dma_dir)
+{
+	struct mxc_v4l_dmabuf_attachment *attachment = attach->priv;
+	int ret;
+
+	/* the mapping is kept until detach, reuse it when possible */
+	if (attachment->dma_dir == dma_dir)
+		return &attachment->sgt;
+
+	if (attachment->dma_dir != DMA_NONE) {
+		dma_unmap_sgtable(attach->dev, &attachment->sgt,
+				  attachment->dma_dir, DMA_ATTR_SKIP_CPU_SYNC);
+		attachment->dma_dir = DMA_NONE;
+	}
+
+	/* the memory is coherent, there is nothing to sync */
+	ret = dma_map_sgtable(attach->dev, &attachment->sgt, dma_dir,
+			      DMA_ATTR_SKIP_CPU_SYNC);
+	if (ret)
+		return ERR_PTR(ret);
+
+	attachment->dma_dir = dma_dir;
+
+	return &attachment->sgt;
+}
+
+static void mxc_v4l_dmabuf_unmap(struct dma_buf_attachment *attach,
+				 struct sg_table *sgt,
+				 enum dma_data_direction dma_dir)
+{
+	/* nothing to do, the mapping is released on detach */
+}
+
+static void mxc_v4l_dmabuf_release(struct dma_buf *dmabuf)
+{
+	struct mxc_v4l_dmabuf *dbuf = dmabuf->priv;
+
+	kref_put(&dbuf->refcount, mxc_v4l_dmabuf_free);
+}
+
+static int mxc_v4l_dmabuf_mmap(struct dma_buf *dmabuf,
+			       struct vm_area_struct *vma)
+{
+	struct mxc_v4l_dmabuf *dbuf = dmabuf->priv;
+
+	return dma_mmap_coherent(dbuf->dev, vma, dbuf->vaddr, dbuf->paddr,
+				 dbuf->size);
+}
+
+static int mxc_v4l_dmabuf_vmap(struct dma_buf *dmabuf, struct iosys_map *map)
+{
+	struct mxc_v4l_dmabuf *dbuf = dmabuf->priv;
+
+	iosys_map_set_vaddr(map, dbuf->vaddr);
+
+	return 0;
+}
+
+static const struct dma_buf_ops mxc_v4l_dmabuf_ops = {
+	.attach = mxc_v4l_dmabuf_attach,
+	.detach = mxc_v4l_dmabuf_detach,
+	.map_dma_buf = mxc_v4l_dmabuf_map,
+	.unmap_dma_buf = mxc_v4l_dmabuf_unmap,
+	.release = mxc_v4l_dmabuf_release,
+	.mmap = mxc_v4l_dmabuf_mmap,
+	.vmap = mxc_v4l_dmabuf_vmap,
+};
+
+/*!
+ * Export a frame buffer as a dma-buf
+ *
+ * @param cam      Structure cam_data *
+ * @param eb       Structure v4l2_exportbuffer *
+ *
+ * @return status  0 success, negative error code on failure.
+ */
+static int mxc_v4l_expbuf(cam_data *cam, struct v4l2_exportbuffer *eb)
+{
+	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	struct mxc_v4l_frame *frame;
+	struct mxc_v4l_dmabuf *dbuf;
+	struct dma_buf *dmabuf;
+	int fd;
+
+	if (eb->type != V4L2_BUF_TYPE_VIDEO_CAPTURE ||
+	    eb->index >= FRAME_NUM || eb->plane != 0)
+		return -EINVAL;
+
+	if (eb->flags & ~(O_CLOEXEC | O_ACCMODE))
+		return -EINVAL;
+
+	frame = &cam->frame[eb->index];
+	if (!frame->vaddress)
+		return -EINVAL;
+
+	dbuf = frame->dbuf;
+	if (!dbuf) {
+		dbuf = kzalloc(sizeof(*dbuf), GFP_KERNEL);
+		if (!dbuf)
+			return -ENOMEM;
+
+		dbuf->dev = cam->dev;
+		dbuf->vaddr = frame->vaddress;
+		dbuf->paddr = frame->paddress;
+		dbuf->size = frame->buffer.length;
+		kref_init(&dbuf->refcount);
+		frame->dbuf = dbuf;
+	}
+
+	exp_info.ops = &mxc_v4l_dmabuf_ops;
+	exp_info.size = dbuf->size;
+	exp_info.flags = eb->flags;
+	exp_info.priv = dbuf;
+
+	kref_get(&dbuf->refcount);
+	dmabuf = dma_buf_export(&exp_info);
+	if (IS_ERR(dmabuf)) {
+		kref_put(&dbuf->refcount, mxc_v4l_dmabuf_free);
+		return PTR_ERR(dmabuf);
+	}
+
+	fd = dma_buf_fd(dmabuf, eb->flags & ~O_ACCMODE);
+	if (fd < 0) {
+		dma_buf_put(dmabuf);
+		return fd;
+	}
+
+	eb->fd = fd;
+
+	return 0;
+}
+
 /***************************************************************************
  * Functions for handling Frame buffers.
  **************************************************************************/
@@ -236,7 +439,13 @@ static int mxc_free_frame_buf(cam_data *cam)
 	pr_debug("MVC: In mxc_free_frame_buf\n");
 
 	for (i = 0; i < FRAME_NUM; i++) {
-		if (cam->frame[i].vaddress != 0) {
+		if (cam->frame[i].dbuf) {
+			/* still in use by an importer, drop our reference */
+			kref_put(&cam->frame[i].dbuf->refcount,
+				 mxc_v4l_dmabuf_free);
+			cam->frame[i].dbuf = NULL;
+			cam->frame[i].vaddress = 0;
+		} else if (cam->frame[i].vaddress != 0) {
 			dma_free_coherent(cam->dev, cam->frame[i].buffer.length,
 					  cam->frame[i].vaddress,
 					  cam->frame[i].paddress);
@@ -2003,6 +2212,19 @@ static long mxc_v4l_do_ioctl(struct file *file,
 		break;
 	}
 
+	/*!
+	 * V4l2 VIDIOC_EXPBUF ioctl
+	 */
+	case VIDIOC_EXPBUF: {
+		struct v4l2_exportbuffer *eb = arg;
+		pr_debug("   case VIDIOC_EXPBUF\n");
+
+		down(&cam->param_lock);
+		retval = mxc_v4l_expbuf(cam, eb);
+		up(&cam->param_lock);
+		break;
+	}
+
 	/*!
 	 * V4l2 VIDIOC_QBUF ioctl
 	 */
@@ -3139,3 +3361,4 @@ module_param(video_nr, int, 0444);
 MODULE_AUTHOR("Freescale Semiconductor, Inc.");
 MODULE_DESCRIPTION("V4L2 capture driver for Mxc based cameras");
 MODULE_LICENSE("GPL");
+MODULE_IMPORT_NS(DMA_BUF);
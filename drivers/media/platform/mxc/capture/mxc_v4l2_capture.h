@@ -41,12 +41,16 @@ enum imx_v4l2_devtype {
 	IMX6_V4L2,
 };
 
+struct mxc_v4l_dmabuf;
+
 /*!
  * v4l2 frame structure.
  */
 struct mxc_v4l_frame {
 	u32 paddress;
 	void *vaddress;
+	/* set once the frame has been exported, owns the memory then */
+	struct mxc_v4l_dmabuf *dbuf;
 	int count;
 	int width;
 	int height;
@@ -6,6 +6,7 @@
 
 #include <linux/bits.h>
 #include <linux/clk.h>
+#include <linux/debugfs.h>
 #include <linux/errno.h>
 #include <linux/iopoll.h>
 #include <linux/kernel.h>
@@ -314,6 +315,15 @@ static const struct dwc_csi_event dwc_events[] = {
 #define DWC_NUM_EVENTS		ARRAY_SIZE(dwc_events)
 #define DWC_EVENT_MASK		0x500ff
 
+#define DWC_EVENT_RING_SIZE	256
+
+/* Interrupt status captured by the interrupt handler when errors occur */
+struct dwc_csi_ring_entry {
+	u64 ts_ns;
+	u32 status;
+	u32 ipi_status;
+};
+
 /* -----------------------------------------------------------------------------
  * Clocks
  */
@@ -360,6 +370,11 @@ struct dwc_csi_device {
 	struct dwc_csi_event events[DWC_NUM_EVENTS];
 	const struct dwc_csi_pix_format *csi_fmt;
 
+	struct dentry *debugfs_root;
+	struct dwc_csi_ring_entry *ring;
+	unsigned int ring_head;	/* written by the interrupt handler only */
+	bool event_ring;
+
 	/* Used for pattern generator */
 	bool pg_enable;
 	enum {
@@ -816,6 +831,73 @@ static void dwc_csi_log_counters(struct dwc_csi_device *csidev)
 	spin_unlock_irqrestore(&csidev->slock, flags);
 }
 
+/*
+ * The counters of all events live in the interrupt handler, the IPI only
+ * receives the virtual channel programmed in CSI2RX_IPI_VCID so they all
+ * belong to it. Reading them without the lock is fine for monitoring.
+ */
+static int dwc_csi_counters_show(struct seq_file *m, void *private)
+{
+	struct dwc_csi_device *csidev = m->private;
+	unsigned int i;
+
+	for (i = 0; i < DWC_NUM_EVENTS; ++i)
+		seq_printf(m, "%-32s %u\n", csidev->events[i].name,
+			   READ_ONCE(csidev->events[i].counter));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(dwc_csi_counters);
+
+/*
+ * Entries may be overwritten by the interrupt handler while they are
+ * printed, the dump is a best effort view of the latest errors.
+ */
+static int dwc_csi_event_ring_show(struct seq_file *m, void *private)
+{
+	struct dwc_csi_device *csidev = m->private;
+	unsigned int head, i;
+
+	head = smp_load_acquire(&csidev->ring_head);
+	i = head > DWC_EVENT_RING_SIZE ? head - DWC_EVENT_RING_SIZE : 0;
+
+	for (; i != head; i++) {
+		const struct dwc_csi_ring_entry *entry =
+			&csidev->ring[i % DWC_EVENT_RING_SIZE];
+
+		seq_printf(m, "%llu.%06llu: main 0x%08x ipi 0x%08x\n",
+			   div_u64(entry->ts_ns, NSEC_PER_SEC),
+			   div_u64(entry->ts_ns % NSEC_PER_SEC, NSEC_PER_USEC),
+			   entry->status, entry->ipi_status);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(dwc_csi_event_ring);
+
+static void dwc_csi_debugfs_init(struct dwc_csi_device *csidev)
+{
+	csidev->debugfs_root = debugfs_create_dir(dev_name(csidev->dev), NULL);
+
+	debugfs_create_file("counters", 0400, csidev->debugfs_root, csidev,
+			    &dwc_csi_counters_fops);
+
+	csidev->ring = devm_kcalloc(csidev->dev, DWC_EVENT_RING_SIZE,
+				    sizeof(*csidev->ring), GFP_KERNEL);
+	if (!csidev->ring)
+		return;
+
+	debugfs_create_bool("event_ring_enable", 0600, csidev->debugfs_root,
+			    &csidev->event_ring);
+	debugfs_create_file("event_ring", 0400, csidev->debugfs_root, csidev,
+			    &dwc_csi_event_ring_fops);
+}
+
+static void dwc_csi_debugfs_exit(struct dwc_csi_device *csidev)
+{
+	debugfs_remove_recursive(csidev->debugfs_root);
+}
+
 static void dwc_csi_dump_regs(struct dwc_csi_device *csidev)
 {
 #define DWC_MIPI_CSIS_DEBUG_REG(name)		{name, #name}
@@ -1525,6 +1607,22 @@ static irqreturn_t dwc_csi_irq_handler(int irq, void *priv)
 
 	status = dwc_csi_read(csidev, CSI2RX_INT_ST_MAIN);
 
+	if (csidev->ring && READ_ONCE(csidev->event_ring) &&
+	    (status & DWC_EVENT_MASK)) {
+		unsigned int head = csidev->ring_head;
+		struct dwc_csi_ring_entry *entry;
+
+		entry = &csidev->ring[head % DWC_EVENT_RING_SIZE];
+		entry->ts_ns = ktime_get_ns();
+		entry->status = status;
+		/* tells FIFO overflows from the other IPI errors */
+		entry->ipi_status = status & CSI2RX_INT_ST_MAIN_FATAL_ERR_IPI ?
+				    dwc_csi_read(csidev, CSI2RX_INT_ST_IPI_FATAL) : 0;
+
+		/* publish the entry before the new head */
+		smp_store_release(&csidev->ring_head, head + 1);
+	}
+
 	spin_lock_irqsave(&csidev->slock, flags);
 
 	if (status & DWC_EVENT_MASK) {
@@ -1653,6 +1751,7 @@ static int dwc_csi_device_probe(struct platform_device *pdev)
 		goto err_ctl_cleanup;
 	}
 
+	dwc_csi_debugfs_init(csidev);
 	pm_runtime_enable(dev);
 
 	return 0;
@@ -1671,6 +1770,7 @@ static void dwc_csi_device_remove(struct platform_device *pdev)
 	struct v4l2_subdev *sd = platform_get_drvdata(pdev);
 	struct dwc_csi_device *csidev = sd_to_dwc_csi_device(sd);
 
+	dwc_csi_debugfs_exit(csidev);
 	dwc_csi_controls_cleanup(csidev);
 
 	v4l2_async_nf_unregister(&csidev->notifier);
@@ -142,7 +142,9 @@ int mxc_jpeg_enable(void __iomem *reg)
 {
 	u32 regval;
 
-	writel(GLB_CTRL_JPG_EN, reg + GLB_CTRL);
+	/* keep the other slots enabled */
+	regval = readl(reg + GLB_CTRL) & ~(GLB_CTRL_SFT_RST | GLB_CTRL_DEC_GO);
+	writel(GLB_CTRL_JPG_EN | regval, reg + GLB_CTRL);
 	regval = readl(reg);
 	return regval;
 }
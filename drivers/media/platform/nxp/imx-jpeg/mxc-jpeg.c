@@ -18,15 +18,21 @@
  * When decoding, the driver detects image resolution and pixel format
  * from the jpeg stream, by parsing the jpeg markers.
  *
- * The IP has 4 slots available for context switching, but only slot 0
- * was fully tested to work. Context switching is not used by the driver.
- * Each driver instance (context) allocates a slot for itself, but this
- * is postponed until device_run, to allow unlimited opens.
+ * The IP has 4 slots available for context switching. The decoder uses one
+ * slot per interrupt described in the device tree, each with its own
+ * descriptors. The m2m framework runs as many jobs of different driver
+ * instances (contexts) at once as there are slots, each job takes the first
+ * idle slot and the hardware arbitrates between the slots. The encoder starts
+ * the encoding phase from the config phase interrupt through the global CAST
+ * registers, so it keeps to a single slot, as does the decoder if only one
+ * interrupt is described; the "slot" property selects which one.
  *
  * The driver submits jobs to the IP by setting up a descriptor for the
  * used slot, and then validating it. The encoder has an additional descriptor
  * for the configuration phase. The driver expects FRM_DONE interrupt from
- * IP to mark the job as finished.
+ * IP to mark the job as finished. When several buffer pairs are queued with
+ * the same format, the decoder links up to max_chain descriptors into one
+ * job, and the FRM_DONE interrupt of each frame only completes its buffers.
  *
  * The decoder IP has some limitations regarding the component ID's,
  * but the driver works around this by replacing them in the jpeg stream.
@@ -40,6 +46,7 @@
  * Copyright 2018-2019 NXP
  */
 
+#include <linux/bitops.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/io.h>
@@ -602,6 +609,10 @@ static unsigned int hw_timeout = 2000;
 module_param(hw_timeout, int, 0644);
 MODULE_PARM_DESC(hw_timeout, "MXC JPEG hw timeout, the number of milliseconds");
 
+static unsigned int max_chain = MXC_JPEG_MAX_CHAIN;
+module_param(max_chain, uint, 0644);
+MODULE_PARM_DESC(max_chain, "Maximum number of frames decoded back to back in one job (1-4)");
+
 static void mxc_jpeg_bytesperline(struct mxc_jpeg_q_data *q, u32 precision);
 static void mxc_jpeg_sizeimage(struct mxc_jpeg_q_data *q);
 
@@ -788,97 +799,126 @@ static void notify_src_chg(struct mxc_jpeg_ctx *ctx)
 	v4l2_event_queue_fh(&ctx->fh, &ev);
 }
 
-static int mxc_get_free_slot(struct mxc_jpeg_slot_data *slot_data)
+static inline struct mxc_jpeg_slot_data *
+mxc_jpeg_ctx_slot_data(struct mxc_jpeg_ctx *ctx)
 {
-	if (!slot_data->used)
-		return slot_data->slot;
-	return -1;
+	return &ctx->mxc_jpeg->slot_data[ctx->slot];
+}
+
+/* the m2m framework runs at most one job per slot, so one is idle */
+static unsigned int mxc_jpeg_get_free_slot(struct mxc_jpeg_dev *jpeg)
+{
+	unsigned int slot;
+
+	for_each_set_bit(slot, &jpeg->slot_mask, MXC_JPEG_MAX_SLOTS) {
+		if (!jpeg->slot_data[slot].used)
+			return slot;
+	}
+
+	return MXC_JPEG_MAX_SLOTS;
+}
+
+/* a soft reset would abort the jobs still running on other slots */
+static bool mxc_jpeg_other_slots_busy(struct mxc_jpeg_dev *jpeg,
+				      unsigned int slot)
+{
+	unsigned int i;
+
+	for_each_set_bit(i, &jpeg->slot_mask, MXC_JPEG_MAX_SLOTS) {
+		if (i != slot && jpeg->slot_data[i].used)
+			return true;
+	}
+
+	return false;
 }
 
-static void mxc_jpeg_free_slot_data(struct mxc_jpeg_dev *jpeg)
+static void mxc_jpeg_free_slot_data(struct mxc_jpeg_slot_data *slot_data)
 {
-	/* free descriptor for decoding/encoding phase */
-	dma_free_coherent(jpeg->dev, sizeof(struct mxc_jpeg_desc),
-			  jpeg->slot_data.desc,
-			  jpeg->slot_data.desc_handle);
-	jpeg->slot_data.desc = NULL;
-	jpeg->slot_data.desc_handle = 0;
+	struct device *dev = slot_data->jpeg->dev;
+
+	/* free descriptors for decoding/encoding phase */
+	dma_free_coherent(dev, MXC_JPEG_MAX_CHAIN * sizeof(struct mxc_jpeg_desc),
+			  slot_data->desc,
+			  slot_data->desc_handle);
+	slot_data->desc = NULL;
+	slot_data->desc_handle = 0;
 
 	/* free descriptor for encoder configuration phase / decoder DHT */
-	dma_free_coherent(jpeg->dev, sizeof(struct mxc_jpeg_desc),
-			  jpeg->slot_data.cfg_desc,
-			  jpeg->slot_data.cfg_desc_handle);
-	jpeg->slot_data.cfg_desc_handle = 0;
-	jpeg->slot_data.cfg_desc = NULL;
+	dma_free_coherent(dev, sizeof(struct mxc_jpeg_desc),
+			  slot_data->cfg_desc,
+			  slot_data->cfg_desc_handle);
+	slot_data->cfg_desc_handle = 0;
+	slot_data->cfg_desc = NULL;
 
 	/* free configuration stream */
-	dma_free_coherent(jpeg->dev, MXC_JPEG_MAX_CFG_STREAM,
-			  jpeg->slot_data.cfg_stream_vaddr,
-			  jpeg->slot_data.cfg_stream_handle);
-	jpeg->slot_data.cfg_stream_vaddr = NULL;
-	jpeg->slot_data.cfg_stream_handle = 0;
+	dma_free_coherent(dev, MXC_JPEG_MAX_CFG_STREAM,
+			  slot_data->cfg_stream_vaddr,
+			  slot_data->cfg_stream_handle);
+	slot_data->cfg_stream_vaddr = NULL;
+	slot_data->cfg_stream_handle = 0;
 
-	dma_free_coherent(jpeg->dev, jpeg->slot_data.cfg_dec_size,
-			  jpeg->slot_data.cfg_dec_vaddr,
-			  jpeg->slot_data.cfg_dec_daddr);
-	jpeg->slot_data.cfg_dec_size = 0;
-	jpeg->slot_data.cfg_dec_vaddr = NULL;
-	jpeg->slot_data.cfg_dec_daddr = 0;
+	dma_free_coherent(dev, slot_data->cfg_dec_size,
+			  slot_data->cfg_dec_vaddr,
+			  slot_data->cfg_dec_daddr);
+	slot_data->cfg_dec_size = 0;
+	slot_data->cfg_dec_vaddr = NULL;
+	slot_data->cfg_dec_daddr = 0;
 
-	jpeg->slot_data.used = false;
+	slot_data->used = false;
 }
 
-static bool mxc_jpeg_alloc_slot_data(struct mxc_jpeg_dev *jpeg)
+static bool mxc_jpeg_alloc_slot_data(struct mxc_jpeg_slot_data *slot_data)
 {
+	struct device *dev = slot_data->jpeg->dev;
 	struct mxc_jpeg_desc *desc;
 	struct mxc_jpeg_desc *cfg_desc;
 	void *cfg_stm;
 
-	if (jpeg->slot_data.desc)
+	if (slot_data->desc)
 		goto skip_alloc; /* already allocated, reuse it */
 
-	/* allocate descriptor for decoding/encoding phase */
-	desc = dma_alloc_coherent(jpeg->dev,
-				  sizeof(struct mxc_jpeg_desc),
-				  &jpeg->slot_data.desc_handle,
+	/* allocate descriptors for decoding/encoding phase */
+	desc = dma_alloc_coherent(dev,
+				  MXC_JPEG_MAX_CHAIN * sizeof(struct mxc_jpeg_desc),
+				  &slot_data->desc_handle,
 				  GFP_ATOMIC);
 	if (!desc)
 		goto err;
-	jpeg->slot_data.desc = desc;
+	slot_data->desc = desc;
 
 	/* allocate descriptor for configuration phase (encoder only) */
-	cfg_desc = dma_alloc_coherent(jpeg->dev,
+	cfg_desc = dma_alloc_coherent(dev,
 				      sizeof(struct mxc_jpeg_desc),
-				      &jpeg->slot_data.cfg_desc_handle,
+				      &slot_data->cfg_desc_handle,
 				      GFP_ATOMIC);
 	if (!cfg_desc)
 		goto err;
-	jpeg->slot_data.cfg_desc = cfg_desc;
+	slot_data->cfg_desc = cfg_desc;
 
 	/* allocate configuration stream */
-	cfg_stm = dma_alloc_coherent(jpeg->dev,
+	cfg_stm = dma_alloc_coherent(dev,
 				     MXC_JPEG_MAX_CFG_STREAM,
-				     &jpeg->slot_data.cfg_stream_handle,
+				     &slot_data->cfg_stream_handle,
 				     GFP_ATOMIC);
 	if (!cfg_stm)
 		goto err;
-	jpeg->slot_data.cfg_stream_vaddr = cfg_stm;
-
-	jpeg->slot_data.cfg_dec_size = MXC_JPEG_PATTERN_WIDTH * MXC_JPEG_PATTERN_HEIGHT * 2;
-	jpeg->slot_data.cfg_dec_vaddr = dma_alloc_coherent(jpeg->dev,
-							   jpeg->slot_data.cfg_dec_size,
-							   &jpeg->slot_data.cfg_dec_daddr,
-							   GFP_ATOMIC);
-	if (!jpeg->slot_data.cfg_dec_vaddr)
+	slot_data->cfg_stream_vaddr = cfg_stm;
+
+	slot_data->cfg_dec_size = MXC_JPEG_PATTERN_WIDTH * MXC_JPEG_PATTERN_HEIGHT * 2;
+	slot_data->cfg_dec_vaddr = dma_alloc_coherent(dev,
+						      slot_data->cfg_dec_size,
+						      &slot_data->cfg_dec_daddr,
+						      GFP_ATOMIC);
+	if (!slot_data->cfg_dec_vaddr)
 		goto err;
 
 skip_alloc:
-	jpeg->slot_data.used = true;
+	slot_data->used = true;
 
 	return true;
 err:
-	dev_err(jpeg->dev, "Could not allocate descriptors for slot %d", jpeg->slot_data.slot);
-	mxc_jpeg_free_slot_data(jpeg);
+	dev_err(dev, "Could not allocate descriptors for slot %d", slot_data->slot);
+	mxc_jpeg_free_slot_data(slot_data);
 
 	return false;
 }
@@ -895,10 +935,8 @@ static void mxc_jpeg_check_and_set_last_buffer(struct mxc_jpeg_ctx *ctx,
 	}
 }
 
-static void mxc_jpeg_job_finish(struct mxc_jpeg_ctx *ctx, enum vb2_buffer_state state, bool reset)
+static void mxc_jpeg_buf_done(struct mxc_jpeg_ctx *ctx, enum vb2_buffer_state state)
 {
-	struct mxc_jpeg_dev *jpeg = ctx->mxc_jpeg;
-	void __iomem *reg = jpeg->base_reg;
 	struct vb2_v4l2_buffer *src_buf, *dst_buf;
 
 	dst_buf = v4l2_m2m_next_dst_buf(ctx->fh.m2m_ctx);
@@ -908,9 +946,21 @@ static void mxc_jpeg_job_finish(struct mxc_jpeg_ctx *ctx, enum vb2_buffer_state
 	v4l2_m2m_dst_buf_remove(ctx->fh.m2m_ctx);
 	v4l2_m2m_buf_done(src_buf, state);
 	v4l2_m2m_buf_done(dst_buf, state);
+}
+
+static void mxc_jpeg_job_finish(struct mxc_jpeg_ctx *ctx, enum vb2_buffer_state state, bool reset)
+{
+	struct mxc_jpeg_dev *jpeg = ctx->mxc_jpeg;
+	struct mxc_jpeg_slot_data *slot_data = mxc_jpeg_ctx_slot_data(ctx);
+	void __iomem *reg = jpeg->base_reg;
+
+	/* on errors, the frames still chained behind are dropped as well */
+	for (; slot_data->chain_len; slot_data->chain_len--)
+		mxc_jpeg_buf_done(ctx, state);
 
 	mxc_jpeg_disable_irq(reg, ctx->slot);
-	jpeg->slot_data.used = false;
+	slot_data->used = false;
+	slot_data->ctx = NULL;
 	if (reset)
 		mxc_jpeg_sw_reset(reg);
 }
@@ -951,7 +1001,7 @@ static bool mxc_dec_is_ongoing(struct mxc_jpeg_ctx *ctx)
 	slot_status = readl(jpeg->base_reg + MXC_SLOT_OFFSET(ctx->slot, SLOT_STATUS));
 	curr_desc = readl(jpeg->base_reg + MXC_SLOT_OFFSET(ctx->slot, SLOT_CUR_DESCPT_PTR));
 
-	if (curr_desc == jpeg->slot_data.cfg_desc_handle)
+	if (curr_desc == jpeg->slot_data[ctx->slot].cfg_desc_handle)
 		return true;
 	if (slot_status & SLOT_STATUS_ONGOING)
 		return true;
@@ -961,7 +1011,8 @@ static bool mxc_dec_is_ongoing(struct mxc_jpeg_ctx *ctx)
 
 static irqreturn_t mxc_jpeg_dec_irq(int irq, void *priv)
 {
-	struct mxc_jpeg_dev *jpeg = priv;
+	struct mxc_jpeg_slot_data *slot_data = priv;
+	struct mxc_jpeg_dev *jpeg = slot_data->jpeg;
 	struct mxc_jpeg_ctx *ctx;
 	void __iomem *reg = jpeg->base_reg;
 	struct device *dev = jpeg->dev;
@@ -972,26 +1023,19 @@ static irqreturn_t mxc_jpeg_dec_irq(int irq, void *priv)
 	unsigned long payload;
 	struct mxc_jpeg_q_data *q_data;
 	enum v4l2_buf_type cap_type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
-	unsigned int slot;
+	unsigned int slot = slot_data->slot;
 
 	spin_lock(&jpeg->hw_lock);
 
 	com_status = readl(reg + COM_STATUS);
-	slot = COM_STATUS_CUR_SLOT(com_status);
-	dev_dbg(dev, "Irq %d on slot %d.\n", irq, slot);
+	dev_dbg(dev, "Irq %d on slot %d, current slot %d.\n", irq, slot,
+		COM_STATUS_CUR_SLOT(com_status));
 
-	ctx = v4l2_m2m_get_curr_priv(jpeg->m2m_dev);
-	if (WARN_ON(!ctx))
-		goto job_unlock;
-
-	if (slot != ctx->slot) {
-		/* TODO investigate when adding multi-instance support */
-		dev_warn(dev, "IRQ slot %d != context slot %d.\n",
-			 slot, ctx->slot);
+	if (!slot_data->used)
 		goto job_unlock;
-	}
 
-	if (!jpeg->slot_data.used)
+	ctx = slot_data->ctx;
+	if (WARN_ON(!ctx))
 		goto job_unlock;
 
 	dec_ret = readl(reg + MXC_SLOT_OFFSET(slot, SLOT_STATUS));
@@ -1061,8 +1105,19 @@ static irqreturn_t mxc_jpeg_dec_irq(int irq, void *priv)
 	print_mxc_buf(jpeg, &dst_buf->vb2_buf, 32);
 	buf_state = VB2_BUF_STATE_DONE;
 
+	if (slot_data->chain_len > 1) {
+		/* the IP moves on to the next chained frame by itself */
+		mxc_jpeg_buf_done(ctx, buf_state);
+		slot_data->chain_len--;
+		spin_unlock(&jpeg->hw_lock);
+		mod_delayed_work(system_wq, &ctx->task_timer,
+				 msecs_to_jiffies(hw_timeout));
+		return IRQ_HANDLED;
+	}
+
 buffers_done:
-	mxc_jpeg_job_finish(ctx, buf_state, sw_reset);
+	mxc_jpeg_job_finish(ctx, buf_state,
+			    sw_reset && !mxc_jpeg_other_slots_busy(jpeg, slot));
 	spin_unlock(&jpeg->hw_lock);
 	cancel_delayed_work(&ctx->task_timer);
 	v4l2_m2m_job_finish(jpeg->m2m_dev, ctx->fh.m2m_ctx);
@@ -1241,30 +1296,18 @@ static unsigned int mxc_jpeg_setup_cfg_stream(void *cfg_stream_vaddr,
 	return offset;
 }
 
-static void mxc_jpeg_config_dec_desc(struct vb2_buffer *out_buf,
-				     struct mxc_jpeg_ctx *ctx,
-				     struct vb2_buffer *src_buf,
-				     struct vb2_buffer *dst_buf)
+static void mxc_jpeg_setup_dec_desc(struct mxc_jpeg_ctx *ctx,
+				    struct mxc_jpeg_desc *desc,
+				    struct vb2_buffer *src_buf,
+				    struct vb2_buffer *dst_buf)
 {
 	enum v4l2_buf_type cap_type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
 	struct mxc_jpeg_q_data *q_data_cap;
 	enum mxc_jpeg_image_format img_fmt;
-	struct mxc_jpeg_dev *jpeg = ctx->mxc_jpeg;
-	void __iomem *reg = jpeg->base_reg;
-	unsigned int slot = ctx->slot;
-	struct mxc_jpeg_desc *desc = jpeg->slot_data.desc;
-	struct mxc_jpeg_desc *cfg_desc = jpeg->slot_data.cfg_desc;
-	dma_addr_t desc_handle = jpeg->slot_data.desc_handle;
-	dma_addr_t cfg_desc_handle = jpeg->slot_data.cfg_desc_handle;
-	dma_addr_t cfg_stream_handle = jpeg->slot_data.cfg_stream_handle;
-	unsigned int *cfg_size = &jpeg->slot_data.cfg_stream_size;
-	void *cfg_stream_vaddr = jpeg->slot_data.cfg_stream_vaddr;
 	struct mxc_jpeg_src_buf *jpeg_src_buf;
 
 	jpeg_src_buf = vb2_to_mxc_buf(src_buf);
 
-	/* setup the decoding descriptor */
-	desc->next_descpt_ptr = 0; /* end of chain */
 	q_data_cap = mxc_jpeg_get_q_data(ctx, cap_type);
 	desc->imgsize = q_data_cap->w_adjusted << 16 | q_data_cap->h_adjusted;
 	img_fmt = mxc_jpeg_fourcc_to_imgfmt(q_data_cap->fmt->fourcc);
@@ -1278,7 +1321,40 @@ static void mxc_jpeg_config_dec_desc(struct vb2_buffer *out_buf,
 	desc->line_pitch = q_data_cap->bytesperline[0];
 	mxc_jpeg_addrs(desc, dst_buf, src_buf, 0);
 	mxc_jpeg_set_bufsize(desc, ALIGN(vb2_plane_size(src_buf, 0), 1024));
-	print_descriptor_info(jpeg->dev, desc);
+}
+
+static void mxc_jpeg_config_dec_desc(struct mxc_jpeg_ctx *ctx,
+				     struct vb2_v4l2_buffer **src_bufs,
+				     struct vb2_v4l2_buffer **dst_bufs,
+				     unsigned int n)
+{
+	struct mxc_jpeg_dev *jpeg = ctx->mxc_jpeg;
+	void __iomem *reg = jpeg->base_reg;
+	unsigned int slot = ctx->slot;
+	struct mxc_jpeg_slot_data *slot_data = &jpeg->slot_data[slot];
+	struct mxc_jpeg_desc *desc = slot_data->desc;
+	struct mxc_jpeg_desc *cfg_desc = slot_data->cfg_desc;
+	dma_addr_t desc_handle = slot_data->desc_handle;
+	dma_addr_t cfg_desc_handle = slot_data->cfg_desc_handle;
+	dma_addr_t cfg_stream_handle = slot_data->cfg_stream_handle;
+	unsigned int *cfg_size = &slot_data->cfg_stream_size;
+	void *cfg_stream_vaddr = slot_data->cfg_stream_vaddr;
+	struct mxc_jpeg_src_buf *jpeg_src_buf;
+	unsigned int i;
+
+	jpeg_src_buf = vb2_to_mxc_buf(&src_bufs[0]->vb2_buf);
+
+	/* setup the decoding descriptors, each linked to the next frame */
+	for (i = 0; i < n; i++) {
+		mxc_jpeg_setup_dec_desc(ctx, &desc[i], &src_bufs[i]->vb2_buf,
+					&dst_bufs[i]->vb2_buf);
+		if (i + 1 < n)
+			desc[i].next_descpt_ptr = (desc_handle + (i + 1) * sizeof(*desc)) |
+						  MXC_NXT_DESCPT_EN;
+		else
+			desc[i].next_descpt_ptr = 0; /* end of chain */
+		print_descriptor_info(jpeg->dev, &desc[i]);
+	}
 
 	if (!jpeg_src_buf->dht_needed) {
 		/* validate the decoding descriptor */
@@ -1295,7 +1371,7 @@ static void mxc_jpeg_config_dec_desc(struct vb2_buffer *out_buf,
 					      MXC_JPEG_PATTERN_WIDTH,
 					      MXC_JPEG_PATTERN_HEIGHT);
 	cfg_desc->next_descpt_ptr = desc_handle | MXC_NXT_DESCPT_EN;
-	cfg_desc->buf_base0 = jpeg->slot_data.cfg_dec_daddr;
+	cfg_desc->buf_base0 = slot_data->cfg_dec_daddr;
 	cfg_desc->buf_base1 = 0;
 	cfg_desc->imgsize = MXC_JPEG_PATTERN_WIDTH << 16;
 	cfg_desc->imgsize |= MXC_JPEG_PATTERN_HEIGHT;
@@ -1318,18 +1394,19 @@ static void mxc_jpeg_config_enc_desc(struct vb2_buffer *out_buf,
 	struct mxc_jpeg_dev *jpeg = ctx->mxc_jpeg;
 	void __iomem *reg = jpeg->base_reg;
 	unsigned int slot = ctx->slot;
-	struct mxc_jpeg_desc *desc = jpeg->slot_data.desc;
-	struct mxc_jpeg_desc *cfg_desc = jpeg->slot_data.cfg_desc;
-	dma_addr_t desc_handle = jpeg->slot_data.desc_handle;
-	dma_addr_t cfg_desc_handle = jpeg->slot_data.cfg_desc_handle;
-	void *cfg_stream_vaddr = jpeg->slot_data.cfg_stream_vaddr;
+	struct mxc_jpeg_slot_data *slot_data = &jpeg->slot_data[slot];
+	struct mxc_jpeg_desc *desc = slot_data->desc;
+	struct mxc_jpeg_desc *cfg_desc = slot_data->cfg_desc;
+	dma_addr_t desc_handle = slot_data->desc_handle;
+	dma_addr_t cfg_desc_handle = slot_data->cfg_desc_handle;
+	void *cfg_stream_vaddr = slot_data->cfg_stream_vaddr;
 	struct mxc_jpeg_q_data *q_data;
 	enum mxc_jpeg_image_format img_fmt;
 	int w, h;
 
 	q_data = mxc_jpeg_get_q_data(ctx, src_buf->vb2_queue->type);
 
-	jpeg->slot_data.cfg_stream_size =
+	slot_data->cfg_stream_size =
 			mxc_jpeg_setup_cfg_stream(cfg_stream_vaddr,
 						  q_data->fmt->fourcc,
 						  q_data->crop.width,
@@ -1338,7 +1415,7 @@ static void mxc_jpeg_config_enc_desc(struct vb2_buffer *out_buf,
 	/* chain the config descriptor with the encoding descriptor */
 	cfg_desc->next_descpt_ptr = desc_handle | MXC_NXT_DESCPT_EN;
 
-	cfg_desc->buf_base0 = jpeg->slot_data.cfg_stream_handle;
+	cfg_desc->buf_base0 = slot_data->cfg_stream_handle;
 	cfg_desc->buf_base1 = 0;
 	cfg_desc->line_pitch = 0;
 	cfg_desc->stm_bufbase = 0; /* no output expected */
@@ -1498,30 +1575,97 @@ static void mxc_jpeg_device_run_timeout(struct work_struct *work)
 	struct delayed_work *dwork = to_delayed_work(work);
 	struct mxc_jpeg_ctx *ctx = container_of(dwork, struct mxc_jpeg_ctx, task_timer);
 	struct mxc_jpeg_dev *jpeg = ctx->mxc_jpeg;
+	struct mxc_jpeg_slot_data *slot_data = mxc_jpeg_ctx_slot_data(ctx);
 	unsigned long flags;
 
 	spin_lock_irqsave(&ctx->mxc_jpeg->hw_lock, flags);
-	if (ctx->mxc_jpeg->slot_data.used) {
-		dev_warn(jpeg->dev, "%s timeout, cancel it\n",
-			 ctx->mxc_jpeg->mode == MXC_JPEG_DECODE ? "decode" : "encode");
+	if (slot_data->used && slot_data->ctx == ctx) {
+		dev_warn(jpeg->dev, "%s timeout on slot %d, cancel it\n",
+			 ctx->mxc_jpeg->mode == MXC_JPEG_DECODE ? "decode" : "encode",
+			 ctx->slot);
 		mxc_jpeg_job_finish(ctx, VB2_BUF_STATE_ERROR, true);
-		v4l2_m2m_job_finish(ctx->mxc_jpeg->m2m_dev, ctx->fh.m2m_ctx);
+		v4l2_m2m_job_finish(jpeg->m2m_dev, ctx->fh.m2m_ctx);
 	}
 	spin_unlock_irqrestore(&ctx->mxc_jpeg->hw_lock, flags);
 }
 
+/*
+ * Collect the buffer pairs queued behind the current one that can be decoded
+ * in the same descriptor chain: anything device_run() would stop at for a
+ * frame of its own (format change, parse error, end of drain) ends the chain.
+ * Frames relying on the default Huffman tables only chain with each other,
+ * they all use the DHT injected in front of the first one.
+ */
+static unsigned int mxc_jpeg_dec_chain(struct mxc_jpeg_ctx *ctx,
+				       struct vb2_v4l2_buffer **src_bufs,
+				       struct vb2_v4l2_buffer **dst_bufs)
+{
+	struct v4l2_m2m_ctx *m2m_ctx = ctx->fh.m2m_ctx;
+	unsigned int max = clamp_t(unsigned int, max_chain, 1, MXC_JPEG_MAX_CHAIN);
+	struct mxc_jpeg_src_buf *head, *jpeg_src_buf;
+	struct mxc_jpeg_q_data *q_data_cap;
+	unsigned int n_src = 0, n_dst = 0, i;
+	struct v4l2_m2m_buffer *b;
+
+	spin_lock(&m2m_ctx->out_q_ctx.rdy_spinlock);
+	v4l2_m2m_for_each_src_buf(m2m_ctx, b) {
+		if (n_src == max)
+			break;
+		src_bufs[n_src++] = &b->vb;
+	}
+	spin_unlock(&m2m_ctx->out_q_ctx.rdy_spinlock);
+
+	spin_lock(&m2m_ctx->cap_q_ctx.rdy_spinlock);
+	v4l2_m2m_for_each_dst_buf(m2m_ctx, b) {
+		if (n_dst == max)
+			break;
+		dst_bufs[n_dst++] = &b->vb;
+	}
+	spin_unlock(&m2m_ctx->cap_q_ctx.rdy_spinlock);
+
+	q_data_cap = mxc_jpeg_get_q_data(ctx, V4L2_BUF_TYPE_VIDEO_CAPTURE);
+	head = vb2_to_mxc_buf(&src_bufs[0]->vb2_buf);
+
+	for (i = 1; i < min(n_src, n_dst); i++) {
+		jpeg_src_buf = vb2_to_mxc_buf(&src_bufs[i]->vb2_buf);
+
+		if (v4l2_m2m_is_last_draining_src_buf(m2m_ctx, src_bufs[i - 1]) ||
+		    jpeg_src_buf->jpeg_parse_error ||
+		    jpeg_src_buf->dht_needed != head->dht_needed ||
+		    !jpeg_src_buf->fmt ||
+		    (jpeg_src_buf->fmt != q_data_cap->fmt &&
+		     !mxc_jpeg_compare_format(q_data_cap->fmt, jpeg_src_buf->fmt)) ||
+		    jpeg_src_buf->w != q_data_cap->w ||
+		    jpeg_src_buf->h != q_data_cap->h ||
+		    dst_bufs[i]->vb2_buf.num_planes != q_data_cap->fmt->mem_planes)
+			break;
+	}
+
+	return i;
+}
+
 static void mxc_jpeg_device_run(void *priv)
 {
 	struct mxc_jpeg_ctx *ctx = priv;
 	struct mxc_jpeg_dev *jpeg = ctx->mxc_jpeg;
+	struct mxc_jpeg_slot_data *slot_data;
+	struct vb2_v4l2_buffer *src_bufs[MXC_JPEG_MAX_CHAIN];
+	struct vb2_v4l2_buffer *dst_bufs[MXC_JPEG_MAX_CHAIN];
 	void __iomem *reg = jpeg->base_reg;
 	struct device *dev = jpeg->dev;
 	struct vb2_v4l2_buffer *src_buf, *dst_buf;
+	unsigned int n, i, slot;
 	unsigned long flags;
 	struct mxc_jpeg_q_data *q_data_cap, *q_data_out;
 	struct mxc_jpeg_src_buf *jpeg_src_buf;
 
 	spin_lock_irqsave(&ctx->mxc_jpeg->hw_lock, flags);
+	slot = mxc_jpeg_get_free_slot(jpeg);
+	if (WARN_ON(slot >= MXC_JPEG_MAX_SLOTS))
+		goto end;
+	ctx->slot = slot;
+	slot_data = &jpeg->slot_data[slot];
+
 	src_buf = v4l2_m2m_next_src_buf(ctx->fh.m2m_ctx);
 	dst_buf = v4l2_m2m_next_dst_buf(ctx->fh.m2m_ctx);
 	if (!src_buf || !dst_buf) {
@@ -1569,21 +1713,18 @@ static void mxc_jpeg_device_run(void *priv)
 	mxc_jpeg_enable(reg);
 	mxc_jpeg_set_l_endian(reg, 1);
 
-	ctx->slot = mxc_get_free_slot(&jpeg->slot_data);
-	if (ctx->slot < 0) {
-		dev_err(dev, "No more free slots\n");
-		goto end;
-	}
-	if (!mxc_jpeg_alloc_slot_data(jpeg)) {
+	if (!mxc_jpeg_alloc_slot_data(slot_data)) {
 		dev_err(dev, "Cannot allocate slot data\n");
 		goto end;
 	}
+	slot_data->ctx = ctx;
 
 	mxc_jpeg_enable_slot(reg, ctx->slot);
 	mxc_jpeg_enable_irq(reg, ctx->slot);
 
 	if (jpeg->mode == MXC_JPEG_ENCODE) {
 		dev_dbg(dev, "Encoding on slot %d\n", ctx->slot);
+		slot_data->chain_len = 1;
 		ctx->enc_state = MXC_JPEG_ENC_CONF;
 		mxc_jpeg_config_enc_desc(&dst_buf->vb2_buf, ctx,
 					 &src_buf->vb2_buf, &dst_buf->vb2_buf);
@@ -1591,10 +1732,18 @@ static void mxc_jpeg_device_run(void *priv)
 		mxc_jpeg_enc_mode_conf(dev, reg,
 				       mxc_jpeg_is_extended_sequential(q_data_out->fmt));
 	} else {
-		dev_dbg(dev, "Decoding on slot %d\n", ctx->slot);
+		n = mxc_jpeg_dec_chain(ctx, src_bufs, dst_bufs);
+		for (i = 1; i < n; i++) {
+			src_bufs[i]->sequence = q_data_out->sequence++;
+			dst_bufs[i]->sequence = q_data_cap->sequence++;
+			v4l2_m2m_buf_copy_metadata(src_bufs[i], dst_bufs[i], true);
+			/* covered by the DHT injected for the first frame */
+			vb2_to_mxc_buf(&src_bufs[i]->vb2_buf)->dht_needed = false;
+		}
+		slot_data->chain_len = n;
+		dev_dbg(dev, "Decoding %u frame(s) on slot %d\n", n, ctx->slot);
 		print_mxc_buf(jpeg, &src_buf->vb2_buf, 0);
-		mxc_jpeg_config_dec_desc(&dst_buf->vb2_buf, ctx,
-					 &src_buf->vb2_buf, &dst_buf->vb2_buf);
+		mxc_jpeg_config_dec_desc(ctx, src_bufs, dst_bufs, n);
 		mxc_jpeg_dec_mode_go(dev, reg);
 	}
 	schedule_delayed_work(&ctx->task_timer, msecs_to_jiffies(hw_timeout));
@@ -1763,6 +1912,17 @@ static void mxc_jpeg_stop_streaming(struct vb2_queue *q)
 	pm_runtime_put_sync(&ctx->mxc_jpeg->pdev->dev);
 }
 
+static void mxc_jpeg_patch_comp_id(struct mxc_jpeg_sof *sof,
+				   struct mxc_jpeg_sos *sos)
+{
+	int i;
+
+	for (i = 0; i < sof->components_no; i++) {
+		sof->comp[i].id = i + 1;
+		sos->comp[i].id = i + 1;
+	}
+}
+
 static int mxc_jpeg_valid_comp_id(struct device *dev,
 				  struct mxc_jpeg_sof *sof,
 				  struct mxc_jpeg_sos *sos)
@@ -1780,14 +1940,13 @@ static int mxc_jpeg_valid_comp_id(struct device *dev,
 			dev_err(dev, "Component %d has invalid ID: %d",
 				i, sof->comp[i].id);
 		}
-	if (!valid)
+	if (!valid) {
 		/* patch all comp IDs if at least one is invalid */
-		for (i = 0; i < sof->components_no; i++) {
+		for (i = 0; i < sof->components_no; i++)
 			dev_warn(dev, "Component %d ID patched to: %d",
 				 i, i + 1);
-			sof->comp[i].id = i + 1;
-			sos->comp[i].id = i + 1;
-		}
+		mxc_jpeg_patch_comp_id(sof, sos);
+	}
 
 	return valid;
 }
@@ -1900,6 +2059,39 @@ static void mxc_jpeg_sizeimage(struct mxc_jpeg_q_data *q)
 	}
 }
 
+/*
+ * MJPEG streams repeat the same header (tables, SOF, SOS) in every frame: if
+ * the start of the frame matches the last parsed header byte for byte, reuse
+ * what was derived from it instead of walking the markers again.
+ */
+static bool mxc_jpeg_parse_cached(struct mxc_jpeg_ctx *ctx,
+				  struct mxc_jpeg_src_buf *jpeg_src_buf,
+				  u8 *src_addr, u32 size)
+{
+	struct mxc_jpeg_hdr_cache *cache = &ctx->hdr_cache;
+	struct mxc_jpeg_q_data *q_data_out, *q_data_cap;
+
+	q_data_cap = mxc_jpeg_get_q_data(ctx, V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE);
+	if (!cache->len || size < cache->len || cache->cap_fmt != q_data_cap->fmt ||
+	    memcmp(src_addr, cache->data, cache->len))
+		return false;
+
+	if (cache->patch_comp_id)
+		mxc_jpeg_patch_comp_id((void *)src_addr + cache->sof_offset,
+				       (void *)src_addr + cache->sos_offset);
+
+	q_data_out = mxc_jpeg_get_q_data(ctx, V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE);
+	q_data_out->w = cache->w;
+	q_data_out->h = cache->h;
+
+	jpeg_src_buf->dht_needed = cache->dht_needed;
+	jpeg_src_buf->fmt = cache->fmt;
+	jpeg_src_buf->w = cache->w;
+	jpeg_src_buf->h = cache->h;
+
+	return true;
+}
+
 static int mxc_jpeg_parse(struct mxc_jpeg_ctx *ctx, struct vb2_buffer *vb)
 {
 	struct device *dev = ctx->mxc_jpeg->dev;
@@ -1912,8 +2104,12 @@ static int mxc_jpeg_parse(struct mxc_jpeg_ctx *ctx, struct vb2_buffer *vb)
 	struct mxc_jpeg_src_buf *jpeg_src_buf = vb2_to_mxc_buf(vb);
 	u8 *src_addr = (u8 *)mxc_jpeg_get_plane_vaddr(vb, 0);
 	u32 size = mxc_jpeg_get_plane_payload(vb, 0);
+	struct mxc_jpeg_hdr_cache *cache = &ctx->hdr_cache;
 	int ret;
 
+	if (mxc_jpeg_parse_cached(ctx, jpeg_src_buf, src_addr, size))
+		goto parsed;
+
 	memset(&header, 0, sizeof(header));
 	ret = v4l2_jpeg_parse_header((void *)src_addr, size, &header);
 	if (ret < 0) {
@@ -1921,6 +2117,11 @@ static int mxc_jpeg_parse(struct mxc_jpeg_ctx *ctx, struct vb2_buffer *vb)
 		return ret;
 	}
 
+	/* keep a copy of the header before the component IDs get patched */
+	cache->len = 0;
+	if (header.ecs_offset <= sizeof(cache->data))
+		memcpy(cache->data, src_addr, header.ecs_offset);
+
 	/* if DHT marker present, no need to inject default one */
 	jpeg_src_buf->dht_needed = (header.num_dht == 0);
 
@@ -1948,8 +2149,11 @@ static int mxc_jpeg_parse(struct mxc_jpeg_ctx *ctx, struct vb2_buffer *vb)
 	/* check and, if necessary, patch component IDs*/
 	psof = (struct mxc_jpeg_sof *)header.sof.start;
 	psos = (struct mxc_jpeg_sos *)header.sos.start;
-	if (!mxc_jpeg_valid_comp_id(dev, psof, psos))
+	cache->patch_comp_id = !mxc_jpeg_valid_comp_id(dev, psof, psos);
+	if (cache->patch_comp_id)
 		dev_warn(dev, "JPEG component ids should be 0-3 or 1-4");
+	cache->sof_offset = (u8 *)psof - src_addr;
+	cache->sos_offset = (u8 *)psos - src_addr;
 
 	q_data_cap = mxc_jpeg_get_q_data(ctx, V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE);
 	if (q_data_cap->fmt && mxc_jpeg_match_image_format(q_data_cap->fmt, &header))
@@ -1962,6 +2166,16 @@ static int mxc_jpeg_parse(struct mxc_jpeg_ctx *ctx, struct vb2_buffer *vb)
 	jpeg_src_buf->fmt = mxc_jpeg_find_format(fourcc);
 	jpeg_src_buf->w = header.frame.width;
 	jpeg_src_buf->h = header.frame.height;
+
+	cache->cap_fmt = q_data_cap->fmt;
+	cache->fmt = jpeg_src_buf->fmt;
+	cache->w = jpeg_src_buf->w;
+	cache->h = jpeg_src_buf->h;
+	cache->dht_needed = jpeg_src_buf->dht_needed;
+	if (header.ecs_offset <= sizeof(cache->data))
+		cache->len = header.ecs_offset;
+
+parsed:
 	ctx->header_parsed = true;
 
 	if (!v4l2_m2m_num_src_bufs_ready(ctx->fh.m2m_ctx))
@@ -2217,7 +2431,6 @@ static int mxc_jpeg_open(struct file *file)
 	}
 	ctx->fh.ctrl_handler = &ctx->ctrl_handler;
 	mxc_jpeg_set_default_params(ctx);
-	ctx->slot = -1; /* slot not allocated yet */
 	INIT_DELAYED_WORK(&ctx->task_timer, mxc_jpeg_device_run_timeout);
 
 	if (mxc_jpeg->mode == MXC_JPEG_DECODE)
@@ -2737,11 +2950,9 @@ static int mxc_jpeg_release(struct file *file)
 
 	mutex_lock(&mxc_jpeg->lock);
 	if (mxc_jpeg->mode == MXC_JPEG_DECODE)
-		dev_dbg(dev, "Release JPEG decoder instance on slot %d.",
-			ctx->slot);
+		dev_dbg(dev, "Release JPEG decoder instance %p.", ctx);
 	else
-		dev_dbg(dev, "Release JPEG encoder instance on slot %d.",
-			ctx->slot);
+		dev_dbg(dev, "Release JPEG encoder instance %p.", ctx);
 	v4l2_ctrl_handler_free(&ctx->ctrl_handler);
 	v4l2_m2m_ctx_release(ctx->fh.m2m_ctx);
 	v4l2_fh_del(&ctx->fh);
@@ -2838,7 +3049,8 @@ static int mxc_jpeg_probe(struct platform_device *pdev)
 {
 	struct mxc_jpeg_dev *jpeg;
 	struct device *dev = &pdev->dev;
-	int dec_irq;
+	unsigned int slot;
+	int dec_irq, nr_irqs;
 	int ret;
 	int mode;
 	const struct of_device_id *of_id;
@@ -2865,21 +3077,44 @@ static int mxc_jpeg_probe(struct platform_device *pdev)
 	if (IS_ERR(jpeg->base_reg))
 		return PTR_ERR(jpeg->base_reg);
 
-	ret = of_property_read_u32_index(pdev->dev.of_node, "slot", 0, &jpeg->slot_data.slot);
-	if (ret)
-		jpeg->slot_data.slot = 0;
-	dev_info(&pdev->dev, "choose slot %d\n", jpeg->slot_data.slot);
-	dec_irq = platform_get_irq(pdev, 0);
-	if (dec_irq < 0) {
-		ret = dec_irq;
+	nr_irqs = platform_irq_count(pdev);
+	if (nr_irqs < 0) {
+		ret = nr_irqs;
 		goto err_irq;
 	}
-	ret = devm_request_irq(&pdev->dev, dec_irq, mxc_jpeg_dec_irq,
-			       0, pdev->name, jpeg);
-	if (ret) {
-		dev_err(&pdev->dev, "Failed to request irq %d (%d)\n",
-			dec_irq, ret);
-		goto err_irq;
+	if (mode == MXC_JPEG_DECODE && nr_irqs > 1) {
+		/* one interrupt per slot, starting from slot 0 */
+		jpeg->slot_mask = GENMASK(min(nr_irqs, MXC_JPEG_MAX_SLOTS) - 1, 0);
+	} else {
+		ret = of_property_read_u32_index(pdev->dev.of_node, "slot", 0, &slot);
+		if (ret)
+			slot = 0;
+		if (slot >= MXC_JPEG_MAX_SLOTS) {
+			dev_err(&pdev->dev, "Invalid slot %u\n", slot);
+			return -EINVAL;
+		}
+		jpeg->slot_mask = BIT(slot);
+	}
+	dev_info(&pdev->dev, "choose slots 0x%lx\n", jpeg->slot_mask);
+
+	for_each_set_bit(slot, &jpeg->slot_mask, MXC_JPEG_MAX_SLOTS) {
+		struct mxc_jpeg_slot_data *slot_data = &jpeg->slot_data[slot];
+
+		slot_data->jpeg = jpeg;
+		slot_data->slot = slot;
+
+		dec_irq = platform_get_irq(pdev, nr_irqs > 1 ? slot : 0);
+		if (dec_irq < 0) {
+			ret = dec_irq;
+			goto err_irq;
+		}
+		ret = devm_request_irq(&pdev->dev, dec_irq, mxc_jpeg_dec_irq,
+				       0, pdev->name, slot_data);
+		if (ret) {
+			dev_err(&pdev->dev, "Failed to request irq %d (%d)\n",
+				dec_irq, ret);
+			goto err_irq;
+		}
 	}
 
 	jpeg->pdev = pdev;
@@ -2912,6 +3147,8 @@ static int mxc_jpeg_probe(struct platform_device *pdev)
 		ret = PTR_ERR(jpeg->m2m_dev);
 		goto err_m2m;
 	}
+	/* one job per slot, device_run() picks an idle one */
+	v4l2_m2m_set_max_jobs(jpeg->m2m_dev, hweight_long(jpeg->slot_mask));
 
 	jpeg->dec_vdev = video_device_alloc();
 	if (!jpeg->dec_vdev) {
@@ -3040,8 +3277,10 @@ static const struct dev_pm_ops	mxc_jpeg_pm_ops = {
 static void mxc_jpeg_remove(struct platform_device *pdev)
 {
 	struct mxc_jpeg_dev *jpeg = platform_get_drvdata(pdev);
+	unsigned int slot;
 
-	mxc_jpeg_free_slot_data(jpeg);
+	for_each_set_bit(slot, &jpeg->slot_mask, MXC_JPEG_MAX_SLOTS)
+		mxc_jpeg_free_slot_data(&jpeg->slot_data[slot]);
 
 	pm_runtime_disable(&pdev->dev);
 	video_unregister_device(jpeg->dec_vdev);
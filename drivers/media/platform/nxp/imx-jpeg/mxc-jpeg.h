@@ -30,6 +30,9 @@
 #define MXC_JPEG_MAX_PLANES		2
 #define MXC_JPEG_PATTERN_WIDTH		128
 #define MXC_JPEG_PATTERN_HEIGHT		64
+#define MXC_JPEG_MAX_SLOTS		4
+#define MXC_JPEG_MAX_CHAIN		4
+#define MXC_JPEG_HDR_CACHE_SIZE		2048
 
 enum mxc_jpeg_enc_state {
 	MXC_JPEG_ENCODING	= 0, /* jpeg encode phase */
@@ -94,6 +97,32 @@ struct mxc_jpeg_q_data {
 	struct v4l2_rect		crop;
 };
 
+/**
+ * struct mxc_jpeg_hdr_cache - result of the last parsed JPEG header
+ * @data:		the header as received, up to the entropy coded segment
+ * @len:		length of @data, 0 if nothing is cached
+ * @cap_fmt:		capture format the header was matched against
+ * @fmt:		format detected from the header
+ * @w:			image width
+ * @h:			image height
+ * @dht_needed:		the header has no DHT marker
+ * @patch_comp_id:	component IDs need patching
+ * @sof_offset:		offset of the SOF segment in @data
+ * @sos_offset:		offset of the SOS segment in @data
+ */
+struct mxc_jpeg_hdr_cache {
+	u8				data[MXC_JPEG_HDR_CACHE_SIZE];
+	u32				len;
+	const struct mxc_jpeg_fmt	*cap_fmt;
+	const struct mxc_jpeg_fmt	*fmt;
+	int				w;
+	int				h;
+	bool				dht_needed;
+	bool				patch_comp_id;
+	u32				sof_offset;
+	u32				sos_offset;
+};
+
 struct mxc_jpeg_ctx {
 	struct mxc_jpeg_dev		*mxc_jpeg;
 	struct mxc_jpeg_q_data		out_q;
@@ -107,12 +136,16 @@ struct mxc_jpeg_ctx {
 	struct v4l2_ctrl_handler	ctrl_handler;
 	u8				jpeg_quality;
 	struct delayed_work		task_timer;
+	struct mxc_jpeg_hdr_cache	hdr_cache;
 };
 
 struct mxc_jpeg_slot_data {
+	struct mxc_jpeg_dev *jpeg;
+	struct mxc_jpeg_ctx *ctx; // context whose job runs on this slot
 	int slot;
 	bool used;
-	struct mxc_jpeg_desc *desc; // enc/dec descriptor
+	unsigned int chain_len; // frames left in the running descriptor chain
+	struct mxc_jpeg_desc *desc; // enc/dec descriptors, one per chained frame
 	struct mxc_jpeg_desc *cfg_desc; // configuration descriptor
 	void *cfg_stream_vaddr; // configuration bitstream virtual address
 	unsigned int cfg_stream_size;
@@ -136,7 +169,8 @@ struct mxc_jpeg_dev {
 	struct v4l2_device		v4l2_dev;
 	struct v4l2_m2m_dev		*m2m_dev;
 	struct video_device		*dec_vdev;
-	struct mxc_jpeg_slot_data	slot_data;
+	struct mxc_jpeg_slot_data	slot_data[MXC_JPEG_MAX_SLOTS];
+	unsigned long			slot_mask; /* slots in use by the driver */
 	int				num_domains;
 	struct device			**pd_dev;
 	struct device_link		**pd_link;
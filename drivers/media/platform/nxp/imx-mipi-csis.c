@@ -108,6 +108,12 @@
 #define MIPI_CSIS_INT_SRC_ERR_CRC		BIT(1)
 #define MIPI_CSIS_INT_SRC_ERR_UNKNOWN		BIT(0)
 #define MIPI_CSIS_INT_SRC_ERRORS		0xfffff
+/* Per channel bits, the ones above are for channel 0 */
+#define MIPI_CSIS_INT_SRC_FRAME_START_CH(n)	BIT(24 + (n))
+#define MIPI_CSIS_INT_SRC_FRAME_END_CH(n)	BIT(20 + (n))
+#define MIPI_CSIS_INT_SRC_ERR_LOST_FS_CH(n)	BIT(12 + (n))
+#define MIPI_CSIS_INT_SRC_ERR_LOST_FE_CH(n)	BIT(8 + (n))
+#define MIPI_CSIS_INT_SRC_ERR_OVER_CH(n)	BIT(4 + (n))
 
 /* D-PHY status control */
 #define MIPI_CSIS_DPHY_STATUS			0x20
@@ -285,6 +291,31 @@ static const struct mipi_csis_event mipi_csis_events[] = {
 
 #define MIPI_CSIS_NUM_EVENTS ARRAY_SIZE(mipi_csis_events)
 
+#define MIPI_CSIS_MAX_CHANNELS			4
+#define MIPI_CSIS_EVENT_RING_SIZE		256
+
+/*
+ * Per channel (virtual channel) statistics. Only the interrupt handler
+ * writes them, readers take a snapshot without locking and may see the
+ * fields of different frames, which is fine for monitoring.
+ */
+struct mipi_csis_vc_stats {
+	u32 frame_start;
+	u32 frame_end;
+	u32 lost_fs;
+	u32 lost_fe;
+	u32 overflow;
+	u64 last_fs_ns;
+	u32 interval_ns;	/* running average of the frame interval */
+};
+
+/* Interrupt status captured by the interrupt handler when errors occur */
+struct mipi_csis_ring_entry {
+	u64 ts_ns;
+	u32 status;
+	u32 dbg_status;
+};
+
 enum mipi_csis_clk {
 	MIPI_CSIS_CLK_PCLK,
 	MIPI_CSIS_CLK_WRAP,
@@ -333,9 +364,13 @@ struct mipi_csis_device {
 
 	spinlock_t slock;	/* Protect events */
 	struct mipi_csis_event events[MIPI_CSIS_NUM_EVENTS];
+	struct mipi_csis_vc_stats vc_stats[MIPI_CSIS_MAX_CHANNELS];
+	struct mipi_csis_ring_entry *ring;
+	unsigned int ring_head;	/* written by the interrupt handler only */
 	struct dentry *debugfs_root;
 	struct {
 		bool enable;
+		bool event_ring;
 		u32 hs_settle;
 		u32 clk_settle;
 	} debug;
@@ -763,6 +798,53 @@ static void mipi_csis_queue_event_sof(struct mipi_csis_device *csis)
 	v4l2_event_queue(csis->sd.devnode, &event);
 }
 
+static void mipi_csis_update_vc_stats(struct mipi_csis_device *csis,
+				      u32 status, u64 now)
+{
+	unsigned int ch;
+
+	for (ch = 0; ch < MIPI_CSIS_MAX_CHANNELS; ch++) {
+		struct mipi_csis_vc_stats *stats = &csis->vc_stats[ch];
+
+		if (status & MIPI_CSIS_INT_SRC_FRAME_START_CH(ch)) {
+			if (stats->last_fs_ns) {
+				s64 delta = now - stats->last_fs_ns;
+
+				/* exponential average with a weight of 1/8 */
+				if (stats->interval_ns)
+					delta = stats->interval_ns +
+						((delta - (s64)stats->interval_ns) >> 3);
+				WRITE_ONCE(stats->interval_ns, delta);
+			}
+			WRITE_ONCE(stats->last_fs_ns, now);
+			WRITE_ONCE(stats->frame_start, stats->frame_start + 1);
+		}
+		if (status & MIPI_CSIS_INT_SRC_FRAME_END_CH(ch))
+			WRITE_ONCE(stats->frame_end, stats->frame_end + 1);
+		if (status & MIPI_CSIS_INT_SRC_ERR_LOST_FS_CH(ch))
+			WRITE_ONCE(stats->lost_fs, stats->lost_fs + 1);
+		if (status & MIPI_CSIS_INT_SRC_ERR_LOST_FE_CH(ch))
+			WRITE_ONCE(stats->lost_fe, stats->lost_fe + 1);
+		if (status & MIPI_CSIS_INT_SRC_ERR_OVER_CH(ch))
+			WRITE_ONCE(stats->overflow, stats->overflow + 1);
+	}
+}
+
+static void mipi_csis_ring_record(struct mipi_csis_device *csis, u32 status,
+				  u32 dbg_status, u64 now)
+{
+	unsigned int head = csis->ring_head;
+	struct mipi_csis_ring_entry *entry;
+
+	entry = &csis->ring[head % MIPI_CSIS_EVENT_RING_SIZE];
+	entry->ts_ns = now;
+	entry->status = status;
+	entry->dbg_status = dbg_status;
+
+	/* publish the entry before the new head */
+	smp_store_release(&csis->ring_head, head + 1);
+}
+
 static irqreturn_t mipi_csis_irq_handler(int irq, void *dev_id)
 {
 	struct mipi_csis_device *csis = dev_id;
@@ -770,9 +852,16 @@ static irqreturn_t mipi_csis_irq_handler(int irq, void *dev_id)
 	unsigned int i;
 	u32 status;
 	u32 dbg_status;
+	u64 now;
 
 	status = mipi_csis_read(csis, MIPI_CSIS_INT_SRC);
 	dbg_status = mipi_csis_read(csis, MIPI_CSIS_DBG_INTR_SRC);
+	now = ktime_get_ns();
+
+	mipi_csis_update_vc_stats(csis, status, now);
+	if (csis->ring && READ_ONCE(csis->debug.event_ring) &&
+	    (status & MIPI_CSIS_INT_SRC_ERRORS))
+		mipi_csis_ring_record(csis, status, dbg_status, now);
 
 	spin_lock_irqsave(&csis->slock, flags);
 
@@ -859,6 +948,9 @@ static void mipi_csis_clear_counters(struct mipi_csis_device *csis)
 	for (i = 0; i < MIPI_CSIS_NUM_EVENTS; i++)
 		csis->events[i].counter = 0;
 	spin_unlock_irqrestore(&csis->slock, flags);
+
+	/* interrupts are disabled while not streaming */
+	memset(csis->vc_stats, 0, sizeof(csis->vc_stats));
 }
 
 static void mipi_csis_log_counters(struct mipi_csis_device *csis, bool non_errors)
@@ -929,6 +1021,56 @@ static int mipi_csis_dump_regs_show(struct seq_file *m, void *private)
 }
 DEFINE_SHOW_ATTRIBUTE(mipi_csis_dump_regs);
 
+static int mipi_csis_vc_stats_show(struct seq_file *m, void *private)
+{
+	struct mipi_csis_device *csis = m->private;
+	unsigned int ch;
+
+	seq_puts(m, "vc  frame_start  frame_end  lost_fs  lost_fe  overflow  interval_us\n");
+
+	for (ch = 0; ch < MIPI_CSIS_MAX_CHANNELS; ch++) {
+		const struct mipi_csis_vc_stats *stats = &csis->vc_stats[ch];
+
+		seq_printf(m, "%2u  %11u  %9u  %7u  %7u  %8u  %11u\n", ch,
+			   READ_ONCE(stats->frame_start),
+			   READ_ONCE(stats->frame_end),
+			   READ_ONCE(stats->lost_fs),
+			   READ_ONCE(stats->lost_fe),
+			   READ_ONCE(stats->overflow),
+			   READ_ONCE(stats->interval_ns) / NSEC_PER_USEC);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(mipi_csis_vc_stats);
+
+/*
+ * Entries may be overwritten by the interrupt handler while they are
+ * printed, the dump is a best effort view of the latest errors.
+ */
+static int mipi_csis_event_ring_show(struct seq_file *m, void *private)
+{
+	struct mipi_csis_device *csis = m->private;
+	unsigned int head, i;
+
+	head = smp_load_acquire(&csis->ring_head);
+	i = head > MIPI_CSIS_EVENT_RING_SIZE ?
+	    head - MIPI_CSIS_EVENT_RING_SIZE : 0;
+
+	for (; i != head; i++) {
+		const struct mipi_csis_ring_entry *entry =
+			&csis->ring[i % MIPI_CSIS_EVENT_RING_SIZE];
+
+		seq_printf(m, "%llu.%06llu: status 0x%08x dbg 0x%08x\n",
+			   div_u64(entry->ts_ns, NSEC_PER_SEC),
+			   div_u64(entry->ts_ns % NSEC_PER_SEC, NSEC_PER_USEC),
+			   entry->status, entry->dbg_status);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(mipi_csis_event_ring);
+
 static void mipi_csis_debugfs_init(struct mipi_csis_device *csis)
 {
 	csis->debug.hs_settle = UINT_MAX;
@@ -944,6 +1086,18 @@ static void mipi_csis_debugfs_init(struct mipi_csis_device *csis)
 			   &csis->debug.clk_settle);
 	debugfs_create_u32("ths_settle", 0600, csis->debugfs_root,
 			   &csis->debug.hs_settle);
+	debugfs_create_file("vc_stats", 0400, csis->debugfs_root, csis,
+			    &mipi_csis_vc_stats_fops);
+
+	csis->ring = devm_kcalloc(csis->dev, MIPI_CSIS_EVENT_RING_SIZE,
+				  sizeof(*csis->ring), GFP_KERNEL);
+	if (!csis->ring)
+		return;
+
+	debugfs_create_bool("event_ring_enable", 0600, csis->debugfs_root,
+			    &csis->debug.event_ring);
+	debugfs_create_file("event_ring", 0400, csis->debugfs_root, csis,
+			    &mipi_csis_event_ring_fops);
 }
 
 static void mipi_csis_debugfs_exit(struct mipi_csis_device *csis)
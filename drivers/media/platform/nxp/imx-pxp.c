@@ -55,6 +55,9 @@ MODULE_PARM_DESC(debug, "activates debug info");
 #define MEM2MEM_HFLIP	(1 << 0)
 #define MEM2MEM_VFLIP	(1 << 1)
 
+/* Maximum number of jobs run back to back from the interrupt handler */
+#define PXP_MAX_BATCH	8
+
 #define PXP_VERSION_MAJOR(version) \
 	FIELD_GET(BM_PXP_VERSION_MAJOR, version)
 #define PXP_VERSION_MINOR(version) \
@@ -79,8 +82,8 @@ static struct pxp_fmt formats[] = {
 	}, {
 		.fourcc	= V4L2_PIX_FMT_ABGR32,
 		.depth	= 32,
-		/* Capture-only format */
-		.types	= MEM2MEM_CAPTURE,
+		/* Alpha is only used by the alpha surface when blending */
+		.types	= MEM2MEM_CAPTURE | MEM2MEM_OUTPUT,
 	}, {
 		.fourcc	= V4L2_PIX_FMT_BGR24,
 		.depth	= 24,
@@ -222,6 +225,9 @@ struct pxp_dev {
 	struct mutex		dev_mutex;
 	spinlock_t		irqlock;
 
+	/* Number of jobs run in the current transaction */
+	unsigned int		batched;
+
 	struct v4l2_m2m_dev	*m2m_dev;
 };
 
@@ -239,6 +245,10 @@ struct pxp_ctx {
 	u8			alpha_component;
 	u8			rotation;
 
+	/* Blend the source over the destination in the compose rectangle */
+	bool			blend;
+	struct v4l2_rect	compose;
+
 	enum v4l2_colorspace	colorspace;
 	enum v4l2_xfer_func	xfer_func;
 
@@ -277,6 +287,7 @@ static inline void pxp_write(struct pxp_dev *dev, u32 reg, u32 value)
 static u32 pxp_v4l2_pix_fmt_to_ps_format(u32 v4l2_pix_fmt)
 {
 	switch (v4l2_pix_fmt) {
+	case V4L2_PIX_FMT_ABGR32:
 	case V4L2_PIX_FMT_XBGR32:  return BV_PXP_PS_CTRL_FORMAT__RGB888;
 	case V4L2_PIX_FMT_RGB555:  return BV_PXP_PS_CTRL_FORMAT__RGB555;
 	case V4L2_PIX_FMT_RGB444:  return BV_PXP_PS_CTRL_FORMAT__RGB444;
@@ -300,6 +311,18 @@ static u32 pxp_v4l2_pix_fmt_to_ps_format(u32 v4l2_pix_fmt)
 	}
 }
 
+static int pxp_v4l2_pix_fmt_to_as_format(u32 v4l2_pix_fmt)
+{
+	switch (v4l2_pix_fmt) {
+	case V4L2_PIX_FMT_ABGR32:  return BV_PXP_AS_CTRL_FORMAT__ARGB8888;
+	case V4L2_PIX_FMT_XBGR32:  return BV_PXP_AS_CTRL_FORMAT__RGB888;
+	case V4L2_PIX_FMT_RGB555:  return BV_PXP_AS_CTRL_FORMAT__RGB555;
+	case V4L2_PIX_FMT_RGB444:  return BV_PXP_AS_CTRL_FORMAT__RGB444;
+	case V4L2_PIX_FMT_RGB565:  return BV_PXP_AS_CTRL_FORMAT__RGB565;
+	default:		   return -EINVAL;
+	}
+}
+
 static u32 pxp_v4l2_pix_fmt_to_out_format(u32 v4l2_pix_fmt)
 {
 	switch (v4l2_pix_fmt) {
@@ -835,6 +858,106 @@ static void pxp_set_data_path(struct pxp_ctx *ctx)
 	pxp_write(dev, HW_PXP_DATA_PATH_CTRL1, ctrl1);
 }
 
+static void pxp_enable(struct pxp_ctx *ctx)
+{
+	struct pxp_dev *dev = ctx->dev;
+
+	/* setup CSC */
+	pxp_setup_csc(ctx);
+
+	/* bypass LUT */
+	pxp_write(dev, HW_PXP_LUT_CTRL, BM_PXP_LUT_CTRL_BYPASS);
+
+	pxp_set_data_path(ctx);
+
+	pxp_write(dev, HW_PXP_IRQ_MASK, 0xffff);
+
+	/* ungate, enable PS/AS/OUT and PXP operation */
+	pxp_write(dev, HW_PXP_CTRL_SET, BM_PXP_CTRL_IRQ_ENABLE);
+	pxp_write(dev, HW_PXP_CTRL_SET,
+		  BM_PXP_CTRL_ENABLE | BM_PXP_CTRL_ENABLE_CSC2 |
+		  BM_PXP_CTRL_ENABLE_ROTATE0 | BM_PXP_CTRL_ENABLE_PS_AS_OUT);
+}
+
+/*
+ * Blend the source frame, fed to the alpha surface, over the destination
+ * frame in the compose rectangle. The processed surface reads the current
+ * contents of the destination buffer as the background, unscaled, and the
+ * output writes back to the same buffer. The PXP reads each 8x8 block before
+ * writing it, so this is safe as long as the output isn't flipped or rotated,
+ * which is why flip and rotation are ignored in this mode.
+ *
+ * The alpha surface can't scale, the compose rectangle size always matches
+ * the source size. Sources with per-pixel alpha are blended with their
+ * embedded alpha, other sources are copied opaque.
+ */
+static int pxp_start_blend(struct pxp_ctx *ctx, dma_addr_t p_in,
+			   dma_addr_t p_out)
+{
+	struct pxp_dev *dev = ctx->dev;
+	struct pxp_q_data *src = &ctx->q_data[V4L2_M2M_SRC];
+	struct pxp_q_data *dst = &ctx->q_data[V4L2_M2M_DST];
+	const struct v4l2_rect *r = &ctx->compose;
+	u32 as_ctrl;
+
+	as_ctrl = BF_PXP_AS_CTRL_FORMAT(pxp_v4l2_pix_fmt_to_as_format(src->fmt->fourcc));
+	if (src->fmt->fourcc == V4L2_PIX_FMT_ABGR32)
+		as_ctrl |= BF_PXP_AS_CTRL_ALPHA_CTRL(BV_PXP_AS_CTRL_ALPHA_CTRL__Embedded);
+	else
+		as_ctrl |= BF_PXP_AS_CTRL_ALPHA_CTRL(BV_PXP_AS_CTRL_ALPHA_CTRL__Override) |
+			   BF_PXP_AS_CTRL_ALPHA(0xff);
+
+	pxp_write(dev, HW_PXP_CTRL, BF_PXP_CTRL_ROTATE0(BV_PXP_CTRL_ROTATE0__ROT_0));
+	pxp_write(dev, HW_PXP_OUT_CTRL,
+		  BF_PXP_OUT_CTRL_ALPHA(ctx->alpha_component) |
+		  BF_PXP_OUT_CTRL_ALPHA_OUTPUT(1) |
+		  pxp_v4l2_pix_fmt_to_out_format(dst->fmt->fourcc));
+	pxp_write(dev, HW_PXP_OUT_BUF, p_out);
+	pxp_write(dev, HW_PXP_OUT_BUF2, 0);
+	pxp_write(dev, HW_PXP_OUT_PITCH, BF_PXP_OUT_PITCH_PITCH(dst->bytesperline));
+	pxp_write(dev, HW_PXP_OUT_LRC,
+		  BF_PXP_OUT_LRC_X(dst->width - 1) |
+		  BF_PXP_OUT_LRC_Y(dst->height - 1));
+
+	/* PS: the destination itself, covering the whole output */
+	pxp_write(dev, HW_PXP_OUT_PS_ULC,
+		  BF_PXP_OUT_PS_ULC_X(0) | BF_PXP_OUT_PS_ULC_Y(0));
+	pxp_write(dev, HW_PXP_OUT_PS_LRC,
+		  BF_PXP_OUT_PS_LRC_X(dst->width - 1) |
+		  BF_PXP_OUT_PS_LRC_Y(dst->height - 1));
+	pxp_write(dev, HW_PXP_PS_CTRL,
+		  pxp_v4l2_pix_fmt_to_ps_format(dst->fmt->fourcc));
+	pxp_write(dev, HW_PXP_PS_BUF, p_out);
+	pxp_write(dev, HW_PXP_PS_UBUF, 0);
+	pxp_write(dev, HW_PXP_PS_VBUF, 0);
+	pxp_write(dev, HW_PXP_PS_PITCH, BF_PXP_PS_PITCH_PITCH(dst->bytesperline));
+	pxp_write(dev, HW_PXP_PS_BACKGROUND_0, 0x00ffffff);
+	pxp_write(dev, HW_PXP_PS_SCALE,
+		  BF_PXP_PS_SCALE_YSCALE(0x1000) | BF_PXP_PS_SCALE_XSCALE(0x1000));
+	pxp_write(dev, HW_PXP_PS_OFFSET,
+		  BF_PXP_PS_OFFSET_YOFFSET(0) | BF_PXP_PS_OFFSET_XOFFSET(0));
+
+	/* AS: the source, in the compose rectangle */
+	pxp_write(dev, HW_PXP_OUT_AS_ULC,
+		  BF_PXP_OUT_AS_ULC_X(r->left) | BF_PXP_OUT_AS_ULC_Y(r->top));
+	pxp_write(dev, HW_PXP_OUT_AS_LRC,
+		  BF_PXP_OUT_AS_LRC_X(r->left + r->width - 1) |
+		  BF_PXP_OUT_AS_LRC_Y(r->top + r->height - 1));
+	pxp_write(dev, HW_PXP_AS_CTRL, as_ctrl);
+	pxp_write(dev, HW_PXP_AS_BUF, p_in);
+	pxp_write(dev, HW_PXP_AS_PITCH, BF_PXP_AS_PITCH_PITCH(src->bytesperline));
+
+	/* disable processed and alpha surface color keying */
+	pxp_write(dev, HW_PXP_PS_CLRKEYLOW_0, 0x00ffffff);
+	pxp_write(dev, HW_PXP_PS_CLRKEYHIGH_0, 0x00000000);
+	pxp_write(dev, HW_PXP_AS_CLRKEYLOW_0, 0x00ffffff);
+	pxp_write(dev, HW_PXP_AS_CLRKEYHIGH_0, 0x00000000);
+
+	pxp_enable(ctx);
+
+	return 0;
+}
+
 static int pxp_start(struct pxp_ctx *ctx, struct vb2_v4l2_buffer *in_vb,
 		     struct vb2_v4l2_buffer *out_vb)
 {
@@ -846,7 +969,7 @@ static int pxp_start(struct pxp_ctx *ctx, struct vb2_v4l2_buffer *in_vb,
 	u32 ctrl, out_ctrl, out_buf, out_buf2, out_pitch, out_lrc, out_ps_ulc;
 	u32 out_ps_lrc;
 	u32 ps_ctrl, ps_buf, ps_ubuf, ps_vbuf, ps_pitch, ps_scale, ps_offset;
-	u32 as_ulc, as_lrc;
+	u32 as_ulc, as_lrc, as_ctrl;
 	u32 y_size;
 	u32 decx, decy, xscale, yscale;
 
@@ -885,6 +1008,9 @@ static int pxp_start(struct pxp_ctx *ctx, struct vb2_v4l2_buffer *in_vb,
 		 V4L2_BUF_FLAG_BFRAME |
 		 V4L2_BUF_FLAG_TSTAMP_SRC_MASK);
 
+	if (ctx->blend)
+		return pxp_start_blend(ctx, p_in, p_out);
+
 	/* 8x8 block size */
 	ctrl = BF_PXP_CTRL_VFLIP0(!!(ctx->mode & MEM2MEM_VFLIP)) |
 	       BF_PXP_CTRL_HFLIP0(!!(ctx->mode & MEM2MEM_HFLIP)) |
@@ -987,6 +1113,7 @@ static int pxp_start(struct pxp_ctx *ctx, struct vb2_v4l2_buffer *in_vb,
 	ps_scale = BF_PXP_PS_SCALE_YSCALE(yscale) |
 		   BF_PXP_PS_SCALE_XSCALE(xscale);
 	ps_offset = BF_PXP_PS_OFFSET_YOFFSET(0) | BF_PXP_PS_OFFSET_XOFFSET(0);
+	as_ctrl = 0;
 
 	pxp_write(dev, HW_PXP_CTRL, ctrl);
 	/* skip STAT */
@@ -999,6 +1126,7 @@ static int pxp_start(struct pxp_ctx *ctx, struct vb2_v4l2_buffer *in_vb,
 	pxp_write(dev, HW_PXP_OUT_PS_LRC, out_ps_lrc);
 	pxp_write(dev, HW_PXP_OUT_AS_ULC, as_ulc);
 	pxp_write(dev, HW_PXP_OUT_AS_LRC, as_lrc);
+	pxp_write(dev, HW_PXP_AS_CTRL, as_ctrl);
 	pxp_write(dev, HW_PXP_PS_CTRL, ps_ctrl);
 	pxp_write(dev, HW_PXP_PS_BUF, ps_buf);
 	pxp_write(dev, HW_PXP_PS_UBUF, ps_ubuf);
@@ -1015,25 +1143,13 @@ static int pxp_start(struct pxp_ctx *ctx, struct vb2_v4l2_buffer *in_vb,
 	pxp_write(dev, HW_PXP_AS_CLRKEYLOW_0, 0x00ffffff);
 	pxp_write(dev, HW_PXP_AS_CLRKEYHIGH_0, 0x00000000);
 
-	/* setup CSC */
-	pxp_setup_csc(ctx);
-
-	/* bypass LUT */
-	pxp_write(dev, HW_PXP_LUT_CTRL, BM_PXP_LUT_CTRL_BYPASS);
-
-	pxp_set_data_path(ctx);
-
-	pxp_write(dev, HW_PXP_IRQ_MASK, 0xffff);
-
-	/* ungate, enable PS/AS/OUT and PXP operation */
-	pxp_write(dev, HW_PXP_CTRL_SET, BM_PXP_CTRL_IRQ_ENABLE);
-	pxp_write(dev, HW_PXP_CTRL_SET,
-		  BM_PXP_CTRL_ENABLE | BM_PXP_CTRL_ENABLE_CSC2 |
-		  BM_PXP_CTRL_ENABLE_ROTATE0 | BM_PXP_CTRL_ENABLE_PS_AS_OUT);
+	pxp_enable(ctx);
 
 	return 0;
 }
 
+static int pxp_job_ready(void *priv);
+
 static void pxp_job_finish(struct pxp_dev *dev)
 {
 	struct pxp_ctx *curr_ctx;
@@ -1055,6 +1171,19 @@ static void pxp_job_finish(struct pxp_dev *dev)
 	v4l2_m2m_buf_done(dst_vb, VB2_BUF_STATE_DONE);
 	spin_unlock_irqrestore(&dev->irqlock, flags);
 
+	/*
+	 * Start the next queued pair of the same context right away instead
+	 * of going through the M2M core scheduler for every job.
+	 */
+	if (!curr_ctx->aborting && ++dev->batched < PXP_MAX_BATCH &&
+	    pxp_job_ready(curr_ctx)) {
+		src_vb = v4l2_m2m_next_src_buf(curr_ctx->fh.m2m_ctx);
+		dst_vb = v4l2_m2m_next_dst_buf(curr_ctx->fh.m2m_ctx);
+
+		if (!pxp_start(curr_ctx, src_vb, dst_vb))
+			return;
+	}
+
 	dprintk(curr_ctx->dev, "Finishing transaction\n");
 	v4l2_m2m_job_finish(dev->m2m_dev, curr_ctx->fh.m2m_ctx);
 }
@@ -1070,6 +1199,9 @@ static void pxp_device_run(void *priv)
 	src_buf = v4l2_m2m_next_src_buf(ctx->fh.m2m_ctx);
 	dst_buf = v4l2_m2m_next_dst_buf(ctx->fh.m2m_ctx);
 
+	ctx->aborting = 0;
+	ctx->dev->batched = 0;
+
 	pxp_start(ctx, src_buf, dst_buf);
 }
 
@@ -1347,6 +1479,8 @@ static int pxp_s_fmt(struct pxp_ctx *ctx, struct v4l2_format *f)
 	q_data->bytesperline	= f->fmt.pix.bytesperline;
 	q_data->sizeimage	= f->fmt.pix.sizeimage;
 
+	ctx->blend = false;
+
 	dprintk(ctx->dev,
 		"Setting format for type %d, wxh: %dx%d, fmt: %d\n",
 		f->type, q_data->width, q_data->height, q_data->fmt->fourcc);
@@ -1420,6 +1554,71 @@ static int pxp_enum_framesizes(struct file *file, void *fh,
 	return 0;
 }
 
+static int pxp_g_selection(struct file *file, void *priv,
+			   struct v4l2_selection *s)
+{
+	struct pxp_ctx *ctx = file2ctx(file);
+	struct pxp_q_data *dst = &ctx->q_data[V4L2_M2M_DST];
+
+	if (s->type != V4L2_BUF_TYPE_VIDEO_CAPTURE)
+		return -EINVAL;
+
+	switch (s->target) {
+	case V4L2_SEL_TGT_COMPOSE:
+		if (ctx->blend) {
+			s->r = ctx->compose;
+			return 0;
+		}
+		fallthrough;
+	case V4L2_SEL_TGT_COMPOSE_DEFAULT:
+	case V4L2_SEL_TGT_COMPOSE_BOUNDS:
+		s->r.left = 0;
+		s->r.top = 0;
+		s->r.width = dst->width;
+		s->r.height = dst->height;
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+/*
+ * Setting the compose rectangle on the capture queue switches the context to
+ * blending the source over the destination contents, see pxp_start_blend().
+ * Setting a format on either queue switches back to the default scaling mode.
+ */
+static int pxp_s_selection(struct file *file, void *priv,
+			   struct v4l2_selection *s)
+{
+	struct pxp_ctx *ctx = file2ctx(file);
+	struct pxp_q_data *src = &ctx->q_data[V4L2_M2M_SRC];
+	struct pxp_q_data *dst = &ctx->q_data[V4L2_M2M_DST];
+
+	if (s->type != V4L2_BUF_TYPE_VIDEO_CAPTURE ||
+	    s->target != V4L2_SEL_TGT_COMPOSE)
+		return -EINVAL;
+
+	if (pxp_v4l2_pix_fmt_to_as_format(src->fmt->fourcc) < 0 ||
+	    pxp_v4l2_pix_fmt_to_as_format(dst->fmt->fourcc) < 0) {
+		dprintk(ctx->dev, "blending requires RGB formats\n");
+		return -EINVAL;
+	}
+
+	if (src->width > dst->width || src->height > dst->height)
+		return -EINVAL;
+
+	/* The alpha surface can't be scaled. */
+	s->r.width = src->width;
+	s->r.height = src->height;
+	s->r.left = clamp_t(s32, s->r.left, 0, dst->width - src->width);
+	s->r.top = clamp_t(s32, s->r.top, 0, dst->height - src->height);
+
+	ctx->compose = s->r;
+	ctx->blend = true;
+
+	return 0;
+}
+
 static u8 pxp_degrees_to_rot_mode(u32 degrees)
 {
 	switch (degrees) {
@@ -1490,6 +1689,9 @@ static const struct v4l2_ioctl_ops pxp_ioctl_ops = {
 
 	.vidioc_enum_framesizes	= pxp_enum_framesizes,
 
+	.vidioc_g_selection	= pxp_g_selection,
+	.vidioc_s_selection	= pxp_s_selection,
+
 	.vidioc_reqbufs		= v4l2_m2m_ioctl_reqbufs,
 	.vidioc_querybuf	= v4l2_m2m_ioctl_querybuf,
 	.vidioc_qbuf		= v4l2_m2m_ioctl_qbuf,
@@ -1639,6 +1841,8 @@ static int queue_init(void *priv, struct vb2_queue *src_vq,
 	dst_vq->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_COPY;
 	dst_vq->lock = &ctx->dev->dev_mutex;
 	dst_vq->dev = ctx->dev->v4l2_dev.dev;
+	/* The destination is read back as the background when blending. */
+	dst_vq->bidirectional = 1;
 
 	return vb2_queue_init(dst_vq);
 }
@@ -15,6 +15,7 @@
 #include <linux/spinlock.h>
 #include <linux/types.h>
 #include <linux/videodev2.h>
+#include <linux/workqueue.h>
 
 #include <media/media-device.h>
 #include <media/media-entity.h>
@@ -43,6 +44,7 @@ struct v4l2_m2m_dev;
 #define MXC_ISI_MAX_WIDTH_UNCHAINED	2048U
 #define MXC_ISI_MAX_WIDTH_CHAINED	4096U
 #define MXC_ISI_MAX_HEIGHT		8191U
+#define MXC_ISI_M2M_MAX_WIDTH		8192U
 
 #define MXC_ISI_DEF_WIDTH		1920U
 #define MXC_ISI_DEF_HEIGHT		1080U
@@ -232,7 +234,20 @@ struct mxc_isi_video {
 	struct list_head		out_active;
 	struct list_head		out_discard;
 	u32				frame_count;
-	/* Protects out_pending, out_active, out_discard and frame_count */
+
+	/* Capture statistics, reset at stream start */
+	struct {
+		u64			completed;
+		u32			discarded;
+		u32			late_queued;
+		u32			missed_irqs;
+		u32			races;
+	} stats;
+
+	/*
+	 * Protects out_pending, out_active, out_discard, frame_count and
+	 * stats
+	 */
 	spinlock_t			buf_lock;
 
 	struct mxc_isi_dma_buffer	discard_buffer[MXC_MAX_PLANES];
@@ -287,6 +302,11 @@ struct mxc_isi_m2m {
 	struct mxc_isi_m2m_ctx		*last_ctx;
 	int				usage_count;
 	int				chained_count;
+
+	/* Tile and job counters of the current run, used in run_work */
+	struct work_struct		run_work;
+	unsigned int			tile;
+	unsigned int			batched;
 };
 
 struct mxc_isi_dev {
@@ -108,8 +108,13 @@ static int __mxc_isi_crossbar_set_routing(struct v4l2_subdev *sd,
 	if (ret)
 		return ret;
 
-	/* The memory input can be routed to the first pipeline only. */
-	for_each_active_route(&state->routing, route) {
+	/*
+	 * A sink can be routed to multiple sources, in which case the input
+	 * stream is duplicated to all the corresponding pipelines, each with
+	 * its own scaler and CSC configuration. The memory input can however
+	 * be routed to the first pipeline only.
+	 */
+	for_each_active_route(routing, route) {
 		if (route->sink_pad == xbar->num_sinks - 1 &&
 		    route->source_pad != xbar->num_sinks) {
 			dev_dbg(xbar->isi->dev,
@@ -108,6 +108,33 @@ static int mxc_isi_debug_dump_regs_show(struct seq_file *m, void *p)
 }
 DEFINE_SHOW_ATTRIBUTE(mxc_isi_debug_dump_regs);
 
+static int mxc_isi_debug_stats_show(struct seq_file *m, void *p)
+{
+	struct mxc_isi_pipe *pipe = m->private;
+	struct mxc_isi_video *video = &pipe->video;
+	u64 completed;
+	u32 frames, discarded, late_queued, missed_irqs, races;
+
+	spin_lock_irq(&video->buf_lock);
+	frames = video->frame_count;
+	completed = video->stats.completed;
+	discarded = video->stats.discarded;
+	late_queued = video->stats.late_queued;
+	missed_irqs = video->stats.missed_irqs;
+	races = video->stats.races;
+	spin_unlock_irq(&video->buf_lock);
+
+	seq_printf(m, "frames:      %u\n", frames);
+	seq_printf(m, "completed:   %llu\n", completed);
+	seq_printf(m, "discarded:   %u\n", discarded);
+	seq_printf(m, "late queued: %u\n", late_queued);
+	seq_printf(m, "missed irqs: %u\n", missed_irqs);
+	seq_printf(m, "races:       %u\n", races);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(mxc_isi_debug_stats);
+
 void mxc_isi_debug_init(struct mxc_isi_dev *isi)
 {
 	unsigned int i;
@@ -116,11 +143,15 @@ void mxc_isi_debug_init(struct mxc_isi_dev *isi)
 
 	for (i = 0; i < isi->pdata->num_channels; ++i) {
 		struct mxc_isi_pipe *pipe = &isi->pipes[i];
-		char name[8];
+		char name[16];
 
 		sprintf(name, "pipe%u", pipe->id);
 		debugfs_create_file(name, 0444, isi->debugfs_root, pipe,
 				    &mxc_isi_debug_dump_regs_fops);
+
+		sprintf(name, "pipe%u_stats", pipe->id);
+		debugfs_create_file(name, 0444, isi->debugfs_root, pipe,
+				    &mxc_isi_debug_stats_fops);
 	}
 }
 
@@ -21,6 +21,7 @@
 #include <linux/string.h>
 #include <linux/types.h>
 #include <linux/videodev2.h>
+#include <linux/workqueue.h>
 
 #include <media/media-entity.h>
 #include <media/v4l2-ctrls.h>
@@ -34,6 +35,30 @@
 
 #include "imx8-isi-core.h"
 
+/*
+ * Images wider than the channel line buffer are processed in vertical tiles,
+ * one frame through the channel per tile. When scaling, tiles overlap on the
+ * input side by MXC_ISI_M2M_TILE_OVERLAP pixels to give the scaler filter
+ * the same context on both sides of the seam, and the overlap is cropped from
+ * the output.
+ */
+#define MXC_ISI_M2M_TILE_ALIGN		16U
+#define MXC_ISI_M2M_TILE_OVERLAP	16U
+
+/*
+ * Maximum number of jobs of the same context processed back to back before
+ * returning to the M2M core scheduler.
+ */
+#define MXC_ISI_M2M_MAX_BATCH		4U
+
+struct mxc_isi_m2m_tile {
+	struct v4l2_area in_size;
+	struct v4l2_area scale;
+	struct v4l2_rect crop;
+	unsigned int in_x;
+	unsigned int out_x;
+};
+
 struct mxc_isi_m2m_buffer {
 	struct v4l2_m2m_buffer buf;
 	dma_addr_t dma_addrs[3];
@@ -65,7 +90,14 @@ struct mxc_isi_m2m_ctx {
 		bool vflip;
 	} ctrls;
 
+	struct {
+		unsigned int max_width;
+		unsigned int width;
+		unsigned int num;
+	} tiles;
+
 	bool chained;
+	bool aborting;
 };
 
 static inline struct mxc_isi_m2m_buffer *
@@ -105,6 +137,14 @@ static void mxc_isi_m2m_frame_write_done(struct mxc_isi_pipe *pipe, u32 status)
 		return;
 	}
 
+	/* Process the next tile of the current job. */
+	if (++m2m->tile < ctx->tiles.num) {
+		schedule_work(&m2m->run_work);
+		return;
+	}
+
+	m2m->tile = 0;
+
 	src_vbuf = v4l2_m2m_src_buf_remove(ctx->fh.m2m_ctx);
 	dst_vbuf = v4l2_m2m_dst_buf_remove(ctx->fh.m2m_ctx);
 
@@ -116,46 +156,141 @@ static void mxc_isi_m2m_frame_write_done(struct mxc_isi_pipe *pipe, u32 status)
 	v4l2_m2m_buf_done(src_vbuf, VB2_BUF_STATE_DONE);
 	v4l2_m2m_buf_done(dst_vbuf, VB2_BUF_STATE_DONE);
 
+	/*
+	 * Keep processing the jobs of the same context without going through
+	 * the M2M core, which would disable the channel and reschedule, unless
+	 * a context with a higher priority is waiting for the pipe.
+	 */
+	if (!READ_ONCE(ctx->aborting) &&
+	    ++m2m->batched < MXC_ISI_M2M_MAX_BATCH &&
+	    v4l2_m2m_num_src_bufs_ready(ctx->fh.m2m_ctx) &&
+	    v4l2_m2m_num_dst_bufs_ready(ctx->fh.m2m_ctx) &&
+	    !v4l2_m2m_should_yield(ctx->fh.m2m_ctx)) {
+		schedule_work(&m2m->run_work);
+		return;
+	}
+
 	v4l2_m2m_job_finish(m2m->m2m_dev, ctx->fh.m2m_ctx);
 }
 
-static void mxc_isi_m2m_device_run(void *priv)
+static void mxc_isi_m2m_ctx_setup_tiles(struct mxc_isi_m2m_ctx *ctx)
+{
+	unsigned int in_width = ctx->queues.out.format.width;
+	unsigned int out_width = ctx->queues.cap.format.width;
+	unsigned int overlap;
+	unsigned int width;
+	unsigned int margin;
+
+	if (in_width <= ctx->tiles.max_width) {
+		ctx->tiles.width = out_width;
+		ctx->tiles.num = 1;
+		return;
+	}
+
+	/*
+	 * Find the widest output tile whose input span, including the overlap
+	 * on both sides and the alignment of the input start, fits in the
+	 * line buffer, and then balance the tile widths.
+	 */
+	overlap = in_width != out_width ? MXC_ISI_M2M_TILE_OVERLAP : 0;
+	margin = 2 * overlap + MXC_ISI_M2M_TILE_ALIGN + 1;
+
+	width = (ctx->tiles.max_width - margin) * out_width / in_width;
+	width = max(ALIGN_DOWN(width, MXC_ISI_M2M_TILE_ALIGN),
+		    MXC_ISI_M2M_TILE_ALIGN);
+
+	ctx->tiles.num = DIV_ROUND_UP(out_width, width);
+	ctx->tiles.width = ALIGN(DIV_ROUND_UP(out_width, ctx->tiles.num),
+				 MXC_ISI_M2M_TILE_ALIGN);
+	ctx->tiles.num = DIV_ROUND_UP(out_width, ctx->tiles.width);
+
+	dev_dbg(ctx->m2m->isi->dev, "%u tiles of %u pixels for %u -> %u\n",
+		ctx->tiles.num, ctx->tiles.width, in_width, out_width);
+}
+
+static void mxc_isi_m2m_ctx_get_tile(struct mxc_isi_m2m_ctx *ctx,
+				     unsigned int index,
+				     struct mxc_isi_m2m_tile *tile)
+{
+	unsigned int in_width = ctx->queues.out.format.width;
+	unsigned int out_width = ctx->queues.cap.format.width;
+	unsigned int out_x0, out_x1;
+	unsigned int in_x0, in_x1;
+	unsigned int overlap;
+
+	out_x0 = index * ctx->tiles.width;
+	out_x1 = min(out_x0 + ctx->tiles.width, out_width);
+
+	if (ctx->tiles.num == 1) {
+		in_x0 = 0;
+		in_x1 = in_width;
+	} else {
+		overlap = in_width != out_width ? MXC_ISI_M2M_TILE_OVERLAP : 0;
+
+		in_x0 = out_x0 * in_width / out_width;
+		in_x0 = ALIGN_DOWN(in_x0 > overlap ? in_x0 - overlap : 0,
+				   MXC_ISI_M2M_TILE_ALIGN);
+		in_x1 = DIV_ROUND_UP(out_x1 * in_width, out_width) + overlap;
+		in_x1 = min(in_x1, in_width);
+		in_x1 = min(in_x1, in_x0 + ctx->tiles.max_width);
+	}
+
+	tile->in_x = in_x0;
+	tile->in_size.width = in_x1 - in_x0;
+	tile->in_size.height = ctx->queues.out.format.height;
+
+	/* Crop the overlap from the scaled tile. */
+	tile->crop.left = out_x0 - DIV_ROUND_CLOSEST(in_x0 * out_width, in_width);
+	tile->crop.top = 0;
+	tile->crop.width = out_x1 - out_x0;
+	tile->crop.height = ctx->queues.cap.format.height;
+
+	tile->scale.width = DIV_ROUND_CLOSEST(tile->in_size.width * out_width,
+					      in_width);
+	tile->scale.width = max(tile->scale.width,
+				tile->crop.left + tile->crop.width);
+	tile->scale.height = ctx->queues.cap.format.height;
+
+	/* Horizontal flipping mirrors the tile position in the output. */
+	tile->out_x = ctx->ctrls.hflip ? out_width - out_x1 : out_x0;
+}
+
+static void mxc_isi_m2m_run_tile(struct mxc_isi_m2m_ctx *ctx)
 {
-	struct mxc_isi_m2m_ctx *ctx = priv;
 	struct mxc_isi_m2m *m2m = ctx->m2m;
 	const struct mxc_isi_plat_data *pdata = m2m->isi->pdata;
-	const struct v4l2_pix_format_mplane *cap_pix = &ctx->queues.cap.format;
+	const struct mxc_isi_format_info *out_info = ctx->queues.out.info;
+	const struct mxc_isi_format_info *cap_info = ctx->queues.cap.info;
+	struct v4l2_pix_format_mplane cap_pix = ctx->queues.cap.format;
 	struct vb2_v4l2_buffer *src_vbuf, *dst_vbuf;
 	struct mxc_isi_m2m_buffer *src_buf, *dst_buf;
+	struct mxc_isi_m2m_tile tile;
+	dma_addr_t dma_addrs[3];
+	unsigned int i;
 
 	mxc_isi_channel_disable(m2m->pipe);
 
-	mutex_lock(&m2m->lock);
+	mutex_lock(ctx->ctrls.handler.lock);
+	mxc_isi_m2m_ctx_get_tile(ctx, m2m->tile, &tile);
+	mxc_isi_channel_set_alpha(m2m->pipe, ctx->ctrls.alpha);
+	mxc_isi_channel_set_flip(m2m->pipe, ctx->ctrls.hflip, ctx->ctrls.vflip);
+	mutex_unlock(ctx->ctrls.handler.lock);
 
-	/* If the context has changed, reconfigure the channel. */
-	if (m2m->last_ctx != ctx) {
-		const struct v4l2_area in_size = {
-			.width = ctx->queues.out.format.width,
-			.height = ctx->queues.out.format.height,
-		};
-		const struct v4l2_area scale = {
-			.width = ctx->queues.cap.format.width,
-			.height = ctx->queues.cap.format.height,
-		};
-		const struct v4l2_rect crop = {
-			.width = ctx->queues.cap.format.width,
-			.height = ctx->queues.cap.format.height,
-		};
+	mutex_lock(&m2m->lock);
 
+	/*
+	 * If the context has changed, reconfigure the channel. When tiling,
+	 * the geometry of the channel changes for every tile.
+	 */
+	if (m2m->last_ctx != ctx || ctx->tiles.num > 1)
 		mxc_isi_channel_config(m2m->pipe, MXC_ISI_INPUT_MEM,
-				       &in_size, &scale, &crop,
-				       ctx->queues.out.info->encoding,
-				       ctx->queues.cap.info->encoding);
-		mxc_isi_channel_set_input_format(m2m->pipe,
-						 ctx->queues.out.info,
+				       &tile.in_size, &tile.scale, &tile.crop,
+				       out_info->encoding, cap_info->encoding);
+
+	if (m2m->last_ctx != ctx) {
+		mxc_isi_channel_set_input_format(m2m->pipe, out_info,
 						 &ctx->queues.out.format);
-		mxc_isi_channel_set_output_format(m2m->pipe,
-						  ctx->queues.cap.info,
+		mxc_isi_channel_set_output_format(m2m->pipe, cap_info,
 						  &ctx->queues.cap.format);
 
 		m2m->last_ctx = ctx;
@@ -163,29 +298,78 @@ static void mxc_isi_m2m_device_run(void *priv)
 
 	mutex_unlock(&m2m->lock);
 
-	mutex_lock(ctx->ctrls.handler.lock);
-	mxc_isi_channel_set_alpha(m2m->pipe, ctx->ctrls.alpha);
-	mxc_isi_channel_set_flip(m2m->pipe, ctx->ctrls.hflip, ctx->ctrls.vflip);
-	mutex_unlock(ctx->ctrls.handler.lock);
-
 	src_vbuf = v4l2_m2m_next_src_buf(ctx->fh.m2m_ctx);
 	dst_vbuf = v4l2_m2m_next_dst_buf(ctx->fh.m2m_ctx);
 
 	src_buf = to_isi_m2m_buffer(src_vbuf);
 	dst_buf = to_isi_m2m_buffer(dst_vbuf);
 
-	mxc_isi_channel_set_inbuf(m2m->pipe, src_buf->dma_addrs[0]);
-	mxc_isi_channel_set_outbuf(m2m->pipe, dst_buf->dma_addrs, MXC_ISI_BUF1);
-	mxc_isi_channel_set_outbuf(m2m->pipe, dst_buf->dma_addrs, MXC_ISI_BUF2);
-	mxc_isi_channel_set_max_size(m2m->pipe, cap_pix, pdata->buf_max_size);
+	/*
+	 * Offset the buffer addresses to the tile position. The line pitches
+	 * are left to the full image width.
+	 */
+	for (i = 0; i < ARRAY_SIZE(dma_addrs); ++i) {
+		unsigned int offset = 0;
+
+		if (i < cap_info->color_planes) {
+			offset = i ? tile.out_x / cap_info->hsub : tile.out_x;
+			offset = offset * cap_info->depth[i] / 8;
+		}
+
+		dma_addrs[i] = dst_buf->dma_addrs[i] + offset;
+
+		if (cap_pix.plane_fmt[i].sizeimage > offset)
+			cap_pix.plane_fmt[i].sizeimage -= offset;
+	}
+
+	mxc_isi_channel_set_inbuf(m2m->pipe, src_buf->dma_addrs[0] +
+				  tile.in_x * out_info->depth[0] / 8);
+	mxc_isi_channel_set_outbuf(m2m->pipe, dma_addrs, MXC_ISI_BUF1);
+	mxc_isi_channel_set_outbuf(m2m->pipe, dma_addrs, MXC_ISI_BUF2);
+	mxc_isi_channel_set_max_size(m2m->pipe, &cap_pix, pdata->buf_max_size);
 
 	mxc_isi_channel_enable(m2m->pipe);
 
 	mxc_isi_channel_m2m_start(m2m->pipe);
 }
 
+static void mxc_isi_m2m_run_work(struct work_struct *work)
+{
+	struct mxc_isi_m2m *m2m = container_of(work, struct mxc_isi_m2m,
+					       run_work);
+	struct mxc_isi_m2m_ctx *ctx;
+
+	ctx = v4l2_m2m_get_curr_priv(m2m->m2m_dev);
+	if (ctx)
+		mxc_isi_m2m_run_tile(ctx);
+}
+
+static void mxc_isi_m2m_device_run(void *priv)
+{
+	struct mxc_isi_m2m_ctx *ctx = priv;
+	struct mxc_isi_m2m *m2m = ctx->m2m;
+
+	WRITE_ONCE(ctx->aborting, false);
+
+	mxc_isi_m2m_ctx_setup_tiles(ctx);
+
+	m2m->tile = 0;
+	m2m->batched = 0;
+
+	mxc_isi_m2m_run_tile(ctx);
+}
+
+static void mxc_isi_m2m_job_abort(void *priv)
+{
+	struct mxc_isi_m2m_ctx *ctx = priv;
+
+	/* Stop batching, the M2M core waits for the current job to finish. */
+	WRITE_ONCE(ctx->aborting, true);
+}
+
 static const struct v4l2_m2m_ops mxc_isi_m2m_ops = {
 	.device_run = mxc_isi_m2m_device_run,
+	.job_abort = mxc_isi_m2m_job_abort,
 };
 
 /* -----------------------------------------------------------------------------
@@ -532,17 +716,21 @@ static int mxc_isi_m2m_streamon(struct file *file, void *fh,
 
 	/*
 	 * Allocate resources for the channel, counting how many users require
-	 * buffer chaining.
+	 * buffer chaining. If the next channel isn't available, fall back to
+	 * tiling with the line buffer of a single channel.
 	 */
 	if (!ctx->chained && out_pix->width > MXC_ISI_MAX_WIDTH_UNCHAINED && !bypass) {
 		ret = mxc_isi_channel_chain(m2m->pipe, bypass);
-		if (ret)
-			goto deinit;
-
-		m2m->chained_count++;
-		ctx->chained = true;
+		if (!ret) {
+			m2m->chained_count++;
+			ctx->chained = true;
+		}
 	}
 
+	ctx->tiles.max_width = ctx->chained || bypass
+			     ? MXC_ISI_MAX_WIDTH_CHAINED
+			     : MXC_ISI_MAX_WIDTH_UNCHAINED;
+
 	/*
 	 * Drop the lock to start the stream, as the .device_run() operation
 	 * needs to acquire it.
@@ -564,7 +752,6 @@ static int mxc_isi_m2m_streamon(struct file *file, void *fh,
 		mxc_isi_channel_unchain(m2m->pipe);
 	ctx->chained = false;
 
-deinit:
 	if (--m2m->usage_count == 0) {
 		mxc_isi_channel_put(m2m->pipe);
 		mxc_isi_channel_release(m2m->pipe);
@@ -801,6 +988,7 @@ int mxc_isi_m2m_register(struct mxc_isi_dev *isi, struct v4l2_device *v4l2_dev)
 	m2m->pipe = &isi->pipes[0];
 
 	mutex_init(&m2m->lock);
+	INIT_WORK(&m2m->run_work, mxc_isi_m2m_run_work);
 
 	/* Initialize the video device and create controls. */
 	snprintf(vdev->name, sizeof(vdev->name), "mxc_isi.m2m");
@@ -815,7 +1003,10 @@ int mxc_isi_m2m_register(struct mxc_isi_dev *isi, struct v4l2_device *v4l2_dev)
 	vdev->device_caps = V4L2_CAP_STREAMING | V4L2_CAP_VIDEO_M2M_MPLANE;
 	video_set_drvdata(vdev, m2m);
 
-	/* Create the M2M device. */
+	/*
+	 * Create the M2M device. Jobs all run on the single pipe reserved for
+	 * memory to memory, so keep the default of one job at a time.
+	 */
 	m2m->m2m_dev = v4l2_m2m_init(&mxc_isi_m2m_ops);
 	if (IS_ERR(m2m->m2m_dev)) {
 		dev_err(isi->dev, "failed to initialize m2m device\n");
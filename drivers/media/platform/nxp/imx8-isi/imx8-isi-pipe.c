@@ -965,24 +965,64 @@ void mxc_isi_pipe_cleanup(struct mxc_isi_pipe *pipe)
 	mutex_destroy(&pipe->lock);
 }
 
+/*
+ * When a crossbar input is routed to multiple pipes, the media pipeline is
+ * started and validated by the first pipe only, and subsequent pipes join
+ * the running pipeline without link validation. The format of their sink pad
+ * may have been changed since, so check it against the crossbar output here.
+ */
+static int mxc_isi_pipe_validate_input(struct mxc_isi_pipe *pipe,
+				       const struct v4l2_mbus_framefmt *sink_fmt)
+{
+	struct mxc_isi_crossbar *xbar = &pipe->isi->crossbar;
+	struct v4l2_mbus_framefmt *xbar_fmt;
+	struct v4l2_subdev_state *state;
+	int ret = 0;
+
+	state = v4l2_subdev_lock_and_get_active_state(&xbar->sd);
+
+	xbar_fmt = v4l2_subdev_state_get_format(state,
+						xbar->num_sinks + pipe->id, 0);
+	if (!xbar_fmt) {
+		ret = -EPIPE;
+	} else if (xbar_fmt->code != sink_fmt->code ||
+		   xbar_fmt->width != sink_fmt->width ||
+		   xbar_fmt->height != sink_fmt->height) {
+		dev_dbg(pipe->isi->dev,
+			"pipe %u: sink format 0x%04x/%ux%u doesn't match input 0x%04x/%ux%u\n",
+			pipe->id, sink_fmt->code, sink_fmt->width,
+			sink_fmt->height, xbar_fmt->code, xbar_fmt->width,
+			xbar_fmt->height);
+		ret = -EPIPE;
+	}
+
+	v4l2_subdev_unlock_state(state);
+
+	return ret;
+}
+
 int mxc_isi_pipe_acquire(struct mxc_isi_pipe *pipe,
 			 mxc_isi_pipe_irq_t irq_handler)
 {
-	struct v4l2_mbus_framefmt *sink_fmt;
+	struct v4l2_mbus_framefmt sink_fmt;
 	struct v4l2_subdev *sd = &pipe->sd;
 	struct v4l2_subdev_state *state;
 	int ret;
 
 	state = v4l2_subdev_lock_and_get_active_state(sd);
-	sink_fmt = v4l2_subdev_state_get_format(state, MXC_ISI_PIPE_PAD_SINK);
+	sink_fmt = *v4l2_subdev_state_get_format(state, MXC_ISI_PIPE_PAD_SINK);
 	v4l2_subdev_unlock_state(state);
 
+	ret = mxc_isi_pipe_validate_input(pipe, &sink_fmt);
+	if (ret)
+		return ret;
+
 	ret = mxc_isi_channel_acquire(pipe, irq_handler, pipe->bypass);
 	if (ret)
 		return ret;
 
 	/* Chain the channel if needed for wide resolutions. */
-	if (sink_fmt->width > MXC_ISI_MAX_WIDTH_UNCHAINED && !pipe->bypass) {
+	if (sink_fmt.width > MXC_ISI_MAX_WIDTH_UNCHAINED && !pipe->bypass) {
 		ret = mxc_isi_channel_chain(pipe, false);
 		if (ret)
 			mxc_isi_channel_release(pipe);
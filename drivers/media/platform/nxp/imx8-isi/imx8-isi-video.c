@@ -500,9 +500,13 @@ mxc_isi_format_try(struct mxc_isi_pipe *pipe, struct v4l2_pix_format_mplane *pix
 	unsigned int max_width;
 	unsigned int i;
 
-	max_width = (!pipe->bypass && pipe->id == pipe->isi->pdata->num_channels - 1)
-		  ? MXC_ISI_MAX_WIDTH_UNCHAINED
-		  : MXC_ISI_MAX_WIDTH_CHAINED;
+	/* The M2M device splits images too wide for the channel in tiles. */
+	if (type & (MXC_ISI_VIDEO_M2M_OUT | MXC_ISI_VIDEO_M2M_CAP))
+		max_width = MXC_ISI_M2M_MAX_WIDTH;
+	else if (!pipe->bypass && pipe->id == pipe->isi->pdata->num_channels - 1)
+		max_width = MXC_ISI_MAX_WIDTH_UNCHAINED;
+	else
+		max_width = MXC_ISI_MAX_WIDTH_CHAINED;
 
 	fmt = mxc_isi_format_by_fourcc(pix->pixelformat, type);
 	if (!fmt)
@@ -677,6 +681,7 @@ static void mxc_isi_video_frame_write_done(struct mxc_isi_pipe *pipe,
 		 * and the ignored interrupts.
 		 */
 		video->frame_count += 2;
+		video->stats.missed_irqs++;
 		goto done;
 	}
 
@@ -716,6 +721,7 @@ static void mxc_isi_video_frame_write_done(struct mxc_isi_pipe *pipe,
 	if (status & CHNL_STS_FRM_STRD) {
 		dev_dbg(dev, "raced with frame end interrupt\n");
 		video->frame_count += 2;
+		video->stats.races++;
 		goto done;
 	}
 
@@ -730,8 +736,10 @@ static void mxc_isi_video_frame_write_done(struct mxc_isi_pipe *pipe,
 		buf->v4l2_buf.sequence = video->frame_count;
 		buf->v4l2_buf.vb2_buf.timestamp = ktime_get_ns();
 		vb2_buffer_done(&buf->v4l2_buf.vb2_buf, VB2_BUF_STATE_DONE);
+		video->stats.completed++;
 	} else {
 		list_move_tail(&buf->list, &video->out_discard);
+		video->stats.discarded++;
 	}
 
 	video->frame_count++;
@@ -1003,6 +1011,61 @@ static int mxc_isi_vb2_buffer_prepare(struct vb2_buffer *vb2)
 					    video->fmtinfo, &video->pix);
 }
 
+/*
+ * When no buffer was pending at the last frame end, the frame end handler has
+ * programmed a discard buffer in the idle BUF slot. The ISI will only switch
+ * to that slot at the next frame end, so a buffer queued by userspace in the
+ * meantime can still replace the discard buffer instead of waiting for one
+ * more frame, which would then be dropped.
+ *
+ * The same race with the frame end as in mxc_isi_video_frame_write_done()
+ * applies. If a frame end interrupt is pending before programming, leave it
+ * to the interrupt handler. If one occurred after programming, we can't tell
+ * which address the ISI has latched, so program the discard buffer back and
+ * keep the new buffer pending. In the worst case the ISI writes one frame to
+ * the new buffer that is then overwritten by the next frame before the buffer
+ * completes, which is no worse than dropping the frame.
+ *
+ * Must be called with buf_lock held.
+ */
+static void mxc_isi_video_queue_late_buffer(struct mxc_isi_video *video)
+{
+	struct mxc_isi_pipe *pipe = video->pipe;
+	const struct mxc_isi_plat_data *pdata = pipe->isi->pdata;
+	struct mxc_isi_buffer *discard_buf;
+	struct mxc_isi_buffer *buf;
+
+	if (list_empty(&video->out_active) ||
+	    list_is_singular(&video->out_active) ||
+	    !list_is_singular(&video->out_pending))
+		return;
+
+	discard_buf = list_last_entry(&video->out_active,
+				      struct mxc_isi_buffer, list);
+	if (!discard_buf->discard)
+		return;
+
+	if (mxc_isi_channel_irq_status(pipe, false) & CHNL_STS_FRM_STRD)
+		return;
+
+	buf = list_first_entry(&video->out_pending, struct mxc_isi_buffer,
+			       list);
+
+	mxc_isi_channel_set_outbuf(pipe, buf->dma_addrs, discard_buf->id);
+	mxc_isi_channel_set_max_size(pipe, &video->pix, pdata->buf_max_size);
+
+	if (mxc_isi_channel_irq_status(pipe, false) & CHNL_STS_FRM_STRD) {
+		mxc_isi_channel_set_outbuf(pipe, discard_buf->dma_addrs,
+					   discard_buf->id);
+		return;
+	}
+
+	buf->id = discard_buf->id;
+	list_move_tail(&discard_buf->list, &video->out_discard);
+	list_move_tail(&buf->list, &video->out_active);
+	video->stats.late_queued++;
+}
+
 static void mxc_isi_vb2_buffer_queue(struct vb2_buffer *vb2)
 {
 	struct vb2_v4l2_buffer *v4l2_buf = to_vb2_v4l2_buffer(vb2);
@@ -1011,6 +1074,7 @@ static void mxc_isi_vb2_buffer_queue(struct vb2_buffer *vb2)
 
 	spin_lock_irq(&video->buf_lock);
 	list_add_tail(&buf->list, &video->out_pending);
+	mxc_isi_video_queue_late_buffer(video);
 	spin_unlock_irq(&video->buf_lock);
 }
 
@@ -1049,8 +1113,9 @@ static int mxc_isi_vb2_start_streaming(struct vb2_queue *q, unsigned int count)
 	/* Queue the first buffers. */
 	mxc_isi_video_queue_first_buffers(video);
 
-	/* Clear frame count */
+	/* Clear frame count and statistics */
 	video->frame_count = 0;
+	memset(&video->stats, 0, sizeof(video->stats));
 
 	spin_unlock_irq(&video->buf_lock);
 
@@ -170,6 +170,25 @@ hantro_vdev_to_func(struct video_device *vdev)
 	return container_of(vdev, struct hantro_func, vdev);
 }
 
+/**
+ * struct hantro_aux_pool - device-wide cache of released auxiliary buffers
+ *
+ * @lock:	Protects the members below.
+ * @free:	Released buffers, most recently released first.
+ * @cached:	Total size of the buffers in @free.
+ * @hits:	Allocations served from the pool.
+ * @misses:	Allocations that went to the DMA allocator.
+ * @evictions:	Buffers freed to keep the pool under its size limit.
+ */
+struct hantro_aux_pool {
+	struct mutex lock;
+	struct list_head free;
+	size_t cached;
+	u64 hits;
+	u64 misses;
+	u64 evictions;
+};
+
 /**
  * struct hantro_dev - driver data
  * @v4l2_dev:		V4L2 device to register video devices for.
@@ -191,6 +210,8 @@ hantro_vdev_to_func(struct video_device *vdev)
  *			shared with interrupt handlers.
  * @variant:		Hardware variant-specific parameters.
  * @watchdog_work:	Delayed work for hardware timeout handling.
+ * @aux_pool:		Pool of auxiliary buffers shared by all contexts.
+ * @debugfs:		Debugfs directory of the device.
  */
 struct hantro_dev {
 	struct v4l2_device v4l2_dev;
@@ -211,6 +232,8 @@ struct hantro_dev {
 	spinlock_t irqlock;
 	const struct hantro_variant *variant;
 	struct delayed_work watchdog_work;
+	struct hantro_aux_pool aux_pool;
+	struct dentry *debugfs;
 };
 
 /**
@@ -493,5 +516,12 @@ int hantro_postproc_init(struct hantro_ctx *ctx);
 void hantro_postproc_free(struct hantro_ctx *ctx);
 int hanto_postproc_enum_framesizes(struct hantro_ctx *ctx,
 				   struct v4l2_frmsizeenum *fsize);
+int hantro_postproc_set_compose(struct hantro_ctx *ctx, struct v4l2_rect *r);
+
+void hantro_aux_pool_init(struct hantro_dev *vpu);
+void hantro_aux_pool_destroy(struct hantro_dev *vpu);
+int hantro_aux_buf_alloc(struct hantro_dev *vpu, struct hantro_aux_buf *buf,
+			 size_t size, unsigned long attrs);
+void hantro_aux_buf_free(struct hantro_dev *vpu, struct hantro_aux_buf *buf);
 
 #endif /* HANTRO_H_ */
@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Hantro VPU auxiliary buffer pool
+ *
+ * Codec contexts allocate their auxiliary buffers (tile, segment map,
+ * probability tables, post-processor reference frames...) at stream
+ * start and whenever the resolution changes. Released buffers are kept
+ * in a device-wide pool, keyed by size class, so that seeks, resolution
+ * switches and new streams reuse them instead of hitting the DMA
+ * allocator again.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/dma-mapping.h>
+#include <linux/log2.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+
+#include "hantro.h"
+
+static unsigned int aux_pool_max_kb = 65536;
+module_param(aux_pool_max_kb, uint, 0644);
+MODULE_PARM_DESC(aux_pool_max_kb,
+		 "Maximum amount of released auxiliary buffers kept for reuse, in KiB");
+
+/**
+ * struct hantro_aux_pool_entry - released auxiliary buffer
+ *
+ * @list:	Entry in &struct hantro_aux_pool.free.
+ * @cpu:	CPU pointer to the buffer.
+ * @dma:	DMA address of the buffer.
+ * @size:	Allocated (size class) size of the buffer.
+ * @attrs:	Attributes of the DMA mapping.
+ */
+struct hantro_aux_pool_entry {
+	struct list_head list;
+	void *cpu;
+	dma_addr_t dma;
+	size_t size;
+	unsigned long attrs;
+};
+
+/*
+ * Small buffers are rounded to pages, larger ones to a quarter of their
+ * power of two, which bounds the waste to 25% while letting nearby
+ * resolutions share a class.
+ */
+static size_t hantro_aux_pool_class(size_t size)
+{
+	size = PAGE_ALIGN(size);
+	if (size <= 4 * PAGE_SIZE)
+		return size;
+
+	return round_up(size, rounddown_pow_of_two(size) / 4);
+}
+
+int hantro_aux_buf_alloc(struct hantro_dev *vpu, struct hantro_aux_buf *buf,
+			 size_t size, unsigned long attrs)
+{
+	struct hantro_aux_pool *pool = &vpu->aux_pool;
+	struct hantro_aux_pool_entry *entry, *found = NULL;
+	size_t class = hantro_aux_pool_class(size);
+
+	mutex_lock(&pool->lock);
+	list_for_each_entry(entry, &pool->free, list) {
+		if (entry->size == class && entry->attrs == attrs) {
+			found = entry;
+			list_del(&entry->list);
+			pool->cached -= entry->size;
+			break;
+		}
+	}
+	if (found)
+		pool->hits++;
+	else
+		pool->misses++;
+	mutex_unlock(&pool->lock);
+
+	if (found) {
+		buf->cpu = found->cpu;
+		buf->dma = found->dma;
+		kfree(found);
+
+		/* Fresh DMA allocations are zeroed, keep it that way. */
+		if (!(attrs & DMA_ATTR_NO_KERNEL_MAPPING))
+			memset(buf->cpu, 0, class);
+	} else {
+		buf->cpu = dma_alloc_attrs(vpu->dev, class, &buf->dma,
+					   GFP_KERNEL, attrs);
+		if (!buf->cpu)
+			return -ENOMEM;
+	}
+
+	buf->size = size;
+	buf->attrs = attrs;
+
+	return 0;
+}
+
+void hantro_aux_buf_free(struct hantro_dev *vpu, struct hantro_aux_buf *buf)
+{
+	struct hantro_aux_pool *pool = &vpu->aux_pool;
+	struct hantro_aux_pool_entry *entry, *tmp;
+	size_t class = hantro_aux_pool_class(buf->size);
+	size_t max = (size_t)aux_pool_max_kb * SZ_1K;
+	LIST_HEAD(evicted);
+
+	if (!buf->cpu)
+		return;
+
+	entry = kmalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry || class > max) {
+		kfree(entry);
+		dma_free_attrs(vpu->dev, class, buf->cpu, buf->dma, buf->attrs);
+		buf->cpu = NULL;
+		return;
+	}
+
+	entry->cpu = buf->cpu;
+	entry->dma = buf->dma;
+	entry->size = class;
+	entry->attrs = buf->attrs;
+	buf->cpu = NULL;
+
+	mutex_lock(&pool->lock);
+	list_add(&entry->list, &pool->free);
+	pool->cached += class;
+
+	/* Evict the least recently released buffers above the limit. */
+	while (pool->cached > max) {
+		tmp = list_last_entry(&pool->free, struct hantro_aux_pool_entry,
+				      list);
+		list_move(&tmp->list, &evicted);
+		pool->cached -= tmp->size;
+		pool->evictions++;
+	}
+	mutex_unlock(&pool->lock);
+
+	list_for_each_entry_safe(entry, tmp, &evicted, list) {
+		dma_free_attrs(vpu->dev, entry->size, entry->cpu, entry->dma,
+			       entry->attrs);
+		kfree(entry);
+	}
+}
+
+static int hantro_aux_pool_show(struct seq_file *s, void *data)
+{
+	struct hantro_aux_pool *pool = s->private;
+	struct hantro_aux_pool_entry *entry;
+	unsigned int count = 0;
+
+	mutex_lock(&pool->lock);
+	list_for_each_entry(entry, &pool->free, list)
+		count++;
+
+	seq_printf(s, "hits:      %llu\n", pool->hits);
+	seq_printf(s, "misses:    %llu\n", pool->misses);
+	seq_printf(s, "evictions: %llu\n", pool->evictions);
+	seq_printf(s, "cached:    %u buffers, %zu bytes\n", count, pool->cached);
+	mutex_unlock(&pool->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(hantro_aux_pool);
+
+void hantro_aux_pool_init(struct hantro_dev *vpu)
+{
+	struct hantro_aux_pool *pool = &vpu->aux_pool;
+
+	mutex_init(&pool->lock);
+	INIT_LIST_HEAD(&pool->free);
+
+	vpu->debugfs = debugfs_create_dir(dev_name(vpu->dev), NULL);
+	debugfs_create_file("aux_pool", 0444, vpu->debugfs, pool,
+			    &hantro_aux_pool_fops);
+}
+
+void hantro_aux_pool_destroy(struct hantro_dev *vpu)
+{
+	struct hantro_aux_pool *pool = &vpu->aux_pool;
+	struct hantro_aux_pool_entry *entry, *tmp;
+
+	debugfs_remove_recursive(vpu->debugfs);
+
+	list_for_each_entry_safe(entry, tmp, &pool->free, list) {
+		dma_free_attrs(vpu->dev, entry->size, entry->cpu, entry->dma,
+			       entry->attrs);
+		kfree(entry);
+	}
+	pool->cached = 0;
+	mutex_destroy(&pool->lock);
+}
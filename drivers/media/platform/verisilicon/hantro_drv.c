@@ -1164,6 +1164,8 @@ static int hantro_probe(struct platform_device *pdev)
 		}
 	}
 
+	hantro_aux_pool_init(vpu);
+
 	pm_runtime_set_autosuspend_delay(vpu->dev, 100);
 	pm_runtime_use_autosuspend(vpu->dev);
 	pm_runtime_enable(vpu->dev);
@@ -1236,6 +1238,7 @@ static int hantro_probe(struct platform_device *pdev)
 err_pm_disable:
 	pm_runtime_dont_use_autosuspend(vpu->dev);
 	pm_runtime_disable(vpu->dev);
+	hantro_aux_pool_destroy(vpu);
 	return ret;
 }
 
@@ -1255,6 +1258,7 @@ static void hantro_remove(struct platform_device *pdev)
 	reset_control_assert(vpu->resets);
 	pm_runtime_dont_use_autosuspend(vpu->dev);
 	pm_runtime_disable(vpu->dev);
+	hantro_aux_pool_destroy(vpu);
 }
 
 #ifdef CONFIG_PM
@@ -47,7 +47,8 @@ irqreturn_t hantro_g2_irq(int irq, void *dev_id)
 
 size_t hantro_g2_chroma_offset(struct hantro_ctx *ctx)
 {
-	return ctx->dst_fmt.width * ctx->dst_fmt.height * ctx->bit_depth / 8;
+	return ctx->postproc.dec_width * ctx->postproc.dec_height *
+	       ctx->bit_depth / 8;
 }
 
 size_t hantro_g2_motion_vectors_offset(struct hantro_ctx *ctx)
@@ -83,5 +84,6 @@ size_t hantro_g2_luma_compress_offset(struct hantro_ctx *ctx)
 size_t hantro_g2_chroma_compress_offset(struct hantro_ctx *ctx)
 {
 	return hantro_g2_luma_compress_offset(ctx) +
-	       hantro_hevc_luma_compressed_size(ctx->dst_fmt.width, ctx->dst_fmt.height);
+	       hantro_hevc_luma_compressed_size(ctx->postproc.dec_width,
+						ctx->postproc.dec_height);
 }
@@ -345,9 +345,16 @@ struct hantro_av1_dec_hw_ctx {
  * struct hantro_postproc_ctx
  *
  * @dec_q:		References buffers, in decoder format.
+ * @down_scale:		Log2 of the post-processor downscale factor, 0 when
+ *			the CAPTURE frames are produced at decoded size.
+ * @dec_width:		Width of the decoded frames, before any scaling.
+ * @dec_height:		Height of the decoded frames, before any scaling.
  */
 struct hantro_postproc_ctx {
 	struct hantro_aux_buf dec_q[MAX_POSTPROC_BUFFERS];
+	unsigned int down_scale;
+	unsigned int dec_width;
+	unsigned int dec_height;
 };
 
 /**
@@ -355,7 +362,8 @@ struct hantro_postproc_ctx {
  *
  * @enable:		Enable the post-processor block. Optional.
  * @disable:		Disable the post-processor block. Optional.
- * @enum_framesizes:	Enumerate possible scaled output formats.
+ * @enum_framesizes:	Enumerate possible scaled output formats, the
+ *			frame size at index N being downscaled by 2^N.
  *			Returns zero if OK, a negative value in error cases.
  *			Optional.
  */
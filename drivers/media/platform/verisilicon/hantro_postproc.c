@@ -105,19 +105,11 @@ static void hantro_postproc_g1_enable(struct hantro_ctx *ctx)
 	HANTRO_PP_REG_WRITE(vpu, display_width, ctx->dst_fmt.width);
 }
 
-static int down_scale_factor(struct hantro_ctx *ctx)
-{
-	if (ctx->src_fmt.width <= ctx->dst_fmt.width)
-		return 0;
-
-	return DIV_ROUND_CLOSEST(ctx->src_fmt.width, ctx->dst_fmt.width);
-}
-
 static void hantro_postproc_g2_enable(struct hantro_ctx *ctx)
 {
 	struct hantro_dev *vpu = ctx->dev;
 	struct vb2_v4l2_buffer *dst_buf;
-	int down_scale = down_scale_factor(ctx);
+	unsigned int down_scale = ctx->postproc.down_scale;
 	int out_depth;
 	size_t chroma_offset;
 	dma_addr_t dst_dma;
@@ -127,13 +119,18 @@ static void hantro_postproc_g2_enable(struct hantro_ctx *ctx)
 	chroma_offset = ctx->dst_fmt.plane_fmt[0].bytesperline *
 			ctx->dst_fmt.height;
 
+	/*
+	 * dst_fmt already describes the scaled frame, so the chroma plane
+	 * of the downscaled output follows its luma plane directly.
+	 */
 	if (down_scale) {
 		hantro_reg_write(vpu, &g2_down_scale_e, 1);
-		hantro_reg_write(vpu, &g2_down_scale_y, down_scale >> 2);
-		hantro_reg_write(vpu, &g2_down_scale_x, down_scale >> 2);
+		hantro_reg_write(vpu, &g2_down_scale_y, down_scale - 1);
+		hantro_reg_write(vpu, &g2_down_scale_x, down_scale - 1);
 		hantro_write_addr(vpu, G2_DS_DST, dst_dma);
-		hantro_write_addr(vpu, G2_DS_DST_CHR, dst_dma + (chroma_offset >> down_scale));
+		hantro_write_addr(vpu, G2_DS_DST_CHR, dst_dma + chroma_offset);
 	} else {
+		hantro_reg_write(vpu, &g2_down_scale_e, 0);
 		hantro_write_addr(vpu, G2_RS_OUT_LUMA_ADDR, dst_dma);
 		hantro_write_addr(vpu, G2_RS_OUT_CHROMA_ADDR, dst_dma + chroma_offset);
 	}
@@ -184,11 +181,7 @@ void hantro_postproc_free(struct hantro_ctx *ctx)
 	for (i = 0; i < queue->max_num_buffers; ++i) {
 		struct hantro_aux_buf *priv = &ctx->postproc.dec_q[i];
 
-		if (priv->cpu) {
-			dma_free_attrs(vpu->dev, priv->size, priv->cpu,
-				       priv->dma, priv->attrs);
-			priv->cpu = NULL;
-		}
+		hantro_aux_buf_free(vpu, priv);
 	}
 }
 
@@ -240,14 +233,8 @@ static int hantro_postproc_alloc(struct hantro_ctx *ctx, int index)
 	 * The buffers on this queue are meant as intermediate
 	 * buffers for the decoder, so no mapping is needed.
 	 */
-	priv->attrs = DMA_ATTR_NO_KERNEL_MAPPING;
-	priv->cpu = dma_alloc_attrs(vpu->dev, buf_size, &priv->dma,
-				    GFP_KERNEL, priv->attrs);
-	if (!priv->cpu)
-		return -ENOMEM;
-	priv->size = buf_size;
-
-	return 0;
+	return hantro_aux_buf_alloc(vpu, priv, buf_size,
+				    DMA_ATTR_NO_KERNEL_MAPPING);
 }
 
 int hantro_postproc_init(struct hantro_ctx *ctx)
@@ -278,10 +265,8 @@ hantro_postproc_get_dec_buf_addr(struct hantro_ctx *ctx, int index)
 	int ret;
 
 	if (priv->size < buf_size && priv->cpu) {
-		/* buffer is too small, release it */
-		dma_free_attrs(vpu->dev, priv->size, priv->cpu,
-			       priv->dma, priv->attrs);
-		priv->cpu = NULL;
+		/* buffer is too small, give it back to the pool */
+		hantro_aux_buf_free(vpu, priv);
 	}
 
 	if (!priv->cpu) {
@@ -338,6 +323,39 @@ int hanto_postproc_enum_framesizes(struct hantro_ctx *ctx,
 	return -EINVAL;
 }
 
+/*
+ * Pick the strongest downscale whose output still covers the requested
+ * compose rectangle, so that the CAPTURE frames can be used as is
+ * instead of going through a separate scaling pass.
+ */
+int hantro_postproc_set_compose(struct hantro_ctx *ctx, struct v4l2_rect *r)
+{
+	struct v4l2_frmsizeenum fsize = {
+		.pixel_format = ctx->vpu_dst_fmt->fourcc,
+	};
+	unsigned int down_scale = 0;
+	int ret;
+
+	ret = hanto_postproc_enum_framesizes(ctx, &fsize);
+	if (ret)
+		return ret;
+
+	for (fsize.index = 1; ; fsize.index++) {
+		if (hanto_postproc_enum_framesizes(ctx, &fsize))
+			break;
+
+		if (fsize.discrete.width < r->width ||
+		    fsize.discrete.height < r->height)
+			break;
+
+		down_scale = fsize.index;
+	}
+
+	ctx->postproc.down_scale = down_scale;
+
+	return 0;
+}
+
 const struct hantro_postproc_ops hantro_g1_postproc_ops = {
 	.enable = hantro_postproc_g1_enable,
 	.disable = hantro_postproc_g1_disable,
@@ -331,6 +331,18 @@ static int hantro_try_fmt(const struct hantro_ctx *ctx,
 	v4l2_apply_frmsize_constraints(&pix_mp->width, &pix_mp->height,
 				       &vpu_fmt->frmsize);
 
+	/*
+	 * A decoder CAPTURE frame produced by the post-processor may be
+	 * downscaled, as negotiated through the compose selection.
+	 */
+	if (!coded && !ctx->is_encoder && ctx->postproc.down_scale &&
+	    hantro_needs_postproc(ctx, fmt)) {
+		pix_mp->width = ctx->src_fmt.width >> ctx->postproc.down_scale;
+		pix_mp->height = ctx->src_fmt.height >> ctx->postproc.down_scale;
+		v4l2_apply_frmsize_constraints(&pix_mp->width, &pix_mp->height,
+					       &vpu_fmt->frmsize);
+	}
+
 	if (!coded) {
 		/* Fill remaining fields */
 		v4l2_fill_pixfmt_mp(pix_mp, fmt->fourcc, pix_mp->width,
@@ -530,6 +542,10 @@ static int hantro_set_fmt_out(struct hantro_ctx *ctx,
 	ctx->vpu_src_fmt = hantro_find_format(ctx, pix_mp->pixelformat);
 	ctx->src_fmt = *pix_mp;
 
+	/* A new coded format invalidates any negotiated scaling. */
+	if (!ctx->is_encoder)
+		ctx->postproc.down_scale = 0;
+
 	/*
 	 * Current raw format might have become invalid with newly
 	 * selected codec, so reset it to default just to be safe and
@@ -588,6 +604,18 @@ static int hantro_set_fmt_cap(struct hantro_ctx *ctx,
 	ctx->vpu_dst_fmt = hantro_find_format(ctx, pix_mp->pixelformat);
 	ctx->dst_fmt = *pix_mp;
 
+	/*
+	 * The decoded frames keep the unscaled size, the reference
+	 * buffers layout is derived from it.
+	 */
+	if (!ctx->is_encoder) {
+		ctx->postproc.dec_width = ctx->src_fmt.width;
+		ctx->postproc.dec_height = ctx->src_fmt.height;
+		v4l2_apply_frmsize_constraints(&ctx->postproc.dec_width,
+					       &ctx->postproc.dec_height,
+					       &ctx->vpu_dst_fmt->frmsize);
+	}
+
 	/*
 	 * Current raw format might have become invalid with newly
 	 * selected codec, so reset it to default just to be safe and
@@ -627,14 +655,82 @@ vidioc_s_fmt_cap_mplane(struct file *file, void *priv, struct v4l2_format *f)
 	return hantro_set_fmt_cap(fh_to_ctx(priv), &f->fmt.pix_mp);
 }
 
+static int hantro_dec_g_selection(struct hantro_ctx *ctx,
+				  struct v4l2_selection *sel)
+{
+	/* Compose, i.e. post-processor scaling, only supported on sink. */
+	if (sel->type != V4L2_BUF_TYPE_VIDEO_CAPTURE)
+		return -EINVAL;
+
+	switch (sel->target) {
+	case V4L2_SEL_TGT_COMPOSE_DEFAULT:
+	case V4L2_SEL_TGT_COMPOSE_BOUNDS:
+		sel->r.top = 0;
+		sel->r.left = 0;
+		sel->r.width = ctx->postproc.dec_width;
+		sel->r.height = ctx->postproc.dec_height;
+		break;
+	case V4L2_SEL_TGT_COMPOSE:
+		sel->r.top = 0;
+		sel->r.left = 0;
+		sel->r.width = ctx->dst_fmt.width;
+		sel->r.height = ctx->dst_fmt.height;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int hantro_dec_s_selection(struct hantro_ctx *ctx,
+				  struct v4l2_selection *sel)
+{
+	struct v4l2_pix_format_mplane pix_mp;
+	struct vb2_queue *vq;
+	int ret;
+
+	if (sel->type != V4L2_BUF_TYPE_VIDEO_CAPTURE ||
+	    sel->target != V4L2_SEL_TGT_COMPOSE)
+		return -EINVAL;
+
+	/* Scaling is only done by the post-processor. */
+	if (!hantro_needs_postproc(ctx, ctx->vpu_dst_fmt))
+		return -EINVAL;
+
+	/* Change not allowed if CAPTURE buffers are allocated. */
+	vq = v4l2_m2m_get_vq(ctx->fh.m2m_ctx, V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE);
+	if (vb2_is_busy(vq))
+		return -EBUSY;
+
+	ret = hantro_postproc_set_compose(ctx, &sel->r);
+	if (ret)
+		return ret;
+
+	/* Resize the CAPTURE format to the selected scaling. */
+	pix_mp = ctx->dst_fmt;
+	ret = hantro_set_fmt_cap(ctx, &pix_mp);
+	if (ret)
+		return ret;
+
+	sel->r.top = 0;
+	sel->r.left = 0;
+	sel->r.width = ctx->dst_fmt.width;
+	sel->r.height = ctx->dst_fmt.height;
+
+	return 0;
+}
+
 static int vidioc_g_selection(struct file *file, void *priv,
 			      struct v4l2_selection *sel)
 {
 	struct hantro_ctx *ctx = fh_to_ctx(priv);
 
+	if (!ctx->is_encoder)
+		return hantro_dec_g_selection(ctx, sel);
+
 	/* Crop only supported on source. */
-	if (!ctx->is_encoder ||
-	    sel->type != V4L2_BUF_TYPE_VIDEO_OUTPUT)
+	if (sel->type != V4L2_BUF_TYPE_VIDEO_OUTPUT)
 		return -EINVAL;
 
 	switch (sel->target) {
@@ -665,9 +761,11 @@ static int vidioc_s_selection(struct file *file, void *priv,
 	struct v4l2_rect *rect = &sel->r;
 	struct vb2_queue *vq;
 
+	if (!ctx->is_encoder)
+		return hantro_dec_s_selection(ctx, sel);
+
 	/* Crop only supported on source. */
-	if (!ctx->is_encoder ||
-	    sel->type != V4L2_BUF_TYPE_VIDEO_OUTPUT)
+	if (sel->type != V4L2_BUF_TYPE_VIDEO_OUTPUT)
 		return -EINVAL;
 
 	/* Change not allowed if the queue is streaming. */
@@ -182,46 +182,34 @@ int hantro_vp9_dec_init(struct hantro_ctx *ctx)
 	vp9_dec->bsd_ctrl_offset = size;
 	size += hantro_vp9_bsd_control_size(max_height);
 
-	tile_edge->cpu = dma_alloc_coherent(vpu->dev, size, &tile_edge->dma, GFP_KERNEL);
-	if (!tile_edge->cpu)
+	if (hantro_aux_buf_alloc(vpu, tile_edge, size, 0))
 		return -ENOMEM;
 
-	tile_edge->size = size;
-	memset(tile_edge->cpu, 0, size);
-
 	size = hantro_vp9_segment_map_size(max_width, max_height);
 	vp9_dec->segment_map_size = size;
 	size *= 2; /* we need two areas of this size, used alternately */
 
-	segment_map->cpu = dma_alloc_coherent(vpu->dev, size, &segment_map->dma, GFP_KERNEL);
-	if (!segment_map->cpu)
+	if (hantro_aux_buf_alloc(vpu, segment_map, size, 0))
 		goto err_segment_map;
 
-	segment_map->size = size;
-	memset(segment_map->cpu, 0, size);
-
 	size = hantro_vp9_prob_tab_size();
 	vp9_dec->ctx_counters_offset = size;
 	size += hantro_vp9_count_tab_size();
 	vp9_dec->tile_info_offset = size;
 	size += hantro_vp9_tile_info_size();
 
-	misc->cpu = dma_alloc_coherent(vpu->dev, size, &misc->dma, GFP_KERNEL);
-	if (!misc->cpu)
+	if (hantro_aux_buf_alloc(vpu, misc, size, 0))
 		goto err_misc;
 
-	misc->size = size;
-	memset(misc->cpu, 0, size);
-
 	init_v4l2_vp9_count_tbl(ctx);
 
 	return 0;
 
 err_misc:
-	dma_free_coherent(vpu->dev, segment_map->size, segment_map->cpu, segment_map->dma);
+	hantro_aux_buf_free(vpu, segment_map);
 
 err_segment_map:
-	dma_free_coherent(vpu->dev, tile_edge->size, tile_edge->cpu, tile_edge->dma);
+	hantro_aux_buf_free(vpu, tile_edge);
 
 	return -ENOMEM;
 }
@@ -234,7 +222,7 @@ void hantro_vp9_dec_exit(struct hantro_ctx *ctx)
 	struct hantro_aux_buf *segment_map = &vp9_dec->segment_map;
 	struct hantro_aux_buf *misc = &vp9_dec->misc;
 
-	dma_free_coherent(vpu->dev, misc->size, misc->cpu, misc->dma);
-	dma_free_coherent(vpu->dev, segment_map->size, segment_map->cpu, segment_map->dma);
-	dma_free_coherent(vpu->dev, tile_edge->size, tile_edge->cpu, tile_edge->dma);
+	hantro_aux_buf_free(vpu, misc);
+	hantro_aux_buf_free(vpu, segment_map);
+	hantro_aux_buf_free(vpu, tile_edge);
 }
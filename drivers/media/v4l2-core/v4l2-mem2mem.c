@@ -84,11 +84,15 @@ static const char * const m2m_entity_name[] = {
  *			v4l2_m2m_unregister_media_controller().
  * @intf_devnode:	&struct media_intf devnode pointer with the interface
  *			with controls the M2M device.
- * @curr_ctx:		currently running instance
- * @job_queue:		instances queued to run
+ * @curr_ctx:		most recently started instance, the running one when
+ *			@max_jobs is 1
+ * @job_queue:		instances queued to run, by decreasing priority
  * @job_spinlock:	protects job_queue
  * @job_work:		worker to run queued jobs.
  * @job_queue_flags:	flags of the queue status, %QUEUE_PAUSED.
+ * @max_jobs:		number of jobs allowed to run at the same time
+ * @num_running:	number of jobs currently running
+ * @job_done:		wait queue signalled when a running job finishes
  * @m2m_ops:		driver callbacks
  */
 struct v4l2_m2m_dev {
@@ -107,6 +111,9 @@ struct v4l2_m2m_dev {
 	spinlock_t		job_spinlock;
 	struct work_struct	job_work;
 	unsigned long		job_queue_flags;
+	unsigned int		max_jobs;
+	unsigned int		num_running;
+	wait_queue_head_t	job_done;
 
 	const struct v4l2_m2m_ops *m2m_ops;
 };
@@ -243,45 +250,85 @@ void *v4l2_m2m_get_curr_priv(struct v4l2_m2m_dev *m2m_dev)
 }
 EXPORT_SYMBOL(v4l2_m2m_get_curr_priv);
 
+void v4l2_m2m_set_max_jobs(struct v4l2_m2m_dev *m2m_dev, unsigned int max_jobs)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&m2m_dev->job_spinlock, flags);
+	m2m_dev->max_jobs = max(max_jobs, 1U);
+	spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
+}
+EXPORT_SYMBOL_GPL(v4l2_m2m_set_max_jobs);
+
+bool v4l2_m2m_should_yield(struct v4l2_m2m_ctx *m2m_ctx)
+{
+	struct v4l2_m2m_dev *m2m_dev = m2m_ctx->m2m_dev;
+	struct v4l2_m2m_ctx *pos;
+	unsigned long flags;
+	bool ret = false;
+
+	spin_lock_irqsave(&m2m_dev->job_spinlock, flags);
+	list_for_each_entry(pos, &m2m_dev->job_queue, queue) {
+		if (!(pos->job_flags & TRANS_RUNNING)) {
+			ret = pos->priority > m2m_ctx->priority;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(v4l2_m2m_should_yield);
+
 /**
- * v4l2_m2m_try_run() - select next job to perform and run it if possible
+ * v4l2_m2m_try_run() - select next jobs to perform and run them if possible
  * @m2m_dev: per-device context
  *
- * Get next transaction (if present) from the waiting jobs list and run it.
+ * Get the next transactions (if present) from the waiting jobs list and run
+ * them, until as many jobs as the device allows are running.
  *
  * Note that this function can run on a given v4l2_m2m_ctx context,
  * but call .device_run for another context.
  */
 static void v4l2_m2m_try_run(struct v4l2_m2m_dev *m2m_dev)
 {
+	struct v4l2_m2m_ctx *m2m_ctx;
 	unsigned long flags;
 
-	spin_lock_irqsave(&m2m_dev->job_spinlock, flags);
-	if (NULL != m2m_dev->curr_ctx) {
-		spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
-		dprintk("Another instance is running, won't run now\n");
-		return;
-	}
+	for (;;) {
+		spin_lock_irqsave(&m2m_dev->job_spinlock, flags);
+		if (m2m_dev->num_running >= m2m_dev->max_jobs) {
+			spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
+			dprintk("Another instance is running, won't run now\n");
+			return;
+		}
 
-	if (list_empty(&m2m_dev->job_queue)) {
-		spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
-		dprintk("No job pending\n");
-		return;
-	}
+		if (m2m_dev->job_queue_flags & QUEUE_PAUSED) {
+			spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
+			dprintk("Running new jobs is paused\n");
+			return;
+		}
 
-	if (m2m_dev->job_queue_flags & QUEUE_PAUSED) {
-		spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
-		dprintk("Running new jobs is paused\n");
-		return;
-	}
+		/* Running instances stay on the queue until their job finishes */
+		list_for_each_entry(m2m_ctx, &m2m_dev->job_queue, queue) {
+			if (!(m2m_ctx->job_flags & TRANS_RUNNING))
+				break;
+		}
 
-	m2m_dev->curr_ctx = list_first_entry(&m2m_dev->job_queue,
-				   struct v4l2_m2m_ctx, queue);
-	m2m_dev->curr_ctx->job_flags |= TRANS_RUNNING;
-	spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
+		if (list_entry_is_head(m2m_ctx, &m2m_dev->job_queue, queue)) {
+			spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
+			dprintk("No job pending\n");
+			return;
+		}
 
-	dprintk("Running job on m2m_ctx: %p\n", m2m_dev->curr_ctx);
-	m2m_dev->m2m_ops->device_run(m2m_dev->curr_ctx->priv);
+		m2m_ctx->job_flags |= TRANS_RUNNING;
+		m2m_dev->curr_ctx = m2m_ctx;
+		m2m_dev->num_running++;
+		spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
+
+		dprintk("Running job on m2m_ctx: %p\n", m2m_ctx);
+		m2m_dev->m2m_ops->device_run(m2m_ctx->priv);
+	}
 }
 
 /*
@@ -298,6 +345,7 @@ static void __v4l2_m2m_try_queue(struct v4l2_m2m_dev *m2m_dev,
 {
 	unsigned long flags_job;
 	struct vb2_v4l2_buffer *dst, *src;
+	struct v4l2_m2m_ctx *pos;
 
 	dprintk("Trying to schedule a job for m2m_ctx: %p\n", m2m_ctx);
 
@@ -367,7 +415,12 @@ static void __v4l2_m2m_try_queue(struct v4l2_m2m_dev *m2m_dev,
 		goto job_unlock;
 	}
 
-	list_add_tail(&m2m_ctx->queue, &m2m_dev->job_queue);
+	/* Queue behind the instances of the same or a higher priority */
+	list_for_each_entry(pos, &m2m_dev->job_queue, queue) {
+		if (pos->priority < m2m_ctx->priority)
+			break;
+	}
+	list_add_tail(&m2m_ctx->queue, &pos->queue);
 	m2m_ctx->job_flags |= TRANS_QUEUED;
 
 job_unlock:
@@ -472,15 +525,18 @@ static void v4l2_m2m_schedule_next_job(struct v4l2_m2m_dev *m2m_dev,
 static bool _v4l2_m2m_job_finish(struct v4l2_m2m_dev *m2m_dev,
 				 struct v4l2_m2m_ctx *m2m_ctx)
 {
-	if (!m2m_dev->curr_ctx || m2m_dev->curr_ctx != m2m_ctx) {
+	if (!(m2m_ctx->job_flags & TRANS_RUNNING)) {
 		dprintk("Called by an instance not currently running\n");
 		return false;
 	}
 
-	list_del(&m2m_dev->curr_ctx->queue);
-	m2m_dev->curr_ctx->job_flags &= ~(TRANS_QUEUED | TRANS_RUNNING);
-	wake_up(&m2m_dev->curr_ctx->finished);
-	m2m_dev->curr_ctx = NULL;
+	list_del(&m2m_ctx->queue);
+	m2m_ctx->job_flags &= ~(TRANS_QUEUED | TRANS_RUNNING);
+	wake_up(&m2m_ctx->finished);
+	if (m2m_dev->curr_ctx == m2m_ctx)
+		m2m_dev->curr_ctx = NULL;
+	m2m_dev->num_running--;
+	wake_up(&m2m_dev->job_done);
 	return true;
 }
 
@@ -547,16 +603,12 @@ EXPORT_SYMBOL(v4l2_m2m_buf_done_and_job_finish);
 void v4l2_m2m_suspend(struct v4l2_m2m_dev *m2m_dev)
 {
 	unsigned long flags;
-	struct v4l2_m2m_ctx *curr_ctx;
 
 	spin_lock_irqsave(&m2m_dev->job_spinlock, flags);
 	m2m_dev->job_queue_flags |= QUEUE_PAUSED;
-	curr_ctx = m2m_dev->curr_ctx;
 	spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
 
-	if (curr_ctx)
-		wait_event(curr_ctx->finished,
-			   !(curr_ctx->job_flags & TRANS_RUNNING));
+	wait_event(m2m_dev->job_done, !READ_ONCE(m2m_dev->num_running));
 }
 EXPORT_SYMBOL(v4l2_m2m_suspend);
 
@@ -758,6 +810,26 @@ static void v4l2_m2m_force_last_buf_done(struct v4l2_m2m_ctx *m2m_ctx,
 	v4l2_m2m_last_buffer_done(m2m_ctx, vbuf);
 }
 
+/*
+ * Jobs are queued by the V4L2 priority of the file handle, so that an
+ * instance set to V4L2_PRIORITY_BACKGROUND with VIDIOC_S_PRIORITY yields the
+ * device to the interactive ones.
+ */
+static void v4l2_m2m_update_priority(struct file *file,
+				     struct v4l2_m2m_ctx *m2m_ctx)
+{
+	struct video_device *vdev = video_devdata(file);
+	struct v4l2_fh *fh = file->private_data;
+	enum v4l2_priority prio;
+
+	if (!test_bit(V4L2_FL_USES_V4L2_FH, &vdev->flags) ||
+	    fh->m2m_ctx != m2m_ctx)
+		return;
+
+	prio = fh->prio == V4L2_PRIORITY_UNSET ? V4L2_PRIORITY_DEFAULT : fh->prio;
+	WRITE_ONCE(m2m_ctx->priority, prio);
+}
+
 int v4l2_m2m_qbuf(struct file *file, struct v4l2_m2m_ctx *m2m_ctx,
 		  struct v4l2_buffer *buf)
 {
@@ -777,6 +849,8 @@ int v4l2_m2m_qbuf(struct file *file, struct v4l2_m2m_ctx *m2m_ctx,
 	if (ret)
 		return ret;
 
+	v4l2_m2m_update_priority(file, m2m_ctx);
+
 	/* Adjust MMAP memory offsets for the CAPTURE queue */
 	v4l2_m2m_adjust_mem_offset(vq, buf);
 
@@ -862,8 +936,10 @@ int v4l2_m2m_streamon(struct file *file, struct v4l2_m2m_ctx *m2m_ctx,
 
 	vq = v4l2_m2m_get_vq(m2m_ctx, type);
 	ret = vb2_streamon(vq, type);
-	if (!ret)
+	if (!ret) {
+		v4l2_m2m_update_priority(file, m2m_ctx);
 		v4l2_m2m_try_schedule(m2m_ctx);
+	}
 
 	return ret;
 }
@@ -890,6 +966,10 @@ int v4l2_m2m_streamoff(struct file *file, struct v4l2_m2m_ctx *m2m_ctx,
 	/* We should not be scheduled anymore, since we're dropping a queue. */
 	if (m2m_ctx->job_flags & TRANS_QUEUED)
 		list_del(&m2m_ctx->queue);
+	if (m2m_ctx->job_flags & TRANS_RUNNING) {
+		m2m_dev->num_running--;
+		wake_up(&m2m_dev->job_done);
+	}
 	m2m_ctx->job_flags = 0;
 
 	spin_lock_irqsave(&q_ctx->rdy_spinlock, flags);
@@ -1207,8 +1287,10 @@ struct v4l2_m2m_dev *v4l2_m2m_init(const struct v4l2_m2m_ops *m2m_ops)
 
 	m2m_dev->curr_ctx = NULL;
 	m2m_dev->m2m_ops = m2m_ops;
+	m2m_dev->max_jobs = 1;
 	INIT_LIST_HEAD(&m2m_dev->job_queue);
 	spin_lock_init(&m2m_dev->job_spinlock);
+	init_waitqueue_head(&m2m_dev->job_done);
 	INIT_WORK(&m2m_dev->job_work, v4l2_m2m_device_run_work);
 
 	return m2m_dev;
@@ -1235,6 +1317,7 @@ struct v4l2_m2m_ctx *v4l2_m2m_ctx_init(struct v4l2_m2m_dev *m2m_dev,
 
 	m2m_ctx->priv = drv_priv;
 	m2m_ctx->m2m_dev = m2m_dev;
+	m2m_ctx->priority = V4L2_PRIORITY_DEFAULT;
 	init_waitqueue_head(&m2m_ctx->finished);
 
 	out_q_ctx = &m2m_ctx->out_q_ctx;
@@ -60,6 +60,8 @@
 #include <linux/atomic.h>
 #include <linux/dma-mapping.h>
 #include <linux/slab.h>
+#include <linux/shrinker.h>
+#include <linux/spinlock.h>
 #if defined(CONFIG_X86) && (LINUX_VERSION_CODE >= KERNEL_VERSION(4, 12, 0))
 #    include <asm/set_memory.h>
 #endif
@@ -69,9 +71,43 @@
 
 #define gcdDISCRETE_PAGES 0
 
+/* Upper bound of freed pages kept for reuse in each page pool. */
+#define gcdGFP_POOL_MAX_PAGES 8192
+
+/*
+ * Freed single pages are kept in a pool per cacheability type, so that
+ * video nodes which are created and destroyed every frame do not go
+ * back to the page allocator each time. Pooled pages were invalidated
+ * when their last user unmapped them and (on x86) keep their WC/UC page
+ * attributes, so mapping them again needs no cache maintenance.
+ */
+enum gfp_pool_type {
+    GFP_POOL_CACHED,
+    GFP_POOL_WC,
+    GFP_POOL_UC,
+    GFP_POOL_COUNT,
+};
+
+struct gfp_pool {
+    spinlock_t       lock;
+    struct list_head pages;
+    unsigned long    count;
+
+    atomic_long_t    hits;
+    atomic_long_t    misses;
+    atomic_long_t    reclaimed;
+};
+
 struct gfp_alloc {
     atomic_t low;
     atomic_t high;
+
+    struct gfp_pool pool[GFP_POOL_COUNT];
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 7, 0)
+    struct shrinker *shrinker;
+#else
+    struct shrinker  shrinker;
+#endif
 };
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(2, 6, 24)
@@ -101,6 +137,10 @@ struct gfp_mdl_priv {
             int               numPages1M;
             int              *isExact;
             struct sg_table   sgt;
+
+            /* Pool the pages go back to, and how many came from it. */
+            struct gfp_pool  *pool;
+            gctSIZE_T         pooled;
         };
     };
 
@@ -126,8 +166,38 @@ static int gc_usage_show(struct seq_file *m, void *data)
     return 0;
 }
 
+static const char * const gfp_pool_names[GFP_POOL_COUNT] = {
+    [GFP_POOL_CACHED] = "cached",
+    [GFP_POOL_WC]     = "wc",
+    [GFP_POOL_UC]     = "uncached",
+};
+
+static int gc_pool_show(struct seq_file *m, void *data)
+{
+    gcsINFO_NODE     *node      = m->private;
+    gckALLOCATOR      Allocator = node->device;
+    struct gfp_alloc *priv      = Allocator->privateData;
+    int               i;
+
+    seq_puts(m, "type        n pages        bytes         hits       misses    reclaimed\n");
+
+    for (i = 0; i < GFP_POOL_COUNT; i++) {
+        struct gfp_pool   *pool  = &priv->pool[i];
+        unsigned long long count = READ_ONCE(pool->count);
+
+        seq_printf(m, "%-8s %10llu %12llu %12ld %12ld %12ld\n",
+                   gfp_pool_names[i], count, count * PAGE_SIZE,
+                   atomic_long_read(&pool->hits),
+                   atomic_long_read(&pool->misses),
+                   atomic_long_read(&pool->reclaimed));
+    }
+
+    return 0;
+}
+
 static gcsINFO InfoList[] = {
     { "usage", gc_usage_show },
+    { "pool", gc_pool_show },
 };
 
 static void
@@ -151,16 +221,206 @@ _GFPAllocatorDebugfsCleanup(IN gckALLOCATOR Allocator)
     gckDEBUGFS_DIR_Deinit(&Allocator->debugfsDir);
 }
 
-static void
-_NonContiguousFree(IN struct page **Pages, IN gctSIZE_T NumPages)
+/*******************************************************************************
+ ************************* GFP Allocator Page Pool *****************************
+ *******************************************************************************/
+
+static struct gfp_pool *
+_GFPPoolSelect(IN struct gfp_alloc *Priv, IN gckALLOCATOR Allocator, IN gctUINT32 Flags)
+{
+    /* 1M pages and address limited allocations bypass the pool. */
+    if ((Flags & (gcvALLOC_FLAG_1M_PAGES | gcvALLOC_FLAG_4GB_ADDR)) ||
+        (Allocator->os->device->platform->flagBits & gcvPLATFORM_FLAG_LIMIT_4G_ADDRESS))
+        return gcvNULL;
+
+    if (Flags & gcvALLOC_FLAG_CACHEABLE)
+        return &Priv->pool[GFP_POOL_CACHED];
+
+#if gcdENABLE_BUFFERABLE_VIDEO_MEMORY
+    return &Priv->pool[GFP_POOL_WC];
+#else
+    return &Priv->pool[GFP_POOL_UC];
+#endif
+}
+
+static gctSIZE_T
+_GFPPoolGet(IN struct gfp_pool *Pool, OUT struct page **Pages, IN gctSIZE_T NumPages)
+{
+    gctSIZE_T i;
+
+    spin_lock(&Pool->lock);
+
+    for (i = 0; i < NumPages && Pool->count; i++) {
+        Pages[i] = list_first_entry(&Pool->pages, struct page, lru);
+        list_del(&Pages[i]->lru);
+        Pool->count--;
+    }
+
+    spin_unlock(&Pool->lock);
+
+    atomic_long_add(i, &Pool->hits);
+    atomic_long_add(NumPages - i, &Pool->misses);
+
+    return i;
+}
+
+static gctSIZE_T
+_GFPPoolPut(IN struct gfp_pool *Pool, IN struct page **Pages, IN gctSIZE_T NumPages)
 {
     gctSIZE_T i;
 
+    spin_lock(&Pool->lock);
+
+    for (i = 0; i < NumPages && Pool->count < gcdGFP_POOL_MAX_PAGES; i++) {
+        list_add(&Pages[i]->lru, &Pool->pages);
+        Pool->count++;
+    }
+
+    spin_unlock(&Pool->lock);
+
+    return i;
+}
+
+static unsigned long
+_GFPPoolShrink(IN struct gfp_pool *Pool, IN unsigned long NumPages)
+{
+    struct page  *page;
+    unsigned long freed = 0;
+
+    while (freed < NumPages) {
+        spin_lock(&Pool->lock);
+
+        if (!Pool->count) {
+            spin_unlock(&Pool->lock);
+            break;
+        }
+
+        page = list_first_entry(&Pool->pages, struct page, lru);
+        list_del(&page->lru);
+        Pool->count--;
+
+        spin_unlock(&Pool->lock);
+
+#if defined(CONFIG_X86)
+        set_pages_wb(page, 1);
+#endif
+        __free_page(page);
+        freed++;
+    }
+
+    atomic_long_add(freed, &Pool->reclaimed);
+
+    return freed;
+}
+
+static unsigned long
+_GFPPoolCount(struct shrinker *Shrinker, struct shrink_control *Sc)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 7, 0)
+    struct gfp_alloc *priv  = Shrinker->private_data;
+#else
+    struct gfp_alloc *priv  = container_of(Shrinker, struct gfp_alloc, shrinker);
+#endif
+    unsigned long     count = 0;
+    int               i;
+
+    for (i = 0; i < GFP_POOL_COUNT; i++)
+        count += READ_ONCE(priv->pool[i].count);
+
+    return count;
+}
+
+static unsigned long
+_GFPPoolScan(struct shrinker *Shrinker, struct shrink_control *Sc)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 7, 0)
+    struct gfp_alloc *priv  = Shrinker->private_data;
+#else
+    struct gfp_alloc *priv  = container_of(Shrinker, struct gfp_alloc, shrinker);
+#endif
+    unsigned long     freed = 0;
+    int               i;
+
+    for (i = 0; i < GFP_POOL_COUNT && freed < Sc->nr_to_scan; i++)
+        freed += _GFPPoolShrink(&priv->pool[i], Sc->nr_to_scan - freed);
+
+    return freed ? freed : SHRINK_STOP;
+}
+
+static gceSTATUS
+_GFPPoolInit(IN struct gfp_alloc *Priv)
+{
+    int i;
+
+    for (i = 0; i < GFP_POOL_COUNT; i++) {
+        spin_lock_init(&Priv->pool[i].lock);
+        INIT_LIST_HEAD(&Priv->pool[i].pages);
+    }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 7, 0)
+    Priv->shrinker = shrinker_alloc(0, "galcore-gfp-pool");
+    if (!Priv->shrinker)
+        return gcvSTATUS_OUT_OF_MEMORY;
+
+    Priv->shrinker->count_objects = _GFPPoolCount;
+    Priv->shrinker->scan_objects  = _GFPPoolScan;
+    Priv->shrinker->private_data  = Priv;
+    shrinker_register(Priv->shrinker);
+#else
+    Priv->shrinker.count_objects = _GFPPoolCount;
+    Priv->shrinker.scan_objects  = _GFPPoolScan;
+    Priv->shrinker.seeks         = DEFAULT_SEEKS;
+#    if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 0, 0)
+    if (register_shrinker(&Priv->shrinker, "galcore-gfp-pool"))
+#    else
+    if (register_shrinker(&Priv->shrinker))
+#    endif
+        return gcvSTATUS_OUT_OF_MEMORY;
+#endif
+
+    return gcvSTATUS_OK;
+}
+
+static void
+_GFPPoolDeinit(IN struct gfp_alloc *Priv)
+{
+    int i;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 7, 0)
+    shrinker_free(Priv->shrinker);
+#else
+    unregister_shrinker(&Priv->shrinker);
+#endif
+
+    for (i = 0; i < GFP_POOL_COUNT; i++)
+        _GFPPoolShrink(&Priv->pool[i], ULONG_MAX);
+}
+
+/*
+ * Give back NumPages pages, the first NumConverted of which carry the
+ * WC/UC attributes on x86, to Pool (if any) and the page allocator.
+ */
+static void
+_NonContiguousRelease(IN struct gfp_pool *Pool,
+                      IN struct page    **Pages,
+                      IN gctSIZE_T        NumPages,
+                      IN gctSIZE_T        NumConverted)
+{
+    gctSIZE_T i, put = 0;
+
     gcmkHEADER_ARG("Pages=%p, NumPages=%zx", Pages, NumPages);
 
     gcmkASSERT(Pages != gcvNULL);
 
-    for (i = 0; i < NumPages; i++)
+    if (Pool)
+        put = _GFPPoolPut(Pool, Pages, NumConverted);
+
+#if defined(CONFIG_X86)
+    if (NumConverted > put)
+        set_pages_array_wb(Pages + put, NumConverted - put);
+#endif
+
+    for (i = put; i < NumPages; i++)
         __free_page(Pages[i]);
 
     if (is_vmalloc_addr(Pages))
@@ -176,7 +436,7 @@ _NonContiguousAlloc(IN struct gfp_mdl_priv *MdlPriv, IN gctSIZE_T NumPages, IN g
 {
     struct page **pages;
     struct page  *p;
-    gctSIZE_T     i, size;
+    gctSIZE_T     i, size, pooled = 0;
 
     gcmkHEADER_ARG("NumPages=%zx", NumPages);
 
@@ -204,11 +464,14 @@ _NonContiguousAlloc(IN struct gfp_mdl_priv *MdlPriv, IN gctSIZE_T NumPages, IN g
         }
     }
 
-    for (i = 0; i < NumPages; i++) {
+    if (MdlPriv->pool)
+        pooled = _GFPPoolGet(MdlPriv->pool, pages, NumPages);
+
+    for (i = pooled; i < NumPages; i++) {
         p = alloc_page(Gfp);
 
         if (!p) {
-            _NonContiguousFree(pages, i);
+            _NonContiguousRelease(MdlPriv->pool, pages, i, pooled);
             gcmkFOOTER_NO();
             return gcvSTATUS_OUT_OF_MEMORY;
         }
@@ -226,7 +489,7 @@ _NonContiguousAlloc(IN struct gfp_mdl_priv *MdlPriv, IN gctSIZE_T NumPages, IN g
                 __free_page(l);
 
                 if (!p) {
-                    _NonContiguousFree(pages, i);
+                    _NonContiguousRelease(MdlPriv->pool, pages, i, pooled);
                     gcmkFOOTER_NO();
                     return gcvSTATUS_OUT_OF_MEMORY;
                 }
@@ -238,6 +501,7 @@ _NonContiguousAlloc(IN struct gfp_mdl_priv *MdlPriv, IN gctSIZE_T NumPages, IN g
     }
 
     MdlPriv->nonContiguousPages = pages;
+    MdlPriv->pooled             = pooled;
 
     gcmkFOOTER_ARG("pages=%p", pages);
     return gcvSTATUS_OK;
@@ -405,6 +669,9 @@ _GFPAlloc(IN gckALLOCATOR  Allocator,
     int                  result;
     int                  low  = 0;
     int                  high = 0;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 8, 0)
+    unsigned long        attrs = 0;
+#endif
 
     gcmkHEADER_ARG("Allocator=%p Mdl=%p NumPages=%zu Flags=0x%x",
                    Allocator, Mdl, NumPages, Flags);
@@ -543,6 +810,8 @@ _GFPAlloc(IN gckALLOCATOR  Allocator,
         if (Mdl->pageUnit1M) {
             gcmkONERROR(_NonContiguous1MPagesAlloc(mdlPriv, &NumPages, gfp));
         } else {
+            mdlPriv->pool = _GFPPoolSelect(priv, Allocator, Flags);
+
             status = _NonContiguousAlloc(mdlPriv, NumPages, normal_gfp);
 
             if (gcmIS_ERROR(status))
@@ -573,21 +842,35 @@ _GFPAlloc(IN gckALLOCATOR  Allocator,
             if (Mdl->pageUnit1M)
                 _NonContiguous1MPagesFree(mdlPriv, mdlPriv->numPages1M);
             else
-                _NonContiguousFree(mdlPriv->nonContiguousPages, NumPages);
+                _NonContiguousRelease(mdlPriv->pool, mdlPriv->nonContiguousPages,
+                                      NumPages, mdlPriv->pooled);
 
             gcmkONERROR(gcvSTATUS_OUT_OF_MEMORY);
         }
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 8, 0)
+        /* Pooled pages hold no dirty cache lines, skip the cache flush. */
+        if (!Mdl->pageUnit1M && mdlPriv->pooled == NumPages)
+            attrs = DMA_ATTR_SKIP_CPU_SYNC;
+
+        result = dma_map_sg_attrs(dev,
+                                  mdlPriv->sgt.sgl,
+                                  mdlPriv->sgt.nents,
+                                  DMA_BIDIRECTIONAL,
+                                  attrs);
+#else
         result = dma_map_sg(dev,
                             mdlPriv->sgt.sgl,
                             mdlPriv->sgt.nents,
                             DMA_BIDIRECTIONAL);
+#endif
 
         if (result != mdlPriv->sgt.nents) {
             if (Mdl->pageUnit1M)
                 _NonContiguous1MPagesFree(mdlPriv, mdlPriv->numPages1M);
             else
-                _NonContiguousFree(mdlPriv->nonContiguousPages, NumPages);
+                _NonContiguousRelease(mdlPriv->pool, mdlPriv->nonContiguousPages,
+                                      NumPages, mdlPriv->pooled);
 
 #if gcdUSE_LINUX_SG_TABLE_API
             sg_free_table(&mdlPriv->sgt);
@@ -598,11 +881,14 @@ _GFPAlloc(IN gckALLOCATOR  Allocator,
         }
 
 #if defined(CONFIG_X86)
+        /* Pooled pages already carry the attributes. */
 #if gcdENABLE_BUFFERABLE_VIDEO_MEMORY
-        if (set_pages_array_wc(mdlPriv->nonContiguousPages, NumPages))
+        if (set_pages_array_wc(mdlPriv->nonContiguousPages + mdlPriv->pooled,
+                               NumPages - mdlPriv->pooled))
             pr_warn("%s(%d): failed to set_pages_array_wc\n", __func__, __LINE__);
 #    else
-        if (set_pages_array_uc(mdlPriv->nonContiguousPages, NumPages))
+        if (set_pages_array_uc(mdlPriv->nonContiguousPages + mdlPriv->pooled,
+                               NumPages - mdlPriv->pooled))
             pr_warn("%s(%d): failed to set_pages_array_uc\n", __func__, __LINE__);
 #    endif
 #endif
@@ -754,15 +1040,15 @@ _GFPFree(IN gckALLOCATOR Allocator, IN OUT PLINUX_MDL Mdl)
         else
 #endif
             __free_pages(mdlPriv->contiguousPages, get_order(Mdl->numPages * PAGE_SIZE));
-    } else {
+    } else if (Mdl->pageUnit1M) {
 #if defined(CONFIG_X86)
         set_pages_array_wb(mdlPriv->nonContiguousPages, Mdl->numPages);
 #endif
 
-        if (Mdl->pageUnit1M)
-            _NonContiguous1MPagesFree(mdlPriv, mdlPriv->numPages1M);
-        else
-            _NonContiguousFree(mdlPriv->nonContiguousPages, Mdl->numPages);
+        _NonContiguous1MPagesFree(mdlPriv, mdlPriv->numPages1M);
+    } else {
+        _NonContiguousRelease(mdlPriv->pool, mdlPriv->nonContiguousPages,
+                              Mdl->numPages, Mdl->numPages);
     }
 
     kfree(Mdl->priv);
@@ -1121,6 +1407,8 @@ _GFPAllocatorDestructor(gcsALLOCATOR *Allocator)
 {
     _GFPAllocatorDebugfsCleanup(Allocator);
 
+    _GFPPoolDeinit(Allocator->privateData);
+
     kfree(Allocator->privateData);
 
     kfree(Allocator);
@@ -1161,6 +1449,12 @@ _GFPAlloctorInit(IN gckOS Os, IN gcsDEBUGFS_DIR *Parent, OUT gckALLOCATOR *Alloc
     atomic_set(&priv->low, 0);
     atomic_set(&priv->high, 0);
 
+    status = _GFPPoolInit(priv);
+    if (gcmIS_ERROR(status)) {
+        kfree(priv);
+        gcmkONERROR(status);
+    }
+
     /* Register private data. */
     allocator->privateData = priv;
     allocator->destructor  = _GFPAllocatorDestructor;
@@ -306,6 +306,112 @@ gc_meminfo_show(void *m, void *data)
     return len;
 }
 
+static void
+_QueryClientCommits(gckGALDEVICE Device, gctUINT32 ProcessID,
+                    gctUINT64 *Commits, gctUINT64 *CommitTime)
+{
+    gcsHAL_PRIVATE_DATA_PTR data;
+
+    *Commits    = 0;
+    *CommitTime = 0;
+
+    mutex_lock(&Device->clientsMutex);
+
+    list_for_each_entry(data, &Device->clients, clientNode) {
+        if (data->pidOpen != ProcessID)
+            continue;
+
+        *Commits    += atomic64_read(&data->commits);
+        *CommitTime += atomic64_read(&data->commitTime);
+    }
+
+    mutex_unlock(&Device->clientsMutex);
+}
+
+gceSTATUS
+gckGALDEVICE_QueryClientUsage(IN gckGALDEVICE Device,
+                              IN gctUINT32 ProcessID,
+                              OUT gcsCLIENT_USAGE_PTR Usage)
+{
+    gckKERNEL       kernel = _GetValidKernel(Device);
+    gcsDATABASE_PTR database;
+    gctUINT32       i;
+
+    memset(Usage, 0, sizeof(*Usage));
+
+    _QueryClientCommits(Device, ProcessID, &Usage->commits, &Usage->commitTime);
+
+    if (kernel && gcmIS_SUCCESS(gckKERNEL_FindDatabase(kernel, ProcessID,
+                                                       gcvFALSE, &database))) {
+        for (i = 0; i < gcvPOOL_NUMBER_OF_POOLS; i++)
+            Usage->vidMemPool[i] = database->vidMemPool[i].bytes;
+
+        Usage->nonPaged = database->nonPaged.bytes;
+    }
+
+    return gcvSTATUS_OK;
+}
+
+/*
+ * One line per process: commits and the time spent committing (which includes
+ * waiting for command buffer space, so it grows when the GPU is saturated), and
+ * the video memory held from each pool. Reserved/CMA carve-out memory is
+ * accounted in SYSTEM, pages from the GFP/DMA allocators mapped through the
+ * GPU MMU in VIRTUAL, and wrapped user memory and imported dma-bufs in USER.
+ */
+static int
+gc_usage_show(void *m, void *data)
+{
+    gckGALDEVICE    device = galDevice;
+    gckKERNEL       kernel = _GetValidKernel(device);
+    gcsDATABASE_PTR database;
+    gctUINT64       commits, commitTime;
+    gctINT          i, pid;
+    char            name[24];
+    int             len = 0;
+#ifdef CONFIG_DEBUG_FS
+    void            *ptr = m;
+#else
+    char            *ptr = (char *)m;
+#endif
+
+    if (!kernel)
+        return -ENXIO;
+
+    len = fs_printf(ptr, "%-8s%-20s%12s%16s%14s%14s%14s%14s\n",
+                    "PID", "NAME", "COMMITS", "COMMIT_US",
+                    "SYSTEM", "VIRTUAL", "USER", "NONPAGED");
+
+    /* Acquire the database mutex. */
+    gcmkVERIFY_OK(gckOS_AcquireMutex(kernel->os, kernel->db->dbMutex, gcvINFINITE));
+
+    /* Walk the databases. */
+    for (i = 0; i < gcmCOUNTOF(kernel->db->db); ++i) {
+        for (database = kernel->db->db[i];
+             database != gcvNULL;
+             database = database->next) {
+            pid = database->processID;
+
+            gcmkVERIFY_OK(gckOS_GetProcessNameByPid(pid, gcmSIZEOF(name), name));
+
+            _QueryClientCommits(device, pid, &commits, &commitTime);
+
+            len += fs_printf(ptr + len, "%-8d%-20s%12llu%16llu%14llu%14llu%14llu%14llu\n",
+                             pid, name, commits, div_u64(commitTime, NSEC_PER_USEC),
+                             database->vidMemPool[gcvPOOL_SYSTEM].bytes +
+                             database->vidMemPool[gcvPOOL_SYSTEM_32BIT_VA].bytes,
+                             database->vidMemPool[gcvPOOL_VIRTUAL].bytes,
+                             database->vidMemPool[gcvPOOL_USER].bytes,
+                             database->nonPaged.bytes);
+        }
+    }
+
+    /* Release the database mutex. */
+    gcmkVERIFY_OK(gckOS_ReleaseMutex(kernel->os, kernel->db->dbMutex));
+
+    return len;
+}
+
 static int
 gc_load_show(void *m, void *data)
 {
@@ -1330,6 +1436,12 @@ gc_db_show_debugfs(struct seq_file *m, void *data)
     return gc_db_show((void *)m, data, gcvTRUE);
 }
 
+static int
+gc_usage_show_debugfs(struct seq_file *m, void *data)
+{
+    return gc_usage_show((void *)m, data);
+}
+
 static int
 gc_version_show_debugfs(struct seq_file *m, void *data)
 {
@@ -1389,6 +1501,7 @@ static gcsINFO InfoList[] = {
     { "idle", gc_idle_show_debugfs },
     { "database", gc_db_old_show_debugfs },
     { "database64x", gc_db_show_debugfs },
+    { "usage", gc_usage_show_debugfs },
     { "version", gc_version_show_debugfs },
     { "vidmem", gc_vidmem_old_show_debugfs, gc_vidmem_write },
     { "vidmem64x", gc_vidmem_show_debugfs, gc_vidmem_write },
@@ -1446,6 +1559,13 @@ database64x_show(struct device *dev, struct device_attribute *attr, char *buf)
 }
 DEVICE_ATTR_RO(database64x);
 
+static ssize_t
+usage_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return gc_usage_show((void *)buf, NULL);
+}
+DEVICE_ATTR_RO(usage);
+
 static ssize_t
 version_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
@@ -1540,6 +1660,7 @@ static struct attribute *Info_attrs[] = {
     &dev_attr_idle.attr,
     &dev_attr_database.attr,
     &dev_attr_database64x.attr,
+    &dev_attr_usage.attr,
     &dev_attr_version.attr,
     &dev_attr_vidmem.attr,
     &dev_attr_vidmem64x.attr,
@@ -2301,6 +2422,9 @@ gckGALDEVICE_Construct(IN gcsPLATFORM                *Platform,
 
     memset(gal_device, 0, sizeof(struct _gckGALDEVICE));
 
+    INIT_LIST_HEAD(&gal_device->clients);
+    mutex_init(&gal_device->clientsMutex);
+
     gal_device->platform      = Platform;
     gal_device->platform->dev = gcvNULL;
 
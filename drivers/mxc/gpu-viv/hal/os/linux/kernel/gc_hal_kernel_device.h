@@ -130,6 +130,10 @@ typedef struct _gckGALDEVICE {
 #if gcdENABLE_DRM
     void                *drm;
 #endif
+
+    /* Open galcore file handles, for per-process usage statistics. */
+    struct list_head    clients;
+    struct mutex        clientsMutex;
 } *gckGALDEVICE;
 
 typedef struct _gcsHAL_PRIVATE_DATA {
@@ -142,8 +146,22 @@ typedef struct _gcsHAL_PRIVATE_DATA {
     gctUINT32           pidOpen;
     gctBOOL             isLocked;
     gctUINT32           devIndex;
+
+    /* Link in gckGALDEVICE::clients. */
+    struct list_head    clientNode;
+    /* Number of commits, and time spent in them including stalls, in ns. */
+    atomic64_t          commits;
+    atomic64_t          commitTime;
 } gcsHAL_PRIVATE_DATA, *gcsHAL_PRIVATE_DATA_PTR;
 
+/* Per-process usage, gathered over all its galcore file handles. */
+typedef struct _gcsCLIENT_USAGE {
+    gctUINT64           commits;
+    gctUINT64           commitTime;
+    gctUINT64           vidMemPool[gcvPOOL_NUMBER_OF_POOLS];
+    gctUINT64           nonPaged;
+} gcsCLIENT_USAGE, *gcsCLIENT_USAGE_PTR;
+
 gceSTATUS
 gckGALDEVICE_Start(IN gckGALDEVICE Device);
 
@@ -158,6 +176,11 @@ gckGALDEVICE_Construct(IN gcsPLATFORM                *Platform,
 gceSTATUS
 gckGALDEVICE_Destroy(IN gckGALDEVICE Device);
 
+gceSTATUS
+gckGALDEVICE_QueryClientUsage(IN gckGALDEVICE Device,
+                              IN gctUINT32 ProcessID,
+                              OUT gcsCLIENT_USAGE_PTR Usage);
+
 static gcmkINLINE gckKERNEL
 _GetValidKernel(gckGALDEVICE Device)
 {
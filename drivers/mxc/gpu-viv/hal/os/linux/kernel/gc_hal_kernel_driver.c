@@ -553,6 +553,8 @@ static int drv_open(struct inode *inode, struct file *filp)
     data->isLocked = gcvFALSE;
     data->device   = galDevice;
     data->pidOpen  = _GetProcessID();
+    atomic64_set(&data->commits, 0);
+    atomic64_set(&data->commitTime, 0);
 
     for (devIndex = 0; devIndex < galDevice->args.devCount; devIndex++) {
         device = galDevice->devices[devIndex];
@@ -574,6 +576,10 @@ static int drv_open(struct inode *inode, struct file *filp)
 
     filp->private_data = data;
 
+    mutex_lock(&galDevice->clientsMutex);
+    list_add_tail(&data->clientNode, &galDevice->clients);
+    mutex_unlock(&galDevice->clientsMutex);
+
     /* Success. */
     gcmkFOOTER_NO();
     return 0;
@@ -651,6 +657,10 @@ static int drv_release(struct inode *inode, struct file *filp)
         }
     }
 
+    mutex_lock(&gal_device->clientsMutex);
+    list_del(&data->clientNode);
+    mutex_unlock(&gal_device->clientsMutex);
+
     kfree(data);
     filp->private_data = NULL;
 
@@ -752,10 +762,20 @@ static long drv_ioctl(struct file *filp, unsigned int ioctlCode, unsigned long a
                 gcmkONERROR(gckDEVICE_ChipInfo(device, &iface, &count));
             }
         } else {
+            gctUINT64 start = 0;
+
             device = gal_device->devices[iface.devIndex];
 
+            if (iface.command == gcvHAL_COMMIT)
+                start = ktime_get_ns();
+
             status = gckDEVICE_Dispatch(device, &iface);
 
+            if (iface.command == gcvHAL_COMMIT) {
+                atomic64_inc(&data->commits);
+                atomic64_add(ktime_get_ns() - start, &data->commitTime);
+            }
+
             /* Redo system call after pending signal is handled. */
             if (status == gcvSTATUS_INTERRUPTED) {
                 ret = -ERESTARTSYS;
@@ -63,6 +63,9 @@
 #        include <drm/drmP.h>
 #    endif
 #    include <drm/drm_gem.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 5, 0)
+#        include <drm/drm_print.h>
+#    endif
 #    include <linux/dma-buf.h>
 #    include "gc_hal_kernel_linux.h"
 #    include "gc_hal_drm.h"
@@ -781,6 +784,46 @@ static void viv_drm_postclose(struct drm_device *drm, struct drm_file *file)
     }
 }
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 5, 0)
+/*
+ * drm-usage-stats. Memory and commits are accounted per process, not per
+ * DRM file, so every file of a process reports the same totals. Busy time
+ * is not reported: GPU work is not attributed to processes.
+ */
+static void viv_drm_show_fdinfo(struct drm_printer *p, struct drm_file *file)
+{
+    static const struct {
+        const char *name;
+        gcePOOL     pools[2];
+    } regions[] = {
+        { "system",  { gcvPOOL_SYSTEM, gcvPOOL_SYSTEM_32BIT_VA } },
+        { "virtual", { gcvPOOL_VIRTUAL } },
+        { "user",    { gcvPOOL_USER } },
+    };
+    gctUINT32       pid     = gcmPTR2SIZE(file->driver_priv);
+    gckGALDEVICE    gal_dev = (gckGALDEVICE)file->minor->dev->dev_private;
+    gcsCLIENT_USAGE usage;
+    gctUINT64       bytes;
+    gctUINT         i, j;
+
+    gcmkVERIFY_OK(gckGALDEVICE_QueryClientUsage(gal_dev, pid, &usage));
+
+    for (i = 0; i < gcmCOUNTOF(regions); i++) {
+        bytes = 0;
+
+        for (j = 0; j < gcmCOUNTOF(regions[i].pools); j++) {
+            if (regions[i].pools[j] != gcvPOOL_UNKNOWN)
+                bytes += usage.vidMemPool[regions[i].pools[j]];
+        }
+
+        drm_printf(p, "drm-total-%s:\t%llu KiB\n", regions[i].name, bytes >> 10);
+    }
+
+    drm_printf(p, "vivante-commits:\t%llu\n", usage.commits);
+    drm_printf(p, "vivante-commit-time:\t%llu ns\n", usage.commitTime);
+}
+#    endif
+
 static const struct file_operations viv_drm_fops = {
     .owner              = THIS_MODULE,
     .open               = drm_open,
@@ -797,16 +840,28 @@ static const struct file_operations viv_drm_fops = {
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 11, 0)
     .fop_flags          = FOP_UNSIGNED_OFFSET,
 #endif
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 5, 0)
+    .show_fdinfo        = drm_show_fdinfo,
+#    endif
 };
 
 static struct drm_driver viv_drm_driver = {
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 4, 0)
+#if gcdLINUX_SYNC_FILE && defined(CONFIG_SYNC_FILE) && LINUX_VERSION_CODE >= KERNEL_VERSION(5, 4, 0)
+    /*
+     * GPU fences are plain dma_fences exported as sync_files, so they can
+     * be imported into (timeline) syncobjs for explicit synchronization.
+     */
+    .driver_features    = DRIVER_GEM | DRIVER_RENDER | DRIVER_SYNCOBJ | DRIVER_SYNCOBJ_TIMELINE,
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(5, 4, 0)
     .driver_features    = DRIVER_GEM | DRIVER_RENDER,
 #    else
     .driver_features    = DRIVER_GEM | DRIVER_PRIME | DRIVER_RENDER,
 #    endif
     .open               = viv_drm_open,
     .postclose          = viv_drm_postclose,
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 5, 0)
+    .show_fdinfo        = viv_drm_show_fdinfo,
+#    endif
 #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 11, 0)
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 7, 0)
     .gem_free_object_unlocked   = viv_gem_free_object,
@@ -6685,6 +6685,11 @@ gckOS_CreateNativeFence(IN gckOS     Os,
     /* Create sync_file. */
     sync = sync_file_create(fence);
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 9, 68)
+    /* sync_file holds its own reference. */
+    dma_fence_put(fence);
+#        endif
+
     if (!sync)
         gcmkONERROR(gcvSTATUS_OUT_OF_MEMORY);
 
@@ -6702,9 +6707,8 @@ gckOS_CreateNativeFence(IN gckOS     Os,
 OnError:
     if (sync)
         fput(sync->file);
-
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 9, 68)
-    if (fence)
+    else if (fence)
         dma_fence_put(fence);
 #        endif
 
@@ -6824,7 +6828,7 @@ gckOS_WaitNativeFence(IN gckOS     Os,
     for (i = 0; i < numFences; i++) {
         struct dma_fence *f = fences[i];
 
-        if (!dma_fence_is_signaled(fence)) {
+        if (!dma_fence_is_signaled(f)) {
             signed long ret;
 
             ret = dma_fence_wait_timeout(f, 1, timeout);
@@ -6836,8 +6840,8 @@ gckOS_WaitNativeFence(IN gckOS     Os,
                 dma_fence_put(fence);
                 gcmkONERROR(gcvSTATUS_TIMEOUT);
             } else {
-                /* wait success. */
-                timeout -= ret;
+                /* wait success, ret is the time left. */
+                timeout = ret;
             }
         }
     }
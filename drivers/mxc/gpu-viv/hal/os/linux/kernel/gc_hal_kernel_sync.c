@@ -252,73 +252,50 @@ static const char *viv_fence_get_timeline_name(struct dma_fence *fence)
     return f->parent->name;
 }
 
-/* Same as fence_signaled. */
-static inline bool __viv_fence_signaled(struct dma_fence *fence)
-{
-    struct viv_fence         *f        = (struct viv_fence *)fence;
-    struct viv_sync_timeline *timeline = f->parent;
-    gceSTATUS                 status;
-
-    status = _QuerySignal(timeline->os, f->signal);
-
-    return (status == gcvSTATUS_TRUE) ? true : false;
-}
-
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4, 20, 0)
 static bool viv_fence_enable_signaling(struct dma_fence *fence)
 {
-    /* fence is locked already. */
-    return !__viv_fence_signaled(fence);
-}
-
-static bool viv_fence_signaled(struct dma_fence *fence)
-{
-    /* fence could be locked, could be not. */
-    return __viv_fence_signaled(fence);
+    /* Signaled from gckOS_Signal(), nothing to arm. */
+    return true;
 }
+#    endif
 
 static void viv_fence_release(struct dma_fence *fence)
 {
-    struct viv_fence         *f        = (struct viv_fence *)fence;
-    struct viv_sync_timeline *timeline = f->parent;
-
-    if (f->signal)
-        gckOS_DestroySignal(timeline->os, f->signal);
-
     kfree(fence);
 }
 
+/*
+ * The fence is signaled directly by gckOS_Signal() when the GPU event of
+ * its signal fires, so there is no signaled callback: waiters only ever
+ * test the fence flags instead of looking up the signal each time.
+ */
 static struct dma_fence_ops viv_fence_ops = {
     .get_driver_name   = viv_fence_get_driver_name,
     .get_timeline_name = viv_fence_get_timeline_name,
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4, 20, 0)
     .enable_signaling  = viv_fence_enable_signaling,
-    .signaled          = viv_fence_signaled,
+#    endif
     .wait              = dma_fence_default_wait,
     .release           = viv_fence_release,
 };
 
+/*
+ * Create a fence for signal on timeline. The returned reference belongs
+ * to the caller, the signal holds another one until it is signaled.
+ */
 struct dma_fence *viv_fence_create(struct viv_sync_timeline *timeline, gcsSIGNAL *signal)
 {
-    gceSTATUS         status;
     struct viv_fence *fence;
     struct dma_fence *old_fence = NULL;
     unsigned int      seqno;
+    bool              done;
 
     fence = kzalloc(sizeof(*fence), gcdNOWARN | GFP_KERNEL);
 
     if (!fence)
         return NULL;
 
-    /* Reference signal in fence. */
-    status = gckOS_MapSignal(timeline->os,
-                             (gctSIGNAL)(uintptr_t)signal->id,
-                             NULL,
-                             &fence->signal);
-
-    if (gcmIS_ERROR(status)) {
-        kfree(fence);
-        return NULL;
-    }
-
     spin_lock_init(&fence->lock);
 
     fence->parent = timeline;
@@ -331,39 +308,25 @@ struct dma_fence *viv_fence_create(struct viv_sync_timeline *timeline, gcsSIGNAL
                    timeline->context,
                    seqno);
 
-    /*
-     * Reference fence in signal.
-     * Be aware of recursive reference!!
-     */
+    /* Reference fence in signal. */
     spin_lock(&signal->lock);
 
-    if (signal->fence) {
-        old_fence     = signal->fence;
-        signal->fence = NULL;
-    }
+    old_fence     = signal->fence;
+    signal->fence = NULL;
 
-    if (!signal->done) {
-        signal->fence = (struct dma_fence *)fence;
+    done = signal->done;
 
-#if LINUX_VERSION_CODE < KERNEL_VERSION(4, 9, 68)
-        dma_fence_get((struct dma_fence *)fence);
-#        endif
-    }
+    if (!done)
+        signal->fence = dma_fence_get((struct dma_fence *)fence);
 
     spin_unlock(&signal->lock);
 
     if (old_fence)
         dma_fence_put(old_fence);
 
-    if (!signal->fence) {
-        /* Fence already signaled. */
-        gckOS_DestroySignal(timeline->os, fence->signal);
-        fence->signal = NULL;
-
-        dma_fence_signal_locked((struct dma_fence *)fence);
-        dma_fence_put((struct dma_fence*)fence);
-        fence = NULL;
-    }
+    /* Signal already fired. */
+    if (done)
+        dma_fence_signal((struct dma_fence *)fence);
 
     return (struct dma_fence *)fence;
 }
@@ -128,9 +128,6 @@ struct viv_fence {
     spinlock_t                lock;
 
     struct viv_sync_timeline *parent;
-
-    /* link with signal. */
-    gctSIGNAL                 signal;
 };
 
 struct viv_sync_timeline *viv_sync_timeline_create(const char *name, gckOS Os);
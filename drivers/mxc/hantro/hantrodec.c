@@ -30,6 +30,7 @@
 #include <linux/interrupt.h>
 #include <linux/ioport.h>
 #include <linux/kernel.h>
+#include <linux/list.h>
 #include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/moduleparam.h>
@@ -41,12 +42,14 @@
 #include <linux/version.h>
 #include <linux/wait.h>
 #include <linux/timer.h>
+#include <linux/workqueue.h>
 #include <linux/clk.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
 #include <linux/of_irq.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/poll.h>
 #include <linux/clk.h>
 #include <linux/compat.h>
 #include <linux/busfreq-imx.h>
@@ -182,6 +185,8 @@ static int ReserveIO(void);
 static void ReleaseIO(void);
 
 static void ResetAsic(hantrodec_t *dev);
+static void ResetCore(hantrodec_t *dev, int id);
+static void DispatchDecJobs(hantrodec_t *dev);
 
 #ifdef HANTRODEC_DEBUG
 static void dump_regs(hantrodec_t *dev);
@@ -212,6 +217,52 @@ static DECLARE_WAIT_QUEUE_HEAD(pp_wait_queue);
 
 static DECLARE_WAIT_QUEUE_HEAD(hw_queue);
 
+/*
+ * Decoder jobs: instead of reserving a Core and waiting for it, clients may
+ * queue register sets, which are started on the next free Core that has the
+ * format right from the IRQ handler, without a round trip to user space.
+ * The jobs and the Cores they run on are protected by owner_lock.
+ */
+#define HANTRODEC_MAX_JOBS		16
+#define HANTRODEC_JOB_TIMEOUT_MS	200
+
+enum dec_job_state {
+	DEC_JOB_QUEUED,
+	DEC_JOB_RUNNING,
+	DEC_JOB_DONE,
+};
+
+struct dec_client;
+
+struct dec_job {
+	struct list_head queue; /* in job_queue, while queued */
+	struct list_head node; /* in the client's jobs */
+	struct dec_client *client;
+	enum dec_job_state state;
+	u64 seqno;
+	u32 format;
+	u32 size;
+	u32 core;
+	int status;
+	unsigned long deadline;
+	u32 regs[DEC_IO_SIZE_MAX/4];
+};
+
+/* per open file */
+struct dec_client {
+	struct list_head jobs;
+	unsigned int nr_jobs;
+	unsigned int nr_done;
+	u64 seqno;
+	wait_queue_head_t wait;
+};
+
+static LIST_HEAD(job_queue);
+static struct dec_job *core_job[HXDEC_MAX_CORES];
+static struct delayed_work job_timeout_work[HXDEC_MAX_CORES];
+static bool jobs_suspended;
+static void __iomem *blkctl_regs;
+
 #define DWL_CLIENT_TYPE_H264_DEC         1U
 #define DWL_CLIENT_TYPE_MPEG4_DEC        2U
 #define DWL_CLIENT_TYPE_JPEG_DEC         3U
@@ -470,7 +521,7 @@ static int GetDecCore(long Core, hantrodec_t *dev, struct file *filp)
 	unsigned long flags;
 
 	spin_lock_irqsave(&owner_lock, flags);
-	if (dec_owner[Core] == NULL) {
+	if (dec_owner[Core] == NULL && core_job[Core] == NULL) {
 		dec_owner[Core] = filp;
 		success = 1;
 	}
@@ -604,6 +655,9 @@ static void ReleaseDecoder(hantrodec_t *dev, long Core)
 
 	dec_owner[Core] = NULL;
 
+	/* queued jobs may use the Core now */
+	DispatchDecJobs(dev);
+
 	spin_unlock_irqrestore(&owner_lock, flags);
 
 	up(&dec_core_sem);
@@ -658,9 +712,47 @@ static void ReleasePostProcessor(hantrodec_t *dev, long Core)
 	up(&pp_core_sem);
 }
 
+/* write all regs but the id reg[0] and the status reg[1] to hardware */
+static void DecWriteRegs(hantrodec_t *dev, u32 id, const u32 *regs)
+{
+	long i;
+
+	if (IS_G1(dev->hw_id[id])) {
+		/* both original and extended regs need to be written */
+		for (i = 2; i <= HANTRO_DEC_ORG_LAST_REG; i++)
+			iowrite32(regs[i], dev->hwregs[id] + i*4);
+#ifdef USE_64BIT_ENV
+		for (i = HANTRO_DEC_EXT_FIRST_REG; i <= HANTRO_DEC_EXT_LAST_REG; i++)
+			iowrite32(regs[i], dev->hwregs[id] + i*4);
+#endif
+	} else {
+		for (i = 2; i <= HANTRO_G2_DEC_LAST_REG; i++)
+			iowrite32(regs[i], dev->hwregs[id] + i*4);
+	}
+}
+
+/* read all registers from hardware */
+static void DecReadRegs(hantrodec_t *dev, u32 id, u32 *regs)
+{
+	long i;
+
+	if (IS_G1(dev->hw_id[id])) {
+		/* both original and extended regs need to be read */
+		for (i = 0; i <= HANTRO_DEC_ORG_LAST_REG; i++)
+			regs[i] = ioread32(dev->hwregs[id] + i*4);
+#ifdef USE_64BIT_ENV
+		for (i = HANTRO_DEC_EXT_FIRST_REG; i <= HANTRO_DEC_EXT_LAST_REG; i++)
+			regs[i] = ioread32(dev->hwregs[id] + i*4);
+#endif
+	} else {
+		for (i = 0; i <= HANTRO_G2_DEC_LAST_REG; i++)
+			regs[i] = ioread32(dev->hwregs[id] + i*4);
+	}
+}
+
 static long DecFlushRegs(hantrodec_t *dev, struct core_desc *Core)
 {
-	long ret = 0, i;
+	long ret = 0;
 
 	u32 id = Core->id;
 
@@ -683,15 +775,6 @@ static long DecFlushRegs(hantrodec_t *dev, struct core_desc *Core)
 			pr_err("copy_from_user failed, returned %li\n", ret);
 			return -EFAULT;
 		}
-
-		/* write dec regs but the status reg[1] to hardware */
-		/* both original and extended regs need to be written */
-		for (i = 2; i <= HANTRO_DEC_ORG_LAST_REG; i++)
-			iowrite32(dec_regs[id][i], dev->hwregs[id] + i*4);
-#ifdef USE_64BIT_ENV
-		for (i = HANTRO_DEC_EXT_FIRST_REG; i <= HANTRO_DEC_EXT_LAST_REG; i++)
-			iowrite32(dec_regs[id][i], dev->hwregs[id] + i*4);
-#endif
 	} else {
 		ret = copy_from_user(dec_regs[id],
 				     (void __user *)Core->regs,
@@ -700,12 +783,10 @@ static long DecFlushRegs(hantrodec_t *dev, struct core_desc *Core)
 			pr_err("copy_from_user failed, returned %li\n", ret);
 			return -EFAULT;
 		}
-
-		/* write all regs but the status reg[1] to hardware */
-		for (i = 2; i <= HANTRO_G2_DEC_LAST_REG; i++)
-			iowrite32(dec_regs[id][i], dev->hwregs[id] + i*4);
 	}
 
+	DecWriteRegs(dev, id, dec_regs[id]);
+
 	if (dec_regs[id][1] & 0x1) {
 		if (down_timeout(&core_suspend_sem[id], msecs_to_jiffies(10000)))
 			pr_err("core suspend sem down error id %d\n", id);
@@ -721,7 +802,7 @@ static long DecFlushRegs(hantrodec_t *dev, struct core_desc *Core)
 
 static long DecRefreshRegs(hantrodec_t *dev, struct core_desc *Core)
 {
-	long ret, i;
+	long ret;
 	u32 id = Core->id;
 
 	if (IS_G1(dev->hw_id[id])) {
@@ -729,20 +810,13 @@ static long DecRefreshRegs(hantrodec_t *dev, struct core_desc *Core)
 		//if(Core->size != (HANTRO_DEC_ORG_REGS * 4))
 		//  return -EFAULT;
 
-		/* read all registers from hardware */
-		/* both original and extended regs need to be read */
-		for (i = 0; i <= HANTRO_DEC_ORG_LAST_REG; i++)
-			dec_regs[id][i] = ioread32(dev->hwregs[id] + i*4);
-#ifdef USE_64BIT_ENV
-		for (i = HANTRO_DEC_EXT_FIRST_REG; i <= HANTRO_DEC_EXT_LAST_REG; i++)
-			dec_regs[id][i] = ioread32(dev->hwregs[id] + i*4);
-#endif
+		DecReadRegs(dev, id, dec_regs[id]);
 
 		if (timeout) {
 			/* Enable TIMEOUT bits in Reg[1] */
 			dec_regs[id][1] = 0x40100;
-			/* Reset HW */
-			ResetAsic(dev);
+			/* Reset HW, the other Core may be running a job */
+			ResetCore(dev, id);
 			timeout = 0;
 		}
 
@@ -766,15 +840,13 @@ static long DecRefreshRegs(hantrodec_t *dev, struct core_desc *Core)
 		if (Core->size != (HANTRO_G2_DEC_REGS * 4))
 			return -EFAULT;
 
-		/* read all registers from hardware */
-		for (i = 0; i <= HANTRO_G2_DEC_LAST_REG; i++)
-			dec_regs[id][i] = ioread32(dev->hwregs[id] + i*4);
+		DecReadRegs(dev, id, dec_regs[id]);
 
 		if (timeout) {
 			/* Enable TIMEOUT bits in Reg[1] */
 			dec_regs[id][1] = 0x40100;
-			/* Reset HW */
-			ResetAsic(dev);
+			/* Reset HW, the other Core may be running a job */
+			ResetCore(dev, id);
 			timeout = 0;
 		}
 
@@ -1052,6 +1124,296 @@ static long WaitCoreReady(hantrodec_t *dev, const struct file *filp, u32 *id)
 	return 0;
 }
 
+/* bytes of registers a job for format needs, on any Core it may run on */
+static u32 DecJobRegsSize(hantrodec_t *dev, u32 format)
+{
+	u32 size = 0, core_size;
+	int c;
+
+	for (c = 0; c < dev->cores; c++) {
+		if (!CoreHasFormat(cfg, c, format))
+			continue;
+		if (IS_G1(dev->hw_id[c])) {
+#ifdef USE_64BIT_ENV
+			core_size = (HANTRO_DEC_EXT_LAST_REG + 1) * 4;
+#else
+			core_size = HANTRO_DEC_ORG_REGS * 4;
+#endif
+		} else {
+			core_size = HANTRO_G2_DEC_REGS * 4;
+		}
+		size = MAX_VAL(size, core_size);
+	}
+	return size;
+}
+
+/* called with owner_lock held */
+static void StartDecJob(hantrodec_t *dev, int id, struct dec_job *job)
+{
+	list_del(&job->queue);
+	job->state = DEC_JOB_RUNNING;
+	job->core = id;
+	job->deadline = jiffies + msecs_to_jiffies(HANTRODEC_JOB_TIMEOUT_MS);
+	core_job[id] = job;
+
+	/* same as hantrodec_choose_core(), which can't be used here */
+	if (blkctl_regs)
+		iowrite32(IS_G1(dev->hw_id[id]) ? 0x1 : 0x0, blkctl_regs + 0x14);
+
+	/* held while the Core runs, for suspend */
+	if (down_trylock(&core_suspend_sem[id]))
+		pr_err("core suspend sem down error id %d\n", id);
+
+	DecWriteRegs(dev, id, job->regs);
+	/* write the status register, which starts the decoder */
+	iowrite32(job->regs[1], dev->hwregs[id] + 4);
+
+	mod_delayed_work(system_wq, &job_timeout_work[id],
+			 msecs_to_jiffies(HANTRODEC_JOB_TIMEOUT_MS));
+	PDEBUG("started job %llu on Core %d\n", job->seqno, id);
+}
+
+/* Start queued jobs on the Cores nobody reserved. Called with owner_lock held */
+static void DispatchDecJobs(hantrodec_t *dev)
+{
+	struct dec_job *job;
+	int c;
+
+	if (jobs_suspended)
+		return;
+
+	for (c = 0; c < dev->cores; c++) {
+		if (dec_owner[c] || core_job[c])
+			continue;
+		list_for_each_entry(job, &job_queue, queue) {
+			if (CoreHasFormat(cfg, c, job->format)) {
+				StartDecJob(dev, c, job);
+				break;
+			}
+		}
+	}
+}
+
+/* called with owner_lock held */
+static void FinishDecJob(hantrodec_t *dev, int id, int status)
+{
+	struct dec_job *job = core_job[id];
+
+	DecReadRegs(dev, id, job->regs);
+	if (status) {
+		/* Enable TIMEOUT bits in Reg[1], as DecRefreshRegs() */
+		job->regs[1] = 0x40100;
+		ResetCore(dev, id);
+	}
+
+	core_job[id] = NULL;
+	job->status = status;
+	job->state = DEC_JOB_DONE;
+	job->client->nr_done++;
+	up(&core_suspend_sem[id]);
+
+	wake_up_all(&job->client->wait);
+	/* for ReserveDecoder() and suspend */
+	wake_up_all(&hw_queue);
+}
+
+static void DecJobTimeout(struct work_struct *work)
+{
+	int id = to_delayed_work(work) - job_timeout_work;
+	hantrodec_t *dev = &hantrodec_data;
+	unsigned long flags;
+	struct dec_job *job;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	job = core_job[id];
+	/* the job timed out, not one started since */
+	if (job && time_after_eq(jiffies, job->deadline)) {
+		pr_err("DEC[%d]  job %llu timeout\n", id, job->seqno);
+		FinishDecJob(dev, id, -ETIMEDOUT);
+		DispatchDecJobs(dev);
+	}
+	spin_unlock_irqrestore(&owner_lock, flags);
+}
+
+static long SubmitDecJob(hantrodec_t *dev, struct file *filp,
+			 struct hantrodec_job __user *ujob)
+{
+	struct dec_client *client = filp->private_data;
+	struct hantrodec_job desc;
+	struct dec_job *job;
+	unsigned long flags;
+	long ret = 0;
+
+	if (copy_from_user(&desc, ujob, sizeof(desc)))
+		return -EFAULT;
+
+	if (desc.format >= 32)
+		return -EINVAL;
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job)
+		return -ENOMEM;
+
+	/* user has to know exactly what they are asking for */
+	job->size = DecJobRegsSize(dev, desc.format);
+	if (!job->size || desc.size < job->size) {
+		ret = -EINVAL;
+		goto err;
+	}
+	if (copy_from_user(job->regs, u64_to_user_ptr(desc.regs), job->size)) {
+		ret = -EFAULT;
+		goto err;
+	}
+	job->format = desc.format;
+	job->client = client;
+
+#ifdef CONFIG_DEVFREQ_THERMAL
+	if (hantro_dynamic_clock)
+		hantro_thermal_check(hantro_dev);
+#endif
+
+	spin_lock_irqsave(&owner_lock, flags);
+	if (client->nr_jobs >= HANTRODEC_MAX_JOBS) {
+		spin_unlock_irqrestore(&owner_lock, flags);
+		ret = -EBUSY;
+		goto err;
+	}
+	client->nr_jobs++;
+	job->seqno = ++client->seqno;
+	job->state = DEC_JOB_QUEUED;
+	list_add_tail(&job->node, &client->jobs);
+	list_add_tail(&job->queue, &job_queue);
+	desc.seqno = job->seqno;
+	DispatchDecJobs(dev);
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	/* the job is queued already: if its id is lost, close() frees it */
+	if (copy_to_user(&ujob->seqno, &desc.seqno, sizeof(desc.seqno)))
+		return -EFAULT;
+	return 0;
+
+err:
+	kfree(job);
+	return ret;
+}
+
+/*
+ * Take the job seqno of the client, or any of its jobs if seqno is 0, if
+ * done: returns -EAGAIN while it runs, -EINVAL if there is no such job.
+ */
+static int TakeDecJob(struct dec_client *client, u64 seqno,
+		      struct dec_job **out)
+{
+	struct dec_job *job;
+	unsigned long flags;
+	int ret = -EINVAL;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	list_for_each_entry(job, &client->jobs, node) {
+		if (seqno && job->seqno != seqno)
+			continue;
+		if (job->state != DEC_JOB_DONE) {
+			ret = -EAGAIN;
+			if (seqno)
+				break;
+			continue;
+		}
+		list_del(&job->node);
+		client->nr_jobs--;
+		client->nr_done--;
+		*out = job;
+		ret = 0;
+		break;
+	}
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	return ret;
+}
+
+static long WaitDecJob(hantrodec_t *dev, struct file *filp,
+		       struct hantrodec_job __user *ujob)
+{
+	struct dec_client *client = filp->private_data;
+	struct hantrodec_job desc;
+	struct dec_job *job;
+	long ret;
+
+	if (copy_from_user(&desc, ujob, sizeof(desc)))
+		return -EFAULT;
+
+	ret = TakeDecJob(client, desc.seqno, &job);
+	if (ret == -EAGAIN && !(filp->f_flags & O_NONBLOCK)) {
+		if (wait_event_interruptible(client->wait,
+				(ret = TakeDecJob(client, desc.seqno, &job)) != -EAGAIN))
+			return -ERESTARTSYS;
+	}
+	if (ret)
+		return ret;
+
+	atomic_inc(&irq_tx);
+
+	/* put registers to user space */
+	if (desc.size < job->size ||
+	    copy_to_user(u64_to_user_ptr(desc.regs), job->regs, job->size)) {
+		ret = -EFAULT;
+		goto out;
+	}
+	desc.seqno = job->seqno;
+	desc.core = job->core;
+	desc.status = job->status;
+	if (copy_to_user(ujob, &desc, sizeof(desc)))
+		ret = -EFAULT;
+out:
+	kfree(job);
+	return ret;
+}
+
+static int DecClientBusy(struct dec_client *client)
+{
+	struct dec_job *job;
+	unsigned long flags;
+	int busy = 0;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	list_for_each_entry(job, &client->jobs, node)
+		busy |= job->state == DEC_JOB_RUNNING;
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	return busy;
+}
+
+/* Drop the queued jobs of the client, and wait for the running ones */
+static void FlushDecJobs(struct dec_client *client)
+{
+	struct dec_job *job, *tmp;
+	unsigned long flags;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	list_for_each_entry(job, &client->jobs, node)
+		if (job->state == DEC_JOB_QUEUED)
+			list_del(&job->queue);
+	/* queued jobs are not picked up anymore, only the running ones are left */
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	/* a stuck Core is reset by DecJobTimeout() */
+	wait_event(client->wait, !DecClientBusy(client));
+
+	list_for_each_entry_safe(job, tmp, &client->jobs, node)
+		kfree(job);
+}
+
+static int DecJobsRunning(void)
+{
+	unsigned long flags;
+	int c, running = 0;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	for (c = 0; c < HXDEC_MAX_CORES; c++)
+		running |= core_job[c] != NULL;
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	return running;
+}
+
 /*-------------------------------------------------------------------------
  *Function name   : hantrodec_ioctl
  *Description     : communication method to/from the user space
@@ -1283,6 +1645,12 @@ static long hantrodec_ioctl(struct file *filp, unsigned int cmd, unsigned long a
 		PDEBUG("Get DEC Core_id, format = %li\n", arg);
 		return GetDecCoreID(&hantrodec_data, filp, arg);
 	}
+	case _IOC_NR(HANTRODEC_IOCX_JOB_SUBMIT):
+		return SubmitDecJob(&hantrodec_data, filp,
+				    (struct hantrodec_job __user *)arg);
+	case _IOC_NR(HANTRODEC_IOCX_JOB_WAIT):
+		return WaitDecJob(&hantrodec_data, filp,
+				  (struct hantrodec_job __user *)arg);
 	case _IOC_NR(HANTRODEC_DEBUG_STATUS): {
 		PDEBUG("hantrodec: dec_irq     = 0x%08x\n", dec_irq);
 		PDEBUG("hantrodec: pp_irq      = 0x%08x\n", pp_irq);
@@ -1397,6 +1765,15 @@ static long hantrodec_ioctl32(struct file *filp, unsigned int cmd, unsigned long
  */
 static int hantrodec_open(struct inode *inode, struct file *filp)
 {
+	struct dec_client *client;
+
+	client = kzalloc(sizeof(*client), GFP_KERNEL);
+	if (!client)
+		return -ENOMEM;
+	INIT_LIST_HEAD(&client->jobs);
+	init_waitqueue_head(&client->wait);
+	filp->private_data = client;
+
 	PDEBUG("dev opened\n");
 	hantro_clk_enable(hantro_dev);
 	pm_runtime_get_sync(hantro_dev);
@@ -1417,6 +1794,9 @@ static int hantrodec_release(struct inode *inode, struct file *filp)
 
 	PDEBUG("closing ...\n");
 
+	FlushDecJobs(filp->private_data);
+	kfree(filp->private_data);
+
 	for (n = 0; n < dev->cores; n++) {
 		if (dec_owner[n] == filp) {
 			PDEBUG("releasing dec Core %i lock\n", n);
@@ -1437,6 +1817,29 @@ static int hantrodec_release(struct inode *inode, struct file *filp)
 	return 0;
 }
 
+/*---------------------------------------------------------------------------
+ *Function name   : hantrodec_poll
+ *Description     : readable when a job of the file is done
+ *
+ *Return type     : __poll_t
+ *---------------------------------------------------------------------------
+ */
+static __poll_t hantrodec_poll(struct file *filp, poll_table *wait)
+{
+	struct dec_client *client = filp->private_data;
+	unsigned long flags;
+	__poll_t mask = 0;
+
+	poll_wait(filp, &client->wait, wait);
+
+	spin_lock_irqsave(&owner_lock, flags);
+	if (client->nr_done)
+		mask |= EPOLLIN | EPOLLRDNORM;
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	return mask;
+}
+
 /*---------------------------------------------------------------------------
  *Function name   : hantro_mmap
  *Description     : memory map interface for hantro file operation
@@ -1465,6 +1868,7 @@ static const struct file_operations hantrodec_fops = {
 	.release = hantrodec_release,
 	.unlocked_ioctl = hantrodec_ioctl,
 	.fasync = NULL,
+	.poll = hantrodec_poll,
 	.mmap = hantro_mmap,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = hantrodec_ioctl32,
@@ -1507,8 +1911,16 @@ static int hantrodec_init(struct platform_device *pdev)
 	if (result < 0)
 		goto err;
 
+	/* kept mapped, jobs select the Core from the IRQ handler */
+	blkctl_regs = ioremap(BLK_CTL_BASE, 0x1000);
+	if (!blkctl_regs)
+		pr_warn("hantrodec: failed to ioremap blk_ctl\n");
+
 	memset(dec_owner, 0, sizeof(dec_owner));
 	memset(pp_owner, 0, sizeof(pp_owner));
+	memset(core_job, 0, sizeof(core_job));
+	INIT_DELAYED_WORK(&job_timeout_work[0], DecJobTimeout);
+	INIT_DELAYED_WORK(&job_timeout_work[1], DecJobTimeout);
 
 	sema_init(&dec_core_sem, hantrodec_data.cores-1);
 	sema_init(&pp_core_sem, 1);
@@ -1585,6 +1997,13 @@ static void hantrodec_cleanup(void)
 {
 	hantrodec_t *dev = &hantrodec_data;
 	int n = 0;
+
+	/* no file is open anymore, so no job is left */
+	for (n = 0; n < HXDEC_MAX_CORES; n++)
+		cancel_delayed_work_sync(&job_timeout_work[n]);
+	if (blkctl_regs)
+		iounmap(blkctl_regs);
+
 	/* reset hardware */
 	ResetAsic(dev);
 
@@ -1731,10 +2150,19 @@ irqreturn_t hantrodec_isr(int irq, void *dev_id)
 
 			PDEBUG("decoder IRQ received! Core %d\n", i);
 
-			up(&core_suspend_sem[i]);
-
 			atomic_inc(&irq_rx);
 
+			if (core_job[i]) {
+				/* hand the job back, and start the next one */
+				cancel_delayed_work(&job_timeout_work[i]);
+				FinishDecJob(dev, i, 0);
+				DispatchDecJobs(dev);
+				handled++;
+				continue;
+			}
+
+			up(&core_suspend_sem[i]);
+
 			dec_irq |= (1 << i);
 
 			//wake_up_interruptible_all(&dec_wait_queue);
@@ -1761,25 +2189,31 @@ irqreturn_t hantrodec_isr(int irq, void *dev_id)
  */
 void ResetAsic(hantrodec_t *dev)
 {
-	int i, j;
-	u32 status;
+	int j;
 
-	for (j = 0; j < dev->cores; j++) {
-		status = ioread32(dev->hwregs[j] + HANTRODEC_IRQ_STAT_DEC_OFF);
+	for (j = 0; j < dev->cores; j++)
+		ResetCore(dev, j);
+}
 
-		if (status & HANTRODEC_DEC_E) {
-			/* abort with IRQ disabled */
-			status = HANTRODEC_DEC_ABORT | HANTRODEC_DEC_IRQ_DISABLE;
-			iowrite32(status, dev->hwregs[j] + HANTRODEC_IRQ_STAT_DEC_OFF);
-		}
+static void ResetCore(hantrodec_t *dev, int id)
+{
+	int i;
+	u32 status;
 
-		if (IS_G1(dev->hw_id[j]))
-			/* reset PP */
-			iowrite32(0, dev->hwregs[j] + HANTRO_IRQ_STAT_PP_OFF);
+	status = ioread32(dev->hwregs[id] + HANTRODEC_IRQ_STAT_DEC_OFF);
 
-		for (i = 4; i < dev->iosize[j]; i += 4)
-			iowrite32(0, dev->hwregs[j] + i);
+	if (status & HANTRODEC_DEC_E) {
+		/* abort with IRQ disabled */
+		status = HANTRODEC_DEC_ABORT | HANTRODEC_DEC_IRQ_DISABLE;
+		iowrite32(status, dev->hwregs[id] + HANTRODEC_IRQ_STAT_DEC_OFF);
 	}
+
+	if (IS_G1(dev->hw_id[id]))
+		/* reset PP */
+		iowrite32(0, dev->hwregs[id] + HANTRO_IRQ_STAT_PP_OFF);
+
+	for (i = 4; i < dev->iosize[id]; i += 4)
+		iowrite32(0, dev->hwregs[id] + i);
 }
 
 /*---------------------------------------------------------------------------
@@ -1935,15 +2369,32 @@ static void hantro_dev_remove(struct platform_device *pdev)
 #ifdef CONFIG_PM
 static int hantro_suspend(struct device *dev)
 {
+	unsigned long flags;
+
+	/* stop starting jobs, and let the running ones finish */
+	spin_lock_irqsave(&owner_lock, flags);
+	jobs_suspended = true;
+	spin_unlock_irqrestore(&owner_lock, flags);
+	if (!wait_event_timeout(hw_queue, !DecJobsRunning(),
+				msecs_to_jiffies(HANTRODEC_JOB_TIMEOUT_MS * 2)))
+		pr_err("hantrodec: jobs still running at suspend\n");
+
 	DecStoreRegs(&hantrodec_data);
 	pm_runtime_put_sync_suspend(dev);   //power off
 	return 0;
 }
 static int hantro_resume(struct device *dev)
 {
+	unsigned long flags;
+
 	pm_runtime_get_sync(dev);     //power on
 	hantro_ctrlblk_reset(dev);
 	DecRestoreRegs(&hantrodec_data);
+
+	spin_lock_irqsave(&owner_lock, flags);
+	jobs_suspended = false;
+	DispatchDecJobs(&hantrodec_data);
+	spin_unlock_irqrestore(&owner_lock, flags);
 	return 0;
 }
 static int hantro_runtime_suspend(struct device *dev)
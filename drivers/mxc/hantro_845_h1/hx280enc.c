@@ -73,6 +73,13 @@ static struct clk *hantro_clk_h1_bus;
 
 #include <linux/delay.h>
 #include <linux/compat.h>
+#include <linux/dma-fence.h>
+#include <linux/file.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/sync_file.h>
+#include <linux/workqueue.h>
 
 /* module description */
 MODULE_LICENSE("GPL");
@@ -153,9 +160,65 @@ typedef struct {
 /* dynamic allocation? */
 static hx280enc_t hx280enc_data;
 
+/*
+ * Encoder jobs: instead of reserving the core and waiting for it, clients
+ * may queue register sets, which are started back to back from the IRQ
+ * handler, without a round trip to user space.  Each job comes with a
+ * sync_file fence, signalled once the frame is encoded.  The jobs and the
+ * core they run on are protected by owner_lock.
+ */
+#define HX280ENC_MAX_JOBS		16
+#define HX280ENC_JOB_TIMEOUT_MS		200
+
+enum enc_job_state {
+	ENC_JOB_QUEUED,
+	ENC_JOB_RUNNING,
+	ENC_JOB_DONE,
+};
+
+struct enc_client;
+
+struct enc_job {
+	struct list_head queue; /* in job_queue, while queued */
+	struct list_head node; /* in the client's jobs */
+	struct enc_client *client;
+	enum enc_job_state state;
+	struct dma_fence *fence;
+	u64 seqno;
+	int status;
+	ktime_t submitted;
+	ktime_t started;
+	unsigned long deadline;
+	u32 size;
+	u32 regs[ENC_IO_SIZE/4];
+};
+
+/* per open file */
+struct enc_client {
+	struct list_head jobs;
+	unsigned int nr_jobs;
+	wait_queue_head_t wait;
+	ktime_t opened;
+	struct enc_job_stats stats;
+};
+
+static LIST_HEAD(job_queue);
+static struct enc_job *core_job;
+static bool jobs_suspended;
+
+/* fences signal in seqno order: jobs are queued in that order */
+static DEFINE_MUTEX(job_submit_lock);
+static DEFINE_SPINLOCK(fence_lock);
+static u64 fence_context;
+static u64 fence_seqno;
+
 static int ReserveIO(void);
 static void ReleaseIO(void);
 static void ResetAsic(hx280enc_t *dev);
+static void DispatchEncJobs(hx280enc_t *dev);
+static void EncJobTimeout(struct work_struct *work);
+
+static DECLARE_DELAYED_WORK(job_timeout_work, EncJobTimeout);
 
 #ifdef HX280ENC_DEBUG
 static void dump_regs(unsigned long data);
@@ -312,7 +375,7 @@ static int CheckCoreOccupation(hx280enc_t *dev, struct file *filp)
 	unsigned long flags;
 
 	spin_lock_irqsave(&owner_lock, flags);
-	if (!dev->is_reserved) {
+	if (!dev->is_reserved && !core_job) {
 		dev->is_reserved = 1;
 		dev->filp = filp;
 		ret = 1;
@@ -357,6 +420,9 @@ static void ReleaseEncoder(hx280enc_t *dev, struct file *filp)
 
 	dev->irq_received = 0;
 	dev->irq_status = 0;
+
+	/* queued jobs may use the core now */
+	DispatchEncJobs(dev);
 	spin_unlock_irqrestore(&owner_lock, flags);
 
 	wake_up_interruptible_all(&enc_hw_queue);
@@ -432,6 +498,340 @@ static int hx280enc_read_regs(struct enc_regs_buffer *regs)
 	return ret;
 }
 
+static const char *enc_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "hx280enc";
+}
+
+static const char *enc_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "h1";
+}
+
+static const struct dma_fence_ops enc_fence_ops = {
+	.get_driver_name = enc_fence_get_driver_name,
+	.get_timeline_name = enc_fence_get_timeline_name,
+};
+
+/* called with owner_lock held */
+static void StartEncJob(hx280enc_t *dev, struct enc_job *job)
+{
+	int i;
+
+	list_del(&job->queue);
+	job->state = ENC_JOB_RUNNING;
+	job->started = ktime_get();
+	job->deadline = jiffies + msecs_to_jiffies(HX280ENC_JOB_TIMEOUT_MS);
+	core_job = job;
+
+	/* held while the core runs, for suspend */
+	if (down_trylock(&dev->core_suspend_sem))
+		pr_err("en core suspend sem down error id\n");
+
+	/* write all regs but the id reg[0] and the status reg[1] to hardware */
+	for (i = 2; i < job->size / 4; i++)
+		if (i != 14)
+			writel(job->regs[i], dev->hwregs + i * 4);
+	/* and the enable reg[14] last, which starts the encoder */
+	writel(job->regs[14] | 0x01, dev->hwregs + 14 * 4);
+
+	mod_delayed_work(system_wq, &job_timeout_work,
+			 msecs_to_jiffies(HX280ENC_JOB_TIMEOUT_MS));
+	PDEBUG("started job %llu\n", job->seqno);
+}
+
+/* Start the next queued job if nobody reserved the core. Called with owner_lock held */
+static void DispatchEncJobs(hx280enc_t *dev)
+{
+	if (jobs_suspended || dev->is_reserved || core_job ||
+	    list_empty(&job_queue))
+		return;
+
+	StartEncJob(dev, list_first_entry(&job_queue, struct enc_job, queue));
+}
+
+/* called with owner_lock held */
+static void FinishEncJob(hx280enc_t *dev, int status)
+{
+	struct enc_job *job = core_job;
+	struct enc_client *client = job->client;
+	ktime_t now = ktime_get();
+	u32 irq_status;
+	int i;
+
+	if (status)
+		writel(readl(dev->hwregs + 14 * 4) & (~1), dev->hwregs + 14 * 4);
+
+	/* read register to job, and clear the status bits, as WaitEncReady() */
+	for (i = 0; i < job->size / 4; i++)
+		job->regs[i] = readl(dev->hwregs + i * 4);
+	irq_status = dev->statusShowReg;
+	job->regs[1] = irq_status;
+	if (job->regs[0x4a0/4] & 0x00800000)
+		writel(irq_status, dev->hwregs + 0x04);
+	else
+		writel(irq_status & (~0xf7d), dev->hwregs + 0x04);
+	dev->statusShowReg = readl(dev->hwregs + 0x04);
+
+	core_job = NULL;
+	job->status = status;
+	job->state = ENC_JOB_DONE;
+	client->stats.jobs++;
+	if (status)
+		client->stats.timeouts++;
+	client->stats.busy_ns += ktime_to_ns(ktime_sub(now, job->started));
+	client->stats.queue_ns += ktime_to_ns(ktime_sub(job->started,
+							job->submitted));
+	up(&dev->core_suspend_sem);
+
+	if (status)
+		dma_fence_set_error(job->fence, status);
+	dma_fence_signal(job->fence);
+
+	wake_up_all(&client->wait);
+	/* for ReserveEncoder() and suspend */
+	wake_up_all(&enc_hw_queue);
+}
+
+static void EncJobTimeout(struct work_struct *work)
+{
+	hx280enc_t *dev = &hx280enc_data;
+	unsigned long flags;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	/* the job timed out, not one started since */
+	if (core_job && time_after_eq(jiffies, core_job->deadline)) {
+		pr_err("%s: job %llu timeout !\n", __func__, core_job->seqno);
+		dev->statusShowReg = readl(dev->hwregs + 0x04);
+		FinishEncJob(dev, -ETIMEDOUT);
+		DispatchEncJobs(dev);
+	}
+	spin_unlock_irqrestore(&owner_lock, flags);
+}
+
+static long SubmitEncJob(hx280enc_t *dev, struct file *filp,
+			 struct enc_job_buffer __user *ujob)
+{
+	struct enc_client *client = filp->private_data;
+	struct enc_job_buffer desc;
+	struct sync_file *sync_file;
+	struct enc_job *job;
+	unsigned long flags;
+	int fd;
+	long ret;
+
+	if (copy_from_user(&desc, ujob, sizeof(desc)))
+		return -EFAULT;
+
+	/* all of the registers, the core may have run another stream before */
+	if (desc.core_id != 0 || desc.size < dev->iosize)
+		return -EINVAL;
+
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job)
+		return -ENOMEM;
+	job->size = dev->iosize;
+	if (copy_from_user(job->regs, u64_to_user_ptr(desc.regs), job->size)) {
+		ret = -EFAULT;
+		goto err;
+	}
+
+	job->fence = kzalloc(sizeof(*job->fence), GFP_KERNEL);
+	if (!job->fence) {
+		ret = -ENOMEM;
+		goto err;
+	}
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		ret = fd;
+		goto err_fence;
+	}
+
+	mutex_lock(&job_submit_lock);
+	dma_fence_init(job->fence, &enc_fence_ops, &fence_lock, fence_context,
+		       ++fence_seqno);
+	/* only SUBMIT adds jobs, and it is serialized */
+	if (READ_ONCE(client->nr_jobs) >= HX280ENC_MAX_JOBS) {
+		ret = -EBUSY;
+		goto err_unlock;
+	}
+	sync_file = sync_file_create(job->fence);
+	if (!sync_file) {
+		ret = -ENOMEM;
+		goto err_unlock;
+	}
+	job->client = client;
+	job->seqno = job->fence->seqno;
+	job->submitted = ktime_get();
+
+	spin_lock_irqsave(&owner_lock, flags);
+	client->nr_jobs++;
+	job->state = ENC_JOB_QUEUED;
+	list_add_tail(&job->node, &client->jobs);
+	list_add_tail(&job->queue, &job_queue);
+	desc.seqno = job->seqno;
+	DispatchEncJobs(dev);
+	spin_unlock_irqrestore(&owner_lock, flags);
+	mutex_unlock(&job_submit_lock);
+
+	fd_install(fd, sync_file->file);
+	desc.fence_fd = fd;
+
+	/* the job is queued already: if its id is lost, close() frees it */
+	if (copy_to_user(ujob, &desc, sizeof(desc)))
+		return -EFAULT;
+	return 0;
+
+err_unlock:
+	mutex_unlock(&job_submit_lock);
+	dma_fence_put(job->fence);
+	put_unused_fd(fd);
+	goto err;
+err_fence:
+	kfree(job->fence);
+err:
+	kfree(job);
+	return ret;
+}
+
+static void FreeEncJob(struct enc_job *job)
+{
+	dma_fence_put(job->fence);
+	kfree(job);
+}
+
+/*
+ * Take the job seqno of the client, or any of its jobs if seqno is 0, if
+ * done: returns -EAGAIN while it runs, -EINVAL if there is no such job.
+ */
+static int TakeEncJob(struct enc_client *client, u64 seqno,
+		      struct enc_job **out)
+{
+	struct enc_job *job;
+	unsigned long flags;
+	int ret = -EINVAL;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	list_for_each_entry(job, &client->jobs, node) {
+		if (seqno && job->seqno != seqno)
+			continue;
+		if (job->state != ENC_JOB_DONE) {
+			ret = -EAGAIN;
+			if (seqno)
+				break;
+			continue;
+		}
+		list_del(&job->node);
+		client->nr_jobs--;
+		*out = job;
+		ret = 0;
+		break;
+	}
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	return ret;
+}
+
+static long WaitEncJob(struct file *filp, struct enc_job_buffer __user *ujob)
+{
+	struct enc_client *client = filp->private_data;
+	struct enc_job_buffer desc;
+	struct enc_job *job;
+	long ret;
+
+	if (copy_from_user(&desc, ujob, sizeof(desc)))
+		return -EFAULT;
+
+	ret = TakeEncJob(client, desc.seqno, &job);
+	if (ret == -EAGAIN && !(filp->f_flags & O_NONBLOCK)) {
+		if (wait_event_interruptible(client->wait,
+				(ret = TakeEncJob(client, desc.seqno, &job)) != -EAGAIN))
+			return -ERESTARTSYS;
+	}
+	if (ret)
+		return ret;
+
+	/* put registers to user space */
+	if (desc.size < job->size ||
+	    copy_to_user(u64_to_user_ptr(desc.regs), job->regs, job->size)) {
+		ret = -EFAULT;
+		goto out;
+	}
+	desc.seqno = job->seqno;
+	desc.status = job->status;
+	if (copy_to_user(ujob, &desc, sizeof(desc)))
+		ret = -EFAULT;
+out:
+	FreeEncJob(job);
+	return ret;
+}
+
+static long GetEncJobStats(struct file *filp, struct enc_job_stats __user *ustats)
+{
+	struct enc_client *client = filp->private_data;
+	struct enc_job_stats stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	stats = client->stats;
+	spin_unlock_irqrestore(&owner_lock, flags);
+	stats.elapsed_ns = ktime_to_ns(ktime_sub(ktime_get(), client->opened));
+
+	if (copy_to_user(ustats, &stats, sizeof(stats)))
+		return -EFAULT;
+	return 0;
+}
+
+static int EncClientBusy(struct enc_client *client)
+{
+	struct enc_job *job;
+	unsigned long flags;
+	int busy = 0;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	list_for_each_entry(job, &client->jobs, node)
+		busy |= job->state == ENC_JOB_RUNNING;
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	return busy;
+}
+
+/* Cancel the queued jobs of the client, and wait for the running one */
+static void FlushEncJobs(struct enc_client *client)
+{
+	struct enc_job *job, *tmp;
+	unsigned long flags;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	list_for_each_entry(job, &client->jobs, node) {
+		if (job->state != ENC_JOB_QUEUED)
+			continue;
+		list_del(&job->queue);
+		job->state = ENC_JOB_DONE;
+		dma_fence_set_error(job->fence, -ECANCELED);
+		dma_fence_signal(job->fence);
+	}
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	/* a stuck core is stopped by EncJobTimeout() */
+	wait_event(client->wait, !EncClientBusy(client));
+
+	list_for_each_entry_safe(job, tmp, &client->jobs, node)
+		FreeEncJob(job);
+}
+
+static int EncJobRunning(void)
+{
+	unsigned long flags;
+	int running;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	running = core_job != NULL;
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	return running;
+}
+
 static long hx280enc_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
 	int err = 0;
@@ -537,6 +937,13 @@ static long hx280enc_ioctl(struct file *filp, unsigned int cmd, unsigned long ar
 
 		break;
 	}
+	case _IOC_NR(HX280ENC_IOCX_JOB_SUBMIT):
+		return SubmitEncJob(&hx280enc_data, filp,
+				    (struct enc_job_buffer __user *)arg);
+	case _IOC_NR(HX280ENC_IOCX_JOB_WAIT):
+		return WaitEncJob(filp, (struct enc_job_buffer __user *)arg);
+	case _IOC_NR(HX280ENC_IOCG_JOB_STATS):
+		return GetEncJobStats(filp, (struct enc_job_stats __user *)arg);
 	default:
 		break;
 	}
@@ -547,8 +954,15 @@ static int hx280enc_open(struct inode *inode, struct file *filp)
 {
 	int result = 0;
 	hx280enc_t *dev = &hx280enc_data;
+	struct enc_client *client;
 
-	filp->private_data = (void *) dev;
+	client = kzalloc(sizeof(*client), GFP_KERNEL);
+	if (!client)
+		return -ENOMEM;
+	INIT_LIST_HEAD(&client->jobs);
+	init_waitqueue_head(&client->wait);
+	client->opened = ktime_get();
+	filp->private_data = client;
 
 #ifndef VSI
 	hantro_h1_clk_enable(dev->dev);
@@ -561,13 +975,16 @@ static int hx280enc_open(struct inode *inode, struct file *filp)
 
 static int hx280enc_release(struct inode *inode, struct file *filp)
 {
-	hx280enc_t *dev = (hx280enc_t *) filp->private_data;
+	hx280enc_t *dev = &hx280enc_data;
 	unsigned long flags;
 #ifdef HX280ENC_DEBUG
 	dump_regs((unsigned long) dev); /* dump the regs */
 #endif
 
 	PDEBUG("dev closed\n");
+	FlushEncJobs(filp->private_data);
+	kfree(filp->private_data);
+
 	spin_lock_irqsave(&owner_lock, flags);
 	if (dev->is_reserved == 1 && dev->filp == filp) {
 		dev->filp = NULL;
@@ -575,6 +992,7 @@ static int hx280enc_release(struct inode *inode, struct file *filp)
 		dev->irq_received = 0;
 		dev->irq_status = 0;
 		PDEBUG("release reserved core\n");
+		DispatchEncJobs(dev);
 	}
 	spin_unlock_irqrestore(&owner_lock, flags);
 	wake_up_interruptible_all(&enc_hw_queue);
@@ -691,6 +1109,7 @@ static int __init hx280enc_init(void)
 	hx280enc_data.async_queue = NULL;
 	hx280enc_data.hwregs = NULL;
 	sema_init(&hx280enc_data.core_suspend_sem, 1);
+	fence_context = dma_fence_context_alloc(1);
 
 	result = register_chrdev(hx280enc_major, "hx280enc", &hx280enc_fops);
 	if (result < 0) {
@@ -745,6 +1164,9 @@ static void hx280enc_cleanup(void)
 static void __exit hx280enc_cleanup(void)
 #endif
 {
+	/* no file is open anymore, so no job is left */
+	cancel_delayed_work_sync(&job_timeout_work);
+
 	writel(0, hx280enc_data.hwregs + 0x38); /* disable HW */
 	writel(0, hx280enc_data.hwregs + 0x04); /* clear enc IRQ */
 
@@ -817,7 +1239,7 @@ irqreturn_t hx280enc_isr(int irq, void *dev_id)
 	u32 is_write1_clr;
 
 	spin_lock_irqsave(&owner_lock, flags);
-	if (!dev->is_reserved)	{
+	if (!dev->is_reserved && !core_job)	{
 		spin_unlock_irqrestore(&owner_lock, flags);
 		return IRQ_HANDLED;
 	}
@@ -843,6 +1265,18 @@ irqreturn_t hx280enc_isr(int irq, void *dev_id)
 			return IRQ_HANDLED;
 		}
 
+		spin_lock_irqsave(&owner_lock, flags);
+		if (core_job) {
+			/* hand the job back, and start the next one */
+			cancel_delayed_work(&job_timeout_work);
+			FinishEncJob(dev, 0);
+			DispatchEncJobs(dev);
+			spin_unlock_irqrestore(&owner_lock, flags);
+			PDEBUG("IRQ handled!\n");
+			return IRQ_HANDLED;
+		}
+		spin_unlock_irqrestore(&owner_lock, flags);
+
 		if (irq_status & 0x04) {
 			spin_lock_irqsave(&owner_lock, flags);
 			dev->irq_received = 1;
@@ -1002,11 +1436,20 @@ static void hantro_h1_dev_remove(struct platform_device *pdev)
 
 static int hx280enc_suspend(struct device *dev)
 {
+	unsigned long flags;
 	int ret = 0;
 	int i;
 
 	PDEBUG("%s start..\n", __func__);
 
+	/* stop starting jobs, and let the running one finish */
+	spin_lock_irqsave(&owner_lock, flags);
+	jobs_suspended = true;
+	spin_unlock_irqrestore(&owner_lock, flags);
+	if (!wait_event_timeout(enc_hw_queue, !EncJobRunning(),
+				msecs_to_jiffies(HX280ENC_JOB_TIMEOUT_MS * 2)))
+		pr_err("h280xenc job still running at suspend\n");
+
 	if (hx280enc_data.is_reserved == 0)
 		return ret;
 
@@ -1027,20 +1470,24 @@ static int hx280enc_suspend(struct device *dev)
 
 static int hx280enc_resume(struct device *dev)
 {
+	unsigned long flags;
 	int ret = 0;
 	int i;
 
 	PDEBUG("%s start..\n", __func__);
 
-	if (hx280enc_data.is_reserved == 0 || hx280enc_data.reg_corrupt == 0)
-		return ret;
-
-	if (hx280enc_data.irq_status & 0x04) {
+	if (hx280enc_data.is_reserved && hx280enc_data.reg_corrupt &&
+	    (hx280enc_data.irq_status & 0x04)) {
 		for (i = 0; i < hx280enc_data.iosize; i += 4)
 			writel(hx280enc_data.mirror_regs[i/4], hx280enc_data.hwregs + i);
 		hx280enc_data.reg_corrupt = 0;
 	}
 
+	spin_lock_irqsave(&owner_lock, flags);
+	jobs_suspended = false;
+	DispatchEncJobs(&hx280enc_data);
+	spin_unlock_irqrestore(&owner_lock, flags);
+
 	return ret;
 }
 
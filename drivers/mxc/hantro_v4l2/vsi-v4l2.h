@@ -73,6 +73,10 @@ struct vsi_v4l2_dev_info {
 
 /* user space daemno should use this ioctl to initial HW info to v4l2 driver */
 #define VSI_IOCTL_CMD_INITDEV		_IOW(VSIV4L2_IOCTL_BASE, 45, struct vsi_v4l2_dev_info)
+/* switch message passing to the shared memory rings, see struct vsi_v4l2_ring */
+#define VSI_IOCTL_CMD_INITRING		_IOWR(VSIV4L2_IOCTL_BASE, 46, struct vsi_v4l2_ring_info)
+/* tell v4l2 driver new responses are in the rsp ring and/or cmds were consumed */
+#define VSI_IOCTL_CMD_RINGNOTIFY	_IO(VSIV4L2_IOCTL_BASE, 47)
 /* end of daemon ioctl id definitions */
 
 /*these two enum have same sequence, identical to the table vsi_coded_fmt[] in vsi-v4l2-config.c */
@@ -649,6 +653,33 @@ struct vsi_v4l2_msg {
 	} params;
 };
 
+/*
+ * Optional shared memory message rings replacing read()/write() on the
+ * daemon device. After VSI_IOCTL_CMD_INITRING, daemon mmaps info.size
+ * bytes at info.offset of the daemon device: the cmd ring (driver to
+ * daemon) comes first, the rsp ring (daemon to driver) right after it.
+ * Indexes are free running; only the producer moves head, only the
+ * consumer moves tail. Driver signals info.eventfd whenever it queues
+ * cmds, daemon calls VSI_IOCTL_CMD_RINGNOTIFY once per batch of
+ * responses, and also after consuming cmds when the cmd ring was full.
+ * Cmds queued before the rings are set up must still be read() out.
+ */
+#define VSI_RING_SLOTS		32
+
+struct vsi_v4l2_ring {
+	u32 head;
+	u32 tail;
+	u32 slots;
+	u32 reserved[13];	/* keep indexes on their own cache line */
+	struct vsi_v4l2_msg msg[VSI_RING_SLOTS];
+};
+
+struct vsi_v4l2_ring_info {
+	s32 eventfd;		/* in */
+	u32 size;		/* out */
+	u64 offset;		/* out */
+};
+
 #endif	//#ifndef VSI_V4L2_H
 
 
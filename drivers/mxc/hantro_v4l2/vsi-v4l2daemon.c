@@ -31,6 +31,8 @@
 #include <linux/string.h>
 #include <linux/io.h>
 #include <linux/atomic.h>
+#include <linux/eventfd.h>
+#include <linux/gfp.h>
 #include <media/v4l2-device.h>
 #include <media/v4l2-dev.h>
 #include <media/v4l2-ioctl.h>
@@ -66,6 +68,19 @@ static struct mutex  ret_lock;
 static s32 v4l2_fn;
 static struct mutex instance_lock;
 
+/* shared memory rings, cmd side protected by cmd_lock, rsp side by the daemon fd */
+static struct {
+	struct vsi_v4l2_ring *cmd;
+	struct vsi_v4l2_ring *rsp;
+	size_t size;
+	u32 cmd_head;		/* private copies, daemon can't corrupt them */
+	u32 cmd_tail;
+	u32 rsp_tail;
+	struct eventfd_ctx *evt;
+	struct file *owner;
+} rings;
+static DECLARE_WAIT_QUEUE_HEAD(ring_queue);
+
 /*************************   for bandwith calc ***************************/
 static u64 accubytes;
 static struct timespec64 lasttime;
@@ -213,6 +228,30 @@ static int getRet(unsigned long seqid, int *error, s32 *retflag)
 	return match;
 }
 
+/* only looks at private indexes, safe to call without cmd_lock */
+static bool ring_hasspace(void)
+{
+	return !READ_ONCE(rings.owner) ||
+		READ_ONCE(rings.cmd_head) - READ_ONCE(rings.cmd_tail) < VSI_RING_SLOTS;
+}
+
+/* called with cmd_lock held and room in the cmd ring */
+static void ring_postcmd(struct vsi_v4l2_msg_hdr *msghdr, void *msgcontent, int msgsize)
+{
+	struct vsi_v4l2_msg *slot;
+
+	slot = &rings.cmd->msg[rings.cmd_head % VSI_RING_SLOTS];
+	memcpy((void *)slot, (void *)msghdr, sizeof(struct vsi_v4l2_msg_hdr));
+	if (msgsize > 0)
+		memcpy((void *)&slot->params, msgcontent, msgsize);
+	accubytes += sizeof(struct vsi_v4l2_msg_hdr) + msgsize;
+
+	/* slot content must be visible before daemon sees the new head */
+	WRITE_ONCE(rings.cmd_head, rings.cmd_head + 1);
+	smp_store_release(&rings.cmd->head, rings.cmd_head);
+	eventfd_signal(rings.evt);
+}
+
 /* send msg from v4l2 driver to user space daemon */
 static int vsi_v4l2_sendcmd(
 	enum v4l2_daemon_cmd_id cmdid,
@@ -231,11 +270,32 @@ static int vsi_v4l2_sendcmd(
 	if (atomic_read(&daemon_fn) <= 0)
 		return DAEMON_ERR_DAEMON_MISSING;
 
+retry:
 	if (mutex_lock_interruptible(&cmd_lock))
 		return -EBUSY;
 
 	v4l2_klog(LOGLVL_VERBOSE, "%s:%lx:%d:%x", __func__, instid, cmdid, param_type);
-	if (msgsize == 0) {
+	if (rings.cmd) {
+		struct vsi_v4l2_msg_hdr hdr = {
+			.size = msgsize,
+			.inst_id = instid,
+			.cmd_id = cmdid,
+			.codec_fmt = codecformat,
+			.param_type = param_type,
+		};
+
+		if (!ring_hasspace()) {
+			mutex_unlock(&cmd_lock);
+			if (wait_event_interruptible(ring_queue, ring_hasspace() ||
+					atomic_read(&daemon_fn) <= 0))
+				return -ERESTARTSYS;
+			if (atomic_read(&daemon_fn) <= 0)
+				return DAEMON_ERR_DAEMON_MISSING;
+			goto retry;
+		}
+		mid = hdr.seq_id = g_seqid;
+		ring_postcmd(&hdr, msgcontent, msgsize);
+	} else if (msgsize == 0) {
 		msghdr = kzalloc(sizeof(struct vsi_v4l2_msg_hdr), GFP_KERNEL);
 		if (!msghdr) {
 			mutex_unlock(&cmd_lock);
@@ -284,6 +344,119 @@ static int vsi_v4l2_sendcmd(
 	return error;
 }
 
+static int ring_init(struct file *filp, unsigned long arg)
+{
+	struct vsi_v4l2_ring_info info;
+	struct eventfd_ctx *evt;
+	size_t size = PAGE_ALIGN(2 * sizeof(struct vsi_v4l2_ring));
+	void *base;
+
+	if (copy_from_user((void *)&info, (void __user *)arg, sizeof(info)) != 0)
+		return -EFAULT;
+
+	evt = eventfd_ctx_fdget(info.eventfd);
+	if (IS_ERR(evt))
+		return PTR_ERR(evt);
+
+	/* physically contiguous so that it is mapped through its pfn like other buffers */
+	base = alloc_pages_exact(size, GFP_KERNEL | __GFP_ZERO);
+	if (!base) {
+		eventfd_ctx_put(evt);
+		return -ENOMEM;
+	}
+
+	mutex_lock(&cmd_lock);
+	if (rings.cmd) {
+		mutex_unlock(&cmd_lock);
+		free_pages_exact(base, size);
+		eventfd_ctx_put(evt);
+		return -EBUSY;
+	}
+	rings.cmd = base;
+	rings.rsp = base + sizeof(struct vsi_v4l2_ring);
+	rings.cmd->slots = VSI_RING_SLOTS;
+	rings.rsp->slots = VSI_RING_SLOTS;
+	rings.size = size;
+	rings.cmd_head = 0;
+	rings.cmd_tail = 0;
+	rings.rsp_tail = 0;
+	rings.evt = evt;
+	rings.owner = filp;
+	mutex_unlock(&cmd_lock);
+
+	info.size = size;
+	info.offset = virt_to_phys(base);
+	if (copy_to_user((void __user *)arg, (void *)&info, sizeof(info)) != 0)
+		return -EFAULT;
+
+	v4l2_klog(LOGLVL_BRIEF, "%s: %zu bytes, %d slots", __func__, size, VSI_RING_SLOTS);
+	return 0;
+}
+
+/* runs on daemon release only, when the rings can't be mapped anymore */
+static void ring_release(struct file *filp)
+{
+	mutex_lock(&cmd_lock);
+	if (rings.owner != filp) {
+		mutex_unlock(&cmd_lock);
+		return;
+	}
+	free_pages_exact(rings.cmd, rings.size);
+	eventfd_ctx_put(rings.evt);
+	rings.cmd = NULL;
+	rings.rsp = NULL;
+	rings.evt = NULL;
+	rings.owner = NULL;
+	mutex_unlock(&cmd_lock);
+	wake_up_interruptible_all(&ring_queue);
+}
+
+static void vsi_v4l2_dispatchmsg(struct vsi_v4l2_msg *pmsg);
+
+static int ring_drainrsp(struct file *filp)
+{
+	struct vsi_v4l2_ring *ring = rings.rsp;
+	struct vsi_v4l2_msg *pmsg;
+	u32 head, tail;
+
+	if (!ring || rings.owner != filp)
+		return -EINVAL;
+
+	/* pick up cmds the daemon consumed, ignoring a bogus tail */
+	tail = READ_ONCE(rings.cmd->tail);
+	if (READ_ONCE(rings.cmd_head) - tail <= VSI_RING_SLOTS)
+		WRITE_ONCE(rings.cmd_tail, tail);
+
+	/* see the daemon's slot content only after head */
+	head = smp_load_acquire(&ring->head);
+	if (head - rings.rsp_tail > VSI_RING_SLOTS)
+		return -EINVAL;
+
+	while (rings.rsp_tail != head) {
+		pmsg = kmalloc(sizeof(struct vsi_v4l2_msg), GFP_KERNEL);
+		if (!pmsg)
+			break;
+		memcpy((void *)pmsg, (void *)&ring->msg[rings.rsp_tail % VSI_RING_SLOTS],
+			sizeof(struct vsi_v4l2_msg));
+		rings.rsp_tail++;
+		if (v4l2_fn == 0) {
+			kfree(pmsg);
+			continue;
+		}
+		if (pmsg->size < 0 || pmsg->size > sizeof(pmsg->params)) {
+			v4l2_klog(LOGLVL_ERROR, "bad ring msg size %d", pmsg->size);
+			kfree(pmsg);
+			continue;
+		}
+		vsi_v4l2_dispatchmsg(pmsg);
+	}
+	smp_store_release(&ring->tail, rings.rsp_tail);
+
+	/* daemon may also have consumed cmds */
+	wake_up_interruptible_all(&ring_queue);
+	return 0;
+}
+
 /* ioctl handler from daemon dev */
 static long vsi_v4l2_daemon_ioctl(
 	struct file *filp,
@@ -301,6 +474,10 @@ static long vsi_v4l2_daemon_ioctl(
 		}
 		vsiv4l2_set_hwinfo(&hwinfo);
 		break;
+	case _IOC_NR(VSI_IOCTL_CMD_INITRING):
+		return ring_init(filp, arg);
+	case _IOC_NR(VSI_IOCTL_CMD_RINGNOTIFY):
+		return ring_drainrsp(filp);
 	default:
 		return -EINVAL;
 	}
@@ -699,7 +876,7 @@ static int vsi_handle_daemonmsg(struct vsi_v4l2_msg *pmsg)
 
 static ssize_t v4l2_msg_write(struct file *fh, const char __user *buf, size_t size, loff_t *offset)
 {
-	int ret = -1, msgsize;
+	int msgsize;
 	struct vsi_v4l2_msg *pmsg;
 
 	if (v4l2_fn == 0)
@@ -730,29 +907,36 @@ static ssize_t v4l2_msg_write(struct file *fh, const char __user *buf, size_t si
 			goto error;
 		}
 	}
+	vsi_v4l2_dispatchmsg(pmsg);
+
+error:
+	return size;
+}
+
+/* hand a daemon msg to its waiter or handler, takes ownership of pmsg */
+static void vsi_v4l2_dispatchmsg(struct vsi_v4l2_msg *pmsg)
+{
+	int ret;
+
 	v4l2_klog(LOGLVL_VERBOSE, "get msg  id = %d, flag = %x, seqid = %llx, err = %d",
 		pmsg->cmd_id, pmsg->param_type, pmsg->seq_id, pmsg->error);
-	accubytes += sizeof(struct vsi_v4l2_msg_hdr) + msgsize;
+	accubytes += sizeof(struct vsi_v4l2_msg_hdr) + pmsg->size;
 
 	if (pmsg->seq_id == (u64)NO_RESPONSE_SEQID) {
 		vsi_handle_daemonmsg(pmsg);
 		kfree(pmsg);
-		return size;
+		return;
 	}
 	if (mutex_lock_interruptible(&ret_lock)) {
 		kfree(pmsg);
-		return size;
+		return;
 	}
 	ret = idr_alloc(retarray, (void *)pmsg, 1, 0, GFP_KERNEL);
 	mutex_unlock(&ret_lock);
 	if (ret < 0)
 		kfree(pmsg);
-
-error:
-	if (ret >= 0)
+	else
 		wake_up_interruptible_all(&ret_queue);
-
-	return size;
 }
 
 static int v4l2_daemon_open(struct inode *inode,	struct file *filp)
@@ -768,6 +952,7 @@ static int v4l2_daemon_open(struct inode *inode,	struct file *filp)
 
 static int v4l2_daemon_release(struct inode *inode, struct file *filp)
 {
+	ring_release(filp);
 	atomic_dec(&daemon_fn);
 	v4l2_klog(LOGLVL_BRIEF, "%s:%d", __func__, atomic_read(&daemon_fn));
 	if (atomic_read(&daemon_fn) <= 0) {
@@ -799,6 +984,14 @@ static int vsi_v4l2_mmap(
 	if (!(vma->vm_flags & VM_MAYSHARE))
 		return -EPERM;
 
+	/* the rings are normal cacheable memory, keep the kernel attributes */
+	if (rings.cmd && vma->vm_pgoff == PHYS_PFN(virt_to_phys(rings.cmd))) {
+		if (size > rings.size)
+			return -EINVAL;
+		return remap_pfn_range(vma, vma->vm_start, vma->vm_pgoff, size,
+					vma->vm_page_prot) ? -EAGAIN : 0;
+	}
+
 	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
 
 	return remap_pfn_range(vma, vma->vm_start, vma->vm_pgoff,
@@ -80,6 +80,10 @@
 #define HX280ENC_IOC_WRITE_REGS     _IOW(HX280ENC_IOC_MAGIC, 20, struct enc_regs_buffer *)
 #define HX280ENC_IOC_READ_REGS      _IOR(HX280ENC_IOC_MAGIC, 21, struct enc_regs_buffer *)
 
+#define HX280ENC_IOCX_JOB_SUBMIT    _IOWR(HX280ENC_IOC_MAGIC, 22, struct enc_job_buffer)
+#define HX280ENC_IOCX_JOB_WAIT      _IOWR(HX280ENC_IOC_MAGIC, 23, struct enc_job_buffer)
+#define HX280ENC_IOCG_JOB_STATS    _IOR(HX280ENC_IOC_MAGIC, 24, struct enc_job_stats)
+
 #define HX280ENC_IOC_MAXNR 30
 
 typedef struct {
@@ -97,4 +101,26 @@ struct enc_regs_buffer {
 	u32 *reserved;
 };
 
+/*
+ * An encoder job: the kernel starts it once the core is free, and gives the
+ * registers back once the frame is encoded.
+ */
+struct enc_job_buffer {
+	u32 core_id; /* id of the core to run the job on */
+	u32 size; /* size of register space */
+	u64 regs; /* pointer to user registers, read back on completion */
+	u64 seqno; /* job id, from SUBMIT; job to wait for or 0 for any, to WAIT */
+	s32 fence_fd; /* sync_file signalled on completion, from SUBMIT */
+	s32 status; /* 0, or -ETIMEDOUT if the core had to be stopped */
+};
+
+/* what the jobs of an open file used the cores for */
+struct enc_job_stats {
+	u64 jobs; /* jobs completed */
+	u64 timeouts; /* of which timed out */
+	u64 busy_ns; /* time the cores ran the jobs */
+	u64 queue_ns; /* time the jobs waited for a core */
+	u64 elapsed_ns; /* time since the file was opened */
+};
+
 #endif /* !_HX280ENC_H_ */
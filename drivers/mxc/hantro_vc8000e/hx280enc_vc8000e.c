@@ -53,7 +53,14 @@
 #include <linux/vmalloc.h>
 #include <linux/timer.h>
 #include <linux/compat.h>
+#include <linux/dma-fence.h>
+#include <linux/file.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
+#include <linux/sync_file.h>
+#include <linux/workqueue.h>
 
 /* our own stuff */
 #include "hx280enc.h"
@@ -102,6 +109,49 @@ static CORE_CONFIG core_array[] = {
 
 /***************************TYPE AND FUNCTION DECLARATION****************/
 
+/*
+ * Encoder jobs: instead of reserving a core and waiting for it, clients may
+ * queue register sets for a core, which are started back to back from the
+ * IRQ handler, without a round trip to user space.  Each job comes with a
+ * sync_file fence, signalled once the frame is encoded.  The jobs and the
+ * cores they run on are protected by owner_lock.
+ */
+#define HX280ENC_MAX_JOBS		16
+#define HX280ENC_JOB_TIMEOUT_MS		200
+
+enum enc_job_state {
+	ENC_JOB_QUEUED,
+	ENC_JOB_RUNNING,
+	ENC_JOB_DONE,
+};
+
+struct enc_client;
+
+struct enc_job {
+	struct list_head queue; /* in the job_queue of its core, while queued */
+	struct list_head node; /* in the client's jobs */
+	struct enc_client *client;
+	enum enc_job_state state;
+	struct dma_fence *fence;
+	u64 seqno;
+	u32 core;
+	int status;
+	ktime_t submitted;
+	ktime_t started;
+	unsigned long deadline;
+	u32 size;
+	u32 regs[CORE_0_IO_SIZE/4];
+};
+
+/* per open file */
+struct enc_client {
+	struct list_head jobs;
+	unsigned int nr_jobs;
+	wait_queue_head_t wait;
+	ktime_t opened;
+	struct enc_job_stats stats;
+};
+
 /* here's all the must remember stuff */
 typedef struct {
 	CORE_CONFIG  core_cfg; //config of each core,such as base addr, irq,etc
@@ -119,6 +169,11 @@ typedef struct {
 	struct semaphore core_suspend_sem;
 	u32 reg_corrupt;
 	struct fasync_struct *async_queue;
+	struct list_head job_queue; //jobs waiting for this core
+	struct enc_job *job; //job running on this core
+	struct delayed_work job_timeout;
+	u64 fence_context; //fences signal in seqno order on each core
+	u64 fence_seqno;
 #ifndef VSI
 	struct device *dev;
 #endif
@@ -128,6 +183,8 @@ static int ReserveIO(void);
 static void ReleaseIO(void);
 static void ResetAsic(hantroenc_t *dev);
 static int CheckCoreOccupation(hantroenc_t *dev, struct file *filp);
+static void DispatchEncJobs(hantroenc_t *dev);
+static void EncJobTimeout(struct work_struct *work);
 
 #ifdef hantroenc_DEBUG
 static void dump_regs(unsigned long data);
@@ -152,6 +209,11 @@ static hantroenc_t *hantroenc_data;
 static struct class *hantro_enc_class;
 static struct device *hantro_enc_dev;
 
+static bool jobs_suspended;
+/* jobs are queued in the order they take their seqno */
+static DEFINE_MUTEX(job_submit_lock);
+static DEFINE_SPINLOCK(fence_lock);
+
 /******************************************************************************/
 #ifndef VSI
 static int hantro_vc8000e_clk_enable(struct device *dev)
@@ -284,7 +346,7 @@ static int CheckCoreOccupation(hantroenc_t *dev, struct file *filp)
 	unsigned long flags;
 
 	spin_lock_irqsave(&owner_lock, flags);
-	if (!dev->is_reserved) {
+	if (!dev->is_reserved && !dev->job) {
 		dev->is_reserved = 1;
 		dev->filp = filp;
 		ret = 1;
@@ -384,6 +446,8 @@ static void ReleaseEncoder(hantroenc_t *dev, u32 *core_info, struct file *filp)
 				dev[core_id].irq_received = 0;
 				dev[core_id].irq_status = 0;
 				dev[core_id].reg_corrupt = 0;
+				/* queued jobs may use the core now */
+				DispatchEncJobs(&dev[core_id]);
 			} else if (dev[core_id].filp != filp)
 				pr_err("WARNING: trying to release core reserved by another instance\n");
 
@@ -461,6 +525,347 @@ static int hantroenc_read_regs(struct enc_regs_buffer *regs)
 	return ret;
 }
 
+static const char *enc_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "hx280enc";
+}
+
+static const char *enc_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "vc8000e";
+}
+
+static const struct dma_fence_ops enc_fence_ops = {
+	.get_driver_name = enc_fence_get_driver_name,
+	.get_timeline_name = enc_fence_get_timeline_name,
+};
+
+/* called with owner_lock held */
+static void StartEncJob(hantroenc_t *dev, struct enc_job *job)
+{
+	u32 i;
+
+	list_del(&job->queue);
+	job->state = ENC_JOB_RUNNING;
+	job->started = ktime_get();
+	job->deadline = jiffies + msecs_to_jiffies(HX280ENC_JOB_TIMEOUT_MS);
+	dev->job = job;
+
+	/* held while the core runs, for suspend */
+	if (down_trylock(&dev->core_suspend_sem))
+		pr_err("%s: core %d suspend sem down error\n", __func__, dev->core_id);
+
+	/* write all regs but the id reg[0] and the status reg[1] to hardware */
+	for (i = 2; i < job->size / 4; i++)
+		if (i != 5)
+			iowrite32(job->regs[i], dev->hwregs + i * 4);
+	/* and the enable reg[5] last, which starts the encoder */
+	iowrite32(job->regs[5] | 0x01, dev->hwregs + 0x14);
+
+	mod_delayed_work(system_wq, &dev->job_timeout,
+			 msecs_to_jiffies(HX280ENC_JOB_TIMEOUT_MS));
+	PDEBUG("started job %llu on core %d\n", job->seqno, dev->core_id);
+}
+
+/* Start the next queued job if nobody reserved the core. Called with owner_lock held */
+static void DispatchEncJobs(hantroenc_t *dev)
+{
+	if (jobs_suspended || dev->is_reserved || dev->job ||
+	    list_empty(&dev->job_queue))
+		return;
+
+	StartEncJob(dev, list_first_entry(&dev->job_queue, struct enc_job, queue));
+}
+
+/* called with owner_lock held */
+static void FinishEncJob(hantroenc_t *dev, u32 irq_status, int status)
+{
+	struct enc_job *job = dev->job;
+	struct enc_client *client = job->client;
+	ktime_t now = ktime_get();
+	u32 i;
+
+	for (i = 0; i < job->size / 4; i++)
+		job->regs[i] = ioread32(dev->hwregs + i * 4);
+	/* the status before it was cleared, as HX280ENC_IOCG_CORE_WAIT gives it */
+	job->regs[1] = irq_status;
+
+	dev->job = NULL;
+	job->status = status;
+	job->state = ENC_JOB_DONE;
+	client->stats.jobs++;
+	if (status)
+		client->stats.timeouts++;
+	client->stats.busy_ns += ktime_to_ns(ktime_sub(now, job->started));
+	client->stats.queue_ns += ktime_to_ns(ktime_sub(job->started,
+							job->submitted));
+	up(&dev->core_suspend_sem);
+
+	if (status)
+		dma_fence_set_error(job->fence, status);
+	dma_fence_signal(job->fence);
+
+	wake_up_all(&client->wait);
+	/* for ReserveEncoder() and suspend */
+	wake_up_all(&hw_queue);
+}
+
+static void EncJobTimeout(struct work_struct *work)
+{
+	hantroenc_t *dev = container_of(to_delayed_work(work), hantroenc_t,
+					job_timeout);
+	unsigned long flags;
+	u32 irq_status;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	/* the job timed out, not one started since */
+	if (dev->job && time_after_eq(jiffies, dev->job->deadline)) {
+		pr_err("%s: core %d job %llu timeout !\n", __func__,
+		       dev->core_id, dev->job->seqno);
+		/* disable HW and clear the IRQ, as hantroenc_cleanup() */
+		iowrite32(0, dev->hwregs + 0x14);
+		irq_status = ioread32(dev->hwregs + 0x04);
+		iowrite32(0, dev->hwregs + 0x04);
+		FinishEncJob(dev, irq_status & (~0x01), -ETIMEDOUT);
+		DispatchEncJobs(dev);
+	}
+	spin_unlock_irqrestore(&owner_lock, flags);
+}
+
+static long SubmitEncJob(struct file *filp, struct enc_job_buffer __user *ujob)
+{
+	struct enc_client *client = filp->private_data;
+	struct enc_job_buffer desc;
+	struct sync_file *sync_file;
+	struct enc_job *job;
+	hantroenc_t *dev;
+	unsigned long flags;
+	int fd;
+	long ret;
+
+	if (copy_from_user(&desc, ujob, sizeof(desc)))
+		return -EFAULT;
+
+	if (desc.core_id >= total_core_num || !hantroenc_data[desc.core_id].is_valid)
+		return -EINVAL;
+	dev = &hantroenc_data[desc.core_id];
+
+	/* all of the registers, the core may have run another stream before */
+	if (desc.size < dev->core_cfg.iosize ||
+	    dev->core_cfg.iosize > sizeof(job->regs))
+		return -EINVAL;
+
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job)
+		return -ENOMEM;
+	job->size = dev->core_cfg.iosize;
+	if (copy_from_user(job->regs, u64_to_user_ptr(desc.regs), job->size)) {
+		ret = -EFAULT;
+		goto err;
+	}
+
+	job->fence = kzalloc(sizeof(*job->fence), GFP_KERNEL);
+	if (!job->fence) {
+		ret = -ENOMEM;
+		goto err;
+	}
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		ret = fd;
+		goto err_fence;
+	}
+
+	mutex_lock(&job_submit_lock);
+	dma_fence_init(job->fence, &enc_fence_ops, &fence_lock,
+		       dev->fence_context, ++dev->fence_seqno);
+	/* only SUBMIT adds jobs, and it is serialized */
+	if (READ_ONCE(client->nr_jobs) >= HX280ENC_MAX_JOBS) {
+		ret = -EBUSY;
+		goto err_unlock;
+	}
+	sync_file = sync_file_create(job->fence);
+	if (!sync_file) {
+		ret = -ENOMEM;
+		goto err_unlock;
+	}
+	job->client = client;
+	job->seqno = job->fence->seqno;
+	job->core = desc.core_id;
+	job->submitted = ktime_get();
+
+	spin_lock_irqsave(&owner_lock, flags);
+	client->nr_jobs++;
+	job->state = ENC_JOB_QUEUED;
+	list_add_tail(&job->node, &client->jobs);
+	list_add_tail(&job->queue, &dev->job_queue);
+	desc.seqno = job->seqno;
+	DispatchEncJobs(dev);
+	spin_unlock_irqrestore(&owner_lock, flags);
+	mutex_unlock(&job_submit_lock);
+
+	fd_install(fd, sync_file->file);
+	desc.fence_fd = fd;
+
+	/* the job is queued already: if its id is lost, close() frees it */
+	if (copy_to_user(ujob, &desc, sizeof(desc)))
+		return -EFAULT;
+	return 0;
+
+err_unlock:
+	mutex_unlock(&job_submit_lock);
+	dma_fence_put(job->fence);
+	put_unused_fd(fd);
+	goto err;
+err_fence:
+	kfree(job->fence);
+err:
+	kfree(job);
+	return ret;
+}
+
+static void FreeEncJob(struct enc_job *job)
+{
+	dma_fence_put(job->fence);
+	kfree(job);
+}
+
+/*
+ * Take the job seqno of the client on core_id, or any of its jobs if seqno
+ * is 0, if done: returns -EAGAIN while it runs, -EINVAL if there is no such
+ * job.
+ */
+static int TakeEncJob(struct enc_client *client, u32 core_id, u64 seqno,
+		      struct enc_job **out)
+{
+	struct enc_job *job;
+	unsigned long flags;
+	int ret = -EINVAL;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	list_for_each_entry(job, &client->jobs, node) {
+		if (seqno && (job->seqno != seqno || job->core != core_id))
+			continue;
+		if (job->state != ENC_JOB_DONE) {
+			ret = -EAGAIN;
+			if (seqno)
+				break;
+			continue;
+		}
+		list_del(&job->node);
+		client->nr_jobs--;
+		*out = job;
+		ret = 0;
+		break;
+	}
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	return ret;
+}
+
+static long WaitEncJob(struct file *filp, struct enc_job_buffer __user *ujob)
+{
+	struct enc_client *client = filp->private_data;
+	struct enc_job_buffer desc;
+	struct enc_job *job;
+	long ret;
+
+	if (copy_from_user(&desc, ujob, sizeof(desc)))
+		return -EFAULT;
+	if (desc.seqno && desc.core_id >= total_core_num)
+		return -EINVAL;
+
+	ret = TakeEncJob(client, desc.core_id, desc.seqno, &job);
+	if (ret == -EAGAIN && !(filp->f_flags & O_NONBLOCK)) {
+		if (wait_event_interruptible(client->wait,
+				(ret = TakeEncJob(client, desc.core_id, desc.seqno,
+						  &job)) != -EAGAIN))
+			return -ERESTARTSYS;
+	}
+	if (ret)
+		return ret;
+
+	/* put registers to user space */
+	if (desc.size < job->size ||
+	    copy_to_user(u64_to_user_ptr(desc.regs), job->regs, job->size)) {
+		ret = -EFAULT;
+		goto out;
+	}
+	desc.seqno = job->seqno;
+	desc.core_id = job->core;
+	desc.status = job->status;
+	if (copy_to_user(ujob, &desc, sizeof(desc)))
+		ret = -EFAULT;
+out:
+	FreeEncJob(job);
+	return ret;
+}
+
+static long GetEncJobStats(struct file *filp, struct enc_job_stats __user *ustats)
+{
+	struct enc_client *client = filp->private_data;
+	struct enc_job_stats stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	stats = client->stats;
+	spin_unlock_irqrestore(&owner_lock, flags);
+	stats.elapsed_ns = ktime_to_ns(ktime_sub(ktime_get(), client->opened));
+
+	if (copy_to_user(ustats, &stats, sizeof(stats)))
+		return -EFAULT;
+	return 0;
+}
+
+static int EncClientBusy(struct enc_client *client)
+{
+	struct enc_job *job;
+	unsigned long flags;
+	int busy = 0;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	list_for_each_entry(job, &client->jobs, node)
+		busy |= job->state == ENC_JOB_RUNNING;
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	return busy;
+}
+
+/* Cancel the queued jobs of the client, and wait for the running ones */
+static void FlushEncJobs(struct enc_client *client)
+{
+	struct enc_job *job, *tmp;
+	unsigned long flags;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	list_for_each_entry(job, &client->jobs, node) {
+		if (job->state != ENC_JOB_QUEUED)
+			continue;
+		list_del(&job->queue);
+		job->state = ENC_JOB_DONE;
+		dma_fence_set_error(job->fence, -ECANCELED);
+		dma_fence_signal(job->fence);
+	}
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	/* a stuck core is stopped by EncJobTimeout() */
+	wait_event(client->wait, !EncClientBusy(client));
+
+	list_for_each_entry_safe(job, tmp, &client->jobs, node)
+		FreeEncJob(job);
+}
+
+static int EncJobsRunning(void)
+{
+	unsigned long flags;
+	int i, running = 0;
+
+	spin_lock_irqsave(&owner_lock, flags);
+	for (i = 0; i < total_core_num; i++)
+		running |= hantroenc_data[i].job != NULL;
+	spin_unlock_irqrestore(&owner_lock, flags);
+
+	return running;
+}
 
 static long hantroenc_ioctl(struct file *filp,
 		unsigned int cmd, unsigned long arg)
@@ -640,6 +1045,12 @@ static long hantroenc_ioctl(struct file *filp,
 			return err;
 		break;
 	}
+	case _IOC_NR(HX280ENC_IOCX_JOB_SUBMIT):
+		return SubmitEncJob(filp, (struct enc_job_buffer __user *)arg);
+	case _IOC_NR(HX280ENC_IOCX_JOB_WAIT):
+		return WaitEncJob(filp, (struct enc_job_buffer __user *)arg);
+	case _IOC_NR(HX280ENC_IOCG_JOB_STATS):
+		return GetEncJobStats(filp, (struct enc_job_stats __user *)arg);
 	default: {
 #ifdef HANTROMMU_SUPPORT
 	if (_IOC_TYPE(cmd) == HANTRO_IOC_MMU)
@@ -654,8 +1065,15 @@ static int hantroenc_open(struct inode *inode, struct file *filp)
 {
 	int result = 0;
 	hantroenc_t *dev = hantroenc_data;
+	struct enc_client *client;
 
-	filp->private_data = (void *) dev;
+	client = kzalloc(sizeof(*client), GFP_KERNEL);
+	if (!client)
+		return -ENOMEM;
+	INIT_LIST_HEAD(&client->jobs);
+	init_waitqueue_head(&client->wait);
+	client->opened = ktime_get();
+	filp->private_data = client;
 
 #ifndef VSI
 	hantro_vc8000e_clk_enable(dev->dev);
@@ -667,7 +1085,7 @@ static int hantroenc_open(struct inode *inode, struct file *filp)
 }
 static int hantroenc_release(struct inode *inode, struct file *filp)
 {
-	hantroenc_t *dev = (hantroenc_t *) filp->private_data;
+	hantroenc_t *dev = hantroenc_data;
 	u32 core_id = 0;
 
 #ifdef hantroenc_DEBUG
@@ -677,6 +1095,9 @@ static int hantroenc_release(struct inode *inode, struct file *filp)
 
 	PDEBUG("dev closed\n");
 
+	FlushEncJobs(filp->private_data);
+	kfree(filp->private_data);
+
 	for (core_id = 0; core_id < total_core_num; core_id++) {
 		spin_lock_irqsave(&owner_lock, flags);
 		if (dev[core_id].is_reserved == 1 && dev[core_id].filp == filp) {
@@ -685,6 +1106,7 @@ static int hantroenc_release(struct inode *inode, struct file *filp)
 			dev[core_id].irq_received = 0;
 			dev[core_id].irq_status = 0;
 			PDEBUG("release reserved core\n");
+			DispatchEncJobs(&dev[core_id]);
 		}
 		spin_unlock_irqrestore(&owner_lock, flags);
 	}
@@ -800,11 +1222,20 @@ static struct file_operations hantroenc_fops = {
 
 static int hantro_enc_suspend(struct device *dev, pm_message_t state)
 {
+	unsigned long flags;
 	int i, j;
 	u32 *reg_buf;
 
 	PDEBUG("%s start..\n", __func__);
 
+	/* stop starting jobs, and let the running ones finish */
+	spin_lock_irqsave(&owner_lock, flags);
+	jobs_suspended = true;
+	spin_unlock_irqrestore(&owner_lock, flags);
+	if (!wait_event_timeout(hw_queue, !EncJobsRunning(),
+				msecs_to_jiffies(HX280ENC_JOB_TIMEOUT_MS * 2)))
+		pr_err("%s: jobs still running\n", __func__);
+
 	for (i = 0; i < total_core_num; i++) {
 		/*if HW is active, need to wait until frame ready interrupt*/
 		if ((hantroenc_data[i].is_reserved == 0) || (down_interruptible(&hantroenc_data[i].core_suspend_sem)))
@@ -826,6 +1257,7 @@ static int hantro_enc_suspend(struct device *dev, pm_message_t state)
 
 static int hantro_enc_resume(struct device *dev)
 {
+	unsigned long flags;
 	int i, j;
 	u32 *reg_buf;
 
@@ -843,6 +1275,12 @@ static int hantro_enc_resume(struct device *dev)
 		}
 	}
 
+	spin_lock_irqsave(&owner_lock, flags);
+	jobs_suspended = false;
+	for (i = 0; i < total_core_num; i++)
+		DispatchEncJobs(&hantroenc_data[i]);
+	spin_unlock_irqrestore(&owner_lock, flags);
+
 	PDEBUG("%s succeed!\n", __func__);
 	return 0;
 
@@ -855,6 +1293,7 @@ static int __init hantroenc_init(void)
 #endif
 {
 	int result = 0;
+	u64 fence_context;
 	int i;
 
 	total_core_num = sizeof(core_array)/sizeof(CORE_CONFIG);
@@ -868,12 +1307,16 @@ static int __init hantroenc_init(void)
 		goto err1;
 	memset(hantroenc_data, 0, sizeof(hantroenc_t)*total_core_num);
 
+	fence_context = dma_fence_context_alloc(total_core_num);
 	for (i = 0; i < total_core_num; i++) {
 		hantroenc_data[i].core_cfg = core_array[i];
 		hantroenc_data[i].async_queue = NULL;
 		hantroenc_data[i].hwregs = NULL;
 		hantroenc_data[i].core_id = i;
 		sema_init(&hantroenc_data[i].core_suspend_sem, 1);
+		INIT_LIST_HEAD(&hantroenc_data[i].job_queue);
+		INIT_DELAYED_WORK(&hantroenc_data[i].job_timeout, EncJobTimeout);
+		hantroenc_data[i].fence_context = fence_context + i;
 	}
 
 	result = register_chrdev(hantroenc_major, "hx280enc", &hantroenc_fops);
@@ -961,6 +1404,8 @@ static void __exit hantroenc_cleanup(void)
 	int i = 0;
 
 	for (i = 0; i < total_core_num; i++) {
+		/* no file is open anymore, so no job is left */
+		cancel_delayed_work_sync(&hantroenc_data[i].job_timeout);
 		if (hantroenc_data[i].is_valid == 0)
 			continue;
 		writel(0, hantroenc_data[i].hwregs + 0x14); /* disable HW */
@@ -1069,7 +1514,7 @@ static irqreturn_t hantroenc_isr(int irq, void *dev_id)
 
 	/*If core is not reserved by any user, but irq is received, just clean it*/
 	spin_lock_irqsave(&owner_lock, flags);
-	if (!dev->is_reserved) {
+	if (!dev->is_reserved && !dev->job) {
 		u32 hwId;
 		u32 majorId;
 		u32 wClr;
@@ -1116,6 +1561,17 @@ static irqreturn_t hantroenc_isr(int irq, void *dev_id)
 		iowrite32(wClr, dev->hwregs + 0x04);
 
 		spin_lock_irqsave(&owner_lock, flags);
+		if (dev->job) {
+			/* slice ready IRQs leave the encoder running */
+			if (!(ioread32(dev->hwregs + 0x14) & 0x01)) {
+				/* hand the job back, and start the next one */
+				cancel_delayed_work(&dev->job_timeout);
+				FinishEncJob(dev, irq_status & (~0x01), 0);
+				DispatchEncJobs(dev);
+			}
+			spin_unlock_irqrestore(&owner_lock, flags);
+			return IRQ_HANDLED;
+		}
 		dev->irq_received = 1;
 		dev->irq_status = irq_status & (~0x01);
 		spin_unlock_irqrestore(&owner_lock, flags);
@@ -275,6 +275,9 @@
 #define RX_CHANNEL		1
 
 #define TRANS_RING_NODES	(1 << 3)
+/* Ring buffer mode: a period is one ADT page, of a 13 bit buffer depth */
+#define RING_MAX_PERIOD_BYTES	(1 << 13)
+#define RING_MAX_PERIODS	256
 #define MLB_QUIRK_MLB150	(1 << 0)
 
 enum MLB_CTYPE {
@@ -315,6 +318,20 @@ struct mlb_ringbuf {
 	rwlock_t rb_lock ____cacheline_aligned; /* ring index lock */
 };
 
+/* Ring buffer mode positions, counted in periods */
+struct mlb_ring {
+	/* periods done by the hardware, and by user space */
+	u64 hw;
+	u64 appl;
+	/* index of the period the hardware works on */
+	u32 hw_idx;
+	u32 xruns;
+	/* tx: a period is queued to the ADT */
+	bool running;
+	u32 phys;
+	spinlock_t lock;
+};
+
 struct mlb_channel_info {
 	/* Input MLB channel address */
 	u32 address;
@@ -369,6 +386,16 @@ struct mlb_dev_info {
 	u32 adt_buf_dep;
 	/* Buffer size to hold data */
 	u32 buf_size;
+	/* ring buffer mode, see MLB_SET_RINGBUF */
+	bool ring_mode;
+	void *ring_virt;
+	dma_addr_t ring_phys;
+	/* bytes of each of the rx and tx rings, page aligned */
+	size_t ring_size;
+	u32 period_bytes;
+	u32 periods;
+	struct mlb_ring rx_ring;
+	struct mlb_ring tx_ring;
 };
 
 struct mlb_data {
@@ -1339,12 +1366,14 @@ static s32 mlb150_dev_init_ch_amba_ahb(struct mlb_dev_info *pdevinfo,
 					enum MLB_CTYPE ctype)
 {
 	u32 ctr_val[4] = { 0 };
+	u32 buf_dep = pdevinfo->ring_mode ? pdevinfo->period_bytes :
+					    pdevinfo->adt_buf_dep;
 
 	/* a. Set the 32-bit base address (BA1) */
 	ctr_val[3] = 0;
 	ctr_val[2] = 0;
-	ctr_val[1] = (pdevinfo->adt_buf_dep - 1) << ADT_BD1_SHIFT;
-	ctr_val[1] |= (pdevinfo->adt_buf_dep - 1) << ADT_BD2_SHIFT;
+	ctr_val[1] = (buf_dep - 1) << ADT_BD1_SHIFT;
+	ctr_val[1] |= (buf_dep - 1) << ADT_BD2_SHIFT;
 	if (MLB_CTYPE_ASYNC == ctype ||
 		MLB_CTYPE_CTRL == ctype) {
 		ctr_val[1] |= ADT_PS1;
@@ -1581,6 +1610,39 @@ static void mxc_mlb150_irq_enable(struct mlb_data *drvdata, u8 enable)
 /*
  * Enable the MLB channel
  */
+static inline u32 mlb_ring_period(struct mlb_dev_info *pdevinfo,
+				  struct mlb_ring *ring, u32 idx)
+{
+	return ring->phys + idx * pdevinfo->period_bytes;
+}
+
+/* Ring buffer mode: start sending the tx ring, if it is idle and filled */
+static void mlb_tx_ring_kick(struct mlb_dev_info *pdevinfo)
+{
+	struct mlb_ring *ring = &pdevinfo->tx_ring;
+	u32 ahb_ch = pdevinfo->channels[TX_CHANNEL].cl;
+	unsigned long flags;
+	u32 tx_buf_ptr;
+	s32 adt_sts;
+	bool start;
+
+	spin_lock_irqsave(&ring->lock, flags);
+	start = atomic_read(&pdevinfo->on) && !ring->running &&
+		ring->appl > ring->hw;
+	if (start)
+		ring->running = true;
+	tx_buf_ptr = mlb_ring_period(pdevinfo, ring, ring->hw_idx);
+	spin_unlock_irqrestore(&ring->lock, flags);
+
+	if (!start)
+		return;
+
+	adt_sts = mlb150_dev_get_adt_sts(ahb_ch);
+	/*  Set ADT for TX */
+	mlb150_dev_pipo_next(ahb_ch, pdevinfo->channel_type, adt_sts,
+			     tx_buf_ptr);
+}
+
 static s32 mlb_channel_enable(struct mlb_data *drvdata,
 				int chan_dev_id, int on)
 {
@@ -1632,11 +1694,27 @@ static s32 mlb_channel_enable(struct mlb_data *drvdata,
 		mlb150_dev_dump_ctr_tbl(0, tx_chinfo->cl + 1);
 #endif
 		/* Init RX ADT */
-		mlb150_dev_pipo_start(&pdevinfo->rx_rbuf, rx_cl,
+		if (pdevinfo->ring_mode) {
+			struct mlb_ring *rx_ring = &pdevinfo->rx_ring;
+
+			mlb150_dev_pipo_start(&pdevinfo->rx_rbuf, rx_cl,
+				mlb_ring_period(pdevinfo, rx_ring,
+						rx_ring->hw_idx));
+			/* periods queued before the startup */
+			mlb_tx_ring_kick(pdevinfo);
+		} else {
+			mlb150_dev_pipo_start(&pdevinfo->rx_rbuf, rx_cl,
 					pdevinfo->rx_rbuf.phy_addrs[0]);
+		}
 	} else {
+		unsigned long flags;
+
 		mlb150_dev_pipo_stop(&pdevinfo->rx_rbuf, rx_cl);
 
+		spin_lock_irqsave(&pdevinfo->tx_ring.lock, flags);
+		pdevinfo->tx_ring.running = false;
+		spin_unlock_irqrestore(&pdevinfo->tx_ring.lock, flags);
+
 		mlb150_dev_enable_dma_irq(0);
 		mlb150_dev_enable_ir_mlb(0);
 
@@ -1651,6 +1729,72 @@ static s32 mlb_channel_enable(struct mlb_data *drvdata,
 	return 0;
 }
 
+/*
+ * Ring buffer mode: a period was filled, hand the next one to the
+ * hardware.  When user space is a whole ring behind, its oldest period
+ * is overwritten and counted as an xrun, so the channel keeps running.
+ */
+static void mlb_rx_ring_isr(s32 ctype, u32 ahb_ch,
+			    struct mlb_dev_info *pdevinfo)
+{
+	struct mlb_ring *ring = &pdevinfo->rx_ring;
+	u32 rx_buf_ptr;
+	s32 adt_sts;
+
+	spin_lock(&ring->lock);
+	ring->hw++;
+	if (++ring->hw_idx == pdevinfo->periods)
+		ring->hw_idx = 0;
+	if (ring->hw - ring->appl >= pdevinfo->periods) {
+		ring->appl = ring->hw - pdevinfo->periods + 1;
+		ring->xruns++;
+	}
+	rx_buf_ptr = mlb_ring_period(pdevinfo, ring, ring->hw_idx);
+	spin_unlock(&ring->lock);
+
+	/* wake up the reader, once per period */
+	wake_up_interruptible(&pdevinfo->rx_wq);
+
+	adt_sts = mlb150_dev_get_adt_sts(ahb_ch);
+	/*  Set ADT for RX */
+	mlb150_dev_pipo_next(ahb_ch, ctype, adt_sts, rx_buf_ptr);
+}
+
+/*
+ * Ring buffer mode: a period was sent, queue the next one if user space
+ * filled it.  Otherwise the ring ran empty, which is counted as an xrun,
+ * and MLB_RINGBUF_SYNC starts it again.
+ */
+static void mlb_tx_ring_isr(s32 ctype, u32 ahb_ch,
+			    struct mlb_dev_info *pdevinfo)
+{
+	struct mlb_ring *ring = &pdevinfo->tx_ring;
+	u32 tx_buf_ptr;
+	s32 adt_sts;
+	bool next;
+
+	spin_lock(&ring->lock);
+	ring->hw++;
+	if (++ring->hw_idx == pdevinfo->periods)
+		ring->hw_idx = 0;
+	next = ring->appl > ring->hw;
+	if (!next) {
+		ring->running = false;
+		ring->xruns++;
+	}
+	tx_buf_ptr = mlb_ring_period(pdevinfo, ring, ring->hw_idx);
+	spin_unlock(&ring->lock);
+
+	wake_up_interruptible(&pdevinfo->tx_wq);
+
+	if (!next)
+		return;
+
+	adt_sts = mlb150_dev_get_adt_sts(ahb_ch);
+	/*  Set ADT for TX */
+	mlb150_dev_pipo_next(ahb_ch, ctype, adt_sts, tx_buf_ptr);
+}
+
 /*
  * MLB interrupt handler
  */
@@ -1660,6 +1804,11 @@ static void mlb_rx_isr(s32 ctype, u32 ahb_ch, struct mlb_dev_info *pdevinfo)
 	s32 head, tail, adt_sts;
 	u32 rx_buf_ptr;
 
+	if (pdevinfo->ring_mode) {
+		mlb_rx_ring_isr(ctype, ahb_ch, pdevinfo);
+		return;
+	}
+
 #ifdef DEBUG_RX
 	pr_debug("mxc_mlb150: mlb_rx_isr\n");
 #endif
@@ -1699,6 +1848,11 @@ static void mlb_tx_isr(s32 ctype, u32 ahb_ch, struct mlb_dev_info *pdevinfo)
 	s32 head, tail, adt_sts;
 	u32 tx_buf_ptr;
 
+	if (pdevinfo->ring_mode) {
+		mlb_tx_ring_isr(ctype, ahb_ch, pdevinfo);
+		return;
+	}
+
 	read_lock(&tx_rbuf->rb_lock);
 
 	head = READ_ONCE(tx_rbuf->head);
@@ -2041,6 +2195,13 @@ static int mxc_mlb150_release(struct inode *inode, struct file *filp)
 
 	atomic_set(&pdevinfo->on, 0);
 
+	if (pdevinfo->ring_virt) {
+		dma_free_coherent(drvdata->dev, 2 * pdevinfo->ring_size,
+				  pdevinfo->ring_virt, pdevinfo->ring_phys);
+		pdevinfo->ring_virt = NULL;
+	}
+	pdevinfo->ring_mode = false;
+
 	clk_disable_unprepare(drvdata->mlb);
 
 	/* decrease the open count */
@@ -2051,6 +2212,115 @@ static int mxc_mlb150_release(struct inode *inode, struct file *filp)
 	return 0;
 }
 
+static void mlb_ring_init(struct mlb_ring *ring, u32 phys)
+{
+	spin_lock_init(&ring->lock);
+	ring->hw = ring->appl = 0;
+	ring->hw_idx = 0;
+	ring->xruns = 0;
+	ring->running = false;
+	ring->phys = phys;
+}
+
+/*
+ * Switch the sync or isoc channel to the ring buffer mode: each period is
+ * a whole ADT page, a multiple of the channel block, so that the DMA
+ * interrupts once per period instead of once per block.
+ */
+static int mlb_ring_setup(struct mlb_data *drvdata,
+			  struct mlb_dev_info *pdevinfo,
+			  const struct mlb_ringbuf_params *params)
+{
+	u32 ctype = pdevinfo->channel_type;
+	size_t ring_size;
+
+	if (MLB_CTYPE_SYNC != ctype && MLB_CTYPE_ISOC != ctype)
+		return -EINVAL;
+
+	if (atomic_read(&pdevinfo->on) || pdevinfo->ring_virt)
+		return -EBUSY;
+
+	if (!params->period_bytes ||
+		params->period_bytes % pdevinfo->adt_buf_dep ||
+		params->period_bytes > RING_MAX_PERIOD_BYTES ||
+		params->periods < 2 || params->periods > RING_MAX_PERIODS) {
+		pr_err("mxc_mlb150: invalid ring of %u periods of %u bytes, "
+			"block %u\n", params->periods, params->period_bytes,
+			pdevinfo->adt_buf_dep);
+		return -EINVAL;
+	}
+
+	ring_size = PAGE_ALIGN(params->period_bytes * params->periods);
+	pdevinfo->ring_virt = dma_alloc_coherent(drvdata->dev, 2 * ring_size,
+					&pdevinfo->ring_phys, GFP_KERNEL);
+	if (!pdevinfo->ring_virt)
+		return -ENOMEM;
+
+	pdevinfo->ring_size = ring_size;
+	pdevinfo->period_bytes = params->period_bytes;
+	pdevinfo->periods = params->periods;
+	mlb_ring_init(&pdevinfo->rx_ring, pdevinfo->ring_phys);
+	mlb_ring_init(&pdevinfo->tx_ring, pdevinfo->ring_phys + ring_size);
+	pdevinfo->ring_mode = true;
+
+	return 0;
+}
+
+/*
+ * Take the periods user space consumed from the rx ring and queued to the
+ * tx ring, and return the hardware positions, as ALSA's sync_ptr does.
+ */
+static long mlb_ring_sync(struct mlb_dev_info *pdevinfo,
+			  struct mlb_ringbuf_status __user *argp)
+{
+	struct mlb_ring *rx_ring = &pdevinfo->rx_ring;
+	struct mlb_ring *tx_ring = &pdevinfo->tx_ring;
+	struct mlb_ringbuf_status status;
+	unsigned long flags;
+
+	if (!pdevinfo->ring_mode)
+		return -EINVAL;
+
+	if (copy_from_user(&status, argp, sizeof(status))) {
+		pr_err("mxc_mlb150: copy from user failed\n");
+		return -EFAULT;
+	}
+
+	spin_lock_irqsave(&rx_ring->lock, flags);
+	if (status.rx_appl > rx_ring->hw) {
+		spin_unlock_irqrestore(&rx_ring->lock, flags);
+		return -EINVAL;
+	}
+	/* an older position is stale, after an xrun moved it on */
+	if (status.rx_appl > rx_ring->appl)
+		rx_ring->appl = status.rx_appl;
+	status.rx_hw = rx_ring->hw;
+	status.rx_appl = rx_ring->appl;
+	status.rx_xruns = rx_ring->xruns;
+	spin_unlock_irqrestore(&rx_ring->lock, flags);
+
+	spin_lock_irqsave(&tx_ring->lock, flags);
+	if (status.tx_appl > tx_ring->hw + pdevinfo->periods) {
+		spin_unlock_irqrestore(&tx_ring->lock, flags);
+		return -EINVAL;
+	}
+	if (status.tx_appl > tx_ring->appl)
+		tx_ring->appl = status.tx_appl;
+	status.tx_hw = tx_ring->hw;
+	status.tx_appl = tx_ring->appl;
+	status.tx_xruns = tx_ring->xruns;
+	spin_unlock_irqrestore(&tx_ring->lock, flags);
+
+	mlb_tx_ring_kick(pdevinfo);
+
+	if (copy_to_user(argp, &status, sizeof(status))) {
+		pr_err("mxc_mlb150: copy to user failed\n");
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
 static long mxc_mlb150_ioctl(struct file *filp,
 			 unsigned int cmd, unsigned long arg)
 {
@@ -2267,6 +2537,21 @@ static long mxc_mlb150_ioctl(struct file *filp,
 			enable_irq(drvdata->irq_mlb);
 			break;
 		}
+
+	case MLB_SET_RINGBUF:
+		{
+			struct mlb_ringbuf_params params;
+
+			if (copy_from_user(&params, argp, sizeof(params))) {
+				pr_err("mxc_mlb150: copy from user failed\n");
+				return -EFAULT;
+			}
+
+			return mlb_ring_setup(drvdata, pdevinfo, &params);
+		}
+
+	case MLB_RINGBUF_SYNC:
+		return mlb_ring_sync(pdevinfo, argp);
 	default:
 		pr_info("mxc_mlb150: Invalid ioctl command\n");
 		return -EINVAL;
@@ -2290,6 +2575,10 @@ static ssize_t mxc_mlb150_read(struct file *filp, char __user *buf,
 	int head, tail;
 	unsigned long flags;
 
+	/* the rings are mapped, see MLB_SET_RINGBUF */
+	if (pdevinfo->ring_mode)
+		return -EBUSY;
+
 	read_lock_irqsave(&rx_rbuf->rb_lock, flags);
 
 	head = READ_ONCE(rx_rbuf->head);
@@ -2380,6 +2669,9 @@ static ssize_t mxc_mlb150_write(struct file *filp, const char __user *buf,
 	 */
 	pchinfo = &pdevinfo->channels[TX_CHANNEL];
 
+	if (pdevinfo->ring_mode)
+		return -EBUSY;
+
 	if (count > pdevinfo->buf_size) {
 		/* too many data to write */
 		pr_warn("mxc_mlb150: overflow write data\n");
@@ -2458,6 +2750,31 @@ static ssize_t mxc_mlb150_write(struct file *filp, const char __user *buf,
 	return ret;
 }
 
+static unsigned int mlb_ring_poll(struct mlb_dev_info *pdevinfo)
+{
+	struct mlb_ring *rx_ring = &pdevinfo->rx_ring;
+	struct mlb_ring *tx_ring = &pdevinfo->tx_ring;
+	unsigned int ret = 0;
+	unsigned long flags;
+
+	/* a period to send is free */
+	spin_lock_irqsave(&tx_ring->lock, flags);
+	if (tx_ring->appl - tx_ring->hw < pdevinfo->periods)
+		ret |= POLLOUT | POLLWRNORM;
+	spin_unlock_irqrestore(&tx_ring->lock, flags);
+
+	/* a received period is filled */
+	spin_lock_irqsave(&rx_ring->lock, flags);
+	if (rx_ring->hw > rx_ring->appl)
+		ret |= POLLIN | POLLRDNORM;
+	spin_unlock_irqrestore(&rx_ring->lock, flags);
+
+	if (pdevinfo->ex_event)
+		ret |= POLLIN | POLLRDNORM;
+
+	return ret;
+}
+
 static unsigned int mxc_mlb150_poll(struct file *filp,
 				 struct poll_table_struct *wait)
 {
@@ -2476,6 +2793,9 @@ static unsigned int mxc_mlb150_poll(struct file *filp,
 	poll_wait(filp, &pdevinfo->rx_wq, wait);
 	poll_wait(filp, &pdevinfo->tx_wq, wait);
 
+	if (pdevinfo->ring_mode)
+		return mlb_ring_poll(pdevinfo);
+
 	read_lock_irqsave(&tx_rbuf->rb_lock, flags);
 	head = tx_rbuf->head;
 	tail = tx_rbuf->tail;
@@ -2502,6 +2822,21 @@ static unsigned int mxc_mlb150_poll(struct file *filp,
 	return ret;
 }
 
+/*
+ * Map the rx ring, followed by the tx ring, of the ring buffer mode
+ */
+static int mxc_mlb150_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct mlb_data *drvdata = filp->private_data;
+	struct mlb_dev_info *pdevinfo = drvdata->devinfo;
+
+	if (!pdevinfo->ring_virt)
+		return -EINVAL;
+
+	return dma_mmap_coherent(drvdata->dev, vma, pdevinfo->ring_virt,
+				 pdevinfo->ring_phys, 2 * pdevinfo->ring_size);
+}
+
 /*
  * char dev file operations structure
  */
@@ -2512,6 +2847,7 @@ static const struct file_operations mxc_mlb150_fops = {
 	.release = mxc_mlb150_release,
 	.unlocked_ioctl = mxc_mlb150_ioctl,
 	.poll = mxc_mlb150_poll,
+	.mmap = mxc_mlb150_mmap,
 	.read = mxc_mlb150_read,
 	.write = mxc_mlb150_write,
 };
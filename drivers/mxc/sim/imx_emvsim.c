@@ -62,6 +62,7 @@
 #define	SIM_TX_FIFO_DEPTH	16
 #define	SIM_RX_FIFO_DEPTH	16
 #define	TX_FIFO_THRESHOLD	4
+#define	RX_FIFO_THRESHOLD	8
 
 #define	SIM_STATE_REMOVED		0
 #define	SIM_STATE_DETECTED		1
@@ -541,6 +542,27 @@ static void emvsim_rcv_read_fifo(struct emvsim_t *emvsim)
 	spin_unlock(&emvsim->lock);
 }
 
+/*
+ * Ask for an interrupt every RX_FIFO_THRESHOLD characters, or on the last
+ * one of a fixed length reception. A shorter tail of a variable length
+ * reception is read when the CWT or BWT expires.
+ */
+static void emvsim_change_rcv_threshold(struct emvsim_t *emvsim)
+{
+	u32 rx_threshold = RX_FIFO_THRESHOLD;
+	u32 reg_val;
+
+	if (emvsim->is_fixed_len_rec &&
+	    emvsim->expected_rcv_cnt > emvsim->rcv_count &&
+	    emvsim->expected_rcv_cnt - emvsim->rcv_count < rx_threshold)
+		rx_threshold = emvsim->expected_rcv_cnt - emvsim->rcv_count;
+
+	reg_val = __raw_readl(emvsim->ioaddr + EMV_SIM_RX_THD);
+	reg_val &= ~SIM_RCV_THRESHOLD_RDT_MASK;
+	reg_val |= SIM_RCV_THRESHOLD_RDT(rx_threshold);
+	__raw_writel(reg_val, emvsim->ioaddr + EMV_SIM_RX_THD);
+}
+
 static void emvsim_tx_irq_enable(struct emvsim_t *emvsim)
 {
 	u32 reg_val;
@@ -552,7 +574,7 @@ static void emvsim_tx_irq_enable(struct emvsim_t *emvsim)
 	__raw_writel(reg_val, emvsim->ioaddr + EMV_SIM_RX_STATUS);
 
 	reg_val = __raw_readl(emvsim->ioaddr + EMV_SIM_INT_MASK);
-	reg_val |= CWT_ERR_IM | BWT_ERR_IM | RX_DATA_IM | RNACK_IM;
+	reg_val |= CWT_ERR_IM | BWT_ERR_IM | RX_DATA_IM | RDT_IM | RNACK_IM;
 
 	if (emvsim->xmt_remaining != 0) {
 		reg_val &= ~TDT_IM;
@@ -591,8 +613,9 @@ static void emvsim_rx_irq_enable(struct emvsim_t *emvsim)
 	__raw_writel(reg_data, emvsim->ioaddr + EMV_SIM_RX_STATUS);
 
 	reg_data = __raw_readl(emvsim->ioaddr + EMV_SIM_INT_MASK);
-	reg_data |= (TC_IM | TDT_IM | TNACK_IM | ETC_IM);
-	reg_data &= ~(RX_DATA_IM | CWT_ERR_IM | BWT_ERR_IM);
+	/* The RX FIFO is read by blocks, at the RDT threshold */
+	reg_data |= (TC_IM | TDT_IM | TNACK_IM | ETC_IM | RX_DATA_IM);
+	reg_data &= ~(RDT_IM | CWT_ERR_IM | BWT_ERR_IM);
 
 	if (emvsim->protocol_type == SIM_PROTOCOL_T0 ||
 	    emvsim->nack_enable != 0)
@@ -608,7 +631,7 @@ static void emvsim_rx_irq_disable(struct emvsim_t *emvsim)
 	u32 reg_val;
 
 	reg_val = __raw_readl(emvsim->ioaddr + EMV_SIM_INT_MASK);
-	reg_val |= (RX_DATA_IM | CWT_ERR_IM | BWT_ERR_IM | RNACK_IM);
+	reg_val |= (RX_DATA_IM | RDT_IM | CWT_ERR_IM | BWT_ERR_IM | RNACK_IM);
 	__raw_writel(reg_val, emvsim->ioaddr + EMV_SIM_INT_MASK);
 }
 
@@ -638,8 +661,6 @@ static irqreturn_t emvsim_irq_handler(int irq, void *dev_id)
 			complete(&emvsim->xfer_done);
 			emvsim->checking_ts_timing = 0;
 		} else if (rx_status & RX_DATA) {
-			u8 rdt = 1;
-
 			emvsim_mask_timer0_int(emvsim);
 
 			emvsim_rcv_read_fifo(emvsim);
@@ -648,11 +669,17 @@ static irqreturn_t emvsim_irq_handler(int irq, void *dev_id)
 			reg_data = ATR_MAX_DURATION - emvsim->rcv_count * 12;
 			__raw_writel(reg_data,  emvsim->ioaddr + EMV_SIM_GPCNT1_VAL);
 
+			/*
+			 * Read the rest of the ATR by blocks, the CWT error
+			 * tells when the card has nothing more to send.
+			 */
 			reg_data = __raw_readl(emvsim->ioaddr + EMV_SIM_INT_MASK);
-			reg_data &= ~(GPCNT1_IM | CWT_ERR_IM | RX_DATA_IM);
+			reg_data &= ~(GPCNT1_IM | CWT_ERR_IM | RDT_IM);
+			reg_data |= RX_DATA_IM;
 			__raw_writel(reg_data, emvsim->ioaddr + EMV_SIM_INT_MASK);
 
-			reg_data = SIM_RCV_THRESHOLD_RTH(0) | SIM_RCV_THRESHOLD_RDT(rdt);
+			reg_data = SIM_RCV_THRESHOLD_RTH(0) |
+				   SIM_RCV_THRESHOLD_RDT(RX_FIFO_THRESHOLD);
 			__raw_writel(reg_data, emvsim->ioaddr + EMV_SIM_RX_THD);
 
 			/* ATR has arrived as EMV demands */
@@ -673,7 +700,8 @@ static irqreturn_t emvsim_irq_handler(int irq, void *dev_id)
 
 			reg_data = __raw_readl(emvsim->ioaddr +
 					       EMV_SIM_INT_MASK);
-			reg_data |= (GPCNT1_IM | CWT_ERR_IM | RX_DATA_IM | GPCNT0_IM);
+			reg_data |= (GPCNT1_IM | CWT_ERR_IM | RX_DATA_IM |
+				     RDT_IM | GPCNT0_IM);
 			__raw_writel(reg_data, emvsim->ioaddr +
 				     EMV_SIM_INT_MASK);
 
@@ -687,7 +715,7 @@ static irqreturn_t emvsim_irq_handler(int irq, void *dev_id)
 			emvsim->state = SIM_STATE_ATR_RECEIVED;
 
 			complete(&emvsim->xfer_done);
-		} else if (rx_status & RX_DATA) {
+		} else if (rx_status & (RX_DATA | RDTF)) {
 			emvsim_rcv_read_fifo(emvsim);
 		}
 	}
@@ -758,7 +786,7 @@ static irqreturn_t emvsim_irq_handler(int irq, void *dev_id)
 			complete(&emvsim->xfer_done);
 		}
 
-		if (rx_status & RX_DATA) {
+		if (rx_status & (RX_DATA | RDTF)) {
 			emvsim_rcv_read_fifo(emvsim);
 			if (emvsim->is_fixed_len_rec &&
 			    emvsim->rcv_count >= emvsim->expected_rcv_cnt) {
@@ -768,6 +796,10 @@ static irqreturn_t emvsim_irq_handler(int irq, void *dev_id)
 					emvsim->state = SIM_STATE_RECEIVE_DONE;
 					complete(&emvsim->xfer_done);
 				}
+			} else {
+				spin_lock(&emvsim->lock);
+				emvsim_change_rcv_threshold(emvsim);
+				spin_unlock(&emvsim->lock);
 			}
 		}
 
@@ -1084,8 +1116,6 @@ static void emvsim_flush_fifo(struct emvsim_t *emvsim, u8 flush_tx, u8 flush_rx)
 
 static void emvsim_start_rcv(struct emvsim_t *emvsim)
 {
-	int rdt = 1;
-
 	emvsim->state = SIM_STATE_RECEIVING;
 
 	emvsim_set_rx(emvsim, 1);
@@ -1103,10 +1133,10 @@ static void emvsim_start_rcv(struct emvsim_t *emvsim)
 	/*Set RX threshold*/
 	if (emvsim->protocol_type == SIM_PROTOCOL_T0)
 		__raw_writel(SIM_RCV_THRESHOLD_RTH(emvsim->nack_threshold) |
-			     SIM_RCV_THRESHOLD_RDT(rdt),
+			     SIM_RCV_THRESHOLD_RDT(RX_FIFO_THRESHOLD),
 			     emvsim->ioaddr + EMV_SIM_RX_THD);
 	else
-		__raw_writel(SIM_RCV_THRESHOLD_RDT(rdt),
+		__raw_writel(SIM_RCV_THRESHOLD_RDT(RX_FIFO_THRESHOLD),
 			     emvsim->ioaddr + EMV_SIM_RX_THD);
 
 	/*Clear status and enable interrupt*/
@@ -1187,7 +1217,8 @@ static long emvsim_ioctl(struct file *file,
 		__raw_writel(reg_data, emvsim->ioaddr + EMV_SIM_CTRL);
 
 		reg_data = __raw_readl(emvsim->ioaddr + EMV_SIM_INT_MASK);
-		reg_data |= (GPCNT0_IM | GPCNT1_IM | CWT_ERR_IM | RX_DATA_IM);
+		reg_data |= (GPCNT0_IM | GPCNT1_IM | CWT_ERR_IM | RX_DATA_IM |
+			     RDT_IM);
 		__raw_writel(reg_data, emvsim->ioaddr + EMV_SIM_INT_MASK);
 
 		if (timeout == 0) {
@@ -1357,6 +1388,10 @@ static long emvsim_ioctl(struct file *file,
 		if (emvsim->state != SIM_STATE_RECEIVING)
 			emvsim_start_rcv(emvsim);
 
+		spin_lock_irqsave(&emvsim->lock, flags);
+		emvsim_change_rcv_threshold(emvsim);
+		spin_unlock_irqrestore(&emvsim->lock, flags);
+
 		emvsim->timeout = RX_TIMEOUT * HZ;
 		timeout = wait_for_completion_interruptible_timeout(
 				&emvsim->xfer_done, emvsim->timeout);
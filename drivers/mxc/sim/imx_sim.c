@@ -600,6 +600,26 @@ static void sim_rcv_read_fifo(struct sim_t *sim)
 	spin_unlock(&sim->lock);
 }
 
+static void sim_change_rcv_threshold(struct sim_t *sim)
+{
+	u32 rx_threshold = 0;
+	u32 reg_val = 0;
+
+	if (sim->is_fixed_len_rec) {
+		/*
+		 * The FIFO is smaller than the receive buffer: read big
+		 * blocks by RX_FIFO_THRESHOLD, then interrupt on the last
+		 * character.
+		 */
+		rx_threshold = min_t(u32, sim->expected_rcv_cnt - sim->rcv_count,
+				     RX_FIFO_THRESHOLD);
+		reg_val = __raw_readl(sim->ioaddr + RCV_THRESHOLD);
+		reg_val &= ~(SIM_RCV_THRESHOLD_RDT_MASK);
+		reg_val |= SIM_RCV_THRESHOLD_RDT(rx_threshold);
+		__raw_writel(reg_val, sim->ioaddr + RCV_THRESHOLD);
+	}
+}
+
 static void sim_tx_irq_enable(struct sim_t *sim)
 {
 	u32 reg_val;
@@ -832,6 +852,10 @@ static irqreturn_t sim_irq_handler(int irq, void *dev_id)
 					sim->state = SIM_STATE_RECEIVE_DONE;
 					complete(&sim->xfer_done);
 				}
+			} else {
+				spin_lock(&sim->lock);
+				sim_change_rcv_threshold(sim);
+				spin_unlock(&sim->lock);
 			}
 		}
 
@@ -1213,20 +1237,6 @@ static void sim_flush_fifo(struct sim_t *sim, u8 flush_tx, u8 flush_rx)
 	__raw_writel(reg_val, sim->ioaddr + RESET_CNTL);
 }
 
-static void sim_change_rcv_threshold(struct sim_t *sim)
-{
-	u32 rx_threshold = 0;
-	u32 reg_val = 0;
-
-	if (sim->is_fixed_len_rec) {
-		rx_threshold = sim->expected_rcv_cnt - sim->rcv_count;
-		reg_val = __raw_readl(sim->ioaddr + RCV_THRESHOLD);
-		reg_val &= ~(SIM_RCV_THRESHOLD_RDT_MASK);
-		reg_val |= SIM_RCV_THRESHOLD_RDT(rx_threshold);
-		__raw_writel(reg_val, sim->ioaddr + RCV_THRESHOLD);
-	}
-}
-
 static void sim_start_rcv(struct sim_t *sim)
 {
 	sim_set_baud_rate(sim);
@@ -7,6 +7,7 @@
 
 #include <linux/types.h>
 #include <linux/debugfs.h>
+#include <linux/math64.h>
 #include "wave6-vpu.h"
 #include "wave6-vpu-dbg.h"
 
@@ -228,3 +229,78 @@ void wave6_vpu_remove_dbgfs_file(struct vpu_instance *inst)
 	debugfs_remove(inst->debugfs);
 	inst->debugfs = NULL;
 }
+
+void wave6_vpu_record_latency(struct vpu_latency_info *info, ktime_t start)
+{
+	s64 latency = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	info->count++;
+	info->last = latency;
+	info->max = max_t(s64, latency, info->max);
+	info->total += latency;
+}
+
+static void wave6_vpu_dbg_latency(struct seq_file *s, const char *name,
+				  struct vpu_latency_info *info)
+{
+	u64 avg = info->count ? div64_u64(info->total, info->count) : 0;
+
+	seq_printf(s, "%s: count %llu, last %llu.%06llu, avg %llu.%06llu, max %llu.%06llu ms\n",
+		   name, info->count,
+		   info->last / NSEC_PER_MSEC, info->last % NSEC_PER_MSEC,
+		   avg / NSEC_PER_MSEC, avg % NSEC_PER_MSEC,
+		   info->max / NSEC_PER_MSEC, info->max % NSEC_PER_MSEC);
+}
+
+static int wave6_vpu_dbg_pool(struct seq_file *s, void *data)
+{
+	struct vpu_device *dev = s->private;
+	struct vpu_buf_pool *pool = &dev->buf_pool;
+
+	mutex_lock(&pool->lock);
+	seq_printf(s, "pool hits %llu, misses %llu, evictions %llu, cached %zu bytes\n",
+		   pool->hits, pool->misses, pool->evictions, pool->cached);
+	mutex_unlock(&pool->lock);
+
+	mutex_lock(&dev->dev_lock);
+	wave6_vpu_dbg_latency(s, "decoder open ", &dev->open_latency[VPU_INST_TYPE_DEC]);
+	wave6_vpu_dbg_latency(s, "decoder close", &dev->close_latency[VPU_INST_TYPE_DEC]);
+	wave6_vpu_dbg_latency(s, "encoder open ", &dev->open_latency[VPU_INST_TYPE_ENC]);
+	wave6_vpu_dbg_latency(s, "encoder close", &dev->close_latency[VPU_INST_TYPE_ENC]);
+	mutex_unlock(&dev->dev_lock);
+
+	return 0;
+}
+
+static int wave6_vpu_dbg_pool_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, wave6_vpu_dbg_pool, inode->i_private);
+}
+
+static const struct file_operations wave6_vpu_dbg_pool_fops = {
+	.owner = THIS_MODULE,
+	.open = wave6_vpu_dbg_pool_open,
+	.release = single_release,
+	.read = seq_read,
+};
+
+void wave6_vpu_create_dev_dbgfs_file(struct vpu_device *dev)
+{
+	char name[64];
+
+	if (IS_ERR_OR_NULL(dev->debugfs))
+		return;
+
+	scnprintf(name, sizeof(name), "pool.%s", dev_name(dev->dev));
+	dev->debugfs_pool = debugfs_create_file((const char *)name,
+						VERIFY_OCTAL_PERMISSIONS(0444),
+						dev->debugfs,
+						dev,
+						&wave6_vpu_dbg_pool_fops);
+}
+
+void wave6_vpu_remove_dev_dbgfs_file(struct vpu_device *dev)
+{
+	debugfs_remove(dev->debugfs_pool);
+	dev->debugfs_pool = NULL;
+}
@@ -18,5 +18,8 @@ unsigned int wave6_vpu_debug(void);
 
 int wave6_vpu_create_dbgfs_file(struct vpu_instance *inst);
 void wave6_vpu_remove_dbgfs_file(struct vpu_instance *inst);
+void wave6_vpu_create_dev_dbgfs_file(struct vpu_device *dev);
+void wave6_vpu_remove_dev_dbgfs_file(struct vpu_device *dev);
+void wave6_vpu_record_latency(struct vpu_latency_info *info, ktime_t start);
 
 #endif /* __WAVE6_VPU_DBG_H__ */
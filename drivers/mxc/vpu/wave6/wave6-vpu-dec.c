@@ -142,11 +142,11 @@ static void wave6_vpu_dec_release_fb(struct vpu_instance *inst)
 	int i;
 
 	for (i = 0; i < WAVE6_MAX_FBS; i++) {
-		wave6_free_dma(&inst->frame_vbuf[i]);
+		wave6_vpu_pool_free(inst->dev, &inst->frame_vbuf[i]);
 		memset(&inst->frame_buf[i], 0, sizeof(struct frame_buffer));
-		wave6_free_dma(&inst->aux_vbuf[AUX_BUF_FBC_Y_TBL][i]);
-		wave6_free_dma(&inst->aux_vbuf[AUX_BUF_FBC_C_TBL][i]);
-		wave6_free_dma(&inst->aux_vbuf[AUX_BUF_MV_COL][i]);
+		wave6_vpu_pool_free(inst->dev, &inst->aux_vbuf[AUX_BUF_FBC_Y_TBL][i]);
+		wave6_vpu_pool_free(inst->dev, &inst->aux_vbuf[AUX_BUF_FBC_C_TBL][i]);
+		wave6_vpu_pool_free(inst->dev, &inst->aux_vbuf[AUX_BUF_MV_COL][i]);
 	}
 }
 
@@ -154,6 +154,7 @@ static void wave6_vpu_dec_destroy_instance(struct vpu_instance *inst)
 {
 	u32 fail_res;
 	int ret;
+	ktime_t start = ktime_get();
 
 	dprintk(inst->dev->dev, "[%d] destroy instance\n", inst->id);
 	wave6_vpu_remove_dbgfs_file(inst);
@@ -170,6 +171,8 @@ static void wave6_vpu_dec_destroy_instance(struct vpu_instance *inst)
 
 	if (!pm_runtime_suspended(inst->dev->dev))
 		pm_runtime_put_sync(inst->dev->dev);
+
+	wave6_vpu_record_latency(&inst->dev->close_latency[inst->type], start);
 }
 
 static void wave6_handle_bitstream_buffer(struct vpu_instance *inst)
@@ -254,7 +257,7 @@ static int wave6_allocate_aux_buffer(struct vpu_instance *inst,
 	num = min_t(u32, num, WAVE6_MAX_FBS);
 	for (i = 0; i < num; i++) {
 		inst->aux_vbuf[type][i].size = size;
-		ret = wave6_alloc_dma(inst->dev->dev, &inst->aux_vbuf[type][i]);
+		ret = wave6_vpu_pool_alloc(inst->dev, &inst->aux_vbuf[type][i]);
 		if (ret) {
 			dev_err(inst->dev->dev, "%s: Alloc fail (type %d)\n", __func__, type);
 			return ret;
@@ -840,6 +843,8 @@ static void wave6_vpu_dec_finish_decode(struct vpu_instance *inst, bool error)
 		goto finish_decode;
 	}
 
+	wave6_vpu_retire_job(inst);
+
 	wave6_vpu_dec_handle_decoding_warn_error(inst, &info);
 
 	if (info.frame_decoded)
@@ -856,6 +861,9 @@ static void wave6_vpu_dec_finish_decode(struct vpu_instance *inst, bool error)
 	if (info.stream_end && !inst->eos)
 		wave6_handle_last_frame(inst, NULL);
 
+	wave6_vpu_retire_done(inst);
+	return;
+
 finish_decode:
 	wave6_vpu_finish_job(inst);
 }
@@ -1386,6 +1394,7 @@ static int wave6_vpu_dec_create_instance(struct vpu_instance *inst)
 {
 	int ret;
 	struct dec_open_param open_param;
+	ktime_t start = ktime_get();
 
 	memset(&open_param, 0, sizeof(struct dec_open_param));
 
@@ -1420,6 +1429,7 @@ static int wave6_vpu_dec_create_instance(struct vpu_instance *inst)
 	wave6_vpu_set_instance_state(inst, VPU_INST_STATE_OPEN);
 	inst->v4l2_fh.m2m_ctx->ignore_cap_streaming = true;
 	v4l2_m2m_set_dst_buffered(inst->v4l2_fh.m2m_ctx, true);
+	wave6_vpu_record_latency(&inst->dev->open_latency[inst->type], start);
 
 	return 0;
 
@@ -1458,7 +1468,7 @@ static int wave6_vpu_dec_prepare_fb(struct vpu_instance *inst)
 		struct vpu_buf *vframe = &inst->frame_vbuf[i];
 
 		vframe->size = luma_size + chroma_size;
-		ret = wave6_alloc_dma(inst->dev->dev, vframe);
+		ret = wave6_vpu_pool_alloc(inst->dev, vframe);
 		if (ret) {
 			dev_err(inst->dev->dev, "alloc FBC buffer fail : %zu\n",
 				vframe->size);
@@ -1701,6 +1711,8 @@ static void wave6_vpu_dec_stop_streaming(struct vb2_queue *q)
 		inst->id, V4L2_TYPE_IS_OUTPUT(q->type) ? "output" : "capture",
 		inst->queued_src_buf_num, inst->processed_buf_num, inst->error_buf_num);
 
+	wave6_vpu_wait_retired(inst);
+
 	if (inst->state == VPU_INST_STATE_NONE)
 		goto exit;
 
@@ -1844,6 +1856,7 @@ static int wave6_vpu_open_dec(struct file *filp)
 	inst->dev = dev;
 	inst->type = VPU_INST_TYPE_DEC;
 	inst->ops = &wave6_vpu_dec_inst_ops;
+	mutex_init(&inst->retire_lock);
 
 	v4l2_fh_init(&inst->v4l2_fh, vdev);
 	filp->private_data = &inst->v4l2_fh;
@@ -1915,6 +1928,7 @@ static int wave6_vpu_dec_release(struct file *filp)
 	v4l2_ctrl_handler_free(&inst->v4l2_ctrl_hdl);
 	v4l2_fh_del(&inst->v4l2_fh);
 	v4l2_fh_exit(&inst->v4l2_fh);
+	mutex_destroy(&inst->retire_lock);
 	kfree(inst);
 
 	return 0;
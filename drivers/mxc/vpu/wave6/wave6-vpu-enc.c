@@ -6,6 +6,7 @@
  */
 
 #include <linux/pm_runtime.h>
+#include <linux/imx_vpu.h>
 #include "wave6-vpu.h"
 #include "wave6-vpu-dbg.h"
 #include "wave6-trace.h"
@@ -429,12 +430,12 @@ static void wave6_vpu_enc_release_fb(struct vpu_instance *inst)
 	int i;
 
 	for (i = 0; i < WAVE6_MAX_FBS; i++) {
-		wave6_free_dma(&inst->frame_vbuf[i]);
+		wave6_vpu_pool_free(inst->dev, &inst->frame_vbuf[i]);
 		memset(&inst->frame_buf[i], 0, sizeof(struct frame_buffer));
-		wave6_free_dma(&inst->aux_vbuf[AUX_BUF_FBC_Y_TBL][i]);
-		wave6_free_dma(&inst->aux_vbuf[AUX_BUF_FBC_C_TBL][i]);
-		wave6_free_dma(&inst->aux_vbuf[AUX_BUF_MV_COL][i]);
-		wave6_free_dma(&inst->aux_vbuf[AUX_BUF_SUB_SAMPLE][i]);
+		wave6_vpu_pool_free(inst->dev, &inst->aux_vbuf[AUX_BUF_FBC_Y_TBL][i]);
+		wave6_vpu_pool_free(inst->dev, &inst->aux_vbuf[AUX_BUF_FBC_C_TBL][i]);
+		wave6_vpu_pool_free(inst->dev, &inst->aux_vbuf[AUX_BUF_MV_COL][i]);
+		wave6_vpu_pool_free(inst->dev, &inst->aux_vbuf[AUX_BUF_SUB_SAMPLE][i]);
 	}
 }
 
@@ -442,6 +443,7 @@ static void wave6_vpu_enc_destroy_instance(struct vpu_instance *inst)
 {
 	u32 fail_res;
 	int ret;
+	ktime_t start = ktime_get();
 
 	dprintk(inst->dev->dev, "[%d] destroy instance\n", inst->id);
 	wave6_vpu_remove_dbgfs_file(inst);
@@ -453,12 +455,14 @@ static void wave6_vpu_enc_destroy_instance(struct vpu_instance *inst)
 	}
 
 	wave6_vpu_enc_release_fb(inst);
-	wave6_free_dma(&inst->ar_vbuf);
+	wave6_vpu_pool_free(inst->dev, &inst->ar_vbuf);
 
 	wave6_vpu_set_instance_state(inst, VPU_INST_STATE_NONE);
 
 	if (!pm_runtime_suspended(inst->dev->dev))
 		pm_runtime_put_sync(inst->dev->dev);
+
+	wave6_vpu_record_latency(&inst->dev->close_latency[inst->type], start);
 }
 
 static struct vb2_v4l2_buffer *wave6_get_valid_src_buf(struct vpu_instance *inst)
@@ -740,7 +744,7 @@ static int wave6_allocate_aux_buffer(struct vpu_instance *inst,
 
 	for (i = 0; i < num; i++) {
 		inst->aux_vbuf[type][i].size = size;
-		ret = wave6_alloc_dma(inst->dev->dev, &inst->aux_vbuf[type][i]);
+		ret = wave6_vpu_pool_alloc(inst->dev, &inst->aux_vbuf[type][i]);
 		if (ret) {
 			dev_err(inst->dev->dev, "%s: Alloc fail (type %d)\n", __func__, type);
 			return ret;
@@ -984,7 +988,6 @@ static void wave6_handle_encoded_frame(struct vpu_instance *inst,
 	wave6_vpu_handle_performance(inst, dst_vpu_buf);
 
 	v4l2_m2m_buf_copy_metadata(src_buf, dst_buf, true);
-	v4l2_m2m_buf_done(src_buf, state);
 
 	vb2_set_plane_payload(&dst_buf->vb2_buf, 0, info->bitstream_size);
 	dst_buf->sequence = inst->sequence++;
@@ -1004,7 +1007,9 @@ static void wave6_handle_encoded_frame(struct vpu_instance *inst,
 	}
 	wave6_vpu_force_dma_sync_single_for_cpu(inst->dev, info->bitstream_buffer,
 						info->bitstream_size, DMA_BIDIRECTIONAL);
+	/* hand the bitstream to the consumer before recycling the source */
 	v4l2_m2m_buf_done(dst_buf, state);
+	v4l2_m2m_buf_done(src_buf, state);
 	inst->processed_buf_num++;
 }
 
@@ -1055,11 +1060,16 @@ static void wave6_vpu_enc_finish_encode(struct vpu_instance *inst, bool error)
 
 	trace_enc_done(inst, &info);
 
+	wave6_vpu_retire_job(inst);
+
 	if (info.enc_src_idx >= 0 && info.recon_frame_index >= 0)
 		wave6_handle_encoded_frame(inst, &info);
 	else if (info.recon_frame_index == RECON_IDX_FLAG_ENC_END)
 		wave6_handle_last_frame(inst, info.bitstream_buffer);
 
+	wave6_vpu_retire_done(inst);
+	return;
+
 finish_encode:
 	wave6_vpu_finish_job(inst);
 }
@@ -1786,6 +1796,9 @@ static int wave6_vpu_enc_s_ctrl(struct v4l2_ctrl *ctrl)
 	case V4L2_CID_MPEG_VIDEO_ROI_MAP_DELTA_QP:
 		wave6_vpu_enc_set_roi_map(inst, ctrl->p_new.p, ctrl->new_elems);
 		break;
+	case V4L2_CID_LOW_LATENCY_MODE:
+		p->low_latency = ctrl->val;
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -1812,6 +1825,17 @@ static const struct v4l2_ctrl_config wave6_vpu_enc_ctrl_roi_block_size = {
 	.type = V4L2_CTRL_TYPE_AREA,
 };
 
+static const struct v4l2_ctrl_config wave6_vpu_enc_ctrl_low_latency = {
+	.ops = &wave6_vpu_enc_ctrl_ops,
+	.id = V4L2_CID_LOW_LATENCY_MODE,
+	.name = "Low Latency Mode",
+	.type = V4L2_CTRL_TYPE_BOOLEAN,
+	.min = 0,
+	.max = 1,
+	.step = 1,
+	.def = 0,
+};
+
 static u32 to_video_full_range_flag(enum v4l2_quantization quantization)
 {
 	switch (quantization) {
@@ -2132,6 +2156,7 @@ static void wave6_set_enc_open_param(struct enc_open_param *open_param,
 	struct enc_codec_param *output = &open_param->codec_param;
 	u32 ctu_size = (inst->std == W_AVC_ENC) ? 16 : 64;
 	u32 num_ctu_row = ALIGN(inst->src_fmt.height, ctu_size) / ctu_size;
+	u32 num_ctu_col = ALIGN(inst->codec_rect.width, ctu_size) / ctu_size;
 	const struct vpu_format *vpu_fmt;
 
 	vpu_fmt = wave6_find_vpu_fmt(inst->src_fmt.pixelformat, VPU_FMT_TYPE_RAW);
@@ -2175,6 +2200,20 @@ static void wave6_set_enc_open_param(struct enc_open_param *open_param,
 	output->slice_arg = ctrls->slice_max_mb;
 	output->forced_idr_header = ctrls->prepend_spspps_to_idr;
 	output->en_vbv_overflow_drop_frame = (ctrls->frame_skip_mode) ? 1 : 0;
+	if (ctrls->low_latency) {
+		/*
+		 * One slice per CTU row lets the sender packetize and the
+		 * receiver decode rows independently, and a CPB of one frame
+		 * interval keeps every frame transmittable within its own
+		 * frame time.
+		 */
+		if (output->slice_mode == V4L2_MPEG_VIDEO_MULTI_SLICE_MODE_SINGLE) {
+			output->slice_mode = V4L2_MPEG_VIDEO_MULTI_SLICE_MODE_MAX_MB;
+			output->slice_arg = num_ctu_col;
+		}
+		output->cpb_size = max_t(u32, 10, DIV_ROUND_UP(MSEC_PER_SEC,
+							       max_t(u32, inst->frame_rate, 1)));
+	}
 	if (ctrls->intra_refresh_period) {
 		output->intra_refresh_mode = INTRA_REFRESH_ROW;
 		// Calculate number of CTU rows based on number of frames.
@@ -2222,6 +2261,7 @@ static int wave6_vpu_enc_create_instance(struct vpu_instance *inst)
 {
 	int ret;
 	struct enc_open_param open_param;
+	ktime_t start = ktime_get();
 
 	memset(&open_param, 0, sizeof(struct enc_open_param));
 
@@ -2235,7 +2275,7 @@ static int wave6_vpu_enc_create_instance(struct vpu_instance *inst)
 	wave6_vpu_wait_activated(inst->dev);
 
 	inst->ar_vbuf.size = ALIGN(WAVE6_ARBUF_SIZE, 4096);
-	ret = wave6_alloc_dma(inst->dev->dev, &inst->ar_vbuf);
+	ret = wave6_vpu_pool_alloc(inst->dev, &inst->ar_vbuf);
 	if (ret) {
 		dev_err(inst->dev->dev, "alloc ar of size %zu failed\n",
 			inst->ar_vbuf.size);
@@ -2253,11 +2293,12 @@ static int wave6_vpu_enc_create_instance(struct vpu_instance *inst)
 	dprintk(inst->dev->dev, "[%d] encoder\n", inst->id);
 	wave6_vpu_create_dbgfs_file(inst);
 	wave6_vpu_set_instance_state(inst, VPU_INST_STATE_OPEN);
+	wave6_vpu_record_latency(&inst->dev->open_latency[inst->type], start);
 
 	return 0;
 
 error_open:
-	wave6_free_dma(&inst->ar_vbuf);
+	wave6_vpu_pool_free(inst->dev, &inst->ar_vbuf);
 error_pm:
 	pm_runtime_put_sync(inst->dev->dev);
 	return ret;
@@ -2337,7 +2378,7 @@ static int wave6_vpu_enc_prepare_fb(struct vpu_instance *inst)
 		struct vpu_buf *vframe = &inst->frame_vbuf[i];
 
 		vframe->size = luma_size + chroma_size;
-		ret = wave6_alloc_dma(inst->dev->dev, vframe);
+		ret = wave6_vpu_pool_alloc(inst->dev, vframe);
 		if (ret) {
 			dev_err(inst->dev->dev, "alloc FBC buffer fail : %zu\n",
 				vframe->size);
@@ -2580,6 +2621,8 @@ static void wave6_vpu_enc_stop_streaming(struct vb2_queue *q)
 		inst->id, V4L2_TYPE_IS_OUTPUT(q->type) ? "output" : "capture",
 		inst->queued_src_buf_num, inst->sequence);
 
+	wave6_vpu_wait_retired(inst);
+
 	if (inst->state == VPU_INST_STATE_NONE)
 		goto exit;
 
@@ -2704,6 +2747,7 @@ static int wave6_vpu_open_enc(struct file *filp)
 	inst->dev = dev;
 	inst->type = VPU_INST_TYPE_ENC;
 	inst->ops = &wave6_vpu_enc_inst_ops;
+	mutex_init(&inst->retire_lock);
 
 	v4l2_fh_init(&inst->v4l2_fh, vdev);
 	filp->private_data = &inst->v4l2_fh;
@@ -2895,6 +2939,7 @@ static int wave6_vpu_open_enc(struct file *filp)
 			       V4L2_MPEG_VIDEO_ROI_MODE_NONE);
 	v4l2_ctrl_new_custom(v4l2_ctrl_hdl, &wave6_vpu_enc_ctrl_roi_map, NULL);
 	v4l2_ctrl_new_custom(v4l2_ctrl_hdl, &wave6_vpu_enc_ctrl_roi_block_size, NULL);
+	v4l2_ctrl_new_custom(v4l2_ctrl_hdl, &wave6_vpu_enc_ctrl_low_latency, NULL);
 
 	if (v4l2_ctrl_hdl->error) {
 		ret = -ENODEV;
@@ -2951,6 +2996,7 @@ static int wave6_vpu_enc_release(struct file *filp)
 	v4l2_ctrl_handler_free(&inst->v4l2_ctrl_hdl);
 	v4l2_fh_del(&inst->v4l2_fh);
 	v4l2_fh_exit(&inst->v4l2_fh);
+	mutex_destroy(&inst->retire_lock);
 	kfree(inst);
 
 	return 0;
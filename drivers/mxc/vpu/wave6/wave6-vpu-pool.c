@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: (GPL-2.0 OR BSD-3-Clause)
+/*
+ * Wave6 series multi-standard codec IP - instance buffer pool
+ *
+ * Frame buffers and auxiliary buffers of an instance are only accessed
+ * by the VPU. Instead of returning them to the DMA allocator when a
+ * stream stops, keep them in a device-wide pool so that the next stream
+ * with the same codec and resolution class finds them ready.
+ *
+ * Copyright 2026 NXP
+ */
+
+#include <linux/dma-mapping.h>
+#include <linux/log2.h>
+#include <linux/module.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include "wave6-vpuapi.h"
+
+static unsigned int pool_max_kb = 131072;
+module_param(pool_max_kb, uint, 0644);
+MODULE_PARM_DESC(pool_max_kb,
+		 "maximum amount of released instance buffers kept for reuse, in KiB");
+
+struct vpu_buf_pool_entry {
+	struct list_head list;
+	struct vpu_buf vb;
+};
+
+/*
+ * Buffer sizes follow from the codec and the aligned picture size. Round
+ * them up to a quarter of their power of two so that nearby resolutions
+ * of one codec share a class, wasting at most 25%.
+ */
+static size_t wave6_vpu_pool_class(size_t size)
+{
+	size = PAGE_ALIGN(size);
+	if (size <= 4 * PAGE_SIZE)
+		return size;
+
+	return round_up(size, rounddown_pow_of_two(size) / 4);
+}
+
+int wave6_vpu_pool_alloc(struct vpu_device *vpu_dev, struct vpu_buf *vb)
+{
+	struct vpu_buf_pool *pool = &vpu_dev->buf_pool;
+	struct vpu_buf_pool_entry *entry, *found = NULL;
+	size_t size;
+
+	if (!vb || !vb->size)
+		return -EINVAL;
+
+	size = wave6_vpu_pool_class(vb->size);
+
+	mutex_lock(&pool->lock);
+	list_for_each_entry(entry, &pool->free, list) {
+		if (entry->vb.size == size) {
+			found = entry;
+			list_del(&entry->list);
+			pool->cached -= size;
+			break;
+		}
+	}
+	if (found)
+		pool->hits++;
+	else
+		pool->misses++;
+	mutex_unlock(&pool->lock);
+
+	if (found) {
+		*vb = found->vb;
+		kfree(found);
+		return 0;
+	}
+
+	vb->size = size;
+	return wave6_alloc_dma(vpu_dev->dev, vb);
+}
+
+void wave6_vpu_pool_free(struct vpu_device *vpu_dev, struct vpu_buf *vb)
+{
+	struct vpu_buf_pool *pool = &vpu_dev->buf_pool;
+	struct vpu_buf_pool_entry *entry, *tmp;
+	size_t max = (size_t)pool_max_kb * SZ_1K;
+	LIST_HEAD(evicted);
+
+	if (!vb || !vb->size || !vb->vaddr)
+		return;
+
+	entry = kmalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry || vb->size > max) {
+		kfree(entry);
+		wave6_free_dma(vb);
+		return;
+	}
+
+	entry->vb = *vb;
+	memset(vb, 0, sizeof(*vb));
+
+	mutex_lock(&pool->lock);
+	list_add(&entry->list, &pool->free);
+	pool->cached += entry->vb.size;
+
+	while (pool->cached > max) {
+		tmp = list_last_entry(&pool->free, struct vpu_buf_pool_entry, list);
+		list_move(&tmp->list, &evicted);
+		pool->cached -= tmp->vb.size;
+		pool->evictions++;
+	}
+	mutex_unlock(&pool->lock);
+
+	list_for_each_entry_safe(entry, tmp, &evicted, list) {
+		wave6_free_dma(&entry->vb);
+		kfree(entry);
+	}
+}
+
+void wave6_vpu_pool_init(struct vpu_device *vpu_dev)
+{
+	struct vpu_buf_pool *pool = &vpu_dev->buf_pool;
+
+	mutex_init(&pool->lock);
+	INIT_LIST_HEAD(&pool->free);
+}
+
+void wave6_vpu_pool_release(struct vpu_device *vpu_dev)
+{
+	struct vpu_buf_pool *pool = &vpu_dev->buf_pool;
+	struct vpu_buf_pool_entry *entry, *tmp;
+
+	list_for_each_entry_safe(entry, tmp, &pool->free, list) {
+		wave6_free_dma(&entry->vb);
+		kfree(entry);
+	}
+	pool->cached = 0;
+	mutex_destroy(&pool->lock);
+}
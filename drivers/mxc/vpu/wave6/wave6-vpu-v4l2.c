@@ -242,6 +242,8 @@ static int wave6_vpu_job_ready(void *priv)
 	dev_dbg(inst->dev->dev, "[%d]%s: state %d\n",
 		inst->id, __func__, inst->state);
 
+	if (READ_ONCE(inst->retiring))
+		return 0;
 	if (inst->type == VPU_INST_TYPE_DEC && inst->state == VPU_INST_STATE_OPEN)
 		return 1;
 	if (inst->state < VPU_INST_STATE_PIC_RUN)
@@ -305,6 +307,33 @@ void wave6_vpu_finish_job(struct vpu_instance *inst)
 	v4l2_m2m_job_finish(inst->dev->m2m_dev, inst->v4l2_fh.m2m_ctx);
 }
 
+/*
+ * The VPU runs a single command at a time, so once the output info of a
+ * command has been fetched there is nothing left for this instance on the
+ * hardware side. Finish the m2m job right away so the next instance can be
+ * started while the buffers of this one are synced and handed back, and
+ * keep this instance off the job queue until wave6_vpu_retire_done().
+ */
+void wave6_vpu_retire_job(struct vpu_instance *inst)
+{
+	mutex_lock(&inst->retire_lock);
+	WRITE_ONCE(inst->retiring, true);
+	wave6_vpu_finish_job(inst);
+}
+
+void wave6_vpu_retire_done(struct vpu_instance *inst)
+{
+	WRITE_ONCE(inst->retiring, false);
+	mutex_unlock(&inst->retire_lock);
+	v4l2_m2m_try_schedule(inst->v4l2_fh.m2m_ctx);
+}
+
+void wave6_vpu_wait_retired(struct vpu_instance *inst)
+{
+	mutex_lock(&inst->retire_lock);
+	mutex_unlock(&inst->retire_lock);
+}
+
 void wave6_vpu_handle_performance(struct vpu_instance *inst, struct vpu_buffer *vpu_buf)
 {
 	s64 latency, time_spent;
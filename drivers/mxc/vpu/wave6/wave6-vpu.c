@@ -358,6 +358,9 @@ static int wave6_vpu_probe(struct platform_device *pdev)
 	if (IS_ERR_OR_NULL(dev->debugfs))
 		dev->debugfs = debugfs_create_dir(WAVE6_VPU_DEBUGFS_DIR, NULL);
 
+	wave6_vpu_pool_init(dev);
+	wave6_vpu_create_dev_dbgfs_file(dev);
+
 	pm_runtime_enable(&pdev->dev);
 
 	if (dev->res->codec_types & WAVE6_IS_DEC) {
@@ -402,6 +405,8 @@ static int wave6_vpu_probe(struct platform_device *pdev)
 	if (dev->res->codec_types & WAVE6_IS_DEC)
 		wave6_vpu_dec_unregister_device(dev);
 err_temp_vbuf_free:
+	wave6_vpu_remove_dev_dbgfs_file(dev);
+	wave6_vpu_pool_release(dev);
 	wave6_free_dma(&dev->temp_vbuf);
 err_kfifo_free:
 	kfifo_free(&dev->irq_status);
@@ -425,6 +430,8 @@ static void wave6_vpu_remove(struct platform_device *pdev)
 
 	wave6_vpu_enc_unregister_device(dev);
 	wave6_vpu_dec_unregister_device(dev);
+	wave6_vpu_remove_dev_dbgfs_file(dev);
+	wave6_vpu_pool_release(dev);
 	wave6_free_dma(&dev->temp_vbuf);
 	kfifo_free(&dev->irq_status);
 	wave6_vpu_release_m2m_dev(dev);
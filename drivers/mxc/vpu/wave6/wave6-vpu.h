@@ -115,6 +115,9 @@ void wave6_vpu_dec_unregister_device(struct vpu_device *dev);
 int  wave6_vpu_enc_register_device(struct vpu_device *dev);
 void wave6_vpu_enc_unregister_device(struct vpu_device *dev);
 void wave6_vpu_finish_job(struct vpu_instance *inst);
+void wave6_vpu_retire_job(struct vpu_instance *inst);
+void wave6_vpu_retire_done(struct vpu_instance *inst);
+void wave6_vpu_wait_retired(struct vpu_instance *inst);
 void wave6_vpu_handle_performance(struct vpu_instance *inst, struct vpu_buffer *vpu_buf);
 void wave6_vpu_reset_performance(struct vpu_instance *inst);
 int wave6_vpu_init_m2m_dev(struct vpu_device *dev);
@@ -456,17 +456,17 @@ int wave6_vpu_dec_give_command(struct vpu_instance *inst, enum codec_command cmd
 		int i;
 
 		for (i = 0; i < WAVE6_MAX_FBS; i++) {
-			wave6_free_dma(&inst->frame_vbuf[i]);
+			wave6_vpu_pool_free(inst->dev, &inst->frame_vbuf[i]);
 			memset(&inst->frame_buf[i], 0, sizeof(struct frame_buffer));
 			memset(&p_dec_info->disp_buf[i], 0, sizeof(struct frame_buffer));
 
-			wave6_free_dma(&inst->aux_vbuf[AUX_BUF_MV_COL][i]);
+			wave6_vpu_pool_free(inst->dev, &inst->aux_vbuf[AUX_BUF_MV_COL][i]);
 			memset(&p_dec_info->vb_mv[i], 0, sizeof(struct vpu_buf));
 
-			wave6_free_dma(&inst->aux_vbuf[AUX_BUF_FBC_Y_TBL][i]);
+			wave6_vpu_pool_free(inst->dev, &inst->aux_vbuf[AUX_BUF_FBC_Y_TBL][i]);
 			memset(&p_dec_info->vb_fbc_y_tbl[i], 0, sizeof(struct vpu_buf));
 
-			wave6_free_dma(&inst->aux_vbuf[AUX_BUF_FBC_C_TBL][i]);
+			wave6_vpu_pool_free(inst->dev, &inst->aux_vbuf[AUX_BUF_FBC_C_TBL][i]);
 			memset(&p_dec_info->vb_fbc_c_tbl[i], 0, sizeof(struct vpu_buf));
 		}
 		break;
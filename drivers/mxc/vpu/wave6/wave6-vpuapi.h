@@ -883,6 +883,24 @@ struct enc_controls {
 	struct hevc_enc_controls hevc;
 	u32 force_key_frame;
 	u32 frame_skip_mode;
+	u32 low_latency;
+};
+
+/* released instance buffers, see wave6-vpu-pool.c */
+struct vpu_buf_pool {
+	struct mutex lock; /* protects the free list and counters */
+	struct list_head free;
+	size_t cached;
+	u64 hits;
+	u64 misses;
+	u64 evictions;
+};
+
+struct vpu_latency_info {
+	u64 count;
+	s64 last;
+	s64 max;
+	u64 total;
 };
 
 struct vpu_device {
@@ -915,6 +933,11 @@ struct vpu_device {
 	struct mutex pause_lock; /* the lock for the pause/resume m2m job. */
 	const struct wave6_match_data *res;
 	struct dentry *debugfs;
+	struct dentry *debugfs_pool;
+
+	struct vpu_buf_pool buf_pool;
+	struct vpu_latency_info open_latency[2];
+	struct vpu_latency_info close_latency[2];
 
 	bool force_dma_sync;
 };
@@ -998,6 +1021,14 @@ struct vpu_instance {
 
 	struct vpu_performance_info performance;
 
+	/*
+	 * Set while the buffers of a finished command are handed back after
+	 * the VPU has been released to the next instance, see
+	 * wave6_vpu_retire_job().
+	 */
+	struct mutex retire_lock;
+	bool retiring;
+
 	struct dentry *debugfs;
 
 	int roi_mode;
@@ -1009,6 +1040,11 @@ void wave6_vdi_writel(struct vpu_device *vpu_device, unsigned int addr, unsigned
 unsigned int wave6_vdi_readl(struct vpu_device *vpu_dev, unsigned int addr);
 unsigned int wave6_vdi_convert_endian(unsigned int endian);
 
+int wave6_vpu_pool_alloc(struct vpu_device *vpu_dev, struct vpu_buf *vb);
+void wave6_vpu_pool_free(struct vpu_device *vpu_dev, struct vpu_buf *vb);
+void wave6_vpu_pool_init(struct vpu_device *vpu_dev);
+void wave6_vpu_pool_release(struct vpu_device *vpu_dev);
+
 int wave6_vpu_dec_open(struct vpu_instance *inst, struct dec_open_param *pop);
 int wave6_vpu_dec_close(struct vpu_instance *inst, u32 *fail_res);
 int wave6_vpu_dec_issue_seq_init(struct vpu_instance *inst);
@@ -16,6 +16,7 @@
 #include <linux/can/error.h>
 #include <linux/clk.h>
 #include <linux/delay.h>
+#include <linux/dma-mapping.h>
 #include <linux/firmware/imx/sci.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
@@ -55,6 +56,7 @@
 #define FLEXCAN_MCR_DOZE		BIT(18)
 #define FLEXCAN_MCR_SRX_DIS		BIT(17)
 #define FLEXCAN_MCR_IRMQ		BIT(16)
+#define FLEXCAN_MCR_DMA			BIT(15)
 #define FLEXCAN_MCR_LPRIO_EN		BIT(13)
 #define FLEXCAN_MCR_AEN			BIT(12)
 #define FLEXCAN_MCR_FDEN		BIT(11)
@@ -164,6 +166,44 @@
 #define FLEXCAN_FDCTRL_TDCOFF		GENMASK(12, 8)
 #define FLEXCAN_FDCTRL_TDCVAL		GENMASK(5, 0)
 
+/* FLEXCAN enhanced RX FIFO control register (ERFCR) bits */
+#define FLEXCAN_ERFCR_ERFEN		BIT(31)
+#define FLEXCAN_ERFCR_DMALW		GENMASK(30, 26)
+#define FLEXCAN_ERFCR_NEXIF		GENMASK(22, 16)
+#define FLEXCAN_ERFCR_NFE		GENMASK(13, 8)
+#define FLEXCAN_ERFCR_ERFWM		GENMASK(4, 0)
+
+/* FLEXCAN enhanced RX FIFO interrupt enable register (ERFIER) bits */
+#define FLEXCAN_ERFIER_ERFUFWIE		BIT(31)
+#define FLEXCAN_ERFIER_ERFOVFIE		BIT(30)
+#define FLEXCAN_ERFIER_ERFWMIIE		BIT(29)
+#define FLEXCAN_ERFIER_ERFDAIE		BIT(28)
+
+/* FLEXCAN enhanced RX FIFO status register (ERFSR) bits */
+#define FLEXCAN_ERFSR_ERFUFW		BIT(31)
+#define FLEXCAN_ERFSR_ERFOVF		BIT(30)
+#define FLEXCAN_ERFSR_ERFWMI		BIT(29)
+#define FLEXCAN_ERFSR_ERFDA		BIT(28)
+#define FLEXCAN_ERFSR_ERFCLR		BIT(27)
+#define FLEXCAN_ERFSR_ERFEL		GENMASK(5, 0)
+#define FLEXCAN_ERFSR_INT_ALL		(FLEXCAN_ERFSR_ERFUFW | \
+					 FLEXCAN_ERFSR_ERFOVF | \
+					 FLEXCAN_ERFSR_ERFWMI)
+
+/* FLEXCAN enhanced RX FIFO filter elements (ERFFEL), "ID and mask" scheme */
+#define FLEXCAN_ERFFEL_FSCH		GENMASK(31, 30)
+#define FLEXCAN_ERFFEL_FSCH_MASK	0x0
+
+/* Enhanced RX FIFO output buffer and filter elements, outside of the
+ * legacy register map
+ */
+#define FLEXCAN_ERF_OUTPUT		0x2000
+#define FLEXCAN_ERFFEL(n)		(0x3000 + (n) * sizeof(u32))
+/* CS and ID words followed by the payload */
+#define FLEXCAN_ERF_FRAME_WORDS(len)	(2 + (len) / sizeof(u32))
+/* Size of the DMA ring the enhanced RX FIFO is drained into, in frames */
+#define FLEXCAN_ERF_DMA_FRAMES		64
+
 /* FLEXCAN FD Bit Timing register (FDCBT) bits */
 #define FLEXCAN_FDCBT_FPRESDIV_MASK	GENMASK(29, 20)
 #define FLEXCAN_FDCBT_FRJW_MASK		GENMASK(18, 16)
@@ -282,7 +322,10 @@ struct flexcan_regs {
 	u32 fdctrl;		/* 0xc00 - Not affected by Soft Reset */
 	u32 fdcbt;		/* 0xc04 - Not affected by Soft Reset */
 	u32 fdcrc;		/* 0xc08 */
-	u32 _reserved9[199];	/* 0xc0c */
+	u32 erfcr;		/* 0xc0c */
+	u32 erfier;		/* 0xc10 */
+	u32 erfsr;		/* 0xc14 */
+	u32 _reserved9[196];	/* 0xc18 */
 	struct_group(init_fd,
 		u32 tx_smb_fd[18];	/* 0xf28 */
 		u32 rx_smb0_fd[18];	/* 0xf70 */
@@ -292,6 +335,11 @@ struct flexcan_regs {
 
 static_assert(sizeof(struct flexcan_regs) ==  0x4 * 18 + 0xfb8);
 
+static unsigned int erf_watermark = 1;
+module_param(erf_watermark, uint, 0644);
+MODULE_PARM_DESC(erf_watermark,
+		 "Frames delivered at once from the enhanced RX FIFO, frames wait until that many are pending (1-20)");
+
 static const struct flexcan_devtype_data fsl_mcf5441x_devtype_data = {
 	.quirks = FLEXCAN_QUIRK_BROKEN_PERR_STATE |
 		FLEXCAN_QUIRK_NR_IRQ_3 | FLEXCAN_QUIRK_NR_MB_16 |
@@ -351,7 +399,8 @@ static struct flexcan_devtype_data fsl_imx93_devtype_data = {
 		FLEXCAN_QUIRK_BROKEN_PERR_STATE | FLEXCAN_QUIRK_SETUP_STOP_MODE_GPR |
 		FLEXCAN_QUIRK_SUPPORT_FD | FLEXCAN_QUIRK_SUPPORT_ECC |
 		FLEXCAN_QUIRK_SUPPORT_RX_MAILBOX |
-		FLEXCAN_QUIRK_SUPPORT_RX_MAILBOX_RTR,
+		FLEXCAN_QUIRK_SUPPORT_RX_MAILBOX_RTR |
+		FLEXCAN_QUIRK_SUPPORT_RX_ENH_FIFO,
 };
 
 static const struct flexcan_devtype_data fsl_imx95_devtype_data = {
@@ -359,7 +408,8 @@ static const struct flexcan_devtype_data fsl_imx95_devtype_data = {
 		FLEXCAN_QUIRK_DISABLE_MECR | FLEXCAN_QUIRK_USE_RX_MAILBOX |
 		FLEXCAN_QUIRK_BROKEN_PERR_STATE | FLEXCAN_QUIRK_SUPPORT_FD |
 		FLEXCAN_QUIRK_SUPPORT_ECC | FLEXCAN_QUIRK_SUPPORT_RX_MAILBOX |
-		FLEXCAN_QUIRK_SUPPORT_RX_MAILBOX_RTR | FLEXCAN_QUIRK_SETUP_STOP_MODE_SCMI,
+		FLEXCAN_QUIRK_SUPPORT_RX_MAILBOX_RTR | FLEXCAN_QUIRK_SETUP_STOP_MODE_SCMI |
+		FLEXCAN_QUIRK_SUPPORT_RX_ENH_FIFO,
 };
 
 static const struct flexcan_devtype_data fsl_vf610_devtype_data = {
@@ -777,8 +827,11 @@ static int flexcan_get_berr_counter(const struct net_device *dev,
 
 static netdev_tx_t flexcan_start_xmit(struct sk_buff *skb, struct net_device *dev)
 {
-	const struct flexcan_priv *priv = netdev_priv(dev);
+	struct flexcan_priv *priv = netdev_priv(dev);
 	struct canfd_frame *cfd = (struct canfd_frame *)skb->data;
+	struct flexcan_mb __iomem *mb;
+	unsigned long flags;
+	unsigned int idx;
 	u32 can_id;
 	u32 data;
 	u32 ctrl = FLEXCAN_MB_CODE_TX_DATA | ((can_fd_len2dlc(cfd->len)) << 16);
@@ -787,7 +840,22 @@ static netdev_tx_t flexcan_start_xmit(struct sk_buff *skb, struct net_device *de
 	if (can_dev_dropped_skb(dev, skb))
 		return NETDEV_TX_OK;
 
-	netif_stop_queue(dev);
+	/* The TX mailboxes are filled in ascending order and the core
+	 * transmits the lowest pending mailbox first (CTRL_LBUF), so the
+	 * frames leave in queue order. Wrapping around would put a frame
+	 * in front of older ones, so the queue is stopped at the end of
+	 * the ring and restarted once all its mailboxes are done.
+	 */
+	spin_lock_irqsave(&priv->tx_lock, flags);
+	idx = priv->tx_next++;
+	priv->tx_busy |= BIT(idx);
+	if (priv->tx_next == priv->tx_mb_count) {
+		netif_stop_queue(dev);
+		priv->tx_queue_stops++;
+	}
+	spin_unlock_irqrestore(&priv->tx_lock, flags);
+
+	mb = flexcan_get_mb(priv, priv->tx_mb_first + idx);
 
 	if (cfd->can_id & CAN_EFF_FLAG) {
 		can_id = cfd->can_id & CAN_EFF_MASK;
@@ -808,13 +876,13 @@ static netdev_tx_t flexcan_start_xmit(struct sk_buff *skb, struct net_device *de
 
 	for (i = 0; i < cfd->len; i += sizeof(u32)) {
 		data = be32_to_cpup((__be32 *)&cfd->data[i]);
-		priv->write(data, &priv->tx_mb->data[i / sizeof(u32)]);
+		priv->write(data, &mb->data[i / sizeof(u32)]);
 	}
 
-	can_put_echo_skb(skb, dev, 0, 0);
+	can_put_echo_skb(skb, dev, idx, 0);
 
-	priv->write(can_id, &priv->tx_mb->can_id);
-	priv->write(ctrl, &priv->tx_mb->can_ctrl);
+	priv->write(can_id, &mb->can_id);
+	priv->write(ctrl, &mb->can_ctrl);
 
 	/* Errata ERR005829 step8:
 	 * Write twice INACTIVE(0x8) code to first MB.
@@ -971,6 +1039,48 @@ static inline struct flexcan_priv *rx_offload_to_priv(struct can_rx_offload *off
 	return container_of(offload, struct flexcan_priv, offload);
 }
 
+/* Allocate an skb for a received frame and fill in everything but the
+ * payload from the CS and ID words of its mailbox or FIFO element.
+ */
+static struct sk_buff *flexcan_alloc_rx_skb(struct net_device *dev,
+					    u32 reg_ctrl, u32 reg_id,
+					    struct canfd_frame **cfdp)
+{
+	struct canfd_frame *cfd;
+	struct sk_buff *skb;
+
+	if (reg_ctrl & FLEXCAN_MB_CNT_EDL)
+		skb = alloc_canfd_skb(dev, &cfd);
+	else
+		skb = alloc_can_skb(dev, (struct can_frame **)&cfd);
+	if (unlikely(!skb))
+		return NULL;
+
+	if (reg_ctrl & FLEXCAN_MB_CNT_IDE)
+		cfd->can_id = ((reg_id >> 0) & CAN_EFF_MASK) | CAN_EFF_FLAG;
+	else
+		cfd->can_id = (reg_id >> 18) & CAN_SFF_MASK;
+
+	if (reg_ctrl & FLEXCAN_MB_CNT_EDL) {
+		cfd->len = can_fd_dlc2len((reg_ctrl >> 16) & 0xf);
+
+		if (reg_ctrl & FLEXCAN_MB_CNT_BRS)
+			cfd->flags |= CANFD_BRS;
+	} else {
+		cfd->len = can_cc_dlc2len((reg_ctrl >> 16) & 0xf);
+
+		if (reg_ctrl & FLEXCAN_MB_CNT_RTR)
+			cfd->can_id |= CAN_RTR_FLAG;
+	}
+
+	if (reg_ctrl & FLEXCAN_MB_CNT_ESI)
+		cfd->flags |= CANFD_ESI;
+
+	*cfdp = cfd;
+
+	return skb;
+}
+
 static struct sk_buff *flexcan_mailbox_read(struct can_rx_offload *offload,
 					    unsigned int n, u32 *timestamp,
 					    bool drop)
@@ -1016,10 +1126,8 @@ static struct sk_buff *flexcan_mailbox_read(struct can_rx_offload *offload,
 		goto mark_as_read;
 	}
 
-	if (reg_ctrl & FLEXCAN_MB_CNT_EDL)
-		skb = alloc_canfd_skb(offload->dev, &cfd);
-	else
-		skb = alloc_can_skb(offload->dev, (struct can_frame **)&cfd);
+	reg_id = priv->read(&mb->can_id);
+	skb = flexcan_alloc_rx_skb(offload->dev, reg_ctrl, reg_id, &cfd);
 	if (unlikely(!skb)) {
 		skb = ERR_PTR(-ENOMEM);
 		goto mark_as_read;
@@ -1028,27 +1136,6 @@ static struct sk_buff *flexcan_mailbox_read(struct can_rx_offload *offload,
 	/* increase timstamp to full 32 bit */
 	*timestamp = reg_ctrl << 16;
 
-	reg_id = priv->read(&mb->can_id);
-	if (reg_ctrl & FLEXCAN_MB_CNT_IDE)
-		cfd->can_id = ((reg_id >> 0) & CAN_EFF_MASK) | CAN_EFF_FLAG;
-	else
-		cfd->can_id = (reg_id >> 18) & CAN_SFF_MASK;
-
-	if (reg_ctrl & FLEXCAN_MB_CNT_EDL) {
-		cfd->len = can_fd_dlc2len((reg_ctrl >> 16) & 0xf);
-
-		if (reg_ctrl & FLEXCAN_MB_CNT_BRS)
-			cfd->flags |= CANFD_BRS;
-	} else {
-		cfd->len = can_cc_dlc2len((reg_ctrl >> 16) & 0xf);
-
-		if (reg_ctrl & FLEXCAN_MB_CNT_RTR)
-			cfd->can_id |= CAN_RTR_FLAG;
-	}
-
-	if (reg_ctrl & FLEXCAN_MB_CNT_ESI)
-		cfd->flags |= CANFD_ESI;
-
 	for (i = 0; i < cfd->len; i += sizeof(u32)) {
 		__be32 data = cpu_to_be32(priv->read(&mb->data[i / sizeof(u32)]));
 		*(__be32 *)(cfd->data + i) = data;
@@ -1069,10 +1156,288 @@ static struct sk_buff *flexcan_mailbox_read(struct can_rx_offload *offload,
 	return skb;
 }
 
-static irqreturn_t flexcan_irq(int irq, void *dev_id)
+static void flexcan_erf_queue_skb(struct net_device *dev,
+				  struct sk_buff *skb, u32 reg_ctrl)
+{
+	struct flexcan_priv *priv = netdev_priv(dev);
+
+	if (unlikely(!skb)) {
+		dev->stats.rx_dropped++;
+		return;
+	}
+
+	/* increase timstamp to full 32 bit */
+	if (can_rx_offload_queue_timestamp(&priv->offload, skb,
+					   reg_ctrl << 16)) {
+		dev->stats.rx_dropped++;
+		dev->stats.rx_fifo_errors++;
+	}
+}
+
+/* Drain the enhanced RX FIFO through MMIO. This is the fallback when no
+ * DMA channel is available, the watermark interrupt still lets a busy
+ * bus be served in batches.
+ */
+static void flexcan_erf_read(struct net_device *dev)
+{
+	struct flexcan_priv *priv = netdev_priv(dev);
+	struct flexcan_regs __iomem *regs = priv->regs;
+	void __iomem *out = (void __iomem *)regs + FLEXCAN_ERF_OUTPUT;
+	struct canfd_frame *cfd;
+	struct sk_buff *skb;
+	u32 reg_ctrl, reg_id;
+	unsigned int count;
+	int i;
+
+	count = FIELD_GET(FLEXCAN_ERFSR_ERFEL, priv->read(&regs->erfsr));
+	while (count--) {
+		reg_ctrl = priv->read(out);
+		reg_id = priv->read(out + sizeof(u32));
+
+		skb = flexcan_alloc_rx_skb(dev, reg_ctrl, reg_id, &cfd);
+		if (skb) {
+			for (i = 0; i < cfd->len; i += sizeof(u32)) {
+				__be32 data = cpu_to_be32(priv->read(out + 2 * sizeof(u32) + i));
+				*(__be32 *)(cfd->data + i) = data;
+			}
+		}
+		flexcan_erf_queue_skb(dev, skb, reg_ctrl);
+
+		/* release the element, the next one moves to the output */
+		priv->write(FLEXCAN_ERFSR_ERFDA, &regs->erfsr);
+	}
+}
+
+static void flexcan_irq_erf(struct net_device *dev, u32 reg_erfsr)
+{
+	struct flexcan_priv *priv = netdev_priv(dev);
+	struct flexcan_regs __iomem *regs = priv->regs;
+
+	if (reg_erfsr & FLEXCAN_ERFSR_ERFOVF) {
+		dev->stats.rx_over_errors++;
+		dev->stats.rx_errors++;
+	}
+
+	if (reg_erfsr & FLEXCAN_ERFSR_ERFUFW)
+		netdev_dbg(dev, "enhanced RX FIFO underflow\n");
+
+	priv->write(reg_erfsr & FLEXCAN_ERFSR_INT_ALL, &regs->erfsr);
+
+	if (!priv->rx_dma_chan && (reg_erfsr & FLEXCAN_ERFSR_ERFWMI))
+		flexcan_erf_read(dev);
+}
+
+/* The DMA engine copies every enhanced RX FIFO element, CS and ID words
+ * followed by the payload, into the next slot of a cyclic ring. It
+ * signals every erf_watermark frames, all frames written since the last
+ * call are handed to rx-offload at once.
+ */
+static void flexcan_erf_dma_callback(void *data)
+{
+	struct net_device *dev = data;
+	struct flexcan_priv *priv = netdev_priv(dev);
+	size_t frame_size = priv->erf_frame_words * sizeof(u32);
+	struct dma_tx_state state;
+	struct canfd_frame *cfd;
+	struct sk_buff *skb;
+	unsigned long flags;
+	unsigned int head;
+	int i;
+
+	if (dmaengine_tx_status(priv->rx_dma_chan, priv->rx_dma_cookie,
+				&state) == DMA_ERROR)
+		return;
+
+	/* only count the frames the DMA has completely written */
+	head = (priv->rx_dma_frames * frame_size - state.residue) / frame_size;
+	head %= priv->rx_dma_frames;
+
+	/* read the ring after the DMA position */
+	dma_rmb();
+
+	spin_lock_irqsave(&priv->rx_lock, flags);
+	while (priv->rx_dma_tail != head) {
+		const __le32 *frame = priv->rx_dma_buf +
+			priv->rx_dma_tail * frame_size;
+		u32 reg_ctrl = le32_to_cpu(frame[0]);
+
+		skb = flexcan_alloc_rx_skb(dev, reg_ctrl, le32_to_cpu(frame[1]),
+					   &cfd);
+		if (skb) {
+			for (i = 0; i < cfd->len; i += sizeof(u32)) {
+				__be32 data = cpu_to_be32(le32_to_cpu(frame[2 + i / sizeof(u32)]));
+				*(__be32 *)(cfd->data + i) = data;
+			}
+		}
+		flexcan_erf_queue_skb(dev, skb, reg_ctrl);
+
+		priv->rx_dma_tail = (priv->rx_dma_tail + 1) % priv->rx_dma_frames;
+	}
+	can_rx_offload_irq_finish(&priv->offload);
+	spin_unlock_irqrestore(&priv->rx_lock, flags);
+}
+
+static void flexcan_erf_dma_release(struct net_device *dev)
+{
+	struct flexcan_priv *priv = netdev_priv(dev);
+
+	if (!priv->rx_dma_chan)
+		return;
+
+	dmaengine_terminate_sync(priv->rx_dma_chan);
+	dma_free_coherent(priv->rx_dma_chan->device->dev,
+			  priv->rx_dma_frames * priv->erf_frame_words * sizeof(u32),
+			  priv->rx_dma_buf, priv->rx_dma_addr);
+	dma_release_channel(priv->rx_dma_chan);
+	priv->rx_dma_chan = NULL;
+}
+
+/* Set up the DMA ring for the enhanced RX FIFO. Without a usable "rx"
+ * DMA channel the FIFO is drained from the interrupt handler instead.
+ * The channel has to be in multi-FIFO mode, so that every request reads
+ * the output buffer word after word and rewinds to its start.
+ */
+static void flexcan_erf_dma_init(struct net_device *dev)
+{
+	struct flexcan_priv *priv = netdev_priv(dev);
+	size_t frame_size = priv->erf_frame_words * sizeof(u32);
+	struct dma_async_tx_descriptor *desc;
+	struct dma_slave_config cfg = { };
+	struct dma_chan *chan;
+	int err;
+
+	chan = dma_request_chan(priv->dev, "rx");
+	if (IS_ERR(chan)) {
+		netdev_dbg(dev, "no RX DMA channel (%pe), using interrupts\n",
+			   chan);
+		return;
+	}
+
+	/* This driver uses native endianness for the DMA ring */
+	if (priv->read == flexcan_read_be) {
+		err = -EOPNOTSUPP;
+		goto out_release;
+	}
+
+	cfg.direction = DMA_DEV_TO_MEM;
+	cfg.src_addr = priv->regs_phys + FLEXCAN_ERF_OUTPUT;
+	cfg.src_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
+	cfg.src_maxburst = priv->erf_frame_words;
+	err = dmaengine_slave_config(chan, &cfg);
+	if (err)
+		goto out_release;
+
+	priv->rx_dma_frames = rounddown(FLEXCAN_ERF_DMA_FRAMES,
+					priv->erf_watermark);
+	priv->rx_dma_buf = dma_alloc_coherent(chan->device->dev,
+					      priv->rx_dma_frames * frame_size,
+					      &priv->rx_dma_addr, GFP_KERNEL);
+	if (!priv->rx_dma_buf) {
+		err = -ENOMEM;
+		goto out_release;
+	}
+
+	desc = dmaengine_prep_dma_cyclic(chan, priv->rx_dma_addr,
+					 priv->rx_dma_frames * frame_size,
+					 priv->erf_watermark * frame_size,
+					 DMA_DEV_TO_MEM, DMA_PREP_INTERRUPT);
+	if (!desc) {
+		err = -EINVAL;
+		goto out_free;
+	}
+
+	desc->callback = flexcan_erf_dma_callback;
+	desc->callback_param = dev;
+	priv->rx_dma_cookie = dmaengine_submit(desc);
+	err = dma_submit_error(priv->rx_dma_cookie);
+	if (err)
+		goto out_free;
+
+	priv->rx_dma_chan = chan;
+	priv->rx_dma_tail = 0;
+	dma_async_issue_pending(chan);
+
+	return;
+
+ out_free:
+	dma_free_coherent(chan->device->dev, priv->rx_dma_frames * frame_size,
+			  priv->rx_dma_buf, priv->rx_dma_addr);
+ out_release:
+	dma_release_channel(chan);
+	netdev_warn(dev, "failed to set up RX DMA (%pe), using interrupts\n",
+		    ERR_PTR(err));
+}
+
+/* Configure the enhanced RX FIFO, entered in freeze mode */
+static void flexcan_erf_setup(struct net_device *dev)
+{
+	struct flexcan_priv *priv = netdev_priv(dev);
+	struct flexcan_regs __iomem *regs = priv->regs;
+	u32 reg_erfcr;
+	int i;
+
+	/* One extended (two elements) and two standard "ID and mask"
+	 * filters, all with a zero mask: accept everything.
+	 */
+	for (i = 0; i < 4; i++)
+		priv->write(FIELD_PREP(FLEXCAN_ERFFEL_FSCH,
+				       FLEXCAN_ERFFEL_FSCH_MASK),
+			    (void __iomem *)regs + FLEXCAN_ERFFEL(i));
+
+	reg_erfcr = FLEXCAN_ERFCR_ERFEN |
+		FIELD_PREP(FLEXCAN_ERFCR_NEXIF, 1) |
+		FIELD_PREP(FLEXCAN_ERFCR_NFE, 4 - 1);
+	if (priv->rx_dma_chan)
+		reg_erfcr |= FIELD_PREP(FLEXCAN_ERFCR_DMALW,
+					priv->erf_frame_words - 1);
+	else
+		reg_erfcr |= FIELD_PREP(FLEXCAN_ERFCR_ERFWM,
+					priv->erf_watermark - 1);
+	priv->write(reg_erfcr, &regs->erfcr);
+
+	/* flush the FIFO and ack stale events */
+	priv->write(FLEXCAN_ERFSR_ERFCLR | FLEXCAN_ERFSR_INT_ALL |
+		    FLEXCAN_ERFSR_ERFDA, &regs->erfsr);
+}
+
+static void flexcan_irq_tx(struct net_device *dev, u64 reg_iflag_tx)
 {
-	struct net_device *dev = dev_id;
 	struct net_device_stats *stats = &dev->stats;
+	struct flexcan_priv *priv = netdev_priv(dev);
+	struct flexcan_regs __iomem *regs = priv->regs;
+	u64 pending = reg_iflag_tx;
+	u32 done = 0;
+
+	while (pending) {
+		unsigned int n = __ffs64(pending);
+		unsigned int idx = n - priv->tx_mb_first;
+		struct flexcan_mb __iomem *mb = flexcan_get_mb(priv, n);
+		u32 reg_ctrl = priv->read(&mb->can_ctrl);
+
+		pending &= ~FLEXCAN_IFLAG_MB(n);
+		done |= BIT(idx);
+
+		stats->tx_bytes +=
+			can_rx_offload_get_echo_skb_queue_timestamp(&priv->offload, idx,
+								    reg_ctrl << 16, NULL);
+		stats->tx_packets++;
+
+		/* after sending a RTR frame MB is in RX mode */
+		priv->write(FLEXCAN_MB_CODE_TX_INACTIVE, &mb->can_ctrl);
+	}
+	flexcan_write64(priv, reg_iflag_tx, &regs->iflag1);
+
+	spin_lock(&priv->tx_lock);
+	priv->tx_busy &= ~done;
+	if (!priv->tx_busy && priv->tx_next == priv->tx_mb_count) {
+		priv->tx_next = 0;
+		netif_wake_queue(dev);
+	}
+	spin_unlock(&priv->tx_lock);
+}
+
+static irqreturn_t __flexcan_irq(struct net_device *dev)
+{
 	struct flexcan_priv *priv = netdev_priv(dev);
 	struct flexcan_regs __iomem *regs = priv->regs;
 	irqreturn_t handled = IRQ_NONE;
@@ -1081,7 +1446,14 @@ static irqreturn_t flexcan_irq(int irq, void *dev_id)
 	enum can_state last_state = priv->can.state;
 
 	/* reception interrupt */
-	if (priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX) {
+	if (flexcan_active_rx_enh_fifo(priv)) {
+		u32 reg_erfsr = priv->read(&regs->erfsr);
+
+		if (reg_erfsr & FLEXCAN_ERFSR_INT_ALL) {
+			handled = IRQ_HANDLED;
+			flexcan_irq_erf(dev, reg_erfsr);
+		}
+	} else if (priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX) {
 		u64 reg_iflag_rx;
 		int ret;
 
@@ -1114,20 +1486,9 @@ static irqreturn_t flexcan_irq(int irq, void *dev_id)
 	reg_iflag_tx = flexcan_read_reg_iflag_tx(priv);
 
 	/* transmission complete interrupt */
-	if (reg_iflag_tx & priv->tx_mask) {
-		u32 reg_ctrl = priv->read(&priv->tx_mb->can_ctrl);
-
+	if (reg_iflag_tx) {
 		handled = IRQ_HANDLED;
-		stats->tx_bytes +=
-			can_rx_offload_get_echo_skb_queue_timestamp(&priv->offload, 0,
-								    reg_ctrl << 16, NULL);
-		stats->tx_packets++;
-
-		/* after sending a RTR frame MB is in RX mode */
-		priv->write(FLEXCAN_MB_CODE_TX_INACTIVE,
-			    &priv->tx_mb->can_ctrl);
-		flexcan_write64(priv, priv->tx_mask, &regs->iflag1);
-		netif_wake_queue(dev);
+		flexcan_irq_tx(dev, reg_iflag_tx);
 	}
 
 	reg_esr = priv->read(&regs->esr);
@@ -1193,6 +1554,19 @@ static irqreturn_t flexcan_irq(int irq, void *dev_id)
 	return handled;
 }
 
+static irqreturn_t flexcan_irq(int irq, void *dev_id)
+{
+	struct net_device *dev = dev_id;
+	struct flexcan_priv *priv = netdev_priv(dev);
+	irqreturn_t handled;
+
+	spin_lock(&priv->rx_lock);
+	handled = __flexcan_irq(dev);
+	spin_unlock(&priv->rx_lock);
+
+	return handled;
+}
+
 static void flexcan_set_bittiming_ctrl(const struct net_device *dev)
 {
 	const struct flexcan_priv *priv = netdev_priv(dev);
@@ -1383,6 +1757,7 @@ static void flexcan_ram_init(struct net_device *dev)
 static int flexcan_rx_offload_setup(struct net_device *dev)
 {
 	struct flexcan_priv *priv = netdev_priv(dev);
+	unsigned int tx_max;
 	int err;
 
 	if (priv->can.ctrlmode & CAN_CTRLMODE_FD)
@@ -1396,21 +1771,52 @@ static int flexcan_rx_offload_setup(struct net_device *dev)
 		priv->mb_count = (sizeof(priv->regs->mb[0]) / priv->mb_size) +
 				 (sizeof(priv->regs->mb[1]) / priv->mb_size);
 
-	if (priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX)
+	if (flexcan_active_rx_enh_fifo(priv) ||
+	    priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX)
 		priv->tx_mb_reserved =
 			flexcan_get_mb(priv, FLEXCAN_TX_MB_RESERVED_RX_MAILBOX);
 	else
 		priv->tx_mb_reserved =
 			flexcan_get_mb(priv, FLEXCAN_TX_MB_RESERVED_RX_FIFO);
-	priv->tx_mb_idx = priv->mb_count - 1;
-	priv->tx_mb = flexcan_get_mb(priv, priv->tx_mb_idx);
-	priv->tx_mask = FLEXCAN_IFLAG_MB(priv->tx_mb_idx);
+
+	/* In mailbox mode the TX ring is taken from the RX mailboxes,
+	 * keep at least as many of them for reception. The enhanced RX
+	 * FIFO leaves all mailboxes to TX.
+	 */
+	if (flexcan_active_rx_enh_fifo(priv))
+		tx_max = priv->mb_count - FLEXCAN_RX_MB_RX_MAILBOX_FIRST;
+	else if (priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX)
+		tx_max = (priv->mb_count - FLEXCAN_RX_MB_RX_MAILBOX_FIRST) / 2;
+	else
+		tx_max = priv->mb_count - FLEXCAN_TX_MB_RESERVED_RX_FIFO - 1;
+	tx_max = min_t(unsigned int, tx_max, FLEXCAN_TX_MB_MAX);
+
+	priv->tx_mb_count = clamp_t(unsigned int, priv->tx_mb_req, 1, tx_max);
+	if (priv->tx_mb_count != priv->tx_mb_req)
+		netdev_info(dev, "using %u TX mailboxes instead of %u\n",
+			    priv->tx_mb_count, priv->tx_mb_req);
+
+	priv->tx_mb_first = priv->mb_count - priv->tx_mb_count;
+	priv->tx_mask = GENMASK_ULL(priv->mb_count - 1, priv->tx_mb_first);
 
 	priv->offload.mailbox_read = flexcan_mailbox_read;
 
-	if (priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX) {
+	if (flexcan_active_rx_enh_fifo(priv)) {
+		if (priv->can.ctrlmode & CAN_CTRLMODE_FD)
+			priv->erf_frame_words = FLEXCAN_ERF_FRAME_WORDS(CANFD_MAX_DLEN);
+		else
+			priv->erf_frame_words = FLEXCAN_ERF_FRAME_WORDS(CAN_MAX_DLEN);
+		priv->erf_watermark = clamp_t(unsigned int, erf_watermark, 1,
+					      FLEXCAN_ERF_DEPTH);
+
+		priv->rx_mask = 0;
+		err = can_rx_offload_add_manual(dev, &priv->offload,
+						FLEXCAN_NAPI_WEIGHT);
+		if (!err)
+			flexcan_erf_dma_init(dev);
+	} else if (priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX) {
 		priv->offload.mb_first = FLEXCAN_RX_MB_RX_MAILBOX_FIRST;
-		priv->offload.mb_last = priv->mb_count - 2;
+		priv->offload.mb_last = priv->tx_mb_first - 1;
 
 		priv->rx_mask = GENMASK_ULL(priv->offload.mb_last,
 					    priv->offload.mb_first);
@@ -1436,6 +1842,13 @@ static void flexcan_chip_interrupts_enable(const struct net_device *dev)
 	reg_imask = priv->rx_mask | priv->tx_mask;
 	priv->write(upper_32_bits(reg_imask), &regs->imask2);
 	priv->write(lower_32_bits(reg_imask), &regs->imask1);
+	if (flexcan_active_rx_enh_fifo(priv)) {
+		u32 reg_erfier = FLEXCAN_ERFIER_ERFUFWIE | FLEXCAN_ERFIER_ERFOVFIE;
+
+		if (!priv->rx_dma_chan)
+			reg_erfier |= FLEXCAN_ERFIER_ERFWMIIE;
+		priv->write(reg_erfier, &regs->erfier);
+	}
 	enable_irq(dev->irq);
 }
 
@@ -1446,6 +1859,8 @@ static void flexcan_chip_interrupts_disable(const struct net_device *dev)
 
 	priv->write(0, &regs->imask2);
 	priv->write(0, &regs->imask1);
+	if (flexcan_active_rx_enh_fifo(priv))
+		priv->write(0, &regs->erfier);
 	priv->write(priv->reg_ctrl_default & ~FLEXCAN_CTRL_ERR_ALL,
 		    &regs->ctrl);
 }
@@ -1494,19 +1909,28 @@ static int flexcan_chip_start(struct net_device *dev)
 	reg_mcr = priv->read(&regs->mcr);
 	reg_mcr &= ~FLEXCAN_MCR_MAXMB(0xff);
 	reg_mcr |= FLEXCAN_MCR_SUPV | FLEXCAN_MCR_WRN_EN | FLEXCAN_MCR_IRMQ |
-		FLEXCAN_MCR_IDAM_C | FLEXCAN_MCR_MAXMB(priv->tx_mb_idx);
+		FLEXCAN_MCR_IDAM_C | FLEXCAN_MCR_MAXMB(priv->mb_count - 1);
 
 	/* MCR
 	 *
 	 * FIFO:
-	 * - disable for mailbox mode
+	 * - disable for mailbox and enhanced FIFO mode
 	 * - enable for FIFO mode
+	 *
+	 * DMA:
+	 * - enable when the enhanced FIFO is drained by DMA
 	 */
-	if (priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX)
+	if (flexcan_active_rx_enh_fifo(priv) ||
+	    priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX)
 		reg_mcr &= ~FLEXCAN_MCR_FEN;
 	else
 		reg_mcr |= FLEXCAN_MCR_FEN;
 
+	if (priv->rx_dma_chan)
+		reg_mcr |= FLEXCAN_MCR_DMA;
+	else
+		reg_mcr &= ~FLEXCAN_MCR_DMA;
+
 	/* MCR
 	 *
 	 * NOTE: In loopback mode, the CAN_MCR[SRXDIS] cannot be
@@ -1598,7 +2022,16 @@ static int flexcan_chip_start(struct net_device *dev)
 		priv->write(reg_fdctrl, &regs->fdctrl);
 	}
 
-	if (priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX) {
+	if (flexcan_active_rx_enh_fifo(priv)) {
+		/* mailboxes below the TX ring are unused */
+		for (i = FLEXCAN_RX_MB_RX_MAILBOX_FIRST; i < priv->tx_mb_first; i++) {
+			mb = flexcan_get_mb(priv, i);
+			priv->write(FLEXCAN_MB_CODE_RX_INACTIVE,
+				    &mb->can_ctrl);
+		}
+
+		flexcan_erf_setup(dev);
+	} else if (priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX) {
 		for (i = priv->offload.mb_first; i <= priv->offload.mb_last; i++) {
 			mb = flexcan_get_mb(priv, i);
 			priv->write(FLEXCAN_MB_CODE_RX_EMPTY,
@@ -1617,9 +2050,14 @@ static int flexcan_chip_start(struct net_device *dev)
 	priv->write(FLEXCAN_MB_CODE_TX_INACTIVE,
 		    &priv->tx_mb_reserved->can_ctrl);
 
-	/* mark TX mailbox as INACTIVE */
-	priv->write(FLEXCAN_MB_CODE_TX_INACTIVE,
-		    &priv->tx_mb->can_ctrl);
+	/* mark TX mailboxes as INACTIVE */
+	for (i = priv->tx_mb_first; i < priv->mb_count; i++) {
+		mb = flexcan_get_mb(priv, i);
+		priv->write(FLEXCAN_MB_CODE_TX_INACTIVE,
+			    &mb->can_ctrl);
+	}
+	priv->tx_next = 0;
+	priv->tx_busy = 0;
 
 	/* acceptance mask/acceptance code (accept everything) */
 	priv->write(0x0, &regs->rxgmask);
@@ -1801,6 +2239,7 @@ static int flexcan_open(struct net_device *dev)
 	can_rx_offload_disable(&priv->offload);
 	flexcan_chip_stop(dev);
  out_can_rx_offload_del:
+	flexcan_erf_dma_release(dev);
 	can_rx_offload_del(&priv->offload);
  out_transceiver_disable:
 	flexcan_transceiver_disable(priv);
@@ -1831,6 +2270,7 @@ static int flexcan_close(struct net_device *dev)
 	can_rx_offload_disable(&priv->offload);
 	flexcan_chip_stop_disable_on_error(dev);
 
+	flexcan_erf_dma_release(dev);
 	can_rx_offload_del(&priv->offload);
 	flexcan_transceiver_disable(priv);
 	close_candev(dev);
@@ -2094,6 +2534,7 @@ static int flexcan_probe(struct platform_device *pdev)
 	struct clk *clk_ipg = NULL, *clk_per = NULL;
 	struct flexcan_regs __iomem *regs;
 	struct flexcan_platform_data *pdata;
+	struct resource *res;
 	int err, irq;
 	u8 clk_src = 1;
 	u32 clock_freq = 0;
@@ -2138,7 +2579,7 @@ static int flexcan_probe(struct platform_device *pdev)
 	if (irq < 0)
 		return irq;
 
-	regs = devm_platform_ioremap_resource(pdev, 0);
+	regs = devm_platform_get_and_ioremap_resource(pdev, 0, &res);
 	if (IS_ERR(regs))
 		return PTR_ERR(regs);
 
@@ -2167,7 +2608,7 @@ static int flexcan_probe(struct platform_device *pdev)
 		return -EINVAL;
 	}
 
-	dev = alloc_candev(sizeof(struct flexcan_priv), 1);
+	dev = alloc_candev(sizeof(struct flexcan_priv), FLEXCAN_TX_MB_MAX);
 	if (!dev)
 		return -ENOMEM;
 
@@ -2192,6 +2633,10 @@ static int flexcan_probe(struct platform_device *pdev)
 	}
 
 	priv->dev = &pdev->dev;
+	spin_lock_init(&priv->tx_lock);
+	spin_lock_init(&priv->rx_lock);
+	priv->regs_phys = res->start;
+	priv->tx_mb_req = FLEXCAN_TX_MB_DEFAULT;
 	priv->can.clock.freq = clock_freq;
 	priv->can.do_set_mode = flexcan_set_mode;
 	priv->can.do_get_berr_counter = flexcan_get_berr_counter;
@@ -15,6 +15,12 @@
 static const char flexcan_priv_flags_strings[][ETH_GSTRING_LEN] = {
 #define FLEXCAN_PRIV_FLAGS_RX_RTR BIT(0)
 	"rx-rtr",
+#define FLEXCAN_PRIV_FLAGS_RX_ENH_FIFO BIT(1)
+	"rx-enh-fifo",
+};
+
+static const char flexcan_stats_strings[][ETH_GSTRING_LEN] = {
+	"tx_queue_stops",
 };
 
 static void
@@ -25,16 +31,49 @@ flexcan_get_ringparam(struct net_device *ndev, struct ethtool_ringparam *ring,
 	const struct flexcan_priv *priv = netdev_priv(ndev);
 
 	ring->rx_max_pending = priv->mb_count;
-	ring->tx_max_pending = priv->mb_count;
+	ring->tx_max_pending = FLEXCAN_TX_MB_MAX;
 
-	if (priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX)
+	if (flexcan_active_rx_enh_fifo(priv))
+		ring->rx_pending = priv->rx_dma_chan ?
+			priv->rx_dma_frames : FLEXCAN_ERF_DEPTH;
+	else if (priv->devtype_data.quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX)
 		ring->rx_pending = priv->offload.mb_last -
 			priv->offload.mb_first + 1;
 	else
 		ring->rx_pending = 6;	/* RX-FIFO depth is fixed */
 
-	/* the drive currently supports only on TX buffer */
-	ring->tx_pending = 1;
+	if (netif_running(ndev))
+		ring->tx_pending = priv->tx_mb_count;
+	else
+		ring->tx_pending = priv->tx_mb_req;
+}
+
+static int
+flexcan_set_ringparam(struct net_device *ndev, struct ethtool_ringparam *ring,
+		      struct kernel_ethtool_ringparam *kernel_ring,
+		      struct netlink_ext_ack *ext_ack)
+{
+	struct flexcan_priv *priv = netdev_priv(ndev);
+	struct ethtool_ringparam cur;
+
+	flexcan_get_ringparam(ndev, &cur, kernel_ring, ext_ack);
+
+	/* the RX side follows from the RX mode and the TX ring size */
+	if (ring->rx_pending != cur.rx_pending)
+		return -EINVAL;
+
+	if (!ring->tx_pending || ring->tx_pending > FLEXCAN_TX_MB_MAX)
+		return -EINVAL;
+
+	if (ring->tx_pending == cur.tx_pending)
+		return 0;
+
+	if (netif_running(ndev))
+		return -EBUSY;
+
+	priv->tx_mb_req = ring->tx_pending;
+
+	return 0;
 }
 
 static void
@@ -44,9 +83,25 @@ flexcan_get_strings(struct net_device *ndev, u32 stringset, u8 *data)
 	case ETH_SS_PRIV_FLAGS:
 		memcpy(data, flexcan_priv_flags_strings,
 		       sizeof(flexcan_priv_flags_strings));
+		break;
+	case ETH_SS_STATS:
+		memcpy(data, flexcan_stats_strings,
+		       sizeof(flexcan_stats_strings));
+		break;
 	}
 }
 
+static void flexcan_get_ethtool_stats(struct net_device *ndev,
+				      struct ethtool_stats *stats, u64 *data)
+{
+	struct flexcan_priv *priv = netdev_priv(ndev);
+	unsigned long flags;
+
+	spin_lock_irqsave(&priv->tx_lock, flags);
+	data[0] = priv->tx_queue_stops;
+	spin_unlock_irqrestore(&priv->tx_lock, flags);
+}
+
 static u32 flexcan_get_priv_flags(struct net_device *ndev)
 {
 	const struct flexcan_priv *priv = netdev_priv(ndev);
@@ -54,6 +109,8 @@ static u32 flexcan_get_priv_flags(struct net_device *ndev)
 
 	if (flexcan_active_rx_rtr(priv))
 		priv_flags |= FLEXCAN_PRIV_FLAGS_RX_RTR;
+	if (flexcan_active_rx_enh_fifo(priv))
+		priv_flags |= FLEXCAN_PRIV_FLAGS_RX_ENH_FIFO;
 
 	return priv_flags;
 }
@@ -77,6 +134,14 @@ static int flexcan_set_priv_flags(struct net_device *ndev, u32 priv_flags)
 			quirks &= ~FLEXCAN_QUIRK_USE_RX_MAILBOX;
 	}
 
+	if (priv_flags & FLEXCAN_PRIV_FLAGS_RX_ENH_FIFO) {
+		if (!flexcan_supports_rx_enh_fifo(priv))
+			return -EOPNOTSUPP;
+		quirks |= FLEXCAN_QUIRK_USE_RX_ENH_FIFO;
+	} else {
+		quirks &= ~FLEXCAN_QUIRK_USE_RX_ENH_FIFO;
+	}
+
 	if (quirks != priv->devtype_data.quirks && netif_running(ndev))
 		return -EBUSY;
 
@@ -95,6 +160,8 @@ static int flexcan_get_sset_count(struct net_device *netdev, int sset)
 	switch (sset) {
 	case ETH_SS_PRIV_FLAGS:
 		return ARRAY_SIZE(flexcan_priv_flags_strings);
+	case ETH_SS_STATS:
+		return ARRAY_SIZE(flexcan_stats_strings);
 	default:
 		return -EOPNOTSUPP;
 	}
@@ -102,7 +169,9 @@ static int flexcan_get_sset_count(struct net_device *netdev, int sset)
 
 const struct ethtool_ops flexcan_ethtool_ops = {
 	.get_ringparam = flexcan_get_ringparam,
+	.set_ringparam = flexcan_set_ringparam,
 	.get_strings = flexcan_get_strings,
+	.get_ethtool_stats = flexcan_get_ethtool_stats,
 	.get_priv_flags = flexcan_get_priv_flags,
 	.set_priv_flags = flexcan_set_priv_flags,
 	.get_sset_count = flexcan_get_sset_count,
@@ -15,6 +15,7 @@
 #define _FLEXCAN_H
 
 #include <linux/can/rx-offload.h>
+#include <linux/dmaengine.h>
 
 /* FLEXCAN hardware feature flags
  *
@@ -74,6 +75,17 @@
  * both need to have an interrupt handler registered.
  */
 #define FLEXCAN_QUIRK_SECONDARY_MB_IRQ	BIT(18)
+/* Device supports RX via the enhanced RX FIFO */
+#define FLEXCAN_QUIRK_SUPPORT_RX_ENH_FIFO BIT(19)
+/* Use the enhanced RX FIFO for RX path, takes precedence over RX mailboxes */
+#define FLEXCAN_QUIRK_USE_RX_ENH_FIFO BIT(20)
+
+/* TX mailboxes used as a ring, taken from the top of the mailbox area */
+#define FLEXCAN_TX_MB_DEFAULT	1
+#define FLEXCAN_TX_MB_MAX	16
+
+/* Number of elements of the enhanced RX FIFO */
+#define FLEXCAN_ERF_DEPTH	20
 
 struct flexcan_devtype_data {
 	u32 quirks;		/* quirks needed for different IP cores */
@@ -91,9 +103,10 @@ struct flexcan_priv {
 	struct device *dev;
 
 	struct flexcan_regs __iomem *regs;
-	struct flexcan_mb __iomem *tx_mb;
 	struct flexcan_mb __iomem *tx_mb_reserved;
-	u8 tx_mb_idx;
+	u8 tx_mb_first;
+	u8 tx_mb_count;
+	u8 tx_mb_req;	/* requested via ethtool, applied on open */
 	u8 mb_count;
 	u8 mb_size;
 	u8 clk_src;	/* clock source of CAN Protocol Engine */
@@ -103,6 +116,24 @@ struct flexcan_priv {
 	u64 tx_mask;
 	u32 reg_ctrl_default;
 
+	/* TX ring state */
+	spinlock_t tx_lock;	/* protects tx_next, tx_busy */
+	u8 tx_next;		/* next TX mailbox of the ring, relative */
+	u32 tx_busy;		/* TX mailboxes in flight, relative */
+	u64 tx_queue_stops;
+
+	/* enhanced RX FIFO */
+	spinlock_t rx_lock;	/* serializes rx-offload with the DMA callback */
+	phys_addr_t regs_phys;
+	struct dma_chan *rx_dma_chan;
+	void *rx_dma_buf;
+	dma_addr_t rx_dma_addr;
+	dma_cookie_t rx_dma_cookie;
+	unsigned int rx_dma_frames;	/* size of the ring, in frames */
+	unsigned int rx_dma_tail;	/* next frame to read from the ring */
+	u8 erf_frame_words;
+	u8 erf_watermark;
+
 	struct clk *clk_ipg;
 	struct clk *clk_per;
 	struct flexcan_devtype_data devtype_data;
@@ -150,12 +181,31 @@ flexcan_supports_rx_fifo(const struct flexcan_priv *priv)
 	return quirks & FLEXCAN_QUIRK_SUPPORT_RX_FIFO;
 }
 
+static inline bool
+flexcan_supports_rx_enh_fifo(const struct flexcan_priv *priv)
+{
+	const u32 quirks = priv->devtype_data.quirks;
+
+	return quirks & FLEXCAN_QUIRK_SUPPORT_RX_ENH_FIFO;
+}
+
+static inline bool
+flexcan_active_rx_enh_fifo(const struct flexcan_priv *priv)
+{
+	const u32 quirks = priv->devtype_data.quirks;
+
+	return quirks & FLEXCAN_QUIRK_USE_RX_ENH_FIFO;
+}
+
 static inline bool
 flexcan_active_rx_rtr(const struct flexcan_priv *priv)
 {
 	const u32 quirks = priv->devtype_data.quirks;
 
-	if (quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX) {
+	if (quirks & FLEXCAN_QUIRK_USE_RX_ENH_FIFO) {
+		/* enhanced RX-FIFO is RTR capable, too */
+		return true;
+	} else if (quirks & FLEXCAN_QUIRK_USE_RX_MAILBOX) {
 		if (quirks & FLEXCAN_QUIRK_SUPPORT_RX_MAILBOX_RTR)
 			return true;
 	} else {
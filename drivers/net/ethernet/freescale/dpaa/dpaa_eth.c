@@ -367,6 +367,43 @@ static void dpaa_get_stats64(struct net_device *net_dev,
 	}
 }
 
+/* Steer each CPU to its own Tx FQ within every traffic class, so that
+ * concurrent transmitters don't end up enqueuing to the same FQ.
+ */
+static void dpaa_set_xps(struct net_device *net_dev)
+{
+	struct dpaa_priv *priv = netdev_priv(net_dev);
+	int num_txqs_per_tc = dpaa_num_txqs_per_tc();
+	int cpu, tc, err;
+
+	for (tc = 0; tc < priv->num_tc; tc++) {
+		for_each_possible_cpu(cpu) {
+			err = netif_set_xps_queue(net_dev, cpumask_of(cpu),
+						  tc * num_txqs_per_tc + cpu);
+			if (err) {
+				netdev_warn(net_dev, "Error setting XPS queue (%d)\n",
+					    err);
+				return;
+			}
+		}
+	}
+}
+
+static u16 dpaa_select_queue(struct net_device *net_dev, struct sk_buff *skb,
+			     struct net_device *sb_dev)
+{
+	struct dpaa_priv *priv = netdev_priv(net_dev);
+	int tc = 0;
+
+	if (!READ_ONCE(priv->tx_fq_per_cpu))
+		return netdev_pick_tx(net_dev, skb, sb_dev);
+
+	if (netdev_get_num_tc(net_dev))
+		tc = netdev_get_prio_tc_map(net_dev, skb->priority);
+
+	return tc * dpaa_num_txqs_per_tc() + smp_processor_id();
+}
+
 static int dpaa_setup_tc(struct net_device *net_dev, enum tc_setup_type type,
 			 void *type_data)
 {
@@ -405,6 +442,7 @@ static int dpaa_setup_tc(struct net_device *net_dev, enum tc_setup_type type,
 out:
 	priv->num_tc = num_tc ? : 1;
 	netif_set_real_num_tx_queues(net_dev, priv->num_tc * num_txqs_per_tc);
+	dpaa_set_xps(net_dev);
 	return 0;
 }
 
@@ -2079,6 +2117,20 @@ static int skb_to_sg_fd(struct dpaa_priv *priv,
 	return err;
 }
 
+static inline struct qman_fq *dpaa_xmit_prep(struct dpaa_priv *priv,
+					     int queue, struct qm_fd *fd)
+{
+	struct qman_fq *egress_fq = priv->egress_fqs[queue];
+
+	if (fd->bpid == FSL_DPAA_BPID_INV)
+		fd->cmd |= cpu_to_be32(qman_fq_fqid(priv->conf_fqs[queue]));
+
+	/* Trace this Tx fd */
+	trace_dpaa_tx_fd(priv->net_dev, egress_fq, fd);
+
+	return egress_fq;
+}
+
 static inline int dpaa_xmit(struct dpaa_priv *priv,
 			    struct rtnl_link_stats64 *percpu_stats,
 			    int queue,
@@ -2087,12 +2139,7 @@ static inline int dpaa_xmit(struct dpaa_priv *priv,
 	struct qman_fq *egress_fq;
 	int err, i;
 
-	egress_fq = priv->egress_fqs[queue];
-	if (fd->bpid == FSL_DPAA_BPID_INV)
-		fd->cmd |= cpu_to_be32(qman_fq_fqid(priv->conf_fqs[queue]));
-
-	/* Trace this Tx fd */
-	trace_dpaa_tx_fd(priv->net_dev, egress_fq, fd);
+	egress_fq = dpaa_xmit_prep(priv, queue, fd);
 
 	for (i = 0; i < DPAA_ENQUEUE_RETRIES; i++) {
 		err = qman_enqueue(egress_fq, fd);
@@ -2102,6 +2149,7 @@ static inline int dpaa_xmit(struct dpaa_priv *priv,
 
 	if (unlikely(err < 0)) {
 		percpu_stats->tx_fifo_errors++;
+		atomic64_inc(&((struct dpaa_fq *)egress_fq)->enq_rejects);
 		return err;
 	}
 
@@ -2111,6 +2159,42 @@ static inline int dpaa_xmit(struct dpaa_priv *priv,
 	return 0;
 }
 
+/* Enqueue the Tx frames held back on this CPU with as few EQCR commits as
+ * possible. Whatever QMan couldn't take after all retries is dropped.
+ */
+static void dpaa_xmit_flush(struct dpaa_priv *priv,
+			    struct dpaa_percpu_priv *percpu_priv)
+{
+	struct rtnl_link_stats64 *percpu_stats = &percpu_priv->stats;
+	int count = percpu_priv->tx_batch_count;
+	struct qm_fd *fds = percpu_priv->tx_batch;
+	struct qman_fq *egress_fq;
+	struct sk_buff *skb;
+	int sent = 0, i;
+
+	egress_fq = priv->egress_fqs[percpu_priv->tx_batch_queue];
+	percpu_priv->tx_batch_count = 0;
+
+	for (i = 0; i < DPAA_ENQUEUE_RETRIES && sent < count; i++)
+		sent += qman_enqueue_multi(egress_fq, fds + sent, count - sent);
+
+	for (i = 0; i < sent; i++) {
+		percpu_stats->tx_packets++;
+		percpu_stats->tx_bytes += qm_fd_get_length(&fds[i]);
+	}
+
+	if (likely(sent == count))
+		return;
+
+	atomic64_inc(&((struct dpaa_fq *)egress_fq)->enq_rejects);
+	for (i = sent; i < count; i++) {
+		percpu_stats->tx_fifo_errors++;
+		percpu_stats->tx_errors++;
+		skb = dpaa_cleanup_tx_fd(priv, &fds[i], false);
+		dev_kfree_skb(skb);
+	}
+}
+
 #ifdef CONFIG_DPAA_ERRATUM_A050385
 static int dpaa_a050385_wa_skb(struct net_device *net_dev, struct sk_buff **s)
 {
@@ -2350,14 +2434,32 @@ dpaa_start_xmit(struct sk_buff *skb, struct net_device *net_dev)
 		skb_shinfo(skb)->tx_flags |= SKBTX_IN_PROGRESS;
 	}
 
-	if (likely(dpaa_xmit(priv, percpu_stats, queue_mapping, &fd) == 0))
-		return NETDEV_TX_OK;
+	/* Hold the frame back while the stack has more for the same queue,
+	 * then hand the whole batch to QMan at once.
+	 */
+	if (percpu_priv->tx_batch_count &&
+	    percpu_priv->tx_batch_queue != queue_mapping)
+		dpaa_xmit_flush(priv, percpu_priv);
+
+	dpaa_xmit_prep(priv, queue_mapping, &fd);
+	percpu_priv->tx_batch[percpu_priv->tx_batch_count++] = fd;
+	percpu_priv->tx_batch_queue = queue_mapping;
+
+	if (!netdev_xmit_more() ||
+	    percpu_priv->tx_batch_count == DPAA_TX_BATCH)
+		dpaa_xmit_flush(priv, percpu_priv);
+
+	return NETDEV_TX_OK;
 
-	dpaa_cleanup_tx_fd(priv, &fd, false);
 skb_to_fd_failed:
 enomem:
 	percpu_stats->tx_errors++;
 	dev_kfree_skb(skb);
+
+	/* Don't leave earlier frames of the burst behind */
+	if (percpu_priv->tx_batch_count && !netdev_xmit_more())
+		dpaa_xmit_flush(priv, percpu_priv);
+
 	return NETDEV_TX_OK;
 }
 
@@ -2878,6 +2980,7 @@ static void egress_ern(struct qman_portal *portal,
 	percpu_priv->stats.tx_dropped++;
 	percpu_priv->stats.tx_fifo_errors++;
 	count_ern(percpu_priv, msg);
+	atomic64_inc(&((struct dpaa_fq *)fq)->erns);
 
 	skb = dpaa_cleanup_tx_fd(priv, fd, false);
 	dev_kfree_skb_any(skb);
@@ -3120,6 +3223,7 @@ static int dpaa_ioctl(struct net_device *net_dev, struct ifreq *rq, int cmd)
 static const struct net_device_ops dpaa_ops = {
 	.ndo_open = dpaa_open,
 	.ndo_start_xmit = dpaa_start_xmit,
+	.ndo_select_queue = dpaa_select_queue,
 	.ndo_stop = dpaa_eth_stop,
 	.ndo_tx_timeout = dpaa_tx_timeout,
 	.ndo_get_stats64 = dpaa_get_stats64,
@@ -3490,6 +3594,8 @@ static int dpaa_eth_probe(struct platform_device *pdev)
 	if (err < 0)
 		goto delete_dpaa_napi;
 
+	dpaa_set_xps(net_dev);
+
 	dpaa_eth_sysfs_init(&net_dev->dev);
 
 	netif_info(priv, probe, net_dev, "Probed interface %s\n",
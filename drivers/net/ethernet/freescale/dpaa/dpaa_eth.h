@@ -41,6 +41,11 @@ struct dpaa_fq {
 	u8 wq;
 	enum dpaa_fq_type fq_type;
 	struct xdp_rxq_info xdp_rxq;
+	/* Tx FQs only: frames that could not be enqueued (portal busy
+	 * after all retries) and frames rejected by QMan via ERN
+	 */
+	atomic64_t enq_rejects;
+	atomic64_t erns;
 };
 
 struct dpaa_fq_cbs {
@@ -102,6 +107,12 @@ struct dpaa_napi_portal {
 	int xdp_act;
 };
 
+/* Maximum number of Tx frames enqueued with one EQCR commit. The EQCR only
+ * has 8 entries, keep the batch at half of it so that flushes seldom find
+ * the ring short.
+ */
+#define DPAA_TX_BATCH		4
+
 struct dpaa_percpu_priv {
 	struct net_device *net_dev;
 	struct dpaa_napi_portal np;
@@ -112,6 +123,10 @@ struct dpaa_percpu_priv {
 	struct rtnl_link_stats64 stats;
 	struct dpaa_rx_errors rx_errors;
 	struct dpaa_ern_cnt ern_cnt;
+	/* Tx frames held back until the end of an xmit_more burst */
+	struct qm_fd tx_batch[DPAA_TX_BATCH];
+	int tx_batch_count;
+	int tx_batch_queue;
 };
 
 struct dpaa_buffer_layout {
@@ -173,6 +188,9 @@ struct dpaa_priv {
 	bool rx_tstamp; /* Rx timestamping enabled */
 
 	struct bpf_prog *xdp_prog;
+
+	/* Bypass XPS/hashing and always transmit on the current CPU's FQ */
+	bool tx_fq_per_cpu;
 };
 
 /* from dpaa_ethtool.c */
@@ -50,8 +50,22 @@ static char dpaa_stats_global[][ETH_GSTRING_LEN] = {
 	"congested (0/1)"
 };
 
+static const char dpaa_stats_txq[][ETH_GSTRING_LEN] = {
+	"enq rejected",
+	"ern",
+};
+
 #define DPAA_STATS_PERCPU_LEN ARRAY_SIZE(dpaa_stats_percpu)
 #define DPAA_STATS_GLOBAL_LEN ARRAY_SIZE(dpaa_stats_global)
+#define DPAA_STATS_TXQ_LEN ARRAY_SIZE(dpaa_stats_txq)
+
+#define DPAA_PRIV_FLAG_TX_FQ_PER_CPU	BIT(0)
+
+static const char dpaa_priv_flags[][ETH_GSTRING_LEN] = {
+	"tx-fq-per-cpu",
+};
+
+#define DPAA_PRIV_FLAGS_LEN ARRAY_SIZE(dpaa_priv_flags)
 
 static int dpaa_get_link_ksettings(struct net_device *net_dev,
 				   struct ethtool_link_ksettings *cmd)
@@ -123,11 +137,14 @@ static int dpaa_get_sset_count(struct net_device *net_dev, int type)
 
 	num_stats   = num_online_cpus() + 1;
 	total_stats = num_stats * (DPAA_STATS_PERCPU_LEN + 1) +
-			DPAA_STATS_GLOBAL_LEN;
+			DPAA_STATS_GLOBAL_LEN +
+			net_dev->real_num_tx_queues * DPAA_STATS_TXQ_LEN;
 
 	switch (type) {
 	case ETH_SS_STATS:
 		return total_stats;
+	case ETH_SS_PRIV_FLAGS:
+		return DPAA_PRIV_FLAGS_LEN;
 	default:
 		return -EOPNOTSUPP;
 	}
@@ -238,6 +255,13 @@ static void dpaa_get_ethtool_stats(struct net_device *net_dev,
 	data[offset++] = cg_time;
 	data[offset++] = cg_num;
 	data[offset++] = cg_status;
+
+	for (i = 0; i < net_dev->real_num_tx_queues; i++) {
+		struct dpaa_fq *fq = (struct dpaa_fq *)priv->egress_fqs[i];
+
+		data[offset++] = atomic64_read(&fq->enq_rejects);
+		data[offset++] = atomic64_read(&fq->erns);
+	}
 }
 
 static void dpaa_get_strings(struct net_device *net_dev, u32 stringset,
@@ -247,6 +271,11 @@ static void dpaa_get_strings(struct net_device *net_dev, u32 stringset,
 	char string_cpu[ETH_GSTRING_LEN];
 	u8 *strings;
 
+	if (stringset == ETH_SS_PRIV_FLAGS) {
+		memcpy(data, dpaa_priv_flags, sizeof(dpaa_priv_flags));
+		return;
+	}
+
 	memset(string_cpu, 0, sizeof(string_cpu));
 	strings   = data;
 	num_cpus  = num_online_cpus();
@@ -275,6 +304,37 @@ static void dpaa_get_strings(struct net_device *net_dev, u32 stringset,
 	strings += ETH_GSTRING_LEN;
 
 	memcpy(strings, dpaa_stats_global, size);
+	strings += size;
+
+	for (j = 0; j < net_dev->real_num_tx_queues; j++) {
+		for (i = 0; i < DPAA_STATS_TXQ_LEN; i++) {
+			snprintf(string_cpu, ETH_GSTRING_LEN, "%s [TXQ %d]",
+				 dpaa_stats_txq[i], j);
+			memcpy(strings, string_cpu, ETH_GSTRING_LEN);
+			strings += ETH_GSTRING_LEN;
+		}
+	}
+}
+
+static u32 dpaa_get_priv_flags(struct net_device *net_dev)
+{
+	struct dpaa_priv *priv = netdev_priv(net_dev);
+	u32 flags = 0;
+
+	if (priv->tx_fq_per_cpu)
+		flags |= DPAA_PRIV_FLAG_TX_FQ_PER_CPU;
+
+	return flags;
+}
+
+static int dpaa_set_priv_flags(struct net_device *net_dev, u32 flags)
+{
+	struct dpaa_priv *priv = netdev_priv(net_dev);
+
+	WRITE_ONCE(priv->tx_fq_per_cpu,
+		   !!(flags & DPAA_PRIV_FLAG_TX_FQ_PER_CPU));
+
+	return 0;
 }
 
 static int dpaa_get_hash_opts(struct net_device *dev,
@@ -522,6 +582,8 @@ const struct ethtool_ops dpaa_ethtool_ops = {
 	.get_sset_count = dpaa_get_sset_count,
 	.get_ethtool_stats = dpaa_get_ethtool_stats,
 	.get_strings = dpaa_get_strings,
+	.get_priv_flags = dpaa_get_priv_flags,
+	.set_priv_flags = dpaa_set_priv_flags,
 	.get_link_ksettings = dpaa_get_link_ksettings,
 	.set_link_ksettings = dpaa_set_link_ksettings,
 	.get_rxnfc = dpaa_get_rxnfc,
@@ -1141,7 +1141,10 @@ static int dpaa2_ceetm_cls_dump_stats(struct Qdisc *sch, unsigned long arg,
 				      struct gnet_dump *d)
 {
 	struct dpaa2_ceetm_class *cl = (struct dpaa2_ceetm_class *)arg;
+	struct dpaa2_ceetm_qdisc *priv = qdisc_priv(sch);
 	struct dpaa2_ceetm_tc_xstats xstats;
+	struct gnet_stats_basic_sync bstats;
+	struct gnet_stats_queue qstats = { 0 };
 	union dpni_statistics dpni_stats;
 	struct net_device *dev = qdisc_dev(sch);
 	struct dpaa2_eth_priv *priv_eth = netdev_priv(dev);
@@ -1149,10 +1152,14 @@ static int dpaa2_ceetm_cls_dump_stats(struct Qdisc *sch, unsigned long arg,
 	int err;
 
 	memset(&xstats, 0, sizeof(xstats));
+	memset(&dpni_stats, 0, sizeof(dpni_stats));
 
 	if (cl->type == CEETM_ROOT)
 		return 0;
 
+	if (priv->prio.parent)
+		ch_id = priv->prio.parent->root.ch_id;
+
 	err = dpni_get_statistics(priv_eth->mc_io, 0, priv_eth->mc_token, 3,
 				  DPNI_BUILD_CH_TC(ch_id, cl->prio.qpri),
 				  &dpni_stats);
@@ -1164,6 +1171,19 @@ static int dpaa2_ceetm_cls_dump_stats(struct Qdisc *sch, unsigned long arg,
 	xstats.ceetm_reject_bytes = dpni_stats.page_3.egress_reject_bytes;
 	xstats.ceetm_reject_frames = dpni_stats.page_3.egress_reject_frames;
 
+	/* Report the hardware counters of the class queue through the
+	 * standard class statistics as well, so that "tc -s class show"
+	 * displays live byte/packet/drop counts for each class.
+	 */
+	gnet_stats_basic_sync_init(&bstats);
+	_bstats_update(&bstats, xstats.ceetm_dequeue_bytes,
+		       xstats.ceetm_dequeue_frames);
+	qstats.drops = xstats.ceetm_reject_frames;
+
+	if (gnet_stats_copy_basic(d, NULL, &bstats, true) < 0 ||
+	    gnet_stats_copy_queue(d, NULL, &qstats, 0) < 0)
+		return -1;
+
 	return gnet_stats_copy_app(d, &xstats, sizeof(xstats));
 }
 
@@ -4,6 +4,11 @@
 #include <linux/netdevice.h>
 #include "dpaa2-eth.h"
 
+/* All counter callbacks of one `ip -s macsec show` dump are served from
+ * the same snapshot, which is taken at most this often.
+ */
+#define DPAA2_MACSEC_STATS_MAX_AGE	(HZ / 10)
+
 static int dpaa2_mdo_dev_open(struct macsec_context *ctx)
 {
 	struct dpaa2_eth_priv *priv = macsec_netdev_priv(ctx->netdev);
@@ -140,6 +145,14 @@ static int dpaa2_mdo_add_secy(struct macsec_context *ctx)
 
 	priv->secy_id = secy_id;
 	priv->sec.secy = secy;
+	priv->sec.protect_frames = secy->protect_frames;
+	priv->sec.replay_protect = secy->replay_protect;
+	priv->sec.replay_window = secy->replay_window;
+	priv->sec.active_tx_an = -1;
+	priv->sec.tx_an_mask = 0;
+	priv->sec.rx_an_mask = 0;
+	priv->sec.has_rx_sc = false;
+	priv->sec.stats.valid = false;
 
 	return 0;
 
@@ -168,7 +181,7 @@ static int dpaa2_mdo_del_secy(struct macsec_context *ctx)
 		goto err_open_dev;
 	}
 
-	priv->sec.secy = NULL;
+	memset(&priv->sec, 0, sizeof(priv->sec));
 	priv->secy_id = 0;
 
 	if (up) {
@@ -186,6 +199,67 @@ static int dpaa2_mdo_del_secy(struct macsec_context *ctx)
 	return err;
 }
 
+static int dpaa2_macsec_set_active_tx_sa(struct dpaa2_eth_priv *priv, u8 an)
+{
+	int err;
+
+	if (priv->sec.active_tx_an == an || !test_bit(an, &priv->sec.tx_an_mask))
+		return 0;
+
+	err = dpni_secy_set_active_tx_sa(priv->mc_io, 0, priv->mc_token,
+					 priv->secy_id, an);
+	if (err) {
+		netdev_err(priv->net_dev,
+			   "dpni_secy_set_active_tx_sa(secy_id %d, assoc_num %d) failed with %d\n",
+			   priv->secy_id, an, err);
+		return err;
+	}
+	priv->sec.active_tx_an = an;
+
+	return 0;
+}
+
+/* Rekeying switches the encoding SA through a SecY update. Only send the
+ * MC the commands for settings which actually changed.
+ */
+static int dpaa2_mdo_upd_secy(struct macsec_context *ctx)
+{
+	struct dpaa2_eth_priv *priv = macsec_netdev_priv(ctx->netdev);
+	struct net_device *net_dev = priv->net_dev;
+	struct macsec_secy *secy = ctx->secy;
+	int err;
+
+	if (!priv->sec.secy)
+		return -ENOENT;
+
+	if (secy->protect_frames != priv->sec.protect_frames) {
+		err = dpni_secy_set_tx_protection(priv->mc_io, 0, priv->mc_token,
+						  priv->secy_id, secy->protect_frames);
+		if (err) {
+			netdev_err(net_dev, "dpni_secy_set_protect_tx_protection() failed with %d\n",
+				   err);
+			return err;
+		}
+		priv->sec.protect_frames = secy->protect_frames;
+	}
+
+	if (secy->replay_protect != priv->sec.replay_protect ||
+	    secy->replay_window != priv->sec.replay_window) {
+		err = dpni_secy_set_replay_protection(priv->mc_io, 0, priv->mc_token,
+						      priv->secy_id, secy->replay_protect,
+						      secy->replay_window);
+		if (err) {
+			netdev_err(net_dev, "dpni_secy_set_replay_protection() failed with %d\n",
+				   err);
+			return err;
+		}
+		priv->sec.replay_protect = secy->replay_protect;
+		priv->sec.replay_window = secy->replay_window;
+	}
+
+	return dpaa2_macsec_set_active_tx_sa(priv, secy->tx_sc.encoding_sa);
+}
+
 static int dpaa2_mdo_add_txsa(struct macsec_context *ctx)
 {
 	struct dpaa2_eth_priv *priv = macsec_netdev_priv(ctx->netdev);
@@ -202,22 +276,20 @@ static int dpaa2_mdo_add_txsa(struct macsec_context *ctx)
 		netdev_err(priv->net_dev, "dpni_secy_add_tx_sa() failed with %d\n", err);
 		return err;
 	}
+	set_bit(ctx->sa.assoc_num, &priv->sec.tx_an_mask);
+	priv->sec.stats.valid = false;
 
 	if (ctx->secy->tx_sc.encoding_sa == ctx->sa.assoc_num) {
-		err = dpni_secy_set_active_tx_sa(priv->mc_io, 0, priv->mc_token,
-						 priv->secy_id, ctx->sa.assoc_num);
-		if (err) {
-			netdev_err(priv->net_dev,
-				   "dpni_secy_set_active_tx_sa(secy_id %d, assoc_num %d) failed with %d\n",
-				   priv->secy_id, ctx->sa.assoc_num, err);
+		err = dpaa2_macsec_set_active_tx_sa(priv, ctx->sa.assoc_num);
+		if (err)
 			goto err_remove_tx_sa;
-		}
 	}
 
 	return 0;
 
 err_remove_tx_sa:
 	dpni_secy_remove_tx_sa(priv->mc_io, 0, priv->mc_token, priv->secy_id, ctx->sa.assoc_num);
+	clear_bit(ctx->sa.assoc_num, &priv->sec.tx_an_mask);
 
 	return err;
 }
@@ -225,23 +297,14 @@ static int dpaa2_mdo_add_txsa(struct macsec_context *ctx)
 static int dpaa2_mdo_upd_txsa(struct macsec_context *ctx)
 {
 	struct dpaa2_eth_priv *priv = macsec_netdev_priv(ctx->netdev);
-	int err;
 
 	if (ctx->sa.update_pn)
 		return -EOPNOTSUPP;
 
-	if (ctx->secy->tx_sc.encoding_sa == ctx->sa.assoc_num) {
-		err = dpni_secy_set_active_tx_sa(priv->mc_io, 0, priv->mc_token,
-						 priv->secy_id, ctx->sa.assoc_num);
-		if (err) {
-			netdev_err(priv->net_dev,
-				   "dpni_secy_set_active_tx_sa(secy_id %d, assoc_num %d) failed with %d\n",
-				   priv->secy_id, ctx->sa.assoc_num, err);
-			return err;
-		}
-	}
+	if (ctx->secy->tx_sc.encoding_sa != ctx->sa.assoc_num)
+		return 0;
 
-	return 0;
+	return dpaa2_macsec_set_active_tx_sa(priv, ctx->sa.assoc_num);
 }
 
 static int dpaa2_mdo_del_txsa(struct macsec_context *ctx)
@@ -255,6 +318,10 @@ static int dpaa2_mdo_del_txsa(struct macsec_context *ctx)
 		netdev_err(priv->net_dev, "dpni_secy_remove_tx_sa() failed with %d\n", err);
 		return err;
 	}
+	clear_bit(ctx->sa.assoc_num, &priv->sec.tx_an_mask);
+	if (priv->sec.active_tx_an == ctx->sa.assoc_num)
+		priv->sec.active_tx_an = -1;
+	priv->sec.stats.valid = false;
 
 	return 0;
 }
@@ -293,6 +360,10 @@ static int dpaa2_mdo_add_rxsc(struct macsec_context *ctx)
 		netdev_err(priv->net_dev, "dpni_secy_set_rx_sc_state() failed with %d\n", err);
 		goto err_remove_rxsc;
 	}
+	priv->sec.has_rx_sc = true;
+	priv->sec.rx_sci = sci_to_cpu(ctx->rx_sc->sci);
+	priv->sec.rx_an_mask = 0;
+	priv->sec.stats.valid = false;
 
 	return 0;
 
@@ -337,6 +408,9 @@ static int dpaa2_mdo_del_rxsc(struct macsec_context *ctx)
 		netdev_err(priv->net_dev, "dpni_secy_remove_rx_sc() failed with %d\n", err);
 		return err;
 	}
+	priv->sec.has_rx_sc = false;
+	priv->sec.rx_an_mask = 0;
+	priv->sec.stats.valid = false;
 	netdev_err(net_dev, "Removed RX SC with SCI 0x%llx\n", sci_to_cpu(ctx->rx_sc->sci));
 
 	return 0;
@@ -377,6 +451,8 @@ static int dpaa2_mdo_add_rxsa(struct macsec_context *ctx)
 		netdev_err(net_dev, "dpni_secy_set_rx_sa_state() failed with %d\n", err);
 		goto err_remove_rx_sa;
 	}
+	set_bit(ctx->sa.assoc_num, &priv->sec.rx_an_mask);
+	priv->sec.stats.valid = false;
 
 	netdev_err(net_dev, "Added RX SA %d for SCI 0x%llx, active %s, next_pn %d\n",
 		   ctx->sa.assoc_num, sci_to_cpu(ctx->sa.rx_sa->sc->sci),
@@ -428,6 +504,8 @@ static int dpaa2_mdo_del_rxsa(struct macsec_context *ctx)
 		netdev_err(net_dev, "dpni_secy_remove_rx_sa() failed with %d\n", err);
 		return err;
 	}
+	clear_bit(ctx->sa.assoc_num, &priv->sec.rx_an_mask);
+	priv->sec.stats.valid = false;
 
 	netdev_err(net_dev, "Removed RX SA %d for SCI 0x%llx\n",
 		   ctx->sa.assoc_num, sci_to_cpu(ctx->sa.rx_sa->sc->sci));
@@ -435,86 +513,115 @@ static int dpaa2_mdo_del_rxsa(struct macsec_context *ctx)
 	return 0;
 }
 
-static int dpaa2_mdo_get_dev_stats(struct macsec_context *ctx)
+/* Read every counter of the SecY, its SAs and its Rx SC in one pass, so
+ * that a stats dump does not go back to the MC once per SA.
+ */
+static int dpaa2_macsec_stats_refresh(struct dpaa2_eth_priv *priv)
 {
-	struct dpaa2_eth_priv *priv = macsec_netdev_priv(ctx->netdev);
+	struct dpaa2_eth_macsec_stats *stats = &priv->sec.stats;
 	struct net_device *net_dev = priv->net_dev;
-	union macsec_global_stats global_stats;
-	union macsec_secy_stats stats;
-	int err;
+	unsigned long an;
+	int err, page;
+
+	if (stats->valid &&
+	    time_before(jiffies, stats->stamp + DPAA2_MACSEC_STATS_MAX_AGE))
+		return 0;
 
-	/* Get and display statistics from page #0 */
-	memset(&stats, 0, sizeof(stats));
-	err = dpni_secy_get_stats(priv->mc_io, 0, priv->mc_token, priv->secy_id, 0, &stats);
+	memset(stats, 0, sizeof(*stats));
+
+	err = dpni_get_macsec_stats(priv->mc_io, 0, priv->mc_token, &stats->global);
 	if (err) {
-		netdev_err(net_dev, "dpni_secy_get_stats() failed with %d\n", err);
+		netdev_err(net_dev, "dpni_get_macsec_stats() failed with %d\n", err);
 		return err;
 	}
 
-	netdev_info(net_dev, "Per SecY statistics:\n");
-	netdev_info(net_dev, "\tcnt_ing_bytes : %llu\n", stats.raw.counter[0]);
-	netdev_info(net_dev, "\tcnt_ing_ucast_frames : %llu\n", stats.raw.counter[1]);
-	netdev_info(net_dev, "\tcnt_ing_mcast_frames : %llu\n", stats.raw.counter[2]);
-	netdev_info(net_dev, "\tcnt_ing_bcast_frames : %llu\n", stats.raw.counter[3]);
-	netdev_info(net_dev, "\tcnt_egr_bytes : %llu\n", stats.raw.counter[4]);
-	netdev_info(net_dev, "\tcnt_egr_ucast_frames : %llu\n", stats.raw.counter[5]);
-	netdev_info(net_dev, "\tcnt_egr_mcast_frames : %llu\n", stats.raw.counter[6]);
-
-	/* Get and display statistics from page #1 */
-	memset(&stats, 0, sizeof(stats));
-	err = dpni_secy_get_stats(priv->mc_io, 0, priv->mc_token, priv->secy_id, 1, &stats);
+	err = dpni_secy_get_tx_sc_stats(priv->mc_io, 0, priv->mc_token, priv->secy_id,
+					&stats->tx_sc);
 	if (err) {
-		netdev_err(net_dev, "dpni_secy_get_stats() failed with %d\n", err);
+		netdev_err(net_dev, "dpni_secy_get_tx_sc_stats() failed with %d\n", err);
 		return err;
 	}
 
-	netdev_info(net_dev, "\tcnt_egr_bcast_frames: %llu\n", stats.raw.counter[0]);
+	for_each_set_bit(an, &priv->sec.tx_an_mask, MACSEC_NUM_AN) {
+		err = dpni_secy_get_tx_sa_stats(priv->mc_io, 0, priv->mc_token,
+						priv->secy_id, an, &stats->tx_sa[an]);
+		if (err) {
+			netdev_err(net_dev, "dpni_secy_get_tx_sa_stats() failed with %d\n", err);
+			return err;
+		}
+	}
 
-	/* Get global MACSec statistics (not per SecY) */
-	memset(&global_stats, 0, sizeof(global_stats));
-	err = dpni_get_macsec_stats(priv->mc_io, 0, priv->mc_token, &global_stats);
-	if (err) {
-		netdev_err(net_dev, "dpni_get_macsec_stats() failed with %d\n", err);
-		return err;
+	if (!priv->sec.has_rx_sc)
+		goto out;
+
+	for (page = 0; page < ARRAY_SIZE(stats->rx_sc); page++) {
+		err = dpni_secy_get_rx_sc_stats(priv->mc_io, 0, priv->mc_token,
+						priv->secy_id, priv->sec.rx_sci, page,
+						&stats->rx_sc[page]);
+		if (err) {
+			netdev_err(net_dev, "dpni_secy_get_rx_sc_stats() failed with %d\n", err);
+			return err;
+		}
+	}
+
+	for_each_set_bit(an, &priv->sec.rx_an_mask, MACSEC_NUM_AN) {
+		err = dpni_secy_get_rx_sa_stats(priv->mc_io, 0, priv->mc_token,
+						priv->secy_id, priv->sec.rx_sci, an,
+						&stats->rx_sa[an]);
+		if (err) {
+			netdev_err(net_dev, "dpni_secy_get_rx_sa_stats() failed with %d\n", err);
+			return err;
+		}
 	}
 
-	netdev_info(net_dev, "MACSec global statistics:\n");
-	netdev_info(net_dev, "\tin_without_tag_frames: %u\n",
-		    global_stats.page_0.in_without_tag_frames);
-	netdev_info(net_dev, "\tin_kay_frames: %u\n",
-		    global_stats.page_0.in_kay_frames);
-	netdev_info(net_dev, "\tin_bag_tag_frames: %u\n",
-		    global_stats.page_0.in_bag_tag_frames);
-	netdev_info(net_dev, "\tin_sci_not_found_frames: %u\n",
-		    global_stats.page_0.in_sci_not_found_frames);
-	netdev_info(net_dev, "\tin_unsupported_ec_frames: %u\n",
-		    global_stats.page_0.in_unsupported_ec_frames);
-	netdev_info(net_dev, "\tin_too_long_frames: %u\n",
-		    global_stats.page_0.in_too_long_frames);
-	netdev_info(net_dev, "\tout_discarded_frames: %u\n",
-		    global_stats.page_0.out_discarded_frames);
+out:
+	stats->stamp = jiffies;
+	stats->valid = true;
 
 	return 0;
 }
 
-static int dpaa2_mdo_get_tx_sc_stats(struct macsec_context *ctx)
+static int dpaa2_mdo_get_dev_stats(struct macsec_context *ctx)
 {
 	struct dpaa2_eth_priv *priv = macsec_netdev_priv(ctx->netdev);
-	struct net_device *net_dev = priv->net_dev;
-	union macsec_secy_tx_sc_stats stats;
+	struct macsec_dev_stats *dev_stats = ctx->stats.dev_stats;
+	union macsec_global_stats *global = &priv->sec.stats.global;
+	bool strict = ctx->secy->validate_frames == MACSEC_VALIDATE_STRICT;
 	int err;
 
-	memset(&stats, 0, sizeof(stats));
-	err = dpni_secy_get_tx_sc_stats(priv->mc_io, 0, priv->mc_token, priv->secy_id, &stats);
-	if (err) {
-		netdev_err(net_dev, "dpni_secy_get_tx_sc_stats() failed with %d\n", err);
+	err = dpaa2_macsec_stats_refresh(priv);
+	if (err)
 		return err;
+
+	/* Untagged frames and frames of unknown SCs are dropped, and
+	 * counted as such, only with strict validation.
+	 */
+	if (strict) {
+		dev_stats->InPktsNoTag = global->page_0.in_without_tag_frames;
+		dev_stats->InPktsNoSCI = global->page_0.in_sci_not_found_frames;
+	} else {
+		dev_stats->InPktsUntagged = global->page_0.in_without_tag_frames;
+		dev_stats->InPktsUnknownSCI = global->page_0.in_sci_not_found_frames;
 	}
+	dev_stats->InPktsBadTag = global->page_0.in_bag_tag_frames;
 
-	ctx->stats.tx_sc_stats->OutPktsProtected = stats.page_0.protected_frames;
-	ctx->stats.tx_sc_stats->OutPktsEncrypted = stats.page_0.encrypted_frames;
-	ctx->stats.tx_sc_stats->OutOctetsProtected = stats.page_0.protected_bytes;
-	ctx->stats.tx_sc_stats->OutOctetsEncrypted = stats.page_0.encrypted_bytes;
+	return 0;
+}
+
+static int dpaa2_mdo_get_tx_sc_stats(struct macsec_context *ctx)
+{
+	struct dpaa2_eth_priv *priv = macsec_netdev_priv(ctx->netdev);
+	union macsec_secy_tx_sc_stats *stats = &priv->sec.stats.tx_sc;
+	int err;
+
+	err = dpaa2_macsec_stats_refresh(priv);
+	if (err)
+		return err;
+
+	ctx->stats.tx_sc_stats->OutPktsProtected = stats->page_0.protected_frames;
+	ctx->stats.tx_sc_stats->OutPktsEncrypted = stats->page_0.encrypted_frames;
+	ctx->stats.tx_sc_stats->OutOctetsProtected = stats->page_0.protected_bytes;
+	ctx->stats.tx_sc_stats->OutOctetsEncrypted = stats->page_0.encrypted_bytes;
 
 	return 0;
 }
@@ -522,20 +629,16 @@ static int dpaa2_mdo_get_tx_sc_stats(struct macsec_context *ctx)
 static int dpaa2_mdo_get_tx_sa_stats(struct macsec_context *ctx)
 {
 	struct dpaa2_eth_priv *priv = macsec_netdev_priv(ctx->netdev);
-	struct net_device *net_dev = priv->net_dev;
-	union macsec_secy_tx_sa_stats stats;
+	union macsec_secy_tx_sa_stats *stats;
 	int err;
 
-	memset(&stats, 0, sizeof(stats));
-	err = dpni_secy_get_tx_sa_stats(priv->mc_io, 0, priv->mc_token, priv->secy_id,
-					ctx->sa.assoc_num, &stats);
-	if (err) {
-		netdev_err(net_dev, "dpni_secy_get_tx_sa_stats() failed with %d\n", err);
+	err = dpaa2_macsec_stats_refresh(priv);
+	if (err)
 		return err;
-	}
 
-	ctx->stats.tx_sa_stats->OutPktsProtected = stats.page_0.protected_frames;
-	ctx->stats.tx_sa_stats->OutPktsEncrypted = stats.page_0.encrypted_frames;
+	stats = &priv->sec.stats.tx_sa[ctx->sa.assoc_num];
+	ctx->stats.tx_sa_stats->OutPktsProtected = stats->page_0.protected_frames;
+	ctx->stats.tx_sa_stats->OutPktsEncrypted = stats->page_0.encrypted_frames;
 
 	return 0;
 }
@@ -543,37 +646,24 @@ static int dpaa2_mdo_get_tx_sa_stats(struct macsec_context *ctx)
 static int dpaa2_mdo_get_rx_sc_stats(struct macsec_context *ctx)
 {
 	struct dpaa2_eth_priv *priv = macsec_netdev_priv(ctx->netdev);
-	struct net_device *net_dev = priv->net_dev;
-	union macsec_secy_rx_sc_stats stats;
+	union macsec_secy_rx_sc_stats *stats = priv->sec.stats.rx_sc;
 	int err;
 
-	memset(&stats, 0, sizeof(stats));
-	err = dpni_secy_get_rx_sc_stats(priv->mc_io, 0, priv->mc_token, priv->secy_id,
-					sci_to_cpu(ctx->rx_sc->sci), 0, &stats);
-	if (err) {
-		netdev_err(net_dev, "dpni_secy_get_rx_sc_stats() failed with %d\n", err);
+	err = dpaa2_macsec_stats_refresh(priv);
+	if (err)
 		return err;
-	}
-
-	ctx->stats.rx_sc_stats->InPktsUnusedSA = stats.page_0.unused_frames;
-	ctx->stats.rx_sc_stats->InPktsNotUsingSA = stats.page_0.not_using_sa_frames;
-	ctx->stats.rx_sc_stats->InPktsInvalid = stats.page_0.invalid_frames;
-	ctx->stats.rx_sc_stats->InPktsNotValid = stats.page_0.not_valid_frames;
-	ctx->stats.rx_sc_stats->InPktsLate = stats.page_0.late_frames;
-	ctx->stats.rx_sc_stats->InPktsDelayed = stats.page_0.delayed_frames;
-	ctx->stats.rx_sc_stats->InPktsUnchecked = stats.page_0.unchecked_frames;
 
-	memset(&stats, 0, sizeof(stats));
-	err = dpni_secy_get_rx_sc_stats(priv->mc_io, 0, priv->mc_token, priv->secy_id,
-					sci_to_cpu(ctx->rx_sc->sci), 1, &stats);
-	if (err) {
-		netdev_err(net_dev, "dpni_secy_get_rx_sc_stats() failed with %d\n", err);
-		return err;
-	}
+	ctx->stats.rx_sc_stats->InPktsUnusedSA = stats[0].page_0.unused_frames;
+	ctx->stats.rx_sc_stats->InPktsNotUsingSA = stats[0].page_0.not_using_sa_frames;
+	ctx->stats.rx_sc_stats->InPktsInvalid = stats[0].page_0.invalid_frames;
+	ctx->stats.rx_sc_stats->InPktsNotValid = stats[0].page_0.not_valid_frames;
+	ctx->stats.rx_sc_stats->InPktsLate = stats[0].page_0.late_frames;
+	ctx->stats.rx_sc_stats->InPktsDelayed = stats[0].page_0.delayed_frames;
+	ctx->stats.rx_sc_stats->InPktsUnchecked = stats[0].page_0.unchecked_frames;
 
-	ctx->stats.rx_sc_stats->InPktsOK = stats.page_1.ok_frames;
-	ctx->stats.rx_sc_stats->InOctetsValidated = stats.page_1.validated_bytes;
-	ctx->stats.rx_sc_stats->InOctetsDecrypted = stats.page_1.decrypted_bytes;
+	ctx->stats.rx_sc_stats->InPktsOK = stats[1].page_1.ok_frames;
+	ctx->stats.rx_sc_stats->InOctetsValidated = stats[1].page_1.validated_bytes;
+	ctx->stats.rx_sc_stats->InOctetsDecrypted = stats[1].page_1.decrypted_bytes;
 
 	return 0;
 }
@@ -581,23 +671,19 @@ static int dpaa2_mdo_get_rx_sc_stats(struct macsec_context *ctx)
 static int dpaa2_mdo_get_rx_sa_stats(struct macsec_context *ctx)
 {
 	struct dpaa2_eth_priv *priv = macsec_netdev_priv(ctx->netdev);
-	struct net_device *net_dev = priv->net_dev;
-	union macsec_secy_rx_sa_stats stats;
+	union macsec_secy_rx_sa_stats *stats;
 	int err;
 
-	memset(&stats, 0, sizeof(stats));
-	err = dpni_secy_get_rx_sa_stats(priv->mc_io, 0, priv->mc_token, priv->secy_id,
-					sci_to_cpu(ctx->rx_sc->sci), ctx->sa.assoc_num, &stats);
-	if (err) {
-		netdev_err(net_dev, "dpni_secy_get_rx_sa_stats() failed with %d\n", err);
+	err = dpaa2_macsec_stats_refresh(priv);
+	if (err)
 		return err;
-	}
 
-	ctx->stats.rx_sa_stats->InPktsUnusedSA = stats.page_0.unused_sa_frames;
-	ctx->stats.rx_sa_stats->InPktsNotUsingSA = stats.page_0.not_using_sa_frames;
-	ctx->stats.rx_sa_stats->InPktsInvalid = stats.page_0.invalid_frames;
-	ctx->stats.rx_sa_stats->InPktsNotValid = stats.page_0.not_valid_frames;
-	ctx->stats.rx_sa_stats->InPktsOK = stats.page_0.ok_frames;
+	stats = &priv->sec.stats.rx_sa[ctx->sa.assoc_num];
+	ctx->stats.rx_sa_stats->InPktsUnusedSA = stats->page_0.unused_sa_frames;
+	ctx->stats.rx_sa_stats->InPktsNotUsingSA = stats->page_0.not_using_sa_frames;
+	ctx->stats.rx_sa_stats->InPktsInvalid = stats->page_0.invalid_frames;
+	ctx->stats.rx_sa_stats->InPktsNotValid = stats->page_0.not_valid_frames;
+	ctx->stats.rx_sa_stats->InPktsOK = stats->page_0.ok_frames;
 
 	return 0;
 }
@@ -606,6 +692,7 @@ static const struct macsec_ops dpaa2_eth_macsec_ops = {
 	.mdo_dev_open = dpaa2_mdo_dev_open,
 	.mdo_dev_stop = dpaa2_mdo_dev_stop,
 	.mdo_add_secy = dpaa2_mdo_add_secy,
+	.mdo_upd_secy = dpaa2_mdo_upd_secy,
 	.mdo_del_secy = dpaa2_mdo_del_secy,
 	.mdo_add_rxsc = dpaa2_mdo_add_rxsc,
 	.mdo_upd_rxsc = dpaa2_mdo_upd_rxsc,
@@ -0,0 +1,384 @@
+// SPDX-License-Identifier: (GPL-2.0+ OR BSD-3-Clause)
+/* Copyright 2026 NXP
+ */
+#include <linux/cpu_rmap.h>
+#include <linux/netdevice.h>
+#include <linux/rtnetlink.h>
+#include <net/flow_dissector.h>
+
+#include "dpaa2-eth.h"
+
+/* Accelerated RFS support.
+ *
+ * ndo_rx_flow_steer() is called in softirq context, while the FS table can
+ * only be changed through MC commands, which may sleep. So the callback only
+ * records the flows to be steered and a work item programs them in hardware.
+ * The same work item periodically asks the stack which of the installed
+ * rules can be removed because their flows went idle.
+ *
+ * The rules share the FS table with the ones added through ethtool, which
+ * always take precedence. We only support aRFS when the FS table has key
+ * masking, so that all rules can use the same (maximal) key.
+ */
+
+static int dpaa2_eth_arfs_find_location(struct dpaa2_eth_priv *priv)
+{
+	int i;
+
+	/* Keep clear of the low locations, preferred by ethtool users */
+	for (i = dpaa2_eth_fs_count(priv) - 1; i >= 0; i--)
+		if (!priv->cls_rules[i].in_use)
+			return i;
+
+	return -ENOSPC;
+}
+
+static void dpaa2_eth_arfs_remove_rule(struct dpaa2_eth_priv *priv,
+				       struct dpaa2_eth_arfs_rule *rule)
+{
+	struct dpaa2_eth_cls_rule *cls_rule;
+
+	if (rule->location < 0)
+		return;
+
+	cls_rule = &priv->cls_rules[rule->location];
+	dpaa2_eth_do_cls_rule(priv->net_dev, &cls_rule->fs, false);
+	cls_rule->in_use = 0;
+	cls_rule->arfs = 0;
+	rule->location = -1;
+}
+
+static int dpaa2_eth_arfs_add_rule(struct dpaa2_eth_priv *priv,
+				   struct dpaa2_eth_arfs_rule *rule,
+				   const struct dpaa2_eth_arfs_rule *flow)
+{
+	struct dpaa2_eth_cls_rule *cls_rule;
+	struct ethtool_tcpip4_spec *spec;
+	struct ethtool_rx_flow_spec fs;
+	int location, err;
+
+	/* Reuse the location of a rule we are moving to a different queue */
+	location = rule->location;
+	dpaa2_eth_arfs_remove_rule(priv, rule);
+	if (location < 0)
+		location = dpaa2_eth_arfs_find_location(priv);
+	if (location < 0)
+		return location;
+
+	memset(&fs, 0, sizeof(fs));
+	fs.flow_type = flow->ip_proto == IPPROTO_TCP ? TCP_V4_FLOW : UDP_V4_FLOW;
+	fs.ring_cookie = flow->rxq;
+	fs.location = location;
+
+	/* TCP and UDP specs share the same layout */
+	spec = &fs.h_u.tcp_ip4_spec;
+	spec->ip4src = flow->saddr;
+	spec->ip4dst = flow->daddr;
+	spec->psrc = flow->sport;
+	spec->pdst = flow->dport;
+
+	spec = &fs.m_u.tcp_ip4_spec;
+	spec->ip4src = htonl(0xffffffff);
+	spec->ip4dst = htonl(0xffffffff);
+	spec->psrc = htons(0xffff);
+	spec->pdst = htons(0xffff);
+
+	err = dpaa2_eth_do_cls_rule(priv->net_dev, &fs, true);
+	if (err)
+		return err;
+
+	cls_rule = &priv->cls_rules[location];
+	cls_rule->fs = fs;
+	cls_rule->in_use = 1;
+	cls_rule->arfs = 1;
+	rule->location = location;
+
+	return 0;
+}
+
+static void dpaa2_eth_arfs_work(struct work_struct *work)
+{
+	struct dpaa2_eth_priv *priv = container_of(to_delayed_work(work),
+						   struct dpaa2_eth_priv,
+						   arfs.work);
+	struct dpaa2_eth_arfs *arfs = &priv->arfs;
+	struct dpaa2_eth_arfs_rule *rule, flow;
+	bool busy = false;
+	int i, err;
+
+	/* Flushing the rules cancels the work with rtnl held */
+	if (!rtnl_trylock()) {
+		schedule_delayed_work(&arfs->work, 1);
+		return;
+	}
+
+	for (i = 0; i < arfs->num_rules; i++) {
+		rule = &arfs->rules[i];
+
+		spin_lock_bh(&arfs->lock);
+		flow = *rule;
+		if (rule->state == DPAA2_ETH_ARFS_PENDING)
+			rule->state = DPAA2_ETH_ARFS_ACTIVE;
+		spin_unlock_bh(&arfs->lock);
+
+		switch (flow.state) {
+		case DPAA2_ETH_ARFS_FREE:
+			continue;
+		case DPAA2_ETH_ARFS_PENDING:
+			err = dpaa2_eth_arfs_add_rule(priv, rule, &flow);
+			if (!err)
+				break;
+
+			netdev_dbg(priv->net_dev,
+				   "Failed to steer flow %u to queue %u: %d\n",
+				   flow.flow_id, flow.rxq, err);
+			spin_lock_bh(&arfs->lock);
+			if (rule->state == DPAA2_ETH_ARFS_ACTIVE)
+				rule->state = DPAA2_ETH_ARFS_FREE;
+			spin_unlock_bh(&arfs->lock);
+			continue;
+		case DPAA2_ETH_ARFS_ACTIVE:
+			if (!rps_may_expire_flow(priv->net_dev, flow.rxq,
+						 flow.flow_id, i))
+				break;
+
+			spin_lock_bh(&arfs->lock);
+			if (rule->state == DPAA2_ETH_ARFS_ACTIVE)
+				rule->state = DPAA2_ETH_ARFS_FREE;
+			spin_unlock_bh(&arfs->lock);
+
+			/* If the slot was taken over by a new flow meanwhile,
+			 * the next run of the work will program it
+			 */
+			dpaa2_eth_arfs_remove_rule(priv, rule);
+			continue;
+		}
+
+		busy = true;
+	}
+
+	rtnl_unlock();
+
+	if (busy)
+		schedule_delayed_work(&arfs->work,
+				      DPAA2_ETH_ARFS_EXPIRE_INTERVAL);
+}
+
+int dpaa2_eth_rx_flow_steer(struct net_device *net_dev,
+			    const struct sk_buff *skb,
+			    u16 rxq_index, u32 flow_id)
+{
+	struct dpaa2_eth_priv *priv = netdev_priv(net_dev);
+	struct dpaa2_eth_arfs *arfs = &priv->arfs;
+	struct dpaa2_eth_arfs_rule *rule, *free_rule = NULL;
+	struct flow_keys keys;
+	int i, ret;
+
+	if (skb->encapsulation)
+		return -EPROTONOSUPPORT;
+
+	if (!skb_flow_dissect_flow_keys(skb, &keys, 0))
+		return -EPROTONOSUPPORT;
+
+	if (keys.basic.n_proto != htons(ETH_P_IP) ||
+	    (keys.basic.ip_proto != IPPROTO_TCP &&
+	     keys.basic.ip_proto != IPPROTO_UDP) ||
+	    keys.control.flags & FLOW_DIS_IS_FRAGMENT)
+		return -EPROTONOSUPPORT;
+
+	spin_lock_bh(&arfs->lock);
+
+	if (!arfs->enabled) {
+		ret = -EOPNOTSUPP;
+		goto out;
+	}
+
+	for (i = 0; i < arfs->num_rules; i++) {
+		rule = &arfs->rules[i];
+
+		if (rule->state == DPAA2_ETH_ARFS_FREE) {
+			if (!free_rule)
+				free_rule = rule;
+			continue;
+		}
+
+		if (rule->flow_id != flow_id ||
+		    rule->saddr != keys.addrs.v4addrs.src ||
+		    rule->daddr != keys.addrs.v4addrs.dst ||
+		    rule->sport != keys.ports.src ||
+		    rule->dport != keys.ports.dst ||
+		    rule->ip_proto != keys.basic.ip_proto)
+			continue;
+
+		/* Flow already steered, maybe to a different queue */
+		if (rule->rxq != rxq_index) {
+			rule->rxq = rxq_index;
+			rule->state = DPAA2_ETH_ARFS_PENDING;
+			mod_delayed_work(system_wq, &arfs->work, 0);
+		}
+		ret = i;
+		goto out;
+	}
+
+	if (!free_rule) {
+		ret = -ENOSPC;
+		goto out;
+	}
+
+	free_rule->saddr = keys.addrs.v4addrs.src;
+	free_rule->daddr = keys.addrs.v4addrs.dst;
+	free_rule->sport = keys.ports.src;
+	free_rule->dport = keys.ports.dst;
+	free_rule->ip_proto = keys.basic.ip_proto;
+	free_rule->rxq = rxq_index;
+	free_rule->flow_id = flow_id;
+	free_rule->state = DPAA2_ETH_ARFS_PENDING;
+	mod_delayed_work(system_wq, &arfs->work, 0);
+
+	ret = free_rule - arfs->rules;
+out:
+	spin_unlock_bh(&arfs->lock);
+
+	return ret;
+}
+
+/* Called with rtnl held when a user rule is installed at a location used by
+ * accelerated RFS. The rule was already removed from the FS table.
+ */
+void dpaa2_eth_arfs_evict(struct dpaa2_eth_priv *priv, int location)
+{
+	struct dpaa2_eth_arfs *arfs = &priv->arfs;
+	struct dpaa2_eth_arfs_rule *rule;
+	int i;
+
+	for (i = 0; i < arfs->num_rules; i++) {
+		rule = &arfs->rules[i];
+		if (rule->location != location)
+			continue;
+
+		rule->location = -1;
+		spin_lock_bh(&arfs->lock);
+		if (rule->state == DPAA2_ETH_ARFS_ACTIVE)
+			rule->state = DPAA2_ETH_ARFS_FREE;
+		spin_unlock_bh(&arfs->lock);
+		break;
+	}
+}
+
+static void dpaa2_eth_arfs_flush(struct dpaa2_eth_priv *priv)
+{
+	struct dpaa2_eth_arfs *arfs = &priv->arfs;
+	struct dpaa2_eth_arfs_rule *rule;
+	int i;
+
+	cancel_delayed_work_sync(&arfs->work);
+
+	for (i = 0; i < arfs->num_rules; i++) {
+		rule = &arfs->rules[i];
+
+		dpaa2_eth_arfs_remove_rule(priv, rule);
+		spin_lock_bh(&arfs->lock);
+		rule->state = DPAA2_ETH_ARFS_FREE;
+		spin_unlock_bh(&arfs->lock);
+	}
+}
+
+/* Called with rtnl held when NETIF_F_NTUPLE is toggled */
+int dpaa2_eth_arfs_enable(struct dpaa2_eth_priv *priv, bool enable)
+{
+	struct dpaa2_eth_arfs *arfs = &priv->arfs;
+
+	if (!arfs->rules)
+		return enable ? -EOPNOTSUPP : 0;
+
+	spin_lock_bh(&arfs->lock);
+	arfs->enabled = enable;
+	spin_unlock_bh(&arfs->lock);
+
+	if (!enable)
+		dpaa2_eth_arfs_flush(priv);
+
+	return 0;
+}
+
+static int dpaa2_eth_arfs_set_rmap(struct dpaa2_eth_priv *priv)
+{
+	struct net_device *net_dev = priv->net_dev;
+	struct dpaa2_eth_fq *fq;
+	struct cpu_rmap *rmap;
+	int i, index;
+
+	rmap = alloc_cpu_rmap(dpaa2_eth_queue_count(priv), GFP_KERNEL);
+	if (!rmap)
+		return -ENOMEM;
+
+	/* Rx queues of the first traffic class are the ones the stack knows
+	 * about; map each of them to the CPU processing its frames
+	 */
+	for (i = 0; i < priv->num_fqs; i++) {
+		fq = &priv->fq[i];
+		if (fq->type != DPAA2_RX_FQ || fq->tc)
+			continue;
+
+		index = cpu_rmap_add(rmap, fq);
+		if (index < 0) {
+			free_cpu_rmap(rmap);
+			return index;
+		}
+		cpu_rmap_update(rmap, index, cpumask_of(fq->target_cpu));
+	}
+
+	net_dev->rx_cpu_rmap = rmap;
+
+	return 0;
+}
+
+int dpaa2_eth_arfs_init(struct dpaa2_eth_priv *priv)
+{
+	struct dpaa2_eth_arfs *arfs = &priv->arfs;
+	int i, err;
+
+	spin_lock_init(&arfs->lock);
+	INIT_DELAYED_WORK(&arfs->work, dpaa2_eth_arfs_work);
+
+	if (!priv->rx_cls_enabled || !dpaa2_eth_fs_mask_enabled(priv) ||
+	    !dpaa2_eth_fs_count(priv))
+		return 0;
+
+	arfs->num_rules = min_t(int, dpaa2_eth_fs_count(priv),
+				DPAA2_ETH_ARFS_MAX_RULES);
+	arfs->rules = kcalloc(arfs->num_rules, sizeof(*arfs->rules),
+			      GFP_KERNEL);
+	if (!arfs->rules)
+		return -ENOMEM;
+
+	for (i = 0; i < arfs->num_rules; i++)
+		arfs->rules[i].location = -1;
+
+	err = dpaa2_eth_arfs_set_rmap(priv);
+	if (err) {
+		kfree(arfs->rules);
+		arfs->rules = NULL;
+		return err;
+	}
+
+	priv->net_dev->hw_features |= NETIF_F_NTUPLE;
+
+	return 0;
+}
+
+void dpaa2_eth_arfs_free(struct dpaa2_eth_priv *priv)
+{
+	struct dpaa2_eth_arfs *arfs = &priv->arfs;
+
+	if (!arfs->rules)
+		return;
+
+	cancel_delayed_work_sync(&arfs->work);
+
+	free_cpu_rmap(priv->net_dev->rx_cpu_rmap);
+	priv->net_dev->rx_cpu_rmap = NULL;
+
+	kfree(arfs->rules);
+	arfs->rules = NULL;
+}
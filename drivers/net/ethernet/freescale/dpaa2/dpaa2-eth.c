@@ -16,10 +16,14 @@
 #include <linux/fsl/ptp_qoriq.h>
 #include <linux/ptp_classify.h>
 #include <linux/device/driver.h>
+#include <linux/jhash.h>
+#include <linux/unaligned.h>
+#include <net/ipv6.h>
 #include <net/pkt_cls.h>
 #include <net/sock.h>
 #include <net/tso.h>
 #include <net/xdp_sock_drv.h>
+#include <net/page_pool/helpers.h>
 
 #include "dpaa2-eth.h"
 #include "dpaa2-eth-ceetm.h"
@@ -143,6 +147,17 @@ static void dpaa2_eth_validate_rx_csum(struct dpaa2_eth_priv *priv,
 	skb->ip_summed = CHECKSUM_UNNECESSARY;
 }
 
+/* Rx buffers stay DMA mapped by their page_pool for their whole life. Since
+ * several channels may share a buffer pool, a buffer goes back to the
+ * page_pool it was allocated from rather than to the channel's own.
+ */
+static void dpaa2_eth_put_rx_page(void *vaddr)
+{
+	struct page *page = virt_to_head_page(vaddr);
+
+	page_pool_put_full_page(page->pp, page, false);
+}
+
 /* Free a received FD.
  * Not to be used for Tx conf FDs or on any other paths.
  */
@@ -150,7 +165,6 @@ static void dpaa2_eth_free_rx_fd(struct dpaa2_eth_priv *priv,
 				 const struct dpaa2_fd *fd,
 				 void *vaddr)
 {
-	struct device *dev = priv->net_dev->dev.parent;
 	dma_addr_t addr = dpaa2_fd_get_addr(fd);
 	u8 fd_format = dpaa2_fd_get_format(fd);
 	struct dpaa2_sg_entry *sgt;
@@ -171,16 +185,13 @@ static void dpaa2_eth_free_rx_fd(struct dpaa2_eth_priv *priv,
 	for (i = 1; i < DPAA2_ETH_MAX_SG_ENTRIES; i++) {
 		addr = dpaa2_sg_get_addr(&sgt[i]);
 		sg_vaddr = dpaa2_iova_to_virt(priv->iommu_domain, addr);
-		dma_unmap_page(dev, addr, priv->rx_buf_size,
-			       DMA_BIDIRECTIONAL);
-
-		free_pages((unsigned long)sg_vaddr, 0);
+		dpaa2_eth_put_rx_page(sg_vaddr);
 		if (dpaa2_sg_is_final(&sgt[i]))
 			break;
 	}
 
 free_buf:
-	free_pages((unsigned long)vaddr, 0);
+	dpaa2_eth_put_rx_page(vaddr);
 }
 
 /* Build a linear skb based on a single-buffer frame descriptor */
@@ -198,6 +209,7 @@ static struct sk_buff *dpaa2_eth_build_linear_skb(struct dpaa2_eth_channel *ch,
 	if (unlikely(!skb))
 		return NULL;
 
+	skb_mark_for_recycle(skb);
 	skb_reserve(skb, fd_offset);
 	skb_put(skb, fd_length);
 
@@ -229,8 +241,8 @@ static struct sk_buff *dpaa2_eth_build_frag_skb(struct dpaa2_eth_priv *priv,
 		/* Get the address and length from the S/G entry */
 		sg_addr = dpaa2_sg_get_addr(sge);
 		sg_vaddr = dpaa2_iova_to_virt(priv->iommu_domain, sg_addr);
-		dma_unmap_page(dev, sg_addr, priv->rx_buf_size,
-			       DMA_BIDIRECTIONAL);
+		dma_sync_single_for_cpu(dev, sg_addr, priv->rx_buf_size,
+					DMA_BIDIRECTIONAL);
 
 		sg_length = dpaa2_sg_get_len(sge);
 
@@ -239,9 +251,9 @@ static struct sk_buff *dpaa2_eth_build_frag_skb(struct dpaa2_eth_priv *priv,
 			skb = build_skb(sg_vaddr, DPAA2_ETH_RX_BUF_RAW_SIZE);
 			if (unlikely(!skb)) {
 				/* Free the first SG entry now, since we already
-				 * unmapped it and obtained the virtual address
+				 * obtained the virtual address
 				 */
-				free_pages((unsigned long)sg_vaddr, 0);
+				dpaa2_eth_put_rx_page(sg_vaddr);
 
 				/* We still need to subtract the buffers used
 				 * by this FD from our software counter
@@ -252,6 +264,7 @@ static struct sk_buff *dpaa2_eth_build_frag_skb(struct dpaa2_eth_priv *priv,
 				break;
 			}
 
+			skb_mark_for_recycle(skb);
 			sg_offset = dpaa2_sg_get_offset(sge);
 			skb_reserve(skb, sg_offset);
 			skb_put(skb, sg_length);
@@ -291,7 +304,6 @@ static struct sk_buff *dpaa2_eth_build_frag_skb(struct dpaa2_eth_priv *priv,
 static void dpaa2_eth_free_bufs(struct dpaa2_eth_priv *priv, u64 *buf_array,
 				int count, bool xsk_zc)
 {
-	struct device *dev = priv->net_dev->dev.parent;
 	struct dpaa2_eth_swa *swa;
 	struct xdp_buff *xdp_buff;
 	void *vaddr;
@@ -301,9 +313,7 @@ static void dpaa2_eth_free_bufs(struct dpaa2_eth_priv *priv, u64 *buf_array,
 		vaddr = dpaa2_iova_to_virt(priv->iommu_domain, buf_array[i]);
 
 		if (!xsk_zc) {
-			dma_unmap_page(dev, buf_array[i], priv->rx_buf_size,
-				       DMA_BIDIRECTIONAL);
-			free_pages((unsigned long)vaddr, 0);
+			dpaa2_eth_put_rx_page(vaddr);
 		} else {
 			swa = (struct dpaa2_eth_swa *)
 				(vaddr + DPAA2_ETH_RX_HWA_SIZE);
@@ -475,25 +485,19 @@ static u32 dpaa2_eth_run_xdp(struct dpaa2_eth_priv *priv,
 		ch->stats.xdp_drop++;
 		break;
 	case XDP_REDIRECT:
-		dma_unmap_page(priv->net_dev->dev.parent, addr,
-			       priv->rx_buf_size, DMA_BIDIRECTIONAL);
 		ch->buf_count--;
 
 		/* Allow redirect use of full headroom */
 		xdp.data_hard_start = vaddr;
 		xdp.frame_sz = DPAA2_ETH_RX_BUF_RAW_SIZE;
 
+		/* The page keeps its page_pool mapping, so on failure it can
+		 * go straight back to the buffer pool
+		 */
 		err = xdp_do_redirect(priv->net_dev, &xdp, xdp_prog);
 		if (unlikely(err)) {
-			addr = dma_map_page(priv->net_dev->dev.parent,
-					    virt_to_page(vaddr), 0,
-					    priv->rx_buf_size, DMA_BIDIRECTIONAL);
-			if (unlikely(dma_mapping_error(priv->net_dev->dev.parent, addr))) {
-				free_pages((unsigned long)vaddr, 0);
-			} else {
-				ch->buf_count++;
-				dpaa2_eth_recycle_buf(priv, ch, addr);
-			}
+			ch->buf_count++;
+			dpaa2_eth_recycle_buf(priv, ch, addr);
 			ch->stats.xdp_drop++;
 		} else {
 			ch->stats.xdp_redirect++;
@@ -506,6 +510,182 @@ static u32 dpaa2_eth_run_xdp(struct dpaa2_eth_priv *priv,
 	return xdp_act;
 }
 
+/* Build a multi-buffer xdp_buff based on a S/G table. The first data buffer
+ * holds the linear part of the frame and, in its tailroom, the shared info
+ * describing the rest of the data buffers as frags.
+ */
+static void dpaa2_eth_sg_to_xdp_buff(struct dpaa2_eth_priv *priv,
+				     struct dpaa2_eth_channel *ch,
+				     struct dpaa2_sg_entry *sgt,
+				     struct xdp_buff *xdp)
+{
+	struct device *dev = priv->net_dev->dev.parent;
+	struct skb_shared_info *sinfo;
+	struct page *page, *head_page;
+	void *sg_vaddr, *buf_start;
+	dma_addr_t sg_addr;
+	u32 sg_length;
+	int page_offset, offset;
+	int i;
+
+	for (i = 0; i < DPAA2_ETH_MAX_SG_ENTRIES; i++) {
+		struct dpaa2_sg_entry *sge = &sgt[i];
+
+		sg_addr = dpaa2_sg_get_addr(sge);
+		sg_vaddr = dpaa2_iova_to_virt(priv->iommu_domain, sg_addr);
+		dma_sync_single_for_cpu(dev, sg_addr, priv->rx_buf_size,
+					DMA_BIDIRECTIONAL);
+
+		sg_length = dpaa2_sg_get_len(sge);
+
+		if (i == 0) {
+			buf_start = sg_vaddr;
+			offset = dpaa2_sg_get_offset(sge) - XDP_PACKET_HEADROOM;
+			xdp_init_buff(xdp, DPAA2_ETH_RX_BUF_RAW_SIZE - offset,
+				      &ch->xdp_rxq);
+			xdp_prepare_buff(xdp, buf_start + offset,
+					 XDP_PACKET_HEADROOM, sg_length, false);
+
+			sinfo = xdp_get_shared_info_from_buff(xdp);
+			sinfo->nr_frags = 0;
+			sinfo->xdp_frags_size = 0;
+			xdp_buff_set_frags_flag(xdp);
+		} else {
+			/* Same as for the skb frags, data in subsequent SG
+			 * entries starts at the beginning of the buffer
+			 */
+			page = virt_to_page(sg_vaddr);
+			head_page = virt_to_head_page(sg_vaddr);
+			page_offset = ((unsigned long)sg_vaddr &
+				(PAGE_SIZE - 1)) +
+				(page_address(page) - page_address(head_page));
+
+			skb_frag_fill_page_desc(&sinfo->frags[sinfo->nr_frags++],
+						head_page, page_offset,
+						sg_length);
+			sinfo->xdp_frags_size += sg_length;
+			if (page_is_pfmemalloc(head_page))
+				xdp_buff_set_frag_pfmemalloc(xdp);
+		}
+
+		if (dpaa2_sg_is_final(sge))
+			break;
+	}
+
+	WARN_ONCE(i == DPAA2_ETH_MAX_SG_ENTRIES, "Final bit not set in SGT");
+
+	/* Count all data buffers + SG table buffer */
+	ch->buf_count -= i + 2;
+}
+
+/* Build a non linear skb around a multi-buffer xdp_buff which the XDP
+ * program decided to pass up the stack
+ */
+static struct sk_buff *dpaa2_eth_xdp_build_skb(struct dpaa2_eth_priv *priv,
+					       struct xdp_buff *xdp)
+{
+	struct skb_shared_info *sinfo = xdp_get_shared_info_from_buff(xdp);
+	u32 frags_size = sinfo->xdp_frags_size;
+	u8 nr_frags = sinfo->nr_frags;
+	struct sk_buff *skb;
+
+	/* build_skb() clears nr_frags, but leaves the frags array untouched */
+	skb = build_skb(xdp->data_hard_start, xdp->frame_sz);
+	if (unlikely(!skb))
+		return NULL;
+
+	skb_mark_for_recycle(skb);
+	skb_reserve(skb, xdp->data - xdp->data_hard_start);
+	__skb_put(skb, xdp->data_end - xdp->data);
+
+	xdp_update_skb_shared_info(skb, nr_frags, frags_size,
+				   nr_frags * priv->rx_buf_size,
+				   xdp_buff_is_frag_pfmemalloc(xdp));
+
+	return skb;
+}
+
+static int dpaa2_eth_xdp_xmit(struct net_device *net_dev, int n,
+			      struct xdp_frame **frames, u32 flags);
+
+/* Run the XDP program on a S/G frame. The SGT buffer itself is not part of
+ * the xdp_buff and is released back to the page_pool right away.
+ * On XDP_PASS, *skb is set to the frame to be delivered to the stack, or to
+ * NULL if building it failed, in which case the frame was already freed.
+ */
+static u32 dpaa2_eth_run_xdp_sg(struct dpaa2_eth_priv *priv,
+				struct dpaa2_eth_channel *ch,
+				struct bpf_prog *xdp_prog,
+				struct dpaa2_fd *fd, void *vaddr,
+				struct sk_buff **skb)
+{
+	struct dpaa2_sg_entry *sgt = vaddr + dpaa2_fd_get_offset(fd);
+	struct xdp_frame *xdpf;
+	struct xdp_buff xdp;
+	u32 xdp_act;
+	int err;
+
+	dpaa2_eth_sg_to_xdp_buff(priv, ch, sgt, &xdp);
+	dpaa2_eth_put_rx_page(vaddr);
+
+	xdp_act = bpf_prog_run_xdp(xdp_prog, &xdp);
+
+	/* The frame length may have changed */
+	dpaa2_fd_set_len(fd, xdp_get_buff_len(&xdp));
+
+	/* Allow redirect and Tx use of full headroom */
+	if (xdp_act == XDP_TX || xdp_act == XDP_REDIRECT) {
+		xdp.data_hard_start = xdp.data_hard_start -
+			(DPAA2_ETH_RX_BUF_RAW_SIZE - xdp.frame_sz);
+		xdp.frame_sz = DPAA2_ETH_RX_BUF_RAW_SIZE;
+	}
+
+	switch (xdp_act) {
+	case XDP_PASS:
+		*skb = dpaa2_eth_xdp_build_skb(priv, &xdp);
+		if (unlikely(!*skb))
+			xdp_return_buff(&xdp);
+		break;
+	case XDP_TX:
+		/* Multi-buffer frames need a S/G FD and a Tx confirmation
+		 * to release the frags, so send them on the xdp_xmit path
+		 * instead of the XDP_TX one
+		 */
+		xdpf = xdp_convert_buff_to_frame(&xdp);
+		if (unlikely(!xdpf) ||
+		    dpaa2_eth_xdp_xmit(priv->net_dev, 1, &xdpf, 0) != 1) {
+			xdp_return_buff(&xdp);
+			ch->stats.xdp_tx_err++;
+			break;
+		}
+		ch->stats.xdp_tx++;
+		break;
+	default:
+		bpf_warn_invalid_xdp_action(priv->net_dev, xdp_prog, xdp_act);
+		fallthrough;
+	case XDP_ABORTED:
+		trace_xdp_exception(priv->net_dev, xdp_prog, xdp_act);
+		fallthrough;
+	case XDP_DROP:
+		xdp_return_buff(&xdp);
+		ch->stats.xdp_drop++;
+		break;
+	case XDP_REDIRECT:
+		err = xdp_do_redirect(priv->net_dev, &xdp, xdp_prog);
+		if (unlikely(err)) {
+			xdp_return_buff(&xdp);
+			ch->stats.xdp_drop++;
+		} else {
+			ch->stats.xdp_redirect++;
+		}
+		break;
+	}
+
+	ch->xdp.res |= xdp_act;
+
+	return xdp_act;
+}
+
 struct sk_buff *dpaa2_eth_alloc_skb(struct dpaa2_eth_priv *priv,
 				    struct dpaa2_eth_channel *ch,
 				    const struct dpaa2_fd *fd, u32 fd_length,
@@ -552,6 +732,50 @@ static bool frame_is_tcp(const struct dpaa2_fd *fd, struct dpaa2_fas *fas)
 	return !!(fapr->faf_hi & DPAA2_FAF_HI_TCP_PRESENT);
 }
 
+/* Set a flow hash on TCP frames based on the offsets found by the hardware
+ * parser. Without it, GRO keeps all flows in the same hash bucket and, with
+ * many flows received at the same time, ends up flushing packets before
+ * being able to aggregate them.
+ */
+static void dpaa2_eth_set_rx_hash(struct dpaa2_fas *fas, struct sk_buff *skb)
+{
+	struct dpaa2_fapr *fapr = dpaa2_get_fapr(fas, false);
+	static u32 dpaa2_eth_hash_rnd __read_mostly;
+	const u8 *base = skb_mac_header(skb);
+	const struct ipv6hdr *ip6h;
+	const struct iphdr *iph;
+	u32 saddr, daddr, ports;
+	u8 l3_off, l4_off;
+
+	l3_off = fapr->l3_offset_n;
+	l4_off = fapr->l4_offset;
+	if (base + l4_off + sizeof(ports) > skb->data + skb_headlen(skb) ||
+	    l3_off + sizeof(*iph) > l4_off)
+		return;
+
+	switch (base[l3_off] >> 4) {
+	case 4:
+		iph = (const struct iphdr *)(base + l3_off);
+		saddr = (__force u32)iph->saddr;
+		daddr = (__force u32)iph->daddr;
+		break;
+	case 6:
+		if (l3_off + sizeof(*ip6h) > l4_off)
+			return;
+		ip6h = (const struct ipv6hdr *)(base + l3_off);
+		saddr = ipv6_addr_hash(&ip6h->saddr);
+		daddr = ipv6_addr_hash(&ip6h->daddr);
+		break;
+	default:
+		return;
+	}
+	ports = get_unaligned((const u32 *)(base + l4_off));
+
+	net_get_random_once(&dpaa2_eth_hash_rnd, sizeof(dpaa2_eth_hash_rnd));
+	skb_set_hash(skb, jhash_3words(saddr, daddr, ports, dpaa2_eth_hash_rnd),
+		     PKT_HASH_TYPE_L4);
+}
+
 void dpaa2_eth_receive_skb(struct dpaa2_eth_priv *priv,
 			   struct dpaa2_eth_channel *ch,
 			   const struct dpaa2_fd *fd, void *vaddr,
@@ -596,8 +820,15 @@ void dpaa2_eth_receive_skb(struct dpaa2_eth_priv *priv,
 	percpu_stats->rx_bytes += dpaa2_fd_get_len(fd);
 	ch->stats.bytes_per_cdan += dpaa2_fd_get_len(fd);
 
-	if (frame_is_tcp(fd, fas))
+	if (frame_is_tcp(fd, fas)) {
+		/* XDP programs may have moved the frame start, in which case
+		 * the parse results no longer match the frame contents
+		 */
+		if (priv->net_dev->features & NETIF_F_RXHASH &&
+		    !READ_ONCE(ch->xdp.prog))
+			dpaa2_eth_set_rx_hash(fas, skb);
 		napi_gro_receive(&ch->napi, skb);
+	}
 	else
 		list_add_tail(&skb->list, ch->rx_list);
 }
@@ -615,6 +846,7 @@ void dpaa2_eth_rx(struct dpaa2_eth_priv *priv,
 	struct rtnl_link_stats64 *percpu_stats;
 	struct dpaa2_eth_drv_stats *percpu_extras;
 	struct device *dev = priv->net_dev->dev.parent;
+	struct bpf_prog *xdp_prog;
 	bool recycle_rx_buf = false;
 	void *buf_data;
 	u32 xdp_act;
@@ -642,21 +874,33 @@ void dpaa2_eth_rx(struct dpaa2_eth_priv *priv,
 
 		skb = dpaa2_eth_copybreak(ch, fd, vaddr);
 		if (!skb) {
-			dma_unmap_page(dev, addr, priv->rx_buf_size,
-				       DMA_BIDIRECTIONAL);
 			skb = dpaa2_eth_build_linear_skb(ch, fd, vaddr);
 		} else {
 			recycle_rx_buf = true;
 		}
 	} else if (fd_format == dpaa2_fd_sg) {
-		WARN_ON(priv->xdp_prog);
-
-		dma_unmap_page(dev, addr, priv->rx_buf_size,
-			       DMA_BIDIRECTIONAL);
-		skb = dpaa2_eth_build_frag_skb(priv, ch, buf_data);
-		free_pages((unsigned long)vaddr, 0);
 		percpu_extras->rx_sg_frames++;
 		percpu_extras->rx_sg_bytes += dpaa2_fd_get_len(fd);
+
+		xdp_prog = READ_ONCE(ch->xdp.prog);
+		if (xdp_prog) {
+			skb = NULL;
+			xdp_act = dpaa2_eth_run_xdp_sg(priv, ch, xdp_prog,
+						       (struct dpaa2_fd *)fd,
+						       vaddr, &skb);
+			if (xdp_act != XDP_PASS) {
+				percpu_stats->rx_packets++;
+				percpu_stats->rx_bytes += dpaa2_fd_get_len(fd);
+				return;
+			}
+
+			/* The frame buffers were already freed in this case */
+			if (unlikely(!skb))
+				goto err_frame_format;
+		} else {
+			skb = dpaa2_eth_build_frag_skb(priv, ch, buf_data);
+			dpaa2_eth_put_rx_page(vaddr);
+		}
 	} else {
 		/* We don't support any other format */
 		goto err_frame_format;
@@ -702,14 +946,10 @@ static void dpaa2_eth_rx_err(struct dpaa2_eth_priv *priv,
 	buf_data = vaddr + dpaa2_fd_get_offset(fd);
 
 	if (fd_format == dpaa2_fd_single) {
-		dma_unmap_page(dev, addr, priv->rx_buf_size,
-			       DMA_BIDIRECTIONAL);
 		skb = dpaa2_eth_build_linear_skb(ch, fd, vaddr);
 	} else if (fd_format == dpaa2_fd_sg) {
-		dma_unmap_page(dev, addr, priv->rx_buf_size,
-			       DMA_BIDIRECTIONAL);
 		skb = dpaa2_eth_build_frag_skb(priv, ch, buf_data);
-		free_pages((unsigned long)vaddr, 0);
+		dpaa2_eth_put_rx_page(vaddr);
 	} else {
 		/* We don't support any other format */
 		dpaa2_eth_free_rx_fd(priv, fd, vaddr);
@@ -740,8 +980,9 @@ static int dpaa2_eth_consume_frames(struct dpaa2_eth_channel *ch,
 {
 	struct dpaa2_eth_priv *priv = ch->priv;
 	struct dpaa2_eth_fq *fq = NULL;
-	struct dpaa2_dq *dq;
+	struct dpaa2_dq *dq, *next;
 	const struct dpaa2_fd *fd;
+	dma_addr_t next_addr;
 	int cleaned = 0, retries = 0;
 	int is_last;
 
@@ -764,6 +1005,19 @@ static int dpaa2_eth_consume_frames(struct dpaa2_eth_channel *ch,
 		fd = dpaa2_dq_fd(dq);
 		fq = (struct dpaa2_eth_fq *)(uintptr_t)dpaa2_dq_fqd_ctx(dq);
 
+		/* Start bringing in the annotation area of the next frame,
+		 * if it's already in the store. Not worth an extra IOMMU
+		 * lookup though.
+		 */
+		if (!priv->iommu_domain) {
+			next = dpaa2_io_store_peek(ch->store);
+			if (next) {
+				next_addr = dpaa2_fd_get_addr(dpaa2_dq_fd(next));
+				prefetch(dpaa2_get_fas(phys_to_virt(next_addr),
+						       false));
+			}
+		}
+
 		fq->consume(priv, ch, fd, fq);
 		cleaned++;
 		retries = 0;
@@ -884,16 +1138,16 @@ static void dpaa2_eth_enable_tx_tstamp(struct dpaa2_eth_priv *priv,
 		*(__be32 *)(data + offset2 + 2) =
 			htonl(origin_timestamp.sec_lsb);
 		*(__be32 *)(data + offset2 + 6) = htonl(origin_timestamp.nsec);
-
-		if (priv->ptp_correction_off == offset1)
-			return;
-
-		priv->dpaa2_set_onestep_params_cb(priv, offset1, udp);
-		priv->ptp_correction_off = offset1;
-
 	}
 }
 
+/* A one-step timestamping frame was confirmed or dropped */
+static void dpaa2_eth_onestep_done(struct dpaa2_eth_priv *priv)
+{
+	if (atomic_dec_and_test(&priv->onestep_inflight))
+		wake_up(&priv->onestep_wq);
+}
+
 void *dpaa2_eth_sgt_get(struct dpaa2_eth_priv *priv)
 {
 	struct dpaa2_eth_sgt_cache *sgt_cache;
@@ -1223,6 +1477,22 @@ void dpaa2_eth_free_tx_fd(struct dpaa2_eth_priv *priv,
 			/* Unmap the SGT Buffer */
 			dma_unmap_single(dev, fd_addr, swa->xsk.sgt_size,
 					 DMA_BIDIRECTIONAL);
+		} else if (swa->type == DPAA2_ETH_SWA_XDP) {
+			sgt = (struct dpaa2_sg_entry *)(buffer_start +
+							priv->tx_data_offset);
+
+			/* Unmap the SGT buffer */
+			dma_unmap_single(dev, fd_addr, swa->xdp.dma_size,
+					 DMA_BIDIRECTIONAL);
+
+			/* Unmap the linear part and then the frags */
+			dma_unmap_single(dev, dpaa2_sg_get_addr(sgt),
+					 dpaa2_sg_get_len(sgt),
+					 DMA_BIDIRECTIONAL);
+			for (i = 1; !dpaa2_sg_is_final(&sgt[i - 1]); i++)
+				dma_unmap_page(dev, dpaa2_sg_get_addr(&sgt[i]),
+					       dpaa2_sg_get_len(&sgt[i]),
+					       DMA_BIDIRECTIONAL);
 		} else {
 			skb = swa->single.skb;
 
@@ -1253,6 +1523,8 @@ void dpaa2_eth_free_tx_fd(struct dpaa2_eth_priv *priv,
 
 	if (swa->type == DPAA2_ETH_SWA_XDP) {
 		xdp_return_frame(swa->xdp.xdpf);
+		if (fd_format != dpaa2_fd_single)
+			dpaa2_eth_sgt_recycle(priv, buffer_start);
 		return;
 	}
 
@@ -1275,7 +1547,7 @@ void dpaa2_eth_free_tx_fd(struct dpaa2_eth_priv *priv,
 			shhwtstamps.hwtstamp = ns_to_ktime(ns);
 			skb_tstamp_tx(skb, &shhwtstamps);
 		} else if (skb->cb[0] == TX_TSTAMP_ONESTEP_SYNC) {
-			mutex_unlock(&priv->onestep_tstamp_lock);
+			dpaa2_eth_onestep_done(priv);
 		}
 	}
 
@@ -1480,12 +1752,14 @@ static netdev_tx_t __dpaa2_eth_tx(struct sk_buff *skb,
 	struct dpaa2_fd *fd;
 	u16 queue_mapping;
 	void *swa = NULL;
+	bool onestep;
 	u8 prio = 0;
 	u32 fd_len;
 
 	percpu_stats = this_cpu_ptr(priv->percpu_stats);
 	percpu_extras = this_cpu_ptr(priv->percpu_extras);
 	fd = (this_cpu_ptr(priv->fd))->array;
+	onestep = skb->cb[0] == TX_TSTAMP_ONESTEP_SYNC;
 
 	/* We'll be holding a back-reference to the skb until Tx Confirmation;
 	 * we don't want that overwritten by a concurrent Tx with a cloned skb.
@@ -1494,6 +1768,8 @@ static netdev_tx_t __dpaa2_eth_tx(struct sk_buff *skb,
 	if (unlikely(!skb)) {
 		/* skb_unshare() has already freed the skb */
 		percpu_stats->tx_dropped++;
+		if (onestep)
+			dpaa2_eth_onestep_done(priv);
 		return NETDEV_TX_OK;
 	}
 
@@ -1602,27 +1878,83 @@ static netdev_tx_t __dpaa2_eth_tx(struct sk_buff *skb,
 
 err_build_fd:
 	dev_kfree_skb(skb);
+	if (onestep)
+		dpaa2_eth_onestep_done(priv);
 
 	return NETDEV_TX_OK;
 }
 
+/* Returns true if the one-step Sync frame can be sent right away, with the
+ * configuration already programmed, or false if it was queued for the
+ * tx_onestep_tstamp work to reprogram it first. Frames queued before keep
+ * the frame from overtaking them.
+ */
+static bool dpaa2_eth_onestep_start(struct dpaa2_eth_priv *priv,
+				    struct sk_buff *skb, u16 offset, u8 udp)
+{
+	bool ready;
+
+	spin_lock_bh(&priv->onestep_lock);
+	ready = !priv->onestep_reconfig && skb_queue_empty(&priv->tx_skbs) &&
+		priv->ptp_correction_off == offset &&
+		priv->ptp_onestep_udp == udp;
+	if (ready)
+		atomic_inc(&priv->onestep_inflight);
+	else
+		__skb_queue_tail(&priv->tx_skbs, skb);
+	spin_unlock_bh(&priv->onestep_lock);
+
+	if (!ready)
+		queue_work(priv->dpaa2_ptp_wq, &priv->tx_onestep_tstamp);
+
+	return ready;
+}
+
 static void dpaa2_eth_tx_onestep_tstamp(struct work_struct *work)
 {
 	struct dpaa2_eth_priv *priv = container_of(work, struct dpaa2_eth_priv,
 						   tx_onestep_tstamp);
+	u8 msgtype, twostep, udp;
+	u16 offset1, offset2;
 	struct sk_buff *skb;
+	bool reconfig;
 
 	while (true) {
-		skb = skb_dequeue(&priv->tx_skbs);
-		if (!skb)
+		spin_lock_bh(&priv->onestep_lock);
+		skb = __skb_dequeue(&priv->tx_skbs);
+		if (!skb) {
+			spin_unlock_bh(&priv->onestep_lock);
 			return;
+		}
+
+		/* Already parsed successfully by dpaa2_eth_tx() */
+		dpaa2_eth_ptp_parse(skb, &msgtype, &twostep, &udp,
+				    &offset1, &offset2);
+		reconfig = priv->ptp_correction_off != offset1 ||
+			   priv->ptp_onestep_udp != udp;
+		priv->onestep_reconfig = reconfig;
+		if (!reconfig)
+			atomic_inc(&priv->onestep_inflight);
+		spin_unlock_bh(&priv->onestep_lock);
+
+		if (reconfig) {
+			/* No new frame is sent until the configuration is
+			 * changed, wait for the ones in flight to be
+			 * confirmed in dpaa2_eth_free_tx_fd(), or dropped.
+			 */
+			wait_event(priv->onestep_wq,
+				   !atomic_read(&priv->onestep_inflight));
+
+			priv->dpaa2_set_onestep_params_cb(priv, offset1, udp);
+
+			spin_lock_bh(&priv->onestep_lock);
+			priv->ptp_correction_off = offset1;
+			priv->ptp_onestep_udp = udp;
+			priv->onestep_reconfig = false;
+			atomic_inc(&priv->onestep_inflight);
+			spin_unlock_bh(&priv->onestep_lock);
+		}
 
-		/* Lock just before TX one-step timestamping packet,
-		 * and release the lock in dpaa2_eth_free_tx_fd when
-		 * confirm the packet has been sent on hardware, or
-		 * when clean up during transmit failure.
-		 */
-		mutex_lock(&priv->onestep_tstamp_lock);
 		__dpaa2_eth_tx(skb, priv->net_dev);
 	}
 }
@@ -1648,9 +1980,9 @@ static netdev_tx_t dpaa2_eth_tx(struct sk_buff *skb, struct net_device *net_dev)
 		if (!dpaa2_eth_ptp_parse(skb, &msgtype, &twostep, &udp,
 					 &offset1, &offset2))
 			if (msgtype == PTP_MSGTYPE_SYNC && twostep == 0) {
-				skb_queue_tail(&priv->tx_skbs, skb);
-				queue_work(priv->dpaa2_ptp_wq,
-					   &priv->tx_onestep_tstamp);
+				if (dpaa2_eth_onestep_start(priv, skb,
+							    offset1, udp))
+					return __dpaa2_eth_tx(skb, net_dev);
 				return NETDEV_TX_OK;
 			}
 		/* Use two-step timestamping if not one-step timestamping
@@ -1765,7 +2097,6 @@ static int dpaa2_eth_add_bufs(struct dpaa2_eth_priv *priv,
 			      struct dpaa2_eth_channel *ch)
 {
 	struct xdp_buff *xdp_buffs[DPAA2_ETH_BUFS_PER_CMD];
-	struct device *dev = priv->net_dev->dev.parent;
 	u64 buf_array[DPAA2_ETH_BUFS_PER_CMD];
 	struct dpaa2_eth_swa *swa;
 	struct page *page;
@@ -1780,17 +2111,14 @@ static int dpaa2_eth_add_bufs(struct dpaa2_eth_priv *priv,
 			/* Also allocate skb shared info and alignment padding.
 			 * There is one page for each Rx buffer. WRIOP sees
 			 * the entire page except for a tailroom reserved for
-			 * skb shared info
+			 * skb shared info. Pages come from the channel's
+			 * page_pool already mapped and synced for the device.
 			 */
-			page = dev_alloc_pages(0);
+			page = page_pool_dev_alloc_pages(ch->page_pool);
 			if (!page)
 				goto err_alloc;
 
-			addr = dma_map_page(dev, page, 0, priv->rx_buf_size,
-					    DMA_BIDIRECTIONAL);
-			if (unlikely(dma_mapping_error(dev, addr)))
-				goto err_map;
-
+			addr = page_pool_get_dma_addr(page);
 			buf_array[i] = addr;
 
 			/* tracing point */
@@ -1805,26 +2133,24 @@ static int dpaa2_eth_add_bufs(struct dpaa2_eth_priv *priv,
 		 * of DPAA2_ETH_BUFS_PER_CMD. Bail out if the UMEM cannot
 		 * provide enough buffers at the moment
 		 */
-		batch = xsk_buff_alloc_batch(ch->xsk_pool, xdp_buffs,
-					     DPAA2_ETH_BUFS_PER_CMD);
+		batch = xsk_buff_alloc_batch_dma(ch->xsk_pool, xdp_buffs,
+						 buf_array,
+						 DPAA2_ETH_BUFS_PER_CMD);
 		if (!batch)
 			goto err_alloc;
 
+		/* The UMEM is mapped as a whole when the pool is set up,
+		 * buf_array already holds the frame addresses
+		 */
 		for (i = 0; i < batch; i++) {
 			swa = (struct dpaa2_eth_swa *)(xdp_buffs[i]->data_hard_start +
 						       DPAA2_ETH_RX_HWA_SIZE);
 			swa->xsk.xdp_buff = xdp_buffs[i];
 
-			addr = xsk_buff_xdp_get_frame_dma(xdp_buffs[i]);
-			if (unlikely(dma_mapping_error(dev, addr)))
-				goto err_map;
-
-			buf_array[i] = addr;
-
 			trace_dpaa2_xsk_buf_seed(priv->net_dev,
 						 xdp_buffs[i]->data_hard_start,
 						 DPAA2_ETH_RX_BUF_RAW_SIZE,
-						 addr, priv->rx_buf_size,
+						 buf_array[i], priv->rx_buf_size,
 						 ch->bp->bpid);
 		}
 	}
@@ -1848,13 +2174,6 @@ static int dpaa2_eth_add_bufs(struct dpaa2_eth_priv *priv,
 
 	return i;
 
-err_map:
-	if (!ch->xsk_zc) {
-		__free_pages(page, 0);
-	} else {
-		for (; i < batch; i++)
-			xsk_buff_free(xdp_buffs[i]);
-	}
 err_alloc:
 	/* If we managed to allocate at least some buffers,
 	 * release them to hardware
@@ -2048,14 +2367,12 @@ static int dpaa2_eth_poll(struct napi_struct *napi, int budget)
 	INIT_LIST_HEAD(&rx_list);
 	ch->rx_list = &rx_list;
 
-	if (ch->xsk_zc) {
+	/* Send a batch of XSK frames first, then go on with the Tx
+	 * confirmations so that completed frames are returned to the
+	 * completion ring in the same NAPI cycle
+	 */
+	if (ch->xsk_zc)
 		work_done_zc = dpaa2_xsk_tx(priv, ch);
-		/* If we reached the XSK Tx per NAPI threshold, we're done */
-		if (work_done_zc) {
-			work_done = budget;
-			goto out;
-		}
-	}
 
 	do {
 		err = dpaa2_eth_pull_channel(ch);
@@ -2065,6 +2382,14 @@ static int dpaa2_eth_poll(struct napi_struct *napi, int budget)
 		/* Refill pool if appropriate */
 		dpaa2_eth_refill_pool(priv, ch);
 
+		/* Only let the next pull go out while we parse this store if
+		 * we're sure to come back for it within this NAPI cycle.
+		 */
+		dpaa2_io_store_set_pull_ahead(ch->store,
+			rx_cleaned + DPAA2_ETH_STORE_SIZE < budget &&
+			txconf_cleaned + DPAA2_ETH_STORE_SIZE <
+				DPAA2_ETH_TXCONF_PER_NAPI);
+
 		store_cleaned = dpaa2_eth_consume_frames(ch, &fq);
 		if (store_cleaned <= 0)
 			break;
@@ -2092,6 +2417,12 @@ static int dpaa2_eth_poll(struct napi_struct *napi, int budget)
 	if (ch->xdp.res & XDP_REDIRECT)
 		xdp_do_flush();
 
+	/* If we reached the XSK Tx per NAPI threshold, keep polling */
+	if (work_done_zc) {
+		work_done = budget;
+		goto out;
+	}
+
 	/* Update NET DIM with the values for this CDAN */
 	dpaa2_io_update_net_dim(ch->dpio, ch->stats.frames_per_cdan,
 				ch->stats.bytes_per_cdan);
@@ -2672,6 +3003,13 @@ static int dpaa2_eth_set_features(struct net_device *net_dev,
 			return err;
 	}
 
+	if (changed & NETIF_F_NTUPLE) {
+		enable = !!(features & NETIF_F_NTUPLE);
+		err = dpaa2_eth_arfs_enable(priv, enable);
+		if (err)
+			return err;
+	}
+
 	return 0;
 }
 
@@ -2732,16 +3070,24 @@ static int dpaa2_eth_ioctl(struct net_device *dev, struct ifreq *rq, int cmd)
 	return -EOPNOTSUPP;
 }
 
-static bool xdp_mtu_valid(struct dpaa2_eth_priv *priv, int mtu)
+static bool xdp_mtu_valid(struct dpaa2_eth_priv *priv, int mtu,
+			  struct bpf_prog *prog)
 {
 	int mfl, linear_mfl;
 
+	/* Programs able to handle multi-buffer frames can also be attached
+	 * when the MTU doesn't fit a single Rx buffer
+	 */
+	if (prog->aux->xdp_has_frags)
+		return true;
+
 	mfl = DPAA2_ETH_L2_MAX_FRM(mtu);
 	linear_mfl = priv->rx_buf_size - DPAA2_ETH_RX_HWA_SIZE -
 		     dpaa2_eth_rx_head_room(priv) - XDP_PACKET_HEADROOM;
 
 	if (mfl > linear_mfl) {
-		netdev_warn(priv->net_dev, "Maximum MTU for XDP is %d\n",
+		netdev_warn(priv->net_dev,
+			    "Maximum MTU for XDP without frags support is %d\n",
 			    linear_mfl - VLAN_ETH_HLEN);
 		return false;
 	}
@@ -2754,9 +3100,9 @@ static int dpaa2_eth_set_rx_mfl(struct dpaa2_eth_priv *priv, int mtu, bool has_x
 	int mfl, err;
 
 	/* We enforce a maximum Rx frame length based on MTU only if we have
-	 * an XDP program attached (in order to avoid Rx S/G frames).
-	 * Otherwise, we accept all incoming frames as long as they are not
-	 * larger than maximum size supported in hardware
+	 * an XDP program attached (in order to avoid Rx S/G frames the program
+	 * isn't able to handle). Otherwise, we accept all incoming frames as
+	 * long as they are not larger than maximum size supported in hardware
 	 */
 	if (has_xdp)
 		mfl = DPAA2_ETH_L2_MAX_FRM(mtu);
@@ -2780,7 +3126,7 @@ static int dpaa2_eth_change_mtu(struct net_device *dev, int new_mtu)
 	if (!priv->xdp_prog)
 		goto out;
 
-	if (!xdp_mtu_valid(priv, new_mtu))
+	if (!xdp_mtu_valid(priv, new_mtu, priv->xdp_prog))
 		return -EINVAL;
 
 	err = dpaa2_eth_set_rx_mfl(priv, new_mtu, true);
@@ -2826,7 +3172,7 @@ static int dpaa2_eth_setup_xdp(struct net_device *dev, struct bpf_prog *prog)
 	bool up, need_update;
 	int i, err;
 
-	if (prog && !xdp_mtu_valid(priv, dev->mtu))
+	if (prog && !xdp_mtu_valid(priv, dev->mtu, prog))
 		return -EINVAL;
 
 	if (prog)
@@ -2894,6 +3240,92 @@ static int dpaa2_eth_xdp(struct net_device *dev, struct netdev_bpf *xdp)
 	return 0;
 }
 
+/* Create a S/G frame descriptor based on a multi-buffer xdp_frame. The
+ * linear part and each of the frags get their own SG entry.
+ */
+static int dpaa2_eth_xdp_create_sg_fd(struct dpaa2_eth_priv *priv,
+				      struct xdp_frame *xdpf,
+				      struct dpaa2_fd *fd)
+{
+	struct skb_shared_info *sinfo = xdp_get_shared_info_from_frame(xdpf);
+	struct device *dev = priv->net_dev->dev.parent;
+	int nr_frags = sinfo->nr_frags;
+	struct dpaa2_sg_entry *sgt;
+	struct dpaa2_eth_swa *swa;
+	dma_addr_t addr, sgt_addr;
+	void *sgt_buf;
+	int sgt_buf_size;
+	int i, err;
+
+	if (unlikely(nr_frags + 1 > DPAA2_ETH_SG_ENTRIES_MAX))
+		return -EINVAL;
+
+	/* Prepare the HW SGT structure */
+	sgt_buf_size = priv->tx_data_offset +
+		       sizeof(struct dpaa2_sg_entry) * (nr_frags + 1);
+	sgt_buf = dpaa2_eth_sgt_get(priv);
+	if (unlikely(!sgt_buf))
+		return -ENOMEM;
+	sgt = (struct dpaa2_sg_entry *)(sgt_buf + priv->tx_data_offset);
+
+	addr = dma_map_single(dev, xdpf->data, xdpf->len, DMA_BIDIRECTIONAL);
+	if (unlikely(dma_mapping_error(dev, addr))) {
+		err = -ENOMEM;
+		goto data_map_failed;
+	}
+	dpaa2_sg_set_addr(&sgt[0], addr);
+	dpaa2_sg_set_len(&sgt[0], xdpf->len);
+
+	for (i = 0; i < nr_frags; i++) {
+		skb_frag_t *frag = &sinfo->frags[i];
+
+		addr = skb_frag_dma_map(dev, frag, 0, skb_frag_size(frag),
+					DMA_BIDIRECTIONAL);
+		if (unlikely(dma_mapping_error(dev, addr))) {
+			err = -ENOMEM;
+			goto frag_map_failed;
+		}
+		dpaa2_sg_set_addr(&sgt[i + 1], addr);
+		dpaa2_sg_set_len(&sgt[i + 1], skb_frag_size(frag));
+	}
+	dpaa2_sg_set_final(&sgt[nr_frags], true);
+
+	/* For S/G frames, dma_size is the size of the SGT buffer */
+	swa = (struct dpaa2_eth_swa *)sgt_buf;
+	swa->type = DPAA2_ETH_SWA_XDP;
+	swa->xdp.dma_size = sgt_buf_size;
+	swa->xdp.xdpf = xdpf;
+
+	/* Separately map the SGT buffer */
+	sgt_addr = dma_map_single(dev, sgt_buf, sgt_buf_size,
+				  DMA_BIDIRECTIONAL);
+	if (unlikely(dma_mapping_error(dev, sgt_addr))) {
+		err = -ENOMEM;
+		goto frag_map_failed;
+	}
+
+	memset(fd, 0, sizeof(struct dpaa2_fd));
+	dpaa2_fd_set_offset(fd, priv->tx_data_offset);
+	dpaa2_fd_set_format(fd, dpaa2_fd_sg);
+	dpaa2_fd_set_addr(fd, sgt_addr);
+	dpaa2_fd_set_len(fd, xdp_get_frame_len(xdpf));
+	dpaa2_fd_set_ctrl(fd, FD_CTRL_PTA);
+
+	return 0;
+
+frag_map_failed:
+	while (i--)
+		dma_unmap_page(dev, dpaa2_sg_get_addr(&sgt[i + 1]),
+			       dpaa2_sg_get_len(&sgt[i + 1]),
+			       DMA_BIDIRECTIONAL);
+	dma_unmap_single(dev, dpaa2_sg_get_addr(&sgt[0]), xdpf->len,
+			 DMA_BIDIRECTIONAL);
+data_map_failed:
+	dpaa2_eth_sgt_recycle(priv, sgt_buf);
+
+	return err;
+}
+
 static int dpaa2_eth_xdp_create_fd(struct net_device *net_dev,
 				   struct xdp_frame *xdpf,
 				   struct dpaa2_fd *fd)
@@ -2904,6 +3336,10 @@ static int dpaa2_eth_xdp_create_fd(struct net_device *net_dev,
 	void *buffer_start, *aligned_start;
 	dma_addr_t addr;
 
+	if (unlikely(xdp_frame_has_frags(xdpf)))
+		return dpaa2_eth_xdp_create_sg_fd(netdev_priv(net_dev), xdpf,
+						  fd);
+
 	/* We require a minimum headroom to be able to transmit the frame.
 	 * Otherwise return an error and let the original net_device handle it
 	 */
@@ -3096,6 +3532,160 @@ static int dpaa2_eth_setup_tbf(struct net_device *net_dev, struct tc_tbf_qopt_of
 	return 0;
 }
 
+static int dpaa2_eth_ets_hw_drops(struct dpaa2_eth_priv *priv, int num_bands,
+				  u64 *drops)
+{
+	union dpni_statistics dpni_stats;
+	int i, err;
+
+	*drops = 0;
+	for (i = 0; i < num_bands; i++) {
+		err = dpni_get_statistics(priv->mc_io, 0, priv->mc_token, 3,
+					  DPNI_BUILD_CH_TC(0, i), &dpni_stats);
+		if (err)
+			return err;
+		*drops += dpni_stats.page_3.egress_reject_frames;
+	}
+
+	return 0;
+}
+
+static int dpaa2_eth_ets_replace(struct net_device *net_dev,
+				 struct tc_ets_qopt_offload_replace_params *p)
+{
+	struct dpaa2_eth_priv *priv = netdev_priv(net_dev);
+	struct dpni_tx_priorities_cfg cfg = { 0 };
+	int i, num_queues, num_strict = 0;
+	u16 increment;
+	int err;
+
+	num_queues = dpaa2_eth_queue_count(priv);
+
+	if (p->bands > dpaa2_eth_tx_tc_count(priv) || p->bands > DPNI_MAX_TC) {
+		netdev_err(net_dev, "Max %d ETS bands supported\n",
+			   min_t(int, dpaa2_eth_tx_tc_count(priv), DPNI_MAX_TC));
+		return -EOPNOTSUPP;
+	}
+
+	for (i = 0; i < p->bands; i++)
+		if (!p->quanta[i])
+			num_strict++;
+
+	/* With more than 8 Tx TCs the MC firmware only lets us change the
+	 * weights of TCs 8-15, while TCs 0-7 stay in strict priority
+	 */
+	if (dpaa2_eth_tx_tc_count(priv) > DPNI_MAX_TC && num_strict != p->bands) {
+		netdev_err(net_dev, "Weighted ETS bands need at most %d Tx TCs\n",
+			   DPNI_MAX_TC);
+		return -EOPNOTSUPP;
+	}
+
+	/* Strict bands always come first in the ETS qdisc, and band 0 is
+	 * the highest priority one, same as Tx TC 0 in hardware. All
+	 * bandwidth sharing bands go into WBFS group A, right below the
+	 * strict priority TCs.
+	 */
+	increment = (DPAA2_CEETM_MAX_WEIGHT - DPAA2_CEETM_MIN_WEIGHT) / 100;
+	for (i = 0; i < p->bands; i++) {
+		if (i < num_strict)
+			continue;
+		cfg.tc_sched[i].mode = DPNI_TX_SCHED_WEIGHTED_A;
+		cfg.tc_sched[i].delta_bandwidth = DPAA2_CEETM_MIN_WEIGHT +
+			min_t(unsigned int, p->weights[i], 100) * increment;
+	}
+	cfg.prio_group_A = num_strict;
+	cfg.prio_group_B = num_strict;
+
+	err = dpni_set_tx_priorities(priv->mc_io, 0, priv->mc_token, &cfg);
+	if (err) {
+		netdev_err(net_dev, "dpni_set_tx_priorities() = %d\n", err);
+		return err;
+	}
+
+	/* Steer each skb priority to the Tx queues of its band. The Tx path
+	 * reverses the netdev TC index into a hardware priority level, so
+	 * band N is mapped onto netdev TC (bands - N - 1).
+	 */
+	netdev_set_num_tc(net_dev, p->bands);
+	netif_set_real_num_tx_queues(net_dev, p->bands * num_queues);
+
+	for (i = 0; i < p->bands; i++)
+		netdev_set_tc_queue(net_dev, p->bands - i - 1, num_queues,
+				    (p->bands - i - 1) * num_queues);
+
+	for (i = 0; i <= TC_PRIO_MAX; i++)
+		netdev_set_prio_tc_map(net_dev, i,
+				       p->bands - p->priomap[i] - 1);
+
+	update_xps(priv);
+
+	/* Only report drops which happen from now on */
+	if (dpaa2_eth_ets_hw_drops(priv, p->bands, &priv->ets_drops))
+		priv->ets_drops = 0;
+
+	return 0;
+}
+
+static int dpaa2_eth_ets_destroy(struct net_device *net_dev)
+{
+	struct dpaa2_eth_priv *priv = netdev_priv(net_dev);
+	struct dpni_tx_priorities_cfg cfg = { 0 };
+	int err;
+
+	netdev_reset_tc(net_dev);
+	netif_set_real_num_tx_queues(net_dev, dpaa2_eth_queue_count(priv));
+	update_xps(priv);
+
+	/* Back to all Tx TCs in strict priority */
+	err = dpni_set_tx_priorities(priv->mc_io, 0, priv->mc_token, &cfg);
+	if (err)
+		netdev_err(net_dev, "dpni_set_tx_priorities() = %d\n", err);
+
+	return err;
+}
+
+static int dpaa2_eth_ets_stats(struct net_device *net_dev,
+			       struct tc_qopt_offload_stats *stats)
+{
+	struct dpaa2_eth_priv *priv = netdev_priv(net_dev);
+	u64 drops;
+	int err;
+
+	/* Frames and bytes are already accounted for by the software qdisc,
+	 * on dequeue. Only the frames rejected by the hardware Tx queues
+	 * are invisible to it.
+	 */
+	err = dpaa2_eth_ets_hw_drops(priv, net_dev->num_tc, &drops);
+	if (err)
+		return err;
+
+	stats->qstats->drops += drops - priv->ets_drops;
+	priv->ets_drops = drops;
+
+	return 0;
+}
+
+static int dpaa2_eth_setup_ets(struct net_device *net_dev,
+			       struct tc_ets_qopt_offload *p)
+{
+	/* Only per port Tx scheduling */
+	if (p->parent != TC_H_ROOT)
+		return -EOPNOTSUPP;
+
+	switch (p->command) {
+	case TC_ETS_REPLACE:
+		return dpaa2_eth_ets_replace(net_dev, &p->replace_params);
+	case TC_ETS_DESTROY:
+		return dpaa2_eth_ets_destroy(net_dev);
+	case TC_ETS_STATS:
+		return dpaa2_eth_ets_stats(net_dev, &p->stats);
+	case TC_ETS_GRAFT:
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
 static int dpaa2_eth_setup_tc(struct net_device *net_dev,
 			      enum tc_setup_type type, void *type_data)
 {
@@ -3104,6 +3694,8 @@ static int dpaa2_eth_setup_tc(struct net_device *net_dev,
 		return dpaa2_eth_setup_mqprio(net_dev, type_data);
 	case TC_SETUP_QDISC_TBF:
 		return dpaa2_eth_setup_tbf(net_dev, type_data);
+	case TC_SETUP_QDISC_ETS:
+		return dpaa2_eth_setup_ets(net_dev, type_data);
 	case TC_SETUP_BLOCK:
 		return 0;
 	default:
@@ -3126,7 +3718,10 @@ static const struct net_device_ops dpaa2_eth_ops = {
 	.ndo_xsk_wakeup = dpaa2_xsk_wakeup,
 	.ndo_setup_tc = dpaa2_eth_setup_tc,
 	.ndo_vlan_rx_add_vid = dpaa2_eth_rx_add_vid,
-	.ndo_vlan_rx_kill_vid = dpaa2_eth_rx_kill_vid
+	.ndo_vlan_rx_kill_vid = dpaa2_eth_rx_kill_vid,
+#ifdef CONFIG_RFS_ACCEL
+	.ndo_rx_flow_steer = dpaa2_eth_rx_flow_steer,
+#endif
 };
 
 static void dpaa2_eth_cdan_cb(struct dpaa2_io_notification_ctx *ctx)
@@ -3240,6 +3835,9 @@ static struct dpaa2_eth_channel *dpaa2_eth_alloc_channel(struct dpaa2_eth_priv *
 static void dpaa2_eth_free_channel(struct dpaa2_eth_priv *priv,
 				   struct dpaa2_eth_channel *channel)
 {
+	if (xdp_rxq_info_is_reg(&channel->xdp_rxq))
+		xdp_rxq_info_unreg(&channel->xdp_rxq);
+	page_pool_destroy(channel->page_pool);
 	dpaa2_eth_free_dpcon(priv, channel->dpcon);
 	kfree(channel);
 }
@@ -3982,6 +4580,39 @@ static void dpaa2_eth_free_dpni(struct dpaa2_eth_priv *priv)
 	dpni_close(priv->mc_io, 0, priv->mc_token);
 }
 
+/* One page_pool per channel keeps the Rx pages DMA mapped across refills,
+ * and lets the stack hand pages back without going through the allocator.
+ */
+static int dpaa2_eth_create_page_pool(struct dpaa2_eth_priv *priv,
+				      struct dpaa2_eth_channel *ch)
+{
+	struct page_pool_params pp_params = {
+		.order = 0,
+		.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV,
+		.pool_size = DPAA2_ETH_NUM_BUFS,
+		.nid = NUMA_NO_NODE,
+		.dev = priv->net_dev->dev.parent,
+		.napi = &ch->napi,
+		.netdev = priv->net_dev,
+		.dma_dir = DMA_BIDIRECTIONAL,
+		.offset = 0,
+		.max_len = priv->rx_buf_size,
+	};
+	struct page_pool *pp;
+
+	if (ch->page_pool)
+		return 0;
+
+	pp = page_pool_create(&pp_params);
+	if (IS_ERR(pp)) {
+		dev_err(pp_params.dev, "page_pool_create() failed\n");
+		return PTR_ERR(pp);
+	}
+	ch->page_pool = pp;
+
+	return 0;
+}
+
 static int dpaa2_eth_setup_rx_flow(struct dpaa2_eth_priv *priv,
 				   struct dpaa2_eth_fq *fq)
 {
@@ -4017,6 +4648,10 @@ static int dpaa2_eth_setup_rx_flow(struct dpaa2_eth_priv *priv,
 	if (fq->tc > 0)
 		return 0;
 
+	err = dpaa2_eth_create_page_pool(priv, fq->channel);
+	if (err)
+		return err;
+
 	err = xdp_rxq_info_reg(&fq->channel->xdp_rxq, priv->net_dev,
 			       fq->flowid, 0);
 	if (err) {
@@ -4025,7 +4660,8 @@ static int dpaa2_eth_setup_rx_flow(struct dpaa2_eth_priv *priv,
 	}
 
 	err = xdp_rxq_info_reg_mem_model(&fq->channel->xdp_rxq,
-					 MEM_TYPE_PAGE_ORDER0, NULL);
+					 MEM_TYPE_PAGE_POOL,
+					 fq->channel->page_pool);
 	if (err) {
 		dev_err(dev, "xdp_rxq_info_reg_mem_model failed\n");
 		return err;
@@ -4543,9 +5179,9 @@ static int dpaa2_eth_alloc_rings(struct dpaa2_eth_priv *priv)
 
 	for (i = 0; i < priv->num_channels; i++) {
 		priv->channel[i]->store =
-			dpaa2_io_store_create(DPAA2_ETH_STORE_SIZE, dev);
+			dpaa2_io_store_create_double(DPAA2_ETH_STORE_SIZE, dev);
 		if (!priv->channel[i]->store) {
-			netdev_err(net_dev, "dpaa2_io_store_create() failed\n");
+			netdev_err(net_dev, "dpaa2_io_store_create_double() failed\n");
 			goto err_ring;
 		}
 	}
@@ -4698,12 +5334,14 @@ static int dpaa2_eth_netdev_init(struct net_device *net_dev)
 	net_dev->features = NETIF_F_RXCSUM |
 			    NETIF_F_IP_CSUM | NETIF_F_IPV6_CSUM |
 			    NETIF_F_SG | NETIF_F_HIGHDMA |
-			    NETIF_F_HW_TC | NETIF_F_TSO;
+			    NETIF_F_HW_TC | NETIF_F_TSO | NETIF_F_RXHASH;
 	net_dev->gso_max_segs = DPAA2_ETH_ENQUEUE_MAX_FDS;
 	net_dev->hw_features = net_dev->features;
 	net_dev->xdp_features = NETDEV_XDP_ACT_BASIC |
 				NETDEV_XDP_ACT_REDIRECT |
-				NETDEV_XDP_ACT_NDO_XMIT;
+				NETDEV_XDP_ACT_NDO_XMIT |
+				NETDEV_XDP_ACT_RX_SG |
+				NETDEV_XDP_ACT_NDO_XMIT_SG;
 	if (priv->dpni_attrs.wriop_version >= DPAA2_WRIOP_VERSION(3, 0, 0) &&
 	    priv->dpni_attrs.num_queues <= 8)
 		net_dev->xdp_features |= NETDEV_XDP_ACT_XSK_ZEROCOPY;
@@ -4962,7 +5600,9 @@ static int dpaa2_eth_probe(struct fsl_mc_device *dpni_dev)
 	}
 
 	INIT_WORK(&priv->tx_onestep_tstamp, dpaa2_eth_tx_onestep_tstamp);
-	mutex_init(&priv->onestep_tstamp_lock);
+	spin_lock_init(&priv->onestep_lock);
+	atomic_set(&priv->onestep_inflight, 0);
+	init_waitqueue_head(&priv->onestep_wq);
 	skb_queue_head_init(&priv->tx_skbs);
 
 	priv->rx_copybreak = DPAA2_ETH_DEFAULT_COPYBREAK;
@@ -5058,6 +5698,10 @@ static int dpaa2_eth_probe(struct fsl_mc_device *dpni_dev)
 	if (err)
 		goto err_netdev_init;
 
+	err = dpaa2_eth_arfs_init(priv);
+	if (err)
+		goto err_arfs_init;
+
 	/* Configure checksum offload based on current interface flags */
 	err = dpaa2_eth_set_rx_csum(priv, !!(net_dev->features & NETIF_F_RXCSUM));
 	if (err)
@@ -5142,6 +5786,8 @@ static int dpaa2_eth_probe(struct fsl_mc_device *dpni_dev)
 	dpaa2_eth_free_rings(priv);
 err_alloc_rings:
 err_csum:
+	dpaa2_eth_arfs_free(priv);
+err_arfs_init:
 err_netdev_init:
 	free_percpu(priv->fd);
 err_alloc_fds:
@@ -5187,6 +5833,7 @@ static void dpaa2_eth_remove(struct fsl_mc_device *ls_dev)
 
 	unregister_netdev(net_dev);
 
+	dpaa2_eth_arfs_free(priv);
 	dpaa2_eth_dl_port_del(priv);
 	dpaa2_eth_dl_traps_unregister(priv);
 	dpaa2_eth_dl_free(priv);
@@ -515,6 +515,7 @@ struct dpaa2_eth_channel {
 	int xsk_tx_pkts_sent;
 	struct xsk_buff_pool *xsk_pool;
 	struct dpaa2_eth_bp *bp;
+	struct page_pool *page_pool;
 };
 
 struct dpaa2_eth_dist_fields {
@@ -528,8 +529,50 @@ struct dpaa2_eth_dist_fields {
 struct dpaa2_eth_cls_rule {
 	struct ethtool_rx_flow_spec fs;
 	u8 in_use;
+	/* Rule installed by accelerated RFS rather than through ethtool */
+	u8 arfs;
 };
 
+#ifdef CONFIG_RFS_ACCEL
+/* Maximum number of flows steered through accelerated RFS at the same time;
+ * the size of the FS table may further limit it
+ */
+#define DPAA2_ETH_ARFS_MAX_RULES	512
+#define DPAA2_ETH_ARFS_EXPIRE_INTERVAL	HZ
+
+enum dpaa2_eth_arfs_state {
+	DPAA2_ETH_ARFS_FREE,
+	/* Needs to be (re)programmed in the FS table */
+	DPAA2_ETH_ARFS_PENDING,
+	DPAA2_ETH_ARFS_ACTIVE,
+};
+
+struct dpaa2_eth_arfs_rule {
+	/* Updated from ndo_rx_flow_steer(), under the aRFS lock */
+	enum dpaa2_eth_arfs_state state;
+	__be32 saddr;
+	__be32 daddr;
+	__be16 sport;
+	__be16 dport;
+	u8 ip_proto;
+	u16 rxq;
+	u32 flow_id;
+	/* Only accessed by the aRFS work, under rtnl: location in the FS
+	 * table of the programmed rule, or -1
+	 */
+	int location;
+};
+
+struct dpaa2_eth_arfs {
+	struct dpaa2_eth_arfs_rule *rules;
+	int num_rules;
+	bool enabled;
+	/* Serializes ndo_rx_flow_steer() against the aRFS work */
+	spinlock_t lock;
+	struct delayed_work work;
+};
+#endif
+
 #define DPAA2_ETH_SGT_CACHE_SIZE	256
 struct dpaa2_eth_sgt_cache {
 	void *buf[DPAA2_ETH_SGT_CACHE_SIZE];
@@ -554,8 +597,33 @@ struct dpaa2_eth_fds {
 	struct dpaa2_fd array[DPAA2_ETH_ENQUEUE_MAX_FDS];
 };
 
+/* Snapshot of all MACSec counters of the SecY, refreshed in one pass */
+struct dpaa2_eth_macsec_stats {
+	union macsec_global_stats global;
+	union macsec_secy_tx_sc_stats tx_sc;
+	union macsec_secy_tx_sa_stats tx_sa[MACSEC_NUM_AN];
+	union macsec_secy_rx_sc_stats rx_sc[2];
+	union macsec_secy_rx_sa_stats rx_sa[MACSEC_NUM_AN];
+	unsigned long stamp;
+	bool valid;
+};
+
 struct dpaa2_eth_macsec {
 	struct macsec_secy *secy;
+
+	/* SecY state as last written to the MC, used to skip commands
+	 * which would not change anything
+	 */
+	bool protect_frames;
+	bool replay_protect;
+	u32 replay_window;
+	int active_tx_an;
+	unsigned long tx_an_mask;
+	unsigned long rx_an_mask;
+	bool has_rx_sc;
+	u64 rx_sci;
+
+	struct dpaa2_eth_macsec_stats stats;
 };
 
 /* Driver private data */
@@ -579,7 +647,8 @@ struct dpaa2_eth_priv {
 	u16 dpni_ver_minor;
 	u16 tx_data_offset;
 	void __iomem *onestep_reg_base;
-	u8 ptp_correction_off;
+	u16 ptp_correction_off;
+	u8 ptp_onestep_udp;
 	void (*dpaa2_set_onestep_params_cb)(struct dpaa2_eth_priv *priv,
 					    u32 offset, u8 udp);
 	u16 rx_buf_size;
@@ -618,6 +687,9 @@ struct dpaa2_eth_priv {
 	struct dpaa2_eth_cls_rule *cls_rules;
 	u8 rx_cls_enabled;
 	u8 vlan_cls_enabled;
+#ifdef CONFIG_RFS_ACCEL
+	struct dpaa2_eth_arfs arfs;
+#endif
 	u8 pfc_enabled;
 #ifdef CONFIG_FSL_DPAA2_ETH_DCB
 	u8 dcbx_mode;
@@ -636,12 +708,18 @@ struct dpaa2_eth_priv {
 	struct sk_buff_head	tx_skbs;
 	/* The one-step timestamping configuration on hardware
 	 * registers could only be done when no one-step
-	 * timestamping frames are in flight. So we use a mutex
-	 * lock here to make sure the lock is released by last
-	 * one-step timestamping packet through TX confirmation
-	 * queue before transmit current packet.
+	 * timestamping frames are in flight. Frames which use the
+	 * configuration already programmed are sent right away and
+	 * counted in onestep_inflight until their TX confirmation.
+	 * A frame which needs it changed is queued on tx_skbs for
+	 * the tx_onestep_tstamp work, which waits on onestep_wq for
+	 * the count to drop to zero before reprogramming it. The
+	 * lock serializes the check against the reconfiguration.
 	 */
-	struct mutex		onestep_tstamp_lock;
+	spinlock_t		onestep_lock;
+	bool			onestep_reconfig;
+	atomic_t		onestep_inflight;
+	wait_queue_head_t	onestep_wq;
 	struct devlink *devlink;
 	struct dpaa2_eth_trap_data *trap_data;
 	struct devlink_port devlink_port;
@@ -650,6 +728,8 @@ struct dpaa2_eth_priv {
 
 	struct dpaa2_eth_fds __percpu *fd;
 	bool ceetm_en;
+	/* Tx TC rejects already reported to the ETS qdisc */
+	u64 ets_drops;
 
 	struct dpaa2_eth_macsec sec;
 	u8 secy_id;
@@ -830,6 +910,8 @@ static inline int dpaa2_eth_ch_count(struct dpaa2_eth_priv *priv)
 
 int dpaa2_eth_set_hash(struct net_device *net_dev, u64 flags);
 int dpaa2_eth_set_cls(struct net_device *net_dev, u64 key);
+int dpaa2_eth_do_cls_rule(struct net_device *net_dev,
+			  struct ethtool_rx_flow_spec *fs, bool add);
 int dpaa2_eth_cls_key_size(u64 key);
 int dpaa2_eth_cls_fld_off(int prot, int field);
 void dpaa2_eth_cls_trim_rule(void *key_mem, u64 fields);
@@ -906,4 +988,30 @@ void dpaa2_eth_sgt_recycle(struct dpaa2_eth_priv *priv, void *sgt_buf);
 int dpaa2_eth_macsec_init(struct dpaa2_eth_priv *priv);
 void dpaa2_eth_macsec_deinit(struct dpaa2_eth_priv *priv);
 
+#ifdef CONFIG_RFS_ACCEL
+int dpaa2_eth_arfs_init(struct dpaa2_eth_priv *priv);
+void dpaa2_eth_arfs_free(struct dpaa2_eth_priv *priv);
+int dpaa2_eth_arfs_enable(struct dpaa2_eth_priv *priv, bool enable);
+void dpaa2_eth_arfs_evict(struct dpaa2_eth_priv *priv, int location);
+int dpaa2_eth_rx_flow_steer(struct net_device *net_dev,
+			    const struct sk_buff *skb,
+			    u16 rxq_index, u32 flow_id);
+#else
+static inline int dpaa2_eth_arfs_init(struct dpaa2_eth_priv *priv)
+{
+	return 0;
+}
+
+static inline void dpaa2_eth_arfs_free(struct dpaa2_eth_priv *priv) {}
+
+static inline int dpaa2_eth_arfs_enable(struct dpaa2_eth_priv *priv,
+					bool enable)
+{
+	return 0;
+}
+
+static inline void dpaa2_eth_arfs_evict(struct dpaa2_eth_priv *priv,
+					int location) {}
+#endif /* CONFIG_RFS_ACCEL */
+
 #endif	/* __DPAA2_H */
@@ -569,9 +569,8 @@ static int dpaa2_eth_prep_cls_rule(struct ethtool_rx_flow_spec *fs, void *key,
 	return 0;
 }
 
-static int dpaa2_eth_do_cls_rule(struct net_device *net_dev,
-				 struct ethtool_rx_flow_spec *fs,
-				 bool add)
+int dpaa2_eth_do_cls_rule(struct net_device *net_dev,
+			  struct ethtool_rx_flow_spec *fs, bool add)
 {
 	struct dpaa2_eth_priv *priv = netdev_priv(net_dev);
 	struct device *dev = net_dev->dev.parent;
@@ -667,7 +666,7 @@ static int dpaa2_eth_num_cls_rules(struct dpaa2_eth_priv *priv)
 	int i, rules = 0;
 
 	for (i = 0; i < dpaa2_eth_fs_count(priv); i++)
-		if (priv->cls_rules[i].in_use)
+		if (priv->cls_rules[i].in_use && !priv->cls_rules[i].arfs)
 			rules++;
 
 	return rules;
@@ -695,7 +694,12 @@ static int dpaa2_eth_update_cls_rule(struct net_device *net_dev,
 		if (err)
 			return err;
 
+		/* User rules take precedence over accelerated RFS ones */
+		if (rule->arfs)
+			dpaa2_eth_arfs_evict(priv, location);
+
 		rule->in_use = 0;
+		rule->arfs = 0;
 
 		if (!dpaa2_eth_fs_mask_enabled(priv) &&
 		    !dpaa2_eth_num_cls_rules(priv))
@@ -744,13 +748,15 @@ static int dpaa2_eth_get_rxnfc(struct net_device *net_dev,
 			return -EINVAL;
 		rxnfc->fs.location = array_index_nospec(rxnfc->fs.location,
 							max_rules);
-		if (!priv->cls_rules[rxnfc->fs.location].in_use)
+		if (!priv->cls_rules[rxnfc->fs.location].in_use ||
+		    priv->cls_rules[rxnfc->fs.location].arfs)
 			return -EINVAL;
 		rxnfc->fs = priv->cls_rules[rxnfc->fs.location].fs;
 		break;
 	case ETHTOOL_GRXCLSRLALL:
 		for (i = 0; i < max_rules; i++) {
-			if (!priv->cls_rules[i].in_use)
+			if (!priv->cls_rules[i].in_use ||
+			    priv->cls_rules[i].arfs)
 				continue;
 			if (j == rxnfc->rule_cnt)
 				return -EMSGSIZE;
@@ -221,22 +221,6 @@ dpaa2_switch_acl_entry_add_to_list(struct dpaa2_switch_filter_block *block,
 	return index;
 }
 
-static struct dpaa2_switch_acl_entry*
-dpaa2_switch_acl_entry_get_by_index(struct dpaa2_switch_filter_block *block,
-				    int index)
-{
-	struct dpaa2_switch_acl_entry *tmp;
-	int i = 0;
-
-	list_for_each_entry(tmp, &block->acl_entries, list) {
-		if (i == index)
-			return tmp;
-		++i;
-	}
-
-	return NULL;
-}
-
 static int
 dpaa2_switch_acl_entry_set_precedence(struct dpaa2_switch_filter_block *block,
 				      struct dpaa2_switch_acl_entry *entry,
@@ -252,36 +236,94 @@ dpaa2_switch_acl_entry_set_precedence(struct dpaa2_switch_filter_block *block,
 	return dpaa2_switch_acl_entry_add(block, entry);
 }
 
+/* Pick a precedence for the entry found at @index in the sorted @entries
+ * array. The precedences of the entries must keep their order, but don't
+ * need to be contiguous: use a free level between the neighbours if there is
+ * one, otherwise make room by moving the entries between the new one and the
+ * closest free level, choosing the side which needs the fewest moves.
+ * Precedence 0 is used by the default trap entry.
+ */
+static int
+dpaa2_switch_acl_tbl_make_room(struct dpaa2_switch_filter_block *block,
+			       struct dpaa2_switch_acl_entry **entries,
+			       int num, int index)
+{
+	int lo, hi, left, right, prev, next, i, err;
+
+	lo = index ? entries[index - 1]->cfg.precedence : 0;
+	hi = index < num - 1 ? entries[index + 1]->cfg.precedence :
+			       DPAA2_ETHSW_PORT_MAX_ACL_ENTRIES;
+	if (hi - lo > 1)
+		return lo + (hi - lo) / 2;
+
+	/* Closest entry on each side with a free level next to it */
+	for (left = index - 1; left >= 0; left--) {
+		prev = left ? entries[left - 1]->cfg.precedence : 0;
+		if (entries[left]->cfg.precedence - prev > 1)
+			break;
+	}
+	for (right = index + 1; right < num; right++) {
+		next = right < num - 1 ? entries[right + 1]->cfg.precedence :
+					 DPAA2_ETHSW_PORT_MAX_ACL_ENTRIES;
+		if (next - entries[right]->cfg.precedence > 1)
+			break;
+	}
+
+	if (left >= 0 && (right == num || index - left <= right - index)) {
+		for (i = left; i < index; i++) {
+			err = dpaa2_switch_acl_entry_set_precedence(block,
+					entries[i], entries[i]->cfg.precedence - 1);
+			if (err)
+				return err;
+		}
+		return entries[index - 1]->cfg.precedence + 1;
+	}
+
+	if (right == num)
+		return -ENOSPC;
+
+	for (i = right; i > index; i--) {
+		err = dpaa2_switch_acl_entry_set_precedence(block,
+				entries[i], entries[i]->cfg.precedence + 1);
+		if (err)
+			return err;
+	}
+	return entries[index + 1]->cfg.precedence - 1;
+}
+
 static int
 dpaa2_switch_acl_tbl_add_entry(struct dpaa2_switch_filter_block *block,
 			       struct dpaa2_switch_acl_entry *entry)
 {
+	struct dpaa2_switch_acl_entry *entries[DPAA2_ETHSW_PORT_MAX_ACL_ENTRIES];
 	struct dpaa2_switch_acl_entry *tmp;
-	int index, i, precedence, err;
+	int index, num = 0, precedence, err;
 
 	/* Add the new ACL entry to the linked list and get its index */
 	index = dpaa2_switch_acl_entry_add_to_list(block, entry);
 
-	/* Move up in priority the ACL entries to make space
-	 * for the new filter.
-	 */
-	precedence = DPAA2_ETHSW_PORT_MAX_ACL_ENTRIES - block->num_acl_rules - 1;
-	for (i = 0; i < index; i++) {
-		tmp = dpaa2_switch_acl_entry_get_by_index(block, i);
-
-		err = dpaa2_switch_acl_entry_set_precedence(block, tmp,
-							    precedence);
-		if (err)
-			return err;
+	list_for_each_entry(tmp, &block->acl_entries, list)
+		entries[num++] = tmp;
 
-		precedence++;
+	precedence = dpaa2_switch_acl_tbl_make_room(block, entries, num,
+						    index);
+	if (precedence < 0) {
+		err = precedence;
+		goto err_list_del;
 	}
 
 	/* Add the new entry to hardware */
 	entry->cfg.precedence = precedence;
 	err = dpaa2_switch_acl_entry_add(block, entry);
+	if (err)
+		goto err_list_del;
+
 	block->num_acl_rules++;
 
+	return 0;
+
+err_list_del:
+	list_del(&entry->list);
 	return err;
 }
 
@@ -298,21 +340,6 @@ dpaa2_switch_acl_tbl_find_entry_by_cookie(struct dpaa2_switch_filter_block *bloc
 	return NULL;
 }
 
-static int
-dpaa2_switch_acl_entry_get_index(struct dpaa2_switch_filter_block *block,
-				 struct dpaa2_switch_acl_entry *entry)
-{
-	struct dpaa2_switch_acl_entry *tmp, *n;
-	int index = 0;
-
-	list_for_each_entry_safe(tmp, n, &block->acl_entries, list) {
-		if (tmp->cookie == entry->cookie)
-			return index;
-		index++;
-	}
-	return -ENOENT;
-}
-
 static struct dpaa2_switch_mirror_entry *
 dpaa2_switch_mirror_find_entry_by_cookie(struct dpaa2_switch_filter_block *block,
 					 unsigned long cookie)
@@ -330,12 +357,11 @@ static int
 dpaa2_switch_acl_tbl_remove_entry(struct dpaa2_switch_filter_block *block,
 				  struct dpaa2_switch_acl_entry *entry)
 {
-	struct dpaa2_switch_acl_entry *tmp;
-	int index, i, precedence, err;
-
-	index = dpaa2_switch_acl_entry_get_index(block, entry);
+	int err;
 
-	/* Remove from hardware the ACL entry */
+	/* Remove from hardware the ACL entry. The precedence levels don't
+	 * need to be contiguous, so there is no need to move the others.
+	 */
 	err = dpaa2_switch_acl_entry_remove(block, entry);
 	if (err)
 		return err;
@@ -345,18 +371,6 @@ dpaa2_switch_acl_tbl_remove_entry(struct dpaa2_switch_filter_block *block,
 	/* Remove it from the list also */
 	list_del(&entry->list);
 
-	/* Move down in priority the entries over the deleted one */
-	precedence = entry->cfg.precedence;
-	for (i = index - 1; i >= 0; i--) {
-		tmp = dpaa2_switch_acl_entry_get_by_index(block, i);
-		err = dpaa2_switch_acl_entry_set_precedence(block, tmp,
-							    precedence);
-		if (err)
-			return err;
-
-		precedence--;
-	}
-
 	kfree(entry);
 
 	return 0;
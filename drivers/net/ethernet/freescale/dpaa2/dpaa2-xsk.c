@@ -188,8 +188,9 @@ static int dpaa2_xsk_disable_pool(struct net_device *dev, u16 qid)
 		dev_close(dev);
 
 	xsk_pool_dma_unmap(pool, 0);
+	xdp_rxq_info_unreg_mem_model(&ch->xdp_rxq);
 	err = xdp_rxq_info_reg_mem_model(&ch->xdp_rxq,
-					 MEM_TYPE_PAGE_ORDER0, NULL);
+					 MEM_TYPE_PAGE_POOL, ch->page_pool);
 	if (err)
 		netdev_err(dev, "xsk_rxq_info_reg_mem_model() failed (err = %d)\n",
 			   err);
@@ -249,6 +250,7 @@ static int dpaa2_xsk_enable_pool(struct net_device *dev,
 	}
 
 	ch = priv->channel[qid];
+	xdp_rxq_info_unreg_mem_model(&ch->xdp_rxq);
 	err = xdp_rxq_info_reg_mem_model(&ch->xdp_rxq, MEM_TYPE_XSK_BUFF_POOL, NULL);
 	if (err) {
 		netdev_err(dev, "xdp_rxq_info_reg_mem_model() failed (err = %d)\n", err);
@@ -287,8 +289,10 @@ static int dpaa2_xsk_enable_pool(struct net_device *dev,
 	if (err2)
 		netdev_err(dev, "dpaa2_xsk_disable_pool() failed %d\n", err2);
 err_bp_alloc:
+	xdp_rxq_info_unreg_mem_model(&priv->channel[qid]->xdp_rxq);
 	err2 = xdp_rxq_info_reg_mem_model(&priv->channel[qid]->xdp_rxq,
-					  MEM_TYPE_PAGE_ORDER0, NULL);
+					  MEM_TYPE_PAGE_POOL,
+					  priv->channel[qid]->page_pool);
 	if (err2)
 		netdev_err(dev, "xsk_rxq_info_reg_mem_model() failed with %d)\n", err2);
 err_mem_model:
@@ -408,8 +412,14 @@ bool dpaa2_xsk_tx(struct dpaa2_eth_priv *priv,
 	fq = &priv->fq[ch->nctx.desired_cpu];
 
 	batch = xsk_tx_peek_release_desc_batch(ch->xsk_pool, budget);
-	if (!batch)
+	if (!batch) {
+		/* The Tx ring is empty, userspace needs to kick us once it
+		 * has more frames to send
+		 */
+		if (xsk_uses_need_wakeup(ch->xsk_pool))
+			xsk_set_tx_need_wakeup(ch->xsk_pool);
 		return false;
+	}
 
 	/* Create a FD for each XSK frame to be sent */
 	for (i = 0; i < batch; i++) {
@@ -450,5 +460,15 @@ bool dpaa2_xsk_tx(struct dpaa2_eth_priv *priv,
 
 	xsk_tx_release(ch->xsk_pool);
 
+	/* As long as we fill up the whole budget NAPI keeps polling, so
+	 * there is no need for userspace to issue a wakeup syscall
+	 */
+	if (xsk_uses_need_wakeup(ch->xsk_pool)) {
+		if (total_enqueued == budget)
+			xsk_clear_tx_need_wakeup(ch->xsk_pool);
+		else
+			xsk_set_tx_need_wakeup(ch->xsk_pool);
+	}
+
 	return total_enqueued == budget;
 }
@@ -155,7 +155,7 @@ static int fs_enet_napi(struct napi_struct *napi, int budget)
 
 		/* Free the sk buffer associated with this last transmit. */
 		if (skb) {
-			dev_kfree_skb(skb);
+			napi_consume_skb(skb, budget);
 			fep->tx_skbuff[dirtyidx] = NULL;
 		}
 
@@ -455,6 +455,7 @@ fs_enet_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	int curidx, nr_frags, len;
 	cbd_t __iomem *bdp;
 	skb_frag_t *frag;
+	bool kick;
 	u16 sc;
 #ifdef CONFIG_FS_ENET_MPC5121_FEC
 	int i, is_aligned = 1;
@@ -492,6 +493,8 @@ fs_enet_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	nr_frags = skb_shinfo(skb)->nr_frags;
 	if (fep->tx_free <= nr_frags || (CBDR_SC(bdp) & BD_ENET_TX_READY)) {
 		netif_stop_queue(dev);
+		/* flush what an earlier xmit_more left behind */
+		(*fep->ops->tx_kickstart)(dev);
 		spin_unlock(&fep->tx_lock);
 
 		/* Ooops.  All transmit buffers are full.  Bail out.
@@ -543,9 +546,17 @@ fs_enet_start_xmit(struct sk_buff *skb, struct net_device *dev)
 		nr_frags--;
 	}
 
+	/* Within a burst of frames, only the last one kicks the controller
+	 * and raises the TX interrupt, which reclaims all frames before it.
+	 * A frame which fills the ring always does, so that the queue gets
+	 * woken up again.
+	 */
+	kick = !netdev_xmit_more() || fep->tx_free < MAX_SKB_FRAGS;
+
 	/* Trigger transmission start */
-	sc = BD_ENET_TX_READY | BD_ENET_TX_INTR |
-	     BD_ENET_TX_LAST | BD_ENET_TX_TC;
+	sc = BD_ENET_TX_READY | BD_ENET_TX_LAST | BD_ENET_TX_TC;
+	if (kick)
+		sc |= BD_ENET_TX_INTR;
 
 	/* note that while FEC does not have this bit
 	 * it marks it as available for software use
@@ -554,7 +565,7 @@ fs_enet_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	if (skb->len <= 60)
 		sc |= BD_ENET_TX_PAD;
 
-	CBDC_SC(bdp, BD_ENET_TX_STATS);
+	CBDC_SC(bdp, BD_ENET_TX_STATS | BD_ENET_TX_INTR);
 	CBDS_SC(bdp, sc);
 
 	/* Save skb pointer. */
@@ -573,7 +584,8 @@ fs_enet_start_xmit(struct sk_buff *skb, struct net_device *dev)
 
 	skb_tx_timestamp(skb);
 
-	(*fep->ops->tx_kickstart)(dev);
+	if (kick)
+		(*fep->ops->tx_kickstart)(dev);
 
 	spin_unlock(&fep->tx_lock);
 
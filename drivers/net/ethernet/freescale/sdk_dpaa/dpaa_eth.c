@@ -59,6 +59,7 @@
 #include <linux/percpu.h>
 #include <linux/dma-mapping.h>
 #include <linux/fsl_bman.h>
+#include <linux/bpf.h>
 #ifdef CONFIG_SOC_BUS
 #include <linux/sys_soc.h>      /* soc_device_match */
 #endif
@@ -288,7 +289,7 @@ static void _dpa_rx_error(struct net_device *net_dev,
 	if (fd->status & FM_FD_STAT_L4CV)
 		dpa_csum_validation(priv, percpu_priv, fd);
 
-	dpa_fd_release(net_dev, fd);
+	dpa_rx_fd_release(net_dev, fd);
 }
 
 static void _dpa_tx_error(struct net_device		*net_dev,
@@ -384,6 +385,11 @@ int dpaa_eth_poll(struct napi_struct *napi, int budget)
 
 	int cleaned = qman_p_poll_dqrr(np->p, budget);
 
+	/* The portal is shared by all interfaces, so the frames redirected
+	 * during this cycle may belong to any of them.
+	 */
+	xdp_do_flush();
+
 	if (cleaned < budget) {
 		int tmp;
 		napi_complete(napi);
@@ -496,8 +502,8 @@ priv_rx_default_dqrr(struct qman_portal		*portal,
 		 */
 		dpa_fd_release(net_dev, &dq->fd);
 	else
-		_dpa_rx(net_dev, portal, priv, percpu_priv, &dq->fd, fq->fqid,
-			count_ptr);
+		_dpa_rx(net_dev, portal, priv, percpu_priv, &dq->fd,
+			(struct dpa_fq *)fq, count_ptr);
 
 	return qman_cb_dqrr_consume;
 }
@@ -673,6 +679,64 @@ static void dpaa_eth_poll_controller(struct net_device *net_dev)
 }
 #endif
 
+static bool dpa_xdp_mtu_valid(struct dpa_priv_s *priv, int mtu)
+{
+	int max_contig_data = priv->dpa_bp->size - priv->rx_headroom;
+
+	/* XDP only runs on contiguous frames, so the whole frame must fit
+	 * in a single buffer.
+	 */
+	if (mtu + VLAN_ETH_HLEN + ETH_FCS_LEN > max_contig_data) {
+		netdev_warn(priv->net_dev, "The maximum MTU for XDP is %d\n",
+			    max_contig_data - VLAN_ETH_HLEN - ETH_FCS_LEN);
+		return false;
+	}
+
+	return true;
+}
+
+static int dpa_change_mtu(struct net_device *net_dev, int new_mtu)
+{
+	struct dpa_priv_s *priv = netdev_priv(net_dev);
+
+	if (priv->xdp_prog && !dpa_xdp_mtu_valid(priv, new_mtu))
+		return -EINVAL;
+
+	WRITE_ONCE(net_dev->mtu, new_mtu);
+
+	return 0;
+}
+
+static int dpa_setup_xdp(struct net_device *net_dev, struct netdev_bpf *bpf)
+{
+	struct dpa_priv_s *priv = netdev_priv(net_dev);
+	struct bpf_prog *old_prog;
+
+	if (bpf->prog && !dpa_xdp_mtu_valid(priv, net_dev->mtu)) {
+		NL_SET_ERR_MSG_MOD(bpf->extack, "MTU too large for XDP");
+		return -EINVAL;
+	}
+
+	/* The Rx buffers are laid out the same with or without XDP, so the
+	 * program can be swapped without stopping the interface.
+	 */
+	old_prog = xchg(&priv->xdp_prog, bpf->prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	return 0;
+}
+
+static int dpa_xdp(struct net_device *net_dev, struct netdev_bpf *xdp)
+{
+	switch (xdp->command) {
+	case XDP_SETUP_PROG:
+		return dpa_setup_xdp(net_dev, xdp);
+	default:
+		return -EINVAL;
+	}
+}
+
 static const struct net_device_ops dpa_private_ops = {
 	.ndo_open = dpa_eth_priv_start,
 	.ndo_start_xmit = dpa_tx,
@@ -691,6 +755,9 @@ static const struct net_device_ops dpa_private_ops = {
 	.ndo_poll_controller = dpaa_eth_poll_controller,
 #endif
 	.ndo_set_features = dpa_set_features,
+	.ndo_change_mtu = dpa_change_mtu,
+	.ndo_bpf = dpa_xdp,
+	.ndo_xdp_xmit = dpa_xdp_xmit,
 };
 
 static int dpa_private_napi_add(struct net_device *net_dev)
@@ -738,9 +805,40 @@ void dpa_private_napi_del(struct net_device *net_dev)
 }
 EXPORT_SYMBOL(dpa_private_napi_del);
 
+static int dpa_private_xdp_rxq_init(struct dpa_priv_s *priv)
+{
+	struct net_device *net_dev = priv->net_dev;
+	struct dpa_fq *dpa_fq;
+	u32 queue_index = 0;
+	int err;
+
+	list_for_each_entry(dpa_fq, &priv->dpa_fq_list, list) {
+		if (dpa_fq->fq_type != FQ_TYPE_RX_DEFAULT &&
+		    dpa_fq->fq_type != FQ_TYPE_RX_PCD &&
+		    dpa_fq->fq_type != FQ_TYPE_RX_PCD_HI_PRIO)
+			continue;
+
+		/* NAPI instances are per portal, not per FQ */
+		err = xdp_rxq_info_reg(&dpa_fq->xdp_rxq, net_dev,
+				       queue_index++, 0);
+		if (err)
+			return err;
+
+		/* Rx buffers are page fragments */
+		err = xdp_rxq_info_reg_mem_model(&dpa_fq->xdp_rxq,
+						 MEM_TYPE_PAGE_SHARED, NULL);
+		if (err) {
+			xdp_rxq_info_unreg(&dpa_fq->xdp_rxq);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
 static int dpa_private_netdev_init(struct net_device *net_dev)
 {
-	int i;
+	int i, err;
 	struct dpa_priv_s *priv = netdev_priv(net_dev);
 	struct dpa_percpu_priv_s *percpu_priv;
 	const uint8_t *mac_addr;
@@ -778,6 +876,15 @@ static int dpa_private_netdev_init(struct net_device *net_dev)
 	/* Advertise GRO support */
 	net_dev->features |= NETIF_F_GRO;
 
+	err = dpa_private_xdp_rxq_init(priv);
+	if (err) {
+		dev_err(net_dev->dev.parent, "xdp_rxq_info_reg() = %d\n", err);
+		return err;
+	}
+
+	net_dev->xdp_features = NETDEV_XDP_ACT_BASIC | NETDEV_XDP_ACT_REDIRECT |
+				NETDEV_XDP_ACT_NDO_XMIT;
+
 	return dpa_netdev_init(net_dev, mac_addr, tx_timeout);
 }
 
@@ -796,6 +903,12 @@ dpa_priv_bp_probe(struct device *dev)
 
 	dpa_bp->free_buf_cb = _dpa_bp_free_pf;
 
+	dpa_bp->cache = devm_alloc_percpu(dev, *dpa_bp->cache);
+	if (unlikely(!dpa_bp->cache)) {
+		dev_err(dev, "devm_alloc_percpu() failed\n");
+		return ERR_PTR(-ENOMEM);
+	}
+
 	return dpa_bp;
 }
 
@@ -35,6 +35,7 @@
 
 #include <linux/netdevice.h>
 #include <linux/fsl_qman.h>	/* struct qman_fq */
+#include <net/xdp.h>
 
 #include "fm_ext.h"
 #include "dpaa_eth_trace.h"
@@ -218,6 +219,19 @@ static inline void DPA_BUG_ON(bool cond)
 	skb = *(skbh + (off)); \
 }
 
+/* XDP frames sent through .ndo_xdp_xmit are Tx-confirmed just like the
+ * non-recyclable skbs, except that the skb back-pointer at the start of the
+ * buffer is NULL and followed by a back-pointer to the xdp_frame.
+ */
+#define DPA_WRITE_XDPF_PTR(xdpf, skbh, addr) \
+{ \
+	skbh = (struct sk_buff **)addr; \
+	*skbh = NULL; \
+	*(struct xdp_frame **)(skbh + 1) = xdpf; \
+}
+#define DPA_READ_XDPF_PTR(xdpf, skbh) \
+	(xdpf = *(struct xdp_frame **)((skbh) + 1))
+
 #ifdef CONFIG_PM
 /* Magic Packet wakeup */
 #define DPAA_WOL_MAGIC		0x00000001
@@ -252,6 +266,7 @@ struct dpa_fq {
 	uint16_t channel;
 	uint8_t wq;
 	enum dpa_fq_type fq_type;
+	struct xdp_rxq_info xdp_rxq;
 };
 
 struct dpa_fq_cbs_t {
@@ -267,6 +282,17 @@ struct fqid_cell {
 	uint32_t count;
 };
 
+/* Per-CPU stash of DMA-mapped buffers given back to the pool from the Rx
+ * path. They are released to BMan in bursts of DPA_BP_CACHE_SIZE rather than
+ * one portal command per buffer.
+ */
+#define DPA_BP_CACHE_SIZE	8
+
+struct dpa_bp_cache {
+	struct bm_buffer	bmb[DPA_BP_CACHE_SIZE];
+	int			count;
+};
+
 struct dpa_bp {
 	struct bman_pool		*pool;
 	uint8_t				bpid;
@@ -298,6 +324,8 @@ struct dpa_bp {
 	 * for freeing of individual buffers taken from the pool
 	 */
 	void (*free_buf_cb)(void *addr);
+	/* only allocated for the private port pools */
+	struct dpa_bp_cache __percpu	*cache;
 };
 
 struct dpa_rx_errors {
@@ -335,6 +363,10 @@ struct dpa_percpu_priv_s {
 	u64 tx_frag_skbuffs;
 	/* number of S/G frames received */
 	u64 rx_sg;
+	/* XDP verdicts other than XDP_PASS */
+	u64 xdp_drop;
+	u64 xdp_tx;
+	u64 xdp_redirect;
 
 	struct rtnl_link_stats64 stats;
 	struct dpa_rx_errors rx_errors;
@@ -415,6 +447,7 @@ struct dpa_priv_s {
 #ifdef CONFIG_FSL_DPAA_CEETM
 	bool ceetm_en; /* CEETM QoS enabled */
 #endif
+	struct bpf_prog *xdp_prog;
 };
 
 struct fm_port_fqs {
@@ -435,9 +468,11 @@ void __hot _dpa_rx(struct net_device *net_dev,
 		const struct dpa_priv_s *priv,
 		struct dpa_percpu_priv_s *percpu_priv,
 		const struct qm_fd *fd,
-		u32 fqid,
+		struct dpa_fq *dpa_fq,
 		int *count_ptr);
 int __hot dpa_tx(struct sk_buff *skb, struct net_device *net_dev);
+int dpa_xdp_xmit(struct net_device *net_dev, int n, struct xdp_frame **frames,
+		 u32 flags);
 int __hot dpa_tx_extended(struct sk_buff *skb, struct net_device *net_dev,
 		struct qman_fq *egress_fq, struct qman_fq *conf_fq);
 struct sk_buff *_dpa_cleanup_tx_fd(const struct dpa_priv_s *priv,
@@ -733,6 +733,16 @@ _dpa_bp_free(struct dpa_bp *dpa_bp)
 	if (!atomic_dec_and_test(&bp->refs))
 		return;
 
+	if (bp->cache) {
+		int cpu;
+
+		/* The interfaces using this pool are down, no one else is
+		 * touching the caches of other CPUs at this point
+		 */
+		for_each_possible_cpu(cpu)
+			dpa_bp_cache_flush(bp, per_cpu_ptr(bp->cache, cpu));
+	}
+
 	if (bp->free_buf_cb)
 		dpa_bp_drain(bp);
 
@@ -1346,6 +1356,9 @@ _dpa_fq_free(struct device *dev, struct qman_fq *fq)
 		}
 	}
 
+	if (xdp_rxq_info_is_reg(&dpa_fq->xdp_rxq))
+		xdp_rxq_info_unreg(&dpa_fq->xdp_rxq);
+
 	qman_destroy_fq(fq, 0);
 	list_del(&dpa_fq->list);
 
@@ -1600,6 +1613,65 @@ dpa_fd_release(const struct net_device *net_dev, const struct qm_fd *fd)
 }
 EXPORT_SYMBOL(dpa_fd_release);
 
+/* Hand the buffers stashed in @cache over to BMan */
+void dpa_bp_cache_flush(struct dpa_bp *dpa_bp, struct dpa_bp_cache *cache)
+{
+	if (!cache->count)
+		return;
+
+	while (bman_release(dpa_bp->pool, cache->bmb, cache->count, 0))
+		cpu_relax();
+
+	cache->count = 0;
+}
+EXPORT_SYMBOL(dpa_bp_cache_flush);
+
+/* Give a DMA-mapped buffer back to @dpa_bp through the local CPU cache.
+ * Must be called from the (non-migratable) Rx processing context; the
+ * per-CPU buffer count is left to the caller.
+ */
+void dpa_bp_cache_put(struct dpa_bp *dpa_bp, dma_addr_t addr)
+{
+	struct dpa_bp_cache *cache;
+	struct bm_buffer *bmb;
+
+	if (unlikely(!dpa_bp->cache)) {
+		struct bm_buffer tmp;
+
+		tmp.opaque = 0;
+		bm_buffer_set64(&tmp, addr);
+		while (bman_release(dpa_bp->pool, &tmp, 1, 0))
+			cpu_relax();
+		return;
+	}
+
+	cache = raw_cpu_ptr(dpa_bp->cache);
+	bmb = &cache->bmb[cache->count++];
+	bmb->opaque = 0;
+	bm_buffer_set64(bmb, addr);
+
+	if (cache->count == DPA_BP_CACHE_SIZE)
+		dpa_bp_cache_flush(dpa_bp, cache);
+}
+EXPORT_SYMBOL(dpa_bp_cache_put);
+
+/* Same as dpa_fd_release(), but contiguous frames from our own pools go
+ * through the local buffer cache. Only for use on the Rx path.
+ */
+void __attribute__((nonnull))
+dpa_rx_fd_release(const struct net_device *net_dev, const struct qm_fd *fd)
+{
+	struct dpa_bp *dpa_bp = dpa_bpid2pool(fd->bpid);
+
+	if (likely(dpa_bp && fd->format == qm_fd_contig)) {
+		dpa_bp_cache_put(dpa_bp, qm_fd_addr(fd));
+		return;
+	}
+
+	dpa_fd_release(net_dev, fd);
+}
+EXPORT_SYMBOL(dpa_rx_fd_release);
+
 void count_ern(struct dpa_percpu_priv_s *percpu_priv,
 		      const struct qm_mr_entry *msg)
 {
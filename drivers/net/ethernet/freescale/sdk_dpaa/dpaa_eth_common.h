@@ -203,6 +203,10 @@ void dpa_release_sgt(struct qm_sg_entry *sgt);
 void dpa_release_sgt_by_bpid(struct qm_sg_entry *sgt);
 void __attribute__((nonnull))
 dpa_fd_release(const struct net_device *net_dev, const struct qm_fd *fd);
+void dpa_bp_cache_put(struct dpa_bp *dpa_bp, dma_addr_t addr);
+void dpa_bp_cache_flush(struct dpa_bp *dpa_bp, struct dpa_bp_cache *cache);
+void __attribute__((nonnull))
+dpa_rx_fd_release(const struct net_device *net_dev, const struct qm_fd *fd);
 void count_ern(struct dpa_percpu_priv_s *percpu_priv,
 		      const struct qm_mr_entry *msg);
 int dpa_enable_tx_csum(struct dpa_priv_s *priv,
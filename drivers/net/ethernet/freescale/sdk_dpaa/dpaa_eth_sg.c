@@ -43,6 +43,8 @@
 #include <linux/skbuff.h>
 #include <linux/highmem.h>
 #include <linux/fsl_bman.h>
+#include <linux/bpf.h>
+#include <linux/bpf_trace.h>
 #include <net/sock.h>
 
 #include "dpaa_eth.h"
@@ -61,11 +63,8 @@
 static void dpa_bp_recycle_frag(struct dpa_bp *dpa_bp, unsigned long vaddr,
 				int *count_ptr)
 {
-	struct bm_buffer bmb;
 	dma_addr_t addr;
 
-	bmb.opaque = 0;
-
 	addr = dma_map_single(dpa_bp->dev, (void *)vaddr, dpa_bp->size,
 			      DMA_BIDIRECTIONAL);
 	if (unlikely(dma_mapping_error(dpa_bp->dev, addr))) {
@@ -73,10 +72,7 @@ static void dpa_bp_recycle_frag(struct dpa_bp *dpa_bp, unsigned long vaddr,
 		return;
 	}
 
-	bm_buffer_set64(&bmb, addr);
-
-	while (bman_release(dpa_bp->pool, &bmb, 1, 0))
-		cpu_relax();
+	dpa_bp_cache_put(dpa_bp, addr);
 
 	(*count_ptr)++;
 }
@@ -188,6 +184,12 @@ int dpaa_eth_refill_bpools(struct dpa_bp *dpa_bp, int *countptr)
 	int new_bufs;
 
 	if (unlikely(count < CONFIG_FSL_DPAA_ETH_REFILL_THRESHOLD)) {
+		/* Recycled buffers are already accounted for; make them
+		 * visible to the FMan before allocating new ones.
+		 */
+		if (dpa_bp->cache)
+			dpa_bp_cache_flush(dpa_bp, raw_cpu_ptr(dpa_bp->cache));
+
 		do {
 			new_bufs = _dpa_bp_add_8_bufs(dpa_bp);
 			if (unlikely(!new_bufs)) {
@@ -236,6 +238,18 @@ struct sk_buff *_dpa_cleanup_tx_fd(const struct dpa_priv_s *priv,
 	/* retrieve skb back pointer */
 	DPA_READ_SKB_PTR(skb, skbh, phys_to_virt(addr), 0);
 
+	/* No skb means this is an XDP frame, always contiguous */
+	if (unlikely(!skb)) {
+		struct xdp_frame *xdpf;
+
+		DPA_READ_XDPF_PTR(xdpf, skbh);
+		dma_unmap_single(dpa_bp->dev, addr,
+				 dpa_fd_offset(fd) + dpa_fd_length(fd), dma_dir);
+		xdp_return_frame(xdpf);
+
+		return NULL;
+	}
+
 	if (unlikely(fd->format == qm_fd_sg)) {
 		nr_frags = skb_shinfo(skb)->nr_frags;
 		dma_unmap_single(dpa_bp->dev, addr,
@@ -397,7 +411,8 @@ static struct sk_buff *__hot contig_fd_to_skb(const struct dpa_priv_s *priv,
 	skb->truesize = SKB_TRUESIZE(dpa_fd_length(fd));
 #endif
 
-	DPA_BUG_ON(fd_off != priv->rx_headroom);
+	/* XDP programs may have moved the start of the frame */
+	DPA_BUG_ON(fd_off != priv->rx_headroom && !READ_ONCE(priv->xdp_prog));
 	skb_reserve(skb, fd_off);
 	skb_put(skb, dpa_fd_length(fd));
 
@@ -554,12 +569,137 @@ static inline int dpa_skb_loop(const struct dpa_priv_s *priv,
 }
 #endif
 
+/* Send a frame back out on the interface it was received on. The buffer comes
+ * from our own pool, so let the FMan release it back there once transmitted
+ * instead of going through Tx confirmation.
+ */
+static int dpa_xdp_tx(struct dpa_priv_s *priv,
+		      struct dpa_percpu_priv_s *percpu_priv,
+		      const struct qm_fd *rx_fd, int *count_ptr)
+{
+	struct dpa_bp *dpa_bp = priv->dpa_bp;
+	void *vaddr = phys_to_virt(qm_fd_addr(rx_fd));
+	int queue = smp_processor_id();
+	ssize_t fd_off = dpa_fd_offset(rx_fd);
+	struct qm_fd fd;
+	dma_addr_t addr;
+
+#ifdef FM_ERRATUM_A050385
+	/* The buffer doesn't cross a 4K boundary, but the XDP program may
+	 * have left the data unaligned.
+	 */
+	if (unlikely(fm_has_errata_a050385()) && fd_off % 16) {
+		memmove(vaddr + ALIGN_DOWN(fd_off, 16), vaddr + fd_off,
+			dpa_fd_length(rx_fd));
+		fd_off = ALIGN_DOWN(fd_off, 16);
+	}
+#endif
+
+	clear_fd(&fd);
+	fd.bpid = dpa_bp->bpid;
+	fd.format = qm_fd_contig;
+	fd.offset = fd_off;
+	fd.length20 = dpa_fd_length(rx_fd);
+	fd.cmd |= FM_FD_CMD_FCO;
+
+	addr = dma_map_single(dpa_bp->dev, vaddr, dpa_bp->size,
+			      DMA_BIDIRECTIONAL);
+	if (unlikely(dma_mapping_error(dpa_bp->dev, addr)))
+		return -EINVAL;
+	qm_fd_addr_set64(&fd, addr);
+
+	/* The buffer is going back into the pool either way */
+	(*count_ptr)++;
+
+	if (unlikely(dpa_xmit(priv, &percpu_priv->stats, &fd,
+			      priv->egress_fqs[queue],
+			      priv->conf_fqs[queue]) < 0)) {
+		dpa_fd_release(priv->net_dev, &fd);
+		return 0;
+	}
+
+	percpu_priv->tx_returned++;
+
+	return 0;
+}
+
+/* Run the XDP program on a contiguous frame. The FMan buffer is preceded by
+ * the skb back-pointer and followed by the shared info of the prebuilt skb,
+ * so all the space in between is available to the program.
+ *
+ * On XDP_PASS the FD offset and length are updated to describe the frame as
+ * left by the program. On any other verdict the buffer is consumed here.
+ */
+static u32 dpa_run_xdp(struct net_device *net_dev, struct bpf_prog *xdp_prog,
+		       struct dpa_percpu_priv_s *percpu_priv, struct qm_fd *fd,
+		       struct dpa_fq *dpa_fq, int *count_ptr)
+{
+	struct dpa_priv_s *priv = netdev_priv(net_dev);
+	struct dpa_bp *dpa_bp = priv->dpa_bp;
+	void *vaddr = phys_to_virt(qm_fd_addr(fd));
+	struct sk_buff *skb, **skbh;
+	struct xdp_buff xdp;
+	u32 xdp_act;
+	int err;
+
+	xdp_init_buff(&xdp, DPA_SKB_SIZE(dpa_bp->size) +
+		      SKB_DATA_ALIGN(sizeof(struct skb_shared_info)),
+		      &dpa_fq->xdp_rxq);
+	xdp_prepare_buff(&xdp, vaddr, dpa_fd_offset(fd), dpa_fd_length(fd),
+			 false);
+
+	xdp_act = bpf_prog_run_xdp(xdp_prog, &xdp);
+
+	fd->offset = xdp.data - vaddr;
+	fd->length20 = xdp.data_end - xdp.data;
+
+	switch (xdp_act) {
+	case XDP_PASS:
+		return xdp_act;
+	case XDP_TX:
+		if (unlikely(dpa_xdp_tx(priv, percpu_priv, fd, count_ptr)))
+			goto drop;
+		percpu_priv->xdp_tx++;
+		return xdp_act;
+	case XDP_REDIRECT:
+		DPA_READ_SKB_PTR(skb, skbh, vaddr, -1);
+
+		err = xdp_do_redirect(net_dev, &xdp, xdp_prog);
+		if (unlikely(err)) {
+			trace_xdp_exception(net_dev, xdp_prog, xdp_act);
+			goto drop;
+		}
+
+		/* The buffer now belongs to the XDP frame; only the skb
+		 * preallocated around it is left to free.
+		 */
+		kfree_skb_partial(skb, true);
+		percpu_priv->xdp_redirect++;
+		return xdp_act;
+	default:
+		bpf_warn_invalid_xdp_action(net_dev, xdp_prog, xdp_act);
+		fallthrough;
+	case XDP_ABORTED:
+		trace_xdp_exception(net_dev, xdp_prog, xdp_act);
+		fallthrough;
+	case XDP_DROP:
+		break;
+	}
+
+drop:
+	/* The prebuilt skb is still intact, put the buffer back in the pool */
+	dpa_bp_recycle_frag(dpa_bp, (unsigned long)vaddr, count_ptr);
+	percpu_priv->xdp_drop++;
+
+	return XDP_DROP;
+}
+
 void __hot _dpa_rx(struct net_device *net_dev,
 		struct qman_portal *portal,
 		const struct dpa_priv_s *priv,
 		struct dpa_percpu_priv_s *percpu_priv,
 		const struct qm_fd *fd,
-		u32 fqid,
+		struct dpa_fq *dpa_fq,
 		int *count_ptr)
 {
 	bool dcl4c_valid = !!(net_dev->features & NETIF_F_RXCSUM);
@@ -570,6 +710,8 @@ void __hot _dpa_rx(struct net_device *net_dev,
 	u32 fd_status = fd->status;
 	unsigned int skb_len;
 	struct rtnl_link_stats64 *percpu_stats = &percpu_priv->stats;
+	struct bpf_prog *xdp_prog;
+	struct qm_fd xdp_fd;
 
 	if (unlikely(fd_status & FM_FD_STAT_RX_ERRORS) != 0) {
 		if (netif_msg_hw(priv) && net_ratelimit())
@@ -595,11 +737,25 @@ void __hot _dpa_rx(struct net_device *net_dev,
 		/* Execute the Rx processing hook, if it exists. */
 		if (dpaa_eth_hooks.rx_default &&
 			dpaa_eth_hooks.rx_default((void *)fd, net_dev,
-					fqid) == DPAA_ETH_STOLEN) {
+					qman_fq_fqid(&dpa_fq->fq_base)) ==
+					DPAA_ETH_STOLEN) {
 			/* won't count the rx bytes in */
 			return;
 		}
 #endif
+		xdp_prog = READ_ONCE(priv->xdp_prog);
+		if (xdp_prog) {
+			xdp_fd = *fd;
+			if (dpa_run_xdp(net_dev, xdp_prog, percpu_priv, &xdp_fd,
+					dpa_fq, count_ptr) != XDP_PASS) {
+				(*count_ptr)--;
+				percpu_stats->rx_packets++;
+				percpu_stats->rx_bytes += dpa_fd_length(fd);
+				return;
+			}
+			fd = &xdp_fd;
+		}
+
 		skb = contig_fd_to_skb(priv, fd, &use_gro, dcl4c_valid);
 	} else {
 		skb = sg_fd_to_skb(priv, fd, &use_gro, count_ptr, dcl4c_valid);
@@ -643,7 +799,7 @@ void __hot _dpa_rx(struct net_device *net_dev,
 	return;
 
 _release_frame:
-	dpa_fd_release(net_dev, fd);
+	dpa_rx_fd_release(net_dev, fd);
 }
 
 int __hot skb_to_contig_fd(struct dpa_priv_s *priv,
@@ -1060,6 +1216,98 @@ int __hot dpa_tx(struct sk_buff *skb, struct net_device *net_dev)
 	return dpa_tx_extended(skb, net_dev, egress_fq, conf_fq);
 }
 
+static int dpa_xdp_xmit_frame(struct dpa_priv_s *priv,
+			      struct dpa_percpu_priv_s *percpu_priv,
+			      struct xdp_frame *xdpf, int queue)
+{
+	struct dpa_bp *dpa_bp = priv->dpa_bp;
+	struct sk_buff **skbh;
+	void *buffer_start;
+	struct qm_fd fd;
+	dma_addr_t addr;
+
+	/* We need room for the skb and xdp_frame back-pointers in front of
+	 * the data, within the reach of the FD offset.
+	 */
+	if (unlikely(xdpf->headroom < DPA_TX_PRIV_DATA_SIZE ||
+		     xdpf->headroom > DPA_MAX_FD_OFFSET))
+		return -EINVAL;
+
+#ifdef FM_ERRATUM_A050385
+	/* Unlike skbs, XDP frames aren't realigned; drop the ones which would
+	 * trigger the erratum.
+	 */
+	if (unlikely(fm_has_errata_a050385()) &&
+	    (((uintptr_t)xdpf->data % 16) ||
+	     (CROSS_4K(xdpf->data, xdpf->len) &&
+	      ((uintptr_t)xdpf->data % 256))))
+		return -EINVAL;
+#endif
+
+	buffer_start = xdpf->data - xdpf->headroom;
+	DPA_WRITE_XDPF_PTR(xdpf, skbh, buffer_start);
+
+	clear_fd(&fd);
+	fd.bpid = 0xff;
+	fd.format = qm_fd_contig;
+	fd.offset = xdpf->headroom;
+	fd.length20 = xdpf->len;
+	fd.cmd |= FM_FD_CMD_FCO;
+
+	addr = dma_map_single(dpa_bp->dev, buffer_start,
+			      xdpf->headroom + xdpf->len, DMA_TO_DEVICE);
+	if (unlikely(dma_mapping_error(dpa_bp->dev, addr)))
+		return -EINVAL;
+	qm_fd_addr_set64(&fd, addr);
+
+	if (unlikely(dpa_xmit(priv, &percpu_priv->stats, &fd,
+			      priv->egress_fqs[queue],
+			      priv->conf_fqs[queue]) < 0)) {
+		dma_unmap_single(dpa_bp->dev, addr,
+				 xdpf->headroom + xdpf->len, DMA_TO_DEVICE);
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
+int dpa_xdp_xmit(struct net_device *net_dev, int n, struct xdp_frame **frames,
+		 u32 flags)
+{
+	struct dpa_priv_s *priv = netdev_priv(net_dev);
+	struct dpa_percpu_priv_s *percpu_priv;
+	int queue = smp_processor_id();
+	struct netdev_queue *txq;
+	int i, err, nxmit = 0;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	if (!netif_running(net_dev))
+		return -ENETDOWN;
+
+	/* Non-migratable context, safe to use raw_cpu_ptr */
+	percpu_priv = raw_cpu_ptr(priv->percpu_priv);
+
+	for (i = 0; i < n; i++) {
+		err = dpa_xdp_xmit_frame(priv, percpu_priv, frames[i], queue);
+		if (unlikely(err)) {
+			/* dpa_xmit() accounts for its own errors */
+			if (err != -EBUSY)
+				percpu_priv->stats.tx_errors++;
+			break;
+		}
+		nxmit++;
+	}
+
+	/* LLTX forces us to update our own jiffies for each netdev queue */
+	txq = netdev_get_tx_queue(net_dev, queue % net_dev->real_num_tx_queues);
+	txq->trans_start = jiffies;
+
+	return nxmit;
+}
+EXPORT_SYMBOL(dpa_xdp_xmit);
+
 int __hot dpa_tx_extended(struct sk_buff *skb, struct net_device *net_dev,
 		struct qman_fq *egress_fq, struct qman_fq *conf_fq)
 {
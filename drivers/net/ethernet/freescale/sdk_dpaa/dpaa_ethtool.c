@@ -57,6 +57,9 @@ static const char dpa_stats_percpu[][ETH_GSTRING_LEN] = {
 	"tx confirm",
 	"tx S/G",
 	"rx S/G",
+	"xdp drop",
+	"xdp tx",
+	"xdp redirect",
 	"tx error",
 	"rx error",
 	"bp count"
@@ -393,6 +396,15 @@ static void copy_stats(struct dpa_percpu_priv_s *percpu_priv, int num_cpus,
 	data[crr_stat * num_stat_values + crr_cpu] = percpu_priv->rx_sg;
 	data[crr_stat++ * num_stat_values + num_cpus] += percpu_priv->rx_sg;
 
+	data[crr_stat * num_stat_values + crr_cpu] = percpu_priv->xdp_drop;
+	data[crr_stat++ * num_stat_values + num_cpus] += percpu_priv->xdp_drop;
+
+	data[crr_stat * num_stat_values + crr_cpu] = percpu_priv->xdp_tx;
+	data[crr_stat++ * num_stat_values + num_cpus] += percpu_priv->xdp_tx;
+
+	data[crr_stat * num_stat_values + crr_cpu] = percpu_priv->xdp_redirect;
+	data[crr_stat++ * num_stat_values + num_cpus] += percpu_priv->xdp_redirect;
+
 	data[crr_stat * num_stat_values + crr_cpu] = percpu_priv->stats.tx_errors;
 	data[crr_stat++ * num_stat_values + num_cpus] += percpu_priv->stats.tx_errors;
 
@@ -45,6 +45,8 @@
 
 #include <linux/init.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/cpumask.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/of_platform.h>
@@ -247,6 +249,216 @@ static void oh_set_buffer_layout(struct fm_port *port,
 	layout->data_align = params.data_align;
 }
 
+/* Serializes the attach and detach of the reprocessing users */
+static DEFINE_MUTEX(oh_reproc_lock);
+
+/* True if the device tree already set up @fqid for the port */
+static bool oh_fqid_configured(struct dpa_oh_config_s *conf, uint32_t fqid)
+{
+	struct fq_duple *fqd;
+	int i;
+
+	for (i = 0; i < conf->egress_cnt; i++)
+		if (qman_fq_fqid(conf->egress_fqs + i) == fqid)
+			return true;
+
+	list_for_each_entry(fqd, &conf->fqs_ingress_list, fq_list)
+		for (i = 0; i < fqd->fqs_count; i++)
+			if ((fqd->fqs + i)->fqid == fqid)
+				return true;
+
+	list_for_each_entry(fqd, &conf->fqs_egress_list, fq_list)
+		for (i = 0; i < fqd->fqs_count; i++)
+			if ((fqd->fqs + i)->fqid == fqid)
+				return true;
+
+	return false;
+}
+
+static enum qman_cb_dqrr_result oh_reproc_rx_dqrr(struct qman_portal *portal,
+						  struct qman_fq *fq,
+						  const struct qm_dqrr_entry *dq)
+{
+	struct oh_reproc_fq *rfq = container_of(fq, struct oh_reproc_fq, fq);
+
+	rfq->reproc->rx(rfq->reproc, &dq->fd, dq->fqid);
+	return qman_cb_dqrr_consume;
+}
+
+static void oh_reproc_tx_ern(struct qman_portal *portal, struct qman_fq *fq,
+			     const struct qm_mr_entry *msg)
+{
+	struct oh_reproc_fq *rfq = container_of(fq, struct oh_reproc_fq, fq);
+
+	if (rfq->reproc->rejected)
+		rfq->reproc->rejected(rfq->reproc, &msg->ern.fd);
+}
+
+static int oh_reproc_fq_init(struct oh_reproc_fq *rfq,
+			     struct oh_reproc *reproc, uint32_t fqid,
+			     uint32_t create_flags, uint16_t channel)
+{
+	struct qm_mcc_initfq fq_opts;
+	int err;
+
+	rfq->reproc = reproc;
+	err = qman_create_fq(fqid, create_flags, &rfq->fq);
+	if (err)
+		return err;
+
+	memset(&fq_opts, 0, sizeof(fq_opts));
+	fq_opts.we_mask = QM_INITFQ_WE_DESTWQ;
+	fq_opts.fqd.dest.wq = 3;
+	fq_opts.fqd.dest.channel = channel;
+
+	err = qman_init_fq(&rfq->fq, QMAN_INITFQ_FLAG_SCHED, &fq_opts);
+	if (err)
+		qman_destroy_fq(&rfq->fq, 0);
+	return err;
+}
+
+static void oh_reproc_destroy_fqs(struct oh_reproc *reproc)
+{
+	int i;
+
+	for (i = 0; i < reproc->rx_count; i++)
+		oh_fq_destroy(&reproc->rx_fqs[i].fq);
+	reproc->rx_count = 0;
+	oh_fq_destroy(&reproc->tx_fq.fq);
+}
+
+/* Looks up the OH port of a "fsl,dpa-oh" node, for oh_reproc_attach() */
+struct dpa_oh_config_s *oh_port_get(struct device_node *np)
+{
+	struct dpa_oh_config_s *oh_config;
+	struct platform_device *pdev;
+
+	if (!of_match_node(oh_port_match_table, np))
+		return ERR_PTR(-EINVAL);
+
+	/* Another partition sets up the shared ports */
+	if (of_device_is_compatible(np, "fsl,dpa-oh-shared"))
+		return ERR_PTR(-ENODEV);
+
+	pdev = of_find_device_by_node(np);
+	if (!pdev)
+		return ERR_PTR(-EPROBE_DEFER);
+
+	oh_config = platform_get_drvdata(pdev);
+	if (!oh_config) {
+		put_device(&pdev->dev);
+		return ERR_PTR(-EPROBE_DEFER);
+	}
+
+	return oh_config;
+}
+EXPORT_SYMBOL(oh_port_get);
+
+void oh_port_put(struct dpa_oh_config_s *oh_config)
+{
+	put_device(oh_config->dev);
+}
+EXPORT_SYMBOL(oh_port_put);
+
+/* Creates a FQ to inject frames into the port, and takes over the @count
+ * FQs of @fqids the port enqueues to, through its default FQ or its PCD.
+ * These must not be set up in the device tree. Their frames are handed to
+ * @reproc->rx, each FQ being scheduled to the portal of another online CPU.
+ * There can only be one user of a port at a time.
+ */
+int oh_reproc_attach(struct dpa_oh_config_s *oh_config,
+		     struct oh_reproc *reproc, const uint32_t *fqids, int count)
+{
+	unsigned int cpu = cpumask_first(cpu_online_mask);
+	struct oh_reproc_fq *rfq;
+	int i, err;
+
+	if (!reproc->rx || count <= 0 || count > OH_REPROC_MAX_FQS)
+		return -EINVAL;
+
+	mutex_lock(&oh_reproc_lock);
+	if (oh_config->reproc) {
+		err = -EBUSY;
+		goto unlock;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (oh_fqid_configured(oh_config, fqids[i])) {
+			dev_err(oh_config->dev,
+				"FQ %u is set up in the device tree\n",
+				fqids[i]);
+			err = -EBUSY;
+			goto unlock;
+		}
+	}
+
+	reproc->oh_config = oh_config;
+	reproc->rx_count = 0;
+	reproc->tx_fq.fq.cb.ern = oh_reproc_tx_ern;
+	err = oh_reproc_fq_init(&reproc->tx_fq, reproc, 0,
+				QMAN_FQ_FLAG_DYNAMIC_FQID |
+				QMAN_FQ_FLAG_TO_DCPORTAL,
+				oh_config->channel);
+	if (err) {
+		dev_err(oh_config->dev, "Can't create the inject FQ: %d\n",
+			err);
+		goto unlock;
+	}
+
+	for (i = 0; i < count; i++) {
+		rfq = &reproc->rx_fqs[i];
+		rfq->fq.cb.dqrr = oh_reproc_rx_dqrr;
+		err = oh_reproc_fq_init(rfq, reproc, fqids[i],
+					QMAN_FQ_FLAG_NO_ENQUEUE,
+					qman_affine_channel(cpu));
+		if (err) {
+			dev_err(oh_config->dev,
+				"Can't create the reprocessing FQ %u: %d\n",
+				fqids[i], err);
+			oh_reproc_destroy_fqs(reproc);
+			goto unlock;
+		}
+		reproc->rx_count++;
+
+		cpu = cpumask_next(cpu, cpu_online_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_online_mask);
+	}
+
+	oh_config->reproc = reproc;
+	dev_dbg(oh_config->dev, "Reprocessing through FQ %u to %d FQs\n",
+		qman_fq_fqid(&reproc->tx_fq.fq), count);
+
+unlock:
+	mutex_unlock(&oh_reproc_lock);
+	return err;
+}
+EXPORT_SYMBOL(oh_reproc_attach);
+
+/* The user must stop injecting frames before detaching */
+void oh_reproc_detach(struct oh_reproc *reproc)
+{
+	mutex_lock(&oh_reproc_lock);
+	reproc->oh_config->reproc = NULL;
+	oh_reproc_destroy_fqs(reproc);
+	mutex_unlock(&oh_reproc_lock);
+}
+EXPORT_SYMBOL(oh_reproc_detach);
+
+int oh_reproc_inject(struct oh_reproc *reproc, const struct qm_fd *fd)
+{
+	int err, i;
+
+	for (i = 0; i < 100000; i++) {
+		err = qman_enqueue(&reproc->tx_fq.fq, fd, 0);
+		if (err != -EBUSY)
+			break;
+	}
+
+	return err;
+}
+EXPORT_SYMBOL(oh_reproc_inject);
+
 static int
 oh_port_probe(struct platform_device *_of_dev)
 {
@@ -363,6 +575,8 @@ oh_port_probe(struct platform_device *_of_dev)
 
 	INIT_LIST_HEAD(&oh_config->fqs_ingress_list);
 	INIT_LIST_HEAD(&oh_config->fqs_egress_list);
+	oh_config->dev = dpa_oh_dev;
+	oh_config->channel = (uint16_t)channel_id;
 
 	/* FQs that enter OH port */
 	lenp = 0;
@@ -784,6 +998,9 @@ static void __cold oh_port_remove(struct platform_device *_of_dev)
 		return;
 	}
 
+	if (WARN_ON(oh_config->reproc))
+		oh_reproc_detach(oh_config->reproc);
+
 	if (oh_config->egress_fqs)
 		for (i = 0; i < oh_config->egress_cnt; i++)
 			oh_fq_destroy(oh_config->egress_fqs + i);
@@ -32,8 +32,10 @@
 #ifndef __OFFLINE_PORT_H
 #define __OFFLINE_PORT_H
 
+#include <linux/fsl_qman.h>
+
 struct fm_port;
-struct qman_fq;
+struct oh_reproc;
 
 /* fqs are defined in duples (base_fq, fq_count) */
 struct fq_duple {
@@ -51,9 +53,48 @@ struct dpa_oh_config_s {
 	uint32_t		egress_cnt;
 	struct qman_fq		*egress_fqs;
 	uint16_t		channel;
+	struct device		*dev;
+	struct oh_reproc	*reproc;
 
 	struct list_head fqs_ingress_list;
 	struct list_head fqs_egress_list;
 };
 
+/* Frame reprocessing through an OH port.
+ *
+ * Frames enqueued with oh_reproc_inject() go through the parser, the
+ * classifier and any manipulations the port was set up with (by fmc or by
+ * the PCD API), then come back to @rx from the FQs given to
+ * oh_reproc_attach(), in softirq context on the CPU the FQ was spread to.
+ * The parse results are in the buffer prefix, as on any OH port output.
+ * The frame buffers stay owned by the user, on the way in or back; those
+ * rejected by QMan on enqueue are returned through @rejected.
+ */
+#define OH_REPROC_MAX_FQS	8
+
+struct oh_reproc_fq {
+	struct qman_fq		fq;
+	struct oh_reproc	*reproc;
+};
+
+struct oh_reproc {
+	/* Set by the user before attaching */
+	void (*rx)(struct oh_reproc *reproc, const struct qm_fd *fd, u32 fqid);
+	void (*rejected)(struct oh_reproc *reproc, const struct qm_fd *fd);
+	void			*priv;
+
+	/* Private to the OH port driver */
+	struct dpa_oh_config_s	*oh_config;
+	struct oh_reproc_fq	tx_fq;
+	struct oh_reproc_fq	rx_fqs[OH_REPROC_MAX_FQS];
+	int			rx_count;
+};
+
+struct dpa_oh_config_s *oh_port_get(struct device_node *np);
+void oh_port_put(struct dpa_oh_config_s *oh_config);
+int oh_reproc_attach(struct dpa_oh_config_s *oh_config,
+		     struct oh_reproc *reproc, const u32 *fqids, int count);
+void oh_reproc_detach(struct oh_reproc *reproc);
+int oh_reproc_inject(struct oh_reproc *reproc, const struct qm_fd *fd);
+
 #endif /* __OFFLINE_PORT_H */
@@ -26,11 +26,13 @@
 #include <linux/ethtool.h>
 #include <linux/rtnetlink.h>
 #include <linux/virtio_ring.h>
+#include <linux/virtio_net.h>
 #include <linux/platform_device.h>
 #include <linux/of_device.h>
 #include <linux/of_reserved_mem.h>
 #include <linux/clk.h>
 #include <linux/mutex.h>
+#include <linux/delay.h>
 
 #ifdef CONFIG_IMX_SCU
 #include <linux/firmware/imx/sci.h>
@@ -50,6 +52,7 @@
 #define IMX_SHM_NET_STATE_RUN	3
 
 #define IMX_SHM_NET_FLAG_RUN	0
+#define IMX_SHM_NET_FLAG_RX_ZC	1
 
 #define IMX_SHM_NET_MTU_MIN 256
 #define IMX_SHM_NET_MTU_MAX 65535
@@ -58,6 +61,28 @@
 #define IMX_SHM_NET_FRAME_SIZE(s) ALIGN(18 + (s), SMP_CACHE_BYTES)
 
 #define IMX_SHM_NET_VQ_ALIGN 64
+#define IMX_SHM_NET_QLEN_MAX 4096
+
+/* RX frames up to this size are always copied, larger ones only get */
+/* their headers copied when handed to the stack without a copy. */
+#define IMX_SHM_NET_RX_COPYBREAK 256
+
+/* The MU message carries the local state in its low byte and, once more
+ * than one queue pair has been negotiated, a bitmap of the queues to kick
+ * in its upper half.
+ */
+#define IMX_SHM_NET_MAX_QUEUES		16
+#define IMX_SHM_NET_MSG_STATE_MASK	0xff
+#define IMX_SHM_NET_MSG_QUEUE_SHIFT	16
+
+/* Each side advertises its queue count at the end of its TX half, */
+/* outside of the area covered by the legacy single queue layout. */
+#define IMX_SHM_NET_HDR_MAGIC	0x514d5349	/* "ISMQ" */
+#define IMX_SHM_NET_HDR_SIZE	IMX_SHM_NET_VQ_ALIGN
+
+/* frames are preceded by a struct virtio_net_hdr */
+#define IMX_SHM_NET_F_VNET_HDR	BIT(0)
+#define IMX_SHM_NET_FEATURES	IMX_SHM_NET_F_VNET_HDR
 
 /* (queue_size + vring_size) * 2 for TX&RX */
 #define IMX_SHM_NET_DMA_SIZE (((IMX_SHM_NET_MTU_DEF * 16) + (64 * 1024)) * 2)
@@ -108,36 +133,61 @@ struct imx_shm_net_queue {
 };
 
 struct imx_shm_net_stats {
-	u32 interrupts;
 	u32 tx_packets;
 	u32 tx_notify;
+	u32 tx_notify_suppressed;
 	u32 tx_pause;
 	u32 rx_packets;
 	u32 rx_notify;
+	u32 rx_notify_suppressed;
+	u32 rx_zerocopy;
 	u32 napi_poll;
 	u32 napi_complete;
 	u32 napi_poll_n[10];
 };
 
-struct imx_shm_net {
+struct imx_shm_net_hdr {
+	u32 magic;
+	u32 num_queues;
+	u32 features;
+};
+
+struct imx_shm_net_qp {
 	struct imx_shm_net_queue rx;
 	struct imx_shm_net_queue tx;
 
-	u32 vrsize;
-	u32 qlen;
-	u32 qsize;
-
 	spinlock_t tx_free_lock;	/* protect available buffers */
 	spinlock_t tx_clean_lock;	/* protect used buffers */
 
 	struct napi_struct napi;
+	struct imx_shm_net *in;
+	unsigned int index;
+	u32 kick;			/* MU message for this queue */
+
+	/* RX slots lent to the stack, returned once their pages are free */
+	DECLARE_BITMAP(rx_zc, IMX_SHM_NET_QLEN_MAX);
+	struct timer_list rx_timer;
+
+	struct imx_shm_net_stats stats;
+};
+
+struct imx_shm_net {
+	struct imx_shm_net_qp qp[IMX_SHM_NET_MAX_QUEUES];
+	unsigned int max_queues;	/* local limit */
+	unsigned int num_queues;	/* negotiated with the peer */
+	u32 features;			/* negotiated with the peer */
+	bool rx_zc_capable;
+
+	u32 vrsize;
+	u32 qlen;
+	u32 qsize;
 
 	unsigned long flags;
 
 	struct workqueue_struct *state_wq;
 	struct work_struct state_work;
 
-	struct imx_shm_net_stats stats;
+	u32 interrupts;
 
 	struct imx_shmem_regs regs;
 	void *shm;
@@ -207,46 +257,70 @@ static void imx_shm_net_init_queues(struct net_device *ndev)
 {
 	struct imx_shm_net *in = netdev_priv(ndev);
 	int ivpos = in->regs.ivpos;
+	size_t half = in->shmlen / 2;
+	size_t stride = in->vrsize + in->qsize;
+	struct imx_shm_net_qp *qp;
+	unsigned int q;
+	void *end;
 	void *tx;
 	void *rx;
 	int i;
 
-	tx = in->shm +  ivpos * in->shmlen / 2;
-	rx = in->shm + !ivpos * in->shmlen / 2;
+	tx = in->shm +  ivpos * half;
+	rx = in->shm + !ivpos * half;
 
-	memset(tx, 0, in->shmlen / 2);
+	/* keep our queue count advertisement, see imx_shm_net_advertise() */
+	memset(tx, 0, half - IMX_SHM_NET_HDR_SIZE);
 
-	imx_shm_net_init_queue(in, &in->rx, rx, in->qlen);
-	imx_shm_net_init_queue(in, &in->tx, tx, in->qlen);
+	for (q = 0; q < in->num_queues; q++) {
+		qp = &in->qp[q];
 
-	swap(in->rx.vr.used, in->tx.vr.used);
+		imx_shm_net_init_queue(in, &qp->rx, rx + q * stride, in->qlen);
+		imx_shm_net_init_queue(in, &qp->tx, tx + q * stride, in->qlen);
 
-	in->tx.num_free = in->tx.vr.num;
+		swap(qp->rx.vr.used, qp->tx.vr.used);
+		bitmap_zero(qp->rx_zc, IMX_SHM_NET_QLEN_MAX);
 
-	for (i = 0; i < in->tx.vr.num - 1; i++)
-		in->tx.vr.desc[i].next = i + 1;
+		qp->tx.num_free = qp->tx.vr.num;
+
+		for (i = 0; i < qp->tx.vr.num - 1; i++)
+			qp->tx.vr.desc[i].next = i + 1;
+	}
+
+	/* The last TX data area stops short of the advertisement. The peer */
+	/* validates against the full area, so this stays compatible. */
+	qp = &in->qp[in->num_queues - 1];
+	end = tx + half - IMX_SHM_NET_HDR_SIZE;
+	if (qp->tx.end > end) {
+		qp->tx.size -= qp->tx.end - end;
+		qp->tx.end = end;
+	}
 }
 
-static int imx_shm_net_calc_qsize(struct net_device *ndev)
+static int imx_shm_net_calc_qsize(struct net_device *ndev,
+				  unsigned int num_queues)
 {
 	struct imx_shm_net *in = netdev_priv(ndev);
+	unsigned int stride;
 	unsigned int vrsize;
 	unsigned int qsize;
 	unsigned int qlen;
 
-	for (qlen = 4096; qlen > 32; qlen >>= 1) {
+	stride = ALIGN_DOWN(in->shmlen / 2 / num_queues, IMX_SHM_NET_VQ_ALIGN);
+
+	for (qlen = IMX_SHM_NET_QLEN_MAX; qlen > 32; qlen >>= 1) {
 		vrsize = vring_size(qlen, IMX_SHM_NET_VQ_ALIGN);
 		vrsize = ALIGN(vrsize, IMX_SHM_NET_VQ_ALIGN);
-		if (vrsize < in->shmlen / 16)
+		if (vrsize < stride / 8)
 			break;
 	}
 
-	if (vrsize > in->shmlen / 2)
+	if (vrsize > stride)
 		return -EINVAL;
 
-	qsize = in->shmlen / 2 - vrsize;
+	qsize = stride - vrsize;
 
-	if (qsize < 4 * IMX_SHM_NET_MTU_MIN)
+	if (qsize < 4 * IMX_SHM_NET_MTU_MIN + IMX_SHM_NET_HDR_SIZE)
 		return -EINVAL;
 
 	in->vrsize = vrsize;
@@ -256,74 +330,134 @@ static int imx_shm_net_calc_qsize(struct net_device *ndev)
 	return 0;
 }
 
-static void imx_shm_net_notify_tx(struct imx_shm_net *in, unsigned int num)
+static struct imx_shm_net_hdr *imx_shm_net_hdr(struct imx_shm_net *in,
+					       u32 pos)
 {
-	u16 evt, old, new;
+	return in->shm + (pos + 1) * in->shmlen / 2 - IMX_SHM_NET_HDR_SIZE;
+}
+
+static void imx_shm_net_advertise(struct imx_shm_net *in)
+{
+	struct imx_shm_net_hdr *hdr = imx_shm_net_hdr(in, in->regs.ivpos);
+
+	WRITE_ONCE(hdr->num_queues, in->max_queues);
+	WRITE_ONCE(hdr->features, IMX_SHM_NET_FEATURES);
+	WRITE_ONCE(hdr->magic, IMX_SHM_NET_HDR_MAGIC);
+}
+
+/* Peers without multi-queue support advertise nothing: one queue pair */
+/* and no features. */
+static void imx_shm_net_peer_caps(struct imx_shm_net *in, u32 *num_queues,
+				  u32 *features)
+{
+	struct imx_shm_net_hdr *hdr = imx_shm_net_hdr(in, !in->regs.ivpos);
+
+	*num_queues = 1;
+	*features = 0;
+
+	if (READ_ONCE(hdr->magic) != IMX_SHM_NET_HDR_MAGIC)
+		return;
+
+	/* memory barrier */
+	virt_rmb();
+	*num_queues = clamp_t(u32, READ_ONCE(hdr->num_queues), 1,
+			      in->max_queues);
+	*features = READ_ONCE(hdr->features) & IMX_SHM_NET_FEATURES;
+}
+
+static void imx_shm_net_kick(struct imx_shm_net_qp *qp, const char *caller)
+{
+	struct imx_shm_net *in = qp->in;
+	void *msg = &in->regs.lstate;
 	int ret;
 
+	if (in->num_queues > 1) {
+		qp->kick = in->regs.lstate |
+			   BIT(IMX_SHM_NET_MSG_QUEUE_SHIFT + qp->index);
+		msg = &qp->kick;
+	}
+
+	ret = mbox_send_message(in->tx_ch, msg);
+	if (ret < 0)
+		dev_err(&in->pdev->dev, "%s send message error=%d!\n",
+			caller, ret);
+}
+
+static void imx_shm_net_notify_tx(struct imx_shm_net_qp *qp, unsigned int num)
+{
+	u16 evt, old, new;
+
 	/* memory barrier */
 	virt_mb();
 
-	evt = READ_ONCE(vring_avail_event(&in->tx.vr));
-	old = in->tx.last_avail_idx - num;
-	new = in->tx.last_avail_idx;
+	evt = READ_ONCE(vring_avail_event(&qp->tx.vr));
+	old = qp->tx.last_avail_idx - num;
+	new = qp->tx.last_avail_idx;
 
 	if (vring_need_event(evt, new, old)) {
-		ret = mbox_send_message(in->tx_ch, &in->regs.lstate);
-		if (ret < 0)
-			dev_err(&in->pdev->dev, "%s send message error=%d!\n",
-				__func__, ret);
-
-		in->stats.tx_notify++;
+		imx_shm_net_kick(qp, __func__);
+		qp->stats.tx_notify++;
+	} else {
+		qp->stats.tx_notify_suppressed++;
 	}
 }
 
-static void imx_shm_net_enable_rx_irq(struct imx_shm_net *in)
+/* Ask for a kick on the next frame. The event index only moves when NAPI */
+/* completes, so the peer stays quiet for as long as we are polling. */
+static void imx_shm_net_enable_rx_irq(struct imx_shm_net_qp *qp)
 {
-	vring_avail_event(&in->rx.vr) = in->rx.last_avail_idx;
+	u16 *evt = &vring_avail_event(&qp->rx.vr);
+
+	/* leave the shared cache line alone when nothing changed */
+	if (READ_ONCE(*evt) == qp->rx.last_avail_idx)
+		return;
+
+	WRITE_ONCE(*evt, qp->rx.last_avail_idx);
 	/* memory barrier */
 	virt_wmb();
 }
 
-static void imx_shm_net_notify_rx(struct imx_shm_net *in, unsigned int num)
+static void imx_shm_net_notify_rx(struct imx_shm_net_qp *qp, unsigned int num)
 {
 	u16 evt, old, new;
-	int ret;
 
 	/* memory barrier */
 	virt_mb();
 
-	evt = vring_used_event(&in->rx.vr);
-	old = in->rx.last_used_idx - num;
-	new = in->rx.last_used_idx;
+	evt = vring_used_event(&qp->rx.vr);
+	old = qp->rx.last_used_idx - num;
+	new = qp->rx.last_used_idx;
 
 	if (vring_need_event(evt, new, old)) {
-		ret = mbox_send_message(in->tx_ch, &in->regs.lstate);
-		if (ret < 0)
-			dev_err(&in->pdev->dev, "%s send message error=%d!\n",
-				__func__, ret);
-
-		in->stats.rx_notify++;
+		imx_shm_net_kick(qp, __func__);
+		qp->stats.rx_notify++;
+	} else {
+		qp->stats.rx_notify_suppressed++;
 	}
 }
 
-static void imx_shm_net_enable_tx_irq(struct imx_shm_net *in)
+/* Like virtqueue_enable_cb_delayed(): with the queue stopped, one kick */
+/* once three quarters of the frames in flight are done is enough to */
+/* restart it, and still leaves frames queued to keep the peer busy. */
+static void imx_shm_net_enable_tx_irq(struct imx_shm_net_qp *qp)
 {
-	vring_used_event(&in->tx.vr) = in->tx.last_used_idx;
+	struct imx_shm_net_queue *tx = &qp->tx;
+	u16 bufs = (u16)(tx->last_avail_idx - tx->last_used_idx) * 3 / 4;
+
+	WRITE_ONCE(vring_used_event(&tx->vr), tx->last_used_idx + bufs);
 	/* memory barrier */
-	virt_wmb();
+	virt_mb();
 }
 
-static bool imx_shm_net_rx_avail(struct imx_shm_net *in)
+static bool imx_shm_net_rx_avail(struct imx_shm_net_qp *qp)
 {
 	/* memory barrier */
 	virt_mb();
-	return READ_ONCE(in->rx.vr.avail->idx) != in->rx.last_avail_idx;
+	return READ_ONCE(qp->rx.vr.avail->idx) != qp->rx.last_avail_idx;
 }
 
-static size_t imx_shm_net_tx_space(struct imx_shm_net *in)
+static size_t imx_shm_net_tx_space(struct imx_shm_net_queue *tx)
 {
-	struct imx_shm_net_queue *tx = &in->tx;
 	u32 tail = tx->tail;
 	u32 head = tx->head;
 	u32 space;
@@ -336,10 +470,22 @@ static size_t imx_shm_net_tx_space(struct imx_shm_net *in)
 	return space;
 }
 
-static bool imx_shm_net_tx_ok(struct imx_shm_net *in, unsigned int mtu)
+/* largest frame the stack may hand us, metadata included */
+static unsigned int imx_shm_net_frame_max(struct net_device *ndev)
 {
-	return in->tx.num_free >= 2 &&
-		imx_shm_net_tx_space(in) >= 2 * IMX_SHM_NET_FRAME_SIZE(mtu);
+	struct imx_shm_net *in = netdev_priv(ndev);
+
+	if (!(in->features & IMX_SHM_NET_F_VNET_HDR))
+		return ndev->mtu;
+
+	return max(ndev->mtu, ndev->tso_max_size) +
+		sizeof(struct virtio_net_hdr);
+}
+
+static bool imx_shm_net_tx_ok(struct imx_shm_net_qp *qp, unsigned int size)
+{
+	return qp->tx.num_free >= 2 &&
+		imx_shm_net_tx_space(&qp->tx) >= 2 * IMX_SHM_NET_FRAME_SIZE(size);
 }
 
 static u32 imx_shm_net_tx_advance(struct imx_shm_net_queue *q, u32 *pos,
@@ -356,11 +502,12 @@ static u32 imx_shm_net_tx_advance(struct imx_shm_net_queue *q, u32 *pos,
 	return p;
 }
 
-static int imx_shm_net_tx_frame(struct net_device *ndev, struct sk_buff *skb,
-				bool xmit_more)
+static int imx_shm_net_tx_frame(struct imx_shm_net_qp *qp, struct sk_buff *skb,
+				struct virtio_net_hdr *vh, bool xmit_more)
 {
-	struct imx_shm_net *in = netdev_priv(ndev);
-	struct imx_shm_net_queue *tx = &in->tx;
+	struct imx_shm_net *in = qp->in;
+	u32 hlen = vh ? sizeof(*vh) : 0;
+	struct imx_shm_net_queue *tx = &qp->tx;
 	struct vring *vr = &tx->vr;
 	struct vring_desc *desc;
 	unsigned int desc_idx;
@@ -370,20 +517,26 @@ static int imx_shm_net_tx_frame(struct net_device *ndev, struct sk_buff *skb,
 
 	BUG_ON(tx->num_free < 1);
 
-	spin_lock(&in->tx_free_lock);
+	spin_lock(&qp->tx_free_lock);
 	desc_idx = tx->free_head;
 	desc = &vr->desc[desc_idx];
 	tx->free_head = desc->next;
 	tx->num_free--;
-	spin_unlock(&in->tx_free_lock);
+	spin_unlock(&qp->tx_free_lock);
 
-	head = imx_shm_net_tx_advance(tx, &tx->head, skb->len);
+	head = imx_shm_net_tx_advance(tx, &tx->head, hlen + skb->len);
 
 	buf = tx->data + head;
-	skb_copy_and_csum_dev(skb, buf);
+	if (vh) {
+		/* checksum and segmentation are left to the peer */
+		memcpy(buf, vh, hlen);
+		skb_copy_bits(skb, 0, buf + hlen, skb->len);
+	} else {
+		skb_copy_and_csum_dev(skb, buf);
+	}
 
 	desc->addr = buf - in->shm;
-	desc->len = skb->len;
+	desc->len = hlen + skb->len;
 	desc->flags = 0;
 
 	avail = tx->last_avail_idx++ & (vr->num - 1);
@@ -393,17 +546,18 @@ static int imx_shm_net_tx_frame(struct net_device *ndev, struct sk_buff *skb,
 	if (!xmit_more) {
 		/* memory barrier */
 		virt_store_release(&vr->avail->idx, tx->last_avail_idx);
-		imx_shm_net_notify_tx(in, tx->num_added);
+		imx_shm_net_notify_tx(qp, tx->num_added);
 		tx->num_added = 0;
 	}
 
 	return 0;
 }
 
-static void imx_shm_net_tx_clean(struct net_device *ndev)
+static void imx_shm_net_tx_clean(struct net_device *ndev,
+				 struct imx_shm_net_qp *qp)
 {
 	struct imx_shm_net *in = netdev_priv(ndev);
-	struct imx_shm_net_queue *tx = &in->tx;
+	struct imx_shm_net_queue *tx = &qp->tx;
 	struct vring_used_elem *used;
 	struct vring *vr = &tx->vr;
 	struct vring_desc *desc;
@@ -413,7 +567,7 @@ static void imx_shm_net_tx_clean(struct net_device *ndev)
 	u16 last;
 	u32 fhead;
 
-	if (!spin_trylock(&in->tx_clean_lock))
+	if (!spin_trylock(&qp->tx_clean_lock))
 		return;
 
 	/* memory barrier */
@@ -438,7 +592,7 @@ static void imx_shm_net_tx_clean(struct net_device *ndev)
 
 		desc = &vr->desc[used->id];
 
-		data = imx_shm_net_desc_data(in, &in->tx, desc, &len);
+		data = imx_shm_net_desc_data(in, tx, desc, &len);
 		if (!data) {
 			netdev_err(ndev, "bad tx descriptor, data == NULL\n");
 			break;
@@ -462,22 +616,22 @@ static void imx_shm_net_tx_clean(struct net_device *ndev)
 
 	tx->last_used_idx = last;
 
-	spin_unlock(&in->tx_clean_lock);
+	spin_unlock(&qp->tx_clean_lock);
 
 	if (num) {
-		spin_lock(&in->tx_free_lock);
+		spin_lock(&qp->tx_free_lock);
 		fdesc->next = tx->free_head;
 		tx->free_head = fhead;
 		tx->num_free += num;
 		BUG_ON(tx->num_free > vr->num);
-		spin_unlock(&in->tx_free_lock);
+		spin_unlock(&qp->tx_free_lock);
 	}
 }
 
-static struct vring_desc *imx_shm_net_rx_desc(struct net_device *ndev)
+static struct vring_desc *imx_shm_net_rx_desc(struct net_device *ndev,
+					      struct imx_shm_net_qp *qp)
 {
-	struct imx_shm_net *in = netdev_priv(ndev);
-	struct imx_shm_net_queue *rx = &in->rx;
+	struct imx_shm_net_queue *rx = &qp->rx;
 	struct vring *vr = &rx->vr;
 	unsigned int avail;
 	u16 avail_idx;
@@ -497,10 +651,10 @@ static struct vring_desc *imx_shm_net_rx_desc(struct net_device *ndev)
 	return &vr->desc[avail];
 }
 
-static void imx_shm_net_rx_finish(struct imx_shm_net *in,
+static void imx_shm_net_rx_finish(struct imx_shm_net_qp *qp,
 				  struct vring_desc *desc)
 {
-	struct imx_shm_net_queue *rx = &in->rx;
+	struct imx_shm_net_queue *rx = &qp->rx;
 	struct vring *vr = &rx->vr;
 	unsigned int desc_id = desc - vr->desc;
 	unsigned int used;
@@ -513,15 +667,188 @@ static void imx_shm_net_rx_finish(struct imx_shm_net *in,
 	virt_store_release(&vr->used->idx, rx->last_used_idx);
 }
 
+/* The stack is done with a frame once none of its pages is referenced */
+/* beyond the allocation itself. Pages shared with a neighbouring frame */
+/* still in flight keep it a little longer. */
+static bool imx_shm_net_rx_released(struct imx_shm_net *in,
+				    struct imx_shm_net_queue *rx,
+				    struct vring_desc *desc)
+{
+	unsigned long pfn, last;
+	void *data;
+	u32 len;
+
+	data = imx_shm_net_desc_data(in, rx, desc, &len);
+	if (!data || !len)
+		return true;
+
+	last = PHYS_PFN(virt_to_phys(data + len - 1));
+	for (pfn = PHYS_PFN(virt_to_phys(data)); pfn <= last; pfn++)
+		if (page_ref_count(pfn_to_page(pfn)) != 1)
+			return false;
+
+	return true;
+}
+
+/* hand consumed descriptors back to the peer, in order */
+static unsigned int imx_shm_net_rx_reclaim(struct imx_shm_net_qp *qp)
+{
+	struct imx_shm_net_queue *rx = &qp->rx;
+	struct vring *vr = &rx->vr;
+	unsigned int num = 0;
+
+	while (rx->last_used_idx != rx->last_avail_idx) {
+		unsigned int pos = rx->last_used_idx & (vr->num - 1);
+		unsigned int id = READ_ONCE(vr->avail->ring[pos]);
+
+		if (id >= vr->num)
+			break;
+
+		if (test_bit(pos, qp->rx_zc)) {
+			if (!imx_shm_net_rx_released(qp->in, rx, &vr->desc[id]))
+				break;
+			__clear_bit(pos, qp->rx_zc);
+		}
+
+		imx_shm_net_rx_finish(qp, &vr->desc[id]);
+		num++;
+	}
+
+	return num;
+}
+
+static void imx_shm_net_rx_timer(struct timer_list *t)
+{
+	struct imx_shm_net_qp *qp = from_timer(qp, t, rx_timer);
+
+	napi_schedule(&qp->napi);
+}
+
+/* Lend the buffer to the stack, unless the peer is running out of them. */
+static bool imx_shm_net_rx_zc_ok(struct imx_shm_net_qp *qp, void *data,
+				 u32 len)
+{
+	struct imx_shm_net *in = qp->in;
+	struct imx_shm_net_queue *rx = &qp->rx;
+	struct vring *vr = &rx->vr;
+	u16 held = rx->last_avail_idx - rx->last_used_idx;
+	unsigned int id;
+	void *first;
+	u32 flen;
+
+	if (!test_bit(IMX_SHM_NET_FLAG_RX_ZC, &in->flags))
+		return false;
+
+	if (len <= IMX_SHM_NET_RX_COPYBREAK ||
+	    DIV_ROUND_UP(offset_in_page(data) + len, PAGE_SIZE) > MAX_SKB_FRAGS)
+		return false;
+
+	if (held > vr->num / 2)
+		return false;
+
+	/* nor when frames still held span half of the data area */
+	id = READ_ONCE(vr->avail->ring[rx->last_used_idx & (vr->num - 1)]);
+	if (id >= vr->num)
+		return false;
+
+	first = imx_shm_net_desc_data(in, rx, &vr->desc[id], &flen);
+	if (!first)
+		return false;
+
+	return (data >= first ? data - first :
+		rx->size - (first - data)) < rx->size / 2;
+}
+
+static void imx_shm_net_rx_frags(struct sk_buff *skb, void *data, u32 len)
+{
+	unsigned int i = 0;
+
+	while (len) {
+		unsigned int off = offset_in_page(data);
+		u32 size = min_t(u32, len, PAGE_SIZE - off);
+		struct page *page = virt_to_page(data);
+
+		get_page(page);
+		skb_add_rx_frag(skb, i++, page, off, size, size);
+		data += size;
+		len -= size;
+	}
+
+	/* the peer owns the memory and may still write to it */
+	skb_shinfo(skb)->flags |= SKBFL_SHARED_FRAG;
+}
+
+static struct sk_buff *imx_shm_net_rx_skb(struct net_device *ndev,
+					  struct imx_shm_net_qp *qp,
+					  void *data, u32 len)
+{
+	struct imx_shm_net *in = qp->in;
+	struct vring *vr = &qp->rx.vr;
+	struct virtio_net_hdr vh = {};
+	struct sk_buff *skb;
+	bool zc;
+	u32 hlen;
+
+	if (in->features & IMX_SHM_NET_F_VNET_HDR) {
+		if (len < sizeof(vh))
+			return NULL;
+		memcpy(&vh, data, sizeof(vh));
+		data += sizeof(vh);
+		len -= sizeof(vh);
+	}
+
+	zc = imx_shm_net_rx_zc_ok(qp, data, len);
+	hlen = len;
+	if (zc) {
+		/* headers, up to the checksum field, go to the linear part */
+		hlen = IMX_SHM_NET_RX_COPYBREAK;
+		if ((in->features & IMX_SHM_NET_F_VNET_HDR) &&
+		    (vh.flags & VIRTIO_NET_HDR_F_NEEDS_CSUM))
+			hlen = max_t(u32, hlen,
+				     __virtio16_to_cpu(true, vh.csum_start) +
+				     __virtio16_to_cpu(true, vh.csum_offset) + 2);
+		hlen = min(hlen, len);
+		zc = hlen < len;
+	}
+
+	skb = napi_alloc_skb(&qp->napi, hlen);
+	if (!skb)
+		return NULL;
+
+	skb_put_data(skb, data, hlen);
+	if (zc) {
+		imx_shm_net_rx_frags(skb, data + hlen, len - hlen);
+		__set_bit((u16)(qp->rx.last_avail_idx - 1) & (vr->num - 1),
+			  qp->rx_zc);
+		qp->stats.rx_zerocopy++;
+	}
+
+	if ((in->features & IMX_SHM_NET_F_VNET_HDR) &&
+	    virtio_net_hdr_to_skb(skb, &vh, true)) {
+		netdev_dbg(ndev, "bad rx virtio-net header\n");
+		/* any frag reference is dropped right here */
+		dev_kfree_skb_any(skb);
+		return NULL;
+	}
+
+	skb->protocol = eth_type_trans(skb, ndev);
+	skb_record_rx_queue(skb, qp->index);
+
+	return skb;
+}
+
 static int imx_shm_net_poll(struct napi_struct *napi, int budget)
 {
 	struct net_device *ndev = napi->dev;
-	struct imx_shm_net *in = container_of(napi, struct imx_shm_net, napi);
+	struct imx_shm_net_qp *qp = container_of(napi, struct imx_shm_net_qp,
+						 napi);
+	struct imx_shm_net *in = qp->in;
+	unsigned int returned;
 	int received = 0;
 
-	in->stats.napi_poll++;
+	qp->stats.napi_poll++;
 
-	imx_shm_net_tx_clean(ndev);
+	imx_shm_net_tx_clean(ndev, qp);
 
 	while (received < budget) {
 		struct vring_desc *desc;
@@ -529,47 +856,49 @@ static int imx_shm_net_poll(struct napi_struct *napi, int budget)
 		void *data;
 		u32 len;
 
-		desc = imx_shm_net_rx_desc(ndev);
+		desc = imx_shm_net_rx_desc(ndev, qp);
 		if (!desc)
 			break;
 
-		data = imx_shm_net_desc_data(in, &in->rx, desc, &len);
+		data = imx_shm_net_desc_data(in, &qp->rx, desc, &len);
 		if (!data) {
 			netdev_err(ndev, "bad rx descriptor\n");
 			break;
 		}
 
-		skb = napi_alloc_skb(napi, len);
-
-		if (skb) {
-			memcpy(skb_put(skb, len), data, len);
-			skb->protocol = eth_type_trans(skb, ndev);
+		skb = imx_shm_net_rx_skb(ndev, qp, data, len);
+		if (skb)
 			napi_gro_receive(napi, skb);
-		}
+		else
+			ndev->stats.rx_dropped++;
 
 		ndev->stats.rx_packets++;
 		ndev->stats.rx_bytes += len;
 
-		imx_shm_net_rx_finish(in, desc);
 		received++;
 	}
 
+	returned = imx_shm_net_rx_reclaim(qp);
+
 	if (received < budget) {
-		in->stats.napi_complete++;
+		qp->stats.napi_complete++;
 		napi_complete_done(napi, received);
-		imx_shm_net_enable_rx_irq(in);
-		if (imx_shm_net_rx_avail(in))
+		imx_shm_net_enable_rx_irq(qp);
+		if (imx_shm_net_rx_avail(qp))
 			napi_schedule(napi);
+		else if (qp->rx.last_used_idx != qp->rx.last_avail_idx)
+			/* nothing tells us when the stack lets go of a frame */
+			mod_timer(&qp->rx_timer, jiffies + 1);
 	}
 
-	if (received)
-		imx_shm_net_notify_rx(in, received);
+	if (returned)
+		imx_shm_net_notify_rx(qp, returned);
 
-	in->stats.rx_packets += received;
-	in->stats.napi_poll_n[received ? 1 + min(ilog2(received), 8) : 0]++;
+	qp->stats.rx_packets += received;
+	qp->stats.napi_poll_n[received ? 1 + min(ilog2(received), 8) : 0]++;
 
-	if (imx_shm_net_tx_ok(in, ndev->mtu))
-		netif_wake_queue(ndev);
+	if (imx_shm_net_tx_ok(qp, imx_shm_net_frame_max(ndev)))
+		netif_wake_subqueue(ndev, qp->index);
 
 	return received;
 }
@@ -578,20 +907,31 @@ static netdev_tx_t imx_shm_net_xmit(struct sk_buff *skb,
 				    struct net_device *ndev)
 {
 	struct imx_shm_net *in = netdev_priv(ndev);
+	struct imx_shm_net_qp *qp = &in->qp[skb_get_queue_mapping(skb)];
 	bool xmit_more = netdev_xmit_more();
+	struct virtio_net_hdr vh, *vhp = NULL;
 
-	imx_shm_net_tx_clean(ndev);
+	if (in->features & IMX_SHM_NET_F_VNET_HDR) {
+		if (virtio_net_hdr_from_skb(skb, &vh, true, true, 0)) {
+			ndev->stats.tx_dropped++;
+			dev_kfree_skb_any(skb);
+			return NETDEV_TX_OK;
+		}
+		vhp = &vh;
+	}
+
+	imx_shm_net_tx_clean(ndev, qp);
 
-	if (!imx_shm_net_tx_ok(in, ndev->mtu)) {
-		imx_shm_net_enable_tx_irq(in);
-		netif_stop_queue(ndev);
+	if (!imx_shm_net_tx_ok(qp, imx_shm_net_frame_max(ndev))) {
+		imx_shm_net_enable_tx_irq(qp);
+		netif_stop_subqueue(ndev, qp->index);
 		xmit_more = false;
-		in->stats.tx_pause++;
+		qp->stats.tx_pause++;
 	}
 
-	imx_shm_net_tx_frame(ndev, skb, xmit_more);
+	imx_shm_net_tx_frame(qp, skb, vhp, xmit_more);
 
-	in->stats.tx_packets++;
+	qp->stats.tx_packets++;
 	ndev->stats.tx_packets++;
 	ndev->stats.tx_bytes += skb->len;
 
@@ -614,9 +954,18 @@ static void imx_shm_net_set_state(struct imx_shm_net *in, u32 state)
 			__func__, ret);
 }
 
+static void imx_shm_net_schedule(struct imx_shm_net *in, unsigned long mask)
+{
+	unsigned int q;
+
+	for_each_set_bit(q, &mask, in->num_queues)
+		napi_schedule_irqoff(&in->qp[q].napi);
+}
+
 static void imx_shm_net_run(struct net_device *ndev)
 {
 	struct imx_shm_net *in = netdev_priv(ndev);
+	unsigned int q;
 
 	if (in->regs.lstate < IMX_SHM_NET_STATE_READY)
 		return;
@@ -627,30 +976,67 @@ static void imx_shm_net_run(struct net_device *ndev)
 	if (test_and_set_bit(IMX_SHM_NET_FLAG_RUN, &in->flags))
 		return;
 
-	netif_start_queue(ndev);
-	napi_enable(&in->napi);
-	napi_schedule(&in->napi);
+	netif_tx_start_all_queues(ndev);
+	for (q = 0; q < in->num_queues; q++) {
+		napi_enable(&in->qp[q].napi);
+		napi_schedule(&in->qp[q].napi);
+	}
 	imx_shm_net_set_state(in, IMX_SHM_NET_STATE_RUN);
 }
 
 static void imx_shm_net_do_stop(struct net_device *ndev)
 {
 	struct imx_shm_net *in = netdev_priv(ndev);
+	unsigned int q;
 
 	imx_shm_net_set_state(in, IMX_SHM_NET_STATE_RESET);
 
 	if (!test_and_clear_bit(IMX_SHM_NET_FLAG_RUN, &in->flags))
 		return;
 
-	netif_stop_queue(ndev);
-	napi_disable(&in->napi);
+	netif_tx_stop_all_queues(ndev);
+	for (q = 0; q < in->num_queues; q++) {
+		napi_disable(&in->qp[q].napi);
+		timer_delete_sync(&in->qp[q].rx_timer);
+	}
+}
+
+/* Called in INIT, with the datapath stopped. */
+static void imx_shm_net_negotiate(struct net_device *ndev)
+{
+	struct imx_shm_net *in = netdev_priv(ndev);
+	unsigned int cpu;
+	u32 features;
+	u32 num;
+
+	imx_shm_net_peer_caps(in, &num, &features);
+
+	/* probe checked max_queues, fewer queues are only larger ones */
+	WARN_ON(imx_shm_net_calc_qsize(ndev, num));
+	in->num_queues = num;
+	in->features = features;
+
+	rtnl_lock();
+	netif_set_real_num_queues(ndev, num, num);
+	/* keep flows on the queue of the CPU sending them */
+	if (num > 1)
+		for_each_online_cpu(cpu)
+			netif_set_xps_queue(ndev, cpumask_of(cpu), cpu % num);
+	/* let segments take a quarter of the smallest TX queue */
+	netif_set_tso_max_size(ndev, min_t(u32, GSO_LEGACY_MAX_SIZE,
+					   (in->qsize - IMX_SHM_NET_HDR_SIZE) / 4));
+	netdev_update_features(ndev);
+	rtnl_unlock();
+
+	netdev_dbg(ndev, "%u queue pair(s) of %u descriptors, %u bytes, features %#x\n",
+		   num, in->qlen, in->qsize, features);
 }
 
 static void imx_shm_net_state_change(struct work_struct *work)
 {
 	struct imx_shm_net *in = container_of(work, struct imx_shm_net,
 			state_work);
-	struct net_device *ndev = in->napi.dev;
+	struct net_device *ndev = platform_get_drvdata(in->pdev);
 	u32 rstate;
 
 	mutex_lock(&in->state_lock);
@@ -672,14 +1058,17 @@ static void imx_shm_net_state_change(struct work_struct *work)
 	case IMX_SHM_NET_STATE_RESET:
 		/* Wait for the remote to leave READY/RUN */
 		/* before transitioning to INIT. */
-		if (rstate < IMX_SHM_NET_STATE_READY)
+		if (rstate < IMX_SHM_NET_STATE_READY) {
+			imx_shm_net_advertise(in);
 			imx_shm_net_set_state(in, IMX_SHM_NET_STATE_INIT);
+		}
 		break;
 
 	case IMX_SHM_NET_STATE_INIT:
 		/* Wait for the remote to leave RESET before performing the */
 		/* initialization and moving to READY. */
 		if (rstate > IMX_SHM_NET_STATE_RESET) {
+			imx_shm_net_negotiate(ndev);
 			imx_shm_net_init_queues(ndev);
 			imx_shm_net_set_state(in, IMX_SHM_NET_STATE_READY);
 
@@ -693,6 +1082,16 @@ static void imx_shm_net_state_change(struct work_struct *work)
 		/* Link is up and we are running */
 		/* once the remote is in READY or RUN. */
 		if (rstate >= IMX_SHM_NET_STATE_READY) {
+			u32 num, features;
+
+			/* A peer that went through INIT without advertising */
+			/* has wiped a stale advertisement by now: start over. */
+			imx_shm_net_peer_caps(in, &num, &features);
+			if (num != in->num_queues || features != in->features) {
+				netdev_warn(ndev, "peer capabilities changed\n");
+				imx_shm_net_set_state(in, IMX_SHM_NET_STATE_RESET);
+				break;
+			}
 			netif_carrier_on(ndev);
 			imx_shm_net_run(ndev);
 			break;
@@ -718,7 +1117,7 @@ static void imx_shm_net_check_state(struct net_device *ndev)
 	struct imx_shm_net *in = netdev_priv(ndev);
 	u32 rstate;
 
-	/* for now message carries only the rstate value */
+	/* queue kicks were stripped off by imx_shm_rx_callback() */
 	rstate = in->remote_message;
 
 	if (rstate != in->regs.rstate ||
@@ -751,24 +1150,33 @@ static int imx_shm_net_stop(struct net_device *ndev)
 static int imx_shm_net_change_mtu(struct net_device *ndev, int mtu)
 {
 	struct imx_shm_net *in = netdev_priv(ndev);
-	struct imx_shm_net_queue *tx = &in->tx;
+	struct imx_shm_net_queue *tx;
+	unsigned int q;
 
 	if (mtu < IMX_SHM_NET_MTU_MIN || mtu > IMX_SHM_NET_MTU_MAX)
 		return -EINVAL;
 
-	if (in->tx.size / mtu < 4)
-		return -EINVAL;
+	/* the last queue is the smallest one, check it first */
+	for (q = in->num_queues; q-- > 0;) {
+		tx = &in->qp[q].tx;
+
+		if (tx->size / mtu < 4)
+			return -EINVAL;
 
-	if (imx_shm_net_tx_space(in) < 2 * IMX_SHM_NET_FRAME_SIZE(mtu))
-		return -EBUSY;
+		if (imx_shm_net_tx_space(tx) < 2 * IMX_SHM_NET_FRAME_SIZE(mtu))
+			return -EBUSY;
 
-	if (in->tx.size - tx->head < IMX_SHM_NET_FRAME_SIZE(mtu) &&
-	    tx->head < tx->tail)
-		return -EBUSY;
+		if (tx->size - tx->head < IMX_SHM_NET_FRAME_SIZE(mtu) &&
+		    tx->head < tx->tail)
+			return -EBUSY;
+	}
 
 	netif_tx_lock_bh(ndev);
-	if (in->tx.size - tx->head < IMX_SHM_NET_FRAME_SIZE(mtu))
-		tx->head = 0;
+	for (q = 0; q < in->num_queues; q++) {
+		tx = &in->qp[q].tx;
+		if (tx->size - tx->head < IMX_SHM_NET_FRAME_SIZE(mtu))
+			tx->head = 0;
+	}
 	netif_tx_unlock_bh(ndev);
 
 	ndev->mtu = mtu;
@@ -776,12 +1184,26 @@ static int imx_shm_net_change_mtu(struct net_device *ndev, int mtu)
 	return 0;
 }
 
+static netdev_features_t imx_shm_net_fix_features(struct net_device *ndev,
+						  netdev_features_t features)
+{
+	struct imx_shm_net *in = netdev_priv(ndev);
+
+	/* segmentation is left to peers taking virtio-net headers only */
+	if (!(in->features & IMX_SHM_NET_F_VNET_HDR))
+		features &= ~NETIF_F_ALL_TSO;
+
+	return features;
+}
+
 #ifdef CONFIG_NET_POLL_CONTROLLER
 static void imx_shm_net_poll_controller(struct net_device *ndev)
 {
 	struct imx_shm_net *in = netdev_priv(ndev);
+	unsigned int q;
 
-	napi_schedule(&in->napi);
+	for (q = 0; q < in->num_queues; q++)
+		napi_schedule(&in->qp[q].napi);
 }
 #endif
 
@@ -790,6 +1212,7 @@ static const struct net_device_ops imx_shm_net_ops = {
 		.ndo_stop		= imx_shm_net_stop,
 		.ndo_start_xmit		= imx_shm_net_xmit,
 		.ndo_change_mtu		= imx_shm_net_change_mtu,
+		.ndo_fix_features	= imx_shm_net_fix_features,
 		.ndo_set_mac_address	= eth_mac_addr,
 		.ndo_validate_addr	= eth_validate_addr,
 #ifdef CONFIG_NET_POLL_CONTROLLER
@@ -801,9 +1224,12 @@ static const char imx_shm_net_stats[][ETH_GSTRING_LEN] = {
 		"interrupts",
 		"tx_packets",
 		"tx_notify",
+		"tx_notify_suppressed",
 		"tx_pause",
 		"rx_packets",
 		"rx_notify",
+		"rx_notify_suppressed",
+		"rx_zerocopy",
 		"napi_poll",
 		"napi_complete",
 		"napi_poll_0",
@@ -820,11 +1246,20 @@ static const char imx_shm_net_stats[][ETH_GSTRING_LEN] = {
 
 #define NUM_STATS ARRAY_SIZE(imx_shm_net_stats)
 
+static const char imx_shm_net_priv_flags[][ETH_GSTRING_LEN] = {
+		"rx-zerocopy",
+};
+
+#define IMX_SHM_NET_PRIV_RX_ZC	BIT(0)
+
 static int imx_shm_net_get_sset_count(struct net_device *ndev, int sset)
 {
 	if (sset == ETH_SS_STATS)
 		return NUM_STATS;
 
+	if (sset == ETH_SS_PRIV_FLAGS)
+		return ARRAY_SIZE(imx_shm_net_priv_flags);
+
 	return -EOPNOTSUPP;
 }
 
@@ -832,28 +1267,70 @@ static void imx_shm_net_get_strings(struct net_device *ndev, u32 sset, u8 *buf)
 {
 	if (sset == ETH_SS_STATS)
 		memcpy(buf, &imx_shm_net_stats, sizeof(imx_shm_net_stats));
+	else if (sset == ETH_SS_PRIV_FLAGS)
+		memcpy(buf, &imx_shm_net_priv_flags,
+		       sizeof(imx_shm_net_priv_flags));
+}
+
+static u32 imx_shm_net_get_priv_flags(struct net_device *ndev)
+{
+	struct imx_shm_net *in = netdev_priv(ndev);
+
+	return test_bit(IMX_SHM_NET_FLAG_RX_ZC, &in->flags) ?
+		IMX_SHM_NET_PRIV_RX_ZC : 0;
+}
+
+/* Frames already lent to the stack are still returned when it is */
+/* done with them, so this can be flipped at any time. */
+static int imx_shm_net_set_priv_flags(struct net_device *ndev, u32 flags)
+{
+	struct imx_shm_net *in = netdev_priv(ndev);
+
+	if (!(flags & IMX_SHM_NET_PRIV_RX_ZC)) {
+		clear_bit(IMX_SHM_NET_FLAG_RX_ZC, &in->flags);
+		return 0;
+	}
+
+	if (!in->rx_zc_capable)
+		return -EOPNOTSUPP;
+
+	set_bit(IMX_SHM_NET_FLAG_RX_ZC, &in->flags);
+
+	return 0;
 }
 
 static void imx_shm_net_get_ethtool_stats(struct net_device *ndev,
 					  struct ethtool_stats *estats, u64 *st)
 {
 	struct imx_shm_net *in = netdev_priv(ndev);
-	unsigned int n = 0;
-	unsigned int i;
-
-	st[n++] = in->stats.interrupts;
-	st[n++] = in->stats.tx_packets;
-	st[n++] = in->stats.tx_notify;
-	st[n++] = in->stats.tx_pause;
-	st[n++] = in->stats.rx_packets;
-	st[n++] = in->stats.rx_notify;
-	st[n++] = in->stats.napi_poll;
-	st[n++] = in->stats.napi_complete;
-
-	for (i = 0; i < ARRAY_SIZE(in->stats.napi_poll_n); i++)
-		st[n++] = in->stats.napi_poll_n[i];
-
-	memset(&in->stats, 0, sizeof(in->stats));
+	struct imx_shm_net_stats *qs;
+	unsigned int n, q, i;
+
+	memset(st, 0, NUM_STATS * sizeof(*st));
+	st[0] = in->interrupts;
+	in->interrupts = 0;
+
+	/* queue pair counters are summed up */
+	for (q = 0; q < in->num_queues; q++) {
+		qs = &in->qp[q].stats;
+		n = 1;
+
+		st[n++] += qs->tx_packets;
+		st[n++] += qs->tx_notify;
+		st[n++] += qs->tx_notify_suppressed;
+		st[n++] += qs->tx_pause;
+		st[n++] += qs->rx_packets;
+		st[n++] += qs->rx_notify;
+		st[n++] += qs->rx_notify_suppressed;
+		st[n++] += qs->rx_zerocopy;
+		st[n++] += qs->napi_poll;
+		st[n++] += qs->napi_complete;
+
+		for (i = 0; i < ARRAY_SIZE(qs->napi_poll_n); i++)
+			st[n++] += qs->napi_poll_n[i];
+
+		memset(qs, 0, sizeof(*qs));
+	}
 }
 
 #define IMX_SHM_NET_REGS_LEN	(3 * sizeof(u32) + 6 * sizeof(u16))
@@ -867,6 +1344,7 @@ static void imx_shm_net_get_regs(struct net_device *ndev,
 				 struct ethtool_regs *regs, void *p)
 {
 	struct imx_shm_net *in = netdev_priv(ndev);
+	struct imx_shm_net_qp *qp = &in->qp[0];
 	u32 *reg32 = p;
 	u16 *reg16;
 
@@ -876,13 +1354,13 @@ static void imx_shm_net_get_regs(struct net_device *ndev,
 
 	reg16 = (u16 *)reg32;
 
-	*reg16++ = in->tx.vr.avail ? in->tx.vr.avail->idx : 0;
-	*reg16++ = in->tx.vr.used ? in->tx.vr.used->idx : 0;
-	*reg16++ = in->tx.vr.avail ? vring_avail_event(&in->tx.vr) : 0;
+	*reg16++ = qp->tx.vr.avail ? qp->tx.vr.avail->idx : 0;
+	*reg16++ = qp->tx.vr.used ? qp->tx.vr.used->idx : 0;
+	*reg16++ = qp->tx.vr.avail ? vring_avail_event(&qp->tx.vr) : 0;
 
-	*reg16++ = in->rx.vr.avail ? in->rx.vr.avail->idx : 0;
-	*reg16++ = in->rx.vr.used ? in->rx.vr.used->idx : 0;
-	*reg16++ = in->rx.vr.avail ? vring_avail_event(&in->rx.vr) : 0;
+	*reg16++ = qp->rx.vr.avail ? qp->rx.vr.avail->idx : 0;
+	*reg16++ = qp->rx.vr.used ? qp->rx.vr.used->idx : 0;
+	*reg16++ = qp->rx.vr.avail ? vring_avail_event(&qp->rx.vr) : 0;
 }
 
 static int imx_shm_partition_notify(struct notifier_block *nb,
@@ -911,7 +1389,7 @@ static int imx_shm_partition_notify(struct notifier_block *nb,
 			ndev = platform_get_drvdata(in->pdev);
 
 			imx_shm_net_check_state(ndev);
-			napi_schedule_irqoff(&in->napi);
+			imx_shm_net_schedule(in, ~0UL);
 
 			dev_info(&in->pdev->dev, "Partition %d reset!\n",
 				 in->mub_partition);
@@ -927,12 +1405,13 @@ static void imx_shm_rx_callback(struct mbox_client *c, void *msg)
 	struct imx_shm_net *isndev = container_of(c,
 			struct imx_shm_net, cl);
 	struct net_device *ndev = platform_get_drvdata(isndev->pdev);
+	unsigned long kick = *data >> IMX_SHM_NET_MSG_QUEUE_SHIFT;
 
-	isndev->stats.interrupts++;
+	isndev->interrupts++;
 
 	/* get message from receive buffer */
 	mutex_lock(&isndev->state_lock);
-	isndev->remote_message = *data;
+	isndev->remote_message = *data & IMX_SHM_NET_MSG_STATE_MASK;
 	if (isndev->message_state == MESS_STATE_NEW)
 		dev_dbg(&isndev->pdev->dev, "RX message overwritten while not yet processed!");
 	isndev->message_state = MESS_STATE_NEW;
@@ -940,7 +1419,8 @@ static void imx_shm_rx_callback(struct mbox_client *c, void *msg)
 	imx_shm_net_check_state(ndev);
 	mutex_unlock(&isndev->state_lock);
 
-	napi_schedule_irqoff(&isndev->napi);
+	/* state changes and single queue peers kick all queues */
+	imx_shm_net_schedule(isndev, kick ?: ~0UL);
 }
 
 static int imx_shm_xtr_channel_init(struct imx_shm_net *isndev)
@@ -1023,12 +1503,35 @@ static int mu_enable_reset_irq(struct net_device *ndev)
 	return 0;
 }
 
+/* none of the shared memory pages is referenced beyond the allocation */
+static bool imx_shm_net_shm_unused(struct imx_shm_net *in)
+{
+	resource_size_t off;
+
+	for (off = 0; off < in->shmlen; off += PAGE_SIZE)
+		if (page_ref_count(virt_to_page(in->shm + off)) != 1)
+			return false;
+
+	return true;
+}
+
+/* Lending RX buffers to the stack needs the shared memory in the linear */
+/* map, each page refcounted on its own, as CMA hands them out. */
+static bool imx_shm_net_rx_zc_capable(struct imx_shm_net *in)
+{
+	return virt_addr_valid(in->shm) &&
+		virt_addr_valid(in->shm + in->shmlen - 1) &&
+		imx_shm_net_shm_unused(in);
+}
+
 static const struct ethtool_ops imx_shm_net_ethtool_ops = {
 		.get_sset_count		= imx_shm_net_get_sset_count,
 		.get_strings		= imx_shm_net_get_strings,
 		.get_ethtool_stats	= imx_shm_net_get_ethtool_stats,
 		.get_regs_len		= imx_shm_net_get_regs_len,
 		.get_regs		= imx_shm_net_get_regs,
+		.get_priv_flags		= imx_shm_net_get_priv_flags,
+		.set_priv_flags		= imx_shm_net_set_priv_flags,
 };
 
 static int imx_shm_net_probe(struct platform_device *pdev)
@@ -1039,9 +1542,11 @@ static int imx_shm_net_probe(struct platform_device *pdev)
 	resource_size_t shmlen;
 	char *device_name;
 	void *shm = NULL;
+	u32 max_queues;
 	u32 ivpos;
 	int ret;
 	char dev_addr[6];
+	unsigned int q;
 
 	/* check if 1st probe or another attempt after EAGAIN */
 	if (pdev->dev.driver_data) {
@@ -1058,6 +1563,13 @@ static int imx_shm_net_probe(struct platform_device *pdev)
 		dev_info(&pdev->dev, "queue position is TX first\n");
 	}
 
+	/* 0 means one queue pair per CPU, the peer may still offer fewer */
+	if (of_property_read_u32(pdev->dev.of_node, "num-queues", &max_queues))
+		max_queues = 1;
+	else if (!max_queues)
+		max_queues = num_online_cpus();
+	max_queues = clamp_t(u32, max_queues, 1, IMX_SHM_NET_MAX_QUEUES);
+
 	/* get shared coherent memory for buffers */
 	if (of_reserved_mem_device_init(&pdev->dev)) {
 		dev_err(&pdev->dev,
@@ -1080,7 +1592,7 @@ static int imx_shm_net_probe(struct platform_device *pdev)
 		goto err_free_dma;
 	}
 
-	ndev = alloc_etherdev(sizeof(*in));
+	ndev = alloc_etherdev_mqs(sizeof(*in), max_queues, max_queues);
 	if (!ndev) {
 		ret = -ENOMEM;
 		goto err_free_dma;
@@ -1102,11 +1614,30 @@ static int imx_shm_net_probe(struct platform_device *pdev)
 	in->regs.ivpos = ivpos;
 	in->regs.rstate = IMX_SHM_NET_STATE_RESET;
 	in->remote_message = IMX_SHM_NET_STATE_RESET;
-	spin_lock_init(&in->tx_free_lock);
-	spin_lock_init(&in->tx_clean_lock);
+	in->max_queues = max_queues;
+	in->num_queues = 1;
 	mutex_init(&in->state_lock);
 
-	ret = imx_shm_net_calc_qsize(ndev);
+	for (q = 0; q < max_queues; q++) {
+		in->qp[q].in = in;
+		in->qp[q].index = q;
+		spin_lock_init(&in->qp[q].tx_free_lock);
+		spin_lock_init(&in->qp[q].tx_clean_lock);
+		timer_setup(&in->qp[q].rx_timer, imx_shm_net_rx_timer, 0);
+	}
+
+	in->rx_zc_capable = imx_shm_net_rx_zc_capable(in);
+	if (in->rx_zc_capable)
+		set_bit(IMX_SHM_NET_FLAG_RX_ZC, &in->flags);
+	else
+		dev_info(&pdev->dev, "shared memory not page backed, RX copies frames\n");
+
+	/* size for the worst case, negotiating fewer queues enlarges them */
+	ret = imx_shm_net_calc_qsize(ndev, max_queues);
+	if (ret)
+		goto err_free;
+
+	ret = netif_set_real_num_queues(ndev, 1, 1);
 	if (ret)
 		goto err_free;
 
@@ -1123,16 +1654,23 @@ static int imx_shm_net_probe(struct platform_device *pdev)
 	ndev->netdev_ops = &imx_shm_net_ops;
 	ndev->ethtool_ops = &imx_shm_net_ethtool_ops;
 	ndev->mtu = min_t(u32, IMX_SHM_NET_MTU_DEF, in->qsize / 16);
-	ndev->hw_features = NETIF_F_HW_CSUM | NETIF_F_SG;
+	ndev->hw_features = NETIF_F_HW_CSUM | NETIF_F_SG |
+			    NETIF_F_TSO | NETIF_F_TSO6 | NETIF_F_TSO_ECN;
 	ndev->features = ndev->hw_features;
 
 	netif_carrier_off(ndev);
-	netif_napi_add(ndev, &in->napi, imx_shm_net_poll);
+	for (q = 0; q < max_queues; q++)
+		netif_napi_add(ndev, &in->qp[q].napi, imx_shm_net_poll);
 
 	ret = register_netdev(ndev);
 	if (ret)
 		goto err_wq;
 
+	/* All queues are kicked from the MU interrupt, on one CPU: let the */
+	/* scheduler spread their NAPI pollers instead. */
+	if (max_queues > 1)
+		dev_set_threaded(ndev, true);
+
 	/* initialize Mailbox for RX/TX */
 	ret = imx_shm_xtr_channel_init(in);
 	if (ret) {
@@ -1194,7 +1732,7 @@ static void imx_shm_net_remove(struct platform_device *pdev)
 {
 	struct net_device *ndev = platform_get_drvdata(pdev);
 	struct imx_shm_net *in = netdev_priv(ndev);
-	int ret;
+	int ret, i;
 
 	/* notify reset */
 	in->regs.lstate = IMX_SHM_NET_STATE_RESET;
@@ -1210,14 +1748,24 @@ static void imx_shm_net_remove(struct platform_device *pdev)
 
 	imx_scu_irq_unregister_notifier(&in->pnotifier);
 
-	dma_free_coherent(&pdev->dev, in->shmlen, in->shm, in->shmaddr);
-
 	/* remove imx_shm_net's node from list */
 	list_del(&in->isn_node);
 
 	unregister_netdev(ndev);
 	cancel_work_sync(&in->state_work);
 	destroy_workqueue(in->state_wq);
+
+	/* RX frames lent to the stack may still sit in socket queues */
+	for (i = 0; in->rx_zc_capable && !imx_shm_net_shm_unused(in); i++) {
+		if (i == 500) {
+			dev_warn(&pdev->dev, "shared memory still in use, leaking it\n");
+			goto out;
+		}
+		msleep(10);
+	}
+
+	dma_free_coherent(&pdev->dev, in->shmlen, in->shm, in->shmaddr);
+out:
 	free_netdev(ndev);
 }
 
@@ -12,6 +12,7 @@
 #include <linux/idr.h>
 #include <linux/init.h>
 #include <linux/kref.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/nvmem-consumer.h>
 #include <linux/nvmem-provider.h>
@@ -21,6 +22,9 @@
 
 #include "internals.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/nvmem.h>
+
 #define to_nvmem_device(d) container_of(d, struct nvmem_device, dev)
 
 #define FLAG_COMPAT		BIT(0)
@@ -58,10 +62,21 @@ static BLOCKING_NOTIFIER_HEAD(nvmem_notifier);
 static int __nvmem_reg_read(struct nvmem_device *nvmem, unsigned int offset,
 			    void *val, size_t bytes)
 {
-	if (nvmem->reg_read)
+	u64 start;
+	int ret;
+
+	if (!nvmem->reg_read)
+		return -EINVAL;
+
+	if (!trace_nvmem_reg_read_enabled())
 		return nvmem->reg_read(nvmem->priv, offset, val, bytes);
 
-	return -EINVAL;
+	start = ktime_get_ns();
+	ret = nvmem->reg_read(nvmem->priv, offset, val, bytes);
+	trace_nvmem_reg_read(dev_name(&nvmem->dev), offset, bytes, ret,
+			     ktime_get_ns() - start);
+
+	return ret;
 }
 
 static int __nvmem_reg_write(struct nvmem_device *nvmem, unsigned int offset,
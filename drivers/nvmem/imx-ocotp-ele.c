@@ -42,72 +42,49 @@ struct imx_ocotp_priv {
 	struct nvmem_config config;
 	struct mutex lock;
 	const struct ocotp_devtype_data *data;
+	/* shadow of the whole fuse array, read once at probe */
+	u32 *cache;
 };
 
-static enum fuse_type imx_ocotp_fuse_type(void *context, u32 index)
+static void imx_ocotp_fill_cache(struct imx_ocotp_priv *priv)
 {
-	struct imx_ocotp_priv *priv = context;
+	void __iomem *reg = priv->base + priv->data->reg_off;
 	const struct ocotp_devtype_data *data = priv->data;
-	u32 start, end;
-	int i;
+	const struct ocotp_map_entry *entry;
+	u32 i, j;
+
+	/* Everything outside the FSB entries reads back as zero. */
+	memset(priv->cache, 0, data->size);
 
 	for (i = 0; i < data->num_entry; i++) {
-		start = data->entry[i].start;
-		end = data->entry[i].start + data->entry[i].num;
+		entry = &data->entry[i];
+		if (!(entry->type & FUSE_FSB))
+			continue;
 
-		if (index >= start && index < end)
-			return data->entry[i].type;
+		for (j = entry->start; j < entry->start + entry->num; j++) {
+			if (entry->type & FUSE_ECC)
+				priv->cache[j] = readl_relaxed(reg + (j << 2)) &
+						 GENMASK(15, 0);
+			else
+				priv->cache[j] = readl_relaxed(reg + (j << 2));
+		}
 	}
-
-	return FUSE_INVALID;
 }
 
 static int imx_ocotp_reg_read(void *context, unsigned int offset, void *val, size_t bytes)
 {
 	struct imx_ocotp_priv *priv = context;
-	void __iomem *reg = priv->base + priv->data->reg_off;
-	u32 count, index, num_bytes;
-	enum fuse_type type;
-	u32 *buf;
-	void *p;
-	int i;
-	u8 skipbytes;
+
+	if (offset >= priv->data->size)
+		return -EINVAL;
 
 	if (offset + bytes > priv->data->size)
 		bytes = priv->data->size - offset;
 
-	index = offset >> 2;
-	skipbytes = offset - (index << 2);
-	num_bytes = round_up(bytes + skipbytes, 4);
-	count = num_bytes >> 2;
-
-	p = kzalloc(num_bytes, GFP_KERNEL);
-	if (!p)
-		return -ENOMEM;
-
 	mutex_lock(&priv->lock);
-
-	buf = p;
-
-	for (i = index; i < (index + count); i++) {
-		type = imx_ocotp_fuse_type(context, i);
-		if (type == FUSE_INVALID || type == FUSE_ELE) {
-			*buf++ = 0;
-			continue;
-		}
-
-		if (type & FUSE_ECC)
-			*buf++ = readl_relaxed(reg + (i << 2)) & GENMASK(15, 0);
-		else
-			*buf++ = readl_relaxed(reg + (i << 2));
-	}
-
-	memcpy(val, ((u8 *)p) + skipbytes, bytes);
-
+	memcpy(val, (u8 *)priv->cache + offset, bytes);
 	mutex_unlock(&priv->lock);
 
-	kfree(p);
-
 	return 0;
 };
 
@@ -147,6 +124,12 @@ static int imx_ele_ocotp_probe(struct platform_device *pdev)
 	if (IS_ERR(priv->base))
 		return PTR_ERR(priv->base);
 
+	priv->cache = devm_kzalloc(dev, priv->data->size, GFP_KERNEL);
+	if (!priv->cache)
+		return -ENOMEM;
+
+	imx_ocotp_fill_cache(priv);
+
 	priv->config.dev = dev;
 	priv->config.name = "ELE-OCOTP";
 	priv->config.id = NVMEM_DEVID_AUTO;
@@ -62,13 +62,7 @@ struct imx_fsb_s400_fuse {
 static int read_words_via_s400_api(u32 *buf, unsigned int fuse_base,
 				   unsigned int num, void *se_data)
 {
-	unsigned int i;
-	int err = 0;
-
-	for (i = 0; i < num; i++)
-		err = imx_se_read_fuse(se_data, fuse_base + i, buf + i);
-
-	return err;
+	return imx_se_read_fuses(se_data, fuse_base, num, buf);
 }
 
 static int read_words_via_fsb(void *priv, unsigned int bank, u32 *buf)
@@ -8,6 +8,7 @@
  */
 
 #include <linux/arm-smccc.h>
+#include <linux/bitmap.h>
 #include <linux/firmware/imx/sci.h>
 #include <linux/module.h>
 #include <linux/nvmem-provider.h>
@@ -42,6 +43,9 @@ struct ocotp_priv {
 	struct device *dev;
 	const struct ocotp_devtype_data *data;
 	struct imx_sc_ipc *nvmem_ipc;
+	/* fuse words already read from the SCU, under scu_ocotp_mutex */
+	u32 *cache;
+	unsigned long *cached;
 };
 
 struct imx_sc_msg_misc_fuse_read {
@@ -139,6 +143,9 @@ static int imx_scu_ocotp_read(void *context, unsigned int offset,
 	int i, ret;
 
 	index = offset;
+	if (index >= priv->data->nregs)
+		return -EINVAL;
+
 	num_bytes = round_up(bytes, 4);
 	count = num_bytes >> 2;
 
@@ -159,13 +166,17 @@ static int imx_scu_ocotp_read(void *context, unsigned int offset,
 			continue;
 		}
 
-		ret = imx_sc_misc_otp_fuse_read(priv->nvmem_ipc, i, buf);
-		if (ret) {
-			mutex_unlock(&scu_ocotp_mutex);
-			kfree(p);
-			return ret;
+		if (!test_bit(i, priv->cached)) {
+			ret = imx_sc_misc_otp_fuse_read(priv->nvmem_ipc, i,
+							&priv->cache[i]);
+			if (ret) {
+				mutex_unlock(&scu_ocotp_mutex);
+				kfree(p);
+				return ret;
+			}
+			__set_bit(i, priv->cached);
 		}
-		buf++;
+		*buf++ = priv->cache[i];
 	}
 
 	memcpy(val, (u8 *)p, bytes);
@@ -192,6 +203,8 @@ static int imx_scu_ocotp_write(void *context, unsigned int offset,
 		return -EINVAL;
 
 	index = offset;
+	if (index >= priv->data->nregs)
+		return -EINVAL;
 
 	if (in_hole(context, index))
 		return -EINVAL;
@@ -213,6 +226,9 @@ static int imx_scu_ocotp_write(void *context, unsigned int offset,
 
 	arm_smccc_smc(IMX_SIP_OTP_WRITE, index, *buf, 0, 0, 0, 0, 0, &res);
 
+	/* Read the word back from the SCU next time, even if this failed */
+	__clear_bit(index, priv->cached);
+
 	mutex_unlock(&scu_ocotp_mutex);
 
 	return res.a0;
@@ -253,6 +269,13 @@ static int imx_scu_ocotp_probe(struct platform_device *pdev)
 
 	priv->data = of_device_get_match_data(dev);
 	priv->dev = dev;
+
+	priv->cache = devm_kcalloc(dev, priv->data->nregs, sizeof(u32),
+				   GFP_KERNEL);
+	priv->cached = devm_bitmap_zalloc(dev, priv->data->nregs, GFP_KERNEL);
+	if (!priv->cache || !priv->cached)
+		return -ENOMEM;
+
 	imx_scu_ocotp_nvmem_config.size = 4 * priv->data->nregs;
 	imx_scu_ocotp_nvmem_config.dev = dev;
 	imx_scu_ocotp_nvmem_config.priv = priv;
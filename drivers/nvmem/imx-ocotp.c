@@ -83,6 +83,8 @@ struct ocotp_priv {
 	void __iomem *base;
 	const struct ocotp_params *params;
 	struct nvmem_config *config;
+	/* shadow registers of all the fuse words, read at probe */
+	u32 *cache;
 };
 
 struct ocotp_ctrl_reg {
@@ -155,6 +157,40 @@ static void imx_ocotp_clr_err_if_set(struct ocotp_priv *priv)
 	writel(bm_ctrl_error, base + IMX_OCOTP_ADDR_CTRL_CLR);
 }
 
+static u32 imx_ocotp_read_shadow(struct ocotp_priv *priv, u32 index)
+{
+	u32 val;
+
+	val = readl(priv->base + IMX_OCOTP_OFFSET_B0W0 +
+		    index * IMX_OCOTP_OFFSET_PER_WORD);
+
+	/* 47.3.1.2
+	 * For "read locked" registers 0xBADABADA will be returned and
+	 * HW_OCOTP_CTRL[ERROR] will be set. It must be cleared by
+	 * software before any new write, read or reload access can be
+	 * issued
+	 */
+	if (val == IMX_OCOTP_READ_LOCKED_VAL)
+		imx_ocotp_clr_err_if_set(priv);
+
+	return val;
+}
+
+static int imx_ocotp_fill_cache(struct ocotp_priv *priv)
+{
+	unsigned int i;
+	int ret;
+
+	ret = imx_ocotp_wait_for_busy(priv, 0);
+	if (ret < 0)
+		return ret;
+
+	for (i = 0; i < priv->params->nregs; i++)
+		priv->cache[i] = imx_ocotp_read_shadow(priv, i);
+
+	return 0;
+}
+
 static int imx_ocotp_read(void *context, unsigned int offset,
 			  void *val, size_t bytes)
 {
@@ -164,6 +200,20 @@ static int imx_ocotp_read(void *context, unsigned int offset,
 	int i, ret;
 	u32 index, num_bytes;
 
+	if (priv->cache) {
+		if (offset >= priv->config->size)
+			return -EINVAL;
+
+		if (offset + bytes > priv->config->size)
+			bytes = priv->config->size - offset;
+
+		mutex_lock(&ocotp_mutex);
+		memcpy(val, (u8 *)priv->cache + offset, bytes);
+		mutex_unlock(&ocotp_mutex);
+
+		return 0;
+	}
+
 	index = offset >> 2;
 	num_bytes = round_up((offset % 4) + bytes, 4);
 	count = num_bytes >> 2;
@@ -194,18 +244,7 @@ static int imx_ocotp_read(void *context, unsigned int offset,
 	}
 
 	for (i = index; i < (index + count); i++) {
-		*(u32 *)buf = readl(priv->base + IMX_OCOTP_OFFSET_B0W0 +
-			       i * IMX_OCOTP_OFFSET_PER_WORD);
-
-		/* 47.3.1.2
-		 * For "read locked" registers 0xBADABADA will be returned and
-		 * HW_OCOTP_CTRL[ERROR] will be set. It must be cleared by
-		 * software before any new write, read or reload access can be
-		 * issued
-		 */
-		if (*((u32 *)buf) == IMX_OCOTP_READ_LOCKED_VAL)
-			imx_ocotp_clr_err_if_set(priv);
-
+		*(u32 *)buf = imx_ocotp_read_shadow(priv, i);
 		buf += 4;
 	}
 
@@ -313,6 +352,7 @@ static int imx_ocotp_write(void *context, unsigned int offset, void *val,
 {
 	struct ocotp_priv *priv = context;
 	u32 *buf = val;
+	u32 index;
 	int ret;
 
 	u32 ctrl;
@@ -324,6 +364,8 @@ static int imx_ocotp_write(void *context, unsigned int offset, void *val,
 	    (offset % priv->config->word_size))
 		return -EINVAL;
 
+	index = offset >> 2;
+
 	mutex_lock(&ocotp_mutex);
 
 	ret = clk_prepare_enable(priv->clk);
@@ -470,6 +512,8 @@ static int imx_ocotp_write(void *context, unsigned int offset, void *val,
 				      priv->params->ctrl.bm_rel_shadows);
 	if (ret < 0)
 		dev_err(priv->dev, "timeout during shadow register reload\n");
+	else if (priv->cache)
+		priv->cache[index] = imx_ocotp_read_shadow(priv, index);
 
 write_end:
 	release_bus_freq(BUS_FREQ_HIGH);
@@ -623,8 +667,18 @@ static int imx_ocotp_probe(struct platform_device *pdev)
 
 	priv->config = &imx_ocotp_nvmem_config;
 
+	priv->cache = devm_kcalloc(dev, priv->params->nregs, sizeof(u32),
+				   GFP_KERNEL);
+	if (!priv->cache)
+		return -ENOMEM;
+
 	clk_prepare_enable(priv->clk);
 	imx_ocotp_clr_err_if_set(priv);
+	if (imx_ocotp_fill_cache(priv)) {
+		dev_warn(dev, "can't cache the fuses, reading them on demand\n");
+		devm_kfree(dev, priv->cache);
+		priv->cache = NULL;
+	}
 	clk_disable_unprepare(priv->clk);
 
 	nvmem = devm_nvmem_register(dev, &imx_ocotp_nvmem_config);
@@ -10,6 +10,7 @@
 #include <linux/delay.h>
 #include <linux/dmaengine.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/pci_ids.h>
@@ -44,20 +45,30 @@
 
 #define TIMER_RESOLUTION		1
 
+/* DMA channels a transfer can be split across */
+#define MAX_DMA_CHANS			8
+/* Alignment of the part of a transfer each DMA channel moves */
+#define DMA_CHUNK_ALIGN			64
+
 static struct workqueue_struct *kpcitest_workqueue;
 
+struct pci_epf_test_xfer {
+	struct dma_chan		*chan;
+	dma_cookie_t		cookie;
+	enum dma_status		status;
+	struct completion	complete;
+};
+
 struct pci_epf_test {
 	void			*reg[PCI_STD_NUM_BARS];
 	struct pci_epf		*epf;
 	enum pci_barno		test_reg_bar;
 	size_t			msix_table_offset;
 	struct delayed_work	cmd_handler;
-	struct dma_chan		*dma_chan_tx;
-	struct dma_chan		*dma_chan_rx;
-	struct dma_chan		*transfer_chan;
-	dma_cookie_t		transfer_cookie;
-	enum dma_status		transfer_status;
-	struct completion	transfer_complete;
+	struct dma_chan		*dma_chan_tx[MAX_DMA_CHANS];
+	struct dma_chan		*dma_chan_rx[MAX_DMA_CHANS];
+	unsigned int		num_dma_chans;
+	struct pci_epf_test_xfer xfer[MAX_DMA_CHANS];
 	bool			dma_supported;
 	bool			dma_private;
 	const struct pci_epc_features *epc_features;
@@ -74,6 +85,17 @@ struct pci_epf_test_reg {
 	u32	irq_type;
 	u32	irq_number;
 	u32	flags;
+	/*
+	 * Benchmark modes of the READ, WRITE and COPY commands, ignored when
+	 * zero: the DMA channels to split each transfer across, and the
+	 * times to repeat it.  Returns the time of all the transfers, and
+	 * of the fastest and slowest one, without their setup.
+	 */
+	u32	dma_chans;
+	u32	iterations;
+	u64	elapsed_ns;
+	u64	min_ns;
+	u64	max_ns;
 } __packed;
 
 static struct pci_epf_header test_header = {
@@ -87,55 +109,28 @@ static size_t bar_size[] = { 512, 512, 1024, 16384, 131072, 1048576 };
 
 static void pci_epf_test_dma_callback(void *param)
 {
-	struct pci_epf_test *epf_test = param;
+	struct pci_epf_test_xfer *xfer = param;
 	struct dma_tx_state state;
 
-	epf_test->transfer_status =
-		dmaengine_tx_status(epf_test->transfer_chan,
-				    epf_test->transfer_cookie, &state);
-	if (epf_test->transfer_status == DMA_COMPLETE ||
-	    epf_test->transfer_status == DMA_ERROR)
-		complete(&epf_test->transfer_complete);
+	xfer->status = dmaengine_tx_status(xfer->chan, xfer->cookie, &state);
+	if (xfer->status == DMA_COMPLETE || xfer->status == DMA_ERROR)
+		complete(&xfer->complete);
 }
 
-/**
- * pci_epf_test_data_transfer() - Function that uses dmaengine API to transfer
- *				  data between PCIe EP and remote PCIe RC
- * @epf_test: the EPF test device that performs the data transfer operation
- * @dma_dst: The destination address of the data transfer. It can be a physical
- *	     address given by pci_epc_mem_alloc_addr or DMA mapping APIs.
- * @dma_src: The source address of the data transfer. It can be a physical
- *	     address given by pci_epc_mem_alloc_addr or DMA mapping APIs.
- * @len: The size of the data transfer
- * @dma_remote: remote RC physical address
- * @dir: DMA transfer direction
- *
- * Function that uses dmaengine API to transfer data between PCIe EP and remote
- * PCIe RC. The source and destination address can be a physical address given
- * by pci_epc_mem_alloc_addr or the one obtained using DMA mapping APIs.
- *
- * The function returns '0' on success and negative value on failure.
- */
-static int pci_epf_test_data_transfer(struct pci_epf_test *epf_test,
-				      dma_addr_t dma_dst, dma_addr_t dma_src,
-				      size_t len, dma_addr_t dma_remote,
-				      enum dma_transfer_direction dir)
+static int pci_epf_test_submit_chunk(struct pci_epf_test *epf_test,
+				     struct pci_epf_test_xfer *xfer,
+				     dma_addr_t dma_dst, dma_addr_t dma_src,
+				     size_t len, dma_addr_t dma_remote,
+				     enum dma_transfer_direction dir)
 {
-	struct dma_chan *chan = (dir == DMA_MEM_TO_DEV) ?
-				 epf_test->dma_chan_tx : epf_test->dma_chan_rx;
 	dma_addr_t dma_local = (dir == DMA_MEM_TO_DEV) ? dma_src : dma_dst;
 	enum dma_ctrl_flags flags = DMA_CTRL_ACK | DMA_PREP_INTERRUPT;
-	struct pci_epf *epf = epf_test->epf;
+	struct device *dev = &epf_test->epf->dev;
 	struct dma_async_tx_descriptor *tx;
 	struct dma_slave_config sconf = {};
-	struct device *dev = &epf->dev;
+	struct dma_chan *chan = xfer->chan;
 	int ret;
 
-	if (IS_ERR_OR_NULL(chan)) {
-		dev_err(dev, "Invalid DMA memcpy channel\n");
-		return -EINVAL;
-	}
-
 	if (epf_test->dma_private) {
 		sconf.direction = dir;
 		if (dir == DMA_MEM_TO_DEV)
@@ -159,32 +154,95 @@ static int pci_epf_test_data_transfer(struct pci_epf_test *epf_test,
 		return -EIO;
 	}
 
-	reinit_completion(&epf_test->transfer_complete);
-	epf_test->transfer_chan = chan;
+	reinit_completion(&xfer->complete);
 	tx->callback = pci_epf_test_dma_callback;
-	tx->callback_param = epf_test;
-	epf_test->transfer_cookie = dmaengine_submit(tx);
+	tx->callback_param = xfer;
+	xfer->cookie = dmaengine_submit(tx);
 
-	ret = dma_submit_error(epf_test->transfer_cookie);
+	ret = dma_submit_error(xfer->cookie);
 	if (ret) {
 		dev_err(dev, "Failed to do DMA tx_submit %d\n", ret);
-		goto terminate;
+		return ret;
 	}
 
 	dma_async_issue_pending(chan);
-	ret = wait_for_completion_interruptible(&epf_test->transfer_complete);
-	if (ret < 0) {
-		dev_err(dev, "DMA wait_for_completion interrupted\n");
-		goto terminate;
-	}
 
-	if (epf_test->transfer_status == DMA_ERROR) {
-		dev_err(dev, "DMA transfer failed\n");
-		ret = -EIO;
+	return 0;
+}
+
+/**
+ * pci_epf_test_data_transfer() - Function that uses dmaengine API to transfer
+ *				  data between PCIe EP and remote PCIe RC
+ * @epf_test: the EPF test device that performs the data transfer operation
+ * @dma_dst: The destination address of the data transfer. It can be a physical
+ *	     address given by pci_epc_mem_alloc_addr or DMA mapping APIs.
+ * @dma_src: The source address of the data transfer. It can be a physical
+ *	     address given by pci_epc_mem_alloc_addr or DMA mapping APIs.
+ * @len: The size of the data transfer
+ * @dma_remote: remote RC physical address
+ * @dir: DMA transfer direction
+ * @nr_chans: number of DMA channels to split the transfer across
+ *
+ * Function that uses dmaengine API to transfer data between PCIe EP and remote
+ * PCIe RC. The source and destination address can be a physical address given
+ * by pci_epc_mem_alloc_addr or the one obtained using DMA mapping APIs.
+ * With more than one channel, each one moves a contiguous part of the data
+ * and all of them run concurrently.
+ *
+ * The function returns '0' on success and negative value on failure.
+ */
+static int pci_epf_test_data_transfer(struct pci_epf_test *epf_test,
+				      dma_addr_t dma_dst, dma_addr_t dma_src,
+				      size_t len, dma_addr_t dma_remote,
+				      enum dma_transfer_direction dir,
+				      unsigned int nr_chans)
+{
+	struct dma_chan **chans = (dir == DMA_MEM_TO_DEV) ?
+				  epf_test->dma_chan_tx : epf_test->dma_chan_rx;
+	struct device *dev = &epf_test->epf->dev;
+	struct pci_epf_test_xfer *xfer;
+	size_t chunk, off = 0;
+	unsigned int i, n;
+	int ret = 0, err;
+
+	nr_chans = clamp(nr_chans, 1U, epf_test->num_dma_chans);
+	chunk = ALIGN(DIV_ROUND_UP(len, nr_chans), DMA_CHUNK_ALIGN);
+
+	for (n = 0; n < nr_chans && off < len; n++, off += chunk) {
+		xfer = &epf_test->xfer[n];
+		xfer->chan = chans[n];
+		if (IS_ERR_OR_NULL(xfer->chan)) {
+			dev_err(dev, "Invalid DMA memcpy channel\n");
+			ret = -EINVAL;
+			break;
+		}
+
+		ret = pci_epf_test_submit_chunk(epf_test, xfer, dma_dst + off,
+						dma_src + off,
+						min(chunk, len - off),
+						dma_remote + off, dir);
+		if (ret) {
+			dmaengine_terminate_sync(xfer->chan);
+			break;
+		}
 	}
 
-terminate:
-	dmaengine_terminate_sync(chan);
+	for (i = 0; i < n; i++) {
+		xfer = &epf_test->xfer[i];
+
+		if (!ret) {
+			err = wait_for_completion_interruptible(&xfer->complete);
+			if (err < 0) {
+				dev_err(dev, "DMA wait_for_completion interrupted\n");
+				ret = err;
+			} else if (xfer->status == DMA_ERROR) {
+				dev_err(dev, "DMA transfer failed\n");
+				ret = -EIO;
+			}
+		}
+
+		dmaengine_terminate_sync(xfer->chan);
+	}
 
 	return ret;
 }
@@ -219,54 +277,62 @@ static int pci_epf_test_init_dma_chan(struct pci_epf_test *epf_test)
 	struct epf_dma_filter filter;
 	struct dma_chan *dma_chan;
 	dma_cap_mask_t mask;
-	int ret;
+	unsigned int i;
+	int ret = 0;
+
+	for (i = 0; i < MAX_DMA_CHANS; i++)
+		init_completion(&epf_test->xfer[i].complete);
 
 	filter.dev = epf->epc->dev.parent;
-	filter.dma_mask = BIT(DMA_DEV_TO_MEM);
 
 	dma_cap_zero(mask);
 	dma_cap_set(DMA_SLAVE, mask);
-	dma_chan = dma_request_channel(mask, epf_dma_filter_fn, &filter);
-	if (!dma_chan) {
-		dev_info(dev, "Failed to get private DMA rx channel. Falling back to generic one\n");
-		goto fail_back_tx;
-	}
-
-	epf_test->dma_chan_rx = dma_chan;
 
-	filter.dma_mask = BIT(DMA_MEM_TO_DEV);
-	dma_chan = dma_request_channel(mask, epf_dma_filter_fn, &filter);
+	/* As many pairs of private rx and tx channels as the EPC has */
+	for (i = 0; i < MAX_DMA_CHANS; i++) {
+		filter.dma_mask = BIT(DMA_DEV_TO_MEM);
+		dma_chan = dma_request_channel(mask, epf_dma_filter_fn, &filter);
+		if (!dma_chan)
+			break;
 
-	if (!dma_chan) {
-		dev_info(dev, "Failed to get private DMA tx channel. Falling back to generic one\n");
-		goto fail_back_rx;
+		filter.dma_mask = BIT(DMA_MEM_TO_DEV);
+		epf_test->dma_chan_tx[i] = dma_request_channel(mask,
+							       epf_dma_filter_fn,
+							       &filter);
+		if (!epf_test->dma_chan_tx[i]) {
+			dma_release_channel(dma_chan);
+			break;
+		}
+		epf_test->dma_chan_rx[i] = dma_chan;
 	}
 
-	epf_test->dma_chan_tx = dma_chan;
-	epf_test->dma_private = true;
-
-	init_completion(&epf_test->transfer_complete);
-
-	return 0;
+	if (i) {
+		epf_test->num_dma_chans = i;
+		epf_test->dma_private = true;
+		return 0;
+	}
 
-fail_back_rx:
-	dma_release_channel(epf_test->dma_chan_rx);
-	epf_test->dma_chan_rx = NULL;
+	dev_info(dev, "Failed to get private DMA channels. Falling back to generic ones\n");
 
-fail_back_tx:
 	dma_cap_zero(mask);
 	dma_cap_set(DMA_MEMCPY, mask);
 
-	dma_chan = dma_request_chan_by_mask(&mask);
-	if (IS_ERR(dma_chan)) {
-		ret = PTR_ERR(dma_chan);
+	for (i = 0; i < MAX_DMA_CHANS; i++) {
+		dma_chan = dma_request_chan_by_mask(&mask);
+		if (IS_ERR(dma_chan)) {
+			ret = PTR_ERR(dma_chan);
+			break;
+		}
+		epf_test->dma_chan_tx[i] = epf_test->dma_chan_rx[i] = dma_chan;
+	}
+
+	if (!i) {
 		if (ret != -EPROBE_DEFER)
 			dev_err(dev, "Failed to get DMA channel\n");
 		return ret;
 	}
-	init_completion(&epf_test->transfer_complete);
 
-	epf_test->dma_chan_tx = epf_test->dma_chan_rx = dma_chan;
+	epf_test->num_dma_chans = i;
 
 	return 0;
 }
@@ -279,20 +345,20 @@ static int pci_epf_test_init_dma_chan(struct pci_epf_test *epf_test)
  */
 static void pci_epf_test_clean_dma_chan(struct pci_epf_test *epf_test)
 {
+	unsigned int i;
+
 	if (!epf_test->dma_supported)
 		return;
 
-	dma_release_channel(epf_test->dma_chan_tx);
-	if (epf_test->dma_chan_tx == epf_test->dma_chan_rx) {
-		epf_test->dma_chan_tx = NULL;
-		epf_test->dma_chan_rx = NULL;
-		return;
+	for (i = 0; i < epf_test->num_dma_chans; i++) {
+		dma_release_channel(epf_test->dma_chan_tx[i]);
+		if (epf_test->dma_chan_rx[i] != epf_test->dma_chan_tx[i])
+			dma_release_channel(epf_test->dma_chan_rx[i]);
+		epf_test->dma_chan_tx[i] = NULL;
+		epf_test->dma_chan_rx[i] = NULL;
 	}
-
-	dma_release_channel(epf_test->dma_chan_rx);
-	epf_test->dma_chan_rx = NULL;
-
-	return;
+	epf_test->num_dma_chans = 0;
+	epf_test->dma_private = false;
 }
 
 static void pci_epf_test_print_rate(struct pci_epf_test *epf_test,
@@ -314,9 +380,27 @@ static void pci_epf_test_print_rate(struct pci_epf_test *epf_test,
 		 (u64)ts.tv_sec, (u32)ts.tv_nsec, rate);
 }
 
+static void pci_epf_test_bench_start(struct pci_epf_test_reg *reg)
+{
+	reg->elapsed_ns = 0;
+	reg->min_ns = U64_MAX;
+	reg->max_ns = 0;
+}
+
+static void pci_epf_test_bench_add(struct pci_epf_test_reg *reg, ktime_t start)
+{
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	reg->elapsed_ns += ns;
+	reg->min_ns = min(reg->min_ns, ns);
+	reg->max_ns = max(reg->max_ns, ns);
+}
+
 static void pci_epf_test_copy(struct pci_epf_test *epf_test,
 			      struct pci_epf_test_reg *reg)
 {
+	unsigned int i, iterations;
+	ktime_t t;
 	int ret;
 	void __iomem *src_addr;
 	void __iomem *dst_addr;
@@ -359,17 +443,27 @@ static void pci_epf_test_copy(struct pci_epf_test *epf_test,
 		goto err_dst_addr;
 	}
 
+	iterations = max(reg->iterations, 1U);
+	pci_epf_test_bench_start(reg);
+
 	ktime_get_ts64(&start);
 	if (reg->flags & FLAG_USE_DMA) {
-		if (!dma_has_cap(DMA_MEMCPY, epf_test->dma_chan_tx->device->cap_mask)) {
+		if (!dma_has_cap(DMA_MEMCPY, epf_test->dma_chan_tx[0]->device->cap_mask)) {
 			dev_err(dev, "DMA controller doesn't support MEMCPY\n");
 			ret = -EINVAL;
 			goto err_map_addr;
 		}
 
-		ret = pci_epf_test_data_transfer(epf_test, dst_phys_addr,
-						 src_phys_addr, reg->size, 0,
-						 DMA_MEM_TO_MEM);
+		for (i = 0; i < iterations && !ret; i++) {
+			t = ktime_get();
+			ret = pci_epf_test_data_transfer(epf_test,
+							 dst_phys_addr,
+							 src_phys_addr,
+							 reg->size, 0,
+							 DMA_MEM_TO_MEM,
+							 reg->dma_chans);
+			pci_epf_test_bench_add(reg, t);
+		}
 		if (ret)
 			dev_err(dev, "Data transfer failed\n");
 	} else {
@@ -381,13 +475,17 @@ static void pci_epf_test_copy(struct pci_epf_test *epf_test,
 			goto err_map_addr;
 		}
 
-		memcpy_fromio(buf, src_addr, reg->size);
-		memcpy_toio(dst_addr, buf, reg->size);
+		for (i = 0; i < iterations; i++) {
+			t = ktime_get();
+			memcpy_fromio(buf, src_addr, reg->size);
+			memcpy_toio(dst_addr, buf, reg->size);
+			pci_epf_test_bench_add(reg, t);
+		}
 		kfree(buf);
 	}
 	ktime_get_ts64(&end);
-	pci_epf_test_print_rate(epf_test, "COPY", reg->size, &start, &end,
-				reg->flags & FLAG_USE_DMA);
+	pci_epf_test_print_rate(epf_test, "COPY", (u64)reg->size * iterations,
+				&start, &end, reg->flags & FLAG_USE_DMA);
 
 err_map_addr:
 	pci_epc_unmap_addr(epc, epf->func_no, epf->vfunc_no, dst_phys_addr);
@@ -411,6 +509,8 @@ static void pci_epf_test_copy(struct pci_epf_test *epf_test,
 static void pci_epf_test_read(struct pci_epf_test *epf_test,
 			      struct pci_epf_test_reg *reg)
 {
+	unsigned int i, iterations;
+	ktime_t t;
 	int ret;
 	void __iomem *src_addr;
 	void *buf;
@@ -445,6 +545,9 @@ static void pci_epf_test_read(struct pci_epf_test *epf_test,
 		goto err_map_addr;
 	}
 
+	iterations = max(reg->iterations, 1U);
+	pci_epf_test_bench_start(reg);
+
 	if (reg->flags & FLAG_USE_DMA) {
 		dst_phys_addr = dma_map_single(dma_dev, buf, reg->size,
 					       DMA_FROM_DEVICE);
@@ -455,9 +558,16 @@ static void pci_epf_test_read(struct pci_epf_test *epf_test,
 		}
 
 		ktime_get_ts64(&start);
-		ret = pci_epf_test_data_transfer(epf_test, dst_phys_addr,
-						 phys_addr, reg->size,
-						 reg->src_addr, DMA_DEV_TO_MEM);
+		for (i = 0; i < iterations && !ret; i++) {
+			t = ktime_get();
+			ret = pci_epf_test_data_transfer(epf_test,
+							 dst_phys_addr,
+							 phys_addr, reg->size,
+							 reg->src_addr,
+							 DMA_DEV_TO_MEM,
+							 reg->dma_chans);
+			pci_epf_test_bench_add(reg, t);
+		}
 		if (ret)
 			dev_err(dev, "Data transfer failed\n");
 		ktime_get_ts64(&end);
@@ -466,12 +576,16 @@ static void pci_epf_test_read(struct pci_epf_test *epf_test,
 				 DMA_FROM_DEVICE);
 	} else {
 		ktime_get_ts64(&start);
-		memcpy_fromio(buf, src_addr, reg->size);
+		for (i = 0; i < iterations; i++) {
+			t = ktime_get();
+			memcpy_fromio(buf, src_addr, reg->size);
+			pci_epf_test_bench_add(reg, t);
+		}
 		ktime_get_ts64(&end);
 	}
 
-	pci_epf_test_print_rate(epf_test, "READ", reg->size, &start, &end,
-				reg->flags & FLAG_USE_DMA);
+	pci_epf_test_print_rate(epf_test, "READ", (u64)reg->size * iterations,
+				&start, &end, reg->flags & FLAG_USE_DMA);
 
 	crc32 = crc32_le(~0, buf, reg->size);
 	if (crc32 != reg->checksum)
@@ -496,6 +610,8 @@ static void pci_epf_test_read(struct pci_epf_test *epf_test,
 static void pci_epf_test_write(struct pci_epf_test *epf_test,
 			       struct pci_epf_test_reg *reg)
 {
+	unsigned int i, iterations;
+	ktime_t t;
 	int ret;
 	void __iomem *dst_addr;
 	void *buf;
@@ -532,6 +648,9 @@ static void pci_epf_test_write(struct pci_epf_test *epf_test,
 	get_random_bytes(buf, reg->size);
 	reg->checksum = crc32_le(~0, buf, reg->size);
 
+	iterations = max(reg->iterations, 1U);
+	pci_epf_test_bench_start(reg);
+
 	if (reg->flags & FLAG_USE_DMA) {
 		src_phys_addr = dma_map_single(dma_dev, buf, reg->size,
 					       DMA_TO_DEVICE);
@@ -542,11 +661,16 @@ static void pci_epf_test_write(struct pci_epf_test *epf_test,
 		}
 
 		ktime_get_ts64(&start);
-
-		ret = pci_epf_test_data_transfer(epf_test, phys_addr,
-						 src_phys_addr, reg->size,
-						 reg->dst_addr,
-						 DMA_MEM_TO_DEV);
+		for (i = 0; i < iterations && !ret; i++) {
+			t = ktime_get();
+			ret = pci_epf_test_data_transfer(epf_test, phys_addr,
+							 src_phys_addr,
+							 reg->size,
+							 reg->dst_addr,
+							 DMA_MEM_TO_DEV,
+							 reg->dma_chans);
+			pci_epf_test_bench_add(reg, t);
+		}
 		if (ret)
 			dev_err(dev, "Data transfer failed\n");
 		ktime_get_ts64(&end);
@@ -555,12 +679,16 @@ static void pci_epf_test_write(struct pci_epf_test *epf_test,
 				 DMA_TO_DEVICE);
 	} else {
 		ktime_get_ts64(&start);
-		memcpy_toio(dst_addr, buf, reg->size);
+		for (i = 0; i < iterations; i++) {
+			t = ktime_get();
+			memcpy_toio(dst_addr, buf, reg->size);
+			pci_epf_test_bench_add(reg, t);
+		}
 		ktime_get_ts64(&end);
 	}
 
-	pci_epf_test_print_rate(epf_test, "WRITE", reg->size, &start, &end,
-				reg->flags & FLAG_USE_DMA);
+	pci_epf_test_print_rate(epf_test, "WRITE", (u64)reg->size * iterations,
+				&start, &end, reg->flags & FLAG_USE_DMA);
 
 	/*
 	 * wait 1ms inorder for the write to complete. Without this delay L3
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/* Copyright 2025 NXP */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM	lynx_28g
+
+#if !defined(_PHY_FSL_LYNX_28G_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _PHY_FSL_LYNX_28G_TRACE_H
+
+#include <linux/device.h>
+#include <linux/tracepoint.h>
+
+/* A protocol change of a lane, from the halt to the end of the reset */
+TRACE_EVENT(lynx_28g_set_lane_mode,
+	    TP_PROTO(struct device *dev, unsigned int lane,
+		     const char *old_mode, const char *new_mode,
+		     bool cached, bool halted, unsigned int regs_written,
+		     u64 elapsed_ns),
+
+	    TP_ARGS(dev, lane, old_mode, new_mode, cached, halted,
+		    regs_written, elapsed_ns),
+
+	    TP_STRUCT__entry(
+		    __string(dev, dev_name(dev))
+		    __field(unsigned int, lane)
+		    __string(old_mode, old_mode)
+		    __string(new_mode, new_mode)
+		    __field(bool, cached)
+		    __field(bool, halted)
+		    __field(unsigned int, regs_written)
+		    __field(u64, elapsed_ns)
+	    ),
+
+	    TP_fast_assign(
+		    __assign_str(dev);
+		    __entry->lane = lane;
+		    __assign_str(old_mode);
+		    __assign_str(new_mode);
+		    __entry->cached = cached;
+		    __entry->halted = halted;
+		    __entry->regs_written = regs_written;
+		    __entry->elapsed_ns = elapsed_ns;
+	    ),
+
+	    TP_printk("%s lane %u: %s -> %s cached=%d halted=%d regs=%u elapsed=%llu ns",
+		      __get_str(dev), __entry->lane, __get_str(old_mode),
+		      __get_str(new_mode), __entry->cached, __entry->halted,
+		      __entry->regs_written, __entry->elapsed_ns)
+);
+
+/* The CDR locked, or gave up locking, after a protocol change or power on */
+TRACE_EVENT(lynx_28g_cdr_lock,
+	    TP_PROTO(struct device *dev, unsigned int lane, const char *mode,
+		     bool locked, unsigned int rx_resets, u64 elapsed_ns),
+
+	    TP_ARGS(dev, lane, mode, locked, rx_resets, elapsed_ns),
+
+	    TP_STRUCT__entry(
+		    __string(dev, dev_name(dev))
+		    __field(unsigned int, lane)
+		    __string(mode, mode)
+		    __field(bool, locked)
+		    __field(unsigned int, rx_resets)
+		    __field(u64, elapsed_ns)
+	    ),
+
+	    TP_fast_assign(
+		    __assign_str(dev);
+		    __entry->lane = lane;
+		    __assign_str(mode);
+		    __entry->locked = locked;
+		    __entry->rx_resets = rx_resets;
+		    __entry->elapsed_ns = elapsed_ns;
+	    ),
+
+	    TP_printk("%s lane %u: %s %s after %llu ns, %u rx resets",
+		      __get_str(dev), __entry->lane, __get_str(mode),
+		      __entry->locked ? "locked" : "not locked",
+		      __entry->elapsed_ns, __entry->rx_resets)
+);
+
+#endif /* _PHY_FSL_LYNX_28G_TRACE_H */
+
+/* This must be outside ifdef _PHY_FSL_LYNX_28G_TRACE_H */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE	phy-fsl-lynx-28g-trace
+#include <trace/define_trace.h>
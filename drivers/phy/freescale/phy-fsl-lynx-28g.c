@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0+
 /* Copyright (c) 2021-2022 NXP. */
 
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/phy.h>
@@ -10,6 +11,9 @@
 
 #include "phy-fsl-lynx-xgkr-algorithm.h"
 
+#define CREATE_TRACE_POINTS
+#include "phy-fsl-lynx-28g-trace.h"
+
 #define LYNX_28G_NUM_LANE			8
 #define LYNX_28G_NUM_PLL			2
 
@@ -341,6 +345,11 @@
 #define LYNX_28G_CDR_SLEEP_US			50
 #define LYNX_28G_CDR_TIMEOUT_US			500
 
+/* CDR lock polling: fast for a while after a protocol change, then slow */
+#define LYNX_28G_CDR_FAST_POLL_MS		10
+#define LYNX_28G_CDR_FAST_TIMEOUT_MS		2000
+#define LYNX_28G_CDR_POLL_MS			1000
+
 #define LYNX_28G_SNAPSHOT_SLEEP_US		1
 #define LYNX_28G_SNAPSHOT_TIMEOUT_US		1000
 
@@ -722,6 +731,42 @@ struct lynx_pccr {
 	int shift;
 };
 
+static const char * const lynx_28g_lane_mode_name[LANE_MODE_MAX] = {
+	[LANE_MODE_UNKNOWN] = "unknown",
+	[LANE_MODE_1000BASEX_SGMII] = "1000base-x/sgmii",
+	[LANE_MODE_10GBASER] = "10gbase-r",
+	[LANE_MODE_USXGMII] = "usxgmii",
+	[LANE_MODE_25GBASER] = "25gbase-r",
+	[LANE_MODE_1000BASEKX] = "1000base-kx",
+	[LANE_MODE_10GBASEKR] = "10gbase-kr",
+	[LANE_MODE_25GBASEKR] = "25gbase-kr",
+	[LANE_MODE_40GBASER_XLAUI] = "40gbase-r",
+	[LANE_MODE_40GBASEKR4] = "40gbase-kr4",
+};
+
+/* Lane registers written by a protocol change, as offsets for lane 0 */
+#define LYNX_28G_NUM_CONF_REGS			13
+
+static const u32 lynx_28g_lane_conf_regs[LYNX_28G_NUM_CONF_REGS] = {
+	LYNX_28G_LNaGCR0(0),
+	LYNX_28G_LNaTGCR0(0),
+	LYNX_28G_LNaRGCR0(0),
+	LYNX_28G_LNaTECR0(0),
+	LYNX_28G_LNaTECR1(0),
+	LYNX_28G_LNaRGCR1(0),
+	LYNX_28G_LNaRECR0(0),
+	LYNX_28G_LNaRECR1(0),
+	LYNX_28G_LNaRECR2(0),
+	LYNX_28G_LNaRSCCR0(0),
+	LYNX_28G_LNaRCCR0(0),
+	LYNX_28G_LNaTTLCR0(0),
+	LYNX_28G_LNaTCSR0(0),
+};
+
+#define LYNX_28G_LANE_CONF_REG(lane, i) \
+	(lynx_28g_lane_conf_regs[i] + LYNX_28G_LNaGCR0((lane)->id) - \
+	 LYNX_28G_LNaGCR0(0))
+
 struct lynx_28g_priv;
 
 struct lynx_28g_pll {
@@ -745,6 +790,17 @@ struct lynx_28g_lane {
 	unsigned int id;
 	enum lynx_28g_lane_mode mode;
 	struct lynx_xgkr_algorithm *algorithm;
+	/*
+	 * The lane registers of each mode, saved the first time the lane
+	 * is switched to it, so that later switches only write the
+	 * registers that differ instead of recomputing all of them.
+	 */
+	u32 conf_cache[LANE_MODE_MAX][LYNX_28G_NUM_CONF_REGS];
+	DECLARE_BITMAP(conf_cached, LANE_MODE_MAX);
+	/* Waiting for the CDR to lock since cdr_start, polled fast */
+	bool cdr_pending;
+	ktime_t cdr_start;
+	unsigned int cdr_rx_resets;
 };
 
 struct lynx_info {
@@ -985,6 +1041,7 @@ static bool lynx_28g_cdr_lock_check(struct lynx_28g_lane *lane)
 		return false;
 
 	dev_dbg(&lane->phy->dev, "CDR unlocked, resetting lane receiver...\n");
+	lane->cdr_rx_resets++;
 
 	lynx_28g_lane_rmw(lane, LNaRRSTCTL,
 			  LYNX_28G_LNaRRSTCTL_RST_REQ,
@@ -996,6 +1053,43 @@ static bool lynx_28g_cdr_lock_check(struct lynx_28g_lane *lane)
 	return !!(rrstctl & LYNX_28G_LNaRRSTCTL_CDR_LOCK);
 }
 
+static void lynx_28g_cdr_lock_done(struct lynx_28g_lane *lane, bool locked)
+{
+	lane->cdr_pending = false;
+	trace_lynx_28g_cdr_lock(lane->priv->dev, lane->id,
+				lynx_28g_lane_mode_name[lane->mode], locked,
+				lane->cdr_rx_resets,
+				ktime_to_ns(ktime_sub(ktime_get(), lane->cdr_start)));
+}
+
+/*
+ * After the lane was reset, give the CDR a short while to lock before
+ * returning.  If it did not, lynx_28g_cdr_lock_check_work() polls it fast
+ * instead of once a second, until it locks or LYNX_28G_CDR_FAST_TIMEOUT_MS.
+ */
+static void lynx_28g_cdr_lock_start(struct lynx_28g_lane *lane, ktime_t start)
+{
+	struct lynx_28g_priv *priv = lane->priv;
+	u32 rrstctl;
+	int err;
+
+	lane->cdr_start = start;
+	lane->cdr_rx_resets = 0;
+
+	err = read_poll_timeout(lynx_28g_lane_read, rrstctl,
+				rrstctl & LYNX_28G_LNaRRSTCTL_CDR_LOCK,
+				LYNX_28G_CDR_SLEEP_US, LYNX_28G_CDR_TIMEOUT_US,
+				false, lane, LNaRRSTCTL);
+	if (!err) {
+		lynx_28g_cdr_lock_done(lane, true);
+		return;
+	}
+
+	lane->cdr_pending = true;
+	mod_delayed_work(system_power_efficient_wq, &priv->cdr_check,
+			 msecs_to_jiffies(LYNX_28G_CDR_FAST_POLL_MS));
+}
+
 /* Halting puts the lane in a mode in which it can be reconfigured */
 static void lynx_28g_lane_halt(struct phy *phy)
 {
@@ -1070,10 +1164,13 @@ static int lynx_28g_power_off(struct phy *phy)
 static int lynx_28g_power_on(struct phy *phy)
 {
 	struct lynx_28g_lane *lane = phy_get_drvdata(phy);
+	ktime_t start;
 
 	if (lane->powered_up)
 		return 0;
 
+	start = ktime_get();
+
 	/* Power up the RX and TX portions of the lane */
 	lynx_28g_lane_rmw(lane, LNaRRSTCTL, 0, LYNX_28G_LNaRRSTCTL_DIS);
 	lynx_28g_lane_rmw(lane, LNaTRSTCTL, 0, LYNX_28G_LNaTRSTCTL_DIS);
@@ -1082,6 +1179,9 @@ static int lynx_28g_power_on(struct phy *phy)
 
 	lane->powered_up = true;
 
+	if (lane->init)
+		lynx_28g_cdr_lock_start(lane, start);
+
 	return 0;
 }
 
@@ -1485,6 +1585,54 @@ static void lynx_28g_lane_change_proto_conf(struct lynx_28g_lane *lane,
 	lynx_28g_lane_write(lane, LNaTTLCR0, conf->ttlcr0);
 }
 
+static void lynx_28g_lane_save_conf(struct lynx_28g_lane *lane,
+				    enum lynx_28g_lane_mode mode)
+{
+	struct lynx_28g_priv *priv = lane->priv;
+	int i;
+
+	for (i = 0; i < LYNX_28G_NUM_CONF_REGS; i++)
+		lane->conf_cache[mode][i] =
+			lynx_28g_read(priv, LYNX_28G_LANE_CONF_REG(lane, i));
+
+	__set_bit(mode, lane->conf_cached);
+}
+
+/* Returns a mask of the cached registers which differ from the lane's */
+static unsigned long lynx_28g_lane_conf_diff(struct lynx_28g_lane *lane,
+					     enum lynx_28g_lane_mode mode)
+{
+	struct lynx_28g_priv *priv = lane->priv;
+	unsigned long diff = 0;
+	u32 status;
+	int i;
+
+	for (i = 0; i < LYNX_28G_NUM_CONF_REGS; i++) {
+		/* data lost is a status, not part of the configuration */
+		status = lynx_28g_lane_conf_regs[i] == LYNX_28G_LNaRGCR1(0) ?
+			 LYNX_28G_LNaRGCR1_DATA_LOST_FLT |
+			 LYNX_28G_LNaRGCR1_DATA_LOST : 0;
+
+		if ((lynx_28g_read(priv, LYNX_28G_LANE_CONF_REG(lane, i)) ^
+		     lane->conf_cache[mode][i]) & ~status)
+			diff |= BIT(i);
+	}
+
+	return diff;
+}
+
+static void lynx_28g_lane_restore_conf(struct lynx_28g_lane *lane,
+				       enum lynx_28g_lane_mode mode,
+				       unsigned long diff)
+{
+	struct lynx_28g_priv *priv = lane->priv;
+	int i;
+
+	for_each_set_bit(i, &diff, LYNX_28G_NUM_CONF_REGS)
+		lynx_28g_write(priv, LYNX_28G_LANE_CONF_REG(lane, i),
+			       lane->conf_cache[mode][i]);
+}
+
 static int lynx_28g_lane_disable_pcvt(struct lynx_28g_lane *lane,
 				      enum lynx_28g_lane_mode mode)
 {
@@ -1571,8 +1719,12 @@ static int lynx_28g_set_lane_mode(struct phy *phy, enum lynx_28g_lane_mode lane_
 {
 	struct lynx_28g_lane *lane = phy_get_drvdata(phy);
 	struct lynx_28g_priv *priv = lane->priv;
+	enum lynx_28g_lane_mode old_mode = lane->mode;
 	bool powered_up = lane->powered_up;
+	unsigned long diff = 0;
 	bool is_backplane;
+	bool cached;
+	ktime_t start;
 	int err;
 
 	if (lane->mode == LANE_MODE_UNKNOWN)
@@ -1581,6 +1733,18 @@ static int lynx_28g_set_lane_mode(struct phy *phy, enum lynx_28g_lane_mode lane_
 	if (lane_mode == lane->mode)
 		return 0;
 
+	start = ktime_get();
+
+	/* Between modes which only differ in the protocol converter, like
+	 * 1000Base-X and 1000Base-KX, the lane itself keeps running.
+	 */
+	cached = test_bit(lane_mode, lane->conf_cached);
+	if (cached) {
+		diff = lynx_28g_lane_conf_diff(lane, lane_mode);
+		if (!diff)
+			powered_up = false;
+	}
+
 	/* If the lane is powered up, put the lane into the halt state while
 	 * the reconfiguration is being done.
 	 */
@@ -1591,18 +1755,26 @@ static int lynx_28g_set_lane_mode(struct phy *phy, enum lynx_28g_lane_mode lane_
 	if (err)
 		goto out;
 
-	lynx_28g_lane_change_proto_conf(lane, lane_mode);
-	lynx_28g_lane_remap_pll(lane, lane_mode);
-	WARN_ON(lynx_28g_lane_enable_pcvt(lane, lane_mode));
-
-	is_backplane = lane_mode == LANE_MODE_1000BASEKX ||
-		       lane_mode == LANE_MODE_10GBASEKR ||
-		       lane_mode == LANE_MODE_25GBASEKR ||
-		       lane_mode == LANE_MODE_40GBASEKR4;
-	/* Enable observation of SerDes status on all status registers */
-	lynx_28g_lane_rmw(lane, LNaTCSR0,
-			  is_backplane ? LYNX_28G_LNaTCSR0_SD_STAT_OBS_EN : 0,
-			  LYNX_28G_LNaTCSR0_SD_STAT_OBS_EN);
+	if (cached) {
+		lynx_28g_lane_restore_conf(lane, lane_mode, diff);
+		WARN_ON(lynx_28g_lane_enable_pcvt(lane, lane_mode));
+	} else {
+		lynx_28g_lane_change_proto_conf(lane, lane_mode);
+		lynx_28g_lane_remap_pll(lane, lane_mode);
+		WARN_ON(lynx_28g_lane_enable_pcvt(lane, lane_mode));
+
+		is_backplane = lane_mode == LANE_MODE_1000BASEKX ||
+			       lane_mode == LANE_MODE_10GBASEKR ||
+			       lane_mode == LANE_MODE_25GBASEKR ||
+			       lane_mode == LANE_MODE_40GBASEKR4;
+		/* Enable observation of SerDes status on all status registers */
+		lynx_28g_lane_rmw(lane, LNaTCSR0,
+				  is_backplane ? LYNX_28G_LNaTCSR0_SD_STAT_OBS_EN : 0,
+				  LYNX_28G_LNaTCSR0_SD_STAT_OBS_EN);
+
+		lynx_28g_lane_save_conf(lane, lane_mode);
+		diff = GENMASK(LYNX_28G_NUM_CONF_REGS - 1, 0);
+	}
 
 	/* 1000Base-KX lanes need their PLL to generate a 312.5 MHz frequency
 	 * through EX_DLY_CLK.
@@ -1618,6 +1790,15 @@ static int lynx_28g_set_lane_mode(struct phy *phy, enum lynx_28g_lane_mode lane_
 	if (powered_up)
 		lynx_28g_lane_reset(phy);
 
+	trace_lynx_28g_set_lane_mode(priv->dev, lane->id,
+				     lynx_28g_lane_mode_name[old_mode],
+				     lynx_28g_lane_mode_name[lane_mode],
+				     cached, powered_up, hweight_long(diff),
+				     ktime_to_ns(ktime_sub(ktime_get(), start)));
+
+	if (powered_up && lane->init && !err)
+		lynx_28g_cdr_lock_start(lane, start);
+
 	return err;
 }
 
@@ -2060,7 +2241,9 @@ static void lynx_28g_pll_read_configuration(struct lynx_28g_priv *priv)
 static void lynx_28g_cdr_lock_check_work(struct work_struct *work)
 {
 	struct lynx_28g_priv *priv = work_to_lynx(work);
+	unsigned int delay = LYNX_28G_CDR_POLL_MS;
 	struct lynx_28g_lane *lane;
+	bool locked;
 	int i;
 
 	for (i = priv->info->first_lane; i < LYNX_28G_NUM_LANE; i++) {
@@ -2069,16 +2252,27 @@ static void lynx_28g_cdr_lock_check_work(struct work_struct *work)
 		mutex_lock(&lane->phy->mutex);
 
 		if (!lane->init || !lane->powered_up) {
+			lane->cdr_pending = false;
 			mutex_unlock(&lane->phy->mutex);
 			continue;
 		}
 
-		lynx_28g_cdr_lock_check(lane);
+		locked = lynx_28g_cdr_lock_check(lane);
+
+		if (lane->cdr_pending) {
+			if (locked)
+				lynx_28g_cdr_lock_done(lane, true);
+			else if (ktime_ms_delta(ktime_get(), lane->cdr_start) >=
+				 LYNX_28G_CDR_FAST_TIMEOUT_MS)
+				lynx_28g_cdr_lock_done(lane, false);
+			else
+				delay = LYNX_28G_CDR_FAST_POLL_MS;
+		}
 
 		mutex_unlock(&lane->phy->mutex);
 	}
 	queue_delayed_work(system_power_efficient_wq, &priv->cdr_check,
-			   msecs_to_jiffies(1000));
+			   msecs_to_jiffies(delay));
 }
 
 static void lynx_28g_lane_read_configuration(struct lynx_28g_lane *lane)
@@ -2164,7 +2358,7 @@ static int lynx_28g_probe(struct platform_device *pdev)
 	INIT_DELAYED_WORK(&priv->cdr_check, lynx_28g_cdr_lock_check_work);
 
 	queue_delayed_work(system_power_efficient_wq, &priv->cdr_check,
-			   msecs_to_jiffies(1000));
+			   msecs_to_jiffies(LYNX_28G_CDR_POLL_MS));
 
 	dev_set_drvdata(&pdev->dev, priv);
 	provider = devm_of_phy_provider_register(&pdev->dev, lynx_28g_xlate);
@@ -3592,6 +3592,27 @@ static int idle_states_show(struct seq_file *s, void *data)
 	return ret;
 }
 
+static int latency_show(struct seq_file *s, void *data)
+{
+	struct generic_pm_domain *genpd = s->private;
+	unsigned int i;
+	int ret;
+
+	ret = genpd_lock_interruptible(genpd);
+	if (ret)
+		return -ERESTARTSYS;
+
+	seq_puts(s, "State          Power-off(ns)  Power-on(ns)\n");
+
+	for (i = 0; i < genpd->state_count; i++)
+		seq_printf(s, "S%-13i %-14lld %lld\n", i,
+			   genpd->states[i].power_off_latency_ns,
+			   genpd->states[i].power_on_latency_ns);
+
+	genpd_unlock(genpd);
+	return 0;
+}
+
 static int active_time_show(struct seq_file *s, void *data)
 {
 	struct generic_pm_domain *genpd = s->private;
@@ -3681,6 +3702,7 @@ DEFINE_SHOW_ATTRIBUTE(summary);
 DEFINE_SHOW_ATTRIBUTE(status);
 DEFINE_SHOW_ATTRIBUTE(sub_domains);
 DEFINE_SHOW_ATTRIBUTE(idle_states);
+DEFINE_SHOW_ATTRIBUTE(latency);
 DEFINE_SHOW_ATTRIBUTE(active_time);
 DEFINE_SHOW_ATTRIBUTE(total_idle_time);
 DEFINE_SHOW_ATTRIBUTE(devices);
@@ -3701,6 +3723,8 @@ static void genpd_debug_add(struct generic_pm_domain *genpd)
 			    d, genpd, &sub_domains_fops);
 	debugfs_create_file("idle_states", 0444,
 			    d, genpd, &idle_states_fops);
+	debugfs_create_file("latency", 0444,
+			    d, genpd, &latency_fops);
 	debugfs_create_file("active_time", 0444,
 			    d, genpd, &active_time_fops);
 	debugfs_create_file("total_idle_time", 0444,
@@ -1515,6 +1515,24 @@ static const struct imx_pgc_domain_data imx8mn_pgc_domain_data = {
 	.pgc_regs = &imx7_pgc_regs,
 };
 
+/*
+ * The virtual devices genpd creates for multi-domain consumers (blk-ctrl
+ * attaches one per power domain) have no driver callbacks of their own,
+ * their system sleep transitions only power the domain off and on. Let
+ * them go through noirq suspend/resume asynchronously, so that the power
+ * up handshakes of independent domains overlap instead of being serialized
+ * on the dpm list. Ordering against consumers is still enforced by the
+ * device links genpd sets up.
+ */
+static int imx_pgc_attach_dev(struct generic_pm_domain *genpd,
+			      struct device *dev)
+{
+	if (!dev->driver)
+		device_enable_async_suspend(dev);
+
+	return 0;
+}
+
 static int imx_pgc_domain_probe(struct platform_device *pdev)
 {
 	struct imx_pgc_domain *domain = pdev->dev.platform_data;
@@ -1543,6 +1561,7 @@ static int imx_pgc_domain_probe(struct platform_device *pdev)
 				     "Failed to get domain's resets\n");
 
 	pm_runtime_enable(domain->dev);
+	device_enable_async_suspend(domain->dev);
 
 	if (domain->bits.map)
 		regmap_update_bits(domain->regmap, domain->regs->map,
@@ -1730,6 +1749,7 @@ static int imx_gpcv2_probe(struct platform_device *pdev)
 
 		domain->genpd.power_on  = imx_pgc_power_up;
 		domain->genpd.power_off = imx_pgc_power_down;
+		domain->genpd.attach_dev = imx_pgc_attach_dev;
 
 		pd_pdev->dev.parent = dev;
 		device_set_node(&pd_pdev->dev, of_fwnode_handle(np));
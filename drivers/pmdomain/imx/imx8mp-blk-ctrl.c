@@ -81,6 +81,7 @@ struct imx8mp_blk_ctrl_domain {
 	struct device *power_dev;
 	struct imx8mp_blk_ctrl *bc;
 	int id;
+	bool noc_programmed;
 };
 
 struct imx8mp_blk_ctrl_data {
@@ -198,7 +199,12 @@ static int imx8mp_qos_set(struct imx8mp_blk_ctrl_domain *domain)
 	if (data->hurry_data)
 		regmap_set_bits(bc->regmap, data->hurry_data->off, data->hurry_data->hurry_mask);
 
-	if (!regmap)
+	/*
+	 * The NoC sits in the always-on domain and keeps the QoS settings of
+	 * the ports across blk-ctrl power cycles, only system suspend may
+	 * lose them.
+	 */
+	if (!regmap || domain->noc_programmed)
 		return 0;
 
 	for (i = 0; i < DOMAIN_MAX_NOC; i++) {
@@ -208,6 +214,7 @@ static int imx8mp_qos_set(struct imx8mp_blk_ctrl_domain *domain)
 		regmap_write(regmap, data->noc_data[i]->off + 0xc, data->noc_data[i]->mode);
 		regmap_write(regmap, data->noc_data[i]->off + 0x18, data->noc_data[i]->extctrl);
 	}
+	domain->noc_programmed = true;
 
 	return 0;
 }
@@ -776,7 +783,8 @@ static int imx8mp_blk_ctrl_probe(struct platform_device *pdev)
 		domain->bc = bc;
 		domain->id = i;
 
-		ret = pm_genpd_init(&domain->genpd, NULL, true);
+		/* the governor lets genpd time and report power on/off */
+		ret = pm_genpd_init(&domain->genpd, &simple_qos_governor, true);
 		if (ret) {
 			dev_err_probe(dev, ret, "failed to init power domain\n");
 			dev_pm_domain_detach(domain->power_dev, true);
@@ -885,6 +893,9 @@ static int imx8mp_blk_ctrl_suspend(struct device *dev)
 			pm_runtime_put_noidle(domain->power_dev);
 			goto out_fail;
 		}
+
+		/* NoC state may not survive, reprogram it on the way up */
+		domain->noc_programmed = false;
 	}
 
 	return 0;
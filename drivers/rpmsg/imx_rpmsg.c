@@ -4,22 +4,29 @@
  */
 
 #include <linux/slab.h>
-#include <linux/circ_buf.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/err.h>
+#include <linux/genalloc.h>
+#include <linux/io.h>
+#include <linux/mm.h>
 #ifdef CONFIG_IMX_SCU
 #include <linux/firmware/imx/sci.h>
 #endif
 #include <linux/init.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
 #include <linux/mailbox_client.h>
 #include <linux/module.h>
 #include <linux/notifier.h>
 #include <linux/of_device.h>
 #include <linux/of_reserved_mem.h>
 #include <linux/platform_device.h>
+#include <linux/seq_file.h>
 #include <linux/virtio_config.h>
 #include <linux/virtio_ids.h>
 #include <linux/virtio_ring.h>
+#include <linux/xarray.h>
 #include <linux/imx_rpmsg.h>
 #include "rpmsg_internal.h"
 
@@ -44,6 +51,34 @@ struct imx_virdev {
 	struct imx_rpmsg_vproc *rpdev;
 };
 
+/* wakeup to vring callback latency, in log2(us) buckets */
+#define IMX_RPMSG_LAT_BUCKETS	16
+
+struct imx_rpmsg_rx_stats {
+	u64 count;
+	u64 total_ns;
+	u64 min_ns;
+	u64 max_ns;
+	u64 buckets[IMX_RPMSG_LAT_BUCKETS];
+};
+
+/* a buffer of the shared pool, see linux/imx_rpmsg.h */
+struct imx_rpmsg_buf {
+	u32 offset;
+	u32 size;
+	bool remote;		/* handed over to the remote */
+	bool orphan;		/* owner went away while it was remote */
+	void *owner;		/* opaque cookie of the local user */
+};
+
+struct imx_rpmsg_pool {
+	struct gen_pool *gen;
+	void *vaddr;
+	phys_addr_t paddr;
+	size_t size;
+	struct xarray bufs;	/* indexed by offset >> PAGE_SHIFT */
+};
+
 struct imx_rpmsg_vproc {
 	struct mbox_client cl;
 	struct mbox_client cl_rxdb;
@@ -55,9 +90,15 @@ struct imx_rpmsg_vproc {
 	int first_notify;
 	u32 flags;
 #define MAX_VDEV_NUMS  8
+#define MAX_VQ_NUMS    (MAX_VDEV_NUMS * 2)
 	struct imx_virdev *ivdev[MAX_VDEV_NUMS];
-	struct delayed_work rpmsg_work;
-	struct circ_buf rx_buffer;
+	struct kthread_worker *rx_worker;
+	struct kthread_work rx_work;
+	unsigned long rx_pending;	/* vq ids kicked by the remote */
+	ktime_t rx_stamp[MAX_VQ_NUMS];	/* time of the first pending kick */
+	struct imx_rpmsg_rx_stats rx_stats;
+	struct dentry *debugfs;
+	struct imx_rpmsg_pool *pool;
 	spinlock_t mu_lock;
 	u32 mub_partition;
 	struct notifier_block proc_nb;
@@ -70,6 +111,14 @@ struct imx_rpmsg_vproc {
  */
 #define REMOTE_READY_WAIT_MAX_RETRIES	500
 
+/*
+ * Number of vring callbacks run before the RX worker gives other tasks a
+ * chance, much like a NAPI budget.
+ */
+#define IMX_RPMSG_RX_BUDGET	64
+
+static struct dentry *imx_rpmsg_debugfs_root;
+
 #define RPMSG_NUM_BUFS		(512)
 #define RPMSG_BUF_SIZE		(512)
 #define RPMSG_BUFS_SPACE	(RPMSG_NUM_BUFS * RPMSG_BUF_SIZE)
@@ -325,45 +374,436 @@ static int set_vring_phy_buf(struct platform_device *pdev,
 	return ret;
 }
 
-static void rpmsg_work_handler(struct work_struct *work)
+static struct imx_rpmsg_pool *imx_rpmsg_get_pool(struct rpmsg_device *rpdev)
 {
-	u32 message;
-	unsigned long flags;
-	struct imx_virdev *virdev;
-	struct delayed_work *dwork = to_delayed_work(work);
-	struct imx_rpmsg_vproc *rpdev = container_of(dwork,
-			struct imx_rpmsg_vproc, rpmsg_work);
-	struct circ_buf *cb = &rpdev->rx_buffer;
-	struct platform_device *pdev = rpdev->pdev;
-	struct device *dev = &pdev->dev;
+	struct device *parent = rpdev ? rpdev->dev.parent : NULL;
+	struct virtio_device *vdev;
 
-	spin_lock_irqsave(&rpdev->mu_lock, flags);
-	/* handle all incoming mu message */
-	while (CIRC_CNT(cb->head, cb->tail, PAGE_SIZE)) {
-		message = cb->buf[cb->tail];
-		message |= (cb->buf[cb->tail + 1] << 8);
-		message |= (cb->buf[cb->tail + 2] << 16);
-		message |= (cb->buf[cb->tail + 3] << 24);
-		spin_unlock_irqrestore(&rpdev->mu_lock, flags);
-		virdev = rpdev->ivdev[(message >> 16) / 2];
+	if (!parent || !is_virtio_device(parent))
+		return NULL;
 
-		dev_dbg(dev, "%s msg: 0x%x\n", __func__, message);
-		message = message >> 16;
-		message -= virdev->base_vq_id;
+	vdev = dev_to_virtio(parent);
+	if (vdev->config != &imx_rpmsg_config_ops)
+		return NULL;
 
-		/*
-		 * Currently both PENDING_MSG and explicit-virtqueue-index
-		 * messaging are supported.
-		 * Whatever approach is taken, at this point message contains
-		 * the index of the vring which was just triggered.
-		 */
-		if (message  < virdev->num_of_vqs)
-			vring_interrupt(message, virdev->vq[message]);
+	return to_imx_virdev(vdev)->rpdev->pool;
+}
+
+/**
+ * imx_rpmsg_buf_alloc() - allocate a buffer from the shared pool
+ * @rpdev: rpmsg device of an i.MX remote processor
+ * @size: size of the buffer, rounded up to pages
+ * @offset: set to the offset of the buffer in the pool
+ * @owner: opaque cookie checked on free and send, may be NULL
+ *
+ * Return: the kernel mapping of the buffer, or an ERR_PTR().
+ */
+void *imx_rpmsg_buf_alloc(struct rpmsg_device *rpdev, size_t size,
+			  u32 *offset, void *owner)
+{
+	struct imx_rpmsg_pool *pool = imx_rpmsg_get_pool(rpdev);
+	struct imx_rpmsg_buf *buf;
+	unsigned long vaddr;
+	int ret;
+
+	if (!pool)
+		return ERR_PTR(-ENODEV);
+
+	if (!size || size > pool->size)
+		return ERR_PTR(-EINVAL);
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return ERR_PTR(-ENOMEM);
+
+	size = PAGE_ALIGN(size);
+	vaddr = gen_pool_alloc(pool->gen, size);
+	if (!vaddr) {
+		kfree(buf);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	buf->offset = vaddr - (unsigned long)pool->vaddr;
+	buf->size = size;
+	buf->owner = owner;
+
+	ret = xa_insert(&pool->bufs, buf->offset >> PAGE_SHIFT, buf,
+			GFP_KERNEL);
+	if (ret) {
+		gen_pool_free(pool->gen, vaddr, size);
+		kfree(buf);
+		return ERR_PTR(ret);
+	}
+
+	*offset = buf->offset;
+
+	return (void *)vaddr;
+}
+EXPORT_SYMBOL_GPL(imx_rpmsg_buf_alloc);
+
+static void imx_rpmsg_buf_destroy(struct imx_rpmsg_pool *pool,
+				  struct imx_rpmsg_buf *buf)
+{
+	gen_pool_free(pool->gen, (unsigned long)pool->vaddr + buf->offset,
+		      buf->size);
+	kfree(buf);
+}
+
+/* must be called with the xarray locked */
+static struct imx_rpmsg_buf *imx_rpmsg_buf_find(struct imx_rpmsg_pool *pool,
+						u32 offset)
+{
+	struct imx_rpmsg_buf *buf;
+
+	buf = xa_load(&pool->bufs, offset >> PAGE_SHIFT);
+	if (!buf || buf->offset != offset)
+		return NULL;
+
+	return buf;
+}
+
+/**
+ * imx_rpmsg_buf_free() - return a buffer to the shared pool
+ * @rpdev: rpmsg device the buffer was allocated for
+ * @offset: offset of the buffer in the pool
+ * @owner: cookie given to imx_rpmsg_buf_alloc()
+ *
+ * Return: 0 on success, -EBUSY if the buffer is owned by the remote.
+ */
+int imx_rpmsg_buf_free(struct rpmsg_device *rpdev, u32 offset, void *owner)
+{
+	struct imx_rpmsg_pool *pool = imx_rpmsg_get_pool(rpdev);
+	struct imx_rpmsg_buf *buf;
+	int ret = 0;
+
+	if (!pool)
+		return -ENODEV;
+
+	xa_lock(&pool->bufs);
+	buf = imx_rpmsg_buf_find(pool, offset);
+	if (!buf || buf->owner != owner)
+		ret = -ENOENT;
+	else if (buf->remote)
+		ret = -EBUSY;
+	else
+		__xa_erase(&pool->bufs, offset >> PAGE_SHIFT);
+	xa_unlock(&pool->bufs);
+
+	if (!ret)
+		imx_rpmsg_buf_destroy(pool, buf);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(imx_rpmsg_buf_free);
+
+/**
+ * imx_rpmsg_buf_send() - pass a buffer to the remote by reference
+ * @ept: endpoint to send the reference from
+ * @dst: destination address
+ * @offset: offset of the buffer in the pool
+ * @len: length of valid data in the buffer
+ * @flags: IMX_RPMSG_BUF_F_* flags
+ * @owner: cookie given to imx_rpmsg_buf_alloc()
+ *
+ * The buffer belongs to the remote until it sends a reference back, and
+ * can't be freed or sent again in the meantime.
+ *
+ * Return: 0 on success, or the error of rpmsg_sendto().
+ */
+int imx_rpmsg_buf_send(struct rpmsg_endpoint *ept, u32 dst, u32 offset,
+		       u32 len, u32 flags, void *owner)
+{
+	struct imx_rpmsg_pool *pool = imx_rpmsg_get_pool(ept->rpdev);
+	struct imx_rpmsg_buf_ref ref;
+	struct imx_rpmsg_buf *buf;
+	int ret = 0;
+
+	if (!pool)
+		return -ENODEV;
+
+	xa_lock(&pool->bufs);
+	buf = imx_rpmsg_buf_find(pool, offset);
+	if (!buf || buf->owner != owner)
+		ret = -ENOENT;
+	else if (buf->remote)
+		ret = -EBUSY;
+	else if (len > buf->size)
+		ret = -EINVAL;
+	else
+		buf->remote = true;
+	xa_unlock(&pool->bufs);
+
+	if (ret)
+		return ret;
+
+	ref.magic = cpu_to_le32(IMX_RPMSG_BUF_MAGIC);
+	ref.offset = cpu_to_le32(offset);
+	ref.len = cpu_to_le32(len);
+	ref.flags = cpu_to_le32(flags);
+
+	/* the pool is write-combined, flush the data before the reference */
+	wmb();
+	ret = rpmsg_sendto(ept, &ref, sizeof(ref), dst);
+	if (ret) {
+		xa_lock(&pool->bufs);
+		buf->remote = false;
+		xa_unlock(&pool->bufs);
+	}
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(imx_rpmsg_buf_send);
+
+/**
+ * imx_rpmsg_buf_recv() - take back a buffer referenced by a message
+ * @rpdev: rpmsg device the message was received on
+ * @msg: message, see imx_rpmsg_is_buf_ref()
+ * @len: length of the message
+ *
+ * Return: the kernel mapping of the buffer, now owned locally again, or
+ * an ERR_PTR(): -ENOMSG if @msg is no reference, -EINVAL if it does not
+ * reference a buffer handed to the remote, -ENOENT if the buffer was
+ * freed on arrival because its local owner went away.
+ */
+void *imx_rpmsg_buf_recv(struct rpmsg_device *rpdev, const void *msg,
+			 int len)
+{
+	struct imx_rpmsg_pool *pool = imx_rpmsg_get_pool(rpdev);
+	const struct imx_rpmsg_buf_ref *ref = msg;
+	struct imx_rpmsg_buf *buf;
+	bool orphan = false;
+	u32 offset;
+	int ret = 0;
+
+	if (!pool)
+		return ERR_PTR(-ENODEV);
+
+	if (!imx_rpmsg_is_buf_ref(msg, len))
+		return ERR_PTR(-ENOMSG);
+
+	offset = le32_to_cpu(ref->offset);
+
+	xa_lock(&pool->bufs);
+	buf = imx_rpmsg_buf_find(pool, offset);
+	if (!buf || !buf->remote || le32_to_cpu(ref->len) > buf->size) {
+		ret = -EINVAL;
+	} else {
+		buf->remote = false;
+		orphan = buf->orphan;
+		if (orphan)
+			__xa_erase(&pool->bufs, offset >> PAGE_SHIFT);
+	}
+	xa_unlock(&pool->bufs);
+
+	if (ret)
+		return ERR_PTR(ret);
+
+	if (orphan) {
+		imx_rpmsg_buf_destroy(pool, buf);
+		return ERR_PTR(-ENOENT);
+	}
+
+	/* don't let reads of the data pass the reference */
+	rmb();
+
+	return pool->vaddr + offset;
+}
+EXPORT_SYMBOL_GPL(imx_rpmsg_buf_recv);
+
+/**
+ * imx_rpmsg_buf_release_owner() - free all buffers of a user
+ * @rpdev: rpmsg device the buffers were allocated for
+ * @owner: cookie given to imx_rpmsg_buf_alloc()
+ *
+ * Buffers owned by the remote are freed when it hands them back.
+ */
+void imx_rpmsg_buf_release_owner(struct rpmsg_device *rpdev, void *owner)
+{
+	struct imx_rpmsg_pool *pool = imx_rpmsg_get_pool(rpdev);
+	struct imx_rpmsg_buf *buf;
+	unsigned long index;
+
+	if (!pool)
+		return;
+
+	xa_lock(&pool->bufs);
+	xa_for_each(&pool->bufs, index, buf) {
+		if (buf->owner != owner)
+			continue;
+
+		if (buf->remote) {
+			buf->orphan = true;
+			continue;
+		}
+
+		__xa_erase(&pool->bufs, index);
+		imx_rpmsg_buf_destroy(pool, buf);
+	}
+	xa_unlock(&pool->bufs);
+}
+EXPORT_SYMBOL_GPL(imx_rpmsg_buf_release_owner);
+
+/**
+ * imx_rpmsg_pool_mmap() - map the shared pool to userspace
+ * @rpdev: rpmsg device of an i.MX remote processor
+ * @vma: the mapping, whose offset is the offset in the pool
+ *
+ * Return: 0 on success or a negative error code.
+ */
+int imx_rpmsg_pool_mmap(struct rpmsg_device *rpdev, struct vm_area_struct *vma)
+{
+	struct imx_rpmsg_pool *pool = imx_rpmsg_get_pool(rpdev);
+	unsigned long size = vma->vm_end - vma->vm_start;
+	unsigned long off = vma->vm_pgoff << PAGE_SHIFT;
+
+	if (!pool)
+		return -ENODEV;
+
+	if (off >= pool->size || size > pool->size - off)
+		return -EINVAL;
+
+	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+
+	return remap_pfn_range(vma, vma->vm_start,
+			       PHYS_PFN(pool->paddr) + vma->vm_pgoff,
+			       size, vma->vm_page_prot);
+}
+EXPORT_SYMBOL_GPL(imx_rpmsg_pool_mmap);
+
+static int imx_rpmsg_pool_init(struct imx_rpmsg_vproc *rpdev)
+{
+	struct device *dev = &rpdev->pdev->dev;
+	struct imx_rpmsg_pool *pool;
+	struct reserved_mem *rmem;
+	struct device_node *np;
+	int ret;
+
+	np = of_parse_phandle(dev->of_node, "fsl,rpmsg-pool", 0);
+	if (!np)
+		return 0;
+
+	rmem = of_reserved_mem_lookup(np);
+	of_node_put(np);
+	if (!rmem || !PAGE_ALIGNED(rmem->base) || rmem->size < PAGE_SIZE) {
+		dev_err(dev, "invalid rpmsg buffer pool\n");
+		return -EINVAL;
+	}
+
+	pool = devm_kzalloc(dev, sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return -ENOMEM;
+
+	/* the M core is not coherent with us */
+	pool->vaddr = devm_memremap(dev, rmem->base, rmem->size, MEMREMAP_WC);
+	if (IS_ERR(pool->vaddr))
+		return PTR_ERR(pool->vaddr);
+
+	pool->gen = devm_gen_pool_create(dev, PAGE_SHIFT, -1, "rpmsg-pool");
+	if (IS_ERR(pool->gen))
+		return PTR_ERR(pool->gen);
+
+	ret = gen_pool_add_virt(pool->gen, (unsigned long)pool->vaddr,
+				rmem->base, rmem->size, -1);
+	if (ret)
+		return ret;
+
+	pool->paddr = rmem->base;
+	pool->size = rmem->size;
+	xa_init(&pool->bufs);
+	rpdev->pool = pool;
+
+	dev_info(dev, "rpmsg buffer pool of %pa bytes at %pa\n",
+		 &rmem->size, &rmem->base);
+
+	return 0;
+}
+
+static void imx_rpmsg_rx_account(struct imx_rpmsg_vproc *rpdev, ktime_t stamp)
+{
+	struct imx_rpmsg_rx_stats *st = &rpdev->rx_stats;
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), stamp));
+	u64 us = div_u64(ns, NSEC_PER_USEC);
+
+	if (!st->count || ns < st->min_ns)
+		st->min_ns = ns;
+	if (ns > st->max_ns)
+		st->max_ns = ns;
+	st->total_ns += ns;
+	st->count++;
+	st->buckets[min_t(u32, us ? ilog2(us) + 1 : 0,
+			  IMX_RPMSG_LAT_BUCKETS - 1)]++;
+}
+
+/*
+ * Runs in a SCHED_FIFO kthread rather than on the system workqueue, so a
+ * kick from the remote does not queue up behind unrelated work. Kicks for
+ * the same virtqueue coalesce until it is serviced, and each callback
+ * drains the whole vring.
+ */
+static void imx_rpmsg_rx_work(struct kthread_work *work)
+{
+	struct imx_rpmsg_vproc *rpdev = container_of(work,
+			struct imx_rpmsg_vproc, rx_work);
+	ktime_t stamp[MAX_VQ_NUMS];
+	int budget = IMX_RPMSG_RX_BUDGET;
+	struct imx_virdev *virdev;
+	unsigned long pending;
+	unsigned long flags;
+	unsigned int id, index;
+
+	while (budget > 0) {
 		spin_lock_irqsave(&rpdev->mu_lock, flags);
-		cb->tail = CIRC_ADD(cb->tail, PAGE_SIZE, 4);
+		pending = rpdev->rx_pending;
+		rpdev->rx_pending = 0;
+		memcpy(stamp, rpdev->rx_stamp, sizeof(stamp));
+		spin_unlock_irqrestore(&rpdev->mu_lock, flags);
+
+		if (!pending)
+			return;
+
+		for_each_set_bit(id, &pending, MAX_VQ_NUMS) {
+			imx_rpmsg_rx_account(rpdev, stamp[id]);
+			budget--;
+
+			virdev = rpdev->ivdev[id / 2];
+			if (!virdev)
+				continue;
+			index = id - virdev->base_vq_id;
+
+			/*
+			 * Currently both PENDING_MSG and explicit-virtqueue-index
+			 * messaging are supported.
+			 * Whatever approach is taken, at this point index is
+			 * the index of the vring which was just triggered.
+			 */
+			if (index < virdev->num_of_vqs)
+				vring_interrupt(index, virdev->vq[index]);
+		}
 	}
-	spin_unlock_irqrestore(&rpdev->mu_lock, flags);
+
+	/* out of budget, let others run and come back */
+	kthread_queue_work(rpdev->rx_worker, &rpdev->rx_work);
+}
+
+static int imx_rpmsg_rx_latency_show(struct seq_file *s, void *unused)
+{
+	struct imx_rpmsg_vproc *rpdev = s->private;
+	struct imx_rpmsg_rx_stats *st = &rpdev->rx_stats;
+	int i;
+
+	seq_printf(s, "count: %llu\n", st->count);
+	if (!st->count)
+		return 0;
+
+	seq_printf(s, "min: %llu ns\nmax: %llu ns\navg: %llu ns\n",
+		   st->min_ns, st->max_ns, div64_u64(st->total_ns, st->count));
+	for (i = 0; i < IMX_RPMSG_LAT_BUCKETS; i++)
+		if (st->buckets[i])
+			seq_printf(s, "<%6u us: %llu\n", 1U << i, st->buckets[i]);
+
+	return 0;
 }
+DEFINE_SHOW_ATTRIBUTE(imx_rpmsg_rx_latency);
 
 #ifdef CONFIG_IMX_SCU
 static void imx_rpmsg_restore(struct imx_rpmsg_vproc *rpdev)
@@ -468,27 +908,24 @@ static int imx_rpmsg_rxdb_channel_init(struct imx_rpmsg_vproc *rpdev)
 
 static void imx_rpmsg_rx_callback(struct mbox_client *c, void *msg)
 {
-	int buf_space;
 	u32 *data = msg;
 	struct imx_rpmsg_vproc *rpdev = container_of(c,
 			struct imx_rpmsg_vproc, cl);
-	struct circ_buf *cb = &rpdev->rx_buffer;
+	unsigned int id = *data >> 16;
 
-	spin_lock(&rpdev->mu_lock);
-	buf_space = CIRC_SPACE(cb->head, cb->tail, PAGE_SIZE);
-	if (unlikely(!buf_space)) {
-		dev_err(c->dev, "RPMSG RX overflow!\n");
-		spin_unlock(&rpdev->mu_lock);
+	dev_dbg(c->dev, "%s msg: 0x%x\n", __func__, *data);
+
+	if (unlikely(id >= MAX_VQ_NUMS)) {
+		dev_err(c->dev, "RPMSG RX kick for unknown vq %u!\n", id);
 		return;
 	}
-	cb->buf[cb->head] = (u8) *data;
-	cb->buf[cb->head + 1] = (u8) (*data >> 8);
-	cb->buf[cb->head + 2] = (u8) (*data >> 16);
-	cb->buf[cb->head + 3] = (u8) (*data >> 24);
-	cb->head = CIRC_ADD(cb->head, PAGE_SIZE, 4);
+
+	spin_lock(&rpdev->mu_lock);
+	if (!__test_and_set_bit(id, &rpdev->rx_pending))
+		rpdev->rx_stamp[id] = ktime_get();
 	spin_unlock(&rpdev->mu_lock);
 
-	schedule_delayed_work(&(rpdev->rpmsg_work), 0);
+	kthread_queue_work(rpdev->rx_worker, &rpdev->rx_work);
 }
 
 static int imx_rpmsg_xtr_channel_init(struct imx_rpmsg_vproc *rpdev)
@@ -535,15 +972,10 @@ static int imx_rpmsg_probe(struct platform_device *pdev)
 {
 	int j, ret = 0;
 	unsigned long variant;
-	char *buf;
 	struct device *dev = &pdev->dev;
 	struct device_node *np = pdev->dev.of_node;
 	struct imx_rpmsg_vproc *rpdev;
 
-	buf = devm_kzalloc(dev, PAGE_SIZE, GFP_KERNEL);
-	if (!buf)
-		return -ENOMEM;
-
 	rpdev = devm_kzalloc(dev, sizeof(*rpdev), GFP_KERNEL);
 	if (!rpdev)
 		return -ENOMEM;
@@ -554,17 +986,19 @@ static int imx_rpmsg_probe(struct platform_device *pdev)
 #endif
 	variant = (uintptr_t)of_device_get_match_data(dev);
 	rpdev->variant = (enum imx_rpmsg_variants)variant;
-	rpdev->rx_buffer.buf = buf;
-	rpdev->rx_buffer.head = 0;
-	rpdev->rx_buffer.tail = 0;
+	spin_lock_init(&rpdev->mu_lock);
+	kthread_init_work(&rpdev->rx_work, imx_rpmsg_rx_work);
+
+	rpdev->rx_worker = kthread_create_worker(0, "%s", dev_name(dev));
+	if (IS_ERR(rpdev->rx_worker))
+		return PTR_ERR(rpdev->rx_worker);
+	sched_set_fifo(rpdev->rx_worker->task);
 
 	/* Initialize the RX/TX channels. */
 	ret = imx_rpmsg_xtr_channel_init(rpdev);
 	if (ret)
-		return ret;
+		goto err_worker;
 
-	spin_lock_init(&rpdev->mu_lock);
-	INIT_DELAYED_WORK(&(rpdev->rpmsg_work), rpmsg_work_handler);
 	ret = of_property_read_u32(np, "vdev-nums", &rpdev->vdev_nums);
 	if (ret)
 		rpdev->vdev_nums = 1;
@@ -581,6 +1015,10 @@ static int imx_rpmsg_probe(struct platform_device *pdev)
 		ret = -ENOMEM;
 		goto err_chl;
 	}
+
+	ret = imx_rpmsg_pool_init(rpdev);
+	if (ret)
+		goto err_chl;
 	if (of_reserved_mem_device_init(dev)) {
 		dev_dbg(dev, "dev doesn't have specific DMA pool.\n");
 		rpdev->flags &= (~SPECIFIC_DMA_POOL);
@@ -614,6 +1052,11 @@ static int imx_rpmsg_probe(struct platform_device *pdev)
 
 	platform_set_drvdata(pdev, rpdev);
 
+	rpdev->debugfs = debugfs_create_dir(dev_name(dev),
+					    imx_rpmsg_debugfs_root);
+	debugfs_create_file("rx_latency", 0400, rpdev->debugfs, rpdev,
+			    &imx_rpmsg_rx_latency_fops);
+
 #ifdef CONFIG_IMX_SCU
 	if (rpdev->variant == IMX8QXP || rpdev->variant == IMX8QM) {
 		/* Get muB partition id and enable irq in SCFW then */
@@ -650,6 +1093,8 @@ static int imx_rpmsg_probe(struct platform_device *pdev)
 		mbox_free_channel(rpdev->tx_ch);
 	if (!IS_ERR(rpdev->rx_ch))
 		mbox_free_channel(rpdev->rx_ch);
+err_worker:
+	kthread_destroy_worker(rpdev->rx_worker);
 	return ret;
 }
 
@@ -666,6 +1111,8 @@ static int __init imx_rpmsg_init(void)
 {
 	int ret;
 
+	imx_rpmsg_debugfs_root = debugfs_create_dir("imx_rpmsg", NULL);
+
 	ret = platform_driver_register(&imx_rpmsg_driver);
 	if (ret)
 		pr_err("Unable to initialize rpmsg driver\n");
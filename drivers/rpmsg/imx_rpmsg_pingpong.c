@@ -3,19 +3,56 @@
  * Copyright 2019 NXP
  */
 
+#include <linux/completion.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
 #include <linux/virtio.h>
 #include <linux/rpmsg.h>
 
 #define MSG		"hello world!"
+#define BENCH_TIMEOUT	msecs_to_jiffies(1000)
+
+/*
+ * struct rpmsg_pingpong - benchmark state of a pingpong channel
+ * @lock:	serializes benchmark runs and their results
+ * @running:	replies are consumed by the benchmark, not answered
+ * @done:	completed by the reply to the last ping
+ * @count:	number of round trips of the last run
+ * @size:	payload size of the last run
+ * @min, @max, @total:	round trip times of the last run
+ * @lost:	pings without a reply within BENCH_TIMEOUT
+ */
+struct rpmsg_pingpong {
+	struct mutex lock;
+	bool running;
+	struct completion done;
+	unsigned int count;
+	unsigned int size;
+	u64 min;
+	u64 max;
+	u64 total;
+	unsigned int lost;
+};
 
 static int rpmsg_pingpong_cb(struct rpmsg_device *rpdev, void *data, int len,
 						void *priv, u32 src)
 {
+	struct rpmsg_pingpong *pp = dev_get_drvdata(&rpdev->dev);
 	int err;
 	unsigned int rpmsg_pingpong;
 
+	if (READ_ONCE(pp->running)) {
+		complete(&pp->done);
+		return 0;
+	}
+
+	if (len < sizeof(rpmsg_pingpong))
+		return 0;
+
 	/* reply */
 	rpmsg_pingpong = *(unsigned int *)data;
 	pr_info("get %d (src: 0x%x)\n", rpmsg_pingpong, src);
@@ -34,14 +71,124 @@ static int rpmsg_pingpong_cb(struct rpmsg_device *rpdev, void *data, int len,
 	return err;
 }
 
+/*
+ * Write "<count> <size>" to run @count round trips of @size byte pings,
+ * read back the round trip times and the resulting message and payload
+ * rates. The remote answers every ping with one message.
+ */
+static ssize_t bench_store(struct device *dev, struct device_attribute *attr,
+			   const char *buf, size_t len)
+{
+	struct rpmsg_device *rpdev = to_rpmsg_device(dev);
+	struct rpmsg_pingpong *pp = dev_get_drvdata(dev);
+	unsigned int count, size, i;
+	ktime_t start;
+	ssize_t mtu;
+	void *msg;
+	u64 rtt;
+	int ret;
+
+	if (sscanf(buf, "%u %u", &count, &size) != 2 || !count)
+		return -EINVAL;
+
+	mtu = rpmsg_get_mtu(rpdev->ept);
+	if (size < sizeof(u32) || (mtu > 0 && size > mtu))
+		return -EINVAL;
+
+	msg = kzalloc(size, GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+
+	mutex_lock(&pp->lock);
+	pp->count = 0;
+	pp->size = size;
+	pp->min = U64_MAX;
+	pp->max = 0;
+	pp->total = 0;
+	pp->lost = 0;
+	WRITE_ONCE(pp->running, true);
+
+	for (i = 0; i < count; i++) {
+		*(u32 *)msg = i;
+		reinit_completion(&pp->done);
+
+		start = ktime_get();
+		ret = rpmsg_send(rpdev->ept, msg, size);
+		if (ret)
+			break;
+
+		if (!wait_for_completion_timeout(&pp->done, BENCH_TIMEOUT)) {
+			pp->lost++;
+			continue;
+		}
+
+		rtt = ktime_to_ns(ktime_sub(ktime_get(), start));
+		pp->min = min(pp->min, rtt);
+		pp->max = max(pp->max, rtt);
+		pp->total += rtt;
+		pp->count++;
+	}
+
+	WRITE_ONCE(pp->running, false);
+	mutex_unlock(&pp->lock);
+	kfree(msg);
+
+	if (ret)
+		dev_err(dev, "rpmsg_send failed: %d\n", ret);
+
+	return ret ? ret : len;
+}
+
+static ssize_t bench_show(struct device *dev, struct device_attribute *attr,
+			  char *buf)
+{
+	struct rpmsg_pingpong *pp = dev_get_drvdata(dev);
+	u64 avg, rate;
+	ssize_t len;
+
+	mutex_lock(&pp->lock);
+	if (!pp->count) {
+		len = sysfs_emit(buf, "count 0 lost %u\n", pp->lost);
+		goto out;
+	}
+
+	avg = div_u64(pp->total, pp->count);
+	rate = div64_u64((u64)pp->count * NSEC_PER_SEC, pp->total);
+	len = sysfs_emit(buf,
+			 "count %u size %u lost %u\n"
+			 "rtt_ns min %llu avg %llu max %llu\n"
+			 "msgs/s %llu bytes/s %llu\n",
+			 pp->count, pp->size, pp->lost,
+			 pp->min, avg, pp->max,
+			 rate, rate * pp->size);
+out:
+	mutex_unlock(&pp->lock);
+
+	return len;
+}
+static DEVICE_ATTR_RW(bench);
+
 static int rpmsg_pingpong_probe(struct rpmsg_device *rpdev)
 {
+	struct rpmsg_pingpong *pp;
 	int err;
 	unsigned int rpmsg_pingpong;
 
 	dev_info(&rpdev->dev, "new channel: 0x%x -> 0x%x!\n",
 			rpdev->src, rpdev->dst);
 
+	pp = devm_kzalloc(&rpdev->dev, sizeof(*pp), GFP_KERNEL);
+	if (!pp)
+		return -ENOMEM;
+
+	mutex_init(&pp->lock);
+	init_completion(&pp->done);
+	dev_set_drvdata(&rpdev->dev, pp);
+
+	err = device_create_file(&rpdev->dev, &dev_attr_bench);
+	if (err)
+		return err;
+
 	/*
 	 * send a message to our remote processor, and tell remote
 	 * processor about this channel
@@ -49,7 +196,7 @@ static int rpmsg_pingpong_probe(struct rpmsg_device *rpdev)
 	err = rpmsg_send(rpdev->ept, MSG, strlen(MSG));
 	if (err) {
 		dev_err(&rpdev->dev, "rpmsg_send failed: %d\n", err);
-		return err;
+		goto err_file;
 	}
 
 	rpmsg_pingpong = 0;
@@ -57,14 +204,19 @@ static int rpmsg_pingpong_probe(struct rpmsg_device *rpdev)
 			   4, rpdev->dst);
 	if (err) {
 		dev_err(&rpdev->dev, "rpmsg_send failed: %d\n", err);
-		return err;
+		goto err_file;
 	}
 
 	return 0;
+
+err_file:
+	device_remove_file(&rpdev->dev, &dev_attr_bench);
+	return err;
 }
 
 static void rpmsg_pingpong_remove(struct rpmsg_device *rpdev)
 {
+	device_remove_file(&rpdev->dev, &dev_attr_bench);
 	dev_info(&rpdev->dev, "rpmsg pingpong driver is removed\n");
 }
 
@@ -6,26 +6,40 @@
 #include <linux/slab.h>
 #include <linux/delay.h>
 #include <linux/kernel.h>
+#include <linux/kfifo.h>
 #include <linux/module.h>
 #include <linux/rpmsg.h>
 #include <linux/tty.h>
 #include <linux/tty_driver.h>
 #include <linux/tty_flip.h>
 #include <linux/virtio.h>
+#include <linux/workqueue.h>
 
 /* this needs to be less then (RPMSG_BUF_SIZE - sizeof(struct rpmsg_hdr)) */
 #define RPMSG_MAX_SIZE		256
+#define RPMSG_TTY_FIFO_SIZE	8192
 #define MSG		"hello world!"
 
 /*
  * struct rpmsgtty_port - Wrapper struct for imx rpmsg tty port.
  * @port:		TTY port data
+ * @tx_fifo:		data written to the tty, not sent yet
+ * @tx_lock:		protects @tx_fifo and @tx_flushed
+ * @tx_flushed:		@tx_fifo was flushed while a packet was sent
+ * @tx_work:		drains @tx_fifo in packets of @tx_size bytes
+ * @tx_buf:		packet being sent by @tx_work
  */
 struct rpmsgtty_port {
 	struct tty_port		port;
 	spinlock_t		rx_lock;
 	struct rpmsg_device	*rpdev;
 	struct tty_driver	*rpmsgtty_driver;
+	DECLARE_KFIFO(tx_fifo, u8, RPMSG_TTY_FIFO_SIZE);
+	spinlock_t		tx_lock;
+	bool			tx_flushed;
+	struct work_struct	tx_work;
+	unsigned int		tx_size;
+	u8			*tx_buf;
 };
 
 static int rpmsg_tty_cb(struct rpmsg_device *rpdev, void *data, int len,
@@ -78,46 +92,111 @@ static void rpmsgtty_close(struct tty_struct *tty, struct file *filp)
 	return tty_port_close(tty->port, tty, filp);
 }
 
+/*
+ * Send the written data in packets as large as the rpmsg buffers. Sending
+ * sleeps until the remote returns a TX buffer, so the rate of the tty is
+ * paced by the TX completions of the vring rather than by the writers.
+ */
+static void rpmsgtty_tx_work(struct work_struct *work)
+{
+	struct rpmsgtty_port *cport = container_of(work, struct rpmsgtty_port,
+						   tx_work);
+	struct rpmsg_device *rpdev = cport->rpdev;
+	unsigned long flags;
+	unsigned int len;
+	int ret;
+
+	for (;;) {
+		spin_lock_irqsave(&cport->tx_lock, flags);
+		len = kfifo_out_peek(&cport->tx_fifo, cport->tx_buf,
+				     cport->tx_size);
+		cport->tx_flushed = false;
+		spin_unlock_irqrestore(&cport->tx_lock, flags);
+
+		if (!len)
+			break;
+
+		ret = rpmsg_send(rpdev->ept, cport->tx_buf, len);
+		if (ret) {
+			/* keep the data, the next write retries */
+			dev_err_ratelimited(&rpdev->dev,
+					    "rpmsg_send failed: %d\n", ret);
+			break;
+		}
+
+		spin_lock_irqsave(&cport->tx_lock, flags);
+		if (!cport->tx_flushed)
+			kfifo_skip_count(&cport->tx_fifo, len);
+		spin_unlock_irqrestore(&cport->tx_lock, flags);
+
+		tty_port_tty_wakeup(&cport->port);
+	}
+}
+
 static ssize_t rpmsgtty_write(struct tty_struct *tty, const unsigned char *buf,
 			 size_t total)
 {
-	int count, ret = 0;
-	const unsigned char *tbuf;
 	struct rpmsgtty_port *rptty_port = container_of(tty->port,
 			struct rpmsgtty_port, port);
-	struct rpmsg_device *rpdev = rptty_port->rpdev;
+	unsigned long flags;
+	unsigned int count;
 
 	if (buf == NULL) {
 		pr_err("buf shouldn't be null.\n");
 		return -ENOMEM;
 	}
 
-	count = total;
-	tbuf = buf;
-	do {
-		/* send a message to our remote processor */
-		ret = rpmsg_send(rpdev->ept, (void *)tbuf,
-			count > RPMSG_MAX_SIZE ? RPMSG_MAX_SIZE : count);
-		if (ret) {
-			dev_err(&rpdev->dev, "rpmsg_send failed: %d\n", ret);
-			return ret;
-		}
+	spin_lock_irqsave(&rptty_port->tx_lock, flags);
+	count = kfifo_in(&rptty_port->tx_fifo, buf, total);
+	spin_unlock_irqrestore(&rptty_port->tx_lock, flags);
 
-		if (count > RPMSG_MAX_SIZE) {
-			count -= RPMSG_MAX_SIZE;
-			tbuf += RPMSG_MAX_SIZE;
-		} else {
-			count = 0;
-		}
-	} while (count > 0);
+	if (count)
+		schedule_work(&rptty_port->tx_work);
 
-	return total;
+	return count;
 }
 
 static unsigned int rpmsgtty_write_room(struct tty_struct *tty)
 {
-	/* report the space in the rpmsg buffer */
-	return RPMSG_MAX_SIZE;
+	struct rpmsgtty_port *rptty_port = container_of(tty->port,
+			struct rpmsgtty_port, port);
+	unsigned long flags;
+	unsigned int room;
+
+	/* the fifo only drains as the remote returns TX buffers */
+	spin_lock_irqsave(&rptty_port->tx_lock, flags);
+	room = kfifo_avail(&rptty_port->tx_fifo);
+	spin_unlock_irqrestore(&rptty_port->tx_lock, flags);
+
+	return room;
+}
+
+static unsigned int rpmsgtty_chars_in_buffer(struct tty_struct *tty)
+{
+	struct rpmsgtty_port *rptty_port = container_of(tty->port,
+			struct rpmsgtty_port, port);
+	unsigned long flags;
+	unsigned int len;
+
+	spin_lock_irqsave(&rptty_port->tx_lock, flags);
+	len = kfifo_len(&rptty_port->tx_fifo);
+	spin_unlock_irqrestore(&rptty_port->tx_lock, flags);
+
+	return len;
+}
+
+static void rpmsgtty_flush_buffer(struct tty_struct *tty)
+{
+	struct rpmsgtty_port *rptty_port = container_of(tty->port,
+			struct rpmsgtty_port, port);
+	unsigned long flags;
+
+	spin_lock_irqsave(&rptty_port->tx_lock, flags);
+	kfifo_reset(&rptty_port->tx_fifo);
+	rptty_port->tx_flushed = true;
+	spin_unlock_irqrestore(&rptty_port->tx_lock, flags);
+
+	tty_wakeup(tty);
 }
 
 static const struct tty_operations imxrpmsgtty_ops = {
@@ -126,11 +205,14 @@ static const struct tty_operations imxrpmsgtty_ops = {
 	.close			= rpmsgtty_close,
 	.write			= rpmsgtty_write,
 	.write_room		= rpmsgtty_write_room,
+	.chars_in_buffer	= rpmsgtty_chars_in_buffer,
+	.flush_buffer		= rpmsgtty_flush_buffer,
 };
 
 static int rpmsg_tty_probe(struct rpmsg_device *rpdev)
 {
 	int ret;
+	ssize_t mtu;
 	struct rpmsgtty_port *cport;
 	struct tty_driver *rpmsgtty_driver;
 
@@ -141,6 +223,16 @@ static int rpmsg_tty_probe(struct rpmsg_device *rpdev)
 	if (!cport)
 		return -ENOMEM;
 
+	mtu = rpmsg_get_mtu(rpdev->ept);
+	cport->tx_size = mtu > 0 ? mtu : RPMSG_MAX_SIZE;
+	cport->tx_buf = devm_kmalloc(&rpdev->dev, cport->tx_size, GFP_KERNEL);
+	if (!cport->tx_buf)
+		return -ENOMEM;
+
+	INIT_KFIFO(cport->tx_fifo);
+	spin_lock_init(&cport->tx_lock);
+	INIT_WORK(&cport->tx_work, rpmsgtty_tx_work);
+
 	rpmsgtty_driver = tty_alloc_driver(1, TTY_DRIVER_UNNUMBERED_NODE);
 	if (IS_ERR(rpmsgtty_driver)) {
 		kfree(cport);
@@ -201,6 +293,7 @@ static void rpmsg_tty_remove(struct rpmsg_device *rpdev)
 
 	dev_info(&rpdev->dev, "rpmsg tty driver is removed\n");
 
+	cancel_work_sync(&cport->tx_work);
 	tty_unregister_driver(cport->rpmsgtty_driver);
 	kfree(cport->rpmsgtty_driver->name);
 	tty_driver_kref_put(cport->rpmsgtty_driver);
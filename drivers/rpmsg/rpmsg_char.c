@@ -17,6 +17,7 @@
 #include <linux/device.h>
 #include <linux/fs.h>
 #include <linux/idr.h>
+#include <linux/imx_rpmsg.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/poll.h>
@@ -79,6 +80,7 @@ int rpmsg_chrdev_eptdev_destroy(struct device *dev, void *data)
 	struct rpmsg_eptdev *eptdev = dev_to_eptdev(dev);
 
 	mutex_lock(&eptdev->ept_lock);
+	imx_rpmsg_buf_release_owner(eptdev->rpdev, eptdev);
 	eptdev->rpdev = NULL;
 	if (eptdev->ept) {
 		/* The default endpoint is released by the rpmsg core */
@@ -103,6 +105,17 @@ static int rpmsg_ept_cb(struct rpmsg_device *rpdev, void *buf, int len,
 {
 	struct rpmsg_eptdev *eptdev = priv;
 	struct sk_buff *skb;
+	void *data;
+
+	/* take back pool buffers, the reference itself goes to the reader */
+	if (imx_rpmsg_is_buf_ref(buf, len)) {
+		data = imx_rpmsg_buf_recv(rpdev, buf, len);
+		if (IS_ERR(data) && PTR_ERR(data) != -ENODEV) {
+			dev_dbg(&eptdev->dev, "dropped buffer reference: %ld\n",
+				PTR_ERR(data));
+			return 0;
+		}
+	}
 
 	skb = alloc_skb(len, GFP_ATOMIC);
 	if (!skb)
@@ -188,6 +201,8 @@ static int rpmsg_eptdev_release(struct inode *inode, struct file *filp)
 			rpmsg_destroy_ept(eptdev->ept);
 		eptdev->ept = NULL;
 	}
+	if (eptdev->rpdev)
+		imx_rpmsg_buf_release_owner(eptdev->rpdev, eptdev);
 	mutex_unlock(&eptdev->ept_lock);
 	eptdev->remote_flow_updated = false;
 
@@ -313,6 +328,60 @@ static __poll_t rpmsg_eptdev_poll(struct file *filp, poll_table *wait)
 	return mask;
 }
 
+static int rpmsg_eptdev_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct rpmsg_eptdev *eptdev = filp->private_data;
+	int ret;
+
+	mutex_lock(&eptdev->ept_lock);
+	if (eptdev->rpdev)
+		ret = imx_rpmsg_pool_mmap(eptdev->rpdev, vma);
+	else
+		ret = -EPIPE;
+	mutex_unlock(&eptdev->ept_lock);
+
+	return ret;
+}
+
+static long rpmsg_eptdev_pool_ioctl(struct rpmsg_eptdev *eptdev,
+				    unsigned int cmd, void __user *argp)
+{
+	struct rpmsg_pool_buf pbuf;
+	void *vaddr;
+	int ret;
+
+	if (copy_from_user(&pbuf, argp, sizeof(pbuf)))
+		return -EFAULT;
+
+	mutex_lock(&eptdev->ept_lock);
+	if (!eptdev->ept || !eptdev->rpdev) {
+		mutex_unlock(&eptdev->ept_lock);
+		return -EPIPE;
+	}
+
+	switch (cmd) {
+	case RPMSG_POOL_ALLOC_IOCTL:
+		vaddr = imx_rpmsg_buf_alloc(eptdev->rpdev, pbuf.len,
+					    &pbuf.offset, eptdev);
+		ret = PTR_ERR_OR_ZERO(vaddr);
+		if (!ret && copy_to_user(argp, &pbuf, sizeof(pbuf))) {
+			imx_rpmsg_buf_free(eptdev->rpdev, pbuf.offset, eptdev);
+			ret = -EFAULT;
+		}
+		break;
+	case RPMSG_POOL_FREE_IOCTL:
+		ret = imx_rpmsg_buf_free(eptdev->rpdev, pbuf.offset, eptdev);
+		break;
+	default:
+		ret = imx_rpmsg_buf_send(eptdev->ept, eptdev->chinfo.dst,
+					 pbuf.offset, pbuf.len, 0, eptdev);
+		break;
+	}
+	mutex_unlock(&eptdev->ept_lock);
+
+	return ret;
+}
+
 static long rpmsg_eptdev_ioctl(struct file *fp, unsigned int cmd,
 			       unsigned long arg)
 {
@@ -342,6 +411,11 @@ static long rpmsg_eptdev_ioctl(struct file *fp, unsigned int cmd,
 		}
 		ret = rpmsg_chrdev_eptdev_destroy(&eptdev->dev, NULL);
 		break;
+	case RPMSG_POOL_ALLOC_IOCTL:
+	case RPMSG_POOL_FREE_IOCTL:
+	case RPMSG_POOL_SEND_IOCTL:
+		ret = rpmsg_eptdev_pool_ioctl(eptdev, cmd, (void __user *)arg);
+		break;
 	default:
 		ret = -EINVAL;
 	}
@@ -356,6 +430,7 @@ static const struct file_operations rpmsg_eptdev_fops = {
 	.read_iter = rpmsg_eptdev_read_iter,
 	.write_iter = rpmsg_eptdev_write_iter,
 	.poll = rpmsg_eptdev_poll,
+	.mmap = rpmsg_eptdev_mmap,
 	.unlocked_ioctl = rpmsg_eptdev_ioctl,
 	.compat_ioctl = compat_ptr_ioctl,
 };
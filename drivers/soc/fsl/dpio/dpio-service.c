@@ -47,8 +47,24 @@ struct dpaa2_io_store {
 	unsigned int idx;      /* position of the next-to-be-returned entry */
 	struct qbman_swp *swp; /* portal used to issue VDQCR */
 	struct device *dev;    /* device used for DMA mapping */
+
+	/* Double-buffered stores only: while the results in 'vaddr' are being
+	 * parsed, the next pull may already be issued into the shadow area.
+	 * The two areas are swapped by the next pull call.
+	 */
+	dma_addr_t shadow_paddr;
+	struct dpaa2_dq *shadow_vaddr;
+	void *shadow_alloced_addr;
+	struct qbman_pull_desc pd; /* last pull, reissued into the shadow */
+	bool pull_ahead;       /* consumer allows the next pull to go early */
+	bool pending;          /* results are on their way into the shadow */
 };
 
+/* Number of dequeue results prefetched ahead of the one being returned, for
+ * double-buffered stores
+ */
+#define DPAA2_IO_STORE_PREFETCH	4
+
 /* keep a per cpu array of DPIOs for fast access */
 static struct dpaa2_io *dpio_by_cpu[NR_CPUS];
 static struct list_head dpio_list = LIST_HEAD_INIT(dpio_list);
@@ -384,6 +400,43 @@ int dpaa2_io_service_rearm(struct dpaa2_io *d,
 }
 EXPORT_SYMBOL_GPL(dpaa2_io_service_rearm);
 
+static void dpaa2_io_store_swap(struct dpaa2_io_store *s)
+{
+	swap(s->vaddr, s->shadow_vaddr);
+	swap(s->paddr, s->shadow_paddr);
+	swap(s->alloced_addr, s->shadow_alloced_addr);
+	s->pending = false;
+}
+
+static int dpaa2_io_store_pull(struct dpaa2_io *d, struct dpaa2_io_store *s,
+			       struct qbman_pull_desc *pd)
+{
+	int err;
+
+	/* The pull has already been issued from dpaa2_io_store_next(); its
+	 * results land (or have landed) in the shadow area.
+	 */
+	if (s->pending) {
+		dpaa2_io_store_swap(s);
+		return 0;
+	}
+
+	d = service_select(d);
+	if (!d)
+		return -ENODEV;
+
+	qbman_pull_desc_set_storage(pd, s->vaddr, s->paddr, 1);
+	if (s->shadow_vaddr)
+		s->pd = *pd;
+
+	s->swp = d->swp;
+	err = qbman_swp_pull(d->swp, pd);
+	if (err)
+		s->swp = NULL;
+
+	return err;
+}
+
 /**
  * dpaa2_io_service_pull_fq() - pull dequeue functions from a fq.
  * @d: the given DPIO service.
@@ -396,22 +449,12 @@ int dpaa2_io_service_pull_fq(struct dpaa2_io *d, u32 fqid,
 			     struct dpaa2_io_store *s)
 {
 	struct qbman_pull_desc pd;
-	int err;
 
 	qbman_pull_desc_clear(&pd);
-	qbman_pull_desc_set_storage(&pd, s->vaddr, s->paddr, 1);
 	qbman_pull_desc_set_numframes(&pd, (u8)s->max);
 	qbman_pull_desc_set_fq(&pd, fqid);
 
-	d = service_select(d);
-	if (!d)
-		return -ENODEV;
-	s->swp = d->swp;
-	err = qbman_swp_pull(d->swp, &pd);
-	if (err)
-		s->swp = NULL;
-
-	return err;
+	return dpaa2_io_store_pull(d, s, &pd);
 }
 EXPORT_SYMBOL(dpaa2_io_service_pull_fq);
 
@@ -427,23 +470,12 @@ int dpaa2_io_service_pull_channel(struct dpaa2_io *d, u32 channelid,
 				  struct dpaa2_io_store *s)
 {
 	struct qbman_pull_desc pd;
-	int err;
 
 	qbman_pull_desc_clear(&pd);
-	qbman_pull_desc_set_storage(&pd, s->vaddr, s->paddr, 1);
 	qbman_pull_desc_set_numframes(&pd, (u8)s->max);
 	qbman_pull_desc_set_channel(&pd, channelid, qbman_pull_type_prio);
 
-	d = service_select(d);
-	if (!d)
-		return -ENODEV;
-
-	s->swp = d->swp;
-	err = qbman_swp_pull(d->swp, &pd);
-	if (err)
-		s->swp = NULL;
-
-	return err;
+	return dpaa2_io_store_pull(d, s, &pd);
 }
 EXPORT_SYMBOL_GPL(dpaa2_io_service_pull_channel);
 
@@ -638,6 +670,42 @@ EXPORT_SYMBOL_GPL(dpaa2_io_service_acquire);
  * assist with parsing those results.
  */
 
+static int dpaa2_io_store_alloc_area(unsigned int max_frames,
+				     struct device *dev, void **alloced_addr,
+				     struct dpaa2_dq **vaddr, dma_addr_t *paddr)
+{
+	size_t size = max_frames * sizeof(struct dpaa2_dq) + 64;
+	struct dpaa2_dq *area;
+	dma_addr_t addr;
+	void *buf;
+
+	buf = kzalloc(size, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	area = PTR_ALIGN(buf, 64);
+	addr = dma_map_single(dev, area, sizeof(struct dpaa2_dq) * max_frames,
+			      DMA_FROM_DEVICE);
+	if (dma_mapping_error(dev, addr)) {
+		kfree(buf);
+		return -ENOMEM;
+	}
+
+	*alloced_addr = buf;
+	*vaddr = area;
+	*paddr = addr;
+
+	return 0;
+}
+
+static void dpaa2_io_store_free_area(struct dpaa2_io_store *s,
+				     void *alloced_addr, dma_addr_t paddr)
+{
+	dma_unmap_single(s->dev, paddr, sizeof(struct dpaa2_dq) * s->max,
+			 DMA_FROM_DEVICE);
+	kfree(alloced_addr);
+}
+
 /**
  * dpaa2_io_store_create() - Create the dma memory storage for dequeue result.
  * @max_frames: the maximum number of dequeued result for frames, must be <= 32.
@@ -653,29 +721,17 @@ struct dpaa2_io_store *dpaa2_io_store_create(unsigned int max_frames,
 					     struct device *dev)
 {
 	struct dpaa2_io_store *ret;
-	size_t size;
 
 	if (!max_frames || (max_frames > 32))
 		return NULL;
 
-	ret = kmalloc(sizeof(*ret), GFP_KERNEL);
+	ret = kzalloc(sizeof(*ret), GFP_KERNEL);
 	if (!ret)
 		return NULL;
 
 	ret->max = max_frames;
-	size = max_frames * sizeof(struct dpaa2_dq) + 64;
-	ret->alloced_addr = kzalloc(size, GFP_KERNEL);
-	if (!ret->alloced_addr) {
-		kfree(ret);
-		return NULL;
-	}
-
-	ret->vaddr = PTR_ALIGN(ret->alloced_addr, 64);
-	ret->paddr = dma_map_single(dev, ret->vaddr,
-				    sizeof(struct dpaa2_dq) * max_frames,
-				    DMA_FROM_DEVICE);
-	if (dma_mapping_error(dev, ret->paddr)) {
-		kfree(ret->alloced_addr);
+	if (dpaa2_io_store_alloc_area(max_frames, dev, &ret->alloced_addr,
+				      &ret->vaddr, &ret->paddr)) {
 		kfree(ret);
 		return NULL;
 	}
@@ -687,6 +743,82 @@ struct dpaa2_io_store *dpaa2_io_store_create(unsigned int max_frames,
 }
 EXPORT_SYMBOL_GPL(dpaa2_io_store_create);
 
+/**
+ * dpaa2_io_store_create_double() - Create a double-buffered dequeue store.
+ * @max_frames: the maximum number of dequeued result for frames, must be <= 32.
+ * @dev:        the device to allow mapping/unmapping the DMAable region.
+ *
+ * Same as dpaa2_io_store_create(), but with a second result area. Once
+ * dpaa2_io_store_set_pull_ahead() allows it, dpaa2_io_store_next() issues the
+ * next pull-dequeue into the second area as soon as the current one starts
+ * filling up, so that QBMan writes the next batch of results while the
+ * current one is being processed. The following pull call then only swaps
+ * the two areas.
+ *
+ * A double-buffered store must always be pulled from the same FQ/channel.
+ *
+ * Return pointer to dpaa2_io_store struct for successfully created storage
+ * memory, or NULL on error.
+ */
+struct dpaa2_io_store *dpaa2_io_store_create_double(unsigned int max_frames,
+						    struct device *dev)
+{
+	struct dpaa2_io_store *ret;
+
+	ret = dpaa2_io_store_create(max_frames, dev);
+	if (!ret)
+		return NULL;
+
+	if (dpaa2_io_store_alloc_area(max_frames, dev,
+				      &ret->shadow_alloced_addr,
+				      &ret->shadow_vaddr, &ret->shadow_paddr)) {
+		dpaa2_io_store_destroy(ret);
+		return NULL;
+	}
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(dpaa2_io_store_create_double);
+
+/**
+ * dpaa2_io_store_set_pull_ahead() - Allow or forbid issuing the next pull
+ *                                   early on a double-buffered store.
+ * @s:      the dpaa2_io_store object.
+ * @enable: whether the next pull may be issued while parsing current results.
+ *
+ * Frames pulled ahead are only handed to the consumer by its next pull call,
+ * so this must only be enabled when the caller is certain it will pull again
+ * after it finished parsing the current results (e.g. there is enough NAPI
+ * budget left for another full store).
+ */
+void dpaa2_io_store_set_pull_ahead(struct dpaa2_io_store *s, bool enable)
+{
+	s->pull_ahead = enable && s->shadow_vaddr;
+}
+EXPORT_SYMBOL_GPL(dpaa2_io_store_set_pull_ahead);
+
+/* Wait for a pull still in flight into the shadow area to complete, so that
+ * QBMan no longer writes to it. The frames it returned are lost.
+ */
+static void dpaa2_io_store_wait_pending(struct dpaa2_io_store *s)
+{
+	int i, retries;
+
+	for (i = 0; i < s->max; i++) {
+		struct dpaa2_dq *dq = &s->shadow_vaddr[i];
+
+		retries = 1000;
+		while (!qbman_result_has_new_result(s->swp, dq) && --retries)
+			cpu_relax();
+
+		if (!retries || dpaa2_dq_is_pull_complete(dq))
+			break;
+	}
+
+	WARN_ONCE(i, "%d dequeued frames dropped on store destroy\n", i);
+	s->pending = false;
+}
+
 /**
  * dpaa2_io_store_destroy() - Frees the dma memory storage for dequeue
  *                            result.
@@ -694,9 +826,13 @@ EXPORT_SYMBOL_GPL(dpaa2_io_store_create);
  */
 void dpaa2_io_store_destroy(struct dpaa2_io_store *s)
 {
-	dma_unmap_single(s->dev, s->paddr, sizeof(struct dpaa2_dq) * s->max,
-			 DMA_FROM_DEVICE);
-	kfree(s->alloced_addr);
+	if (s->pending)
+		dpaa2_io_store_wait_pending(s);
+
+	if (s->shadow_vaddr)
+		dpaa2_io_store_free_area(s, s->shadow_alloced_addr,
+					 s->shadow_paddr);
+	dpaa2_io_store_free_area(s, s->alloced_addr, s->paddr);
 	kfree(s);
 }
 EXPORT_SYMBOL_GPL(dpaa2_io_store_destroy);
@@ -741,15 +877,71 @@ struct dpaa2_dq *dpaa2_io_store_next(struct dpaa2_io_store *s, int *is_last)
 		 */
 		if (!(dpaa2_dq_flags(ret) & DPAA2_DQ_STAT_VALIDFRAME))
 			ret = NULL;
-	} else {
+		return ret;
+	}
+
+	*is_last = 0;
+
+	if (!s->shadow_vaddr) {
 		prefetch(&s->vaddr[s->idx]);
-		*is_last = 0;
+		return ret;
+	}
+
+	if (s->idx == 1) {
+		int i;
+
+		/* The VDQCR became available again once the first result of
+		 * the current pull showed up, so the next one can go out now.
+		 */
+		if (s->pull_ahead && !s->pending) {
+			struct qbman_pull_desc pd = s->pd;
+
+			qbman_pull_desc_set_storage(&pd, s->shadow_vaddr,
+						    s->shadow_paddr, 1);
+			if (!qbman_swp_pull(s->swp, &pd))
+				s->pending = true;
+		}
+
+		for (i = 1; i < DPAA2_IO_STORE_PREFETCH && i < s->max; i++)
+			prefetch(&s->vaddr[i]);
+	} else if (s->idx + DPAA2_IO_STORE_PREFETCH - 1 < s->max) {
+		prefetch(&s->vaddr[s->idx + DPAA2_IO_STORE_PREFETCH - 1]);
 	}
 
 	return ret;
 }
 EXPORT_SYMBOL_GPL(dpaa2_io_store_next);
 
+/**
+ * dpaa2_io_store_peek() - Look at the dequeue result following the one last
+ *                         returned by dpaa2_io_store_next().
+ * @s: the dpaa2_io_store object.
+ *
+ * Meant for consumers to prefetch what they need of the next frame (e.g. its
+ * annotation area) while still processing the current one.
+ *
+ * Return the next dequeue result if QBMan already wrote it and it carries a
+ * valid frame, or NULL otherwise. The result is not consumed.
+ */
+struct dpaa2_dq *dpaa2_io_store_peek(struct dpaa2_io_store *s)
+{
+	struct dpaa2_dq *dq;
+
+	/* Last result returned completed the pull */
+	if (!s->idx)
+		return NULL;
+
+	dq = &s->vaddr[s->idx];
+	if (!qbman_result_is_written(dq))
+		return NULL;
+
+	if (!(dpaa2_dq_flags(dq) & DPAA2_DQ_STAT_VALIDFRAME))
+		return NULL;
+
+	return dq;
+}
+EXPORT_SYMBOL_GPL(dpaa2_io_store_peek);
+
 /**
  * dpaa2_io_query_fq_count() - Get the frame and byte count for a given fq.
  * @d: the given DPIO object.
@@ -1456,6 +1456,25 @@ int qbman_result_has_new_result(struct qbman_swp *s, const struct dpaa2_dq *dq)
 	return 1;
 }
 
+/**
+ * qbman_result_is_written() - Check whether a dequeue result has been written
+ *                             to the storage, without consuming it
+ * @dq: the dequeue result read from the memory
+ *
+ * Unlike qbman_result_has_new_result(), the token is left untouched and the
+ * VDQCR availability is not updated.
+ *
+ * Return true if QBMan has written the dequeue result.
+ */
+bool qbman_result_is_written(const struct dpaa2_dq *dq)
+{
+	if (READ_ONCE(dq->dq.tok) != QMAN_DQ_TOKEN_VALID)
+		return false;
+
+	dma_rmb();
+	return true;
+}
+
 /**
  * qbman_release_desc_clear() - Clear the contents of a descriptor to
  *                              default/starting state.
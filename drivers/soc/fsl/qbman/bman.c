@@ -237,6 +237,14 @@ static inline void put_affine_portal(void)
 	put_cpu_var(bman_affine_portal);
 }
 
+/* Buffers accumulated per CPU by bman_release_staged() before going out */
+#define BMAN_STAGE_SIZE		64
+
+struct bman_stage {
+	struct bm_buffer bufs[BMAN_STAGE_SIZE];
+	int count;
+};
+
 /*
  * This object type refers to a pool, it isn't *the* pool. There may be
  * more than one such object per BMan buffer pool, eg. if different users of the
@@ -248,6 +256,7 @@ struct bman_pool {
 	/* Used for hash-table admin when using depletion notifications. */
 	struct bman_portal *portal;
 	struct bman_pool *next;
+	struct bman_stage __percpu *stage;
 };
 
 static u32 poll_portal_slow(struct bman_portal *p, u32 is);
@@ -377,6 +386,54 @@ static inline void bm_rcr_pvb_commit(struct bm_portal *portal, u8 myverb)
 #endif
 }
 
+/*
+ * Spread up to @num buffers over as many RCR entries as are available, 8 per
+ * entry, and publish them all with a single barrier. Returns the number of
+ * buffers placed in the ring.
+ */
+static int bm_rcr_pvb_commit_multi(struct bm_portal *portal, u32 bpid,
+				   const struct bm_buffer *bufs, int num)
+{
+	struct bm_rcr *rcr = &portal->rcr;
+	struct bm_rcr_entry *r = rcr->cursor;
+	u8 counts[BM_RCR_SIZE];
+	int entries, i, n, done = 0;
+
+	DPAA_ASSERT(!rcr->busy);
+	DPAA_ASSERT(rcr->pmode == bm_rcr_pvb);
+	entries = min_t(int, rcr->available, DIV_ROUND_UP(num, 8));
+
+	for (i = 0; i < entries; i++) {
+		n = min(num - done, 8);
+		dpaa_zero(r);
+		/*
+		 * we can copy all but the first buffer, as this can trigger
+		 * badness with the valid-bit
+		 */
+		bm_buffer_set64(r->bufs, bm_buffer_get64(&bufs[done]));
+		bm_buffer_set_bpid(r->bufs, bpid);
+		if (n > 1)
+			memcpy(&r->bufs[1], &bufs[done + 1],
+			       (n - 1) * sizeof(bufs[0]));
+		counts[i] = n;
+		done += n;
+		r = rcr_carryclear(r + 1);
+	}
+
+	dma_wmb();
+	for (i = 0; i < entries; i++) {
+		r = rcr->cursor;
+		r->_ncw_verb = BM_RCR_VERB_CMD_BPID_SINGLE |
+			       (counts[i] & BM_RCR_VERB_BUFCOUNT_MASK) |
+			       rcr->vbit;
+		dpaa_flush(r);
+		rcr_inc(rcr);
+	}
+	rcr->available -= entries;
+
+	return done;
+}
+
 static int bm_rcr_init(struct bm_portal *portal, enum bm_rcr_pmode pmode,
 		       enum bm_rcr_cmode cmode)
 {
@@ -704,9 +761,15 @@ struct bman_pool *bman_new_pool(void)
 	if (!pool)
 		goto err;
 
+	pool->stage = alloc_percpu(struct bman_stage);
+	if (!pool->stage)
+		goto err_stage;
+
 	pool->bpid = bpid;
 
 	return pool;
+err_stage:
+	kfree(pool);
 err:
 	bm_release_bpid(bpid);
 	return NULL;
@@ -715,6 +778,16 @@ EXPORT_SYMBOL(bman_new_pool);
 
 void bman_free_pool(struct bman_pool *pool)
 {
+	int cpu;
+
+	/*
+	 * Releasing them now would hand them to whoever gets this BPID next;
+	 * users must call bman_release_flush_all() before draining the pool.
+	 */
+	for_each_possible_cpu(cpu)
+		WARN_ON(per_cpu_ptr(pool->stage, cpu)->count);
+	free_percpu(pool->stage);
+
 	bm_release_bpid(pool->bpid);
 
 	kfree(pool);
@@ -783,6 +856,104 @@ int bman_release(struct bman_pool *pool, const struct bm_buffer *bufs, u8 num)
 }
 EXPORT_SYMBOL(bman_release);
 
+int bman_release_bulk(struct bman_pool *pool, const struct bm_buffer *bufs,
+		      int num)
+{
+	struct bman_portal *p;
+	unsigned long irqflags;
+	int timeout = 1000; /* 1ms */
+	int done = 0, n;
+
+	while (done < num) {
+		p = get_affine_portal();
+		local_irq_save(irqflags);
+		/* A single CI update for all the entries we're about to fill */
+		if (bm_rcr_get_avail(&p->p) < DIV_ROUND_UP(num - done, 8))
+			bm_rcr_cce_update(&p->p);
+		n = bm_rcr_pvb_commit_multi(&p->p, pool->bpid, bufs + done,
+					    num - done);
+		local_irq_restore(irqflags);
+		put_affine_portal();
+
+		done += n;
+		if (n)
+			continue;
+
+		if (unlikely(!--timeout))
+			return -ETIMEDOUT;
+		udelay(1);
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(bman_release_bulk);
+
+int bman_release_staged(struct bman_pool *pool, const struct bm_buffer *bufs,
+			u8 num)
+{
+	struct bman_stage *stage;
+	unsigned long irqflags;
+	int err = 0;
+
+	DPAA_ASSERT(num > 0 && num <= 8);
+
+	local_irq_save(irqflags);
+	stage = this_cpu_ptr(pool->stage);
+
+	if (stage->count + num > BMAN_STAGE_SIZE) {
+		err = bman_release_bulk(pool, stage->bufs, stage->count);
+		stage->count = 0;
+	}
+
+	memcpy(&stage->bufs[stage->count], bufs, num * sizeof(bufs[0]));
+	stage->count += num;
+
+	if (stage->count == BMAN_STAGE_SIZE) {
+		err = bman_release_bulk(pool, stage->bufs, stage->count);
+		stage->count = 0;
+	}
+	local_irq_restore(irqflags);
+
+	return err;
+}
+EXPORT_SYMBOL(bman_release_staged);
+
+int bman_release_flush(struct bman_pool *pool)
+{
+	struct bman_stage *stage;
+	unsigned long irqflags;
+	int err = 0;
+
+	local_irq_save(irqflags);
+	stage = this_cpu_ptr(pool->stage);
+	if (stage->count) {
+		err = bman_release_bulk(pool, stage->bufs, stage->count);
+		stage->count = 0;
+	}
+	local_irq_restore(irqflags);
+
+	return err;
+}
+EXPORT_SYMBOL(bman_release_flush);
+
+int bman_release_flush_all(struct bman_pool *pool)
+{
+	struct bman_stage *stage;
+	int cpu, err = 0;
+
+	for_each_possible_cpu(cpu) {
+		stage = per_cpu_ptr(pool->stage, cpu);
+		if (!stage->count)
+			continue;
+		if (bman_release_bulk(pool, stage->bufs, stage->count))
+			err = -ETIMEDOUT;
+		stage->count = 0;
+	}
+
+	return err;
+}
+EXPORT_SYMBOL(bman_release_flush_all);
+
 int bman_acquire(struct bman_pool *pool, struct bm_buffer *bufs, u8 num)
 {
 	struct bman_portal *p = get_affine_portal();
@@ -812,6 +983,22 @@ int bman_acquire(struct bman_pool *pool, struct bm_buffer *bufs, u8 num)
 }
 EXPORT_SYMBOL(bman_acquire);
 
+int bman_acquire_bulk(struct bman_pool *pool, struct bm_buffer *bufs, int num)
+{
+	int done = 0, n, ret;
+
+	while (done < num) {
+		n = min(num - done, 8);
+		ret = bman_acquire(pool, bufs ? bufs + done : NULL, n);
+		if (ret < 0)
+			return done ? done : ret;
+		done += ret;
+	}
+
+	return done;
+}
+EXPORT_SYMBOL(bman_acquire_bulk);
+
 const struct bm_portal_config *
 bman_get_bm_portal_config(const struct bman_portal *portal)
 {
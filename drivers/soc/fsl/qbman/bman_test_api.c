@@ -33,12 +33,107 @@
 #define NUM_BUFS	93
 #define LOOPS		3
 #define BMAN_TOKEN_MASK 0x00FFFFFFFFFFLLU
+#define PERF_BUFS	1024
+#define PERF_LOOPS	64
 
 static struct bman_pool *pool;
 static struct bm_buffer bufs_in[NUM_BUFS] ____cacheline_aligned;
 static struct bm_buffer bufs_out[NUM_BUFS] ____cacheline_aligned;
+static struct bm_buffer perf_bufs[PERF_BUFS] ____cacheline_aligned;
 static int bufs_received;
 
+enum perf_mode {
+	PERF_SINGLE,
+	PERF_BULK,
+	PERF_STAGED,
+};
+
+static const char * const perf_mode_names[] = {
+	[PERF_SINGLE] = "bman_release",
+	[PERF_BULK] = "bman_release_bulk",
+	[PERF_STAGED] = "bman_release_staged",
+};
+
+static int perf_release(enum perf_mode mode)
+{
+	int i, num;
+
+	switch (mode) {
+	case PERF_SINGLE:
+		for (i = 0; i < PERF_BUFS; i += 8)
+			if (bman_release(pool, perf_bufs + i, 8))
+				return -ETIMEDOUT;
+		return 0;
+	case PERF_BULK:
+		return bman_release_bulk(pool, perf_bufs, PERF_BUFS);
+	case PERF_STAGED:
+		/* vary the burst size as a driver's Rx path would */
+		for (i = 0; i < PERF_BUFS; i += num) {
+			num = min(1 + (i & 7), PERF_BUFS - i);
+			if (bman_release_staged(pool, perf_bufs + i, num))
+				return -ETIMEDOUT;
+		}
+		return bman_release_flush(pool);
+	}
+
+	return -EINVAL;
+}
+
+/*
+ * Release and acquire back PERF_BUFS buffers PERF_LOOPS times with each
+ * release flavour, and report the buffers/sec of both directions so the
+ * batched paths can be compared with the 8-at-a-time one.
+ */
+static int bman_test_perf(void)
+{
+	u64 rel_ns, acq_ns;
+	ktime_t start;
+	int i, mode, loop, ret;
+
+	for (i = 0; i < PERF_BUFS; i++)
+		bm_buffer_set64(&perf_bufs[i], 0x123400000000LLU + i * 64);
+
+	for (mode = PERF_SINGLE; mode <= PERF_STAGED; mode++) {
+		rel_ns = 0;
+		acq_ns = 0;
+		for (loop = 0; loop < PERF_LOOPS; loop++) {
+			start = ktime_get();
+			if (perf_release(mode)) {
+				pr_crit("%s() failed\n", perf_mode_names[mode]);
+				return -ETIMEDOUT;
+			}
+			rel_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+
+			start = ktime_get();
+			ret = 0;
+			/* the release is posted, wait for all to land */
+			for (i = 0; i < 1000 && ret < PERF_BUFS; i++) {
+				int got = bman_acquire_bulk(pool,
+							    perf_bufs + ret,
+							    PERF_BUFS - ret);
+
+				if (got > 0)
+					ret += got;
+			}
+			acq_ns += ktime_to_ns(ktime_sub(ktime_get(), start));
+			if (ret != PERF_BUFS) {
+				pr_crit("bman_acquire_bulk() got %d of %d\n",
+					ret, PERF_BUFS);
+				return -EIO;
+			}
+		}
+
+		pr_info("%s: release %llu bufs/s, acquire %llu bufs/s\n",
+			perf_mode_names[mode],
+			div64_u64((u64)PERF_BUFS * PERF_LOOPS * NSEC_PER_SEC,
+				  rel_ns ? : 1),
+			div64_u64((u64)PERF_BUFS * PERF_LOOPS * NSEC_PER_SEC,
+				  acq_ns ? : 1));
+	}
+
+	return 0;
+}
+
 static void bufs_init(void)
 {
 	int i;
@@ -141,6 +236,9 @@ void bman_test_api(void)
 	if (--loops)
 		goto do_loop;
 
+	if (bman_test_perf())
+		goto failed;
+
 	/* Clean up */
 	bman_free_pool(pool);
 	pr_info("%s(): Finished\n", __func__);
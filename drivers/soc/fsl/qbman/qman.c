@@ -528,6 +528,42 @@ static inline void qm_eqcr_pvb_commit(struct qm_portal *portal, u8 myverb)
 #endif
 }
 
+/*
+ * Write @num consecutive EQCR entries, all targeting @fqid, and publish them
+ * with a single barrier between the entry contents and their verbs. The
+ * caller must have made sure @num entries are available.
+ */
+static inline void qm_eqcr_pvb_commit_multi(struct qm_portal *portal,
+					    u32 fqid, u32 tag,
+					    const struct qm_fd *fd, int num,
+					    u8 myverb)
+{
+	struct qm_eqcr *eqcr = &portal->eqcr;
+	struct qm_eqcr_entry *eq = eqcr->cursor;
+	int i;
+
+	DPAA_ASSERT(!eqcr->busy);
+	DPAA_ASSERT(eqcr->pmode == qm_eqcr_pvb);
+	DPAA_ASSERT(eqcr->available >= num);
+
+	for (i = 0; i < num; i++) {
+		dpaa_zero(eq);
+		qm_fqid_set(eq, fqid);
+		eq->tag = cpu_to_be32(tag);
+		eq->fd = fd[i];
+		eq = eqcr_carryclear(eq + 1);
+	}
+
+	dma_wmb();
+	for (i = 0; i < num; i++) {
+		eq = eqcr->cursor;
+		eq->_ncw_verb = myverb | eqcr->vbit;
+		dpaa_flush(eq);
+		eqcr_inc(eqcr);
+	}
+	eqcr->available -= num;
+}
+
 static inline void qm_eqcr_cce_prefetch(struct qm_portal *portal)
 {
 	qm_cl_touch_ro(portal, QM_CL_EQCR_CI_CENA);
@@ -545,6 +581,18 @@ static inline u8 qm_eqcr_cce_update(struct qm_portal *portal)
 	return diff;
 }
 
+/* Same as qm_eqcr_cce_update(), for a CI cacheline stashed by QMan */
+static inline u8 qm_eqcr_cce_stash_update(struct qm_portal *portal)
+{
+	struct qm_eqcr *eqcr = &portal->eqcr;
+	u8 diff, old_ci = eqcr->ci;
+
+	eqcr->ci = qm_ce_in(portal, QM_CL_EQCR_CI_CENA) & (QM_EQCR_SIZE - 1);
+	diff = dpaa_cyc_diff(QM_EQCR_SIZE, old_ci, eqcr->ci);
+	eqcr->available += diff;
+	return diff;
+}
+
 static inline void qm_eqcr_set_ithresh(struct qm_portal *portal, u8 ithresh)
 {
 	struct qm_eqcr *eqcr = &portal->eqcr;
@@ -2348,6 +2396,33 @@ int qman_enqueue(struct qman_fq *fq, const struct qm_fd *fd)
 }
 EXPORT_SYMBOL(qman_enqueue);
 
+int qman_enqueue_multi(struct qman_fq *fq, const struct qm_fd *fd, int frames)
+{
+	struct qman_portal *p;
+	unsigned long irqflags;
+	int num;
+
+	p = get_affine_portal();
+	local_irq_save(irqflags);
+
+	if (qm_eqcr_get_avail(&p->p) < frames) {
+		if (p->use_eqcr_ci_stashing)
+			qm_eqcr_cce_stash_update(&p->p);
+		else
+			qm_eqcr_cce_update(&p->p);
+	}
+
+	num = min_t(int, frames, qm_eqcr_get_avail(&p->p));
+	if (num)
+		qm_eqcr_pvb_commit_multi(&p->p, fq->fqid, fq_to_tag(fq), fd,
+					 num, QM_EQCR_VERB_CMD_ENQUEUE);
+
+	local_irq_restore(irqflags);
+	put_affine_portal();
+	return num;
+}
+EXPORT_SYMBOL(qman_enqueue_multi);
+
 static int qm_modify_cgr(struct qman_cgr *cgr, u32 flags,
 			 struct qm_mcc_initcgr *opts)
 {
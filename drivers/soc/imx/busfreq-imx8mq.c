@@ -26,6 +26,7 @@
 #include <linux/of_address.h>
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
+#include <linux/pm_qos.h>
 #include <linux/proc_fs.h>
 #include <linux/reboot.h>
 #include <linux/sched.h>
@@ -43,6 +44,18 @@
 #define WAIT_BUS_FREQ_DONE	0xf
 #define DLL_ON_DRATE		667
 
+/*
+ * With bw_scaling set, the DDR frequency follows the bandwidth the
+ * interconnect consumers declare instead of the BUS_FREQ_HIGH request
+ * count. The i.MX interconnect provider turns the aggregated DRAM
+ * bandwidth into a minimum frequency request on the device its
+ * "fsl,ddrc" phandle points at, which must then be this one.
+ */
+static bool bw_scaling;
+module_param(bw_scaling, bool, 0444);
+MODULE_PARM_DESC(bw_scaling,
+		 "scale DDR on interconnect bandwidth requests instead of request counts");
+
 static struct device *busfreq_dev;
 static int low_bus_freq_mode;
 static int audio_bus_freq_mode;
@@ -80,8 +93,24 @@ static struct clk *sys2_pll_333m;
 static struct delayed_work low_bus_freq_handler;
 static struct delayed_work bus_freq_daemon;
 
+/* aggregated minimum dram_core rate requested by interconnect users, kHz */
+static unsigned long ddr_min_freq;
+static struct notifier_block busfreq_qos_nb;
+
 DEFINE_MUTEX(bus_freq_mutex);
 
+/*
+ * The dram_core clock runs at a quarter of the data rate, so the lowest
+ * operating point meets any demand up to fsp_table[] MT/s * 250 kHz.
+ */
+static bool busfreq_high_needed(void)
+{
+	if (!bw_scaling)
+		return high_bus_count;
+
+	return ddr_min_freq > fsp_table[low_bus_mode_fsp_index] * 250UL;
+}
+
 static void update_bus_freq(int target_freq)
 {
 	struct arm_smccc_res res;
@@ -318,6 +347,12 @@ void request_bus_freq(enum bus_freq_mode mode)
 		return;
 	}
 
+	/* bandwidth requests decide, the counter is only kept balanced */
+	if (bw_scaling && mode == BUS_FREQ_HIGH) {
+		mutex_unlock(&bus_freq_mutex);
+		return;
+	}
+
 	cancel_low_bus_freq_handler();
 
 	if ((mode == BUS_FREQ_HIGH) && (!high_bus_freq_mode)) {
@@ -372,14 +407,14 @@ void release_bus_freq(enum bus_freq_mode mode)
 		return;
 	}
 
-	if ((!audio_bus_freq_mode) && (high_bus_count == 0) &&
+	if ((!audio_bus_freq_mode) && !busfreq_high_needed() &&
 		(audio_bus_count != 0)) {
 		set_low_bus_freq();
 		mutex_unlock(&bus_freq_mutex);
 		return;
 	}
 
-	if ((!low_bus_freq_mode) && (high_bus_count == 0) &&
+	if ((!low_bus_freq_mode) && !busfreq_high_needed() &&
 		(audio_bus_count == 0)) {
 		set_low_bus_freq();
 		mutex_unlock(&bus_freq_mutex);
@@ -399,12 +434,38 @@ EXPORT_SYMBOL(get_bus_freq_mode);
 static void bus_freq_daemon_handler(struct work_struct *work)
 {
 	mutex_lock(&bus_freq_mutex);
-	if ((!low_bus_freq_mode) && (high_bus_count == 0) &&
+	if ((!low_bus_freq_mode) && !busfreq_high_needed() &&
 		(audio_bus_count == 0))
 		set_low_bus_freq();
 	mutex_unlock(&bus_freq_mutex);
 }
 
+static int busfreq_qos_notify(struct notifier_block *nb, unsigned long freq,
+			      void *data)
+{
+	mutex_lock(&bus_freq_mutex);
+
+	ddr_min_freq = freq;
+
+	if (busfreq_suspended || !bus_freq_scaling_initialized ||
+		!bus_freq_scaling_is_active) {
+		mutex_unlock(&bus_freq_mutex);
+		return NOTIFY_OK;
+	}
+
+	/* raise right away, lower through the usual delayed reduction */
+	if (busfreq_high_needed()) {
+		cancel_low_bus_freq_handler();
+		set_high_bus_freq(1);
+	} else if (high_bus_freq_mode) {
+		set_low_bus_freq();
+	}
+
+	mutex_unlock(&bus_freq_mutex);
+
+	return NOTIFY_OK;
+}
+
 static ssize_t bus_freq_scaling_enable_show(struct device *dev,
 				struct device_attribute *attr, char *buf)
 {
@@ -460,8 +521,15 @@ static int bus_freq_pm_notify(struct notifier_block *nb, unsigned long event,
 static int busfreq_reboot_notifier_event(struct notifier_block *this,
 						 unsigned long event, void *ptr)
 {
-	/* System is rebooting. Set the system into high_bus_freq_mode. */
-	request_bus_freq(BUS_FREQ_HIGH);
+	/*
+	 * System is rebooting. Set the system into high_bus_freq_mode and
+	 * keep it there, whatever the requests or bandwidth votes say.
+	 */
+	mutex_lock(&bus_freq_mutex);
+	cancel_low_bus_freq_handler();
+	set_high_bus_freq(1);
+	busfreq_suspended = 1;
+	mutex_unlock(&bus_freq_mutex);
 
 	return 0;
 }
@@ -618,6 +686,17 @@ static int busfreq_probe(struct platform_device *pdev)
 	register_pm_notifier(&imx_bus_freq_pm_notifier);
 	register_reboot_notifier(&imx_busfreq_reboot_notifier);
 
+	if (bw_scaling) {
+		busfreq_qos_nb.notifier_call = busfreq_qos_notify;
+		err = dev_pm_qos_add_notifier(busfreq_dev, &busfreq_qos_nb,
+					      DEV_PM_QOS_MIN_FREQUENCY);
+		if (err) {
+			dev_warn(busfreq_dev,
+				 "no bandwidth based scaling, falling back to request counts\n");
+			bw_scaling = false;
+		}
+	}
+
 	/* enter low bus mode if no high speed device enabled */
 	schedule_delayed_work(&bus_freq_daemon, msecs_to_jiffies(10000));
 
@@ -655,6 +734,9 @@ static int __init busfreq_init(void)
 
 static void __exit busfreq_cleanup(void)
 {
+	if (bw_scaling)
+		dev_pm_qos_remove_notifier(busfreq_dev, &busfreq_qos_nb,
+					   DEV_PM_QOS_MIN_FREQUENCY);
 	sysfs_remove_file(&busfreq_dev->kobj, &dev_attr_enable.attr);
 
 	/* Unregister the device structure */
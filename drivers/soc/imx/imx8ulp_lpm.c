@@ -10,8 +10,12 @@
 #include <linux/of_address.h>
 #include <linux/of_device.h>
 #include <linux/of_irq.h>
+#include <linux/of_platform.h>
 #include <linux/platform_device.h>
+#include <linux/pm_runtime.h>
 #include <linux/suspend.h>
+#include <linux/tick.h>
+#include <linux/workqueue.h>
 
 #define FSL_SIP_DDR_DVFS                0xc2000004
 #define DDR_DFS_GET_FSP_COUNT		0x10
@@ -30,6 +34,9 @@
 #define DENALI_CTL_273	0x444
 #define DENALI_CTL_280	0x460
 
+/* consecutive idle samples before the governor enters LPM mode */
+#define LPM_GOV_DOWN_SAMPLES	5
+
 static bool is_tref_normal = true;
 static void *__iomem ddrc_base;
 static u32 tref_normal_f0, tref_normal_f1, tref_normal_f2;
@@ -54,6 +61,29 @@ static bool sys_dvfs_enabled = false;
 static struct device *imx8ulp_lpm_dev;
 static int num_fsp;
 
+static unsigned int gov_period_ms = 100;
+module_param(gov_period_ms, uint, 0644);
+MODULE_PARM_DESC(gov_period_ms, "governor sampling period in ms");
+
+static unsigned int gov_lpm_idle = 80;
+module_param(gov_lpm_idle, uint, 0644);
+MODULE_PARM_DESC(gov_lpm_idle, "CPU idle percentage above which LPM mode is entered");
+
+static DEFINE_MUTEX(lpm_mutex);
+/* mode requested through sysfs, applied while the governor is off */
+static bool lpm_manual;
+static bool gov_enabled;
+static unsigned int gov_down_count;
+static u64 gov_last_idle, gov_last_wall;
+static struct delayed_work lpm_gov_work;
+/* bus masters whose runtime PM state keeps DDR at high frequency */
+static struct device **lpm_masters;
+static int num_lpm_masters;
+/* residency and entries, indexed by lpm_enabled */
+static ktime_t lpm_entered;
+static u64 lpm_residency_ns[2];
+static u64 lpm_entries[2];
+
 static int scaling_dram_freq(unsigned int fsp_index)
 {
 	struct arm_smccc_res res;
@@ -133,7 +163,7 @@ static void sys_freq_scaling(bool enter)
 		 */
 		scaling_dram_freq(DDR_FSP_LOW);
 
-		pr_info("DDR enter low frequency mode\n");
+		pr_debug("DDR enter low frequency mode\n");
 	} else {
 		/* prepare enable PLL4 first */
 		clk_prepare_enable(pll4);
@@ -184,9 +214,103 @@ static void sys_freq_scaling(bool enter)
 		/* unprepare pll4 after clock tree info is correct */
 		clk_disable_unprepare(pll4);
 
-		pr_info("DDR Exit from low frequency mode\n");
+		pr_debug("DDR Exit from low frequency mode\n");
+	}
+}
+
+/* Caller should hold lpm_mutex */
+static void lpm_update_residency(bool enter)
+{
+	ktime_t now = ktime_get();
+
+	lpm_residency_ns[lpm_enabled] += ktime_to_ns(ktime_sub(now, lpm_entered));
+	lpm_entered = now;
+
+	if (enter != lpm_enabled)
+		lpm_entries[enter]++;
+}
+
+/* Caller should hold lpm_mutex */
+static void lpm_set_mode(bool enter)
+{
+	if (enter == lpm_enabled)
+		return;
+
+	lpm_update_residency(enter);
+	sys_freq_scaling(enter);
+	lpm_enabled = enter;
+}
+
+static bool lpm_masters_busy(void)
+{
+	struct device *dev;
+	int i;
+
+	/* unbound masters are idle, bound ones without runtime PM are not */
+	for (i = 0; i < num_lpm_masters; i++) {
+		dev = lpm_masters[i];
+		if (READ_ONCE(dev->driver) && pm_runtime_active(dev))
+			return true;
+	}
+
+	return false;
+}
+
+/* Average idle ratio of the online CPUs since the previous sample, in percent */
+static unsigned int lpm_cpu_idle_pct(void)
+{
+	u64 idle = 0, wall = 0, cpu_idle, cpu_wall;
+	u64 last_idle = gov_last_idle, last_wall = gov_last_wall;
+	unsigned int cpu;
+
+	for_each_online_cpu(cpu) {
+		cpu_idle = get_cpu_idle_time_us(cpu, &cpu_wall);
+		/* no NOHZ idle accounting, assume busy */
+		if (cpu_idle == -1ULL)
+			return 0;
+		idle += cpu_idle;
+		wall += cpu_wall;
+	}
+
+	gov_last_idle = idle;
+	gov_last_wall = wall;
+
+	/* first sample or CPU hotplug in between */
+	if (!last_wall || wall <= last_wall || idle < last_idle)
+		return 0;
+
+	return min_t(u64, div64_u64((idle - last_idle) * 100, wall - last_wall),
+		     100);
+}
+
+static void lpm_gov_work_fn(struct work_struct *work)
+{
+	bool enter = !lpm_masters_busy() && lpm_cpu_idle_pct() >= gov_lpm_idle;
+
+	mutex_lock(&lpm_mutex);
+
+	if (!gov_enabled) {
+		mutex_unlock(&lpm_mutex);
+		return;
 	}
+
+	/*
+	 * Leave LPM mode as soon as there is activity, enter it only after
+	 * a few quiet periods, each switch is a DDR frequency change.
+	 */
+	if (!enter)
+		gov_down_count = 0;
+	else if (!lpm_enabled && ++gov_down_count < LPM_GOV_DOWN_SAMPLES)
+		enter = false;
+
+	lpm_set_mode(enter);
+
+	mutex_unlock(&lpm_mutex);
+
+	queue_delayed_work(system_freezable_power_efficient_wq, &lpm_gov_work,
+			   msecs_to_jiffies(max(gov_period_ms, 10U)));
 }
+
 static ssize_t lpm_enable_show(struct device *dev, struct device_attribute *attr,
 				char *buf)
 {
@@ -207,33 +331,105 @@ static ssize_t lpm_enable_store(struct device *dev, struct device_attribute *att
 		pr_info("DDR DFS only support with both F1 & F2 enabled\n");
 
 
-	if ((strncmp(buf, "1", 1) == 0) && !lpm_enabled) {
-		sys_freq_scaling(true);
+	mutex_lock(&lpm_mutex);
 
-		lpm_enabled = true;
-	} else if (strncmp(buf, "0", 1) == 0) {
-		if (lpm_enabled)
-			sys_freq_scaling(false);
+	if (strncmp(buf, "1", 1) == 0)
+		lpm_manual = true;
+	else if (strncmp(buf, "0", 1) == 0)
+		lpm_manual = false;
 
-		lpm_enabled = false;
-	}
+	/* the governor owns the mode while it is enabled */
+	if (!gov_enabled)
+		lpm_set_mode(lpm_manual);
+
+	mutex_unlock(&lpm_mutex);
 
 	return size;
 }
 static DEVICE_ATTR(enable, 0644, lpm_enable_show,
 			lpm_enable_store);
 
+static ssize_t governor_show(struct device *dev,
+			     struct device_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%d\n", gov_enabled);
+}
+
+static ssize_t governor_store(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t size)
+{
+	bool enable;
+
+	if (kstrtobool(buf, &enable))
+		return -EINVAL;
+
+	mutex_lock(&lpm_mutex);
+	if (enable == gov_enabled) {
+		mutex_unlock(&lpm_mutex);
+		return size;
+	}
+	gov_enabled = enable;
+	gov_down_count = 0;
+	mutex_unlock(&lpm_mutex);
+
+	if (enable) {
+		lpm_cpu_idle_pct();
+		queue_delayed_work(system_freezable_power_efficient_wq,
+				   &lpm_gov_work, msecs_to_jiffies(gov_period_ms));
+		return size;
+	}
+
+	cancel_delayed_work_sync(&lpm_gov_work);
+
+	/* back to the manually selected mode */
+	mutex_lock(&lpm_mutex);
+	lpm_set_mode(lpm_manual);
+	mutex_unlock(&lpm_mutex);
+
+	return size;
+}
+static DEVICE_ATTR_RW(governor);
+
+static ssize_t mode_residency_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	ssize_t len;
+
+	mutex_lock(&lpm_mutex);
+	lpm_update_residency(lpm_enabled);
+
+	/* mode, residency in ms, number of entries */
+	len = sysfs_emit(buf, "high %llu %llu\nlow  %llu %llu\n",
+			 div_u64(lpm_residency_ns[0], NSEC_PER_MSEC), lpm_entries[0],
+			 div_u64(lpm_residency_ns[1], NSEC_PER_MSEC), lpm_entries[1]);
+	mutex_unlock(&lpm_mutex);
+
+	return len;
+}
+static DEVICE_ATTR_RO(mode_residency);
+
+static const struct attribute *imx8ulp_lpm_attrs[] = {
+	&dev_attr_enable.attr,
+	&dev_attr_governor.attr,
+	&dev_attr_mode_residency.attr,
+	NULL
+};
+
 static int imx8ulp_lpm_pm_notify(struct notifier_block *nb, unsigned long event,
 	void *dummy)
 {
+	mutex_lock(&lpm_mutex);
+
 	/* if DDR is not in low frequency, return directly */
-	if (!lpm_enabled)
-		return NOTIFY_OK;
+	if (lpm_enabled) {
+		if (event == PM_SUSPEND_PREPARE)
+			sys_freq_scaling(false);
+		else if (event == PM_POST_SUSPEND)
+			sys_freq_scaling(true);
+	}
 
-	if (event == PM_SUSPEND_PREPARE)
-		sys_freq_scaling(false);
-	else if (event == PM_POST_SUSPEND)
-		sys_freq_scaling(true);
+	mutex_unlock(&lpm_mutex);
 
 	return NOTIFY_OK;
 }
@@ -343,6 +539,47 @@ static int ddr_refresh_rate_adjust_init(void)
 	return 0;
 }
 
+static void lpm_put_master(void *data)
+{
+	put_device(data);
+}
+
+static int lpm_get_masters(struct device *dev)
+{
+	struct platform_device *master;
+	struct device_node *np;
+	int i, count, err;
+
+	count = of_count_phandle_with_args(dev->of_node, "nxp,bus-masters", NULL);
+	if (count <= 0)
+		return 0;
+
+	lpm_masters = devm_kcalloc(dev, count, sizeof(*lpm_masters), GFP_KERNEL);
+	if (!lpm_masters)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		np = of_parse_phandle(dev->of_node, "nxp,bus-masters", i);
+		if (!np)
+			continue;
+
+		master = of_find_device_by_node(np);
+		of_node_put(np);
+		if (!master) {
+			dev_warn(dev, "bus master %d has no device, ignored\n", i);
+			continue;
+		}
+
+		err = devm_add_action_or_reset(dev, lpm_put_master, &master->dev);
+		if (err)
+			return err;
+
+		lpm_masters[num_lpm_masters++] = &master->dev;
+	}
+
+	return 0;
+}
+
 /* sysfs for user control */
 static int imx8ulp_lpm_probe(struct platform_device *pdev)
 {
@@ -389,8 +626,15 @@ static int imx8ulp_lpm_probe(struct platform_device *pdev)
 	    IS_ERR(pll4))
 		dev_err(&pdev->dev, "Get clocks failed\n");
 
+	err = lpm_get_masters(&pdev->dev);
+	if (err)
+		return err;
+
+	lpm_entered = ktime_get();
+	INIT_DELAYED_WORK(&lpm_gov_work, lpm_gov_work_fn);
+
 	/* create the sysfs file */
-	err = sysfs_create_file(&imx8ulp_lpm_dev->kobj, &dev_attr_enable.attr);
+	err = sysfs_create_files(&imx8ulp_lpm_dev->kobj, imx8ulp_lpm_attrs);
 	if (err) {
 		dev_err(&pdev->dev, "creating i.MX8ULP LPM control sys file\n");
 		return err;
@@ -398,6 +642,14 @@ static int imx8ulp_lpm_probe(struct platform_device *pdev)
 
 	register_pm_notifier(&imx8ulp_lpm_pm_notifier);
 
+	/* the governor can also be switched on from sysfs later */
+	if (of_property_read_bool(pdev->dev.of_node, "nxp,lpm-governor")) {
+		gov_enabled = true;
+		lpm_cpu_idle_pct();
+		queue_delayed_work(system_freezable_power_efficient_wq,
+				   &lpm_gov_work, msecs_to_jiffies(gov_period_ms));
+	}
+
 	return 0;
 }
 
@@ -10,9 +10,13 @@
 #include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
+#include <linux/of_platform.h>
 #include <linux/platform_device.h>
+#include <linux/pm_runtime.h>
 #include <linux/regulator/consumer.h>
 #include <linux/suspend.h>
+#include <linux/tick.h>
+#include <linux/workqueue.h>
 #include <linux/mfd/syscon.h>
 #include <linux/regmap.h>
 #include <linux/firmware/imx/se_api.h>
@@ -38,6 +42,9 @@
 
 #define MAX_COOLING_LEVEL 1
 
+/* consecutive samples asking for a lower power mode before switching down */
+#define LPM_GOV_DOWN_SAMPLES		5
+
 enum SYS_PLL_CLKS {
 	SYS_PLL_PFD0,
 	SYS_PLL_PFD0_DIV2,
@@ -104,6 +111,14 @@ struct operating_mode {
 	enum mode_type current_mode;
 	bool auto_gate_enabled;
 	unsigned int ssi_strap;
+	/* in-kernel mode selection instead of the manual mode */
+	bool governor_enabled;
+	enum mode_type governor_mode;
+	unsigned int gov_down_count;
+	/* time spent in and number of entries to each mode */
+	ktime_t mode_entered;
+	u64 residency_ns[MODE_END];
+	u64 entries[MODE_END];
 	/* critical clocks */
 	struct critical_clk_path paths[CLK_PATH_END];
 };
@@ -191,6 +206,35 @@ static struct regmap *regmap;
 static void *se_data;
 DEFINE_MUTEX(mode_mutex);
 
+static const char * const mode_names[MODE_END] = {
+	[OD_MODE] = "OD",
+	[ND_MODE] = "ND",
+	[LD_MODE] = "LD",
+	[SWFFC_MODE] = "SWFFC",
+};
+
+static unsigned int gov_period_ms = 100;
+module_param(gov_period_ms, uint, 0644);
+MODULE_PARM_DESC(gov_period_ms, "governor sampling period in ms");
+
+static unsigned int gov_nd_idle = 50;
+module_param(gov_nd_idle, uint, 0644);
+MODULE_PARM_DESC(gov_nd_idle, "CPU idle percentage above which ND mode is selected");
+
+static unsigned int gov_ld_idle = 80;
+module_param(gov_ld_idle, uint, 0644);
+MODULE_PARM_DESC(gov_ld_idle, "CPU idle percentage above which LD mode is selected");
+
+static unsigned int gov_swffc_idle = 95;
+module_param(gov_swffc_idle, uint, 0644);
+MODULE_PARM_DESC(gov_swffc_idle, "CPU idle percentage above which LD+SWFFC mode is selected");
+
+/* bus masters whose runtime PM state keeps the system in the fastest mode */
+static struct device **lpm_masters;
+static int num_lpm_masters;
+static u64 gov_last_idle, gov_last_wall;
+static struct delayed_work lpm_gov_work;
+
 struct lpm_ctx {
 	unsigned int level;
 	struct thermal_cooling_device *cdev;
@@ -236,6 +280,20 @@ static void lpm_update_all_clks(struct critical_clk_path *path,
 	}
 }
 
+/* Caller should hold mode_mutex lock */
+static void lpm_update_residency(enum mode_type new_mode)
+{
+	ktime_t now = ktime_get();
+	enum mode_type cur = system_run_mode.current_mode;
+
+	system_run_mode.residency_ns[cur] +=
+		ktime_to_ns(ktime_sub(now, system_run_mode.mode_entered));
+	system_run_mode.mode_entered = now;
+
+	if (new_mode != cur)
+		system_run_mode.entries[new_mode]++;
+}
+
 /* Caller should hold mode_mutex lock */
 static void sys_freq_scaling(enum mode_type new_mode)
 {
@@ -258,7 +316,7 @@ static void sys_freq_scaling(enum mode_type new_mode)
 
 		/* Scaling up the DDR frequency */
 		scaling_dram_freq(0x0);
-		pr_info("System switching to OD mode...\n");
+		pr_debug("System switching to OD mode...\n");
 	} else if (new_mode == ND_MODE) {
 		/*
 		 * if switch from LD mode to ND mode, voltage should be increase firstly.
@@ -278,7 +336,7 @@ static void sys_freq_scaling(enum mode_type new_mode)
 			regulator_set_voltage_tol(soc_reg, VDD_SOC_ND_VOLTAGE, 0);
 		}
 
-		pr_info("System switching to ND mode...\n");
+		pr_debug("System switching to ND mode...\n");
 	} else if (new_mode == LD_MODE || new_mode == SWFFC_MODE) {
 		/*
 		 * NIC AXI frequency should be changed after all other clock
@@ -299,9 +357,10 @@ static void sys_freq_scaling(enum mode_type new_mode)
 		if (!no_od_mode)
 			imx_se_voltage_change_req(se_data, false);
 
-		pr_info("System switching to LD/SWFFC mode...\n");
+		pr_debug("System switching to LD/SWFFC mode...\n");
 	}
 
+	lpm_update_residency(new_mode);
 	system_run_mode.current_mode = new_mode;
 }
 
@@ -347,21 +406,24 @@ static ssize_t lpm_enable_show(struct device *dev, struct device_attribute *attr
 /* Caller should hold mode_mutex lock */
 static enum mode_type lpm_get_tartget_mode(void)
 {
-	enum mode_type new_mode;
+	enum mode_type new_mode, req_mode;
+
+	req_mode = system_run_mode.governor_enabled ?
+		   system_run_mode.governor_mode : system_run_mode.manual_mode;
 
 	if (system_run_mode.suspend_prepared) {
 		new_mode = no_od_mode ? ND_MODE : OD_MODE;
 	} else if (!system_run_mode.cooling_actived) {
-		new_mode = system_run_mode.manual_mode;
+		new_mode = req_mode;
 	} else {
 		new_mode = ld_mode_enabled ? LD_MODE : ND_MODE;
 
 		/*
-		 * manual setting mode is preferred if it makes the
-		 * system colder
+		 * manual or governor selected mode is preferred if it
+		 * makes the system colder
 		 */
-		if (new_mode < system_run_mode.manual_mode)
-			new_mode = system_run_mode.manual_mode;
+		if (new_mode < req_mode)
+			new_mode = req_mode;
 	}
 
 	return new_mode;
@@ -438,12 +500,173 @@ static ssize_t auto_clk_gating_store(struct device *dev,
 	return count;
 }
 
+static bool lpm_masters_busy(void)
+{
+	struct device *dev;
+	int i;
+
+	/* unbound masters are idle, bound ones without runtime PM are not */
+	for (i = 0; i < num_lpm_masters; i++) {
+		dev = lpm_masters[i];
+		if (READ_ONCE(dev->driver) && pm_runtime_active(dev))
+			return true;
+	}
+
+	return false;
+}
+
+/* Average idle ratio of the online CPUs since the previous sample, in percent */
+static unsigned int lpm_cpu_idle_pct(void)
+{
+	u64 idle = 0, wall = 0, cpu_idle, cpu_wall;
+	u64 last_idle = gov_last_idle, last_wall = gov_last_wall;
+	unsigned int cpu;
+
+	for_each_online_cpu(cpu) {
+		cpu_idle = get_cpu_idle_time_us(cpu, &cpu_wall);
+		/* no NOHZ idle accounting, assume busy */
+		if (cpu_idle == -1ULL)
+			return 0;
+		idle += cpu_idle;
+		wall += cpu_wall;
+	}
+
+	gov_last_idle = idle;
+	gov_last_wall = wall;
+
+	/* first sample or CPU hotplug in between */
+	if (!last_wall || wall <= last_wall || idle < last_idle)
+		return 0;
+
+	return min_t(u64, div64_u64((idle - last_idle) * 100, wall - last_wall),
+		     100);
+}
+
+static enum mode_type lpm_gov_select(void)
+{
+	unsigned int idle = lpm_cpu_idle_pct();
+
+	if (lpm_masters_busy() || idle < gov_nd_idle)
+		return no_od_mode ? ND_MODE : OD_MODE;
+
+	if (!ld_mode_enabled || idle < gov_ld_idle)
+		return ND_MODE;
+
+	if (num_fsp > 2 && idle >= gov_swffc_idle)
+		return SWFFC_MODE;
+
+	return LD_MODE;
+}
+
+static void lpm_gov_work_fn(struct work_struct *work)
+{
+	enum mode_type new_mode = lpm_gov_select();
+
+	mutex_lock(&mode_mutex);
+
+	if (!system_run_mode.governor_enabled) {
+		mutex_unlock(&mode_mutex);
+		return;
+	}
+
+	/*
+	 * Go to a faster mode right away, but only drop to a lower power
+	 * mode once the system stayed quiet for a few periods, every
+	 * switch costs a DDR frequency change.
+	 */
+	if (new_mode < system_run_mode.governor_mode) {
+		system_run_mode.governor_mode = new_mode;
+		system_run_mode.gov_down_count = 0;
+	} else if (new_mode > system_run_mode.governor_mode) {
+		if (++system_run_mode.gov_down_count >= LPM_GOV_DOWN_SAMPLES) {
+			system_run_mode.governor_mode = new_mode;
+			system_run_mode.gov_down_count = 0;
+		}
+	} else {
+		system_run_mode.gov_down_count = 0;
+	}
+
+	lpm_switch_to_new_mode(lpm_get_tartget_mode());
+
+	mutex_unlock(&mode_mutex);
+
+	queue_delayed_work(system_freezable_power_efficient_wq, &lpm_gov_work,
+			   msecs_to_jiffies(max(gov_period_ms, 10U)));
+}
+
+static ssize_t governor_show(struct device *dev,
+			     struct device_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%d\n", system_run_mode.governor_enabled);
+}
+
+static ssize_t governor_store(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t count)
+{
+	bool enable;
+
+	if (kstrtobool(buf, &enable))
+		return -EINVAL;
+
+	mutex_lock(&mode_mutex);
+	if (enable == system_run_mode.governor_enabled) {
+		mutex_unlock(&mode_mutex);
+		return count;
+	}
+
+	system_run_mode.governor_enabled = enable;
+	system_run_mode.governor_mode = system_run_mode.current_mode;
+	system_run_mode.gov_down_count = 0;
+	mutex_unlock(&mode_mutex);
+
+	if (enable) {
+		lpm_cpu_idle_pct();
+		queue_delayed_work(system_freezable_power_efficient_wq,
+				   &lpm_gov_work, msecs_to_jiffies(gov_period_ms));
+		return count;
+	}
+
+	cancel_delayed_work_sync(&lpm_gov_work);
+
+	/* back to the manually selected mode */
+	mutex_lock(&mode_mutex);
+	lpm_switch_to_new_mode(lpm_get_tartget_mode());
+	mutex_unlock(&mode_mutex);
+
+	return count;
+}
+
+static ssize_t mode_residency_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	ssize_t len = 0;
+	int i;
+
+	mutex_lock(&mode_mutex);
+	lpm_update_residency(system_run_mode.current_mode);
+
+	/* mode, residency in ms, number of entries */
+	for (i = 0; i < MODE_END; i++)
+		len += sysfs_emit_at(buf, len, "%-5s %llu %llu\n", mode_names[i],
+				     div_u64(system_run_mode.residency_ns[i],
+					     NSEC_PER_MSEC),
+				     system_run_mode.entries[i]);
+	mutex_unlock(&mode_mutex);
+
+	return len;
+}
+
 static DEVICE_ATTR(mode, 0644, lpm_enable_show, lpm_enable_store);
 static DEVICE_ATTR(auto_clk_gating, 0644, auto_clk_gating_show, auto_clk_gating_store);
+static DEVICE_ATTR_RW(governor);
+static DEVICE_ATTR_RO(mode_residency);
 
 static const struct attribute *imx93_lpm_attrs[] = {
 	&dev_attr_mode.attr,
 	&dev_attr_auto_clk_gating.attr,
+	&dev_attr_governor.attr,
+	&dev_attr_mode_residency.attr,
 	NULL
 };
 
@@ -565,6 +788,47 @@ static int lpm_cooling_device_register(struct platform_device *pdev)
 	return 0;
 }
 
+static void lpm_put_master(void *data)
+{
+	put_device(data);
+}
+
+static int lpm_get_masters(struct device *dev)
+{
+	struct platform_device *master;
+	struct device_node *np;
+	int i, count, err;
+
+	count = of_count_phandle_with_args(dev->of_node, "nxp,bus-masters", NULL);
+	if (count <= 0)
+		return 0;
+
+	lpm_masters = devm_kcalloc(dev, count, sizeof(*lpm_masters), GFP_KERNEL);
+	if (!lpm_masters)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		np = of_parse_phandle(dev->of_node, "nxp,bus-masters", i);
+		if (!np)
+			continue;
+
+		master = of_find_device_by_node(np);
+		of_node_put(np);
+		if (!master) {
+			dev_warn(dev, "bus master %d has no device, ignored\n", i);
+			continue;
+		}
+
+		err = devm_add_action_or_reset(dev, lpm_put_master, &master->dev);
+		if (err)
+			return err;
+
+		lpm_masters[num_lpm_masters++] = &master->dev;
+	}
+
+	return 0;
+}
+
 /* sysfs for user control */
 static int imx93_lpm_probe(struct platform_device *pdev)
 {
@@ -661,6 +925,13 @@ static int imx93_lpm_probe(struct platform_device *pdev)
 	/* Normally, we assuming the system in boot up in OD or ND(i.MX91/P) mode */
 	system_run_mode.current_mode = no_od_mode ? ND_MODE : OD_MODE;
 	system_run_mode.manual_mode = system_run_mode.current_mode;
+	system_run_mode.mode_entered = ktime_get();
+
+	err = lpm_get_masters(&pdev->dev);
+	if (err)
+		return err;
+
+	INIT_DELAYED_WORK(&lpm_gov_work, lpm_gov_work_fn);
 
 	lpm_cooling_device_register(pdev);
 
@@ -673,6 +944,15 @@ static int imx93_lpm_probe(struct platform_device *pdev)
 
 	register_pm_notifier(&imx93_lpm_pm_notifier);
 
+	/* the governor can also be switched on from sysfs later */
+	if (of_property_read_bool(pdev->dev.of_node, "nxp,lpm-governor")) {
+		system_run_mode.governor_enabled = true;
+		system_run_mode.governor_mode = system_run_mode.current_mode;
+		lpm_cpu_idle_pct();
+		queue_delayed_work(system_freezable_power_efficient_wq,
+				   &lpm_gov_work, msecs_to_jiffies(gov_period_ms));
+	}
+
 	return 0;
 }
 
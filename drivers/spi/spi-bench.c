@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * SPI controller throughput benchmark
+ *
+ * Binds to a spi device (ideally with MISO looped back to MOSI or with
+ * nothing attached) and times full-duplex transfers over a sweep of
+ * transfer lengths and word sizes, so that DMA/PIO thresholds and
+ * burst handling of a controller driver can be compared.
+ *
+ * Copyright 2026 NXP
+ */
+
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/mod_devicetable.h>
+#include <linux/module.h>
+#include <linux/random.h>
+#include <linux/slab.h>
+#include <linux/spi/spi.h>
+
+static unsigned int iterations = 64;
+module_param(iterations, uint, 0644);
+MODULE_PARM_DESC(iterations, "number of messages timed per length and word size");
+
+static unsigned int min_len = 16;
+module_param(min_len, uint, 0644);
+MODULE_PARM_DESC(min_len, "shortest transfer length in bytes");
+
+static unsigned int max_len = 65536;
+module_param(max_len, uint, 0644);
+MODULE_PARM_DESC(max_len, "longest transfer length in bytes");
+
+static unsigned int odd_tail = 12;
+module_param(odd_tail, uint, 0644);
+MODULE_PARM_DESC(odd_tail,
+		 "also time each length plus this many bytes to exercise unaligned tails, 0 to skip");
+
+static unsigned int speed_hz;
+module_param(speed_hz, uint, 0644);
+MODULE_PARM_DESC(speed_hz, "bus clock to use, 0 for the device default");
+
+static const u8 spi_bench_bpw[] = { 8, 12, 16, 32 };
+
+static int spi_bench_one(struct spi_device *spi, void *tx, void *rx,
+			 unsigned int len, u8 bpw)
+{
+	struct spi_transfer xfer = {
+		.tx_buf = tx,
+		.rx_buf = rx,
+		.len = len,
+		.bits_per_word = bpw,
+		.speed_hz = speed_hz,
+	};
+	struct spi_message msg;
+	unsigned int i;
+	ktime_t start;
+	u64 ns, kbps;
+	int ret;
+
+	spi_message_init_with_transfers(&msg, &xfer, 1);
+
+	/* Optimize once so the timed loop only measures the transfer. */
+	ret = spi_optimize_message(spi, &msg);
+	if (ret)
+		return ret;
+
+	start = ktime_get();
+	for (i = 0; i < iterations; i++) {
+		ret = spi_sync(spi, &msg);
+		if (ret)
+			goto out;
+	}
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	kbps = ns ? div64_u64((u64)len * iterations * NSEC_PER_SEC, ns * 1024) : 0;
+	dev_info(&spi->dev, "bpw %2u len %6u: %8llu KiB/s, %8llu ns/msg\n",
+		 bpw, len, kbps, div_u64(ns, iterations));
+
+out:
+	spi_unoptimize_message(&msg);
+	return ret;
+}
+
+static int spi_bench_probe(struct spi_device *spi)
+{
+	struct spi_controller *ctlr = spi->controller;
+	void *tx __free(kfree) = NULL;
+	void *rx __free(kfree) = NULL;
+	unsigned int len, bytes_per_word, size, i;
+	u8 bpw;
+	int ret;
+
+	if (!iterations || !min_len || min_len > max_len)
+		return -EINVAL;
+
+	/* room for lengths rounded up to whole 32-bit words */
+	size = max_len + odd_tail + sizeof(u32);
+	tx = kmalloc(size, GFP_KERNEL);
+	rx = kmalloc(size, GFP_KERNEL);
+	if (!tx || !rx)
+		return -ENOMEM;
+
+	get_random_bytes(tx, size);
+
+	for (i = 0; i < ARRAY_SIZE(spi_bench_bpw); i++) {
+		bpw = spi_bench_bpw[i];
+		if (ctlr->bits_per_word_mask &&
+		    !(ctlr->bits_per_word_mask & SPI_BPW_MASK(bpw)))
+			continue;
+
+		bytes_per_word = roundup_pow_of_two(BITS_TO_BYTES(bpw));
+
+		for (len = min_len; len <= max_len; len *= 2) {
+			ret = spi_bench_one(spi, tx, rx,
+					    round_up(len, bytes_per_word), bpw);
+			if (ret)
+				goto err;
+
+			if (!odd_tail)
+				continue;
+
+			ret = spi_bench_one(spi, tx, rx,
+					    round_up(len + odd_tail, bytes_per_word),
+					    bpw);
+			if (ret)
+				goto err;
+		}
+	}
+
+	return 0;
+
+err:
+	dev_err(&spi->dev, "bpw %u len %u failed: %d\n", bpw, len, ret);
+	return ret;
+}
+
+/* non const match table to permit to change via a module parameter */
+static struct of_device_id spi_bench_of_match[] = {
+	{ .compatible	= "linux,spi-bench", },
+	{ }
+};
+
+/* allow to override the compatible string via a module_parameter */
+module_param_string(compatible, spi_bench_of_match[0].compatible,
+		    sizeof(spi_bench_of_match[0].compatible),
+		    0000);
+
+MODULE_DEVICE_TABLE(of, spi_bench_of_match);
+
+static struct spi_driver spi_bench_driver = {
+	.driver = {
+		.name = "spi-bench",
+		.of_match_table = spi_bench_of_match,
+	},
+	.probe = spi_bench_probe,
+};
+
+module_spi_driver(spi_bench_driver);
+
+MODULE_DESCRIPTION("spi_driver timing full-duplex transfers across lengths and word sizes");
+MODULE_LICENSE("GPL");
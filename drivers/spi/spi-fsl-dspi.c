@@ -17,6 +17,7 @@
 #include <linux/platform_device.h>
 #include <linux/pinctrl/consumer.h>
 #include <linux/regmap.h>
+#include <linux/sizes.h>
 #include <linux/spi/spi.h>
 #include <linux/spi/spi-fsl-dspi.h>
 
@@ -109,6 +110,13 @@
 
 #define DMA_COMPLETION_TIMEOUT		msecs_to_jiffies(3000)
 
+/*
+ * Size of each of the persistent TX/RX DMA buffers. Every word moved by
+ * DMA occupies a 32-bit PUSHR/POPR entry, so this bounds the number of
+ * words per DMA chunk, not the size of a transfer.
+ */
+#define DSPI_DMA_BUFSIZE		SZ_16K
+
 struct chip_data {
 	u32			ctar_val;
 };
@@ -365,18 +373,103 @@ static void dspi_tx_dma_callback(void *arg)
 	complete(&dma->cmd_tx_complete);
 }
 
+/*
+ * Unpack a whole DMA chunk from the RX buffer. The common word formats
+ * are open-coded so that the per-word indirect call is only taken for
+ * the remaining cases.
+ */
+static void dspi_dma_unpack_rx(struct fsl_dspi *dspi)
+{
+	const u32 *buf = dspi->dma->rx_dma_buf;
+	int n = dspi->words_in_flight;
+	int i;
+
+	if (dspi->dev_to_host == dspi_8on16_dev_to_host) {
+		u16 *rx = dspi->rx;
+
+		for (i = 0; i < n; i++)
+			rx[i] = be16_to_cpu(buf[i]);
+	} else if (dspi->dev_to_host == dspi_native_dev_to_host &&
+		   dspi->oper_word_size == 1) {
+		u8 *rx = dspi->rx;
+
+		for (i = 0; i < n; i++)
+			rx[i] = buf[i];
+	} else if (dspi->dev_to_host == dspi_native_dev_to_host &&
+		   dspi->oper_word_size == 2) {
+		u16 *rx = dspi->rx;
+
+		for (i = 0; i < n; i++)
+			rx[i] = buf[i];
+	} else {
+		for (i = 0; i < n; i++)
+			dspi_push_rx(dspi, buf[i]);
+		return;
+	}
+
+	dspi->rx += n * dspi->oper_word_size;
+}
+
 static void dspi_rx_dma_callback(void *arg)
 {
 	struct fsl_dspi *dspi = arg;
 	struct fsl_dspi_dma *dma = dspi->dma;
+
+	if (dspi->rx)
+		dspi_dma_unpack_rx(dspi);
+
+	complete(&dma->cmd_rx_complete);
+}
+
+/*
+ * Build the PUSHR stream for a whole DMA chunk. The command half is the
+ * same for every entry but the last one of the transfer, so it is
+ * computed once and only the data half is generated per word.
+ */
+static void dspi_dma_pack_tx(struct fsl_dspi *dspi)
+{
+	int n = dspi->words_in_flight, bytes = n * dspi->oper_word_size;
+	u32 *buf = dspi->dma->tx_dma_buf;
+	u32 cmd = 0, last_cmd = 0;
 	int i;
 
-	if (dspi->rx) {
-		for (i = 0; i < dspi->words_in_flight; i++)
-			dspi_push_rx(dspi, dspi->dma->rx_dma_buf[i]);
+	if (!spi_controller_is_target(dspi->ctlr)) {
+		last_cmd = (u32)dspi->tx_cmd << 16;
+		cmd = last_cmd | (u32)SPI_PUSHR_CMD_CONT << 16;
 	}
 
-	complete(&dma->cmd_rx_complete);
+	if (!dspi->tx) {
+		for (i = 0; i < n; i++)
+			buf[i] = cmd;
+	} else if (dspi->host_to_dev == dspi_8on16_host_to_dev) {
+		const u16 *tx = dspi->tx;
+
+		for (i = 0; i < n; i++)
+			buf[i] = cmd | (u16)cpu_to_be16(tx[i]);
+	} else if (dspi->host_to_dev == dspi_native_host_to_dev &&
+		   dspi->oper_word_size == 1) {
+		const u8 *tx = dspi->tx;
+
+		for (i = 0; i < n; i++)
+			buf[i] = cmd | tx[i];
+	} else if (dspi->host_to_dev == dspi_native_host_to_dev &&
+		   dspi->oper_word_size == 2) {
+		const u16 *tx = dspi->tx;
+
+		for (i = 0; i < n; i++)
+			buf[i] = cmd | tx[i];
+	} else {
+		for (i = 0; i < n; i++)
+			buf[i] = dspi_pop_tx_pushr(dspi);
+		return;
+	}
+
+	dspi->tx += bytes;
+	dspi->len -= bytes;
+
+	/* Deassert CS after the last word unless tx_cmd says otherwise */
+	if (!dspi->len && cmd)
+		buf[n - 1] = (buf[n - 1] & 0xffff) | last_cmd;
 }
 
 static int dspi_next_xfer_dma_submit(struct fsl_dspi *dspi)
@@ -384,10 +477,8 @@ static int dspi_next_xfer_dma_submit(struct fsl_dspi *dspi)
 	struct device *dev = &dspi->pdev->dev;
 	struct fsl_dspi_dma *dma = dspi->dma;
 	int time_left;
-	int i;
 
-	for (i = 0; i < dspi->words_in_flight; i++)
-		dspi->dma->tx_dma_buf[i] = dspi_pop_tx_pushr(dspi);
+	dspi_dma_pack_tx(dspi);
 
 	dma->tx_desc = dmaengine_prep_slave_single(dma->chan_tx,
 					dma->tx_dma_phys,
@@ -466,16 +557,19 @@ static int dspi_dma_xfer(struct fsl_dspi *dspi)
 	int ret = 0;
 
 	/*
-	 * dspi->len gets decremented by dspi_pop_tx_pushr in
+	 * dspi->len gets decremented by dspi_dma_pack_tx in
 	 * dspi_next_xfer_dma_submit
 	 */
 	while (dspi->len) {
 		/* Figure out operational bits-per-word for this chunk */
 		dspi_setup_accel(dspi);
 
-		dspi->words_in_flight = dspi->len / dspi->oper_word_size;
-		if (dspi->words_in_flight > dspi->devtype_data->fifo_size)
-			dspi->words_in_flight = dspi->devtype_data->fifo_size;
+		/*
+		 * The TX DMA request follows TFFF, so a chunk is not bound
+		 * to the FIFO depth, only to the size of the DMA buffers.
+		 */
+		dspi->words_in_flight = min_t(int, dspi->len / dspi->oper_word_size,
+					      DSPI_DMA_BUFSIZE / sizeof(u32));
 
 		message->actual_length += dspi->words_in_flight *
 					  dspi->oper_word_size;
@@ -492,7 +586,7 @@ static int dspi_dma_xfer(struct fsl_dspi *dspi)
 
 static int dspi_request_dma(struct fsl_dspi *dspi, phys_addr_t phy_addr)
 {
-	int dma_bufsize = dspi->devtype_data->fifo_size * 2;
+	int dma_bufsize = DSPI_DMA_BUFSIZE;
 	struct device *dev = &dspi->pdev->dev;
 	struct dma_slave_config cfg;
 	struct fsl_dspi_dma *dma;
@@ -575,7 +669,7 @@ static int dspi_request_dma(struct fsl_dspi *dspi, phys_addr_t phy_addr)
 
 static void dspi_release_dma(struct fsl_dspi *dspi)
 {
-	int dma_bufsize = dspi->devtype_data->fifo_size * 2;
+	int dma_bufsize = DSPI_DMA_BUFSIZE;
 	struct fsl_dspi_dma *dma = dspi->dma;
 
 	if (!dma)
@@ -15,6 +15,8 @@
 #include <linux/io.h>
 #include <linux/irq.h>
 #include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/log2.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/pinctrl/consumer.h>
@@ -86,6 +88,20 @@ struct fsl_lpspi_devtype_data {
 	u8 prescale_max;
 };
 
+/*
+ * A run of back-to-back transfers of a message sent as one transfer, so
+ * the whole run goes out with a single TCR command word and one DMA
+ * descriptor pair instead of reprogramming the controller per transfer.
+ */
+struct fsl_lpspi_batch {
+	struct list_head link;
+	/* the original transfers, restored on unoptimize */
+	struct list_head replaced;
+	struct spi_transfer xfer;
+	void *tx;
+	void *rx;
+};
+
 struct lpspi_config {
 	u8 bpw;
 	u8 chip_select;
@@ -763,6 +779,190 @@ static int fsl_lpspi_transfer_one(struct spi_controller *controller,
 	return 0;
 }
 
+static bool fsl_lpspi_can_batch(struct spi_transfer *prev,
+				struct spi_transfer *next)
+{
+	unsigned int bytes_per_word;
+
+	if (prev->cs_change || prev->delay.value || prev->cs_off ||
+	    next->cs_off || prev->word_delay.value || next->word_delay.value)
+		return false;
+
+	if (prev->bits_per_word != next->bits_per_word ||
+	    prev->speed_hz != next->speed_hz ||
+	    prev->tx_nbits != next->tx_nbits ||
+	    prev->rx_nbits != next->rx_nbits)
+		return false;
+
+	/* the same constraint as fsl_lpspi_can_dma(), per transfer */
+	bytes_per_word = fsl_lpspi_bytes_per_word(next->bits_per_word);
+	if (!is_power_of_2(bytes_per_word) || bytes_per_word > 4)
+		return false;
+
+	return !(prev->len % bytes_per_word) && !(next->len % bytes_per_word);
+}
+
+static void fsl_lpspi_free_batches(struct list_head *batches)
+{
+	struct fsl_lpspi_batch *batch, *tmp;
+
+	list_for_each_entry_safe(batch, tmp, batches, link) {
+		list_splice(&batch->replaced, &batch->xfer.transfer_list);
+		list_del(&batch->xfer.transfer_list);
+		list_del(&batch->link);
+		kfree(batch->tx);
+		kfree(batch->rx);
+		kfree(batch);
+	}
+}
+
+static int fsl_lpspi_optimize_message(struct spi_message *msg)
+{
+	struct spi_controller *controller = msg->spi->controller;
+	struct fsl_lpspi_data *fsl_lpspi =
+				spi_controller_get_devdata(controller);
+	struct spi_transfer *first, *last, *next;
+	struct fsl_lpspi_batch *batch;
+	struct list_head *batches;
+	unsigned int count, len;
+
+	if (fsl_lpspi->is_target || !controller->dma_rx)
+		return 0;
+
+	batches = kmalloc(sizeof(*batches), GFP_KERNEL);
+	if (!batches)
+		return -ENOMEM;
+	INIT_LIST_HEAD(batches);
+
+	first = list_first_entry(&msg->transfers, struct spi_transfer,
+				 transfer_list);
+	while (!list_entry_is_head(first, &msg->transfers, transfer_list)) {
+		last = first;
+		len = first->len;
+		count = 1;
+
+		while (!list_is_last(&last->transfer_list, &msg->transfers)) {
+			next = list_next_entry(last, transfer_list);
+			if (!fsl_lpspi_can_batch(last, next) ||
+			    len + next->len > FSL_LPSPI_MAX_EDMA_BYTES)
+				break;
+			len += next->len;
+			last = next;
+			count++;
+		}
+
+		if (count < 2)
+			goto next_run;
+
+		batch = kzalloc(sizeof(*batch), GFP_KERNEL);
+		if (!batch)
+			goto err;
+
+		batch->tx = kmalloc(len, GFP_KERNEL);
+		batch->rx = kmalloc(len, GFP_KERNEL);
+		if (!batch->tx || !batch->rx) {
+			kfree(batch->tx);
+			kfree(batch->rx);
+			kfree(batch);
+			goto err;
+		}
+
+		batch->xfer = *first;
+		batch->xfer.tx_buf = batch->tx;
+		batch->xfer.rx_buf = batch->rx;
+		batch->xfer.len = len;
+		batch->xfer.cs_change = last->cs_change;
+		batch->xfer.delay = last->delay;
+		batch->xfer.cs_change_delay = last->cs_change_delay;
+
+		/* swap the run for the batched transfer */
+		INIT_LIST_HEAD(&batch->replaced);
+		list_add_tail(&batch->xfer.transfer_list, &first->transfer_list);
+		list_cut_position(&batch->replaced, &batch->xfer.transfer_list,
+				  &last->transfer_list);
+		list_add_tail(&batch->link, batches);
+		last = &batch->xfer;
+next_run:
+		first = list_next_entry(last, transfer_list);
+	}
+
+	if (list_empty(batches)) {
+		kfree(batches);
+		return 0;
+	}
+
+	msg->opt_state = batches;
+
+	return 0;
+
+err:
+	fsl_lpspi_free_batches(batches);
+	kfree(batches);
+	return -ENOMEM;
+}
+
+static int fsl_lpspi_unoptimize_message(struct spi_message *msg)
+{
+	struct list_head *batches = msg->opt_state;
+
+	if (batches) {
+		fsl_lpspi_free_batches(batches);
+		kfree(batches);
+	}
+
+	return 0;
+}
+
+static int fsl_lpspi_prepare_message(struct spi_controller *controller,
+				     struct spi_message *msg)
+{
+	struct list_head *batches = msg->opt_state;
+	struct fsl_lpspi_batch *batch;
+	struct spi_transfer *xfer;
+	unsigned int offset;
+
+	if (!batches)
+		return 0;
+
+	/* gather the TX data of each run into its bounce buffer */
+	list_for_each_entry(batch, batches, link) {
+		offset = 0;
+		list_for_each_entry(xfer, &batch->replaced, transfer_list) {
+			if (xfer->tx_buf)
+				memcpy(batch->tx + offset, xfer->tx_buf, xfer->len);
+			else
+				memset(batch->tx + offset, 0, xfer->len);
+			offset += xfer->len;
+		}
+	}
+
+	return 0;
+}
+
+static int fsl_lpspi_unprepare_message(struct spi_controller *controller,
+				       struct spi_message *msg)
+{
+	struct list_head *batches = msg->opt_state;
+	struct fsl_lpspi_batch *batch;
+	struct spi_transfer *xfer;
+	unsigned int offset;
+
+	if (!batches)
+		return 0;
+
+	/* the message is unmapped by now, scatter the RX data back */
+	list_for_each_entry(batch, batches, link) {
+		offset = 0;
+		list_for_each_entry(xfer, &batch->replaced, transfer_list) {
+			if (xfer->rx_buf)
+				memcpy(xfer->rx_buf, batch->rx + offset, xfer->len);
+			offset += xfer->len;
+		}
+	}
+
+	return 0;
+}
+
 static irqreturn_t fsl_lpspi_isr(int irq, void *dev_id)
 {
 	u32 temp_SR, temp_IER;
@@ -935,6 +1135,10 @@ static int fsl_lpspi_probe(struct platform_device *pdev)
 
 	controller->bits_per_word_mask = SPI_BPW_RANGE_MASK(8, 32);
 	controller->transfer_one = fsl_lpspi_transfer_one;
+	controller->optimize_message = fsl_lpspi_optimize_message;
+	controller->unoptimize_message = fsl_lpspi_unoptimize_message;
+	controller->prepare_message = fsl_lpspi_prepare_message;
+	controller->unprepare_message = fsl_lpspi_unprepare_message;
 	controller->prepare_transfer_hardware = lpspi_prepare_xfer_hardware;
 	controller->unprepare_transfer_hardware = lpspi_unprepare_xfer_hardware;
 	controller->mode_bits = SPI_CPOL | SPI_CPHA | SPI_CS_HIGH;
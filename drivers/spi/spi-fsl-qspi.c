@@ -23,6 +23,7 @@
 #include <linux/bitops.h>
 #include <linux/clk.h>
 #include <linux/completion.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/err.h>
 #include <linux/errno.h>
@@ -272,6 +273,17 @@ struct fsl_qspi {
 	struct mutex lock;
 	struct pm_qos_request pm_qos_req;
 	int selected;
+	/*
+	 * Read-ahead cache of one AHB buffer sized line, filled by dirmap
+	 * reads and dropped by anything that may change the flash array.
+	 */
+	u8 *rcache;
+	struct spi_mem_dirmap_desc *rcache_desc;
+	u64 rcache_addr;
+	u64 rcache_hits;
+	u64 rcache_misses;
+	u64 rcache_bypass;
+	struct dentry *debugfs;
 };
 
 static inline int needs_swap_endian(struct fsl_qspi *q)
@@ -638,15 +650,19 @@ static int fsl_qspi_readl_poll_tout(struct fsl_qspi *q, void __iomem *base,
 				  timeout_us);
 }
 
-static int fsl_qspi_exec_op(struct spi_mem *mem, const struct spi_mem_op *op)
+static int fsl_qspi_do_exec_op(struct fsl_qspi *q, struct spi_mem *mem,
+			       const struct spi_mem_op *op)
 {
-	struct fsl_qspi *q = spi_controller_get_devdata(mem->spi->controller);
 	void __iomem *base = q->iobase;
 	u32 addr_offset = 0;
 	int err = 0;
 	int invalid_mstrid = q->devtype_data->invalid_mstrid;
 
-	mutex_lock(&q->lock);
+	lockdep_assert_held(&q->lock);
+
+	/* Erase, program and register writes may all change the array */
+	if (op->data.dir != SPI_MEM_DATA_IN)
+		q->rcache_desc = NULL;
 
 	/* wait for the controller being ready */
 	fsl_qspi_readl_poll_tout(q, base + QUADSPI_SR, (QUADSPI_SR_IP_ACC_MASK |
@@ -695,6 +711,16 @@ static int fsl_qspi_exec_op(struct spi_mem *mem, const struct spi_mem_op *op)
 	/* Invalidate the data in the AHB buffer. */
 	fsl_qspi_invalidate(q);
 
+	return err;
+}
+
+static int fsl_qspi_exec_op(struct spi_mem *mem, const struct spi_mem_op *op)
+{
+	struct fsl_qspi *q = spi_controller_get_devdata(mem->spi->controller);
+	int err;
+
+	mutex_lock(&q->lock);
+	err = fsl_qspi_do_exec_op(q, mem, op);
 	mutex_unlock(&q->lock);
 
 	return err;
@@ -717,6 +743,90 @@ static int fsl_qspi_adjust_op_size(struct spi_mem *mem, struct spi_mem_op *op)
 	return 0;
 }
 
+static int fsl_qspi_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	/* Writes keep going through exec_op(), which drops the cache */
+	if (desc->info.op_tmpl.data.dir != SPI_MEM_DATA_IN)
+		return -EOPNOTSUPP;
+
+	if (!spi_mem_supports_op(desc->mem, &desc->info.op_tmpl))
+		return -EOPNOTSUPP;
+
+	return 0;
+}
+
+static void fsl_qspi_dirmap_destroy(struct spi_mem_dirmap_desc *desc)
+{
+	struct fsl_qspi *q = spi_controller_get_devdata(desc->mem->spi->controller);
+
+	mutex_lock(&q->lock);
+	if (q->rcache_desc == desc)
+		q->rcache_desc = NULL;
+	mutex_unlock(&q->lock);
+}
+
+/*
+ * Small random reads (UBIFS/JFFS2 nodes, directory lookups) each pay the
+ * full command and AHB buffer setup. Serve them from a line of
+ * ahb_buf_size bytes aligned to the AHB buffer, so that neighbouring
+ * reads hit without touching the bus. Reads of a whole line or more go
+ * straight to the flash as before. A short count is returned when a
+ * read crosses the end of the line; spi-nor issues the remainder.
+ */
+static ssize_t fsl_qspi_dirmap_read(struct spi_mem_dirmap_desc *desc,
+				    u64 offs, size_t len, void *buf)
+{
+	struct fsl_qspi *q = spi_controller_get_devdata(desc->mem->spi->controller);
+	u32 line = q->devtype_data->ahb_buf_size;
+	struct spi_mem_op op = desc->info.op_tmpl;
+	u64 addr = desc->info.offset + offs;
+	u64 start = ALIGN_DOWN(addr, line);
+	ssize_t ret;
+	size_t n;
+
+	mutex_lock(&q->lock);
+
+	if (len >= line ||
+	    start + line > desc->info.offset + desc->info.length) {
+		op.addr.val = addr;
+		op.data.buf.in = buf;
+		op.data.nbytes = len;
+		fsl_qspi_adjust_op_size(desc->mem, &op);
+
+		q->rcache_bypass++;
+		ret = fsl_qspi_do_exec_op(q, desc->mem, &op);
+		if (!ret)
+			ret = op.data.nbytes;
+		goto out;
+	}
+
+	if (q->rcache_desc == desc && q->rcache_addr == start) {
+		q->rcache_hits++;
+	} else {
+		op.addr.val = start;
+		op.data.buf.in = q->rcache;
+		op.data.nbytes = line;
+
+		q->rcache_desc = NULL;
+		q->rcache_misses++;
+		ret = fsl_qspi_do_exec_op(q, desc->mem, &op);
+		if (ret)
+			goto out;
+
+		q->rcache_desc = desc;
+		q->rcache_addr = start;
+	}
+
+	n = min_t(u64, len, start + line - addr);
+	memcpy(buf, q->rcache + (addr - start), n);
+	ret = n;
+
+out:
+	mutex_unlock(&q->lock);
+
+	return ret;
+}
+
 static int fsl_qspi_default_setup(struct fsl_qspi *q)
 {
 	void __iomem *base = q->iobase;
@@ -792,6 +902,7 @@ static int fsl_qspi_default_setup(struct fsl_qspi *q)
 		    base + QUADSPI_SFB2AD);
 
 	q->selected = -1;
+	q->rcache_desc = NULL;
 
 	/* Enable the module */
 	qspi_writel(q, QUADSPI_MCR_RESERVED_MASK | QUADSPI_MCR_END_CFG_MASK,
@@ -837,8 +948,21 @@ static const struct spi_controller_mem_ops fsl_qspi_mem_ops = {
 	.supports_op = fsl_qspi_supports_op,
 	.exec_op = fsl_qspi_exec_op,
 	.get_name = fsl_qspi_get_name,
+	.dirmap_create = fsl_qspi_dirmap_create,
+	.dirmap_destroy = fsl_qspi_dirmap_destroy,
+	.dirmap_read = fsl_qspi_dirmap_read,
 };
 
+static void fsl_qspi_debugfs_init(struct fsl_qspi *q)
+{
+	q->debugfs = debugfs_create_dir(dev_name(q->dev), NULL);
+	debugfs_create_u64("rcache_hits", 0444, q->debugfs, &q->rcache_hits);
+	debugfs_create_u64("rcache_misses", 0444, q->debugfs,
+			   &q->rcache_misses);
+	debugfs_create_u64("rcache_bypass", 0444, q->debugfs,
+			   &q->rcache_bypass);
+}
+
 static int fsl_qspi_probe(struct platform_device *pdev)
 {
 	struct spi_controller *ctlr;
@@ -887,6 +1011,12 @@ static int fsl_qspi_probe(struct platform_device *pdev)
 		goto err_put_ctrl;
 	}
 
+	q->rcache = devm_kmalloc(dev, q->devtype_data->ahb_buf_size, GFP_KERNEL);
+	if (!q->rcache) {
+		ret = -ENOMEM;
+		goto err_put_ctrl;
+	}
+
 	/* find the clocks */
 	q->clk_en = devm_clk_get(dev, "qspi_en");
 	if (IS_ERR(q->clk_en)) {
@@ -932,6 +1062,8 @@ static int fsl_qspi_probe(struct platform_device *pdev)
 	if (ret)
 		goto err_destroy_mutex;
 
+	fsl_qspi_debugfs_init(q);
+
 	return 0;
 
 err_destroy_mutex:
@@ -957,6 +1089,7 @@ static void fsl_qspi_remove(struct platform_device *pdev)
 
 	fsl_qspi_clk_disable_unprep(q);
 
+	debugfs_remove_recursive(q->debugfs);
 	mutex_destroy(&q->lock);
 }
 
@@ -1781,6 +1781,25 @@ static int spi_imx_transfer_one(struct spi_controller *controller,
 	return spi_imx_pio_transfer(spi, transfer);
 }
 
+/*
+ * The SDMA script moves data in bursts of the watermark level, and
+ * spi_imx_dma_transfer() has to shrink the watermark until it divides
+ * the transfer length. Peel unaligned tails off large transfers so the
+ * body goes out with half-FIFO bursts and only the tail uses PIO.
+ */
+static int spi_imx_optimize_message(struct spi_message *msg)
+{
+	struct spi_controller *controller = msg->spi->controller;
+	struct spi_imx_data *spi_imx = spi_controller_get_devdata(controller);
+	unsigned int fifo_size = spi_imx->devtype_data->fifo_size;
+
+	if (!use_dma || spi_imx->target_mode || !controller->dma_rx)
+		return 0;
+
+	return spi_split_transfers_tail(controller, msg, fifo_size / 2,
+					fifo_size);
+}
+
 static int spi_imx_setup(struct spi_device *spi)
 {
 	dev_dbg(&spi->dev, "%s: mode %d, %u bpw, %d hz\n", __func__,
@@ -1895,6 +1914,7 @@ static int spi_imx_probe(struct platform_device *pdev)
 	controller->transfer_one = spi_imx_transfer_one;
 	controller->setup = spi_imx_setup;
 	controller->prepare_message = spi_imx_prepare_message;
+	controller->optimize_message = spi_imx_optimize_message;
 	controller->unprepare_message = spi_imx_unprepare_message;
 	controller->target_abort = spi_imx_target_abort;
 	spi_imx->spi_bus_clk = MXC_SPI_DEFAULT_SPEED;
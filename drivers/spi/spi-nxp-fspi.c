@@ -37,6 +37,8 @@
 #include <linux/clk.h>
 #include <linux/completion.h>
 #include <linux/delay.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
 #include <linux/err.h>
 #include <linux/errno.h>
 #include <linux/interrupt.h>
@@ -324,6 +326,8 @@
 #define POLL_TOUT		5000
 #define NXP_FSPI_MAX_CHIPSELECT		4
 #define NXP_FSPI_MIN_IOMAP	SZ_4M
+/* AHB reads at least this long are copied by a DMA memcpy channel */
+#define NXP_FSPI_DMA_MIN_LEN	SZ_1K
 
 #define DCFG_RCWSR1		0x100
 #define SYS_PLL_RAT		GENMASK(6, 2)
@@ -399,6 +403,8 @@ struct nxp_fspi {
 	struct clk *clk, *clk_en;
 	struct device *dev;
 	struct completion c;
+	struct dma_chan *rx_chan;
+	struct completion rx_dma_complete;
 	struct nxp_fspi_devtype_data *devtype_data;
 	struct mutex lock;
 	struct pm_qos_request pm_qos_req;
@@ -851,10 +857,70 @@ static void nxp_fspi_select_mem(struct nxp_fspi *f, struct spi_device *spi,
 	f->selected = spi_get_chipselect(spi, 0);
 }
 
+static void nxp_fspi_rx_dma_callback(void *param)
+{
+	struct nxp_fspi *f = param;
+
+	complete(&f->rx_dma_complete);
+}
+
+/*
+ * Let the DMA engine pull the data out of the AHB window, so the CPU does
+ * not stall on every uncached beat while the flash streams the data out.
+ */
+static int nxp_fspi_read_ahb_dma(struct nxp_fspi *f, void *buf, u32 start,
+				 u32 len)
+{
+	struct dma_async_tx_descriptor *tx;
+	struct device *ddev = f->rx_chan->device->dev;
+	dma_addr_t dma_src = f->memmap_phy + start;
+	dma_cookie_t cookie;
+	dma_addr_t dma_dst;
+	int ret = 0;
+
+	dma_dst = dma_map_single(ddev, buf, len, DMA_FROM_DEVICE);
+	if (dma_mapping_error(ddev, dma_dst))
+		return -ENOMEM;
+
+	tx = dmaengine_prep_dma_memcpy(f->rx_chan, dma_dst, dma_src, len,
+				       DMA_CTRL_ACK | DMA_PREP_INTERRUPT);
+	if (!tx) {
+		ret = -EIO;
+		goto err_unmap;
+	}
+
+	tx->callback = nxp_fspi_rx_dma_callback;
+	tx->callback_param = f;
+	reinit_completion(&f->rx_dma_complete);
+	cookie = dmaengine_submit(tx);
+	ret = dma_submit_error(cookie);
+	if (ret)
+		goto err_unmap;
+
+	dma_async_issue_pending(f->rx_chan);
+	if (!wait_for_completion_timeout(&f->rx_dma_complete,
+					 msecs_to_jiffies(max_t(u32, len, 500)))) {
+		dmaengine_terminate_sync(f->rx_chan);
+		dev_err(f->dev, "AHB read DMA timeout\n");
+		ret = -ETIMEDOUT;
+	}
+
+err_unmap:
+	dma_unmap_single(ddev, dma_dst, len, DMA_FROM_DEVICE);
+
+	return ret;
+}
+
 static int nxp_fspi_read_ahb(struct nxp_fspi *f, const struct spi_mem_op *op)
 {
 	u32 start = op->addr.val;
 	u32 len = op->data.nbytes;
+	void *buf = op->data.buf.in;
+
+	if (f->rx_chan && len >= NXP_FSPI_DMA_MIN_LEN &&
+	    virt_addr_valid(buf) && virt_addr_valid(buf + len - 1) &&
+	    !nxp_fspi_read_ahb_dma(f, buf, start, len))
+		return 0;
 
 	/* if necessary, ioremap before AHB read */
 	if ((!f->ahb_addr) || start < f->memmap_start ||
@@ -1319,11 +1385,61 @@ static const char *nxp_fspi_get_name(struct spi_mem *mem)
 	return name;
 }
 
+static int nxp_fspi_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	struct spi_controller *ctlr = desc->mem->spi->controller;
+	struct nxp_fspi *f = spi_controller_get_devdata(ctlr);
+
+	if (desc->info.op_tmpl.data.dir != SPI_MEM_DATA_IN || needs_ip_only(f))
+		return -EOPNOTSUPP;
+
+	/* The whole AHB window is handed to the selected chip. */
+	if (desc->info.offset + desc->info.length > f->memmap_phy_size)
+		return -EOPNOTSUPP;
+
+	if (!nxp_fspi_supports_op(desc->mem, &desc->info.op_tmpl))
+		return -EOPNOTSUPP;
+
+	return 0;
+}
+
+/*
+ * Direct mapped reads go through the AHB window in one go, instead of
+ * being chopped at the AHB buffer size by adjust_op_size(). Short tails
+ * still take the IP command path in nxp_fspi_exec_op().
+ */
+static ssize_t nxp_fspi_dirmap_read(struct spi_mem_dirmap_desc *desc,
+				    u64 offs, size_t len, void *buf)
+{
+	struct spi_mem_op op = desc->info.op_tmpl;
+	int err;
+
+	op.addr.val = desc->info.offset + offs;
+	op.data.buf.in = buf;
+	op.data.nbytes = min_t(size_t, len, NXP_FSPI_MIN_IOMAP);
+
+	/* keep the OCTAL DTR odd address handling of the regular path */
+	if ((op.addr.val & 1) && op.cmd.dtr && op.addr.dtr &&
+	    op.dummy.dtr && op.data.dtr) {
+		err = nxp_fspi_adjust_op_size(desc->mem, &op);
+		if (err)
+			return err;
+	}
+
+	err = nxp_fspi_exec_op(desc->mem, &op);
+	if (err)
+		return err;
+
+	return op.data.nbytes;
+}
+
 static const struct spi_controller_mem_ops nxp_fspi_mem_ops = {
 	.adjust_op_size = nxp_fspi_adjust_op_size,
 	.supports_op = nxp_fspi_supports_op,
 	.exec_op = nxp_fspi_exec_op,
 	.get_name = nxp_fspi_get_name,
+	.dirmap_create = nxp_fspi_dirmap_create,
+	.dirmap_read = nxp_fspi_dirmap_read,
 };
 
 static const struct spi_controller_mem_caps nxp_fspi_mem_caps = {
@@ -1354,10 +1470,31 @@ static void nxp_fspi_cleanup(void *data)
 
 	mutex_destroy(&f->lock);
 
+	if (f->rx_chan)
+		dma_release_channel(f->rx_chan);
+
 	if (f->ahb_addr)
 		iounmap(f->ahb_addr);
 }
 
+static void nxp_fspi_request_mmap_dma(struct nxp_fspi *f)
+{
+	dma_cap_mask_t mask;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_MEMCPY, mask);
+
+	/* DMA is optional, fall back to memcpy_fromio() without it */
+	f->rx_chan = dma_request_chan_by_mask(&mask);
+	if (IS_ERR(f->rx_chan)) {
+		dev_dbg(f->dev, "no memcpy DMA channel for AHB reads\n");
+		f->rx_chan = NULL;
+		return;
+	}
+
+	init_completion(&f->rx_dma_complete);
+}
+
 static int nxp_fspi_probe(struct platform_device *pdev)
 {
 	struct spi_controller *ctlr;
@@ -1461,6 +1598,9 @@ static int nxp_fspi_probe(struct platform_device *pdev)
 
 	mutex_init(&f->lock);
 
+	if (!needs_ip_only(f))
+		nxp_fspi_request_mmap_dma(f);
+
 	ctlr->bus_num = -1;
 	ctlr->num_chipselect = NXP_FSPI_MAX_CHIPSELECT;
 	ctlr->mem_ops = &nxp_fspi_mem_ops;
@@ -35,6 +35,8 @@
 #include <linux/clk.h>
 #include <linux/completion.h>
 #include <linux/delay.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
 #include <linux/err.h>
 #include <linux/errno.h>
 #include <linux/interrupt.h>
@@ -211,6 +213,7 @@
 #define XSPI_FR_TFF			BIT(0)
 
 #define XSPI_RSER			0x164
+#define XSPI_RSER_TBFDE			BIT(27)
 #define XSPI_RSER_TFIE			BIT(0)
 
 #define XSPI_SFA1AD			0x180
@@ -323,6 +326,16 @@
 #define NXP_XSPI_MAX_CHIPSELECT		2
 #define POLL_TOUT		5000
 
+/* ops with at least this much data move it by DMA instead of PIO */
+#define NXP_XSPI_DMA_MIN_LEN	128
+/* TX buffer words moved per DMA request */
+#define NXP_XSPI_DMA_TX_BURST	8
+
+static bool use_dma = true;
+module_param(use_dma, bool, 0644);
+MODULE_PARM_DESC(use_dma,
+		 "move IP command TX data and AHB reads by DMA, e.g. to compare with mtd_speedtest");
+
 /* Access flash memory using IP bus only */
 #define XSPI_QUIRK_USE_IP_ONLY	BIT(0)
 
@@ -343,6 +356,7 @@ static struct nxp_xspi_devtype_data imx94_data = {
 
 struct nxp_xspi {
 	void __iomem *iobase;
+	phys_addr_t iobase_phy;
 	void __iomem *ahb_addr;
 	u32 memmap_phy;
 	u32 memmap_phy_size;
@@ -351,6 +365,10 @@ struct nxp_xspi {
 	struct clk *clk;
 	struct device *dev;
 	struct completion c;
+	/* slave channel feeding TBDR, memcpy channel for AHB reads */
+	struct dma_chan *tx_chan;
+	struct dma_chan *rx_chan;
+	struct completion dma_c;
 	struct nxp_xspi_devtype_data *devtype_data;
 	struct mutex lock;
 	int selected;
@@ -771,10 +789,71 @@ static void nxp_xspi_select_mem(struct nxp_xspi *xspi, struct spi_device *spi,
 		nxp_xspi_dll_auto(xspi, rate);
 }
 
+static void nxp_xspi_dma_callback(void *param)
+{
+	struct nxp_xspi *xspi = param;
+
+	complete(&xspi->dma_c);
+}
+
+static int nxp_xspi_dma_wait(struct nxp_xspi *xspi, struct dma_chan *chan,
+			     u32 len)
+{
+	if (!wait_for_completion_timeout(&xspi->dma_c,
+					 msecs_to_jiffies(max_t(u32, len, 1000)))) {
+		dmaengine_terminate_sync(chan);
+		dev_err(xspi->dev, "DMA timeout\n");
+		return -ETIMEDOUT;
+	}
+
+	return 0;
+}
+
+static int nxp_xspi_ahb_read_dma(struct nxp_xspi *xspi, void *buf, u32 start,
+				 u32 len)
+{
+	struct device *ddev = xspi->rx_chan->device->dev;
+	struct dma_async_tx_descriptor *tx;
+	dma_addr_t dma_dst;
+	int ret;
+
+	dma_dst = dma_map_single(ddev, buf, len, DMA_FROM_DEVICE);
+	if (dma_mapping_error(ddev, dma_dst))
+		return -ENOMEM;
+
+	tx = dmaengine_prep_dma_memcpy(xspi->rx_chan, dma_dst,
+				       xspi->memmap_phy + start, len,
+				       DMA_CTRL_ACK | DMA_PREP_INTERRUPT);
+	if (!tx) {
+		ret = -EIO;
+		goto out;
+	}
+
+	tx->callback = nxp_xspi_dma_callback;
+	tx->callback_param = xspi;
+	reinit_completion(&xspi->dma_c);
+	ret = dma_submit_error(dmaengine_submit(tx));
+	if (ret)
+		goto out;
+
+	dma_async_issue_pending(xspi->rx_chan);
+	ret = nxp_xspi_dma_wait(xspi, xspi->rx_chan, len);
+
+out:
+	dma_unmap_single(ddev, dma_dst, len, DMA_FROM_DEVICE);
+	return ret;
+}
+
 static int nxp_xspi_ahb_read(struct nxp_xspi *xspi, const struct spi_mem_op *op)
 {
 	u32 start = op->addr.val;
 	u32 len = op->data.nbytes;
+	void *buf = op->data.buf.in;
+
+	if (use_dma && xspi->rx_chan && len >= NXP_XSPI_DMA_MIN_LEN &&
+	    virt_addr_valid(buf) && virt_addr_valid(buf + len - 1) &&
+	    !nxp_xspi_ahb_read_dma(xspi, buf, start, len))
+		return 0;
 
 	/* if necessary, ioremap before AHB read */
 	if ((!xspi->ahb_addr) || start < xspi->memmap_start ||
@@ -890,12 +969,74 @@ static void nxp_xspi_read_rxfifo(struct nxp_xspi *xspi,
 				   XSPI_MCR_CLR_RXF, 1, POLL_TOUT, false);
 }
 
+/*
+ * Map the page program data and queue a descriptor that feeds TBDR. The
+ * channel is only kicked once the IP command has been triggered, the
+ * watermark then paces the requests the same way the PIO loop is paced.
+ */
+static int nxp_xspi_tx_dma_prep(struct nxp_xspi *xspi,
+				const struct spi_mem_op *op, dma_addr_t *dma)
+{
+	struct device *ddev = xspi->tx_chan->device->dev;
+	struct dma_slave_config cfg = {
+		.direction = DMA_MEM_TO_DEV,
+		.dst_addr = xspi->iobase_phy + XSPI_TBDR,
+		.dst_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES,
+		.dst_maxburst = NXP_XSPI_DMA_TX_BURST,
+	};
+	struct dma_async_tx_descriptor *tx;
+	void *buf = (void *)op->data.buf.out;
+	u32 len = op->data.nbytes;
+	int ret;
+
+	if (!use_dma || !xspi->tx_chan || len < NXP_XSPI_DMA_MIN_LEN ||
+	    len % (NXP_XSPI_DMA_TX_BURST * 4) ||
+	    !virt_addr_valid(buf) || !virt_addr_valid(buf + len - 1))
+		return -EOPNOTSUPP;
+
+	ret = dmaengine_slave_config(xspi->tx_chan, &cfg);
+	if (ret)
+		return ret;
+
+	*dma = dma_map_single(ddev, buf, len, DMA_TO_DEVICE);
+	if (dma_mapping_error(ddev, *dma))
+		return -ENOMEM;
+
+	tx = dmaengine_prep_slave_single(xspi->tx_chan, *dma, len,
+					 DMA_MEM_TO_DEV,
+					 DMA_CTRL_ACK | DMA_PREP_INTERRUPT);
+	if (!tx) {
+		ret = -EIO;
+		goto err_unmap;
+	}
+
+	tx->callback = nxp_xspi_dma_callback;
+	tx->callback_param = xspi;
+	reinit_completion(&xspi->dma_c);
+	ret = dma_submit_error(dmaengine_submit(tx));
+	if (ret)
+		goto err_terminate;
+
+	return 0;
+
+err_terminate:
+	dmaengine_terminate_sync(xspi->tx_chan);
+err_unmap:
+	dma_unmap_single(ddev, *dma, len, DMA_TO_DEVICE);
+	return ret;
+}
+
 static int nxp_xspi_do_op(struct nxp_xspi *xspi, const struct spi_mem_op *op)
 {
 	void __iomem *base = xspi->iobase;
 	int watermark, err = 0;
+	bool tx_dma = false;
+	dma_addr_t tx_dma_addr;
 	u32 reg;
 
+	if (op->data.nbytes && op->data.dir == SPI_MEM_DATA_OUT)
+		tx_dma = !nxp_xspi_tx_dma_prep(xspi, op, &tx_dma_addr);
+
 	if (op->data.nbytes && op->data.dir == SPI_MEM_DATA_OUT) {
 		/* clear the TX FIFO. */
 		reg = xspi_readl(xspi, base + XSPI_MCR);
@@ -904,7 +1045,10 @@ static int nxp_xspi_do_op(struct nxp_xspi *xspi, const struct spi_mem_op *op)
 		/* Wait for the CLR_TXF clear */
 		err = xspi_readl_poll_tout(xspi, base + XSPI_MCR,
 					   XSPI_MCR_CLR_TXF, 1, POLL_TOUT, false);
-		watermark = (xspi->devtype_data->txfifo - ALIGN_DOWN(op->data.nbytes, 4)) / 4 + 1;
+		if (tx_dma)
+			watermark = NXP_XSPI_DMA_TX_BURST;
+		else
+			watermark = (xspi->devtype_data->txfifo - ALIGN_DOWN(op->data.nbytes, 4)) / 4 + 1;
 		reg = XSPI_TBCT_WMRK(watermark);
 		xspi_writel(xspi, reg, base + XSPI_TBCT);
 
@@ -931,13 +1075,29 @@ static int nxp_xspi_do_op(struct nxp_xspi *xspi, const struct spi_mem_op *op)
 
 	xspi_writel(xspi, reg, base + XSPI_SFP_TG_IPCR);
 
-	if (op->data.nbytes && op->data.dir == SPI_MEM_DATA_OUT)
+	if (tx_dma) {
+		dma_async_issue_pending(xspi->tx_chan);
+		xspi_writel(xspi, XSPI_RSER_TFIE | XSPI_RSER_TBFDE,
+			    base + XSPI_RSER);
+	} else if (op->data.nbytes && op->data.dir == SPI_MEM_DATA_OUT) {
 		nxp_xspi_fill_txfifo(xspi, op);
+	}
 
 	/* Wait for the interrupt. */
 	if (!wait_for_completion_timeout(&xspi->c, msecs_to_jiffies(1000)))
 		err = -ETIMEDOUT;
 
+	if (tx_dma) {
+		if (err)
+			dmaengine_terminate_sync(xspi->tx_chan);
+		else
+			err = nxp_xspi_dma_wait(xspi, xspi->tx_chan,
+						op->data.nbytes);
+		xspi_writel(xspi, XSPI_RSER_TFIE, base + XSPI_RSER);
+		dma_unmap_single(xspi->tx_chan->device->dev, tx_dma_addr,
+				 op->data.nbytes, DMA_TO_DEVICE);
+	}
+
 	/* Invoke IP data read, if request is of data read. */
 	if (!err && op->data.nbytes && op->data.dir == SPI_MEM_DATA_IN)
 		nxp_xspi_read_rxfifo(xspi, op);
@@ -1178,6 +1338,11 @@ static void nxp_xspi_cleanup(void *data)
 
 	nxp_xspi_clk_disable_unprep(xspi);
 
+	if (xspi->tx_chan)
+		dma_release_channel(xspi->tx_chan);
+	if (xspi->rx_chan)
+		dma_release_channel(xspi->rx_chan);
+
 	if (xspi->ahb_addr)
 		iounmap(xspi->ahb_addr);
 
@@ -1185,6 +1350,34 @@ static void nxp_xspi_cleanup(void *data)
 	pm_runtime_put_noidle(xspi->dev);
 }
 
+static int nxp_xspi_dma_init(struct nxp_xspi *xspi)
+{
+	dma_cap_mask_t mask;
+
+	xspi->tx_chan = dma_request_chan(xspi->dev, "tx");
+	if (IS_ERR(xspi->tx_chan)) {
+		if (PTR_ERR(xspi->tx_chan) == -EPROBE_DEFER)
+			return -EPROBE_DEFER;
+		xspi->tx_chan = NULL;
+	}
+
+	if (!needs_ip_only(xspi)) {
+		dma_cap_zero(mask);
+		dma_cap_set(DMA_MEMCPY, mask);
+		xspi->rx_chan = dma_request_chan_by_mask(&mask);
+		if (IS_ERR(xspi->rx_chan))
+			xspi->rx_chan = NULL;
+	}
+
+	init_completion(&xspi->dma_c);
+
+	/* DMA is optional, every op can still be done by PIO */
+	dev_dbg(xspi->dev, "TX DMA %s, AHB read DMA %s\n",
+		xspi->tx_chan ? "on" : "off", xspi->rx_chan ? "on" : "off");
+
+	return 0;
+}
+
 static int nxp_xspi_probe(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
@@ -1209,9 +1402,11 @@ static int nxp_xspi_probe(struct platform_device *pdev)
 	platform_set_drvdata(pdev, xspi);
 
 	/* find the resources - configuration register address space */
-	xspi->iobase = devm_platform_ioremap_resource_byname(pdev, "base");
+	res = platform_get_resource_byname(pdev, IORESOURCE_MEM, "base");
+	xspi->iobase = devm_ioremap_resource(dev, res);
 	if (IS_ERR(xspi->iobase))
 		return PTR_ERR(xspi->iobase);
+	xspi->iobase_phy = res->start;
 
 	/* find the resources - controller memory mapped space */
 	res = platform_get_resource_byname(pdev, IORESOURCE_MEM, "mmap");
@@ -1260,6 +1455,10 @@ static int nxp_xspi_probe(struct platform_device *pdev)
 
 	devm_mutex_init(dev, &xspi->lock);
 
+	ret = nxp_xspi_dma_init(xspi);
+	if (ret)
+		return ret;
+
 	ret = devm_add_action_or_reset(dev, nxp_xspi_cleanup, xspi);
 	if (ret)
 		return ret;
@@ -3823,6 +3823,48 @@ int spi_split_transfers_maxwords(struct spi_controller *ctlr,
 }
 EXPORT_SYMBOL_GPL(spi_split_transfers_maxwords);
 
+/**
+ * spi_split_transfers_tail - split the unaligned tail off SPI transfers
+ * @ctlr:       the @spi_controller for this transfer
+ * @msg:        the @spi_message to transform
+ * @alignwords: the number of SPI words the body of a transfer is aligned to
+ * @minsize:    only split transfers whose aligned body is at least this long
+ *
+ * Transfers that are not a multiple of @alignwords SPI words are replaced by
+ * an aligned body and a short tail, so that a controller can move the body
+ * with full DMA bursts and the tail by PIO within the same message.
+ *
+ * This function allocates resources that are automatically freed during the
+ * spi message unoptimize phase so this function should only be called from
+ * optimize_message callbacks.
+ *
+ * Return: status of transformation
+ */
+int spi_split_transfers_tail(struct spi_controller *ctlr,
+			     struct spi_message *msg,
+			     size_t alignwords, size_t minsize)
+{
+	struct spi_transfer *xfer;
+
+	/* As above, xfer is advanced past the transfers we insert. */
+	list_for_each_entry(xfer, &msg->transfers, transfer_list) {
+		size_t align, body;
+		int ret;
+
+		align = alignwords * roundup_pow_of_two(BITS_TO_BYTES(xfer->bits_per_word));
+		body = rounddown(xfer->len, align);
+		if (body < minsize || body == xfer->len)
+			continue;
+
+		ret = __spi_split_transfer_maxsize(ctlr, msg, &xfer, body);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(spi_split_transfers_tail);
+
 /*-------------------------------------------------------------------------*/
 
 /*
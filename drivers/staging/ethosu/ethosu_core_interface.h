@@ -24,10 +24,13 @@ namespace EthosU {
 /** Maximum number of PMU counters to be returned for inference */
 #define ETHOSU_CORE_PMU_MAX 4
 
+/** Maximum number of inferences in a batch request or response */
+#define ETHOSU_CORE_BATCH_MAX 8
+
 #define ETHOSU_CORE_MSG_MAGIC 0x41457631
 #define ETHOSU_CORE_MSG_VERSION_MAJOR 0
 #define ETHOSU_CORE_MSG_VERSION_MINOR 2
-#define ETHOSU_CORE_MSG_VERSION_PATCH 0
+#define ETHOSU_CORE_MSG_VERSION_PATCH 2
 
 #define ETHOSU_CORE_INFERENCE_MODEL 0
 #define ETHOSU_CORE_INFERENCE_OP    1
@@ -53,6 +56,11 @@ enum ethosu_core_msg_type {
 	ETHOSU_CORE_MSG_CANCEL_INFERENCE_RSP,
 	ETHOSU_CORE_MSG_POWER_REQ,
 	ETHOSU_CORE_MSG_POWER_RSP,
+	ETHOSU_CORE_MSG_INFERENCE_BATCH_REQ,
+	ETHOSU_CORE_MSG_INFERENCE_BATCH_RSP,
+	ETHOSU_CORE_MSG_NETWORK_LOAD_REQ,
+	ETHOSU_CORE_MSG_NETWORK_LOAD_RSP,
+	ETHOSU_CORE_MSG_NETWORK_UNLOAD_REQ,
 	ETHOSU_CORE_MSG_MAX
 };
 
@@ -109,10 +117,14 @@ struct ethosu_core_buffer {
 
 /**
  * enum ethosu_core_network_type - Network buffer type
+ * @ETHOSU_CORE_NETWORK_HANDLE:	Network loaded with
+ *				ETHOSU_CORE_MSG_NETWORK_LOAD_REQ, referenced
+ *				by the handle in the index field.
  */
 enum ethosu_core_network_type {
 	ETHOSU_CORE_NETWORK_BUFFER = 1,
-	ETHOSU_CORE_NETWORK_INDEX
+	ETHOSU_CORE_NETWORK_INDEX,
+	ETHOSU_CORE_NETWORK_HANDLE
 };
 
 /**
@@ -157,6 +169,50 @@ struct ethosu_core_inference_rsp {
 	uint64_t pmu_cycle_counter_count;
 };
 
+/**
+ * struct ethosu_core_inference_batch_req - Batched inference request
+ *
+ * Carries @count inference requests in a single message. Each request
+ * keeps its own user_arg and is answered through an entry of an
+ * ETHOSU_CORE_MSG_INFERENCE_BATCH_RSP message.
+ */
+struct ethosu_core_inference_batch_req {
+	uint32_t                         count;
+	uint32_t                         _reserved;
+	struct ethosu_core_inference_req req[];
+};
+
+/**
+ * struct ethosu_core_inference_stats - Inference timing
+ * @core_cycles:	Core cycles spent running the inference
+ * @queue_wait_us:	Time the request spent queued before it was run
+ */
+struct ethosu_core_inference_stats {
+	uint64_t core_cycles;
+	uint32_t queue_wait_us;
+	uint32_t _reserved;
+};
+
+/**
+ * struct ethosu_core_inference_batch_entry - Batched inference response entry
+ */
+struct ethosu_core_inference_batch_entry {
+	struct ethosu_core_inference_rsp   rsp;
+	struct ethosu_core_inference_stats stats;
+};
+
+/**
+ * struct ethosu_core_inference_batch_rsp - Coalesced inference responses
+ *
+ * The firmware may answer the requests of one batch over several
+ * responses, and may coalesce completions of different batches.
+ */
+struct ethosu_core_inference_batch_rsp {
+	uint32_t                                 count;
+	uint32_t                                 _reserved;
+	struct ethosu_core_inference_batch_entry rsp[];
+};
+
 /**
  * struct ethosu_core_network_info_req - Network information request
  */
@@ -187,6 +243,37 @@ struct ethosu_core_network_info_rsp {
 	u32      status;
 };
 
+/**
+ * struct ethosu_core_network_load_req - Network load request
+ *
+ * Asks the firmware to parse the network and keep it resident until an
+ * ETHOSU_CORE_MSG_NETWORK_UNLOAD_REQ for the returned handle.
+ */
+struct ethosu_core_network_load_req {
+	u64                               user_arg;
+	struct ethosu_core_network_buffer network;
+};
+
+/**
+ * struct ethosu_core_network_load_rsp - Network load response
+ * @handle:	Handle of the loaded network, never 0
+ */
+struct ethosu_core_network_load_rsp {
+	u64 user_arg;
+	u32 handle;
+	u32 status;
+};
+
+/**
+ * struct ethosu_core_network_unload_req - Network unload request
+ *
+ * Not answered by the firmware.
+ */
+struct ethosu_core_network_unload_req {
+	u32 handle;
+	u32 _reserved;
+};
+
 /**
  * struct ethosu_core_msg_version - Message protocol version
  */
@@ -224,6 +311,18 @@ struct ethosu_core_msg_capabilities_rsp {
 	uint32_t custom_dma;
 };
 
+/**
+ * struct ethosu_core_msg_capabilities_ext - Capabilities response extension
+ * @batch_max:	Maximum number of requests per batch, 0 if unsupported
+ *
+ * Appended to struct ethosu_core_msg_capabilities_rsp by firmware
+ * supporting ETHOSU_CORE_MSG_INFERENCE_BATCH_REQ.
+ */
+struct ethosu_core_msg_capabilities_ext {
+	uint32_t batch_max;
+	uint32_t _reserved;
+};
+
 /**
  * struct ethosu_core_cancel_inference_req - Message cancel inference request
  */
@@ -31,6 +31,7 @@
 #include "ethosu_inference.h"
 #include "ethosu_network.h"
 #include "ethosu_network_info.h"
+#include "ethosu_network_load.h"
 #include "uapi/ethosu.h"
 
 #include <linux/dma-mapping.h>
@@ -80,6 +81,16 @@ static int ethosu_handle_msg(struct ethosu_device *edev, void *data)
 	struct ethosu_core_network_info_rsp *network_info =
 			(struct ethosu_core_network_info_rsp *)
 			((char *)data + sizeof(struct ethosu_core_msg));
+	struct ethosu_core_network_load_rsp *network_load =
+			(struct ethosu_core_network_load_rsp *)
+			((char *)data + sizeof(struct ethosu_core_msg));
+	struct ethosu_core_inference_batch_rsp *batch =
+			(struct ethosu_core_inference_batch_rsp *)
+			((char *)data + sizeof(struct ethosu_core_msg));
+	struct ethosu_core_msg_capabilities_ext *capabilities_ext =
+			(struct ethosu_core_msg_capabilities_ext *)
+			(capabilities + 1);
+	uint32_t i;
 
 	switch (header->type) {
 	case ETHOSU_CORE_MSG_ERR:
@@ -119,7 +130,26 @@ static int ethosu_handle_msg(struct ethosu_device *edev, void *data)
 			"Msg: Inference response. user_arg=0x%llx, ofm_count=%u, status=%u\n",
 			rsp->user_arg, rsp->ofm_count,
 			rsp->status);
-		ethosu_inference_rsp(edev, rsp);
+		ethosu_inference_rsp(edev, rsp, NULL);
+		break;
+	case ETHOSU_CORE_MSG_INFERENCE_BATCH_RSP:
+		if (header->length < sizeof(struct ethosu_core_inference_batch_rsp) ||
+		    batch->count > ETHOSU_CORE_BATCH_MAX ||
+		    header->length != struct_size(batch, rsp, batch->count)) {
+			dev_warn(edev->dev,
+				 "Msg: Inference batch response of incorrect size. size=%u\n",
+				 header->length);
+			ret = -EBADMSG;
+			break;
+		}
+
+		dev_dbg(edev->dev,
+			"Msg: Inference batch response. count=%u\n",
+			batch->count);
+
+		for (i = 0; i < batch->count; i++)
+			ethosu_inference_rsp(edev, &batch->rsp[i].rsp,
+					     &batch->rsp[i].stats);
 		break;
 	case ETHOSU_CORE_MSG_VERSION_RSP:
 		if (header->length != sizeof(struct ethosu_core_msg_version)) {
@@ -146,7 +176,9 @@ static int ethosu_handle_msg(struct ethosu_device *edev, void *data)
 
 		break;
 	case ETHOSU_CORE_MSG_CAPABILITIES_RSP:
-		if (header->length != sizeof(struct ethosu_core_msg_capabilities_rsp)) {
+		if (header->length != sizeof(struct ethosu_core_msg_capabilities_rsp) &&
+		    header->length != sizeof(struct ethosu_core_msg_capabilities_rsp) +
+				      sizeof(struct ethosu_core_msg_capabilities_ext)) {
 			dev_warn(edev->dev,
 				 "Msg: Capabilities response of incorrect size. size=%u, expected=%zu\n", header->length,
 				 sizeof(struct ethosu_core_msg_capabilities_rsp));
@@ -171,6 +203,13 @@ static int ethosu_handle_msg(struct ethosu_device *edev, void *data)
 			capabilities->cmd_stream_version,
 			capabilities->custom_dma);
 
+		/* Firmware supporting batched inference appends its limit */
+		if (header->length > sizeof(struct ethosu_core_msg_capabilities_rsp))
+			edev->batch_max = min_t(u32, capabilities_ext->batch_max,
+						ETHOSU_CORE_BATCH_MAX);
+		else
+			edev->batch_max = 0;
+
 		ethosu_capability_rsp(edev, capabilities);
 		break;
 	case ETHOSU_CORE_MSG_NETWORK_INFO_RSP:
@@ -189,6 +228,22 @@ static int ethosu_handle_msg(struct ethosu_device *edev, void *data)
 
 		ethosu_network_info_rsp(edev, network_info);
 		break;
+	case ETHOSU_CORE_MSG_NETWORK_LOAD_RSP:
+		if (header->length != sizeof(struct ethosu_core_network_load_rsp)) {
+			dev_warn(edev->dev,
+				 "Msg: Network load response of incorrect size. size=%u, expected=%zu\n",
+				 header->length, sizeof(struct ethosu_core_network_load_rsp));
+			ret = -EBADMSG;
+			break;
+		}
+
+		dev_dbg(edev->dev,
+			"Msg: Network load response. user_arg=0x%llx, handle=%u, status=%u",
+			network_load->user_arg, network_load->handle,
+			network_load->status);
+
+		ethosu_network_load_rsp(edev, network_load);
+		break;
 	default:
 		/* This should not happen due to version checks */
 		dev_warn(edev->dev, "Msg: Protocol error\n");
@@ -291,6 +346,21 @@ static long ethosu_ioctl(struct file *file,
 		ret = ethosu_buffer_create(edev, uapi.capacity);
 		break;
 	}
+	case ETHOSU_IOCTL_INFERENCE_BATCH: {
+		struct ethosu_uapi_inference_batch uapi;
+
+		if (copy_from_user(&uapi, udata, sizeof(uapi))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		dev_dbg(edev->dev,
+			"Device ioctl: Inference batch. count=%u\n",
+			uapi.count);
+
+		ret = ethosu_inference_batch(edev, &uapi);
+		break;
+	}
 	case ETHOSU_IOCTL_NETWORK_CREATE: {
 		struct ethosu_uapi_network_create uapi;
 
@@ -323,9 +393,11 @@ static void ethosu_rpmsg_rx(void *user_arg, void *data)
 
 	mutex_lock(&edev->mutex);
 
-	do {
-		ret = ethosu_handle_msg(edev, data);
-	} while (ret != 0);
+	/* Each callback carries one message, don't spin on a bad one */
+	ret = ethosu_handle_msg(edev, data);
+	if (ret)
+		dev_dbg(edev->dev, "Msg: Failed to handle message. ret=%d\n",
+			ret);
 
 	mutex_unlock(&edev->mutex);
 }
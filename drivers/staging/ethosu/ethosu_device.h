@@ -39,6 +39,8 @@
 
 /**
  * struct ethosu_device - Device structure
+ * @batch_max:	Maximum inferences per batch message advertised by the
+ *		firmware capabilities, 0 if batching is not supported
  */
 struct ethosu_device {
 	struct device         *dev;
@@ -48,6 +50,7 @@ struct ethosu_device {
 	struct mutex          mutex;
 	struct ethosu_rpmsg   erp;
 	bool                  open;
+	u32                   batch_max;
 };
 
 /****************************************************************************
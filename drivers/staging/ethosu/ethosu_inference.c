@@ -34,7 +34,9 @@
 #include <linux/anon_inodes.h>
 #include <linux/file.h>
 #include <linux/fs.h>
+#include <linux/ktime.h>
 #include <linux/poll.h>
+#include <linux/slab.h>
 
 /****************************************************************************
  * Variables
@@ -90,12 +92,13 @@ static const char *status_to_string(const enum ethosu_uapi_status status)
 	}
 }
 
-static int ethosu_inference_send(struct ethosu_inference *inf)
+static void ethosu_inference_prepare(struct ethosu_inference *inf)
 {
-	int ret;
-
 	inf->status = ETHOSU_UAPI_STATUS_ERROR;
 	inf->done = false;
+	inf->core_cycles = 0;
+	inf->queue_wait_us = 0;
+	inf->latency_us = 0;
 
 	/* Get pointer to arena buffer, sync the input data */
 	phys_addr_t paddr = dma_to_phys(inf->edev->dev, inf->ifm[0]->dma_addr_orig);
@@ -104,12 +107,28 @@ static int ethosu_inference_send(struct ethosu_inference *inf)
 		arch_sync_dma_for_device(paddr + inf->memory_layout.input_offset[i],
 					 inf->memory_layout.input_size[i], DMA_TO_DEVICE);
 	}
+}
+
+static void ethosu_inference_submitted(struct ethosu_inference *inf)
+{
+	inf->status = ETHOSU_UAPI_STATUS_RUNNING;
+	inf->submit_time = ktime_get();
+
+	ethosu_inference_get(inf);
+}
+
+static int ethosu_inference_send(struct ethosu_inference *inf)
+{
+	int ret;
+
+	ethosu_inference_prepare(inf);
 
 	ret = ethosu_rpmsg_inference(&inf->edev->erp, &inf->msg,
 				     inf->ifm_count, inf->ifm,
 				     inf->ofm_count, inf->ofm,
 				     inf->net->buf,
 				     inf->net->index,
+				     inf->net->handle,
 				     inf->pmu_event_config,
 				     ETHOSU_PMU_EVENT_MAX,
 				     inf->pmu_cycle_counter_enable,
@@ -124,13 +143,61 @@ static int ethosu_inference_send(struct ethosu_inference *inf)
 		return ret;
 	}
 
-	inf->status = ETHOSU_UAPI_STATUS_RUNNING;
-
-	ethosu_inference_get(inf);
+	ethosu_inference_submitted(inf);
 
 	return 0;
 }
 
+static int ethosu_inference_send_batch(struct ethosu_device *edev,
+				       struct ethosu_inference **inf,
+				       uint32_t count)
+{
+	struct ethosu_core_inference_req *req;
+	uint32_t i;
+	int ret;
+
+	req = kcalloc(count, sizeof(*req), GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		ethosu_inference_prepare(inf[i]);
+
+		ret = ethosu_rpmsg_inference_fill(&edev->erp, &inf[i]->msg,
+						  &req[i],
+						  inf[i]->ifm_count, inf[i]->ifm,
+						  inf[i]->ofm_count, inf[i]->ofm,
+						  inf[i]->net->buf,
+						  inf[i]->net->index,
+						  inf[i]->net->handle,
+						  inf[i]->pmu_event_config,
+						  ETHOSU_PMU_EVENT_MAX,
+						  inf[i]->pmu_cycle_counter_enable,
+						  inf[i]->memory_layout.flash_offset,
+						  inf[i]->memory_layout.arena_offset,
+						  inf[i]->inference_type);
+		if (ret)
+			goto free_req;
+	}
+
+	ret = ethosu_rpmsg_inference_batch(&edev->erp, req, count);
+	if (ret) {
+		dev_warn(edev->dev,
+			 "Failed to send inference batch. count=%u, ret=%d",
+			 count, ret);
+
+		goto free_req;
+	}
+
+	for (i = 0; i < count; i++)
+		ethosu_inference_submitted(inf[i]);
+
+free_req:
+	kfree(req);
+
+	return ret;
+}
+
 static void ethosu_inference_fail(struct ethosu_rpmsg_msg *msg)
 {
 	struct ethosu_inference *inf =
@@ -304,6 +371,17 @@ static long ethosu_inference_ioctl(struct file *file,
 		ret = ethosu_inference_send(inf);
 		break;
 	}
+	case ETHOSU_IOCTL_INFERENCE_STATS: {
+		struct ethosu_uapi_inference_stats uapi = {
+			.core_cycles   = inf->core_cycles,
+			.queue_wait_us = inf->queue_wait_us,
+			.latency_us    = inf->latency_us,
+		};
+
+		ret = copy_to_user(udata, &uapi, sizeof(uapi)) ? -EFAULT : 0;
+
+		break;
+	}
 	case ETHOSU_IOCTL_INFERENCE_CANCEL: {
 		struct ethosu_uapi_cancel_inference_status uapi;
 
@@ -463,6 +541,70 @@ int ethosu_inference_create(struct ethosu_device *edev,
 	return ret;
 }
 
+int ethosu_inference_batch(struct ethosu_device *edev,
+			   struct ethosu_uapi_inference_batch *uapi)
+{
+	struct ethosu_inference *inf[ETHOSU_BATCH_MAX];
+	uint32_t batch_max;
+	uint32_t count;
+	uint32_t i, j, n;
+	int ret = 0;
+
+	if (!uapi->count || uapi->count > ETHOSU_BATCH_MAX)
+		return -EINVAL;
+
+	for (count = 0; count < uapi->count; count++) {
+		inf[count] = ethosu_inference_get_from_fd(uapi->fd[count]);
+		if (IS_ERR(inf[count])) {
+			ret = PTR_ERR(inf[count]);
+			goto put_inf;
+		}
+
+		/* Each inference can only be pending once */
+		for (j = 0; j < count; j++) {
+			if (inf[j] == inf[count])
+				ret = -EINVAL;
+		}
+
+		if (inf[count]->edev != edev ||
+		    (inf[count]->status == ETHOSU_UAPI_STATUS_RUNNING &&
+		     !inf[count]->done))
+			ret = ret ? : -EBUSY;
+
+		if (ret) {
+			count++;
+			goto put_inf;
+		}
+	}
+
+	/* Fall back to one message per inference for older firmware */
+	batch_max = min_t(uint32_t, edev->batch_max,
+			  ethosu_rpmsg_inference_batch_max(&edev->erp));
+
+	for (i = 0; i < count; i += n) {
+		if (batch_max < 2) {
+			n = 1;
+			ret = ethosu_inference_send(inf[i]);
+		} else {
+			n = min(count - i, batch_max);
+			ret = ethosu_inference_send_batch(edev, &inf[i], n);
+		}
+
+		if (ret)
+			break;
+	}
+
+	dev_dbg(edev->dev,
+		"Inference batch. count=%u, batch_max=%u, sent=%u, ret=%d\n",
+		count, batch_max, ret ? i : count, ret);
+
+put_inf:
+	while (count-- > 0)
+		ethosu_inference_put(inf[count]);
+
+	return ret;
+}
+
 struct ethosu_inference *ethosu_inference_get_from_fd(int fd)
 {
 	struct ethosu_inference *inf;
@@ -496,7 +638,8 @@ int ethosu_inference_put(struct ethosu_inference *inf)
 }
 
 void ethosu_inference_rsp(struct ethosu_device *edev,
-			  struct ethosu_core_inference_rsp *rsp)
+			  struct ethosu_core_inference_rsp *rsp,
+			  struct ethosu_core_inference_stats *stats)
 {
 	int id = (int)rsp->user_arg;
 	struct ethosu_rpmsg_msg *msg;
@@ -515,6 +658,12 @@ void ethosu_inference_rsp(struct ethosu_device *edev,
 
 	inf = container_of(msg, typeof(*inf), msg);
 
+	inf->latency_us = ktime_us_delta(ktime_get(), inf->submit_time);
+	if (stats) {
+		inf->core_cycles = stats->core_cycles;
+		inf->queue_wait_us = stats->queue_wait_us;
+	}
+
 	if (rsp->status == ETHOSU_CORE_STATUS_OK &&
 	    inf->ofm_count <= ETHOSU_CORE_BUFFER_MAX) {
 		uint32_t i;
@@ -29,6 +29,7 @@
 #include "uapi/ethosu.h"
 
 #include <linux/kref.h>
+#include <linux/ktime.h>
 #include <linux/types.h>
 #include <linux/wait.h>
 
@@ -38,8 +39,10 @@
 
 struct ethosu_buffer;
 struct ethosu_core_inference_rsp;
+struct ethosu_core_inference_stats;
 struct ethosu_device;
 struct ethosu_network;
+struct ethosu_uapi_inference_batch;
 struct ethosu_uapi_inference_create;
 struct file;
 
@@ -58,6 +61,10 @@ struct file;
  * @pmu_event_count:		PMU event count after inference
  * @pmu_cycle_counter_enable:	PMU cycle counter config
  * @pmu_cycle_counter_count:	PMU cycle counter count after inference
+ * @submit_time:		Time the request was sent to the firmware
+ * @core_cycles:		Core cycles reported by the firmware
+ * @queue_wait_us:		Firmware queue wait reported by the firmware
+ * @latency_us:			Time from submission to response
  * @msg:			Rpmsg message
  */
 struct ethosu_inference {
@@ -78,6 +85,10 @@ struct ethosu_inference {
 	uint64_t                pmu_cycle_counter_count;
 	uint32_t                inference_type;
 	struct ethosu_uapi_memory_layout memory_layout;
+	ktime_t                 submit_time;
+	uint64_t                core_cycles;
+	uint32_t                queue_wait_us;
+	uint32_t                latency_us;
 	struct ethosu_rpmsg_msg msg;
 };
 
@@ -96,6 +107,18 @@ int ethosu_inference_create(struct ethosu_device *edev,
 			    struct ethosu_network *net,
 			    struct ethosu_uapi_inference_create *uapi);
 
+/**
+ * ethosu_inference_batch() - Invoke a batch of inferences
+ *
+ * Sends the inferences to the firmware using as few messages as the
+ * firmware and the rpmsg buffer size allow. If a message fails to be sent,
+ * the inferences of earlier messages are still running.
+ *
+ * Return: 0 on success, else error code.
+ */
+int ethosu_inference_batch(struct ethosu_device *edev,
+			   struct ethosu_uapi_inference_batch *uapi);
+
 /**
  * ethosu_inference_get_from_fd() - Get inference handle from fd
  *
@@ -119,8 +142,11 @@ int ethosu_inference_put(struct ethosu_inference *inf);
 
 /**
  * ethosu_inference_rsp() - Handle inference response
+ *
+ * @stats is NULL for responses not carrying timing information.
  */
 void ethosu_inference_rsp(struct ethosu_device *edev,
-			  struct ethosu_core_inference_rsp *rsp);
+			  struct ethosu_core_inference_rsp *rsp,
+			  struct ethosu_core_inference_stats *stats);
 
 #endif /* ETHOSU_INFERENCE_H */
@@ -28,6 +28,7 @@
 #include "ethosu_device.h"
 #include "ethosu_inference.h"
 #include "ethosu_network_info.h"
+#include "ethosu_network_load.h"
 #include "uapi/ethosu.h"
 
 #include <linux/anon_inodes.h>
@@ -70,6 +71,10 @@ static void ethosu_network_destroy(struct kref *kref)
 
 	dev_dbg(net->edev->dev, "Network destroy. net=0x%pK\n", net);
 
+	/* Release the parsed copy before the buffer backing it */
+	if (net->handle)
+		ethosu_rpmsg_network_unload(&net->edev->erp, net->handle);
+
 	if (net->buf)
 		ethosu_buffer_put(net->buf);
 
@@ -123,6 +128,14 @@ static long ethosu_network_ioctl(struct file *file,
 		ret = copy_to_user(udata, &uapi, sizeof(uapi)) ? -EFAULT : 0;
 		break;
 	}
+	case ETHOSU_IOCTL_NETWORK_LOAD: {
+		dev_dbg(net->edev->dev,
+			"Network ioctl: Network load. net=0x%pK\n",
+			net);
+
+		ret = ethosu_network_load_request(net);
+		break;
+	}
 	case ETHOSU_IOCTL_INFERENCE_CREATE: {
 		struct ethosu_uapi_inference_create uapi;
 
@@ -38,12 +38,18 @@ struct ethosu_uapi_network_create;
 struct device;
 struct file;
 
+/**
+ * struct ethosu_network - Network struct
+ * @handle:	Handle of the network loaded in the firmware, 0 if the
+ *		network is passed by buffer or index with every request
+ */
 struct ethosu_network {
 	struct ethosu_device *edev;
 	struct file          *file;
 	struct kref          kref;
 	struct ethosu_buffer *buf;
 	u32                  index;
+	u32                  handle;
 };
 
 /****************************************************************************
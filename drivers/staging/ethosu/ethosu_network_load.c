@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright 2026 NXP
+ */
+
+/****************************************************************************
+ * Includes
+ ****************************************************************************/
+
+#include "ethosu_network_load.h"
+
+#include "ethosu_device.h"
+#include "ethosu_network.h"
+#include "ethosu_rpmsg.h"
+#include "uapi/ethosu.h"
+
+#define NETWORK_LOAD_RESP_TIMEOUT_MS 30000
+
+static inline int ethosu_network_load_send(struct ethosu_network_load *load)
+{
+	/* Send network load request to firmware */
+	return ethosu_rpmsg_network_load_request(&load->edev->erp,
+						 &load->msg,
+						 load->net->buf,
+						 load->net->index);
+}
+
+static void ethosu_network_load_fail(struct ethosu_rpmsg_msg *msg)
+{
+	struct ethosu_network_load *load =
+		container_of(msg, typeof(*load), msg);
+
+	if (completion_done(&load->done))
+		return;
+
+	load->errno = -EFAULT;
+	complete(&load->done);
+}
+
+static int ethosu_network_load_resend(struct ethosu_rpmsg_msg *msg)
+{
+	struct ethosu_network_load *load =
+		container_of(msg, typeof(*load), msg);
+
+	/* Don't resend request if response has already been received */
+	if (completion_done(&load->done))
+		return 0;
+
+	/* Resend request */
+	return ethosu_network_load_send(load);
+}
+
+int ethosu_network_load_request(struct ethosu_network *net)
+{
+	struct ethosu_network_load *load;
+	int ret;
+	int timeout;
+
+	/* The firmware already holds a parsed copy of this network */
+	if (net->handle)
+		return 0;
+
+	load = devm_kzalloc(net->edev->dev, sizeof(*load), GFP_KERNEL);
+	if (!load)
+		return -ENOMEM;
+
+	load->edev = net->edev;
+	load->net = net;
+	init_completion(&load->done);
+	load->msg.fail = ethosu_network_load_fail;
+	load->msg.resend = ethosu_network_load_resend;
+
+	ret = ethosu_rpmsg_register(&load->edev->erp, &load->msg);
+	if (ret < 0)
+		goto kfree;
+
+	/* Get reference to network */
+	ethosu_network_get(load->net);
+
+	ret = ethosu_network_load_send(load);
+	if (ret)
+		goto deregister;
+
+	dev_dbg(load->edev->dev,
+		"Network load create. load=0x%pK, net=0x%pK, msg.id=0x%x\n",
+		load, load->net, load->msg.id);
+
+	/* Unlock the device mutex and wait for completion */
+	mutex_unlock(&load->edev->mutex);
+	timeout = wait_for_completion_timeout(&load->done,
+					      msecs_to_jiffies(NETWORK_LOAD_RESP_TIMEOUT_MS));
+	mutex_lock(&load->edev->mutex);
+
+	if (timeout == 0) {
+		dev_warn(load->edev->dev, "Network load timed out. load=0x%pK",
+			 load);
+
+		ret = -ETIME;
+		goto deregister;
+	}
+
+	ret = load->errno;
+	if (ret)
+		goto deregister;
+
+	/* Another load of the same network may have completed meanwhile */
+	if (net->handle)
+		ethosu_rpmsg_network_unload(&load->edev->erp, load->handle);
+	else
+		net->handle = load->handle;
+
+deregister:
+	ethosu_rpmsg_deregister(&load->edev->erp, &load->msg);
+	ethosu_network_put(load->net);
+
+kfree:
+	dev_dbg(load->edev->dev,
+		"Network load destroy. load=0x%pK, msg.id=0x%x\n",
+		load, load->msg.id);
+	devm_kfree(load->edev->dev, load);
+
+	return ret;
+}
+
+void ethosu_network_load_rsp(struct ethosu_device *edev,
+			     struct ethosu_core_network_load_rsp *rsp)
+{
+	int id = (int)rsp->user_arg;
+	struct ethosu_rpmsg_msg *msg;
+	struct ethosu_network_load *load;
+
+	msg = ethosu_rpmsg_find(&edev->erp, id);
+	if (IS_ERR(msg)) {
+		dev_warn(edev->dev,
+			 "Id for network load msg not found. msg.id=0x%x\n",
+			 id);
+
+		/* Don't leak a network nobody is waiting for */
+		if (rsp->status == ETHOSU_CORE_STATUS_OK && rsp->handle)
+			ethosu_rpmsg_network_unload(&edev->erp, rsp->handle);
+
+		return;
+	}
+
+	load = container_of(msg, typeof(*load), msg);
+
+	if (completion_done(&load->done))
+		return;
+
+	if (rsp->status != ETHOSU_CORE_STATUS_OK || !rsp->handle) {
+		load->errno = -EBADF;
+	} else {
+		load->errno = 0;
+		load->handle = rsp->handle;
+	}
+
+	complete(&load->done);
+}
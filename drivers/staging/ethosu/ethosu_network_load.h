@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright 2026 NXP
+ */
+
+#ifndef ETHOSU_NETWORK_LOAD_H
+#define ETHOSU_NETWORK_LOAD_H
+
+/****************************************************************************
+ * Includes
+ ****************************************************************************/
+
+#include "ethosu_core_interface.h"
+#include "ethosu_rpmsg.h"
+
+#include <linux/types.h>
+#include <linux/completion.h>
+
+/****************************************************************************
+ * Types
+ ****************************************************************************/
+
+struct ethosu_device;
+struct ethosu_network;
+
+struct ethosu_network_load {
+	struct ethosu_device    *edev;
+	struct ethosu_network   *net;
+	struct completion       done;
+	int                     errno;
+	u32                     handle;
+	struct ethosu_rpmsg_msg msg;
+};
+
+/****************************************************************************
+ * Functions
+ ****************************************************************************/
+
+/**
+ * ethosu_network_load_request() - Load a network into the firmware
+ *
+ * Asks the firmware to parse the network once and keep it resident. On
+ * success the handle is stored in the network and used by all following
+ * inference requests instead of the network buffer.
+ *
+ * This function must be called in the context of a user space process.
+ *
+ * Return: 0 on success, else error code.
+ */
+int ethosu_network_load_request(struct ethosu_network *net);
+
+/**
+ * ethosu_network_load_rsp() - Handle network load response.
+ */
+void ethosu_network_load_rsp(struct ethosu_device *edev,
+			     struct ethosu_core_network_load_rsp *rsp);
+
+#endif /* ETHOSU_NETWORK_LOAD_H */
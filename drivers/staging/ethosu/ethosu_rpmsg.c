@@ -7,6 +7,7 @@
 #include <linux/module.h>
 #include <linux/resource.h>
 #include <linux/rpmsg.h>
+#include <linux/slab.h>
 #include <linux/uio.h>
 #include <linux/virtio.h>
 
@@ -190,6 +191,65 @@ int ethosu_rpmsg_power_request(struct ethosu_rpmsg *erp,
 	return 0;
 }
 
+int ethosu_rpmsg_inference_fill(struct ethosu_rpmsg *erp,
+				struct ethosu_rpmsg_msg *rpmsg,
+				struct ethosu_core_inference_req *req,
+				uint32_t ifm_count,
+				struct ethosu_buffer **ifm,
+				uint32_t ofm_count,
+				struct ethosu_buffer **ofm,
+				struct ethosu_buffer *network,
+				u32 network_index,
+				u32 network_handle,
+				uint8_t *pmu_event_config,
+				uint8_t pmu_event_config_count,
+				uint8_t pmu_cycle_counter_enable,
+				u32 flash_offset,
+				u32 arena_offset,
+				uint32_t inference_type)
+{
+	struct rpmsg_device *rpdev = erp->rpdev;
+	uint32_t i;
+
+	/* Verify that the uapi and core has the same number of pmus */
+	if (pmu_event_config_count != ETHOSU_CORE_PMU_MAX) {
+		dev_err(&rpdev->dev, "PMU count misconfigured.\n");
+
+		return -EINVAL;
+	}
+
+	memset(req, 0, sizeof(*req));
+	req->user_arg = rpmsg->id;
+	req->ifm_count = ifm_count;
+	req->ofm_count = ofm_count;
+	req->pmu_cycle_counter_enable = pmu_cycle_counter_enable;
+	req->inference_type = inference_type;
+	req->flash_offset = flash_offset;
+	req->arena_offset = arena_offset;
+
+	for (i = 0; i < ifm_count; i++)
+		ethosu_core_set_size(ifm[i], &req->ifm[i]);
+
+	for (i = 0; i < ofm_count; i++)
+		ethosu_core_set_capacity(ofm[i], &req->ofm[i]);
+
+	for (i = 0; i < ETHOSU_CORE_PMU_MAX; i++)
+		req->pmu_event_config[i] = pmu_event_config[i];
+
+	if (network_handle) {
+		req->network.type = ETHOSU_CORE_NETWORK_HANDLE;
+		req->network.index = network_handle;
+	} else if (network) {
+		req->network.type = ETHOSU_CORE_NETWORK_BUFFER;
+		ethosu_core_set_size(network, &req->network.buffer);
+	} else {
+		req->network.type = ETHOSU_CORE_NETWORK_INDEX;
+		req->network.index = network_index;
+	}
+
+	return 0;
+}
+
 int ethosu_rpmsg_inference(struct ethosu_rpmsg *erp,
 			   struct ethosu_rpmsg_msg *rpmsg,
 			   uint32_t ifm_count,
@@ -198,6 +258,7 @@ int ethosu_rpmsg_inference(struct ethosu_rpmsg *erp,
 			   struct ethosu_buffer **ofm,
 			   struct ethosu_buffer *network,
 			   u32 network_index,
+			   u32 network_handle,
 			   uint8_t *pmu_event_config,
 			   uint8_t pmu_event_config_count,
 			   uint8_t pmu_cycle_counter_enable,
@@ -215,31 +276,101 @@ int ethosu_rpmsg_inference(struct ethosu_rpmsg *erp,
 	uint8_t data[sizeof(struct ethosu_core_msg) +
 		sizeof(struct ethosu_core_inference_req)];
 	int ret;
-	uint32_t i;
 
-	/* Verify that the uapi and core has the same number of pmus */
-	if (pmu_event_config_count != ETHOSU_CORE_PMU_MAX) {
-		dev_err(&rpdev->dev, "PMU count misconfigured.\n");
+	ret = ethosu_rpmsg_inference_fill(erp, rpmsg, &req,
+					  ifm_count, ifm, ofm_count, ofm,
+					  network, network_index,
+					  network_handle,
+					  pmu_event_config,
+					  pmu_event_config_count,
+					  pmu_cycle_counter_enable,
+					  flash_offset, arena_offset,
+					  inference_type);
+	if (ret)
+		return ret;
 
-		return -EINVAL;
+	memcpy(data, &msg, sizeof(struct ethosu_core_msg));
+	memcpy(data + sizeof(struct ethosu_core_msg), &req,
+	       sizeof(struct ethosu_core_inference_req));
+
+	ret = rpmsg_send(rpdev->ept, (void *)&data,
+			 sizeof(struct ethosu_core_msg) +
+			 sizeof(struct ethosu_core_inference_req));
+	if (ret) {
+		dev_err(&rpdev->dev, "rpmsg_send failed: %d\n", ret);
+		return ret;
 	}
 
-	req.user_arg = rpmsg->id;
-	req.ifm_count = ifm_count;
-	req.ofm_count = ofm_count;
-	req.pmu_cycle_counter_enable = pmu_cycle_counter_enable;
-	req.inference_type = inference_type;
-	req.flash_offset = flash_offset;
-	req.arena_offset = arena_offset;
+	return 0;
+}
 
-	for (i = 0; i < ifm_count; i++)
-		ethosu_core_set_size(ifm[i], &req.ifm[i]);
+unsigned int ethosu_rpmsg_inference_batch_max(struct ethosu_rpmsg *erp)
+{
+	const size_t hdr = sizeof(struct ethosu_core_msg) +
+			   sizeof(struct ethosu_core_inference_batch_req);
+	ssize_t mtu;
 
-	for (i = 0; i < ofm_count; i++)
-		ethosu_core_set_capacity(ofm[i], &req.ofm[i]);
+	mtu = rpmsg_get_mtu(erp->rpdev->ept);
+	if (mtu < 0 || (size_t)mtu < hdr + sizeof(struct ethosu_core_inference_req))
+		return 1;
 
-	for (i = 0; i < ETHOSU_CORE_PMU_MAX; i++)
-		req.pmu_event_config[i] = pmu_event_config[i];
+	return min_t(size_t, ETHOSU_CORE_BATCH_MAX,
+		     ((size_t)mtu - hdr) /
+		     sizeof(struct ethosu_core_inference_req));
+}
+
+int ethosu_rpmsg_inference_batch(struct ethosu_rpmsg *erp,
+				 const struct ethosu_core_inference_req *req,
+				 uint32_t count)
+{
+	struct ethosu_core_inference_batch_req *batch;
+	struct rpmsg_device *rpdev = erp->rpdev;
+	struct ethosu_core_msg *msg;
+	size_t len;
+	int ret;
+
+	if (!count || count > ethosu_rpmsg_inference_batch_max(erp))
+		return -EINVAL;
+
+	len = sizeof(*msg) + struct_size(batch, req, count);
+	msg = kzalloc(len, GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+
+	msg->magic = ETHOSU_CORE_MSG_MAGIC;
+	msg->type = ETHOSU_CORE_MSG_INFERENCE_BATCH_REQ;
+	msg->length = struct_size(batch, req, count);
+
+	batch = (struct ethosu_core_inference_batch_req *)(msg + 1);
+	batch->count = count;
+	memcpy(batch->req, req, count * sizeof(*req));
+
+	ret = rpmsg_send(rpdev->ept, (void *)msg, len);
+	if (ret)
+		dev_err(&rpdev->dev, "rpmsg_send failed: %d\n", ret);
+
+	kfree(msg);
+
+	return ret;
+}
+
+int ethosu_rpmsg_network_info_request(struct ethosu_rpmsg *erp,
+				      struct ethosu_rpmsg_msg *rpmsg,
+				      struct ethosu_buffer *network,
+				      uint32_t network_index)
+{
+	struct ethosu_core_msg msg = {
+		.magic  = ETHOSU_CORE_MSG_MAGIC,
+		.type   = ETHOSU_CORE_MSG_NETWORK_INFO_REQ,
+		.length = sizeof(struct ethosu_core_network_info_req)
+	};
+	struct ethosu_core_network_info_req req;
+	struct rpmsg_device *rpdev = erp->rpdev;
+	u8 data[sizeof(struct ethosu_core_msg) +
+		sizeof(struct ethosu_core_network_info_req)];
+	int ret;
+
+	req.user_arg = rpmsg->id;
 
 	if (network) {
 		req.network.type = ETHOSU_CORE_NETWORK_BUFFER;
@@ -251,11 +382,11 @@ int ethosu_rpmsg_inference(struct ethosu_rpmsg *erp,
 
 	memcpy(data, &msg, sizeof(struct ethosu_core_msg));
 	memcpy(data + sizeof(struct ethosu_core_msg), &req,
-	       sizeof(struct ethosu_core_inference_req));
+	       sizeof(struct ethosu_core_network_info_req));
 
 	ret = rpmsg_send(rpdev->ept, (void *)&data,
 			 sizeof(struct ethosu_core_msg) +
-			 sizeof(struct ethosu_core_inference_req));
+			 sizeof(struct ethosu_core_network_info_req));
 	if (ret) {
 		dev_err(&rpdev->dev, "rpmsg_send failed: %d\n", ret);
 		return ret;
@@ -264,20 +395,20 @@ int ethosu_rpmsg_inference(struct ethosu_rpmsg *erp,
 	return 0;
 }
 
-int ethosu_rpmsg_network_info_request(struct ethosu_rpmsg *erp,
+int ethosu_rpmsg_network_load_request(struct ethosu_rpmsg *erp,
 				      struct ethosu_rpmsg_msg *rpmsg,
 				      struct ethosu_buffer *network,
 				      uint32_t network_index)
 {
 	struct ethosu_core_msg msg = {
 		.magic  = ETHOSU_CORE_MSG_MAGIC,
-		.type   = ETHOSU_CORE_MSG_NETWORK_INFO_REQ,
-		.length = sizeof(struct ethosu_core_network_info_req)
+		.type   = ETHOSU_CORE_MSG_NETWORK_LOAD_REQ,
+		.length = sizeof(struct ethosu_core_network_load_req)
 	};
-	struct ethosu_core_network_info_req req;
+	struct ethosu_core_network_load_req req;
 	struct rpmsg_device *rpdev = erp->rpdev;
 	u8 data[sizeof(struct ethosu_core_msg) +
-		sizeof(struct ethosu_core_network_info_req)];
+		sizeof(struct ethosu_core_network_load_req)];
 	int ret;
 
 	req.user_arg = rpmsg->id;
@@ -292,11 +423,41 @@ int ethosu_rpmsg_network_info_request(struct ethosu_rpmsg *erp,
 
 	memcpy(data, &msg, sizeof(struct ethosu_core_msg));
 	memcpy(data + sizeof(struct ethosu_core_msg), &req,
-	       sizeof(struct ethosu_core_network_info_req));
+	       sizeof(struct ethosu_core_network_load_req));
 
 	ret = rpmsg_send(rpdev->ept, (void *)&data,
 			 sizeof(struct ethosu_core_msg) +
-			 sizeof(struct ethosu_core_network_info_req));
+			 sizeof(struct ethosu_core_network_load_req));
+	if (ret) {
+		dev_err(&rpdev->dev, "rpmsg_send failed: %d\n", ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+int ethosu_rpmsg_network_unload(struct ethosu_rpmsg *erp, u32 handle)
+{
+	struct ethosu_core_msg msg = {
+		.magic  = ETHOSU_CORE_MSG_MAGIC,
+		.type   = ETHOSU_CORE_MSG_NETWORK_UNLOAD_REQ,
+		.length = sizeof(struct ethosu_core_network_unload_req)
+	};
+	struct ethosu_core_network_unload_req req = {
+		.handle = handle
+	};
+	struct rpmsg_device *rpdev = erp->rpdev;
+	u8 data[sizeof(struct ethosu_core_msg) +
+		sizeof(struct ethosu_core_network_unload_req)];
+	int ret;
+
+	memcpy(data, &msg, sizeof(struct ethosu_core_msg));
+	memcpy(data + sizeof(struct ethosu_core_msg), &req,
+	       sizeof(struct ethosu_core_network_unload_req));
+
+	ret = rpmsg_send(rpdev->ept, (void *)&data,
+			 sizeof(struct ethosu_core_msg) +
+			 sizeof(struct ethosu_core_network_unload_req));
 	if (ret) {
 		dev_err(&rpdev->dev, "rpmsg_send failed: %d\n", ret);
 		return ret;
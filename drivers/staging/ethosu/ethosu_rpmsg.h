@@ -86,6 +86,7 @@ int ethosu_rpmsg_inference(struct ethosu_rpmsg *erp,
 			   struct ethosu_buffer **ofm,
 			   struct ethosu_buffer *network,
 			   u32 network_index,
+			   u32 network_handle,
 			   uint8_t *pmu_event_config,
 			   uint8_t pmu_event_config_count,
 			   uint8_t pmu_cycle_counter_enable,
@@ -94,6 +95,44 @@ int ethosu_rpmsg_inference(struct ethosu_rpmsg *erp,
 			   uint32_t inference_type
 			   );
 
+/**
+ * ethosu_rpmsg_inference_fill() - Fill in an inference request
+ *
+ * Return: 0 on success, else error code.
+ */
+int ethosu_rpmsg_inference_fill(struct ethosu_rpmsg *erp,
+				struct ethosu_rpmsg_msg *rpmsg,
+				struct ethosu_core_inference_req *req,
+				uint32_t ifm_count,
+				struct ethosu_buffer **ifm,
+				uint32_t ofm_count,
+				struct ethosu_buffer **ofm,
+				struct ethosu_buffer *network,
+				u32 network_index,
+				u32 network_handle,
+				uint8_t *pmu_event_config,
+				uint8_t pmu_event_config_count,
+				uint8_t pmu_cycle_counter_enable,
+				u32 flash_offset,
+				u32 arena_offset,
+				uint32_t inference_type);
+
+/**
+ * ethosu_rpmsg_inference_batch_max() - Maximum requests per batch message
+ *
+ * Return: Number of inference requests fitting in one rpmsg buffer.
+ */
+unsigned int ethosu_rpmsg_inference_batch_max(struct ethosu_rpmsg *erp);
+
+/**
+ * ethosu_rpmsg_inference_batch() - Send a batch of inference requests
+ *
+ * Return: 0 on success, else error code.
+ */
+int ethosu_rpmsg_inference_batch(struct ethosu_rpmsg *erp,
+				 const struct ethosu_core_inference_req *req,
+				 uint32_t count);
+
 /**
  * ethosu_rpmsg_network_info_request() - Send network info request
  *
@@ -104,6 +143,23 @@ int ethosu_rpmsg_network_info_request(struct ethosu_rpmsg *erp,
 				      struct ethosu_buffer *network,
 				      uint32_t network_index);
 
+/**
+ * ethosu_rpmsg_network_load_request() - Send network load request
+ *
+ * Return: 0 on success, else error code.
+ */
+int ethosu_rpmsg_network_load_request(struct ethosu_rpmsg *erp,
+				      struct ethosu_rpmsg_msg *rpmsg,
+				      struct ethosu_buffer *network,
+				      uint32_t network_index);
+
+/**
+ * ethosu_rpmsg_network_unload() - Release a network loaded in the firmware
+ *
+ * Return: 0 on success, else error code.
+ */
+int ethosu_rpmsg_network_unload(struct ethosu_rpmsg *erp, u32 handle);
+
 /**
  * ethosu_rpmsg_cancel_inference() - Send inference cancellation
  *
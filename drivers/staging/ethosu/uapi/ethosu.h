@@ -56,6 +56,7 @@ namespace EthosU {
 						   struct ethosu_uapi_network_create)
 #define ETHOSU_IOCTL_NETWORK_INFO       ETHOSU_IOR(0x21, \
 						   struct ethosu_uapi_network_info)
+#define ETHOSU_IOCTL_NETWORK_LOAD       ETHOSU_IO(0x22)
 #define ETHOSU_IOCTL_INFERENCE_CREATE   ETHOSU_IOR(0x30, \
 						   struct ethosu_uapi_inference_create)
 #define ETHOSU_IOCTL_INFERENCE_STATUS   ETHOSU_IOR(0x31, \
@@ -64,6 +65,10 @@ namespace EthosU {
 						   struct ethosu_uapi_cancel_inference_status)
 #define ETHOSU_IOCTL_INFERENCE_INVOKE   ETHOSU_IOR(0x33, \
 						   struct ethosu_uapi_result_status)
+#define ETHOSU_IOCTL_INFERENCE_BATCH    ETHOSU_IOR(0x34, \
+						   struct ethosu_uapi_inference_batch)
+#define ETHOSU_IOCTL_INFERENCE_STATS    ETHOSU_IOR(0x35, \
+						   struct ethosu_uapi_inference_stats)
 
 /* Maximum number of IFM/OFM file descriptors per network */
 #define ETHOSU_FD_MAX                   16
@@ -74,6 +79,9 @@ namespace EthosU {
 /* Maximum number of PMUs available */
 #define ETHOSU_PMU_EVENT_MAX             4
 
+/* Maximum number of inferences per batch */
+#define ETHOSU_BATCH_MAX                 16
+
 /****************************************************************************
  * Types
  ****************************************************************************/
@@ -296,6 +304,34 @@ struct ethosu_uapi_result_status {
 	struct ethosu_uapi_pmu_counts pmu_count;
 };
 
+/**
+ * struct ethosu_uapi_inference_batch - Invoke a batch of inferences
+ * @count:	Number of inference file descriptors
+ * @fd:		Inference file descriptors
+ *
+ * The inferences are sent to the firmware in as few messages as it
+ * supports. Completion is still reported per inference file descriptor.
+ */
+struct ethosu_uapi_inference_batch {
+	__u32 count;
+	__u32 fd[ETHOSU_BATCH_MAX];
+};
+
+/**
+ * struct ethosu_uapi_inference_stats - Timing of the last run
+ * @core_cycles:	Core cycles spent running the inference
+ * @queue_wait_us:	Time queued in the firmware before it was run
+ * @latency_us:		Time from submission to response, seen by the host
+ *
+ * @core_cycles and @queue_wait_us are only reported by firmware
+ * supporting batched inference and read as 0 otherwise.
+ */
+struct ethosu_uapi_inference_stats {
+	__u64 core_cycles;
+	__u32 queue_wait_us;
+	__u32 latency_us;
+};
+
 /**
  * struct ethosu_uapi_cancel_status - Status of inference cancellation.
  * @status	OK if inference cancellation was performed, ERROR otherwise.
@@ -23,6 +23,9 @@
 #include <linux/timer.h>
 #include <linux/hrtimer.h>
 #include <linux/platform_device.h>
+#include <linux/bpf.h>
+#include <linux/bpf_trace.h>
+#include <linux/if_vlan.h>
 
 #include <net/ip.h>
 #include <net/sock.h>
@@ -50,6 +53,11 @@
 bool pfe_use_old_dts_phy;
 bool pfe_errata_a010897;
 
+static bool rx_spread = true;
+module_param(rx_spread, bool, 0444);
+MODULE_PARM_DESC(rx_spread,
+		 "Poll the RX queues of the interfaces on different CPUs (default: 1)");
+
 static void *cbus_emac_base[3];
 static void *cbus_gpi_base[3];
 
@@ -1325,51 +1333,65 @@ static int pfe_gemac_init(struct pfe_eth_priv_s *priv)
 	return 0;
 }
 
-/* pfe_eth_event_handler
- */
-static int pfe_eth_event_handler(void *data, int event, int qno)
+static struct napi_struct *pfe_eth_rx_napi(struct pfe_eth_priv_s *priv,
+					   int qno)
 {
-	struct pfe_eth_priv_s *priv = data;
+	switch (qno) {
+	case 0:
+		return &priv->high_napi;
+	case 1:
+		return &priv->low_napi;
+	case 2:
+		return &priv->lro_napi;
+	}
 
-	switch (event) {
-	case EVENT_RX_PKT_IND:
+	return NULL;
+}
 
-		if (qno == 0) {
-			if (napi_schedule_prep(&priv->high_napi)) {
-				netif_info(priv, intr, priv->ndev,
-					   "%s: schedule high prio poll\n"
-					   , __func__);
+/* pfe_eth_rx_kick
+ * IPI handler scheduling a RX queue poll on its CPU
+ */
+static void pfe_eth_rx_kick(void *info)
+{
+	__napi_schedule(info);
+}
 
-#ifdef PFE_ETH_NAPI_STATS
-				priv->napi_counters[NAPI_SCHED_COUNT]++;
-#endif
+/* pfe_eth_rx_schedule
+ * All client queues are filled from the single HIF RX poll. Schedule the
+ * queue polls, which build the skbs and run the stack, on the CPU
+ * assigned to the queue so that the traffic of both interfaces does not
+ * end up on the HIF interrupt CPU.
+ */
+static void pfe_eth_rx_schedule(struct pfe_eth_priv_s *priv, int qno)
+{
+	struct napi_struct *napi = pfe_eth_rx_napi(priv, qno);
+	int cpu;
 
-				__napi_schedule(&priv->high_napi);
-			}
-		} else if (qno == 1) {
-			if (napi_schedule_prep(&priv->low_napi)) {
-				netif_info(priv, intr, priv->ndev,
-					   "%s: schedule low prio poll\n"
-					   , __func__);
+	if (!napi || !napi_schedule_prep(napi))
+		return;
 
-#ifdef PFE_ETH_NAPI_STATS
-				priv->napi_counters[NAPI_SCHED_COUNT]++;
-#endif
-				__napi_schedule(&priv->low_napi);
-			}
-		} else if (qno == 2) {
-			if (napi_schedule_prep(&priv->lro_napi)) {
-				netif_info(priv, intr, priv->ndev,
-					   "%s: schedule lro prio poll\n"
-					   , __func__);
+	netif_info(priv, intr, priv->ndev, "%s: schedule queue %d poll\n",
+		   __func__, qno);
 
 #ifdef PFE_ETH_NAPI_STATS
-				priv->napi_counters[NAPI_SCHED_COUNT]++;
+	priv->napi_counters[NAPI_SCHED_COUNT]++;
 #endif
-				__napi_schedule(&priv->lro_napi);
-			}
-		}
 
+	cpu = priv->rx_cpu[qno];
+	if (cpu < 0 || cpu == smp_processor_id() ||
+	    smp_call_function_single_async(cpu, &priv->rx_csd[qno]))
+		__napi_schedule(napi);
+}
+
+/* pfe_eth_event_handler
+ */
+static int pfe_eth_event_handler(void *data, int event, int qno)
+{
+	struct pfe_eth_priv_s *priv = data;
+
+	switch (event) {
+	case EVENT_RX_PKT_IND:
+		pfe_eth_rx_schedule(priv, qno);
 		break;
 
 	case EVENT_TXDONE_IND:
@@ -1384,10 +1406,23 @@ static int pfe_eth_event_handler(void *data, int event, int qno)
 	return 0;
 }
 
+/* Largest frame an XDP program can be run on, it must fit in one buffer */
+static unsigned int pfe_eth_xdp_max_mtu(void)
+{
+	return pfe_pkt_size - PFE_PKT_HEADER_SZ - PFE_PARSE_INFO_SIZE -
+	       VLAN_ETH_HLEN;
+}
+
 static int pfe_eth_change_mtu(struct net_device *ndev, int new_mtu)
 {
 	struct pfe_eth_priv_s *priv = netdev_priv(ndev);
 
+	if (priv->xdp_prog && new_mtu > pfe_eth_xdp_max_mtu()) {
+		netdev_err(ndev, "MTU %d too large for XDP, maximum %u\n",
+			   new_mtu, pfe_eth_xdp_max_mtu());
+		return -EINVAL;
+	}
+
 	ndev->mtu = new_mtu;
 	new_mtu += ETH_HLEN + ETH_FCS_LEN;
 	gemac_set_rx_max_fl(priv->EMAC_baseaddr, new_mtu);
@@ -1401,6 +1436,7 @@ static int pfe_eth_open(struct net_device *ndev)
 {
 	struct pfe_eth_priv_s *priv = netdev_priv(ndev);
 	struct hif_client_s *client;
+	int qno;
 	int rc;
 
 	netif_info(priv, ifup, ndev, "%s\n", __func__);
@@ -1439,6 +1475,21 @@ static int pfe_eth_open(struct net_device *ndev)
 	gemac_set_laddrN(priv->EMAC_baseaddr,
 			 (struct pfe_mac_addr *)ndev->dev_addr, 1);
 
+	for (qno = 0; qno < EMAC_RXQ_CNT; qno++) {
+		struct napi_struct *napi = pfe_eth_rx_napi(priv, qno);
+
+		/* spread the queues of both interfaces over the CPUs */
+		priv->rx_cpu[qno] = rx_spread ?
+			cpumask_local_spread(priv->id * EMAC_RXQ_CNT + qno,
+					     NUMA_NO_NODE) : -1;
+		INIT_CSD(&priv->rx_csd[qno], pfe_eth_rx_kick, napi);
+
+		rc = xdp_rxq_info_reg(&priv->xdp_rxq[qno], ndev, qno,
+				      napi->napi_id);
+		if (rc)
+			goto err2;
+	}
+
 	napi_enable(&priv->high_napi);
 	napi_enable(&priv->low_napi);
 	napi_enable(&priv->lro_napi);
@@ -1449,6 +1500,9 @@ static int pfe_eth_open(struct net_device *ndev)
 
 	return rc;
 
+err2:
+	while (qno--)
+		xdp_rxq_info_unreg(&priv->xdp_rxq[qno]);
 err1:
 	hif_lib_client_unregister(&priv->client);
 
@@ -1543,6 +1597,9 @@ static int pfe_eth_shutdown(struct net_device *ndev, int wake)
 	napi_disable(&priv->low_napi);
 	napi_disable(&priv->high_napi);
 
+	for (i = 0; i < EMAC_RXQ_CNT; i++)
+		xdp_rxq_info_unreg(&priv->xdp_rxq[i]);
+
 	for (id = CLASS0_ID; id <= CLASS_MAX_ID; id++) {
 		pe_dmem_write(id, 0, CLASS_DM_CRC_VALIDATED
 			      + (priv->id * 4), 4);
@@ -1743,7 +1800,6 @@ static void pfe_hif_send_packet(struct sk_buff *skb, struct  pfe_eth_priv_s
 			   "%s: pkt sent successfully skb:%p len:%d\n",
 			   __func__, skb, skb->len);
 	}
-	hif_tx_dma_start();
 	priv->stats.tx_packets++;
 	priv->stats.tx_bytes += skb->len;
 	hif_lib_tx_credit_use(pfe, priv->id, queuenum, 1);
@@ -1842,12 +1898,20 @@ static int pfe_eth_send_packet(struct sk_buff *skb, struct net_device *ndev)
 			priv->was_stopped[tx_q_num] = 0;
 		}
 #endif
+		/* kick what an earlier xmit_more left for us */
+		hif_tx_dma_start();
 		hif_tx_unlock(&pfe->hif);
 		return NETDEV_TX_BUSY;
 	}
 
 	pfe_hif_send_packet(skb, priv, tx_q_num);
 
+	/* The descriptors are valid already, only start the TX DMA once
+	 * for a burst of frames.
+	 */
+	if (!netdev_xmit_more() || netif_xmit_stopped(tx_queue))
+		hif_tx_dma_start();
+
 	hif_tx_unlock(&pfe->hif);
 
 	tx_queue->trans_start = jiffies;
@@ -2095,10 +2159,45 @@ static void pfe_eth_fast_tx_timeout_init(struct pfe_eth_priv_s *priv)
 	}
 }
 
+/* pfe_eth_run_xdp
+ * Run the XDP program on a single buffer frame, on XDP_PASS the frame
+ * bounds are updated for the skb to be built.
+ */
+static u32 pfe_eth_run_xdp(struct pfe_eth_priv_s *priv, struct bpf_prog *prog,
+			   unsigned int qno, void *buf_addr, int *offset,
+			   int *length)
+{
+	struct xdp_buff xdp;
+	u32 act;
+
+	xdp_init_buff(&xdp, PFE_BUF_SIZE, &priv->xdp_rxq[qno]);
+	xdp_prepare_buff(&xdp, buf_addr, *offset, *length, false);
+
+	act = bpf_prog_run_xdp(prog, &xdp);
+	switch (act) {
+	case XDP_PASS:
+		*offset = xdp.data - buf_addr;
+		*length = xdp.data_end - xdp.data;
+		break;
+	default:
+		bpf_warn_invalid_xdp_action(priv->ndev, prog, act);
+		fallthrough;
+	case XDP_ABORTED:
+		trace_xdp_exception(priv->ndev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		priv->stats.rx_dropped++;
+		break;
+	}
+
+	return act;
+}
+
 static struct sk_buff *pfe_eth_rx_skb(struct net_device *ndev,
 				      struct	pfe_eth_priv_s *priv,
-				      unsigned int qno)
+				      unsigned int qno, bool *consumed)
 {
+	struct bpf_prog *xdp_prog = READ_ONCE(priv->xdp_prog);
 	void *buf_addr;
 	unsigned int rx_ctrl;
 	unsigned int desc_ctrl = 0;
@@ -2107,6 +2206,7 @@ static struct sk_buff *pfe_eth_rx_skb(struct net_device *ndev,
 	struct sk_buff *skb_frag, *skb_frag_last = NULL;
 	int length = 0, offset;
 
+	*consumed = false;
 	skb = priv->skb_inflight[qno];
 
 	if (skb) {
@@ -2130,6 +2230,20 @@ static struct sk_buff *pfe_eth_rx_skb(struct net_device *ndev,
 
 		/* First frag */
 		if (desc_ctrl & CL_DESC_FIRST) {
+			if (xdp_prog) {
+				/* frames spanning buffers are not run by XDP */
+				if (unlikely(!(desc_ctrl & CL_DESC_LAST)))
+					goto pkt_drop;
+
+				if (pfe_eth_run_xdp(priv, xdp_prog, qno,
+						    buf_addr, &offset,
+						    &length) != XDP_PASS) {
+					kfree(buf_addr);
+					*consumed = true;
+					return NULL;
+				}
+			}
+
 			skb = build_skb(buf_addr, 0);
 			if (unlikely(!skb))
 				goto pkt_drop;
@@ -2205,6 +2319,7 @@ static int pfe_eth_poll(struct pfe_eth_priv_s *priv, struct napi_struct *napi,
 	struct sk_buff *skb;
 	int work_done = 0;
 	unsigned int len;
+	bool consumed;
 
 	netif_info(priv, intr, priv->ndev, "%s\n", __func__);
 
@@ -2213,10 +2328,16 @@ static int pfe_eth_poll(struct pfe_eth_priv_s *priv, struct napi_struct *napi,
 #endif
 
 	do {
-		skb = pfe_eth_rx_skb(ndev, priv, qno);
+		skb = pfe_eth_rx_skb(ndev, priv, qno, &consumed);
 
-		if (!skb)
+		if (!skb) {
+			/* dropped by XDP, go on with the next frame */
+			if (consumed) {
+				work_done++;
+				continue;
+			}
 			break;
+		}
 
 		len = skb->len;
 
@@ -2292,6 +2413,41 @@ static int pfe_eth_high_poll(struct napi_struct *napi, int budget)
 	return pfe_eth_poll(priv, napi, 0, budget);
 }
 
+static int pfe_eth_xdp_setup(struct net_device *ndev, struct bpf_prog *prog,
+			     struct netlink_ext_ack *extack)
+{
+	struct pfe_eth_priv_s *priv = netdev_priv(ndev);
+	struct bpf_prog *old_prog;
+
+	/* page mode buffers share pages of varying size */
+	if (prog && page_mode) {
+		NL_SET_ERR_MSG_MOD(extack, "XDP is not supported in LRO mode");
+		return -EOPNOTSUPP;
+	}
+
+	if (prog && ndev->mtu > pfe_eth_xdp_max_mtu()) {
+		NL_SET_ERR_MSG_FMT_MOD(extack, "MTU too large for XDP, maximum %u",
+				       pfe_eth_xdp_max_mtu());
+		return -EINVAL;
+	}
+
+	old_prog = xchg(&priv->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	return 0;
+}
+
+static int pfe_eth_bpf(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		return pfe_eth_xdp_setup(ndev, bpf->prog, bpf->extack);
+	default:
+		return -EINVAL;
+	}
+}
+
 static const struct net_device_ops pfe_netdev_ops = {
 	.ndo_open = pfe_eth_open,
 	.ndo_stop = pfe_eth_close,
@@ -2303,6 +2459,7 @@ static const struct net_device_ops pfe_netdev_ops = {
 	.ndo_change_mtu = pfe_eth_change_mtu,
 	.ndo_get_stats = pfe_eth_get_stats,
 	.ndo_set_features = pfe_eth_set_features,
+	.ndo_bpf = pfe_eth_bpf,
 };
 
 /* pfe_eth_init_one
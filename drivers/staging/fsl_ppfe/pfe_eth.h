@@ -14,7 +14,9 @@
 #include <linux/phy.h>
 #include <linux/clk.h>
 #include <linux/interrupt.h>
+#include <linux/smp.h>
 #include <linux/time.h>
+#include <net/xdp.h>
 
 #define PFE_ETH_NAPI_STATS
 #define PFE_ETH_TX_STATS
@@ -107,6 +109,11 @@ struct  pfe_eth_priv_s {
 	struct napi_struct	lro_napi;
 	struct napi_struct	low_napi;
 	struct napi_struct	high_napi;
+	/* RX queue polls are kicked on these CPUs, off the HIF poll CPU */
+	int			rx_cpu[EMAC_RXQ_CNT];
+	call_single_data_t	rx_csd[EMAC_RXQ_CNT];
+	struct bpf_prog		*xdp_prog;
+	struct xdp_rxq_info	xdp_rxq[EMAC_RXQ_CNT];
 	int			low_tmu_q;
 	int			high_tmu_q;
 	struct net_device_stats stats;
@@ -23,7 +23,6 @@
 
 unsigned char napi_first_batch;
 
-static void pfe_tx_do_cleanup(unsigned long data);
 
 static int pfe_hif_alloc_descr(struct pfe_hif *hif)
 {
@@ -707,17 +706,22 @@ static int client_ack_txpacket(struct pfe_hif *hif, unsigned int client_id,
 	}
 }
 
-void __hif_tx_done_process(struct pfe_hif *hif, int count)
+/*
+ * __hif_tx_done_process-
+ * Reclaims up to count completed TX descriptors and returns how many were
+ * reclaimed. The clients are told once about all their completions.
+ */
+int __hif_tx_done_process(struct pfe_hif *hif, int count)
 {
 	struct hif_desc *desc;
 	struct hif_desc_sw *desc_sw;
-	int ttc, tx_avl;
+	int ttc, tx_avl, done = 0;
 	int pkts_done[HIF_CLIENTS_MAX] = {0, 0};
 
 	ttc = hif->txtoclean;
 	tx_avl = hif->txavail;
 
-	while ((tx_avl < hif->tx_ring_size) && count--) {
+	while ((tx_avl < hif->tx_ring_size) && done < count) {
 		desc = hif->tx_base + ttc;
 
 		if (readl(&desc->ctrl) & BD_CTRL_DESC_EN)
@@ -745,32 +749,43 @@ void __hif_tx_done_process(struct pfe_hif *hif, int count)
 
 		ttc = (ttc + 1) & (hif->tx_ring_size - 1);
 		tx_avl++;
+		done++;
 	}
 
+	hif->txtoclean = ttc;
+	hif->txavail = tx_avl;
+
 	if (pkts_done[0])
 		hif_lib_indicate_client(0, EVENT_TXDONE_IND, 0);
 	if (pkts_done[1])
 		hif_lib_indicate_client(1, EVENT_TXDONE_IND, 0);
 
-	hif->txtoclean = ttc;
-	hif->txavail = tx_avl;
-
-	if (!count) {
-		tasklet_schedule(&hif->tx_cleanup_tasklet);
-	} else {
-		/*Enable Tx done interrupt */
-		writel(readl_relaxed(HIF_INT_ENABLE) | HIF_TXPKT_INT,
-		       HIF_INT_ENABLE);
-	}
+	return done;
 }
 
-static void pfe_tx_do_cleanup(unsigned long data)
+/*
+ * pfe_hif_tx_poll
+ *  This function is NAPI poll function to reclaim HIF Tx descriptors,
+ *  the HIF Tx lock is taken once per batch of completions.
+ */
+static int pfe_hif_tx_poll(struct napi_struct *napi, int budget)
 {
-	struct pfe_hif *hif = (struct pfe_hif *)data;
+	struct pfe_hif *hif = container_of(napi, struct pfe_hif, tx_napi);
+	int done;
 
 	writel(HIF_INT | HIF_TXPKT_INT, HIF_INT_SRC);
 
-	hif_tx_done_process(hif, 64);
+	done = hif_tx_done_process(hif, HIF_TX_POLL_WEIGHT);
+	if (done == HIF_TX_POLL_WEIGHT)
+		return budget;
+
+	if (napi_complete_done(napi, 0)) {
+		/*Enable Tx done interrupt */
+		writel(readl_relaxed(HIF_INT_ENABLE) | HIF_TXPKT_INT,
+		       HIF_INT_ENABLE);
+	}
+
+	return 0;
 }
 
 /*
@@ -880,8 +895,8 @@ static irqreturn_t hif_isr(int irq, void *dev_id)
 	if (int_status & HIF_TXPKT_INT) {
 		int_status &= ~(HIF_TXPKT_INT);
 		int_enable_mask &= ~(HIF_TXPKT_INT);
-		/*Schedule tx cleanup tassklet */
-		tasklet_schedule(&hif->tx_cleanup_tasklet);
+		/*Schedule tx cleanup poll */
+		napi_schedule(&hif->tx_napi);
 	}
 
 	/*Disable interrupts, they will be enabled after they are serviced */
@@ -993,6 +1008,8 @@ int pfe_hif_init(struct pfe *pfe)
 	init_dummy_netdev(&hif->dummy_dev);
 	netif_napi_add(&hif->dummy_dev, &hif->napi, pfe_hif_rx_poll);
 	napi_enable(&hif->napi);
+	netif_napi_add_tx(&hif->dummy_dev, &hif->tx_napi, pfe_hif_tx_poll);
+	napi_enable(&hif->tx_napi);
 
 	spin_lock_init(&hif->tx_lock);
 	spin_lock_init(&hif->lock);
@@ -1020,10 +1037,6 @@ int pfe_hif_init(struct pfe *pfe)
 		goto err1;
 	}
 
-	tasklet_init(&hif->tx_cleanup_tasklet,
-		     (void(*)(unsigned long))pfe_tx_do_cleanup,
-		     (unsigned long)hif);
-
 	return 0;
 err1:
 	pfe_hif_free_descr(hif);
@@ -1038,7 +1051,8 @@ void pfe_hif_exit(struct pfe *pfe)
 
 	pr_info("%s\n", __func__);
 
-	tasklet_kill(&hif->tx_cleanup_tasklet);
+	napi_disable(&hif->tx_napi);
+	netif_napi_del(&hif->tx_napi);
 
 	spin_lock_bh(&hif->lock);
 	hif->shm->g_client_status[0] = 0;
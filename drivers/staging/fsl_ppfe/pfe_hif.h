@@ -13,6 +13,7 @@
 
 #define HIF_CLIENT_QUEUES_MAX	16
 #define HIF_RX_POLL_WEIGHT	64
+#define HIF_TX_POLL_WEIGHT	64
 
 #define HIF_RX_PKT_MIN_SIZE 0x800 /* 2KB */
 #define HIF_RX_PKT_MIN_SIZE_MASK ~(HIF_RX_PKT_MIN_SIZE - 1)
@@ -152,29 +153,34 @@ struct pfe_hif {
 	spinlock_t lock;
 	struct net_device	dummy_dev;
 	struct napi_struct	napi;
+	/* reclaims the TX descriptors completed by the HIF */
+	struct napi_struct	tx_napi;
 	struct device *dev;
 
 #ifdef HIF_NAPI_STATS
 	unsigned int napi_counters[NAPI_MAX_COUNT];
 #endif
-	struct tasklet_struct	tx_cleanup_tasklet;
 };
 
 void __hif_xmit_pkt(struct pfe_hif *hif, unsigned int client_id, unsigned int
 			q_no, void *data, u32 len, unsigned int flags);
 int hif_xmit_pkt(struct pfe_hif *hif, unsigned int client_id, unsigned int q_no,
 		 void *data, unsigned int len);
-void __hif_tx_done_process(struct pfe_hif *hif, int count);
+int __hif_tx_done_process(struct pfe_hif *hif, int count);
 void hif_process_client_req(struct pfe_hif *hif, int req, int data1, int
 				data2);
 int pfe_hif_init(struct pfe *pfe);
 void pfe_hif_exit(struct pfe *pfe);
 void pfe_hif_rx_idle(struct pfe_hif *hif);
-static inline void hif_tx_done_process(struct pfe_hif *hif, int count)
+static inline int hif_tx_done_process(struct pfe_hif *hif, int count)
 {
+	int done;
+
 	spin_lock_bh(&hif->tx_lock);
-	__hif_tx_done_process(hif, count);
+	done = __hif_tx_done_process(hif, count);
 	spin_unlock_bh(&hif->tx_lock);
+
+	return done;
 }
 
 static inline void hif_tx_lock(struct pfe_hif *hif)
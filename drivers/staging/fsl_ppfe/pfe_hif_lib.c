@@ -414,6 +414,12 @@ void *hif_lib_receive_pkt(struct hif_client_s *client, int qno, int *len, int
 	/*spin_lock_irqsave(&client->rx_lock, flags); */
 	desc = queue->base + queue->read_idx;
 	if (!(desc->ctrl & CL_DESC_OWN)) {
+		/*
+		 * The client poll may run on another CPU than the HIF poll
+		 * filling the queue, read the descriptor after its ctrl.
+		 */
+		smp_rmb();
+
 		pkt = desc->data - pfe_pkt_headroom;
 
 		*rx_ctrl = desc->client_ctrl;
@@ -1743,7 +1743,8 @@ static int csi_set_selection(struct v4l2_subdev *sd,
 static int csi_subscribe_event(struct v4l2_subdev *sd, struct v4l2_fh *fh,
 			       struct v4l2_event_subscription *sub)
 {
-	if (sub->type != V4L2_EVENT_IMX_FRAME_INTERVAL_ERROR)
+	if (sub->type != V4L2_EVENT_IMX_FRAME_INTERVAL_ERROR &&
+	    sub->type != V4L2_EVENT_IMX_FRAME_INTERVAL_DRIFT)
 		return -EINVAL;
 	if (sub->id != 0)
 		return -EINVAL;
@@ -6,6 +6,7 @@
  */
 #include <linux/delay.h>
 #include <linux/irq.h>
+#include <linux/log2.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
@@ -61,9 +62,22 @@ struct imx_media_fim {
 
 	int               counter;
 	ktime_t		  last_ts;
-	unsigned long     sum;       /* usec */
 	unsigned long     nominal;   /* usec */
 
+	/*
+	 * Running estimators, kept as exponentially weighted averages
+	 * scaled by 2^avg_shift so that updating them per frame needs
+	 * neither a division nor a history buffer.
+	 */
+	unsigned int      avg_shift;
+	u64               nominal_ns;
+	u64               tol_min_ns;
+	u64               tol_max_ns;
+	u64               abs_err_avg; /* |interval - nominal|, ns << shift */
+	s64               drift_avg;   /* interval - nominal, ns << shift */
+	bool              avg_valid;
+	bool              drifting;
+
 	struct completion icap_first_event;
 	bool              stream_on;
 };
@@ -82,8 +96,9 @@ static void update_fim_nominal(struct imx_media_fim *fim,
 		return;
 	}
 
-	fim->nominal = DIV_ROUND_CLOSEST_ULL(1000000ULL * (u64)fi->numerator,
-					     fi->denominator);
+	fim->nominal_ns = DIV_ROUND_CLOSEST_ULL(NSEC_PER_SEC * (u64)fi->numerator,
+						fi->denominator);
+	fim->nominal = DIV_ROUND_CLOSEST_ULL(fim->nominal_ns, NSEC_PER_USEC);
 
 	dev_dbg(fim->sd->dev, "FI=%lu usec\n", fim->nominal);
 }
@@ -125,7 +140,15 @@ static void reset_fim(struct imx_media_fim *fim, bool curval)
 		fim->num_skip = max_t(int, fim->num_skip, 1);
 
 	fim->counter = -fim->num_skip;
-	fim->sum = 0;
+
+	/* an average over num_avg frames has a 1/num_avg weight */
+	fim->avg_shift = order_base_2(fim->num_avg);
+	fim->tol_min_ns = (u64)fim->tolerance_min * NSEC_PER_USEC;
+	fim->tol_max_ns = (u64)fim->tolerance_max * NSEC_PER_USEC;
+	fim->abs_err_avg = 0;
+	fim->drift_avg = 0;
+	fim->avg_valid = false;
+	fim->drifting = false;
 }
 
 static void send_fim_event(struct imx_media_fim *fim, unsigned long error)
@@ -137,57 +160,89 @@ static void send_fim_event(struct imx_media_fim *fim, unsigned long error)
 	v4l2_subdev_notify_event(fim->sd, &ev);
 }
 
+static void send_drift_event(struct imx_media_fim *fim, s64 drift)
+{
+	struct v4l2_event ev = {
+		.type = V4L2_EVENT_IMX_FRAME_INTERVAL_DRIFT,
+	};
+	struct imx_media_fim_drift *data = (void *)ev.u.data;
+
+	data->drift_ns = drift;
+	data->nominal_ns = fim->nominal_ns;
+	data->drifting = fim->drifting;
+
+	v4l2_subdev_notify_event(fim->sd, &ev);
+}
+
 /*
- * Monitor an averaged frame interval. If the average deviates too much
- * from the nominal frame rate, send the frame interval error event. The
- * frame intervals are averaged in order to quiet noise from
- * (presumably random) interrupt latency.
+ * Monitor the frame interval through running averages. If the average
+ * error deviates too much from the nominal frame rate, send the frame
+ * interval error event once per num_avg frames. The frame intervals are
+ * averaged in order to quiet noise from (presumably random) interrupt
+ * latency.
+ *
+ * The signed average tracks a systematic drift of the source clock
+ * against ours. The drift event is sent when it crosses the minimum
+ * tolerance, in either direction, so that listeners synchronizing
+ * several sources are only woken up on changes.
  */
 static void frame_interval_monitor(struct imx_media_fim *fim,
 				   ktime_t timestamp)
 {
-	long long interval, error;
-	unsigned long error_avg;
+	unsigned int shift = fim->avg_shift;
 	bool send_event = false;
+	bool send_drift = false;
+	s64 error, drift;
+	u64 abs_error;
 
 	if (!fim->enabled || ++fim->counter <= 0)
 		goto out_update_ts;
 
-	/* max error is less than l00µs, so use 32-bit division or fail */
-	interval = ktime_to_ns(ktime_sub(timestamp, fim->last_ts));
-	error = abs(interval - NSEC_PER_USEC * (u64)fim->nominal);
-	if (error > U32_MAX)
-		error = U32_MAX;
-	else
-		error = abs((u32)error / NSEC_PER_USEC);
+	error = ktime_to_ns(ktime_sub(timestamp, fim->last_ts)) -
+		(s64)fim->nominal_ns;
+	abs_error = abs(error);
 
-	if (fim->tolerance_max && error >= fim->tolerance_max) {
+	if (fim->tol_max_ns && abs_error >= fim->tol_max_ns) {
 		dev_dbg(fim->sd->dev,
-			"FIM: %llu ignored, out of tolerance bounds\n",
+			"FIM: %lld ns ignored, out of tolerance bounds\n",
 			error);
 		fim->counter--;
 		goto out_update_ts;
 	}
 
-	fim->sum += error;
+	/* seed the averages with the first measured interval */
+	if (!fim->avg_valid) {
+		fim->abs_err_avg = abs_error << shift;
+		fim->drift_avg = error * (1LL << shift);
+		fim->avg_valid = true;
+	} else {
+		fim->abs_err_avg += abs_error - (fim->abs_err_avg >> shift);
+		fim->drift_avg += error - (fim->drift_avg >> shift);
+	}
 
-	if (fim->counter == fim->num_avg) {
-		error_avg = DIV_ROUND_CLOSEST(fim->sum, fim->num_avg);
+	drift = fim->drift_avg >> shift;
+	if (fim->drifting != (abs(drift) > fim->tol_min_ns)) {
+		fim->drifting = !fim->drifting;
+		send_drift = true;
+	}
 
-		if (error_avg > fim->tolerance_min)
+	if (fim->counter >= fim->num_avg) {
+		if ((fim->abs_err_avg >> shift) > fim->tol_min_ns)
 			send_event = true;
 
-		dev_dbg(fim->sd->dev, "FIM: error: %lu usec%s\n",
-			error_avg, send_event ? " (!!!)" : "");
+		dev_dbg(fim->sd->dev, "FIM: error: %llu ns, drift %lld ns%s\n",
+			fim->abs_err_avg >> shift, drift,
+			send_event ? " (!!!)" : "");
 
 		fim->counter = 0;
-		fim->sum = 0;
 	}
 
 out_update_ts:
 	fim->last_ts = timestamp;
 	if (send_event)
-		send_fim_event(fim, error_avg);
+		send_fim_event(fim, fim->abs_err_avg >> shift);
+	if (send_drift)
+		send_drift_event(fim, drift);
 }
 
 /*
@@ -417,6 +472,7 @@ struct imx_media_fim *imx_media_fim_init(struct v4l2_subdev *sd)
 	fim->sd = sd;
 
 	spin_lock_init(&fim->lock);
+	init_completion(&fim->icap_first_event);
 
 	ret = init_fim_controls(fim);
 	if (ret)
@@ -14,10 +14,12 @@
 #include <linux/types.h>
 #include <linux/errno.h>
 #include <linux/bug.h>
+#include <linux/debugfs.h>
 #include <linux/interrupt.h>
 #include <linux/device.h>
 #include <linux/pm_runtime.h>
 #include <linux/list.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/of_graph.h>
 #include <linux/videodev2.h>
@@ -184,6 +186,8 @@ void mxc_isi_cap_frame_write_done(struct mxc_isi_dev *mxc_isi)
 	}
 
 	if (buf->discard) {
+		/* no buffer was queued in time, the frame is lost */
+		isi_cap->latency.dropped++;
 		list_move_tail(isi_cap->out_active.next, &isi_cap->out_discard);
 	} else {
 		vb2 = &buf->v4l2_buf.vb2_buf;
@@ -309,6 +313,33 @@ static int cap_vb2_buffer_init(struct vb2_buffer *vb2)
 	return 0;
 }
 
+/*
+ * Buffers are timestamped when the ISI has written the last line. The time
+ * until userspace dequeues them adds to the latency of an HDMI in to display
+ * passthrough, along with the wait for the next vblank that userspace can
+ * derive from the DRM event timestamp (both use CLOCK_MONOTONIC).
+ */
+static void cap_vb2_buffer_finish(struct vb2_buffer *vb2)
+{
+	struct mxc_isi_cap_dev *isi_cap = vb2_get_drv_priv(vb2->vb2_queue);
+	struct mxc_isi_cap_latency *lat = &isi_cap->latency;
+	unsigned long flags;
+	u64 delay;
+
+	/* buffers returned by stop_streaming were not dequeued */
+	if (vb2->state != VB2_BUF_STATE_DONE || !vb2_is_streaming(vb2->vb2_queue))
+		return;
+
+	delay = ktime_get_ns() - vb2->timestamp;
+
+	spin_lock_irqsave(&isi_cap->slock, flags);
+	lat->count++;
+	lat->total_ns += delay;
+	lat->last_ns = delay;
+	lat->max_ns = max(lat->max_ns, delay);
+	spin_unlock_irqrestore(&isi_cap->slock, flags);
+}
+
 static void cap_vb2_buffer_queue(struct vb2_buffer *vb2)
 {
 	struct vb2_v4l2_buffer *v4l2_buf = to_vb2_v4l2_buffer(vb2);
@@ -404,6 +435,7 @@ static int cap_vb2_start_streaming(struct vb2_queue *q, unsigned int count)
 
 	/* Clear frame count */
 	isi_cap->frame_count = 1;
+	memset(&isi_cap->latency, 0, sizeof(isi_cap->latency));
 	spin_unlock_irqrestore(&isi_cap->slock, flags);
 
 	return 0;
@@ -485,6 +517,7 @@ static struct vb2_ops mxc_cap_vb2_qops = {
 	.queue_setup		= cap_vb2_queue_setup,
 	.buf_prepare		= cap_vb2_buffer_prepare,
 	.buf_init		= cap_vb2_buffer_init,
+	.buf_finish		= cap_vb2_buffer_finish,
 	.buf_queue		= cap_vb2_buffer_queue,
 	.wait_prepare		= vb2_ops_wait_prepare,
 	.wait_finish		= vb2_ops_wait_finish,
@@ -1679,7 +1712,8 @@ static int mxc_isi_register_cap_device(struct mxc_isi_cap_dev *isi_cap,
 	q->ops = &mxc_cap_vb2_qops;
 	q->mem_ops = &vb2_dma_contig_memops;
 	q->buf_struct_size = sizeof(struct mxc_isi_buffer);
-	q->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+	q->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC |
+			     V4L2_BUF_FLAG_TSTAMP_SRC_EOF;
 	q->lock = &isi_cap->lock;
 	q->min_queued_buffers = 2;
 	q->dev = &isi_cap->pdev->dev;
@@ -1759,6 +1793,27 @@ static const struct v4l2_subdev_internal_ops mxc_isi_capture_sd_internal_ops = {
 	.unregistered = mxc_isi_subdev_unregistered,
 };
 
+static int mxc_isi_cap_latency_show(struct seq_file *s, void *data)
+{
+	struct mxc_isi_cap_dev *isi_cap = s->private;
+	struct mxc_isi_cap_latency lat;
+	unsigned long flags;
+
+	spin_lock_irqsave(&isi_cap->slock, flags);
+	lat = isi_cap->latency;
+	spin_unlock_irqrestore(&isi_cap->slock, flags);
+
+	seq_printf(s, "frames:  %llu\n", lat.count);
+	seq_printf(s, "dropped: %u\n", lat.dropped);
+	seq_printf(s, "last:    %llu us\n", div_u64(lat.last_ns, NSEC_PER_USEC));
+	seq_printf(s, "avg:     %llu us\n",
+		   lat.count ? div64_u64(lat.total_ns, lat.count * NSEC_PER_USEC) : 0);
+	seq_printf(s, "max:     %llu us\n", div_u64(lat.max_ns, NSEC_PER_USEC));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(mxc_isi_cap_latency);
+
 static int isi_cap_probe(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
@@ -1829,6 +1884,10 @@ static int isi_cap_probe(struct platform_device *pdev)
 	v4l2_set_subdevdata(sd, isi_cap);
 	platform_set_drvdata(pdev, isi_cap);
 
+	isi_cap->debugfs = debugfs_create_dir(dev_name(dev), NULL);
+	debugfs_create_file("latency", 0444, isi_cap->debugfs, isi_cap,
+			    &mxc_isi_cap_latency_fops);
+
 	pm_runtime_enable(dev);
 	return 0;
 }
@@ -1838,6 +1897,7 @@ static void isi_cap_remove(struct platform_device *pdev)
 	struct mxc_isi_cap_dev *isi_cap = platform_get_drvdata(pdev);
 	struct v4l2_subdev *sd = &isi_cap->sd;
 
+	debugfs_remove_recursive(isi_cap->debugfs);
 	v4l2_device_unregister_subdev(sd);
 	media_entity_cleanup(&sd->entity);
 	v4l2_set_subdevdata(sd, NULL);
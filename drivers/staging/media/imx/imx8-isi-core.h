@@ -302,6 +302,15 @@ struct mxc_isi_plat_data {
 	struct mxc_isi_gate_clk_ops *gclk_ops;
 };
 
+/* Delay from frame done to dequeue, and frames lost for lack of buffers */
+struct mxc_isi_cap_latency {
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+	u64 last_ns;
+	u32 dropped;
+};
+
 struct mxc_isi_cap_dev {
 	struct v4l2_subdev  sd;
 	struct video_device vdev;
@@ -325,6 +334,8 @@ struct mxc_isi_cap_dev {
 	struct mxc_isi_frame dst_f;
 
 	u32 frame_count;
+	struct mxc_isi_cap_latency latency;
+	struct dentry *debugfs;
 	u32 id;
 	u32 is_streaming[MXC_ISI_MAX_DEVS];
 	bool runtime_suspend;
@@ -6,6 +6,7 @@
 /****************************************************************************/
 
 #include <linux/anon_inodes.h>
+#include <linux/dma-buf.h>
 #include <linux/dma-mapping.h>
 #include <linux/of_address.h>
 #include <linux/file.h>
@@ -39,6 +40,15 @@ static void neutron_buffer_destroy(struct kref *kref)
 
 	dev_dbg(buf->ndev->dev, "Buffer destroy. buf=0x%pS\n", buf);
 
+	if (buf->dmabuf) {
+		dma_buf_unmap_attachment_unlocked(buf->attach, buf->sgt,
+						  DMA_BIDIRECTIONAL);
+		dma_buf_detach(buf->dmabuf, buf->attach);
+		dma_buf_put(buf->dmabuf);
+		devm_kfree(buf->ndev->dev, buf);
+		return;
+	}
+
 	if (buf->firmware_p)
 		release_firmware(buf->firmware_p);
 
@@ -69,6 +79,9 @@ static int neutron_buffer_mmap(struct file *file,
 	dev_dbg(buf->ndev->dev, "Buffer mmap. file=0x%pS, buf=0x%pS\n",
 		file, buf);
 
+	if (buf->dmabuf)
+		return dma_buf_mmap(buf->dmabuf, vma, vma->vm_pgoff);
+
 	ret = dma_mmap_attrs(buf->ndev->dev, vma, buf->cpu_addr,
 			     buf->dma_addr, buf->size, DMA_ATTR_FORCE_CONTIGUOUS);
 
@@ -122,6 +135,80 @@ int neutron_buffer_create(struct neutron_device *ndev,
 	return ret;
 }
 
+int neutron_buffer_import(struct neutron_device *ndev, int fd,
+			  __u32 *size_out, __u64 *addr_out)
+{
+	struct neutron_buffer *buf;
+	struct scatterlist *sg;
+	dma_addr_t next;
+	int i, ret;
+
+	buf = devm_kzalloc(ndev->dev, sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	buf->ndev = ndev;
+	kref_init(&buf->kref);
+
+	buf->dmabuf = dma_buf_get(fd);
+	if (IS_ERR(buf->dmabuf)) {
+		ret = PTR_ERR(buf->dmabuf);
+		goto free_buf;
+	}
+
+	buf->attach = dma_buf_attach(buf->dmabuf, ndev->dev);
+	if (IS_ERR(buf->attach)) {
+		ret = PTR_ERR(buf->attach);
+		goto put_dmabuf;
+	}
+
+	buf->sgt = dma_buf_map_attachment_unlocked(buf->attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(buf->sgt)) {
+		ret = PTR_ERR(buf->sgt);
+		goto detach;
+	}
+
+	/* neutron has no IOMMU, it needs the buffer to be DMA contiguous */
+	ret = -EINVAL;
+	buf->dma_addr = sg_dma_address(buf->sgt->sgl);
+	next = buf->dma_addr;
+	for_each_sgtable_dma_sg(buf->sgt, sg, i) {
+		if (sg_dma_address(sg) != next)
+			goto unmap;
+		next += sg_dma_len(sg);
+	}
+	buf->size = next - buf->dma_addr;
+	if (buf->size > U32_MAX)
+		goto unmap;
+
+	ret = anon_inode_getfd("neutron-buffer", &neutron_buffer_fops, buf,
+			       O_RDWR | O_CLOEXEC);
+	if (ret < 0)
+		goto unmap;
+
+	buf->file = fget(ret);
+	fput(buf->file);
+	*size_out = buf->size;
+	*addr_out = buf->dma_addr;
+
+	dev_dbg(ndev->dev,
+		"Buffer import. fd=%d, size=%zu, dma_addr=0x%llx\n",
+		ret, buf->size, buf->dma_addr);
+
+	return ret;
+
+unmap:
+	dma_buf_unmap_attachment_unlocked(buf->attach, buf->sgt, DMA_BIDIRECTIONAL);
+detach:
+	dma_buf_detach(buf->dmabuf, buf->attach);
+put_dmabuf:
+	dma_buf_put(buf->dmabuf);
+free_buf:
+	devm_kfree(ndev->dev, buf);
+
+	return ret;
+}
+
 struct neutron_buffer *neutron_buffer_get_from_fd(int fd)
 {
 	struct neutron_buffer *buf;
@@ -131,6 +218,11 @@ struct neutron_buffer *neutron_buffer_get_from_fd(int fd)
 	if (!file)
 		return ERR_PTR(-EINVAL);
 
+	if (file->f_op != &neutron_buffer_fops) {
+		fput(file);
+		return ERR_PTR(-EINVAL);
+	}
+
 	buf = file->private_data;
 	fput(file);
 
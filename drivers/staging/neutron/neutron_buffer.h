@@ -15,6 +15,9 @@
 
 struct neutron_device;
 struct device;
+struct dma_buf;
+struct dma_buf_attachment;
+struct sg_table;
 
 /**
  * struct neutron_buffer - Buffer
@@ -27,6 +30,9 @@ struct device;
  * @dma_addr_orig:      Original DMA address before range mapping
  * @firmware_name:      Neutron custom firmware file name
  * @firmware_p:         Neutron Custom firmware pointer.
+ * @dmabuf:             Imported dma-buf, NULL for own buffers
+ * @attach:             Attachment of @dmabuf to neutron
+ * @sgt:                Mapping of @attach
  */
 struct neutron_buffer {
 	struct neutron_device *ndev;
@@ -37,6 +43,9 @@ struct neutron_buffer {
 	dma_addr_t            dma_addr;
 	const char            *firmware_name;
 	const struct firmware *firmware_p;
+	struct dma_buf        *dmabuf;
+	struct dma_buf_attachment *attach;
+	struct sg_table       *sgt;
 };
 
 /****************************************************************************/
@@ -51,6 +60,16 @@ struct neutron_buffer {
 int neutron_buffer_create(struct neutron_device *ndev,
 			  size_t size, __u64 *addr_out);
 
+/**
+ * neutron_buffer_import() - Import a dma-buf as buffer
+ *
+ * This function must be called in the context of a user space process.
+ *
+ * Return: fd on success, else error code.
+ */
+int neutron_buffer_import(struct neutron_device *ndev, int fd,
+			  __u32 *size_out, __u64 *addr_out);
+
 struct neutron_buffer *neutron_buffer_get_from_fd(int fd);
 
 /**
@@ -7,6 +7,8 @@
 #include <linux/dma-mapping.h>
 #include <linux/dma-map-ops.h>
 #include <linux/bitmap.h>
+#include <linux/crc32.h>
+#include <linux/debugfs.h>
 #include <linux/interrupt.h>
 #include <linux/mutex.h>
 #include <linux/fs.h>
@@ -226,6 +228,7 @@ static int neutron_firmw_request(struct neutron_device *ndev, struct neutron_buf
 
 	/* Firmware is changed, it should be reloaded on next job */
 	ndev->firmw_id = 0;
+	memset(ndev->firmw_cache.slot, 0, sizeof(ndev->firmw_cache.slot));
 
 	return ret;
 }
@@ -257,6 +260,109 @@ int neutron_firmw_reload(struct neutron_device *ndev, struct neutron_buffer *buf
 	return ret;
 }
 
+/* Checksum of the ELF segments that go to the neutron local memory */
+static int neutron_firmw_sig(const struct firmware *fw, u32 *sig)
+{
+	const struct elf32_hdr *ehdr = (const struct elf32_hdr *)fw->data;
+	const struct elf32_phdr *phdr;
+	u32 crc = ~0;
+	int i;
+
+	if (fw->size < sizeof(*ehdr) ||
+	    ehdr->e_phoff + (u64)ehdr->e_phnum * sizeof(*phdr) > fw->size)
+		return -EINVAL;
+
+	phdr = (const struct elf32_phdr *)(fw->data + ehdr->e_phoff);
+	for (i = 0; i < ehdr->e_phnum; i++, phdr++) {
+		/* the DDR data segment is resident in the job buffer */
+		if (phdr->p_type != PT_LOAD || !phdr->p_memsz ||
+		    phdr->p_paddr == 0x50000)
+			continue;
+
+		if (phdr->p_filesz > phdr->p_memsz ||
+		    (u64)phdr->p_offset + phdr->p_filesz > fw->size)
+			return -EINVAL;
+
+		crc = crc32_le(crc, (const u8 *)&phdr->p_paddr, sizeof(phdr->p_paddr));
+		crc = crc32_le(crc, (const u8 *)&phdr->p_memsz, sizeof(phdr->p_memsz));
+		crc = crc32_le(crc, fw->data + phdr->p_offset, phdr->p_filesz);
+	}
+
+	*sig = ~crc;
+	return 0;
+}
+
+static struct neutron_firmw_slot *neutron_firmw_lookup(struct neutron_device *ndev,
+						       struct neutron_buffer *buf,
+						       u32 firmw_id)
+{
+	struct neutron_firmw_cache *cache = &ndev->firmw_cache;
+	struct neutron_firmw_slot *slot, *lru = &cache->slot[0];
+	int i, ret;
+
+	for (i = 0; i < NEUTRON_FIRMW_CACHE_SIZE; i++) {
+		slot = &cache->slot[i];
+		if (slot->last_used && slot->firmw_id == firmw_id)
+			goto found;
+		if (slot->last_used < lru->last_used)
+			lru = slot;
+	}
+
+	slot = lru;
+	ret = neutron_firmw_sig(buf->firmware_p, &slot->sig);
+	if (ret) {
+		slot->last_used = 0;
+		return ERR_PTR(ret);
+	}
+	slot->firmw_id = firmw_id;
+
+found:
+	slot->last_used = ++cache->clock;
+	return slot;
+}
+
+/**
+ * neutron_firmw_switch - Make the firmware of a job the running one
+ *
+ * Switching between firmwares whose local memory image is identical only
+ * needs the BASEDDR registers of the job, which are set for every job.
+ * Must be called with ndev->mutex held.
+ *
+ * Return: 0 on success, else error code.
+ */
+int neutron_firmw_switch(struct neutron_device *ndev, struct neutron_buffer *buf,
+			 u32 firmw_id)
+{
+	struct neutron_firmw_cache *cache = &ndev->firmw_cache;
+	struct neutron_firmw_slot *slot;
+	int ret;
+
+	if (!buf->firmware_p) {
+		dev_err(ndev->dev, "firmware is not ready\n");
+		return -EINVAL;
+	}
+
+	slot = neutron_firmw_lookup(ndev, buf, firmw_id);
+	if (IS_ERR(slot))
+		return PTR_ERR(slot);
+
+	if (cache->resident && cache->resident_sig == slot->sig) {
+		cache->reloads_avoided++;
+		return 0;
+	}
+
+	cache->resident = false;
+	ret = neutron_firmw_reload(ndev, buf);
+	if (ret)
+		return ret;
+
+	cache->resident = true;
+	cache->resident_sig = slot->sig;
+	cache->reloads++;
+
+	return 0;
+}
+
 void neutron_memory_sync(struct neutron_device *ndev, dma_addr_t addr,
 			 size_t size, enum dma_data_direction dir)
 {
@@ -278,6 +384,27 @@ void neutron_memory_sync(struct neutron_device *ndev, dma_addr_t addr,
 	ndev->dev->dma_coherent = true;
 }
 
+void neutron_sgt_sync(struct neutron_device *ndev, struct sg_table *sgt,
+		      enum dma_data_direction dir)
+{
+	/* unset dma_coherent to ensure arch_sync_dma_for_device() is executed */
+	ndev->dev->dma_coherent = false;
+
+	switch (dir) {
+	case DMA_TO_DEVICE:
+		dma_sync_sgtable_for_device(ndev->dev, sgt, DMA_TO_DEVICE);
+		break;
+	case DMA_FROM_DEVICE:
+		dma_sync_sgtable_for_cpu(ndev->dev, sgt, DMA_FROM_DEVICE);
+		break;
+	default:
+		break;
+	}
+
+	/* recovery dma_coherent */
+	ndev->dev->dma_coherent = true;
+}
+
 /* Clock gating via RESETCTRL register */
 void neutron_clk_disable(struct neutron_device *ndev)
 {
@@ -332,6 +459,7 @@ int neutron_rproc_boot(struct neutron_device *ndev, const char *fw_name)
 
 		/* Firmware is changed */
 		ndev->firmw_id = 0;
+		ndev->firmw_cache.resident = false;
 	}
 	/* Update power state */
 	if (ndev->power_state == NEUTRON_POWER_OFF)
@@ -520,6 +648,20 @@ static long neutron_ioctl(struct file *file,
 
 		break;
 	}
+	case NEUTRON_IOCTL_BUFFER_IMPORT: {
+		struct neutron_uapi_buffer_import uapi;
+
+		if (copy_from_user(&uapi, udata, sizeof(uapi)))
+			break;
+
+		dev_dbg(ndev->dev, "Ioctl: Buffer import. fd=%d\n", uapi.fd);
+
+		ret = neutron_buffer_import(ndev, uapi.fd, &uapi.size, &uapi.addr);
+		if (copy_to_user(udata, &uapi, sizeof(uapi)))
+			break;
+
+		break;
+	}
 	case NEUTRON_IOCTL_KERNEL_LOAD: {
 		struct neutron_uapi_inference_args uapi;
 
@@ -702,6 +844,10 @@ int neutron_dev_init(struct neutron_device *ndev,
 		goto put_clk;
 	}
 
+	/* The clocks are up now, make sure the done IRQ is unmasked */
+	if (ndev->flags & NEUTRON_USE_IRQ_MODE)
+		neutron_irq_enable(ndev);
+
 	ndev->queue = neutron_queue_create(ndev);
 	if (!ndev->queue) {
 		dev_err(ndev->dev, "Failed to create inference queue.\n");
@@ -733,6 +879,12 @@ int neutron_dev_init(struct neutron_device *ndev,
 
 	ndev->rproc = neutron_get_rproc(ndev);
 
+	ndev->debugfs = debugfs_create_dir(dev_name(sysdev), NULL);
+	debugfs_create_u64("firmw_reloads", 0444, ndev->debugfs,
+			   &ndev->firmw_cache.reloads);
+	debugfs_create_u64("firmw_reloads_avoided", 0444, ndev->debugfs,
+			   &ndev->firmw_cache.reloads_avoided);
+
 	dev_info(ndev->dev,
 		 "created neutron device, name=%s\n", dev_name(sysdev));
 
@@ -755,6 +907,7 @@ int neutron_dev_init(struct neutron_device *ndev,
 
 void neutron_dev_deinit(struct neutron_device *ndev)
 {
+	debugfs_remove_recursive(ndev->debugfs);
 	neutron_queue_destroy(ndev->queue);
 	neutron_mbox_destroy(ndev->mbox);
 	neutron_rproc_put(ndev);
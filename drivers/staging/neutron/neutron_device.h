@@ -91,6 +91,9 @@
 struct rproc;
 struct clk_bulk_data;
 struct neutron_buffer;
+struct dentry;
+
+#define NEUTRON_FIRMW_CACHE_SIZE    4
 
 /**
  * struct neutron_log_buffer - Neutron log buffer
@@ -102,6 +105,40 @@ struct neutron_log_buffer {
 	char *last_to_console; /* Last data sent to console */
 };
 
+/**
+ * struct neutron_firmw_slot - Firmware residency cache entry
+ * @firmw_id:		Firmware id given by the jobs
+ * @sig:		Checksum of the image loaded into the neutron local memory
+ * @last_used:		LRU stamp, 0 if the slot is free
+ */
+struct neutron_firmw_slot {
+	u32 firmw_id;
+	u32 sig;
+	u64 last_used;
+};
+
+/**
+ * struct neutron_firmw_cache - Firmware residency cache
+ * @slot:		Recently used firmware ids
+ * @clock:		LRU clock
+ * @resident:		@resident_sig is valid
+ * @resident_sig:	Checksum of the image currently in the local memory
+ * @reloads:		Number of firmware reloads
+ * @reloads_avoided:	Number of firmware switches that needed no reload
+ *
+ * The DDR part of every firmware stays resident in its buffer and is
+ * selected through the BASEDDR registers, only the part in the neutron
+ * local memory has to be reloaded, and only if it differs.
+ */
+struct neutron_firmw_cache {
+	struct neutron_firmw_slot slot[NEUTRON_FIRMW_CACHE_SIZE];
+	u64 clock;
+	bool resident;
+	u32 resident_sig;
+	u64 reloads;
+	u64 reloads_avoided;
+};
+
 /**
  * struct neutron_device - Device structure
  * @dev:			Common device
@@ -134,6 +171,10 @@ struct neutron_device {
 	void __iomem                   *reg_reset;
 	u32                            power_mode;
 	u32                            suspend_delay;
+	/* shortest status polling period in polling mode, in us */
+	u32                            poll_interval;
+	struct neutron_firmw_cache     firmw_cache;
+	struct dentry                  *debugfs;
 };
 
 int neutron_dev_init(struct neutron_device *ndev,
@@ -146,8 +187,12 @@ int neutron_rproc_boot(struct neutron_device *ndev, const char *fw_name);
 int neutron_rproc_shutdown(struct neutron_device *ndev);
 int neutron_hw_reset(struct neutron_device *ndev);
 int neutron_firmw_reload(struct neutron_device *ndev, struct neutron_buffer *buf);
+int neutron_firmw_switch(struct neutron_device *ndev, struct neutron_buffer *buf,
+			 u32 firmw_id);
 void neutron_memory_sync(struct neutron_device *ndev, dma_addr_t addr,
 			 size_t size, enum dma_data_direction dir);
+void neutron_sgt_sync(struct neutron_device *ndev, struct sg_table *sgt,
+		      enum dma_data_direction dir);
 void neutron_clk_enable(struct neutron_device *ndev);
 void neutron_clk_disable(struct neutron_device *ndev);
 void neutron_irq_enable(struct neutron_device *ndev);
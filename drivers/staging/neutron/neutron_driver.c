@@ -45,6 +45,11 @@ static bool use_irq = true;
 module_param(use_irq, bool, 0644);
 MODULE_PARM_DESC(use_irq, "Enable IRQ mode for the inference job, set it to 0 for polling mode.");
 
+static unsigned int poll_interval = 100;
+
+module_param(poll_interval, uint, 0644);
+MODULE_PARM_DESC(poll_interval, "Shortest status polling period in polling mode, default is 100 (us)");
+
 static struct class *neutron_class;
 static dev_t devt;
 static DECLARE_BITMAP(minors, MINOR_COUNT);
@@ -93,6 +98,7 @@ static int neutron_pdev_probe(struct platform_device *pdev)
 		ndev->flags |= NEUTRON_USE_IRQ_MODE;
 	else
 		ndev->flags &= (~NEUTRON_USE_IRQ_MODE);
+	ndev->poll_interval = max(poll_interval, 10U);
 
 	pm_runtime_enable(&pdev->dev);
 
@@ -271,6 +277,7 @@ static void __exit neutron_exit(void)
 
 late_initcall(neutron_init) /* After neutron rproc */
 module_exit(neutron_exit)
+MODULE_IMPORT_NS(DMA_BUF);
 MODULE_LICENSE("GPL v2");
 MODULE_DESCRIPTION("i.MX Neutron NPU Driver");
 MODULE_VERSION(NEUTRON_DRIVER_VERSION);
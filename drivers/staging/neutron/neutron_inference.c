@@ -8,6 +8,9 @@
  ****************************************************************************/
 
 #include <linux/dma-mapping.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/dma-resv.h>
 #include <linux/anon_inodes.h>
 #include <linux/file.h>
 #include <linux/fs.h>
@@ -62,6 +65,139 @@ static inline void neutron_inference_del_list(struct neutron_inference_queue *qu
 	list_del(&inf->node);
 }
 
+/* Longest wait for the other users of an imported buffer */
+#define NEUTRON_FENCE_TIMEOUT	msecs_to_jiffies(1000)
+
+struct neutron_fence {
+	struct dma_fence base;
+	spinlock_t lock;
+};
+
+static const char *neutron_fence_get_driver_name(struct dma_fence *fence)
+{
+	return "neutron";
+}
+
+static const char *neutron_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "inference";
+}
+
+static const struct dma_fence_ops neutron_fence_ops = {
+	.get_driver_name = neutron_fence_get_driver_name,
+	.get_timeline_name = neutron_fence_get_timeline_name,
+};
+
+static struct dma_fence *neutron_fence_create(void)
+{
+	struct neutron_fence *fence;
+
+	fence = kzalloc(sizeof(*fence), GFP_KERNEL);
+	if (!fence)
+		return NULL;
+
+	spin_lock_init(&fence->lock);
+	dma_fence_init(&fence->base, &neutron_fence_ops, &fence->lock,
+		       dma_fence_context_alloc(1), 1);
+
+	return &fence->base;
+}
+
+/*
+ * Wait until the other users of an imported buffer are done with it and
+ * fence our access, so they wait for the inference in turn.
+ */
+static int neutron_inference_fence_ext(struct neutron_inference *inf,
+				       struct neutron_buffer *buf, bool write)
+{
+	struct dma_resv *resv = buf->dmabuf->resv;
+	long timeout;
+	int ret;
+
+	timeout = dma_resv_wait_timeout(resv, dma_resv_usage_rw(write), true,
+					NEUTRON_FENCE_TIMEOUT);
+	if (timeout <= 0)
+		return timeout ? timeout : -ETIMEDOUT;
+
+	ret = dma_resv_lock_interruptible(resv, NULL);
+	if (ret)
+		return ret;
+
+	ret = dma_resv_reserve_fences(resv, 1);
+	if (!ret)
+		dma_resv_add_fence(resv, inf->fence, write ? DMA_RESV_USAGE_WRITE :
+				   DMA_RESV_USAGE_READ);
+	dma_resv_unlock(resv);
+
+	return ret;
+}
+
+static struct neutron_buffer *neutron_inference_get_ext(int fd)
+{
+	struct neutron_buffer *buf;
+
+	buf = neutron_buffer_get_from_fd(fd);
+	if (IS_ERR(buf) || !buf->dmabuf)
+		return ERR_PTR(-EINVAL);
+
+	neutron_buffer_get(buf);
+
+	return buf;
+}
+
+/* Longest status polling period in polling mode */
+#define NEUTRON_POLL_MAX_NS	(10 * NSEC_PER_MSEC)
+
+static u64 neutron_inference_key(struct neutron_inference *inf)
+{
+	return (u64)inf->args.buf_id << 32 | inf->args.microcode_offset;
+}
+
+/*
+ * In polling mode, sleep through most of the expected run time of the
+ * model and then poll with a period that is a fraction of it, so short
+ * jobs aren't quantized to a coarse period and long ones don't wake the
+ * CPU constantly.
+ */
+static bool neutron_inference_poll_start(struct neutron_inference *inf)
+{
+	struct neutron_inference_queue *queue = inf->ndev->queue;
+	u64 min = (u64)inf->ndev->poll_interval * NSEC_PER_USEC;
+	u64 avg = 0, period;
+
+	if (inf->cmd_type == NEUTRON_CMD_RUN_INFERENCE &&
+	    queue->run_key == neutron_inference_key(inf))
+		avg = queue->run_avg;
+
+	period = clamp_t(u64, avg / 16, min, max(min, NEUTRON_POLL_MAX_NS));
+	inf->poll_period = ns_to_ktime(period);
+
+	/* nothing known about this job, catch short ones early */
+	if (!avg)
+		return false;
+
+	hrtimer_start(&inf->poll_timer, ns_to_ktime(max(avg - avg / 8, min)),
+		      HRTIMER_MODE_REL);
+	return true;
+}
+
+static void neutron_inference_update_avg(struct neutron_inference *inf)
+{
+	struct neutron_inference_queue *queue = inf->ndev->queue;
+	u64 key = neutron_inference_key(inf);
+	u64 rt;
+
+	if (inf->cmd_type != NEUTRON_CMD_RUN_INFERENCE)
+		return;
+
+	rt = ktime_to_ns(inf->run_time);
+	if (queue->run_key != key || !queue->run_avg)
+		queue->run_avg = rt;
+	else
+		queue->run_avg = (queue->run_avg * 3 + rt) / 4;
+	queue->run_key = key;
+}
+
 static enum hrtimer_restart poll_result_callback(struct hrtimer *poll_timer)
 {
 	struct neutron_inference *inf =
@@ -80,59 +216,186 @@ static enum hrtimer_restart poll_result_callback(struct hrtimer *poll_timer)
 		return HRTIMER_NORESTART;
 	}
 	/* Reload timer */
-	hrtimer_forward_now(poll_timer, ns_to_ktime(100 * 1000));
+	hrtimer_forward_now(poll_timer, inf->poll_period);
 	return HRTIMER_RESTART;
 }
 
+/*
+ * Stage a job at submission, while the previous ones are still running,
+ * so only the register writes and the doorbell are left for submission.
+ */
+static int neutron_inference_prepare(struct neutron_inference *inf)
+{
+	struct neutron_device *ndev = inf->ndev;
+	struct neutron_mbox_tx_msg *msg = &inf->msg;
+	int ret;
+
+	/* Sync the input data for device before running inference job */
+	if (inf->ext_in) {
+		ret = neutron_inference_fence_ext(inf, inf->ext_in, false);
+		if (ret)
+			return ret;
+		neutron_sgt_sync(ndev, inf->ext_in->sgt, DMA_TO_DEVICE);
+	} else {
+		neutron_memory_sync(ndev, inf->buf->dma_addr + inf->args.input_offset,
+				    inf->args.input_size, DMA_TO_DEVICE);
+	}
+
+	if (inf->ext_out) {
+		ret = neutron_inference_fence_ext(inf, inf->ext_out, true);
+		if (ret)
+			return ret;
+	}
+
+	/* Run neutron inference */
+	if (inf->cmd_type == NEUTRON_CMD_RUN_INFERENCE) {
+		msg->command = RUN;
+		msg->args[0] = inf->args.tensor_offset;
+		msg->args[1] = inf->args.microcode_offset;
+		msg->args[2] = inf->args.tensor_count;
+		msg->argc = 3;
+
+	/* Load neutron kernel binary */
+	} else if (inf->cmd_type == NEUTRON_CMD_LOAD_KERNEL) {
+		msg->command = KERNELS;
+		msg->args[0] = inf->args.kernel_offset;
+		msg->argc = 1;
+	/* Clear log */
+	} else if (inf->cmd_type == NEUTRON_CMD_CLEAR_LOG) {
+		msg->command = CLEAR_FW_LOG;
+		msg->argc = 0;
+	} else {
+		dev_err(ndev->dev, "unkonw inference type: %d\n", inf->cmd_type);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void neutron_inference_setup(struct neutron_inference *inf)
+{
+	void __iomem *base = inf->ndev->reg_base;
+
+	neu_dbg("job %x is started, base_ddr %llx\n",
+		inf->args.tensor_offset, (__u64)inf->args.base_ddr_h << 32 | inf->args.base_ddr_l);
+
+	/* set BASEDDR address */
+	writel(inf->args.base_ddr_l, base + BASEDDRL);
+	writel(inf->args.base_ddr_l, base + BASEINOUTL);
+	writel(inf->args.base_ddr_l, base + BASESPILLL);
+
+	writel(inf->args.base_ddr_h, base + BASEDDRH);
+	writel(inf->args.base_ddr_h, base + BASEINOUTH);
+	writel(inf->args.base_ddr_h, base + BASESPILLH);
+}
+
+/* Must be called with the queue lock held */
+static struct neutron_inference *neutron_inference_claim(struct neutron_inference_queue *queue)
+{
+	struct neutron_inference *inf;
+
+	if (queue->cur_inf)
+		return NULL;
+
+	inf = list_first_entry_or_null(&queue->head, struct neutron_inference, node);
+	queue->cur_inf = inf;
+
+	return inf;
+}
+
+/* Must be called with the queue lock held, the job must be the current one */
+static void neutron_inference_retire(struct neutron_inference_queue *queue,
+				     struct neutron_inference *inf)
+{
+	queue->cur_inf = NULL;
+	neutron_inference_del_list(queue, inf);
+	list_add_tail(&inf->node, &queue->done);
+}
+
+/*
+ * Submit a prepared job right after the previous one completed, from
+ * the completion IRQ or the poll timer. Jobs that need a firmware reload
+ * or fail to submit are left to neutron_inference_run().
+ *
+ * Must be called with the queue lock held.
+ */
+static bool neutron_inference_kick(struct neutron_inference *inf)
+{
+	struct neutron_device *ndev = inf->ndev;
+	struct neutron_mbox *mbox = ndev->mbox;
+
+	if (inf->status != NEUTRON_UAPI_STATUS_PENDING ||
+	    ndev->firmw_id != inf->args.firmw_id)
+		return false;
+
+	/* Get neutron out of the done state of the previous job */
+	if (mbox->ops->send_reset_atomic(mbox))
+		return false;
+
+	neutron_inference_setup(inf);
+
+	inf->status = NEUTRON_UAPI_STATUS_RUNNING;
+	inf->run_start = ktime_get();
+	if (mbox->ops->send_data_atomic(mbox, &inf->msg)) {
+		inf->status = NEUTRON_UAPI_STATUS_PENDING;
+		return false;
+	}
+	ndev->queue->cur_inf = inf;
+
+	if (inf->poll_mode && !neutron_inference_poll_start(inf))
+		hrtimer_start(&inf->poll_timer, inf->poll_period, HRTIMER_MODE_REL);
+
+	return true;
+}
+
+static void neutron_inference_fail(struct neutron_inference *inf)
+{
+	struct neutron_inference_queue *queue = inf->ndev->queue;
+
+	spin_lock_irq(&queue->lock);
+	inf->status = NEUTRON_UAPI_STATUS_ERROR;
+	neutron_inference_retire(queue, inf);
+	spin_unlock_irq(&queue->lock);
+
+	queue_work(queue->wq, &queue->work);
+}
+
+/* Submit the current job from process context */
 static int neutron_inference_run(struct neutron_inference *inf)
 {
 	struct neutron_device *ndev;
-	struct neutron_mbox_tx_msg msg;
+	struct neutron_inference_queue *queue;
 	u32 i, val;
 	int ret = 0;
 
-	if (!inf || IS_ERR(inf))
-		return PTR_ERR(inf);
-
-	if (!inf->ndev || IS_ERR(inf->ndev))
-		return PTR_ERR(inf);
-
-	/* The job have been done */
-	if (inf->status == NEUTRON_UAPI_STATUS_DONE)
-		return 0;
-
 	ndev = inf->ndev;
+	queue = ndev->queue;
+
+	if (inf->status == NEUTRON_UAPI_STATUS_ERROR) {
+		ret = -EINVAL;
+		goto inf_stop_early;
+	}
 
 	if (ndev->power_mode >= POWER_MODE_LOW)
 		neutron_clk_enable(ndev);
 
-	/* Sync the input data for device before running inference job */
-	neutron_memory_sync(ndev, inf->buf->dma_addr + inf->args.input_offset,
-			    inf->args.input_size, DMA_TO_DEVICE);
-
 	// reload only when firmware was changed
 	if (ndev->firmw_id  != inf->args.firmw_id) {
 		mutex_lock(&ndev->mutex);
-		ret = neutron_firmw_reload(ndev, inf->buf);
+		ret = neutron_firmw_switch(ndev, inf->buf, inf->args.firmw_id);
 		if (ret) {
-			inf->status = NEUTRON_UAPI_STATUS_ERROR;
 			mutex_unlock(&ndev->mutex);
 			goto inf_stop_early;
 		}
 		ndev->firmw_id = inf->args.firmw_id;
 		mutex_unlock(&ndev->mutex);
-		dev_dbg(ndev->dev, "Inference firmw_reload: %x\n", inf->args.firmw_id);
+		dev_dbg(ndev->dev, "Inference firmw_switch: %x\n", inf->args.firmw_id);
 	}
 
-	spin_lock_bh(&ndev->queue->lock);
-	ndev->queue->cur_inf = inf;
-	inf->status = NEUTRON_UAPI_STATUS_RUNNING;
-	spin_unlock_bh(&ndev->queue->lock);
-
-	ndev = inf->ndev;
-
-	neu_dbg("job %x is started, base_ddr %llx\n",
-		inf->args.tensor_offset, (__u64)inf->args.base_ddr_h << 32 | inf->args.base_ddr_l);
+	/* Get neutron out of the done state of the previous job */
+	if (ndev->mbox->ops->read_ret(ndev->mbox) == DONE &&
+	    ndev->mbox->ops->send_reset(ndev->mbox))
+		dev_warn(ndev->dev, "failed to reset neutron state\n");
 
 	/* Do reset when neutron is stuck.
 	 * If the previous inference job is done, the ACK register will be set to RESET_VAL.
@@ -147,44 +410,16 @@ static int neutron_inference_run(struct neutron_inference *inf)
 		mutex_unlock(&ndev->mutex);
 	}
 
-	/* set BASEDDR address */
-	writel(inf->args.base_ddr_l, inf->ndev->reg_base + BASEDDRL);
-	writel(inf->args.base_ddr_l, inf->ndev->reg_base + BASEINOUTL);
-	writel(inf->args.base_ddr_l, inf->ndev->reg_base + BASESPILLL);
+	neutron_inference_setup(inf);
 
-	writel(inf->args.base_ddr_h, inf->ndev->reg_base + BASEDDRH);
-	writel(inf->args.base_ddr_h, inf->ndev->reg_base + BASEINOUTH);
-	writel(inf->args.base_ddr_h, inf->ndev->reg_base + BASESPILLH);
-
-	/* Run neutron inference */
-	if (inf->cmd_type == NEUTRON_CMD_RUN_INFERENCE) {
-		neu_dbg("run inference\n");
-		msg.command = RUN;
-		msg.args[0] = inf->args.tensor_offset;
-		msg.args[1] = inf->args.microcode_offset;
-		msg.args[2] = inf->args.tensor_count;
-		msg.argc = 3;
-
-	/* Load neutron kernel binary */
-	} else if (inf->cmd_type == NEUTRON_CMD_LOAD_KERNEL) {
-		neu_dbg("load kernel\n");
-		msg.command = KERNELS;
-		msg.args[0] = inf->args.kernel_offset;
-		msg.argc = 1;
-	/* Clear log */
-	} else if (inf->cmd_type == NEUTRON_CMD_CLEAR_LOG) {
-		msg.command = CLEAR_FW_LOG;
-		msg.argc = 0;
-	} else {
-		inf->status = NEUTRON_UAPI_STATUS_ERROR;
-		ret = -EINVAL;
-		dev_err(ndev->dev, "unkonw inference type: %d\n", inf->cmd_type);
-		goto inf_stop_early;
-	}
+	spin_lock_irq(&queue->lock);
+	inf->status = NEUTRON_UAPI_STATUS_RUNNING;
+	inf->run_start = ktime_get();
+	spin_unlock_irq(&queue->lock);
 
 	mutex_lock(&ndev->mutex);
 	for (int i = 0; i < 3; i++) {
-		ret = ndev->mbox->ops->send_data(ndev->mbox, &msg);
+		ret = ndev->mbox->ops->send_data(ndev->mbox, &inf->msg);
 		if (ret == 0)
 			break;
 		neutron_hw_reset(ndev);
@@ -194,35 +429,64 @@ static int neutron_inference_run(struct neutron_inference *inf)
 	mutex_unlock(&ndev->mutex);
 
 	if (ret < 0) {
-		inf->status = NEUTRON_UAPI_STATUS_ERROR;
 		dev_err(ndev->dev, "failed to send mbox_message\n");
 		goto inf_stop_early;
 	}
 
-	if (inf->poll_mode) {
+	if (inf->poll_mode && !neutron_inference_poll_start(inf)) {
 		/* Loop state before setting timer to get result early */
 		for (i = 0; i < 100; i++) {
 			val = ndev->mbox->ops->read_ret(ndev->mbox);
 			/* Call inference_done_callback if it is done status */
-			if (val == DONE)
-				goto inf_stop_early;
+			if (val == DONE) {
+				neutron_inference_done(ndev);
+				return 0;
+			}
 			usleep_range(10, 20);
 		}
 		/* Start timer to continue poll status if it's not done yet */
-		hrtimer_start(&inf->poll_timer, ns_to_ktime(100 * 1000), HRTIMER_MODE_REL);
-	};
+		hrtimer_start(&inf->poll_timer, inf->poll_period, HRTIMER_MODE_REL);
+	}
 
 	return 0;
 
 inf_stop_early:
-	neutron_inference_done(ndev);
+	neutron_inference_fail(inf);
 	return ret;
 }
 
 int neutron_inference_done(struct neutron_device *ndev)
 {
-	if (ndev->queue->wq)
-		queue_work(ndev->queue->wq, &ndev->queue->work);
+	struct neutron_inference_queue *queue = ndev->queue;
+	struct neutron_mbox_rx_msg rx_msg;
+	struct neutron_inference *inf, *next;
+	unsigned long flags;
+
+	spin_lock_irqsave(&queue->lock, flags);
+	inf = queue->cur_inf;
+
+	/* Spurious, the DONE state of the previous job wasn't reset yet */
+	if (!inf || inf->status != NEUTRON_UAPI_STATUS_RUNNING) {
+		spin_unlock_irqrestore(&queue->lock, flags);
+		return 0;
+	}
+
+	inf->run_time = ktime_sub(ktime_get(), inf->run_start);
+
+	/* Latch the return code, the next job reuses the mailbox */
+	ndev->mbox->ops->recv_data(ndev->mbox, &rx_msg);
+	inf->error_code = rx_msg.args[0];
+
+	neutron_inference_retire(queue, inf);
+
+	/* Keep neutron busy, the next job was staged at submission */
+	next = list_first_entry_or_null(&queue->head, struct neutron_inference, node);
+	if (next && neutron_inference_kick(next))
+		neu_dbg("next %x\n", next->args.tensor_offset);
+	spin_unlock_irqrestore(&queue->lock, flags);
+
+	if (queue->wq)
+		queue_work(queue->wq, &queue->work);
 
 	return 0;
 }
@@ -230,39 +494,25 @@ int neutron_inference_done(struct neutron_device *ndev)
 static void inference_inqueue(struct neutron_inference_queue *queue,
 			      struct neutron_inference *inf)
 {
-	int queue_count;
-
-	spin_lock_bh(&queue->lock);
-	queue_count = queue->queue_count++;
-	list_add_tail(&inf->node, &queue->head);
-	inf->status = NEUTRON_UAPI_STATUS_PENDING;
-	spin_unlock_bh(&queue->lock);
+	struct neutron_inference *next;
 
-	/* Start inference directly if there are no jobs in queue */
-	if (queue_count == 0)
-		neutron_inference_run(inf);
-}
+	if (neutron_inference_prepare(inf))
+		inf->status = NEUTRON_UAPI_STATUS_ERROR;
+	else
+		inf->status = NEUTRON_UAPI_STATUS_PENDING;
 
-static struct neutron_inference *inference_dequeue(struct neutron_inference_queue *queue,
-						   struct neutron_inference *inf)
-{
-	struct neutron_inference *next_inf;
-	int queue_count;
+	/* The queue holds a reference until the job is completed */
+	neutron_inference_get(inf);
 
-	spin_lock_bh(&queue->lock);
-	/* Get next element before delete it */
-	next_inf = list_next_entry(inf, node);
-	neutron_inference_del_list(queue, inf);
-	queue->cur_inf = NULL;
-	queue_count = queue->queue_count;
-	spin_unlock_bh(&queue->lock);
+	spin_lock_irq(&queue->lock);
+	queue->queue_count++;
+	list_add_tail(&inf->node, &queue->head);
+	next = neutron_inference_claim(queue);
+	spin_unlock_irq(&queue->lock);
 
-	/* There are jobs left in queue list */
-	if (queue_count > 0) {
-		neu_dbg("next %x\n", next_inf->args.tensor_offset);
-		return next_inf;
-	}
-	return NULL;
+	/* Start inference directly if there are no jobs running */
+	if (next)
+		neutron_inference_run(next);
 }
 
 static void inference_done_callback(struct work_struct *work)
@@ -271,56 +521,60 @@ static void inference_done_callback(struct work_struct *work)
 		container_of(work, struct neutron_inference_queue, work);
 
 	struct neutron_inference *inf, *next_inf;
-	struct neutron_device *ndev;
-	struct neutron_mbox *mbox;
-
-	spin_lock_bh(&queue->lock);
-	inf = queue->cur_inf;
-	spin_unlock_bh(&queue->lock);
-
-	if (!inf || IS_ERR(inf))
-		return;
-
-	if (!kref_read(&inf->kref))
-		return;
+	struct neutron_device *ndev = queue->ndev;
 
-	neutron_inference_get(inf);
+	pm_runtime_get_sync(ndev->dev);
 
-	/* Update inference job from running to done */
-	if (inf->status == NEUTRON_UAPI_STATUS_RUNNING)
-		inf->status = NEUTRON_UAPI_STATUS_DONE;
+	for (;;) {
+		spin_lock_irq(&queue->lock);
+		inf = list_first_entry_or_null(&queue->done, struct neutron_inference, node);
+		if (inf)
+			list_del_init(&inf->node);
+		spin_unlock_irq(&queue->lock);
 
-	ndev = inf->ndev;
-	mbox = ndev->mbox;
-
-	pm_runtime_get_sync(ndev->dev);
+		if (!inf)
+			break;
 
-	/* Sync the output data for cpu after inference is done */
-	neutron_memory_sync(ndev, inf->buf->dma_addr + inf->args.output_offset,
-			    inf->args.output_size, DMA_FROM_DEVICE);
+		/* Update inference job from running to done */
+		if (inf->status == NEUTRON_UAPI_STATUS_RUNNING) {
+			inf->status = NEUTRON_UAPI_STATUS_DONE;
+			neutron_inference_update_avg(inf);
+		}
 
-	/* Wake up the waiting process */
-	wake_up_interruptible(&inf->waitq);
+		/* Sync the output data for cpu after inference is done */
+		if (inf->ext_out)
+			neutron_sgt_sync(ndev, inf->ext_out->sgt, DMA_FROM_DEVICE);
+		else
+			neutron_memory_sync(ndev, inf->buf->dma_addr + inf->args.output_offset,
+					    inf->args.output_size, DMA_FROM_DEVICE);
+
+		/* Let the other users of the imported buffers go on */
+		if (inf->fence) {
+			if (inf->status != NEUTRON_UAPI_STATUS_DONE)
+				dma_fence_set_error(inf->fence, -EIO);
+			dma_fence_signal(inf->fence);
+		}
 
-	/* Reset neutron */
-	if (mbox->ops->send_reset(ndev->mbox))
-		dev_warn(ndev->dev, "failed to reset neutron state\n");
+		/* Wake up the waiting process */
+		wake_up_interruptible(&inf->waitq);
 
-	dev_dbg(ndev->dev, "inf %x is done\n", inf->args.tensor_offset);
+		dev_dbg(ndev->dev, "inf %x is done\n", inf->args.tensor_offset);
 
-	/* Only dequeue a new job when the previous one is completed,
-	 * allowing only 1 job to run at a time.
-	 */
-	next_inf = inference_dequeue(ndev->queue, inf);
-	neutron_inference_put(inf);
+		neutron_inference_put(inf);
+	}
 
-	if (next_inf)
-		neutron_inference_run(next_inf);
+	/* Start the next job if it couldn't be submitted on completion */
+	spin_lock_irq(&queue->lock);
+	next_inf = neutron_inference_claim(queue);
 	/* In low power mode, if there are no new inferences
 	 * the clock should be gated.
 	 */
-	else if (ndev->power_mode >= POWER_MODE_LOW)
+	if (!queue->cur_inf && ndev->power_mode >= POWER_MODE_LOW)
 		neutron_clk_disable(ndev);
+	spin_unlock_irq(&queue->lock);
+
+	if (next_inf)
+		neutron_inference_run(next_inf);
 
 	pm_runtime_put_sync(ndev->dev);
 }
@@ -330,25 +584,21 @@ static void neutron_inference_kref_destroy(struct kref *kref)
 	struct neutron_inference *inf =
 		container_of(kref, struct neutron_inference, kref);
 
-	struct neutron_inference *del_inf, *_del_inf;
-
 	dev_dbg(inf->ndev->dev,
 		"inference %x destroy status: %x\n",
 		inf->args.tensor_offset, inf->status);
 
-	/* Delete entry if inference is not scheduled */
-	spin_lock_bh(&inf->ndev->queue->lock);
-	list_for_each_entry_safe(del_inf, _del_inf, &inf->ndev->queue->head, node) {
-		if (del_inf == inf) {
-			neutron_inference_del_list(inf->ndev->queue, inf);
-			break;
-		}
-	}
-	spin_unlock_bh(&inf->ndev->queue->lock);
-
+	/* The queue holds a reference, so the job is not queued anymore */
 	if (inf->poll_mode)
 		hrtimer_cancel(&inf->poll_timer);
 
+	if (inf->fence)
+		dma_fence_put(inf->fence);
+	if (inf->ext_in)
+		neutron_buffer_put(inf->ext_in);
+	if (inf->ext_out)
+		neutron_buffer_put(inf->ext_out);
+
 	devm_kfree(inf->ndev->dev, inf);
 }
 
@@ -393,7 +643,6 @@ static long neutron_inference_ioctl(struct file *file,
 	struct neutron_device *ndev;
 	int ret = -EINVAL;
 	struct neutron_uapi_result_status uapi;
-	struct neutron_mbox_rx_msg rx_msg;
 
 	if (!inf || IS_ERR(inf))
 		return ret;
@@ -408,11 +657,9 @@ static long neutron_inference_ioctl(struct file *file,
 		uapi.status = inf->status;
 		uapi.error_code = 0;
 
-		/* Read firmware return code if the job is done */
-		if (inf->status == NEUTRON_UAPI_STATUS_DONE) {
-			ndev->mbox->ops->recv_data(ndev->mbox, &rx_msg);
-			uapi.error_code = rx_msg.args[0];
-		}
+		/* Firmware return code latched when the job was done */
+		if (inf->status == NEUTRON_UAPI_STATUS_DONE)
+			uapi.error_code = inf->error_code;
 
 		if (copy_to_user(udata, &uapi, sizeof(uapi)))
 			break;
@@ -458,11 +705,37 @@ int neutron_inference_create(struct neutron_device *ndev, enum neutron_cmd_type
 
 	memcpy(&inf->args, uapi, sizeof(struct neutron_uapi_inference_args));
 
+	if (uapi->flags & NEUTRON_INFERENCE_EXT_INPUT) {
+		inf->ext_in = neutron_inference_get_ext(uapi->ext_input_fd);
+		if (IS_ERR(inf->ext_in)) {
+			ret = PTR_ERR(inf->ext_in);
+			inf->ext_in = NULL;
+			goto put_ext;
+		}
+	}
+
+	if (uapi->flags & NEUTRON_INFERENCE_EXT_OUTPUT) {
+		inf->ext_out = neutron_inference_get_ext(uapi->ext_output_fd);
+		if (IS_ERR(inf->ext_out)) {
+			ret = PTR_ERR(inf->ext_out);
+			inf->ext_out = NULL;
+			goto put_ext;
+		}
+	}
+
+	if (inf->ext_in || inf->ext_out) {
+		inf->fence = neutron_fence_create();
+		if (!inf->fence) {
+			ret = -ENOMEM;
+			goto put_ext;
+		}
+	}
+
 	/* Create file descriptor */
 	ret = anon_inode_getfd("neutron-inference", &neutron_inference_fops,
 			       inf, O_RDWR | O_CLOEXEC);
 	if (ret < 0)
-		goto kfree_inference;
+		goto put_ext;
 
 	inf->buf = neutron_buffer_get_from_fd(inf->args.buf_id);
 
@@ -478,7 +751,13 @@ int neutron_inference_create(struct neutron_device *ndev, enum neutron_cmd_type
 
 	return ret;
 
-kfree_inference:
+put_ext:
+	if (inf->fence)
+		dma_fence_put(inf->fence);
+	if (inf->ext_in)
+		neutron_buffer_put(inf->ext_in);
+	if (inf->ext_out)
+		neutron_buffer_put(inf->ext_out);
 	devm_kfree(ndev->dev, inf);
 
 	return ret;
@@ -513,6 +792,7 @@ struct neutron_inference_queue *neutron_queue_create(struct neutron_device *ndev
 	}
 
 	INIT_LIST_HEAD(&queue->head);
+	INIT_LIST_HEAD(&queue->done);
 	INIT_WORK(&queue->work, inference_done_callback);
 
 	return queue;
@@ -11,8 +11,10 @@
  ****************************************************************************/
 
 #include "uapi/neutron.h"
+#include "neutron_mailbox.h"
 
 #include <linux/kref.h>
+#include <linux/ktime.h>
 #include <linux/types.h>
 #include <linux/wait.h>
 #include <linux/spinlock.h>
@@ -25,6 +27,7 @@ struct neutron_device;
 struct neutron_buffer;
 struct neutron_uapi_inference_args;
 struct file;
+struct dma_fence;
 
 enum neutron_cmd_type {
 	NEUTRON_CMD_RESET_STATUS,
@@ -46,6 +49,14 @@ enum neutron_cmd_type {
  * @inf_arg:			Inference arguments
  * @poll_mode:			Whether use polling mode to read inference result
  * @poll_timer:			Poll timer to check inference status
+ * @poll_period:		Period of @poll_timer
+ * @msg:			Mailbox message staged at submission
+ * @run_start:			Time the job was submitted to neutron
+ * @run_time:			Run time of the job on neutron
+ * @error_code:			Firmware return code of the job
+ * @ext_in:			Imported buffer used as input, or NULL
+ * @ext_out:			Imported buffer used as output, or NULL
+ * @fence:			Signaled on completion, fences @ext_in and @ext_out
  */
 struct neutron_inference {
 	struct neutron_device    *ndev;
@@ -57,7 +68,15 @@ struct neutron_inference {
 	struct list_head         node;
 	bool                     poll_mode;
 	struct hrtimer           poll_timer;
+	ktime_t                  poll_period;
 	unsigned int             poll_count;
+	struct neutron_mbox_tx_msg msg;
+	ktime_t                  run_start;
+	ktime_t                  run_time;
+	u32                      error_code;
+	struct neutron_buffer    *ext_in;
+	struct neutron_buffer    *ext_out;
+	struct dma_fence         *fence;
 	enum   neutron_cmd_type  cmd_type;
 	struct neutron_uapi_inference_args  args;
 };
@@ -65,11 +84,14 @@ struct neutron_inference {
 /**
  * struct neutron_inference_queue - Inference queue
  * @ndev:			Neutron device
- * @head:			List header
+ * @head:			List of pending jobs and the running one
+ * @done:			List of completed jobs to be finished by @work
  * @queue_count:		Inference queue element count
  * @cur_inf:			Point to current inference instance
  * @wq:				Inference singlethread workqueue
- * @lock:			A spin_lock to protect list data
+ * @lock:			A spin_lock to protect list data, taken from IRQ context
+ * @run_key:			Model of the last inference job
+ * @run_avg:			Average run time of @run_key in ns
  */
 
 struct neutron_inference_queue {
@@ -78,6 +100,8 @@ struct neutron_inference_queue {
 	unsigned int             queue_count;
 	/* inference list head */
 	struct list_head         head;
+	/* completed inferences */
+	struct list_head         done;
 	/* current inference job */
 	struct neutron_inference *cur_inf;
 	/* singlethread_workqueue */
@@ -85,6 +109,9 @@ struct neutron_inference_queue {
 	struct work_struct       work;
 	/* protects the list add/modify/delete */
 	spinlock_t               lock;
+	/* run time estimate for polling mode */
+	u64                      run_key;
+	u64                      run_avg;
 };
 
 /****************************************************************************
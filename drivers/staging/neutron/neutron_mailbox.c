@@ -69,15 +69,16 @@ static bool mbox_tx_done(struct neutron_mbox *mbox)
 		return false;
 }
 
-/**
- * mbox_send_data - Send mailbox data.
- *
- * @mbox: neutron_mbox pointer
- * @data: data to be sent
- *
- * Return: 0 is success, else fail.
- */
-static int mbox_send_data(struct neutron_mbox *mbox, void *data)
+/* Busy wait in atomic context, sleep otherwise */
+static void mbox_delay(bool atomic, unsigned long min, unsigned long max)
+{
+	if (atomic)
+		udelay(min);
+	else
+		usleep_range(min, max);
+}
+
+static int __mbox_send_data(struct neutron_mbox *mbox, void *data, bool atomic)
 {
 	struct neutron_mbox_tx_msg *msg = data;
 	int i;
@@ -106,7 +107,7 @@ static int mbox_send_data(struct neutron_mbox *mbox, void *data)
 		/* return success if tx is done */
 		if (mbox_tx_done(mbox))
 			return 0;
-		usleep_range(1, 10);
+		mbox_delay(atomic, 1, 10);
 	}
 
 	/* Timeout */
@@ -115,12 +116,32 @@ static int mbox_send_data(struct neutron_mbox *mbox, void *data)
 }
 
 /**
- * mbox_send_reset - Send command to reset neutron state
+ * mbox_send_data - Send mailbox data.
  *
- * Return: 0 is successful, else fail.
+ * @mbox: neutron_mbox pointer
+ * @data: data to be sent
+ *
+ * Return: 0 is success, else fail.
  */
+static int mbox_send_data(struct neutron_mbox *mbox, void *data)
+{
+	return __mbox_send_data(mbox, data, false);
+}
 
-static int mbox_send_reset(struct neutron_mbox *mbox)
+/**
+ * mbox_send_data_atomic - Send mailbox data without sleeping.
+ *
+ * @mbox: neutron_mbox pointer
+ * @data: data to be sent
+ *
+ * Return: 0 is success, else fail.
+ */
+static int mbox_send_data_atomic(struct neutron_mbox *mbox, void *data)
+{
+	return __mbox_send_data(mbox, data, true);
+}
+
+static int __mbox_send_reset(struct neutron_mbox *mbox, bool atomic)
 {
 	u32 i, val;
 
@@ -128,12 +149,12 @@ static int mbox_send_reset(struct neutron_mbox *mbox)
 	writel(RESET_VAL, mbox->base + MBOX5);
 	writel(RESET, mbox->base + MBOX3);
 
-	usleep_range(2, 5);
+	mbox_delay(atomic, 2, 5);
 	/* Wait for neutron to get into reset */
 	for (i = 0; i < 50; i++) {
 		val = readl(mbox->base + MBOX0);
 		if (val != RESET_VAL)
-			usleep_range(2, 10);
+			mbox_delay(atomic, 2, 10);
 		else
 			return 0;
 	}
@@ -141,6 +162,27 @@ static int mbox_send_reset(struct neutron_mbox *mbox)
 	return val;
 }
 
+/**
+ * mbox_send_reset - Send command to reset neutron state
+ *
+ * Return: 0 is successful, else fail.
+ */
+
+static int mbox_send_reset(struct neutron_mbox *mbox)
+{
+	return __mbox_send_reset(mbox, false);
+}
+
+/**
+ * mbox_send_reset_atomic - Reset neutron state without sleeping
+ *
+ * Return: 0 is successful, else fail.
+ */
+static int mbox_send_reset_atomic(struct neutron_mbox *mbox)
+{
+	return __mbox_send_reset(mbox, true);
+}
+
 /**
  * mbox_recv_data - Recevie mailbox data and store into data.
  *
@@ -171,7 +213,9 @@ static int mbox_recv_data(struct neutron_mbox *mbox, void *data)
 
 static const struct neutron_mbox_ops neutron_mbox_ops = {
 	.send_data	= mbox_send_data,
+	.send_data_atomic = mbox_send_data_atomic,
 	.send_reset	= mbox_send_reset,
+	.send_reset_atomic = mbox_send_reset_atomic,
 	.recv_data	= mbox_recv_data,
 	.read_ret	= mbox_read_ret,
 	.tx_done	= mbox_tx_done,
@@ -36,10 +36,14 @@ struct neutron_mbox {
 struct neutron_mbox_ops {
 	/* Send data to neutron */
 	int (*send_data)(struct neutron_mbox *mbox, void *data);
+	/* Send data to neutron, callable from atomic context */
+	int (*send_data_atomic)(struct neutron_mbox *mbox, void *data);
 	/* Receive data from neutron */
 	int (*recv_data)(struct neutron_mbox *mbox, void *data);
 	/* Send reset command to neutron */
 	int (*send_reset)(struct neutron_mbox *mbox);
+	/* Send reset command to neutron, callable from atomic context */
+	int (*send_reset_atomic)(struct neutron_mbox *mbox);
 	/* Read return value */
 	unsigned int (*read_ret)(struct neutron_mbox *mbox);
 	/* Test whether tx is successful */
@@ -46,6 +46,12 @@ namespace Neutron {
 						    struct neutron_uapi_firmware_load)
 #define NEUTRON_IOCTL_CACHE_SYNC	NEUTRON_IOW(0x0d, \
 						    struct neutron_uapi_cache_sync)
+#define NEUTRON_IOCTL_BUFFER_IMPORT	NEUTRON_IOWR(0x0e, \
+						     struct neutron_uapi_buffer_import)
+
+/* Flags of struct neutron_uapi_inference_args */
+#define NEUTRON_INFERENCE_EXT_INPUT	(1 << 0)
+#define NEUTRON_INFERENCE_EXT_OUTPUT	(1 << 1)
 /****************************************************************************
  * Types
  ****************************************************************************/
@@ -118,6 +124,21 @@ struct neutron_uapi_buffer_create {
 	__u64 addr;
 };
 
+/**
+ * struct neutron_uapi_buffer_import - Import dma-buf request
+ * @fd:     The dma-buf file descriptor, must be DMA contiguous for neutron
+ * @size:   Size of the buffer
+ * @addr:   Dma addr of the buffer
+ *
+ * Returns a neutron buffer fd which can be given to an inference as
+ * external input or output.
+ */
+struct neutron_uapi_buffer_import {
+	__s32 fd;
+	__u32 size;
+	__u64 addr;
+};
+
 /**
  * struct neutron_uapi_inference_args - Job creation struct
  * @args:              Union parameters
@@ -130,6 +151,11 @@ struct neutron_uapi_buffer_create {
  * @input_size:        Size of input data.
  * @output_offset:     Offset address for output data.
  * @output_size:       Size of output data.
+ * @flags:             NEUTRON_INFERENCE_* flags.
+ * @ext_input_fd:      Imported buffer used as input with NEUTRON_INFERENCE_EXT_INPUT,
+ *                     @input_offset and @input_size are ignored then.
+ * @ext_output_fd:     Imported buffer used as output with NEUTRON_INFERENCE_EXT_OUTPUT,
+ *                     @output_offset and @output_size are ignored then.
  * @reserve:           Reserve for future.
  */
 struct neutron_uapi_inference_args {
@@ -157,7 +183,10 @@ struct neutron_uapi_inference_args {
 	__u32 input_size;
 	__u32 output_offset;
 	__u32 output_size;
-	__u32 reserve[5];
+	__u32 flags;
+	__s32 ext_input_fd;
+	__s32 ext_output_fd;
+	__u32 reserve[2];
 };
 
 #ifdef __cplusplus
@@ -617,7 +617,8 @@ __cpufreq_cooling_register(struct device_node *np,
  *
  * This interface function registers the cpufreq cooling device with the name
  * "cpufreq-%s". This API can support multiple instances of cpufreq cooling
- * devices.
+ * devices. If an energy model is registered for the policy CPUs, the
+ * cooling device implements the power APIs as well.
  *
  * Return: a valid struct thermal_cooling_device pointer on success,
  * on failure, it returns a corresponding ERR_PTR().
@@ -625,7 +626,7 @@ __cpufreq_cooling_register(struct device_node *np,
 struct thermal_cooling_device *
 cpufreq_cooling_register(struct cpufreq_policy *policy)
 {
-	return __cpufreq_cooling_register(NULL, policy, NULL);
+	return __cpufreq_cooling_register(NULL, policy, em_cpu_get(policy->cpu));
 }
 EXPORT_SYMBOL_GPL(cpufreq_cooling_register);
 
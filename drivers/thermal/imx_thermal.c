@@ -6,6 +6,7 @@
 #include <linux/cpufreq.h>
 #include <linux/cpu_cooling.h>
 #include <linux/delay.h>
+#include <linux/energy_model.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/mfd/syscon.h>
@@ -80,6 +81,8 @@ enum imx_thermal_trip {
 
 #define IMX_POLLING_DELAY		2000 /* millisecond */
 #define IMX_PASSIVE_DELAY		1000
+/* the power allocator needs a short control period to avoid overshoot */
+#define IMX_IPA_PASSIVE_DELAY		100
 
 #define TEMPMON_IMX6Q			1
 #define TEMPMON_IMX6SX			2
@@ -592,9 +595,29 @@ static inline void imx_thermal_unregister_legacy_cooling(struct imx_thermal_data
 }
 #endif
 
+static const struct thermal_zone_params imx_ipa_params = {
+	.governor_name = "power_allocator",
+};
+
+/*
+ * Step-wise throttling walks the cpufreq cooling states one by one around
+ * the passive trip and keeps oscillating. When the CPUs have an energy
+ * model, the CPU cooling device exposes power and the power allocator can
+ * converge on the sustainable OPP instead.
+ */
+static bool imx_thermal_use_ipa(struct imx_thermal_data *data)
+{
+	if (!IS_ENABLED(CONFIG_THERMAL_GOV_POWER_ALLOCATOR) || !data->policy)
+		return false;
+
+	return em_cpu_get(data->policy->cpu);
+}
+
 static int imx_thermal_probe(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
+	const struct thermal_zone_params *tzp = NULL;
+	int passive_delay = IMX_PASSIVE_DELAY;
 	struct imx_thermal_data *data;
 	struct regmap *map;
 	int measure_freq;
@@ -689,12 +712,17 @@ static int imx_thermal_probe(struct platform_device *pdev)
 		goto legacy_cleanup;
 	}
 
+	if (imx_thermal_use_ipa(data)) {
+		tzp = &imx_ipa_params;
+		passive_delay = IMX_IPA_PASSIVE_DELAY;
+	}
+
 	data->tz = thermal_zone_device_register_with_trips("imx_thermal_zone",
 							   trips,
 							   ARRAY_SIZE(trips),
 							   data,
-							   &imx_tz_ops, NULL,
-							   IMX_PASSIVE_DELAY,
+							   &imx_tz_ops, tzp,
+							   passive_delay,
 							   IMX_POLLING_DELAY);
 	if (IS_ERR(data->tz)) {
 		ret = PTR_ERR(data->tz);
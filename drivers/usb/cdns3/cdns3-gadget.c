@@ -73,8 +73,17 @@ static int __cdns3_gadget_ep_queue(struct usb_ep *ep,
 				   struct usb_request *request,
 				   gfp_t gfp_flags);
 
+/* cdns3_ep_run_transfer() flags, used when several requests are batched */
+#define CDNS3_XFER_NO_DRDY	BIT(0)	/* a later request rings the doorbell */
+#define CDNS3_XFER_NO_IOC	BIT(1)	/* a later request interrupts */
+
+/* Max number of consecutive IN requests left without interrupt */
+#define CDNS3_IOC_COALESCE_MAX	8
+
 static int cdns3_ep_run_transfer(struct cdns3_endpoint *priv_ep,
-				 struct usb_request *request);
+				 struct usb_request *request, u32 flags);
+
+static void cdns3_ep_ring_drdy(struct cdns3_endpoint *priv_ep);
 
 static int cdns3_ep_run_stream_transfer(struct cdns3_endpoint *priv_ep,
 					struct usb_request *request);
@@ -373,20 +382,56 @@ enum usb_device_speed cdns3_get_speed(struct cdns3_device *priv_dev)
 	return USB_SPEED_UNKNOWN;
 }
 
+/**
+ * cdns3_ep_can_batch - check whether @next can share a doorbell with @request
+ * @priv_ep: endpoint object
+ * @request: request about to be added to ring
+ * @next: request following @request on deferred list
+ *
+ * Batching is only done when both requests are known to fit in the ring
+ * in front of the LINK TRB, so cdns3_ep_run_transfer() can't fail for
+ * @next and leave @request without doorbell or interrupt.
+ */
+static bool cdns3_ep_can_batch(struct cdns3_endpoint *priv_ep,
+			       struct usb_request *request,
+			       struct usb_request *next)
+{
+	struct cdns3_device *priv_dev = priv_ep->cdns3_dev;
+	int num_trb;
+
+	if (priv_dev->dev_ver <= DEV_VER_V2 || priv_ep->use_streams ||
+	    priv_ep->type == USB_ENDPOINT_XFER_ISOC ||
+	    (priv_ep->flags & EP_TDLCHK_EN) || next->stream_id ||
+	    TRBS_PER_SEGMENT == 2)
+		return false;
+
+	num_trb = (request->num_mapped_sgs ?: 1) + (next->num_mapped_sgs ?: 1);
+
+	return priv_ep->enqueue + num_trb < priv_ep->num_trbs - 1 &&
+	       num_trb <= priv_ep->free_trbs;
+}
+
 /**
  * cdns3_start_all_request - add to ring all request not started
  * @priv_dev: Extended gadget object
  * @priv_ep: The endpoint for whom request will be started.
  *
+ * Requests which fit in the ring together are linked with a single
+ * doorbell write, and for bulk IN only the last of up to
+ * CDNS3_IOC_COALESCE_MAX requests interrupts on completion.
+ *
  * Returns return ENOMEM if transfer ring i not enough TRBs to start
  *         all requests.
  */
 static int cdns3_start_all_request(struct cdns3_device *priv_dev,
 				   struct cdns3_endpoint *priv_ep)
 {
-	struct usb_request *request;
+	struct usb_request *request, *next;
 	int ret = 0;
 	u8 pending_empty = list_empty(&priv_ep->pending_req_list);
+	bool drdy_owed = false;
+	int no_ioc = 0;
+	int batched = 0;
 
 	/*
 	 * If the last pending transfer is INTERNAL
@@ -407,22 +452,54 @@ static int cdns3_start_all_request(struct cdns3_device *priv_dev,
 	}
 
 	while (!list_empty(&priv_ep->deferred_req_list)) {
+		u32 flags = 0;
+
 		request = cdns3_next_request(&priv_ep->deferred_req_list);
 
 		if (!priv_ep->use_streams) {
-			ret = cdns3_ep_run_transfer(priv_ep, request);
+			next = list_is_last(&request->list,
+					    &priv_ep->deferred_req_list) ?
+			       NULL : list_next_entry(request, list);
+
+			if (next && cdns3_ep_can_batch(priv_ep, request, next)) {
+				flags |= CDNS3_XFER_NO_DRDY;
+
+				if (priv_ep->dir &&
+				    priv_ep->type == USB_ENDPOINT_XFER_BULK &&
+				    no_ioc < CDNS3_IOC_COALESCE_MAX - 1)
+					flags |= CDNS3_XFER_NO_IOC;
+			}
+
+			no_ioc = flags & CDNS3_XFER_NO_IOC ? no_ioc + 1 : 0;
+
+			ret = cdns3_ep_run_transfer(priv_ep, request, flags);
 		} else {
 			priv_ep->stream_sg_idx = 0;
 			ret = cdns3_ep_run_stream_transfer(priv_ep, request);
 		}
 		if (ret)
-			return ret;
+			break;
+
+		drdy_owed = flags & CDNS3_XFER_NO_DRDY;
+		batched++;
 
 		list_move_tail(&request->list, &priv_ep->pending_req_list);
 		if (request->stream_id != 0 || (priv_ep->flags & EP_TDLCHK_EN))
 			break;
 	}
 
+	/* Not expected as cdns3_ep_can_batch() reserved room, but be safe */
+	if (drdy_owed) {
+		cdns3_select_ep(priv_dev, priv_ep->endpoint.desc->bEndpointAddress);
+		cdns3_ep_ring_drdy(priv_ep);
+	}
+
+	if (batched)
+		trace_cdns3_ring_fill(priv_ep, batched);
+
+	if (ret)
+		return ret;
+
 	priv_ep->flags &= ~EP_RING_FULL;
 	return ret;
 }
@@ -1106,15 +1183,35 @@ static void cdns3_rearm_drdy_if_needed(struct cdns3_endpoint *priv_ep)
 	}
 }
 
+/* Ring the doorbell of the selected endpoint for all TRBs added so far */
+static void cdns3_ep_ring_drdy(struct cdns3_endpoint *priv_ep)
+{
+	struct cdns3_device *priv_dev = priv_ep->cdns3_dev;
+
+	if (!priv_ep->wa1_set && !(priv_ep->flags & EP_STALLED)) {
+		trace_cdns3_ring(priv_ep);
+		/*clearing TRBERR and EP_STS_DESCMIS before seting DRDY*/
+		writel(EP_STS_TRBERR | EP_STS_DESCMIS, &priv_dev->regs->ep_sts);
+		writel(EP_CMD_DRDY, &priv_dev->regs->ep_cmd);
+		cdns3_rearm_drdy_if_needed(priv_ep);
+		trace_cdns3_doorbell_epx(priv_ep->name,
+					 readl(&priv_dev->regs->ep_traddr));
+	}
+
+	/* WORKAROUND for transition to L0 */
+	__cdns3_gadget_wakeup(priv_dev);
+}
+
 /**
  * cdns3_ep_run_transfer - start transfer on no-default endpoint hardware
  * @priv_ep: endpoint object
  * @request: request object
+ * @flags: CDNS3_XFER_* flags set when more requests follow in the batch
  *
  * Returns zero on success or negative value on failure
  */
 static int cdns3_ep_run_transfer(struct cdns3_endpoint *priv_ep,
-				 struct usb_request *request)
+				 struct usb_request *request, u32 flags)
 {
 	struct cdns3_device *priv_dev = priv_ep->cdns3_dev;
 	struct cdns3_request *priv_req;
@@ -1132,7 +1229,8 @@ static int cdns3_ep_run_transfer(struct cdns3_endpoint *priv_ep,
 	u16 total_tdl = 0;
 	struct scatterlist *s = NULL;
 	bool sg_supported = !!(request->num_mapped_sgs);
-	u32 ioc = request->no_interrupt ? 0 : TRB_IOC;
+	u32 ioc = request->no_interrupt || (flags & CDNS3_XFER_NO_IOC) ?
+		  0 : TRB_IOC;
 
 	num_trb_req = sg_supported ? request->num_mapped_sgs : 1;
 
@@ -1402,18 +1500,8 @@ static int cdns3_ep_run_transfer(struct cdns3_endpoint *priv_ep,
 		priv_ep->flags &= ~EP_UPDATE_EP_TRBADDR;
 	}
 
-	if (!priv_ep->wa1_set && !(priv_ep->flags & EP_STALLED)) {
-		trace_cdns3_ring(priv_ep);
-		/*clearing TRBERR and EP_STS_DESCMIS before seting DRDY*/
-		writel(EP_STS_TRBERR | EP_STS_DESCMIS, &priv_dev->regs->ep_sts);
-		writel(EP_CMD_DRDY, &priv_dev->regs->ep_cmd);
-		cdns3_rearm_drdy_if_needed(priv_ep);
-		trace_cdns3_doorbell_epx(priv_ep->name,
-					 readl(&priv_dev->regs->ep_traddr));
-	}
-
-	/* WORKAROUND for transition to L0 */
-	__cdns3_gadget_wakeup(priv_dev);
+	if (!(flags & CDNS3_XFER_NO_DRDY))
+		cdns3_ep_ring_drdy(priv_ep);
 
 	return 0;
 }
@@ -1553,6 +1641,7 @@ static void cdns3_transfer_completed(struct cdns3_device *priv_dev,
 	struct cdns3_trb *trb;
 	bool request_handled = false;
 	bool transfer_end = false;
+	int completed = 0;
 
 	while (!list_empty(&priv_ep->pending_req_list)) {
 		request = cdns3_next_request(&priv_ep->pending_req_list);
@@ -1607,6 +1696,7 @@ static void cdns3_transfer_completed(struct cdns3_device *priv_dev,
 				cdns3_gadget_giveback(priv_ep, priv_req, 0);
 				request_handled = false;
 				transfer_end = false;
+				completed++;
 			} else {
 				goto prepare_next_td;
 			}
@@ -1644,6 +1734,8 @@ static void cdns3_transfer_completed(struct cdns3_device *priv_dev,
 	priv_ep->flags &= ~EP_PENDING_REQUEST;
 
 prepare_next_td:
+	trace_cdns3_ring_drain(priv_ep, completed);
+
 	if (!(priv_ep->flags & EP_STALLED) &&
 	    !(priv_ep->flags & EP_STALL_PENDING))
 		cdns3_start_all_request(priv_dev, priv_ep);
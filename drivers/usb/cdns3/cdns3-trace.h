@@ -451,6 +451,40 @@ DEFINE_EVENT(cdns3_log_ring, cdns3_ring,
 	TP_ARGS(priv_ep)
 );
 
+DECLARE_EVENT_CLASS(cdns3_log_ring_occupancy,
+	TP_PROTO(struct cdns3_endpoint *priv_ep, int reqs),
+	TP_ARGS(priv_ep, reqs),
+	TP_STRUCT__entry(
+		__string(name, priv_ep->name)
+		__field(int, reqs)
+		__field(int, used)
+		__field(int, num_trbs)
+		__field(int, enqueue)
+		__field(int, dequeue)
+	),
+	TP_fast_assign(
+		__assign_str(name);
+		__entry->reqs = reqs;
+		__entry->used = priv_ep->num_trbs - 1 - priv_ep->free_trbs;
+		__entry->num_trbs = priv_ep->num_trbs;
+		__entry->enqueue = priv_ep->enqueue;
+		__entry->dequeue = priv_ep->dequeue;
+	),
+	TP_printk("%s: reqs %d, TRBs used %d/%d, enq %d, deq %d",
+		  __get_str(name), __entry->reqs, __entry->used,
+		  __entry->num_trbs, __entry->enqueue, __entry->dequeue)
+);
+
+DEFINE_EVENT(cdns3_log_ring_occupancy, cdns3_ring_fill,
+	TP_PROTO(struct cdns3_endpoint *priv_ep, int reqs),
+	TP_ARGS(priv_ep, reqs)
+);
+
+DEFINE_EVENT(cdns3_log_ring_occupancy, cdns3_ring_drain,
+	TP_PROTO(struct cdns3_endpoint *priv_ep, int reqs),
+	TP_ARGS(priv_ep, reqs)
+);
+
 DECLARE_EVENT_CLASS(cdns3_log_ep,
 	TP_PROTO(struct cdns3_endpoint *priv_ep),
 	TP_ARGS(priv_ep),
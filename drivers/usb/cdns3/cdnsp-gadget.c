@@ -10,6 +10,7 @@
 
 #include <linux/moduleparam.h>
 #include <linux/dma-mapping.h>
+#include <linux/debugfs.h>
 #include <linux/module.h>
 #include <linux/iopoll.h>
 #include <linux/delay.h>
@@ -18,6 +19,7 @@
 #include <linux/pci.h>
 #include <linux/irq.h>
 #include <linux/dmi.h>
+#include <linux/usb.h>
 
 #include "core.h"
 #include "gadget-export.h"
@@ -1260,6 +1262,8 @@ void cdnsp_gadget_giveback(struct cdnsp_ep *pep,
 
 	trace_cdnsp_request_giveback(preq);
 
+	pdev->stats.bytes += preq->request.actual;
+
 	if (preq != &pdev->ep0_preq) {
 		spin_unlock(&pdev->lock);
 		usb_gadget_giveback_request(&pep->endpoint, &preq->request);
@@ -1273,6 +1277,43 @@ static struct usb_endpoint_descriptor cdnsp_gadget_ep0_desc = {
 	.bmAttributes =		USB_ENDPOINT_XFER_CONTROL,
 };
 
+static unsigned int imod_interval_ns = IMOD_DEFAULT_INTERVAL;
+module_param(imod_interval_ns, uint, 0444);
+MODULE_PARM_DESC(imod_interval_ns, "initial interrupt moderation interval in ns");
+
+static bool imod_adaptive;
+module_param(imod_adaptive, bool, 0444);
+MODULE_PARM_DESC(imod_adaptive, "adapt interrupt moderation to the interrupt rate");
+
+void cdnsp_set_imod(struct cdnsp_device *pdev, u32 interval_ns)
+{
+	u32 temp;
+
+	interval_ns = min_t(u32, interval_ns, IMOD_INTERVAL_MASK * 250);
+	pdev->imod_interval = interval_ns;
+
+	temp = readl(&pdev->ir_set->irq_control);
+	temp &= ~IMOD_INTERVAL_MASK;
+	temp |= ((interval_ns / 250) & IMOD_INTERVAL_MASK);
+	writel(temp, &pdev->ir_set->irq_control);
+}
+
+static void cdnsp_imod_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct cdnsp_device *pdev = container_of(dim, struct cdnsp_device, dim);
+	struct dim_cq_moder moder = comp_dim_get_moderation(dim->profile_ix);
+	unsigned long flags;
+
+	spin_lock_irqsave(&pdev->lock, flags);
+	if (pdev->imod_adaptive &&
+	    !(pdev->cdnsp_state & (CDNSP_STATE_HALTED | CDNSP_STATE_DYING)))
+		cdnsp_set_imod(pdev, min_t(u32, moder.usec * NSEC_PER_USEC,
+					   IMOD_ADAPTIVE_MAX));
+	dim->state = DIM_START_MEASURE;
+	spin_unlock_irqrestore(&pdev->lock, flags);
+}
+
 static int cdnsp_run(struct cdnsp_device *pdev,
 		     enum usb_device_speed speed)
 {
@@ -1280,10 +1321,8 @@ static int cdnsp_run(struct cdnsp_device *pdev,
 	u32 temp;
 	int ret;
 
-	temp = readl(&pdev->ir_set->irq_control);
-	temp &= ~IMOD_INTERVAL_MASK;
-	temp |= ((IMOD_DEFAULT_INTERVAL / 250) & IMOD_INTERVAL_MASK);
-	writel(temp, &pdev->ir_set->irq_control);
+	cdnsp_set_imod(pdev, pdev->imod_interval);
+	pdev->dim.state = DIM_START_MEASURE;
 
 	temp = readl(&pdev->port3x_regs->mode_addr);
 
@@ -1937,6 +1976,11 @@ static int __cdnsp_gadget_init(struct cdns *cdns)
 	pdev->gadget.max_speed = max_speed;
 	pdev->gadget.lpm_capable = 1;
 
+	pdev->imod_interval = imod_interval_ns;
+	pdev->imod_adaptive = imod_adaptive;
+	INIT_WORK(&pdev->dim.work, cdnsp_imod_dim_work);
+	pdev->dim.profile_ix = COMP_DIM_START_PROFILE;
+
 	pdev->setup_buf = kzalloc(CDNSP_EP0_SETUP_SIZE, GFP_KERNEL);
 	if (!pdev->setup_buf)
 		goto free_pdev;
@@ -1972,6 +2016,8 @@ static int __cdnsp_gadget_init(struct cdns *cdns)
 	if (ret)
 		goto del_gadget;
 
+	cdnsp_debugfs_init(pdev);
+
 	return 0;
 
 del_gadget:
@@ -1990,11 +2036,58 @@ static int __cdnsp_gadget_init(struct cdns *cdns)
 	return ret;
 }
 
+static int cdnsp_imod_get(void *data, u64 *val)
+{
+	struct cdnsp_device *pdev = data;
+
+	*val = pdev->imod_interval;
+
+	return 0;
+}
+
+static int cdnsp_imod_set(void *data, u64 val)
+{
+	struct cdnsp_device *pdev = data;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pdev->lock, flags);
+	cdnsp_set_imod(pdev, min_t(u64, val, U32_MAX));
+	spin_unlock_irqrestore(&pdev->lock, flags);
+
+	return 0;
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(cdnsp_imod_fops, cdnsp_imod_get, cdnsp_imod_set,
+			 "%llu\n");
+
+static void cdnsp_debugfs_init(struct cdnsp_device *pdev)
+{
+	struct dentry *root;
+
+	root = debugfs_create_dir(dev_name(pdev->dev), usb_debug_root);
+	pdev->debugfs = root;
+
+	debugfs_create_file_unsafe("imod_interval_ns", 0644, root, pdev,
+				   &cdnsp_imod_fops);
+	debugfs_create_bool("imod_adaptive", 0644, root, &pdev->imod_adaptive);
+	debugfs_create_u64("irqs", 0444, root, &pdev->stats.irqs);
+	debugfs_create_u64("events", 0444, root, &pdev->stats.events);
+	debugfs_create_u64("bytes", 0444, root, &pdev->stats.bytes);
+	debugfs_create_u64("max_events_per_irq", 0444, root,
+			   &pdev->stats.max_events);
+	debugfs_create_u64("budget_exhausted", 0444, root,
+			   &pdev->stats.budget_exhausted);
+	debugfs_create_u64("event_ring_full", 0444, root,
+			   &pdev->stats.ring_full);
+}
+
 static void cdnsp_gadget_exit(struct cdns *cdns)
 {
 	struct cdnsp_device *pdev = cdns->gadget_dev;
 
+	debugfs_remove_recursive(pdev->debugfs);
 	devm_free_irq(pdev->dev, cdns->dev_irq, pdev);
+	cancel_work_sync(&pdev->dim.work);
 	pm_runtime_mark_last_busy(cdns->dev);
 	pm_runtime_put_autosuspend(cdns->dev);
 	usb_del_gadget_udc(&pdev->gadget);
@@ -15,6 +15,7 @@
 #include <linux/io-64-nonatomic-lo-hi.h>
 #include <linux/usb/gadget.h>
 #include <linux/irq.h>
+#include <linux/dim.h>
 
 /* Max number slots - only 1 is allowed. */
 #define CDNSP_DEV_MAX_SLOTS	1
@@ -400,6 +401,8 @@ struct cdnsp_intr_reg {
 /* Counter used to count down the time to the next interrupt - HW use only */
 #define IMOD_COUNTER_MASK	GENMASK(31, 16)
 #define IMOD_DEFAULT_INTERVAL	0
+/* Upper bound used by adaptive moderation, in ns. */
+#define IMOD_ADAPTIVE_MAX	128000
 
 /* erst_size bitmasks. */
 /* Preserve bits 16:31 of erst_size. */
@@ -1152,6 +1155,8 @@ union cdnsp_trb {
 #define TRBS_PER_SEGMENT		256
 #define TRBS_PER_EVENT_SEGMENT		256
 #define TRBS_PER_EV_DEQ_UPDATE		100
+/* Events handled before the lock is dropped to let other contexts in. */
+#define CDNSP_EVENT_BUDGET		256
 #define TRB_SEGMENT_SIZE		(TRBS_PER_SEGMENT * 16)
 #define TRB_SEGMENT_SHIFT		(ilog2(TRB_SEGMENT_SIZE))
 /* TRB buffer pointers can't cross 64KB boundaries. */
@@ -1397,6 +1402,12 @@ struct cdnsp_port {
  * @usb3_port - Port USB 3.0.
  * @active_port - Current selected Port.
  * @test_mode: selected Test Mode.
+ * @imod_interval: Current interrupt moderation interval in ns.
+ * @imod_adaptive: Adjust @imod_interval to the interrupt rate.
+ * @dim: Adaptive moderation state, see cdnsp_imod_adapt().
+ * @dim_irqs: Interrupts accounted to @dim.
+ * @stats: Event ring statistics exported through debugfs.
+ * @debugfs: debugfs directory of the controller.
  */
 struct cdnsp_device {
 	struct device *dev;
@@ -1471,6 +1482,20 @@ struct cdnsp_device {
 	struct cdnsp_port usb3_port;
 	struct cdnsp_port *active_port;
 	u16 test_mode;
+
+	u32 imod_interval;
+	bool imod_adaptive;
+	struct dim dim;
+	u16 dim_irqs;
+	struct {
+		u64 irqs;
+		u64 events;
+		u64 bytes;
+		u64 max_events;
+		u64 budget_exhausted;
+		u64 ring_full;
+	} stats;
+	struct dentry *debugfs;
 };
 
 /*
@@ -1516,6 +1541,7 @@ int cdnsp_find_next_ext_cap(void __iomem *base, u32 start, int id);
 int cdnsp_halt(struct cdnsp_device *pdev);
 void cdnsp_died(struct cdnsp_device *pdev);
 int cdnsp_reset(struct cdnsp_device *pdev);
+void cdnsp_set_imod(struct cdnsp_device *pdev, u32 interval_ns);
 irqreturn_t cdnsp_irq_handler(int irq, void *priv);
 int cdnsp_setup_device(struct cdnsp_device *pdev, enum cdnsp_setup_dev setup);
 void cdnsp_set_usb2_hardware_lpm(struct cdnsp_device *usbsssp_data,
@@ -1497,6 +1497,7 @@ static bool cdnsp_handle_event(struct cdnsp_device *pdev)
 
 		switch (comp_code) {
 		case COMP_EVENT_RING_FULL_ERROR:
+			pdev->stats.ring_full++;
 			dev_err(pdev->dev, "Event Ring Full\n");
 			break;
 		default:
@@ -1525,12 +1526,30 @@ static bool cdnsp_handle_event(struct cdnsp_device *pdev)
 	return true;
 }
 
+/*
+ * Adaptive interrupt moderation: comp_dim raises the moderation interval
+ * for as long as that brings more bytes or events per msec, or fewer
+ * interrupts for the same, so that small packet traffic (RNDIS/NCM)
+ * doesn't end up taking an interrupt per event.  The new interval is
+ * applied by cdnsp_imod_dim_work().
+ */
+static void cdnsp_imod_adapt(struct cdnsp_device *pdev)
+{
+	struct dim_sample sample = {};
+
+	dim_update_sample_with_comps(++pdev->dim_irqs, 0, pdev->stats.bytes,
+				     pdev->stats.events, &sample);
+	comp_dim(&pdev->dim, sample, false);
+}
+
 irqreturn_t cdnsp_thread_irq_handler(int irq, void *data)
 {
 	struct cdnsp_device *pdev = (struct cdnsp_device *)data;
 	union cdnsp_trb *event_ring_deq;
+	int budget = CDNSP_EVENT_BUDGET;
 	unsigned long flags;
 	int counter = 0;
+	u64 events = 0;
 
 	local_bh_disable();
 	spin_lock_irqsave(&pdev->lock, flags);
@@ -1552,15 +1571,51 @@ irqreturn_t cdnsp_thread_irq_handler(int irq, void *data)
 	event_ring_deq = pdev->event_ring->dequeue;
 
 	while (cdnsp_handle_event(pdev)) {
+		events++;
+
 		if (++counter >= TRBS_PER_EV_DEQ_UPDATE) {
 			cdnsp_update_erst_dequeue(pdev, event_ring_deq, 0);
 			event_ring_deq = pdev->event_ring->dequeue;
 			counter = 0;
 		}
+
+		if (--budget)
+			continue;
+
+		/*
+		 * Give the queueing paths a chance at the lock before
+		 * draining further. EHB stays set, so no new interrupt is
+		 * raised for the events still on the ring.
+		 */
+		pdev->stats.budget_exhausted++;
+		cdnsp_update_erst_dequeue(pdev, event_ring_deq, 0);
+		spin_unlock_irqrestore(&pdev->lock, flags);
+		local_bh_enable();
+
+		cond_resched();
+
+		local_bh_disable();
+		spin_lock_irqsave(&pdev->lock, flags);
+
+		if (pdev->cdnsp_state & (CDNSP_STATE_HALTED | CDNSP_STATE_DYING))
+			goto unlock;
+
+		event_ring_deq = pdev->event_ring->dequeue;
+		counter = 0;
+		budget = CDNSP_EVENT_BUDGET;
 	}
 
 	cdnsp_update_erst_dequeue(pdev, event_ring_deq, 1);
 
+	pdev->stats.irqs++;
+	pdev->stats.events += events;
+	if (events > pdev->stats.max_events)
+		pdev->stats.max_events = events;
+
+	if (pdev->imod_adaptive)
+		cdnsp_imod_adapt(pdev);
+
+unlock:
 	spin_unlock_irqrestore(&pdev->lock, flags);
 	local_bh_enable();
 
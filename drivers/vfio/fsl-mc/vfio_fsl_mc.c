@@ -188,7 +188,7 @@ static long vfio_fsl_mc_ioctl(struct vfio_device *core_vdev,
 		if (info.index >= mc_dev->obj_desc.irq_count)
 			return -EINVAL;
 
-		info.flags = VFIO_IRQ_INFO_EVENTFD;
+		info.flags = VFIO_IRQ_INFO_EVENTFD | VFIO_IRQ_INFO_MASKABLE;
 		info.count = 1;
 
 		if (copy_to_user((void __user *)arg, &info, minsz))
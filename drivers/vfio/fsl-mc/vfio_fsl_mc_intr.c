@@ -42,7 +42,10 @@ static int vfio_fsl_mc_irqs_allocate(struct vfio_fsl_mc_device *vdev)
 
 	for (i = 0; i < irq_count; i++) {
 		mc_irq[i].count = 1;
-		mc_irq[i].flags = VFIO_IRQ_INFO_EVENTFD;
+		mc_irq[i].flags = VFIO_IRQ_INFO_EVENTFD |
+				  VFIO_IRQ_INFO_MASKABLE;
+		mc_irq[i].hwirq = mc_dev->irqs[i]->virq;
+		spin_lock_init(&mc_irq[i].lock);
 	}
 
 	vdev->mc_irqs = mc_irq;
@@ -50,6 +53,94 @@ static int vfio_fsl_mc_irqs_allocate(struct vfio_fsl_mc_device *vdev)
 	return 0;
 }
 
+static void vfio_fsl_mc_mask(struct vfio_fsl_mc_irq *irq)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&irq->lock, flags);
+	if (!irq->masked) {
+		disable_irq_nosync(irq->hwirq);
+		irq->masked = true;
+	}
+	spin_unlock_irqrestore(&irq->lock, flags);
+}
+
+static int vfio_fsl_mc_mask_handler(void *opaque, void *unused)
+{
+	vfio_fsl_mc_mask(opaque);
+
+	return 0;
+}
+
+static void vfio_fsl_mc_unmask(struct vfio_fsl_mc_irq *irq)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&irq->lock, flags);
+	if (irq->masked) {
+		enable_irq(irq->hwirq);
+		irq->masked = false;
+	}
+	spin_unlock_irqrestore(&irq->lock, flags);
+}
+
+static int vfio_fsl_mc_unmask_handler(void *opaque, void *unused)
+{
+	vfio_fsl_mc_unmask(opaque);
+
+	return 0;
+}
+
+/*
+ * Masking only gates the MSI in the kernel: while it is masked, an incoming
+ * notification is held pending and signaled on unmask. With an eventfd bound
+ * to the (un)mask action, a datapath toggles it with a plain eventfd write
+ * instead of a VFIO_DEVICE_SET_IRQS ioctl.
+ */
+static int vfio_fsl_mc_set_irq_mask(struct vfio_fsl_mc_device *vdev,
+				    unsigned int index, unsigned int start,
+				    unsigned int count, u32 flags,
+				    void *data, bool mask)
+{
+	struct vfio_fsl_mc_irq *irq;
+
+	if (start != 0 || count != 1)
+		return -EINVAL;
+
+	/* the line only exists once a trigger has been set */
+	if (!vdev->mc_irqs)
+		return -EINVAL;
+
+	irq = &vdev->mc_irqs[index];
+
+	if (flags & VFIO_IRQ_SET_DATA_EVENTFD) {
+		struct virqfd **virqfd = mask ? &irq->mask : &irq->unmask;
+		s32 fd = *(s32 *)data;
+
+		if (fd >= 0)
+			return vfio_virqfd_enable(irq, mask ?
+						  vfio_fsl_mc_mask_handler :
+						  vfio_fsl_mc_unmask_handler,
+						  NULL, NULL, virqfd, fd);
+
+		vfio_virqfd_disable(virqfd);
+		return 0;
+	}
+
+	if (!irq->trigger)
+		return -EINVAL;
+
+	if ((flags & VFIO_IRQ_SET_DATA_BOOL) && !*(u8 *)data)
+		return 0;
+
+	if (mask)
+		vfio_fsl_mc_mask(irq);
+	else
+		vfio_fsl_mc_unmask(irq);
+
+	return 0;
+}
+
 static irqreturn_t vfio_fsl_mc_irq_handler(int irq_num, void *arg)
 {
 	struct vfio_fsl_mc_irq *mc_irq = (struct vfio_fsl_mc_irq *)arg;
@@ -68,6 +159,8 @@ static int vfio_set_trigger(struct vfio_fsl_mc_device *vdev,
 
 	hwirq = vdev->mc_dev->irqs[index]->virq;
 	if (irq->trigger) {
+		/* don't leave the line disabled for the next user */
+		vfio_fsl_mc_unmask(irq);
 		free_irq(hwirq, irq);
 		kfree(irq->name);
 		eventfd_ctx_put(irq->trigger);
@@ -165,6 +258,12 @@ int vfio_fsl_mc_set_irqs_ioctl(struct vfio_fsl_mc_device *vdev,
 	if (flags & VFIO_IRQ_SET_ACTION_TRIGGER)
 		return  vfio_fsl_mc_set_irq_trigger(vdev, index, start,
 			  count, flags, data);
+	else if (flags & VFIO_IRQ_SET_ACTION_MASK)
+		return vfio_fsl_mc_set_irq_mask(vdev, index, start, count,
+						flags, data, true);
+	else if (flags & VFIO_IRQ_SET_ACTION_UNMASK)
+		return vfio_fsl_mc_set_irq_mask(vdev, index, start, count,
+						flags, data, false);
 	else
 		return -EINVAL;
 }
@@ -183,8 +282,11 @@ void vfio_fsl_mc_irqs_cleanup(struct vfio_fsl_mc_device *vdev)
 	if (!vdev->mc_irqs)
 		return;
 
-	for (i = 0; i < irq_count; i++)
+	for (i = 0; i < irq_count; i++) {
+		vfio_virqfd_disable(&vdev->mc_irqs[i].mask);
+		vfio_virqfd_disable(&vdev->mc_irqs[i].unmask);
 		vfio_set_trigger(vdev, i, -1);
+	}
 
 	fsl_mc_free_irqs(mc_dev);
 	kfree(vdev->mc_irqs);
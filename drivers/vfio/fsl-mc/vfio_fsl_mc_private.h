@@ -20,6 +20,11 @@ struct vfio_fsl_mc_irq {
 	u32         count;
 	struct eventfd_ctx  *trigger;
 	char            *name;
+	int		hwirq;
+	spinlock_t	lock;	/* protects masked */
+	bool		masked;
+	struct virqfd	*mask;
+	struct virqfd	*unmask;
 };
 
 struct vfio_fsl_mc_region {
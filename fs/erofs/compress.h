@@ -97,4 +97,20 @@ int z_erofs_fixup_insize(struct z_erofs_decompress_req *rq, const char *padbuf,
 			 unsigned int padbufsize);
 int __init z_erofs_init_decompressor(void);
 void z_erofs_exit_decompressor(void);
+
+#ifdef CONFIG_EROFS_FS_ZIP_ACCEL
+int z_erofs_crypto_enable(struct super_block *sb, unsigned int alg);
+int z_erofs_crypto_decompress(struct z_erofs_decompress_req *rq,
+			      struct page **pgpl);
+void z_erofs_crypto_exit(void);
+#else
+static inline int z_erofs_crypto_enable(struct super_block *sb,
+					unsigned int alg) { return 0; }
+static inline int z_erofs_crypto_decompress(struct z_erofs_decompress_req *rq,
+					    struct page **pgpl)
+{
+	return -EAGAIN;
+}
+static inline void z_erofs_crypto_exit(void) {}
+#endif
 #endif
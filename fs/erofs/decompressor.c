@@ -552,6 +552,7 @@ void z_erofs_exit_decompressor(void)
 {
 	int i;
 
+	z_erofs_crypto_exit();
 	for (i = 0; i < Z_EROFS_COMPRESSION_MAX; ++i)
 		if (z_erofs_decomp[i])
 			z_erofs_decomp[i]->exit();
@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Offload of whole pclusters to compression engines exposed through the
+ * crypto acomp API.  Each engine has a fixed number of preallocated
+ * requests; when all of them are in flight, or the engine rejects the
+ * request, the pcluster is decompressed on the CPU as usual.
+ */
+#include <crypto/acompress.h>
+#include <linux/scatterlist.h>
+#include "compress.h"
+
+struct z_erofs_crypto_engine {
+	struct crypto_acomp *tfm;
+	spinlock_t lock;
+	unsigned int nreqs, avail;
+	struct acomp_req **reqs;
+};
+
+static struct z_erofs_crypto_engine z_erofs_crypto[Z_EROFS_COMPRESSION_MAX];
+static DEFINE_MUTEX(z_erofs_crypto_mutex);
+
+static char *z_erofs_deflate_accel;
+module_param_named(deflate_accel, z_erofs_deflate_accel, charp, 0444);
+MODULE_PARM_DESC(deflate_accel, "acomp driver used to offload DEFLATE pclusters");
+
+static unsigned int z_erofs_accel_depth = 16;
+module_param_named(accel_depth, z_erofs_accel_depth, uint, 0444);
+MODULE_PARM_DESC(accel_depth, "number of pclusters in flight per acomp engine");
+
+static const char *z_erofs_crypto_name(unsigned int alg)
+{
+	if (alg == Z_EROFS_COMPRESSION_DEFLATE)
+		return z_erofs_deflate_accel;
+	return NULL;
+}
+
+static void z_erofs_crypto_free(struct z_erofs_crypto_engine *eng,
+				struct crypto_acomp *tfm)
+{
+	while (eng->avail)
+		acomp_request_free(eng->reqs[--eng->avail]);
+	kfree(eng->reqs);
+	eng->reqs = NULL;
+	crypto_free_acomp(tfm);
+}
+
+int z_erofs_crypto_enable(struct super_block *sb, unsigned int alg)
+{
+	struct z_erofs_crypto_engine *eng = &z_erofs_crypto[alg];
+	const char *name = z_erofs_crypto_name(alg);
+	struct crypto_acomp *tfm;
+	struct acomp_req *req;
+	int err = 0;
+
+	if (!name || !*name || !z_erofs_accel_depth)
+		return 0;
+
+	mutex_lock(&z_erofs_crypto_mutex);
+	if (eng->tfm)
+		goto out;
+
+	tfm = crypto_alloc_acomp(name, 0, 0);
+	if (IS_ERR(tfm)) {
+		err = PTR_ERR(tfm);
+		goto out;
+	}
+
+	spin_lock_init(&eng->lock);
+	eng->reqs = kcalloc(z_erofs_accel_depth, sizeof(*eng->reqs),
+			    GFP_KERNEL);
+	if (!eng->reqs) {
+		err = -ENOMEM;
+		goto failed;
+	}
+	while (eng->avail < z_erofs_accel_depth) {
+		req = acomp_request_alloc(tfm);
+		if (!req) {
+			err = -ENOMEM;
+			goto failed;
+		}
+		eng->reqs[eng->avail++] = req;
+	}
+	eng->nreqs = eng->avail;
+	/* pairs with smp_load_acquire() in z_erofs_crypto_decompress() */
+	smp_store_release(&eng->tfm, tfm);
+	erofs_info(sb, "offloading %s to %s", z_erofs_decomp[alg]->name,
+		   crypto_tfm_alg_driver_name(crypto_acomp_tfm(tfm)));
+	goto out;
+failed:
+	z_erofs_crypto_free(eng, tfm);
+out:
+	mutex_unlock(&z_erofs_crypto_mutex);
+	/* the CPU decompressor still works, don't fail the mount */
+	if (err)
+		erofs_info(sb, "cannot use %s to offload %s: %d", name,
+			   z_erofs_decomp[alg]->name, err);
+	return 0;
+}
+
+static struct acomp_req *z_erofs_crypto_get_req(struct z_erofs_crypto_engine *eng)
+{
+	struct acomp_req *req = NULL;
+
+	spin_lock(&eng->lock);
+	if (eng->avail)
+		req = eng->reqs[--eng->avail];
+	spin_unlock(&eng->lock);
+	return req;
+}
+
+static void z_erofs_crypto_put_req(struct z_erofs_crypto_engine *eng,
+				   struct acomp_req *req)
+{
+	spin_lock(&eng->lock);
+	eng->reqs[eng->avail++] = req;
+	spin_unlock(&eng->lock);
+}
+
+/*
+ * Returns -EAGAIN if the pcluster should be decompressed on the CPU instead,
+ * which is also the case for any engine failure: the output is rewritten
+ * from scratch and genuine corruption is reported by the CPU decompressor.
+ */
+int z_erofs_crypto_decompress(struct z_erofs_decompress_req *rq,
+			      struct page **pgpl)
+{
+	struct z_erofs_crypto_engine *eng = &z_erofs_crypto[rq->alg];
+	unsigned int inpages, outpages, i;
+	struct sg_table st_in, st_out;
+	struct acomp_req *req;
+	DECLARE_CRYPTO_WAIT(wait);
+	int err;
+
+	/*
+	 * Engines decode whole streams only and DMA straight into the output,
+	 * which must not overlap the input.
+	 */
+	if (!smp_load_acquire(&eng->tfm) || rq->inplace_io ||
+	    rq->partial_decoding)
+		return -EAGAIN;
+
+	req = z_erofs_crypto_get_req(eng);
+	if (!req)
+		return -EAGAIN;
+
+	err = -EAGAIN;
+	outpages = PAGE_ALIGN(rq->pageofs_out + rq->outputsize) >> PAGE_SHIFT;
+	for (i = 0; i < outpages; ++i) {
+		if (rq->out[i])
+			continue;
+		rq->out[i] = erofs_allocpage(pgpl, rq->gfp);
+		if (!rq->out[i])
+			goto out;
+		set_page_private(rq->out[i], Z_EROFS_SHORTLIVED_PAGE);
+	}
+
+	inpages = PAGE_ALIGN(rq->pageofs_in + rq->inputsize) >> PAGE_SHIFT;
+	if (sg_alloc_table_from_pages(&st_in, rq->in, inpages, rq->pageofs_in,
+				      rq->inputsize, rq->gfp))
+		goto out;
+	if (sg_alloc_table_from_pages(&st_out, rq->out, outpages,
+				      rq->pageofs_out, rq->outputsize, rq->gfp))
+		goto out_free_in;
+
+	acomp_request_set_params(req, st_in.sgl, st_out.sgl, rq->inputsize,
+				 rq->outputsize);
+	acomp_request_set_callback(req, CRYPTO_TFM_REQ_MAY_SLEEP,
+				   crypto_req_done, &wait);
+	/* without CRYPTO_TFM_REQ_MAY_BACKLOG, -EBUSY means the engine is full */
+	err = crypto_acomp_decompress(req);
+	if (err != -EBUSY)
+		err = crypto_wait_req(err, &wait);
+	if (!err && req->dlen != rq->outputsize)
+		err = -EIO;
+	if (err) {
+		pr_debug("%s offload failed %d, fall back to the CPU\n",
+			 z_erofs_decomp[rq->alg]->name, err);
+		err = -EAGAIN;
+	}
+
+	sg_free_table(&st_out);
+out_free_in:
+	sg_free_table(&st_in);
+out:
+	z_erofs_crypto_put_req(eng, req);
+	return err;
+}
+
+void z_erofs_crypto_exit(void)
+{
+	int i;
+
+	for (i = 0; i < Z_EROFS_COMPRESSION_MAX; ++i)
+		if (z_erofs_crypto[i].tfm)
+			z_erofs_crypto_free(&z_erofs_crypto[i],
+					    z_erofs_crypto[i].tfm);
+}
@@ -90,7 +90,7 @@ static int z_erofs_load_deflate_config(struct super_block *sb,
 	}
 	mutex_unlock(&deflate_resize_mutex);
 	erofs_info(sb, "EXPERIMENTAL DEFLATE feature in use. Use at your own risk!");
-	return 0;
+	return z_erofs_crypto_enable(sb, Z_EROFS_COMPRESSION_DEFLATE);
 failed:
 	mutex_unlock(&deflate_resize_mutex);
 	z_erofs_deflate_exit();
@@ -120,7 +120,15 @@ static int z_erofs_deflate_decompress(struct z_erofs_decompress_req *rq,
 		return err;
 	}
 
-	/* 2. get an available DEFLATE context */
+	/* 2. try the compression engine, if any */
+	err = z_erofs_crypto_decompress(rq, pgpl);
+	if (err != -EAGAIN) {
+		kunmap_local(dctx.kin);
+		return err;
+	}
+	err = 0;
+
+	/* 3. get an available DEFLATE context */
 again:
 	spin_lock(&z_erofs_deflate_lock);
 	strm = z_erofs_deflate_head;
@@ -132,7 +140,7 @@ static int z_erofs_deflate_decompress(struct z_erofs_decompress_req *rq,
 	z_erofs_deflate_head = strm->next;
 	spin_unlock(&z_erofs_deflate_lock);
 
-	/* 3. multi-call decompress */
+	/* 4. multi-call decompress */
 	zerr = zlib_inflateInit2(&strm->z, -MAX_WBITS);
 	if (zerr != Z_OK) {
 		err = -EIO;
@@ -175,7 +183,7 @@ static int z_erofs_deflate_decompress(struct z_erofs_decompress_req *rq,
 		kunmap_local(dctx.kout);
 failed_zinit:
 	kunmap_local(dctx.kin);
-	/* 4. push back DEFLATE stream context to the global list */
+	/* 5. push back DEFLATE stream context to the global list */
 	spin_lock(&z_erofs_deflate_lock);
 	strm->next = z_erofs_deflate_head;
 	z_erofs_deflate_head = strm;
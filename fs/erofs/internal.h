@@ -70,6 +70,8 @@ struct erofs_mount_opts {
 	unsigned int sync_decompress;
 	/* threshold for decompression synchronously */
 	unsigned int max_sync_decompress_pages;
+	/* budget of the decompressed pcluster cache in KiB (0 - disabled) */
+	unsigned int zcache_max_kb;
 	unsigned int mount_opt;
 };
 
@@ -129,6 +131,11 @@ struct erofs_sb_info {
 	/* pseudo inode to manage cached pages */
 	struct inode *managed_cache;
 
+	/* decompressed pclusters arranged in physical block number */
+	struct xarray zcache;
+	struct list_head zcache_lru;	/* protected by the zcache xa_lock */
+	unsigned long zcache_bytes, zcache_hits, zcache_misses;
+
 	struct erofs_sb_lz4_info lz4;
 #endif	/* CONFIG_EROFS_FS_ZIP */
 	struct inode *packed_inode;
@@ -675,9 +675,188 @@ int z_erofs_init_super(struct super_block *sb)
 	mapping_set_gfp_mask(inode->i_mapping, GFP_KERNEL);
 	EROFS_SB(sb)->managed_cache = inode;
 	xa_init(&EROFS_SB(sb)->managed_pslots);
+	xa_init(&EROFS_SB(sb)->zcache);
+	INIT_LIST_HEAD(&EROFS_SB(sb)->zcache_lru);
 	return 0;
 }
 
+/*
+ * Decompressed pcluster cache (zcache).  The managed cache only keeps
+ * compressed data, so random reads served by a large pcluster decompress
+ * the whole pcluster again whenever the page cache has dropped the folio.
+ * If enabled with the `zcache_max_kb' sysfs knob, fully decoded pclusters
+ * are kept here in LRU order until the budget or the shrinker evicts them.
+ */
+struct z_erofs_zcache_entry {
+	struct list_head lru;
+	refcount_t ref;
+	erofs_blk_t blkaddr;
+	unsigned int length;		/* decoded bytes */
+	unsigned int nrpages;
+	struct page *pages[];
+};
+
+static void z_erofs_zcache_put(struct z_erofs_zcache_entry *ze)
+{
+	unsigned int i;
+
+	if (!refcount_dec_and_test(&ze->ref))
+		return;
+	for (i = 0; i < ze->nrpages; ++i)
+		if (ze->pages[i])
+			__free_page(ze->pages[i]);
+	kfree(ze);
+}
+
+/* callers must hold the zcache xa_lock, entries are put by the caller */
+static void z_erofs_zcache_evict(struct erofs_sb_info *sbi,
+				 struct z_erofs_zcache_entry *ze,
+				 struct list_head *evicted)
+{
+	__xa_erase(&sbi->zcache, ze->blkaddr);
+	list_move(&ze->lru, evicted);
+	sbi->zcache_bytes -= ze->length;
+	atomic_long_dec(&erofs_global_shrink_cnt);
+}
+
+static void z_erofs_zcache_put_list(struct list_head *evicted)
+{
+	struct z_erofs_zcache_entry *ze, *n;
+
+	list_for_each_entry_safe(ze, n, evicted, lru) {
+		list_del(&ze->lru);
+		z_erofs_zcache_put(ze);
+	}
+}
+
+static unsigned long z_erofs_zcache_shrink(struct erofs_sb_info *sbi,
+					   unsigned long nr)
+{
+	unsigned long freed = 0;
+	LIST_HEAD(evicted);
+
+	xa_lock(&sbi->zcache);
+	while (freed < nr && !list_empty(&sbi->zcache_lru)) {
+		z_erofs_zcache_evict(sbi, list_last_entry(&sbi->zcache_lru,
+				struct z_erofs_zcache_entry, lru), &evicted);
+		++freed;
+	}
+	xa_unlock(&sbi->zcache);
+	z_erofs_zcache_put_list(&evicted);
+	return freed;
+}
+
+static unsigned long z_erofs_zcache_max(struct erofs_sb_info *sbi)
+{
+	return (unsigned long)READ_ONCE(sbi->opt.zcache_max_kb) << 10;
+}
+
+static bool z_erofs_zcache_wanted(struct erofs_sb_info *sbi,
+				  struct z_erofs_pcluster *pcl)
+{
+	return !pcl->partial && !z_erofs_is_inline_pcluster(pcl) &&
+		pcl->algorithmformat < Z_EROFS_COMPRESSION_MAX &&
+		pcl->length <= z_erofs_zcache_max(sbi);
+}
+
+/* keep a copy of a fully decoded pcluster, best effort */
+static void z_erofs_zcache_insert(struct erofs_sb_info *sbi,
+				  struct z_erofs_pcluster *pcl,
+				  struct page **pages)
+{
+	unsigned long max = z_erofs_zcache_max(sbi);
+	unsigned int nrpages = PAGE_ALIGN(pcl->length) >> PAGE_SHIFT;
+	unsigned int i, cur, cnt, spos;
+	struct z_erofs_zcache_entry *ze;
+	LIST_HEAD(evicted);
+	void *src;
+
+	ze = kzalloc(struct_size(ze, pages, nrpages), GFP_NOWAIT | __GFP_NOWARN);
+	if (!ze)
+		return;
+	refcount_set(&ze->ref, 1);
+	ze->blkaddr = pcl->index;
+	ze->length = pcl->length;
+	ze->nrpages = nrpages;
+	for (i = 0; i < nrpages; ++i) {
+		ze->pages[i] = alloc_page(GFP_NOWAIT | __GFP_NOWARN);
+		if (!ze->pages[i])
+			goto out;
+	}
+
+	for (cur = 0; cur < ze->length; cur += cnt) {
+		spos = cur + pcl->pageofs_out;
+		cnt = min_t(unsigned int, ze->length - cur,
+			    PAGE_SIZE - (spos & ~PAGE_MASK));
+		cnt = min_t(unsigned int, cnt, PAGE_SIZE - (cur & ~PAGE_MASK));
+		if (!pages[spos >> PAGE_SHIFT])
+			goto out;
+		src = kmap_local_page(pages[spos >> PAGE_SHIFT]);
+		memcpy_to_page(ze->pages[cur >> PAGE_SHIFT], cur & ~PAGE_MASK,
+			       src + (spos & ~PAGE_MASK), cnt);
+		kunmap_local(src);
+	}
+
+	xa_lock(&sbi->zcache);
+	if (__xa_insert(&sbi->zcache, ze->blkaddr, ze, GFP_NOWAIT)) {
+		xa_unlock(&sbi->zcache);
+		goto out;
+	}
+	list_add(&ze->lru, &sbi->zcache_lru);
+	sbi->zcache_bytes += ze->length;
+	atomic_long_inc(&erofs_global_shrink_cnt);
+	while (sbi->zcache_bytes > max)
+		z_erofs_zcache_evict(sbi, list_last_entry(&sbi->zcache_lru,
+				struct z_erofs_zcache_entry, lru), &evicted);
+	xa_unlock(&sbi->zcache);
+	z_erofs_zcache_put_list(&evicted);
+	return;
+out:
+	z_erofs_zcache_put(ze);
+}
+
+/* fill [cur, end) of the folio from a cached pcluster if possible */
+static bool z_erofs_zcache_read(struct inode *inode,
+				struct erofs_map_blocks *map,
+				struct folio *folio, unsigned int cur,
+				unsigned int end)
+{
+	struct erofs_sb_info *sbi = EROFS_I_SB(inode);
+	erofs_off_t dpos = folio_pos(folio) + cur - map->m_la;
+	struct z_erofs_zcache_entry *ze;
+	unsigned int cnt;
+	void *src;
+
+	if (!READ_ONCE(sbi->opt.zcache_max_kb) ||
+	    (map->m_flags & EROFS_MAP_META) ||
+	    map->m_algorithmformat >= Z_EROFS_COMPRESSION_MAX)
+		return false;
+
+	xa_lock(&sbi->zcache);
+	ze = xa_load(&sbi->zcache, erofs_blknr(inode->i_sb, map->m_pa));
+	if (ze && dpos + end - cur <= ze->length) {
+		refcount_inc(&ze->ref);
+		list_move(&ze->lru, &sbi->zcache_lru);
+		++sbi->zcache_hits;
+	} else {
+		ze = NULL;
+		++sbi->zcache_misses;
+	}
+	xa_unlock(&sbi->zcache);
+	if (!ze)
+		return false;
+
+	for (; cur < end; cur += cnt, dpos += cnt) {
+		cnt = min_t(unsigned int, end - cur,
+			    PAGE_SIZE - (dpos & ~PAGE_MASK));
+		src = kmap_local_page(ze->pages[dpos >> PAGE_SHIFT]);
+		memcpy_to_folio(folio, cur, src + (dpos & ~PAGE_MASK), cnt);
+		kunmap_local(src);
+	}
+	z_erofs_zcache_put(ze);
+	return true;
+}
+
 /* callers must be with pcluster lock held */
 static int z_erofs_attach_page(struct z_erofs_decompress_frontend *fe,
 			       struct z_erofs_bvec *bvec, bool exclusive)
@@ -920,7 +1099,13 @@ unsigned long z_erofs_shrink_scan(struct erofs_sb_info *sbi,
 				  unsigned long nr_shrink)
 {
 	struct z_erofs_pcluster *pcl;
-	unsigned long index, freed = 0;
+	unsigned long index, freed;
+
+	/* decompressed copies go first, they are the cheapest to rebuild */
+	freed = z_erofs_zcache_shrink(sbi, nr_shrink);
+	nr_shrink -= freed;
+	if (!nr_shrink)
+		return freed;
 
 	xa_lock(&sbi->managed_pslots);
 	xa_for_each(&sbi->managed_pslots, index, pcl) {
@@ -1039,6 +1224,9 @@ static int z_erofs_scan_folio(struct z_erofs_decompress_frontend *f,
 			if (err)
 				break;
 			tight = false;
+		} else if (!f->pcl &&
+			   z_erofs_zcache_read(inode, map, folio, cur, end)) {
+			tight = false;
 		} else {
 			if (!f->pcl) {
 				err = z_erofs_pcluster_begin(f);
@@ -1270,9 +1458,10 @@ static int z_erofs_decompress_pcluster(struct z_erofs_decompress_backend *be,
 				z_erofs_decomp[pcl->algorithmformat];
 	int i, j, jtop, err2;
 	struct page *page;
-	bool overlapped;
+	bool overlapped, zcache;
 
 	mutex_lock(&pcl->lock);
+	zcache = z_erofs_zcache_wanted(sbi, pcl);
 	be->nr_pages = PAGE_ALIGN(pcl->length + pcl->pageofs_out) >> PAGE_SHIFT;
 
 	/* allocate (de)compressed page arrays if cannot be kept on stack */
@@ -1314,10 +1503,13 @@ static int z_erofs_decompress_pcluster(struct z_erofs_decompress_backend *be,
 					.alg = pcl->algorithmformat,
 					.inplace_io = overlapped,
 					.partial_decoding = pcl->partial,
-					.fillgaps = be->keepxcpy,
+					/* the zcache copy needs every page */
+					.fillgaps = be->keepxcpy || zcache,
 					.gfp = pcl->besteffort ? GFP_KERNEL :
 						GFP_NOWAIT | __GFP_NORETRY
 				 }, be->pagepool);
+	if (!err && zcache)
+		z_erofs_zcache_insert(sbi, pcl, be->decompressed_pages);
 
 	/* must handle all compressed pages before actual file pages */
 	if (z_erofs_is_inline_pcluster(pcl)) {
@@ -64,6 +64,31 @@ static ssize_t fuse_conn_waiting_read(struct file *file, char __user *buf,
 	return simple_read_from_buffer(buf, len, ppos, tmp, size);
 }
 
+static ssize_t fuse_conn_io_stats_read(struct file *file, char __user *buf,
+				       size_t len, loff_t *ppos)
+{
+	struct fuse_io_stats *stats;
+	struct fuse_conn *fc;
+	char tmp[128];
+	size_t size;
+
+	fc = fuse_ctl_file_conn_get(file);
+	if (!fc)
+		return 0;
+
+	stats = &fc->io_stats;
+	size = scnprintf(tmp, sizeof(tmp),
+			 "passthrough_read %lld\npassthrough_write %lld\n"
+			 "daemon_read %lld\ndaemon_write %lld\n",
+			 atomic64_read(&stats->passthrough_read),
+			 atomic64_read(&stats->passthrough_write),
+			 atomic64_read(&stats->daemon_read),
+			 atomic64_read(&stats->daemon_write));
+	fuse_conn_put(fc);
+
+	return simple_read_from_buffer(buf, len, ppos, tmp, size);
+}
+
 static ssize_t fuse_conn_limit_read(struct file *file, char __user *buf,
 				    size_t len, loff_t *ppos, unsigned val)
 {
@@ -190,6 +215,11 @@ static const struct file_operations fuse_ctl_waiting_ops = {
 	.read = fuse_conn_waiting_read,
 };
 
+static const struct file_operations fuse_ctl_io_stats_ops = {
+	.open = nonseekable_open,
+	.read = fuse_conn_io_stats_read,
+};
+
 static const struct file_operations fuse_conn_max_background_ops = {
 	.open = nonseekable_open,
 	.read = fuse_conn_max_background_read,
@@ -270,7 +300,9 @@ int fuse_ctl_add_conn(struct fuse_conn *fc)
 				 1, NULL, &fuse_conn_max_background_ops) ||
 	    !fuse_ctl_add_dentry(parent, fc, "congestion_threshold",
 				 S_IFREG | 0600, 1, NULL,
-				 &fuse_conn_congestion_threshold_ops))
+				 &fuse_conn_congestion_threshold_ops) ||
+	    !fuse_ctl_add_dentry(parent, fc, "io_stats", S_IFREG | 0400, 1,
+				 NULL, &fuse_ctl_io_stats_ops))
 		goto err;
 
 	return 0;
@@ -779,6 +779,9 @@ static void fuse_aio_complete_req(struct fuse_mount *fm, struct fuse_args *args,
 	}
 
 	fuse_release_user_pages(&ia->ap, err ?: nres, io->should_dirty);
+	if (!err)
+		fuse_account_io(file_inode(io->iocb->ki_filp), false, io->write,
+				nres);
 
 	fuse_aio_complete(io, err, pos);
 	fuse_io_free(ia);
@@ -888,6 +891,7 @@ static int fuse_do_readpage(struct file *file, struct page *page)
 	res = fuse_simple_request(fm, &ia.ap.args);
 	if (res < 0)
 		return res;
+	fuse_account_io(inode, false, false, res);
 	/*
 	 * Short read means EOF.  If file size is larger, truncate it
 	 */
@@ -937,6 +941,8 @@ static void fuse_readpages_end(struct fuse_mount *fm, struct fuse_args *args,
 		 */
 		if (!err && num_read < count)
 			fuse_short_read(inode, ia->read.attr_ver, num_read, ap);
+		if (!err)
+			fuse_account_io(inode, false, false, num_read);
 
 		fuse_invalidate_atime(inode);
 	}
@@ -1134,6 +1140,35 @@ bool fuse_write_update_attr(struct inode *inode, loff_t pos, ssize_t written)
 	return ret;
 }
 
+/*
+ * Account @bytes of file data moved for @inode, either directly on the
+ * backing file in passthrough mode or by a request served by the daemon.
+ */
+void fuse_account_io(struct inode *inode, bool passthrough, bool write,
+		     ssize_t bytes)
+{
+	struct fuse_io_stats *stats[] = {
+		&get_fuse_inode(inode)->io_stats,
+		&get_fuse_conn(inode)->io_stats,
+	};
+	int i;
+
+	if (bytes <= 0)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(stats); i++) {
+		atomic64_t *ctr;
+
+		if (passthrough)
+			ctr = write ? &stats[i]->passthrough_write :
+				      &stats[i]->passthrough_read;
+		else
+			ctr = write ? &stats[i]->daemon_write :
+				      &stats[i]->daemon_read;
+		atomic64_add(bytes, ctr);
+	}
+}
+
 static ssize_t fuse_send_write_pages(struct fuse_io_args *ia,
 				     struct kiocb *iocb, struct inode *inode,
 				     loff_t pos, size_t count)
@@ -1158,6 +1193,9 @@ static ssize_t fuse_send_write_pages(struct fuse_io_args *ia,
 	if (!err && ia->write.out.size > count)
 		err = -EIO;
 
+	if (!err)
+		fuse_account_io(inode, false, true, ia->write.out.size);
+
 	short_write = ia->write.out.size < count;
 	offset = ap->descs[0].offset;
 	count = ia->write.out.size;
@@ -1623,6 +1661,8 @@ ssize_t fuse_direct_io(struct fuse_io_priv *io, struct iov_iter *iter,
 			fuse_release_user_pages(&ia->ap, nres, io->should_dirty);
 			fuse_io_free(ia);
 		}
+		if (!io->async)
+			fuse_account_io(inode, false, write, nres);
 		ia = NULL;
 		if (nres < 0) {
 			iov_iter_revert(iter, nbytes);
@@ -1943,6 +1983,8 @@ static void fuse_writepage_end(struct fuse_mount *fm, struct fuse_args *args,
 	struct fuse_conn *fc = get_fuse_conn(inode);
 
 	mapping_set_error(inode->i_mapping, error);
+	if (!error)
+		fuse_account_io(inode, false, true, wpa->ia.write.out.size);
 	/*
 	 * A writeback finished and this might have updated mtime/ctime on
 	 * server making local mtime/ctime stale.  Hence invalidate attrs.
@@ -3304,6 +3346,7 @@ static ssize_t __fuse_copy_file_range(struct file *file_in, loff_t pos_in,
 
 	file_update_time(file_out);
 	fuse_write_update_attr(inode_out, pos_out + outarg.size, outarg.size);
+	fuse_account_io(inode_out, false, true, outarg.size);
 
 	err = outarg.size;
 out:
@@ -3322,10 +3365,20 @@ static ssize_t fuse_copy_file_range(struct file *src_file, loff_t src_off,
 				    struct file *dst_file, loff_t dst_off,
 				    size_t len, unsigned int flags)
 {
+	struct fuse_file *ff_in = src_file->private_data;
+	struct fuse_file *ff_out = dst_file->private_data;
 	ssize_t ret;
 
-	ret = __fuse_copy_file_range(src_file, src_off, dst_file, dst_off,
-				     len, flags);
+	/* FOPEN_DIRECT_IO overrides FOPEN_PASSTHROUGH */
+	if (fuse_file_passthrough(ff_in) && fuse_file_passthrough(ff_out) &&
+	    !(ff_in->open_flags & FOPEN_DIRECT_IO) &&
+	    !(ff_out->open_flags & FOPEN_DIRECT_IO))
+		ret = fuse_passthrough_copy_file_range(src_file, src_off,
+						       dst_file, dst_off,
+						       len, flags);
+	else
+		ret = __fuse_copy_file_range(src_file, src_off, dst_file,
+					     dst_off, len, flags);
 
 	if (ret == -EOPNOTSUPP || ret == -EXDEV)
 		ret = splice_copy_file_range(src_file, src_off, dst_file,
@@ -124,6 +124,39 @@ TRACE_EVENT(fuse_request_end,
 		  __entry->unique, __entry->len, __entry->error)
 );
 
+TRACE_EVENT(fuse_inode_io_stats,
+	TP_PROTO(struct inode *inode),
+
+	TP_ARGS(inode),
+
+	TP_STRUCT__entry(
+		__field(dev_t,		connection)
+		__field(uint64_t,	nodeid)
+		__field(uint64_t,	passthrough_read)
+		__field(uint64_t,	passthrough_write)
+		__field(uint64_t,	daemon_read)
+		__field(uint64_t,	daemon_write)
+	),
+
+	TP_fast_assign(
+		__entry->connection	=	get_fuse_conn(inode)->dev;
+		__entry->nodeid		=	get_fuse_inode(inode)->nodeid;
+		__entry->passthrough_read = atomic64_read(
+			&get_fuse_inode(inode)->io_stats.passthrough_read);
+		__entry->passthrough_write = atomic64_read(
+			&get_fuse_inode(inode)->io_stats.passthrough_write);
+		__entry->daemon_read	= atomic64_read(
+			&get_fuse_inode(inode)->io_stats.daemon_read);
+		__entry->daemon_write	= atomic64_read(
+			&get_fuse_inode(inode)->io_stats.daemon_write);
+	),
+
+	TP_printk("connection %u nodeid %llu passthrough read %llu write %llu daemon read %llu write %llu",
+		  __entry->connection, __entry->nodeid,
+		  __entry->passthrough_read, __entry->passthrough_write,
+		  __entry->daemon_read, __entry->daemon_write)
+);
+
 #endif /* _TRACE_FUSE_H */
 
 #undef TRACE_INCLUDE_PATH
@@ -24,6 +24,7 @@
 #include <linux/posix_acl.h>
 #include <linux/pid_namespace.h>
 #include <uapi/linux/magic.h>
+#include "fuse_trace.h"
 
 MODULE_AUTHOR("Miklos Szeredi <miklos@szeredi.hu>");
 MODULE_DESCRIPTION("Filesystem in Userspace");
@@ -102,6 +103,7 @@ static struct inode *fuse_alloc_inode(struct super_block *sb)
 	fi->orig_ino = 0;
 	fi->state = 0;
 	fi->submount_lookup = NULL;
+	memset(&fi->io_stats, 0, sizeof(fi->io_stats));
 	mutex_init(&fi->mutex);
 	spin_lock_init(&fi->lock);
 	fi->forget = fuse_alloc_forget();
@@ -174,6 +176,8 @@ static void fuse_evict_inode(struct inode *inode)
 			fi->submount_lookup = NULL;
 		}
 	}
+	if (S_ISREG(inode->i_mode))
+		trace_fuse_inode_io_stats(inode);
 	if (S_ISREG(inode->i_mode) && !fuse_is_bad(inode)) {
 		WARN_ON(fi->iocachectr != 0);
 		WARN_ON(!list_empty(&fi->write_files));
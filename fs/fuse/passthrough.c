@@ -47,6 +47,7 @@ ssize_t fuse_passthrough_read_iter(struct kiocb *iocb, struct iov_iter *iter)
 
 	ret = backing_file_read_iter(backing_file, iter, iocb, iocb->ki_flags,
 				     &ctx);
+	fuse_account_io(file_inode(file), true, false, ret);
 
 	return ret;
 }
@@ -76,6 +77,7 @@ ssize_t fuse_passthrough_write_iter(struct kiocb *iocb,
 	ret = backing_file_write_iter(backing_file, iter, iocb, iocb->ki_flags,
 				      &ctx);
 	inode_unlock(inode);
+	fuse_account_io(inode, true, true, ret);
 
 	return ret;
 }
@@ -86,6 +88,7 @@ ssize_t fuse_passthrough_splice_read(struct file *in, loff_t *ppos,
 {
 	struct fuse_file *ff = in->private_data;
 	struct file *backing_file = fuse_file_passthrough(ff);
+	ssize_t ret;
 	struct backing_file_ctx ctx = {
 		.cred = ff->cred,
 		.user_file = in,
@@ -95,8 +98,11 @@ ssize_t fuse_passthrough_splice_read(struct file *in, loff_t *ppos,
 	pr_debug("%s: backing_file=0x%p, pos=%lld, len=%zu, flags=0x%x\n", __func__,
 		 backing_file, ppos ? *ppos : 0, len, flags);
 
-	return backing_file_splice_read(backing_file, ppos, pipe, len, flags,
-					&ctx);
+	ret = backing_file_splice_read(backing_file, ppos, pipe, len, flags,
+				       &ctx);
+	fuse_account_io(file_inode(in), true, false, ret);
+
+	return ret;
 }
 
 ssize_t fuse_passthrough_splice_write(struct pipe_inode_info *pipe,
@@ -120,6 +126,7 @@ ssize_t fuse_passthrough_splice_write(struct pipe_inode_info *pipe,
 	ret = backing_file_splice_write(pipe, backing_file, ppos, len, flags,
 					&ctx);
 	inode_unlock(inode);
+	fuse_account_io(inode, true, true, ret);
 
 	return ret;
 }
@@ -140,6 +147,46 @@ ssize_t fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
 	return backing_file_mmap(backing_file, vma, &ctx);
 }
 
+/*
+ * Copy between two passthrough files directly on the backing files, which
+ * lets the backing filesystem clone or copy offload instead of bouncing the
+ * data through the daemon or the page cache.
+ */
+ssize_t fuse_passthrough_copy_file_range(struct file *file_in, loff_t pos_in,
+					 struct file *file_out, loff_t pos_out,
+					 size_t len, unsigned int flags)
+{
+	struct fuse_file *ff_in = file_in->private_data;
+	struct fuse_file *ff_out = file_out->private_data;
+	struct inode *inode_out = file_inode(file_out);
+	const struct cred *old_cred;
+	ssize_t ret;
+
+	pr_debug("%s: backing_in=0x%p, pos_in=%lld, backing_out=0x%p, pos_out=%lld, len=%zu\n",
+		 __func__, ff_in->passthrough, pos_in, ff_out->passthrough,
+		 pos_out, len);
+
+	/* the backing files must be accessed with a single set of creds */
+	if (ff_in->cred != ff_out->cred)
+		return -EXDEV;
+
+	inode_lock(inode_out);
+	old_cred = override_creds(ff_out->cred);
+	ret = vfs_copy_file_range(ff_in->passthrough, pos_in,
+				  ff_out->passthrough, pos_out, len, flags);
+	revert_creds(old_cred);
+	if (ret > 0) {
+		fuse_passthrough_end_write(file_out, pos_out + ret, ret);
+		fuse_file_accessed(file_in);
+	}
+	inode_unlock(inode_out);
+
+	fuse_account_io(file_inode(file_in), true, false, ret);
+	fuse_account_io(inode_out, true, true, ret);
+
+	return ret;
+}
+
 struct fuse_backing *fuse_backing_get(struct fuse_backing *fb)
 {
 	if (fb && refcount_inc_not_zero(&fb->count))
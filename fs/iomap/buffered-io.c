@@ -17,12 +17,24 @@
 #include <linux/bio.h>
 #include <linux/sched/signal.h>
 #include <linux/migrate.h>
+#include <linux/log2.h>
 #include "trace.h"
 
 #include "../internal.h"
 
 #define IOEND_BATCH_SIZE	4096
 
+/*
+ * Flash devices such as eMMC perform best when writes fill whole erase or
+ * allocation units.  When set, buffered writeback never lets an ioend cross
+ * a boundary of this size on the device, and tries to finish the unit it is
+ * in before giving up on a non-integrity writeback pass.
+ */
+static unsigned int iomap_wb_cluster_kb;
+module_param_named(writeback_cluster_kb, iomap_wb_cluster_kb, uint, 0644);
+MODULE_PARM_DESC(writeback_cluster_kb,
+		 "align buffered writeback I/O to this many KiB (0 = off)");
+
 /*
  * Structure allocated for each folio to track per-block uptodate, dirty state
  * and I/O completions.
@@ -1682,6 +1694,8 @@ static int iomap_submit_ioend(struct iomap_writepage_ctx *wpc, int error)
 	if (!wpc->ioend)
 		return error;
 
+	trace_iomap_submit_ioend(wpc->ioend);
+
 	/*
 	 * Let the file systems prepare the I/O submission and hook in an I/O
 	 * comletion handler.  This also needs to happen in case after a
@@ -1729,8 +1743,26 @@ static struct iomap_ioend *iomap_alloc_ioend(struct iomap_writepage_ctx *wpc,
 	return ioend;
 }
 
+/* Writeback cluster size in sectors, a power of two, or 0 if disabled. */
+static sector_t iomap_wb_cluster_sectors(void)
+{
+	unsigned int kb = READ_ONCE(iomap_wb_cluster_kb);
+
+	if (!kb)
+		return 0;
+	return (sector_t)rounddown_pow_of_two(kb) << (10 - SECTOR_SHIFT);
+}
+
+/* Sectors left until the next cluster boundary, 0 if @sector is on one. */
+static sector_t iomap_wb_cluster_rem(sector_t cluster, sector_t sector)
+{
+	return (cluster - (sector & (cluster - 1))) & (cluster - 1);
+}
+
 static bool iomap_can_add_to_ioend(struct iomap_writepage_ctx *wpc, loff_t pos)
 {
+	sector_t cluster = iomap_wb_cluster_sectors();
+
 	if ((wpc->iomap.flags & IOMAP_F_SHARED) !=
 	    (wpc->ioend->io_flags & IOMAP_F_SHARED))
 		return false;
@@ -1748,6 +1780,9 @@ static bool iomap_can_add_to_ioend(struct iomap_writepage_ctx *wpc, loff_t pos)
 	 */
 	if (wpc->nr_folios >= IOEND_BATCH_SIZE)
 		return false;
+	if (cluster &&
+	    !iomap_wb_cluster_rem(cluster, bio_end_sector(&wpc->ioend->io_bio)))
+		return false;
 	return true;
 }
 
@@ -1834,6 +1869,38 @@ static int iomap_add_to_ioend(struct iomap_writepage_ctx *wpc,
 	return 0;
 }
 
+/*
+ * Add a mapped range to the ioend, splitting it at writeback cluster
+ * boundaries so that no ioend spans two clusters.
+ */
+static int iomap_add_clustered(struct iomap_writepage_ctx *wpc,
+		struct writeback_control *wbc, struct folio *folio,
+		struct inode *inode, loff_t pos, loff_t end_pos,
+		unsigned len)
+{
+	sector_t cluster = iomap_wb_cluster_sectors();
+	sector_t rem;
+	unsigned int plen;
+	int error;
+
+	if (!cluster)
+		return iomap_add_to_ioend(wpc, wbc, folio, inode, pos,
+				end_pos, len);
+
+	do {
+		rem = iomap_wb_cluster_rem(cluster,
+				iomap_sector(&wpc->iomap, pos));
+		plen = len;
+		if (rem && ((u64)rem << SECTOR_SHIFT) < len)
+			plen = rem << SECTOR_SHIFT;
+		error = iomap_add_to_ioend(wpc, wbc, folio, inode, pos,
+				end_pos, plen);
+		pos += plen;
+		len -= plen;
+	} while (len && !error);
+	return error;
+}
+
 static int iomap_writepage_map_blocks(struct iomap_writepage_ctx *wpc,
 		struct writeback_control *wbc, struct folio *folio,
 		struct inode *inode, u64 pos, u64 end_pos,
@@ -1861,7 +1928,7 @@ static int iomap_writepage_map_blocks(struct iomap_writepage_ctx *wpc,
 		case IOMAP_HOLE:
 			break;
 		default:
-			error = iomap_add_to_ioend(wpc, wbc, folio, inode, pos,
+			error = iomap_add_clustered(wpc, wbc, folio, inode, pos,
 					end_pos, map_len);
 			if (!error)
 				(*count)++;
@@ -2030,12 +2097,41 @@ static int iomap_writepage_map(struct iomap_writepage_ctx *wpc,
 	return error;
 }
 
+/*
+ * If this folio uses up the budget of a non-integrity writeback pass while
+ * the current ioend stops short of a cluster boundary, allow enough pages to
+ * reach it so that the device sees a full cluster rather than a fragment
+ * that the next pass completes.  This is only done once per call so that
+ * the budget overshoots by one cluster at most.
+ */
+static bool iomap_writeback_extend(struct iomap_writepage_ctx *wpc,
+		struct writeback_control *wbc, struct folio *folio)
+{
+	sector_t cluster = iomap_wb_cluster_sectors();
+	sector_t rem;
+
+	if (!cluster || !wpc->ioend || wbc->sync_mode != WB_SYNC_NONE)
+		return false;
+	/* writeback_iter() charges the folio when asked for the next one */
+	if (wbc->nr_to_write > folio_nr_pages(folio))
+		return false;
+
+	rem = iomap_wb_cluster_rem(cluster,
+			bio_end_sector(&wpc->ioend->io_bio));
+	if (!rem)
+		return false;
+	wbc->nr_to_write = folio_nr_pages(folio) +
+		DIV_ROUND_UP((u64)rem << SECTOR_SHIFT, PAGE_SIZE);
+	return true;
+}
+
 int
 iomap_writepages(struct address_space *mapping, struct writeback_control *wbc,
 		struct iomap_writepage_ctx *wpc,
 		const struct iomap_writeback_ops *ops)
 {
 	struct folio *folio = NULL;
+	bool extended = false;
 	int error;
 
 	/*
@@ -2047,8 +2143,11 @@ iomap_writepages(struct address_space *mapping, struct writeback_control *wbc,
 		return -EIO;
 
 	wpc->ops = ops;
-	while ((folio = writeback_iter(mapping, wbc, folio, &error)))
+	while ((folio = writeback_iter(mapping, wbc, folio, &error))) {
 		error = iomap_writepage_map(wpc, wbc, folio);
+		if (!extended)
+			extended = iomap_writeback_extend(wpc, wbc, folio);
+	}
 	return iomap_submit_ioend(wpc, error);
 }
 EXPORT_SYMBOL_GPL(iomap_writepages);
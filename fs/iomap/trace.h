@@ -197,6 +197,38 @@ TRACE_EVENT(iomap_writepage_map,
 		  __print_flags(__entry->flags, "|", IOMAP_F_FLAGS_STRINGS))
 );
 
+TRACE_EVENT(iomap_submit_ioend,
+	TP_PROTO(struct iomap_ioend *ioend),
+	TP_ARGS(ioend),
+	TP_STRUCT__entry(
+		__field(dev_t, dev)
+		__field(u64, ino)
+		__field(loff_t, offset)
+		__field(size_t, size)
+		__field(sector_t, sector)
+		__field(unsigned int, bio_size)
+		__field(u16, type)
+	),
+	TP_fast_assign(
+		__entry->dev = ioend->io_inode->i_sb->s_dev;
+		__entry->ino = ioend->io_inode->i_ino;
+		__entry->offset = ioend->io_offset;
+		__entry->size = ioend->io_size;
+		__entry->sector = ioend->io_sector;
+		__entry->bio_size = ioend->io_bio.bi_iter.bi_size;
+		__entry->type = ioend->io_type;
+	),
+	TP_printk("dev %d:%d ino 0x%llx offset 0x%llx size 0x%zx sector 0x%llx "
+		  "bio_size 0x%x type %s",
+		  MAJOR(__entry->dev), MINOR(__entry->dev),
+		  __entry->ino,
+		  __entry->offset,
+		  __entry->size,
+		  (unsigned long long)__entry->sector,
+		  __entry->bio_size,
+		  __print_symbolic(__entry->type, IOMAP_TYPE_STRINGS))
+);
+
 TRACE_EVENT(iomap_iter,
 	TP_PROTO(struct iomap_iter *iter, const void *ops,
 		 unsigned long caller),
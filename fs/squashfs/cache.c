@@ -17,7 +17,9 @@
  * access the metadata and fragment caches.
  *
  * To avoid out of memory and fragmentation issues with vmalloc the cache
- * uses sequences of kmalloced PAGE_SIZE buffers.
+ * uses sequences of kmalloced PAGE_SIZE buffers.  Under memory pressure the
+ * buffers of idle entries beyond the reserved ones are given back, and
+ * allocated again when the entry is next used.
  *
  * It should be noted that the cache is not used for file datablocks, these
  * are decompressed and cached in the page-cache in the normal way.  The
@@ -45,6 +47,33 @@
 #include "squashfs.h"
 #include "page_actor.h"
 
+static void squashfs_cache_free_buffers(struct squashfs_cache *cache,
+	struct squashfs_cache_entry *entry)
+{
+	int j;
+
+	for (j = 0; j < cache->pages; j++) {
+		kfree(entry->data[j]);
+		entry->data[j] = NULL;
+	}
+}
+
+static int squashfs_cache_alloc_buffers(struct squashfs_cache *cache,
+	struct squashfs_cache_entry *entry)
+{
+	int j;
+
+	for (j = 0; j < cache->pages; j++) {
+		entry->data[j] = kmalloc(PAGE_SIZE, GFP_KERNEL);
+		if (entry->data[j] == NULL) {
+			squashfs_cache_free_buffers(cache, entry);
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
 /*
  * Look-up block in cache, and increment usage count.  If not in cache, read
  * and decompress it from disk.
@@ -100,6 +129,7 @@ struct squashfs_cache_entry *squashfs_cache_get(struct super_block *sb,
 			 * disk.
 			 */
 			cache->unused--;
+			cache->misses++;
 			entry->block = block;
 			entry->refcount = 1;
 			entry->pending = 1;
@@ -107,11 +137,25 @@ struct squashfs_cache_entry *squashfs_cache_get(struct super_block *sb,
 			entry->error = 0;
 			spin_unlock(&cache->lock);
 
-			entry->length = squashfs_read_data(sb, block, length,
-				&entry->next_index, entry->actor);
+			/* The buffers may have been reclaimed by the shrinker */
+			if (entry->data[0] == NULL &&
+			    squashfs_cache_alloc_buffers(cache, entry))
+				entry->length = -ENOMEM;
+			else
+				entry->length = squashfs_read_data(sb, block,
+					length, &entry->next_index,
+					entry->actor);
 
 			spin_lock(&cache->lock);
 
+			if (entry->data[0] == NULL) {
+				/* Don't keep a transient failure cached */
+				entry->block = SQUASHFS_INVALID_BLK;
+			} else if (!entry->populated) {
+				entry->populated = 1;
+				cache->populated++;
+			}
+
 			if (entry->length < 0)
 				entry->error = entry->length;
 
@@ -141,6 +185,7 @@ struct squashfs_cache_entry *squashfs_cache_get(struct super_block *sb,
 		if (entry->refcount == 0)
 			cache->unused--;
 		entry->refcount++;
+		cache->hits++;
 
 		/*
 		 * If the entry is currently being filled in by another process
@@ -191,20 +236,80 @@ void squashfs_cache_put(struct squashfs_cache_entry *entry)
 	spin_unlock(&cache->lock);
 }
 
+/*
+ * Number of entries whose buffers could be reclaimed right now: idle,
+ * populated entries above the reserved count.
+ */
+unsigned long squashfs_cache_count(struct squashfs_cache *cache)
+{
+	unsigned long count = 0;
+	int i;
+
+	if (cache == NULL)
+		return 0;
+
+	spin_lock(&cache->lock);
+	if (cache->populated > cache->reserved) {
+		for (i = 0; i < cache->entries; i++)
+			if (cache->entry[i].populated &&
+			    cache->entry[i].refcount == 0)
+				count++;
+		count = min_t(unsigned long, count,
+			      cache->populated - cache->reserved);
+	}
+	spin_unlock(&cache->lock);
+
+	return count;
+}
+
+/*
+ * Free the buffers of up to nr idle entries, in eviction order, keeping
+ * at least the reserved number of entries populated.  Returns the number
+ * of entries freed.
+ */
+unsigned long squashfs_cache_shrink(struct squashfs_cache *cache,
+	unsigned long nr)
+{
+	unsigned long freed = 0;
+	int i, n;
+
+	if (cache == NULL)
+		return 0;
+
+	spin_lock(&cache->lock);
+	i = cache->next_blk;
+	for (n = 0; n < cache->entries && freed < nr &&
+	     cache->populated > cache->reserved; n++) {
+		struct squashfs_cache_entry *entry = &cache->entry[i];
+
+		if (entry->populated && entry->refcount == 0) {
+			squashfs_cache_free_buffers(cache, entry);
+			entry->block = SQUASHFS_INVALID_BLK;
+			entry->populated = 0;
+			cache->populated--;
+			cache->reclaimed++;
+			freed++;
+		}
+		i = (i + 1) % cache->entries;
+	}
+	spin_unlock(&cache->lock);
+
+	return freed;
+}
+
 /*
  * Delete cache reclaiming all kmalloced buffers.
  */
 void squashfs_cache_delete(struct squashfs_cache *cache)
 {
-	int i, j;
+	int i;
 
 	if (cache == NULL)
 		return;
 
 	for (i = 0; i < cache->entries; i++) {
 		if (cache->entry[i].data) {
-			for (j = 0; j < cache->pages; j++)
-				kfree(cache->entry[i].data[j]);
+			squashfs_cache_free_buffers(cache, &cache->entry[i]);
 			kfree(cache->entry[i].data);
 		}
 		kfree(cache->entry[i].actor);
@@ -218,12 +323,14 @@ void squashfs_cache_delete(struct squashfs_cache *cache)
 /*
  * Initialise cache allocating the specified number of entries, each of
  * size block_size.  To avoid vmalloc fragmentation issues each entry
- * is allocated as a sequence of kmalloced PAGE_SIZE buffers.
+ * is allocated as a sequence of kmalloced PAGE_SIZE buffers.  All entries
+ * are reserved, i.e. not reclaimable, until the caller lowers
+ * cache->reserved.
  */
 struct squashfs_cache *squashfs_cache_init(char *name, int entries,
 	int block_size)
 {
-	int i, j;
+	int i;
 	struct squashfs_cache *cache = kzalloc(sizeof(*cache), GFP_KERNEL);
 
 	if (cache == NULL) {
@@ -246,6 +353,7 @@ struct squashfs_cache *squashfs_cache_init(char *name, int entries,
 	cache->pages = cache->pages ? cache->pages : 1;
 	cache->name = name;
 	cache->num_waiters = 0;
+	cache->reserved = entries;
 	spin_lock_init(&cache->lock);
 	init_waitqueue_head(&cache->wait_queue);
 
@@ -261,13 +369,12 @@ struct squashfs_cache *squashfs_cache_init(char *name, int entries,
 			goto cleanup;
 		}
 
-		for (j = 0; j < cache->pages; j++) {
-			entry->data[j] = kmalloc(PAGE_SIZE, GFP_KERNEL);
-			if (entry->data[j] == NULL) {
-				ERROR("Failed to allocate %s buffer\n", name);
-				goto cleanup;
-			}
+		if (squashfs_cache_alloc_buffers(cache, entry)) {
+			ERROR("Failed to allocate %s buffer\n", name);
+			goto cleanup;
 		}
+		entry->populated = 1;
+		cache->populated++;
 
 		entry->actor = squashfs_page_actor_init(entry->data,
 						cache->pages, 0);
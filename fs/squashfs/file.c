@@ -34,6 +34,8 @@
 #include <linux/string.h>
 #include <linux/pagemap.h>
 #include <linux/mutex.h>
+#include <linux/completion.h>
+#include <linux/workqueue.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -563,6 +565,98 @@ static int squashfs_readahead_fragment(struct page **page,
 	return 1;
 }
 
+/*
+ * The datablocks of a readahead window are independent of each other.  When
+ * the decompressor implementation allows several blocks to be decompressed
+ * at once, the blocks are read and decompressed on the readahead workqueue,
+ * and their pages are completed in file order by the readahead caller.
+ */
+struct squashfs_ra_block {
+	struct work_struct	work;
+	struct completion	done;
+	struct super_block	*sb;
+	struct page		**pages;
+	struct page		*last_page;
+	unsigned int		nr_pages;
+	unsigned int		expected;
+	loff_t			start;
+	u64			block;
+	int			bsize;
+	int			res;
+	bool			tail;
+};
+
+static struct workqueue_struct *squashfs_readahead_wq;
+
+static void squashfs_readahead_block(struct squashfs_ra_block *rab)
+{
+	struct squashfs_sb_info *msblk = rab->sb->s_fs_info;
+	struct squashfs_page_actor *actor;
+
+	actor = squashfs_page_actor_init_special(msblk, rab->pages,
+				rab->nr_pages, rab->expected, rab->start);
+	if (!actor) {
+		rab->res = -ENOMEM;
+		rab->last_page = NULL;
+		return;
+	}
+
+	rab->res = squashfs_read_data(rab->sb, rab->block, rab->bsize, NULL,
+				      actor);
+	rab->last_page = squashfs_page_actor_free(actor);
+}
+
+static void squashfs_readahead_work(struct work_struct *work)
+{
+	struct squashfs_ra_block *rab = container_of(work,
+					struct squashfs_ra_block, work);
+
+	squashfs_readahead_block(rab);
+	complete(&rab->done);
+}
+
+static void squashfs_readahead_complete(struct squashfs_ra_block *rab)
+{
+	int i;
+
+	if (rab->res == rab->expected && !IS_ERR(rab->last_page)) {
+		int bytes;
+
+		/* Last page (if present) may have trailing bytes not filled */
+		bytes = rab->res % PAGE_SIZE;
+		if (rab->tail && bytes && rab->last_page)
+			memzero_page(rab->last_page, bytes, PAGE_SIZE - bytes);
+
+		for (i = 0; i < rab->nr_pages; i++) {
+			flush_dcache_page(rab->pages[i]);
+			SetPageUptodate(rab->pages[i]);
+		}
+	}
+
+	for (i = 0; i < rab->nr_pages; i++) {
+		unlock_page(rab->pages[i]);
+		put_page(rab->pages[i]);
+	}
+}
+
+/*
+ * Number of datablocks of a readahead window of len bytes which may be in
+ * flight at once.  A single decompressor serialises the blocks anyway, so
+ * keep the work in the caller then.
+ */
+static unsigned int squashfs_readahead_slots(struct squashfs_sb_info *msblk,
+					     size_t len)
+{
+	unsigned int blocks = DIV_ROUND_UP(len, msblk->block_size);
+
+	if (!squashfs_readahead_wq || msblk->max_thread_num <= 1)
+		return 1;
+
+	return clamp_t(unsigned int, blocks, 1,
+		       min_t(unsigned int, msblk->max_thread_num,
+			     num_online_cpus()));
+}
+
 static void squashfs_readahead(struct readahead_control *ractl)
 {
 	struct inode *inode = ractl->mapping->host;
@@ -571,8 +665,9 @@ static void squashfs_readahead(struct readahead_control *ractl)
 	unsigned short shift = msblk->block_log - PAGE_SHIFT;
 	loff_t start = readahead_pos(ractl) & ~mask;
 	size_t len = readahead_length(ractl) + readahead_pos(ractl) - start;
-	struct squashfs_page_actor *actor;
-	unsigned int nr_pages = 0;
+	unsigned int nr_slots = squashfs_readahead_slots(msblk, len);
+	unsigned int head = 0, queued = 0;
+	struct squashfs_ra_block *rab, *cur = NULL;
 	struct page **pages;
 	int i;
 	loff_t file_end = i_size_read(inode) >> msblk->block_log;
@@ -580,15 +675,31 @@ static void squashfs_readahead(struct readahead_control *ractl)
 
 	readahead_expand(ractl, start, (len | mask) + 1);
 
-	pages = kmalloc_array(max_pages, sizeof(void *), GFP_KERNEL);
-	if (!pages)
-		return;
+	rab = kcalloc(nr_slots, sizeof(*rab), GFP_KERNEL);
+	pages = kmalloc_array(nr_slots * max_pages, sizeof(void *), GFP_KERNEL);
+	if (!rab || !pages)
+		goto out;
+
+	for (i = 0; i < nr_slots; i++) {
+		rab[i].sb = inode->i_sb;
+		rab[i].pages = pages + i * max_pages;
+		INIT_WORK(&rab[i].work, squashfs_readahead_work);
+		init_completion(&rab[i].done);
+	}
 
 	for (;;) {
 		int res, bsize;
 		u64 block = 0;
 		unsigned int expected;
-		struct page *last_page;
+
+		/* Complete the oldest block in flight to free its slot */
+		if (queued == nr_slots) {
+			wait_for_completion(&rab[head].done);
+			squashfs_readahead_complete(&rab[head]);
+			head = (head + 1) % nr_slots;
+			queued--;
+		}
+		cur = &rab[(head + queued) % nr_slots];
 
 		expected = start >> msblk->block_log == file_end ?
 			   (i_size_read(inode) & (msblk->block_size - 1)) :
@@ -596,8 +707,8 @@ static void squashfs_readahead(struct readahead_control *ractl)
 
 		max_pages = (expected + PAGE_SIZE - 1) >> PAGE_SHIFT;
 
-		nr_pages = __readahead_batch(ractl, pages, max_pages);
-		if (!nr_pages)
+		cur->nr_pages = __readahead_batch(ractl, cur->pages, max_pages);
+		if (!cur->nr_pages)
 			break;
 
 		if (readahead_pos(ractl) >= i_size_read(inode))
@@ -605,8 +716,8 @@ static void squashfs_readahead(struct readahead_control *ractl)
 
 		if (start >> msblk->block_log == file_end &&
 				squashfs_i(inode)->fragment_block != SQUASHFS_INVALID_BLK) {
-			res = squashfs_readahead_fragment(pages, nr_pages,
-							  expected, start);
+			res = squashfs_readahead_fragment(cur->pages,
+					cur->nr_pages, expected, start);
 			if (res)
 				goto skip_pages;
 			continue;
@@ -616,47 +727,59 @@ static void squashfs_readahead(struct readahead_control *ractl)
 		if (bsize == 0)
 			goto skip_pages;
 
-		actor = squashfs_page_actor_init_special(msblk, pages, nr_pages,
-							expected, start);
-		if (!actor)
-			goto skip_pages;
-
-		res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
-
-		last_page = squashfs_page_actor_free(actor);
+		cur->block = block;
+		cur->bsize = bsize;
+		cur->expected = expected;
+		cur->start = start;
+		cur->tail = start >> msblk->block_log == file_end;
 
-		if (res == expected && !IS_ERR(last_page)) {
-			int bytes;
-
-			/* Last page (if present) may have trailing bytes not filled */
-			bytes = res % PAGE_SIZE;
-			if (start >> msblk->block_log == file_end && bytes && last_page)
-				memzero_page(last_page, bytes,
-					     PAGE_SIZE - bytes);
-
-			for (i = 0; i < nr_pages; i++) {
-				flush_dcache_page(pages[i]);
-				SetPageUptodate(pages[i]);
-			}
-		}
-
-		for (i = 0; i < nr_pages; i++) {
-			unlock_page(pages[i]);
-			put_page(pages[i]);
+		if (nr_slots > 1) {
+			reinit_completion(&cur->done);
+			queue_work(squashfs_readahead_wq, &cur->work);
+			queued++;
+		} else {
+			squashfs_readahead_block(cur);
+			squashfs_readahead_complete(cur);
 		}
 
 		start += readahead_batch_length(ractl);
 	}
 
-	kfree(pages);
-	return;
+	cur = NULL;
 
 skip_pages:
-	for (i = 0; i < nr_pages; i++) {
-		unlock_page(pages[i]);
-		put_page(pages[i]);
+	/* Blocks already in flight still complete, in order */
+	for (; queued; queued--, head = (head + 1) % nr_slots) {
+		wait_for_completion(&rab[head].done);
+		squashfs_readahead_complete(&rab[head]);
+	}
+
+	if (cur) {
+		for (i = 0; i < cur->nr_pages; i++) {
+			unlock_page(cur->pages[i]);
+			put_page(cur->pages[i]);
+		}
 	}
+
+out:
 	kfree(pages);
+	kfree(rab);
+}
+
+int __init squashfs_readahead_init(void)
+{
+	if (num_possible_cpus() == 1)
+		return 0;
+
+	squashfs_readahead_wq = alloc_workqueue("squashfs_ra",
+					WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+	return squashfs_readahead_wq ? 0 : -ENOMEM;
+}
+
+void squashfs_readahead_destroy(void)
+{
+	if (squashfs_readahead_wq)
+		destroy_workqueue(squashfs_readahead_wq);
 }
 
 const struct address_space_operations squashfs_aops = {
@@ -21,6 +21,9 @@ extern int squashfs_read_data(struct super_block *, u64, int, u64 *,
 /* cache.c */
 extern struct squashfs_cache *squashfs_cache_init(char *, int, int);
 extern void squashfs_cache_delete(struct squashfs_cache *);
+extern unsigned long squashfs_cache_count(struct squashfs_cache *);
+extern unsigned long squashfs_cache_shrink(struct squashfs_cache *,
+				unsigned long);
 extern struct squashfs_cache_entry *squashfs_cache_get(struct super_block *,
 				struct squashfs_cache *, u64, int);
 extern void squashfs_cache_put(struct squashfs_cache_entry *);
@@ -70,6 +73,8 @@ extern __le64 *squashfs_read_fragment_index_table(struct super_block *,
 void squashfs_fill_page(struct page *, struct squashfs_cache_entry *, int, int);
 void squashfs_copy_cache(struct page *, struct squashfs_cache_entry *, int,
 				int);
+extern int squashfs_readahead_init(void);
+extern void squashfs_readahead_destroy(void);
 
 /* file_xxx.c */
 extern int squashfs_readpage_block(struct page *, u64, int, int);
@@ -84,6 +89,12 @@ extern struct inode *squashfs_iget(struct super_block *, long long,
 				unsigned int);
 extern int squashfs_read_inode(struct inode *, long long);
 
+/* sysfs.c */
+extern int squashfs_register_sysfs(struct super_block *);
+extern void squashfs_unregister_sysfs(struct super_block *);
+extern int squashfs_init_sysfs(void);
+extern void squashfs_exit_sysfs(void);
+
 /* xattr.c */
 extern ssize_t squashfs_listxattr(struct dentry *, char *, size_t);
 
@@ -10,6 +10,9 @@
  * squashfs_fs_sb.h
  */
 
+#include <linux/completion.h>
+#include <linux/kobject.h>
+
 #include "squashfs_fs.h"
 
 struct squashfs_cache {
@@ -21,6 +24,11 @@ struct squashfs_cache {
 	int			unused;
 	int			block_size;
 	int			pages;
+	int			populated;
+	int			reserved;
+	unsigned long		hits;
+	unsigned long		misses;
+	unsigned long		reclaimed;
 	spinlock_t		lock;
 	wait_queue_head_t	wait_queue;
 	struct squashfs_cache_entry *entry;
@@ -34,6 +42,7 @@ struct squashfs_cache_entry {
 	int			pending;
 	int			error;
 	int			num_waiters;
+	int			populated;
 	wait_queue_head_t	wait_queue;
 	struct squashfs_cache	*cache;
 	void			**data;
@@ -69,5 +78,8 @@ struct squashfs_sb_info {
 	bool					panic_on_errors;
 	const struct squashfs_decompressor_thread_ops *thread_ops;
 	int					max_thread_num;
+	struct shrinker				*cache_shrinker;
+	struct kobject				s_kobj;
+	struct completion			s_kobj_unregister;
 };
 #endif
@@ -24,6 +24,7 @@
 #include <linux/slab.h>
 #include <linux/mutex.h>
 #include <linux/seq_file.h>
+#include <linux/shrinker.h>
 #include <linux/pagemap.h>
 #include <linux/init.h>
 #include <linux/module.h>
@@ -48,12 +49,16 @@ enum Opt_errors {
 enum squashfs_param {
 	Opt_errors,
 	Opt_threads,
+	Opt_fragment_cache,
+	Opt_metadata_cache,
 };
 
 struct squashfs_mount_opts {
 	enum Opt_errors errors;
 	const struct squashfs_decompressor_thread_ops *thread_ops;
 	int thread_num;
+	unsigned int fragment_cache;
+	unsigned int metadata_cache;
 };
 
 static const struct constant_table squashfs_param_errors[] = {
@@ -65,6 +70,8 @@ static const struct constant_table squashfs_param_errors[] = {
 static const struct fs_parameter_spec squashfs_fs_parameters[] = {
 	fsparam_enum("errors", Opt_errors, squashfs_param_errors),
 	fsparam_string("threads", Opt_threads),
+	fsparam_u32("fragment_cache", Opt_fragment_cache),
+	fsparam_u32("metadata_cache", Opt_metadata_cache),
 	{}
 };
 
@@ -142,6 +149,21 @@ static int squashfs_parse_param(struct fs_context *fc, struct fs_parameter *para
 		if (squashfs_parse_param_threads(param->string, opts) != 0)
 			return -EINVAL;
 		break;
+	case Opt_fragment_cache:
+		if (result.uint_32 < 1 ||
+		    result.uint_32 > SQUASHFS_MAX_CACHED_FRAGMENTS)
+			return invalfc(fc, "fragment_cache must be 1-%d",
+				       SQUASHFS_MAX_CACHED_FRAGMENTS);
+		opts->fragment_cache = result.uint_32;
+		break;
+	case Opt_metadata_cache:
+		if (result.uint_32 < SQUASHFS_CACHED_BLKS ||
+		    result.uint_32 > SQUASHFS_MAX_CACHED_BLKS)
+			return invalfc(fc, "metadata_cache must be %d-%d",
+				       SQUASHFS_CACHED_BLKS,
+				       SQUASHFS_MAX_CACHED_BLKS);
+		opts->metadata_cache = result.uint_32;
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -177,6 +199,58 @@ static const struct squashfs_decompressor *supported_squashfs_filesystem(
 }
 
 
+/*
+ * Cache entries beyond the compiled in defaults were asked for at mount
+ * time, give their buffers back under memory pressure.
+ */
+static unsigned long squashfs_cache_shrink_count(struct shrinker *shrink,
+	struct shrink_control *sc)
+{
+	struct squashfs_sb_info *msblk = shrink->private_data;
+	unsigned long count = squashfs_cache_count(msblk->fragment_cache) +
+		squashfs_cache_count(msblk->block_cache);
+
+	return count ? count : SHRINK_EMPTY;
+}
+
+static unsigned long squashfs_cache_shrink_scan(struct shrinker *shrink,
+	struct shrink_control *sc)
+{
+	struct squashfs_sb_info *msblk = shrink->private_data;
+	unsigned long freed;
+
+	freed = squashfs_cache_shrink(msblk->fragment_cache, sc->nr_to_scan);
+	if (freed < sc->nr_to_scan)
+		freed += squashfs_cache_shrink(msblk->block_cache,
+					       sc->nr_to_scan - freed);
+
+	return freed;
+}
+
+static int squashfs_register_shrinker(struct super_block *sb)
+{
+	struct squashfs_sb_info *msblk = sb->s_fs_info;
+	struct shrinker *shrinker;
+
+	if (msblk->block_cache->reserved == msblk->block_cache->entries &&
+	    (!msblk->fragment_cache || msblk->fragment_cache->reserved ==
+	     msblk->fragment_cache->entries))
+		return 0;
+
+	shrinker = shrinker_alloc(0, "squashfs-cache:%s", sb->s_id);
+	if (!shrinker)
+		return -ENOMEM;
+
+	shrinker->count_objects = squashfs_cache_shrink_count;
+	shrinker->scan_objects = squashfs_cache_shrink_scan;
+	shrinker->private_data = msblk;
+	shrinker_register(shrinker);
+	msblk->cache_shrinker = shrinker;
+
+	return 0;
+}
+
+
 static int squashfs_fill_super(struct super_block *sb, struct fs_context *fc)
 {
 	struct squashfs_mount_opts *opts = fc->fs_private;
@@ -322,9 +396,10 @@ static int squashfs_fill_super(struct super_block *sb, struct fs_context *fc)
 	err = -ENOMEM;
 
 	msblk->block_cache = squashfs_cache_init("metadata",
-			SQUASHFS_CACHED_BLKS, SQUASHFS_METADATA_SIZE);
+			opts->metadata_cache, SQUASHFS_METADATA_SIZE);
 	if (msblk->block_cache == NULL)
 		goto failed_mount;
+	msblk->block_cache->reserved = SQUASHFS_CACHED_BLKS;
 
 	/* Allocate read_page block */
 	msblk->read_page = squashfs_cache_init("data",
@@ -410,11 +485,13 @@ static int squashfs_fill_super(struct super_block *sb, struct fs_context *fc)
 		goto check_directory_table;
 
 	msblk->fragment_cache = squashfs_cache_init("fragment",
-		SQUASHFS_CACHED_FRAGMENTS, msblk->block_size);
+		opts->fragment_cache, msblk->block_size);
 	if (msblk->fragment_cache == NULL) {
 		err = -ENOMEM;
 		goto failed_mount;
 	}
+	msblk->fragment_cache->reserved = min_t(int,
+		opts->fragment_cache, SQUASHFS_CACHED_FRAGMENTS);
 
 	/* Allocate and read fragment index table */
 	msblk->fragment_index = squashfs_read_fragment_index_table(sb,
@@ -440,6 +517,14 @@ static int squashfs_fill_super(struct super_block *sb, struct fs_context *fc)
 		goto insanity;
 	}
 
+	err = squashfs_register_shrinker(sb);
+	if (err)
+		goto failed_mount;
+
+	err = squashfs_register_sysfs(sb);
+	if (err)
+		goto failed_mount;
+
 	/* allocate root */
 	root = new_inode(sb);
 	if (!root) {
@@ -469,6 +554,8 @@ static int squashfs_fill_super(struct super_block *sb, struct fs_context *fc)
 insanity:
 	errorf(fc, "squashfs image failed sanity check");
 failed_mount:
+	squashfs_unregister_sysfs(sb);
+	shrinker_free(msblk->cache_shrinker);
 	squashfs_cache_delete(msblk->block_cache);
 	squashfs_cache_delete(msblk->fragment_cache);
 	squashfs_cache_delete(msblk->read_page);
@@ -526,6 +613,14 @@ static int squashfs_show_options(struct seq_file *s, struct dentry *root)
 	else
 		seq_puts(s, ",errors=continue");
 
+	if (msblk->fragment_cache &&
+	    msblk->fragment_cache->entries != SQUASHFS_CACHED_FRAGMENTS)
+		seq_printf(s, ",fragment_cache=%d",
+			   msblk->fragment_cache->entries);
+	if (msblk->block_cache->entries != SQUASHFS_CACHED_BLKS)
+		seq_printf(s, ",metadata_cache=%d",
+			   msblk->block_cache->entries);
+
 #ifdef CONFIG_SQUASHFS_CHOICE_DECOMP_BY_MOUNT
 	if (msblk->thread_ops == &squashfs_decompressor_single) {
 		seq_puts(s, ",threads=single");
@@ -560,6 +655,8 @@ static int squashfs_init_fs_context(struct fs_context *fc)
 #error "fail: unknown squashfs decompression thread mode?"
 #endif
 	opts->thread_num = 0;
+	opts->fragment_cache = SQUASHFS_CACHED_FRAGMENTS;
+	opts->metadata_cache = SQUASHFS_CACHED_BLKS;
 	fc->fs_private = opts;
 	fc->ops = &squashfs_context_ops;
 	return 0;
@@ -589,6 +686,8 @@ static void squashfs_put_super(struct super_block *sb)
 {
 	if (sb->s_fs_info) {
 		struct squashfs_sb_info *sbi = sb->s_fs_info;
+		squashfs_unregister_sysfs(sb);
+		shrinker_free(sbi->cache_shrinker);
 		squashfs_cache_delete(sbi->block_cache);
 		squashfs_cache_delete(sbi->fragment_cache);
 		squashfs_cache_delete(sbi->read_page);
@@ -645,8 +744,23 @@ static int __init init_squashfs_fs(void)
 	if (err)
 		return err;
 
+	err = squashfs_readahead_init();
+	if (err) {
+		destroy_inodecache();
+		return err;
+	}
+
+	err = squashfs_init_sysfs();
+	if (err) {
+		squashfs_readahead_destroy();
+		destroy_inodecache();
+		return err;
+	}
+
 	err = register_filesystem(&squashfs_fs_type);
 	if (err) {
+		squashfs_exit_sysfs();
+		squashfs_readahead_destroy();
 		destroy_inodecache();
 		return err;
 	}
@@ -660,6 +774,8 @@ static int __init init_squashfs_fs(void)
 static void __exit exit_squashfs_fs(void)
 {
 	unregister_filesystem(&squashfs_fs_type);
+	squashfs_exit_sysfs();
+	squashfs_readahead_destroy();
 	destroy_inodecache();
 }
 
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Squashfs - a compressed read only filesystem for Linux
+ *
+ * sysfs.c
+ */
+
+/*
+ * This file exports the metadata and fragment cache statistics of each
+ * mounted filesystem in /sys/fs/squashfs/<dev>/.
+ */
+
+#include <linux/fs.h>
+#include <linux/kobject.h>
+#include <linux/spinlock.h>
+#include <linux/sysfs.h>
+
+#include "squashfs_fs.h"
+#include "squashfs_fs_sb.h"
+#include "squashfs.h"
+
+enum {
+	attr_entries,
+	attr_populated,
+	attr_hits,
+	attr_misses,
+	attr_reclaimed,
+};
+
+struct squashfs_attr {
+	struct attribute attr;
+	short attr_id;
+	int offset;
+};
+
+#define SQUASHFS_CACHE_ATTR(_name, _cache, _id)				\
+static struct squashfs_attr squashfs_attr_##_name##_##_id = {		\
+	.attr = {.name = __stringify(_name) "_" __stringify(_id),	\
+		 .mode = 0444 },					\
+	.attr_id = attr_##_id,						\
+	.offset = offsetof(struct squashfs_sb_info, _cache),		\
+}
+
+#define SQUASHFS_CACHE_ATTRS(_name, _cache)				\
+	SQUASHFS_CACHE_ATTR(_name, _cache, entries);			\
+	SQUASHFS_CACHE_ATTR(_name, _cache, populated);			\
+	SQUASHFS_CACHE_ATTR(_name, _cache, hits);			\
+	SQUASHFS_CACHE_ATTR(_name, _cache, misses);			\
+	SQUASHFS_CACHE_ATTR(_name, _cache, reclaimed)
+
+#define ATTR_LIST(name, id) (&squashfs_attr_##name##_##id.attr)
+
+SQUASHFS_CACHE_ATTRS(fragment_cache, fragment_cache);
+SQUASHFS_CACHE_ATTRS(metadata_cache, block_cache);
+
+static struct attribute *squashfs_attrs[] = {
+	ATTR_LIST(fragment_cache, entries),
+	ATTR_LIST(fragment_cache, populated),
+	ATTR_LIST(fragment_cache, hits),
+	ATTR_LIST(fragment_cache, misses),
+	ATTR_LIST(fragment_cache, reclaimed),
+	ATTR_LIST(metadata_cache, entries),
+	ATTR_LIST(metadata_cache, populated),
+	ATTR_LIST(metadata_cache, hits),
+	ATTR_LIST(metadata_cache, misses),
+	ATTR_LIST(metadata_cache, reclaimed),
+	NULL,
+};
+ATTRIBUTE_GROUPS(squashfs);
+
+static ssize_t squashfs_attr_show(struct kobject *kobj,
+				  struct attribute *attr, char *buf)
+{
+	struct squashfs_sb_info *msblk = container_of(kobj,
+					struct squashfs_sb_info, s_kobj);
+	struct squashfs_attr *a = container_of(attr, struct squashfs_attr,
+					       attr);
+	struct squashfs_cache *cache =
+		*(struct squashfs_cache **)((char *)msblk + a->offset);
+	unsigned long val = 0;
+
+	/* A filesystem without fragments has no fragment cache */
+	if (cache == NULL)
+		return sysfs_emit(buf, "0\n");
+
+	spin_lock(&cache->lock);
+	switch (a->attr_id) {
+	case attr_entries:
+		val = cache->entries;
+		break;
+	case attr_populated:
+		val = cache->populated;
+		break;
+	case attr_hits:
+		val = cache->hits;
+		break;
+	case attr_misses:
+		val = cache->misses;
+		break;
+	case attr_reclaimed:
+		val = cache->reclaimed;
+		break;
+	}
+	spin_unlock(&cache->lock);
+
+	return sysfs_emit(buf, "%lu\n", val);
+}
+
+static void squashfs_sb_release(struct kobject *kobj)
+{
+	struct squashfs_sb_info *msblk = container_of(kobj,
+					struct squashfs_sb_info, s_kobj);
+
+	complete(&msblk->s_kobj_unregister);
+}
+
+static const struct sysfs_ops squashfs_attr_ops = {
+	.show	= squashfs_attr_show,
+};
+
+static const struct kobj_type squashfs_sb_ktype = {
+	.default_groups = squashfs_groups,
+	.sysfs_ops	= &squashfs_attr_ops,
+	.release	= squashfs_sb_release,
+};
+
+static const struct kobj_type squashfs_ktype = {
+	.sysfs_ops	= &squashfs_attr_ops,
+};
+
+static struct kset squashfs_root = {
+	.kobj	= {.ktype = &squashfs_ktype},
+};
+
+int squashfs_register_sysfs(struct super_block *sb)
+{
+	struct squashfs_sb_info *msblk = sb->s_fs_info;
+	int err;
+
+	msblk->s_kobj.kset = &squashfs_root;
+	init_completion(&msblk->s_kobj_unregister);
+	err = kobject_init_and_add(&msblk->s_kobj, &squashfs_sb_ktype, NULL,
+				   "%s", sb->s_id);
+	if (err) {
+		kobject_put(&msblk->s_kobj);
+		wait_for_completion(&msblk->s_kobj_unregister);
+	}
+	return err;
+}
+
+void squashfs_unregister_sysfs(struct super_block *sb)
+{
+	struct squashfs_sb_info *msblk = sb->s_fs_info;
+
+	if (msblk->s_kobj.state_in_sysfs) {
+		kobject_del(&msblk->s_kobj);
+		kobject_put(&msblk->s_kobj);
+		wait_for_completion(&msblk->s_kobj_unregister);
+	}
+}
+
+int __init squashfs_init_sysfs(void)
+{
+	kobject_set_name(&squashfs_root.kobj, "squashfs");
+	squashfs_root.kobj.parent = fs_kobj;
+	return kset_register(&squashfs_root);
+}
+
+void squashfs_exit_sysfs(void)
+{
+	kset_unregister(&squashfs_root);
+}
@@ -206,6 +206,8 @@ typedef __u32 __bitwise blk_opf_t;
 
 typedef unsigned int blk_qc_t;
 #define BLK_QC_T_NONE		-1U
+/* set in bi_cookie once bio_poll() did the hybrid polling sleep for a bio */
+#define BLK_QC_T_SLEPT		(1U << 31)
 
 /*
  * main unit of I/O for the block layer and lower layers (ie drivers and
@@ -40,6 +40,7 @@ struct pr_ops;
 struct rq_qos;
 struct blk_queue_stats;
 struct blk_stat_callback;
+struct blk_stat_callback;
 struct blk_crypto_profile;
 
 extern const struct device_type disk_type;
@@ -507,6 +508,15 @@ struct request_queue {
 	struct rq_qos		*rq_qos;
 	struct mutex		rq_qos_mutex;
 
+	/*
+	 * Hybrid polling: BLK_MQ_POLL_CLASSIC to always spin, 0 to sleep for
+	 * half of the mean completion time seen in poll_stat first, or a
+	 * fixed sleep in nanoseconds.
+	 */
+	int			poll_nsec;
+	struct blk_stat_callback *poll_cb;
+	struct blk_rq_stat	*poll_stat;
+
 	/*
 	 * ida allocated id for this queue.  Used to index queues from
 	 * ioctx.
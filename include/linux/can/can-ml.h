@@ -56,6 +56,8 @@ struct can_dev_rcv_lists {
 	struct hlist_head rx[RX_MAX];
 	struct hlist_head rx_sff[CAN_SFF_RCV_ARRAY_SZ];
 	struct hlist_head rx_eff[CAN_EFF_RCV_ARRAY_SZ];
+	/* can_id/mask filters indexed by their 11 lower can_id bits */
+	struct hlist_head rx_fil_id[CAN_SFF_RCV_ARRAY_SZ];
 	int entries;
 };
 
@@ -552,6 +552,8 @@ struct device_physical_location {
  * @dma_io_tlb_pools:	List of transient swiotlb memory pools.
  * @dma_io_tlb_lock:	Protects changes to the list of active pools.
  * @dma_uses_io_tlb: %true if device has used the software IO TLB.
+ * @dma_io_tlb_dev: Per-device software IO TLB state.  Not for driver use.
+ * @dma_recycle: Cache of freed coherent buffers.  Not for driver use.
  * @archdata:	For arch-specific additions.
  * @of_node:	Associated device tree node.
  * @fwnode:	Associated device node supplied by platform firmware.
@@ -664,6 +666,10 @@ struct device {
 	struct list_head dma_io_tlb_pools;
 	spinlock_t dma_io_tlb_lock;
 	bool dma_uses_io_tlb;
+	struct io_tlb_dev *dma_io_tlb_dev;
+#endif
+#ifdef CONFIG_DMA_RECYCLE
+	struct dma_recycle_cache *dma_recycle;
 #endif
 	/* arch specific additions */
 	struct dev_archdata	archdata;
@@ -447,4 +447,37 @@ void net_dim(struct dim *dim, struct dim_sample end_sample);
  */
 void rdma_dim(struct dim *dim, u64 completions);
 
+/* Completion DIM */
+
+/*
+ * Completion DIM profile:
+ * profile size must be of COMP_DIM_PARAMS_NUM_PROFILES.
+ * Profile 0 is no moderation, and the one to start from.
+ */
+#define COMP_DIM_PARAMS_NUM_PROFILES 6
+#define COMP_DIM_START_PROFILE 0
+
+/**
+ *	comp_dim_get_moderation - provide the moderation of the given profile
+ *	@ix: Profile index
+ *
+ * @usec is how long completions may be held at most, and @comps after how
+ * many they are signalled anyway.
+ */
+struct dim_cq_moder comp_dim_get_moderation(int ix);
+
+/**
+ *	comp_dim - Runs the adaptive moderation of a completion queue.
+ *	@dim: DIM instance information
+ *	@end_sample: Current data measurement
+ *	@latency_bias: Prefer lower moderation when throughput doesn't change
+ *
+ * Called by the consumer each time it signals completions, with the
+ * number of such events, the completions and the bytes they account for
+ * in @end_sample, see dim_update_sample_with_comps().
+ * Moderation is only raised when that brings more bytes or completions per
+ * msec, or fewer events for the same, unless @latency_bias is set.
+ */
+void comp_dim(struct dim *dim, struct dim_sample end_sample, bool latency_bias);
+
 #endif /* DIM_H */
@@ -421,6 +421,14 @@ static inline void arch_teardown_dma_ops(struct device *dev)
 }
 #endif /* CONFIG_ARCH_HAS_TEARDOWN_DMA_OPS */
 
+#ifdef CONFIG_DMA_RECYCLE
+void dma_recycle_drain(struct device *dev);
+#else
+static inline void dma_recycle_drain(struct device *dev)
+{
+}
+#endif /* CONFIG_DMA_RECYCLE */
+
 #ifdef CONFIG_DMA_API_DEBUG
 void dma_debug_add_bus(const struct bus_type *bus);
 void debug_dma_dump_mappings(struct device *dev);
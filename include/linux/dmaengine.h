@@ -200,6 +200,11 @@ struct dma_vec {
  *  transaction is marked with DMA_PREP_REPEAT will cause the new transaction
  *  to never be processed and stay in the issued queue forever. The flag is
  *  ignored if the previous transaction is not a repeated transaction.
+ * @DMA_PREP_POLL: tell the driver that the client busy polls for the
+ *  completion of this transaction with dma_async_poll_complete(). Drivers
+ *  supporting it check the hardware and complete the transaction from
+ *  device_tx_status() instead of waiting for the completion interrupt, which
+ *  stays enabled as a fallback.
  */
 enum dma_ctrl_flags {
 	DMA_PREP_INTERRUPT = (1 << 0),
@@ -212,6 +217,7 @@ enum dma_ctrl_flags {
 	DMA_PREP_CMD = (1 << 7),
 	DMA_PREP_REPEAT = (1 << 8),
 	DMA_PREP_LOAD_EOT = (1 << 9),
+	DMA_PREP_POLL = (1 << 10),
 };
 
 /**
@@ -1513,6 +1519,9 @@ dma_set_tx_state(struct dma_tx_state *st, dma_cookie_t last, dma_cookie_t used,
 #ifdef CONFIG_DMA_ENGINE
 struct dma_chan *dma_find_channel(enum dma_transaction_type tx_type);
 enum dma_status dma_sync_wait(struct dma_chan *chan, dma_cookie_t cookie);
+enum dma_status dma_async_poll_complete(struct dma_chan *chan,
+					dma_cookie_t cookie,
+					unsigned int budget_us);
 enum dma_status dma_wait_for_async_tx(struct dma_async_tx_descriptor *tx);
 void dma_issue_pending_all(void);
 struct dma_chan *__dma_request_channel(const dma_cap_mask_t *mask,
@@ -1533,6 +1542,12 @@ static inline enum dma_status dma_sync_wait(struct dma_chan *chan, dma_cookie_t
 {
 	return DMA_COMPLETE;
 }
+static inline enum dma_status dma_async_poll_complete(struct dma_chan *chan,
+						      dma_cookie_t cookie,
+						      unsigned int budget_us)
+{
+	return DMA_COMPLETE;
+}
 static inline enum dma_status dma_wait_for_async_tx(struct dma_async_tx_descriptor *tx)
 {
 	return DMA_COMPLETE;
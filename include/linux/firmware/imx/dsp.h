@@ -9,11 +9,18 @@
 #define _IMX_DSP_IPC_H
 
 #include <linux/device.h>
+#include <linux/ktime.h>
 #include <linux/types.h>
 #include <linux/mailbox_client.h>
+#include <linux/spinlock.h>
 
 #define DSP_MU_CHAN_NUM		4
 
+/* Latency histogram buckets, power of two microseconds */
+#define IMX_DSP_LAT_BUCKETS	16
+
+struct dentry;
+
 struct imx_dsp_chan {
 	struct imx_dsp_ipc *ipc;
 	struct mbox_client cl;
@@ -22,6 +29,17 @@ struct imx_dsp_chan {
 	int idx;
 };
 
+struct imx_dsp_ipc_stats {
+	spinlock_t lock;
+	ktime_t start;
+	bool pending;
+	u64 count;
+	u64 polled;
+	u64 total_ns;
+	u64 max_ns;
+	u32 hist[IMX_DSP_LAT_BUCKETS];
+};
+
 struct imx_dsp_ops {
 	void (*handle_reply)(struct imx_dsp_ipc *ipc);
 	void (*handle_request)(struct imx_dsp_ipc *ipc);
@@ -33,6 +51,9 @@ struct imx_dsp_ipc {
 	struct device *dev;
 	struct imx_dsp_ops *ops;
 	void *private_data;
+	/* Doorbell to reply latency of channel 0 */
+	struct imx_dsp_ipc_stats stats;
+	struct dentry *debugfs;
 };
 
 static inline void imx_dsp_set_data(struct imx_dsp_ipc *ipc, void *data)
@@ -48,6 +69,9 @@ static inline void *imx_dsp_get_data(struct imx_dsp_ipc *ipc)
 #if IS_ENABLED(CONFIG_IMX_DSP)
 
 int imx_dsp_ring_doorbell(struct imx_dsp_ipc *dsp, unsigned int chan_idx);
+int imx_dsp_ring_doorbell_sync(struct imx_dsp_ipc *ipc, unsigned int idx,
+			       size_t size);
+void imx_dsp_debugfs_init(struct imx_dsp_ipc *ipc, struct dentry *parent);
 
 struct mbox_chan *imx_dsp_request_channel(struct imx_dsp_ipc *ipc, int idx);
 void imx_dsp_free_channel(struct imx_dsp_ipc *ipc, int idx);
@@ -60,6 +84,15 @@ static inline int imx_dsp_ring_doorbell(struct imx_dsp_ipc *ipc,
 	return -ENOTSUPP;
 }
 
+static inline int imx_dsp_ring_doorbell_sync(struct imx_dsp_ipc *ipc,
+					     unsigned int idx, size_t size)
+{
+	return -ENOTSUPP;
+}
+
+static inline void imx_dsp_debugfs_init(struct imx_dsp_ipc *ipc,
+					struct dentry *parent) { }
+
 struct mbox_chan *imx_dsp_request_channel(struct imx_dsp_ipc *ipc, int idx)
 {
 	return ERR_PTR(-EOPNOTSUPP);
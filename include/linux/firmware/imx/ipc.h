@@ -50,6 +50,23 @@ struct imx_sc_rpc_msg {
  */
 int imx_scu_call_rpc(struct imx_sc_ipc *ipc, void *msg, bool have_resp);
 
+/*
+ * This function sends a sequence of RPC messages over an IPC channel,
+ * without letting other callers interleave their messages.
+ *
+ * @param[in]     ipc         IPC handle
+ * @param[in,out] msgs        array of message handles
+ * @param[in]     num         number of messages
+ *
+ * Every message must have a response, which is returned in its msg. The
+ * sequence stops at the first message whose status is an error, the
+ * following messages are not sent.
+ *
+ * @return Returns an error code (0 = success, failed if < 0)
+ */
+int imx_scu_call_rpc_batch(struct imx_sc_ipc *ipc, void **msgs,
+			   unsigned int num);
+
 /*
  * This function gets the default ipc handle used by SCU
  *
@@ -65,6 +82,12 @@ static inline int imx_scu_call_rpc(struct imx_sc_ipc *ipc, void *msg,
 	return -ENOTSUPP;
 }
 
+static inline int imx_scu_call_rpc_batch(struct imx_sc_ipc *ipc, void **msgs,
+					 unsigned int num)
+{
+	return -ENOTSUPP;
+}
+
 static inline int imx_scu_get_handle(struct imx_sc_ipc **ipc)
 {
 	return -ENOTSUPP;
@@ -26,5 +26,7 @@ int imx_se_write_fuse(void *se_if_data, uint16_t fuse_index,
 int imx_se_voltage_change_req(void *se_if_data, bool start);
 int imx_se_read_fuse(void *se_if_data,
 		     uint16_t fuse_id, u32 *value);
+int imx_se_read_fuses(void *se_if_data, uint16_t fuse_base,
+		      unsigned int num, u32 *value);
 
 #endif /* __SE_API_H__ */
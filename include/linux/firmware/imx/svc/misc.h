@@ -42,6 +42,15 @@ enum imx_misc_func {
 	IMX_SC_MISC_FUNC_GET_BUTTON_STATUS = 18,
 };
 
+/*
+ * One entry of a imx_sc_misc_set_controls() request
+ */
+struct imx_sc_misc_ctrl {
+	u32 resource;
+	u8 ctrl;
+	u32 val;
+};
+
 /*
  * Control Functions
  */
@@ -50,6 +59,10 @@ enum imx_misc_func {
 int imx_sc_misc_set_control(struct imx_sc_ipc *ipc, u32 resource,
 			    u8 ctrl, u32 val);
 
+int imx_sc_misc_set_controls(struct imx_sc_ipc *ipc,
+			     const struct imx_sc_misc_ctrl *ctrls,
+			     unsigned int num);
+
 int imx_sc_misc_set_dma_group(struct imx_sc_ipc *ipc, u32 resource,
 			    u32 val);
 
@@ -65,6 +78,13 @@ static inline int imx_sc_misc_set_control(struct imx_sc_ipc *ipc,
 	return -ENOTSUPP;
 }
 
+static inline int imx_sc_misc_set_controls(struct imx_sc_ipc *ipc,
+					   const struct imx_sc_misc_ctrl *ctrls,
+					   unsigned int num)
+{
+	return -ENOTSUPP;
+}
+
 static inline int imx_sc_misc_get_control(struct imx_sc_ipc *ipc,
 					  u32 resource, u8 ctrl, u32 *val)
 {
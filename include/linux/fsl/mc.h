@@ -311,6 +311,7 @@ static inline void mc_cmd_read_api_version(struct fsl_mc_command *cmd,
  * Bit masks for a MC I/O object (struct fsl_mc_io) flags
  */
 #define FSL_MC_IO_ATOMIC_CONTEXT_PORTAL	0x0001
+#define FSL_MC_IO_CMD_COMPLETION_IRQ	0x0002
 
 /**
  * struct fsl_mc_io - MC I/O object to be passed-in to mc_send_command()
@@ -334,6 +335,13 @@ static inline void mc_cmd_read_api_version(struct fsl_mc_command *cmd,
  * portal, if the fsl_mc_io object was created with the
  * FSL_MC_IO_ATOMIC_CONTEXT_PORTAL flag on. mc_send_command() calls for this
  * fsl_mc_io object can be made from atomic or non-atomic context.
+ *
+ * Fields are only meaningful if the FSL_MC_IO_CMD_COMPLETION_IRQ flag is set:
+ * @irq: Linux IRQ number of the DPMCP command completion interrupt, or 0 while
+ * it is not armed and commands are completed by polling
+ * @queue_lock: Spinlock protecting @cmd_queue
+ * @cmd_queue: Commands submitted through the portal, the one at the head is
+ * the one the MC is working on
  */
 struct fsl_mc_io {
 	struct device *dev;
@@ -355,10 +363,35 @@ struct fsl_mc_io {
 		 */
 		raw_spinlock_t spinlock; /* serializes mc_send_command() */
 	};
+	int irq;
+	spinlock_t queue_lock; /* protects cmd_queue */
+	struct list_head cmd_queue;
+};
+
+/**
+ * struct fsl_mc_async_cmd - MC command submitted with mc_send_command_async()
+ * @cmd: the command, overwritten with the MC response on completion
+ * @done: called from the completion interrupt thread with the outcome of the
+ * command; the structure may be freed or reused from there
+ * @priv: for use by the submitter
+ * @node: queue linkage (private)
+ * @cmd_id: command ID, kept for latency accounting (private)
+ * @start: time the command was handed to the MC (private)
+ */
+struct fsl_mc_async_cmd {
+	struct fsl_mc_command cmd;
+	void (*done)(struct fsl_mc_async_cmd *acmd, int error);
+	void *priv;
+	struct list_head node;
+	u16 cmd_id;
+	ktime_t start;
 };
 
 int mc_send_command(struct fsl_mc_io *mc_io, struct fsl_mc_command *cmd);
 
+int mc_send_command_async(struct fsl_mc_io *mc_io,
+			  struct fsl_mc_async_cmd *acmd);
+
 #ifdef CONFIG_FSL_MC_BUS
 #define dev_is_fsl_mc(_dev) ((_dev)->bus == &fsl_mc_bus_type)
 #else
@@ -11,6 +11,18 @@
  */
 #define V4L2_EVENT_IMX_CLASS                V4L2_EVENT_PRIVATE_START
 #define V4L2_EVENT_IMX_FRAME_INTERVAL_ERROR (V4L2_EVENT_IMX_CLASS + 1)
+#define V4L2_EVENT_IMX_FRAME_INTERVAL_DRIFT (V4L2_EVENT_IMX_CLASS + 2)
+
+/*
+ * Payload of V4L2_EVENT_IMX_FRAME_INTERVAL_DRIFT, sent when the averaged
+ * signed frame interval error crosses the FIM minimum tolerance. A
+ * positive drift means the source runs slower than nominal.
+ */
+struct imx_media_fim_drift {
+	__s64 drift_ns;
+	__u64 nominal_ns;
+	__u8 drifting;
+};
 
 enum imx_ctrl_id {
 	V4L2_CID_IMX_FIM_ENABLE = (V4L2_CID_USER_IMX_BASE + 0),
@@ -17,6 +17,11 @@
 #ifndef __LINUX_IMX_RPMSG_H__
 #define __LINUX_IMX_RPMSG_H__
 
+#include <linux/bits.h>
+#include <linux/err.h>
+#include <linux/types.h>
+#include <asm/byteorder.h>
+
 /* Category define */
 #define IMX_RMPSG_LIFECYCLE	1
 #define IMX_RPMSG_PMIC		2
@@ -40,4 +45,83 @@ struct imx_rpmsg_head {
 	u8 reserved[5];
 } __packed;
 
+/*
+ * Messages larger than a vring buffer are passed by reference into a
+ * buffer pool shared with the remote, described by the "fsl,rpmsg-pool"
+ * reserved memory region. A buffer belongs to whoever received the last
+ * reference to it: sending one hands the buffer over to the remote, and
+ * the M core hands it back by sending a reference in return, either with
+ * data or with IMX_RPMSG_BUF_F_RELEASE set.
+ */
+#define IMX_RPMSG_BUF_MAGIC		0x46425052	/* "RPBF" */
+#define IMX_RPMSG_BUF_F_RELEASE		BIT(0)
+
+struct imx_rpmsg_buf_ref {
+	__le32 magic;
+	__le32 offset;		/* from the start of the pool */
+	__le32 len;		/* of valid data */
+	__le32 flags;
+} __packed;
+
+struct rpmsg_device;
+struct rpmsg_endpoint;
+struct vm_area_struct;
+
+static inline bool imx_rpmsg_is_buf_ref(const void *msg, int len)
+{
+	const struct imx_rpmsg_buf_ref *ref = msg;
+
+	return len == sizeof(*ref) &&
+		le32_to_cpu(ref->magic) == IMX_RPMSG_BUF_MAGIC;
+}
+
+#ifdef CONFIG_HAVE_IMX_RPMSG
+void *imx_rpmsg_buf_alloc(struct rpmsg_device *rpdev, size_t size,
+			  u32 *offset, void *owner);
+int imx_rpmsg_buf_free(struct rpmsg_device *rpdev, u32 offset, void *owner);
+int imx_rpmsg_buf_send(struct rpmsg_endpoint *ept, u32 dst, u32 offset,
+		       u32 len, u32 flags, void *owner);
+void *imx_rpmsg_buf_recv(struct rpmsg_device *rpdev, const void *msg,
+			 int len);
+void imx_rpmsg_buf_release_owner(struct rpmsg_device *rpdev, void *owner);
+int imx_rpmsg_pool_mmap(struct rpmsg_device *rpdev,
+			struct vm_area_struct *vma);
+#else
+static inline void *imx_rpmsg_buf_alloc(struct rpmsg_device *rpdev,
+					size_t size, u32 *offset, void *owner)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline int imx_rpmsg_buf_free(struct rpmsg_device *rpdev, u32 offset,
+				     void *owner)
+{
+	return -ENODEV;
+}
+
+static inline int imx_rpmsg_buf_send(struct rpmsg_endpoint *ept, u32 dst,
+				     u32 offset, u32 len, u32 flags,
+				     void *owner)
+{
+	return -ENODEV;
+}
+
+static inline void *imx_rpmsg_buf_recv(struct rpmsg_device *rpdev,
+				       const void *msg, int len)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline void imx_rpmsg_buf_release_owner(struct rpmsg_device *rpdev,
+					       void *owner)
+{
+}
+
+static inline int imx_rpmsg_pool_mmap(struct rpmsg_device *rpdev,
+				      struct vm_area_struct *vma)
+{
+	return -ENODEV;
+}
+#endif
+
 #endif /* __LINUX_IMX_RPMSG_H__ */
@@ -30,6 +30,9 @@ extern char *__kfence_pool;
 DECLARE_STATIC_KEY_FALSE(kfence_allocation_key);
 extern atomic_t kfence_allocation_gate;
 
+/* Enabled while caches are targeted with the kfence.targets parameter. */
+DECLARE_STATIC_KEY_FALSE(kfence_target_key);
+
 /**
  * is_kfence_address() - check if an address belongs to KFENCE pool
  * @addr: address to check
@@ -99,6 +102,12 @@ void kfence_shutdown_cache(struct kmem_cache *s);
  */
 void *__kfence_alloc(struct kmem_cache *s, size_t size, gfp_t flags);
 
+/*
+ * Allocate a KFENCE object if @s is targeted and this allocation is sampled.
+ * Allocators must not call this function directly, use kfence_alloc() instead.
+ */
+void *__kfence_alloc_target(struct kmem_cache *s, size_t size, gfp_t flags);
+
 /**
  * kfence_alloc() - allocate a KFENCE object with a low probability
  * @s:     struct kmem_cache with object requirements
@@ -113,10 +122,18 @@ void *__kfence_alloc(struct kmem_cache *s, size_t size, gfp_t flags);
  * kfence_alloc() should be inserted into the heap allocation fast path,
  * allowing it to transparently return KFENCE-allocated objects with a low
  * probability using a static branch (the probability is controlled by the
- * kfence.sample_interval boot parameter).
+ * kfence.sample_interval boot parameter).  Caches listed in the kfence.targets
+ * parameter are sampled on their own as well, at their own rate.
  */
 static __always_inline void *kfence_alloc(struct kmem_cache *s, size_t size, gfp_t flags)
 {
+	if (static_branch_unlikely(&kfence_target_key)) {
+		void *addr = __kfence_alloc_target(s, size, flags);
+
+		if (addr)
+			return addr;
+	}
+
 #if defined(CONFIG_KFENCE_STATIC_KEYS) || CONFIG_KFENCE_SAMPLE_INTERVAL == 0
 	if (!static_branch_unlikely(&kfence_allocation_key))
 		return NULL;
@@ -15,6 +15,19 @@
 #define DMA_MAP_TO_DEVICE       1
 #define DMA_MAP_FROM_DEVICE     2
 
+/* what one loop of the benchmark measures as its "map" and "unmap" step */
+#define DMA_MAP_BENCHMARK_SINGLE	0 /* dma_map_single/dma_unmap_single */
+#define DMA_MAP_BENCHMARK_SG		1 /* dma_map_sgtable/dma_unmap_sgtable */
+#define DMA_MAP_BENCHMARK_COHERENT	2 /* dma_alloc/free_coherent */
+#define DMA_MAP_BENCHMARK_SYNC		3 /* dma_sync_single_for_device/cpu */
+#define DMA_MAP_BENCHMARK_DMABUF	4 /* dma-buf attach+map/unmap+detach */
+
+#define DMA_MAP_MAX_NENTS	256
+#define DMA_MAP_MAX_PAGES	1024
+
+/* p50, p90, p99 and p99.9 */
+#define DMA_MAP_NR_PERCENTILES	4
+
 struct map_benchmark {
 	__u64 avg_map_100ns; /* average map latency in 100ns */
 	__u64 map_stddev; /* standard deviation of map latency */
@@ -27,5 +40,9 @@ struct map_benchmark {
 	__u32 dma_dir; /* DMA data direction */
 	__u32 dma_trans_ns; /* time for DMA transmission in ns */
 	__u32 granule;  /* how many PAGE_SIZE will do map/unmap once a time */
+	__u32 mode; /* DMA_MAP_BENCHMARK_*, SINGLE if zero */
+	__u32 nents; /* scatterlist segments of granule pages each in SG mode */
+	__u64 map_pct_ns[DMA_MAP_NR_PERCENTILES]; /* map latency percentiles */
+	__u64 unmap_pct_ns[DMA_MAP_NR_PERCENTILES]; /* as above */
 };
 #endif /* _KERNEL_DMA_BENCHMARK_H */
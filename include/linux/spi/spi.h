@@ -1393,6 +1393,9 @@ extern int spi_split_transfers_maxsize(struct spi_controller *ctlr,
 extern int spi_split_transfers_maxwords(struct spi_controller *ctlr,
 					struct spi_message *msg,
 					size_t maxwords);
+extern int spi_split_transfers_tail(struct spi_controller *ctlr,
+				    struct spi_message *msg,
+				    size_t alignwords, size_t minsize);
 
 /*---------------------------------------------------------------------------*/
 
@@ -179,6 +179,7 @@ static inline bool is_swiotlb_force_bounce(struct device *dev)
 void swiotlb_init(bool addressing_limited, unsigned int flags);
 void __init swiotlb_exit(void);
 void swiotlb_dev_init(struct device *dev);
+void swiotlb_dev_release(struct device *dev);
 size_t swiotlb_max_mapping_size(struct device *dev);
 bool is_swiotlb_allocated(void);
 bool is_swiotlb_active(struct device *dev);
@@ -194,6 +195,10 @@ static inline void swiotlb_dev_init(struct device *dev)
 {
 }
 
+static inline void swiotlb_dev_release(struct device *dev)
+{
+}
+
 static inline struct io_tlb_pool *swiotlb_find_pool(struct device *dev,
 		phys_addr_t paddr)
 {
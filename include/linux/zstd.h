@@ -611,4 +611,29 @@ typedef ZSTD_frameHeader zstd_frame_header;
 size_t zstd_get_frame_header(zstd_frame_header *params, const void *src,
 	size_t src_size);
 
+/* ======   Parallel Decompression   ====== */
+
+/**
+ * zstd_decompress_frames() - decompress a run of independent frames in parallel
+ * @src:      The source buffer, starting with a zstd or skippable frame.
+ * @src_size: The size of the source buffer.
+ * @flush:    Called with the content of each frame, in order, from the
+ *            caller's context. It returns 0 or a negative errno, which stops
+ *            the decompression.
+ * @priv:     Passed to @flush.
+ * @consumed: On success, the size of the run of frames, which ends at the end
+ *            of @src or at the first data that is not a frame.
+ *
+ * Each frame is decompressed in one go by an unbound worker, so this needs
+ * the content size of every frame in their headers, and memory for up to one
+ * frame per online CPU in flight.
+ *
+ * Return:    0 on success, -EOPNOTSUPP without calling @flush if there are
+ *            less than two frames or the content size of one is unknown or
+ *            too large, or another negative errno.
+ */
+int zstd_decompress_frames(const void *src, size_t src_size,
+	int (*flush)(void *priv, void *buf, size_t len), void *priv,
+	size_t *consumed);
+
 #endif  /* LINUX_ZSTD_H */
@@ -97,6 +97,7 @@ struct v4l2_m2m_queue_ctx {
  * @job_flags: Job queue flags, used internally by v4l2-mem2mem.c:
  *		%TRANS_QUEUED, %TRANS_RUNNING and %TRANS_ABORT.
  * @finished: Wait queue used to signalize when a job queue finished.
+ * @priority: V4L2 priority of the file handle, orders the job queue.
  * @priv: Instance private data
  *
  * The memory to memory context is specific to a file handle, NOT to e.g.
@@ -125,6 +126,7 @@ struct v4l2_m2m_ctx {
 	struct list_head		queue;
 	unsigned long			job_flags;
 	wait_queue_head_t		finished;
+	enum v4l2_priority		priority;
 
 	void				*priv;
 };
@@ -145,9 +147,42 @@ struct v4l2_m2m_buffer {
  * running instance or NULL if no instance is running
  *
  * @m2m_dev: opaque pointer to the internal data to handle M2M context
+ *
+ * Only meaningful if a single job runs at a time, drivers that raised the
+ * limit with v4l2_m2m_set_max_jobs() have to track their running instances.
  */
 void *v4l2_m2m_get_curr_priv(struct v4l2_m2m_dev *m2m_dev);
 
+/**
+ * v4l2_m2m_set_max_jobs() - set the number of jobs that may run concurrently
+ *
+ * @m2m_dev: opaque pointer to the internal data to handle M2M context
+ * @max_jobs: maximum number of running jobs, 1 by default
+ *
+ * For hardware with several independent processing units, such as the
+ * slots of a JPEG codec. The framework then calls &v4l2_m2m_ops->device_run
+ * for jobs of different instances before the previous ones are finished,
+ * possibly concurrently, and the driver dispatches each job to a free unit.
+ * A given instance never has more than one job running.
+ *
+ * Jobs are started by decreasing V4L2 priority of the instances' file
+ * handles, and in queuing order for a same priority.
+ *
+ * Usually called from driver's ``probe()`` function, after v4l2_m2m_init().
+ */
+void v4l2_m2m_set_max_jobs(struct v4l2_m2m_dev *m2m_dev, unsigned int max_jobs);
+
+/**
+ * v4l2_m2m_should_yield() - check if a higher priority job is waiting
+ *
+ * @m2m_ctx: m2m context assigned to the instance given by struct &v4l2_m2m_ctx
+ *
+ * For drivers that process several buffers of an instance in one job: they
+ * should finish the job once this returns true, so that the queued job of a
+ * higher priority instance gets the device.
+ */
+bool v4l2_m2m_should_yield(struct v4l2_m2m_ctx *m2m_ctx);
+
 /**
  * v4l2_m2m_get_vq() - return vb2_queue for the given type
  *
@@ -318,7 +353,7 @@ void v4l2_m2m_last_buffer_done(struct v4l2_m2m_ctx *m2m_ctx,
  * @m2m_dev: opaque pointer to the internal data to handle M2M context
  *
  * Called by a driver in the suspend hook. Stop new jobs from being run, and
- * wait for current running job to finish.
+ * wait for current running jobs to finish.
  */
 void v4l2_m2m_suspend(struct v4l2_m2m_dev *m2m_dev);
 
@@ -126,6 +126,61 @@ int bman_release(struct bman_pool *pool, const struct bm_buffer *bufs, u8 num);
  */
 int bman_acquire(struct bman_pool *pool, struct bm_buffer *bufs, u8 num);
 
+/**
+ * bman_release_bulk - Release any number of buffers to the buffer pool
+ * @pool: the buffer pool object to release to
+ * @bufs: an array of buffers to release
+ * @num: the number of buffers in @bufs
+ *
+ * Like bman_release(), but fills back-to-back RCR entries (8 buffers each)
+ * and commits them together, with a single consumer index update per batch.
+ * Returns zero, or -ETIMEDOUT if the RCR ring is unresponsive, in which case
+ * some of the buffers may not have been released.
+ */
+int bman_release_bulk(struct bman_pool *pool, const struct bm_buffer *bufs,
+		      int num);
+
+/**
+ * bman_acquire_bulk - Acquire any number of buffers from a buffer pool
+ * @pool: the buffer pool object to acquire from
+ * @bufs: array for storing the acquired buffers
+ * @num: the number of buffers desired (@bufs is at least this big)
+ *
+ * Issues as many "Acquire" commands as needed. Returns the number of buffers
+ * obtained, which is less than @num if the pool ran dry, or a negative error
+ * code if none could be acquired.
+ */
+int bman_acquire_bulk(struct bman_pool *pool, struct bm_buffer *bufs, int num);
+
+/**
+ * bman_release_staged - Release buffer(s) through the per-CPU staging area
+ * @pool: the buffer pool object to release to
+ * @bufs: an array of buffers to release
+ * @num: the number of buffers in @bufs (1-8)
+ *
+ * The buffers are accumulated on the local CPU and handed to BMan with
+ * bman_release_bulk() once enough of them are staged. They stay out of the
+ * pool until then, or until bman_release_flush() is called on this CPU.
+ * Returns zero, or -ETIMEDOUT if a flush to an unresponsive RCR ring failed.
+ */
+int bman_release_staged(struct bman_pool *pool, const struct bm_buffer *bufs,
+			u8 num);
+
+/**
+ * bman_release_flush - Release the buffers staged on the local CPU
+ * @pool: the buffer pool object
+ */
+int bman_release_flush(struct bman_pool *pool);
+
+/**
+ * bman_release_flush_all - Release the buffers staged on all CPUs
+ * @pool: the buffer pool object
+ *
+ * Must only be called when no CPU can be staging buffers to @pool, e.g.
+ * before draining it for good.
+ */
+int bman_release_flush_all(struct bman_pool *pool);
+
 /**
  * bman_is_probed - Check if bman is probed
  *
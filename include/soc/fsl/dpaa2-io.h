@@ -124,8 +124,12 @@ int dpaa2_io_service_acquire(struct dpaa2_io *d, u16 bpid,
 
 struct dpaa2_io_store *dpaa2_io_store_create(unsigned int max_frames,
 					     struct device *dev);
+struct dpaa2_io_store *dpaa2_io_store_create_double(unsigned int max_frames,
+						    struct device *dev);
+void dpaa2_io_store_set_pull_ahead(struct dpaa2_io_store *s, bool enable);
 void dpaa2_io_store_destroy(struct dpaa2_io_store *s);
 struct dpaa2_dq *dpaa2_io_store_next(struct dpaa2_io_store *s, int *is_last);
+struct dpaa2_dq *dpaa2_io_store_peek(struct dpaa2_io_store *s);
 
 /* Order Restoration Support */
 int dpaa2_io_service_enqueue_orp_fq(struct dpaa2_io *d, u32 fqid,
@@ -1086,6 +1086,19 @@ int qman_volatile_dequeue(struct qman_fq *fq, u32 flags, u32 vdqcr);
  */
 int qman_enqueue(struct qman_fq *fq, const struct qm_fd *fd);
 
+/**
+ * qman_enqueue_multi - Enqueue several frames to a frame queue
+ * @fq: the frame queue object to enqueue to
+ * @fd: array of descriptors of the frames to be enqueued
+ * @frames: number of entries in @fd
+ *
+ * Like qman_enqueue(), but fills as many EQCR entries of the affine portal as
+ * are available (up to @frames) and commits them all at once. Returns the
+ * number of frames enqueued, which may be less than @frames (including zero)
+ * if the ring is full.
+ */
+int qman_enqueue_multi(struct qman_fq *fq, const struct qm_fd *fd, int frames);
+
 /**
  * qman_alloc_fqid_range - Allocate a contiguous range of FQIDs
  * @result: is set by the API to the base FQID of the allocated range
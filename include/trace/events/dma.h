@@ -6,6 +6,7 @@
 #define _TRACE_DMA_H
 
 #include <linux/tracepoint.h>
+#include <linux/cma.h>
 #include <linux/dma-direction.h>
 #include <linux/dma-mapping.h>
 #include <trace/events/mmflags.h>
@@ -175,6 +176,64 @@ TRACE_EVENT(dma_free,
 		decode_dma_attrs(__entry->attrs))
 );
 
+TRACE_EVENT(dma_alloc_contiguous,
+	TP_PROTO(struct device *dev, struct cma *cma, struct page *page,
+		 size_t size, u64 latency_ns),
+	TP_ARGS(dev, cma, page, size, latency_ns),
+
+	TP_STRUCT__entry(
+		__string(device, dev_name(dev))
+		__string(cma, cma_get_name(cma))
+		__field(unsigned long, pfn)
+		__field(size_t, size)
+		__field(u64, latency_ns)
+	),
+
+	TP_fast_assign(
+		__assign_str(device);
+		__assign_str(cma);
+		__entry->pfn = page ? page_to_pfn(page) : -1UL;
+		__entry->size = size;
+		__entry->latency_ns = latency_ns;
+	),
+
+	TP_printk("%s cma=%s pfn=0x%lx size=%zu latency_ns=%llu",
+		__get_str(device),
+		__get_str(cma),
+		__entry->pfn,
+		__entry->size,
+		__entry->latency_ns)
+);
+
+TRACE_EVENT(dma_contiguous_preclean,
+	TP_PROTO(struct cma *cma, unsigned long free_run, unsigned long count,
+		 u64 latency_ns, int ret),
+	TP_ARGS(cma, free_run, count, latency_ns, ret),
+
+	TP_STRUCT__entry(
+		__string(cma, cma_get_name(cma))
+		__field(unsigned long, free_run)
+		__field(unsigned long, count)
+		__field(u64, latency_ns)
+		__field(int, ret)
+	),
+
+	TP_fast_assign(
+		__assign_str(cma);
+		__entry->free_run = free_run;
+		__entry->count = count;
+		__entry->latency_ns = latency_ns;
+		__entry->ret = ret;
+	),
+
+	TP_printk("cma=%s free_run=%lu count=%lu latency_ns=%llu ret=%d",
+		__get_str(cma),
+		__entry->free_run,
+		__entry->count,
+		__entry->latency_ns,
+		__entry->ret)
+);
+
 TRACE_EVENT(dma_map_sg,
 	TP_PROTO(struct device *dev, struct scatterlist *sgl, int nents,
 		 int ents, enum dma_data_direction dir, unsigned long attrs),
@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM nvmem
+
+#if !defined(_TRACE_NVMEM_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_NVMEM_H
+
+#include <linux/tracepoint.h>
+
+/* A read of the provider, with the time it took */
+TRACE_EVENT(nvmem_reg_read,
+	TP_PROTO(const char *name, unsigned int offset, size_t bytes, int ret,
+		 u64 elapsed_ns),
+	TP_ARGS(name, offset, bytes, ret, elapsed_ns),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(unsigned int, offset)
+		__field(size_t, bytes)
+		__field(int, ret)
+		__field(u64, elapsed_ns)
+	),
+
+	TP_fast_assign(
+		__assign_str(name);
+		__entry->offset = offset;
+		__entry->bytes = bytes;
+		__entry->ret = ret;
+		__entry->elapsed_ns = elapsed_ns;
+	),
+
+	TP_printk("%s offset=%#x bytes=%zu ret=%d elapsed=%llu ns",
+		  __get_str(name), __entry->offset, __entry->bytes,
+		  __entry->ret, __entry->elapsed_ns)
+);
+#endif /* _TRACE_NVMEM_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
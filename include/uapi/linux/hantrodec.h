@@ -43,6 +43,19 @@ struct core_desc {
 	__u32 size; /* size of register space */
 };
 
+/*
+ * A decoder job: the kernel runs it on the next free core that has the
+ * format, and gives the registers back once the core is done with it.
+ */
+struct hantrodec_job {
+	__u32 format; /* DWL_CLIENT_TYPE_* the job needs */
+	__u32 size; /* size of register space */
+	__u64 regs; /* pointer to user registers, read back on completion */
+	__u64 seqno; /* job id, from SUBMIT; job to wait for or 0 for any, to WAIT */
+	__u32 core; /* id of the Core that ran the job */
+	__s32 status; /* 0, or -ETIMEDOUT if the Core had to be reset */
+};
+
 /* Use 'k' as magic number */
 #define HANTRODEC_IOC_MAGIC  'k'
 
@@ -86,6 +99,9 @@ struct core_desc {
 
 #define HANTRODEC_IOCG_CORE_ID       _IO(HANTRODEC_IOC_MAGIC, 21)
 
+#define HANTRODEC_IOCX_JOB_SUBMIT    _IOWR(HANTRODEC_IOC_MAGIC, 22, struct hantrodec_job)
+#define HANTRODEC_IOCX_JOB_WAIT      _IOWR(HANTRODEC_IOC_MAGIC, 23, struct hantrodec_job)
+
 #define HANTRODEC_DEBUG_STATUS       _IO(HANTRODEC_IOC_MAGIC, 29)
 
 #define HANTRODEC_IOC_MAXNR 29
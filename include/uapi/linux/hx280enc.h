@@ -52,6 +52,28 @@ struct enc_regs_buffer {
 	__u32 *reserved;
 };
 
+/*
+ * An encoder job: the kernel starts it once the core is free, and gives the
+ * registers back once the frame is encoded.
+ */
+struct enc_job_buffer {
+	__u32 core_id; /* id of the core to run the job on */
+	__u32 size; /* size of register space */
+	__u64 regs; /* pointer to user registers, read back on completion */
+	__u64 seqno; /* job id, from SUBMIT; job to wait for or 0 for any, to WAIT */
+	__s32 fence_fd; /* sync_file signalled on completion, from SUBMIT */
+	__s32 status; /* 0, or -ETIMEDOUT if the core had to be stopped */
+};
+
+/* what the jobs of an open file used the core for */
+struct enc_job_stats {
+	__u64 jobs; /* jobs completed */
+	__u64 timeouts; /* of which timed out */
+	__u64 busy_ns; /* time the core ran the jobs */
+	__u64 queue_ns; /* time the jobs waited for the core */
+	__u64 elapsed_ns; /* time since the file was opened */
+};
+
 /*
  * Ioctl definitions
  */
@@ -89,6 +111,10 @@ struct enc_regs_buffer {
 
 #define HX280ENC_IOCG_EN_CORE      _IO(HX280ENC_IOC_MAGIC, 16)
 
+#define HX280ENC_IOCX_JOB_SUBMIT    _IOWR(HX280ENC_IOC_MAGIC, 17, struct enc_job_buffer)
+#define HX280ENC_IOCX_JOB_WAIT      _IOWR(HX280ENC_IOC_MAGIC, 18, struct enc_job_buffer)
+#define HX280ENC_IOCG_JOB_STATS    _IOR(HX280ENC_IOC_MAGIC, 19, struct enc_job_stats)
+
 #define HX280ENC_IOC_MAXNR 30
 
 #endif /* !_UAPI_HX280ENC_H_ */
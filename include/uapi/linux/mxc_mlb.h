@@ -16,6 +16,8 @@
 #ifndef _MXC_MLB_UAPI_H
 #define _MXC_MLB_UAPI_H
 
+#include <linux/types.h>
+
 /* define IOCTL command */
 #define MLB_DBG_RUNTIME		_IO('S', 0x09)
 #define MLB_SET_FPS		_IOW('S', 0x10, unsigned int)
@@ -37,6 +39,40 @@
 #define MLB_IRQ_ENABLE		_IO('S', 0x20)
 #define MLB_IRQ_DISABLE		_IO('S', 0x21)
 
+/*!
+ * Ring buffer mode, for the sync and isoc channels: the AHB DMA fills (rx)
+ * and drains (tx) rings of periods which user space maps, with one
+ * interrupt and one wakeup per period, instead of read() and write().
+ * Set the periods before MLB_CHAN_STARTUP, once per open, then mmap() the
+ * rx ring at offset 0 and the tx ring right after it, at the next page.
+ */
+struct mlb_ringbuf_params {
+	/* bytes of a period, a multiple of the channel block, at most 8192 */
+	__u32 period_bytes;
+	/* periods in each ring, 2 to 256 */
+	__u32 periods;
+};
+
+/*!
+ * Positions in the rings, counted in periods since the ring was set
+ * up.  Period n is at (n % periods) * period_bytes.  Pass the periods
+ * user space consumed (rx_appl) and queued (tx_appl), get back what the
+ * hardware filled (rx_hw) and sent (tx_hw).
+ */
+struct mlb_ringbuf_status {
+	__u64 rx_hw;
+	__u64 rx_appl;
+	__u64 tx_hw;
+	__u64 tx_appl;
+	/* rx periods overwritten before they were consumed */
+	__u32 rx_xruns;
+	/* times the tx ring ran empty */
+	__u32 tx_xruns;
+};
+
+#define MLB_SET_RINGBUF		_IOW('S', 0x22, struct mlb_ringbuf_params)
+#define MLB_RINGBUF_SYNC	_IOWR('S', 0x23, struct mlb_ringbuf_status)
+
 /*!
  * MLB event define
  */
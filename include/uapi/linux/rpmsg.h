@@ -53,4 +53,29 @@ struct rpmsg_endpoint_info {
  */
 #define RPMSG_SET_INCOMING_FLOWCONTROL _IOR(0xb5, 0x6, int)
 
+/**
+ * struct rpmsg_pool_buf - buffer of the shared pool of a rpmsg char device
+ * @offset: offset of the buffer in the pool, as mapped by mmap()
+ * @len: size of the buffer on alloc, length of valid data on send
+ */
+struct rpmsg_pool_buf {
+	__u32 offset;
+	__u32 len;
+};
+
+/**
+ * Allocate a buffer from the shared pool.
+ */
+#define RPMSG_POOL_ALLOC_IOCTL	_IOWR(0xb5, 0x7, struct rpmsg_pool_buf)
+
+/**
+ * Return a buffer to the shared pool.
+ */
+#define RPMSG_POOL_FREE_IOCTL	_IOW(0xb5, 0x8, struct rpmsg_pool_buf)
+
+/**
+ * Pass a buffer of the shared pool to the remote by reference.
+ */
+#define RPMSG_POOL_SEND_IOCTL	_IOW(0xb5, 0x9, struct rpmsg_pool_buf)
+
 #endif
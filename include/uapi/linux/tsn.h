@@ -75,6 +75,9 @@ enum {
 	TSN_CMD_ECHO,			/* user->kernel request/get-response */
 	TSN_CMD_REPLY,			/* kernel->user event */
 	TSN_CMD_CAP_GET,
+	TSN_CMD_TXN_BEGIN,		/* stage the following set commands */
+	TSN_CMD_TXN_COMMIT,		/* apply the staged commands */
+	TSN_CMD_TXN_ABORT,		/* drop the staged commands */
 	__TSN_CMD_MAX,
 };
 #define TSN_CMD_MAX (__TSN_CMD_MAX - 1)
@@ -102,10 +105,18 @@ enum {
 	TSN_ATTR_PCPMAP,
 	TSN_ATTR_DSCP,
 	TSN_ATTR_CAP,			/* TSN capbility */
+	TSN_ATTR_TXN,			/* configuration transaction */
 	__TSN_CMD_ATTR_MAX,
 };
 #define TSN_CMD_ATTR_MAX (__TSN_CMD_ATTR_MAX - 1)
 
+enum {
+	TSN_TXN_ATTR_UNSPEC,
+	TSN_TXN_ATTR_BASETIME,		/* common base time of all schedules */
+	__TSN_TXN_ATTR_MAX,
+	TSN_TXN_ATTR_MAX = __TSN_TXN_ATTR_MAX - 1,
+};
+
 enum {
 	TSN_CAP_ATTR_UNSPEC,
 	TSN_CAP_ATTR_QBV,
@@ -734,6 +734,8 @@ struct dpu_plane_grp {
 	u32			src_mask;
 	u32			src_a_mask;
 	u32			src_use_vproc_mask;
+	/* planes needing tile resolving which are not assigned yet */
+	unsigned int		src_tiled_num;
 };
 
 static inline struct dpu_plane_grp *plane_res_to_grp(struct dpu_plane_res *res)
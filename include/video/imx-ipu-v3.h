@@ -252,7 +252,15 @@ struct ipu_image {
 	u32 v_offset;
 };
 
+/* copy of the two 160-bit parameter words of a channel */
+struct ipu_cpmem_snapshot {
+	u32 data[2][5];
+};
+
 void ipu_cpmem_zero(struct ipuv3_channel *ch);
+void ipu_cpmem_save(struct ipuv3_channel *ch, struct ipu_cpmem_snapshot *snap);
+void ipu_cpmem_restore(struct ipuv3_channel *ch,
+		       const struct ipu_cpmem_snapshot *snap);
 void ipu_cpmem_set_resolution(struct ipuv3_channel *ch, int xres, int yres);
 void ipu_cpmem_skip_odd_chroma_rows(struct ipuv3_channel *ch);
 void ipu_cpmem_set_stride(struct ipuv3_channel *ch, int stride);
@@ -6,6 +6,8 @@
 #ifndef __IMX_LCDIFV3_H__
 #define __IMX_LCDIFV3_H__
 
+#include <drm/drm_color_mgmt.h>
+
 struct lcdifv3_soc;
 struct videomode;
 
@@ -21,6 +23,9 @@ void lcdifv3_vblank_irq_clear(struct lcdifv3_soc *lcdifv3);
 int  lcdifv3_get_bus_fmt_from_pix_fmt(struct lcdifv3_soc *lcdifv3,
 				    uint32_t format);
 int  lcdifv3_set_pix_fmt(struct lcdifv3_soc *lcdifv3, u32 format);
+void lcdifv3_set_csc(struct lcdifv3_soc *lcdifv3, u32 format,
+		     enum drm_color_encoding encoding,
+		     enum drm_color_range range);
 void lcdifv3_set_bus_fmt(struct lcdifv3_soc *lcdifv3, u32 bus_format);
 void lcdifv3_set_fb_addr(struct lcdifv3_soc *lcdifv3, int id, u32 addr);
 void lcdifv3_set_mode(struct lcdifv3_soc *lcdifv3, struct videomode *vmode);
@@ -30,4 +35,8 @@ void lcdifv3_enable_controller(struct lcdifv3_soc *lcdifv3);
 void lcdifv3_disable_controller(struct lcdifv3_soc *lcdifv3);
 void lcdifv3_dump_registers(struct lcdifv3_soc *lcdifv3);
 
+bool lcdifv3_handover_get_mode(struct lcdifv3_soc *lcdifv3,
+			       struct videomode *vmode);
+void lcdifv3_handover_release(struct lcdifv3_soc *lcdifv3);
+
 #endif
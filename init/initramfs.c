@@ -497,6 +497,44 @@ static unsigned long my_inptr __initdata; /* index of next byte to be processed
 
 #include <linux/decompress/generic.h>
 
+#ifdef CONFIG_RD_ZSTD
+#include <linux/zstd.h>
+
+static int __init flush_zstd_frame(void *priv, void *buf, size_t len)
+{
+	return flush_buffer(buf, len) == len ? 0 : -EINVAL;
+}
+
+/*
+ * Archives made of many independent frames, e.g. by pzstd, are unpacked with
+ * all CPUs decompressing frames ahead of the cpio parser.
+ */
+static bool __init unpack_zstd_frames(char *buf, unsigned long len,
+				      const char *compress_name)
+{
+	size_t consumed;
+	int err;
+
+	if (strcmp(compress_name, "zstd"))
+		return false;
+
+	err = zstd_decompress_frames(buf, len, flush_zstd_frame, NULL,
+				     &consumed);
+	if (err == -EOPNOTSUPP)
+		return false;
+	if (err)
+		error("decompressor failed");
+	my_inptr = err ? 0 : consumed;
+	return true;
+}
+#else
+static bool __init unpack_zstd_frames(char *buf, unsigned long len,
+				      const char *compress_name)
+{
+	return false;
+}
+#endif
+
 static char * __init unpack_to_rootfs(char *buf, unsigned long len)
 {
 	long written;
@@ -532,7 +570,10 @@ static char * __init unpack_to_rootfs(char *buf, unsigned long len)
 		this_header = 0;
 		decompress = decompress_method(buf, len, &compress_name);
 		pr_debug("Detected %s compressed data\n", compress_name);
-		if (decompress) {
+		if (decompress && unpack_zstd_frames(buf, len, compress_name)) {
+			pr_debug("Decompressed %s frames in parallel\n",
+				 compress_name);
+		} else if (decompress) {
 			int res = decompress(buf, len, NULL, flush_buffer, NULL,
 				   &my_inptr, error);
 			if (res)
@@ -44,7 +44,11 @@
 #include <linux/sizes.h>
 #include <linux/dma-map-ops.h>
 #include <linux/cma.h>
+#include <linux/ktime.h>
+#include <linux/mm.h>
 #include <linux/nospec.h>
+#include <linux/workqueue.h>
+#include <trace/events/dma.h>
 
 #ifdef CONFIG_CMA_SIZE_MBYTES
 #define CMA_SIZE_MBYTES CONFIG_CMA_SIZE_MBYTES
@@ -325,12 +329,139 @@ bool dma_release_from_contiguous(struct device *dev, struct page *pages,
 	return cma_release(dev_get_cma_area(dev), pages, count);
 }
 
-static struct page *cma_alloc_aligned(struct cma *cma, size_t size, gfp_t gfp)
+/*
+ * Pre-cleaning of the default area: big allocations spend most of their time
+ * migrating movable pages out of the range they land on.  With
+ * cma_preclean=<size>, a background worker makes sure that a free range of
+ * that size exists, by allocating and releasing it when it does not, so that
+ * the next allocation of up to that size finds the range it picks already
+ * clean.  The movable page allocator may fill it again under pressure, so
+ * this is best effort.
+ */
+#define DMA_PRECLEAN_INTERVAL		HZ
+#define DMA_PRECLEAN_MAX_INTERVAL	(60 * HZ)
+#define DMA_PRECLEAN_DELAY		(HZ / 10)
+
+static unsigned long dma_preclean_pages;
+static unsigned long dma_preclean_interval = DMA_PRECLEAN_INTERVAL;
+static void dma_preclean_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(dma_preclean_work, dma_preclean_fn);
+
+static int __init early_cma_preclean(char *p)
+{
+	dma_preclean_pages = PAGE_ALIGN(memparse(p, &p)) >> PAGE_SHIFT;
+	return 0;
+}
+early_param("cma_preclean", early_cma_preclean);
+
+static unsigned int cma_align(size_t size)
+{
+	return min(get_order(size), CONFIG_CMA_ALIGNMENT);
+}
+
+static struct page *cma_alloc_aligned(struct device *dev, struct cma *cma,
+				      size_t size, gfp_t gfp)
+{
+	ktime_t start = ktime_get();
+	struct page *page;
+
+	page = cma_alloc(cma, size >> PAGE_SHIFT, cma_align(size),
+			 gfp & __GFP_NOWARN);
+	trace_dma_alloc_contiguous(dev, cma, page, size,
+				   ktime_to_ns(ktime_sub(ktime_get(), start)));
+
+	/* the allocation may have used up the clean range, look for another */
+	if (page && cma == dma_contiguous_default_area && dma_preclean_pages)
+		mod_delayed_work(system_unbound_wq, &dma_preclean_work,
+				 DMA_PRECLEAN_DELAY);
+	return page;
+}
+
+/*
+ * Longest run of free pages in @cma.  This peeks at the buddy state without
+ * the zone lock, which is fine for a heuristic: a stale order is bounded, and
+ * at worst the area is cleaned once too often or too late.
+ */
+static unsigned long dma_preclean_free_run(struct cma *cma)
+{
+	unsigned long pfn = PHYS_PFN(cma_get_base(cma));
+	unsigned long end = pfn + (cma_get_size(cma) >> PAGE_SHIFT);
+	unsigned long run = 0, best = 0, nr, order;
+	unsigned int n = 0;
+
+	while (pfn < end) {
+		struct page *page = pfn_to_page(pfn);
+
+		nr = 1;
+		if (PageBuddy(page)) {
+			order = READ_ONCE(page_private(page));
+			if (order <= MAX_PAGE_ORDER)
+				nr = min(1UL << order, end - pfn);
+			run += nr;
+			best = max(best, run);
+		} else {
+			run = 0;
+		}
+		pfn += nr;
+
+		if (!(++n % SZ_1K))
+			cond_resched();
+	}
+	return best;
+}
+
+static void dma_preclean_fn(struct work_struct *work)
 {
-	unsigned int align = min(get_order(size), CONFIG_CMA_ALIGNMENT);
+	struct cma *cma = dma_contiguous_default_area;
+	unsigned long count = dma_preclean_pages, free_run;
+	struct page *page;
+	ktime_t start;
+	int ret = 0;
+
+	free_run = dma_preclean_free_run(cma);
+	if (free_run < count) {
+		start = ktime_get();
+		page = cma_alloc(cma, count, cma_align(count << PAGE_SHIFT),
+				 true);
+		if (page)
+			cma_release(cma, page, count);
+		else
+			ret = -ENOMEM;
+		trace_dma_contiguous_preclean(cma, free_run, count,
+				ktime_to_ns(ktime_sub(ktime_get(), start)), ret);
+	}
+
+	/* back off while the area is too busy to be cleaned */
+	if (ret)
+		dma_preclean_interval = min(dma_preclean_interval * 2,
+					    DMA_PRECLEAN_MAX_INTERVAL);
+	else
+		dma_preclean_interval = DMA_PRECLEAN_INTERVAL;
+	queue_delayed_work(system_unbound_wq, &dma_preclean_work,
+			   round_jiffies_relative(dma_preclean_interval));
+}
 
-	return cma_alloc(cma, size >> PAGE_SHIFT, align, gfp & __GFP_NOWARN);
+static int __init dma_preclean_init(void)
+{
+	struct cma *cma = dma_contiguous_default_area;
+
+	if (!dma_preclean_pages || !cma)
+		return 0;
+
+	if (dma_preclean_pages > cma_get_size(cma) >> (PAGE_SHIFT + 1)) {
+		pr_warn("cma_preclean size larger than half of area %s, ignored\n",
+			cma_get_name(cma));
+		dma_preclean_pages = 0;
+		return 0;
+	}
+
+	pr_info("keeping %lu MiB of area %s clean\n",
+		dma_preclean_pages >> (20 - PAGE_SHIFT), cma_get_name(cma));
+	queue_delayed_work(system_unbound_wq, &dma_preclean_work,
+			   DMA_PRECLEAN_INTERVAL);
+	return 0;
 }
+late_initcall(dma_preclean_init);
 
 /**
  * dma_alloc_contiguous() - allocate contiguous pages
@@ -357,7 +488,7 @@ struct page *dma_alloc_contiguous(struct device *dev, size_t size, gfp_t gfp)
 	if (!gfpflags_allow_blocking(gfp))
 		return NULL;
 	if (dev->cma_area)
-		return cma_alloc_aligned(dev->cma_area, size, gfp);
+		return cma_alloc_aligned(dev, dev->cma_area, size, gfp);
 	if (size <= PAGE_SIZE)
 		return NULL;
 
@@ -367,14 +498,14 @@ struct page *dma_alloc_contiguous(struct device *dev, size_t size, gfp_t gfp)
 		struct page *page;
 
 		if (cma) {
-			page = cma_alloc_aligned(cma, size, gfp);
+			page = cma_alloc_aligned(dev, cma, size, gfp);
 			if (page)
 				return page;
 		}
 
 		cma = dma_contiguous_numa_area[nid];
 		if (cma) {
-			page = cma_alloc_aligned(cma, size, gfp);
+			page = cma_alloc_aligned(dev, cma, size, gfp);
 			if (page)
 				return page;
 		}
@@ -383,7 +514,8 @@ struct page *dma_alloc_contiguous(struct device *dev, size_t size, gfp_t gfp)
 	if (!dma_contiguous_default_area)
 		return NULL;
 
-	return cma_alloc_aligned(dma_contiguous_default_area, size, gfp);
+	return cma_alloc_aligned(dev, dma_contiguous_default_area, size,
+				 gfp);
 }
 
 /**
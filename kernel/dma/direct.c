@@ -246,6 +246,13 @@ void *dma_direct_alloc(struct device *dev, size_t size,
 		}
 	}
 
+	/* a recycled buffer is already remapped and can be handed out here */
+	if (remap) {
+		ret = dma_recycle_alloc(dev, size, dma_handle, attrs);
+		if (ret)
+			return ret;
+	}
+
 	/*
 	 * Remapping or decrypting memory may block, allocate the memory from
 	 * the atomic pools instead if we aren't allowed block.
@@ -254,6 +261,9 @@ void *dma_direct_alloc(struct device *dev, size_t size,
 	    dma_direct_use_pool(dev, gfp))
 		return dma_direct_alloc_from_pool(dev, size, dma_handle, gfp);
 
+	/* allocate whole size classes if the buffer may get recycled */
+	size = dma_recycle_size(dev, size, attrs);
+
 	/* we always manually zero the memory once we are done */
 	page = __dma_direct_alloc_pages(dev, size, gfp & ~__GFP_ZERO, true);
 	if (!page)
@@ -343,6 +353,9 @@ void dma_direct_free(struct device *dev, size_t size,
 		return;
 
 	if (is_vmalloc_addr(cpu_addr)) {
+		size = dma_recycle_size(dev, PAGE_ALIGN(size), attrs);
+		if (dma_recycle_free(dev, cpu_addr, dma_addr, size, attrs))
+			return;
 		vunmap(cpu_addr);
 	} else {
 		if (IS_ENABLED(CONFIG_ARCH_HAS_DMA_CLEAR_UNCACHED))
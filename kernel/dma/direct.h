@@ -23,6 +23,30 @@ int dma_direct_map_sg(struct device *dev, struct scatterlist *sgl, int nents,
 bool dma_direct_all_ram_mapped(struct device *dev);
 size_t dma_direct_max_mapping_size(struct device *dev);
 
+#ifdef CONFIG_DMA_RECYCLE
+size_t dma_recycle_size(struct device *dev, size_t size, unsigned long attrs);
+void *dma_recycle_alloc(struct device *dev, size_t size,
+		dma_addr_t *dma_handle, unsigned long attrs);
+bool dma_recycle_free(struct device *dev, void *cpu_addr, dma_addr_t dma_addr,
+		size_t size, unsigned long attrs);
+#else
+static inline size_t dma_recycle_size(struct device *dev, size_t size,
+		unsigned long attrs)
+{
+	return size;
+}
+static inline void *dma_recycle_alloc(struct device *dev, size_t size,
+		dma_addr_t *dma_handle, unsigned long attrs)
+{
+	return NULL;
+}
+static inline bool dma_recycle_free(struct device *dev, void *cpu_addr,
+		dma_addr_t dma_addr, size_t size, unsigned long attrs)
+{
+	return false;
+}
+#endif /* CONFIG_DMA_RECYCLE */
+
 #if defined(CONFIG_ARCH_HAS_SYNC_DMA_FOR_DEVICE) || \
     defined(CONFIG_SWIOTLB)
 void dma_direct_sync_sg_for_device(struct device *dev, struct scatterlist *sgl,
@@ -8,6 +8,7 @@
 #include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/device.h>
+#include <linux/dma-buf.h>
 #include <linux/dma-mapping.h>
 #include <linux/kernel.h>
 #include <linux/kthread.h>
@@ -16,9 +17,17 @@
 #include <linux/module.h>
 #include <linux/pci.h>
 #include <linux/platform_device.h>
+#include <linux/scatterlist.h>
 #include <linux/slab.h>
 #include <linux/timekeeping.h>
 
+/*
+ * Latencies are kept in a log-linear histogram in ns: 8 buckets per power of
+ * two, so the percentiles derived from it are within 12.5% of the truth.
+ */
+#define MAP_BENCHMARK_SUB_BITS	3
+#define MAP_BENCHMARK_BUCKETS	(32 << MAP_BENCHMARK_SUB_BITS)
+
 struct map_benchmark_data {
 	struct map_benchmark bparam;
 	struct device *dev;
@@ -29,43 +38,429 @@ struct map_benchmark_data {
 	atomic64_t sum_sq_map;
 	atomic64_t sum_sq_unmap;
 	atomic64_t loops;
+	atomic64_t map_hist[MAP_BENCHMARK_BUCKETS];
+	atomic64_t unmap_hist[MAP_BENCHMARK_BUCKETS];
+};
+
+/* per-thread state of one benchmark loop */
+struct map_benchmark_ctx {
+	struct map_benchmark_data *map;
+	size_t size;		/* bytes of each buffer */
+	unsigned int nents;	/* number of buffers */
+	void **bufs;
+	void *cpu_addr;
+	dma_addr_t dma_addr;
+	bool mapped;
+	struct sg_table sgt;
+	struct dma_buf *dmabuf;
+	struct dma_buf_attachment *attach;
+	struct sg_table *dmabuf_sgt;
+};
+
+/*
+ * ->map and ->unmap are the two operations timed by each loop, ->setup and
+ * ->teardown run once per thread outside of the measurement.
+ */
+struct map_benchmark_ops {
+	int (*setup)(struct map_benchmark_ctx *ctx);
+	int (*map)(struct map_benchmark_ctx *ctx);
+	void (*unmap)(struct map_benchmark_ctx *ctx);
+	void (*teardown)(struct map_benchmark_ctx *ctx);
+	bool stain;
+};
+
+static unsigned int map_benchmark_bucket(u64 ns)
+{
+	unsigned int shift, bucket;
+
+	if (ns < (1 << MAP_BENCHMARK_SUB_BITS))
+		return ns;
+	shift = fls64(ns) - 1 - MAP_BENCHMARK_SUB_BITS;
+	bucket = ((shift + 1) << MAP_BENCHMARK_SUB_BITS) +
+		 ((ns >> shift) & ((1 << MAP_BENCHMARK_SUB_BITS) - 1));
+	return min(bucket, MAP_BENCHMARK_BUCKETS - 1);
+}
+
+/* lowest latency accounted to @bucket */
+static u64 map_benchmark_bucket_ns(unsigned int bucket)
+{
+	unsigned int shift;
+
+	if (bucket < (1 << MAP_BENCHMARK_SUB_BITS))
+		return bucket;
+	shift = (bucket >> MAP_BENCHMARK_SUB_BITS) - 1;
+	return (u64)((1 << MAP_BENCHMARK_SUB_BITS) |
+		     (bucket & ((1 << MAP_BENCHMARK_SUB_BITS) - 1))) << shift;
+}
+
+static void map_benchmark_percentiles(atomic64_t *hist, u64 loops, __u64 *pct)
+{
+	static const unsigned int permille[DMA_MAP_NR_PERCENTILES] = {
+		500, 900, 990, 999
+	};
+	unsigned int bucket, i = 0;
+	u64 seen = 0;
+
+	for (bucket = 0; bucket < MAP_BENCHMARK_BUCKETS; bucket++) {
+		seen += atomic64_read(&hist[bucket]);
+		while (i < DMA_MAP_NR_PERCENTILES &&
+		       seen * 1000 >= loops * permille[i])
+			pct[i++] = map_benchmark_bucket_ns(bucket);
+	}
+}
+
+static int map_benchmark_alloc_bufs(struct map_benchmark_ctx *ctx)
+{
+	unsigned int i;
+
+	ctx->bufs = kcalloc(ctx->nents, sizeof(*ctx->bufs), GFP_KERNEL);
+	if (!ctx->bufs)
+		return -ENOMEM;
+
+	for (i = 0; i < ctx->nents; i++) {
+		ctx->bufs[i] = alloc_pages_exact(ctx->size, GFP_KERNEL);
+		if (!ctx->bufs[i])
+			return -ENOMEM;
+	}
+	return 0;
+}
+
+static void map_benchmark_free_bufs(struct map_benchmark_ctx *ctx)
+{
+	unsigned int i;
+
+	if (!ctx->bufs)
+		return;
+	for (i = 0; i < ctx->nents; i++)
+		if (ctx->bufs[i])
+			free_pages_exact(ctx->bufs[i], ctx->size);
+	kfree(ctx->bufs);
+}
+
+static void map_benchmark_stain(struct map_benchmark_ctx *ctx)
+{
+	unsigned int i;
+
+	/*
+	 * for a non-coherent device, if we don't stain them in the
+	 * cache, this will give an underestimate of the real-world
+	 * overhead of BIDIRECTIONAL or TO_DEVICE mappings;
+	 * 66 means evertything goes well! 66 is lucky.
+	 */
+	for (i = 0; i < ctx->nents; i++)
+		memset(ctx->bufs[i], 0x66, ctx->size);
+}
+
+static int map_benchmark_map_single(struct map_benchmark_ctx *ctx)
+{
+	struct device *dev = ctx->map->dev;
+
+	ctx->dma_addr = dma_map_single(dev, ctx->bufs[0], ctx->size,
+				       ctx->map->dir);
+	if (unlikely(dma_mapping_error(dev, ctx->dma_addr))) {
+		pr_err("dma_map_single failed on %s\n", dev_name(dev));
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+static void map_benchmark_unmap_single(struct map_benchmark_ctx *ctx)
+{
+	dma_unmap_single(ctx->map->dev, ctx->dma_addr, ctx->size,
+			 ctx->map->dir);
+}
+
+static int map_benchmark_setup_sg(struct map_benchmark_ctx *ctx)
+{
+	struct scatterlist *sg;
+	unsigned int i;
+	int ret;
+
+	ret = map_benchmark_alloc_bufs(ctx);
+	if (ret)
+		return ret;
+	ret = sg_alloc_table(&ctx->sgt, ctx->nents, GFP_KERNEL);
+	if (ret)
+		return ret;
+	for_each_sgtable_sg(&ctx->sgt, sg, i)
+		sg_set_buf(sg, ctx->bufs[i], ctx->size);
+	return 0;
+}
+
+static int map_benchmark_map_sg(struct map_benchmark_ctx *ctx)
+{
+	struct device *dev = ctx->map->dev;
+	int ret;
+
+	ret = dma_map_sgtable(dev, &ctx->sgt, ctx->map->dir, 0);
+	if (unlikely(ret))
+		pr_err("dma_map_sgtable failed on %s\n", dev_name(dev));
+	return ret;
+}
+
+static void map_benchmark_unmap_sg(struct map_benchmark_ctx *ctx)
+{
+	dma_unmap_sgtable(ctx->map->dev, &ctx->sgt, ctx->map->dir, 0);
+}
+
+static void map_benchmark_teardown_sg(struct map_benchmark_ctx *ctx)
+{
+	sg_free_table(&ctx->sgt);
+	map_benchmark_free_bufs(ctx);
+}
+
+static int map_benchmark_alloc_coherent(struct map_benchmark_ctx *ctx)
+{
+	struct device *dev = ctx->map->dev;
+
+	ctx->cpu_addr = dma_alloc_coherent(dev, ctx->size, &ctx->dma_addr,
+					   GFP_KERNEL);
+	if (unlikely(!ctx->cpu_addr)) {
+		pr_err("dma_alloc_coherent failed on %s\n", dev_name(dev));
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+static void map_benchmark_free_coherent(struct map_benchmark_ctx *ctx)
+{
+	dma_free_coherent(ctx->map->dev, ctx->size, ctx->cpu_addr,
+			  ctx->dma_addr);
+}
+
+static int map_benchmark_setup_sync(struct map_benchmark_ctx *ctx)
+{
+	int ret;
+
+	ret = map_benchmark_alloc_bufs(ctx);
+	if (ret)
+		return ret;
+	ret = map_benchmark_map_single(ctx);
+	if (ret)
+		return ret;
+	ctx->mapped = true;
+	return 0;
+}
+
+static int map_benchmark_sync_for_device(struct map_benchmark_ctx *ctx)
+{
+	dma_sync_single_for_device(ctx->map->dev, ctx->dma_addr, ctx->size,
+				   ctx->map->dir);
+	return 0;
+}
+
+static void map_benchmark_sync_for_cpu(struct map_benchmark_ctx *ctx)
+{
+	dma_sync_single_for_cpu(ctx->map->dev, ctx->dma_addr, ctx->size,
+				ctx->map->dir);
+}
+
+static void map_benchmark_teardown_sync(struct map_benchmark_ctx *ctx)
+{
+	if (ctx->mapped)
+		map_benchmark_unmap_single(ctx);
+	map_benchmark_free_bufs(ctx);
+}
+
+/*
+ * A minimal exporter of discontiguous pages, so that the dma-buf benchmark
+ * does not depend on any heap or driver being present.
+ */
+struct map_benchmark_dmabuf {
+	unsigned int npages;
+	struct page *pages[];
+};
+
+static struct sg_table *
+map_benchmark_map_dma_buf(struct dma_buf_attachment *attach,
+			  enum dma_data_direction dir)
+{
+	struct map_benchmark_dmabuf *mb = attach->dmabuf->priv;
+	struct sg_table *sgt;
+	int ret;
+
+	sgt = kmalloc(sizeof(*sgt), GFP_KERNEL);
+	if (!sgt)
+		return ERR_PTR(-ENOMEM);
+
+	ret = sg_alloc_table_from_pages(sgt, mb->pages, mb->npages, 0,
+					(size_t)mb->npages << PAGE_SHIFT,
+					GFP_KERNEL);
+	if (ret)
+		goto free_sgt;
+	ret = dma_map_sgtable(attach->dev, sgt, dir, 0);
+	if (ret)
+		goto free_table;
+	return sgt;
+
+free_table:
+	sg_free_table(sgt);
+free_sgt:
+	kfree(sgt);
+	return ERR_PTR(ret);
+}
+
+static void map_benchmark_unmap_dma_buf(struct dma_buf_attachment *attach,
+					struct sg_table *sgt,
+					enum dma_data_direction dir)
+{
+	dma_unmap_sgtable(attach->dev, sgt, dir, 0);
+	sg_free_table(sgt);
+	kfree(sgt);
+}
+
+static void map_benchmark_free_dmabuf(struct map_benchmark_dmabuf *mb)
+{
+	unsigned int i;
+
+	for (i = 0; i < mb->npages; i++)
+		if (mb->pages[i])
+			__free_page(mb->pages[i]);
+	kfree(mb);
+}
+
+static void map_benchmark_release_dma_buf(struct dma_buf *dmabuf)
+{
+	map_benchmark_free_dmabuf(dmabuf->priv);
+}
+
+static const struct dma_buf_ops map_benchmark_dma_buf_ops = {
+	.map_dma_buf	= map_benchmark_map_dma_buf,
+	.unmap_dma_buf	= map_benchmark_unmap_dma_buf,
+	.release	= map_benchmark_release_dma_buf,
+};
+
+static int map_benchmark_setup_dmabuf(struct map_benchmark_ctx *ctx)
+{
+	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	unsigned int npages = ctx->size >> PAGE_SHIFT, i;
+	struct map_benchmark_dmabuf *mb;
+	struct dma_buf *dmabuf;
+
+	mb = kzalloc(struct_size(mb, pages, npages), GFP_KERNEL);
+	if (!mb)
+		return -ENOMEM;
+	mb->npages = npages;
+	for (i = 0; i < npages; i++) {
+		mb->pages[i] = alloc_page(GFP_KERNEL);
+		if (!mb->pages[i]) {
+			map_benchmark_free_dmabuf(mb);
+			return -ENOMEM;
+		}
+	}
+
+	exp_info.ops = &map_benchmark_dma_buf_ops;
+	exp_info.size = ctx->size;
+	exp_info.flags = O_RDWR;
+	exp_info.priv = mb;
+	dmabuf = dma_buf_export(&exp_info);
+	if (IS_ERR(dmabuf)) {
+		map_benchmark_free_dmabuf(mb);
+		return PTR_ERR(dmabuf);
+	}
+	ctx->dmabuf = dmabuf;
+	return 0;
+}
+
+static int map_benchmark_map_dmabuf(struct map_benchmark_ctx *ctx)
+{
+	struct device *dev = ctx->map->dev;
+	struct sg_table *sgt;
+
+	ctx->attach = dma_buf_attach(ctx->dmabuf, dev);
+	if (IS_ERR(ctx->attach)) {
+		pr_err("dma_buf_attach failed on %s\n", dev_name(dev));
+		return PTR_ERR(ctx->attach);
+	}
+
+	sgt = dma_buf_map_attachment_unlocked(ctx->attach, ctx->map->dir);
+	if (IS_ERR(sgt)) {
+		pr_err("dma_buf_map_attachment failed on %s\n", dev_name(dev));
+		dma_buf_detach(ctx->dmabuf, ctx->attach);
+		return PTR_ERR(sgt);
+	}
+	ctx->dmabuf_sgt = sgt;
+	return 0;
+}
+
+static void map_benchmark_unmap_dmabuf(struct map_benchmark_ctx *ctx)
+{
+	dma_buf_unmap_attachment_unlocked(ctx->attach, ctx->dmabuf_sgt,
+					  ctx->map->dir);
+	dma_buf_detach(ctx->dmabuf, ctx->attach);
+}
+
+static void map_benchmark_teardown_dmabuf(struct map_benchmark_ctx *ctx)
+{
+	if (ctx->dmabuf)
+		dma_buf_put(ctx->dmabuf);
+}
+
+static const struct map_benchmark_ops map_benchmark_ops[] = {
+	[DMA_MAP_BENCHMARK_SINGLE] = {
+		.setup		= map_benchmark_alloc_bufs,
+		.map		= map_benchmark_map_single,
+		.unmap		= map_benchmark_unmap_single,
+		.teardown	= map_benchmark_free_bufs,
+		.stain		= true,
+	},
+	[DMA_MAP_BENCHMARK_SG] = {
+		.setup		= map_benchmark_setup_sg,
+		.map		= map_benchmark_map_sg,
+		.unmap		= map_benchmark_unmap_sg,
+		.teardown	= map_benchmark_teardown_sg,
+		.stain		= true,
+	},
+	[DMA_MAP_BENCHMARK_COHERENT] = {
+		.map		= map_benchmark_alloc_coherent,
+		.unmap		= map_benchmark_free_coherent,
+	},
+	[DMA_MAP_BENCHMARK_SYNC] = {
+		.setup		= map_benchmark_setup_sync,
+		.map		= map_benchmark_sync_for_device,
+		.unmap		= map_benchmark_sync_for_cpu,
+		.teardown	= map_benchmark_teardown_sync,
+		.stain		= true,
+	},
+	[DMA_MAP_BENCHMARK_DMABUF] = {
+		.setup		= map_benchmark_setup_dmabuf,
+		.map		= map_benchmark_map_dmabuf,
+		.unmap		= map_benchmark_unmap_dmabuf,
+		.teardown	= map_benchmark_teardown_dmabuf,
+	},
 };
 
 static int map_benchmark_thread(void *data)
 {
-	void *buf;
-	dma_addr_t dma_addr;
 	struct map_benchmark_data *map = data;
-	int npages = map->bparam.granule;
-	u64 size = npages * PAGE_SIZE;
+	const struct map_benchmark_ops *ops =
+		&map_benchmark_ops[map->bparam.mode];
+	struct map_benchmark_ctx ctx = {
+		.map = map,
+		.size = map->bparam.granule * PAGE_SIZE,
+		.nents = map->bparam.mode == DMA_MAP_BENCHMARK_SG ?
+			 map->bparam.nents : 1,
+	};
 	int ret = 0;
 
-	buf = alloc_pages_exact(size, GFP_KERNEL);
-	if (!buf)
-		return -ENOMEM;
+	if (ops->setup) {
+		ret = ops->setup(&ctx);
+		if (ret)
+			goto out;
+	}
 
 	while (!kthread_should_stop())  {
 		u64 map_100ns, unmap_100ns, map_sq, unmap_sq;
 		ktime_t map_stime, map_etime, unmap_stime, unmap_etime;
 		ktime_t map_delta, unmap_delta;
 
-		/*
-		 * for a non-coherent device, if we don't stain them in the
-		 * cache, this will give an underestimate of the real-world
-		 * overhead of BIDIRECTIONAL or TO_DEVICE mappings;
-		 * 66 means evertything goes well! 66 is lucky.
-		 */
-		if (map->dir != DMA_FROM_DEVICE)
-			memset(buf, 0x66, size);
+		if (ops->stain && map->dir != DMA_FROM_DEVICE)
+			map_benchmark_stain(&ctx);
 
 		map_stime = ktime_get();
-		dma_addr = dma_map_single(map->dev, buf, size, map->dir);
-		if (unlikely(dma_mapping_error(map->dev, dma_addr))) {
-			pr_err("dma_map_single failed on %s\n",
-				dev_name(map->dev));
-			ret = -ENOMEM;
+		ret = ops->map(&ctx);
+		if (unlikely(ret))
 			goto out;
-		}
 		map_etime = ktime_get();
 		map_delta = ktime_sub(map_etime, map_stime);
 
@@ -73,7 +468,7 @@ static int map_benchmark_thread(void *data)
 		ndelay(map->bparam.dma_trans_ns);
 
 		unmap_stime = ktime_get();
-		dma_unmap_single(map->dev, dma_addr, size, map->dir);
+		ops->unmap(&ctx);
 		unmap_etime = ktime_get();
 		unmap_delta = ktime_sub(unmap_etime, unmap_stime);
 
@@ -88,6 +483,9 @@ static int map_benchmark_thread(void *data)
 		atomic64_add(unmap_100ns, &map->sum_unmap_100ns);
 		atomic64_add(map_sq, &map->sum_sq_map);
 		atomic64_add(unmap_sq, &map->sum_sq_unmap);
+		atomic64_inc(&map->map_hist[map_benchmark_bucket(map_delta)]);
+		atomic64_inc(&map->unmap_hist[
+				map_benchmark_bucket(unmap_delta)]);
 		atomic64_inc(&map->loops);
 
 		/*
@@ -108,7 +506,8 @@ static int map_benchmark_thread(void *data)
 	}
 
 out:
-	free_pages_exact(buf, size);
+	if (ops->teardown)
+		ops->teardown(&ctx);
 	return ret;
 }
 
@@ -148,6 +547,10 @@ static int do_map_benchmark(struct map_benchmark_data *map)
 	atomic64_set(&map->sum_sq_map, 0);
 	atomic64_set(&map->sum_sq_unmap, 0);
 	atomic64_set(&map->loops, 0);
+	for (i = 0; i < MAP_BENCHMARK_BUCKETS; i++) {
+		atomic64_set(&map->map_hist[i], 0);
+		atomic64_set(&map->unmap_hist[i], 0);
+	}
 
 	for (i = 0; i < threads; i++) {
 		get_task_struct(tsk[i]);
@@ -188,6 +591,11 @@ static int do_map_benchmark(struct map_benchmark_data *map)
 				map->bparam.avg_unmap_100ns;
 		map->bparam.map_stddev = int_sqrt64(map_variance);
 		map->bparam.unmap_stddev = int_sqrt64(unmap_variance);
+
+		map_benchmark_percentiles(map->map_hist, loops,
+					  map->bparam.map_pct_ns);
+		map_benchmark_percentiles(map->unmap_hist, loops,
+					  map->bparam.unmap_pct_ns);
 	}
 
 out:
@@ -196,91 +604,117 @@ static int do_map_benchmark(struct map_benchmark_data *map)
 	return ret;
 }
 
+/* the ioctl of binaries built before the mode and percentiles were added */
+#define DMA_MAP_BENCHMARK_V1_SIZE	\
+	ALIGN(offsetof(struct map_benchmark, mode), sizeof(__u64))
+#define DMA_MAP_BENCHMARK_V1	\
+	_IOC(_IOC_READ | _IOC_WRITE, 'd', 1, DMA_MAP_BENCHMARK_V1_SIZE)
+
 static long map_benchmark_ioctl(struct file *file, unsigned int cmd,
 		unsigned long arg)
 {
 	struct map_benchmark_data *map = file->private_data;
 	void __user *argp = (void __user *)arg;
 	u64 old_dma_mask;
+	size_t size;
 	int ret;
 
-	if (copy_from_user(&map->bparam, argp, sizeof(map->bparam)))
-		return -EFAULT;
-
 	switch (cmd) {
 	case DMA_MAP_BENCHMARK:
-		if (map->bparam.threads == 0 ||
-		    map->bparam.threads > DMA_MAP_MAX_THREADS) {
-			pr_err("invalid thread number\n");
-			return -EINVAL;
-		}
-
-		if (map->bparam.seconds == 0 ||
-		    map->bparam.seconds > DMA_MAP_MAX_SECONDS) {
-			pr_err("invalid duration seconds\n");
-			return -EINVAL;
-		}
+		size = sizeof(map->bparam);
+		break;
+	case DMA_MAP_BENCHMARK_V1:
+		/* the rest, including the tail padding, stays zero */
+		size = offsetof(struct map_benchmark, mode);
+		break;
+	default:
+		return -EINVAL;
+	}
 
-		if (map->bparam.dma_trans_ns > DMA_MAP_MAX_TRANS_DELAY) {
-			pr_err("invalid transmission delay\n");
-			return -EINVAL;
-		}
+	memset(&map->bparam, 0, sizeof(map->bparam));
+	if (copy_from_user(&map->bparam, argp, size))
+		return -EFAULT;
 
-		if (map->bparam.node != NUMA_NO_NODE &&
-		    (map->bparam.node < 0 || map->bparam.node >= MAX_NUMNODES ||
-		     !node_possible(map->bparam.node))) {
-			pr_err("invalid numa node\n");
-			return -EINVAL;
-		}
+	if (map->bparam.threads == 0 ||
+	    map->bparam.threads > DMA_MAP_MAX_THREADS) {
+		pr_err("invalid thread number\n");
+		return -EINVAL;
+	}
 
-		if (map->bparam.granule < 1 || map->bparam.granule > 1024) {
-			pr_err("invalid granule size\n");
-			return -EINVAL;
-		}
+	if (map->bparam.seconds == 0 ||
+	    map->bparam.seconds > DMA_MAP_MAX_SECONDS) {
+		pr_err("invalid duration seconds\n");
+		return -EINVAL;
+	}
 
-		switch (map->bparam.dma_dir) {
-		case DMA_MAP_BIDIRECTIONAL:
-			map->dir = DMA_BIDIRECTIONAL;
-			break;
-		case DMA_MAP_FROM_DEVICE:
-			map->dir = DMA_FROM_DEVICE;
-			break;
-		case DMA_MAP_TO_DEVICE:
-			map->dir = DMA_TO_DEVICE;
-			break;
-		default:
-			pr_err("invalid DMA direction\n");
-			return -EINVAL;
-		}
+	if (map->bparam.dma_trans_ns > DMA_MAP_MAX_TRANS_DELAY) {
+		pr_err("invalid transmission delay\n");
+		return -EINVAL;
+	}
 
-		old_dma_mask = dma_get_mask(map->dev);
+	if (map->bparam.node != NUMA_NO_NODE &&
+	    (map->bparam.node < 0 || map->bparam.node >= MAX_NUMNODES ||
+	     !node_possible(map->bparam.node))) {
+		pr_err("invalid numa node\n");
+		return -EINVAL;
+	}
 
-		ret = dma_set_mask(map->dev,
-				   DMA_BIT_MASK(map->bparam.dma_bits));
-		if (ret) {
-			pr_err("failed to set dma_mask on device %s\n",
-				dev_name(map->dev));
-			return -EINVAL;
-		}
+	if (map->bparam.granule < 1 ||
+	    map->bparam.granule > DMA_MAP_MAX_PAGES) {
+		pr_err("invalid granule size\n");
+		return -EINVAL;
+	}
 
-		ret = do_map_benchmark(map);
+	if (map->bparam.mode >= ARRAY_SIZE(map_benchmark_ops)) {
+		pr_err("invalid benchmark mode\n");
+		return -EINVAL;
+	}
 
-		/*
-		 * restore the original dma_mask as many devices' dma_mask are
-		 * set by architectures, acpi, busses. When we bind them back
-		 * to their original drivers, those drivers shouldn't see
-		 * dma_mask changed by benchmark
-		 */
-		dma_set_mask(map->dev, old_dma_mask);
+	if (map->bparam.mode == DMA_MAP_BENCHMARK_SG &&
+	    (map->bparam.nents < 1 || map->bparam.nents > DMA_MAP_MAX_NENTS ||
+	     map->bparam.nents * map->bparam.granule > DMA_MAP_MAX_PAGES)) {
+		pr_err("invalid number of segments\n");
+		return -EINVAL;
+	}
 
-		if (ret)
-			return ret;
+	switch (map->bparam.dma_dir) {
+	case DMA_MAP_BIDIRECTIONAL:
+		map->dir = DMA_BIDIRECTIONAL;
+		break;
+	case DMA_MAP_FROM_DEVICE:
+		map->dir = DMA_FROM_DEVICE;
+		break;
+	case DMA_MAP_TO_DEVICE:
+		map->dir = DMA_TO_DEVICE;
 		break;
 	default:
+		pr_err("invalid DMA direction\n");
 		return -EINVAL;
 	}
 
-	if (copy_to_user(argp, &map->bparam, sizeof(map->bparam)))
+	old_dma_mask = dma_get_mask(map->dev);
+
+	ret = dma_set_mask(map->dev, DMA_BIT_MASK(map->bparam.dma_bits));
+	if (ret) {
+		pr_err("failed to set dma_mask on device %s\n",
+			dev_name(map->dev));
+		return -EINVAL;
+	}
+
+	ret = do_map_benchmark(map);
+
+	/*
+	 * restore the original dma_mask as many devices' dma_mask are
+	 * set by architectures, acpi, busses. When we bind them back
+	 * to their original drivers, those drivers shouldn't see
+	 * dma_mask changed by benchmark
+	 */
+	dma_set_mask(map->dev, old_dma_mask);
+
+	if (ret)
+		return ret;
+
+	if (copy_to_user(argp, &map->bparam, size))
 		return -EFAULT;
 
 	return ret;
@@ -379,3 +813,4 @@ module_exit(map_benchmark_cleanup);
 
 MODULE_AUTHOR("Barry Song <song.bao.hua@hisilicon.com>");
 MODULE_DESCRIPTION("dma_map benchmark driver");
+MODULE_IMPORT_NS(DMA_BUF);
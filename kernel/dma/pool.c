@@ -9,6 +9,8 @@
 #include <linux/dma-direct.h>
 #include <linux/init.h>
 #include <linux/genalloc.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
 #include <linux/set_memory.h>
 #include <linux/slab.h>
 #include <linux/workqueue.h>
@@ -26,6 +28,48 @@ static size_t atomic_pool_size;
 /* Dynamic background expansion when the atomic pool is near capacity */
 static struct work_struct atomic_pool_work;
 
+/*
+ * Most atomic allocations are for single pages (descriptors rounded up by
+ * dma-direct).  Each CPU keeps a few of those per pool so that they can be
+ * recycled without searching the gen_pool bitmaps.
+ */
+#define ATOMIC_POOL_PCP_CHUNKS	8
+
+struct atomic_pool_pcp {
+	spinlock_t lock;
+	unsigned int nr;
+	unsigned long addr[ATOMIC_POOL_PCP_CHUNKS];
+};
+
+/*
+ * Allocation rate over ATOMIC_POOL_RATE_WINDOW, used to grow a pool before
+ * a burst drains it rather than after.
+ */
+#define ATOMIC_POOL_RATE_WINDOW	(HZ / 10)
+
+struct atomic_pool_state {
+	struct atomic_pool_pcp __percpu *pcp;
+	unsigned long window_start;
+	atomic_long_t window_bytes;
+	unsigned long rate;
+};
+
+enum {
+	ATOMIC_POOL_KERNEL,
+	ATOMIC_POOL_DMA,
+	ATOMIC_POOL_DMA32,
+	NR_ATOMIC_POOLS,
+};
+
+static struct atomic_pool_state atomic_pool_state[NR_ATOMIC_POOLS];
+
+static atomic_long_t pool_allocs;
+static atomic_long_t pool_alloc_failures;
+static atomic_long_t pool_pcp_hits;
+static atomic_long_t pool_expansions;
+static atomic64_t pool_alloc_ns;
+static u64 pool_alloc_max_ns;
+
 static int __init early_coherent_pool(char *p)
 {
 	atomic_pool_size = memparse(p, &p);
@@ -33,6 +77,28 @@ static int __init early_coherent_pool(char *p)
 }
 early_param("coherent_pool", early_coherent_pool);
 
+static int dma_atomic_pool_stats_show(struct seq_file *s, void *unused)
+{
+	long allocs = atomic_long_read(&pool_allocs);
+
+	seq_printf(s, "allocs %ld\n", allocs);
+	seq_printf(s, "alloc_failures %ld\n",
+		   atomic_long_read(&pool_alloc_failures));
+	seq_printf(s, "pcp_hits %ld\n", atomic_long_read(&pool_pcp_hits));
+	seq_printf(s, "expansions %ld\n", atomic_long_read(&pool_expansions));
+	seq_printf(s, "alloc_avg_ns %llu\n", allocs ?
+		   div64_u64(atomic64_read(&pool_alloc_ns), allocs) : 0);
+	seq_printf(s, "alloc_max_ns %llu\n", READ_ONCE(pool_alloc_max_ns));
+	seq_printf(s, "rate_kernel %lu\n",
+		   READ_ONCE(atomic_pool_state[ATOMIC_POOL_KERNEL].rate));
+	seq_printf(s, "rate_dma %lu\n",
+		   READ_ONCE(atomic_pool_state[ATOMIC_POOL_DMA].rate));
+	seq_printf(s, "rate_dma32 %lu\n",
+		   READ_ONCE(atomic_pool_state[ATOMIC_POOL_DMA32].rate));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(dma_atomic_pool_stats);
+
 static void __init dma_atomic_pool_debugfs_init(void)
 {
 	struct dentry *root;
@@ -41,6 +107,117 @@ static void __init dma_atomic_pool_debugfs_init(void)
 	debugfs_create_ulong("pool_size_dma", 0400, root, &pool_size_dma);
 	debugfs_create_ulong("pool_size_dma32", 0400, root, &pool_size_dma32);
 	debugfs_create_ulong("pool_size_kernel", 0400, root, &pool_size_kernel);
+	debugfs_create_file("stats", 0400, root, NULL,
+			    &dma_atomic_pool_stats_fops);
+}
+
+static struct atomic_pool_state *atomic_pool_state_of(struct gen_pool *pool)
+{
+	if (pool == atomic_pool_dma)
+		return &atomic_pool_state[ATOMIC_POOL_DMA];
+	if (pool == atomic_pool_dma32)
+		return &atomic_pool_state[ATOMIC_POOL_DMA32];
+	return &atomic_pool_state[ATOMIC_POOL_KERNEL];
+}
+
+/*
+ * Free space to keep in a pool: the static low watermark, or two windows
+ * worth of the recent allocation rate, which leaves the worker ample time
+ * to expand the pool during a burst.
+ */
+static size_t atomic_pool_target(struct gen_pool *pool)
+{
+	struct atomic_pool_state *st = atomic_pool_state_of(pool);
+
+	return max_t(size_t, atomic_pool_size, 2 * READ_ONCE(st->rate));
+}
+
+static void atomic_pool_account(struct gen_pool *pool, size_t size)
+{
+	struct atomic_pool_state *st = atomic_pool_state_of(pool);
+	unsigned long start = READ_ONCE(st->window_start);
+	unsigned long bytes;
+
+	atomic_long_add(size, &st->window_bytes);
+	if (time_before(jiffies, start + ATOMIC_POOL_RATE_WINDOW) ||
+	    cmpxchg(&st->window_start, start, jiffies) != start)
+		return;
+
+	/* an exponentially weighted average, but follow bursts at once */
+	bytes = atomic_long_xchg(&st->window_bytes, 0);
+	WRITE_ONCE(st->rate, max(bytes, (3 * st->rate + bytes) / 4));
+}
+
+static unsigned long atomic_pool_pcp_get(struct atomic_pool_state *st)
+{
+	struct atomic_pool_pcp *pcp;
+	unsigned long flags, addr = 0;
+
+	if (!st->pcp)
+		return 0;
+
+	pcp = raw_cpu_ptr(st->pcp);
+	spin_lock_irqsave(&pcp->lock, flags);
+	if (pcp->nr)
+		addr = pcp->addr[--pcp->nr];
+	spin_unlock_irqrestore(&pcp->lock, flags);
+	return addr;
+}
+
+static bool atomic_pool_pcp_put(struct atomic_pool_state *st,
+				unsigned long addr)
+{
+	struct atomic_pool_pcp *pcp;
+	unsigned long flags;
+	bool cached = false;
+
+	if (!st->pcp)
+		return false;
+
+	pcp = raw_cpu_ptr(st->pcp);
+	spin_lock_irqsave(&pcp->lock, flags);
+	if (pcp->nr < ATOMIC_POOL_PCP_CHUNKS) {
+		pcp->addr[pcp->nr++] = addr;
+		cached = true;
+	}
+	spin_unlock_irqrestore(&pcp->lock, flags);
+	return cached;
+}
+
+/* Give the chunks cached by all CPUs back to the pool, returns true if any */
+static bool atomic_pool_pcp_drain(struct gen_pool *pool,
+				  struct atomic_pool_state *st)
+{
+	struct atomic_pool_pcp *pcp;
+	unsigned long flags;
+	bool drained = false;
+	int cpu;
+
+	if (!st->pcp)
+		return false;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(st->pcp, cpu);
+		spin_lock_irqsave(&pcp->lock, flags);
+		while (pcp->nr) {
+			gen_pool_free(pool, pcp->addr[--pcp->nr], PAGE_SIZE);
+			drained = true;
+		}
+		spin_unlock_irqrestore(&pcp->lock, flags);
+	}
+	return drained;
+}
+
+static void __init atomic_pool_state_init(struct atomic_pool_state *st)
+{
+	int cpu;
+
+	st->window_start = jiffies;
+	st->pcp = alloc_percpu(struct atomic_pool_pcp);
+	if (!st->pcp)
+		return;
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(st->pcp, cpu)->lock);
 }
 
 static void dma_atomic_pool_size_add(gfp_t gfp, size_t size)
@@ -123,6 +300,7 @@ static int atomic_pool_expand(struct gen_pool *pool, size_t pool_size,
 		goto encrypt_mapping;
 
 	dma_atomic_pool_size_add(gfp, pool_size);
+	atomic_long_inc(&pool_expansions);
 	return 0;
 
 encrypt_mapping:
@@ -144,8 +322,23 @@ static int atomic_pool_expand(struct gen_pool *pool, size_t pool_size,
 
 static void atomic_pool_resize(struct gen_pool *pool, gfp_t gfp)
 {
-	if (pool && gen_pool_avail(pool) < atomic_pool_size)
+	size_t target, avail;
+	int i;
+
+	if (!pool)
+		return;
+
+	if (gen_pool_avail(pool) < atomic_pool_size)
 		atomic_pool_expand(pool, gen_pool_size(pool), gfp);
+
+	/* then grow by the expected demand, a few chunks at most per run */
+	target = atomic_pool_target(pool);
+	for (i = 0; i < 4; i++) {
+		avail = gen_pool_avail(pool);
+		if (avail >= target ||
+		    atomic_pool_expand(pool, target - avail, gfp))
+			break;
+	}
 }
 
 static void atomic_pool_work_fn(struct work_struct *work)
@@ -203,17 +396,20 @@ static int __init dma_atomic_pool_init(void)
 						    GFP_KERNEL);
 	if (!atomic_pool_kernel)
 		ret = -ENOMEM;
+	atomic_pool_state_init(&atomic_pool_state[ATOMIC_POOL_KERNEL]);
 	if (has_managed_dma()) {
 		atomic_pool_dma = __dma_atomic_pool_init(atomic_pool_size,
 						GFP_KERNEL | GFP_DMA);
 		if (!atomic_pool_dma)
 			ret = -ENOMEM;
+		atomic_pool_state_init(&atomic_pool_state[ATOMIC_POOL_DMA]);
 	}
 	if (IS_ENABLED(CONFIG_ZONE_DMA32)) {
 		atomic_pool_dma32 = __dma_atomic_pool_init(atomic_pool_size,
 						GFP_KERNEL | GFP_DMA32);
 		if (!atomic_pool_dma32)
 			ret = -ENOMEM;
+		atomic_pool_state_init(&atomic_pool_state[ATOMIC_POOL_DMA32]);
 	}
 
 	dma_atomic_pool_debugfs_init();
@@ -241,10 +437,18 @@ static struct page *__dma_alloc_from_pool(struct device *dev, size_t size,
 		struct gen_pool *pool, void **cpu_addr,
 		bool (*phys_addr_ok)(struct device *, phys_addr_t, size_t))
 {
-	unsigned long addr;
+	struct atomic_pool_state *st = atomic_pool_state_of(pool);
+	unsigned long addr = 0;
 	phys_addr_t phys;
 
-	addr = gen_pool_alloc(pool, size);
+	if (size == PAGE_SIZE)
+		addr = atomic_pool_pcp_get(st);
+	if (addr)
+		atomic_long_inc(&pool_pcp_hits);
+	else
+		addr = gen_pool_alloc(pool, size);
+	if (!addr && atomic_pool_pcp_drain(pool, st))
+		addr = gen_pool_alloc(pool, size);
 	if (!addr)
 		return NULL;
 
@@ -254,7 +458,8 @@ static struct page *__dma_alloc_from_pool(struct device *dev, size_t size,
 		return NULL;
 	}
 
-	if (gen_pool_avail(pool) < atomic_pool_size)
+	atomic_pool_account(pool, size);
+	if (gen_pool_avail(pool) < atomic_pool_target(pool))
 		schedule_work(&atomic_pool_work);
 
 	*cpu_addr = (void *)addr;
@@ -267,17 +472,27 @@ struct page *dma_alloc_from_pool(struct device *dev, size_t size,
 		bool (*phys_addr_ok)(struct device *, phys_addr_t, size_t))
 {
 	struct gen_pool *pool = NULL;
-	struct page *page;
+	struct page *page = NULL;
+	u64 start = ktime_get_ns(), ns;
 
 	while ((pool = dma_guess_pool(pool, gfp))) {
 		page = __dma_alloc_from_pool(dev, size, pool, cpu_addr,
 					     phys_addr_ok);
 		if (page)
-			return page;
+			break;
 	}
 
-	WARN(1, "Failed to get suitable pool for %s\n", dev_name(dev));
-	return NULL;
+	ns = ktime_get_ns() - start;
+	atomic_long_inc(&pool_allocs);
+	atomic64_add(ns, &pool_alloc_ns);
+	if (ns > READ_ONCE(pool_alloc_max_ns))
+		WRITE_ONCE(pool_alloc_max_ns, ns);
+
+	if (!page) {
+		atomic_long_inc(&pool_alloc_failures);
+		WARN(1, "Failed to get suitable pool for %s\n", dev_name(dev));
+	}
+	return page;
 }
 
 bool dma_free_from_pool(struct device *dev, void *start, size_t size)
@@ -287,7 +502,10 @@ bool dma_free_from_pool(struct device *dev, void *start, size_t size)
 	while ((pool = dma_guess_pool(pool, 0))) {
 		if (!gen_pool_has_addr(pool, (unsigned long)start, size))
 			continue;
-		gen_pool_free(pool, (unsigned long)start, size);
+		if (size != PAGE_SIZE ||
+		    !atomic_pool_pcp_put(atomic_pool_state_of(pool),
+					 (unsigned long)start))
+			gen_pool_free(pool, (unsigned long)start, size);
 		return true;
 	}
 
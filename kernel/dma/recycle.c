@@ -0,0 +1,321 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Recycling of freed coherent buffers of non-coherent devices.
+ *
+ * A coherent allocation for a non-coherent device allocates pages, cleans
+ * them from the caches and remaps them uncached, and freeing undoes all of
+ * it.  Drivers that allocate and free descriptors all the time pay for this
+ * on every call, so keep freed buffers, mapping included, in per-device
+ * power-of-two size classes and hand them out again, zeroed, to the next
+ * allocation of the same class.
+ */
+#include <linux/debugfs.h>
+#include <linux/dma-map-ops.h>
+#include <linux/init.h>
+#include <linux/rculist.h>
+#include <linux/seq_file.h>
+#include <linux/shrinker.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include "direct.h"
+
+/* buffers of PAGE_SIZE << 0 up to PAGE_SIZE << (DMA_RECYCLE_CLASSES - 1) */
+#define DMA_RECYCLE_CLASSES	8
+
+/* stored at the start of each cached buffer */
+struct dma_recycle_buf {
+	struct list_head list;
+	struct page *page;
+	dma_addr_t dma_addr;
+};
+
+struct dma_recycle_cache {
+	struct device *dev;
+	struct list_head node;
+	spinlock_t lock;
+	struct list_head free[DMA_RECYCLE_CLASSES];
+	size_t cached;
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long overflows;
+	unsigned long evictions;
+};
+
+/* Maximum size cached per device, set by the dma_recycle command line */
+static size_t dma_recycle_max;
+
+/*
+ * Caches are added under dma_recycle_list_lock, possibly from atomic
+ * context, and only walked and removed with dma_recycle_mutex held, which
+ * also keeps a cache alive while the shrinker frees its buffers.
+ */
+static LIST_HEAD(dma_recycle_caches);
+static DEFINE_SPINLOCK(dma_recycle_list_lock);
+static DEFINE_MUTEX(dma_recycle_mutex);
+static atomic_long_t dma_recycle_pages;
+
+static int __init early_dma_recycle(char *p)
+{
+	dma_recycle_max = memparse(p, &p);
+	return 0;
+}
+early_param("dma_recycle", early_dma_recycle);
+
+static int dma_recycle_class(size_t size)
+{
+	int order = get_order(size);
+
+	return order < DMA_RECYCLE_CLASSES ? order : -1;
+}
+
+/*
+ * This only depends on the device and the attributes, so an allocation and
+ * the matching free always agree on whether the buffer is recycled.
+ */
+static bool dma_recycle_ok(struct device *dev, size_t size,
+		unsigned long attrs)
+{
+	return dma_recycle_max && !dev_is_dma_coherent(dev) &&
+		!force_dma_unencrypted(dev) && !is_swiotlb_for_alloc(dev) &&
+		!(attrs & ~DMA_ATTR_NO_WARN) && dma_recycle_class(size) >= 0;
+}
+
+size_t dma_recycle_size(struct device *dev, size_t size, unsigned long attrs)
+{
+	if (!dma_recycle_ok(dev, size, attrs))
+		return size;
+	return PAGE_SIZE << get_order(size);
+}
+
+void *dma_recycle_alloc(struct device *dev, size_t size,
+		dma_addr_t *dma_handle, unsigned long attrs)
+{
+	struct dma_recycle_cache *cache = READ_ONCE(dev->dma_recycle);
+	struct dma_recycle_buf *buf;
+	unsigned long flags;
+	int class;
+
+	if (!cache || !dma_recycle_ok(dev, size, attrs))
+		return NULL;
+
+	class = dma_recycle_class(size);
+	spin_lock_irqsave(&cache->lock, flags);
+	buf = list_first_entry_or_null(&cache->free[class],
+				       struct dma_recycle_buf, list);
+	if (buf) {
+		list_del(&buf->list);
+		cache->cached -= PAGE_SIZE << class;
+		cache->hits++;
+	} else {
+		cache->misses++;
+	}
+	spin_unlock_irqrestore(&cache->lock, flags);
+	if (!buf)
+		return NULL;
+
+	atomic_long_sub(1 << class, &dma_recycle_pages);
+	*dma_handle = buf->dma_addr;
+	memset(buf, 0, PAGE_SIZE << class);
+	return buf;
+}
+
+static struct dma_recycle_cache *dma_recycle_get_cache(struct device *dev)
+{
+	struct dma_recycle_cache *cache = READ_ONCE(dev->dma_recycle), *old;
+	unsigned long flags;
+	int i;
+
+	if (cache)
+		return cache;
+
+	cache = kzalloc(sizeof(*cache), GFP_NOWAIT | __GFP_NOWARN);
+	if (!cache)
+		return NULL;
+	cache->dev = dev;
+	spin_lock_init(&cache->lock);
+	for (i = 0; i < DMA_RECYCLE_CLASSES; i++)
+		INIT_LIST_HEAD(&cache->free[i]);
+
+	old = cmpxchg(&dev->dma_recycle, NULL, cache);
+	if (old) {
+		kfree(cache);
+		return old;
+	}
+
+	spin_lock_irqsave(&dma_recycle_list_lock, flags);
+	list_add_tail_rcu(&cache->node, &dma_recycle_caches);
+	spin_unlock_irqrestore(&dma_recycle_list_lock, flags);
+	return cache;
+}
+
+bool dma_recycle_free(struct device *dev, void *cpu_addr, dma_addr_t dma_addr,
+		size_t size, unsigned long attrs)
+{
+	struct dma_recycle_buf *buf = cpu_addr;
+	struct dma_recycle_cache *cache;
+	unsigned long flags;
+	bool cached = false;
+	int class;
+
+	if (!dma_recycle_ok(dev, size, attrs))
+		return false;
+	cache = dma_recycle_get_cache(dev);
+	if (!cache)
+		return false;
+
+	class = dma_recycle_class(size);
+	buf->page = dma_direct_to_page(dev, dma_addr);
+	buf->dma_addr = dma_addr;
+
+	spin_lock_irqsave(&cache->lock, flags);
+	if (cache->cached + (PAGE_SIZE << class) <= dma_recycle_max) {
+		/* reuse the most recently freed buffer first */
+		list_add(&buf->list, &cache->free[class]);
+		cache->cached += PAGE_SIZE << class;
+		cached = true;
+	} else {
+		cache->overflows++;
+	}
+	spin_unlock_irqrestore(&cache->lock, flags);
+
+	if (cached)
+		atomic_long_add(1 << class, &dma_recycle_pages);
+	return cached;
+}
+
+/* Free up to @nr_pages pages worth of the least recently cached buffers */
+static unsigned long dma_recycle_evict(struct dma_recycle_cache *cache,
+		unsigned long nr_pages)
+{
+	struct dma_recycle_buf *buf;
+	unsigned long flags, freed = 0;
+	struct page *page;
+	int class;
+
+	lockdep_assert_held(&dma_recycle_mutex);
+
+	for (class = DMA_RECYCLE_CLASSES - 1; class >= 0; class--) {
+		while (freed < nr_pages) {
+			buf = NULL;
+			spin_lock_irqsave(&cache->lock, flags);
+			if (!list_empty(&cache->free[class])) {
+				buf = list_last_entry(&cache->free[class],
+						      struct dma_recycle_buf,
+						      list);
+				list_del(&buf->list);
+				cache->cached -= PAGE_SIZE << class;
+				cache->evictions++;
+			}
+			spin_unlock_irqrestore(&cache->lock, flags);
+			if (!buf)
+				break;
+
+			atomic_long_sub(1 << class, &dma_recycle_pages);
+			page = buf->page;
+			vunmap(buf);
+			dma_free_contiguous(cache->dev, page,
+					    PAGE_SIZE << class);
+			freed += 1 << class;
+		}
+	}
+	return freed;
+}
+
+/*
+ * Called when the device loses its driver or goes away: no buffer can be
+ * allocated or freed for it concurrently.
+ */
+void dma_recycle_drain(struct device *dev)
+{
+	struct dma_recycle_cache *cache;
+	unsigned long flags;
+
+	if (!READ_ONCE(dev->dma_recycle))
+		return;
+
+	mutex_lock(&dma_recycle_mutex);
+	cache = xchg(&dev->dma_recycle, NULL);
+	if (cache) {
+		spin_lock_irqsave(&dma_recycle_list_lock, flags);
+		list_del_rcu(&cache->node);
+		spin_unlock_irqrestore(&dma_recycle_list_lock, flags);
+		dma_recycle_evict(cache, ULONG_MAX);
+	}
+	mutex_unlock(&dma_recycle_mutex);
+	kfree(cache);
+}
+
+static unsigned long dma_recycle_shrink_count(struct shrinker *shrink,
+		struct shrink_control *sc)
+{
+	return atomic_long_read(&dma_recycle_pages) ?: SHRINK_EMPTY;
+}
+
+static unsigned long dma_recycle_shrink_scan(struct shrinker *shrink,
+		struct shrink_control *sc)
+{
+	struct dma_recycle_cache *cache;
+	unsigned long freed = 0;
+
+	if (!mutex_trylock(&dma_recycle_mutex))
+		return SHRINK_STOP;
+	list_for_each_entry_rcu(cache, &dma_recycle_caches, node,
+				lockdep_is_held(&dma_recycle_mutex)) {
+		freed += dma_recycle_evict(cache, sc->nr_to_scan - freed);
+		if (freed >= sc->nr_to_scan)
+			break;
+	}
+	mutex_unlock(&dma_recycle_mutex);
+
+	return freed;
+}
+
+static int dma_recycle_stats_show(struct seq_file *s, void *unused)
+{
+	struct dma_recycle_cache *cache;
+	unsigned long flags;
+
+	seq_printf(s, "max %zu cached_pages %ld\n", dma_recycle_max,
+		   atomic_long_read(&dma_recycle_pages));
+
+	mutex_lock(&dma_recycle_mutex);
+	list_for_each_entry_rcu(cache, &dma_recycle_caches, node,
+				lockdep_is_held(&dma_recycle_mutex)) {
+		spin_lock_irqsave(&cache->lock, flags);
+		seq_printf(s, "%s: cached %zu hits %lu misses %lu overflows %lu evictions %lu\n",
+			   dev_name(cache->dev), cache->cached, cache->hits,
+			   cache->misses, cache->overflows, cache->evictions);
+		spin_unlock_irqrestore(&cache->lock, flags);
+	}
+	mutex_unlock(&dma_recycle_mutex);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(dma_recycle_stats);
+
+static int __init dma_recycle_init(void)
+{
+	struct shrinker *shrinker;
+
+	if (!dma_recycle_max)
+		return 0;
+
+	/*
+	 * Allocations may already have been rounded up to their class, so
+	 * keep recycling even without a shrinker: the cache is bounded.
+	 */
+	shrinker = shrinker_alloc(0, "dma-recycle");
+	if (shrinker) {
+		shrinker->count_objects = dma_recycle_shrink_count;
+		shrinker->scan_objects = dma_recycle_shrink_scan;
+		shrinker_register(shrinker);
+	} else {
+		pr_warn("DMA: no shrinker for recycled coherent buffers\n");
+	}
+
+	debugfs_create_file("dma_recycle", 0400, NULL, NULL,
+			    &dma_recycle_stats_fops);
+	pr_info("DMA: recycling up to %zu KiB of coherent buffers per device\n",
+		dma_recycle_max >> 10);
+	return 0;
+}
+postcore_initcall(dma_recycle_init);
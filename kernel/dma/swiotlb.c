@@ -37,6 +37,7 @@
 #include <linux/pfn.h>
 #include <linux/rculist.h>
 #include <linux/scatterlist.h>
+#include <linux/seq_file.h>
 #include <linux/set_memory.h>
 #include <linux/spinlock.h>
 #include <linux/string.h>
@@ -561,6 +562,7 @@ void __init swiotlb_exit(void)
 
 /**
  * alloc_dma_pages() - allocate pages to be used for DMA
+ * @nid:	Preferred NUMA node, or %NUMA_NO_NODE.
  * @gfp:	GFP flags for the allocation.
  * @bytes:	Size of the buffer.
  * @phys_limit:	Maximum allowed physical address of the buffer.
@@ -571,14 +573,15 @@ void __init swiotlb_exit(void)
  * Return: Decrypted pages, %NULL on allocation failure, or ERR_PTR(-EAGAIN)
  * if the allocated physical address was above @phys_limit.
  */
-static struct page *alloc_dma_pages(gfp_t gfp, size_t bytes, u64 phys_limit)
+static struct page *alloc_dma_pages(int nid, gfp_t gfp, size_t bytes,
+		u64 phys_limit)
 {
 	unsigned int order = get_order(bytes);
 	struct page *page;
 	phys_addr_t paddr;
 	void *vaddr;
 
-	page = alloc_pages(gfp, order);
+	page = alloc_pages_node(nid, gfp, order);
 	if (!page)
 		return NULL;
 
@@ -612,6 +615,7 @@ static struct page *alloc_dma_pages(gfp_t gfp, size_t bytes, u64 phys_limit)
 static struct page *swiotlb_alloc_tlb(struct device *dev, size_t bytes,
 		u64 phys_limit, gfp_t gfp)
 {
+	int nid = dev ? dev_to_node(dev) : NUMA_NO_NODE;
 	struct page *page;
 
 	/*
@@ -634,7 +638,7 @@ static struct page *swiotlb_alloc_tlb(struct device *dev, size_t bytes,
 	else if (phys_limit <= DMA_BIT_MASK(32))
 		gfp |= __GFP_DMA32;
 
-	while (IS_ERR(page = alloc_dma_pages(gfp, bytes, phys_limit))) {
+	while (IS_ERR(page = alloc_dma_pages(nid, gfp, bytes, phys_limit))) {
 		if (IS_ENABLED(CONFIG_ZONE_DMA32) &&
 		    phys_limit < DMA_BIT_MASK(64) &&
 		    !(gfp & (__GFP_DMA32 | __GFP_DMA)))
@@ -811,6 +815,164 @@ static void swiotlb_del_pool(struct device *dev, struct io_tlb_pool *pool)
 	call_rcu(&pool->rcu, swiotlb_dyn_free);
 }
 
+/*
+ * Devices that keep many slots of the shared pools in use get pools of their
+ * own, with their own areas and locks, allocated on the device's node and
+ * below its DMA limit.  Each one is sized at twice the number of slots the
+ * device has been seen to use at once.
+ */
+#define IO_TLB_DEV_POOL_THRESHOLD	(4 * IO_TLB_SEGSIZE)
+#define IO_TLB_DEV_MAX_POOLS		4
+
+/**
+ * struct io_tlb_dev - per-device bounce buffer state
+ * @dev:	Device.
+ * @node:	Entry in io_tlb_devs.
+ * @bounced:	Number of bytes copied to or from bounce buffers.
+ * @used:	Number of slots currently used by the device.
+ * @hiwater:	Highest value of @used since the last pool was added.
+ * @nslabs:	Number of slabs in the pools dedicated to the device.
+ * @npools:	Number of pools dedicated to the device.
+ * @grow:	Work item adding a dedicated pool.
+ */
+struct io_tlb_dev {
+	struct device *dev;
+	struct list_head node;
+	atomic_long_t bounced;
+	atomic_long_t used;
+	atomic_long_t hiwater;
+	unsigned long nslabs;
+	unsigned int npools;
+	struct work_struct grow;
+};
+
+static LIST_HEAD(io_tlb_devs);
+static DEFINE_SPINLOCK(io_tlb_devs_lock);
+
+static void swiotlb_dev_grow(struct work_struct *work)
+{
+	struct io_tlb_dev *td = container_of(work, struct io_tlb_dev, grow);
+	struct device *dev = td->dev;
+	struct io_tlb_pool *pool;
+	unsigned long nslabs, flags;
+	u64 phys_limit;
+
+	nslabs = roundup_pow_of_two(2 * atomic_long_read(&td->hiwater));
+	nslabs = clamp_t(unsigned long, nslabs, IO_TLB_MIN_SLABS,
+			 max_t(unsigned long, default_nslabs / 4,
+			       IO_TLB_MIN_SLABS));
+	phys_limit = min_not_zero(*dev->dma_mask, dev->bus_dma_limit);
+	pool = swiotlb_alloc_pool(dev, IO_TLB_MIN_SLABS, nslabs,
+				  default_nareas, phys_limit, GFP_KERNEL);
+	if (!pool) {
+		dev_warn_ratelimited(dev, "failed to allocate a bounce pool\n");
+		return;
+	}
+
+	spin_lock_irqsave(&dev->dma_io_tlb_lock, flags);
+	list_add_rcu(&pool->node, &dev->dma_io_tlb_pools);
+	spin_unlock_irqrestore(&dev->dma_io_tlb_lock, flags);
+	td->nslabs += pool->nslabs;
+	td->npools++;
+	atomic_long_set(&td->hiwater, 0);
+	dev_dbg(dev, "added a bounce pool of %lu slabs\n", pool->nslabs);
+}
+
+static struct io_tlb_dev *swiotlb_dev_get(struct device *dev)
+{
+	struct io_tlb_dev *td = READ_ONCE(dev->dma_io_tlb_dev);
+	unsigned long flags;
+
+	if (td)
+		return td;
+
+	td = kzalloc(sizeof(*td), GFP_ATOMIC | __GFP_NOWARN);
+	if (!td)
+		return NULL;
+	td->dev = dev;
+	INIT_WORK(&td->grow, swiotlb_dev_grow);
+	if (cmpxchg(&dev->dma_io_tlb_dev, NULL, td)) {
+		kfree(td);
+		return READ_ONCE(dev->dma_io_tlb_dev);
+	}
+
+	spin_lock_irqsave(&io_tlb_devs_lock, flags);
+	list_add_tail(&td->node, &io_tlb_devs);
+	spin_unlock_irqrestore(&io_tlb_devs_lock, flags);
+	return td;
+}
+
+static void swiotlb_dev_account(struct device *dev, long nslots)
+{
+	struct io_tlb_dev *td = swiotlb_dev_get(dev);
+	long used, hiwater;
+
+	if (!td)
+		return;
+
+	used = atomic_long_add_return(nslots, &td->used);
+	hiwater = atomic_long_read(&td->hiwater);
+	while (used > hiwater &&
+	       !atomic_long_try_cmpxchg(&td->hiwater, &hiwater, used))
+		;
+
+	/* only the default allocator can grow, restricted pools are fixed */
+	if (nslots > 0 && used >= IO_TLB_DEV_POOL_THRESHOLD &&
+	    used > td->nslabs / 2 && td->npools < IO_TLB_DEV_MAX_POOLS &&
+	    dev->dma_io_tlb_mem == &io_tlb_default_mem &&
+	    io_tlb_default_mem.can_grow)
+		schedule_work(&td->grow);
+}
+
+static void swiotlb_dev_bounced(struct device *dev, size_t size)
+{
+	struct io_tlb_dev *td = READ_ONCE(dev->dma_io_tlb_dev);
+
+	if (td)
+		atomic_long_add(size, &td->bounced);
+}
+
+/**
+ * swiotlb_dev_release() - free bounce buffer state of a device
+ * @dev:	Device which is being released.
+ *
+ * Free the pools dedicated to @dev.  There must be no mappings left.
+ */
+void swiotlb_dev_release(struct device *dev)
+{
+	struct io_tlb_dev *td = xchg(&dev->dma_io_tlb_dev, NULL);
+	struct io_tlb_pool *pool, *tmp;
+	unsigned long flags;
+
+	if (!td)
+		return;
+
+	cancel_work_sync(&td->grow);
+	spin_lock_irqsave(&io_tlb_devs_lock, flags);
+	list_del(&td->node);
+	spin_unlock_irqrestore(&io_tlb_devs_lock, flags);
+
+	list_for_each_entry_safe(pool, tmp, &dev->dma_io_tlb_pools, node) {
+		WARN_ON_ONCE(pool->transient);
+		swiotlb_del_pool(dev, pool);
+	}
+	kfree(td);
+}
+
+#else  /* !CONFIG_SWIOTLB_DYNAMIC */
+
+static inline void swiotlb_dev_account(struct device *dev, long nslots)
+{
+}
+
+static inline void swiotlb_dev_bounced(struct device *dev, size_t size)
+{
+}
+
+void swiotlb_dev_release(struct device *dev)
+{
+}
+
 #endif	/* CONFIG_SWIOTLB_DYNAMIC */
 
 /**
@@ -824,6 +986,7 @@ void swiotlb_dev_init(struct device *dev)
 	INIT_LIST_HEAD(&dev->dma_io_tlb_pools);
 	spin_lock_init(&dev->dma_io_tlb_lock);
 	dev->dma_uses_io_tlb = false;
+	dev->dma_io_tlb_dev = NULL;
 #endif
 }
 
@@ -869,6 +1032,8 @@ static void swiotlb_bounce(struct device *dev, phys_addr_t tlb_addr, size_t size
 	if (orig_addr == INVALID_PHYS_ADDR)
 		return;
 
+	swiotlb_dev_bounced(dev, size);
+
 	/*
 	 * It's valid for tlb_offset to be negative. This can happen when the
 	 * "offset" returned by swiotlb_align_offset() is non-zero, and the
@@ -1117,6 +1282,7 @@ static int swiotlb_search_pool_area(struct device *dev, struct io_tlb_pool *pool
 	spin_unlock_irqrestore(&area->lock, flags);
 
 	inc_used_and_hiwater(dev->dma_io_tlb_mem, nslots);
+	swiotlb_dev_account(dev, nslots);
 	return slot_index;
 }
 
@@ -1164,6 +1330,49 @@ static int swiotlb_search_area(struct device *dev, int start_cpu,
 	return index;
 }
 
+/**
+ * swiotlb_search_dev_pools() - search the pools dedicated to a device
+ * @dev:	Device which maps the buffer.
+ * @start_cpu:	Start CPU number.
+ * @orig_addr:	Original (non-bounced) IO buffer address.
+ * @alloc_size: Total requested size of the bounce buffer,
+ *		including initial alignment padding.
+ * @alloc_align_mask:	Required alignment of the allocated buffer.
+ * @retpool:	Used memory pool, updated on return.
+ *
+ * Return: Index of the first allocated slot, or -1 on error.
+ */
+static int swiotlb_search_dev_pools(struct device *dev, int start_cpu,
+		phys_addr_t orig_addr, size_t alloc_size,
+		unsigned int alloc_align_mask, struct io_tlb_pool **retpool)
+{
+	struct io_tlb_pool *pool;
+	int index = -1;
+	int i;
+
+	if (!READ_ONCE(dev->dma_io_tlb_dev))
+		return -1;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(pool, &dev->dma_io_tlb_pools, node) {
+		if (pool->transient)
+			continue;
+		for (i = 0; i < pool->nareas; i++) {
+			index = swiotlb_search_pool_area(dev, pool,
+					(start_cpu + i) & (pool->nareas - 1),
+					orig_addr, alloc_size,
+					alloc_align_mask);
+			if (index >= 0) {
+				*retpool = pool;
+				goto out;
+			}
+		}
+	}
+out:
+	rcu_read_unlock();
+	return index;
+}
+
 /**
  * swiotlb_find_slots() - search for slots in the whole swiotlb
  * @dev:	Device which maps the buffer.
@@ -1194,6 +1403,11 @@ static int swiotlb_find_slots(struct device *dev, phys_addr_t orig_addr,
 		return -1;
 
 	cpu = raw_smp_processor_id();
+	index = swiotlb_search_dev_pools(dev, cpu, orig_addr, alloc_size,
+					 alloc_align_mask, &pool);
+	if (index >= 0)
+		goto found;
+
 	for (i = 0; i < default_nareas; ++i) {
 		index = swiotlb_search_area(dev, cpu, i, orig_addr, alloc_size,
 					    alloc_align_mask, &pool);
@@ -1492,6 +1706,7 @@ static void swiotlb_release_slots(struct device *dev, phys_addr_t tlb_addr,
 	spin_unlock_irqrestore(&area->lock, flags);
 
 	dec_used(dev->dma_io_tlb_mem, nslots);
+	swiotlb_dev_account(dev, -nslots);
 }
 
 #ifdef CONFIG_SWIOTLB_DYNAMIC
@@ -1514,6 +1729,7 @@ static bool swiotlb_del_transient(struct device *dev, phys_addr_t tlb_addr,
 		return false;
 
 	dec_used(dev->dma_io_tlb_mem, pool->nslabs);
+	swiotlb_dev_account(dev, -(long)pool->nslabs);
 	swiotlb_del_pool(dev, pool);
 	dec_transient_used(dev->dma_io_tlb_mem, pool->nslabs);
 	return true;
@@ -1677,6 +1893,23 @@ static int io_tlb_transient_used_get(void *data, u64 *val)
 
 DEFINE_DEBUGFS_ATTRIBUTE(fops_io_tlb_transient_used, io_tlb_transient_used_get,
 			 NULL, "%llu\n");
+
+static int io_tlb_devices_show(struct seq_file *s, void *unused)
+{
+	struct io_tlb_dev *td;
+	unsigned long flags;
+
+	spin_lock_irqsave(&io_tlb_devs_lock, flags);
+	list_for_each_entry(td, &io_tlb_devs, node)
+		seq_printf(s, "%s: bounced %ld used %ld hiwater %ld pools %u nslabs %lu\n",
+			   dev_name(td->dev), atomic_long_read(&td->bounced),
+			   atomic_long_read(&td->used),
+			   atomic_long_read(&td->hiwater), td->npools,
+			   td->nslabs);
+	spin_unlock_irqrestore(&io_tlb_devs_lock, flags);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(io_tlb_devices);
 #endif /* CONFIG_SWIOTLB_DYNAMIC */
 
 static int io_tlb_used_get(void *data, u64 *val)
@@ -1732,6 +1965,10 @@ static void swiotlb_create_debugfs_files(struct io_tlb_mem *mem,
 static int __init swiotlb_create_default_debugfs(void)
 {
 	swiotlb_create_debugfs_files(&io_tlb_default_mem, "swiotlb");
+#ifdef CONFIG_SWIOTLB_DYNAMIC
+	debugfs_create_file("devices", 0400, io_tlb_default_mem.debugfs, NULL,
+			    &io_tlb_devices_fops);
+#endif
 	return 0;
 }
 
@@ -0,0 +1,256 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Benchmark of 842 against LZ4 on page sized inputs, as zswap and zram use
+ * them.
+ *
+ * Reading /sys/kernel/debug/842_bench compresses and decompresses a built-in
+ * corpus of pages shaped after anonymous memory, and reports the ratio and
+ * the speed of both in MB/s.  The corpus is generated from a fixed seed, so
+ * runs are comparable across devices.
+ */
+#define pr_fmt(fmt) "842_bench: " fmt
+
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/lz4.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/prandom.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
+#include <linux/sw842.h>
+#include <linux/unaligned.h>
+#include <linux/vmalloc.h>
+
+#define SW842_BENCH_PAGES	64
+#define SW842_BENCH_NSEC	(100 * NSEC_PER_MSEC)
+
+/* 842 output may be a bit larger than its input, with the templates */
+#define SW842_BENCH_DST		(2 * PAGE_SIZE)
+
+/* Mostly zeroed pages with a few counters and pointers */
+static void sw842_bench_sparse(u8 *buf, struct rnd_state *rnd)
+{
+	size_t i;
+
+	memset(buf, 0, PAGE_SIZE);
+	for (i = 0; i < PAGE_SIZE; i += 64)
+		if (!(prandom_u32_state(rnd) % 4))
+			put_unaligned(0xffff000000000000ull |
+				      prandom_u32_state(rnd), (u64 *)(buf + i));
+}
+
+/* Arrays of small records */
+static void sw842_bench_records(u8 *buf, struct rnd_state *rnd)
+{
+	size_t i;
+	u32 v = 0;
+
+	for (i = 0; i + 16 <= PAGE_SIZE; i += 16) {
+		if (!(prandom_u32_state(rnd) % 8))
+			v = prandom_u32_state(rnd);
+		put_unaligned(v, (u32 *)(buf + i));
+		put_unaligned(i / 16 % 4, (u32 *)(buf + i + 4));
+		put_unaligned(0, (u64 *)(buf + i + 8));
+	}
+}
+
+/* Heap-like pages: pointers into a few regions, sizes and flags */
+static void sw842_bench_heap(u8 *buf, struct rnd_state *rnd)
+{
+	size_t i;
+	u64 v;
+
+	for (i = 0; i < PAGE_SIZE; i += 8) {
+		switch (prandom_u32_state(rnd) % 4) {
+		case 0:
+			v = 0xffff800000000000ull |
+			    (prandom_u32_state(rnd) % 16) << 20 |
+			    (prandom_u32_state(rnd) & 0xff8);
+			break;
+		case 1:
+			v = prandom_u32_state(rnd) % 256;
+			break;
+		default:
+			v = 0;
+			break;
+		}
+		put_unaligned(v, (u64 *)(buf + i));
+	}
+}
+
+/* Media-like data, barely compressible */
+static void sw842_bench_random(u8 *buf, struct rnd_state *rnd)
+{
+	prandom_bytes_state(rnd, buf, PAGE_SIZE);
+}
+
+static const struct {
+	const char *name;
+	void (*fill)(u8 *buf, struct rnd_state *rnd);
+} sw842_bench_corpus[] = {
+	{ "sparse", sw842_bench_sparse },
+	{ "records", sw842_bench_records },
+	{ "heap", sw842_bench_heap },
+	{ "random", sw842_bench_random },
+};
+
+struct sw842_bench_buf {
+	u8 *in;
+	u8 *comp;
+	u8 *out;
+	unsigned int comp_len[SW842_BENCH_PAGES];
+	void *wrkmem;
+};
+
+static int sw842_bench_compress(bool lz4, struct sw842_bench_buf *b,
+				unsigned int *total)
+{
+	unsigned int i, len;
+	int ret;
+
+	*total = 0;
+	for (i = 0; i < SW842_BENCH_PAGES; i++) {
+		u8 *src = b->in + i * PAGE_SIZE;
+		u8 *dst = b->comp + i * SW842_BENCH_DST;
+
+		if (lz4) {
+			ret = LZ4_compress_default((const char *)src,
+						   (char *)dst, PAGE_SIZE,
+						   SW842_BENCH_DST, b->wrkmem);
+			len = ret;
+			ret = ret > 0 ? 0 : -EINVAL;
+		} else {
+			len = SW842_BENCH_DST;
+			ret = sw842_compress(src, PAGE_SIZE, dst, &len,
+					     b->wrkmem);
+		}
+		if (ret)
+			return ret;
+		b->comp_len[i] = len;
+		*total += len;
+	}
+	return 0;
+}
+
+static int sw842_bench_decompress(bool lz4, struct sw842_bench_buf *b)
+{
+	unsigned int i, len;
+	int ret;
+
+	for (i = 0; i < SW842_BENCH_PAGES; i++) {
+		u8 *src = b->comp + i * SW842_BENCH_DST;
+		u8 *dst = b->out + i * PAGE_SIZE;
+
+		if (lz4) {
+			ret = LZ4_decompress_safe((const char *)src,
+						  (char *)dst, b->comp_len[i],
+						  PAGE_SIZE);
+			len = ret;
+			ret = ret >= 0 ? 0 : -EINVAL;
+		} else {
+			len = PAGE_SIZE;
+			ret = sw842_decompress(src, b->comp_len[i], dst, &len);
+		}
+		if (ret)
+			return ret;
+		if (len != PAGE_SIZE)
+			return -EINVAL;
+	}
+	return 0;
+}
+
+/* Returns the speed in MB/s, or a negative error */
+static long sw842_bench_run(bool lz4, bool decompress,
+			    struct sw842_bench_buf *b, unsigned int *comp)
+{
+	u64 start, ns, bytes = 0;
+	int err;
+
+	start = ktime_get_ns();
+	do {
+		if (decompress)
+			err = sw842_bench_decompress(lz4, b);
+		else
+			err = sw842_bench_compress(lz4, b, comp);
+		if (err)
+			return err;
+		bytes += SW842_BENCH_PAGES * PAGE_SIZE;
+		cond_resched();
+		ns = ktime_get_ns() - start;
+	} while (ns < SW842_BENCH_NSEC);
+
+	if (decompress && memcmp(b->in, b->out, SW842_BENCH_PAGES * PAGE_SIZE))
+		return -EILSEQ;
+	return div64_u64(bytes * NSEC_PER_SEC / SZ_1M, ns);
+}
+
+static int sw842_bench_show(struct seq_file *s, void *unused)
+{
+	static const char *const names[] = { "842", "lz4" };
+	struct sw842_bench_buf b = {};
+	unsigned int i, j, k, comp = 0, ratio;
+	long ctime, dtime;
+	struct rnd_state rnd;
+	int err = -ENOMEM;
+
+	b.in = vmalloc(SW842_BENCH_PAGES * PAGE_SIZE);
+	b.out = vmalloc(SW842_BENCH_PAGES * PAGE_SIZE);
+	b.comp = vmalloc(SW842_BENCH_PAGES * SW842_BENCH_DST);
+	b.wrkmem = vmalloc(max(SW842_MEM_COMPRESS, LZ4_MEM_COMPRESS));
+	if (!b.in || !b.out || !b.comp || !b.wrkmem)
+		goto out;
+
+	seq_puts(s, "corpus   algo  ratio  compress_MBps  decompress_MBps\n");
+	for (i = 0; i < ARRAY_SIZE(sw842_bench_corpus); i++) {
+		prandom_seed_state(&rnd, 42);
+		for (k = 0; k < SW842_BENCH_PAGES; k++)
+			sw842_bench_corpus[i].fill(b.in + k * PAGE_SIZE, &rnd);
+
+		for (j = 0; j < ARRAY_SIZE(names); j++) {
+			ctime = sw842_bench_run(j, false, &b, &comp);
+			memset(b.out, 0, SW842_BENCH_PAGES * PAGE_SIZE);
+			dtime = ctime > 0 ? sw842_bench_run(j, true, &b, NULL)
+					  : ctime;
+			if (ctime <= 0 || dtime <= 0) {
+				err = ctime <= 0 ? ctime : dtime;
+				pr_err("%s/%s: failed: %d\n",
+				       sw842_bench_corpus[i].name, names[j],
+				       err);
+				goto out;
+			}
+
+			ratio = SW842_BENCH_PAGES * PAGE_SIZE * 100 / comp;
+			seq_printf(s, "%-8s %-4s %3u.%02u  %13ld  %15ld\n",
+				   sw842_bench_corpus[i].name, names[j],
+				   ratio / 100, ratio % 100, ctime, dtime);
+		}
+	}
+	err = 0;
+out:
+	vfree(b.wrkmem);
+	vfree(b.comp);
+	vfree(b.out);
+	vfree(b.in);
+	return err;
+}
+DEFINE_SHOW_ATTRIBUTE(sw842_bench);
+
+static struct dentry *sw842_bench_dentry;
+
+static int __init sw842_bench_init(void)
+{
+	sw842_bench_dentry = debugfs_create_file("842_bench", 0400, NULL,
+						 NULL, &sw842_bench_fops);
+	return 0;
+}
+module_init(sw842_bench_init);
+
+static void __exit sw842_bench_exit(void)
+{
+	debugfs_remove(sw842_bench_dentry);
+}
+module_exit(sw842_bench_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("842 and LZ4 page compression benchmark");
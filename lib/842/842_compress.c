@@ -64,24 +64,6 @@ static u8 comp_ops[OPS_MAX][5] = { /* params size in bits */
 	{ D8, N0, N0, N0, 0x00 }, /* 64 */
 };
 
-struct sw842_hlist_node8 {
-	struct hlist_node node;
-	u64 data;
-	u8 index;
-};
-
-struct sw842_hlist_node4 {
-	struct hlist_node node;
-	u32 data;
-	u16 index;
-};
-
-struct sw842_hlist_node2 {
-	struct hlist_node node;
-	u16 data;
-	u8 index;
-};
-
 #define INDEX_NOT_FOUND		(-1)
 #define INDEX_NOT_CHECKED	(-2)
 
@@ -98,37 +80,60 @@ struct sw842_param {
 	int index8[1];
 	int index4[2];
 	int index2[4];
-	DECLARE_HASHTABLE(htable8, SW842_HASHTABLE8_BITS);
-	DECLARE_HASHTABLE(htable4, SW842_HASHTABLE4_BITS);
-	DECLARE_HASHTABLE(htable2, SW842_HASHTABLE2_BITS);
-	struct sw842_hlist_node8 node8[1 << I8_BITS];
-	struct sw842_hlist_node4 node4[1 << I4_BITS];
-	struct sw842_hlist_node2 node2[1 << I2_BITS];
+
+	/*
+	 * Hash chains of the positions of the last 1 << I<b>_BITS <b> byte
+	 * blocks, which are what the index<b> values refer to.  Positions are
+	 * offsets in the input plus base, which starts past the end of the
+	 * previous input and its window on each call: so entries of earlier
+	 * calls are out of the window, and the tables are never reset.
+	 *
+	 * An entry is only used if it is inside the window and the data at that
+	 * position matches, so the tables may start uninitialized, as they do
+	 * in the caller's workspace, and a chain can't be followed past the
+	 * window, where prev<b> slots have been reused.
+	 */
+	u32 base;
+	u32 end;
+	u32 head8[1 << SW842_HASHTABLE8_BITS];
+	u32 head4[1 << SW842_HASHTABLE4_BITS];
+	u32 head2[1 << SW842_HASHTABLE2_BITS];
+	u32 prev8[1 << I8_BITS];
+	u32 prev4[1 << I4_BITS];
+	u32 prev2[1 << I2_BITS];
 };
 
+/* the largest window, of the 8 and 4 byte blocks */
+#define SW842_WINDOW		((1 << I8_BITS) * 8)
+
 #define get_input_data(p, o, b)						\
 	be##b##_to_cpu(get_unaligned((__be##b *)((p)->in + (o))))
 
-#define init_hashtable_nodes(p, b)	do {			\
-	int _i;							\
-	hash_init((p)->htable##b);				\
-	for (_i = 0; _i < ARRAY_SIZE((p)->node##b); _i++) {	\
-		(p)->node##b[_i].index = _i;			\
-		(p)->node##b[_i].data = 0;			\
-		INIT_HLIST_NODE(&(p)->node##b[_i].node);	\
-	}							\
-} while (0)
+#define hash_data(p, b, n)						\
+	hash_min((p)->data##b[n], SW842_HASHTABLE##b##_BITS)
 
+/* the chain walk ends at the first entry that isn't older and in window */
 #define find_index(p, b, n)	({					\
-	struct sw842_hlist_node##b *_n;					\
-	p->index##b[n] = INDEX_NOT_FOUND;				\
-	hash_for_each_possible(p->htable##b, _n, node, p->data##b[n]) {	\
-		if (p->data##b[n] == _n->data) {			\
-			p->index##b[n] = _n->index;			\
+	u32 _pos = (p)->in - (p)->instart;				\
+	u32 _cur = (p)->base + _pos;					\
+	u32 _c = (p)->head##b[hash_data(p, b, n)];			\
+	u32 _dist, _last = 0;						\
+	(p)->index##b[n] = INDEX_NOT_FOUND;				\
+	for (;;) {							\
+		_dist = _cur - _c;					\
+		if (_dist <= _last || _dist > _pos ||			\
+		    _dist > (1 << I##b##_BITS) * (b) || _dist % (b))	\
+			break;						\
+		if (!memcmp((p)->in - _dist, (p)->in + (n) * (b), b)) {	\
+			(p)->index##b[n] = (_pos - _dist) / (b) %	\
+				(1 << I##b##_BITS);			\
 			break;						\
 		}							\
+		_last = _dist;						\
+		_c = (p)->prev##b[(_pos - _dist) / (b) %		\
+				  (1 << I##b##_BITS)];			\
 	}								\
-	p->index##b[n] >= 0;						\
+	(p)->index##b[n] >= 0;						\
 })
 
 #define check_index(p, b, n)			\
@@ -137,14 +142,13 @@ struct sw842_param {
 	 : (p)->index##b[n] >= 0)
 
 #define replace_hash(p, b, i, d)	do {				\
-	struct sw842_hlist_node##b *_n = &(p)->node##b[(i)+(d)];	\
-	hash_del(&_n->node);						\
-	_n->data = (p)->data##b[d];					\
+	u32 *_head = &(p)->head##b[hash_data(p, b, d)];			\
 	pr_debug("add hash index%x %x pos %x data %lx\n", b,		\
-		 (unsigned int)_n->index,				\
+		 (unsigned int)((i)+(d)),				\
 		 (unsigned int)((p)->in - (p)->instart),		\
-		 (unsigned long)_n->data);				\
-	hash_add((p)->htable##b, &_n->node, _n->data);			\
+		 (unsigned long)(p)->data##b[d]);			\
+	(p)->prev##b[(i)+(d)] = *_head;					\
+	*_head = (p)->base + ((p)->in - (p)->instart) + (d) * (b);	\
 } while (0)
 
 static u8 bmask[8] = { 0x00, 0x80, 0xc0, 0xe0, 0xf0, 0xf8, 0xfc, 0xfe };
@@ -485,9 +489,9 @@ int sw842_compress(const u8 *in, unsigned int ilen,
 
 	BUILD_BUG_ON(sizeof(*p) > SW842_MEM_COMPRESS);
 
-	init_hashtable_nodes(p, 8);
-	init_hashtable_nodes(p, 4);
-	init_hashtable_nodes(p, 2);
+	/* start out of the window of the previous input, 8 byte aligned */
+	p->base = ALIGN(p->end + SW842_WINDOW, 8);
+	p->end = p->base + ilen;
 
 	p->in = (u8 *)in;
 	p->instart = p->in;
@@ -225,6 +225,44 @@ extern UDItype __udiv_qrnnd(UDItype *, UDItype, UDItype, UDItype);
 #define UDIV_TIME 100
 #endif /* __arm__ */
 
+/***************************************
+	**************  ARM64  ****************
+	***************************************/
+#if defined(__aarch64__) && W_TYPE_SIZE == 64
+#define add_ssaaaa(sh, sl, ah, al, bh, bl) \
+	__asm__ ("adds %1, %4, %5\n" \
+		"adc  %0, %2, %3" \
+	: "=r" (sh), \
+		"=&r" (sl) \
+	: "r" ((UWtype)(ah)), \
+		"r" ((UWtype)(bh)), \
+		"r" ((UWtype)(al)), \
+		"r" ((UWtype)(bl)) \
+	: "cc")
+#define sub_ddmmss(sh, sl, ah, al, bh, bl) \
+	__asm__ ("subs %1, %4, %5\n" \
+		"sbc  %0, %2, %3" \
+	: "=r" (sh), \
+		"=&r" (sl) \
+	: "r" ((UWtype)(ah)), \
+		"r" ((UWtype)(bh)), \
+		"r" ((UWtype)(al)), \
+		"r" ((UWtype)(bl)) \
+	: "cc")
+#define umul_ppmm(xh, xl, a, b) \
+do { \
+	UWtype __a = (a), __b = (b); \
+	__asm__ ("umulh %0, %1, %2" \
+	: "=r" (xh) \
+	: "r" (__a), \
+		"r" (__b)); \
+	(xl) = __a * __b; \
+} while (0)
+#define UMUL_TIME 4
+/* udiv_qrnnd is the generic C one, multiplying by the inverse is cheaper */
+#define UDIV_TIME 100
+#endif /* __aarch64__ */
+
 /***************************************
 	**************  CLIPPER  **************
 	***************************************/
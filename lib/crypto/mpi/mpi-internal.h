@@ -174,6 +174,8 @@ int mpihelp_mul(mpi_ptr_t prodp, mpi_ptr_t up, mpi_size_t usize,
 void mpih_sqr_n_basecase(mpi_ptr_t prodp, mpi_ptr_t up, mpi_size_t size);
 void mpih_sqr_n(mpi_ptr_t prodp, mpi_ptr_t up, mpi_size_t size,
 		mpi_ptr_t tspace);
+void mpih_mul_n(mpi_ptr_t prodp, mpi_ptr_t up, mpi_ptr_t vp, mpi_size_t size,
+		mpi_ptr_t tspace);
 
 int mpihelp_mul_karatsuba_case(mpi_ptr_t prodp,
 			       mpi_ptr_t up, mpi_size_t usize,
@@ -184,6 +186,11 @@ int mpihelp_mul_karatsuba_case(mpi_ptr_t prodp,
 mpi_limb_t mpihelp_mul_1(mpi_ptr_t res_ptr, mpi_ptr_t s1_ptr,
 			 mpi_size_t s1_size, mpi_limb_t s2_limb);
 
+/*-- mpi-pow.c --*/
+bool mpi_powm_mont_ok(MPI base, MPI exp, MPI mod);
+int mpi_powm_mont(MPI res, MPI base, MPI exp, MPI mod);
+int mpi_powm_divrem(MPI res, MPI base, MPI exp, MPI mod);
+
 /*-- mpih-div.c --*/
 mpi_limb_t mpihelp_mod_1(mpi_ptr_t dividend_ptr, mpi_size_t dividend_size,
 			 mpi_limb_t divisor_limb);
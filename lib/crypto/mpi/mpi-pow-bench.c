@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Benchmark of the Montgomery mpi_powm() against the division based one.
+ *
+ * Reading /sys/kernel/debug/mpi_powm_bench runs modular exponentiations
+ * shaped after RSA signature verification (e = 65537) and signing (full
+ * size exponent) for the usual key sizes, and reports the time per
+ * operation of both.  The operands are generated from a fixed seed, so
+ * runs are comparable across devices.
+ */
+#define pr_fmt(fmt) "mpi_bench: " fmt
+
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/prandom.h>
+#include <linux/seq_file.h>
+#include "mpi-internal.h"
+
+#define MPI_BENCH_NSEC		(200 * NSEC_PER_MSEC)
+
+static const unsigned int mpi_bench_bits[] = { 2048, 3072, 4096 };
+
+static MPI mpi_bench_rand(unsigned int bits, struct rnd_state *rnd)
+{
+	mpi_size_t i, n = DIV_ROUND_UP(bits, BITS_PER_MPI_LIMB);
+	MPI a = mpi_alloc(n);
+
+	if (!a)
+		return NULL;
+	prandom_bytes_state(rnd, a->d, n * BYTES_PER_MPI_LIMB);
+	for (i = 0; i < n; i++)
+		if (!a->d[i])
+			a->d[i] = 1;
+	a->nlimbs = n;
+	return a;
+}
+
+/* Returns the time per operation in ns, or a negative error */
+static s64 mpi_bench_run(bool mont, MPI res, MPI base, MPI exp, MPI mod)
+{
+	u64 start, ns, ops = 0;
+	int err;
+
+	start = ktime_get_ns();
+	do {
+		if (mont)
+			err = mpi_powm_mont(res, base, exp, mod);
+		else
+			err = mpi_powm_divrem(res, base, exp, mod);
+		if (err)
+			return err;
+		ops++;
+		cond_resched();
+		ns = ktime_get_ns() - start;
+	} while (ns < MPI_BENCH_NSEC);
+
+	return div64_u64(ns, ops);
+}
+
+static int mpi_bench_show(struct seq_file *s, void *unused)
+{
+	MPI mod = NULL, base = NULL, exp = NULL, r1 = NULL, r2 = NULL;
+	unsigned int i, bits;
+	struct rnd_state rnd;
+	s64 divrem, mont;
+	int j, err = 0;
+
+	seq_puts(s, "bits  exponent  divrem_us  mont_us  speedup\n");
+	for (i = 0; i < ARRAY_SIZE(mpi_bench_bits) && !err; i++) {
+		bits = mpi_bench_bits[i];
+		prandom_seed_state(&rnd, 42);
+
+		err = -ENOMEM;
+		mod = mpi_bench_rand(bits, &rnd);
+		base = mpi_bench_rand(bits - 1, &rnd);
+		exp = mpi_bench_rand(bits, &rnd);
+		r1 = mpi_alloc(0);
+		r2 = mpi_alloc(0);
+		if (!mod || !base || !exp || !r1 || !r2)
+			goto next;
+		mod->d[0] |= 1;
+		mod->d[mod->nlimbs - 1] |= 1UL << (BITS_PER_MPI_LIMB - 1);
+
+		for (j = 0; j < 2; j++) {
+			if (!j) {
+				exp->d[0] = 65537;
+				exp->nlimbs = 1;
+			} else {
+				exp->nlimbs = mod->nlimbs;
+			}
+
+			divrem = mpi_bench_run(false, r1, base, exp, mod);
+			mont = mpi_bench_run(true, r2, base, exp, mod);
+			if (divrem <= 0 || mont <= 0) {
+				err = divrem <= 0 ? divrem : mont;
+				pr_err("%u bits: mpi_powm failed: %d\n",
+				       bits, err);
+				goto next;
+			}
+			if (mpi_cmp(r1, r2)) {
+				err = -EILSEQ;
+				pr_err("%u bits: results differ\n", bits);
+				goto next;
+			}
+
+			seq_printf(s, "%4u  %8s  %9lld  %7lld  %3lld.%02lld\n",
+				   bits, j ? "full" : "65537",
+				   divrem / NSEC_PER_USEC, mont / NSEC_PER_USEC,
+				   divrem / mont, divrem * 100 / mont % 100);
+		}
+		err = 0;
+next:
+		mpi_free(r2);
+		mpi_free(r1);
+		mpi_free(exp);
+		mpi_free(base);
+		mpi_free(mod);
+	}
+	return err;
+}
+DEFINE_SHOW_ATTRIBUTE(mpi_bench);
+
+static struct dentry *mpi_bench_dentry;
+
+static int __init mpi_bench_init(void)
+{
+	mpi_bench_dentry = debugfs_create_file("mpi_powm_bench", 0400, NULL,
+					       NULL, &mpi_bench_fops);
+	return 0;
+}
+module_init(mpi_bench_init);
+
+static void __exit mpi_bench_exit(void)
+{
+	debugfs_remove(mpi_bench_dentry);
+}
+module_exit(mpi_bench_exit);
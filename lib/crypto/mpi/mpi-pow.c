@@ -18,10 +18,226 @@
 #include "mpi-internal.h"
 #include "longlong.h"
 
+/*
+ * Montgomery exponentiation, for odd moduli such as all RSA moduli.
+ *
+ * Numbers are kept as A * R mod M, with R = 2^(N * BITS_PER_MPI_LIMB) for
+ * an N limb modulus, so that the reduction after each multiplication is
+ * N multiply-accumulate passes over M instead of a long division.  The
+ * exponent is scanned left to right with a sliding window over a table of
+ * the odd powers of the base.
+ */
+struct mpi_mont {
+	mpi_ptr_t mp;		/* modulus */
+	mpi_ptr_t np;		/* modulus normalized for mpihelp_divrem */
+	mpi_ptr_t tp;		/* double length product */
+	mpi_ptr_t cy;		/* carries of the reduction */
+	mpi_ptr_t tspace;	/* Karatsuba scratch */
+	mpi_size_t n;
+	unsigned int shift;
+	mpi_limb_t minv;	/* -1 / M mod 2^BITS_PER_MPI_LIMB */
+};
+
+static mpi_limb_t mpi_mont_minv(mpi_limb_t m0)
+{
+	/* m0 * m0 == 1 mod 8 for any odd m0, so x starts with 3 good bits */
+	mpi_limb_t x = m0;
+	int i;
+
+	/* and each Newton step doubles the number of good bits */
+	for (i = 3; i < BITS_PER_MPI_LIMB; i *= 2)
+		x *= 2 - m0 * x;
+	return -x;
+}
+
+/* RP = TP / R mod M, for TP < M * R of 2 * N limbs; TP is clobbered */
+static void mpi_mont_redc(struct mpi_mont *mt, mpi_ptr_t rp)
+{
+	mpi_ptr_t tp = mt->tp;
+	mpi_size_t i, n = mt->n;
+	mpi_limb_t c;
+
+	/*
+	 * Each pass clears one low limb.  Its carry belongs to the upper
+	 * half, which no later pass looks at, so they are all added there
+	 * at the end instead of being propagated each time.
+	 */
+	for (i = 0; i < n; i++)
+		mt->cy[i] = mpihelp_addmul_1(tp + i, mt->mp, n,
+					     tp[i] * mt->minv);
+
+	c = mpihelp_add_n(rp, tp + n, mt->cy, n);
+	if (c || mpihelp_cmp(rp, mt->mp, n) >= 0)
+		mpihelp_sub_n(rp, rp, mt->mp, n);
+}
+
+/* RP = AP * BP / R mod M; RP may be AP or BP */
+static void mpi_mont_mul(struct mpi_mont *mt, mpi_ptr_t rp, mpi_ptr_t ap,
+			 mpi_ptr_t bp)
+{
+	if (ap == bp) {
+		if (mt->n < KARATSUBA_THRESHOLD)
+			mpih_sqr_n_basecase(mt->tp, ap, mt->n);
+		else
+			mpih_sqr_n(mt->tp, ap, mt->n, mt->tspace);
+	} else {
+		mpih_mul_n(mt->tp, ap, bp, mt->n, mt->tspace);
+	}
+	mpi_mont_redc(mt, rp);
+}
+
+/* RP = AP * R mod M, with the usual division */
+static void mpi_mont_to(struct mpi_mont *mt, mpi_ptr_t rp, mpi_ptr_t ap,
+			mpi_size_t asize)
+{
+	mpi_ptr_t tp = mt->tp;
+	mpi_size_t n = mt->n;
+	mpi_size_t tsize = n + asize;
+
+	MPN_ZERO(tp, n);
+	if (mt->shift)
+		tp[tsize++] = mpihelp_lshift(tp + n, ap, asize, mt->shift);
+	else
+		MPN_COPY(tp + n, ap, asize);
+
+	/* the quotient goes above the remainder, we don't need it */
+	mpihelp_divrem(tp + n, 0, tp, tsize, mt->np, n);
+	if (mt->shift)
+		mpihelp_rshift(rp, tp, n, mt->shift);
+	else
+		MPN_COPY(rp, tp, n);
+}
+
+static int mpi_powm_bit(mpi_ptr_t ep, int i)
+{
+	return (ep[i / BITS_PER_MPI_LIMB] >> (i % BITS_PER_MPI_LIMB)) & 1;
+}
+
+/*
+ * A window of W bits saves about EBITS / (W + 1) multiplications and costs
+ * a table of 2^(W - 1) entries to compute.  Verifying with e = 65537 uses
+ * no table at all.
+ */
+static unsigned int mpi_powm_window_bits(unsigned int ebits)
+{
+	if (ebits > 671)
+		return 6;
+	if (ebits > 239)
+		return 5;
+	if (ebits > 79)
+		return 4;
+	if (ebits > 23)
+		return 3;
+	return 1;
+}
+
+bool mpi_powm_mont_ok(MPI base, MPI exp, MPI mod)
+{
+	return mod->nlimbs && (mod->d[0] & 1) && mod->d[mod->nlimbs - 1] &&
+	       !mod->sign && base->nlimbs && !base->sign &&
+	       exp->nlimbs && exp->d[exp->nlimbs - 1];
+}
+
+int mpi_powm_mont(MPI res, MPI base, MPI exp, MPI mod)
+{
+	mpi_size_t n = mod->nlimbs, bsize = base->nlimbs, rsize;
+	mpi_size_t esize = exp->nlimbs, tsize;
+	struct mpi_mont mt = { .mp = mod->d, .n = n };
+	mpi_ptr_t ep = exp->d, space, gp, rp;
+	unsigned int wbits, w;
+	int ebits, i, j, k;
+	bool first = true;
+
+	ebits = esize * BITS_PER_MPI_LIMB - count_leading_zeros(ep[esize - 1]);
+	wbits = mpi_powm_window_bits(ebits);
+
+	/* the product, or the base shifted up by N limbs, and a spare limb */
+	tsize = max(2 * n, n + bsize) + 1;
+	space = mpi_alloc_limb_space(tsize + 5 * n + (n << (wbits - 1)));
+	if (!space)
+		return -ENOMEM;
+	mt.tp = space;
+	mt.cy = mt.tp + tsize;
+	mt.tspace = mt.cy + n;
+	mt.np = mt.tspace + 2 * n;
+	rp = mt.np + n;
+	gp = rp + n;
+
+	mt.minv = mpi_mont_minv(mod->d[0]);
+	mt.shift = count_leading_zeros(mod->d[n - 1]);
+	if (mt.shift)
+		mpihelp_lshift(mt.np, mod->d, n, mt.shift);
+	else
+		MPN_COPY(mt.np, mod->d, n);
+
+	/* the odd powers B, B^3, ..., B^(2^WBITS - 1) */
+	mpi_mont_to(&mt, gp, base->d, bsize);
+	if (wbits > 1) {
+		mpi_mont_mul(&mt, rp, gp, gp);
+		for (j = 1; j < 1 << (wbits - 1); j++)
+			mpi_mont_mul(&mt, gp + j * n, gp + (j - 1) * n, rp);
+	}
+
+	/* the top bit is set, so the first window comes before any square */
+	for (i = ebits - 1; i >= 0; ) {
+		if (!mpi_powm_bit(ep, i)) {
+			mpi_mont_mul(&mt, rp, rp, rp);
+			i--;
+			continue;
+		}
+
+		/* the longest window of at most WBITS, ending with a set bit */
+		j = max(i - (int)wbits + 1, 0);
+		while (!mpi_powm_bit(ep, j))
+			j++;
+		for (w = 0, k = i; k >= j; k--)
+			w = w << 1 | mpi_powm_bit(ep, k);
+
+		if (first) {
+			MPN_COPY(rp, gp + (w >> 1) * n, n);
+			first = false;
+		} else {
+			for (k = i; k >= j; k--)
+				mpi_mont_mul(&mt, rp, rp, rp);
+			mpi_mont_mul(&mt, rp, rp, gp + (w >> 1) * n);
+		}
+		i = j - 1;
+		cond_resched();
+	}
+
+	/* and out of Montgomery form, fully reduced */
+	MPN_COPY(mt.tp, rp, n);
+	MPN_ZERO(mt.tp + n, n);
+	mpi_mont_redc(&mt, rp);
+
+	/* RES may be any of the inputs, which are not needed any more */
+	rsize = n;
+	MPN_NORMALIZE(rp, rsize);
+	if (mpi_resize(res, n) < 0) {
+		mpi_free_limb_space(space);
+		return -ENOMEM;
+	}
+	MPN_COPY(res->d, rp, rsize);
+	res->nlimbs = rsize;
+	res->sign = 0;
+
+	mpi_free_limb_space(space);
+	return 0;
+}
+
 /****************
  * RES = BASE ^ EXP mod MOD
  */
 int mpi_powm(MPI res, MPI base, MPI exp, MPI mod)
+{
+	if (mpi_powm_mont_ok(base, exp, mod))
+		return mpi_powm_mont(res, base, exp, mod);
+	return mpi_powm_divrem(res, base, exp, mod);
+}
+EXPORT_SYMBOL_GPL(mpi_powm);
+
+/* The same, with a division after each multiplication, for any modulus */
+int mpi_powm_divrem(MPI res, MPI base, MPI exp, MPI mod)
 {
 	mpi_ptr_t mp_marker = NULL, bp_marker = NULL, ep_marker = NULL;
 	struct karatsuba_ctx karactx = {};
@@ -306,4 +522,3 @@ int mpi_powm(MPI res, MPI base, MPI exp, MPI mod)
 		mpi_free_limb_space(tspace);
 	return rc;
 }
-EXPORT_SYMBOL_GPL(mpi_powm);
@@ -204,40 +204,48 @@ mul_n(mpi_ptr_t prodp, mpi_ptr_t up, mpi_ptr_t vp,
 	}
 }
 
+/*
+ * Squaring only needs each cross product U[i] * U[j], i < j, once: sum
+ * them, double the sum and add the squares U[i]^2 on the diagonal.  That
+ * is about half the multiplications of mul_n_basecase().
+ */
 void mpih_sqr_n_basecase(mpi_ptr_t prodp, mpi_ptr_t up, mpi_size_t size)
 {
+	mpi_limb_t hi, lo, p0, p1, c0, cy;
 	mpi_size_t i;
-	mpi_limb_t cy_limb;
-	mpi_limb_t v_limb;
-
-	/* Multiply by the first limb in V separately, as the result can be
-	 * stored (not added) to PROD.  We also avoid a loop for zeroing.  */
-	v_limb = up[0];
-	if (v_limb <= 1) {
-		if (v_limb == 1)
-			MPN_COPY(prodp, up, size);
-		else
-			MPN_ZERO(prodp, size);
-		cy_limb = 0;
-	} else
-		cy_limb = mpihelp_mul_1(prodp, up, size, v_limb);
-
-	prodp[size] = cy_limb;
-	prodp++;
 
-	/* For each iteration in the outer loop, multiply one limb from
-	 * U with one limb from V, and add it to PROD.  */
-	for (i = 1; i < size; i++) {
-		v_limb = up[i];
-		if (v_limb <= 1) {
-			cy_limb = 0;
-			if (v_limb == 1)
-				cy_limb = mpihelp_add_n(prodp, prodp, up, size);
-		} else
-			cy_limb = mpihelp_addmul_1(prodp, up, size, v_limb);
+	if (size == 1) {
+		umul_ppmm(prodp[1], prodp[0], up[0], up[0]);
+		return;
+	}
 
-		prodp[size] = cy_limb;
-		prodp++;
+	/* Row I is U[I] * U[I+1..], at 2 * I + 1, with its carry at SIZE + I */
+	prodp[0] = 0;
+	prodp[size] = mpihelp_mul_1(prodp + 1, up + 1, size - 1, up[0]);
+	for (i = 1; i < size - 1; i++)
+		prodp[size + i] = mpihelp_addmul_1(prodp + 2 * i + 1, up + i + 1,
+						   size - i - 1, up[i]);
+	prodp[2 * size - 1] = 0;
+
+	/* The cross products are less than half of the square */
+	mpihelp_lshift(prodp, prodp, 2 * size, 1);
+
+	cy = 0;
+	for (i = 0; i < size; i++) {
+		umul_ppmm(hi, lo, up[i], up[i]);
+		/* U[i]^2 <= (B - 1)^2, so HI is at most B - 2 and can't wrap */
+		lo += cy;
+		hi += lo < cy;
+
+		p0 = prodp[2 * i] + lo;
+		c0 = p0 < lo;
+		p1 = prodp[2 * i + 1] + hi;
+		cy = p1 < hi;
+		p1 += c0;
+		cy += p1 < c0;
+
+		prodp[2 * i] = p0;
+		prodp[2 * i + 1] = p1;
 	}
 }
 
@@ -317,6 +325,13 @@ mpih_sqr_n(mpi_ptr_t prodp, mpi_ptr_t up, mpi_size_t size, mpi_ptr_t tspace)
 	}
 }
 
+/* PRODP = UP * VP, of SIZE limbs each, with TSPACE of 2 * SIZE limbs */
+void mpih_mul_n(mpi_ptr_t prodp, mpi_ptr_t up, mpi_ptr_t vp, mpi_size_t size,
+		mpi_ptr_t tspace)
+{
+	MPN_MUL_N_RECURSE(prodp, up, vp, size, tspace);
+}
+
 int
 mpihelp_mul_karatsuba_case(mpi_ptr_t prodp,
 			   mpi_ptr_t up, mpi_size_t usize,
@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: GPL-2.0 OR Linux-OpenIB
+/*
+ * Completion DIM: moderation of completion queues that are not network
+ * queues, such as block device completion queues, DMA engine channels or
+ * USB controller event rings.  It tunes on the byte and completion rates,
+ * and can be biased towards latency.
+ */
+
+#include <linux/dim.h>
+
+/*
+ * Completion DIM profiles:
+ *        @usec is the longest a completion may be held, @comps the number of
+ *        completions after which they are signalled anyway.  The first
+ *        profile is no moderation at all.
+ *        Profile size must be of COMP_DIM_PARAMS_NUM_PROFILES.
+ */
+#define COMP_DIM_PROFILES { \
+	{.usec = 0,   .comps = 1,},  \
+	{.usec = 8,   .comps = 4,},  \
+	{.usec = 16,  .comps = 8,},  \
+	{.usec = 32,  .comps = 16,}, \
+	{.usec = 64,  .comps = 32,}, \
+	{.usec = 128, .comps = 64,}  \
+}
+
+static const struct dim_cq_moder
+comp_profile[COMP_DIM_PARAMS_NUM_PROFILES] = COMP_DIM_PROFILES;
+
+struct dim_cq_moder comp_dim_get_moderation(int ix)
+{
+	return comp_profile[clamp(ix, 0, COMP_DIM_PARAMS_NUM_PROFILES - 1)];
+}
+EXPORT_SYMBOL(comp_dim_get_moderation);
+
+static int comp_dim_step(struct dim *dim)
+{
+	if (dim->tired == (COMP_DIM_PARAMS_NUM_PROFILES * 2))
+		return DIM_TOO_TIRED;
+
+	switch (dim->tune_state) {
+	case DIM_PARKING_ON_TOP:
+	case DIM_PARKING_TIRED:
+		break;
+	case DIM_GOING_RIGHT:
+		if (dim->profile_ix == (COMP_DIM_PARAMS_NUM_PROFILES - 1))
+			return DIM_ON_EDGE;
+		dim->profile_ix++;
+		dim->steps_right++;
+		break;
+	case DIM_GOING_LEFT:
+		if (dim->profile_ix == 0)
+			return DIM_ON_EDGE;
+		dim->profile_ix--;
+		dim->steps_left++;
+		break;
+	}
+
+	dim->tired++;
+	return DIM_STEPPED;
+}
+
+static void comp_dim_exit_parking(struct dim *dim)
+{
+	dim->tune_state = dim->profile_ix ? DIM_GOING_LEFT : DIM_GOING_RIGHT;
+	comp_dim_step(dim);
+}
+
+static int comp_dim_stats_compare(struct dim_stats *curr,
+				  struct dim_stats *prev, bool latency_bias)
+{
+	if (!prev->bpms)
+		return curr->bpms ? DIM_STATS_BETTER : DIM_STATS_SAME;
+
+	if (IS_SIGNIFICANT_DIFF(curr->bpms, prev->bpms))
+		return (curr->bpms > prev->bpms) ? DIM_STATS_BETTER :
+						   DIM_STATS_WORSE;
+
+	if (!prev->cpms)
+		return curr->cpms ? DIM_STATS_BETTER : DIM_STATS_SAME;
+
+	if (IS_SIGNIFICANT_DIFF(curr->cpms, prev->cpms))
+		return (curr->cpms > prev->cpms) ? DIM_STATS_BETTER :
+						   DIM_STATS_WORSE;
+
+	/*
+	 * Same throughput: fewer events for the same work is better, unless
+	 * latency matters more, as saving events is then not worth the delay
+	 * added to each completion.
+	 */
+	if (latency_bias || !prev->epms)
+		return DIM_STATS_SAME;
+
+	if (IS_SIGNIFICANT_DIFF(curr->epms, prev->epms))
+		return (curr->epms < prev->epms) ? DIM_STATS_BETTER :
+						   DIM_STATS_WORSE;
+
+	return DIM_STATS_SAME;
+}
+
+static bool comp_dim_decision(struct dim_stats *curr_stats, struct dim *dim,
+			      bool latency_bias)
+{
+	int prev_state = dim->tune_state;
+	int prev_ix = dim->profile_ix;
+	int stats_res;
+	int step_res;
+
+	switch (dim->tune_state) {
+	case DIM_PARKING_ON_TOP:
+		stats_res = comp_dim_stats_compare(curr_stats,
+						   &dim->prev_stats,
+						   latency_bias);
+		if (stats_res != DIM_STATS_SAME)
+			comp_dim_exit_parking(dim);
+		break;
+
+	case DIM_PARKING_TIRED:
+		dim->tired--;
+		if (!dim->tired)
+			comp_dim_exit_parking(dim);
+		break;
+
+	case DIM_GOING_RIGHT:
+	case DIM_GOING_LEFT:
+		stats_res = comp_dim_stats_compare(curr_stats,
+						   &dim->prev_stats,
+						   latency_bias);
+		/* with a latency bias, less moderation for the same is a win */
+		if (stats_res == DIM_STATS_SAME && latency_bias)
+			stats_res = dim->tune_state == DIM_GOING_LEFT ?
+				    DIM_STATS_BETTER : DIM_STATS_WORSE;
+		if (stats_res != DIM_STATS_BETTER)
+			dim_turn(dim);
+
+		if (dim_on_top(dim)) {
+			dim_park_on_top(dim);
+			break;
+		}
+
+		step_res = comp_dim_step(dim);
+		switch (step_res) {
+		case DIM_ON_EDGE:
+			dim_park_on_top(dim);
+			break;
+		case DIM_TOO_TIRED:
+			dim_park_tired(dim);
+			break;
+		}
+
+		break;
+	}
+
+	if (prev_state != DIM_PARKING_ON_TOP ||
+	    dim->tune_state != DIM_PARKING_ON_TOP)
+		dim->prev_stats = *curr_stats;
+
+	return dim->profile_ix != prev_ix;
+}
+
+void comp_dim(struct dim *dim, struct dim_sample end_sample, bool latency_bias)
+{
+	struct dim_stats curr_stats;
+	u16 nevents;
+
+	switch (dim->state) {
+	case DIM_MEASURE_IN_PROGRESS:
+		nevents = BIT_GAP(BITS_PER_TYPE(u16),
+				  end_sample.event_ctr,
+				  dim->start_sample.event_ctr);
+		if (nevents < DIM_NEVENTS)
+			break;
+		if (!dim_calc_stats(&dim->start_sample, &end_sample, &curr_stats))
+			break;
+		if (comp_dim_decision(&curr_stats, dim, latency_bias)) {
+			dim->state = DIM_APPLY_NEW_PROFILE;
+			schedule_work(&dim->work);
+			break;
+		}
+		fallthrough;
+	case DIM_START_MEASURE:
+		dim_update_sample_with_comps(end_sample.event_ctr, 0,
+					     end_sample.byte_ctr,
+					     end_sample.comp_ctr,
+					     &dim->start_sample);
+		dim->state = DIM_MEASURE_IN_PROGRESS;
+		break;
+	case DIM_APPLY_NEW_PROFILE:
+		break;
+	}
+}
+EXPORT_SYMBOL(comp_dim);
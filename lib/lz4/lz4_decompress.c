@@ -50,6 +50,11 @@
 #define assert(condition) ((void)0)
 #endif
 
+/* Literal copy of the decoder, NEON instances override it */
+#ifndef LZ4_DEC_WILDCOPY
+#define LZ4_DEC_WILDCOPY LZ4_wildCopy
+#endif
+
 /*
  * LZ4_decompress_generic() :
  * This generic decompression function covers all use cases.
@@ -280,7 +285,7 @@ static FORCE_INLINE int LZ4_decompress_generic(
 				break;
 		} else {
 			/* may overwrite up to WILDCOPYLENGTH beyond cpy */
-			LZ4_wildCopy(op, ip, cpy);
+			LZ4_DEC_WILDCOPY(op, ip, cpy);
 			ip += length;
 			op = cpy;
 		}
@@ -402,6 +407,15 @@ static FORCE_INLINE int LZ4_decompress_generic(
 			continue;
 		}
 
+#ifdef LZ4_DEC_MATCHCOPY
+		/* may overwrite up to LZ4_DEC_MATCH_SAFEGUARD - 1 beyond cpy */
+		if (likely(offset && cpy <= oend - LZ4_DEC_MATCH_SAFEGUARD)) {
+			LZ4_DEC_MATCHCOPY(op, match, cpy, offset);
+			op = cpy;
+			continue;
+		}
+#endif
+
 		if (unlikely(offset < 8)) {
 			op[0] = match[0];
 			op[1] = match[1];
@@ -457,9 +471,51 @@ static FORCE_INLINE int LZ4_decompress_generic(
 	return (int) (-(((const char *)ip) - src)) - 1;
 }
 
+/* lz4_decompress_neon.c only needs the decoder above */
+#ifndef LZ4_DECOMPRESS_NEON
+
+#ifdef LZ4_NEON
+#include <asm/neon.h>
+#include <asm/simd.h>
+
+/* Blocks smaller than this don't make up for saving the FPSIMD state */
+#define LZ4_NEON_MIN_SIZE 1024
+
+static bool LZ4_neon __read_mostly = true;
+module_param_named(neon, LZ4_neon, bool, 0644);
+MODULE_PARM_DESC(neon, "Use NEON to decompress blocks of 1KiB or more");
+
+static bool LZ4_use_neon(int outputSize)
+{
+	return READ_ONCE(LZ4_neon) && outputSize >= LZ4_NEON_MIN_SIZE &&
+		may_use_simd();
+}
+
+int LZ4_decompress_safe_scalar(const char *source, char *dest,
+	int compressedSize, int maxDecompressedSize)
+{
+	return LZ4_decompress_generic(source, dest,
+				      compressedSize, maxDecompressedSize,
+				      endOnInputSize, decode_full_block,
+				      noDict, (BYTE *)dest, NULL, 0);
+}
+EXPORT_SYMBOL_GPL(LZ4_decompress_safe_scalar);
+#endif
+
 int LZ4_decompress_safe(const char *source, char *dest,
 	int compressedSize, int maxDecompressedSize)
 {
+#ifdef LZ4_NEON
+	if (LZ4_use_neon(maxDecompressedSize)) {
+		int ret;
+
+		kernel_neon_begin();
+		ret = LZ4_decompress_safe_neon(source, dest, compressedSize,
+					       maxDecompressedSize);
+		kernel_neon_end();
+		return ret;
+	}
+#endif
 	return LZ4_decompress_generic(source, dest,
 				      compressedSize, maxDecompressedSize,
 				      endOnInputSize, decode_full_block,
@@ -470,6 +526,17 @@ int LZ4_decompress_safe_partial(const char *src, char *dst,
 	int compressedSize, int targetOutputSize, int dstCapacity)
 {
 	dstCapacity = min(targetOutputSize, dstCapacity);
+#ifdef LZ4_NEON
+	if (LZ4_use_neon(dstCapacity)) {
+		int ret;
+
+		kernel_neon_begin();
+		ret = LZ4_decompress_safe_partial_neon(src, dst, compressedSize,
+						       dstCapacity);
+		kernel_neon_end();
+		return ret;
+	}
+#endif
 	return LZ4_decompress_generic(src, dst, compressedSize, dstCapacity,
 				      endOnInputSize, partial_decode,
 				      noDict, (BYTE *)dst, NULL, 0);
@@ -718,3 +785,5 @@ EXPORT_SYMBOL(LZ4_decompress_fast_usingDict);
 MODULE_LICENSE("Dual BSD/GPL");
 MODULE_DESCRIPTION("LZ4 decompressor");
 #endif
+
+#endif /* LZ4_DECOMPRESS_NEON */
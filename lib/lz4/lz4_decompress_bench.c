@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Benchmark of the NEON LZ4 decompressor against the generic one.
+ *
+ * Reading /sys/kernel/debug/lz4_decompress_bench compresses a small built-in
+ * corpus, shaped after what zram, erofs and squashfs usually hold, in 4KiB
+ * and 64KiB blocks, and reports the decompression speed of both decoders in
+ * MB/s.  The corpus is generated from a fixed seed, so runs are comparable
+ * across devices.
+ */
+#define pr_fmt(fmt) "lz4_bench: " fmt
+
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/lz4.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/prandom.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <asm/neon.h>
+#include <asm/simd.h>
+#include "lz4defs.h"
+
+#define LZ4_BENCH_SIZE		(256 * KB)
+#define LZ4_BENCH_NSEC		(100 * NSEC_PER_MSEC)
+
+static const unsigned int lz4_bench_blocks[] = { 4 * KB, 64 * KB };
+
+static const char *const lz4_bench_words[] = {
+	"the", "of", "and", "to", "in", "is", "that", "for", "it", "as",
+	"with", "was", "on", "be", "at", "by", "this", "had", "not", "are",
+	"kernel", "memory", "page", "buffer", "device", "driver", "return",
+	"struct", "unsigned", "long", "static", "const", "void", "int",
+};
+
+/* English-like text, as on most read-only filesystems */
+static void lz4_bench_text(u8 *buf, size_t size, struct rnd_state *rnd)
+{
+	size_t len = 0;
+	const char *w;
+
+	while (len < size) {
+		w = lz4_bench_words[prandom_u32_state(rnd) %
+				    ARRAY_SIZE(lz4_bench_words)];
+		while (*w && len < size)
+			buf[len++] = *w++;
+		if (len < size)
+			buf[len++] = prandom_u32_state(rnd) % 12 ? ' ' : '\n';
+	}
+}
+
+/* Mostly zeroed pages with a few counters and pointers, as in swap */
+static void lz4_bench_sparse(u8 *buf, size_t size, struct rnd_state *rnd)
+{
+	size_t i;
+
+	memset(buf, 0, size);
+	for (i = 0; i < size; i += 64)
+		if (!(prandom_u32_state(rnd) % 4))
+			put_unaligned(0xffff000000000000ull |
+				      prandom_u32_state(rnd), (u64 *)(buf + i));
+}
+
+/* Arrays of small records, full of matches closer than 16 bytes */
+static void lz4_bench_records(u8 *buf, size_t size, struct rnd_state *rnd)
+{
+	size_t i;
+	u32 v = 0;
+
+	for (i = 0; i + 12 <= size; i += 12) {
+		if (!(prandom_u32_state(rnd) % 8))
+			v = prandom_u32_state(rnd);
+		put_unaligned(v, (u32 *)(buf + i));
+		put_unaligned(i / 12 % 4, (u32 *)(buf + i + 4));
+		put_unaligned(0, (u32 *)(buf + i + 8));
+	}
+	memset(buf + i, 0, size - i);
+}
+
+/* Media-like data, barely compressible */
+static void lz4_bench_random(u8 *buf, size_t size, struct rnd_state *rnd)
+{
+	size_t i;
+
+	prandom_bytes_state(rnd, buf, size);
+	for (i = 0; i + 64 <= size; i += 256)
+		memcpy(buf + i, buf + i / 2, 64);
+}
+
+static const struct {
+	const char *name;
+	void (*fill)(u8 *buf, size_t size, struct rnd_state *rnd);
+} lz4_bench_corpus[] = {
+	{ "text", lz4_bench_text },
+	{ "sparse", lz4_bench_sparse },
+	{ "records", lz4_bench_records },
+	{ "random", lz4_bench_random },
+};
+
+struct lz4_bench_buf {
+	char *in;
+	char *out;
+	char *comp;
+	int *comp_len;
+	void *wrkmem;
+};
+
+static int lz4_bench_decompress(bool neon, struct lz4_bench_buf *b,
+				unsigned int block, unsigned int nr_blocks)
+{
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < nr_blocks; i++) {
+		const char *src = b->comp + i * LZ4_COMPRESSBOUND(block);
+		char *dst = b->out + i * block;
+
+		if (neon) {
+			kernel_neon_begin();
+			ret = LZ4_decompress_safe_neon(src, dst,
+						       b->comp_len[i], block);
+			kernel_neon_end();
+		} else {
+			ret = LZ4_decompress_safe_scalar(src, dst,
+							 b->comp_len[i], block);
+		}
+		if (ret != block)
+			return -EINVAL;
+	}
+	return 0;
+}
+
+/* Returns the speed of the decoder in MB/s, or a negative error */
+static long lz4_bench_run(bool neon, struct lz4_bench_buf *b,
+			  unsigned int block)
+{
+	unsigned int nr_blocks = LZ4_BENCH_SIZE / block;
+	u64 start, ns, bytes = 0;
+	int err;
+
+	start = ktime_get_ns();
+	do {
+		err = lz4_bench_decompress(neon, b, block, nr_blocks);
+		if (err)
+			return err;
+		bytes += LZ4_BENCH_SIZE;
+		cond_resched();
+		ns = ktime_get_ns() - start;
+	} while (ns < LZ4_BENCH_NSEC);
+
+	if (memcmp(b->in, b->out, LZ4_BENCH_SIZE))
+		return -EILSEQ;
+	return div64_u64(bytes * NSEC_PER_SEC / MB, ns);
+}
+
+static int lz4_bench_show(struct seq_file *s, void *unused)
+{
+	struct lz4_bench_buf b = {};
+	unsigned int i, j, k, block, comp, ratio;
+	long generic, neon;
+	struct rnd_state rnd;
+	int err = -ENOMEM;
+
+	if (!may_use_simd())
+		return -EOPNOTSUPP;
+
+	b.in = vmalloc(LZ4_BENCH_SIZE);
+	b.out = vmalloc(LZ4_BENCH_SIZE);
+	b.comp = vmalloc(LZ4_BENCH_SIZE / lz4_bench_blocks[0] *
+			 LZ4_COMPRESSBOUND(lz4_bench_blocks[0]));
+	b.comp_len = kcalloc(LZ4_BENCH_SIZE / lz4_bench_blocks[0],
+			     sizeof(*b.comp_len), GFP_KERNEL);
+	b.wrkmem = vmalloc(LZ4_MEM_COMPRESS);
+	if (!b.in || !b.out || !b.comp || !b.comp_len || !b.wrkmem)
+		goto out;
+
+	seq_puts(s, "corpus   block  ratio  generic_MBps  neon_MBps  speedup\n");
+	for (i = 0; i < ARRAY_SIZE(lz4_bench_corpus); i++) {
+		prandom_seed_state(&rnd, 42);
+		lz4_bench_corpus[i].fill((u8 *)b.in, LZ4_BENCH_SIZE, &rnd);
+
+		for (j = 0; j < ARRAY_SIZE(lz4_bench_blocks); j++) {
+			block = lz4_bench_blocks[j];
+			comp = 0;
+			for (k = 0; k < LZ4_BENCH_SIZE / block; k++) {
+				b.comp_len[k] = LZ4_compress_default(
+					b.in + k * block,
+					b.comp + k * LZ4_COMPRESSBOUND(block),
+					block, LZ4_COMPRESSBOUND(block),
+					b.wrkmem);
+				if (b.comp_len[k] <= 0) {
+					err = -EINVAL;
+					goto out;
+				}
+				comp += b.comp_len[k];
+			}
+
+			generic = lz4_bench_run(false, &b, block);
+			memset(b.out, 0, LZ4_BENCH_SIZE);
+			neon = lz4_bench_run(true, &b, block);
+			if (generic <= 0 || neon <= 0) {
+				err = generic <= 0 ? generic : neon;
+				pr_err("%s/%u: decompression failed: %d\n",
+				       lz4_bench_corpus[i].name, block, err);
+				goto out;
+			}
+
+			ratio = LZ4_BENCH_SIZE * 100 / comp;
+			seq_printf(s, "%-8s %5u  %2u.%02u  %12ld  %9ld  %3ld.%02ld\n",
+				   lz4_bench_corpus[i].name, block,
+				   ratio / 100, ratio % 100, generic, neon,
+				   neon / generic, neon * 100 / generic % 100);
+		}
+	}
+	err = 0;
+out:
+	vfree(b.wrkmem);
+	kfree(b.comp_len);
+	vfree(b.comp);
+	vfree(b.out);
+	vfree(b.in);
+	return err;
+}
+DEFINE_SHOW_ATTRIBUTE(lz4_bench);
+
+static struct dentry *lz4_bench_dentry;
+
+static int __init lz4_bench_init(void)
+{
+	lz4_bench_dentry = debugfs_create_file("lz4_decompress_bench", 0400,
+					       NULL, NULL, &lz4_bench_fops);
+	return 0;
+}
+module_init(lz4_bench_init);
+
+static void __exit lz4_bench_exit(void)
+{
+	debugfs_remove(lz4_bench_dentry);
+}
+module_exit(lz4_bench_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("LZ4 decompression benchmark, generic and NEON");
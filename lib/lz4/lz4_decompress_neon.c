@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * LZ4 decompressor instances for arm64 with NEON copies.
+ *
+ * This builds the decoder of lz4_decompress.c once more, copying literals
+ * and matches 16 bytes at a time through NEON registers.  Matches closer than
+ * 16 bytes, which overlap their own output, are expanded with table lookups
+ * instead of being copied 8 or even 1 byte at a time.
+ *
+ * Callers must wrap these in kernel_neon_begin() and kernel_neon_end(), which
+ * lz4_decompress.c does when NEON is usable.
+ */
+#include <asm/neon-intrinsics.h>
+#include "lz4defs.h"
+
+/*
+ * For a match at offset 1..15, lz4_neon_rep gives the indices that repeat its
+ * first offset bytes over 16 bytes, and lz4_neon_next the indices that turn
+ * such a pattern into the one for the following 16 bytes.
+ */
+static const u8 lz4_neon_rep[16][16] = {
+	[1] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+	[2] = { 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1 },
+	[3] = { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+	[4] = { 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3 },
+	[5] = { 0, 1, 2, 3, 4, 0, 1, 2, 3, 4, 0, 1, 2, 3, 4, 0 },
+	[6] = { 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3 },
+	[7] = { 0, 1, 2, 3, 4, 5, 6, 0, 1, 2, 3, 4, 5, 6, 0, 1 },
+	[8] = { 0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7 },
+	[9] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 0, 1, 2, 3, 4, 5, 6 },
+	[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5 },
+	[11] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0, 1, 2, 3, 4 },
+	[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3 },
+	[13] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 0, 1, 2 },
+	[14] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 0, 1 },
+	[15] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 0 },
+};
+
+static const u8 lz4_neon_next[16][16] = {
+	[1] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+	[2] = { 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1 },
+	[3] = { 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1 },
+	[4] = { 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3 },
+	[5] = { 1, 2, 3, 4, 0, 1, 2, 3, 4, 0, 1, 2, 3, 4, 0, 1 },
+	[6] = { 4, 5, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 0, 1 },
+	[7] = { 2, 3, 4, 5, 6, 0, 1, 2, 3, 4, 5, 6, 0, 1, 2, 3 },
+	[8] = { 0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7 },
+	[9] = { 7, 8, 0, 1, 2, 3, 4, 5, 6, 7, 8, 0, 1, 2, 3, 4 },
+	[10] = { 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1 },
+	[11] = { 5, 6, 7, 8, 9, 10, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 },
+	[12] = { 4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3, 4, 5, 6, 7 },
+	[13] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 0, 1, 2, 3, 4, 5 },
+	[14] = { 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 0, 1, 2, 3 },
+	[15] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 0, 1 },
+};
+
+/*
+ * Same as LZ4_wildCopy(), and also may write up to 7 bytes beyond dstEnd:
+ * the last 16-byte copy is only done if it ends less than 8 bytes beyond it.
+ */
+static FORCE_INLINE void LZ4_wildCopy_neon(void *dstPtr,
+	const void *srcPtr, void *dstEnd)
+{
+	BYTE *d = (BYTE *)dstPtr;
+	const BYTE *s = (const BYTE *)srcPtr;
+	BYTE *const e = (BYTE *)dstEnd;
+
+	while (d + 8 < e) {
+		vst1q_u8(d, vld1q_u8(s));
+		d += 16;
+		s += 16;
+	}
+	if (d < e)
+		LZ4_copy8(d, s);
+}
+
+/*
+ * Copy the match at @offset (not 0) before @op up to @end, writing up to 15
+ * bytes beyond @end.  This may read up to 15 bytes beyond @match too, which
+ * is not beyond @end as the match starts before @op.
+ */
+static FORCE_INLINE void LZ4_matchCopy_neon(BYTE *op, const BYTE *match,
+	BYTE *end, size_t offset)
+{
+	uint8x16_t v, next;
+
+	if (offset >= 16) {
+		do {
+			vst1q_u8(op, vld1q_u8(match));
+			op += 16;
+			match += 16;
+		} while (op < end);
+		return;
+	}
+
+	v = vqtbl1q_u8(vld1q_u8(match), vld1q_u8(lz4_neon_rep[offset]));
+	next = vld1q_u8(lz4_neon_next[offset]);
+	do {
+		vst1q_u8(op, v);
+		v = vqtbl1q_u8(v, next);
+		op += 16;
+	} while (op < end);
+}
+
+#define LZ4_DEC_WILDCOPY	LZ4_wildCopy_neon
+#define LZ4_DEC_MATCHCOPY	LZ4_matchCopy_neon
+#define LZ4_DEC_MATCH_SAFEGUARD	16
+#define LZ4_DECOMPRESS_NEON
+#include "lz4_decompress.c"
+
+int LZ4_decompress_safe_neon(const char *source, char *dest,
+	int compressedSize, int maxDecompressedSize)
+{
+	return LZ4_decompress_generic(source, dest,
+				      compressedSize, maxDecompressedSize,
+				      endOnInputSize, decode_full_block,
+				      noDict, (BYTE *)dest, NULL, 0);
+}
+EXPORT_SYMBOL_GPL(LZ4_decompress_safe_neon);
+
+int LZ4_decompress_safe_partial_neon(const char *src, char *dst,
+	int compressedSize, int dstCapacity)
+{
+	return LZ4_decompress_generic(src, dst, compressedSize, dstCapacity,
+				      endOnInputSize, partial_decode,
+				      noDict, (BYTE *)dst, NULL, 0);
+}
+EXPORT_SYMBOL_GPL(LZ4_decompress_safe_partial_neon);
+
+MODULE_LICENSE("Dual BSD/GPL");
+MODULE_DESCRIPTION("LZ4 decompressor, arm64 NEON instances");
@@ -244,4 +244,18 @@ typedef enum { decode_full_block = 0, partial_decode = 1 } earlyEnd_directive;
 
 #define LZ4_STATIC_ASSERT(c)	BUILD_BUG_ON(!(c))
 
+#if defined(CONFIG_ARM64) && defined(CONFIG_KERNEL_MODE_NEON) && !defined(STATIC)
+#define LZ4_NEON 1
+
+/* lz4_decompress_neon.c, to be called between kernel_neon_begin() and end */
+int LZ4_decompress_safe_neon(const char *source, char *dest,
+	int compressedSize, int maxDecompressedSize);
+int LZ4_decompress_safe_partial_neon(const char *src, char *dst,
+	int compressedSize, int dstCapacity);
+
+/* LZ4_decompress_safe() without NEON, for lz4_decompress_bench.c */
+int LZ4_decompress_safe_scalar(const char *source, char *dest,
+	int compressedSize, int maxDecompressedSize);
+#endif
+
 #endif
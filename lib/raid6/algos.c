@@ -67,6 +67,11 @@ const struct raid6_calls * const raid6_algos[] = {
 #if defined(CONFIG_S390)
 	&raid6_s390vx8,
 #endif
+#ifdef CONFIG_RAID6_SVE
+	&raid6_svex4,
+	&raid6_svex2,
+	&raid6_svex1,
+#endif
 #ifdef CONFIG_KERNEL_MODE_NEON
 	&raid6_neonx8,
 	&raid6_neonx4,
@@ -105,6 +110,9 @@ const struct raid6_recov_calls *const raid6_recov_algos[] = {
 #ifdef CONFIG_S390
 	&raid6_recov_s390xc,
 #endif
+#ifdef CONFIG_RAID6_SVE
+	&raid6_recov_sve,
+#endif
 #if defined(CONFIG_KERNEL_MODE_NEON)
 	&raid6_recov_neon,
 #endif
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Based on recov_neon_inner.c:
+ *   Copyright (C) 2012 Intel Corporation
+ *   Copyright (C) 2017 Linaro Ltd. <ard.biesheuvel@linaro.org>
+ */
+
+#include <arm_sve.h>
+#include "sve.h"
+
+/*
+ * The multiplication tables are 16 bytes for each nibble.  svld1rq_u8()
+ * replicates them in each 128-bit segment, and as the indices are below 16,
+ * svtbl_u8() then looks them up in the first segment whatever the vector
+ * length.
+ */
+static inline svuint8_t gf_mul(svbool_t pg, svuint8_t v, svuint8_t m0,
+			       svuint8_t m1)
+{
+	svuint8_t lo = svand_n_u8_x(pg, v, 0x0f);
+	svuint8_t hi = svlsr_n_u8_x(pg, v, 4);
+
+	return sveor_u8_x(pg, svtbl_u8(m0, lo), svtbl_u8(m1, hi));
+}
+
+void __raid6_2data_recov_sve(int bytes, uint8_t *p, uint8_t *q, uint8_t *dp,
+			     uint8_t *dq, const uint8_t *pbmul,
+			     const uint8_t *qmul)
+{
+	svbool_t all = svptrue_b8();
+	svuint8_t pm0 = svld1rq_u8(all, pbmul);
+	svuint8_t pm1 = svld1rq_u8(all, pbmul + 16);
+	svuint8_t qm0 = svld1rq_u8(all, qmul);
+	svuint8_t qm1 = svld1rq_u8(all, qmul + 16);
+	int i;
+
+	/*
+	 * while ( bytes-- ) {
+	 *	uint8_t px, qx, db;
+	 *
+	 *	px    = *p ^ *dp;
+	 *	qx    = qmul[*q ^ *dq];
+	 *	*dq++ = db = pbmul[px] ^ qx;
+	 *	*dp++ = db ^ px;
+	 *	p++; q++;
+	 * }
+	 */
+
+	for (i = 0; i < bytes; i += svcntb()) {
+		svbool_t pg = svwhilelt_b8_s32(i, bytes);
+		svuint8_t px, qx, db;
+
+		px = sveor_u8_x(pg, svld1_u8(pg, p + i), svld1_u8(pg, dp + i));
+		qx = sveor_u8_x(pg, svld1_u8(pg, q + i), svld1_u8(pg, dq + i));
+
+		qx = gf_mul(pg, qx, qm0, qm1);
+		db = sveor_u8_x(pg, gf_mul(pg, px, pm0, pm1), qx);
+
+		svst1_u8(pg, dq + i, db);
+		svst1_u8(pg, dp + i, sveor_u8_x(pg, db, px));
+	}
+}
+
+void __raid6_datap_recov_sve(int bytes, uint8_t *p, uint8_t *q, uint8_t *dq,
+			     const uint8_t *qmul)
+{
+	svbool_t all = svptrue_b8();
+	svuint8_t qm0 = svld1rq_u8(all, qmul);
+	svuint8_t qm1 = svld1rq_u8(all, qmul + 16);
+	int i;
+
+	/*
+	 * while (bytes--) {
+	 *	*p++ ^= *dq = qmul[*q ^ *dq];
+	 *	q++; dq++;
+	 * }
+	 */
+
+	for (i = 0; i < bytes; i += svcntb()) {
+		svbool_t pg = svwhilelt_b8_s32(i, bytes);
+		svuint8_t vx;
+
+		vx = sveor_u8_x(pg, svld1_u8(pg, q + i), svld1_u8(pg, dq + i));
+		vx = gf_mul(pg, vx, qm0, qm1);
+
+		svst1_u8(pg, dq + i, vx);
+		svst1_u8(pg, p + i, sveor_u8_x(pg, vx, svld1_u8(pg, p + i)));
+	}
+}
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * linux/lib/raid6/sve.c - RAID6 syndrome calculation using ARM SVE intrinsics
+ *
+ * Based on neon.c, Copyright (C) 2013 Linaro Ltd <ard.biesheuvel@linaro.org>
+ */
+
+#include <linux/raid/pq.h>
+
+#ifdef __KERNEL__
+#include <linux/bottom_half.h>
+#include <asm/cpufeature.h>
+#include <asm/fpsimd.h>
+#include <asm/neon.h>
+#include <asm/sysreg.h>
+#else
+#include <sys/auxv.h>
+#define kernel_neon_begin()
+#define kernel_neon_end()
+#define local_bh_disable()
+#define local_bh_enable()
+#define system_supports_sve()	(getauxval(AT_HWCAP) & HWCAP_SVE)
+#endif
+#include "sve.h"
+
+/*
+ * As for NEON, the wrappers are kept apart from the actual implementations
+ * in sveN.c (generated from sve.uc by unroll.awk), which are the only code
+ * built with SVE enabled.
+ */
+
+int raid6_have_sve(void)
+{
+	/* see raid6_sve_begin() */
+#ifdef CONFIG_PREEMPT_RT
+	return 0;
+#else
+	return system_supports_sve();
+#endif
+}
+
+/*
+ * The kernel mode NEON state that is saved on preemption, or when a softirq
+ * uses NEON in turn, is only the FPSIMD view of the registers: the upper
+ * bits of the Z registers and the P registers would be lost.  So keep both
+ * out while the SVE code runs, which is why SVE is not used on PREEMPT_RT.
+ *
+ * The vector length is whatever the last task loaded, so also use the
+ * largest one while at it: the user state has been saved, and the length
+ * of the task is set again when its state is loaded back.
+ */
+void raid6_sve_begin(void)
+{
+	kernel_neon_begin();
+	local_bh_disable();
+#ifdef __KERNEL__
+	sve_cond_update_zcr_vq(sve_vq_from_vl(sve_max_vl()) - 1, SYS_ZCR_EL1);
+#endif
+}
+
+void raid6_sve_end(void)
+{
+	local_bh_enable();
+	kernel_neon_end();
+}
+
+#define RAID6_SVE_WRAPPER(_n)						\
+	static void raid6_sve ## _n ## _gen_syndrome(int disks,		\
+					size_t bytes, void **ptrs)	\
+	{								\
+		raid6_sve_begin();					\
+		raid6_sve ## _n ## _gen_syndrome_real(disks,		\
+					(unsigned long)bytes, ptrs);	\
+		raid6_sve_end();					\
+	}								\
+	static void raid6_sve ## _n ## _xor_syndrome(int disks,		\
+					int start, int stop,		\
+					size_t bytes, void **ptrs)	\
+	{								\
+		raid6_sve_begin();					\
+		raid6_sve ## _n ## _xor_syndrome_real(disks,		\
+			start, stop, (unsigned long)bytes, ptrs);	\
+		raid6_sve_end();					\
+	}								\
+	struct raid6_calls const raid6_svex ## _n = {			\
+		raid6_sve ## _n ## _gen_syndrome,			\
+		raid6_sve ## _n ## _xor_syndrome,			\
+		raid6_have_sve,						\
+		"svex" #_n,						\
+		0							\
+	}
+
+RAID6_SVE_WRAPPER(1);
+RAID6_SVE_WRAPPER(2);
+RAID6_SVE_WRAPPER(4);
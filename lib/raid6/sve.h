@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+void raid6_sve1_gen_syndrome_real(int disks, unsigned long bytes, void **ptrs);
+void raid6_sve1_xor_syndrome_real(int disks, int start, int stop,
+				  unsigned long bytes, void **ptrs);
+void raid6_sve2_gen_syndrome_real(int disks, unsigned long bytes, void **ptrs);
+void raid6_sve2_xor_syndrome_real(int disks, int start, int stop,
+				  unsigned long bytes, void **ptrs);
+void raid6_sve4_gen_syndrome_real(int disks, unsigned long bytes, void **ptrs);
+void raid6_sve4_xor_syndrome_real(int disks, int start, int stop,
+				  unsigned long bytes, void **ptrs);
+void __raid6_2data_recov_sve(int bytes, uint8_t *p, uint8_t *q, uint8_t *dp,
+			     uint8_t *dq, const uint8_t *pbmul,
+			     const uint8_t *qmul);
+
+void __raid6_datap_recov_sve(int bytes, uint8_t *p, uint8_t *q, uint8_t *dq,
+			     const uint8_t *qmul);
+
+int raid6_have_sve(void);
+void raid6_sve_begin(void);
+void raid6_sve_end(void);
@@ -0,0 +1,114 @@
+/* -----------------------------------------------------------------------
+ *
+ *   sve.uc - RAID-6 syndrome calculation using ARM SVE instructions
+ *
+ *   Based on neon.uc:
+ *     Copyright (C) 2012 Rob Herring
+ *     Copyright (C) 2015 Linaro Ltd. <ard.biesheuvel@linaro.org>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, Inc., 53 Temple Place Ste 330,
+ *   Boston MA 02111-1307, USA; either version 2 of the License, or
+ *   (at your option) any later version; incorporated herein by reference.
+ *
+ * ----------------------------------------------------------------------- */
+
+/*
+ * sve$#.c
+ *
+ * $#-way unrolled SVE intrinsics math RAID-6 instruction set
+ *
+ * The code is vector length agnostic: each step handles svcntb() bytes,
+ * whatever the implementation provides, and the last partial vector of
+ * the block, if any, is handled by the governing predicates.
+ *
+ * This file is postprocessed using unroll.awk
+ */
+
+#include <arm_sve.h>
+#include "sve.h"
+
+typedef svuint8_t unative_t;
+
+/*
+ * Multiply each byte by 2 in GF(2^8): shift it left by 1 and reduce by
+ * the polynomial where the high bit was set.
+ */
+static inline unative_t MUL2(svbool_t pg, unative_t v, unative_t x1d)
+{
+	svbool_t hi = svcmplt_n_s8(pg, svreinterpret_s8_u8(v), 0);
+
+	v = svadd_u8_x(pg, v, v);
+	return sveor_u8_m(hi, v, x1d);
+}
+
+void raid6_sve$#_gen_syndrome_real(int disks, unsigned long bytes, void **ptrs)
+{
+	uint8_t **dptr = (uint8_t **)ptrs;
+	const unsigned long nsize = svcntb();
+	uint8_t *p, *q;
+	unsigned long d;
+	int z, z0;
+
+	svbool_t pg$$;
+	unative_t wd$$, wq$$, wp$$;
+	const unative_t x1d = svdup_n_u8(0x1d);
+
+	z0 = disks - 3;		/* Highest data disk */
+	p = dptr[z0+1];		/* XOR parity */
+	q = dptr[z0+2];		/* RS syndrome */
+
+	for ( d = 0 ; d < bytes ; d += nsize*$# ) {
+		pg$$ = svwhilelt_b8_u64(d+$$*nsize, bytes);
+		wq$$ = wp$$ = svld1_u8(pg$$, &dptr[z0][d+$$*nsize]);
+		for ( z = z0-1 ; z >= 0 ; z-- ) {
+			wd$$ = svld1_u8(pg$$, &dptr[z][d+$$*nsize]);
+			wp$$ = sveor_u8_x(pg$$, wp$$, wd$$);
+			wq$$ = MUL2(pg$$, wq$$, x1d);
+			wq$$ = sveor_u8_x(pg$$, wq$$, wd$$);
+		}
+		svst1_u8(pg$$, &p[d+$$*nsize], wp$$);
+		svst1_u8(pg$$, &q[d+$$*nsize], wq$$);
+	}
+}
+
+void raid6_sve$#_xor_syndrome_real(int disks, int start, int stop,
+				   unsigned long bytes, void **ptrs)
+{
+	uint8_t **dptr = (uint8_t **)ptrs;
+	const unsigned long nsize = svcntb();
+	uint8_t *p, *q;
+	unsigned long d;
+	int z, z0;
+
+	svbool_t pg$$;
+	unative_t wd$$, wq$$, wp$$;
+	const unative_t x1d = svdup_n_u8(0x1d);
+
+	z0 = stop;		/* P/Q right side optimization */
+	p = dptr[disks-2];	/* XOR parity */
+	q = dptr[disks-1];	/* RS syndrome */
+
+	for ( d = 0 ; d < bytes ; d += nsize*$# ) {
+		pg$$ = svwhilelt_b8_u64(d+$$*nsize, bytes);
+		wq$$ = svld1_u8(pg$$, &dptr[z0][d+$$*nsize]);
+		wp$$ = sveor_u8_x(pg$$, svld1_u8(pg$$, &p[d+$$*nsize]), wq$$);
+
+		/* P/Q data pages */
+		for ( z = z0-1 ; z >= start ; z-- ) {
+			wd$$ = svld1_u8(pg$$, &dptr[z][d+$$*nsize]);
+			wp$$ = sveor_u8_x(pg$$, wp$$, wd$$);
+			wq$$ = MUL2(pg$$, wq$$, x1d);
+			wq$$ = sveor_u8_x(pg$$, wq$$, wd$$);
+		}
+		/* P/Q left side optimization */
+		for ( z = start-1 ; z >= 0 ; z-- ) {
+			wq$$ = MUL2(pg$$, wq$$, x1d);
+		}
+		wq$$ = sveor_u8_x(pg$$, wq$$, svld1_u8(pg$$, &q[d+$$*nsize]));
+
+		svst1_u8(pg$$, &p[d+$$*nsize], wp$$);
+		svst1_u8(pg$$, &q[d+$$*nsize], wq$$);
+	}
+}
@@ -358,8 +358,14 @@ static bool dict_repeat(struct dictionary *dict, uint32_t *len, uint32_t dist)
 	*len -= left;
 
 	back = dict->pos - dist - 1;
-	if (dist >= dict->pos)
+	if (dist >= dict->pos) {
 		back += dict->end;
+	} else if (left <= dist + 1) {
+		/* The source neither wraps nor overlaps the destination. */
+		memcpy(dict->buf + dict->pos, dict->buf + back, left);
+		dict->pos += left;
+		goto out;
+	}
 
 	do {
 		dict->buf[dict->pos++] = dict->buf[back++];
@@ -367,6 +373,7 @@ static bool dict_repeat(struct dictionary *dict, uint32_t *len, uint32_t dist)
 			back = 0;
 	} while (--left > 0);
 
+out:
 	if (dict->full < dict->pos)
 		dict->full = dict->pos;
 
@@ -546,53 +553,110 @@ static __always_inline int rc_bit(struct rc_dec *rc, uint16_t *prob)
 	return bit;
 }
 
+/*
+ * Decode one bit like rc_bit(), but for the bits that only go into the
+ * value being decoded: the bits in a bittree are close to random, so
+ * computing both outcomes with masks instead of branching on the bit
+ * avoids a misprediction on about every other bit.
+ *
+ * With mask = 0 - bit, the updates of rc_bit() become
+ *     range = bound + ((range - 2 * bound) & mask)
+ *     code -= bound & mask
+ * and, since (RC_BIT_MODEL_TOTAL - p) >> RC_MOVE_BITS rounds p / 32 up
+ * where p >> RC_MOVE_BITS rounds it down,
+ *     p += (64 & ~mask) - ((p + (31 & ~mask)) >> RC_MOVE_BITS)
+ */
+static __always_inline uint32_t rc_bit_branchless(struct rc_dec *rc,
+						  uint16_t *prob)
+{
+	uint32_t p = *prob;
+	uint32_t bound;
+	uint32_t mask;
+	uint32_t bit;
+
+	rc_normalize(rc);
+	bound = (rc->range >> RC_BIT_MODEL_TOTAL_BITS) * p;
+	bit = rc->code >= bound;
+	mask = (uint32_t)0 - bit;
+
+	rc->range = bound + ((rc->range - bound - bound) & mask);
+	rc->code -= bound & mask;
+	*prob = p + ((RC_BIT_MODEL_TOTAL >> RC_MOVE_BITS) & ~mask)
+		- ((p + (((1 << RC_MOVE_BITS) - 1) & ~mask)) >> RC_MOVE_BITS);
+
+	return bit;
+}
+
+/*
+ * The bittree functions below work on a copy of the range decoder: the
+ * kernel is built with -fno-strict-aliasing, so each store to a probability
+ * would otherwise force range and code to be reloaded from memory.
+ */
+
 /* Decode a bittree starting from the most significant bit. */
 static __always_inline uint32_t rc_bittree(struct rc_dec *rc,
 					   uint16_t *probs, uint32_t limit)
 {
+	struct rc_dec r = *rc;
 	uint32_t symbol = 1;
 
 	do {
-		if (rc_bit(rc, &probs[symbol]))
-			symbol = (symbol << 1) + 1;
-		else
-			symbol <<= 1;
+		symbol = (symbol << 1) + rc_bit_branchless(&r, &probs[symbol]);
 	} while (symbol < limit);
 
+	*rc = r;
 	return symbol;
 }
 
+/* Decode a bittree of a constant number of bits, fully unrolled */
+#define __rc_bittree_step(i, rc, probs, symbol) \
+	symbol = (symbol << 1) + rc_bit_branchless(rc, &(probs)[symbol]);
+
+#define rc_bittree_unrolled(rc, probs, bits)				\
+({									\
+	struct rc_dec __r = *(rc);					\
+	uint32_t __symbol = 1;						\
+									\
+	UNROLL(bits, __rc_bittree_step, &__r, probs, __symbol)		\
+	*(rc) = __r;							\
+	__symbol;							\
+})
+
 /* Decode a bittree starting from the least significant bit. */
 static __always_inline void rc_bittree_reverse(struct rc_dec *rc,
 					       uint16_t *probs,
 					       uint32_t *dest, uint32_t limit)
 {
+	struct rc_dec r = *rc;
 	uint32_t symbol = 1;
+	uint32_t bit;
 	uint32_t i = 0;
 
 	do {
-		if (rc_bit(rc, &probs[symbol])) {
-			symbol = (symbol << 1) + 1;
-			*dest += 1 << i;
-		} else {
-			symbol <<= 1;
-		}
+		bit = rc_bit_branchless(&r, &probs[symbol]);
+		symbol = (symbol << 1) + bit;
+		*dest += bit << i;
 	} while (++i < limit);
+
+	*rc = r;
 }
 
 /* Decode direct bits (fixed fifty-fifty probability) */
 static inline void rc_direct(struct rc_dec *rc, uint32_t *dest, uint32_t limit)
 {
+	struct rc_dec r = *rc;
 	uint32_t mask;
 
 	do {
-		rc_normalize(rc);
-		rc->range >>= 1;
-		rc->code -= rc->range;
-		mask = (uint32_t)0 - (rc->code >> 31);
-		rc->code += rc->range & mask;
+		rc_normalize(&r);
+		r.range >>= 1;
+		r.code -= r.range;
+		mask = (uint32_t)0 - (r.code >> 31);
+		r.code += r.range & mask;
 		*dest = (*dest << 1) + (mask + 1);
 	} while (--limit > 0);
+
+	*rc = r;
 }
 
 /********
@@ -611,18 +675,21 @@ static uint16_t *lzma_literal_probs(struct xz_dec_lzma2 *s)
 /* Decode a literal (one 8-bit byte) */
 static void lzma_literal(struct xz_dec_lzma2 *s)
 {
+	struct rc_dec rc;
 	uint16_t *probs;
 	uint32_t symbol;
 	uint32_t match_byte;
 	uint32_t match_bit;
 	uint32_t offset;
+	uint32_t bit;
 	uint32_t i;
 
 	probs = lzma_literal_probs(s);
 
 	if (lzma_state_is_literal(s->lzma.state)) {
-		symbol = rc_bittree(&s->rc, probs, 0x100);
+		symbol = rc_bittree_unrolled(&s->rc, probs, 8);
 	} else {
+		rc = s->rc;
 		symbol = 1;
 		match_byte = dict_get(&s->dict, s->lzma.rep0) << 1;
 		offset = 0x100;
@@ -632,14 +699,12 @@ static void lzma_literal(struct xz_dec_lzma2 *s)
 			match_byte <<= 1;
 			i = offset + match_bit + symbol;
 
-			if (rc_bit(&s->rc, &probs[i])) {
-				symbol = (symbol << 1) + 1;
-				offset &= match_bit;
-			} else {
-				symbol <<= 1;
-				offset &= ~match_bit;
-			}
+			bit = rc_bit_branchless(&rc, &probs[i]);
+			symbol = (symbol << 1) + bit;
+			/* keep offset if the bits match, else clear it */
+			offset &= match_bit ^ (bit - 1);
 		} while (symbol < 0x100);
+		s->rc = rc;
 	}
 
 	dict_put(&s->dict, (uint8_t)symbol);
@@ -689,7 +754,8 @@ static void lzma_match(struct xz_dec_lzma2 *s, uint32_t pos_state)
 	lzma_len(s, &s->lzma.match_len_dec, pos_state);
 
 	probs = s->lzma.dist_slot[lzma_get_dist_state(s->lzma.len)];
-	dist_slot = rc_bittree(&s->rc, probs, DIST_SLOTS) - DIST_SLOTS;
+	dist_slot = rc_bittree_unrolled(&s->rc, probs, DIST_SLOT_BITS)
+			- DIST_SLOTS;
 
 	if (dist_slot < DIST_MODEL_START) {
 		s->lzma.rep0 = dist_slot;
@@ -11,6 +11,8 @@
 #include <linux/fs.h>
 #include <linux/uaccess.h>
 #include <linux/crc32.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
 #include <linux/xz.h>
 
 /* Maximum supported dictionary size */
@@ -60,6 +62,14 @@ static struct xz_buf buffers = {
  */
 static uint32_t crc;
 
+/*
+ * Time spent in xz_dec_run() and the amount of data it produced, to report
+ * the decoding speed at the end of the Stream. Copying the input from the
+ * userspace and calculating the CRC32 aren't included.
+ */
+static u64 decode_ns;
+static u64 decode_bytes;
+
 static int xz_dec_test_open(struct inode *i, struct file *f)
 {
 	if (device_is_open)
@@ -70,6 +80,8 @@ static int xz_dec_test_open(struct inode *i, struct file *f)
 	xz_dec_reset(state);
 	ret = XZ_OK;
 	crc = 0xFFFFFFFF;
+	decode_ns = 0;
+	decode_bytes = 0;
 
 	buffers.in_pos = 0;
 	buffers.in_size = 0;
@@ -102,6 +114,7 @@ static ssize_t xz_dec_test_write(struct file *file, const char __user *buf,
 				 size_t size, loff_t *pos)
 {
 	size_t remaining;
+	u64 start;
 
 	if (ret != XZ_OK) {
 		if (size > 0)
@@ -129,7 +142,10 @@ static ssize_t xz_dec_test_write(struct file *file, const char __user *buf,
 		}
 
 		buffers.out_pos = 0;
+		start = ktime_get_ns();
 		ret = xz_dec_run(state, &buffers);
+		decode_ns += ktime_get_ns() - start;
+		decode_bytes += buffers.out_pos;
 		crc = crc32(crc, buffer_out, buffers.out_pos);
 	}
 
@@ -141,6 +157,11 @@ static ssize_t xz_dec_test_write(struct file *file, const char __user *buf,
 	case XZ_STREAM_END:
 		printk(KERN_INFO DEVICE_NAME ": XZ_STREAM_END, "
 				"CRC32 = 0x%08X\n", ~crc);
+		printk(KERN_INFO DEVICE_NAME ": decoded %llu bytes in "
+				"%llu us, %llu KiB/s\n", decode_bytes,
+				div_u64(decode_ns, NSEC_PER_USEC),
+				div64_u64(decode_bytes * NSEC_PER_SEC / 1024,
+					  decode_ns ?: 1));
 		return size - remaining - (buffers.in_size - buffers.in_pos);
 
 	case XZ_MEMLIMIT_ERROR:
@@ -13,6 +13,7 @@
 #	include <linux/xz.h>
 #	include <linux/kernel.h>
 #	include <linux/unaligned.h>
+#	include <linux/unroll.h>
 	/* XZ_PREBOOT may be defined only via decompress_unxz.c. */
 #	ifndef XZ_PREBOOT
 #		include <linux/slab.h>
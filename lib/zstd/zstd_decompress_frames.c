@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0+ OR BSD-3-Clause
+/*
+ * Parallel decompression of runs of independent zstd frames, as written by
+ * pzstd or by zstd with a fixed frame size.  Frames do not reference each
+ * other, so each one is decompressed on its own by an unbound worker, and
+ * passed on in order from the caller's context.
+ */
+
+#include <linux/completion.h>
+#include <linux/cpumask.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+#include <linux/zstd.h>
+
+/* Frames in flight, at most, and the largest frame decompressed this way */
+#define ZSTD_FRAMES_MAX_SLOTS	16
+#define ZSTD_FRAMES_MAX_CONTENT	(32 << 20)
+
+struct zstd_frame_slot {
+	struct work_struct work;
+	struct completion done;
+	void *workspace;
+	size_t workspace_size;
+	const void *src;
+	size_t src_size;
+	void *dst;
+	size_t dst_size;
+	size_t ret;
+};
+
+static void zstd_frame_work(struct work_struct *work)
+{
+	struct zstd_frame_slot *slot =
+		container_of(work, struct zstd_frame_slot, work);
+	zstd_dctx *dctx;
+
+	dctx = zstd_init_dctx(slot->workspace, slot->workspace_size);
+	if (!dctx)
+		slot->ret = -ZSTD_error_memory_allocation;
+	else
+		slot->ret = zstd_decompress_dctx(dctx, slot->dst,
+				slot->dst_size, slot->src, slot->src_size);
+	complete(&slot->done);
+}
+
+/*
+ * Find the end of the run of frames at @src, and whether all of them fit:
+ * returns the number of frames with content, or 0 if there is any frame of
+ * unknown or too large content size.
+ */
+static unsigned int zstd_frames_scan(const u8 *src, size_t src_size,
+		size_t *run_size)
+{
+	zstd_frame_header header;
+	unsigned int nr = 0;
+	size_t pos = 0, size;
+
+	while (pos < src_size) {
+		if (zstd_get_frame_header(&header, src + pos, src_size - pos))
+			break;
+		size = zstd_find_frame_compressed_size(src + pos,
+				src_size - pos);
+		if (zstd_is_error(size))
+			break;
+		if (header.frameType == ZSTD_frame) {
+			if (header.frameContentSize > ZSTD_FRAMES_MAX_CONTENT)
+				return 0;
+			nr++;
+		}
+		pos += size;
+	}
+	*run_size = pos;
+	return nr;
+}
+
+/* Queue the next frame with content, if any, returning where it ends */
+static size_t zstd_frames_queue(struct zstd_frame_slot *slot, const u8 *src,
+		size_t pos, size_t end)
+{
+	zstd_frame_header header;
+	size_t size;
+
+	while (pos < end) {
+		zstd_get_frame_header(&header, src + pos, end - pos);
+		size = zstd_find_frame_compressed_size(src + pos, end - pos);
+		if (header.frameType == ZSTD_frame)
+			break;
+		pos += size;
+	}
+	if (pos == end)
+		return end;
+
+	slot->src = src + pos;
+	slot->src_size = size;
+	slot->dst_size = header.frameContentSize;
+	slot->dst = kvmalloc(slot->dst_size ?: 1, GFP_KERNEL);
+	if (!slot->dst) {
+		slot->ret = -ZSTD_error_memory_allocation;
+		complete(&slot->done);
+	} else {
+		queue_work(system_unbound_wq, &slot->work);
+	}
+	return pos + size;
+}
+
+int zstd_decompress_frames(const void *src, size_t src_size,
+	int (*flush)(void *priv, void *buf, size_t len), void *priv,
+	size_t *consumed)
+{
+	size_t run_size, pos = 0, workspace_size = zstd_dctx_workspace_bound();
+	struct zstd_frame_slot *slots, *slot;
+	unsigned int nr_frames, nr_slots, i;
+	int err = 0;
+
+	nr_frames = zstd_frames_scan(src, src_size, &run_size);
+	if (nr_frames < 2)
+		return -EOPNOTSUPP;
+
+	nr_slots = min3(nr_frames, num_online_cpus() + 1,
+			(unsigned int)ZSTD_FRAMES_MAX_SLOTS);
+	slots = kcalloc(nr_slots, sizeof(*slots), GFP_KERNEL);
+	if (!slots)
+		return -ENOMEM;
+	for (i = 0; i < nr_slots; i++) {
+		slot = &slots[i];
+		INIT_WORK(&slot->work, zstd_frame_work);
+		init_completion(&slot->done);
+		slot->workspace_size = workspace_size;
+		slot->workspace = kvmalloc(workspace_size, GFP_KERNEL);
+		if (!slot->workspace) {
+			err = -ENOMEM;
+			goto out;
+		}
+	}
+
+	for (i = 0; i < nr_slots; i++)
+		pos = zstd_frames_queue(&slots[i], src, pos, run_size);
+
+	/* Frame n goes in slot n % nr_slots, once frame n - nr_slots is out */
+	for (i = 0; i < nr_frames; i++) {
+		slot = &slots[i % nr_slots];
+		wait_for_completion(&slot->done);
+		reinit_completion(&slot->done);
+
+		if (!err && zstd_is_error(slot->ret))
+			err = -EINVAL;
+		if (!err && slot->ret != slot->dst_size)
+			err = -EINVAL;
+		if (!err)
+			err = flush(priv, slot->dst, slot->dst_size);
+		kvfree(slot->dst);
+		slot->dst = NULL;
+
+		/* on errors, only wait for the frames already queued */
+		if (!err)
+			pos = zstd_frames_queue(slot, src, pos, run_size);
+		else
+			nr_frames = min(nr_frames, i + nr_slots);
+	}
+	if (!err)
+		*consumed = run_size;
+out:
+	for (i = 0; i < nr_slots; i++)
+		kvfree(slots[i].workspace);
+	kfree(slots);
+	return err;
+}
+EXPORT_SYMBOL(zstd_decompress_frames);
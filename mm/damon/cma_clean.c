@@ -0,0 +1,377 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * DAMON-based cleaning of CMA areas
+ *
+ * Movable pages placed in a CMA area have to be migrated out by each
+ * cma_alloc() that needs their range, which is what makes big allocations
+ * for video and display buffers slow under memory pressure.  This finds cold
+ * pages in the biggest CMA area and moves them out in the background, ahead
+ * of those allocations.
+ */
+
+#define pr_fmt(fmt) "damon-cma-clean: " fmt
+
+#include <linux/cma.h>
+#include <linux/damon.h>
+#include <linux/kstrtox.h>
+#include <linux/module.h>
+
+#include "modules-common.h"
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "damon_cma_clean."
+
+/*
+ * Enable or disable DAMON_CMA_CLEAN.
+ *
+ * You can enable DAMON_CMA_CLEAN by setting the value of this parameter as
+ * ``Y``.  Setting it as ``N`` disables DAMON_CMA_CLEAN.
+ */
+static bool enabled __read_mostly;
+
+/*
+ * Make DAMON_CMA_CLEAN reads the input parameters again, except ``enabled``.
+ *
+ * Input parameters that updated while DAMON_CMA_CLEAN is running are not
+ * applied by default.  Once this parameter is set as ``Y``, DAMON_CMA_CLEAN
+ * reads values of parametrs except ``enabled`` again.  Once the re-reading is
+ * done, this parameter is set as ``N``.  If invalid parameters are found while
+ * the re-reading, DAMON_CMA_CLEAN will be disabled.
+ */
+static bool commit_inputs __read_mostly;
+module_param(commit_inputs, bool, 0600);
+
+/*
+ * Time threshold for cold memory regions identification in microseconds.
+ *
+ * If a memory region is not accessed for this or longer time,
+ * DAMON_CMA_CLEAN identifies the region as cold, and migrates the movable
+ * pages of it out of CMA.  10 seconds by default: unlike reclaimed pages,
+ * migrated pages stay in memory, so being wrong is cheap.
+ */
+static unsigned long min_age __read_mostly = 10000000;
+module_param(min_age, ulong, 0600);
+
+static struct damos_quota damon_cma_clean_quota = {
+	/* use up to 10 ms time, migrate up to 64 MiB per 1 sec by default */
+	.ms = 10,
+	.sz = 64 * 1024 * 1024,
+	.reset_interval = 1000,
+	/* Within the quota, migrate older regions first. */
+	.weight_sz = 0,
+	.weight_nr_accesses = 0,
+	.weight_age = 1
+};
+DEFINE_DAMON_MODULES_DAMOS_QUOTAS(damon_cma_clean_quota);
+
+/*
+ * User-specifiable feedback for auto-tuning of the effective quota.
+ *
+ * While keeping the caps that set by other quotas, DAMON_CMA_CLEAN
+ * automatically increases and decreases the effective level of the quota
+ * aiming receiving this feedback of value ``10,000`` from the user, for
+ * example the permyriad of CMA allocations that met their latency target.
+ * DAMON_CMA_CLEAN assumes the feedback value and the quota are positively
+ * proportional.  Value zero means disabling this auto-tuning feature.
+ *
+ * Disabled by default.
+ */
+static unsigned long quota_autotune_feedback __read_mostly;
+module_param(quota_autotune_feedback, ulong, 0600);
+
+/*
+ * Desired level of memory pressure-stall time in microseconds.
+ *
+ * Migrating pages out of CMA needs free memory elsewhere.  While keeping the
+ * caps that set by other quotas, DAMON_CMA_CLEAN automatically increases and
+ * decreases the effective level of the quota aiming this level of memory
+ * pressure is incurred.  Value zero means disabling this auto-tuning feature.
+ *
+ * Disabled by default.
+ */
+static unsigned long quota_mem_pressure_us __read_mostly;
+module_param(quota_mem_pressure_us, ulong, 0600);
+
+static struct damon_attrs damon_cma_clean_mon_attrs = {
+	.sample_interval = 5000,	/* 5 ms */
+	.aggr_interval = 100000,	/* 100 ms */
+	.ops_update_interval = 0,
+	.min_nr_regions = 10,
+	.max_nr_regions = 1000,
+};
+DEFINE_DAMON_MODULES_MON_ATTRS_PARAMS(damon_cma_clean_mon_attrs);
+
+/*
+ * Start of the target memory region in physical address.
+ *
+ * The start physical address of memory region that DAMON_CMA_CLEAN will do
+ * work against.  By default, the biggest CMA area is used as the region.
+ */
+static unsigned long monitor_region_start __read_mostly;
+module_param(monitor_region_start, ulong, 0600);
+
+/*
+ * End of the target memory region in physical address.
+ *
+ * The end physical address of memory region that DAMON_CMA_CLEAN will do
+ * work against.  By default, the biggest CMA area is used as the region.
+ */
+static unsigned long monitor_region_end __read_mostly;
+module_param(monitor_region_end, ulong, 0600);
+
+/*
+ * Skip anonymous pages.
+ *
+ * If this parameter is set as ``Y``, DAMON_CMA_CLEAN migrates only page cache
+ * pages out of CMA.  By default, ``N``.
+ */
+static bool skip_anon __read_mostly;
+module_param(skip_anon, bool, 0600);
+
+/*
+ * PID of the DAMON thread
+ *
+ * If DAMON_CMA_CLEAN is enabled, this becomes the PID of the worker thread.
+ * Else, -1.
+ */
+static int kdamond_pid __read_mostly = -1;
+module_param(kdamond_pid, int, 0400);
+
+static struct damos_stat damon_cma_clean_stat;
+DEFINE_DAMON_MODULES_DAMOS_STATS_PARAMS(damon_cma_clean_stat,
+		migrate_tried_regions, migrated_regions, quota_exceeds);
+
+static struct damon_ctx *ctx;
+static struct damon_target *target;
+
+static int damon_cma_clean_biggest_area(struct cma *cma, void *data)
+{
+	struct damon_addr_range *range = data;
+	unsigned long start = cma_get_base(cma);
+	unsigned long size = cma_get_size(cma);
+
+	if (size > range->end - range->start) {
+		range->start = start;
+		range->end = start + size;
+	}
+	return 0;
+}
+
+static int damon_cma_clean_set_region(struct damon_target *t)
+{
+	struct damon_addr_range range = {};
+
+	if (monitor_region_start > monitor_region_end)
+		return -EINVAL;
+
+	if (!monitor_region_start && !monitor_region_end) {
+		cma_for_each_area(damon_cma_clean_biggest_area, &range);
+		if (range.start == range.end)
+			return -EINVAL;
+		monitor_region_start = range.start;
+		monitor_region_end = range.end;
+	}
+
+	range.start = monitor_region_start;
+	range.end = monitor_region_end;
+	return damon_set_regions(t, &range, 1);
+}
+
+static struct damos *damon_cma_clean_new_scheme(void)
+{
+	struct damos_access_pattern pattern = {
+		/* Find regions having PAGE_SIZE or larger size */
+		.min_sz_region = PAGE_SIZE,
+		.max_sz_region = ULONG_MAX,
+		/* and not accessed at all */
+		.min_nr_accesses = 0,
+		.max_nr_accesses = 0,
+		/* for min_age or more micro-seconds */
+		.min_age_region = min_age /
+			damon_cma_clean_mon_attrs.aggr_interval,
+		.max_age_region = UINT_MAX,
+	};
+	struct damos_watermarks wmarks = {
+		.metric = DAMOS_WMARK_NONE,
+	};
+
+	return damon_new_scheme(
+			&pattern,
+			/* migrate those out of CMA, as soon as found */
+			DAMOS_MIGRATE_OUT,
+			/* for each aggregation interval */
+			0,
+			/* under the quota. */
+			&damon_cma_clean_quota,
+			/* always active */
+			&wmarks,
+			NUMA_NO_NODE);
+}
+
+static int damon_cma_clean_apply_parameters(void)
+{
+	struct damon_ctx *param_ctx;
+	struct damon_target *param_target;
+	struct damos *scheme;
+	struct damos_quota_goal *goal;
+	struct damos_filter *filter;
+	int err;
+
+	err = damon_modules_new_paddr_ctx_target(&param_ctx, &param_target);
+	if (err)
+		return err;
+
+	err = damon_set_attrs(ctx, &damon_cma_clean_mon_attrs);
+	if (err)
+		goto out;
+
+	err = -ENOMEM;
+	scheme = damon_cma_clean_new_scheme();
+	if (!scheme)
+		goto out;
+	damon_set_schemes(ctx, &scheme, 1);
+
+	if (quota_mem_pressure_us) {
+		goal = damos_new_quota_goal(DAMOS_QUOTA_SOME_MEM_PSI_US,
+				quota_mem_pressure_us);
+		if (!goal)
+			goto out;
+		damos_add_quota_goal(&scheme->quota, goal);
+	}
+
+	if (quota_autotune_feedback) {
+		goal = damos_new_quota_goal(DAMOS_QUOTA_USER_INPUT, 10000);
+		if (!goal)
+			goto out;
+		goal->current_value = quota_autotune_feedback;
+		damos_add_quota_goal(&scheme->quota, goal);
+	}
+
+	/* only pages in CMA pageblocks are worth looking at */
+	filter = damos_new_filter(DAMOS_FILTER_TYPE_CMA, false);
+	if (!filter)
+		goto out;
+	damos_add_filter(scheme, filter);
+
+	if (skip_anon) {
+		filter = damos_new_filter(DAMOS_FILTER_TYPE_ANON, true);
+		if (!filter)
+			goto out;
+		damos_add_filter(scheme, filter);
+	}
+
+	err = damon_cma_clean_set_region(param_target);
+	if (err)
+		goto out;
+	err = damon_commit_ctx(ctx, param_ctx);
+out:
+	damon_destroy_ctx(param_ctx);
+	return err;
+}
+
+static int damon_cma_clean_turn(bool on)
+{
+	int err;
+
+	if (!on) {
+		err = damon_stop(&ctx, 1);
+		if (!err)
+			kdamond_pid = -1;
+		return err;
+	}
+
+	err = damon_cma_clean_apply_parameters();
+	if (err)
+		return err;
+
+	err = damon_start(&ctx, 1, true);
+	if (err)
+		return err;
+	kdamond_pid = ctx->kdamond->pid;
+	return 0;
+}
+
+static int damon_cma_clean_enabled_store(const char *val,
+		const struct kernel_param *kp)
+{
+	bool is_enabled = enabled;
+	bool enable;
+	int err;
+
+	err = kstrtobool(val, &enable);
+	if (err)
+		return err;
+
+	if (is_enabled == enable)
+		return 0;
+
+	/* Called before init function.  The function will handle this. */
+	if (!ctx)
+		goto set_param_out;
+
+	err = damon_cma_clean_turn(enable);
+	if (err)
+		return err;
+
+set_param_out:
+	enabled = enable;
+	return err;
+}
+
+static const struct kernel_param_ops enabled_param_ops = {
+	.set = damon_cma_clean_enabled_store,
+	.get = param_get_bool,
+};
+
+module_param_cb(enabled, &enabled_param_ops, &enabled, 0600);
+MODULE_PARM_DESC(enabled,
+	"Enable or disable DAMON_CMA_CLEAN (default: disabled)");
+
+static int damon_cma_clean_handle_commit_inputs(void)
+{
+	int err;
+
+	if (!commit_inputs)
+		return 0;
+
+	err = damon_cma_clean_apply_parameters();
+	commit_inputs = false;
+	return err;
+}
+
+static int damon_cma_clean_after_aggregation(struct damon_ctx *c)
+{
+	struct damos *s;
+
+	/* update the stats parameter */
+	damon_for_each_scheme(s, c)
+		damon_cma_clean_stat = s->stat;
+
+	return damon_cma_clean_handle_commit_inputs();
+}
+
+static int damon_cma_clean_after_wmarks_check(struct damon_ctx *c)
+{
+	return damon_cma_clean_handle_commit_inputs();
+}
+
+static int __init damon_cma_clean_init(void)
+{
+	int err = damon_modules_new_paddr_ctx_target(&ctx, &target);
+
+	if (err)
+		return err;
+
+	ctx->callback.after_wmarks_check = damon_cma_clean_after_wmarks_check;
+	ctx->callback.after_aggregation = damon_cma_clean_after_aggregation;
+
+	/* 'enabled' has set before this function, probably via command line */
+	if (enabled)
+		err = damon_cma_clean_turn(true);
+
+	return err;
+}
+
+module_init(damon_cma_clean_init);
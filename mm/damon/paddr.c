@@ -222,6 +222,9 @@ static bool __damos_pa_filter_out(struct damos_filter *filter,
 		if (matched)
 			damon_folio_mkold(folio);
 		break;
+	case DAMOS_FILTER_TYPE_CMA:
+		matched = is_migrate_cma_folio(folio, folio_pfn(folio));
+		break;
 	default:
 		break;
 	}
@@ -486,6 +489,82 @@ static unsigned long damon_pa_migrate(struct damon_region *r, struct damos *s)
 	return applied * PAGE_SIZE;
 }
 
+static unsigned long damon_pa_migrate_out_folios(struct list_head *folio_list)
+{
+	unsigned int nr_succeeded = 0, pin_flags, noreclaim_flag;
+	struct migration_target_control mtc = {
+		/* stay on the node of the folio, fail quickly and quietly */
+		.gfp_mask = (GFP_HIGHUSER_MOVABLE & ~__GFP_RECLAIM) |
+			__GFP_NOWARN | __GFP_NOMEMALLOC | GFP_NOWAIT,
+		.nid = NUMA_NO_NODE,
+	};
+	struct folio *folio;
+
+	if (list_empty(folio_list))
+		return 0;
+
+	/*
+	 * Like migrating out folios to be long term pinned, keep the targets
+	 * movable but out of CMA pageblocks.
+	 */
+	noreclaim_flag = memalloc_noreclaim_save();
+	pin_flags = memalloc_pin_save();
+	migrate_pages(folio_list, alloc_migration_target, NULL,
+		      (unsigned long)&mtc, MIGRATE_ASYNC, MR_DAMON,
+		      &nr_succeeded);
+	memalloc_pin_restore(pin_flags);
+	memalloc_noreclaim_restore(noreclaim_flag);
+
+	while (!list_empty(folio_list)) {
+		folio = lru_to_folio(folio_list);
+		list_del(&folio->lru);
+		folio_putback_lru(folio);
+	}
+	return nr_succeeded;
+}
+
+/*
+ * Move cold movable pages out of CMA, so that later cma_alloc() calls for the
+ * range find it free instead of migrating them synchronously.
+ */
+static unsigned long damon_pa_migrate_out(struct damon_region *r,
+		struct damos *s)
+{
+	unsigned long pageblock_sz = pageblock_nr_pages << PAGE_SHIFT;
+	unsigned long addr, applied;
+	LIST_HEAD(folio_list);
+
+	addr = r->ar.start;
+	while (addr < r->ar.end) {
+		struct page *page = pfn_to_online_page(PHYS_PFN(addr));
+		struct folio *folio;
+
+		/* nothing to do in this pageblock */
+		if (!page || !is_migrate_cma_page(page)) {
+			addr = ALIGN_DOWN(addr, pageblock_sz) + pageblock_sz;
+			continue;
+		}
+
+		folio = damon_get_folio(PHYS_PFN(addr));
+		if (!folio) {
+			addr += PAGE_SIZE;
+			continue;
+		}
+
+		if (damos_pa_filter_out(s, folio))
+			goto put_folio;
+
+		if (!folio_isolate_lru(folio))
+			goto put_folio;
+		list_add(&folio->lru, &folio_list);
+put_folio:
+		addr += folio_size(folio);
+		folio_put(folio);
+	}
+	applied = damon_pa_migrate_out_folios(&folio_list);
+	cond_resched();
+	return applied * PAGE_SIZE;
+}
 
 static unsigned long damon_pa_apply_scheme(struct damon_ctx *ctx,
 		struct damon_target *t, struct damon_region *r,
@@ -501,6 +580,8 @@ static unsigned long damon_pa_apply_scheme(struct damon_ctx *ctx,
 	case DAMOS_MIGRATE_HOT:
 	case DAMOS_MIGRATE_COLD:
 		return damon_pa_migrate(r, scheme);
+	case DAMOS_MIGRATE_OUT:
+		return damon_pa_migrate_out(r, scheme);
 	case DAMOS_STAT:
 		break;
 	default:
@@ -524,6 +605,7 @@ static int damon_pa_scheme_score(struct damon_ctx *context,
 	case DAMOS_MIGRATE_HOT:
 		return damon_hot_score(context, r, scheme);
 	case DAMOS_MIGRATE_COLD:
+	case DAMOS_MIGRATE_OUT:
 		return damon_cold_score(context, r, scheme);
 	default:
 		break;
@@ -0,0 +1,349 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * DAMON-based always-on working set size estimation
+ *
+ * Monitors the biggest System RAM resource with fixed and minimal sampling
+ * and keeps rolling estimates of the working set size and of how long
+ * memory has been idle, in total and per memory cgroup, for telemetry.
+ */
+
+#define pr_fmt(fmt) "damon-wss: " fmt
+
+#include <linux/damon.h>
+#include <linux/kstrtox.h>
+#include <linux/memcontrol.h>
+#include <linux/module.h>
+#include <linux/spinlock.h>
+
+#include "modules-common.h"
+#include "ops-common.h"
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "damon_wss."
+
+/*
+ * Idle time buckets, in seconds since the last access.  Memory idle for
+ * less than DAMON_WSS_WINDOW_SEC is counted in the working set.
+ */
+static const unsigned int damon_wss_idle_sec[] = { 0, 10, 60, 600 };
+#define DAMON_WSS_NR_BUCKETS	ARRAY_SIZE(damon_wss_idle_sec)
+#define DAMON_WSS_WINDOW_SEC	60
+
+/* Number of memory cgroups tracked; the rest are accounted to id 0 */
+#define DAMON_WSS_NR_MEMCGS	64
+
+/* Weight of the newest aggregation in the rolling estimates, in 1/8 */
+#define DAMON_WSS_EWMA_SHIFT	3
+
+struct damon_wss_stat {
+	unsigned short memcg_id;
+	unsigned long cur[DAMON_WSS_NR_BUCKETS];
+	unsigned long avg[DAMON_WSS_NR_BUCKETS];
+};
+
+/*
+ * Enable or disable DAMON_WSS.
+ *
+ * DAMON_WSS is enabled at boot by default.  Setting this parameter as ``N``
+ * stops it, and ``Y`` starts it again from empty estimates.
+ */
+static bool enabled __read_mostly = true;
+
+/*
+ * Rolling estimate of the working set size in bytes.
+ *
+ * The amount of memory that has been accessed in the last minute.
+ */
+static unsigned long wss_bytes __read_mostly;
+module_param(wss_bytes, ulong, 0400);
+
+/*
+ * PID of the DAMON thread
+ *
+ * If DAMON_WSS is enabled, this becomes the PID of the worker thread.
+ * Else, -1.
+ */
+static int kdamond_pid __read_mostly = -1;
+module_param(kdamond_pid, int, 0400);
+
+/* 50 ms sampling with 1 second aggregation over up to 100 regions */
+static struct damon_attrs damon_wss_mon_attrs = {
+	.sample_interval = 50000,
+	.aggr_interval = 1000000,
+	.ops_update_interval = 0,
+	.min_nr_regions = 10,
+	.max_nr_regions = 100,
+};
+
+static struct damon_ctx *ctx;
+static struct damon_target *target;
+static unsigned long monitor_region_start, monitor_region_end;
+
+/* protects the estimates against readers of the parameters below */
+static DEFINE_SPINLOCK(damon_wss_lock);
+static struct damon_wss_stat damon_wss_total;
+/* one more slot for id 0, which is used once the others are taken */
+static struct damon_wss_stat damon_wss_memcgs[DAMON_WSS_NR_MEMCGS + 1];
+static unsigned int damon_wss_nr_memcgs;
+
+static unsigned int damon_wss_bucket(struct damon_region *r)
+{
+	unsigned long idle_sec;
+	unsigned int i;
+
+	if (r->nr_accesses)
+		return 0;
+
+	idle_sec = (unsigned long)r->age * damon_wss_mon_attrs.aggr_interval /
+		USEC_PER_SEC;
+	for (i = DAMON_WSS_NR_BUCKETS - 1; i > 0; i--)
+		if (idle_sec >= damon_wss_idle_sec[i])
+			break;
+	return i;
+}
+
+/*
+ * Attribute the whole region to the memory cgroup of the page that DAMON
+ * sampled in it.  This is cheap but approximate: regions are split and
+ * merged by access pattern, not by owner.
+ */
+static struct damon_wss_stat *damon_wss_memcg_stat(struct damon_region *r)
+{
+	unsigned short id = 0;
+	struct folio *folio;
+	unsigned int i;
+
+	folio = damon_get_folio(PHYS_PFN(r->sampling_addr));
+	if (folio) {
+		struct mem_cgroup *memcg;
+
+		rcu_read_lock();
+		memcg = folio_memcg_check(folio);
+		if (memcg)
+			id = mem_cgroup_id(memcg);
+		rcu_read_unlock();
+		folio_put(folio);
+	}
+
+	for (i = 0; i < damon_wss_nr_memcgs; i++)
+		if (damon_wss_memcgs[i].memcg_id == id)
+			return &damon_wss_memcgs[i];
+	if (damon_wss_nr_memcgs >= DAMON_WSS_NR_MEMCGS && id) {
+		id = 0;
+		for (i = 0; i < damon_wss_nr_memcgs; i++)
+			if (damon_wss_memcgs[i].memcg_id == id)
+				return &damon_wss_memcgs[i];
+	}
+
+	i = damon_wss_nr_memcgs++;
+	memset(&damon_wss_memcgs[i], 0, sizeof(damon_wss_memcgs[i]));
+	damon_wss_memcgs[i].memcg_id = id;
+	return &damon_wss_memcgs[i];
+}
+
+static bool damon_wss_stat_update(struct damon_wss_stat *stat)
+{
+	bool empty = true;
+	unsigned int i;
+
+	for (i = 0; i < DAMON_WSS_NR_BUCKETS; i++) {
+		stat->avg[i] += (long)(stat->cur[i] - stat->avg[i]) >>
+			DAMON_WSS_EWMA_SHIFT;
+		/* don't let small estimates get stuck above zero */
+		if (!stat->cur[i] && stat->avg[i] < PAGE_SIZE)
+			stat->avg[i] = 0;
+		if (stat->avg[i])
+			empty = false;
+		stat->cur[i] = 0;
+	}
+	return empty;
+}
+
+static unsigned long damon_wss_stat_wss(struct damon_wss_stat *stat)
+{
+	unsigned long sz = 0;
+	unsigned int i;
+
+	for (i = 0; i < DAMON_WSS_NR_BUCKETS; i++)
+		if (damon_wss_idle_sec[i] < DAMON_WSS_WINDOW_SEC)
+			sz += stat->avg[i];
+	return sz;
+}
+
+static int damon_wss_after_aggregation(struct damon_ctx *c)
+{
+	struct damon_wss_stat *stat;
+	struct damon_target *t;
+	struct damon_region *r;
+	unsigned int i, b;
+
+	spin_lock(&damon_wss_lock);
+	damon_for_each_target(t, c) {
+		damon_for_each_region(r, t) {
+			b = damon_wss_bucket(r);
+			stat = damon_wss_memcg_stat(r);
+			stat->cur[b] += damon_sz_region(r);
+			damon_wss_total.cur[b] += damon_sz_region(r);
+		}
+	}
+
+	damon_wss_stat_update(&damon_wss_total);
+	for (i = 0; i < damon_wss_nr_memcgs; ) {
+		if (!damon_wss_stat_update(&damon_wss_memcgs[i])) {
+			i++;
+			continue;
+		}
+		/* the memcg is gone or has no memory here any more */
+		damon_wss_memcgs[i] = damon_wss_memcgs[--damon_wss_nr_memcgs];
+	}
+	WRITE_ONCE(wss_bytes, damon_wss_stat_wss(&damon_wss_total));
+	spin_unlock(&damon_wss_lock);
+	return 0;
+}
+
+static int damon_wss_print(char *buf, int len, struct damon_wss_stat *stat)
+{
+	unsigned int i;
+
+	len += scnprintf(buf + len, PAGE_SIZE - len, " %lu",
+			 damon_wss_stat_wss(stat));
+	for (i = 0; i < DAMON_WSS_NR_BUCKETS; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, " %lu",
+				 stat->avg[i]);
+	return len + scnprintf(buf + len, PAGE_SIZE - len, "\n");
+}
+
+/*
+ * Rolling estimates of the memory idle time histogram, one line per memory
+ * cgroup.
+ *
+ * The first line gives the lower bound, in seconds, of the idle time of each
+ * bucket.  Each following line gives a memory cgroup id, its working set
+ * size and the bytes in each bucket, all in bytes.  The line for id 0
+ * accounts the memory of the root and of unknown cgroups and pages not
+ * charged to any.  The ``total`` line is for the whole monitored memory.
+ */
+static int damon_wss_memcgs_get(char *buf, const struct kernel_param *kp)
+{
+	unsigned int i;
+	int len;
+
+	len = scnprintf(buf, PAGE_SIZE, "memcg wss");
+	for (i = 0; i < DAMON_WSS_NR_BUCKETS; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, " idle_%us",
+				 damon_wss_idle_sec[i]);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+
+	spin_lock(&damon_wss_lock);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "total");
+	len = damon_wss_print(buf, len, &damon_wss_total);
+	for (i = 0; i < damon_wss_nr_memcgs; i++) {
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%u",
+				 damon_wss_memcgs[i].memcg_id);
+		len = damon_wss_print(buf, len, &damon_wss_memcgs[i]);
+	}
+	spin_unlock(&damon_wss_lock);
+	return len;
+}
+
+static const struct kernel_param_ops memcg_idle_histogram_ops = {
+	.get = damon_wss_memcgs_get,
+};
+
+module_param_cb(memcg_idle_histogram, &memcg_idle_histogram_ops, NULL,
+		0400);
+MODULE_PARM_DESC(memcg_idle_histogram,
+	"Rolling working set size and idle time histogram per memory cgroup");
+
+static void damon_wss_reset(void)
+{
+	spin_lock(&damon_wss_lock);
+	memset(&damon_wss_total, 0, sizeof(damon_wss_total));
+	damon_wss_nr_memcgs = 0;
+	WRITE_ONCE(wss_bytes, 0);
+	spin_unlock(&damon_wss_lock);
+}
+
+static int damon_wss_turn(bool on)
+{
+	int err;
+
+	if (!on) {
+		err = damon_stop(&ctx, 1);
+		if (!err)
+			kdamond_pid = -1;
+		return err;
+	}
+
+	damon_wss_reset();
+	err = damon_start(&ctx, 1, true);
+	if (err)
+		return err;
+	kdamond_pid = ctx->kdamond->pid;
+	return 0;
+}
+
+static int damon_wss_enabled_store(const char *val,
+		const struct kernel_param *kp)
+{
+	bool is_enabled = enabled;
+	bool enable;
+	int err;
+
+	err = kstrtobool(val, &enable);
+	if (err)
+		return err;
+
+	if (is_enabled == enable)
+		return 0;
+
+	/* Called before init function.  The function will handle this. */
+	if (!ctx)
+		goto set_param_out;
+
+	err = damon_wss_turn(enable);
+	if (err)
+		return err;
+
+set_param_out:
+	enabled = enable;
+	return err;
+}
+
+static const struct kernel_param_ops enabled_param_ops = {
+	.set = damon_wss_enabled_store,
+	.get = param_get_bool,
+};
+
+module_param_cb(enabled, &enabled_param_ops, &enabled, 0600);
+MODULE_PARM_DESC(enabled,
+	"Enable or disable DAMON_WSS (default: enabled)");
+
+static int __init damon_wss_init(void)
+{
+	int err = damon_modules_new_paddr_ctx_target(&ctx, &target);
+
+	if (err)
+		return err;
+
+	err = damon_set_attrs(ctx, &damon_wss_mon_attrs);
+	if (err)
+		return err;
+	err = damon_set_region_biggest_system_ram_default(target,
+					&monitor_region_start,
+					&monitor_region_end);
+	if (err)
+		return err;
+
+	ctx->callback.after_aggregation = damon_wss_after_aggregation;
+
+	/* 'enabled' has set before this function, probably via command line */
+	if (enabled)
+		err = damon_wss_turn(true);
+
+	return err;
+}
+
+module_init(damon_wss_init);
@@ -9,6 +9,7 @@
 
 #include <linux/atomic.h>
 #include <linux/bug.h>
+#include <linux/cpu.h>
 #include <linux/debugfs.h>
 #include <linux/hash.h>
 #include <linux/irq_work.h>
@@ -112,6 +113,10 @@ module_param_named(deferrable, kfence_deferrable, bool, 0444);
 static bool kfence_check_on_panic __read_mostly;
 module_param_named(check_on_panic, kfence_check_on_panic, bool, 0444);
 
+/* If true, only allocations from the targeted caches are sampled. */
+static bool kfence_targets_only __read_mostly;
+module_param_named(targets_only, kfence_targets_only, bool, 0644);
+
 /* The pool of pages used for guard pages and objects. */
 char *__kfence_pool __read_mostly;
 EXPORT_SYMBOL(__kfence_pool); /* Export for test modules. */
@@ -195,6 +200,35 @@ static const char *const counter_names[] = {
 };
 static_assert(ARRAY_SIZE(counter_names) == KFENCE_COUNTER_COUNT);
 
+/*
+ * Caches sampled on their own, one of every @interval allocations, on top of
+ * the global sampling.  The array is replaced as a whole under
+ * kfence_targets_mutex, with the CPU hotplug lock held for the static key, and
+ * read under RCU by the allocation path.
+ */
+#define KFENCE_MAX_TARGETS	8
+#define KFENCE_TARGETS_LEN	256
+
+struct kfence_target {
+	struct kmem_cache *cache;
+	unsigned long interval;
+	atomic_long_t count;	/* allocations from the cache */
+	atomic_long_t hits;	/* KFENCE allocations made for the cache */
+	atomic_long_t misses;	/* sampled, but not allocated by KFENCE */
+	atomic64_t ns;		/* time spent sampling the cache */
+};
+
+struct kfence_targets {
+	struct rcu_head rcu;
+	unsigned int nr;
+	struct kfence_target t[];
+};
+
+DEFINE_STATIC_KEY_FALSE(kfence_target_key);
+static struct kfence_targets __rcu *kfence_targets;
+static DEFINE_MUTEX(kfence_targets_mutex);
+static char kfence_targets_str[KFENCE_TARGETS_LEN];
+
 /* === Internals ============================================================ */
 
 static inline bool should_skip_covered(void)
@@ -728,6 +762,29 @@ static int stats_show(struct seq_file *seq, void *v)
 }
 DEFINE_SHOW_ATTRIBUTE(stats);
 
+static int targets_show(struct seq_file *seq, void *v)
+{
+	struct kfence_targets *targets;
+	struct kfence_target *t;
+	unsigned int i;
+
+	/* kfence_shutdown_cache() drops a target before its cache goes away */
+	mutex_lock(&kfence_targets_mutex);
+	targets = rcu_dereference_protected(kfence_targets,
+					    lockdep_is_held(&kfence_targets_mutex));
+	for (i = 0; targets && i < targets->nr; i++) {
+		t = &targets->t[i];
+		seq_printf(seq, "%s: interval %lu allocations %ld hits %ld misses %ld overhead_ns %lld\n",
+			   t->cache->name, t->interval, atomic_long_read(&t->count),
+			   atomic_long_read(&t->hits), atomic_long_read(&t->misses),
+			   atomic64_read(&t->ns));
+	}
+	mutex_unlock(&kfence_targets_mutex);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(targets);
+
 /*
  * debugfs seq_file operations for /sys/kernel/debug/kfence/objects.
  * start_object() and next_object() return the object index + 1, because NULL is used
@@ -783,6 +840,7 @@ static int kfence_debugfs_init(void)
 	kfence_dir = debugfs_create_dir("kfence", NULL);
 	debugfs_create_file("stats", 0444, kfence_dir, NULL, &stats_fops);
 	debugfs_create_file("objects", 0400, kfence_dir, NULL, &objects_fops);
+	debugfs_create_file("targets", 0444, kfence_dir, NULL, &targets_fops);
 	return 0;
 }
 
@@ -844,6 +902,10 @@ static void toggle_allocation_gate(struct work_struct *work)
 	if (!READ_ONCE(kfence_enabled))
 		return;
 
+	/* Leave the gate closed, only the targeted caches are sampled. */
+	if (READ_ONCE(kfence_targets_only))
+		goto out;
+
 	atomic_set(&kfence_allocation_gate, -kfence_burst);
 #ifdef CONFIG_KFENCE_STATIC_KEYS
 	/* Enable static key, and await allocation to happen. */
@@ -854,6 +916,7 @@ static void toggle_allocation_gate(struct work_struct *work)
 	/* Disable static key and reset timer. */
 	static_branch_disable(&kfence_allocation_key);
 #endif
+out:
 	queue_delayed_work(system_unbound_wq, &kfence_timer,
 			   msecs_to_jiffies(kfence_sample_interval));
 }
@@ -1001,12 +1064,21 @@ static int kfence_enable_late(void)
 	return 0;
 }
 
+static void kfence_update_targets(struct kfence_targets *new, struct kmem_cache *gone);
+
 void kfence_shutdown_cache(struct kmem_cache *s)
 {
 	unsigned long flags;
 	struct kfence_metadata *meta;
 	int i;
 
+	/* Called under the CPU hotplug lock, see kfence_set_targets(). */
+	if (rcu_access_pointer(kfence_targets)) {
+		mutex_lock(&kfence_targets_mutex);
+		kfence_update_targets(NULL, s);
+		mutex_unlock(&kfence_targets_mutex);
+	}
+
 	/* Pairs with release in kfence_init_pool(). */
 	if (!smp_load_acquire(&kfence_metadata))
 		return;
@@ -1063,20 +1135,11 @@ void kfence_shutdown_cache(struct kmem_cache *s)
 	}
 }
 
-void *__kfence_alloc(struct kmem_cache *s, size_t size, gfp_t flags)
+static bool kfence_alloc_compatible(struct kmem_cache *s, size_t size, gfp_t flags)
 {
-	unsigned long stack_entries[KFENCE_STACK_DEPTH];
-	size_t num_stack_entries;
-	u32 alloc_stack_hash;
-	int allocation_gate;
-
-	/*
-	 * Perform size check before switching kfence_allocation_gate, so that
-	 * we don't disable KFENCE without making an allocation.
-	 */
 	if (size > PAGE_SIZE) {
 		atomic_long_inc(&counters[KFENCE_COUNTER_SKIP_INCOMPAT]);
-		return NULL;
+		return false;
 	}
 
 	/*
@@ -1088,32 +1151,22 @@ void *__kfence_alloc(struct kmem_cache *s, size_t size, gfp_t flags)
 	    ((flags & __GFP_THISNODE) && num_online_nodes() > 1) ||
 	    (s->flags & (SLAB_CACHE_DMA | SLAB_CACHE_DMA32))) {
 		atomic_long_inc(&counters[KFENCE_COUNTER_SKIP_INCOMPAT]);
-		return NULL;
+		return false;
 	}
 
 	/*
 	 * Skip allocations for this slab, if KFENCE has been disabled for
 	 * this slab.
 	 */
-	if (s->flags & SLAB_SKIP_KFENCE)
-		return NULL;
+	return !(s->flags & SLAB_SKIP_KFENCE);
+}
 
-	allocation_gate = atomic_inc_return(&kfence_allocation_gate);
-	if (allocation_gate > 1)
-		return NULL;
-#ifdef CONFIG_KFENCE_STATIC_KEYS
-	/*
-	 * waitqueue_active() is fully ordered after the update of
-	 * kfence_allocation_gate per atomic_inc_return().
-	 */
-	if (allocation_gate == 1 && waitqueue_active(&allocation_wait)) {
-		/*
-		 * Calling wake_up() here may deadlock when allocations happen
-		 * from within timer code. Use an irq_work to defer it.
-		 */
-		irq_work_queue(&wake_up_kfence_timer_work);
-	}
-#endif
+/* Allocate a KFENCE object for an allocation that has been sampled. */
+static void *kfence_sampled_alloc(struct kmem_cache *s, size_t size, gfp_t flags)
+{
+	unsigned long stack_entries[KFENCE_STACK_DEPTH];
+	size_t num_stack_entries;
+	u32 alloc_stack_hash;
 
 	if (!READ_ONCE(kfence_enabled))
 		return NULL;
@@ -1139,6 +1192,200 @@ void *__kfence_alloc(struct kmem_cache *s, size_t size, gfp_t flags)
 				    alloc_stack_hash);
 }
 
+void *__kfence_alloc(struct kmem_cache *s, size_t size, gfp_t flags)
+{
+	int allocation_gate;
+
+	/*
+	 * Perform size check before switching kfence_allocation_gate, so that
+	 * we don't disable KFENCE without making an allocation.
+	 */
+	if (!kfence_alloc_compatible(s, size, flags))
+		return NULL;
+
+	allocation_gate = atomic_inc_return(&kfence_allocation_gate);
+	if (allocation_gate > 1)
+		return NULL;
+#ifdef CONFIG_KFENCE_STATIC_KEYS
+	/*
+	 * waitqueue_active() is fully ordered after the update of
+	 * kfence_allocation_gate per atomic_inc_return().
+	 */
+	if (allocation_gate == 1 && waitqueue_active(&allocation_wait)) {
+		/*
+		 * Calling wake_up() here may deadlock when allocations happen
+		 * from within timer code. Use an irq_work to defer it.
+		 */
+		irq_work_queue(&wake_up_kfence_timer_work);
+	}
+#endif
+
+	return kfence_sampled_alloc(s, size, flags);
+}
+
+void *__kfence_alloc_target(struct kmem_cache *s, size_t size, gfp_t flags)
+{
+	struct kfence_targets *targets;
+	struct kfence_target *t = NULL;
+	void *addr = NULL;
+	unsigned int i;
+	u64 start;
+
+	rcu_read_lock();
+	targets = rcu_dereference(kfence_targets);
+	for (i = 0; targets && i < targets->nr; i++) {
+		if (targets->t[i].cache == s) {
+			t = &targets->t[i];
+			break;
+		}
+	}
+	if (!t || atomic_long_inc_return(&t->count) % t->interval)
+		goto out;
+
+	start = local_clock();
+	if (kfence_alloc_compatible(s, size, flags))
+		addr = kfence_sampled_alloc(s, size, flags);
+	atomic64_add(local_clock() - start, &t->ns);
+	atomic_long_inc(addr ? &t->hits : &t->misses);
+out:
+	rcu_read_unlock();
+	return addr;
+}
+
+/* Replace the targets, or only drop @gone if it is not NULL. */
+static void kfence_update_targets(struct kfence_targets *new, struct kmem_cache *gone)
+{
+	struct kfence_targets *old;
+	unsigned int i;
+
+	lockdep_assert_held(&kfence_targets_mutex);
+	lockdep_assert_cpus_held();
+
+	old = rcu_dereference_protected(kfence_targets,
+					lockdep_is_held(&kfence_targets_mutex));
+	if (gone) {
+		for (i = 0; old && i < old->nr; i++)
+			if (old->t[i].cache == gone)
+				break;
+		if (!old || i == old->nr)
+			return;
+		new = kmemdup(old, struct_size(old, t, old->nr),
+			      GFP_KERNEL | __GFP_NOFAIL);
+		new->t[i] = new->t[--new->nr];
+	}
+
+	if (new && !new->nr) {
+		kfree(new);
+		new = NULL;
+	}
+	if (!new)
+		static_branch_disable_cpuslocked(&kfence_target_key);
+	rcu_assign_pointer(kfence_targets, new);
+	if (new)
+		static_branch_enable_cpuslocked(&kfence_target_key);
+	if (old)
+		kfree_rcu(old, rcu);
+}
+
+/*
+ * Parses "<cache>:<interval>[,<cache>:<interval>...]" and looks the caches up
+ * by name.  Caches that do not exist are an error if @strict, else skipped:
+ * at boot time, the targets are resolved once all built-in caches exist.
+ */
+static int kfence_set_targets(const char *val, bool strict)
+{
+	struct kfence_targets *new;
+	char *buf, *p, *name, *sep;
+	struct kmem_cache *s;
+	unsigned long interval;
+	int err = 0;
+
+	buf = kstrdup(val, GFP_KERNEL);
+	new = kzalloc(struct_size(new, t, KFENCE_MAX_TARGETS), GFP_KERNEL);
+	if (!buf || !new) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	/* same order as kmem_cache_destroy(), which calls kfence_shutdown_cache() */
+	cpus_read_lock();
+	mutex_lock(&slab_mutex);
+	mutex_lock(&kfence_targets_mutex);
+	p = strim(buf);
+	while ((name = strsep(&p, ",")) && *name) {
+		sep = strchr(name, ':');
+		if (!sep || kstrtoul(sep + 1, 0, &interval) || !interval ||
+		    new->nr == KFENCE_MAX_TARGETS) {
+			err = -EINVAL;
+			break;
+		}
+		*sep = '\0';
+
+		list_for_each_entry(s, &slab_caches, list)
+			if (!strcmp(s->name, name))
+				break;
+		if (list_entry_is_head(s, &slab_caches, list)) {
+			if (!strict) {
+				pr_warn("no cache %s to target\n", name);
+				continue;
+			}
+			err = -ENOENT;
+			break;
+		}
+
+		new->t[new->nr].cache = s;
+		new->t[new->nr].interval = interval;
+		new->nr++;
+	}
+	if (!err) {
+		kfence_update_targets(new, NULL);
+		new = NULL;
+	}
+	mutex_unlock(&kfence_targets_mutex);
+	mutex_unlock(&slab_mutex);
+	cpus_read_unlock();
+out:
+	kfree(new);
+	kfree(buf);
+	return err;
+}
+
+static int param_set_targets(const char *val, const struct kernel_param *kp)
+{
+	int err;
+
+	if (strlen(val) >= KFENCE_TARGETS_LEN)
+		return -ENOSPC;
+
+	/* Too early to look caches up, kfence_targets_init() will do it. */
+	if (system_state != SYSTEM_BOOTING) {
+		err = kfence_set_targets(val, true);
+		if (err)
+			return err;
+	}
+	strscpy(kfence_targets_str, val, KFENCE_TARGETS_LEN);
+	strim(kfence_targets_str);
+	return 0;
+}
+
+static const struct kernel_param_ops targets_param_ops = {
+	.set = param_set_targets,
+	.get = param_get_string,
+};
+static struct kparam_string kfence_targets_kps = {
+	.string = kfence_targets_str,
+	.maxlen = KFENCE_TARGETS_LEN,
+};
+module_param_cb(targets, &targets_param_ops, &kfence_targets_kps, 0644);
+
+static int __init kfence_targets_init(void)
+{
+	if (kfence_targets_str[0])
+		kfence_set_targets(kfence_targets_str, false);
+	return 0;
+}
+late_initcall(kfence_targets_init);
+
 size_t kfence_ksize(const void *addr)
 {
 	const struct kfence_metadata *meta = addr_to_metadata((unsigned long)addr);
@@ -404,6 +404,13 @@ static struct hlist_head *can_rcv_list_find(canid_t *can_id, canid_t *mask,
 		}
 	}
 
+	/* can_id/can_mask filters which test all SFF identifier bits, like
+	 * the common per-ID subscriptions with a plain CAN_SFF_MASK or
+	 * CAN_EFF_MASK, are indexed by these bits
+	 */
+	if ((*mask & CAN_SFF_MASK) == CAN_SFF_MASK)
+		return &dev_rcv_lists->rx_fil_id[*can_id & CAN_SFF_MASK];
+
 	/* default: filter via can_id/can_mask */
 	return &dev_rcv_lists->rx[RX_FIL];
 }
@@ -609,6 +616,15 @@ static int can_rcv_filter(struct can_dev_rcv_lists *dev_rcv_lists, struct sk_buf
 		}
 	}
 
+	/* check for indexed can_id/mask entries */
+	hlist_for_each_entry_rcu(rcv, &dev_rcv_lists->rx_fil_id[can_id & CAN_SFF_MASK],
+				 list) {
+		if ((can_id & rcv->mask) == rcv->can_id) {
+			deliver(skb, rcv);
+			matches++;
+		}
+	}
+
 	/* check for inverted can_id/mask entries */
 	hlist_for_each_entry_rcu(rcv, &dev_rcv_lists->rx[RX_INV], list) {
 		if ((can_id & rcv->mask) != rcv->can_id) {
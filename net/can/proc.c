@@ -302,9 +302,21 @@ static inline void can_rcvlist_proc_show_one(struct seq_file *m, int idx,
 					     struct net_device *dev,
 					     struct can_dev_rcv_lists *dev_rcv_lists)
 {
-	if (!hlist_empty(&dev_rcv_lists->rx[idx])) {
+	int all_empty = hlist_empty(&dev_rcv_lists->rx[idx]);
+	unsigned int i;
+
+	/* the indexed can_id/mask filters belong to 'rx_fil', too */
+	if (idx == RX_FIL)
+		for (i = 0; all_empty && i < CAN_SFF_RCV_ARRAY_SZ; i++)
+			all_empty = hlist_empty(&dev_rcv_lists->rx_fil_id[i]);
+
+	if (!all_empty) {
 		can_print_recv_banner(m);
 		can_print_rcvlist(m, &dev_rcv_lists->rx[idx], dev);
+		if (idx == RX_FIL)
+			for (i = 0; i < CAN_SFF_RCV_ARRAY_SZ; i++)
+				can_print_rcvlist(m, &dev_rcv_lists->rx_fil_id[i],
+						  dev);
 	} else
 		seq_printf(m, "  (%s: no entry)\n", DNAME(dev));
 
@@ -51,22 +51,25 @@ static bool dsa_skb_defer_rx_timestamp(struct dsa_user_priv *p,
 	return ds->ops->port_rxtstamp(ds, p->dp->index, skb, type);
 }
 
-static int dsa_switch_rcv(struct sk_buff *skb, struct net_device *dev,
-			  struct packet_type *pt, struct net_device *unused)
+/* Strip the tag of a frame received on the conduit and steer it to its
+ * user port. Returns the frame if it is to be delivered on a DSA user
+ * netdev, or NULL if it was consumed.
+ */
+static struct sk_buff *dsa_switch_rcv_one(struct sk_buff *skb,
+					  struct net_device *dev)
 {
 	struct metadata_dst *md_dst = skb_metadata_dst(skb);
 	struct dsa_port *cpu_dp = dev->dsa_ptr;
 	struct sk_buff *nskb = NULL;
-	struct dsa_user_priv *p;
 
 	if (unlikely(!cpu_dp)) {
 		kfree_skb(skb);
-		return 0;
+		return NULL;
 	}
 
 	skb = skb_unshare(skb, GFP_ATOMIC);
 	if (!skb)
-		return 0;
+		return NULL;
 
 	if (md_dst && md_dst->type == METADATA_HW_PORT_MUX) {
 		unsigned int port = md_dst->u.port_info.port_id;
@@ -86,7 +89,7 @@ static int dsa_switch_rcv(struct sk_buff *skb, struct net_device *dev,
 
 	if (!nskb) {
 		kfree_skb(skb);
-		return 0;
+		return NULL;
 	}
 
 	skb = nskb;
@@ -100,21 +103,33 @@ static int dsa_switch_rcv(struct sk_buff *skb, struct net_device *dev,
 		 * specific actions.
 		 */
 		netif_rx(skb);
-		return 0;
+		return NULL;
 	}
 
-	p = netdev_priv(skb->dev);
-
 	if (unlikely(cpu_dp->ds->untag_bridge_pvid ||
 		     cpu_dp->ds->untag_vlan_aware_bridge_pvid)) {
 		nskb = dsa_software_vlan_untag(skb);
 		if (!nskb) {
 			kfree_skb(skb);
-			return 0;
+			return NULL;
 		}
 		skb = nskb;
 	}
 
+	return skb;
+}
+
+static int dsa_switch_rcv(struct sk_buff *skb, struct net_device *dev,
+			  struct packet_type *pt, struct net_device *unused)
+{
+	struct dsa_user_priv *p;
+
+	skb = dsa_switch_rcv_one(skb, dev);
+	if (!skb)
+		return 0;
+
+	p = netdev_priv(skb->dev);
+
 	dev_sw_netstats_rx_add(skb->dev, skb->len + ETH_HLEN);
 
 	if (dsa_skb_defer_rx_timestamp(p, skb))
@@ -125,9 +140,75 @@ static int dsa_switch_rcv(struct sk_buff *skb, struct net_device *dev,
 	return 0;
 }
 
+/* Hand a run of frames of one user port to its GRO cell, the statistics
+ * are updated once for the whole run.
+ */
+static void dsa_user_rcv_list(struct net_device *dev, struct list_head *head)
+{
+	struct pcpu_sw_netstats *tstats;
+	struct sk_buff *skb, *next;
+	struct dsa_user_priv *p;
+	unsigned int packets = 0;
+	unsigned int bytes = 0;
+
+	if (list_empty(head))
+		return;
+
+	p = netdev_priv(dev);
+
+	list_for_each_entry_safe(skb, next, head, list) {
+		skb_list_del_init(skb);
+
+		packets++;
+		bytes += skb->len + ETH_HLEN;
+
+		if (dsa_skb_defer_rx_timestamp(p, skb))
+			continue;
+
+		gro_cells_receive(&p->gcells, skb);
+	}
+
+	tstats = this_cpu_ptr(dev->tstats);
+	u64_stats_update_begin(&tstats->syncp);
+	u64_stats_add(&tstats->rx_bytes, bytes);
+	u64_stats_add(&tstats->rx_packets, packets);
+	u64_stats_update_end(&tstats->syncp);
+}
+
+/* Receive a conduit NAPI batch. Consecutive frames of the same user port
+ * are demultiplexed into one sublist, which keeps GRO batching on the
+ * user netdev instead of interleaving per-frame deliveries.
+ */
+static void dsa_switch_rcv_list(struct list_head *head, struct packet_type *pt,
+				struct net_device *orig_dev)
+{
+	struct net_device *curr_dev = NULL;
+	struct sk_buff *skb, *next;
+	LIST_HEAD(sublist);
+
+	list_for_each_entry_safe(skb, next, head, list) {
+		skb_list_del_init(skb);
+
+		skb = dsa_switch_rcv_one(skb, skb->dev);
+		if (!skb)
+			continue;
+
+		if (curr_dev != skb->dev) {
+			if (curr_dev)
+				dsa_user_rcv_list(curr_dev, &sublist);
+			curr_dev = skb->dev;
+		}
+		list_add_tail(&skb->list, &sublist);
+	}
+
+	if (curr_dev)
+		dsa_user_rcv_list(curr_dev, &sublist);
+}
+
 struct packet_type dsa_pack_type __read_mostly = {
-	.type	= cpu_to_be16(ETH_P_XDSA),
-	.func	= dsa_switch_rcv,
+	.type		= cpu_to_be16(ETH_P_XDSA),
+	.func		= dsa_switch_rcv,
+	.list_func	= dsa_switch_rcv_list,
 };
 
 static void dsa_tag_driver_register(struct dsa_tag_driver *dsa_tag_driver,
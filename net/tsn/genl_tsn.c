@@ -22,6 +22,36 @@
 static struct genl_family tsn_family;
 static LIST_HEAD(port_list);
 
+/* Configuration transactions, one per port and netlink socket. While a
+ * transaction is open, the Qbv, Qci and CBS set commands of its socket
+ * are only parsed and staged, TSN_CMD_TXN_COMMIT hands them to the driver
+ * in one go with a common base time.
+ */
+struct tsn_txn_op {
+	struct list_head list;
+	u8 cmd;
+	u32 index;
+	bool enable;
+	union {
+		struct tsn_qbv_conf qbv;
+		struct tsn_qci_psfp_sfi_conf sfi;
+		struct tsn_qci_psfp_sgi_conf sgi;
+		struct tsn_qci_psfp_fmi fmi;
+		u8 bw;
+	} conf;
+};
+
+struct tsn_txn {
+	struct list_head list;
+	struct net_device *netdev;
+	u32 portid;
+	unsigned int count;
+	struct list_head ops;
+};
+
+static LIST_HEAD(txn_list);
+static DEFINE_MUTEX(txn_lock);
+
 static const struct nla_policy tsn_cmd_policy[TSN_CMD_ATTR_MAX + 1] = {
 	[TSN_CMD_ATTR_MESG]		= { .type = NLA_STRING },
 	[TSN_CMD_ATTR_DATA]		= { .type = NLA_S32 },
@@ -42,6 +72,11 @@ static const struct nla_policy tsn_cmd_policy[TSN_CMD_ATTR_MAX + 1] = {
 	[TSN_ATTR_CBREC]		= { .type = NLA_NESTED },
 	[TSN_ATTR_CBSTAT]               = { .type = NLA_NESTED },
 	[TSN_ATTR_DSCP]                 = { .type = NLA_NESTED },
+	[TSN_ATTR_TXN]			= { .type = NLA_NESTED },
+};
+
+static const struct nla_policy txn_policy[TSN_TXN_ATTR_MAX + 1] = {
+	[TSN_TXN_ATTR_BASETIME]		= { .type = NLA_U64 },
 };
 
 static const struct nla_policy tsn_cap_policy[TSN_CAP_ATTR_MAX + 1] = {
@@ -463,6 +498,96 @@ static struct tsn_port *tsn_init_check(struct genl_info *info,
 	return port;
 }
 
+/* txn_lock must be held */
+static struct tsn_txn *tsn_txn_find(struct net_device *netdev, u32 portid)
+{
+	struct tsn_txn *txn;
+
+	list_for_each_entry(txn, &txn_list, list) {
+		if (txn->netdev == netdev && txn->portid == portid)
+			return txn;
+	}
+
+	return NULL;
+}
+
+static void tsn_txn_free(struct tsn_txn *txn)
+{
+	struct tsn_txn_op *op, *tmp;
+
+	list_for_each_entry_safe(op, tmp, &txn->ops, list) {
+		if (op->cmd == TSN_CMD_QBV_SET)
+			kfree(op->conf.qbv.admin.control_list);
+		else if (op->cmd == TSN_CMD_QCI_SGI_SET)
+			kfree(op->conf.sgi.admin.gcl);
+		kfree(op);
+	}
+	kfree(txn);
+}
+
+/* Stage a set command if the sender has a transaction open on the port.
+ * Returns -ENOENT if there is none and the command has to be applied
+ * right away.
+ */
+static int tsn_txn_stage(struct genl_info *info, struct net_device *netdev,
+			 u8 cmd, u32 index, bool enable,
+			 const void *conf, size_t len)
+{
+	struct tsn_txn_op *op;
+	struct tsn_txn *txn;
+	void *list = NULL;
+	int ret = 0;
+
+	if (WARN_ON(len > sizeof(op->conf)))
+		return -EINVAL;
+
+	mutex_lock(&txn_lock);
+	txn = tsn_txn_find(netdev, info->snd_portid);
+	if (!txn) {
+		ret = -ENOENT;
+		goto out;
+	}
+
+	op = kzalloc(sizeof(*op), GFP_KERNEL);
+	if (!op) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	op->cmd = cmd;
+	op->index = index;
+	op->enable = enable;
+	memcpy(&op->conf, conf, len);
+
+	/* the gate control lists belong to the caller */
+	if (cmd == TSN_CMD_QBV_SET && op->conf.qbv.admin.control_list) {
+		list = kmemdup_array(op->conf.qbv.admin.control_list,
+				     op->conf.qbv.admin.control_list_length,
+				     sizeof(struct tsn_qbv_entry), GFP_KERNEL);
+		op->conf.qbv.admin.control_list = list;
+	} else if (cmd == TSN_CMD_QCI_SGI_SET && op->conf.sgi.admin.gcl) {
+		list = kmemdup_array(op->conf.sgi.admin.gcl,
+				     op->conf.sgi.admin.control_list_length,
+				     sizeof(struct tsn_qci_psfp_gcl), GFP_KERNEL);
+		op->conf.sgi.admin.gcl = list;
+	} else {
+		list = op;
+	}
+
+	if (!list) {
+		kfree(op);
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	list_add_tail(&op->list, &txn->ops);
+	txn->count++;
+out:
+	mutex_unlock(&txn_lock);
+
+	return ret;
+}
+
 static int tsn_cap_get(struct sk_buff *skb, struct genl_info *info)
 {
 	struct genlmsghdr *genlhdr = info->genlhdr;
@@ -1022,7 +1147,11 @@ static int cmd_qci_sfi_set(struct genl_info *info)
 		return -EINVAL;
 	}
 
-	ret = tsnops->qci_sfi_set(netdev, sfi_handle, enable, &sficonf);
+	ret = tsn_txn_stage(info, netdev, TSN_CMD_QCI_SFI_SET, sfi_handle,
+			    enable, &sficonf, sizeof(sficonf));
+	if (ret == -ENOENT)
+		ret = tsnops->qci_sfi_set(netdev, sfi_handle, enable,
+					  &sficonf);
 	if (ret < 0) {
 		tsn_simple_reply(info, TSN_CMD_REPLY, netdev->name, ret);
 		return ret;
@@ -1441,7 +1570,10 @@ static int cmd_qci_sgi_set(struct genl_info *info)
 
 	sgi.admin.gcl = gcl;
 
-	ret = tsnops->qci_sgi_set(netdev, sgi_handle, &sgi);
+	ret = tsn_txn_stage(info, netdev, TSN_CMD_QCI_SGI_SET, sgi_handle,
+			    sgi.gate_enabled, &sgi, sizeof(sgi));
+	if (ret == -ENOENT)
+		ret = tsnops->qci_sgi_set(netdev, sgi_handle, &sgi);
 	kfree(gcl);
 	if (!ret)
 		return tsn_simple_reply(info, TSN_CMD_REPLY,
@@ -1902,7 +2034,10 @@ static int cmd_qci_fmi_set(struct genl_info *info)
 		return -EINVAL;
 	}
 
-	ret = tsnops->qci_fmi_set(netdev, index, enable, &fmiconf);
+	ret = tsn_txn_stage(info, netdev, TSN_CMD_QCI_FMI_SET, index, enable,
+			    &fmiconf, sizeof(fmiconf));
+	if (ret == -ENOENT)
+		ret = tsnops->qci_fmi_set(netdev, index, enable, &fmiconf);
 	if (ret < 0) {
 		tsn_simple_reply(info, TSN_CMD_REPLY, netdev->name, ret);
 		return ret;
@@ -2152,7 +2287,10 @@ static int cmd_qbv_set(struct genl_info *info)
 		goto err;
 	}
 
-	ret = tsnops->qbv_set(netdev, &qbvconfig);
+	ret = tsn_txn_stage(info, netdev, TSN_CMD_QBV_SET, 0, true,
+			    &qbvconfig, sizeof(qbvconfig));
+	if (ret == -ENOENT)
+		ret = tsnops->qbv_set(netdev, &qbvconfig);
 
 	/* send back */
 	if (ret < 0)
@@ -2525,7 +2663,10 @@ static int tsn_cbs_set(struct sk_buff *skb, struct genl_info *info)
 		return -EINVAL;
 	}
 
-	ret = tsnops->cbs_set(netdev, tc, bw);
+	ret = tsn_txn_stage(info, netdev, TSN_CMD_CBS_SET, tc, true,
+			    &bw, sizeof(bw));
+	if (ret == -ENOENT)
+		ret = tsnops->cbs_set(netdev, tc, bw);
 	if (ret < 0) {
 		tsn_simple_reply(info, TSN_CMD_REPLY, netdev->name, ret);
 		return ret;
@@ -3216,6 +3357,213 @@ static int tsn_pcpmap_set(struct sk_buff *skb, struct genl_info *info)
 	return ret;
 }
 
+static int tsn_txn_begin(struct sk_buff *skb, struct genl_info *info)
+{
+	struct net_device *netdev;
+	struct tsn_port *port;
+	struct tsn_txn *txn;
+	int ret = 0;
+
+	port = tsn_init_check(info, &netdev);
+	if (!port)
+		return -ENODEV;
+
+	mutex_lock(&txn_lock);
+	list_for_each_entry(txn, &txn_list, list) {
+		if (txn->netdev == netdev) {
+			ret = -EBUSY;
+			goto out;
+		}
+	}
+
+	txn = kzalloc(sizeof(*txn), GFP_KERNEL);
+	if (!txn) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	txn->netdev = netdev;
+	txn->portid = info->snd_portid;
+	INIT_LIST_HEAD(&txn->ops);
+	list_add_tail(&txn->list, &txn_list);
+out:
+	mutex_unlock(&txn_lock);
+
+	tsn_simple_reply(info, TSN_CMD_REPLY, netdev->name, ret);
+	return ret;
+}
+
+static int tsn_txn_apply(const struct tsn_ops *tsnops,
+			 struct net_device *netdev, struct tsn_txn_op *op)
+{
+	switch (op->cmd) {
+	case TSN_CMD_QCI_FMI_SET:
+		if (!tsnops->qci_fmi_set)
+			return -EPERM;
+		return tsnops->qci_fmi_set(netdev, op->index, op->enable,
+					   &op->conf.fmi);
+	case TSN_CMD_QCI_SGI_SET:
+		if (!tsnops->qci_sgi_set)
+			return -EPERM;
+		return tsnops->qci_sgi_set(netdev, op->index, &op->conf.sgi);
+	case TSN_CMD_QCI_SFI_SET:
+		if (!tsnops->qci_sfi_set)
+			return -EPERM;
+		return tsnops->qci_sfi_set(netdev, op->index, op->enable,
+					   &op->conf.sfi);
+	case TSN_CMD_CBS_SET:
+		if (!tsnops->cbs_set)
+			return -EPERM;
+		return tsnops->cbs_set(netdev, op->index, op->conf.bw);
+	case TSN_CMD_QBV_SET:
+		if (!tsnops->qbv_set)
+			return -EPERM;
+		return tsnops->qbv_set(netdev, &op->conf.qbv);
+	}
+
+	return -EINVAL;
+}
+
+static int tsn_txn_commit(struct sk_buff *skb, struct genl_info *info)
+{
+	/* meters and gates before the filters referencing them, the port
+	 * schedule last
+	 */
+	static const u8 order[] = {
+		TSN_CMD_QCI_FMI_SET,
+		TSN_CMD_QCI_SGI_SET,
+		TSN_CMD_QCI_SFI_SET,
+		TSN_CMD_CBS_SET,
+		TSN_CMD_QBV_SET,
+	};
+	struct nlattr *txna[TSN_TXN_ATTR_MAX + 1];
+	struct net_device *netdev;
+	struct tsn_txn_op *op;
+	struct tsn_port *port;
+	struct tsn_txn *txn;
+	u64 base_time = 0;
+	int ret = 0;
+	int i;
+
+	port = tsn_init_check(info, &netdev);
+	if (!port)
+		return -ENODEV;
+
+	if (info->attrs[TSN_ATTR_TXN]) {
+		ret = NLA_PARSE_NESTED(txna, TSN_TXN_ATTR_MAX,
+				       info->attrs[TSN_ATTR_TXN], txn_policy);
+		if (ret) {
+			tsn_simple_reply(info, TSN_CMD_REPLY, netdev->name,
+					 -EINVAL);
+			return -EINVAL;
+		}
+
+		if (txna[TSN_TXN_ATTR_BASETIME])
+			base_time = nla_get_u64(txna[TSN_TXN_ATTR_BASETIME]);
+	}
+
+	mutex_lock(&txn_lock);
+	txn = tsn_txn_find(netdev, info->snd_portid);
+	if (txn)
+		list_del(&txn->list);
+	mutex_unlock(&txn_lock);
+
+	if (!txn) {
+		tsn_simple_reply(info, TSN_CMD_REPLY, netdev->name, -ENOENT);
+		return -ENOENT;
+	}
+
+	/* With a common base time in the future, all gate control lists are
+	 * loaded as admin (shadow) lists and the new schedules take over
+	 * at the same instant, whatever the programming takes.
+	 */
+	for (i = 0; i < ARRAY_SIZE(order); i++) {
+		list_for_each_entry(op, &txn->ops, list) {
+			if (op->cmd != order[i])
+				continue;
+
+			if (base_time && op->cmd == TSN_CMD_QBV_SET &&
+			    op->conf.qbv.gate_enabled) {
+				op->conf.qbv.admin.base_time = base_time;
+				op->conf.qbv.config_change = 1;
+			} else if (base_time && op->cmd == TSN_CMD_QCI_SGI_SET &&
+				   op->conf.sgi.gate_enabled) {
+				op->conf.sgi.admin.base_time = base_time;
+				op->conf.sgi.config_change = 1;
+			}
+
+			ret = tsn_txn_apply(port->tsnops, netdev, op);
+			if (ret < 0) {
+				netdev_err(netdev,
+					   "tsn: staged command %u index %u failed: %pe\n",
+					   op->cmd, op->index, ERR_PTR(ret));
+				goto out;
+			}
+		}
+	}
+
+	netdev_dbg(netdev, "tsn: committed %u staged commands\n", txn->count);
+out:
+	tsn_txn_free(txn);
+
+	tsn_simple_reply(info, TSN_CMD_REPLY, netdev->name, ret);
+	return ret;
+}
+
+static int tsn_txn_abort(struct sk_buff *skb, struct genl_info *info)
+{
+	struct net_device *netdev;
+	struct tsn_port *port;
+	struct tsn_txn *txn;
+
+	port = tsn_init_check(info, &netdev);
+	if (!port)
+		return -ENODEV;
+
+	mutex_lock(&txn_lock);
+	txn = tsn_txn_find(netdev, info->snd_portid);
+	if (txn)
+		list_del(&txn->list);
+	mutex_unlock(&txn_lock);
+
+	if (!txn) {
+		tsn_simple_reply(info, TSN_CMD_REPLY, netdev->name, -ENOENT);
+		return -ENOENT;
+	}
+
+	tsn_txn_free(txn);
+
+	tsn_simple_reply(info, TSN_CMD_REPLY, netdev->name, 0);
+	return 0;
+}
+
+/* drop the transactions of closed netlink sockets */
+static int tsn_txn_netlink_notify(struct notifier_block *nb,
+				  unsigned long state, void *_notify)
+{
+	struct netlink_notify *notify = _notify;
+	struct tsn_txn *txn, *tmp;
+
+	if (state != NETLINK_URELEASE || notify->protocol != NETLINK_GENERIC)
+		return NOTIFY_DONE;
+
+	mutex_lock(&txn_lock);
+	list_for_each_entry_safe(txn, tmp, &txn_list, list) {
+		if (txn->portid == notify->portid &&
+		    net_eq(dev_net(txn->netdev), notify->net)) {
+			list_del(&txn->list);
+			tsn_txn_free(txn);
+		}
+	}
+	mutex_unlock(&txn_lock);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block tsn_txn_netlink_notifier = {
+	.notifier_call = tsn_txn_netlink_notify,
+};
+
 static const struct genl_ops tsnnl_ops[] = {
 	{
 		.cmd		= TSN_CMD_ECHO,
@@ -3368,6 +3716,21 @@ static const struct genl_ops tsnnl_ops[] = {
 		.flags		= GENL_ADMIN_PERM,
 		.validate	= GENL_DONT_VALIDATE_STRICT,
 	},
+	{
+		.cmd		= TSN_CMD_TXN_BEGIN,
+		.doit		= tsn_txn_begin,
+		.flags		= GENL_ADMIN_PERM,
+	},
+	{
+		.cmd		= TSN_CMD_TXN_COMMIT,
+		.doit		= tsn_txn_commit,
+		.flags		= GENL_ADMIN_PERM,
+	},
+	{
+		.cmd		= TSN_CMD_TXN_ABORT,
+		.doit		= tsn_txn_abort,
+		.flags		= GENL_ADMIN_PERM,
+	},
 };
 
 static struct genl_family tsn_family = {
@@ -3560,8 +3923,18 @@ EXPORT_SYMBOL(tsn_qbu_ethtool_mm_compat_set);
 
 void tsn_port_unregister(struct net_device *netdev)
 {
+	struct tsn_txn *txn, *tmp;
 	struct tsn_port *p;
 
+	mutex_lock(&txn_lock);
+	list_for_each_entry_safe(txn, tmp, &txn_list, list) {
+		if (txn->netdev == netdev) {
+			list_del(&txn->list);
+			tsn_txn_free(txn);
+		}
+	}
+	mutex_unlock(&txn_lock);
+
 	list_for_each_entry(p, &port_list, list) {
 		if (!p || !p->netdev)
 			continue;
@@ -3578,15 +3951,27 @@ EXPORT_SYMBOL(tsn_port_unregister);
 
 static int __init tsn_genetlink_init(void)
 {
+	int ret;
+
 	pr_debug("tsn generic netlink module v%d init...\n", TSN_GENL_VERSION);
 
-	return genl_register_family(&tsn_family);
+	ret = genl_register_family(&tsn_family);
+	if (ret)
+		return ret;
+
+	ret = netlink_register_notifier(&tsn_txn_netlink_notifier);
+	if (ret)
+		genl_unregister_family(&tsn_family);
+
+	return ret;
 }
 
 static void __exit tsn_genetlink_exit(void)
 {
 	int ret;
 
+	netlink_unregister_notifier(&tsn_txn_netlink_notifier);
+
 	ret = genl_unregister_family(&tsn_family);
 	if (ret)
 		pr_err("failed to unregister family: %pe\nn", ERR_PTR(ret));
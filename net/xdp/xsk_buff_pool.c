@@ -670,6 +670,36 @@ u32 xp_alloc_batch(struct xsk_buff_pool *pool, struct xdp_buff **xdp, u32 max)
 }
 EXPORT_SYMBOL(xp_alloc_batch);
 
+/**
+ * xp_alloc_batch_dma - allocate buffers and return their frame DMA addresses
+ * @pool: buffer pool to allocate from
+ * @xdp: array receiving the allocated buffers
+ * @dma: array receiving the DMA address of the start of each frame
+ * @max: maximum number of buffers to allocate
+ *
+ * Drivers of hardware buffer pools hand whole frames to the device and
+ * release them in bulk commands. Every frame of a mapped pool already
+ * has its DMA address, so fill @dma here instead of leaving the driver
+ * to look it up (and check it) buffer after buffer.
+ *
+ * Return: the number of buffers allocated.
+ */
+u32 xp_alloc_batch_dma(struct xsk_buff_pool *pool, struct xdp_buff **xdp,
+		       u64 *dma, u32 max)
+{
+	struct xdp_buff_xsk *xskb;
+	u32 i, nb_entries;
+
+	nb_entries = xp_alloc_batch(pool, xdp, max);
+	for (i = 0; i < nb_entries; i++) {
+		xskb = container_of(xdp[i], struct xdp_buff_xsk, xdp);
+		dma[i] = xskb->frame_dma;
+	}
+
+	return nb_entries;
+}
+EXPORT_SYMBOL(xp_alloc_batch_dma);
+
 bool xp_can_alloc(struct xsk_buff_pool *pool, u32 count)
 {
 	u32 req_count, avail_count;
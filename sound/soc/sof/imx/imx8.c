@@ -107,7 +107,16 @@ static int imx8_send_msg(struct snd_sof_dev *sdev, struct snd_sof_ipc_msg *msg)
 
 	sof_mailbox_write(sdev, sdev->host_box.offset, msg->msg_data,
 			  msg->msg_size);
-	imx_dsp_ring_doorbell(priv->dsp_ipc, 0);
+	imx_dsp_ring_doorbell_sync(priv->dsp_ipc, 0, msg->msg_size);
+
+	return 0;
+}
+
+static int imx8_post_fw_run(struct snd_sof_dev *sdev)
+{
+	struct imx8_priv *priv = sdev->pdata->hw_pdata;
+
+	imx_dsp_debugfs_init(priv->dsp_ipc, sdev->debugfs_root);
 
 	return 0;
 }
@@ -495,6 +504,7 @@ static const struct snd_sof_dsp_ops sof_imx8_ops = {
 
 	/* ipc */
 	.send_msg	= imx8_send_msg,
+	.post_fw_run	= imx8_post_fw_run,
 	.get_mailbox_offset	= imx8_get_mailbox_offset,
 	.get_window_offset	= imx8_get_window_offset,
 
@@ -556,6 +566,7 @@ static const struct snd_sof_dsp_ops sof_imx8x_ops = {
 
 	/* ipc */
 	.send_msg	= imx8_send_msg,
+	.post_fw_run	= imx8_post_fw_run,
 	.get_mailbox_offset	= imx8_get_mailbox_offset,
 	.get_window_offset	= imx8_get_window_offset,
 
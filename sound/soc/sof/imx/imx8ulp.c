@@ -113,7 +113,16 @@ static int imx8ulp_send_msg(struct snd_sof_dev *sdev, struct snd_sof_ipc_msg *ms
 
 	sof_mailbox_write(sdev, sdev->host_box.offset, msg->msg_data,
 			  msg->msg_size);
-	imx_dsp_ring_doorbell(priv->dsp_ipc, 0);
+	imx_dsp_ring_doorbell_sync(priv->dsp_ipc, 0, msg->msg_size);
+
+	return 0;
+}
+
+static int imx8ulp_post_fw_run(struct snd_sof_dev *sdev)
+{
+	struct imx8ulp_priv *priv = sdev->pdata->hw_pdata;
+
+	imx_dsp_debugfs_init(priv->dsp_ipc, sdev->debugfs_root);
 
 	return 0;
 }
@@ -429,6 +438,7 @@ static const struct snd_sof_dsp_ops sof_imx8ulp_ops = {
 
 	/* ipc */
 	.send_msg	= imx8ulp_send_msg,
+	.post_fw_run	= imx8ulp_post_fw_run,
 	.get_mailbox_offset	= imx8ulp_get_mailbox_offset,
 	.get_window_offset	= imx8ulp_get_window_offset,
 
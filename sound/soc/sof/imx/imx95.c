@@ -187,7 +187,16 @@ static int imx95_send_msg(struct snd_sof_dev *sdev, struct snd_sof_ipc_msg *msg)
 	sof_mailbox_write(sdev, sdev->host_box.offset, msg->msg_data,
 			  msg->msg_size);
 
-	imx_dsp_ring_doorbell(priv->ipc_handle, 0);
+	imx_dsp_ring_doorbell_sync(priv->ipc_handle, 0, msg->msg_size);
+
+	return 0;
+}
+
+static int imx95_post_fw_run(struct snd_sof_dev *sdev)
+{
+	struct imx95_priv *priv = sdev->pdata->hw_pdata;
+
+	imx_dsp_debugfs_init(priv->ipc_handle, sdev->debugfs_root);
 
 	return 0;
 }
@@ -351,6 +360,7 @@ static const struct snd_sof_dsp_ops sof_imx95_ops = {
 	.block_read = sof_block_read,
 	.block_write = sof_block_write,
 	.send_msg = imx95_send_msg,
+	.post_fw_run = imx95_post_fw_run,
 	.load_firmware = snd_sof_load_firmware_memcpy,
 	.ipc_msg_data = sof_ipc_msg_data,
 
@@ -0,0 +1,361 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * dlfilter-spe-mem.c: Memory latency report from Arm SPE samples
+ *
+ * Aggregates the latency of the memory operations sampled by SPE by data
+ * source, by symbol, by physical memory region and by memory node, to find
+ * the code and the buffers that keep DDR busy.
+ */
+#include <perf/perf_dlfilter.h>
+#include <linux/perf_event.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+struct perf_dlfilter_fns perf_dlfilter_fns;
+
+#define MAX_NODES	8
+#define DEF_TOP		20
+#define DEF_REGION	(64ULL << 20)
+
+#define BITS		16
+#define TABLESZ		(1 << BITS)
+#define TABLEMAX	(TABLESZ / 2)
+#define MASK		(TABLESZ - 1)
+
+enum {
+	SRC_L1,
+	SRC_L2,
+	SRC_LLC,
+	SRC_DRAM,
+	SRC_REMOTE,
+	SRC_OTHER,
+	MAX_SRC
+};
+
+static const char * const src_names[MAX_SRC] = {
+	"L1", "L2", "LLC", "DRAM", "remote", "other",
+};
+
+struct mem_stat {
+	__u64 cnt;
+	__u64 lat;
+	__u64 max_lat;
+	__u64 dram_cnt;
+	__u64 dram_lat;
+};
+
+static struct entry {
+	__u32 used;
+	__u64 key;
+	const char *sym;
+	const char *dso;
+	struct mem_stat stat;
+} syms[TABLESZ], regions[TABLESZ];
+
+static int sym_cnt, region_cnt;
+
+static struct node {
+	__u64 start;
+	__u64 end;
+	struct mem_stat stat;
+} nodes[MAX_NODES];
+
+static int node_cnt;
+
+static struct mem_stat srcs[MAX_SRC];
+static struct mem_stat total;
+
+/* Options, from --dlarg */
+static const char *event_name = "memory";
+static __u64 region_size = DEF_REGION;
+static int top = DEF_TOP;
+static bool keep;
+
+static void stat_add(struct mem_stat *s, __u64 lat, bool dram)
+{
+	s->cnt += 1;
+	s->lat += lat;
+	if (lat > s->max_lat)
+		s->max_lat = lat;
+	if (dram) {
+		s->dram_cnt += 1;
+		s->dram_lat += lat;
+	}
+}
+
+/*
+ * Neoverse cores report the level that served the access.  Others only
+ * report whether the L1D and the LLC were accessed or missed, so an L1D
+ * miss that did not reach the LLC is counted as served by the L2.
+ */
+static int data_source(__u64 val)
+{
+	union perf_mem_data_src src = { .val = val };
+
+	if (!val || src.mem_op == PERF_MEM_OP_NA)
+		return SRC_OTHER;
+
+	switch (src.mem_lvl_num) {
+	case PERF_MEM_LVLNUM_L1:
+		return SRC_L1;
+	case PERF_MEM_LVLNUM_L2:
+		return SRC_L2;
+	case PERF_MEM_LVLNUM_L3:
+		return SRC_LLC;
+	case PERF_MEM_LVLNUM_RAM:
+		return SRC_DRAM;
+	case PERF_MEM_LVLNUM_ANY_CACHE:
+		return SRC_REMOTE;
+	default:
+		break;
+	}
+
+	if (src.mem_lvl & PERF_MEM_LVL_REM_CCE1)
+		return SRC_REMOTE;
+	if (src.mem_lvl & PERF_MEM_LVL_L3)
+		return src.mem_lvl & PERF_MEM_LVL_MISS ? SRC_DRAM : SRC_LLC;
+	if (src.mem_lvl & PERF_MEM_LVL_L1)
+		return src.mem_lvl & PERF_MEM_LVL_MISS ? SRC_L2 : SRC_L1;
+	return SRC_OTHER;
+}
+
+static struct entry *find_entry(struct entry *table, int *cnt, __u64 key,
+				const char *sym, const char *dso)
+{
+	__u32 pos = (key ^ (key >> BITS) ^ (key >> (2 * BITS))) & MASK;
+	struct entry *e;
+
+	e = &table[pos];
+	while (e->used) {
+		if (e->key == key && e->sym == sym && e->dso == dso)
+			return e;
+		if (++pos == TABLESZ)
+			pos = 0;
+		e = &table[pos];
+	}
+
+	if (*cnt >= TABLEMAX)
+		return NULL;
+
+	*cnt += 1;
+	e->used = 1;
+	e->key = key;
+	e->sym = sym;
+	e->dso = dso;
+	return e;
+}
+
+static struct node *find_node(__u64 phys_addr)
+{
+	int i;
+
+	for (i = 0; i < node_cnt; i++)
+		if (phys_addr >= nodes[i].start && phys_addr < nodes[i].end)
+			return &nodes[i];
+	return NULL;
+}
+
+static int parse_node(const char *arg)
+{
+	char *end;
+
+	if (node_cnt >= MAX_NODES) {
+		fprintf(stderr, "spe-mem: too many nodes\n");
+		return -1;
+	}
+	nodes[node_cnt].start = strtoull(arg, &end, 0);
+	if (*end != '-')
+		goto err;
+	nodes[node_cnt].end = strtoull(end + 1, &end, 0);
+	if (*end || nodes[node_cnt].end <= nodes[node_cnt].start)
+		goto err;
+	node_cnt += 1;
+	return 0;
+err:
+	fprintf(stderr, "spe-mem: bad node range '%s'\n", arg);
+	return -1;
+}
+
+int start(void **data, void *ctx)
+{
+	int dlargc, i;
+	char **dlargv;
+
+	dlargv = perf_dlfilter_fns.args(ctx, &dlargc);
+	for (i = 0; i < dlargc; i++) {
+		const char *arg = dlargv[i];
+
+		if (!strncmp(arg, "event=", 6)) {
+			event_name = arg + 6;
+		} else if (!strncmp(arg, "region=", 7)) {
+			region_size = strtoull(arg + 7, NULL, 0) << 20;
+		} else if (!strncmp(arg, "top=", 4)) {
+			top = atoi(arg + 4);
+		} else if (!strncmp(arg, "node=", 5)) {
+			if (parse_node(arg + 5))
+				return -1;
+		} else if (!strcmp(arg, "keep")) {
+			keep = true;
+		} else {
+			fprintf(stderr, "spe-mem: unknown argument '%s'\n", arg);
+			return -1;
+		}
+	}
+	if (!region_size) {
+		fprintf(stderr, "spe-mem: region size must be at least 1 MiB\n");
+		return -1;
+	}
+	return 0;
+}
+
+int filter_event(void *data, const struct perf_dlfilter_sample *sample, void *ctx)
+{
+	const struct perf_dlfilter_al *al;
+	const char *sym = NULL, *dso = NULL;
+	__u64 lat = sample->weight;
+	struct entry *e;
+	struct node *n;
+	int src;
+	bool dram;
+
+	/* SPE synthesizes one sample per event an operation matched */
+	if (!sample->event || strcmp(sample->event, event_name))
+		return !keep;
+
+	src = data_source(sample->data_src);
+	dram = src == SRC_DRAM;
+	stat_add(&total, lat, dram);
+	stat_add(&srcs[src], lat, dram);
+
+	al = perf_dlfilter_fns.resolve_ip(ctx);
+	if (al) {
+		sym = al->sym;
+		dso = al->dso;
+	}
+	e = find_entry(syms, &sym_cnt, sym ? al->sym_start : 0, sym, dso);
+	if (e)
+		stat_add(&e->stat, lat, dram);
+
+	if (sample->phys_addr) {
+		e = find_entry(regions, &region_cnt,
+			       sample->phys_addr / region_size, NULL, NULL);
+		if (e)
+			stat_add(&e->stat, lat, dram);
+		n = find_node(sample->phys_addr);
+		if (n)
+			stat_add(&n->stat, lat, dram);
+	}
+
+	return !keep;
+}
+
+static int cmp_entry(const void *a, const void *b)
+{
+	const struct entry *ea = a, *eb = b;
+
+	if (ea->stat.lat != eb->stat.lat)
+		return ea->stat.lat < eb->stat.lat ? 1 : -1;
+	return 0;
+}
+
+static void print_stat_header(const char *what)
+{
+	printf("%-40s %10s %6s %8s %8s %6s %8s\n", what, "samples", "lat%",
+	       "avg_lat", "max_lat", "dram%", "dram_avg");
+}
+
+static void print_stat(const char *what, const struct mem_stat *s)
+{
+	printf("%-40s %10llu %6.2f %8.1f %8llu %6.2f %8.1f\n", what,
+	       (unsigned long long)s->cnt,
+	       total.lat ? 100.0 * s->lat / total.lat : 0.0,
+	       s->cnt ? (double)s->lat / s->cnt : 0.0,
+	       (unsigned long long)s->max_lat,
+	       s->cnt ? 100.0 * s->dram_cnt / s->cnt : 0.0,
+	       s->dram_cnt ? (double)s->dram_lat / s->dram_cnt : 0.0);
+}
+
+/* Sort the used entries to the front, by decreasing total latency */
+static int sort_entries(struct entry *table)
+{
+	int i, n = 0;
+
+	for (i = 0; i < TABLESZ; i++)
+		if (table[i].used)
+			table[n++] = table[i];
+	qsort(table, n, sizeof(*table), cmp_entry);
+	return n;
+}
+
+int stop(void *data, void *ctx)
+{
+	char name[64];
+	int i, n;
+
+	printf("\nSPE '%s' samples: %llu, latency in cycles\n\n", event_name,
+	       (unsigned long long)total.cnt);
+	if (!total.cnt)
+		return 0;
+
+	print_stat_header("data source");
+	for (i = 0; i < MAX_SRC; i++)
+		if (srcs[i].cnt)
+			print_stat(src_names[i], &srcs[i]);
+
+	n = sort_entries(syms);
+	printf("\n");
+	print_stat_header("symbol");
+	for (i = 0; i < n && i < top; i++) {
+		if (syms[i].sym)
+			snprintf(name, sizeof(name), "%s", syms[i].sym);
+		else
+			snprintf(name, sizeof(name), "[unknown] %s",
+				 syms[i].dso ? syms[i].dso : "");
+		print_stat(name, &syms[i].stat);
+	}
+
+	n = sort_entries(regions);
+	printf("\n");
+	print_stat_header("physical region");
+	for (i = 0; i < n && i < top; i++) {
+		snprintf(name, sizeof(name), "%#llx-%#llx",
+			 (unsigned long long)(regions[i].key * region_size),
+			 (unsigned long long)((regions[i].key + 1) * region_size - 1));
+		print_stat(name, &regions[i].stat);
+	}
+
+	if (node_cnt) {
+		printf("\n");
+		print_stat_header("node");
+		for (i = 0; i < node_cnt; i++) {
+			snprintf(name, sizeof(name), "%d %#llx-%#llx", i,
+				 (unsigned long long)nodes[i].start,
+				 (unsigned long long)nodes[i].end - 1);
+			print_stat(name, &nodes[i].stat);
+		}
+	}
+
+	if (sym_cnt >= TABLEMAX || region_cnt >= TABLEMAX)
+		fprintf(stderr, "spe-mem: too many symbols or regions, some were not counted\n");
+	return 0;
+}
+
+const char *filter_description(const char **long_description)
+{
+	static char *long_desc = "Latency of the memory operations sampled by "
+		"Arm SPE, by data source (L1, L2, LLC, DRAM), by symbol, by "
+		"physical region and by memory node, printed at the end. Only "
+		"the samples of one SPE event are counted, as SPE synthesizes "
+		"one sample per event an operation matched. Arguments: "
+		"event=NAME (default memory), region=MiB (default 64), "
+		"top=N (default 20), node=START-END (physical address range "
+		"of a memory node, may be repeated) and keep to print the "
+		"samples too. Record with "
+		"'perf record -e arm_spe/load_filter=1,store_filter=1,pa_enable=1,ts_enable=1/' "
+		"so physical addresses are available.";
+
+	*long_description = long_desc;
+	return "Memory latency report by data source, symbol, region and node";
+}
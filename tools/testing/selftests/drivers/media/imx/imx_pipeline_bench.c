@@ -0,0 +1,1665 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Throughput and latency of the i.MX multimedia pipelines
+ *
+ * Builds pipelines of V4L2 mem2mem devices (ISI, mxc-jpeg and the Chips&Media
+ * VPU), chained through dma-bufs and optionally ending on a DRM plane.  Each
+ * pipeline runs a fixed number of frames and reports:
+ *  - the frame rate at its sink, and the displayed frame rate if it ends on
+ *    a display;
+ *  - the latency percentiles, from queuing a frame at the source to its
+ *    dequeue at the sink or to the page flip that showed it;
+ *  - the system wide CPU usage, which includes the drivers' interrupts and
+ *    workers.
+ *
+ * The results are checked against the thresholds stored for the board in
+ * imx_pipeline_bench.conf, so that regressions fail the test.
+ *
+ * Usage: imx_pipeline_bench [-n frames] [-r fps] [-t thresholds] [-p]
+ *                           [pipeline...]
+ *
+ * By default, frames are queued as fast as the pipeline takes them, which
+ * measures throughput; -r paces the source to measure latency at a given
+ * frame rate instead.  -p prints threshold lines from the measured results,
+ * with some margin, to update the thresholds file.  Pipelines whose devices
+ * are missing are skipped.  Display pipelines need DRM master: stop any
+ * compositor first.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#include <drm/drm.h>
+#include <drm/drm_mode.h>
+#include <linux/videodev2.h>
+
+#include "../../../kselftest.h"
+
+#define DEFAULT_FRAMES		300
+#define WARMUP_FRAMES		10
+#define BITSTREAM_FRAMES	30
+#define BITSTREAM_SIZE		(2 << 20)
+#define STALL_US		3000000
+
+#define WIDTH			1920
+#define HEIGHT			1080
+
+#define MAX_STAGES		3
+#define MAX_BUFS		16
+#define NR_BUFS			4
+
+#define THRESHOLDS_FILE		"imx_pipeline_bench.conf"
+
+enum dev_kind {
+	DEV_ISI,
+	DEV_JPEG_ENC,
+	DEV_JPEG_DEC,
+	DEV_VPU_ENC,
+	DEV_VPU_DEC,
+	NR_KINDS
+};
+
+static const char *const kind_names[NR_KINDS] = {
+	[DEV_ISI]	= "ISI mem2mem",
+	[DEV_JPEG_ENC]	= "JPEG encoder",
+	[DEV_JPEG_DEC]	= "JPEG decoder",
+	[DEV_VPU_ENC]	= "VPU encoder",
+	[DEV_VPU_DEC]	= "VPU decoder",
+};
+
+static char dev_paths[NR_KINDS][32];
+
+struct stage_desc {
+	enum dev_kind kind;
+	uint32_t out_fmt;
+	uint32_t cap_fmt;
+	/* capture size, if scaling */
+	unsigned int width;
+	unsigned int height;
+};
+
+struct pipeline_desc {
+	const char *name;
+	unsigned int nr_stages;
+	struct stage_desc stages[MAX_STAGES];
+	bool display;
+	/* decoder pipelines: the stage that encodes their input beforehand */
+	const struct stage_desc *bitstream;
+};
+
+static const struct stage_desc jpeg_bitstream = {
+	DEV_JPEG_ENC, V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_JPEG,
+};
+
+static const struct stage_desc h264_bitstream = {
+	DEV_VPU_ENC, V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_H264,
+};
+
+/*
+ * V4L2 XBGR32 has the same memory layout and fourcc as DRM XRGB8888, and
+ * so do NV12 and YUYV in both APIs, so capture formats are used as they are
+ * for framebuffers.
+ */
+static const struct pipeline_desc pipelines[] = {
+	{
+		.name = "isi-csc",
+		.nr_stages = 1,
+		.stages = {
+			{ DEV_ISI, V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_NV12 },
+		},
+	}, {
+		.name = "isi-jpeg-enc",
+		.nr_stages = 2,
+		.stages = {
+			{ DEV_ISI, V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_YUYV,
+			  1280, 720 },
+			{ DEV_JPEG_ENC, V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_JPEG },
+		},
+	}, {
+		.name = "isi-vpu-enc",
+		.nr_stages = 2,
+		.stages = {
+			{ DEV_ISI, V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_NV12 },
+			{ DEV_VPU_ENC, V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_H264 },
+		},
+	}, {
+		.name = "isi-display",
+		.nr_stages = 1,
+		.stages = {
+			{ DEV_ISI, V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_XBGR32 },
+		},
+		.display = true,
+	}, {
+		.name = "jpeg-dec-display",
+		.nr_stages = 1,
+		.stages = {
+			{ DEV_JPEG_DEC, V4L2_PIX_FMT_JPEG, V4L2_PIX_FMT_NV12 },
+		},
+		.display = true,
+		.bitstream = &jpeg_bitstream,
+	}, {
+		.name = "jpeg-dec-isi-display",
+		.nr_stages = 2,
+		.stages = {
+			{ DEV_JPEG_DEC, V4L2_PIX_FMT_JPEG, V4L2_PIX_FMT_NV12 },
+			{ DEV_ISI, V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_XBGR32 },
+		},
+		.display = true,
+		.bitstream = &jpeg_bitstream,
+	}, {
+		.name = "vpu-dec-display",
+		.nr_stages = 1,
+		.stages = {
+			{ DEV_VPU_DEC, V4L2_PIX_FMT_H264, V4L2_PIX_FMT_NV12 },
+		},
+		.display = true,
+		.bitstream = &h264_bitstream,
+	}, {
+		.name = "vpu-dec-isi-display",
+		.nr_stages = 2,
+		.stages = {
+			{ DEV_VPU_DEC, V4L2_PIX_FMT_H264, V4L2_PIX_FMT_NV12 },
+			{ DEV_ISI, V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_XBGR32 },
+		},
+		.display = true,
+		.bitstream = &h264_bitstream,
+	},
+};
+
+enum { Q_OUT, Q_CAP };
+
+static const uint32_t queue_types[] = {
+	[Q_OUT] = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE,
+	[Q_CAP] = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE,
+};
+
+struct buffer {
+	void *mem;
+	size_t length;
+	int dmabuf;
+	uint32_t fb_id;
+	uint32_t handle;
+	struct timeval ts;
+};
+
+struct stage {
+	const struct stage_desc *desc;
+	int fd;
+	bool decoder;
+	/* false until a decoder found the format of the stream */
+	bool cap_ready;
+	bool streaming[2];
+	struct v4l2_format fmt[2];
+	uint32_t memory[2];
+	unsigned int nr_bufs[2];
+	struct buffer bufs[2][MAX_BUFS];
+};
+
+struct bitstream {
+	unsigned int nr;
+	void *data[BITSTREAM_FRAMES];
+	uint32_t size[BITSTREAM_FRAMES];
+};
+
+static struct bitstream bitstreams[NR_KINDS];
+
+struct run {
+	const struct pipeline_desc *desc;
+	unsigned int nr_stages;
+	struct stage stages[MAX_STAGES];
+	unsigned int frames;
+	unsigned int warmup;
+	unsigned int rate;
+	/* encode into this instead of measuring */
+	struct bitstream *collect;
+	/* decode this, else generate raw frames */
+	struct bitstream *source;
+
+	uint32_t free_out;
+	unsigned int queued;
+	unsigned int done;
+	uint64_t next_due;
+	uint64_t last_progress;
+
+	/* display: the buffers on screen, being flipped to and next */
+	int shown;
+	int flipping;
+	int waiting;
+	unsigned int displayed;
+	unsigned int dropped;
+
+	uint32_t *latency;
+	unsigned int nr_latency;
+	uint64_t t0, t1;
+	uint64_t busy0, total0, busy1, total1;
+	unsigned int displayed0;
+};
+
+struct result {
+	double fps;
+	double display_fps;
+	double p50, p90, p99, max;
+	double cpu;
+};
+
+struct threshold {
+	double min_fps;
+	double max_p99_ms;
+	double max_cpu;
+};
+
+struct display {
+	int fd;
+	uint32_t crtc_id;
+	unsigned int crtc_index;
+	uint32_t conn_id;
+	struct drm_mode_modeinfo mode;
+	uint32_t mode_blob;
+	/* the CRTC is off, enable it with the first commit */
+	bool modeset;
+
+	uint32_t plane_id;
+	uint32_t fb_prop, crtc_prop;
+	uint32_t src_x_prop, src_y_prop, src_w_prop, src_h_prop;
+	uint32_t crtc_x_prop, crtc_y_prop, crtc_w_prop, crtc_h_prop;
+	uint32_t active_prop, mode_id_prop, conn_crtc_prop;
+	uint32_t src_w, src_h, crtc_x, crtc_y;
+};
+
+static struct display disp = { .fd = -1 };
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void read_cpu(uint64_t *busy, uint64_t *total)
+{
+	unsigned long long v[8] = {};
+	FILE *f;
+	int i;
+
+	*busy = *total = 0;
+	f = fopen("/proc/stat", "r");
+	if (!f)
+		return;
+	if (fscanf(f, "cpu %llu %llu %llu %llu %llu %llu %llu %llu", &v[0],
+		   &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) == 8) {
+		for (i = 0; i < 8; i++)
+			*total += v[i];
+		/* all but idle and iowait */
+		*busy = *total - v[3] - v[4];
+	}
+	fclose(f);
+}
+
+/* -----------------------------------------------------------------------------
+ * V4L2
+ */
+
+static enum dev_kind jpeg_kind(int fd)
+{
+	struct v4l2_fmtdesc fmt = { .type = queue_types[Q_OUT] };
+
+	for (; !ioctl(fd, VIDIOC_ENUM_FMT, &fmt); fmt.index++)
+		if (fmt.pixelformat == V4L2_PIX_FMT_JPEG)
+			return DEV_JPEG_DEC;
+	return DEV_JPEG_ENC;
+}
+
+static void find_devices(void)
+{
+	struct v4l2_capability cap;
+	char path[32];
+	size_t len;
+	int i, fd;
+	int kind;
+
+	for (i = 0; i < 64; i++) {
+		snprintf(path, sizeof(path), "/dev/video%d", i);
+		fd = open(path, O_RDWR | O_NONBLOCK);
+		if (fd < 0)
+			continue;
+
+		memset(&cap, 0, sizeof(cap));
+		if (ioctl(fd, VIDIOC_QUERYCAP, &cap) ||
+		    !(cap.device_caps & V4L2_CAP_VIDEO_M2M_MPLANE)) {
+			close(fd);
+			continue;
+		}
+
+		len = strlen((char *)cap.driver);
+		kind = -1;
+		if (!strcmp((char *)cap.driver, "mxc-isi") &&
+		    !strcmp((char *)cap.card, "mxc-isi-m2m"))
+			kind = DEV_ISI;
+		else if (!strcmp((char *)cap.driver, "mxc-jpeg codec"))
+			kind = jpeg_kind(fd);
+		else if (!strncmp((char *)cap.driver, "wave", 4) && len > 4 &&
+			 !strcmp((char *)cap.driver + len - 4, "-enc"))
+			kind = DEV_VPU_ENC;
+		else if (!strncmp((char *)cap.driver, "wave", 4) && len > 4 &&
+			 !strcmp((char *)cap.driver + len - 4, "-dec"))
+			kind = DEV_VPU_DEC;
+		close(fd);
+
+		if (kind >= 0 && !dev_paths[kind][0]) {
+			strcpy(dev_paths[kind], path);
+			ksft_print_msg("%s: %s (%s)\n", kind_names[kind],
+				       path, cap.driver);
+		}
+	}
+}
+
+static bool is_compressed(uint32_t fourcc)
+{
+	return fourcc == V4L2_PIX_FMT_JPEG || fourcc == V4L2_PIX_FMT_H264;
+}
+
+static int set_format(struct stage *st, int q, uint32_t fourcc,
+		      unsigned int width, unsigned int height,
+		      uint32_t bytesperline, uint32_t sizeimage)
+{
+	struct v4l2_pix_format_mplane *pix = &st->fmt[q].fmt.pix_mp;
+
+	memset(&st->fmt[q], 0, sizeof(st->fmt[q]));
+	st->fmt[q].type = queue_types[q];
+	pix->width = width;
+	pix->height = height;
+	pix->pixelformat = fourcc;
+	pix->field = V4L2_FIELD_NONE;
+	pix->num_planes = 1;
+	pix->plane_fmt[0].bytesperline = bytesperline;
+	pix->plane_fmt[0].sizeimage = sizeimage;
+
+	if (ioctl(st->fd, VIDIOC_S_FMT, &st->fmt[q]))
+		return -errno;
+	if (pix->pixelformat != fourcc || pix->num_planes != 1)
+		return -EINVAL;
+	return 0;
+}
+
+static int request_bufs(struct stage *st, int q, unsigned int count,
+			uint32_t memory, bool map, bool export)
+{
+	struct v4l2_requestbuffers req = {
+		.count = count,
+		.type = queue_types[q],
+		.memory = memory,
+	};
+	struct v4l2_exportbuffer exp;
+	struct v4l2_buffer buf;
+	struct v4l2_plane plane;
+	struct buffer *b;
+	unsigned int i;
+
+	if (ioctl(st->fd, VIDIOC_REQBUFS, &req))
+		return -errno;
+	/* the indices of dma-buf queues match those of the exporter */
+	if (req.count > MAX_BUFS ||
+	    (memory == V4L2_MEMORY_DMABUF && req.count < count))
+		return -ENOBUFS;
+	st->nr_bufs[q] = req.count;
+	st->memory[q] = memory;
+
+	for (i = 0; i < req.count; i++) {
+		b = &st->bufs[q][i];
+		b->dmabuf = -1;
+		if (memory != V4L2_MEMORY_MMAP)
+			continue;
+
+		memset(&buf, 0, sizeof(buf));
+		memset(&plane, 0, sizeof(plane));
+		buf.type = queue_types[q];
+		buf.memory = memory;
+		buf.index = i;
+		buf.m.planes = &plane;
+		buf.length = 1;
+		if (ioctl(st->fd, VIDIOC_QUERYBUF, &buf))
+			return -errno;
+		b->length = plane.length;
+
+		if (map) {
+			b->mem = mmap(NULL, plane.length,
+				      PROT_READ | PROT_WRITE, MAP_SHARED,
+				      st->fd, plane.m.mem_offset);
+			if (b->mem == MAP_FAILED) {
+				b->mem = NULL;
+				return -errno;
+			}
+		}
+
+		if (export) {
+			memset(&exp, 0, sizeof(exp));
+			exp.type = queue_types[q];
+			exp.index = i;
+			exp.flags = O_RDWR | O_CLOEXEC;
+			if (ioctl(st->fd, VIDIOC_EXPBUF, &exp))
+				return -errno;
+			b->dmabuf = exp.fd;
+		}
+	}
+	return 0;
+}
+
+static int queue_buf(struct stage *st, int q, unsigned int index,
+		     uint32_t bytesused, const struct timeval *ts)
+{
+	struct v4l2_plane plane = { .bytesused = bytesused };
+	struct v4l2_buffer buf = {
+		.type = queue_types[q],
+		.memory = st->memory[q],
+		.index = index,
+		.m.planes = &plane,
+		.length = 1,
+	};
+
+	if (st->memory[q] == V4L2_MEMORY_DMABUF)
+		plane.m.fd = st->bufs[q][index].dmabuf;
+	if (ts)
+		buf.timestamp = *ts;
+
+	return ioctl(st->fd, VIDIOC_QBUF, &buf) ? -errno : 0;
+}
+
+/* Returns 1 if a buffer was dequeued, 0 if there was none */
+static int dequeue_buf(struct stage *st, int q, struct v4l2_buffer *buf,
+		       struct v4l2_plane *plane)
+{
+	memset(buf, 0, sizeof(*buf));
+	memset(plane, 0, sizeof(*plane));
+	buf->type = queue_types[q];
+	buf->memory = st->memory[q];
+	buf->m.planes = plane;
+	buf->length = 1;
+
+	if (!ioctl(st->fd, VIDIOC_DQBUF, buf))
+		return 1;
+	return errno == EAGAIN ? 0 : -errno;
+}
+
+static int stream_on(struct stage *st, int q)
+{
+	int type = queue_types[q];
+
+	if (ioctl(st->fd, VIDIOC_STREAMON, &type))
+		return -errno;
+	st->streaming[q] = true;
+	return 0;
+}
+
+static void set_ctrl(int fd, uint32_t id, int32_t value)
+{
+	struct v4l2_control ctrl = { .id = id, .value = value };
+
+	/* not all encoders have all of them, the defaults do as well */
+	ioctl(fd, VIDIOC_S_CTRL, &ctrl);
+}
+
+/* Colour bars, shifted by the frame number so that encoders see motion */
+static void fill_pattern(struct buffer *b, const struct v4l2_format *fmt,
+			 unsigned int frame)
+{
+	const struct v4l2_pix_format_mplane *pix = &fmt->fmt.pix_mp;
+	uint32_t bpl = pix->plane_fmt[0].bytesperline;
+	uint8_t *p = b->mem;
+	unsigned int x, y, v;
+
+	if (!p)
+		return;
+
+	for (y = 0; y < pix->height; y++) {
+		for (x = 0; x < pix->width; x++) {
+			v = ((x + frame * 8) * 8 / pix->width) * 32 + 16;
+			if (pix->pixelformat == V4L2_PIX_FMT_YUYV) {
+				p[y * bpl + x * 2] = v;
+				p[y * bpl + x * 2 + 1] = x & 1 ? 96 : 160;
+			} else {
+				p[y * bpl + x] = v;
+			}
+		}
+	}
+	if (pix->pixelformat == V4L2_PIX_FMT_NV12)
+		memset(p + bpl * pix->height, 128, bpl * pix->height / 2);
+}
+
+static int display_attach(struct run *run);
+
+static int setup_capture(struct run *run, unsigned int i);
+
+static int setup_stage(struct run *run, unsigned int i)
+{
+	const struct stage_desc *desc = &run->desc->stages[i];
+	struct stage *st = &run->stages[i];
+	const struct v4l2_pix_format_mplane *in;
+	struct v4l2_event_subscription sub = {
+		.type = V4L2_EVENT_SOURCE_CHANGE,
+	};
+	unsigned int width, height;
+	struct stage *prev;
+	unsigned int j;
+	int ret;
+
+	st->desc = desc;
+	st->decoder = is_compressed(desc->out_fmt);
+	st->fd = open(dev_paths[desc->kind], O_RDWR | O_NONBLOCK);
+	if (st->fd < 0)
+		return -errno;
+
+	if (!i) {
+		width = WIDTH;
+		height = HEIGHT;
+		ret = set_format(st, Q_OUT, desc->out_fmt, width, height, 0,
+				 st->decoder ? BITSTREAM_SIZE : 0);
+	} else {
+		prev = &run->stages[i - 1];
+		in = &prev->fmt[Q_CAP].fmt.pix_mp;
+		width = in->width;
+		height = in->height;
+		ret = set_format(st, Q_OUT, in->pixelformat, width, height,
+				 in->plane_fmt[0].bytesperline,
+				 in->plane_fmt[0].sizeimage);
+	}
+	if (ret)
+		return ret;
+
+	if (st->decoder) {
+		if (ioctl(st->fd, VIDIOC_SUBSCRIBE_EVENT, &sub))
+			return -errno;
+	} else {
+		ret = set_format(st, Q_CAP, desc->cap_fmt,
+				 desc->width ? : width, desc->height ? : height,
+				 0, is_compressed(desc->cap_fmt) ?
+				 BITSTREAM_SIZE : 0);
+		if (ret)
+			return ret;
+	}
+
+	if (desc->kind == DEV_VPU_ENC) {
+		set_ctrl(st->fd, V4L2_CID_MPEG_VIDEO_GOP_SIZE,
+			 BITSTREAM_FRAMES);
+		set_ctrl(st->fd, V4L2_CID_MPEG_VIDEO_B_FRAMES, 0);
+		set_ctrl(st->fd, V4L2_CID_MPEG_VIDEO_HEADER_MODE,
+			 V4L2_MPEG_VIDEO_HEADER_MODE_JOINED_WITH_1ST_FRAME);
+		set_ctrl(st->fd, V4L2_CID_MPEG_VIDEO_PREPEND_SPSPPS_TO_IDR, 1);
+	}
+
+	if (!i) {
+		ret = request_bufs(st, Q_OUT, NR_BUFS, V4L2_MEMORY_MMAP, true,
+				   false);
+		if (ret)
+			return ret;
+		run->free_out = (1U << st->nr_bufs[Q_OUT]) - 1;
+		if (!st->decoder)
+			for (j = 0; j < st->nr_bufs[Q_OUT]; j++)
+				fill_pattern(&st->bufs[Q_OUT][j],
+					     &st->fmt[Q_OUT], j);
+	} else {
+		prev = &run->stages[i - 1];
+		ret = request_bufs(st, Q_OUT, prev->nr_bufs[Q_CAP],
+				   V4L2_MEMORY_DMABUF, false, false);
+		if (ret)
+			return ret;
+		for (j = 0; j < prev->nr_bufs[Q_CAP]; j++)
+			st->bufs[Q_OUT][j].dmabuf =
+				prev->bufs[Q_CAP][j].dmabuf;
+	}
+
+	ret = stream_on(st, Q_OUT);
+	if (ret)
+		return ret;
+
+	/* decoders set up their capture queue once they know the format */
+	return st->decoder ? 0 : setup_capture(run, i);
+}
+
+static int setup_capture(struct run *run, unsigned int i)
+{
+	struct stage *st = &run->stages[i];
+	bool last = i + 1 == run->nr_stages;
+	struct v4l2_control ctrl = {
+		.id = V4L2_CID_MIN_BUFFERS_FOR_CAPTURE,
+	};
+	struct v4l2_format fmt;
+	unsigned int count = NR_BUFS, j;
+	int ret;
+
+	if (st->decoder) {
+		memset(&fmt, 0, sizeof(fmt));
+		fmt.type = queue_types[Q_CAP];
+		if (ioctl(st->fd, VIDIOC_G_FMT, &fmt))
+			return -errno;
+		st->fmt[Q_CAP] = fmt;
+		/* keep the decoder's choice if it can't give the one wanted */
+		if (fmt.fmt.pix_mp.pixelformat != st->desc->cap_fmt &&
+		    set_format(st, Q_CAP, st->desc->cap_fmt,
+			       fmt.fmt.pix_mp.width, fmt.fmt.pix_mp.height,
+			       0, 0))
+			st->fmt[Q_CAP] = fmt;
+		if (st->fmt[Q_CAP].fmt.pix_mp.num_planes != 1)
+			return -EINVAL;
+		if (!ioctl(st->fd, VIDIOC_G_CTRL, &ctrl) &&
+		    ctrl.value + 2 > (int)count)
+			count = ctrl.value + 2;
+	}
+
+	ret = request_bufs(st, Q_CAP, count, V4L2_MEMORY_MMAP,
+			   last && run->collect, !last || run->desc->display);
+	if (ret)
+		return ret;
+
+	ret = stream_on(st, Q_CAP);
+	if (ret)
+		return ret;
+	for (j = 0; j < st->nr_bufs[Q_CAP]; j++) {
+		ret = queue_buf(st, Q_CAP, j, 0, NULL);
+		if (ret)
+			return ret;
+	}
+	st->cap_ready = true;
+
+	if (!last)
+		return setup_stage(run, i + 1);
+	return run->desc->display ? display_attach(run) : 0;
+}
+
+static void teardown_stage(struct stage *st)
+{
+	struct buffer *b;
+	unsigned int q, j;
+	int type;
+
+	if (st->fd < 0)
+		return;
+
+	for (q = Q_OUT; q <= Q_CAP; q++) {
+		type = queue_types[q];
+		if (st->streaming[q])
+			ioctl(st->fd, VIDIOC_STREAMOFF, &type);
+		for (j = 0; j < st->nr_bufs[q]; j++) {
+			b = &st->bufs[q][j];
+			if (b->mem)
+				munmap(b->mem, b->length);
+			/* dma-buf queues only borrow the exporter's fds */
+			if (b->dmabuf >= 0 && st->memory[q] == V4L2_MEMORY_MMAP)
+				close(b->dmabuf);
+		}
+	}
+	close(st->fd);
+	st->fd = -1;
+}
+
+/* -----------------------------------------------------------------------------
+ * DRM
+ */
+
+static uint32_t prop_id(uint32_t obj_id, uint32_t obj_type, const char *name)
+{
+	struct drm_mode_obj_get_properties props = {
+		.obj_id = obj_id,
+		.obj_type = obj_type,
+	};
+	struct drm_mode_get_property prop;
+	uint64_t values[64];
+	uint32_t ids[64];
+	unsigned int i;
+
+	if (ioctl(disp.fd, DRM_IOCTL_MODE_OBJ_GETPROPERTIES, &props))
+		return 0;
+	if (props.count_props > 64)
+		props.count_props = 64;
+	props.props_ptr = (uintptr_t)ids;
+	props.prop_values_ptr = (uintptr_t)values;
+	if (ioctl(disp.fd, DRM_IOCTL_MODE_OBJ_GETPROPERTIES, &props))
+		return 0;
+
+	for (i = 0; i < props.count_props; i++) {
+		memset(&prop, 0, sizeof(prop));
+		prop.prop_id = ids[i];
+		if (!ioctl(disp.fd, DRM_IOCTL_MODE_GETPROPERTY, &prop) &&
+		    !strcmp(prop.name, name))
+			return ids[i];
+	}
+	return 0;
+}
+
+/* Pick the first connected connector, and the CRTC driving it */
+static int display_find_output(void)
+{
+	struct drm_mode_card_res res = {};
+	struct drm_mode_get_connector conn;
+	struct drm_mode_get_encoder enc;
+	struct drm_mode_modeinfo *modes;
+	struct drm_mode_crtc crtc;
+	uint32_t crtcs[32], conns[32];
+	unsigned int i, j;
+
+	if (ioctl(disp.fd, DRM_IOCTL_MODE_GETRESOURCES, &res))
+		return -errno;
+	res.count_crtcs = res.count_crtcs < 32 ? res.count_crtcs : 32;
+	res.count_connectors = res.count_connectors < 32 ?
+			       res.count_connectors : 32;
+	res.count_encoders = 0;
+	res.count_fbs = 0;
+	res.crtc_id_ptr = (uintptr_t)crtcs;
+	res.connector_id_ptr = (uintptr_t)conns;
+	if (ioctl(disp.fd, DRM_IOCTL_MODE_GETRESOURCES, &res))
+		return -errno;
+
+	for (i = 0; i < res.count_connectors; i++) {
+		memset(&conn, 0, sizeof(conn));
+		conn.connector_id = conns[i];
+		if (ioctl(disp.fd, DRM_IOCTL_MODE_GETCONNECTOR, &conn) ||
+		    conn.connection != 1 || !conn.count_modes ||
+		    !conn.encoder_id)
+			continue;
+
+		modes = calloc(conn.count_modes, sizeof(*modes));
+		if (!modes)
+			return -ENOMEM;
+		conn.count_props = 0;
+		conn.count_encoders = 0;
+		conn.modes_ptr = (uintptr_t)modes;
+		if (ioctl(disp.fd, DRM_IOCTL_MODE_GETCONNECTOR, &conn)) {
+			free(modes);
+			continue;
+		}
+		disp.mode = modes[0];
+		for (j = 0; j < conn.count_modes; j++) {
+			if (modes[j].type & DRM_MODE_TYPE_PREFERRED) {
+				disp.mode = modes[j];
+				break;
+			}
+		}
+		free(modes);
+
+		memset(&enc, 0, sizeof(enc));
+		enc.encoder_id = conn.encoder_id;
+		if (ioctl(disp.fd, DRM_IOCTL_MODE_GETENCODER, &enc))
+			continue;
+		disp.crtc_id = enc.crtc_id;
+		for (j = 0; j < res.count_crtcs; j++) {
+			if (!disp.crtc_id && (enc.possible_crtcs & (1U << j)))
+				disp.crtc_id = crtcs[j];
+			if (crtcs[j] == disp.crtc_id)
+				break;
+		}
+		if (j == res.count_crtcs)
+			continue;
+		disp.crtc_index = j;
+		disp.conn_id = conns[i];
+
+		memset(&crtc, 0, sizeof(crtc));
+		crtc.crtc_id = disp.crtc_id;
+		if (!ioctl(disp.fd, DRM_IOCTL_MODE_GETCRTC, &crtc) &&
+		    crtc.mode_valid)
+			disp.mode = crtc.mode;
+		else
+			disp.modeset = true;
+		return 0;
+	}
+	return -ENODEV;
+}
+
+static int display_init(void)
+{
+	struct drm_set_client_cap cap;
+	struct drm_mode_create_blob blob = {
+		.data = (uintptr_t)&disp.mode,
+		.length = sizeof(disp.mode),
+	};
+	char path[32];
+	int i, ret = -ENODEV;
+
+	for (i = 0; i < 8; i++) {
+		snprintf(path, sizeof(path), "/dev/dri/card%d", i);
+		disp.fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+		if (disp.fd < 0)
+			continue;
+
+		cap.capability = DRM_CLIENT_CAP_UNIVERSAL_PLANES;
+		cap.value = 1;
+		if (!ioctl(disp.fd, DRM_IOCTL_SET_CLIENT_CAP, &cap)) {
+			cap.capability = DRM_CLIENT_CAP_ATOMIC;
+			if (!ioctl(disp.fd, DRM_IOCTL_SET_CLIENT_CAP, &cap))
+				ret = display_find_output();
+		}
+		if (!ret)
+			break;
+		close(disp.fd);
+		disp.fd = -1;
+	}
+	if (ret)
+		return ret;
+
+	if (ioctl(disp.fd, DRM_IOCTL_SET_MASTER, 0))
+		return -EBUSY;
+
+	disp.active_prop = prop_id(disp.crtc_id, DRM_MODE_OBJECT_CRTC,
+				   "ACTIVE");
+	disp.mode_id_prop = prop_id(disp.crtc_id, DRM_MODE_OBJECT_CRTC,
+				    "MODE_ID");
+	disp.conn_crtc_prop = prop_id(disp.conn_id, DRM_MODE_OBJECT_CONNECTOR,
+				      "CRTC_ID");
+	if (disp.modeset &&
+	    ioctl(disp.fd, DRM_IOCTL_MODE_CREATEPROPBLOB, &blob))
+		return -errno;
+	disp.mode_blob = blob.blob_id;
+
+	ksft_print_msg("display: %s, %ux%u@%u\n", path, disp.mode.hdisplay,
+		       disp.mode.vdisplay, disp.mode.vrefresh);
+	return 0;
+}
+
+static uint32_t display_find_plane(uint32_t fourcc)
+{
+	struct drm_mode_get_plane_res res = {};
+	struct drm_mode_get_plane plane;
+	uint32_t ids[64], formats[128];
+	unsigned int i, j;
+
+	if (ioctl(disp.fd, DRM_IOCTL_MODE_GETPLANERESOURCES, &res))
+		return 0;
+	if (res.count_planes > 64)
+		res.count_planes = 64;
+	res.plane_id_ptr = (uintptr_t)ids;
+	if (ioctl(disp.fd, DRM_IOCTL_MODE_GETPLANERESOURCES, &res))
+		return 0;
+
+	for (i = 0; i < res.count_planes; i++) {
+		memset(&plane, 0, sizeof(plane));
+		plane.plane_id = ids[i];
+		if (ioctl(disp.fd, DRM_IOCTL_MODE_GETPLANE, &plane) ||
+		    !(plane.possible_crtcs & (1U << disp.crtc_index)))
+			continue;
+		if (plane.count_format_types > 128)
+			plane.count_format_types = 128;
+		plane.format_type_ptr = (uintptr_t)formats;
+		if (ioctl(disp.fd, DRM_IOCTL_MODE_GETPLANE, &plane))
+			continue;
+		for (j = 0; j < plane.count_format_types; j++)
+			if (formats[j] == fourcc)
+				return ids[i];
+	}
+	return 0;
+}
+
+/* Create framebuffers for the capture buffers of the last stage */
+static int display_attach(struct run *run)
+{
+	struct stage *st = &run->stages[run->nr_stages - 1];
+	const struct v4l2_pix_format_mplane *pix = &st->fmt[Q_CAP].fmt.pix_mp;
+	uint32_t bpl = pix->plane_fmt[0].bytesperline;
+	struct drm_prime_handle prime;
+	struct drm_mode_fb_cmd2 fb;
+	struct buffer *b;
+	unsigned int j;
+
+	disp.plane_id = display_find_plane(pix->pixelformat);
+	if (!disp.plane_id) {
+		ksft_print_msg("no plane for %.4s\n",
+			       (char *)&pix->pixelformat);
+		return -EINVAL;
+	}
+
+	disp.fb_prop = prop_id(disp.plane_id, DRM_MODE_OBJECT_PLANE, "FB_ID");
+	disp.crtc_prop = prop_id(disp.plane_id, DRM_MODE_OBJECT_PLANE,
+				 "CRTC_ID");
+	disp.src_x_prop = prop_id(disp.plane_id, DRM_MODE_OBJECT_PLANE,
+				  "SRC_X");
+	disp.src_y_prop = prop_id(disp.plane_id, DRM_MODE_OBJECT_PLANE,
+				  "SRC_Y");
+	disp.src_w_prop = prop_id(disp.plane_id, DRM_MODE_OBJECT_PLANE,
+				  "SRC_W");
+	disp.src_h_prop = prop_id(disp.plane_id, DRM_MODE_OBJECT_PLANE,
+				  "SRC_H");
+	disp.crtc_x_prop = prop_id(disp.plane_id, DRM_MODE_OBJECT_PLANE,
+				   "CRTC_X");
+	disp.crtc_y_prop = prop_id(disp.plane_id, DRM_MODE_OBJECT_PLANE,
+				   "CRTC_Y");
+	disp.crtc_w_prop = prop_id(disp.plane_id, DRM_MODE_OBJECT_PLANE,
+				   "CRTC_W");
+	disp.crtc_h_prop = prop_id(disp.plane_id, DRM_MODE_OBJECT_PLANE,
+				   "CRTC_H");
+
+	/* unscaled, centered and cropped to the mode */
+	disp.src_w = pix->width < disp.mode.hdisplay ? pix->width :
+		     disp.mode.hdisplay;
+	disp.src_h = pix->height < disp.mode.vdisplay ? pix->height :
+		     disp.mode.vdisplay;
+	disp.crtc_x = (disp.mode.hdisplay - disp.src_w) / 2;
+	disp.crtc_y = (disp.mode.vdisplay - disp.src_h) / 2;
+
+	for (j = 0; j < st->nr_bufs[Q_CAP]; j++) {
+		b = &st->bufs[Q_CAP][j];
+
+		memset(&prime, 0, sizeof(prime));
+		prime.fd = b->dmabuf;
+		if (ioctl(disp.fd, DRM_IOCTL_PRIME_FD_TO_HANDLE, &prime))
+			return -errno;
+		b->handle = prime.handle;
+
+		memset(&fb, 0, sizeof(fb));
+		fb.width = pix->width;
+		fb.height = pix->height;
+		fb.pixel_format = pix->pixelformat;
+		fb.handles[0] = b->handle;
+		fb.pitches[0] = bpl;
+		if (pix->pixelformat == V4L2_PIX_FMT_NV12) {
+			fb.handles[1] = b->handle;
+			fb.pitches[1] = bpl;
+			fb.offsets[1] = bpl * pix->height;
+		}
+		if (ioctl(disp.fd, DRM_IOCTL_MODE_ADDFB2, &fb))
+			return -errno;
+		b->fb_id = fb.fb_id;
+	}
+	return 0;
+}
+
+static void display_detach(struct run *run)
+{
+	struct stage *st = &run->stages[run->nr_stages - 1];
+	struct drm_gem_close close_args;
+	struct buffer *b;
+	unsigned int j;
+
+	for (j = 0; j < st->nr_bufs[Q_CAP]; j++) {
+		b = &st->bufs[Q_CAP][j];
+		/* removing the framebuffer on screen disables the plane */
+		if (b->fb_id)
+			ioctl(disp.fd, DRM_IOCTL_MODE_RMFB, &b->fb_id);
+		if (b->handle) {
+			memset(&close_args, 0, sizeof(close_args));
+			close_args.handle = b->handle;
+			ioctl(disp.fd, DRM_IOCTL_GEM_CLOSE, &close_args);
+		}
+		b->fb_id = 0;
+		b->handle = 0;
+	}
+}
+
+static int display_commit(struct run *run, unsigned int index)
+{
+	struct stage *st = &run->stages[run->nr_stages - 1];
+	uint32_t objs[3], counts[3], props[16];
+	uint64_t values[16];
+	struct drm_mode_atomic atomic = {
+		.flags = DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK,
+		.user_data = index,
+	};
+	unsigned int nr_objs = 0, n = 0, first;
+
+#define ADD_PROP(p, v) do { props[n] = (p); values[n++] = (v); } while (0)
+
+	first = n;
+	objs[nr_objs] = disp.plane_id;
+	ADD_PROP(disp.fb_prop, st->bufs[Q_CAP][index].fb_id);
+	ADD_PROP(disp.crtc_prop, disp.crtc_id);
+	ADD_PROP(disp.src_x_prop, 0);
+	ADD_PROP(disp.src_y_prop, 0);
+	ADD_PROP(disp.src_w_prop, (uint64_t)disp.src_w << 16);
+	ADD_PROP(disp.src_h_prop, (uint64_t)disp.src_h << 16);
+	ADD_PROP(disp.crtc_x_prop, disp.crtc_x);
+	ADD_PROP(disp.crtc_y_prop, disp.crtc_y);
+	ADD_PROP(disp.crtc_w_prop, disp.src_w);
+	ADD_PROP(disp.crtc_h_prop, disp.src_h);
+	counts[nr_objs++] = n - first;
+
+	if (disp.modeset) {
+		first = n;
+		objs[nr_objs] = disp.crtc_id;
+		ADD_PROP(disp.active_prop, 1);
+		ADD_PROP(disp.mode_id_prop, disp.mode_blob);
+		counts[nr_objs++] = n - first;
+
+		first = n;
+		objs[nr_objs] = disp.conn_id;
+		ADD_PROP(disp.conn_crtc_prop, disp.crtc_id);
+		counts[nr_objs++] = n - first;
+
+		atomic.flags |= DRM_MODE_ATOMIC_ALLOW_MODESET;
+	}
+
+#undef ADD_PROP
+
+	atomic.count_objs = nr_objs;
+	atomic.objs_ptr = (uintptr_t)objs;
+	atomic.count_props_ptr = (uintptr_t)counts;
+	atomic.props_ptr = (uintptr_t)props;
+	atomic.prop_values_ptr = (uintptr_t)values;
+	if (ioctl(disp.fd, DRM_IOCTL_MODE_ATOMIC, &atomic))
+		return -errno;
+
+	disp.modeset = false;
+	run->flipping = index;
+	return 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Pipeline
+ */
+
+static void start_measure(struct run *run)
+{
+	run->t0 = now_us();
+	run->displayed0 = run->displayed;
+	read_cpu(&run->busy0, &run->total0);
+}
+
+static void record_latency(struct run *run, const struct timeval *ts)
+{
+	uint64_t t = ts->tv_sec * 1000000ULL + ts->tv_usec;
+
+	if (run->done > run->warmup && run->nr_latency < run->frames)
+		run->latency[run->nr_latency++] = now_us() - t;
+}
+
+static int release_sink_buf(struct run *run, unsigned int index)
+{
+	return queue_buf(&run->stages[run->nr_stages - 1], Q_CAP, index, 0,
+			 NULL);
+}
+
+/*
+ * Frames wait for the page flip in flight in a mailbox of one: a newer
+ * frame replaces the one waiting, which is dropped.
+ */
+static int display_frame(struct run *run, unsigned int index)
+{
+	int ret;
+
+	if (run->flipping < 0)
+		return display_commit(run, index);
+
+	if (run->waiting >= 0) {
+		run->dropped++;
+		ret = release_sink_buf(run, run->waiting);
+		if (ret)
+			return ret;
+	}
+	run->waiting = index;
+	return 0;
+}
+
+static int display_flipped(struct run *run)
+{
+	struct stage *st = &run->stages[run->nr_stages - 1];
+	int ret;
+
+	if (run->flipping < 0)
+		return 0;
+
+	run->displayed++;
+	record_latency(run, &st->bufs[Q_CAP][run->flipping].ts);
+	if (run->shown >= 0) {
+		ret = release_sink_buf(run, run->shown);
+		if (ret)
+			return ret;
+	}
+	run->shown = run->flipping;
+	run->flipping = -1;
+
+	if (run->waiting < 0)
+		return 0;
+	ret = display_commit(run, run->waiting);
+	run->waiting = -1;
+	return ret;
+}
+
+static int display_events(struct run *run)
+{
+	char buf[1024];
+	struct drm_event *ev;
+	ssize_t len, pos;
+	int ret;
+
+	len = read(disp.fd, buf, sizeof(buf));
+	if (len < 0)
+		return errno == EAGAIN ? 0 : -errno;
+
+	for (pos = 0; pos + (ssize_t)sizeof(*ev) <= len; pos += ev->length) {
+		ev = (struct drm_event *)(buf + pos);
+		if (ev->type != DRM_EVENT_FLIP_COMPLETE)
+			continue;
+		ret = display_flipped(run);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+static int sink(struct run *run, unsigned int index, uint32_t bytesused,
+		const struct timeval *ts)
+{
+	struct stage *st = &run->stages[run->nr_stages - 1];
+	struct buffer *b = &st->bufs[Q_CAP][index];
+	struct bitstream *bs = run->collect;
+
+	run->done++;
+	if (run->done == run->warmup)
+		start_measure(run);
+
+	if (bs) {
+		if (bs->nr < BITSTREAM_FRAMES && b->mem) {
+			bs->data[bs->nr] = malloc(bytesused);
+			if (!bs->data[bs->nr])
+				return -ENOMEM;
+			memcpy(bs->data[bs->nr], b->mem, bytesused);
+			bs->size[bs->nr++] = bytesused;
+		}
+		return release_sink_buf(run, index);
+	}
+
+	if (run->desc->display) {
+		b->ts = *ts;
+		return display_frame(run, index);
+	}
+
+	record_latency(run, ts);
+	return release_sink_buf(run, index);
+}
+
+static int feed_source(struct run *run)
+{
+	struct stage *st = &run->stages[0];
+	const struct v4l2_pix_format_mplane *pix = &st->fmt[Q_OUT].fmt.pix_mp;
+	struct bitstream *bs = run->source;
+	uint64_t now = now_us();
+	uint32_t bytesused;
+	struct timeval ts;
+	struct buffer *b;
+	unsigned int index;
+	int ret;
+
+	while (run->free_out) {
+		if (run->rate && now < run->next_due)
+			break;
+		/* the bitstream is meant to be encoded once, in order */
+		if (run->collect && run->queued == run->frames)
+			break;
+
+		index = __builtin_ctz(run->free_out);
+		b = &st->bufs[Q_OUT][index];
+		if (bs) {
+			bytesused = bs->size[run->queued % bs->nr];
+			if (bytesused > b->length)
+				return -ENOSPC;
+			memcpy(b->mem, bs->data[run->queued % bs->nr],
+			       bytesused);
+		} else {
+			if (run->collect)
+				fill_pattern(b, &st->fmt[Q_OUT], run->queued);
+			bytesused = pix->plane_fmt[0].sizeimage;
+		}
+
+		ts.tv_sec = now / 1000000;
+		ts.tv_usec = now % 1000000;
+		ret = queue_buf(st, Q_OUT, index, bytesused, &ts);
+		if (ret)
+			return ret;
+		run->free_out &= ~(1U << index);
+		run->queued++;
+		if (run->rate)
+			run->next_due += 1000000 / run->rate;
+	}
+	return 0;
+}
+
+static int handle_events(struct run *run, unsigned int i)
+{
+	struct stage *st = &run->stages[i];
+	struct v4l2_event ev;
+	int ret;
+
+	while (!ioctl(st->fd, VIDIOC_DQEVENT, &ev)) {
+		if (ev.type != V4L2_EVENT_SOURCE_CHANGE || st->cap_ready)
+			continue;
+		ret = setup_capture(run, i);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+static int drain_stage(struct run *run, unsigned int i)
+{
+	struct stage *st = &run->stages[i];
+	struct v4l2_plane plane;
+	struct v4l2_buffer buf;
+	int ret = 0;
+
+	if (st->decoder && !st->cap_ready) {
+		ret = handle_events(run, i);
+		if (ret)
+			return ret;
+	}
+
+	while (st->cap_ready &&
+	       (ret = dequeue_buf(st, Q_CAP, &buf, &plane)) > 0) {
+		run->last_progress = now_us();
+		if ((buf.flags & V4L2_BUF_FLAG_ERROR) || !plane.bytesused)
+			ret = queue_buf(st, Q_CAP, buf.index, 0, NULL);
+		else if (i + 1 < run->nr_stages)
+			ret = queue_buf(&run->stages[i + 1], Q_OUT, buf.index,
+					plane.bytesused, &buf.timestamp);
+		else
+			ret = sink(run, buf.index, plane.bytesused,
+				   &buf.timestamp);
+		if (ret)
+			return ret;
+	}
+	if (ret < 0)
+		return ret;
+
+	while ((ret = dequeue_buf(st, Q_OUT, &buf, &plane)) > 0) {
+		run->last_progress = now_us();
+		if (!i) {
+			run->free_out |= 1U << buf.index;
+			continue;
+		}
+		ret = queue_buf(&run->stages[i - 1], Q_CAP, buf.index, 0, NULL);
+		if (ret)
+			return ret;
+	}
+	return ret;
+}
+
+static int run_pipeline(struct run *run)
+{
+	struct pollfd fds[MAX_STAGES + 1];
+	unsigned int i, nfds;
+	int timeout, ret;
+
+	run->nr_stages = run->desc->nr_stages;
+	for (i = 0; i < MAX_STAGES; i++)
+		run->stages[i].fd = -1;
+	run->shown = run->flipping = run->waiting = -1;
+
+	ret = setup_stage(run, 0);
+	if (ret)
+		goto out;
+
+	run->next_due = run->last_progress = now_us();
+	if (!run->warmup)
+		start_measure(run);
+
+	while (run->done < run->warmup + run->frames) {
+		ret = feed_source(run);
+		if (ret)
+			goto out;
+
+		nfds = 0;
+		for (i = 0; i < run->nr_stages; i++) {
+			if (run->stages[i].fd < 0)
+				continue;
+			fds[nfds].fd = run->stages[i].fd;
+			fds[nfds++].events = POLLIN | POLLOUT | POLLPRI;
+		}
+		if (run->desc->display) {
+			fds[nfds].fd = disp.fd;
+			fds[nfds++].events = POLLIN;
+		}
+		timeout = 100;
+		if (run->rate && run->free_out && run->next_due > now_us())
+			timeout = (run->next_due - now_us()) / 1000 + 1;
+		if (poll(fds, nfds, timeout) < 0) {
+			ret = -errno;
+			goto out;
+		}
+
+		for (i = run->nr_stages; i-- > 0; ) {
+			if (run->stages[i].fd < 0)
+				continue;
+			ret = drain_stage(run, i);
+			if (ret)
+				goto out;
+		}
+		if (run->desc->display) {
+			ret = display_events(run);
+			if (ret)
+				goto out;
+		}
+
+		if (now_us() - run->last_progress > STALL_US) {
+			ksft_print_msg("%s: stalled after %u frames\n",
+				       run->desc->name, run->done);
+			ret = -ETIMEDOUT;
+			goto out;
+		}
+	}
+
+	run->t1 = now_us();
+	read_cpu(&run->busy1, &run->total1);
+
+	/* let the last flip complete before removing its framebuffer */
+	if (run->desc->display && run->flipping >= 0) {
+		fds[0].fd = disp.fd;
+		fds[0].events = POLLIN;
+		if (poll(fds, 1, 100) > 0)
+			display_events(run);
+	}
+
+out:
+	if (run->desc->display && disp.fd >= 0)
+		display_detach(run);
+	for (i = 0; i < MAX_STAGES; i++)
+		teardown_stage(&run->stages[i]);
+	return ret;
+}
+
+/* Encode test frames once, as the input of the decoder pipelines */
+static int prepare_bitstream(const struct stage_desc *enc)
+{
+	struct bitstream *bs = &bitstreams[enc->kind];
+	struct pipeline_desc desc = {
+		.name = kind_names[enc->kind],
+		.nr_stages = 1,
+		.stages = { *enc },
+	};
+	struct run run = {
+		.desc = &desc,
+		.frames = BITSTREAM_FRAMES,
+		.collect = bs,
+	};
+	int ret;
+
+	if (bs->nr)
+		return 0;
+
+	ret = run_pipeline(&run);
+	if (!ret && !bs->nr)
+		ret = -ENODATA;
+	return ret;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double percentile_ms(const struct run *run, unsigned int pct)
+{
+	unsigned int i;
+
+	if (!run->nr_latency)
+		return 0;
+	i = (run->nr_latency - 1) * pct / 100;
+	return run->latency[i] / 1000.0;
+}
+
+static void compute_result(struct run *run, struct result *res)
+{
+	double secs = (run->t1 - run->t0) / 1000000.0;
+	uint64_t total = run->total1 - run->total0;
+
+	qsort(run->latency, run->nr_latency, sizeof(*run->latency), cmp_u32);
+
+	res->fps = secs > 0 ? run->frames / secs : 0;
+	res->display_fps = secs > 0 ?
+			   (run->displayed - run->displayed0) / secs : 0;
+	res->p50 = percentile_ms(run, 50);
+	res->p90 = percentile_ms(run, 90);
+	res->p99 = percentile_ms(run, 99);
+	res->max = percentile_ms(run, 100);
+	res->cpu = total ? 100.0 * (run->busy1 - run->busy0) / total : 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * Thresholds
+ */
+
+static char compatible[1024];
+static size_t compatible_len;
+
+static void read_compatible(void)
+{
+	FILE *f = fopen("/proc/device-tree/compatible", "r");
+
+	if (!f)
+		return;
+	compatible_len = fread(compatible, 1, sizeof(compatible) - 1, f);
+	fclose(f);
+}
+
+static bool board_is(const char *compat)
+{
+	size_t pos;
+
+	for (pos = 0; pos < compatible_len; pos += strlen(compatible + pos) + 1)
+		if (!strcmp(compatible + pos, compat))
+			return true;
+	return false;
+}
+
+static double parse_limit(const char *s)
+{
+	return strcmp(s, "-") ? strtod(s, NULL) : -1;
+}
+
+/*
+ * Each line is "<compatible> <pipeline> <min fps> <max p99 latency ms>
+ * <max CPU %>", with "-" for no limit.  The first line for a compatible of
+ * the board and the pipeline applies.
+ */
+static bool find_threshold(const char *path, const char *name,
+			   struct threshold *t)
+{
+	char line[256], compat[64], pipeline[64], fps[16], p99[16], cpu[16];
+	bool found = false;
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (!f)
+		return false;
+
+	while (!found && fgets(line, sizeof(line), f)) {
+		if (line[0] == '#')
+			continue;
+		if (sscanf(line, "%63s %63s %15s %15s %15s", compat, pipeline,
+			   fps, p99, cpu) != 5)
+			continue;
+		if (strcmp(pipeline, name) || !board_is(compat))
+			continue;
+		t->min_fps = parse_limit(fps);
+		t->max_p99_ms = parse_limit(p99);
+		t->max_cpu = parse_limit(cpu);
+		found = true;
+	}
+	fclose(f);
+	return found;
+}
+
+/* -----------------------------------------------------------------------------
+ * Main
+ */
+
+static const char *thresholds_path;
+static unsigned int nr_frames = DEFAULT_FRAMES;
+static unsigned int rate;
+static bool print_thresholds;
+
+static void bench_pipeline(const struct pipeline_desc *desc)
+{
+	struct run run = {
+		.desc = desc,
+		.frames = nr_frames,
+		.warmup = WARMUP_FRAMES,
+		.rate = rate,
+	};
+	static int display_err = 1;
+	struct threshold t;
+	struct result res;
+	bool pass = true;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < desc->nr_stages; i++) {
+		if (!dev_paths[desc->stages[i].kind][0]) {
+			ksft_test_result_skip("%s: no %s\n", desc->name,
+					      kind_names[desc->stages[i].kind]);
+			return;
+		}
+	}
+	if (desc->bitstream && !dev_paths[desc->bitstream->kind][0]) {
+		ksft_test_result_skip("%s: no %s for the input\n", desc->name,
+				      kind_names[desc->bitstream->kind]);
+		return;
+	}
+
+	if (desc->display) {
+		if (display_err > 0)
+			display_err = display_init();
+		if (display_err) {
+			ksft_test_result_skip("%s: no display: %s\n",
+					      desc->name,
+					      strerror(-display_err));
+			return;
+		}
+	}
+
+	if (desc->bitstream) {
+		ret = prepare_bitstream(desc->bitstream);
+		if (ret) {
+			ksft_test_result_fail("%s: encoding the input: %s\n",
+					      desc->name, strerror(-ret));
+			return;
+		}
+		run.source = &bitstreams[desc->bitstream->kind];
+	}
+
+	run.latency = calloc(run.frames, sizeof(*run.latency));
+	if (!run.latency)
+		ksft_exit_fail_msg("out of memory\n");
+
+	ret = run_pipeline(&run);
+	if (ret) {
+		ksft_test_result_fail("%s: %s\n", desc->name, strerror(-ret));
+		free(run.latency);
+		return;
+	}
+	compute_result(&run, &res);
+	free(run.latency);
+
+	if (desc->display)
+		ksft_print_msg("%s: %.1f fps, %.1f displayed (%u dropped)\n",
+			       desc->name, res.fps, res.display_fps,
+			       run.dropped);
+	else
+		ksft_print_msg("%s: %.1f fps\n", desc->name, res.fps);
+	ksft_print_msg("%s: latency p50 %.1f p90 %.1f p99 %.1f max %.1f ms, cpu %.1f%%\n",
+		       desc->name, res.p50, res.p90, res.p99, res.max, res.cpu);
+	if (print_thresholds)
+		ksft_print_msg("threshold: %s\t%s\t%.0f\t%.0f\t%.0f\n",
+			       compatible_len ? compatible : "-", desc->name,
+			       res.fps * 0.8, res.p99 * 1.25 + 1,
+			       res.cpu * 1.25 + 5);
+
+	if (!find_threshold(thresholds_path, desc->name, &t)) {
+		ksft_test_result_pass("%s: no threshold for this board\n",
+				      desc->name);
+		return;
+	}
+	if (t.min_fps >= 0 && res.fps < t.min_fps) {
+		ksft_print_msg("%s: %.1f fps, below %.1f\n", desc->name,
+			       res.fps, t.min_fps);
+		pass = false;
+	}
+	if (t.max_p99_ms >= 0 && res.p99 > t.max_p99_ms) {
+		ksft_print_msg("%s: p99 latency %.1f ms, above %.1f\n",
+			       desc->name, res.p99, t.max_p99_ms);
+		pass = false;
+	}
+	if (t.max_cpu >= 0 && res.cpu > t.max_cpu) {
+		ksft_print_msg("%s: cpu %.1f%%, above %.1f%%\n", desc->name,
+			       res.cpu, t.max_cpu);
+		pass = false;
+	}
+	ksft_test_result(pass, "%s\n", desc->name);
+}
+
+static bool selected(const char *name, int argc, char **argv)
+{
+	int i;
+
+	if (optind == argc)
+		return true;
+	for (i = optind; i < argc; i++)
+		if (!strcmp(argv[i], name))
+			return true;
+	return false;
+}
+
+int main(int argc, char **argv)
+{
+	static char default_path[PATH_MAX];
+	char self[PATH_MAX];
+	unsigned int i, n = 0;
+	int opt;
+
+	snprintf(self, sizeof(self), "%s", argv[0]);
+	snprintf(default_path, sizeof(default_path), "%s/%s", dirname(self),
+		 THRESHOLDS_FILE);
+	thresholds_path = default_path;
+
+	while ((opt = getopt(argc, argv, "n:r:t:p")) != -1) {
+		switch (opt) {
+		case 'n':
+			nr_frames = strtoul(optarg, NULL, 0) ? : 1;
+			break;
+		case 'r':
+			rate = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			thresholds_path = optarg;
+			break;
+		case 'p':
+			print_thresholds = true;
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-n frames] [-r fps] [-t thresholds] [-p] [pipeline...]\n",
+				argv[0]);
+			return KSFT_FAIL;
+		}
+	}
+
+	ksft_print_header();
+
+	for (i = optind; i < (unsigned int)argc; i++) {
+		for (n = 0; n < ARRAY_SIZE(pipelines); n++)
+			if (!strcmp(argv[i], pipelines[n].name))
+				break;
+		if (n == ARRAY_SIZE(pipelines))
+			ksft_exit_fail_msg("unknown pipeline %s\n", argv[i]);
+	}
+	for (i = n = 0; i < ARRAY_SIZE(pipelines); i++)
+		n += selected(pipelines[i].name, argc, argv);
+	ksft_set_plan(n);
+
+	read_compatible();
+	find_devices();
+
+	for (i = 0; i < ARRAY_SIZE(pipelines); i++)
+		if (selected(pipelines[i].name, argc, argv))
+			bench_pipeline(&pipelines[i]);
+
+	ksft_finished();
+}
@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Interrupt notification cost of an fsl-mc object assigned to vfio-fsl-mc
+ *
+ * Measures, for one IRQ of the object:
+ *  - the kernel -> eventfd -> userspace notification path, looped back by
+ *    VFIO_IRQ_SET_ACTION_TRIGGER with no data;
+ *  - a mask/unmask pair done with VFIO_DEVICE_SET_IRQS ioctls;
+ *  - the same pair done with writes to eventfds bound to the mask and
+ *    unmask actions.
+ *
+ * Usage: fsl_mc_irq_bench <object> [irq index] [iterations]
+ * e.g.   fsl_mc_irq_bench dpio.5
+ *
+ * The object's container must already be bound to vfio-fsl-mc.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+
+#include <linux/vfio.h>
+
+#include "../kselftest.h"
+
+#define DEFAULT_ITERATIONS	100000
+
+static int device_fd;
+static unsigned int irq_index;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int set_irqs(uint32_t flags, int32_t *fd)
+{
+	char buf[sizeof(struct vfio_irq_set) + sizeof(int32_t)];
+	struct vfio_irq_set *set = (struct vfio_irq_set *)buf;
+
+	set->argsz = sizeof(*set) + (fd ? sizeof(*fd) : 0);
+	set->flags = flags | (fd ? VFIO_IRQ_SET_DATA_EVENTFD :
+				   VFIO_IRQ_SET_DATA_NONE);
+	set->index = irq_index;
+	set->start = 0;
+	set->count = 1;
+	if (fd)
+		memcpy(set->data, fd, sizeof(*fd));
+
+	return ioctl(device_fd, VFIO_DEVICE_SET_IRQS, set);
+}
+
+static int open_device(const char *name)
+{
+	struct vfio_group_status status = { .argsz = sizeof(status) };
+	char path[PATH_MAX], link[PATH_MAX];
+	int container, group;
+	ssize_t len;
+
+	snprintf(path, sizeof(path), "/sys/bus/fsl-mc/devices/%s/iommu_group",
+		 name);
+	len = readlink(path, link, sizeof(link) - 1);
+	if (len < 0)
+		ksft_exit_skip("%s has no IOMMU group\n", name);
+	link[len] = '\0';
+
+	container = open("/dev/vfio/vfio", O_RDWR);
+	if (container < 0)
+		ksft_exit_skip("cannot open /dev/vfio/vfio: %s\n",
+			       strerror(errno));
+
+	snprintf(path, sizeof(path), "/dev/vfio/%s", basename(link));
+	group = open(path, O_RDWR);
+	if (group < 0)
+		ksft_exit_skip("cannot open %s: %s\n", path, strerror(errno));
+
+	if (ioctl(group, VFIO_GROUP_GET_STATUS, &status) ||
+	    !(status.flags & VFIO_GROUP_FLAGS_VIABLE))
+		ksft_exit_skip("group %s is not viable\n", path);
+
+	if (ioctl(group, VFIO_GROUP_SET_CONTAINER, &container) ||
+	    ioctl(container, VFIO_SET_IOMMU, VFIO_TYPE1_IOMMU))
+		ksft_exit_fail_msg("cannot set up the container: %s\n",
+				   strerror(errno));
+
+	return ioctl(group, VFIO_GROUP_GET_DEVICE_FD, name);
+}
+
+static void bench_trigger(unsigned long iterations)
+{
+	uint64_t start, count;
+	unsigned long i;
+	int32_t efd;
+
+	efd = eventfd(0, 0);
+	if (efd < 0 || set_irqs(VFIO_IRQ_SET_ACTION_TRIGGER, &efd)) {
+		ksft_test_result_fail("trigger eventfd: %s\n", strerror(errno));
+		return;
+	}
+
+	start = now_ns();
+	for (i = 0; i < iterations; i++) {
+		if (set_irqs(VFIO_IRQ_SET_ACTION_TRIGGER, NULL) ||
+		    read(efd, &count, sizeof(count)) != sizeof(count))
+			break;
+	}
+
+	if (i == iterations)
+		ksft_test_result_pass("loopback notification: %llu ns\n",
+				      (unsigned long long)((now_ns() - start) /
+							   iterations));
+	else
+		ksft_test_result_fail("loopback notification: %s\n",
+				      strerror(errno));
+}
+
+static void bench_mask_ioctl(unsigned long iterations)
+{
+	uint64_t start;
+	unsigned long i;
+
+	start = now_ns();
+	for (i = 0; i < iterations; i++) {
+		if (set_irqs(VFIO_IRQ_SET_ACTION_MASK, NULL) ||
+		    set_irqs(VFIO_IRQ_SET_ACTION_UNMASK, NULL))
+			break;
+	}
+
+	if (i == iterations)
+		ksft_test_result_pass("mask+unmask via ioctl: %llu ns\n",
+				      (unsigned long long)((now_ns() - start) /
+							   iterations));
+	else
+		ksft_test_result_fail("mask+unmask via ioctl: %s\n",
+				      strerror(errno));
+}
+
+static void bench_mask_eventfd(unsigned long iterations)
+{
+	uint64_t start, one = 1;
+	int32_t mfd, ufd, none = -1;
+	unsigned long i;
+
+	mfd = eventfd(0, 0);
+	ufd = eventfd(0, 0);
+	if (mfd < 0 || ufd < 0 ||
+	    set_irqs(VFIO_IRQ_SET_ACTION_MASK, &mfd) ||
+	    set_irqs(VFIO_IRQ_SET_ACTION_UNMASK, &ufd)) {
+		ksft_test_result_fail("mask+unmask eventfds: %s\n",
+				      strerror(errno));
+		return;
+	}
+
+	start = now_ns();
+	for (i = 0; i < iterations; i++) {
+		if (write(mfd, &one, sizeof(one)) != sizeof(one) ||
+		    write(ufd, &one, sizeof(one)) != sizeof(one))
+			break;
+	}
+
+	if (i == iterations)
+		ksft_test_result_pass("mask+unmask via eventfd: %llu ns\n",
+				      (unsigned long long)((now_ns() - start) /
+							   iterations));
+	else
+		ksft_test_result_fail("mask+unmask via eventfd: %s\n",
+				      strerror(errno));
+
+	set_irqs(VFIO_IRQ_SET_ACTION_MASK, &none);
+	set_irqs(VFIO_IRQ_SET_ACTION_UNMASK, &none);
+}
+
+int main(int argc, char **argv)
+{
+	struct vfio_irq_info info = { .argsz = sizeof(info) };
+	unsigned long iterations = DEFAULT_ITERATIONS;
+	int32_t none = -1;
+
+	ksft_print_header();
+
+	if (argc < 2)
+		ksft_exit_skip("usage: %s <object> [irq index] [iterations]\n",
+			       argv[0]);
+	if (argc > 2)
+		irq_index = strtoul(argv[2], NULL, 0);
+	if (argc > 3)
+		iterations = strtoul(argv[3], NULL, 0) ? : 1;
+
+	device_fd = open_device(argv[1]);
+	if (device_fd < 0)
+		ksft_exit_skip("cannot get a device fd for %s: %s\n", argv[1],
+			       strerror(errno));
+
+	info.index = irq_index;
+	if (ioctl(device_fd, VFIO_DEVICE_GET_IRQ_INFO, &info))
+		ksft_exit_skip("%s has no IRQ %u\n", argv[1], irq_index);
+
+	ksft_set_plan(3);
+
+	bench_trigger(iterations);
+
+	if (info.flags & VFIO_IRQ_INFO_MASKABLE) {
+		bench_mask_ioctl(iterations);
+		bench_mask_eventfd(iterations);
+	} else {
+		ksft_test_result_skip("IRQ %u is not maskable\n", irq_index);
+		ksft_test_result_skip("IRQ %u is not maskable\n", irq_index);
+	}
+
+	set_irqs(VFIO_IRQ_SET_ACTION_TRIGGER, &none);
+
+	ksft_finished();
+}